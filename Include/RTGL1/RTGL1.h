@@ -39,7 +39,7 @@
     #define RGCONV
 #endif // defined(_WIN32)
 
-#define RG_RTGL_VERSION_API "001.006.000"
+#define RG_RTGL_VERSION_API "001.007.000"
 
 #ifdef RG_USE_SURFACE_WIN32
     #include <windows.h>
@@ -150,6 +150,14 @@ typedef struct RgXlibSurfaceCreateInfo
 } RgXlibSurfaceCreateInfo;
 #endif // RG_USE_SURFACE_XLIB
 
+// No surface and no presentation: frames are rendered into an offscreen image
+// of the specified size, and can be read back with rgUtilGetHeadlessFrame.
+typedef struct RgHeadlessCreateInfo
+{
+    uint32_t            width;
+    uint32_t            height;
+} RgHeadlessCreateInfo;
+
 typedef enum RgStructureType
 {
     RG_STRUCTURE_TYPE_NONE                                = 0,
@@ -185,6 +193,19 @@ typedef enum RgStructureType
     RG_STRUCTURE_TYPE_START_FRAME_RENDER_RESOLUTION_PARAMS  = 33,
     RG_STRUCTURE_TYPE_SPAWN_FLUID_INFO                      = 34,
     RG_STRUCTURE_TYPE_START_FRAME_FLUID_PARAMS              = 35,
+    RG_STRUCTURE_TYPE_DRAW_FRAME_INSTANCE_CULLING_PARAMS    = 36,
+    RG_STRUCTURE_TYPE_MESH_PRIMITIVE_SKINNING_EXT           = 37,
+    RG_STRUCTURE_TYPE_MESH_PRIMITIVE_NAME_HANDLE_EXT        = 38,
+    RG_STRUCTURE_TYPE_MESH_NAME_HANDLE_EXT                  = 39,
+    RG_STRUCTURE_TYPE_START_FRAME_STEREO_PARAMS             = 40,
+    RG_STRUCTURE_TYPE_START_FRAME_VIEWS_PARAMS              = 41,
+    RG_STRUCTURE_TYPE_DRAW_FRAME_VIEWS_PARAMS               = 42,
+    RG_STRUCTURE_TYPE_MESH_AREA_EXT                         = 43,
+    RG_STRUCTURE_TYPE_DRAW_FRAME_AREA_VISIBILITY_PARAMS     = 44,
+    RG_STRUCTURE_TYPE_MESH_PRIMITIVE_PARTICLES_EXT          = 45,
+    RG_STRUCTURE_TYPE_ORIGINAL_TEXTURE_ASYNC_EXT            = 46,
+    RG_STRUCTURE_TYPE_READBACK_REQUEST_INFO                 = 47,
+    RG_STRUCTURE_TYPE_START_FRAME_FRAME_PACING_PARAMS       = 48,
 } RgStructureType;
 
 typedef enum RgTextureSwizzling
@@ -232,7 +253,7 @@ typedef struct RgInstanceCreateInfo
     // Application GUID. Generate it for your application and specify it here.
     const char*                 pAppGUID;
 
-    // Exactly one of these surface create infos must be not null.
+    // Exactly one of these surface create infos or pHeadlessCreateInfo must be not null.
     RgWin32SurfaceCreateInfo*   pWin32SurfaceInfo;
     RgMetalSurfaceCreateInfo*   pMetalSurfaceCreateInfo;
     RgWaylandSurfaceCreateInfo* pWaylandSurfaceCreateInfo;
@@ -254,10 +275,14 @@ typedef struct RgInstanceCreateInfo
     uint32_t                    indirectIlluminationMaxAlbedoLayers;
 
     // How many vertices to allocate for static and replacements (load once) geometry.
-    // Bytes allocated in VRAM: 2 * replacementsMaxVertexCount * sizeof(RgPrimitiveVertex)
+    // Bytes allocated in VRAM: 2 * replacementsMaxVertexCount * sizeof(RgPrimitiveVertex),
+    // or 20 bytes per vertex instead of sizeof(RgPrimitiveVertex), if quantizeStaticVertices.
     uint64_t                    replacementsMaxVertexCount;
-    // How many vertices to allocate for dynamic (load each frame) geometry.
-    // Bytes allocated in VRAM: 3 * dynamicMaxVertexCount * sizeof(RgPrimitiveVertex)
+    // Max count of vertices for dynamic (load each frame) geometry. Buffers are allocated
+    // with a smaller capacity, and grow on demand up to this count: geometry that didn't fit
+    // is skipped only for the frame, when it was encountered. They shrink after a long time
+    // of a low usage.
+    // Bytes allocated in VRAM: at most 3 * dynamicMaxVertexCount * sizeof(RgPrimitiveVertex)
     uint64_t                    dynamicMaxVertexCount;
 
     RgBool32                    rayCullBackFacingTriangles;
@@ -268,9 +293,10 @@ typedef struct RgInstanceCreateInfo
     // Set to 0, if no lightmaps.
     uint32_t                    lightmapTexCoordLayerIndex;
 
-    // Memory that must be allocated for vertex and index buffers of rasterized geometry.
-    // It can't be changed after rgCreateInstance.
-    // If buffer is full, rasterized data will be ignored
+    // Initial capacity of vertex and index buffers of rasterized geometry.
+    // The buffers grow on demand: if they're full, the rest of rasterized data is ignored
+    // only for that frame, and the buffers are reallocated on the next rgStartFrame.
+    // See RgUtilMemoryUsage::rasterizedVertexCount for the usage.
     uint32_t                    rasterizedMaxVertexCount;
     uint32_t                    rasterizedMaxIndexCount;
     // Apply gamma correction to packed rasterized vertex colors.
@@ -299,6 +325,78 @@ typedef struct RgInstanceCreateInfo
     float                       importedLightIntensityScaleDirectional;
     float                       importedLightIntensityScaleSphere;
     float                       importedLightIntensityScaleSpot;
+
+    // If true, rgUploadMeshPrimitive(s) can be called from multiple threads at once.
+    // The calls are ordered internally, but vertex data is copied on the calling threads
+    // in parallel. All calls must return before rgDrawFrame.
+    RgBool32                    allowMultithreadedUpload;
+
+    // If true, static and replacement vertices are stored in a compact format:
+    // positions are 16-bit, relative to the bounds of a primitive; texture coordinates
+    // are half-float. Less memory and bandwidth, but lower precision: adjacent primitives
+    // with different bounds might not match exactly on the shared edges.
+    RgBool32                    quantizeStaticVertices;
+
+    // Host memory that is reserved per frame in flight for uploading textures.
+    // If a texture doesn't fit, a separate staging buffer is created for it.
+    // If 0, a default size is used. At most 64 MB.
+    uint64_t                    textureStagingRingSize;
+
+    // If true, some of the intermediate HDR images (denoised illumination, bloom chain)
+    // are stored in a 32-bit packed float format instead of 64-bit half-floats.
+    // Less memory and bandwidth, but the colors are slightly less precise.
+    // If the GPU doesn't support the packed format, the default one is used.
+    RgBool32                    compactFramebuffers;
+
+    // How many frames can be recorded on CPU, while GPU is processing the previous ones.
+    // 2 has a lower latency. 3 gives more throughput, if CPU and GPU frame times are close,
+    // but more memory is used for the per-frame resources. If 0, then 2 is used.
+    uint32_t                    framesInFlight;
+
+    // If true, opaque rasterized world geometry is drawn grouped by pipeline state
+    // and material, instead of the submission order, to reduce state changes.
+    // Translucent geometry, sky, decals and swapchain geometry keep the submission order.
+    RgBool32                    rasterizedSortDraws;
+
+    // If true, in release builds, the arguments of rgUploadMeshPrimitive(s) and rgUploadLight
+    // are not validated: structure types, null pointers and flag combinations must be correct.
+    // Debug builds always validate.
+    RgBool32                    trustedInput;
+
+    // If not null, the library renders offscreen, without a window and a swapchain.
+    // All surface create infos must be null then.
+    RgHeadlessCreateInfo*       pHeadlessCreateInfo;
+
+    // If not null, the calls of rgRegisterName, rgStartFrame, rgUploadCamera,
+    // rgUploadMeshPrimitive(s), rgUploadLight, rgProvideOriginalTexture,
+    // rgMarkOriginalTextureAsDeleted and rgDrawFrame are recorded into this file.
+    // It can be fed back with rgUtilReplayCapture.
+    const char*                 pApiCaptureFilePath;
+
+    // If true, the library renders on its own thread, one frame behind the application.
+    // rgStartFrame, rgUploadCamera, rgUploadMeshPrimitive(s), rgUploadLensFlare, rgSpawnFluid,
+    // rgUploadLight, rgProvideOriginalTexture, rgMarkOriginalTextureAsDeleted,
+    // rgUpdateMeshTransform, rgDestroyMesh and rgDrawFrame copy their arguments and return
+    // immediately; errors of these calls are only printed. Other functions that access
+    // the renderer wait for the render thread to finish the queued calls.
+    // RgStartFrameInfo::pResultStaticSceneStatus receives the status of the previous frame.
+    // rgUtilStagingAllocForVertices returns memory that is valid until rgDrawFrame.
+    // pfnPrint can be called from the render thread.
+    RgBool32                    renderOnSeparateThread;
+
+    // If true, the same calls are copied, but issued on the calling thread in rgDrawFrame.
+    // So rgStartFrame doesn't wait for the GPU to release the resources of the frame slot,
+    // and uploads can begin immediately; the wait happens in rgDrawFrame instead.
+    // The limitations of renderOnSeparateThread apply. Implied by renderOnSeparateThread.
+    RgBool32                    deferFrameUploads;
+
+    // Max count of TLAS instances in a frame. A static cluster reserves an instance
+    // per its geometry. If 0, 65536 is used.
+    uint32_t                    maxInstanceCount;
+    // Max count of geometries and of unique materials in a frame. Per-geometry buffers
+    // (~1 KB per geometry in total) are allocated with this capacity.
+    // Can't be less than maxInstanceCount. If 0, 131072 is used.
+    uint32_t                    maxGeometryCount;
 } RgInstanceCreateInfo;
 
 typedef struct RgInterface RgInterface;
@@ -376,6 +474,9 @@ typedef enum RgMeshPrimitiveFlagBits
     RG_MESH_PRIMITIVE_EXPORT_INVERT_NORMALS = 1 << 15,
     RG_MESH_PRIMITIVE_NO_SHADOW             = 1 << 16,
     RG_MESH_PRIMITIVE_NO_MOTION_VECTORS     = 1 << 17,
+    // Dynamic primitive that keeps its vertex count and indices between frames,
+    // only positions are changed. Its BLAS is refitted instead of being fully rebuilt.
+    RG_MESH_PRIMITIVE_TOPOLOGY_STABLE       = 1 << 18,
 } RgMeshPrimitiveFlagBits;
 typedef uint32_t RgMeshPrimitiveFlags;
 
@@ -486,6 +587,74 @@ typedef struct RgMeshPrimitiveSwapchainedEXT
     const float*                    pViewProjection;
 } RgMeshPrimitiveSwapchainedEXT;
 
+typedef struct RgVertexSkinWeights
+{
+    // Indices into RgMeshPrimitiveSkinningEXT::pBoneTransforms
+    uint8_t                     joints[ 4 ];
+    // Should sum up to 1.0, stored with 8-bit precision
+    float                       weights[ 4 ];
+} RgVertexSkinWeights;
+
+// Skin a dynamic primitive on GPU, right before its BLAS build.
+// RgMeshPrimitiveInfo::pVertices must be the bind pose: it's uploaded to GPU memory
+// once, and then again only if 'bindPoseVersion' changes; only the bone palette
+// is uploaded each frame. Rasterized passes and the exporter skin a copy on CPU instead.
+// Ignored for static primitives.
+// Can be linked after RgMeshPrimitiveInfo.
+typedef struct RgMeshPrimitiveSkinningEXT
+{
+    RgStructureType             sType;
+    void*                       pNext;
+    // 'vertexCount' elements
+    const RgVertexSkinWeights*  pSkinWeights;
+    // Bind pose space to mesh space, at most 256
+    const RgTransform*          pBoneTransforms;
+    uint32_t                    boneCount;
+    uint32_t                    bindPoseVersion;
+} RgMeshPrimitiveSkinningEXT;
+
+typedef struct RgParticle
+{
+    RgFloat3D                   position;
+    // Width and height of the quad
+    float                       size;
+    // Around the view direction, in radians
+    float                       rotation;
+    RgColor4DPacked32           color;
+    // Cell of the flipbook, left to right, top to bottom
+    uint32_t                    frame;
+} RgParticle;
+
+// Camera-facing quads, that are expanded from the particles on GPU, right before
+// the BLAS build; all particles of a primitive are in one BLAS. The primitive's
+// pVertices and pIndices are ignored, vertexCount can be 0. Particle positions are
+// in mesh space. Rasterized primitives are expanded on CPU, static ones are ignored.
+// Can be linked after RgMeshPrimitiveInfo.
+typedef struct RgMeshPrimitiveParticlesEXT
+{
+    RgStructureType             sType;
+    void*                       pNext;
+    const RgParticle*           pParticles;
+    uint32_t                    particleCount;
+    // Texture is split into a grid of flipbook frames. 0 is treated as 1.
+    uint32_t                    flipbookColumns;
+    uint32_t                    flipbookRows;
+} RgMeshPrimitiveParticlesEXT;
+
+// String interned by rgRegisterName. 0 is an empty name.
+typedef uint32_t RgNameHandle;
+
+// Registered name instead of RgMeshPrimitiveInfo::pTextureName: lookups by the texture name
+// are done once per handle, and not for each primitive in each frame.
+// Can be linked after RgMeshPrimitiveInfo.
+typedef struct RgMeshPrimitiveNameHandleEXT
+{
+    RgStructureType             sType;
+    void*                       pNext;
+    // If not 0, pTextureName is ignored.
+    RgNameHandle                textureName;
+} RgMeshPrimitiveNameHandleEXT;
+
 // Primitive is an indexed or non-indexed geometry with a material.
 typedef struct RgMeshPrimitiveInfo
 {
@@ -504,6 +673,9 @@ typedef struct RgMeshPrimitiveInfo
     float                       emissive;
     // Default: 1.0
     float                       classicLight;
+    // If not null, 'indexCount' 16-bit indices are used instead of pIndices.
+    // They are kept 16-bit in GPU memory.
+    const uint16_t*             pIndices16;
 } RgMeshPrimitiveInfo;
 
 // Mesh is a set of primitives.
@@ -526,8 +698,53 @@ typedef struct RgMeshInfo
     float                       localLightsIntensity;
 } RgMeshInfo;
 
+// Registered name instead of RgMeshInfo::pMeshName.
+// Can be linked after RgMeshInfo.
+typedef struct RgMeshNameHandleEXT
+{
+    RgStructureType             sType;
+    void*                       pNext;
+    // If not 0, pMeshName is ignored.
+    RgNameHandle                meshName;
+} RgMeshNameHandleEXT;
+
+// Can be linked after RgMeshInfo.
+// Area of a level that the mesh belongs to, e.g. a BSP cluster or a portal area.
+// See RgDrawFrameAreaVisibilityParams.
+typedef struct RgMeshAreaEXT
+{
+    RgStructureType             sType;
+    void*                       pNext;
+    uint32_t                    areaIndex;
+} RgMeshAreaEXT;
+
 typedef RgResult( RGAPI_PTR* PFN_rgUploadMeshPrimitive )( const RgMeshInfo*          pMesh,
                                                           const RgMeshPrimitiveInfo* pPrimitive );
+// Same as rgUploadMeshPrimitive for each of pPrimitives, but mesh-level validation
+// and lookups are done once.
+typedef RgResult( RGAPI_PTR* PFN_rgUploadMeshPrimitives )( const RgMeshInfo*          pMesh,
+                                                           const RgMeshPrimitiveInfo* pPrimitives,
+                                                           uint32_t primitiveCount );
+// Intern a string to pass it as RgNameHandle. The same string gets the same handle,
+// which is valid until rgDestroyInstance. Returns 0 for an empty string.
+typedef RgNameHandle( RGAPI_PTR* PFN_rgRegisterName )( const char* pName );
+
+// Mesh that is kept by the library, see rgCreateMesh. 0 is an invalid handle.
+typedef uint32_t RgMeshHandle;
+
+// Create a mesh that is uploaded by the library itself each frame, until rgDestroyMesh.
+// Vertex data and names are copied. From pNext chains, only RgMeshPrimitivePBREXT,
+// RgMeshPrimitiveAttachedLightEXT, RgMeshAreaEXT and name handles are preserved.
+// As its content doesn't change, vertex data and BLAS are kept on GPU.
+typedef RgResult( RGAPI_PTR* PFN_rgCreateMesh )( const RgMeshInfo*          pMesh,
+                                                 const RgMeshPrimitiveInfo* pPrimitives,
+                                                 uint32_t                   primitiveCount,
+                                                 RgMeshHandle*              pOutMesh );
+// Replaces RgMeshInfo::transform and RgMeshInfo::flags of a created mesh.
+typedef RgResult( RGAPI_PTR* PFN_rgUpdateMeshTransform )( RgMeshHandle       mesh,
+                                                          const RgTransform* pTransform,
+                                                          RgMeshInfoFlags    flags );
+typedef RgResult( RGAPI_PTR* PFN_rgDestroyMesh )( RgMeshHandle mesh );
 
 
 
@@ -568,6 +785,60 @@ typedef RgResult( RGAPI_PTR* PFN_rgSpawnFluid )( const RgSpawnFluidInfo* pInfo )
 
 
 
+typedef enum RgReadbackSource
+{
+    // The image that is presented, with HUD
+    RG_READBACK_SOURCE_FINAL,
+    // G-buffer images in render resolution
+    RG_READBACK_SOURCE_ALBEDO,
+    RG_READBACK_SOURCE_METALLIC_ROUGHNESS,
+    RG_READBACK_SOURCE_SCREEN_EMISSION,
+} RgReadbackSource;
+
+typedef enum RgReadbackFormat
+{
+    // R8G8B8A8 in sRGB
+    RG_READBACK_FORMAT_R8G8B8A8_SRGB,
+    // Y plane of width*height bytes, followed by a plane of interleaved U and V bytes
+    // in half the resolution. BT.709 limited range. Converted on GPU, so the result
+    // can be passed to a video encoder as is. Width is a multiple of 4, height of 2.
+    RG_READBACK_FORMAT_NV12,
+} RgReadbackFormat;
+
+// Rows are tightly packed. Valid only during the callback.
+typedef struct RgReadbackResult
+{
+    // Null, if the image couldn't be read back, or the instance is being destroyed
+    const void*      pPixels;
+    uint32_t         width;
+    uint32_t         height;
+    // Count of rgDrawFrame calls before the frame was drawn
+    uint64_t         frameNumber;
+    RgReadbackFormat format;
+} RgReadbackResult;
+
+typedef void ( *PFN_rgReadbackCallback )( const RgReadbackResult* pResult, void* pUserData );
+
+// rgRequestReadback can be called from any thread. The image of the next rgDrawFrame
+// is copied on GPU into a host-visible buffer, and pfnCallback is called exactly once
+// in one of the next rgStartFrame calls, after the frame is finished on GPU,
+// so the renderer is not stalled. With renderOnSeparateThread, the callback is called
+// on the render thread.
+typedef struct RgReadbackRequestInfo
+{
+    RgStructureType        sType;
+    void*                  pNext;
+    RgReadbackSource       source;
+    RgReadbackFormat       format;
+    // If not 0, the image is downscaled on GPU to fit into this size, keeping the aspect ratio
+    RgExtent2D             maxSize;
+    PFN_rgReadbackCallback pfnCallback;
+    void*                  pUserData;
+} RgReadbackRequestInfo;
+typedef RgResult( RGAPI_PTR* PFN_rgRequestReadback )( const RgReadbackRequestInfo* pInfo );
+
+
+
 // If provided, members are initialized in rgUploadCamera().
 // Can be linked after RgCameraInfo.
 typedef struct RgCameraInfoReadbackEXT
@@ -722,6 +993,16 @@ typedef enum RgFormat
     RG_FORMAT_R8G8B8A8_SRGB    = 43,
     RG_FORMAT_B8G8R8A8_UNORM   = 44,
     RG_FORMAT_B8G8R8A8_SRGB    = 50,
+    // Block-compressed formats require pregenerated mip levels,
+    // see RgOriginalTextureAsyncEXT::pregeneratedLevelCount
+    RG_FORMAT_BC1_RGBA_UNORM   = 133,
+    RG_FORMAT_BC1_RGBA_SRGB    = 134,
+    RG_FORMAT_BC3_UNORM        = 137,
+    RG_FORMAT_BC3_SRGB         = 138,
+    RG_FORMAT_BC4_UNORM        = 139,
+    RG_FORMAT_BC5_UNORM        = 141,
+    RG_FORMAT_BC7_UNORM        = 145,
+    RG_FORMAT_BC7_SRGB         = 146,
 } RgFormat;
 
 typedef enum RgOriginalTextureInfoFlagBits
@@ -739,12 +1020,35 @@ typedef struct RgOriginalTextureDetailsEXT
     RgFormat                   format;
 } RgOriginalTextureDetailsEXT;
 
+typedef void ( *PFN_rgReleaseOriginalTexturePixels )( const void* pPixels, void* pUserData );
+
+// Can be linked after RgOriginalTextureInfo. If linked, rgProvideOriginalTexture can be
+// called from any thread, and returns immediately: the material is created in one of the
+// next rgDrawFrame calls, with the upload and mip generation on the transfer queue.
+// Until then, the material doesn't exist, and the order relative to
+// rgMarkOriginalTextureAsDeleted is not defined.
+typedef struct RgOriginalTextureAsyncEXT
+{
+    RgStructureType                    sType;
+    void*                              pNext;
+    // If not null, pPixels is not copied: it must be valid until this function is called,
+    // exactly once, on any thread; also if the texture was rejected.
+    // Otherwise, pPixels is copied before return.
+    PFN_rgReleaseOriginalTexturePixels pfnReleasePixels;
+    void*                              pUserData;
+    // If not 0, pPixels contains this count of mip levels, tightly packed, starting from
+    // the base level of RgOriginalTextureInfo::size. Otherwise, mip levels are generated.
+    // Must be not 0 for the block-compressed formats.
+    uint32_t                           pregeneratedLevelCount;
+} RgOriginalTextureAsyncEXT;
+
 typedef struct RgOriginalTextureInfo
 {
     RgStructureType         sType;
     void*                   pNext;
     const char*             pTextureName;
-    // R8G8B8A8 pixel data. Must be (size.width * size.height * 4) bytes.
+    // R8G8B8A8 pixel data. Must be (size.width * size.height * 4) bytes,
+    // unless the format or the mip levels are specified in the linked structs.
     const void*             pPixels;
     RgExtent2D              size;
     RgSamplerFilter         filter;
@@ -806,6 +1110,19 @@ typedef struct RgStartFrameRenderResolutionParams
     // be done in higher resolution.
     RgBool32                 pixelizedRenderSizeEnable;
     RgExtent2D               pixelizedRenderSize;
+    // If true and upscaleTechnique is RG_RENDER_UPSCALE_TECHNIQUE_NVIDIA_DLSS,
+    // DLSS Ray Reconstruction will do both denoising and upscaling, instead of
+    // the built-in denoiser. Ignored, if not supported or if frame generation is on.
+    RgBool32                 dlssRayReconstruction;
+    // If true, render size is adjusted over time to keep the GPU frame time
+    // under 'dynamicResolutionTargetFrameTime' (in milliseconds). The size provided
+    // by resolutionMode / customRenderSize is ignored then, but the mode is still
+    // passed to the upscaler.
+    RgBool32                 dynamicResolution;
+    float                    dynamicResolutionTargetFrameTime;
+    // The lowest allowed render size, as a fraction of the output size.
+    // If 0, 0.5 is used.
+    float                    dynamicResolutionMinScale;
 } RgStartFrameRenderResolutionParams;
 
 // Can be linked after RgStartFrameInfo.
@@ -819,13 +1136,71 @@ typedef struct RgStartFrameFluidParams
     RgFloat3D       color;
     uint32_t        particleBudget;
     float           particleRadius;
+    // Sources farther than this from the camera spawn proportionally fewer, but larger
+    // particles. If 0, spawn counts don't depend on the distance.
+    float           lodDistance;
+    // If not 0, spawn counts are gradually reduced while the GPU frame time
+    // (in milliseconds) is over this value, and restored when it's under.
+    float           targetFrameTime;
 } RgStartFrameFluidParams;
 
+// Can be linked after RgStartFrameInfo.
+// Stereo rendering for VR: both eyes are path traced in one frame, sharing the acceleration
+// structures, vertex preprocessing, lights and ReSTIR buffers. The render target is split
+// side-by-side: the left eye is in the left half, the right eye is in the right half.
+// RgCameraInfo describes the point between the eyes, and RgCameraInfo::aspect must be
+// the aspect of one eye. The eyes are offset along RgCameraInfo::right.
+// Fluids, lens flares and the non-world rasterized geometry are not stereo.
+typedef struct RgStartFrameStereoParams
+{
+    RgStructureType sType;
+    void*           pNext;
+    RgBool32        sideBySide;
+    // Distance between the eyes, in world units.
+    float           interpupillaryDistance;
+} RgStartFrameStereoParams;
+
+// Can be linked after RgStartFrameInfo.
+// Several camera views are rendered in one frame, sharing the acceleration structures,
+// vertex preprocessing, lights, textures and descriptors. The render target is split into
+// 'viewCount' equal columns, view 0 is the leftmost one. Each view has its own region of
+// every framebuffer, so its own history. The cameras of the views are provided with
+// RgDrawFrameViewsParams. Ignored, if RgStartFrameStereoParams::sideBySide is true.
+// Fluids, lens flares and the non-world rasterized geometry are drawn only for view 0.
+typedef struct RgStartFrameViewsParams
+{
+    RgStructureType sType;
+    void*           pNext;
+    // Max value: 4
+    uint32_t        viewCount;
+} RgStartFrameViewsParams;
+
+// Can be linked after RgStartFrameInfo.
+// Frame pacing on a Vulkan swapchain with VK_KHR_present_wait, if supported.
+// rgStartFrame waits until the older presents reach the display, so CPU and GPU work
+// stays aligned to the display, instead of filling the presentation queue.
+typedef struct RgStartFrameFramePacingParams
+{
+    RgStructureType sType;
+    void*           pNext;
+    RgBool32        enable;
+    // Max count of presented frames that may not be on the display yet, when a frame starts.
+    // 0 gives the lowest latency, but CPU and GPU work of the frames won't overlap.
+    uint32_t        maxQueuedFrames;
+    // If not 0, rgStartFrame is throttled to this interval between the frame starts,
+    // in milliseconds. Works also without VK_KHR_present_wait.
+    float           targetFrameTime;
+} RgStartFrameFramePacingParams;
+
 typedef enum RgStaticSceneStatusFlagBits
 {
     RG_STATIC_SCENE_STATUS_LOADED            = 1,
     RG_STATIC_SCENE_STATUS_NEW_SCENE_STARTED = 2,
     RG_STATIC_SCENE_STATUS_EXPORT_STARTED    = 4,
+    // Files are being written on a background thread
+    RG_STATIC_SCENE_STATUS_EXPORT_IN_PROGRESS = 8,
+    // Set once, in the frame after the background export has successfully finished
+    RG_STATIC_SCENE_STATUS_EXPORT_FINISHED = 16,
 } RgStaticSceneStatusFlagBits;
 typedef uint32_t RgStaticSceneStatusFlags;
 
@@ -845,6 +1220,9 @@ typedef struct RgStartFrameInfo
     const uint8_t*  pLightstyleValues8;
     RgStaticSceneStatusFlags* pResultStaticSceneStatus;
     float           staticSceneAnimationTime;
+    // Reduce input latency on a Vulkan swapchain with VK_NV_low_latency2 or VK_AMD_anti_lag,
+    // if supported. DXGI swapchain uses NVIDIA Reflex, if DLSS3 is available.
+    RgBool32        lowLatency;
 } RgStartFrameInfo;
 
 typedef RgResult( RGAPI_PTR* PFN_rgStartFrame )( const RgStartFrameInfo* pInfo );
@@ -858,6 +1236,16 @@ typedef enum RgSkyType
     RG_SKY_TYPE_RASTERIZED_GEOMETRY,
 } RgSkyType;
 
+typedef enum RgSkyCubemapUpdate
+{
+    // Render all faces of the rasterized sky cubemap each frame.
+    RG_SKY_CUBEMAP_UPDATE_EVERY_FRAME,
+    // Render only if sky geometry, its textures, or viewer position were changed.
+    RG_SKY_CUBEMAP_UPDATE_IF_CHANGED,
+    // Render only if 'rasterizedSkyDirty' is true, or if the cubemap was never rendered.
+    RG_SKY_CUBEMAP_UPDATE_IF_DIRTY,
+} RgSkyCubemapUpdate;
+
 // Can be linked after RgDrawFrameInfo.
 typedef struct RgDrawFrameTonemappingParams
 {
@@ -902,6 +1290,12 @@ typedef struct RgDrawFrameSkyParams
     // If equals to zero, then default value is used.
     // Default: identity matrix.
     RgMatrix3D      skyCubemapRotationTransform;
+    // When to re-render the cubemap of RG_SKY_TYPE_RASTERIZED_GEOMETRY.
+    // Default: RG_SKY_CUBEMAP_UPDATE_EVERY_FRAME
+    RgSkyCubemapUpdate rasterizedSkyUpdate;
+    // If true, the rasterized sky cubemap is re-rendered on this frame regardless of
+    // 'rasterizedSkyUpdate'. E.g. if a sky texture was updated in place.
+    RgBool32        rasterizedSkyDirty;
 } RgDrawFrameSkyParams;
 
 // Can be linked after RgDrawFrameInfo.
@@ -925,6 +1319,31 @@ typedef struct RgDrawFrameTexturesParams
 } RgDrawFrameTexturesParams;
 
 // Can be linked after RgDrawFrameInfo.
+typedef enum RgIndirectIlluminationResolution
+{
+    RG_INDIRECT_ILLUMINATION_RESOLUTION_FULL,
+    // One ray per 2x2 pixels.
+    RG_INDIRECT_ILLUMINATION_RESOLUTION_HALF,
+    // One ray per 4x4 pixels.
+    RG_INDIRECT_ILLUMINATION_RESOLUTION_QUARTER,
+    // One ray per 2x1 pixels, in a checkerboard pattern that alternates every frame.
+    RG_INDIRECT_ILLUMINATION_RESOLUTION_CHECKERBOARD,
+} RgIndirectIlluminationResolution;
+
+// Source of random numbers for the stochastic passes:
+// BRDF sampling, light choosing and sampling a point on a light.
+typedef enum RgSampleSequence
+{
+    // Hashed per pixel and per frame.
+    RG_SAMPLE_SEQUENCE_WHITE_NOISE,
+    // Spatiotemporal blue noise: error is pushed to high frequencies in screen space
+    // and over frames, so the denoisers blur it out faster.
+    RG_SAMPLE_SEQUENCE_BLUE_NOISE,
+    // Owen-scrambled Sobol (0,2)-sequence, indexed by frame and decorrelated per pixel.
+    // Stratified over frames, so the temporal accumulation converges faster.
+    RG_SAMPLE_SEQUENCE_SOBOL,
+} RgSampleSequence;
+
 typedef struct RgDrawFrameIlluminationParams
 {
     RgStructureType sType;
@@ -957,6 +1376,58 @@ typedef struct RgDrawFrameIlluminationParams
     // E.g. first-person flashlight.
     // Null, if none.
     const uint64_t* lightUniqueIdIgnoreFirstPersonViewerShadows;
+    // If true, light candidates for direct and indirect illumination are chosen
+    // from a camera-relative grid of cells. Better for the scenes with hundreds of local lights.
+    // Default: false
+    RgBool32        enableLightGrid;
+    // Resolution at which indirect illumination rays are traced. If not full,
+    // a traced pixel is changed every frame, and others reuse the samples of the
+    // traced neighbors with a similar depth and normal.
+    // Default: RG_INDIRECT_ILLUMINATION_RESOLUTION_FULL
+    RgIndirectIlluminationResolution indirectResolution;
+    // If true, the amount of samples for direct and indirect illumination is reduced
+    // in the regions that were converged in the previous frame (low variance, long history),
+    // and increased in the noisy or disoccluded ones.
+    // Default: false
+    RgBool32        enableAdaptiveSampling;
+    // If true, indirect diffuse rays that hit distant surfaces, and the second bounce rays,
+    // terminate into a world-space cache of irradiance, instead of computing further illumination.
+    // This gives multi-bounce indirect diffuse at a roughly fixed cost.
+    // Default: false
+    RgBool32        enableIrradianceCache;
+    // Size of the side of a cache cell near the camera. Farther cells are larger.
+    // Default: 0.5
+    float           irradianceCacheCellSize;
+    // Fraction of the indirect rays that are fully traced to update the cache,
+    // even if they could terminate into it. In [0, 1].
+    // Default: 0.25
+    float           irradianceCacheUpdateRate;
+    // Default: RG_SAMPLE_SEQUENCE_WHITE_NOISE
+    RgSampleSequence sampleSequence;
+    // If true, visibility of the directional light from the static geometry is reprojected
+    // from the previous frames, instead of being traced for each pixel every frame.
+    // Shadows of the movable geometry are still traced every frame.
+    // Default: false
+    RgBool32        enableSunShadowCache;
+    // Fraction of the cached pixels that re-trace the visibility from the static geometry
+    // per frame, to refine soft shadows. In [0, 1].
+    // Default: 0.125
+    float           sunShadowCacheUpdateRate;
+    // ReSTIR budgets, counts are chosen per pixel in [min, max]: the max is used after
+    // a disocclusion, the min - where the history is long and the variance is low.
+    // If adaptive sampling is disabled, the max is always used.
+    // Light candidates per pixel for direct illumination, at most 10.
+    // Default: 4, 8
+    uint32_t        restirDirectCandidateCountMin;
+    uint32_t        restirDirectCandidateCountMax;
+    // Spatial neighbors to reuse for direct illumination, at most 10.
+    // Default: 2, 8
+    uint32_t        restirDirectSpatialCountMin;
+    uint32_t        restirDirectSpatialCountMax;
+    // Spatial neighbors to reuse for indirect illumination, at most 16.
+    // Default: 1, 2
+    uint32_t        restirIndirectSpatialCountMin;
+    uint32_t        restirIndirectSpatialCountMax;
 } RgDrawFrameIlluminationParams;
 
 // Can be linked after RgDrawFrameInfo.
@@ -992,6 +1463,14 @@ typedef struct RgDrawFrameVolumetricParams
     float           lightMultiplier;
     RgBool32        allowTintUnderwater;
     RgFloat3D       underwaterColor;
+    // Resolution of the froxel grid: screen-space XY and depth slices.
+    // Zero or a value bigger than 160x88x64 is clamped to it.
+    uint32_t        gridWidth;
+    uint32_t        gridHeight;
+    uint32_t        gridDepth;
+    // If true, only a quarter of froxels is traced each frame,
+    // others are reprojected from the previous frame.
+    RgBool32        temporalReprojection;
 } RgDrawFrameVolumetricParams;
 
 // Can be linked after RgDrawFrameInfo.
@@ -1164,8 +1643,78 @@ typedef struct RgDrawFrameReflectRefractParams
     float           waterTextureAreaScale;
     // If true, portal normal will be twirled around its 'inPosition'.
     RgBool32        portalNormalTwirl;
+    // Per-pixel termination of the reflection / refraction chain, before reaching
+    // 'maxReflectRefractDepth'. Portals are never terminated.
+    // Stop, if the throughput of a next bounce is lower than this value.
+    // Default: 0.01
+    float           minReflectRefractThroughput;
+    // Stop on a reflective surface that is rougher than this value, its specular
+    // is then left to the indirect illumination. If 1.0, disabled.
+    // Default: 1.0
+    float           maxReflectRefractRoughness;
+    // Stop, if the path length from the camera is longer than this value.
+    // If 0.0, disabled.
+    // Default: 0.0
+    float           maxReflectRefractDistance;
+    // If true, a terminated pixel takes the sky in the direction of the skipped bounce.
+    // Otherwise, the last hit surface is shaded as it is.
+    // Default: false
+    RgBool32        skyOnReflectRefractTermination;
 } RgDrawFrameReflectRefractParams;
 
+// Can be linked after RgDrawFrameInfo.
+// Dynamic geometry instances can be excluded from ray tracing on CPU, to make
+// the TLAS build and traversal cheaper. Static geometry is never culled.
+typedef struct RgDrawFrameInstanceCullingParams
+{
+    RgStructureType sType;
+    void*           pNext;
+    RgBool32        enable;
+    // Instances whose bounds are further than this distance from the camera are culled.
+    // If equals to 0.0, distance culling is disabled.
+    float           maxDistance;
+    // Instances whose bounds are outside of the camera frustum, expanded by this distance,
+    // are culled. Must cover the reach of reflections and indirect illumination.
+    // If negative, frustum culling is disabled.
+    float           frustumMargin;
+} RgDrawFrameInstanceCullingParams;
+
+// Can be linked after RgDrawFrameInfo.
+// Visibility of the level areas from the camera, e.g. from the PVS of a BSP level,
+// or from the area portals. Instances of invisible areas (see RgMeshAreaEXT) are excluded
+// from the TLAS, so primary, reflection and indirect rays don't hit them.
+// Instances without RgMeshAreaEXT, with areaIndex >= areaCount, first-person
+// and sky geometry are always visible.
+// Bitsets are arrays of (areaCount + 31) / 32 words:
+// area i is set, if (pBits[i / 32] >> (i % 32)) & 1.
+typedef struct RgDrawFrameAreaVisibilityParams
+{
+    RgStructureType sType;
+    void*           pNext;
+    RgBool32        enable;
+    uint32_t        areaCount;
+    const uint32_t* pVisibleAreas;
+    // Optional. Instances of invisible areas that are set in this bitset are still
+    // kept in the TLAS, but only for shadow rays: so the geometry that is not visible
+    // can still occlude the lights of the visible areas.
+    // If null, instances of invisible areas don't cast shadows.
+    const uint32_t* pShadowAreas;
+} RgDrawFrameAreaVisibilityParams;
+
+// Can be linked after RgDrawFrameInfo.
+// Cameras of the views that were requested by RgStartFrameViewsParams. View 0 always uses
+// the camera from rgUploadCamera, so 'pAdditionalCameras[i]' is for the view (i+1).
+// RgCameraInfo::aspect must be the aspect of one view. RgCameraInfo::pView and
+// RgCameraInfo::pNext must be null. If a camera is not provided, the view uses
+// the camera of view 0.
+typedef struct RgDrawFrameViewsParams
+{
+    RgStructureType     sType;
+    void*               pNext;
+    uint32_t            additionalCameraCount;
+    const RgCameraInfo* pAdditionalCameras;
+} RgDrawFrameViewsParams;
+
 typedef struct RgDrawFrameInfo
 {
     RgStructureType             sType;
@@ -1193,12 +1742,110 @@ typedef enum RgUtilImScratchTopology
     RG_UTIL_IM_SCRATCH_TOPOLOGY_QUADS,
 } RgUtilImScratchTopology;
 
+typedef enum RgUtilMemoryCategory
+{
+    RG_UTIL_MEMORY_CATEGORY_OTHER,
+    RG_UTIL_MEMORY_CATEGORY_FRAMEBUFFERS,
+    RG_UTIL_MEMORY_CATEGORY_TEXTURES,
+    RG_UTIL_MEMORY_CATEGORY_STATIC_GEOMETRY,
+    RG_UTIL_MEMORY_CATEGORY_DYNAMIC_GEOMETRY,
+    RG_UTIL_MEMORY_CATEGORY_ACCELERATION_STRUCTURES,
+    RG_UTIL_MEMORY_CATEGORY_SCRATCH,
+    RG_UTIL_MEMORY_CATEGORY_RESTIR,
+    RG_UTIL_MEMORY_CATEGORY_VOLUMETRIC,
+    RG_UTIL_MEMORY_CATEGORY_FLUID,
+    RG_UTIL_MEMORY_CATEGORY_CUBEMAPS,
+    // Host-visible memory that is not device-local: staging and readback buffers
+    RG_UTIL_MEMORY_CATEGORY_STAGING,
+    RG_UTIL_MEMORY_CATEGORY_COUNT,
+} RgUtilMemoryCategory;
+
+typedef struct RgUtilMemoryCategoryUsage
+{
+    size_t current;
+    // Max of 'current' since the instance creation
+    size_t peak;
+} RgUtilMemoryCategoryUsage;
+
 typedef struct RgUtilMemoryUsage
 {
-    size_t vramUsed;
-    size_t vramTotal;
+    size_t   vramUsed;
+    size_t   vramTotal;
+    // In the last frame: instances in TLAS, and instances culled
+    // by RgDrawFrameInstanceCullingParams and RgDrawFrameAreaVisibilityParams.
+    uint32_t tlasInstanceCount;
+    uint32_t tlasInstancesCulled;
+    // Memory pools of acceleration structures and their scratch buffers.
+    // Peak is the max usage between resets. Wasted are unused tails of the chunks
+    // in the last frame. Per-frame pools release the chunks that are idle for some time.
+    size_t   asPoolsAllocated;
+    size_t   asPoolsPeakUsed;
+    size_t   asPoolsWasted;
+    uint32_t asPoolsChunkCount;
+    // In the last frame: rasterized primitives, draw calls they were batched into,
+    // and pipeline binds between them.
+    uint32_t rasterizedDrawCount;
+    uint32_t rasterizedDrawCallCount;
+    uint32_t rasterizedPipelineSwitches;
+    // In the last frame: requested vertices / indices of rasterized geometry, and the current
+    // capacity of their buffers. Dropped primitives didn't fit, and will fit after regrowth.
+    uint32_t rasterizedVertexCount;
+    uint32_t rasterizedVertexCapacity;
+    uint32_t rasterizedIndexCount;
+    uint32_t rasterizedIndexCapacity;
+    uint32_t rasterizedDroppedCount;
+    // In the last frame: simulated fluid particles, and how many of them were out of view,
+    // so only gravity and collisions were applied to them.
+    uint32_t fluidParticleCount;
+    uint32_t fluidParticlesCulled;
+    // Memory allocated by the library, indexed by RgUtilMemoryCategory
+    RgUtilMemoryCategoryUsage categories[ RG_UTIL_MEMORY_CATEGORY_COUNT ];
 } RgUtilMemoryUsage;
 
+// GPU time in milliseconds, measured with timestamp queries. The values are of a frame
+// that was submitted a few frames ago. All zeros, if timestamps are not supported.
+typedef struct RgUtilFrameTimings
+{
+    float frame;
+    float accelerationStructures;
+    float vertexPreprocessing;
+    float primaryRays;
+    float reflectRefract;
+    float directIllumination;
+    float indirectIllumination;
+    float volumetric;
+    float denoiser;
+    // Zero, if an upscaler runs on DX12
+    float upscaler;
+    float bloom;
+    float postEffects;
+    float rasterization;
+    // CPU time from vkQueuePresentKHR to the image being on the display, of the last present
+    // that was waited by RgStartFrameFramePacingParams. Zero, if frame pacing is not active.
+    float presentLatency;
+} RgUtilFrameTimings;
+
+// CPU time of an instrumented zone, summed over all its calls in the last finished frame.
+// Zones are collected only if the library was built with RG_WITH_CPU_PROFILING.
+typedef struct RgUtilCpuZone
+{
+    const char* pName;
+    float       timeMs;
+    uint32_t    callCount;
+} RgUtilCpuZone;
+
+// The latest finished frame of a headless instance, see RgHeadlessCreateInfo.
+// Pixels are R8G8B8A8 in sRGB, rows are tightly packed. Valid until rgDrawFrame.
+typedef struct RgUtilHeadlessFrame
+{
+    // Null, if the instance is not headless, or no frame has been finished yet
+    const void* pPixels;
+    uint32_t    width;
+    uint32_t    height;
+    // Count of rgDrawFrame calls before the frame was drawn
+    uint64_t    frameNumber;
+} RgUtilHeadlessFrame;
+
 typedef enum RgFeatureFlagBits
 {
     RG_FEATURE_HDR      = 1,
@@ -1208,10 +1855,19 @@ typedef uint32_t RgFeatureFlags;
 
 typedef RgPrimitiveVertex*  ( RGAPI_PTR* PFN_rgUtilScratchAllocForVertices      )( uint32_t vertexCount );
 typedef void                ( RGAPI_PTR* PFN_rgUtilScratchFree                  )( const RgPrimitiveVertex* pPointer );
+// Reserve vertices in the staging memory of the current frame's dynamic geometry,
+// valid until rgDrawFrame. Fill them in place and set as pVertices of a dynamic primitive,
+// to upload it without copying the vertices. The memory might be write-combined:
+// write sequentially, don't read. Null, if out of space.
+typedef RgPrimitiveVertex*  ( RGAPI_PTR* PFN_rgUtilStagingAllocForVertices      )( uint32_t vertexCount );
 typedef void                ( RGAPI_PTR* PFN_rgUtilScratchGetIndices            )( RgUtilImScratchTopology topology, uint32_t vertexCount, const uint32_t** ppOutIndices, uint32_t* pOutIndexCount );
 typedef void                ( RGAPI_PTR* PFN_rgUtilImScratchClear               )();
 typedef void                ( RGAPI_PTR* PFN_rgUtilImScratchStart               )( RgUtilImScratchTopology topology );
 typedef void                ( RGAPI_PTR* PFN_rgUtilImScratchVertex              )( float x, float y, float z ); // Push vertex to a list
+// Push 'count' vertices at once. 'pPositions' and 'pNormals' are 3 floats per vertex,
+// 'pTexCoords' is 2. Optional arrays can be null: then the values set by
+// rgUtilImScratchNormal / TexCoord / Color are used
+typedef void                ( RGAPI_PTR* PFN_rgUtilImScratchVertices            )( const float* pPositions, const float* pNormals, const float* pTexCoords, const RgColor4DPacked32* pColors, uint32_t count );
 typedef void                ( RGAPI_PTR* PFN_rgUtilImScratchNormal              )( float x, float y, float z );
 typedef void                ( RGAPI_PTR* PFN_rgUtilImScratchTexCoord            )( float u, float v );
 typedef void                ( RGAPI_PTR* PFN_rgUtilImScratchTexCoord_Layer1     )( float u, float v );
@@ -1229,6 +1885,19 @@ typedef RgColor4DPacked32   ( RGAPI_PTR* PFN_rgUtilPackColorFloat4D
 typedef RgNormalPacked32    ( RGAPI_PTR* PFN_rgUtilPackNormal                   )( float x, float y, float z );
 typedef void                ( RGAPI_PTR* PFN_rgUtilExportAsTGA                  )( const void* pPixels, uint32_t width, uint32_t height, const char* pPath );
 typedef RgFeatureFlags      ( RGAPI_PTR* PFN_rgUtilGetSupportedFeatures         )();
+typedef RgUtilFrameTimings  ( RGAPI_PTR* PFN_rgUtilGetFrameTimings              )();
+// Copy up to 'maxZoneCount' zones to 'pOutZones'. Returns the count written.
+// If 'pOutZones' is null, returns the count available.
+typedef uint32_t            ( RGAPI_PTR* PFN_rgUtilGetCpuZones                  )( RgUtilCpuZone* pOutZones, uint32_t maxZoneCount );
+// Doesn't wait for the GPU: call between rgStartFrame and rgDrawFrame to get the frame
+// that was drawn 'framesInFlight' frames ago.
+typedef RgUtilHeadlessFrame ( RGAPI_PTR* PFN_rgUtilGetHeadlessFrame             )();
+// Called by rgUtilReplayCapture after each replayed rgDrawFrame.
+// Return false to stop the replay.
+typedef RgBool32 ( *PFN_rgUtilReplayOnFrame )( uint32_t frameIndex, void* pUserData );
+// Feed a file recorded with RgInstanceCreateInfo::pApiCaptureFilePath back into this instance,
+// as fast as possible. Blocks until the last frame of the capture, or 'pfnOnFrame' returned false.
+typedef RgResult            ( RGAPI_PTR* PFN_rgUtilReplayCapture                )( const char* pCaptureFilePath, PFN_rgUtilReplayOnFrame pfnOnFrame, void* pUserData );
 
 
 
@@ -1271,6 +1940,18 @@ typedef struct RgInterface
     PFN_rgUtilGetSupportedFeatures        rgUtilGetSupportedFeatures;
     // Additional
     PFN_rgSpawnFluid                      rgSpawnFluid;
+    PFN_rgUtilGetFrameTimings             rgUtilGetFrameTimings;
+    PFN_rgUtilGetCpuZones                 rgUtilGetCpuZones;
+    PFN_rgRegisterName                    rgRegisterName;
+    PFN_rgCreateMesh                      rgCreateMesh;
+    PFN_rgUpdateMeshTransform             rgUpdateMeshTransform;
+    PFN_rgDestroyMesh                     rgDestroyMesh;
+    PFN_rgUtilImScratchVertices           rgUtilImScratchVertices;
+    PFN_rgUtilGetHeadlessFrame            rgUtilGetHeadlessFrame;
+    PFN_rgUtilReplayCapture               rgUtilReplayCapture;
+    PFN_rgRequestReadback                 rgRequestReadback;
+    PFN_rgUploadMeshPrimitives            rgUploadMeshPrimitives;
+    PFN_rgUtilStagingAllocForVertices     rgUtilStagingAllocForVertices;
 } RgInterface;
 
 #if defined( _WIN32 )
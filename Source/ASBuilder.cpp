@@ -53,7 +53,10 @@ auto ASBuilder::GetBuildSizes( VkDevice
                                VkAccelerationStructureTypeKHR                        type,
                                std::span< const VkAccelerationStructureGeometryKHR > geometries,
                                std::span< const uint32_t > maxPrimitiveCountPerGeometry,
-                               bool fastTrace ) -> VkAccelerationStructureBuildSizesInfoKHR
+                               bool                        fastTrace,
+                               bool                        allowCompaction,
+                               bool                        allowUpdate,
+                               bool lowMemory ) -> VkAccelerationStructureBuildSizesInfoKHR
 {
     assert( !geometries.empty() );
     assert( geometries.size() == maxPrimitiveCountPerGeometry.size() );
@@ -62,6 +65,22 @@ auto ASBuilder::GetBuildSizes( VkDevice
         fastTrace ? VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR
                   : VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
 
+    if( allowCompaction )
+    {
+        flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+    }
+
+    // otherwise, updateScratchSize is not guaranteed to be valid
+    if( allowUpdate )
+    {
+        flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+    }
+
+    if( lowMemory )
+    {
+        flags |= VK_BUILD_ACCELERATION_STRUCTURE_LOW_MEMORY_BIT_KHR;
+    }
+
     // mode, srcAccelerationStructure, dstAccelerationStructure
     // and all VkDeviceOrHostAddressKHR except transformData are ignored
     // in vkGetAccelerationStructureBuildSizesKHR(..)
@@ -94,7 +113,9 @@ void ASBuilder::AddBLAS( VkAccelerationStructureKHR
                          const VkAccelerationStructureBuildSizesInfoKHR&             buildSizes,
                          bool                                                        fastTrace,
                          bool                                                        update,
-                         bool isBLASUpdateable )
+                         bool isBLASUpdateable,
+                         bool allowCompaction,
+                         bool lowMemory )
 {
     assert( as );
 
@@ -116,6 +137,16 @@ void ASBuilder::AddBLAS( VkAccelerationStructureKHR
         flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
     }
 
+    if( allowCompaction )
+    {
+        flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+    }
+
+    if( lowMemory )
+    {
+        flags |= VK_BUILD_ACCELERATION_STRUCTURE_LOW_MEMORY_BIT_KHR;
+    }
+
     auto buildInfo = VkAccelerationStructureBuildGeometryInfoKHR{
         .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
         .type  = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
@@ -136,6 +167,48 @@ void ASBuilder::AddBLAS( VkAccelerationStructureKHR
     bottomLBuildInfo.rangeInfos.push_back( rangeInfos.data() );
 }
 
+void ASBuilder::AddBLASUpdate(
+    VkAccelerationStructureKHR                                  dst,
+    VkAccelerationStructureKHR                                  src,
+    std::span< const VkAccelerationStructureGeometryKHR >       geometries,
+    std::span< const VkAccelerationStructureBuildRangeInfoKHR > rangeInfos,
+    const VkAccelerationStructureBuildSizesInfoKHR&             buildSizes,
+    bool                                                        fastTrace )
+{
+    assert( dst && src );
+
+    // while building bottom level, top level must be not
+    assert( topLBuildInfo.geomInfos.empty() && topLBuildInfo.rangeInfos.empty() );
+
+    assert( !geometries.empty() );
+    assert( geometries.size() == rangeInfos.size() );
+
+    VkBuildAccelerationStructureFlagsKHR flags =
+        fastTrace ? VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR
+                  : VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
+
+    // must be the same as on the initial build
+    flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+
+    auto buildInfo = VkAccelerationStructureBuildGeometryInfoKHR{
+        .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
+        .type  = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+        .flags = flags | AdditionalFlags(),
+        .mode  = VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR,
+        .srcAccelerationStructure = src,
+        .dstAccelerationStructure = dst,
+        .geometryCount            = static_cast<uint32_t>(geometries.size()),
+        .pGeometries              = geometries.data(),
+        .ppGeometries             = nullptr,
+        .scratchData = {
+            .deviceAddress = scratchBuffer->Push( buildSizes.updateScratchSize ).address,
+        },
+    };
+
+    bottomLBuildInfo.geomInfos.push_back( buildInfo );
+    bottomLBuildInfo.rangeInfos.push_back( rangeInfos.data() );
+}
+
 bool ASBuilder::BuildBottomLevel( VkCommandBuffer cmd )
 {
     auto label = CmdLabel{ cmd, "Build BLAS" };
@@ -160,12 +233,19 @@ bool ASBuilder::BuildBottomLevel( VkCommandBuffer cmd )
     return true;
 }
 
+void ASBuilder::ClearBottomLevel()
+{
+    bottomLBuildInfo.geomInfos.clear();
+    bottomLBuildInfo.rangeInfos.clear();
+}
+
 void ASBuilder::AddTLAS( VkAccelerationStructureKHR                      as,
                          const VkAccelerationStructureGeometryKHR*       instance,
                          const VkAccelerationStructureBuildRangeInfoKHR* rangeInfo,
                          const VkAccelerationStructureBuildSizesInfoKHR& buildSizes,
                          bool                                            fastTrace,
-                         bool                                            update )
+                         bool                                            update,
+                         bool isTLASUpdateable )
 {
     assert( as );
 
@@ -178,6 +258,12 @@ void ASBuilder::AddTLAS( VkAccelerationStructureKHR                      as,
         fastTrace ? VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR
                   : VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
 
+    // must be the same as on the initial build
+    if( isTLASUpdateable || update )
+    {
+        flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+    }
+
     VkAccelerationStructureBuildGeometryInfoKHR buildInfo = {
         .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR,
         .type  = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
@@ -53,20 +53,35 @@ public:
                   const VkAccelerationStructureBuildSizesInfoKHR&             buildSizes,
                   bool                                                        fastTrace,
                   bool                                                        update,
-                  bool                                                        isBLASUpdateable );
+                  bool                                                        isBLASUpdateable,
+                  bool allowCompaction = false,
+                  bool lowMemory       = false );
+
+    // Refit 'dst' using 'src' as a source, 'src' must have been built with
+    // isBLASUpdateable=true and with the same topology. 'dst' can be equal to 'src'
+    void AddBLASUpdate( VkAccelerationStructureKHR                                  dst,
+                        VkAccelerationStructureKHR                                  src,
+                        std::span< const VkAccelerationStructureGeometryKHR >       geometries,
+                        std::span< const VkAccelerationStructureBuildRangeInfoKHR > rangeInfos,
+                        const VkAccelerationStructureBuildSizesInfoKHR&             buildSizes,
+                        bool                                                        fastTrace );
 
     bool BuildBottomLevel( VkCommandBuffer cmd );
+    // Drop added BLAS-es without building, e.g. if their content was loaded from elsewhere
+    void ClearBottomLevel();
 
 
     // pGeometry is a pointer to one AS geometry,
     // pRangeInfo is a pointer to build range info.
-    // All pointers must be valid until BuildTopLevel is called
+    // All pointers must be valid until BuildTopLevel is called.
+    // If 'update', 'as' is refitted in place, it must have been built with isTLASUpdateable=true
     void AddTLAS( VkAccelerationStructureKHR                      as,
                   const VkAccelerationStructureGeometryKHR*       instance,
                   const VkAccelerationStructureBuildRangeInfoKHR* rangeInfo,
                   const VkAccelerationStructureBuildSizesInfoKHR& buildSizes,
                   bool                                            fastTrace,
-                  bool                                            update );
+                  bool                                            update,
+                  bool                                            isTLASUpdateable = false );
 
     bool BuildTopLevel( VkCommandBuffer cmd );
 
@@ -74,25 +89,52 @@ public:
     static auto GetBottomBuildSizes( VkDevice                                  device,
                                      const VkAccelerationStructureGeometryKHR& geometry,
                                      const uint32_t maxPrimitiveCountPerGeometry,
-                                     bool           fastTrace )
+                                     bool           fastTrace,
+                                     bool           allowCompaction = false,
+                                     bool           allowUpdate     = false,
+                                     bool           lowMemory       = false )
     {
         return GetBuildSizes( device,
                               VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
                               { &geometry, 1 },
                               { &maxPrimitiveCountPerGeometry, 1 },
-                              fastTrace );
+                              fastTrace,
+                              allowCompaction,
+                              allowUpdate,
+                              lowMemory );
+    }
+
+    static auto GetBottomBuildSizes(
+        VkDevice                                              device,
+        std::span< const VkAccelerationStructureGeometryKHR > geometries,
+        std::span< const uint32_t >                           maxPrimitiveCountPerGeometry,
+        bool                                                  fastTrace,
+        bool                                                  allowCompaction = false )
+    {
+        return GetBuildSizes( device,
+                              VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+                              geometries,
+                              maxPrimitiveCountPerGeometry,
+                              fastTrace,
+                              allowCompaction,
+                              false,
+                              false );
     }
 
     static auto GetTopBuildSizes( VkDevice                                  device,
                                   const VkAccelerationStructureGeometryKHR& instance,
                                   uint32_t maxPrimitiveCountInInstance,
-                                  bool     fastTrace )
+                                  bool     fastTrace,
+                                  bool     allowUpdate = false )
     {
         return GetBuildSizes( device,
                               VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
                               { &instance, 1 },
                               { &maxPrimitiveCountInInstance, 1 },
-                              fastTrace );
+                              fastTrace,
+                              false,
+                              allowUpdate,
+                              false );
     }
 
 private:
@@ -100,7 +142,10 @@ private:
                                VkAccelerationStructureTypeKHR                        type,
                                std::span< const VkAccelerationStructureGeometryKHR > geometries,
                                std::span< const uint32_t > maxPrimitiveCountPerGeometry,
-                               bool fastTrace ) -> VkAccelerationStructureBuildSizesInfoKHR;
+                               bool                        fastTrace,
+                               bool                        allowCompaction,
+                               bool                        allowUpdate,
+                               bool lowMemory ) -> VkAccelerationStructureBuildSizesInfoKHR;
 
 private:
     std::shared_ptr< ChunkedStackAllocator > scratchBuffer;
@@ -82,6 +82,13 @@ void RTGL1::ASComponent::DestroyAS()
     }
     asSize = 0;
     asAddress = 0;
+
+    if( pool )
+    {
+        pool->Free( pooled );
+        pool   = nullptr;
+        pooled = {};
+    }
 }
 
 bool RTGL1::ASComponent::RecreateIfNotValid(
@@ -111,3 +118,55 @@ bool RTGL1::ASComponent::RecreateIfNotValid(
     }
     return false;
 }
+
+bool RTGL1::ASComponent::RecreateIfNotValid(
+    const VkAccelerationStructureBuildSizesInfoKHR& buildSizes, ChunkedPoolAllocator& _pool )
+{
+    if( !as || asSize < buildSizes.accelerationStructureSize )
+    {
+        // destroy, and return the previous range to its pool
+        DestroyAS();
+
+        pooled = _pool.Alloc( buildSizes.accelerationStructureSize );
+        pool   = &_pool;
+
+        as = CreateAS( pooled.buffer, pooled.offsetInBuffer, buildSizes.accelerationStructureSize );
+        asSize = buildSizes.accelerationStructureSize;
+        asAddress = FetchASAddress( device, as );
+
+        return true;
+    }
+    return false;
+}
+
+auto RTGL1::ASComponent::RecordCompactedCopy( VkCommandBuffer        cmd,
+                                              VkDeviceSize           compactedSize,
+                                              ChunkedStackAllocator& allocator )
+    -> VkAccelerationStructureKHR
+{
+    assert( as );
+    assert( compactedSize > 0 && compactedSize <= asSize );
+    // the original AS is destroyed by the caller, so its pooled range would leak
+    assert( !pool );
+
+    const auto allocation = allocator.Push( compactedSize );
+
+    VkAccelerationStructureKHR compacted =
+        CreateAS( allocation.buffer, allocation.offsetInBuffer, compactedSize );
+
+    auto info = VkCopyAccelerationStructureInfoKHR{
+        .sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR,
+        .src   = as,
+        .dst   = compacted,
+        .mode  = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR,
+    };
+    svkCmdCopyAccelerationStructureKHR( cmd, &info );
+
+    VkAccelerationStructureKHR original = as;
+
+    as        = compacted;
+    asSize    = compactedSize;
+    asAddress = FetchASAddress( device, as );
+
+    return original;
+}
@@ -45,6 +45,17 @@ public:
     bool RecreateIfNotValid( const VkAccelerationStructureBuildSizesInfoKHR& buildSizes,
                              ChunkedStackAllocator&                          allocator,
                              bool                                            resetAllocOnCreate = false );
+    // Same, but the AS memory is taken from 'pool' and returned to it on destruction,
+    // so 'pool' must outlive this component
+    bool RecreateIfNotValid( const VkAccelerationStructureBuildSizesInfoKHR& buildSizes,
+                             ChunkedPoolAllocator&                           pool );
+
+    // Create AS of 'compactedSize' in 'allocator' and record a compacting copy to it.
+    // Returns the original AS, it must be destroyed after 'cmd' is completed
+    [[nodiscard]] auto RecordCompactedCopy( VkCommandBuffer        cmd,
+                                            VkDeviceSize           compactedSize,
+                                            ChunkedStackAllocator& allocator )
+        -> VkAccelerationStructureKHR;
 
     [[nodiscard]] VkAccelerationStructureKHR GetAS() const
     {
@@ -52,6 +63,8 @@ public:
         return as;
     }
 
+    [[nodiscard]] VkDeviceSize GetASSize() const { return asSize; }
+
     [[nodiscard]] VkDeviceAddress GetASAddress() const
     {
         assert( asAddress != 0 );
@@ -72,6 +85,9 @@ protected:
     VkDeviceSize               asSize;
     VkDeviceSize               asAddress;
 
+    ChunkedPoolAllocator*            pool{ nullptr };
+    ChunkedPoolAllocator::Allocation pooled{};
+
     const char* debugName;
 };
 
@@ -20,17 +20,30 @@
 
 #include "ASManager.h"
 
+#include "BatchMath.h"
 #include "CmdLabel.h"
+#include "CpuProfiler.h"
 #include "DrawFrameInfo.h"
 #include "Fluid.h"
 #include "GeomInfoManager.h"
+#include "LibraryConfig.h"
 #include "Matrix.h"
+#include "TriangleSplitting.h"
 #include "Utils.h"
 
 #include "Generated/ShaderCommonC.h"
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cfloat>
 #include <cstring>
+#include <format>
+
+namespace RTGL1
+{
+extern bool g_supportsOpacityMicromap;
+}
 
 namespace
 {
@@ -49,10 +62,293 @@ bool IsFastTrace( RTGL1::VertexCollectorFilterTypeFlags filter )
     return !IsFastBuild( filter );
 }
 
+// full TLAS rebuild after this count of refits
+constexpr uint32_t TLAS_MAX_REFIT_COUNT = 32;
+
+// dynamic primitive with the same content for this count of frames is promoted
+constexpr uint32_t DYNAMIC_PROMOTION_FRAME_COUNT = 8;
+
+// static BLAS that is built again within this count of frames is a quick rebuild;
+// after a few of them in a row, the primitive is built for a fast build
+constexpr uint64_t STATIC_QUICK_REBUILD_FRAME_COUNT     = 300;
+constexpr uint32_t STATIC_QUICK_REBUILDS_FOR_FAST_BUILD = 2;
+
+// cached dynamic BLAS with the same content for this count of frames is rebuilt once
+// for a fast trace; only a few per frame, to spread the cost
+constexpr uint64_t DYNAMIC_LONG_LIVED_FRAME_COUNT        = 120;
+constexpr uint32_t DYNAMIC_LONG_LIVED_REBUILDS_PER_FRAME = 4;
+
+// dynamic BLAS, which is rebuilt each frame, of this size prefers low memory
+constexpr uint32_t DYNAMIC_LOW_MEMORY_TRIANGLE_COUNT = 65536;
+
+auto TracePolicy() -> RTGL1::BLASBuildPolicy
+{
+    return RTGL1::LibConfig().blasCompaction ? RTGL1::BLASBuildPolicy::FastTraceCompacted
+                                             : RTGL1::BLASBuildPolicy::FastTrace;
+}
+
+auto DynamicBuildPolicy( uint32_t triangleCount ) -> RTGL1::BLASBuildPolicy
+{
+    if( RTGL1::LibConfig().adaptiveBlasFlags &&
+        triangleCount >= DYNAMIC_LOW_MEMORY_TRIANGLE_COUNT )
+    {
+        return RTGL1::BLASBuildPolicy::FastBuildLowMemory;
+    }
+    return RTGL1::BLASBuildPolicy::FastBuild;
+}
+
+// per-frame allocators release chunks that were not used for this count of frames;
+// must be larger than MAX_FRAMES_IN_FLIGHT, as frames in flight might use them
+constexpr uint32_t TRANSIENT_ALLOC_TRIM_FRAME_COUNT = 300;
+
+// dynamic vertex buffers are created with this capacity, and grow up to dynamicMaxVertexCount
+constexpr uint32_t DYNAMIC_INITIAL_VERTEX_COUNT = 262144;
+// dynamic vertex buffers are halved, if less than a quarter was used for this count of frames
+constexpr uint32_t DYNAMIC_SHRINK_FRAME_COUNT = 600;
+
+// dynamic primitives up to this size are merged into batches
+constexpr uint32_t DYNAMIC_BATCH_MAX_PRIMITIVE_TRIANGLES = 64;
+constexpr uint32_t DYNAMIC_BATCH_MAX_VERTEX_COUNT        = 65536;
+// primitive indices of the app are 32-bit, so the ones of batches are above that range,
+// and can't collide with a real primitive, whatever its object ID is
+constexpr uint64_t DYNAMIC_BATCH_PRIMITIVE_INDEX_BIT = uint64_t{ 1 } << 32;
+
 uint32_t floatToUint8( float v )
 {
     return static_cast< uint32_t >( std::clamp( v, 0.f, 1.f ) * 255.f );
 }
+
+uint64_t HashPrimitiveContent( const RgMeshPrimitiveInfo& primitive )
+{
+    using ankerl::unordered_dense::detail::wyhash::hash;
+
+    uint64_t h = hash( primitive.pVertices, sizeof( RgPrimitiveVertex ) * primitive.vertexCount );
+    if( RTGL1::Utils::HasIndices( primitive ) )
+    {
+        const auto     indices = RTGL1::Utils::GetIndexData( primitive );
+        const uint64_t hi      = hash( indices.data(), indices.size() );
+        h ^= hi + 0x9e3779b9 + ( h << 6 ) + ( h >> 2 );
+    }
+    return h;
+}
+
+uint64_t HashPrimitiveIndices( const RgMeshPrimitiveInfo& primitive )
+{
+    if( RTGL1::Utils::HasIndices( primitive ) )
+    {
+        const auto indices = RTGL1::Utils::GetIndexData( primitive );
+        return ankerl::unordered_dense::detail::wyhash::hash( indices.data(), indices.size() );
+    }
+    return 0;
+}
+
+// primitives with the same key can be merged, as their geometry infos differ only by vertices
+uint64_t HashBatchKey( const RgMeshInfo&                     mesh,
+                       const RgMeshPrimitiveInfo&            primitive,
+                       RTGL1::VertexCollectorFilterTypeFlags geomFlags )
+{
+    using ankerl::unordered_dense::detail::wyhash::hash;
+
+    const uint64_t params[] = {
+        uint32_t( geomFlags ),
+        mesh.flags,
+        primitive.flags,
+        primitive.textureFrame,
+        primitive.color,
+        std::bit_cast< uint32_t >( primitive.emissive ),
+        std::bit_cast< uint32_t >( primitive.classicLight ),
+    };
+
+    uint64_t h = hash( params, sizeof( params ) );
+    if( primitive.pTextureName )
+    {
+        const uint64_t ht = hash( primitive.pTextureName, strlen( primitive.pTextureName ) );
+        h ^= ht + 0x9e3779b9 + ( h << 6 ) + ( h >> 2 );
+    }
+    return h;
+}
+
+// identical dynamic primitives with the same key share vertex data and BLAS in a frame;
+// flags are included, as they define BLAS geometry flags and normals generation
+uint64_t HashInstancingKey( const RgMeshInfo&                     mesh,
+                            const RgMeshPrimitiveInfo&            primitive,
+                            RTGL1::VertexCollectorFilterTypeFlags geomFlags )
+{
+    using ankerl::unordered_dense::detail::wyhash::hash;
+
+    const uint64_t params[] = {
+        uint32_t( geomFlags ),
+        mesh.flags,
+        primitive.flags,
+        primitive.vertexCount,
+        primitive.indexCount,
+        primitive.pIndices16 ? 1u : 0u,
+    };
+
+    uint64_t h = hash( params, sizeof( params ) );
+    h ^= HashPrimitiveContent( primitive ) + 0x9e3779b9 + ( h << 6 ) + ( h >> 2 );
+    return h;
+}
+
+// mesh-space AABB of the bind pose vertices
+auto MakeLocalBounds( const RgMeshPrimitiveInfo& primitive )
+    -> std::pair< std::array< float, 3 >, std::array< float, 3 > >
+{
+    auto b = RTGL1::BatchMath::ComputeBounds( primitive.pVertices, primitive.vertexCount );
+    return { b.min, b.max };
+}
+
+auto MakeBoundingSphere( const std::array< float, 3 >& mn,
+                         const std::array< float, 3 >& mx,
+                         const RgTransform&            transform ) -> std::pair< RgFloat3D, float >
+{
+    const auto& m = transform.matrix;
+
+    const float c[ 3 ] = {
+        ( mn[ 0 ] + mx[ 0 ] ) * 0.5f,
+        ( mn[ 1 ] + mx[ 1 ] ) * 0.5f,
+        ( mn[ 2 ] + mx[ 2 ] ) * 0.5f,
+    };
+    const float e[ 3 ] = {
+        ( mx[ 0 ] - mn[ 0 ] ) * 0.5f,
+        ( mx[ 1 ] - mn[ 1 ] ) * 0.5f,
+        ( mx[ 2 ] - mn[ 2 ] ) * 0.5f,
+    };
+
+    RgFloat3D center;
+    float     radiusSq = 0;
+    for( int i = 0; i < 3; i++ )
+    {
+        center.data[ i ] = m[ i ][ 0 ] * c[ 0 ] + m[ i ][ 1 ] * c[ 1 ] + m[ i ][ 2 ] * c[ 2 ] +
+                           m[ i ][ 3 ];
+
+        // extent of the transformed AABB
+        const float ext = std::abs( m[ i ][ 0 ] ) * e[ 0 ] + std::abs( m[ i ][ 1 ] ) * e[ 1 ] +
+                          std::abs( m[ i ][ 2 ] ) * e[ 2 ];
+        radiusSq += ext * ext;
+    }
+
+    return { center, std::sqrt( radiusSq ) };
+}
+
+// conservative world-space bounding sphere of a primitive
+auto MakeBoundingSphere( const RgMeshPrimitiveInfo& primitive, const RgTransform& transform )
+    -> std::pair< RgFloat3D, float >
+{
+    const auto& m = transform.matrix;
+
+    if( !primitive.pVertices || primitive.vertexCount == 0 )
+    {
+        return { RgFloat3D{ m[ 0 ][ 3 ], m[ 1 ][ 3 ], m[ 2 ][ 3 ] }, 0.0f };
+    }
+
+    const auto [ mn, mx ] = MakeLocalBounds( primitive );
+    return MakeBoundingSphere( mn, mx, transform );
+}
+
+// A skinned vertex is a convex combination of the vertex transformed by its bones,
+// so it's inside the union of the bind pose bounds transformed by each bone
+auto MakeSkinnedBoundingSphere( const RgMeshPrimitiveInfo&        primitive,
+                                const RgMeshPrimitiveSkinningEXT& skin,
+                                const RgTransform&                transform )
+    -> std::pair< RgFloat3D, float >
+{
+    using namespace RTGL1;
+
+    const auto bind = BatchMath::ComputeBounds( primitive.pVertices, primitive.vertexCount );
+    const auto all  = BatchMath::TransformBoundsUnion( skin.pBoneTransforms, skin.boneCount, bind );
+
+    return MakeBoundingSphere( all.min, all.max, transform );
+}
+
+auto MakeParticlesBoundingSphere( const RgMeshPrimitiveParticlesEXT& particles,
+                                  const RgTransform&                 transform )
+    -> std::pair< RgFloat3D, float >
+{
+    const auto [ mn, mx ] = RTGL1::ParticleExpansion::MakeLocalBounds( particles );
+    return MakeBoundingSphere( mn, mx, transform );
+}
+
+// where the vertices and indices of the uploaded geometry are, for fetching them in shaders
+void WriteGeometryLocation( RTGL1::ShGeometryInstance&                 dst,
+                            const RTGL1::VertexCollector::UploadResult& geometry )
+{
+    using namespace RTGL1;
+
+    dst.baseVertexIndex = geometry.firstVertex;
+    dst.baseIndexIndex  = geometry.firstIndex ? *geometry.firstIndex : UINT32_MAX;
+
+    // values ignored if doesn't exist
+    dst.firstVertex_Layer1 = geometry.firstVertex_Layer1;
+    dst.firstVertex_Layer2 = geometry.firstVertex_Layer2;
+    dst.firstVertex_Layer3 = geometry.firstVertex_Layer3;
+
+    if( geometry.asGeometryInfo.geometry.triangles.indexType == VK_INDEX_TYPE_UINT16 )
+    {
+        dst.flags |= GEOM_INST_FLAG_INDICES_16BIT;
+    }
+    if( const auto& dq = geometry.dequant )
+    {
+        dst.flags |= GEOM_INST_FLAG_QUANTIZED_VERTICES;
+        RG_SET_VEC3_A( dst.dequantCenter, dq->center.data );
+        RG_SET_VEC3_A( dst.dequantExtent, dq->extent.data );
+    }
+    {
+        // positions are at the start of a vertex, so the BLAS input addresses
+        // also point at the first vertex / first index of the geometry
+        static_assert( offsetof( ShVertex, position ) == 0 );
+        static_assert( offsetof( ShVertexQuantized, positionXY ) == 0 );
+
+        const auto& tri = geometry.asGeometryInfo.geometry.triangles;
+
+        dst.vertexBufferAddress[ 0 ] = uint32_t( tri.vertexData.deviceAddress );
+        dst.vertexBufferAddress[ 1 ] = uint32_t( tri.vertexData.deviceAddress >> 32 );
+        dst.indexBufferAddress[ 0 ]  = uint32_t( tri.indexData.deviceAddress );
+        dst.indexBufferAddress[ 1 ]  = uint32_t( tri.indexData.deviceAddress >> 32 );
+    }
+}
+
+// order all previous commands in the queue before the next ones
+void FullMemoryBarrier( VkCommandBuffer cmd )
+{
+    auto barrier = VkMemoryBarrier{
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+    };
+
+    vkCmdPipelineBarrier( cmd,
+                          VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                          VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                          0,
+                          1,
+                          &barrier,
+                          0,
+                          nullptr,
+                          0,
+                          nullptr );
+}
+
+// make results of AS building visible to AS commands (copy, property query)
+void ASBuildToASCopyBarrier( VkCommandBuffer cmd )
+{
+    auto barrier = VkMemoryBarrier{
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+        .dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR,
+    };
+
+    vkCmdPipelineBarrier( cmd,
+                          VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                          VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                          0,
+                          1,
+                          &barrier,
+                          0,
+                          nullptr,
+                          0,
+                          nullptr );
+}
 }
 
 RTGL1::ASManager::ASManager( VkDevice                                _device,
@@ -60,11 +356,15 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
                              std::shared_ptr< MemoryAllocator >      _allocator,
                              std::shared_ptr< CommandBufferManager > _cmdManager,
                              std::shared_ptr< GeomInfoManager >      _geomInfoManager,
+                             const GlobalUniform&                    _uniform,
+                             const ShaderManager&                    _shaderManager,
                              uint64_t                                _maxReplacementsVerts,
                              uint64_t                                _maxDynamicVerts,
+                             uint32_t                                _maxInstanceCount,
                              bool                                    _enableTexCoordLayer1,
                              bool                                    _enableTexCoordLayer2,
-                             bool                                    _enableTexCoordLayer3 )
+                             bool                                    _enableTexCoordLayer3,
+                             bool                                    _quantizeStaticVertices )
     : device( _device )
     , allocator( std::move( _allocator ) )
     , staticCopyFence( VK_NULL_HANDLE )
@@ -90,9 +390,49 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
             32 * 1024 * 1024,
             scratchOffsetAligment,
-            "Scratch buffer" );
+            "Scratch buffer",
+            TRANSIENT_ALLOC_TRIM_FRAME_COUNT );
 
         asBuilder = std::make_unique< ASBuilder >( scratchBuffer );
+
+        if( g_supportsOpacityMicromap )
+        {
+            ommBuilder =
+                std::make_unique< OpacityMicromapBuilder >( device, allocator, scratchBuffer );
+        }
+
+        if( LibConfig().staticBlasCache )
+        {
+            diskCache = std::make_unique< BLASDiskCache >( device, _physDevice, allocator );
+        }
+
+        asyncBuild = LibConfig().asyncBlasBuild && cmdManager->HasAsyncCompute();
+        if( asyncBuild )
+        {
+            for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+            {
+                asyncScratchBuffer[ i ] = std::make_shared< ChunkedStackAllocator >(
+                    allocator,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                    16 * 1024 * 1024,
+                    scratchOffsetAligment,
+                    "Scratch buffer for async",
+                    TRANSIENT_ALLOC_TRIM_FRAME_COUNT );
+
+                asyncBuilder[ i ] = std::make_unique< ASBuilder >( asyncScratchBuffer[ i ] );
+
+                auto semaphoreInfo = VkSemaphoreCreateInfo{
+                    .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                };
+                VkResult r =
+                    vkCreateSemaphore( device, &semaphoreInfo, nullptr, &asyncBuildFinished[ i ] );
+                VK_CHECKERROR( r );
+                SET_DEBUG_NAME( device,
+                                asyncBuildFinished[ i ],
+                                VK_OBJECT_TYPE_SEMAPHORE,
+                                "Async BLAS build finished" );
+            }
+        }
     }
 
     {
@@ -113,11 +453,50 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
 
         for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
         {
-            allocDynamicGeom[ i ] = std::make_unique< ChunkedStackAllocator >(
-                allocator, usage, 16 * 1024 * 1024, asAlignment, "BLAS common buffer for dynamic" );
+            allocDynamicGeom[ i ] =
+                std::make_unique< ChunkedStackAllocator >( allocator,
+                                                           usage,
+                                                           16 * 1024 * 1024,
+                                                           asAlignment,
+                                                           "BLAS common buffer for dynamic",
+                                                           TRANSIENT_ALLOC_TRIM_FRAME_COUNT );
+
+            // reset only on TLAS recreation, so idle chunks are from the previous sizes
+            allocTlas[ i ] =
+                std::make_unique< ChunkedStackAllocator >( allocator,
+                                                           usage,
+                                                           16 * 1024 * 1024,
+                                                           asAlignment,
+                                                           "TLAS common buffer",
+                                                           TRANSIENT_ALLOC_TRIM_FRAME_COUNT );
+        }
+
+        if( LibConfig().blasCompaction )
+        {
+            allocStaticGeomCompacted = std::make_unique< ChunkedStackAllocator >(
+                allocator, usage, 4 * 1024 * 1024, asAlignment, "BLAS compacted for static" );
+
+            allocReplacementsGeomCompacted = std::make_unique< ChunkedStackAllocator >(
+                allocator,
+                usage,
+                16 * 1024 * 1024,
+                asAlignment,
+                "BLAS compacted for replacements" );
+        }
+
+        allocPersistentDynamicGeom = std::make_unique< ChunkedPoolAllocator >(
+            allocator, usage, 16 * 1024 * 1024, asAlignment, "BLAS pool for persistent dynamic" );
+
+        if( ommBuilder )
+        {
+            constexpr auto ommUsage = VK_BUFFER_USAGE_MICROMAP_STORAGE_BIT_EXT |
+                                      VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
+            allocStaticOmm = std::make_unique< ChunkedStackAllocator >(
+                allocator, ommUsage, 4 * 1024 * 1024, 256, "Opacity micromaps for static" );
 
-            allocTlas[ i ] = std::make_unique< ChunkedStackAllocator >(
-                allocator, usage, 16 * 1024 * 1024, asAlignment, "TLAS common buffer" );
+            allocReplacementsOmm = std::make_unique< ChunkedStackAllocator >(
+                allocator, ommUsage, 8 * 1024 * 1024, 256, "Opacity micromaps for replacements" );
         }
     }
 
@@ -131,63 +510,93 @@ RTGL1::ASManager::ASManager( VkDevice                                _device,
         };
         const size_t maxIndices = _maxReplacementsVerts * 3;
 
-        collectorStatic = std::make_unique< VertexCollector >(
-            device, *allocator, maxVertsPerLayer, maxIndices, false, "Static" );
+        auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_STATIC_GEOMETRY };
+        collectorStatic = std::make_unique< VertexCollector >( device,
+                                                               *allocator,
+                                                               maxVertsPerLayer,
+                                                               maxIndices,
+                                                               false,
+                                                               "Static",
+                                                               _quantizeStaticVertices );
+
+        // quantized vertices of each primitive are placed by its own instance transform
+        staticClustering = LibConfig().staticBlasClustering && !_quantizeStaticVertices;
+        if( LibConfig().staticBlasClustering && _quantizeStaticVertices )
+        {
+            debug::Warning( "Static BLAS clustering is disabled: static vertices are quantized" );
+        }
     }
 
     _maxDynamicVerts = _maxDynamicVerts > 0 ? _maxDynamicVerts : 2097152;
     {
-        const size_t maxVertsPerLayer[] = {
-            _maxDynamicVerts,
-            _enableTexCoordLayer1 ? _maxDynamicVerts : 0,
-            _enableTexCoordLayer2 ? _maxDynamicVerts : 0,
-            _enableTexCoordLayer3 ? _maxDynamicVerts : 0,
-        };
-        const size_t maxIndices = _maxDynamicVerts * 3;
+        dynamicMaxVertexCapacity =
+            uint32_t( std::min< uint64_t >( _maxDynamicVerts, UINT32_MAX ) );
+        dynamicTexCoordLayers[ 0 ] = _enableTexCoordLayer1;
+        dynamicTexCoordLayers[ 1 ] = _enableTexCoordLayer2;
+        dynamicTexCoordLayers[ 2 ] = _enableTexCoordLayer3;
 
-        collectorDynamic[ 0 ] = std::make_unique< VertexCollector >(
-            device, *allocator, maxVertsPerLayer, maxIndices, true, "Dynamic 0" );
+        // promoted BLAS-es are built once, and must not be in flight in async submissions
+        promoteDynamic = LibConfig().dynamicPromotion && !asyncBuild;
 
-        // share device-local buffer with 0
-        collectorDynamic[ 1 ] = VertexCollector::CreateWithSameDeviceLocalBuffers(
-            *( collectorDynamic[ 0 ] ), *allocator, "Dynamic 1" );
+        // promoted vertex data is tracked per frame index, but the spare collector rotates
+        directDynamicWrites = LibConfig().resizableBarWrites && allocator->HasResizableBar() &&
+                              !promoteDynamic;
 
-        assert( std::size( collectorDynamic ) == 2 );
+        CreateDynamicBuffers( std::min( DYNAMIC_INITIAL_VERTEX_COUNT, dynamicMaxVertexCapacity ) );
     }
 
-    previousDynamicPositions.Init( *allocator,
-                                   _maxDynamicVerts * sizeof( ShVertex ),
-                                   VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                   "Previous frame's vertex data" );
-    previousDynamicIndices.Init( *allocator,
-                                 _maxDynamicVerts * sizeof( uint32_t ),
-                                 VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-                                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-                                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                 "Previous frame's index data" );
-
 
     // instance buffer for TLAS
-    instanceBuffer = std::make_unique< AutoBuffer >( allocator );
+    {
+        maxInstanceCount = _maxInstanceCount;
 
-    constexpr VkDeviceSize instanceBufferSize =
-        MAX_INSTANCE_COUNT * sizeof( VkAccelerationStructureInstanceKHR );
+        auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_ACCELERATION_STRUCTURES };
+        instanceBuffer   = std::make_unique< AutoBuffer >( allocator );
 
-    instanceBuffer->Create(
-        instanceBufferSize,
-        VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
-            VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
-        "TLAS instance buffer" );
+        const VkDeviceSize instanceBufferSize =
+            VkDeviceSize{ maxInstanceCount } * sizeof( VkAccelerationStructureInstanceKHR );
+
+        // written by a compute shader, if generated on GPU
+        const VkBufferUsageFlags generationUsage =
+            LibConfig().gpuTlasInstances ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT : 0;
+
+        instanceBuffer->Create(
+            instanceBufferSize,
+            VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+                generationUsage,
+            "TLAS instance buffer" );
+    }
+
+
+    emissiveTriangles = std::make_unique< EmissiveTriangles >( allocator );
 
 
     CreateDescriptors();
 
-    // buffers won't be changing, update once
-    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    // static buffers won't be changing, dynamic ones are updated after a resize
+    for( uint32_t i = 0; i < FramesInFlight(); i++ )
+    {
+        UpdateBufferDescriptors(
+            i, *collectorDynamic[ Utils::GetPreviousByModulo( i, FramesInFlight() ) ] );
+    }
+
+    skinning = std::make_shared< Skinning >(
+        device, allocator, _uniform, buffersDescSetLayout, _shaderManager );
+    particleExpansion = std::make_shared< ParticleExpansion >(
+        device, allocator, _uniform, buffersDescSetLayout, _shaderManager );
+    if( LibConfig().gpuTlasInstances )
     {
-        UpdateBufferDescriptors( i );
+        auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_ACCELERATION_STRUCTURES };
+
+        tlasInstanceGeneration =
+            std::make_shared< TLASInstanceGeneration >( device,
+                                                        allocator,
+                                                        _uniform,
+                                                        buffersDescSetLayout,
+                                                        instanceBuffer->GetDeviceLocal(),
+                                                        maxInstanceCount,
+                                                        _shaderManager );
     }
 
 
@@ -322,6 +731,24 @@ void RTGL1::ASManager::CreateDescriptors()
                 .descriptorCount = 1,
                 .stageFlags      = VK_SHADER_STAGE_ALL,
             },
+            {
+                .binding         = BINDING_EMISSIVE_TRIANGLES,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_ALL,
+            },
+            {
+                .binding         = BINDING_GEOMETRY_INSTANCES_PREV,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_ALL,
+            },
+            {
+                .binding         = BINDING_GEOMETRY_MATERIALS,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_ALL,
+            },
         };
         static_assert( CheckBindings( bindings ) );
 
@@ -400,7 +827,8 @@ void RTGL1::ASManager::CreateDescriptors()
     }
 }
 
-void RTGL1::ASManager::UpdateBufferDescriptors( uint32_t frameIndex )
+void RTGL1::ASManager::UpdateBufferDescriptors( uint32_t               frameIndex,
+                                                const VertexCollector& prevCollector )
 {
     VkDescriptorBufferInfo infos[] = {
         {
@@ -434,12 +862,12 @@ void RTGL1::ASManager::UpdateBufferDescriptors( uint32_t frameIndex )
             .range  = VK_WHOLE_SIZE,
         },
         {
-            .buffer = previousDynamicPositions.GetBuffer(),
+            .buffer = prevCollector.GetVertexBuffer(),
             .offset = 0,
             .range  = VK_WHOLE_SIZE,
         },
         {
-            .buffer = previousDynamicIndices.GetBuffer(),
+            .buffer = prevCollector.GetIndexBuffer(),
             .offset = 0,
             .range  = VK_WHOLE_SIZE,
         },
@@ -473,6 +901,21 @@ void RTGL1::ASManager::UpdateBufferDescriptors( uint32_t frameIndex )
             .offset = 0,
             .range  = VK_WHOLE_SIZE,
         },
+        {
+            .buffer = emissiveTriangles->GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = geomInfoMgr->GetPrevBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = geomInfoMgr->GetMaterialsBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
     };
 
     VkWriteDescriptorSet writes[] = {
@@ -602,6 +1045,33 @@ void RTGL1::ASManager::UpdateBufferDescriptors( uint32_t frameIndex )
             .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
             .pBufferInfo     = &infos[ BINDING_DYNAMIC_TEXCOORD_LAYER_3 ],
         },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = buffersDescSets[ frameIndex ],
+            .dstBinding      = BINDING_EMISSIVE_TRIANGLES,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &infos[ BINDING_EMISSIVE_TRIANGLES ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = buffersDescSets[ frameIndex ],
+            .dstBinding      = BINDING_GEOMETRY_INSTANCES_PREV,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &infos[ BINDING_GEOMETRY_INSTANCES_PREV ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = buffersDescSets[ frameIndex ],
+            .dstBinding      = BINDING_GEOMETRY_MATERIALS,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &infos[ BINDING_GEOMETRY_MATERIALS ],
+        },
     };
     assert( CheckBindings( writes ) );
 
@@ -636,26 +1106,74 @@ void RTGL1::ASManager::UpdateASDescriptors( uint32_t frameIndex )
 
 RTGL1::ASManager::~ASManager()
 {
+    if( staticBuildInFlight )
+    {
+        Utils::WaitAndResetFence( device, staticCopyFence );
+        FinishStaticBuild();
+    }
+
     vkDestroyDescriptorPool( device, descPool, nullptr );
     vkDestroyDescriptorSetLayout( device, buffersDescSetLayout, nullptr );
     vkDestroyDescriptorSetLayout( device, asDescSetLayout, nullptr );
     vkDestroyFence( device, staticCopyFence, nullptr );
+    for( VkSemaphore s : asyncBuildFinished )
+    {
+        vkDestroySemaphore( device, s, nullptr );
+    }
+}
+
+void RTGL1::ASManager::FinishStaticBuild()
+{
+    collectorStatic->DeleteStaging();
+    if( ommBuilder )
+    {
+        ommBuilder->DeleteStaging();
+    }
+    if( diskCache )
+    {
+        diskCache->FreeStaging();
+    }
+    retiredStatic.clear();
+    staticBuildInFlight = false;
 }
 
 RTGL1::StaticGeometryToken RTGL1::ASManager::BeginStaticGeometry( bool freeReplacements )
 {
+    // staging buffers of the previous build must not be in use
+    if( staticBuildInFlight )
+    {
+        Utils::WaitAndResetFence( device, staticCopyFence );
+        FinishStaticBuild();
+    }
+
     // static vertex data must be recreated, clear previous data
     // (just statics or fully, if need to erase replacements)
     collectorStatic->Reset( freeReplacements ? nullptr : &collectorStatic_replacements );
     geomInfoMgr->ResetOnlyStatic();
+    emissiveTriangles->Reset();
 
-    // static geometry submission happens very infrequently, e.g. on level load
-    vkDeviceWaitIdle( device );
-
-    // destroy previous AS
+    // previous AS might be in use by the frames in flight, so instead of vkDeviceWaitIdle,
+    // keep them alive until the new static build is finished: it's ordered after those frames
+    assert( retiredStatic.empty() );
+    for( auto& b : builtStaticInstances )
+    {
+        retiredStatic.push_back( std::move( b ) );
+    }
     builtStaticInstances.clear();
+    staticClusterCandidates.clear();
+    staticClusterExtraInstances = 0;
+    erase_if( staticBuildHistory, [ this ]( const auto& h ) {
+        return h.second.lastBuildFrame + STATIC_QUICK_REBUILD_FRAME_COUNT < cachedDynamicFrame;
+    } );
     if( freeReplacements )
     {
+        for( auto& [ name, prims ] : builtReplacements )
+        {
+            for( auto& b : prims )
+            {
+                retiredStatic.push_back( std::move( b ) );
+            }
+        }
         builtReplacements.clear();
     }
 
@@ -665,6 +1183,22 @@ RTGL1::StaticGeometryToken RTGL1::ASManager::BeginStaticGeometry( bool freeRepla
     {
         allocReplacementsGeom->Reset();
     }
+    if( allocStaticGeomCompacted )
+    {
+        allocStaticGeomCompacted->Reset();
+    }
+    if( allocReplacementsGeomCompacted && freeReplacements )
+    {
+        allocReplacementsGeomCompacted->Reset();
+    }
+    if( allocStaticOmm )
+    {
+        allocStaticOmm->Reset();
+    }
+    if( allocReplacementsOmm && freeReplacements )
+    {
+        allocReplacementsOmm->Reset();
+    }
 
     erase_if( curFrame_objects, []( const Object& o ) { return o.isStatic; } );
 
@@ -679,149 +1213,1428 @@ void RTGL1::ASManager::MarkReplacementsRegionEnd( const StaticGeometryToken& tok
     collectorStatic_replacements = collectorStatic->GetCurrentRanges();
 }
 
-void RTGL1::ASManager::SubmitStaticGeometry( StaticGeometryToken& token, bool buildReplacements )
+void RTGL1::ASManager::BuildStaticClusters()
 {
-    assert( token );
-    token = {};
-
-    if( buildReplacements )
+    if( staticClusterCandidates.empty() )
     {
-        if( builtReplacements.empty() && builtStaticInstances.empty() )
+        return;
+    }
+
+    RG_CPU_ZONE( "ASManager::BuildStaticClusters" );
+
+    // only the primitives with the same TLAS instance parameters can share a BLAS;
+    // the order must be stable between runs, as BLAS-es are restored from the disk cache
+    const auto compareInstance = []( const StaticClusterCandidate& a,
+                                     const StaticClusterCandidate& b ) -> int {
+        if( a.built->flags != b.built->flags )
         {
-            collectorStatic->DeleteStaging();
-            return;
+            return a.built->flags < b.built->flags ? -1 : 1;
         }
-    }
-    else
-    {
-        if( builtStaticInstances.empty() )
+        if( a.areaIndex != b.areaIndex )
         {
-            collectorStatic->DeleteStaging();
-            return;
+            return a.areaIndex < b.areaIndex ? -1 : 1;
         }
-    }
+        return memcmp( &a.transform, &b.transform, sizeof( RgTransform ) );
+    };
+    std::ranges::stable_sort(
+        staticClusterCandidates,
+        [ & ]( const StaticClusterCandidate& a, const StaticClusterCandidate& b ) {
+            return compareInstance( a, b ) < 0;
+        } );
+
+    const auto center = []( const StaticClusterCandidate& c, int axis ) {
+        return ( c.boundsMin[ axis ] + c.boundsMax[ axis ] ) * 0.5f;
+    };
 
-    VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
+    const auto makeCluster = [ this ]( std::span< StaticClusterCandidate > members ) {
+        const StaticClusterCandidate& first = members.front();
+
+        // 'geometry' of the first member is only for the location of the BLAS,
+        // as all members have the same instance transform
+        auto cluster = std::unique_ptr< BuiltAS >( new BuiltAS{
+            .flags    = first.built->flags,
+            .blas     = BLASComponent{ device },
+            .geometry = first.built->geometry,
+            .policy   = TracePolicy(),
+        } );
+
+        auto primitiveCounts = std::vector< uint32_t >{};
+        primitiveCounts.reserve( members.size() );
+        for( StaticClusterCandidate& m : members )
+        {
+            // rebuilt as often as its most often rebuilt member
+            if( m.built->policy == BLASBuildPolicy::FastBuild )
+            {
+                cluster->policy = BLASBuildPolicy::FastBuild;
+            }
 
-    // copy from staging with barrier
-    if( buildReplacements )
-    {
-        collectorStatic->CopyFromStaging( cmd );
-    }
-    else
-    {
-        auto onlyStaticRange = VertexCollector::CopyRanges::RemoveAtStart(
-            collectorStatic->GetCurrentRanges(), collectorStatic_replacements );
+            cluster->clusterGeometries.push_back( m.built->geometry.asGeometryInfo );
+            cluster->clusterRanges.push_back( m.built->geometry.asRange );
+            cluster->clusterUniqueIDs.push_back( m.uniqueID );
+            primitiveCounts.push_back( m.built->geometry.asRange.primitiveCount );
+            cluster->clusterMembers.push_back( std::move( m.built ) );
+        }
 
-        collectorStatic->CopyFromStaging( cmd, onlyStaticRange );
-    }
+        const bool fastTrace       = cluster->policy != BLASBuildPolicy::FastBuild;
+        const bool allowCompaction = cluster->policy == BLASBuildPolicy::FastTraceCompacted;
 
-    assert( !asBuilder->IsEmpty() );
-    asBuilder->BuildBottomLevel( cmd );
+        const auto buildSizes = ASBuilder::GetBottomBuildSizes(
+            device, cluster->clusterGeometries, primitiveCounts, fastTrace, allowCompaction );
+        cluster->blas.RecreateIfNotValid( buildSizes, *allocStaticGeom );
 
-    // submit and wait
-    cmdManager->Submit( cmd, staticCopyFence );
-    Utils::WaitAndResetFence( device, staticCopyFence );
+        // arrays are in the cluster, so they're alive until BuildBottomLevel()
+        asBuilder->AddBLAS( cluster->blas.GetAS(),
+                            cluster->clusterGeometries,
+                            cluster->clusterRanges,
+                            buildSizes,
+                            fastTrace,
+                            false,
+                            false,
+                            allowCompaction );
+
+        curFrame_objects.push_back( Object{
+            .builtInstance = cluster.get(),
+            .isStatic      = true,
+            .uniqueID      = first.uniqueID,
+            .transform     = first.transform,
+            .instanceFlags = cluster->flags,
+            .boundsCenter  = {},
+            .boundsRadius  = 0.0f,
+            .areaIndex     = first.areaIndex,
+        } );
+        staticClusterExtraInstances += static_cast< uint32_t >( members.size() - 1 );
+
+        builtStaticInstances.push_back( std::move( cluster ) );
+    };
 
-    collectorStatic->DeleteStaging();
-}
+    auto all = std::span{ staticClusterCandidates };
+    while( !all.empty() )
+    {
+        // primitives with the same instance parameters
+        size_t groupSize = 1;
+        while( groupSize < all.size() && compareInstance( all[ 0 ], all[ groupSize ] ) == 0 )
+        {
+            groupSize++;
+        }
 
-RTGL1::DynamicGeometryToken RTGL1::ASManager::BeginDynamicGeometry( VkCommandBuffer cmd,
-                                                                    uint32_t        frameIndex )
-{
-    // store data of current frame to use it in the next one
-    CopyDynamicDataToPrevBuffers( cmd,
-                                  Utils::GetPreviousByModulo( frameIndex, MAX_FRAMES_IN_FLIGHT ) );
+        // split a group at the median of primitive centers along the longest axis,
+        // until each part fits into the cluster limits
+        auto toSplit = std::vector{ all.first( groupSize ) };
+        while( !toSplit.empty() )
+        {
+            auto range = toSplit.back();
+            toSplit.pop_back();
 
-    scratchBuffer->Reset();
+            uint64_t triangleCount = 0;
+            float    mn[ 3 ]       = { FLT_MAX, FLT_MAX, FLT_MAX };
+            float    mx[ 3 ]       = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+            for( const StaticClusterCandidate& c : range )
+            {
+                triangleCount += c.built->geometry.asRange.primitiveCount;
+                for( int i = 0; i < 3; i++ )
+                {
+                    mn[ i ] = std::min( mn[ i ], center( c, i ) );
+                    mx[ i ] = std::max( mx[ i ], center( c, i ) );
+                }
+            }
+
+            const bool fits = range.size() == 1 ||
+                              ( range.size() <= STATIC_CLUSTER_MAX_GEOMETRY_COUNT &&
+                                triangleCount <= STATIC_CLUSTER_MAX_TRIANGLE_COUNT );
+            if( fits )
+            {
+                makeCluster( range );
+                continue;
+            }
+
+            int axis = 0;
+            for( int i = 1; i < 3; i++ )
+            {
+                if( mx[ i ] - mn[ i ] > mx[ axis ] - mn[ axis ] )
+                {
+                    axis = i;
+                }
+            }
+
+            const size_t half = range.size() / 2;
+            std::ranges::nth_element(
+                range,
+                range.begin() + ptrdiff_t( half ),
+                [ & ]( const StaticClusterCandidate& a, const StaticClusterCandidate& b ) {
+                    return center( a, axis ) < center( b, axis );
+                } );
+
+            toSplit.push_back( range.first( half ) );
+            toSplit.push_back( range.subspan( half ) );
+        }
+
+        all = all.subspan( groupSize );
+    }
+
+    debug::Verbose( "Static BLAS clustering: {} primitives -> {} BLAS-es",
+                    staticClusterCandidates.size(),
+                    staticClusterCandidates.size() - staticClusterExtraInstances );
+
+    staticClusterCandidates.clear();
+}
+
+void RTGL1::ASManager::SubmitStaticGeometry( StaticGeometryToken& token,
+                                              bool                 buildReplacements,
+                                              const BLASCacheFile* cacheFile )
+{
+    assert( token );
+    token = {};
+
+    BuildStaticClusters();
+
+    const bool nothingToBuild = buildReplacements
+                                    ? ( builtReplacements.empty() && builtStaticInstances.empty() )
+                                    : builtStaticInstances.empty();
+
+    VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
+
+    // previous static data might be still in use by the frames in flight
+    FullMemoryBarrier( cmd );
+
+    emissiveTriangles->Upload( cmd );
+
+    if( nothingToBuild )
+    {
+        // still need a fence to know when the retired AS-es can be destroyed
+        cmdManager->Submit( cmd, staticCopyFence );
+        staticBuildInFlight = true;
+        return;
+    }
+
+    // copy from staging with barrier
+    if( buildReplacements )
+    {
+        collectorStatic->CopyFromStaging( cmd );
+    }
+    else
+    {
+        auto onlyStaticRange = VertexCollector::CopyRanges::RemoveAtStart(
+            collectorStatic->GetCurrentRanges(), collectorStatic_replacements );
+
+        collectorStatic->CopyFromStaging( cmd, onlyStaticRange );
+    }
+
+    if( ommBuilder )
+    {
+        ommBuilder->Build( cmd );
+    }
+
+    const auto cacheTargets = cacheFile && diskCache ? MakeDiskCacheTargets( buildReplacements )
+                                                     : std::vector< BLASDiskCache::Target >{};
+
+    const bool fromCache =
+        !cacheTargets.empty() && diskCache->TryRecordLoad( cmd, *cacheFile, cacheTargets );
+    const bool saveToCache = !cacheTargets.empty() && !fromCache;
+
+    assert( !asBuilder->IsEmpty() );
+    if( fromCache )
+    {
+        asBuilder->ClearBottomLevel();
+    }
+    else
+    {
+        asBuilder->BuildBottomLevel( cmd );
+    }
+
+    // BLAS-es that are built in this submission, to be compacted
+    auto toCompact = std::vector< CompactionTarget >{};
+    if( LibConfig().blasCompaction )
+    {
+        // LODs are in the same allocator as their base
+        const auto addWithLods = [ &toCompact ]( BuiltAS& b, ChunkedStackAllocator* dstAlloc ) {
+            // rebuilt often, so not built for compaction
+            if( b.policy != BLASBuildPolicy::FastTraceCompacted )
+            {
+                return;
+            }
+            toCompact.push_back( { &b.blas, dstAlloc } );
+            for( auto& lod : b.lods )
+            {
+                toCompact.push_back( { &lod.built->blas, dstAlloc } );
+            }
+        };
+
+        for( const auto& b : builtStaticInstances )
+        {
+            addWithLods( *b, allocStaticGeomCompacted.get() );
+        }
+        if( buildReplacements )
+        {
+            for( const auto& [ name, prims ] : builtReplacements )
+            {
+                for( const auto& b : prims )
+                {
+                    addWithLods( *b, allocReplacementsGeomCompacted.get() );
+                }
+            }
+        }
+    }
+
+    if( !toCompact.empty() )
+    {
+        VkQueryPool compactedSizes = WriteCompactedSizes( cmd, toCompact );
+
+        // compacted sizes are needed on CPU, so wait
+        cmdManager->Submit( cmd, staticCopyFence );
+        Utils::WaitAndResetFence( device, staticCopyFence );
+
+        CompactStaticGeometry( compactedSizes, toCompact, buildReplacements );
+        vkDestroyQueryPool( device, compactedSizes, nullptr );
+
+        FinishStaticBuild();
+
+        if( saveToCache )
+        {
+            diskCache->Save( *cmdManager, staticCopyFence, *cacheFile, cacheTargets );
+        }
+        return;
+    }
+
+    if( saveToCache )
+    {
+        // serialization needs the built BLAS-es, so only the first load waits
+        cmdManager->Submit( cmd, staticCopyFence );
+        Utils::WaitAndResetFence( device, staticCopyFence );
+        FinishStaticBuild();
+
+        diskCache->Save( *cmdManager, staticCopyFence, *cacheFile, cacheTargets );
+        return;
+    }
+
+    // don't wait: staging and retired AS-es are freed, when the fence is signaled
+    cmdManager->Submit( cmd, staticCopyFence );
+    staticBuildInFlight       = true;
+    staticBuildBarrierPending = true;
+}
+
+auto RTGL1::ASManager::MakeDiskCacheTargets( bool withReplacements ) const
+    -> std::vector< BLASDiskCache::Target >
+{
+    auto targets = std::vector< BLASDiskCache::Target >{};
+
+    using ankerl::unordered_dense::detail::wyhash::hash;
+
+    const auto hashGeometry = []( const BuiltAS& b ) -> std::optional< uint64_t > {
+        // micromaps are referenced by address, they can't be restored with BLAS
+        if( b.omm )
+        {
+            return std::nullopt;
+        }
+
+        const auto& tri = b.geometry.asGeometryInfo.geometry.triangles;
+
+        const uint64_t values[] = {
+            b.flags,
+            b.geometry.asRange.primitiveCount,
+            tri.maxVertex,
+            tri.indexType,
+            tri.vertexFormat,
+            LibConfig().blasCompaction,
+            uint64_t( b.policy ),
+        };
+        return hash( values, sizeof( values ) );
+    };
+
+    const auto addOne = [ &targets, &hashGeometry ]( BuiltAS& b ) -> bool {
+        auto fingerprint = hashGeometry( b );
+
+        // a cluster is built from the geometries of its members
+        for( const auto& member : b.clusterMembers )
+        {
+            const auto m = hashGeometry( *member );
+            if( !fingerprint || !m )
+            {
+                return false;
+            }
+            const uint64_t values[] = { *fingerprint, *m };
+            fingerprint             = hash( values, sizeof( values ) );
+        }
+
+        if( !fingerprint )
+        {
+            return false;
+        }
+
+        targets.push_back( BLASDiskCache::Target{
+            .blas        = &b.blas,
+            .fingerprint = *fingerprint,
+        } );
+        return true;
+    };
+
+    // LODs are built together with their base, so they're restored too
+    const auto add = [ &addOne ]( const std::unique_ptr< BuiltAS >& b ) -> bool {
+        if( !addOne( *b ) )
+        {
+            return false;
+        }
+        return std::ranges::all_of(
+            b->lods, [ & ]( const BuiltAS::Lod& lod ) { return addOne( *lod.built ); } );
+    };
+
+    for( const auto& b : builtStaticInstances )
+    {
+        if( !add( b ) )
+        {
+            return {};
+        }
+    }
+
+    if( withReplacements )
+    {
+        // map order is not stable between runs
+        auto names = std::vector< std::string_view >{};
+        names.reserve( builtReplacements.size() );
+        for( const auto& [ name, prims ] : builtReplacements )
+        {
+            names.push_back( name );
+        }
+        std::ranges::sort( names );
+
+        for( std::string_view name : names )
+        {
+            for( const auto& b : builtReplacements.find( name )->second )
+            {
+                if( !add( b ) )
+                {
+                    return {};
+                }
+            }
+        }
+    }
+
+    return targets;
+}
+
+auto RTGL1::ASManager::WriteCompactedSizes( VkCommandBuffer                     cmd,
+                                            std::span< const CompactionTarget > targets ) const
+    -> VkQueryPool
+{
+    assert( !targets.empty() );
+
+    auto poolInfo = VkQueryPoolCreateInfo{
+        .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType  = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR,
+        .queryCount = static_cast< uint32_t >( targets.size() ),
+    };
+
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    VkResult    r         = vkCreateQueryPool( device, &poolInfo, nullptr, &queryPool );
+    VK_CHECKERROR( r );
+
+    SET_DEBUG_NAME( device, queryPool, VK_OBJECT_TYPE_QUERY_POOL, "BLAS compacted sizes" );
+
+    auto handles = std::vector< VkAccelerationStructureKHR >{};
+    handles.reserve( targets.size() );
+    for( const auto& t : targets )
+    {
+        handles.push_back( t.blas->GetAS() );
+    }
+
+    vkCmdResetQueryPool( cmd, queryPool, 0, poolInfo.queryCount );
+
+    ASBuildToASCopyBarrier( cmd );
+
+    svkCmdWriteAccelerationStructuresPropertiesKHR(
+        cmd,
+        static_cast< uint32_t >( handles.size() ),
+        handles.data(),
+        VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR,
+        queryPool,
+        0 );
+
+    return queryPool;
+}
+
+void RTGL1::ASManager::CompactStaticGeometry( VkQueryPool                         compactedSizes,
+                                              std::span< const CompactionTarget > targets,
+                                              bool withReplacements )
+{
+    auto sizes = std::vector< VkDeviceSize >( targets.size() );
+
+    VkResult r = vkGetQueryPoolResults( device,
+                                        compactedSizes,
+                                        0,
+                                        static_cast< uint32_t >( sizes.size() ),
+                                        sizes.size() * sizeof( VkDeviceSize ),
+                                        sizes.data(),
+                                        sizeof( VkDeviceSize ),
+                                        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT );
+    VK_CHECKERROR( r );
+
+    // all or nothing, as original chunks are released fully
+    if( std::ranges::any_of( sizes, []( VkDeviceSize sz ) { return sz == 0; } ) )
+    {
+        debug::Warning( "BLAS compaction was skipped: got invalid compacted size" );
+        return;
+    }
+
+    const VkDeviceSize sizeBefore =
+        allocStaticGeom->GetAllocatedSize() +
+        ( withReplacements ? allocReplacementsGeom->GetAllocatedSize() : 0 );
+
+    auto originals = std::vector< VkAccelerationStructureKHR >{};
+    originals.reserve( targets.size() );
+    {
+        VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
+        {
+            auto label = CmdLabel{ cmd, "Compact BLAS" };
+
+            ASBuildToASCopyBarrier( cmd );
+
+            for( size_t i = 0; i < targets.size(); i++ )
+            {
+                const auto& t = targets[ i ];
+                originals.push_back( t.blas->RecordCompactedCopy( cmd, sizes[ i ], *t.dstAlloc ) );
+            }
+        }
+
+        cmdManager->Submit( cmd, staticCopyFence );
+        Utils::WaitAndResetFence( device, staticCopyFence );
+    }
+
+    for( VkAccelerationStructureKHR o : originals )
+    {
+        svkDestroyAccelerationStructureKHR( device, o, nullptr );
+    }
+
+    // all BLAS-es of those allocators were moved to the compacted ones
+    allocStaticGeom->Free();
+    if( withReplacements )
+    {
+        allocReplacementsGeom->Free();
+    }
+
+    const VkDeviceSize sizeAfter =
+        allocStaticGeomCompacted->GetAllocatedSize() +
+        ( withReplacements ? allocReplacementsGeomCompacted->GetAllocatedSize() : 0 );
+
+    debug::Info( "BLAS compaction: {} MB -> {} MB",
+                 sizeBefore / ( 1024 * 1024 ),
+                 sizeAfter / ( 1024 * 1024 ) );
+}
+
+RgPrimitiveVertex* RTGL1::ASManager::ReserveDynamicVertices( uint32_t frameIndex,
+                                                              uint32_t vertexCount )
+{
+    return collectorDynamic[ frameIndex ]->ReserveStagingVertices( vertexCount );
+}
+
+void RTGL1::ASManager::CreateDynamicBuffers( uint32_t vertexCapacity )
+{
+    const size_t maxVertsPerLayer[] = {
+        vertexCapacity,
+        dynamicTexCoordLayers[ 0 ] ? vertexCapacity : 0,
+        dynamicTexCoordLayers[ 1 ] ? vertexCapacity : 0,
+        dynamicTexCoordLayers[ 2 ] ? vertexCapacity : 0,
+    };
+    const size_t maxIndices = size_t{ vertexCapacity } * 3;
+
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_DYNAMIC_GEOMETRY };
+
+    auto makeCollector = [ & ]( uint32_t index ) {
+        return std::make_unique< VertexCollector >( device,
+                                                    *allocator,
+                                                    maxVertsPerLayer,
+                                                    maxIndices,
+                                                    true,
+                                                    std::format( "Dynamic {}", index ),
+                                                    false,
+                                                    directDynamicWrites );
+    };
+
+    // a collector per frame, so the previous frame's data is read from its own collector
+    for( uint32_t i = 0; i < FramesInFlight(); i++ )
+    {
+        collectorDynamic[ i ] = makeCollector( i );
+    }
+
+    if( directDynamicWrites )
+    {
+        // a collector is read by the next frame as the previous one's data, which might be
+        // still in flight when CPU starts writing the same collector again; so one more
+        collectorDynamicSpare = makeCollector( FramesInFlight() );
+    }
+
+    dynamicVertexCapacity = vertexCapacity;
+    promotedVertexBudget  = vertexCapacity / 4;
+    dynamicLowUsageFrames = 0;
+}
+
+auto RTGL1::ASManager::ChooseDynamicVertexCapacity( const VertexCollector& lastFrame )
+    -> std::optional< uint32_t >
+{
+    const uint32_t required = lastFrame.GetRequiredVertexCapacity();
+
+    if( required >= dynamicVertexCapacity )
+    {
+        if( dynamicVertexCapacity >= dynamicMaxVertexCapacity )
+        {
+            return std::nullopt;
+        }
+
+        // with a reserve, so the growth is not by small steps
+        const uint64_t grown = std::max( uint64_t{ dynamicVertexCapacity } * 2,
+                                         uint64_t{ required } + required / 2 );
+        return uint32_t( std::min< uint64_t >( grown, dynamicMaxVertexCapacity ) );
+    }
+
+    if( required < dynamicVertexCapacity / 4 &&
+        dynamicVertexCapacity / 2 >= DYNAMIC_INITIAL_VERTEX_COUNT )
+    {
+        dynamicLowUsageFrames++;
+        if( dynamicLowUsageFrames >= DYNAMIC_SHRINK_FRAME_COUNT )
+        {
+            return dynamicVertexCapacity / 2;
+        }
+    }
+    else
+    {
+        dynamicLowUsageFrames = 0;
+    }
+
+    return std::nullopt;
+}
+
+void RTGL1::ASManager::ResizeDynamicBuffers( uint32_t frameIndex, uint32_t vertexCapacity )
+{
+    debug::Verbose( "Resizing dynamic vertex buffers: {} -> {} vertices",
+                    dynamicVertexCapacity,
+                    vertexCapacity );
+
+    // promoted vertex data is in the old buffers, start over
+    ResetPromotedDynamic( frameIndex );
+
+    auto& retired = retiredDynamicBuffers[ frameIndex ].emplace_back();
+    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        retired.collectors[ i ] = std::move( collectorDynamic[ i ] );
+    }
+    retired.collectorSpare = std::move( collectorDynamicSpare );
+
+    CreateDynamicBuffers( vertexCapacity );
+
+    for( bool& outdated : bufferDescriptorsOutdated )
+    {
+        outdated = true;
+    }
+}
+
+RTGL1::DynamicGeometryToken RTGL1::ASManager::BeginDynamicGeometry( VkCommandBuffer cmd,
+                                                                    uint32_t        frameIndex )
+{
+    // retired by N-2, which is finished, as well as the frames before it
+    retiredDynamicBuffers[ frameIndex ].clear();
+
+    const VertexCollector& prevCollector =
+        *collectorDynamic[ Utils::GetPreviousByModulo( frameIndex, FramesInFlight() ) ];
+
+    const uint32_t nextFrameIndex = ( frameIndex + 1 ) % FramesInFlight();
+
+    // if resized, previous collector is kept alive in the retired list
+    const bool resized = [ & ] {
+        if( auto newCapacity = ChooseDynamicVertexCapacity( prevCollector ) )
+        {
+            ResizeDynamicBuffers( frameIndex, *newCapacity );
+            return true;
+        }
+        return false;
+    }();
+
+    if( directDynamicWrites )
+    {
+        // the spare one was last read by a finished frame
+        std::swap( collectorDynamic[ frameIndex ], collectorDynamicSpare );
+        bufferDescriptorsOutdated[ frameIndex ]     = true;
+        // next frame reads the previous data from the swapped-in collector
+        bufferDescriptorsOutdated[ nextFrameIndex ] = true;
+    }
+
+    if( bufferDescriptorsOutdated[ frameIndex ] )
+    {
+        // previous frame's data is read directly from its collector, as the layouts are the
+        // same, the offsets in the previous frame's geom infos stay valid without any copies
+        UpdateBufferDescriptors( frameIndex, prevCollector );
+        // a retired collector is bound, rebind when this frame index comes again
+        bufferDescriptorsOutdated[ frameIndex ] = resized;
+    }
+
+    scratchBuffer->Reset();
+    if( asyncBuild )
+    {
+        // was used by N-2, which is finished
+        asyncScratchBuffer[ frameIndex ]->Reset();
+    }
+
+    // static build is submitted before the frames that use it, check if it's done
+    if( staticBuildInFlight && vkGetFenceStatus( device, staticCopyFence ) == VK_SUCCESS )
+    {
+        Utils::ResetFence( device, staticCopyFence );
+        FinishStaticBuild();
+    }
+
+    // dynamic vertices are refilled each frame, except the promoted ones
+    if( !promoteDynamic )
+    {
+        collectorDynamic[ frameIndex ]->Reset( nullptr );
+    }
+    // destroy dynamic instances from N-2
+    builtDynamicInstances[ frameIndex ].Reset();
+    allocDynamicGeom[ frameIndex ]->Reset();
+
+    // retired cached BLAS-es from N-2 are not referenced by any TLAS anymore
+    cachedDynamicRetired[ frameIndex ].clear();
+    cachedDynamicFrame++;
+    cachedDynamicUpgrades = 0;
+
+    // retire cached BLAS-es that were not used in the previous frame
+    erase_if( cachedDynamic, [ this, frameIndex ]( auto& c ) {
+        if( c.second.lastUsedFrame + 1 < cachedDynamicFrame )
+        {
+            cachedDynamicRetired[ frameIndex ].push_back( std::move( c.second ) );
+            return true;
+        }
+        return false;
+    } );
+
+    refitDynamicRetired[ frameIndex ].clear();
+    erase_if( refitDynamic, [ this, frameIndex ]( auto& c ) {
+        if( c.second.lastUsedFrame + 1 < cachedDynamicFrame )
+        {
+            refitDynamicRetired[ frameIndex ].push_back( std::move( c.second ) );
+            return true;
+        }
+        return false;
+    } );
+
+    if( promoteDynamic )
+    {
+        UploadPendingPromotions( frameIndex );
+    }
+
+    erase_if( curFrame_objects, []( const Object& o ) { return !o.isStatic; } );
+    curFrame_dynamicInstancing.clear();
+
+    skinning->BeginFrame( frameIndex );
+    particleExpansion->BeginFrame( frameIndex );
+
+    assert( asBuilder->IsEmpty() );
+    assert( DynamicBuilder( frameIndex ).IsEmpty() );
+    return DynamicGeometryToken( InitAsExisting );
+}
+
+auto RTGL1::ASManager::DynamicBuilder( uint32_t frameIndex ) -> ASBuilder&
+{
+    return asyncBuild ? *asyncBuilder[ frameIndex ] : *asBuilder;
+}
+
+auto RTGL1::ASManager::UploadAndBuildAS( ASBuilder&                     builder,
+                                         const RgMeshPrimitiveInfo&     primitive,
+                                         VertexCollectorFilterTypeFlags geomFlags,
+                                         VertexCollector&               vertexAlloc,
+                                         ChunkedStackAllocator&         accelStructAlloc,
+                                         BLASBuildPolicy                policy,
+                                         std::shared_ptr< OpacityMicromap > omm,
+                                         const bool                     verticesOnDevice )
+    -> std::unique_ptr< BuiltAS >
+{
+    auto uploadedData = vertexAlloc.Upload( geomFlags, primitive, verticesOnDevice );
+    if( !uploadedData )
+    {
+        return {};
+    }
+
+    return BuildAS(
+        builder, *uploadedData, geomFlags, accelStructAlloc, policy, false, std::move( omm ) );
+}
+
+void RTGL1::ASManager::UploadAndBuildLods( BuiltAS&                        base,
+                                           const RgMeshPrimitiveInfo&      basePrimitive,
+                                           std::span< const PrimitiveLod > lods,
+                                           ASBuilder&                      builder,
+                                           VertexCollector&                vertexAlloc,
+                                           ChunkedStackAllocator&          accelStructAlloc )
+{
+    if( lods.empty() )
+    {
+        return;
+    }
+
+    for( const PrimitiveLod& lod : lods )
+    {
+        auto built = UploadAndBuildAS(
+            builder, lod.primitive, base.flags, vertexAlloc, accelStructAlloc, base.policy );
+        if( !built )
+        {
+            debug::Warning( "Failed to upload vertex data of a primitive LOD" );
+            break;
+        }
+
+        base.lods.push_back( BuiltAS::Lod{
+            .built = std::move( built ),
+            .error = lod.error,
+        } );
+    }
+
+    const auto [ mn, mx ] = MakeLocalBounds( basePrimitive );
+    base.lodBoundsMin     = mn;
+    base.lodBoundsMax     = mx;
+}
+
+auto RTGL1::ASManager::MakeOpacityMicromap( const RgMeshPrimitiveInfo&     primitive,
+                                            VertexCollectorFilterTypeFlags geomFlags,
+                                            const TextureManager&          textureManager,
+                                            ChunkedStackAllocator&         ommAlloc )
+    -> std::shared_ptr< OpacityMicromap >
+{
+    if( !ommBuilder || !( geomFlags & VertexCollectorFilterTypeFlagBits::PT_ALPHA_TESTED ) )
+    {
+        return {};
+    }
+
+    // alpha test in any-hit also depends on the primitive color
+    if( primitive.color != Utils::PackColor( 255, 255, 255, 255 ) )
+    {
+        return {};
+    }
+
+    const OpacityMask* mask = textureManager.GetOpacityMask( primitive.pTextureName );
+    if( !mask )
+    {
+        return {};
+    }
+
+    return ommBuilder->Add( primitive, *mask, ommAlloc );
+}
+
+template< typename Allocator >
+auto RTGL1::ASManager::BuildAS( ASBuilder&                           builder,
+                                const VertexCollector::UploadResult& uploadedData,
+                                VertexCollectorFilterTypeFlags       geomFlags,
+                                Allocator&                           accelStructAlloc,
+                                BLASBuildPolicy                      policy,
+                                const bool                           isUpdateable,
+                                std::shared_ptr< OpacityMicromap >   omm )
+    -> std::unique_ptr< BuiltAS >
+{
+    // NOTE: dedicated allocation, so pointers in builder
+    //       are valid until end of the frame
+    auto newlyBuilt = std::unique_ptr< BuiltAS >( new BuiltAS{
+        .flags    = geomFlags,
+        .blas     = BLASComponent{ device },
+        .geometry = uploadedData,
+        .omm      = std::move( omm ),
+        .policy   = policy,
+    } );
+
+    AddBLASBuild( builder, *newlyBuilt, accelStructAlloc, isUpdateable );
+    return newlyBuilt;
+}
+
+auto RTGL1::ASManager::UploadAndBuildDynamicAS( uint32_t                       frameIndex,
+                                                const RgMeshPrimitiveInfo&     primitive,
+                                                VertexCollectorFilterTypeFlags geomFlags,
+                                                bool                           verticesOnDevice )
+    -> BuiltAS*
+{
+    auto uploadedData =
+        collectorDynamic[ frameIndex ]->Upload( geomFlags, primitive, verticesOnDevice );
+    if( !uploadedData )
+    {
+        return nullptr;
+    }
+
+    // arena keeps the pointers stable, so the ones in builder are valid until end of the frame
+    BuiltAS* newlyBuilt = builtDynamicInstances[ frameIndex ].Emplace( [ & ] {
+        return BuiltAS{
+            .flags    = geomFlags,
+            .blas     = BLASComponent{ device },
+            .geometry = *uploadedData,
+            .policy   = DynamicBuildPolicy( uploadedData->asRange.primitiveCount ),
+        };
+    } );
+
+    AddBLASBuild(
+        DynamicBuilder( frameIndex ), *newlyBuilt, *allocDynamicGeom[ frameIndex ], false );
+    return newlyBuilt;
+}
+
+template< typename Allocator >
+void RTGL1::ASManager::AddBLASBuild( ASBuilder& builder,
+                                     BuiltAS&   target,
+                                     Allocator& accelStructAlloc,
+                                     bool       isUpdateable )
+{
+    if( target.omm )
+    {
+        target.geometry.asGeometryInfo.geometry.triangles.pNext = target.omm->GetAttachment();
+    }
+
+    const bool fastTrace = target.policy == BLASBuildPolicy::FastTrace ||
+                           target.policy == BLASBuildPolicy::FastTraceCompacted;
+    const bool allowCompaction = target.policy == BLASBuildPolicy::FastTraceCompacted;
+    const bool lowMemory       = target.policy == BLASBuildPolicy::FastBuildLowMemory;
+
+    // get AS size and create buffer for AS
+    const auto buildSizes =
+        ASBuilder::GetBottomBuildSizes( device,
+                                        target.geometry.asGeometryInfo,
+                                        target.geometry.asRange.primitiveCount,
+                                        fastTrace,
+                                        allowCompaction,
+                                        isUpdateable,
+                                        lowMemory );
+    target.blas.RecreateIfNotValid( buildSizes, accelStructAlloc );
+
+    // add BLAS, all passed arrays must be alive until BuildBottomLevel() call
+    builder.AddBLAS( target.blas.GetAS(),
+                     { &target.geometry.asGeometryInfo, 1 },
+                     { &target.geometry.asRange, 1 },
+                     buildSizes,
+                     fastTrace,
+                     false,
+                     isUpdateable,
+                     allowCompaction,
+                     lowMemory );
+}
+
+auto RTGL1::ASManager::ChooseStaticBuildPolicy( const PrimitiveUniqueID& uniqueID )
+    -> BLASBuildPolicy
+{
+    if( !LibConfig().adaptiveBlasFlags )
+    {
+        return TracePolicy();
+    }
+
+    auto [ iter, inserted ] = staticBuildHistory.try_emplace( uniqueID,
+                                                              StaticBuildHistory{
+                                                                  .lastBuildFrame = 0,
+                                                                  .quickRebuilds  = 0,
+                                                              } );
+    StaticBuildHistory& h = iter->second;
+
+    // same primitive twice in one build is not a rebuild
+    if( !inserted && h.lastBuildFrame != cachedDynamicFrame )
+    {
+        const bool quick =
+            h.lastBuildFrame + STATIC_QUICK_REBUILD_FRAME_COUNT >= cachedDynamicFrame;
+        h.quickRebuilds = quick ? h.quickRebuilds + 1 : 0;
+    }
+    h.lastBuildFrame = cachedDynamicFrame;
+
+    return h.quickRebuilds >= STATIC_QUICK_REBUILDS_FOR_FAST_BUILD ? BLASBuildPolicy::FastBuild
+                                                                    : TracePolicy();
+}
+
+auto RTGL1::ASManager::UploadAndBuildCachedDynamicAS( uint32_t                       frameIndex,
+                                                      const PrimitiveUniqueID&       uniqueID,
+                                                      const RgMeshPrimitiveInfo&     primitive,
+                                                      VertexCollectorFilterTypeFlags geomFlags )
+    -> BuiltAS*
+{
+    // vertex data is still required by shaders
+    auto uploadedData = collectorDynamic[ frameIndex ]->Upload( geomFlags, primitive );
+    if( !uploadedData )
+    {
+        return nullptr;
+    }
 
-    // dynamic vertices are refilled each frame
-    collectorDynamic[ frameIndex ]->Reset( nullptr );
-    // destroy dynamic instances from N-2
-    builtDynamicInstances[ frameIndex ].clear();
-    allocDynamicGeom[ frameIndex ]->Reset();
+    const uint64_t contentHash = HashPrimitiveContent( primitive );
 
-    erase_if( curFrame_objects, []( const Object& o ) { return !o.isStatic; } );
+    auto     policy         = DynamicBuildPolicy( uploadedData->asRange.primitiveCount );
+    uint64_t firstUsedFrame = cachedDynamicFrame;
 
-    assert( asBuilder->IsEmpty() );
-    return DynamicGeometryToken( InitAsExisting );
+    auto found = cachedDynamic.find( uniqueID );
+    if( found != cachedDynamic.end() )
+    {
+        CachedDynamicAS& c = found->second;
+
+        if( c.contentHash == contentHash && c.built->flags == geomFlags )
+        {
+            // BLAS is the same, only point to the new location of vertex data
+            c.built->geometry = *uploadedData;
+            c.lastUsedFrame   = cachedDynamicFrame;
+
+            const bool longLived =
+                LibConfig().adaptiveBlasFlags && c.built->policy != BLASBuildPolicy::FastTrace &&
+                c.firstUsedFrame + DYNAMIC_LONG_LIVED_FRAME_COUNT <= cachedDynamicFrame &&
+                cachedDynamicUpgrades < DYNAMIC_LONG_LIVED_REBUILDS_PER_FRAME;
+            if( !longLived )
+            {
+                return c.built.get();
+            }
+
+            // traced for many frames, so rebuild once for a fast trace;
+            // the current BLAS might be in use by the frames in flight, so it's retired
+            cachedDynamicUpgrades++;
+            policy         = BLASBuildPolicy::FastTrace;
+            firstUsedFrame = c.firstUsedFrame;
+        }
+
+        cachedDynamicRetired[ frameIndex ].push_back( std::move( c ) );
+        cachedDynamic.erase( found );
+    }
+
+    // BLAS is freed individually, so it's in the pool
+    std::unique_ptr< BuiltAS > built = BuildAS( DynamicBuilder( frameIndex ),
+                                                *uploadedData,
+                                                geomFlags,
+                                                *allocPersistentDynamicGeom,
+                                                policy );
+
+    auto [ iter, inserted ] = cachedDynamic.emplace( uniqueID,
+                                                     CachedDynamicAS{
+                                                         .built          = std::move( built ),
+                                                         .contentHash    = contentHash,
+                                                         .lastUsedFrame  = cachedDynamicFrame,
+                                                         .firstUsedFrame = firstUsedFrame,
+                                                     } );
+    assert( inserted );
+    return iter->second.built.get();
 }
 
-auto RTGL1::ASManager::UploadAndBuildAS( const RgMeshPrimitiveInfo&     primitive,
-                                         VertexCollectorFilterTypeFlags geomFlags,
-                                         VertexCollector&               vertexAlloc,
-                                         ChunkedStackAllocator&         accelStructAlloc,
-                                         const bool isDynamic ) -> std::unique_ptr< BuiltAS >
+auto RTGL1::ASManager::UploadAndRefitDynamicAS( uint32_t                       frameIndex,
+                                                const PrimitiveUniqueID&       uniqueID,
+                                                const RgMeshPrimitiveInfo&     primitive,
+                                                VertexCollectorFilterTypeFlags geomFlags,
+                                                const bool                     verticesOnDevice )
+    -> BuiltAS*
 {
-    auto uploadedData = vertexAlloc.Upload( geomFlags, primitive );
+    const uint64_t indicesHash = HashPrimitiveIndices( primitive );
+
+    auto found = refitDynamic.find( uniqueID );
+    if( found != refitDynamic.end() )
+    {
+        RefitDynamicAS& c = found->second;
+
+        // same BLAS can't be refitted twice in a frame
+        if( c.lastUsedFrame == cachedDynamicFrame )
+        {
+            return nullptr;
+        }
+
+        const bool sameTopology = c.vertexCount == primitive.vertexCount &&
+                                  c.indexCount == primitive.indexCount &&
+                                  c.indicesHash == indicesHash &&
+                                  c.built[ c.lastBuiltIndex ]->flags == geomFlags;
+        if( !sameTopology )
+        {
+            refitDynamicRetired[ frameIndex ].push_back( std::move( c ) );
+            refitDynamic.erase( found );
+            found = refitDynamic.end();
+        }
+    }
+
+    auto uploadedData =
+        collectorDynamic[ frameIndex ]->Upload( geomFlags, primitive, verticesOnDevice );
     if( !uploadedData )
     {
-        return {};
+        return nullptr;
     }
 
-    // NOTE: dedicated allocation, so pointers in asBuilder
-    //       are valid until end of the frame
-    auto newlyBuilt = new BuiltAS{
-        .flags    = geomFlags,
-        .blas     = BLASComponent{ device },
-        .geometry = *uploadedData,
-    };
+    if( found != refitDynamic.end() )
     {
-        const bool fastTrace = isDynamic ? false : true;
+        RefitDynamicAS& c = found->second;
 
-        // get AS size and create buffer for AS
         const auto buildSizes =
             ASBuilder::GetBottomBuildSizes( device,
-                                            newlyBuilt->geometry.asGeometryInfo,
-                                            newlyBuilt->geometry.asRange.primitiveCount,
-                                            fastTrace );
-        newlyBuilt->blas.RecreateIfNotValid( buildSizes, accelStructAlloc );
-
-        // add BLAS, all passed arrays must be alive until BuildBottomLevel() call
-        asBuilder->AddBLAS( newlyBuilt->blas.GetAS(),
-                            { &newlyBuilt->geometry.asGeometryInfo, 1 },
-                            { &newlyBuilt->geometry.asRange, 1 },
+                                            uploadedData->asGeometryInfo,
+                                            uploadedData->asRange.primitiveCount,
+                                            false,
+                                            false,
+                                            true );
+
+        // BLAS of this frame index was used by N-2, so it's safe to write into it
+        auto& dst = c.built[ frameIndex ];
+        if( !dst )
+        {
+            dst.reset( new BuiltAS{
+                .flags    = geomFlags,
+                .blas     = BLASComponent{ device },
+                .geometry = *uploadedData,
+            } );
+            dst->blas.RecreateIfNotValid( buildSizes, *allocPersistentDynamicGeom );
+        }
+        dst->geometry = *uploadedData;
+
+        DynamicBuilder( frameIndex )
+            .AddBLASUpdate( dst->blas.GetAS(),
+                            c.built[ c.lastBuiltIndex ]->blas.GetAS(),
+                            { &dst->geometry.asGeometryInfo, 1 },
+                            { &dst->geometry.asRange, 1 },
                             buildSizes,
-                            fastTrace,
-                            false,
                             false );
+
+        c.lastBuiltIndex = frameIndex;
+        c.lastUsedFrame  = cachedDynamicFrame;
+        return dst.get();
+    }
+
+    auto entry = RefitDynamicAS{
+        .built          = {},
+        .lastBuiltIndex = frameIndex,
+        .vertexCount    = primitive.vertexCount,
+        .indexCount     = primitive.indexCount,
+        .indicesHash    = indicesHash,
+        .lastUsedFrame  = cachedDynamicFrame,
+    };
+    entry.built[ frameIndex ] = BuildAS( DynamicBuilder( frameIndex ),
+                                         *uploadedData,
+                                         geomFlags,
+                                         *allocPersistentDynamicGeom,
+                                         BLASBuildPolicy::FastBuild,
+                                         true );
+
+    auto [ iter, inserted ] = refitDynamic.emplace( uniqueID, std::move( entry ) );
+    assert( inserted );
+    return iter->second.built[ frameIndex ].get();
+}
+
+auto RTGL1::ASManager::FindPromotedDynamicAS( uint32_t                       frameIndex,
+                                              const PrimitiveUniqueID&       uniqueID,
+                                              const RgMeshPrimitiveInfo&     primitive,
+                                              VertexCollectorFilterTypeFlags geomFlags )
+    -> BuiltAS*
+{
+    const uint64_t contentHash = HashPrimitiveContent( primitive );
+
+    auto found = promotedDynamic.find( uniqueID );
+    if( found != promotedDynamic.end() )
+    {
+        CachedDynamicAS& p = found->second;
+
+        if( p.contentHash == contentHash && p.built->flags == geomFlags )
+        {
+            // no upload, vertex data and BLAS are persistent
+            p.lastUsedFrame = cachedDynamicFrame;
+            return p.built.get();
+        }
+
+        // demote
+        promotedLeakedVertices += p.built->geometry.asGeometryInfo.geometry.triangles.maxVertex;
+        cachedDynamicRetired[ frameIndex ].push_back( std::move( p ) );
+        promotedDynamic.erase( found );
+    }
+
+    // texture layers are not preserved in a pending copy
+    const bool canBePromoted = primitive.vertexCount > 0 &&
+                               primitive.vertexCount <= promotedVertexBudget &&
+                               !GeomInfoManager::LayerExists( primitive, 1 ) &&
+                               !GeomInfoManager::LayerExists( primitive, 2 ) &&
+                               !GeomInfoManager::LayerExists( primitive, 3 );
+    if( !canBePromoted )
+    {
+        return nullptr;
+    }
+
+    PromotionCandidate& c = promotionCandidates[ uniqueID ];
+    if( c.lastUsedFrame == cachedDynamicFrame )
+    {
+        // same primitive twice in a frame
+        return nullptr;
+    }
+
+    if( c.lastUsedFrame + 1 == cachedDynamicFrame && c.contentHash == contentHash &&
+        c.flags == geomFlags )
+    {
+        c.stableFrames++;
+    }
+    else
+    {
+        c = PromotionCandidate{
+            .contentHash  = contentHash,
+            .flags        = geomFlags,
+            .stableFrames = 1,
+        };
+    }
+    c.lastUsedFrame = cachedDynamicFrame;
+
+    if( c.stableFrames >= DYNAMIC_PROMOTION_FRAME_COUNT )
+    {
+        const bool useIndices = Utils::HasIndices( primitive );
+
+        // uploaded in the beginning of the next frame, before any other dynamic data
+        auto& pending = pendingPromotions.emplace_back( PendingPromotion{
+            .uniqueID = uniqueID,
+            .vertices = { primitive.pVertices, primitive.pVertices + primitive.vertexCount },
+            .indices  = {},
+            .flags       = geomFlags,
+            .contentHash = contentHash,
+        } );
+        if( useIndices )
+        {
+            pending.indices.reserve( primitive.indexCount );
+            for( uint32_t i = 0; i < primitive.indexCount; i++ )
+            {
+                pending.indices.push_back( Utils::GetIndex( primitive, i ) );
+            }
+        }
+        promotionCandidates.erase( uniqueID );
+    }
+
+    // this frame, upload as a regular dynamic
+    return nullptr;
+}
+
+void RTGL1::ASManager::UploadPendingPromotions( uint32_t frameIndex )
+{
+    // demote the ones that were not used in the previous frame
+    erase_if( promotedDynamic, [ this, frameIndex ]( auto& p ) {
+        if( p.second.lastUsedFrame + 1 < cachedDynamicFrame )
+        {
+            promotedLeakedVertices +=
+                p.second.built->geometry.asGeometryInfo.geometry.triangles.maxVertex;
+            cachedDynamicRetired[ frameIndex ].push_back( std::move( p.second ) );
+            return true;
+        }
+        return false;
+    } );
+    erase_if( promotionCandidates, [ this ]( const auto& c ) {
+        return c.second.lastUsedFrame + 1 < cachedDynamicFrame;
+    } );
+
+    // start over, if too much of the promoted vertex data is unused
+    if( promotedLeakedVertices > promotedRanges.vertices.count() / 2 )
+    {
+        ResetPromotedDynamic( frameIndex );
+    }
+
+    VertexCollector& collector = *collectorDynamic[ frameIndex ];
+
+    // this frame's collector has the promoted data that was uploaded the last time it was used
+    collector.ResetToPrefix( promotedUploadedRanges[ frameIndex ] );
+    promotedCopyStart = promotedUploadedRanges[ frameIndex ];
+
+    // replay the ones that were promoted in the other frames since then: the sequence of
+    // uploads is the same, so the data is at the same offsets as in their BLAS-es and geom infos
+    for( size_t k = promotedUploadedCount[ frameIndex ]; k < promotedUploads.size(); k++ )
+    {
+        const PendingPromotion& uploaded = promotedUploads[ k ];
+
+        const auto primitive = RgMeshPrimitiveInfo{
+            .sType       = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO,
+            .pNext       = nullptr,
+            .pVertices   = uploaded.vertices.data(),
+            .vertexCount = uint32_t( uploaded.vertices.size() ),
+            .pIndices    = uploaded.indices.empty() ? nullptr : uploaded.indices.data(),
+            .indexCount  = uint32_t( uploaded.indices.size() ),
+        };
+
+        // all collectors have the same capacity, it fit in the other one
+        [[maybe_unused]] auto replayed = collector.Upload( uploaded.flags, primitive );
+        assert( replayed );
+    }
+    assert( promotedUploads.empty() ||
+            collector.GetCurrentRanges().vertices.count() == promotedRanges.vertices.count() );
+
+    for( PendingPromotion& pending : pendingPromotions )
+    {
+        if( promotedDynamic.contains( pending.uniqueID ) ||
+            promotedRanges.vertices.count() + pending.vertices.size() > promotedVertexBudget )
+        {
+            continue;
+        }
+
+        const auto primitive = RgMeshPrimitiveInfo{
+            .sType       = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO,
+            .pNext       = nullptr,
+            .pVertices   = pending.vertices.data(),
+            .vertexCount = uint32_t( pending.vertices.size() ),
+            .pIndices    = pending.indices.empty() ? nullptr : pending.indices.data(),
+            .indexCount  = uint32_t( pending.indices.size() ),
+        };
+
+        auto uploadedData = collector.Upload( pending.flags, primitive );
+        if( !uploadedData )
+        {
+            break;
+        }
+
+        // content was stable for several frames, and is expected to stay so
+        const auto policy = LibConfig().adaptiveBlasFlags ? BLASBuildPolicy::FastTrace
+                                                          : BLASBuildPolicy::FastBuild;
+
+        std::unique_ptr< BuiltAS > built = BuildAS( DynamicBuilder( frameIndex ),
+                                                    *uploadedData,
+                                                    pending.flags,
+                                                    *allocPersistentDynamicGeom,
+                                                    policy );
+
+        promotedDynamic.emplace( pending.uniqueID,
+                                 CachedDynamicAS{
+                                     .built         = std::move( built ),
+                                     .contentHash   = pending.contentHash,
+                                     .lastUsedFrame = cachedDynamicFrame,
+                                 } );
+        promotedRanges = collector.GetCurrentRanges();
+        promotedUploads.push_back( std::move( pending ) );
+    }
+    pendingPromotions.clear();
+
+    promotedUploadedCount[ frameIndex ]  = uint32_t( promotedUploads.size() );
+    promotedUploadedRanges[ frameIndex ] = collector.GetCurrentRanges();
+}
+
+void RTGL1::ASManager::ResetPromotedDynamic( uint32_t frameIndex )
+{
+    for( auto& [ uniqueID, p ] : promotedDynamic )
+    {
+        cachedDynamicRetired[ frameIndex ].push_back( std::move( p ) );
+    }
+    promotedDynamic.clear();
+    promotedRanges         = {};
+    promotedLeakedVertices = 0;
+
+    promotedUploads.clear();
+    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        promotedUploadedCount[ i ]  = 0;
+        promotedUploadedRanges[ i ] = {};
     }
-    return std::unique_ptr< BuiltAS >{ newlyBuilt };
 }
 
-bool RTGL1::ASManager::AddMeshPrimitive( uint32_t                   frameIndex,
-                                         const RgMeshInfo&          mesh,
-                                         const RgMeshPrimitiveInfo& primitive,
-                                         const PrimitiveUniqueID&   uniqueID,
-                                         const bool                 isStatic,
-                                         const bool                 isReplacement,
-                                         const TextureManager&      textureManager,
-                                         GeomInfoManager&           geomInfoManager )
+bool RTGL1::ASManager::AddMeshPrimitive( uint32_t                        frameIndex,
+                                         const RgMeshInfo&               mesh,
+                                         const RgMeshPrimitiveInfo&      srcPrimitive,
+                                         const PrimitiveUniqueID&        uniqueID,
+                                         const bool                      isStatic,
+                                         const bool                      isReplacement,
+                                         const TextureManager&           textureManager,
+                                         GeomInfoManager&                geomInfoManager,
+                                         const bool                      allowBatching,
+                                         std::span< const PrimitiveLod > lods )
 {
-    if( geomInfoManager.GetCount( frameIndex ) >= MAX_GEOM_INFO_COUNT )
+    RG_CPU_ZONE( "ASManager::AddMeshPrimitive" );
+
+    if( geomInfoManager.GetCount( frameIndex ) >= geomInfoManager.GetMaxCount() )
     {
-        debug::Error( "Too many geometry infos: the limit is {}", MAX_GEOM_INFO_COUNT );
+        debug::Error( "Too many geometry infos: the limit is {}", geomInfoManager.GetMaxCount() );
         return false;
     }
 
 
+    // other texture layers would need to be split too
+    const bool canSplit = isStatic && !isReplacement && LibConfig().staticTriangleSplitting &&
+                          Utils::HasIndices( srcPrimitive ) &&
+                          !GeomInfoManager::LayerExists( srcPrimitive, 1 ) &&
+                          !GeomInfoManager::LayerExists( srcPrimitive, 2 ) &&
+                          !GeomInfoManager::LayerExists( srcPrimitive, 3 );
+
+    // splitting works with 32-bit indices
+    auto widenedIndices = std::vector< uint32_t >{};
+    if( canSplit && srcPrimitive.pIndices16 )
+    {
+        widenedIndices.reserve( srcPrimitive.indexCount );
+        for( uint32_t i = 0; i < srcPrimitive.indexCount; i++ )
+        {
+            widenedIndices.push_back( Utils::GetIndex( srcPrimitive, i ) );
+        }
+    }
+
+    const auto srcIndices = srcPrimitive.pIndices16
+                                ? std::span< const uint32_t >{ widenedIndices }
+                                : std::span{ srcPrimitive.pIndices, srcPrimitive.indexCount };
+
+    const auto split =
+        canSplit ? SplitLongTriangles( { srcPrimitive.pVertices, srcPrimitive.vertexCount },
+                                       srcIndices )
+                 : std::nullopt;
+
+    auto splitPrimitive = RgMeshPrimitiveInfo{};
+    if( split )
+    {
+        splitPrimitive             = srcPrimitive;
+        splitPrimitive.pVertices   = split->vertices.data();
+        splitPrimitive.vertexCount = static_cast< uint32_t >( split->vertices.size() );
+        splitPrimitive.pIndices    = split->indices.data();
+        splitPrimitive.pIndices16  = nullptr;
+        splitPrimitive.indexCount  = static_cast< uint32_t >( split->indices.size() );
+    }
+
+    // particles are expanded into non-indexed quads on GPU, only their vertex space is reserved
+    const auto particles = !isStatic && !isReplacement
+                               ? pnext::find< RgMeshPrimitiveParticlesEXT >( &srcPrimitive )
+                               : nullptr;
+    auto particleOffset    = std::optional< uint32_t >{};
+    auto particlePrimitive = RgMeshPrimitiveInfo{};
+    if( particles )
+    {
+        if( GeomInfoManager::LayerExists( srcPrimitive, 1 ) ||
+            GeomInfoManager::LayerExists( srcPrimitive, 2 ) ||
+            GeomInfoManager::LayerExists( srcPrimitive, 3 ) )
+        {
+            debug::Warning( "RgMeshPrimitiveParticlesEXT: texture layers are not supported" );
+            return false;
+        }
+
+        particleOffset = particleExpansion->PrepareParticles( frameIndex, *particles );
+        if( !particleOffset )
+        {
+            return false;
+        }
+
+        particlePrimitive           = srcPrimitive;
+        particlePrimitive.pVertices = nullptr;
+        particlePrimitive.vertexCount =
+            particles->particleCount * ParticleExpansion::VERTICES_PER_PARTICLE;
+        particlePrimitive.pIndices   = nullptr;
+        particlePrimitive.pIndices16 = nullptr;
+        particlePrimitive.indexCount = 0;
+    }
+
+    const RgMeshPrimitiveInfo& primitive = particles ? particlePrimitive
+                                           : split   ? splitPrimitive
+                                                     : srcPrimitive;
+
+
     const auto geomFlags =
         VertexCollectorFilterTypeFlags_GetForGeometry( mesh, primitive, isStatic, isReplacement );
 
+    // if can't be skinned on GPU, pVertices are used as is
+    const auto skin = !isStatic && !isReplacement && !particles
+                          ? pnext::find< RgMeshPrimitiveSkinningEXT >( &primitive )
+                          : nullptr;
+    const auto bindPoseOffset =
+        skin ? skinning->PrepareBindPose( frameIndex, uniqueID, primitive, *skin ) : std::nullopt;
+    const bool skinnedOnDevice = bindPoseOffset.has_value();
+    // vertex content is not known on CPU
+    const bool verticesOnDevice = skinnedOnDevice || particleOffset.has_value();
+
+    const auto area = pnext::find< RgMeshAreaEXT >( &mesh );
+
+    // batches don't track areas
+    if( allowBatching && !isStatic && !isReplacement && !verticesOnDevice && !area &&
+        LibConfig().dynamicBatching )
+    {
+        if( TryAddToDynamicBatch(
+                frameIndex, mesh, primitive, geomFlags, textureManager, geomInfoManager ) )
+        {
+            return true;
+        }
+    }
+
     // if exceeds a limit of geometries in a group with specified geomFlags
-    if( curFrame_objects.size() >= MAX_INSTANCE_COUNT )
+    if( curFrame_objects.size() + staticClusterCandidates.size() + staticClusterExtraInstances >=
+        maxInstanceCount )
     {
         using FT = VertexCollectorFilterTypeFlagBits;
         debug::Error( "Too many geometries in a group ({}-{}-{}). Limit is {}",
                       uint32_t( geomFlags & FT::MASK_CHANGE_FREQUENCY_GROUP ),
                       uint32_t( geomFlags & FT::MASK_PASS_THROUGH_GROUP ),
                       uint32_t( geomFlags & FT::MASK_PRIMARY_VISIBILITY_GROUP ),
-                      MAX_INSTANCE_COUNT );
+                      maxInstanceCount );
         return false;
     }
 
 
     auto builtInstance = static_cast< BuiltAS* >( nullptr );
+    // if true, TLAS instance is made for the whole cluster in BuildStaticClusters
+    bool toCluster     = false;
 
     if( isReplacement )
     {
@@ -851,33 +2664,168 @@ bool RTGL1::ASManager::AddMeshPrimitive( uint32_t                   frameIndex,
             return false;
         }
 
-        std ::unique_ptr< BuiltAS > created =
-            UploadAndBuildAS( primitive,
-                              geomFlags,
-                              isStatic ? *collectorStatic : *collectorDynamic[ frameIndex ],
-                              isStatic ? *allocStaticGeom : *( allocDynamicGeom[ frameIndex ] ),
-                              !isStatic );
-        builtInstance = created.get();
+        // texture coordinates of layers are not a part of the key
+        const bool canBeInstanced = !isStatic && !verticesOnDevice &&
+                                    LibConfig().dynamicInstancing &&
+                                    !GeomInfoManager::LayerExists( primitive, 1 ) &&
+                                    !GeomInfoManager::LayerExists( primitive, 2 ) &&
+                                    !GeomInfoManager::LayerExists( primitive, 3 );
+        const auto instancingKey =
+            canBeInstanced ? std::optional{ HashInstancingKey( mesh, primitive, geomFlags ) }
+                           : std::nullopt;
+
+        if( instancingKey )
+        {
+            if( auto found = curFrame_dynamicInstancing.find( *instancingKey );
+                found != curFrame_dynamicInstancing.end() )
+            {
+                // only a new TLAS instance and geometry info with its own transform
+                builtInstance = found->second;
+            }
+        }
 
-        if( isStatic )
+        // content written on GPU changes each frame, and it's not known on CPU
+        if( !builtInstance && !isStatic && !verticesOnDevice && promoteDynamic )
         {
-            builtStaticInstances.push_back( std::move( created ) );
+            builtInstance = FindPromotedDynamicAS( frameIndex, uniqueID, primitive, geomFlags );
         }
-        else
+
+        if( !builtInstance && !isStatic && ( primitive.flags & RG_MESH_PRIMITIVE_TOPOLOGY_STABLE ) )
+        {
+            builtInstance = UploadAndRefitDynamicAS(
+                frameIndex, uniqueID, primitive, geomFlags, verticesOnDevice );
+        }
+
+        if( !builtInstance && !isStatic && !verticesOnDevice && LibConfig().dynamicBlasCache )
+        {
+            builtInstance =
+                UploadAndBuildCachedDynamicAS( frameIndex, uniqueID, primitive, geomFlags );
+        }
+
+        if( !builtInstance && isStatic && allowBatching && lods.empty() && staticClustering )
+        {
+            auto uploaded = collectorStatic->Upload( geomFlags, primitive );
+            if( !uploaded )
+            {
+                return false;
+            }
+
+            auto member = std::unique_ptr< BuiltAS >( new BuiltAS{
+                .flags    = geomFlags,
+                .blas     = BLASComponent{ device },
+                .geometry = *uploaded,
+                .omm      = allocStaticOmm ? MakeOpacityMicromap(
+                                            primitive, geomFlags, textureManager, *allocStaticOmm )
+                                      : nullptr,
+                .policy   = ChooseStaticBuildPolicy( uniqueID ),
+            } );
+            if( member->omm )
+            {
+                member->geometry.asGeometryInfo.geometry.triangles.pNext =
+                    member->omm->GetAttachment();
+            }
+            builtInstance = member.get();
+            toCluster     = true;
+
+            const auto [ mn, mx ] = MakeLocalBounds( primitive );
+            staticClusterCandidates.push_back( StaticClusterCandidate{
+                .built     = std::move( member ),
+                .uniqueID  = uniqueID,
+                .transform = mesh.transform,
+                .areaIndex = area ? area->areaIndex : NO_AREA,
+                .boundsMin = mn,
+                .boundsMax = mx,
+            } );
+        }
+
+        if( !builtInstance )
+        {
+            if( isStatic )
+            {
+                std::unique_ptr< BuiltAS > created = UploadAndBuildAS(
+                    *asBuilder,
+                    primitive,
+                    geomFlags,
+                    *collectorStatic,
+                    *allocStaticGeom,
+                    ChooseStaticBuildPolicy( uniqueID ),
+                    allocStaticOmm ? MakeOpacityMicromap(
+                                         primitive, geomFlags, textureManager, *allocStaticOmm )
+                                   : nullptr );
+                if( !created )
+                {
+                    return false;
+                }
+
+                UploadAndBuildLods(
+                    *created, primitive, lods, *asBuilder, *collectorStatic, *allocStaticGeom );
+
+                builtInstance = created.get();
+                builtStaticInstances.push_back( std::move( created ) );
+            }
+            else
+            {
+                builtInstance =
+                    UploadAndBuildDynamicAS( frameIndex, primitive, geomFlags, verticesOnDevice );
+                if( !builtInstance )
+                {
+                    return false;
+                }
+            }
+        }
+
+        if( instancingKey && builtInstance )
         {
-            builtDynamicInstances[ frameIndex ].push_back( std::move( created ) );
+            curFrame_dynamicInstancing.try_emplace( *instancingKey, builtInstance );
         }
     }
 
 
+    if( skinnedOnDevice )
+    {
+        skinning->AddJob( frameIndex,
+                          *bindPoseOffset,
+                          primitive.vertexCount,
+                          *skin,
+                          builtInstance->geometry.firstVertex );
+    }
+    if( particleOffset )
+    {
+        particleExpansion->AddJob( frameIndex,
+                                   *particleOffset,
+                                   *particles,
+                                   mesh.transform,
+                                   builtInstance->geometry.firstVertex );
+    }
+
+    const bool hasLods = !builtInstance->lods.empty();
+
+    // replacements don't keep their vertices, so LOD bounds are saved on upload;
+    // dynamic bounds are only for culling, negative radius if not computed
+    const auto [ boundsCenter, boundsRadius ] =
+        hasLods ? MakeBoundingSphere(
+                      builtInstance->lodBoundsMin, builtInstance->lodBoundsMax, mesh.transform )
+        : isStatic               ? std::pair{ RgFloat3D{}, 0.0f }
+        : !dynamicCullingEnabled ? std::pair{ RgFloat3D{}, -1.0f }
+        : skinnedOnDevice        ? MakeSkinnedBoundingSphere( primitive, *skin, mesh.transform )
+        : particles              ? MakeParticlesBoundingSphere( *particles, mesh.transform )
+                                 : MakeBoundingSphere( primitive, mesh.transform );
+
     // register the built instance as an instance in this frame
-    curFrame_objects.push_back( Object{
-        .builtInstance = builtInstance,
-        .isStatic      = isStatic,
-        .uniqueID      = uniqueID,
-        .transform     = mesh.transform,
-        .instanceFlags = geomFlags,
-    } );
+    if( !toCluster )
+    {
+        curFrame_objects.push_back( Object{
+            .builtInstance = builtInstance,
+            .isStatic      = isStatic,
+            .uniqueID      = uniqueID,
+            .transform     = mesh.transform,
+            .instanceFlags = geomFlags,
+            .boundsCenter  = boundsCenter,
+            .boundsRadius  = boundsRadius,
+            .areaIndex     = area ? area->areaIndex : NO_AREA,
+            .lodBase       = hasLods ? builtInstance : nullptr,
+        } );
+    }
 
     // make geom info
     {
@@ -890,17 +2838,22 @@ bool RTGL1::ASManager::AddMeshPrimitive( uint32_t                   frameIndex,
             .model_1 = { RG_ACCESS_VEC4( mesh.transform.matrix[ 1 ] ) },
             .model_2 = { RG_ACCESS_VEC4( mesh.transform.matrix[ 2 ] ) },
 
-            .prevModel_0 = { /* set in geomInfoManager */ },
-            .prevModel_1 = { /* set in geomInfoManager */ },
-            .prevModel_2 = { /* set in geomInfoManager */ },
-
             .flags = GeomInfoManager::GetPrimitiveFlags( &mesh, primitive, !isStatic && !isReplacement ),
 
+            .materialIndex = { /* set in geomInfoManager */ },
+
+            .vertexCount = primitive.vertexCount,
+            .indexCount = builtInstance->geometry.firstIndex ? primitive.indexCount : UINT32_MAX,
+        };
+        WriteGeometryLocation( geomInfo, builtInstance->geometry );
+
+        const auto material = ShGeometryMaterial{
             .texture_base = layerTextures[ 0 ].indices[ TEXTURE_ALBEDO_ALPHA_INDEX ],
             .texture_base_ORM =
                 layerTextures[ 0 ].indices[ TEXTURE_OCCLUSION_ROUGHNESS_METALLIC_INDEX ],
             .texture_base_N = layerTextures[ 0 ].indices[ TEXTURE_NORMAL_INDEX ],
             .texture_base_E = layerTextures[ 0 ].indices[ TEXTURE_EMISSIVE_INDEX ],
+            .texture_base_D = layerTextures[ 0 ].indices[ TEXTURE_HEIGHT_INDEX ],
 
             .texture_layer1 = layerTextures[ 1 ].indices[ TEXTURE_ALBEDO_ALPHA_INDEX ],
             .texture_layer2 = layerTextures[ 2 ].indices[ TEXTURE_ALBEDO_ALPHA_INDEX ],
@@ -911,39 +2864,209 @@ bool RTGL1::ASManager::AddMeshPrimitive( uint32_t                   frameIndex,
             .colorFactor_layer2 = layerColors[ 2 ],
             .colorFactor_layer3 = layerColors[ 3 ],
 
-            .baseVertexIndex     = builtInstance->geometry.firstVertex,
-            .baseIndexIndex      = builtInstance->geometry.firstIndex
-                                       ? *builtInstance->geometry.firstIndex
-                                       : UINT32_MAX,
-            .prevBaseVertexIndex = { /* set in geomInfoManager */ },
-            .prevBaseIndexIndex  = { /* set in geomInfoManager */ },
-            .vertexCount         = primitive.vertexCount,
-            .indexCount = builtInstance->geometry.firstIndex ? primitive.indexCount : UINT32_MAX,
-
-            .texture_base_D = layerTextures[ 0 ].indices[ TEXTURE_HEIGHT_INDEX ],
-
             .roughnessDefault_metallicDefault =
                 ( floatToUint8( pbrInfo ? pbrInfo->roughnessDefault : 1.0f ) << 0 ) |
                 ( floatToUint8( pbrInfo ? pbrInfo->metallicDefault : 0.0f ) << 8 ),
 
             .emissiveMult = Utils::Saturate( primitive.emissive ),
-
-            // values ignored if doesn't exist
-            .firstVertex_Layer1 = builtInstance->geometry.firstVertex_Layer1,
-            .firstVertex_Layer2 = builtInstance->geometry.firstVertex_Layer2,
-            .firstVertex_Layer3 = builtInstance->geometry.firstVertex_Layer3,
         };
 
+        if( isStatic && EmissiveTriangles::IsEmissive( primitive, layerTextures[ 0 ] ) )
+        {
+            // direct illumination samples its emission, so indirect should ignore it
+            if( emissiveTriangles->Add(
+                    mesh.transform, primitive, layerTextures[ 0 ], layerColors[ 0 ] ) )
+            {
+                geomInfo.flags |= GEOM_INST_FLAG_EMISSIVE_SAMPLED;
+            }
+        }
+
         // global geometry index -- for indexing in geom infos buffer
         // local geometry index -- index of geometry in BLAS
         geomInfoManager.WriteGeomInfo( frameIndex,
                                        uniqueID,
                                        geomInfo,
+                                       material,
                                        isStatic,
                                        ( primitive.flags & RG_MESH_PRIMITIVE_NO_MOTION_VECTORS ) );
     }
 
-    return true;
+    return true;
+}
+
+bool RTGL1::ASManager::TryAddToDynamicBatch( uint32_t                       frameIndex,
+                                             const RgMeshInfo&              mesh,
+                                             const RgMeshPrimitiveInfo&     primitive,
+                                             VertexCollectorFilterTypeFlags geomFlags,
+                                             const TextureManager&          textureManager,
+                                             GeomInfoManager&               geomInfoManager )
+{
+    const auto& m = mesh.transform.matrix;
+
+    const bool     useIndices    = Utils::HasIndices( primitive );
+    const uint32_t triangleCount =
+        ( useIndices ? primitive.indexCount : primitive.vertexCount ) / 3;
+
+    // cofactors, to transform normals if there's a non-uniform scale
+    const float cof[ 3 ][ 3 ] = {
+        {
+            m[ 1 ][ 1 ] * m[ 2 ][ 2 ] - m[ 1 ][ 2 ] * m[ 2 ][ 1 ],
+            m[ 1 ][ 2 ] * m[ 2 ][ 0 ] - m[ 1 ][ 0 ] * m[ 2 ][ 2 ],
+            m[ 1 ][ 0 ] * m[ 2 ][ 1 ] - m[ 1 ][ 1 ] * m[ 2 ][ 0 ],
+        },
+        {
+            m[ 2 ][ 1 ] * m[ 0 ][ 2 ] - m[ 2 ][ 2 ] * m[ 0 ][ 1 ],
+            m[ 2 ][ 2 ] * m[ 0 ][ 0 ] - m[ 2 ][ 0 ] * m[ 0 ][ 2 ],
+            m[ 2 ][ 0 ] * m[ 0 ][ 1 ] - m[ 2 ][ 1 ] * m[ 0 ][ 0 ],
+        },
+        {
+            m[ 0 ][ 1 ] * m[ 1 ][ 2 ] - m[ 0 ][ 2 ] * m[ 1 ][ 1 ],
+            m[ 0 ][ 2 ] * m[ 1 ][ 0 ] - m[ 0 ][ 0 ] * m[ 1 ][ 2 ],
+            m[ 0 ][ 0 ] * m[ 1 ][ 1 ] - m[ 0 ][ 1 ] * m[ 1 ][ 0 ],
+        },
+    };
+    const float det = m[ 0 ][ 0 ] * cof[ 0 ][ 0 ] + m[ 0 ][ 1 ] * cof[ 0 ][ 1 ] +
+                      m[ 0 ][ 2 ] * cof[ 0 ][ 2 ];
+
+    // extensions (texture layers, PBR, etc) are not preserved in a batch;
+    // mirroring would flip the winding, and so generated normals
+    if( primitive.pNext || !primitive.pVertices || triangleCount == 0 ||
+        triangleCount > DYNAMIC_BATCH_MAX_PRIMITIVE_TRIANGLES || !( det > 0 ) )
+    {
+        return false;
+    }
+
+    // already in place, and staging memory is slow to read back
+    if( collectorDynamic[ frameIndex ]->FindStagingVertexIndex( primitive ) )
+    {
+        return false;
+    }
+
+    const uint64_t key   = HashBatchKey( mesh, primitive, geomFlags );
+    DynamicBatch&  batch = dynamicBatches[ key ];
+
+    if( batch.vertices.size() + primitive.vertexCount > DYNAMIC_BATCH_MAX_VERTEX_COUNT )
+    {
+        // full, continue in a new one with the same key
+        AddDynamicBatch( frameIndex, key, batch, textureManager, geomInfoManager );
+    }
+
+    if( batch.vertices.empty() )
+    {
+        batch.meshFlags   = mesh.flags;
+        batch.primitive   = primitive;
+        batch.textureName = Utils::SafeCstr( primitive.pTextureName );
+    }
+
+    const auto baseVertex = uint32_t( batch.vertices.size() );
+
+    dynamicBatchNormals.resize( primitive.vertexCount );
+    for( uint32_t v = 0; v < primitive.vertexCount; v++ )
+    {
+        const RgPrimitiveVertex& src = primitive.pVertices[ v ];
+        const RgFloat3D          n   = Utils::UnpackNormal( src.normalPacked );
+
+        RgPrimitiveVertex dst = src;
+        for( int i = 0; i < 3; i++ )
+        {
+            dst.position[ i ] = m[ i ][ 0 ] * src.position[ 0 ] + m[ i ][ 1 ] * src.position[ 1 ] +
+                                m[ i ][ 2 ] * src.position[ 2 ] + m[ i ][ 3 ];
+        }
+        for( int i = 0; i < 3; i++ )
+        {
+            dynamicBatchNormals[ v ].data[ i ] = cof[ i ][ 0 ] * n.data[ 0 ] +
+                                                 cof[ i ][ 1 ] * n.data[ 1 ] +
+                                                 cof[ i ][ 2 ] * n.data[ 2 ];
+        }
+
+        batch.vertices.push_back( dst );
+    }
+    if( primitive.vertexCount > 0 )
+    {
+        BatchMath::PackNormals( dynamicBatchNormals.data(),
+                                primitive.vertexCount,
+                                &batch.vertices[ baseVertex ].normalPacked,
+                                sizeof( RgPrimitiveVertex ) );
+    }
+
+    for( uint32_t i = 0; i < triangleCount * 3; i++ )
+    {
+        const uint32_t local = useIndices ? Utils::GetIndex( primitive, i ) : i;
+        batch.indices.push_back( baseVertex + local );
+    }
+
+    return true;
+}
+
+bool RTGL1::ASManager::AddDynamicBatch( uint32_t              frameIndex,
+                                        uint64_t              key,
+                                        DynamicBatch&         batch,
+                                        const TextureManager& textureManager,
+                                        GeomInfoManager&      geomInfoManager )
+{
+    if( batch.vertices.empty() )
+    {
+        return true;
+    }
+
+    const auto mesh = RgMeshInfo{
+        .sType                = RG_STRUCTURE_TYPE_MESH_INFO,
+        .pNext                = nullptr,
+        .flags                = batch.meshFlags,
+        .uniqueObjectID       = key,
+        .pMeshName            = nullptr,
+        .transform            = RG_TRANSFORM_IDENTITY,
+        .isExportable         = false,
+        .animationTime        = 0.0f,
+        .localLightsIntensity = 1.0f,
+    };
+
+    RgMeshPrimitiveInfo primitive = batch.primitive;
+    {
+        // batch content changes between frames, so there's no correspondence to the previous
+        primitive.flags |= RG_MESH_PRIMITIVE_NO_MOTION_VECTORS;
+        primitive.primitiveIndexInMesh = batch.sequence++;
+        primitive.pVertices            = batch.vertices.data();
+        primitive.vertexCount          = uint32_t( batch.vertices.size() );
+        primitive.pIndices             = batch.indices.data();
+        primitive.pIndices16           = nullptr;
+        primitive.indexCount           = uint32_t( batch.indices.size() );
+        primitive.pTextureName         = batch.textureName.c_str();
+    }
+
+    auto uniqueID = PrimitiveUniqueID{ mesh, primitive };
+    uniqueID.primitiveIndex |= DYNAMIC_BATCH_PRIMITIVE_INDEX_BIT;
+
+    const bool added = AddMeshPrimitive( frameIndex,
+                                         mesh,
+                                         primitive,
+                                         uniqueID,
+                                         false,
+                                         false,
+                                         textureManager,
+                                         geomInfoManager,
+                                         false );
+
+    // batch storage is reused, so can't defer
+    VertexCollector::DeferredStagingCopies::FlushCurrent();
+
+    batch.vertices.clear();
+    batch.indices.clear();
+    return added;
+}
+
+void RTGL1::ASManager::FlushDynamicBatches( uint32_t              frameIndex,
+                                            const TextureManager& textureManager,
+                                            GeomInfoManager&      geomInfoManager )
+{
+    // drop the ones that were not used in this frame
+    erase_if( dynamicBatches, []( const auto& b ) { return b.second.vertices.empty(); } );
+
+    for( auto& [ key, batch ] : dynamicBatches )
+    {
+        AddDynamicBatch( frameIndex, key, batch, textureManager, geomInfoManager );
+        batch.sequence = 0;
+    }
 }
 
 void RTGL1::ASManager::Hack_PatchTexturesForStaticPrimitive( const PrimitiveUniqueID& uniqueID,
@@ -961,34 +3084,86 @@ void RTGL1::ASManager::Hack_PatchTexturesForStaticPrimitive( const PrimitiveUniq
         textures_layer0.indices[ TEXTURE_HEIGHT_INDEX ] );
 }
 
-void RTGL1::ASManager::Hack_PatchGeomInfoTransformForStatic( const PrimitiveUniqueID& geomUniqueID,
-                                                             const RgTransform&       transform )
+void RTGL1::ASManager::Hack_PatchGeomInfoTransformsForStatic(
+    std::span< const std::pair< PrimitiveUniqueID, RgTransform > > transforms )
 {
+    if( transforms.empty() )
+    {
+        return;
+    }
+
+    // index in 'transforms', or none if the primitive can't be moved
+    auto toPatch = rgl::unordered_map< PrimitiveUniqueID, std::optional< size_t > >{};
+    toPatch.reserve( transforms.size() );
+    for( size_t i = 0; i < transforms.size(); i++ )
+    {
+        toPatch[ transforms[ i ].first ] = i;
+    }
+
+    // one pass over the objects for all transforms
     for( Object& obj : curFrame_objects )
     {
-        if( obj.isStatic && obj.uniqueID == geomUniqueID )
+        if( !obj.isStatic )
         {
-            obj.transform = transform;
-            break;
+            continue;
+        }
+
+        if( obj.builtInstance->clusterUniqueIDs.size() > 1 )
+        {
+            for( const PrimitiveUniqueID& clusterID : obj.builtInstance->clusterUniqueIDs )
+            {
+                auto found = toPatch.find( clusterID );
+                if( found != toPatch.end() && found->second )
+                {
+                    debug::Warning(
+                        "Can't move a primitive {}-{}, it shares BLAS with other primitives",
+                        clusterID.objectId,
+                        clusterID.primitiveIndex );
+                    found->second = std::nullopt;
+                }
+            }
+            continue;
+        }
+
+        auto found = toPatch.find( obj.uniqueID );
+        if( found != toPatch.end() && found->second )
+        {
+            obj.transform = transforms[ *found->second ].second;
         }
     }
 
-    geomInfoMgr->Hack_PatchGeomInfoTransformForStatic( geomUniqueID, transform );
+    for( const auto& [ uniqueID, index ] : toPatch )
+    {
+        if( index )
+        {
+            geomInfoMgr->Hack_PatchGeomInfoTransformForStatic( uniqueID,
+                                                               transforms[ *index ].second );
+        }
+    }
 }
 
-void RTGL1::ASManager::CacheReplacement( std::string_view           meshName,
-                                         const RgMeshPrimitiveInfo& primitive,
-                                         uint32_t                   index )
+void RTGL1::ASManager::CacheReplacement( std::string_view                meshName,
+                                         const RgMeshPrimitiveInfo&      primitive,
+                                         uint32_t                        index,
+                                         const TextureManager&           textureManager,
+                                         std::span< const PrimitiveLod > lods )
 {
     constexpr bool isReplacement = true;
     constexpr bool isStatic      = false;
-    constexpr bool isDynamic     = false;
 
     const auto geomFlags =
         VertexCollectorFilterTypeFlags_GetForGeometry( {}, primitive, isStatic, isReplacement );
 
     std::unique_ptr< BuiltAS > builtInstance = UploadAndBuildAS(
-        primitive, geomFlags, *collectorStatic, *allocReplacementsGeom, isDynamic );
+        *asBuilder,
+        primitive,
+        geomFlags,
+        *collectorStatic,
+        *allocReplacementsGeom,
+        TracePolicy(),
+        allocReplacementsOmm
+            ? MakeOpacityMicromap( primitive, geomFlags, textureManager, *allocReplacementsOmm )
+            : nullptr );
 
     if( !builtInstance )
     {
@@ -996,6 +3171,9 @@ void RTGL1::ASManager::CacheReplacement( std::string_view           meshName,
         return;
     }
 
+    UploadAndBuildLods(
+        *builtInstance, primitive, lods, *asBuilder, *collectorStatic, *allocReplacementsGeom );
+
     // TODO: look at the note above on primitiveIndex
     assert( builtReplacements[ meshName ].size() == index );
     builtReplacements[ meshName ].push_back( std::move( builtInstance ) );
@@ -1003,16 +3181,39 @@ void RTGL1::ASManager::CacheReplacement( std::string_view           meshName,
 
 void RTGL1::ASManager::SubmitDynamicGeometry( DynamicGeometryToken& token,
                                               VkCommandBuffer       cmd,
-                                              uint32_t              frameIndex )
+                                              uint32_t              frameIndex,
+                                              const GlobalUniform&  uniform )
 {
     assert( token );
     token = {};
 
+    if( staticBuildBarrierPending )
+    {
+        // static vertex data and BLAS-es must be ready for TLAS build and shaders
+        FullMemoryBarrier( cmd );
+        staticBuildBarrierPending = false;
+    }
+
+    if( asyncBuild && !asyncBuilder[ frameIndex ]->IsEmpty() )
+    {
+        SubmitDynamicGeometryAsync( frameIndex, uniform );
+        return;
+    }
+
     {
         auto label = CmdLabel{ cmd, "Vertex data" };
-        collectorDynamic[ frameIndex ]->CopyFromStaging( cmd );
+        // promoted vertex data that this collector had before is already in its device-local
+        // buffers, the replayed and the new ones are copied with the rest
+        collectorDynamic[ frameIndex ]->CopyFromStaging(
+            cmd,
+            VertexCollector::CopyRanges::RemoveAtStart(
+                collectorDynamic[ frameIndex ]->GetCurrentRanges(), promotedCopyStart ) );
     }
 
+    // skinned and particle vertices are written after the copy, and before the BLAS build
+    skinning->Dispatch( cmd, frameIndex, uniform, buffersDescSets[ frameIndex ] );
+    particleExpansion->Dispatch( cmd, frameIndex, uniform, buffersDescSets[ frameIndex ] );
+
 
     if( asBuilder->BuildBottomLevel( cmd ) )
     {
@@ -1021,22 +3222,91 @@ void RTGL1::ASManager::SubmitDynamicGeometry( DynamicGeometryToken& token,
     }
 }
 
+void RTGL1::ASManager::SubmitDynamicGeometryAsync( uint32_t             frameIndex,
+                                                   const GlobalUniform& uniform )
+{
+    VkCommandBuffer asyncCmd = cmdManager->StartAsyncComputeCmd();
+
+    // refit reads the BLAS that was built by the previous async submission
+    FullMemoryBarrier( asyncCmd );
+
+    {
+        auto label = CmdLabel{ asyncCmd, "Vertex data" };
+        collectorDynamic[ frameIndex ]->CopyFromStaging( asyncCmd );
+    }
+
+    skinning->Dispatch( asyncCmd, frameIndex, uniform, buffersDescSets[ frameIndex ] );
+    particleExpansion->Dispatch( asyncCmd, frameIndex, uniform, buffersDescSets[ frameIndex ] );
+
+    {
+        auto label = CmdLabel{ asyncCmd, "Dynamic BLAS" };
+        asyncBuilder[ frameIndex ]->BuildBottomLevel( asyncCmd );
+    }
+
+    cmdManager->Submit_Binary( asyncCmd, {}, asyncBuildFinished[ frameIndex ], VK_NULL_HANDLE );
+
+    // only the consumers of BLAS-es and vertex data wait, so rasterization
+    // that is recorded in the frame's command buffer is overlapped with the build
+    constexpr VkPipelineStageFlags consumers =
+        VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+        VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+    cmdManager->WaitSemaphoreOnGraphics( asyncBuildFinished[ frameIndex ], consumers );
+}
+
 auto RTGL1::ASManager::MakeVkTLAS( const BuiltAS&                 builtAS,
                                    uint32_t                       rayCullMaskWorld,
                                    const RgTransform&             instanceTransform,
                                    VertexCollectorFilterTypeFlags instanceFlags )
     -> std::optional< VkAccelerationStructureInstanceKHR >
 {
-    using FT = VertexCollectorFilterTypeFlagBits;
-
     auto rgToVkTransform = []( const RgTransform& t ) {
-        return VkTransformMatrixKHR{ {
-            { t.matrix[ 0 ][ 0 ], t.matrix[ 0 ][ 1 ], t.matrix[ 0 ][ 2 ], t.matrix[ 0 ][ 3 ] },
-            { t.matrix[ 1 ][ 0 ], t.matrix[ 1 ][ 1 ], t.matrix[ 1 ][ 2 ], t.matrix[ 1 ][ 3 ] },
-            { t.matrix[ 2 ][ 0 ], t.matrix[ 2 ][ 1 ], t.matrix[ 2 ][ 2 ], t.matrix[ 2 ][ 3 ] },
-        } };
+        auto r = VkTransformMatrixKHR{};
+        BatchMath::ToVkTransforms( &t, 1, &r );
+        return r;
+    };
+
+
+    auto instance = MakeVkTLASParams( builtAS, rayCullMaskWorld, instanceFlags );
+    if( !instance )
+    {
+        return {};
+    }
+
+
+    // quantized vertices are placed in the local space by the instance
+    auto withDequant = [ &builtAS ]( const RgTransform& t ) {
+        if( !builtAS.geometry.dequant )
+        {
+            return t;
+        }
+        const auto& [ c, e ] = *builtAS.geometry.dequant;
+
+        auto r = RgTransform{};
+        for( int i = 0; i < 3; i++ )
+        {
+            for( int j = 0; j < 3; j++ )
+            {
+                r.matrix[ i ][ j ] = t.matrix[ i ][ j ] * e.data[ j ];
+            }
+            r.matrix[ i ][ 3 ] = t.matrix[ i ][ 0 ] * c.data[ 0 ] +
+                                 t.matrix[ i ][ 1 ] * c.data[ 1 ] +
+                                 t.matrix[ i ][ 2 ] * c.data[ 2 ] + t.matrix[ i ][ 3 ];
+        }
+        return r;
     };
 
+    instance->transform = rgToVkTransform( withDequant( instanceTransform ) );
+    return instance;
+}
+
+auto RTGL1::ASManager::MakeVkTLASParams( const BuiltAS&                 builtAS,
+                                         uint32_t                       rayCullMaskWorld,
+                                         VertexCollectorFilterTypeFlags instanceFlags )
+    -> std::optional< VkAccelerationStructureInstanceKHR >
+{
+    using FT = VertexCollectorFilterTypeFlagBits;
+
 
     if( builtAS.blas.GetAS() == VK_NULL_HANDLE )
     {
@@ -1046,7 +3316,7 @@ auto RTGL1::ASManager::MakeVkTLAS( const BuiltAS&                 builtAS,
 
 
     auto instance = VkAccelerationStructureInstanceKHR{
-        .transform                              = rgToVkTransform( instanceTransform ),
+        .transform                              = {},
         .instanceCustomIndex                    = 0,
         .mask                                   = 0,
         .instanceShaderBindingTableRecordOffset = 0,
@@ -1126,10 +3396,19 @@ auto RTGL1::ASManager::MakeVkTLAS( const BuiltAS&                 builtAS,
     if( filter & FT::PT_ALPHA_TESTED )
     {
         instance.instanceShaderBindingTableRecordOffset = SBT_INDEX_HITGROUP_ALPHA_TESTED;
-        instance.flags = VK_GEOMETRY_INSTANCE_FORCE_NO_OPAQUE_BIT_KHR |
-                         VK_GEOMETRY_INSTANCE_TRIANGLE_FRONT_COUNTERCLOCKWISE_BIT_KHR /*|
-                         VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR*/
-            ;
+        if( builtAS.omm )
+        {
+            // geometry is non-opaque anyway, but the micromap's
+            // opaque / transparent states must not be overridden
+            instance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FRONT_COUNTERCLOCKWISE_BIT_KHR;
+        }
+        else
+        {
+            instance.flags = VK_GEOMETRY_INSTANCE_FORCE_NO_OPAQUE_BIT_KHR |
+                             VK_GEOMETRY_INSTANCE_TRIANGLE_FRONT_COUNTERCLOCKWISE_BIT_KHR /*|
+                             VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR*/
+                ;
+        }
     }
     else
     {
@@ -1147,38 +3426,356 @@ auto RTGL1::ASManager::MakeVkTLAS( const BuiltAS&                 builtAS,
 }
 
 
+void RTGL1::ASManager::CullDynamicInstances( const GlobalUniform&                    uniform,
+                                              const RgDrawFrameInstanceCullingParams& params )
+{
+    instanceStats         = {};
+    dynamicCullingEnabled = params.enable;
+
+    // culled instances are made inactive on GPU, so the geometry instances keep their indices
+    if( tlasInstanceGeneration )
+    {
+        gpuCulling                  = params;
+        instanceStats.instanceCount = static_cast< uint32_t >( curFrame_objects.size() );
+        return;
+    }
+
+    if( params.enable )
+    {
+        const ShGlobalUniform* gu = uniform.GetData();
+
+        // an instance is culled only if it's culled for every view
+        const uint32_t viewCount = std::clamp< uint32_t >( gu->viewCount, 1, MAX_VIEW_COUNT );
+
+        // side planes of the frustum (near/far are ignored, as projection might be infinite),
+        // made from the rows of a column-major view-projection
+        float planes[ MAX_VIEW_COUNT ][ 4 ][ 4 ];
+        for( uint32_t v = 0; v < viewCount; v++ )
+        {
+            float viewProj[ 16 ];
+            Matrix::Multiply( viewProj, &gu->viewsView[ 16 * v ], &gu->viewsProjection[ 16 * v ] );
+
+            for( int p = 0; p < 4; p++ )
+            {
+                const int   row  = p / 2;
+                const float sign = p % 2 == 0 ? 1.0f : -1.0f;
+
+                float len = 0;
+                for( int i = 0; i < 4; i++ )
+                {
+                    planes[ v ][ p ][ i ] = viewProj[ i * 4 + 3 ] + sign * viewProj[ i * 4 + row ];
+                    len += i < 3 ? planes[ v ][ p ][ i ] * planes[ v ][ p ][ i ] : 0;
+                }
+                len = std::sqrt( len );
+                for( float& f : planes[ v ][ p ] )
+                {
+                    f = len > 0 ? f / len : 0;
+                }
+            }
+        }
+
+        const auto isCulledForView = [ & ]( const Object& o, uint32_t v ) {
+            const float* c   = o.boundsCenter.data;
+            const float* cam = &gu->viewsCameraPosition[ 4 * v ];
+
+            if( params.maxDistance > 0 )
+            {
+                const float dx = c[ 0 ] - cam[ 0 ];
+                const float dy = c[ 1 ] - cam[ 1 ];
+                const float dz = c[ 2 ] - cam[ 2 ];
+
+                if( std::sqrt( dx * dx + dy * dy + dz * dz ) - o.boundsRadius >
+                    params.maxDistance )
+                {
+                    return true;
+                }
+            }
+
+            if( params.frustumMargin >= 0 )
+            {
+                for( const auto& pl : planes[ v ] )
+                {
+                    const float d =
+                        pl[ 0 ] * c[ 0 ] + pl[ 1 ] * c[ 1 ] + pl[ 2 ] * c[ 2 ] + pl[ 3 ];
+                    if( d < -( o.boundsRadius + params.frustumMargin ) )
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        };
+
+        const auto isCulled = [ & ]( const Object& o ) {
+            using FT = VertexCollectorFilterTypeFlagBits;
+
+            // first-person geometry is at the camera anyway
+            if( o.isStatic || ( o.instanceFlags & ( uint32_t( FT::PV_FIRST_PERSON ) |
+                                                    uint32_t( FT::PV_FIRST_PERSON_VIEWER ) ) ) )
+            {
+                return false;
+            }
+
+            // uploaded while culling was disabled
+            if( o.boundsRadius < 0 )
+            {
+                return false;
+            }
+
+            for( uint32_t v = 0; v < viewCount; v++ )
+            {
+                if( !isCulledForView( o, v ) )
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        instanceStats.culledCount =
+            static_cast< uint32_t >( erase_if( curFrame_objects, isCulled ) );
+    }
+
+    instanceStats.instanceCount = static_cast< uint32_t >( curFrame_objects.size() );
+}
+
+void RTGL1::ASManager::SelectLods( uint32_t frameIndex, const GlobalUniform& uniform )
+{
+    const ShGlobalUniform* gu = uniform.GetData();
+
+    // size of a unit at a unit distance, in pixels
+    const float pixelsPerUnit = 0.5f * gu->renderHeight * std::abs( gu->projection[ 5 ] );
+
+    for( Object& obj : curFrame_objects )
+    {
+        if( !obj.lodBase )
+        {
+            continue;
+        }
+
+        // errors are in the local units, so take the largest scale of the transform
+        const auto& m       = obj.transform.matrix;
+        float       scaleSq = 0;
+        for( int j = 0; j < 3; j++ )
+        {
+            scaleSq = std::max( scaleSq,
+                                m[ 0 ][ j ] * m[ 0 ][ j ] + m[ 1 ][ j ] * m[ 1 ][ j ] +
+                                    m[ 2 ][ j ] * m[ 2 ][ j ] );
+        }
+
+        const float* c    = obj.boundsCenter.data;
+        const float* cam  = gu->cameraPosition;
+        const float  dx   = c[ 0 ] - cam[ 0 ];
+        const float  dy   = c[ 1 ] - cam[ 1 ];
+        const float  dz   = c[ 2 ] - cam[ 2 ];
+        const float  dist = std::sqrt( dx * dx + dy * dy + dz * dz ) - obj.boundsRadius;
+
+        uint32_t lodIndex = 0;
+        if( dist > 0 )
+        {
+            const float errorToPixels = std::sqrt( scaleSq ) * pixelsPerUnit / dist;
+
+            // the coarsest one that is still precise enough
+            for( auto i = uint32_t( obj.lodBase->lods.size() ); i > 0; i-- )
+            {
+                if( obj.lodBase->lods[ i - 1 ].error * errorToPixels < MESH_LOD_MAX_PIXEL_ERROR )
+                {
+                    lodIndex = i;
+                    break;
+                }
+            }
+        }
+
+        // static geometry info is kept between frames,
+        // dynamic is written each frame with the base geometry
+        const bool patchInfo = obj.isStatic ? obj.lodIndex != lodIndex : lodIndex != 0;
+
+        BuiltAS* target =
+            lodIndex == 0 ? obj.lodBase : obj.lodBase->lods[ lodIndex - 1 ].built.get();
+
+        obj.builtInstance = target;
+        obj.lodIndex      = lodIndex;
+
+        if( patchInfo )
+        {
+            const auto& tri = target->geometry.asGeometryInfo.geometry.triangles;
+
+            auto geometry = ShGeometryInstance{
+                .vertexCount = tri.maxVertex,
+                .indexCount  = target->geometry.firstIndex
+                                   ? target->geometry.asRange.primitiveCount * 3
+                                   : UINT32_MAX,
+            };
+            WriteGeometryLocation( geometry, target->geometry );
+
+            geomInfoMgr->PatchGeometry( frameIndex, obj.uniqueID, geometry );
+        }
+    }
+}
+
+void RTGL1::ASManager::ApplyAreaVisibility( const RgDrawFrameAreaVisibilityParams& params )
+{
+    const bool enable = params.enable && params.areaCount > 0 && params.pVisibleAreas;
+
+    const auto isSet = []( const uint32_t* bits, uint32_t area ) {
+        return bits && ( bits[ area / 32 ] >> ( area % 32 ) ) & 1;
+    };
+
+    uint32_t hiddenCount = 0;
+
+    for( Object& o : curFrame_objects )
+    {
+        using FT = VertexCollectorFilterTypeFlagBits;
+
+        o.areaVisibility = AreaVisibility::Visible;
+
+        if( !enable || o.areaIndex == NO_AREA || o.areaIndex >= params.areaCount )
+        {
+            continue;
+        }
+
+        // first-person is at the camera, sky is seen through the sky portals
+        if( o.instanceFlags & ( uint32_t( FT::PV_FIRST_PERSON ) |
+                                uint32_t( FT::PV_FIRST_PERSON_VIEWER ) |
+                                uint32_t( FT::PV_WORLD_2 ) ) )
+        {
+            continue;
+        }
+
+        if( isSet( params.pVisibleAreas, o.areaIndex ) )
+        {
+            continue;
+        }
+
+        // only WORLD_0 is in the shadow ray mask, see rayCullMaskWorld_Shadow
+        const bool castsShadows = ( o.instanceFlags & uint32_t( FT::PV_WORLD_0 ) ) &&
+                                  !( o.instanceFlags & uint32_t( FT::PT_REFRACT ) );
+
+        if( castsShadows && isSet( params.pShadowAreas, o.areaIndex ) )
+        {
+            o.areaVisibility = AreaVisibility::ShadowOnly;
+        }
+        else
+        {
+            o.areaVisibility = AreaVisibility::Hidden;
+            hiddenCount++;
+        }
+    }
+
+    instanceStats.instanceCount -= std::min( hiddenCount, instanceStats.instanceCount );
+    instanceStats.culledCount += hiddenCount;
+}
+
 auto RTGL1::ASManager::MakeUniqueIDToTlasID( bool disableRTGeometry ) const -> UniqueIDToTlasID
 {
+    RG_CPU_ZONE( "ASManager::MakeUniqueIDToTlasID" );
+
     auto all = UniqueIDToTlasID{};
     if( !disableRTGeometry )
     {
         all.reserve( curFrame_objects.size() );
-        for( uint32_t i = 0; i < curFrame_objects.size(); i++ )
+
+        // must match the order of instances in BuildTLAS
+        uint32_t tlasIndex = 0;
+        for( const auto& obj : curFrame_objects )
         {
-            all[ curFrame_objects[ i ].uniqueID ] = i;
+            if( obj.areaVisibility == AreaVisibility::Hidden )
+            {
+                continue;
+            }
+
+            // geometry info of a cluster member is at gl_InstanceID + gl_GeometryIndexEXT
+            if( !obj.builtInstance->clusterUniqueIDs.empty() )
+            {
+                for( const PrimitiveUniqueID& memberID : obj.builtInstance->clusterUniqueIDs )
+                {
+                    all[ memberID ] = tlasIndex++;
+                }
+                continue;
+            }
+
+            all[ obj.uniqueID ] = tlasIndex++;
         }
     }
     return all;
 }
 
-void RTGL1::ASManager::BuildTLAS( VkCommandBuffer cmd,
-                                  uint32_t        frameIndex,
-                                  uint32_t        uniformData_rayCullMaskWorld,
-                                  bool            disableRTGeometry )
+void RTGL1::ASManager::BuildTLAS( VkCommandBuffer      cmd,
+                                  uint32_t             frameIndex,
+                                  const GlobalUniform& uniform,
+                                  uint32_t             uniformData_rayCullMaskWorld,
+                                  bool                 disableRTGeometry )
 {
+    RG_CPU_ZONE( "ASManager::BuildTLAS" );
+
     auto label = CmdLabel{ cmd, "Building TLAS" };
 
 
-    auto allVkTlas = std::vector< VkAccelerationStructureInstanceKHR >{};
+    // if generated on GPU, only the parameters are written here, and the transforms
+    // are taken from the geometry instances, as their indices are the same
+    ShTlasInstanceSource* gpuSources =
+        tlasInstanceGeneration ? tlasInstanceGeneration->GetSources( frameIndex ) : nullptr;
+
+    if( tlasInstanceGeneration )
+    {
+        // from the last frame with the same index, as the current one is not finished
+        const uint32_t culled = tlasInstanceGeneration->ReadCulledCount( frameIndex );
+
+        instanceStats.instanceCount -= std::min( culled, instanceStats.instanceCount );
+        instanceStats.culledCount += culled;
+    }
+
+    auto     allVkTlas     = std::vector< VkAccelerationStructureInstanceKHR >{};
+    uint32_t instanceCount = 0;
+
+    // negative radius, if can't be culled on GPU
+    const auto addInstance = [ & ]( const VkAccelerationStructureInstanceKHR& inst,
+                                    const RgFloat3D&                          boundsCenter,
+                                    float                                     boundsRadius ) {
+        if( gpuSources )
+        {
+            const uint64_t blas = inst.accelerationStructureReference;
+
+            gpuSources[ instanceCount ] = ShTlasInstanceSource{
+                .boundsCenter       = { RG_ACCESS_VEC3( boundsCenter.data ) },
+                .boundsRadius       = boundsRadius,
+                .blasAddress        = { uint32_t( blas ), uint32_t( blas >> 32 ) },
+                .customIndexAndMask = inst.instanceCustomIndex | ( uint32_t{ inst.mask } << 24 ),
+                .sbtOffsetAndFlags  = inst.instanceShaderBindingTableRecordOffset |
+                                     ( uint32_t{ inst.flags } << 24 ),
+            };
+        }
+        else
+        {
+            allVkTlas.push_back( inst );
+        }
+        instanceCount++;
+    };
+
+    // identity of the instance set, to check if the TLAS can be refitted
+    uint64_t instancesHash = 0;
     if( !disableRTGeometry )
     {
-        allVkTlas.reserve( curFrame_objects.size() );
+        if( !gpuSources )
+        {
+            allVkTlas.reserve( curFrame_objects.size() + staticClusterExtraInstances );
+        }
+
         for( const auto& obj : curFrame_objects )
         {
-            auto vkTlas = MakeVkTLAS( *obj.builtInstance,
-                                      uniformData_rayCullMaskWorld,
-                                      obj.transform,
-                                      obj.instanceFlags );
+            if( obj.areaVisibility == AreaVisibility::Hidden )
+            {
+                continue;
+            }
+
+            auto vkTlas = gpuSources ? MakeVkTLASParams( *obj.builtInstance,
+                                                         uniformData_rayCullMaskWorld,
+                                                         obj.instanceFlags )
+                                     : MakeVkTLAS( *obj.builtInstance,
+                                                   uniformData_rayCullMaskWorld,
+                                                   obj.transform,
+                                                   obj.instanceFlags );
 
             if( !vkTlas )
             {
@@ -1186,16 +3783,77 @@ void RTGL1::ASManager::BuildTLAS( VkCommandBuffer cmd,
                               obj.uniqueID.objectId,
                               obj.uniqueID.primitiveIndex );
                 allVkTlas.clear();
+                instanceCount = 0;
                 break;
             }
 
-            allVkTlas.push_back( *vkTlas );
+            if( obj.areaVisibility == AreaVisibility::ShadowOnly )
+            {
+                vkTlas->mask = INSTANCE_MASK_AREA_SHADOW_ONLY;
+            }
+
+            if( !obj.isStatic )
+            {
+                vkTlas->instanceCustomIndex |= INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC;
+
+                // separate bit, so the shadows of movable geometry can be traced
+                // without the static one, e.g. for the cached sun visibility
+                if( vkTlas->mask == INSTANCE_MASK_WORLD_0 )
+                {
+                    vkTlas->mask = INSTANCE_MASK_WORLD_0_DYNAMIC;
+                }
+            }
+
+            {
+                using FT = VertexCollectorFilterTypeFlagBits;
+
+                // same as in CullDynamicInstances
+                constexpr uint32_t firstPerson =
+                    uint32_t( FT::PV_FIRST_PERSON ) | uint32_t( FT::PV_FIRST_PERSON_VIEWER );
+
+                const bool cullable = !obj.isStatic && !( obj.instanceFlags & firstPerson );
+
+                addInstance( *vkTlas, obj.boundsCenter, cullable ? obj.boundsRadius : -1.0f );
+            }
+
+            // inactive instances, only to reserve the geometry info indices of cluster members
+            for( size_t i = 1; i < obj.builtInstance->clusterUniqueIDs.size(); i++ )
+            {
+                addInstance(
+                    VkAccelerationStructureInstanceKHR{
+                        .accelerationStructureReference = 0,
+                    },
+                    RgFloat3D{},
+                    -1.0f );
+            }
+
+            // transform and mask may change, but not the instances themselves;
+            // dynamic BLAS-es are rebuilt each frame, so only static ones are compared
+            const uint64_t values[] = {
+                obj.uniqueID.objectId,
+                obj.uniqueID.primitiveIndex,
+                vkTlas->instanceShaderBindingTableRecordOffset,
+                vkTlas->flags,
+                obj.isStatic ? vkTlas->accelerationStructureReference : 0,
+            };
+            const uint64_t h =
+                ankerl::unordered_dense::detail::wyhash::hash( values, sizeof( values ) );
+            instancesHash ^= h + 0x9e3779b9 + ( instancesHash << 6 ) + ( instancesHash >> 2 );
         }
     }
-    assert( MakeUniqueIDToTlasID( disableRTGeometry ).size() == allVkTlas.size() );
+    assert( MakeUniqueIDToTlasID( disableRTGeometry ).size() == instanceCount );
 
 
-    if( !allVkTlas.empty() )
+    if( gpuSources )
+    {
+        tlasInstanceGeneration->Dispatch( cmd,
+                                          frameIndex,
+                                          uniform,
+                                          buffersDescSets[ frameIndex ],
+                                          instanceCount,
+                                          gpuCulling );
+    }
+    else if( !allVkTlas.empty() )
     {
         // fill buffer
         auto mapped =
@@ -1225,25 +3883,52 @@ void RTGL1::ASManager::BuildTLAS( VkCommandBuffer cmd,
     };
 
     auto range = VkAccelerationStructureBuildRangeInfoKHR{
-        .primitiveCount = static_cast< uint32_t >( allVkTlas.size() ),
+        .primitiveCount = instanceCount,
     };
 
     constexpr bool fastTrace = true;
 
+    const bool updateable = LibConfig().tlasRefit;
+
     bool tlasWasRecreated = false;
 
     TLASComponent* curTlas = tlas[ frameIndex ].get();
     {
         // get AS size and create buffer for AS
-        const auto buildSizes = ASBuilder::GetTopBuildSizes(
-            device, instGeom, static_cast< uint32_t >( allVkTlas.size() ), fastTrace );
+        const auto buildSizes =
+            ASBuilder::GetTopBuildSizes( device, instGeom, instanceCount, fastTrace, updateable );
 
         // if previous buffer's size is not enough
         tlasWasRecreated = curTlas->RecreateIfNotValid( buildSizes, *( allocTlas[ frameIndex ] ), true );
 
+        // the TLAS of this frame index was used by N-2, so it can be refitted in place,
+        // if it has the same instances; the quality degrades, so it's bounded
+        TLASHistory& history = tlasHistory[ frameIndex ];
+
+        // instances that are culled on GPU become inactive, which is not allowed on refit
+        const bool gpuCulled = gpuSources && gpuCulling.enable;
+
+        const bool refit = updateable && !tlasWasRecreated && !gpuCulled && instanceCount > 0 &&
+                           history.instanceCount == instanceCount &&
+                           history.instancesHash == instancesHash &&
+                           history.refitCount < TLAS_MAX_REFIT_COUNT;
+        if( refit )
+        {
+            history.refitCount++;
+        }
+        else
+        {
+            history = TLASHistory{
+                .instancesHash = instancesHash,
+                .instanceCount = instanceCount,
+                .refitCount    = 0,
+            };
+        }
+
         // ASBuilder requires 'instGeom', 'range' to be alive
         assert( asBuilder->IsEmpty() );
-        asBuilder->AddTLAS( curTlas->GetAS(), &instGeom, &range, buildSizes, fastTrace, false );
+        asBuilder->AddTLAS(
+            curTlas->GetAS(), &instGeom, &range, buildSizes, fastTrace, refit, updateable );
         asBuilder->BuildTopLevel( cmd );
     }
 
@@ -1258,40 +3943,37 @@ void RTGL1::ASManager::BuildTLAS( VkCommandBuffer cmd,
     }
 }
 
-void RTGL1::ASManager::CopyDynamicDataToPrevBuffers( VkCommandBuffer cmd, uint32_t frameIndex )
+auto RTGL1::ASManager::GetAllocatorStats() const -> ChunkedStackAllocator::Stats
 {
-    uint32_t vertCount  = collectorDynamic[ frameIndex ]->GetCurrentVertexCount();
-    uint32_t indexCount = collectorDynamic[ frameIndex ]->GetCurrentIndexCount();
-
-    if( vertCount > 0 )
-    {
-        VkBufferCopy vertRegion = {
-            .srcOffset = 0,
-            .dstOffset = 0,
-            .size      = vertCount * sizeof( ShVertex ),
-        };
+    auto total = ChunkedStackAllocator::Stats{};
 
-        vkCmdCopyBuffer( cmd,
-                         collectorDynamic[ frameIndex ]->GetVertexBuffer(),
-                         previousDynamicPositions.GetBuffer(),
-                         1,
-                         &vertRegion );
-    }
+    // stack or pool allocator
+    auto add = [ &total ]( const auto* a ) {
+        if( a )
+        {
+            const auto s = a->GetStats();
+            total.allocatedSize += s.allocatedSize;
+            total.peakUsedSize += s.peakUsedSize;
+            total.wastedSize += s.wastedSize;
+            total.chunkCount += s.chunkCount;
+        }
+    };
 
-    if( indexCount > 0 )
+    add( scratchBuffer.get() );
+    add( allocStaticGeom.get() );
+    add( allocReplacementsGeom.get() );
+    add( allocStaticGeomCompacted.get() );
+    add( allocReplacementsGeomCompacted.get() );
+    add( allocStaticOmm.get() );
+    add( allocReplacementsOmm.get() );
+    add( allocPersistentDynamicGeom.get() );
+    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
     {
-        VkBufferCopy indexRegion = {
-            .srcOffset = 0,
-            .dstOffset = 0,
-            .size      = indexCount * sizeof( uint32_t ),
-        };
-
-        vkCmdCopyBuffer( cmd,
-                         collectorDynamic[ frameIndex ]->GetIndexBuffer(),
-                         previousDynamicIndices.GetBuffer(),
-                         1,
-                         &indexRegion );
+        add( asyncScratchBuffer[ i ].get() );
+        add( allocDynamicGeom[ i ].get() );
+        add( allocTlas[ i ].get() );
     }
+    return total;
 }
 
 void RTGL1::ASManager::OnVertexPreprocessingBegin( VkCommandBuffer cmd,
@@ -1334,6 +4016,27 @@ VkDescriptorSet RTGL1::ASManager::GetTLASDescSet( uint32_t frameIndex ) const
     return asDescSets[ frameIndex ];
 }
 
+const std::shared_ptr< RTGL1::Skinning >& RTGL1::ASManager::GetSkinning() const
+{
+    return skinning;
+}
+
+const std::shared_ptr< RTGL1::ParticleExpansion >& RTGL1::ASManager::GetParticleExpansion() const
+{
+    return particleExpansion;
+}
+
+auto RTGL1::ASManager::GetTLASInstanceGeneration() const
+    -> const std::shared_ptr< TLASInstanceGeneration >&
+{
+    return tlasInstanceGeneration;
+}
+
+uint32_t RTGL1::ASManager::GetEmissiveTriangleCount() const
+{
+    return emissiveTriangles->GetCount();
+}
+
 VkDescriptorSetLayout RTGL1::ASManager::GetBuffersDescSetLayout() const
 {
     return buffersDescSetLayout;
@@ -21,9 +21,16 @@
 #pragma once
 
 #include "ASBuilder.h"
+#include "BLASDiskCache.h"
 #include "CommandBufferManager.h"
+#include "EmissiveTriangles.h"
+#include "FrameArena.h"
 #include "GlobalUniform.h"
+#include "OpacityMicromap.h"
+#include "ParticleExpansion.h"
 #include "ScratchBuffer.h"
+#include "Skinning.h"
+#include "TLASInstanceGeneration.h"
 #include "TextureManager.h"
 #include "VertexCollector.h"
 #include "ASComponent.h"
@@ -33,6 +40,19 @@
 namespace RTGL1
 {
 
+// Build flags of a BLAS, chosen by the lifetime and rebuild frequency of its primitive
+enum class BLASBuildPolicy : uint8_t
+{
+    // traced for many frames
+    FastTrace,
+    // same, and compacted after the build; only for the static geometry
+    FastTraceCompacted,
+    // rebuilt often, so the build time matters more than the traversal
+    FastBuild,
+    // rebuilt each frame and large: less memory for the BLAS and its scratch
+    FastBuildLowMemory,
+};
+
 class ASManager
 {
 public:
@@ -41,11 +61,15 @@ public:
                std::shared_ptr< MemoryAllocator >      allocator,
                std::shared_ptr< CommandBufferManager > cmdManager,
                std::shared_ptr< GeomInfoManager >      geomInfoManager,
+               const GlobalUniform&                    uniform,
+               const ShaderManager&                    shaderManager,
                uint64_t                                maxReplacementsVerts,
                uint64_t                                maxDynamicVerts,
+               uint32_t                                maxInstanceCount,
                bool                                    enableTexCoordLayer1,
                bool                                    enableTexCoordLayer2,
-               bool                                    enableTexCoordLayer3 );
+               bool                                    enableTexCoordLayer3,
+               bool                                    quantizeStaticVertices );
     ~ASManager();
 
     ASManager( const ASManager& other )                = delete;
@@ -56,102 +80,323 @@ public:
 
     [[nodiscard]] StaticGeometryToken BeginStaticGeometry( bool freeReplacements );
     void                              MarkReplacementsRegionEnd( const StaticGeometryToken& token );
-    // Submitting static geometry to the building is a heavy operation
-    // with waiting for it to complete.
-    void SubmitStaticGeometry( StaticGeometryToken& token, bool buildReplacements );
+    // Submitting static geometry to the building is a heavy operation.
+    // The build is not waited on CPU, unless BLAS compaction is enabled:
+    // it's ordered on GPU with the frames in flight and the current frame.
+    // If 'cacheFile' is provided, BLAS-es are deserialized from it instead of being built;
+    // if it's outdated, the built BLAS-es are saved to it, which is waited on CPU.
+    void SubmitStaticGeometry( StaticGeometryToken& token,
+                               bool                 buildReplacements,
+                               const BLASCacheFile* cacheFile = nullptr );
 
 
     [[nodiscard]] DynamicGeometryToken BeginDynamicGeometry( VkCommandBuffer cmd,
                                                              uint32_t        frameIndex );
     void                               SubmitDynamicGeometry( DynamicGeometryToken& token,
                                                               VkCommandBuffer       cmd,
-                                                              uint32_t              frameIndex );
+                                                              uint32_t              frameIndex,
+                                                              const GlobalUniform&  uniform );
 
 
-    bool AddMeshPrimitive( uint32_t                   frameIndex,
-                           const RgMeshInfo&          mesh,
-                           const RgMeshPrimitiveInfo& primitive,
-                           const PrimitiveUniqueID&   uniqueID,
-                           const bool                 isStatic,
-                           const bool                 isReplacement,
-                           const TextureManager&      textureManager,
-                           GeomInfoManager&           geomInfoManager );
+    // Vertices to be filled in place, for a dynamic primitive of the current frame
+    RgPrimitiveVertex* ReserveDynamicVertices( uint32_t frameIndex, uint32_t vertexCount );
 
-    void Hack_PatchTexturesForStaticPrimitive( const PrimitiveUniqueID& uniqueID,
-                                               const char*              pTextureName,
-                                               const TextureManager&    textureManager );
-    void Hack_PatchGeomInfoTransformForStatic( const PrimitiveUniqueID& geomUniqueID,
-                                               const RgTransform&       transform );
 
-    void CacheReplacement( std::string_view           meshName,
-                           const RgMeshPrimitiveInfo& primitive,
-                           uint32_t                   index );
+    // Simplified version of a primitive, only the vertices and indices are different
+    struct PrimitiveLod
+    {
+        RgMeshPrimitiveInfo primitive;
+        // max deviation from the original surface, in the local units of the primitive
+        float               error;
+    };
 
+    // 'lods' are used only for static geometry, replacements get them in CacheReplacement.
+    // If 'allowBatching', the primitive can be merged with others: a dynamic one into
+    // a world-space batch, a static one into a BLAS cluster
+    bool AddMeshPrimitive( uint32_t                        frameIndex,
+                           const RgMeshInfo&               mesh,
+                           const RgMeshPrimitiveInfo&      primitive,
+                           const PrimitiveUniqueID&        uniqueID,
+                           const bool                      isStatic,
+                           const bool                      isReplacement,
+                           const TextureManager&           textureManager,
+                           GeomInfoManager&                geomInfoManager,
+                           bool                            allowBatching = true,
+                           std::span< const PrimitiveLod > lods = {} );
+    // Merged small dynamic primitives must be added before the dynamic geometry submission
+    void FlushDynamicBatches( uint32_t              frameIndex,
+                              const TextureManager& textureManager,
+                              GeomInfoManager&      geomInfoManager );
 
+    void Hack_PatchTexturesForStaticPrimitive( const PrimitiveUniqueID& uniqueID,
+                                               const char*              pTextureName,
+                                               const TextureManager&    textureManager );
+    // Patch transforms of many static primitives at once
+    void Hack_PatchGeomInfoTransformsForStatic(
+        std::span< const std::pair< PrimitiveUniqueID, RgTransform > > transforms );
+
+    void CacheReplacement( std::string_view                meshName,
+                           const RgMeshPrimitiveInfo&      primitive,
+                           uint32_t                        index,
+                           const TextureManager&           textureManager,
+                           std::span< const PrimitiveLod > lods = {} );
+
+
+    // Remove dynamic instances that are too far or outside of the expanded camera frustum,
+    // must be called before MakeUniqueIDToTlasID. If TLAS instances are generated on GPU,
+    // the instances are only made inactive there, in BuildTLAS
+    void CullDynamicInstances( const GlobalUniform&                    uniform,
+                               const RgDrawFrameInstanceCullingParams& params );
+    // Choose a BLAS for each instance that has LODs by its error projected on the screen,
+    // must be called before GeomInfoManager::CopyFromStaging
+    void SelectLods( uint32_t frameIndex, const GlobalUniform& uniform );
+    // Exclude instances of invisible areas from the TLAS, or leave them only for shadow rays,
+    // must be called after CullDynamicInstances and before MakeUniqueIDToTlasID
+    void ApplyAreaVisibility( const RgDrawFrameAreaVisibilityParams& params );
     auto MakeUniqueIDToTlasID( bool disableRTGeometry ) const -> UniqueIDToTlasID;
-    void BuildTLAS( VkCommandBuffer cmd,
-                    uint32_t        frameIndex,
-                    uint32_t        uniformData_rayCullMaskWorld,
-                    bool            disableRTGeometry );
-
-
-    // Copy current dynamic vertex and index data to
-    // special buffers for using current frame's data in the next frame.
-    void CopyDynamicDataToPrevBuffers( VkCommandBuffer cmd, uint32_t frameIndex );
+    void BuildTLAS( VkCommandBuffer      cmd,
+                    uint32_t             frameIndex,
+                    const GlobalUniform& uniform,
+                    uint32_t             uniformData_rayCullMaskWorld,
+                    bool                 disableRTGeometry );
 
 
     void OnVertexPreprocessingBegin( VkCommandBuffer cmd, uint32_t frameIndex, bool onlyDynamic );
     void OnVertexPreprocessingFinish( VkCommandBuffer cmd, uint32_t frameIndex, bool onlyDynamic );
 
 
+    struct InstanceStats
+    {
+        uint32_t instanceCount;
+        uint32_t culledCount;
+    };
+    InstanceStats GetInstanceStats() const { return instanceStats; }
+    // Summed over the memory pools of acceleration structures and scratch buffers
+    auto          GetAllocatorStats() const -> ChunkedStackAllocator::Stats;
+
+
     VkDescriptorSet GetBuffersDescSet( uint32_t frameIndex ) const;
     VkDescriptorSet GetTLASDescSet( uint32_t frameIndex ) const;
 
     VkDescriptorSetLayout GetBuffersDescSetLayout() const;
     VkDescriptorSetLayout GetTLASDescSetLayout() const;
 
+    const std::shared_ptr< Skinning >&          GetSkinning() const;
+    const std::shared_ptr< ParticleExpansion >& GetParticleExpansion() const;
+    // null, if TLAS instances are made on CPU
+    auto GetTLASInstanceGeneration() const -> const std::shared_ptr< TLASInstanceGeneration >&;
+
+    uint32_t GetEmissiveTriangleCount() const;
+
 private:
     void CreateDescriptors();
-    void UpdateBufferDescriptors( uint32_t frameIndex );
+    void FinishStaticBuild();
+    // 'prevCollector' has the data of the previous frame, its buffers are bound as such
+    void UpdateBufferDescriptors( uint32_t frameIndex, const VertexCollector& prevCollector );
     void UpdateASDescriptors( uint32_t frameIndex );
 
+    // Dynamic vertex buffers start small and are resized on demand in the beginning of a frame
+    void CreateDynamicBuffers( uint32_t vertexCapacity );
+    auto ChooseDynamicVertexCapacity( const VertexCollector& lastFrame )
+        -> std::optional< uint32_t >;
+    void ResizeDynamicBuffers( uint32_t frameIndex, uint32_t vertexCapacity );
+
     struct BuiltAS
     {
         VertexCollectorFilterTypeFlags flags;
         BLASComponent                  blas;
         VertexCollector::UploadResult  geometry;
+        // referenced by BLAS, so must be alive while it is
+        std::shared_ptr< OpacityMicromap > omm{};
+        BLASBuildPolicy                    policy{ BLASBuildPolicy::FastTrace };
+
+        struct Lod
+        {
+            std::unique_ptr< BuiltAS > built;
+            float                      error;
+        };
+        // coarser versions of this geometry, from finer to coarser
+        std::vector< Lod >     lods{};
+        // mesh-space AABB, to select a LOD by the distance
+        std::array< float, 3 > lodBoundsMin{};
+        std::array< float, 3 > lodBoundsMax{};
+
+        // if not empty, this is a cluster: 'blas' has a geometry for each member,
+        // in the order of gl_GeometryIndexEXT; members' own 'blas' is not built
+        std::vector< std::unique_ptr< BuiltAS > >               clusterMembers{};
+        std::vector< PrimitiveUniqueID >                        clusterUniqueIDs{};
+        std::vector< VkAccelerationStructureGeometryKHR >       clusterGeometries{};
+        std::vector< VkAccelerationStructureBuildRangeInfoKHR > clusterRanges{};
     };
 
-    auto UploadAndBuildAS( const RgMeshPrimitiveInfo&     primitive,
-                           VertexCollectorFilterTypeFlags geomFlags,
-                           VertexCollector&               vertexAlloc,
-                           ChunkedStackAllocator&         accelStructAlloc,
-                           const bool                     isDynamic ) -> std::unique_ptr< BuiltAS >;
+    struct CompactionTarget
+    {
+        BLASComponent*         blas;
+        ChunkedStackAllocator* dstAlloc;
+    };
+
+    auto WriteCompactedSizes( VkCommandBuffer                     cmd,
+                              std::span< const CompactionTarget > targets ) const -> VkQueryPool;
+    void CompactStaticGeometry( VkQueryPool                         compactedSizes,
+                                std::span< const CompactionTarget > targets,
+                                bool                                withReplacements );
+
+    // Static primitives with the same instance parameters are grouped spatially,
+    // and each group is built as one multi-geometry BLAS
+    void BuildStaticClusters();
+
+    // Empty, if static BLAS-es can't be cached
+    auto MakeDiskCacheTargets( bool withReplacements ) const
+        -> std::vector< BLASDiskCache::Target >;
+
+    // Dynamic BLAS-es are built on the async compute queue, if it's enabled
+    auto DynamicBuilder( uint32_t frameIndex ) -> ASBuilder&;
+    void SubmitDynamicGeometryAsync( uint32_t frameIndex, const GlobalUniform& uniform );
+
+    auto UploadAndBuildAS( ASBuilder&                         builder,
+                           const RgMeshPrimitiveInfo&         primitive,
+                           VertexCollectorFilterTypeFlags     geomFlags,
+                           VertexCollector&                   vertexAlloc,
+                           ChunkedStackAllocator&             accelStructAlloc,
+                           BLASBuildPolicy                    policy,
+                           std::shared_ptr< OpacityMicromap > omm              = {},
+                           const bool                         verticesOnDevice = false )
+        -> std::unique_ptr< BuiltAS >;
+    // LODs share the flags of the base geometry, but not its micromap
+    void UploadAndBuildLods( BuiltAS&                        base,
+                             const RgMeshPrimitiveInfo&      basePrimitive,
+                             std::span< const PrimitiveLod > lods,
+                             ASBuilder&                      builder,
+                             VertexCollector&                vertexAlloc,
+                             ChunkedStackAllocator&          accelStructAlloc );
+    // 'Allocator' is ChunkedStackAllocator or ChunkedPoolAllocator
+    template< typename Allocator >
+    auto BuildAS( ASBuilder&                           builder,
+                  const VertexCollector::UploadResult& uploadedData,
+                  VertexCollectorFilterTypeFlags       geomFlags,
+                  Allocator&                           accelStructAlloc,
+                  BLASBuildPolicy                      policy,
+                  const bool                           isUpdateable = false,
+                  std::shared_ptr< OpacityMicromap >   omm          = {} )
+        -> std::unique_ptr< BuiltAS >;
+    // Same as UploadAndBuildAS, but the record is in the frame's arena
+    auto UploadAndBuildDynamicAS( uint32_t                       frameIndex,
+                                  const RgMeshPrimitiveInfo&     primitive,
+                                  VertexCollectorFilterTypeFlags geomFlags,
+                                  bool                           verticesOnDevice ) -> BuiltAS*;
+    // 'target' must have its geometry, micromap and policy set
+    template< typename Allocator >
+    void AddBLASBuild( ASBuilder& builder,
+                       BuiltAS&   target,
+                       Allocator& accelStructAlloc,
+                       bool       isUpdateable );
+    // Static primitive that is rebuilt often (e.g. reimported during gameplay)
+    // is built for a fast build; also records this build
+    auto ChooseStaticBuildPolicy( const PrimitiveUniqueID& uniqueID ) -> BLASBuildPolicy;
+
+    // Null, if micromaps are not supported or alpha test can't be resolved in advance
+    auto MakeOpacityMicromap( const RgMeshPrimitiveInfo&     primitive,
+                              VertexCollectorFilterTypeFlags geomFlags,
+                              const TextureManager&          textureManager,
+                              ChunkedStackAllocator&         ommAlloc )
+        -> std::shared_ptr< OpacityMicromap >;
+
+    // Vertex data is uploaded each frame, but BLAS is reused if the content is the same
+    auto UploadAndBuildCachedDynamicAS( uint32_t                       frameIndex,
+                                        const PrimitiveUniqueID&       uniqueID,
+                                        const RgMeshPrimitiveInfo&     primitive,
+                                        VertexCollectorFilterTypeFlags geomFlags ) -> BuiltAS*;
+    // For RG_MESH_PRIMITIVE_TOPOLOGY_STABLE: BLAS is refitted, if topology is the same.
+    // Returns null, if a regular build should be used instead
+    auto UploadAndRefitDynamicAS( uint32_t                       frameIndex,
+                                  const PrimitiveUniqueID&       uniqueID,
+                                  const RgMeshPrimitiveInfo&     primitive,
+                                  VertexCollectorFilterTypeFlags geomFlags,
+                                  bool                           verticesOnDevice ) -> BuiltAS*;
+
+    // Dynamic primitive, which content didn't change for several frames, is uploaded once
+    // into the persistent beginning of dynamic vertex buffers, and its BLAS is kept.
+    // Returns null, if the primitive is not promoted (yet)
+    auto FindPromotedDynamicAS( uint32_t                       frameIndex,
+                                const PrimitiveUniqueID&       uniqueID,
+                                const RgMeshPrimitiveInfo&     primitive,
+                                VertexCollectorFilterTypeFlags geomFlags ) -> BuiltAS*;
+    void UploadPendingPromotions( uint32_t frameIndex );
+    void ResetPromotedDynamic( uint32_t frameIndex );
+
+    struct DynamicBatch;
+    // Small dynamic primitives with the same material are merged in world space
+    // into one primitive, so each doesn't need its own BLAS and TLAS instance.
+    // Returns false, if the primitive can't be batched
+    bool TryAddToDynamicBatch( uint32_t                       frameIndex,
+                               const RgMeshInfo&              mesh,
+                               const RgMeshPrimitiveInfo&     primitive,
+                               VertexCollectorFilterTypeFlags geomFlags,
+                               const TextureManager&          textureManager,
+                               GeomInfoManager&               geomInfoManager );
+    bool AddDynamicBatch( uint32_t              frameIndex,
+                          uint64_t              key,
+                          DynamicBatch&         batch,
+                          const TextureManager& textureManager,
+                          GeomInfoManager&      geomInfoManager );
 
     static auto MakeVkTLAS( const BuiltAS&                 builtAS,
                             uint32_t                       rayCullMaskWorld,
                             const RgTransform&             instanceTransform,
                             VertexCollectorFilterTypeFlags instanceFlags )
         -> std::optional< VkAccelerationStructureInstanceKHR >;
+    // Everything, except the transform
+    static auto MakeVkTLASParams( const BuiltAS&                 builtAS,
+                                  uint32_t                       rayCullMaskWorld,
+                                  VertexCollectorFilterTypeFlags instanceFlags )
+        -> std::optional< VkAccelerationStructureInstanceKHR >;
 
 private:
     VkDevice                           device;
     std::shared_ptr< MemoryAllocator > allocator;
 
     VkFence staticCopyFence;
+    bool    staticBuildInFlight{ false };
+    // current frame must wait for the static build on GPU
+    bool    staticBuildBarrierPending{ false };
 
     // for filling buffers
     std::unique_ptr< VertexCollector > collectorStatic;
     std::unique_ptr< VertexCollector > collectorDynamic[ MAX_FRAMES_IN_FLIGHT ];
-    // device-local buffer for storing previous info
-    Buffer                             previousDynamicPositions;
-    Buffer                             previousDynamicIndices;
+    // if 'directDynamicWrites', rotated with the collector of the current frame
+    std::unique_ptr< VertexCollector > collectorDynamicSpare;
     VertexCollector::CopyRanges        collectorStatic_replacements{};
 
+    // current capacity of dynamic vertex buffers, up to dynamicMaxVertexCount
+    uint32_t dynamicVertexCapacity{ 0 };
+    uint32_t dynamicMaxVertexCapacity{ 0 };
+    // capacity of the TLAS instance buffer
+    uint32_t maxInstanceCount{ 0 };
+    bool     dynamicTexCoordLayers[ 3 ]{};
+    // frames in a row that used only a small part of dynamic vertex buffers
+    uint32_t dynamicLowUsageFrames{ 0 };
+    struct RetiredDynamicBuffers
+    {
+        std::unique_ptr< VertexCollector > collectors[ MAX_FRAMES_IN_FLIGHT ];
+        std::unique_ptr< VertexCollector > collectorSpare;
+    };
+    // old buffers after a resize, might be still in use by the frames in flight
+    std::vector< RetiredDynamicBuffers > retiredDynamicBuffers[ MAX_FRAMES_IN_FLIGHT ];
+    // descriptor set of a frame in flight can't be updated right after a resize
+    bool                                 bufferDescriptorsOutdated[ MAX_FRAMES_IN_FLIGHT ]{};
+
     // building
     std::shared_ptr< ChunkedStackAllocator > scratchBuffer;
     std::unique_ptr< ASBuilder >             asBuilder;
 
+    // dynamic BLAS-es are built on the second graphics-family queue, overlapping
+    // with the rasterization of the current frame; vertex buffers are not shared between
+    // frames in that case, as the queues are not ordered with each other
+    bool                                     asyncBuild{ false };
+    std::shared_ptr< ChunkedStackAllocator > asyncScratchBuffer[ MAX_FRAMES_IN_FLIGHT ];
+    std::unique_ptr< ASBuilder >             asyncBuilder[ MAX_FRAMES_IN_FLIGHT ];
+    VkSemaphore                              asyncBuildFinished[ MAX_FRAMES_IN_FLIGHT ]{};
+
     std::shared_ptr< CommandBufferManager > cmdManager;
     std::shared_ptr< TextureManager >       textureMgr;
     std::shared_ptr< GeomInfoManager >      geomInfoMgr;
@@ -160,12 +405,144 @@ private:
     std::unique_ptr< ChunkedStackAllocator > allocReplacementsGeom;
     std::unique_ptr< ChunkedStackAllocator > allocStaticGeom;
     std::unique_ptr< ChunkedStackAllocator > allocDynamicGeom[ MAX_FRAMES_IN_FLIGHT ];
+    // tightly sized storage for compacted static / replacement BLAS
+    std::unique_ptr< ChunkedStackAllocator > allocReplacementsGeomCompacted;
+    std::unique_ptr< ChunkedStackAllocator > allocStaticGeomCompacted;
+    // BLAS-es of cached, refitted and promoted dynamic primitives, each is freed individually;
+    // declared before them, so it's destroyed after
+    std::unique_ptr< ChunkedPoolAllocator >  allocPersistentDynamicGeom;
+
+    // opacity micromaps for alpha-tested static / replacement geometry
+    std::unique_ptr< OpacityMicromapBuilder > ommBuilder;
+    std::unique_ptr< ChunkedStackAllocator >  allocReplacementsOmm;
+    std::unique_ptr< ChunkedStackAllocator >  allocStaticOmm;
+
+    // serialized static / replacement BLAS-es
+    std::unique_ptr< BLASDiskCache > diskCache;
 
     rgl::string_map< std::vector< std::unique_ptr< BuiltAS > > > builtReplacements;
     std::vector< std::unique_ptr< BuiltAS > >                    builtStaticInstances;
-    std::vector< std::unique_ptr< BuiltAS > > builtDynamicInstances[ MAX_FRAMES_IN_FLIGHT ];
+    // previous static AS-es, alive until the new static build is finished
+    std::vector< std::unique_ptr< BuiltAS > >                    retiredStatic;
+    // reset when the frame index comes back, so no per-primitive heap allocations
+    FrameArena< BuiltAS > builtDynamicInstances[ MAX_FRAMES_IN_FLIGHT ];
+
+    // static primitives are merged into multi-geometry BLAS-es, see BuildStaticClusters
+    bool staticClustering{ false };
+    // static primitives, which vertex data is uploaded, but BLAS is built in a cluster
+    struct StaticClusterCandidate
+    {
+        std::unique_ptr< BuiltAS > built;
+        PrimitiveUniqueID          uniqueID;
+        RgTransform                transform;
+        uint32_t                   areaIndex;
+        std::array< float, 3 >     boundsMin;
+        std::array< float, 3 >     boundsMax;
+    };
+    std::vector< StaticClusterCandidate > staticClusterCandidates;
+    // a cluster has a TLAS instance for each member, only the first one is active
+    uint32_t                              staticClusterExtraInstances{ 0 };
+
+    // dynamic BLAS-es that persist while their primitive's content doesn't change
+    struct CachedDynamicAS
+    {
+        std::unique_ptr< BuiltAS > built;
+        uint64_t                   contentHash;
+        uint64_t                   lastUsedFrame;
+        // since when the content is the same
+        uint64_t                   firstUsedFrame{ 0 };
+    };
+    rgl::unordered_map< PrimitiveUniqueID, CachedDynamicAS > cachedDynamic;
+    // can't be destroyed immediately, as might be in use by frames in flight
+    std::vector< CachedDynamicAS > cachedDynamicRetired[ MAX_FRAMES_IN_FLIGHT ];
+    uint64_t                       cachedDynamicFrame{ 0 };
+    // long-lived cached BLAS-es that were rebuilt for a fast trace in this frame
+    uint32_t                       cachedDynamicUpgrades{ 0 };
+
+    // static primitives: when their BLAS was built last time,
+    // and how many times it was rebuilt in quick succession
+    struct StaticBuildHistory
+    {
+        uint64_t lastBuildFrame;
+        uint32_t quickRebuilds;
+    };
+    rgl::unordered_map< PrimitiveUniqueID, StaticBuildHistory > staticBuildHistory;
+
+    // dynamic BLAS-es of topology-stable primitives; one per frame in flight,
+    // so the refit of the current one is done from the previous frame's BLAS
+    struct RefitDynamicAS
+    {
+        std::unique_ptr< BuiltAS > built[ MAX_FRAMES_IN_FLIGHT ];
+        uint32_t                   lastBuiltIndex;
+        uint32_t                   vertexCount;
+        uint32_t                   indexCount;
+        uint64_t                   indicesHash;
+        uint64_t                   lastUsedFrame;
+    };
+    rgl::unordered_map< PrimitiveUniqueID, RefitDynamicAS > refitDynamic;
+    std::vector< RefitDynamicAS > refitDynamicRetired[ MAX_FRAMES_IN_FLIGHT ];
+
+    // quasi-static: promoted dynamic primitives, their vertex data is preserved
+    // in the beginning of the dynamic vertex buffers of each frame, at the same offsets
+    bool promoteDynamic{ false };
+    // dynamic vertices are written by CPU right into the device-local memory (Resizable BAR)
+    bool directDynamicWrites{ false };
+    struct PromotionCandidate
+    {
+        uint64_t                       contentHash;
+        VertexCollectorFilterTypeFlags flags;
+        uint32_t                       stableFrames;
+        uint64_t                       lastUsedFrame;
+    };
+    struct PendingPromotion
+    {
+        PrimitiveUniqueID                uniqueID;
+        std::vector< RgPrimitiveVertex > vertices;
+        std::vector< uint32_t >          indices;
+        VertexCollectorFilterTypeFlags   flags;
+        uint64_t                         contentHash;
+    };
+    rgl::unordered_map< PrimitiveUniqueID, PromotionCandidate > promotionCandidates;
+    std::vector< PendingPromotion >                             pendingPromotions;
+    // demoted ones are retired to cachedDynamicRetired
+    rgl::unordered_map< PrimitiveUniqueID, CachedDynamicAS >    promotedDynamic;
+    VertexCollector::CopyRanges                                 promotedRanges{};
+    // only the data after it is copied from staging
+    VertexCollector::CopyRanges                                 promotedCopyStart{};
+    uint32_t                                                    promotedVertexBudget{ 0 };
+    // vertex data of demoted can't be freed individually
+    uint32_t                                                    promotedLeakedVertices{ 0 };
+
+    // in the order of upload, to replay them into the collectors of the other frames
+    std::vector< PendingPromotion > promotedUploads;
+    // how many of 'promotedUploads' are in the device-local buffers of a frame's collector
+    uint32_t                        promotedUploadedCount[ MAX_FRAMES_IN_FLIGHT ]{};
+    VertexCollector::CopyRanges     promotedUploadedRanges[ MAX_FRAMES_IN_FLIGHT ]{};
+
+    // world-space vertices of small dynamic primitives, by a material key
+    struct DynamicBatch
+    {
+        RgMeshInfoFlags                  meshFlags{};
+        // material parameters of the first primitive
+        RgMeshPrimitiveInfo              primitive{};
+        std::string                      textureName;
+        std::vector< RgPrimitiveVertex > vertices;
+        std::vector< uint32_t >          indices;
+        // for batches with the same key in a frame
+        uint32_t                         sequence{ 0 };
+    };
+    rgl::unordered_map< uint64_t, DynamicBatch > dynamicBatches;
+    // world-space normals of a primitive, before packing
+    std::vector< RgFloat3D >                     dynamicBatchNormals;
 
     // Exists only in the current frame
+    enum class AreaVisibility : uint8_t
+    {
+        Visible,
+        ShadowOnly,
+        Hidden,
+    };
+
     struct Object
     {
         // should be weak_ptr
@@ -175,12 +552,49 @@ private:
         PrimitiveUniqueID              uniqueID;
         RgTransform                    transform;
         VertexCollectorFilterTypeFlags instanceFlags;
+        // world-space bounding sphere, only for dynamic
+        RgFloat3D                      boundsCenter;
+        float                          boundsRadius;
+        // RgMeshAreaEXT::areaIndex, or NO_AREA
+        uint32_t                       areaIndex;
+        // updated each frame, as static objects are kept between frames
+        AreaVisibility                 areaVisibility{ AreaVisibility::Visible };
+        // if not null, 'builtInstance' is one of its LODs, or itself if 'lodIndex' is 0
+        BuiltAS*                       lodBase{ nullptr };
+        uint32_t                       lodIndex{ 0 };
     };
+    constexpr static uint32_t NO_AREA = UINT32_MAX;
     std::vector< Object > curFrame_objects;
+    // identical dynamic primitives of the current frame, by content
+    rgl::unordered_map< uint64_t, BuiltAS* > curFrame_dynamicInstancing;
+    InstanceStats         instanceStats{};
 
     // top level AS
     std::unique_ptr< AutoBuffer >    instanceBuffer;
     std::unique_ptr< TLASComponent > tlas[ MAX_FRAMES_IN_FLIGHT ];
+    // instance set of the last TLAS build, to refit instead of rebuilding
+    struct TLASHistory
+    {
+        uint64_t instancesHash{ 0 };
+        uint32_t instanceCount{ 0 };
+        uint32_t refitCount{ 0 };
+    };
+    TLASHistory tlasHistory[ MAX_FRAMES_IN_FLIGHT ];
+
+    // writes skinned vertices into the dynamic vertex buffer
+    std::shared_ptr< Skinning > skinning;
+    // writes quads of particles into the dynamic vertex buffer
+    std::shared_ptr< ParticleExpansion > particleExpansion;
+    // writes TLAS instances from the geometry instances, if enabled
+    std::shared_ptr< TLASInstanceGeneration > tlasInstanceGeneration;
+    // culling is deferred to the TLAS instance generation
+    RgDrawFrameInstanceCullingParams          gpuCulling{};
+    // bounds of dynamic instances are computed on upload, before the culling parameters
+    // of the frame are known, so it's the last frame's value
+    bool                                      dynamicCullingEnabled{ false };
+
+    // static emissive geometry, to sample it as a light source
+    std::unique_ptr< EmissiveTriangles > emissiveTriangles;
 
     // TLAS and buffer descriptors
     VkDescriptorPool descPool;
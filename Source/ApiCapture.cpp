@@ -0,0 +1,711 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "ApiCapture.h"
+
+#include "ApiChains.h"
+#include "DrawFrameInfo.h"
+#include "Utils.h"
+
+#include <cstring>
+#include <span>
+
+using namespace RTGL1::apichain;
+
+namespace
+{
+
+constexpr char     CAPTURE_MAGIC[ 4 ] = { 'R', 'G', 'C', 'P' };
+constexpr uint32_t CAPTURE_VERSION    = 2;
+
+// records and the data inside them are 8-byte aligned,
+// so the blobs can be used in place, after the file is loaded
+constexpr size_t CAPTURE_ALIGN = 8;
+
+enum Opcode : uint32_t
+{
+    OP_BLOB                             = 1,
+    OP_REGISTER_NAME                    = 2,
+    OP_START_FRAME                      = 3,
+    OP_UPLOAD_CAMERA                    = 4,
+    OP_UPLOAD_MESH_PRIMITIVE            = 5,
+    OP_UPLOAD_LIGHT                     = 6,
+    OP_PROVIDE_ORIGINAL_TEXTURE         = 7,
+    OP_MARK_ORIGINAL_TEXTURE_AS_DELETED = 8,
+    OP_DRAW_FRAME                       = 9,
+};
+
+struct FileHeader
+{
+    char     magic[ 4 ];
+    uint32_t version;
+    // structures are stored as is, so the capture is valid only for the same ABI
+    uint32_t pointerSize;
+    uint32_t sizeOfRgInterface;
+};
+
+// Followed by 'size' bytes of payload.
+// OP_BLOB payload: uint64_t hash, then the data.
+// Other payloads: chains of NodeHeader, each terminated by RG_STRUCTURE_TYPE_NONE
+struct RecordHeader
+{
+    uint32_t opcode;
+    uint32_t _pad;
+    uint64_t size;
+};
+
+// Followed by the structure bytes (with null pointers), and then uint64_t blob hashes
+// of its pointer members, in the order of VisitPointers
+struct NodeHeader
+{
+    RgStructureType sType;
+    uint32_t        size;
+};
+
+static_assert( sizeof( FileHeader ) % CAPTURE_ALIGN == 0 );
+static_assert( sizeof( RecordHeader ) % CAPTURE_ALIGN == 0 );
+static_assert( sizeof( NodeHeader ) % CAPTURE_ALIGN == 0 );
+
+
+void AppendBytes( std::vector< uint8_t >& dst, const void* src, size_t size )
+{
+    const size_t offset = dst.size();
+    dst.resize( offset + RTGL1::Utils::Align( size, CAPTURE_ALIGN ), 0 );
+    if( size > 0 )
+    {
+        memcpy( &dst[ offset ], src, size );
+    }
+}
+
+}
+
+
+namespace RTGL1
+{
+
+// Writes the pointed data as blobs, and replaces pointers with their hashes
+struct ApiCaptureWriterVisitor
+{
+    ApiCaptureWriter&        writer;
+    std::vector< uint64_t >& hashes;
+
+    template< typename T >
+    void Data( const T*& p, size_t count )
+    {
+        hashes.push_back( writer.WriteBlob( p, p ? sizeof( T ) * count : 0 ) );
+        p = nullptr;
+    }
+
+    void String( const char*& p )
+    {
+        hashes.push_back( writer.WriteBlob( p, p ? strlen( p ) + 1 : 0 ) );
+        p = nullptr;
+    }
+
+    void Layer( RgTextureLayer*& p, uint32_t vertexCount )
+    {
+        if( !p )
+        {
+            hashes.push_back( 0 );
+            return;
+        }
+
+        RgTextureLayer layer = *p;
+        p                    = nullptr;
+
+        // the layer itself is written with null pointers, and its members follow it
+        const RgFloat2D* texCoord = layer.pTexCoord;
+        const char*      name     = layer.pTextureName;
+        layer.pTexCoord           = nullptr;
+        layer.pTextureName        = nullptr;
+
+        hashes.push_back( writer.WriteBlob( &layer, sizeof( layer ) ) );
+        Data( texCoord, vertexCount );
+        String( name );
+    }
+
+    template< typename T >
+    void Output( T*& p )
+    {
+        p = nullptr;
+    }
+};
+
+}
+
+
+RTGL1::ApiCaptureWriter::ApiCaptureWriter( const std::filesystem::path& _path )
+    : file{ _path, std::ios::binary | std::ios::trunc }, path{ _path }
+{
+    if( !file )
+    {
+        debug::Warning( "Can't open a file for API capture: {}", path.string() );
+        return;
+    }
+
+    auto header = FileHeader{
+        .version           = CAPTURE_VERSION,
+        .pointerSize       = sizeof( void* ),
+        .sizeOfRgInterface = sizeof( RgInterface ),
+    };
+    memcpy( header.magic, CAPTURE_MAGIC, sizeof( CAPTURE_MAGIC ) );
+
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    debug::Info( "Capturing API calls to: {}", path.string() );
+}
+
+RTGL1::ApiCaptureWriter::~ApiCaptureWriter()
+{
+    if( file )
+    {
+        file.flush();
+        debug::Info( "API capture is written: {}", path.string() );
+    }
+}
+
+uint64_t RTGL1::ApiCaptureWriter::WriteBlob( const void* pData, size_t size )
+{
+    if( !pData || size == 0 )
+    {
+        return 0;
+    }
+
+    uint64_t hash = ankerl::unordered_dense::detail::wyhash::hash( pData, size );
+    hash ^= size + 0x9e3779b9 + ( hash << 6 ) + ( hash >> 2 );
+    // 0 is reserved for null
+    hash = hash != 0 ? hash : 1;
+
+    if( writtenBlobs.insert( hash ).second )
+    {
+        auto header = RecordHeader{
+            .opcode = OP_BLOB,
+            .size   = sizeof( hash ) + Utils::Align( size, CAPTURE_ALIGN ),
+        };
+
+        blob.clear();
+        AppendBytes( blob, &header, sizeof( header ) );
+        AppendBytes( blob, &hash, sizeof( hash ) );
+        AppendBytes( blob, pData, size );
+
+        file.write( reinterpret_cast< const char* >( blob.data() ),
+                    static_cast< std::streamsize >( blob.size() ) );
+    }
+    return hash;
+}
+
+void RTGL1::ApiCaptureWriter::AppendChain( const void* pRoot )
+{
+    auto ctx    = ChainContext{};
+    auto hashes = std::vector< uint64_t >{};
+
+    if( auto tex = pnext::cast< RgOriginalTextureInfo >( pRoot ) )
+    {
+        ctx.pixelDataSize = OriginalTextureDataSize( *tex );
+    }
+
+    for( const void* node = pRoot; node; node = detail::GetPNext( node ) )
+    {
+        const RgStructureType sType = detail::GetStructureType( node );
+
+        bool captured = ForChainType( sType, [ & ]< typename T >() {
+            T copy     = *static_cast< const T* >( node );
+            copy.pNext = nullptr;
+
+            hashes.clear();
+            auto v = ApiCaptureWriterVisitor{ *this, hashes };
+            VisitPointers( copy, v, ctx );
+
+            auto nodeHeader = NodeHeader{
+                .sType = sType,
+                .size  = sizeof( T ),
+            };
+            AppendBytes( record, &nodeHeader, sizeof( nodeHeader ) );
+            AppendBytes( record, &copy, sizeof( copy ) );
+            AppendBytes( record, hashes.data(), hashes.size() * sizeof( uint64_t ) );
+        } );
+
+        // readback is an output, nothing to replay
+        if( !captured && sType != RG_STRUCTURE_TYPE_CAMERA_INFO_READ_BACK_EXT )
+        {
+            debug::Warning( "API capture: sType={} is not supported, skipping", int( sType ) );
+        }
+    }
+
+    auto end = NodeHeader{ .sType = RG_STRUCTURE_TYPE_NONE, .size = 0 };
+    AppendBytes( record, &end, sizeof( end ) );
+}
+
+void RTGL1::ApiCaptureWriter::WriteRecord( uint32_t opcode, const void* pRoot, const void* pRoot2 )
+{
+    if( !file )
+    {
+        return;
+    }
+
+    // reserve the header, as blobs are written to the file while appending chains
+    record.clear();
+    record.resize( sizeof( RecordHeader ) );
+
+    AppendChain( pRoot );
+    if( pRoot2 )
+    {
+        AppendChain( pRoot2 );
+    }
+
+    auto header = RecordHeader{
+        .opcode = opcode,
+        .size   = record.size() - sizeof( RecordHeader ),
+    };
+    memcpy( record.data(), &header, sizeof( header ) );
+
+    file.write( reinterpret_cast< const char* >( record.data() ),
+                static_cast< std::streamsize >( record.size() ) );
+}
+
+void RTGL1::ApiCaptureWriter::WriteString( uint32_t opcode, const char* pStr )
+{
+    if( !file || !pStr )
+    {
+        return;
+    }
+
+    uint64_t hash = WriteBlob( pStr, strlen( pStr ) + 1 );
+
+    auto header = RecordHeader{
+        .opcode = opcode,
+        .size   = sizeof( hash ),
+    };
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    file.write( reinterpret_cast< const char* >( &hash ), sizeof( hash ) );
+}
+
+void RTGL1::ApiCaptureWriter::RegisterName( const char* pName )
+{
+    auto lock = std::lock_guard{ mutex };
+    WriteString( OP_REGISTER_NAME, pName );
+}
+
+void RTGL1::ApiCaptureWriter::StartFrame( const RgStartFrameInfo* pInfo )
+{
+    auto lock = std::lock_guard{ mutex };
+    if( pInfo )
+    {
+        WriteRecord( OP_START_FRAME, pInfo );
+    }
+}
+
+void RTGL1::ApiCaptureWriter::UploadCamera( const RgCameraInfo* pInfo )
+{
+    auto lock = std::lock_guard{ mutex };
+    if( pInfo )
+    {
+        WriteRecord( OP_UPLOAD_CAMERA, pInfo );
+    }
+}
+
+void RTGL1::ApiCaptureWriter::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
+                                                   const RgMeshPrimitiveInfo* pPrimitive )
+{
+    auto lock = std::lock_guard{ mutex };
+    if( pMesh && pPrimitive )
+    {
+        WriteRecord( OP_UPLOAD_MESH_PRIMITIVE, pMesh, pPrimitive );
+    }
+}
+
+void RTGL1::ApiCaptureWriter::UploadLight( const RgLightInfo* pInfo )
+{
+    auto lock = std::lock_guard{ mutex };
+    if( pInfo )
+    {
+        WriteRecord( OP_UPLOAD_LIGHT, pInfo );
+    }
+}
+
+void RTGL1::ApiCaptureWriter::ProvideOriginalTexture( const RgOriginalTextureInfo* pInfo )
+{
+    auto lock = std::lock_guard{ mutex };
+    if( pInfo )
+    {
+        WriteRecord( OP_PROVIDE_ORIGINAL_TEXTURE, pInfo );
+    }
+}
+
+void RTGL1::ApiCaptureWriter::MarkOriginalTextureAsDeleted( const char* pTextureName )
+{
+    auto lock = std::lock_guard{ mutex };
+    WriteString( OP_MARK_ORIGINAL_TEXTURE_AS_DELETED, pTextureName );
+}
+
+void RTGL1::ApiCaptureWriter::DrawFrame( const RgDrawFrameInfo* pInfo )
+{
+    auto lock = std::lock_guard{ mutex };
+    if( pInfo )
+    {
+        WriteRecord( OP_DRAW_FRAME, pInfo );
+    }
+}
+
+
+
+namespace
+{
+
+// Restores the structures of one record. They are valid until the next record
+class ChainReader
+{
+public:
+    ChainReader( std::span< const uint8_t >                            payload,
+                 const rgl::unordered_map< uint64_t, const uint8_t* >& _blobs,
+                 std::vector< std::unique_ptr< uint8_t[] > >&          _arena )
+        : cur{ payload.data() }
+        , end{ payload.data() + payload.size() }
+        , blobs{ _blobs }
+        , arena{ _arena }
+    {
+    }
+
+    // Null, if the chain is empty or invalid
+    const void* ReadChain()
+    {
+        auto  ctx  = ChainContext{};
+        void* root = nullptr;
+        void* last = nullptr;
+
+        while( !failed )
+        {
+            auto header = Read< NodeHeader >();
+            if( failed || header.sType == RG_STRUCTURE_TYPE_NONE )
+            {
+                break;
+            }
+
+            void* node = nullptr;
+            ForChainType( header.sType, [ & ]< typename T >() {
+                if( header.size != sizeof( T ) || !Has( sizeof( T ) ) )
+                {
+                    return;
+                }
+
+                T* s = Allocate< T >();
+                memcpy( s, cur, sizeof( T ) );
+                cur += RTGL1::Utils::Align( sizeof( T ), CAPTURE_ALIGN );
+
+                VisitPointers( *s, *this, ctx );
+                node = s;
+            } );
+
+            if( !node )
+            {
+                failed = true;
+                break;
+            }
+
+            if( last )
+            {
+                static_cast< RTGL1::detail::AnyInfoPrototype* >( last )->pNext = node;
+            }
+            else
+            {
+                root = node;
+            }
+            last = node;
+        }
+
+        return failed ? nullptr : root;
+    }
+
+    const char* ReadString()
+    {
+        const char* str = nullptr;
+        String( str );
+        return failed ? nullptr : str;
+    }
+
+    // Visitor
+
+    template< typename T >
+    void Data( const T*& p, size_t )
+    {
+        p = reinterpret_cast< const T* >( Lookup( Read< uint64_t >() ) );
+    }
+
+    void String( const char*& p )
+    {
+        p = reinterpret_cast< const char* >( Lookup( Read< uint64_t >() ) );
+    }
+
+    void Layer( RgTextureLayer*& p, uint32_t )
+    {
+        p = nullptr;
+
+        auto src = reinterpret_cast< const RgTextureLayer* >( Lookup( Read< uint64_t >() ) );
+        if( !src )
+        {
+            return;
+        }
+
+        p = Allocate< RgTextureLayer >();
+        memcpy( p, src, sizeof( RgTextureLayer ) );
+
+        Data( p->pTexCoord, 0 );
+        String( p->pTextureName );
+    }
+
+    template< typename T >
+    void Output( T*& p )
+    {
+        p = nullptr;
+    }
+
+private:
+    bool Has( size_t size ) const { return size_t( end - cur ) >= size; }
+
+    template< typename T >
+    T Read()
+    {
+        if( failed || !Has( sizeof( T ) ) )
+        {
+            failed = true;
+            return T{};
+        }
+
+        T v;
+        memcpy( &v, cur, sizeof( T ) );
+        cur += RTGL1::Utils::Align( sizeof( T ), CAPTURE_ALIGN );
+        return v;
+    }
+
+    const uint8_t* Lookup( uint64_t hash )
+    {
+        if( hash == 0 )
+        {
+            return nullptr;
+        }
+
+        auto found = blobs.find( hash );
+        if( found == blobs.end() )
+        {
+            failed = true;
+            return nullptr;
+        }
+        return found->second;
+    }
+
+    template< typename T >
+    T* Allocate()
+    {
+        arena.push_back( std::make_unique< uint8_t[] >( sizeof( T ) ) );
+        return reinterpret_cast< T* >( arena.back().get() );
+    }
+
+private:
+    const uint8_t* cur;
+    const uint8_t* end;
+    bool           failed{ false };
+
+    const rgl::unordered_map< uint64_t, const uint8_t* >& blobs;
+    std::vector< std::unique_ptr< uint8_t[] > >&          arena;
+};
+
+}
+
+RgResult RTGL1::ReplayApiCapture( const std::filesystem::path& path,
+                                  const RgInterface&           rg,
+                                  PFN_rgUtilReplayOnFrame      pfnOnFrame,
+                                  void*                        pUserData )
+{
+    // as uint64_t, for the alignment
+    auto   data = std::vector< uint64_t >{};
+    size_t size = 0;
+    {
+        auto f = std::ifstream( path, std::ios::binary | std::ios::ate );
+        if( !f )
+        {
+            debug::Warning( "Can't open API capture: {}", path.string() );
+            return RG_RESULT_WRONG_FUNCTION_ARGUMENT;
+        }
+
+        size = static_cast< size_t >( f.tellg() );
+        data.resize( ( size + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ) );
+
+        f.seekg( 0 );
+        f.read( reinterpret_cast< char* >( data.data() ), static_cast< std::streamsize >( size ) );
+        if( !f )
+        {
+            debug::Warning( "Can't read API capture: {}", path.string() );
+            return RG_RESULT_WRONG_FUNCTION_ARGUMENT;
+        }
+    }
+
+    const auto bytes = std::span{ reinterpret_cast< const uint8_t* >( data.data() ), size };
+
+    {
+        FileHeader header = {};
+        if( bytes.size() < sizeof( header ) )
+        {
+            debug::Warning( "API capture is corrupted: {}", path.string() );
+            return RG_RESULT_WRONG_FUNCTION_ARGUMENT;
+        }
+        memcpy( &header, bytes.data(), sizeof( header ) );
+
+        if( memcmp( header.magic, CAPTURE_MAGIC, sizeof( CAPTURE_MAGIC ) ) != 0 ||
+            header.version != CAPTURE_VERSION || header.pointerSize != sizeof( void* ) ||
+            header.sizeOfRgInterface != sizeof( RgInterface ) )
+        {
+            debug::Warning( "API capture was made with an incompatible version of the library: {}",
+                            path.string() );
+            return RG_RESULT_WRONG_FUNCTION_ARGUMENT;
+        }
+    }
+
+    auto     blobs      = rgl::unordered_map< uint64_t, const uint8_t* >{};
+    auto     arena      = std::vector< std::unique_ptr< uint8_t[] > >{};
+    uint32_t frameIndex = 0;
+
+    size_t offset = sizeof( FileHeader );
+    while( offset + sizeof( RecordHeader ) <= bytes.size() )
+    {
+        RecordHeader header = {};
+        memcpy( &header, &bytes[ offset ], sizeof( header ) );
+        offset += sizeof( header );
+
+        if( header.size > bytes.size() - offset )
+        {
+            debug::Warning( "API capture is truncated: {}", path.string() );
+            break;
+        }
+
+        const auto payload = bytes.subspan( offset, header.size );
+        offset += Utils::Align( header.size, uint64_t{ CAPTURE_ALIGN } );
+
+        if( header.opcode == OP_BLOB )
+        {
+            uint64_t hash = 0;
+            if( payload.size() >= sizeof( hash ) )
+            {
+                memcpy( &hash, payload.data(), sizeof( hash ) );
+                blobs[ hash ] = payload.data() + sizeof( hash );
+            }
+            continue;
+        }
+
+        arena.clear();
+        auto reader = ChainReader{ payload, blobs, arena };
+
+        bool valid = true;
+        switch( header.opcode )
+        {
+            case OP_REGISTER_NAME: {
+                auto pName = reader.ReadString();
+                valid      = pName != nullptr;
+                if( valid )
+                {
+                    rg.rgRegisterName( pName );
+                }
+                break;
+            }
+            case OP_START_FRAME: {
+                auto pInfo = static_cast< const RgStartFrameInfo* >( reader.ReadChain() );
+                valid      = pInfo != nullptr;
+                if( valid )
+                {
+                    rg.rgStartFrame( pInfo );
+                }
+                break;
+            }
+            case OP_UPLOAD_CAMERA: {
+                auto pInfo = static_cast< const RgCameraInfo* >( reader.ReadChain() );
+                valid      = pInfo != nullptr;
+                if( valid )
+                {
+                    rg.rgUploadCamera( pInfo );
+                }
+                break;
+            }
+            case OP_UPLOAD_MESH_PRIMITIVE: {
+                auto pMesh      = static_cast< const RgMeshInfo* >( reader.ReadChain() );
+                auto pPrimitive = static_cast< const RgMeshPrimitiveInfo* >( reader.ReadChain() );
+                valid           = pMesh != nullptr && pPrimitive != nullptr;
+                if( valid )
+                {
+                    rg.rgUploadMeshPrimitive( pMesh, pPrimitive );
+                }
+                break;
+            }
+            case OP_UPLOAD_LIGHT: {
+                auto pInfo = static_cast< const RgLightInfo* >( reader.ReadChain() );
+                valid      = pInfo != nullptr;
+                if( valid )
+                {
+                    rg.rgUploadLight( pInfo );
+                }
+                break;
+            }
+            case OP_PROVIDE_ORIGINAL_TEXTURE: {
+                auto pInfo = static_cast< const RgOriginalTextureInfo* >( reader.ReadChain() );
+                valid      = pInfo != nullptr;
+                if( valid )
+                {
+                    rg.rgProvideOriginalTexture( pInfo );
+                }
+                break;
+            }
+            case OP_MARK_ORIGINAL_TEXTURE_AS_DELETED: {
+                auto pName = reader.ReadString();
+                valid      = pName != nullptr;
+                if( valid )
+                {
+                    rg.rgMarkOriginalTextureAsDeleted( pName );
+                }
+                break;
+            }
+            case OP_DRAW_FRAME: {
+                auto pInfo = static_cast< const RgDrawFrameInfo* >( reader.ReadChain() );
+                valid      = pInfo != nullptr;
+                if( valid )
+                {
+                    rg.rgDrawFrame( pInfo );
+
+                    if( pfnOnFrame && !pfnOnFrame( frameIndex, pUserData ) )
+                    {
+                        return RG_RESULT_SUCCESS;
+                    }
+                    frameIndex++;
+                }
+                break;
+            }
+            default: valid = false; break;
+        }
+
+        if( !valid )
+        {
+            debug::Warning( "API capture has an invalid record (opcode={}) at offset {}: {}",
+                            header.opcode,
+                            offset,
+                            path.string() );
+            return RG_RESULT_WRONG_FUNCTION_ARGUMENT;
+        }
+    }
+
+    debug::Info( "Replayed {} frames from API capture: {}", frameIndex, path.string() );
+    return RG_RESULT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Common.h"
+#include "Containers.h"
+
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Records the main API calls into a binary file. The data that the calls point to
+// (vertices, indices, pixels, strings) is written once per content hash,
+// and the calls refer to it by the hash, so the data repeated each frame is not duplicated
+class ApiCaptureWriter
+{
+public:
+    explicit ApiCaptureWriter( const std::filesystem::path& path );
+    ~ApiCaptureWriter();
+
+    ApiCaptureWriter( const ApiCaptureWriter& other )                = delete;
+    ApiCaptureWriter( ApiCaptureWriter&& other ) noexcept            = delete;
+    ApiCaptureWriter& operator=( const ApiCaptureWriter& other )     = delete;
+    ApiCaptureWriter& operator=( ApiCaptureWriter&& other ) noexcept = delete;
+
+    void RegisterName( const char* pName );
+    void StartFrame( const RgStartFrameInfo* pInfo );
+    void UploadCamera( const RgCameraInfo* pInfo );
+    void UploadMeshPrimitive( const RgMeshInfo* pMesh, const RgMeshPrimitiveInfo* pPrimitive );
+    void UploadLight( const RgLightInfo* pInfo );
+    void ProvideOriginalTexture( const RgOriginalTextureInfo* pInfo );
+    void MarkOriginalTextureAsDeleted( const char* pTextureName );
+    void DrawFrame( const RgDrawFrameInfo* pInfo );
+
+private:
+    friend struct ApiCaptureWriterVisitor;
+
+    // Returns the hash to refer to the data. 0, if null
+    uint64_t WriteBlob( const void* pData, size_t size );
+    void     AppendChain( const void* pRoot );
+    void     WriteRecord( uint32_t opcode, const void* pRoot, const void* pRoot2 = nullptr );
+    void     WriteString( uint32_t opcode, const char* pStr );
+
+private:
+    std::ofstream                  file;
+    std::filesystem::path          path;
+    rgl::unordered_set< uint64_t > writtenBlobs;
+
+    // reused between the calls, to not allocate
+    std::vector< uint8_t > record;
+    std::vector< uint8_t > blob;
+
+    // rgUploadMeshPrimitive can be called from multiple threads
+    std::mutex mutex;
+};
+
+// Calls the API functions of 'rg' with the arguments read from a file of ApiCaptureWriter.
+// The whole file is loaded in memory beforehand, so disk reads don't affect the replay
+RgResult ReplayApiCapture( const std::filesystem::path& path,
+                           const RgInterface&           rg,
+                           PFN_rgUtilReplayOnFrame      pfnOnFrame,
+                           void*                        pUserData );
+
+}
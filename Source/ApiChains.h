@@ -0,0 +1,296 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Common.h"
+#include "DrawFrameInfo.h"
+
+#include <algorithm>
+#include <tuple>
+
+// Structure chains of the API calls that can be stored and issued later:
+// by ApiCaptureWriter into a file, and by RenderThread into a frame's arena
+namespace RTGL1::apichain
+{
+
+// clang-format off
+using ChainTypes = std::tuple<
+    RgMeshInfo,
+    RgMeshNameHandleEXT,
+    RgMeshAreaEXT,
+    RgMeshPrimitiveInfo,
+    RgMeshPrimitivePortalEXT,
+    RgMeshPrimitiveTextureLayersEXT,
+    RgMeshPrimitivePBREXT,
+    RgMeshPrimitiveAttachedLightEXT,
+    RgMeshPrimitiveSwapchainedEXT,
+    RgMeshPrimitiveSkinningEXT,
+    RgMeshPrimitiveParticlesEXT,
+    RgMeshPrimitiveNameHandleEXT,
+    RgLightInfo,
+    RgLightAdditionalEXT,
+    RgLightDirectionalEXT,
+    RgLightSphericalEXT,
+    RgLightPolygonalEXT,
+    RgLightSpotEXT,
+    RgCameraInfo,
+    RgOriginalTextureInfo,
+    RgOriginalTextureDetailsEXT,
+    RgOriginalTextureAsyncEXT,
+    RgStartFrameInfo,
+    RgStartFrameRenderResolutionParams,
+    RgStartFrameFluidParams,
+    RgStartFrameStereoParams,
+    RgStartFrameViewsParams,
+    RgStartFrameFramePacingParams,
+    RgDrawFrameInfo,
+    RgDrawFrameIlluminationParams,
+    RgDrawFrameVolumetricParams,
+    RgDrawFrameTonemappingParams,
+    RgDrawFrameBloomParams,
+    RgDrawFrameReflectRefractParams,
+    RgDrawFrameSkyParams,
+    RgDrawFrameTexturesParams,
+    RgDrawFramePostEffectsParams,
+    RgDrawFrameInstanceCullingParams,
+    RgDrawFrameViewsParams,
+    RgDrawFrameAreaVisibilityParams,
+    RgLensFlareInfo,
+    RgSpawnFluidInfo >;
+// clang-format on
+
+// Call f.operator()< T >() for T that corresponds to sType. False, if sType is not in ChainTypes
+template< typename F >
+bool ForChainType( RgStructureType sType, F&& f )
+{
+    return [ & ]< typename... Ts >( std::type_identity< std::tuple< Ts... > > ) {
+        return ( ( sType == detail::TypeToStructureType< Ts >
+                       ? ( f.template operator()< Ts >(), true )
+                       : false ) ||
+                 ... );
+    }( std::type_identity< ChainTypes >{} );
+}
+
+// Values from the previous nodes of a chain, that define the size of the pointed data
+struct ChainContext
+{
+    uint32_t vertexCount{ 0 };
+    size_t   pixelDataSize{ 0 };
+};
+
+// Visitor 'v' is called for each pointer member, in the same order on writing and reading.
+// V::Data( const T*&, count ), V::String( const char*& ), V::Layer( RgTextureLayer*&, count ),
+// V::Output( T*& ) for the members that are written by the library
+template< typename T, typename V >
+void VisitPointers( T&, V&, ChainContext& )
+{
+    // no pointer members
+}
+
+template< typename V >
+void VisitPointers( RgMeshInfo& s, V& v, ChainContext& ctx )
+{
+    v.String( s.pMeshName );
+}
+
+template< typename V >
+void VisitPointers( RgMeshPrimitiveInfo& s, V& v, ChainContext& ctx )
+{
+    ctx.vertexCount = s.vertexCount;
+
+    v.Data( s.pVertices, s.vertexCount );
+    v.Data( s.pIndices, s.pIndices16 ? 0 : s.indexCount );
+    v.String( s.pTextureName );
+    v.Data( s.pIndices16, s.indexCount );
+}
+
+template< typename V >
+void VisitPointers( RgMeshPrimitiveTextureLayersEXT& s, V& v, ChainContext& ctx )
+{
+    v.Layer( s.pLayer1, ctx.vertexCount );
+    v.Layer( s.pLayer2, ctx.vertexCount );
+    v.Layer( s.pLayer3, ctx.vertexCount );
+}
+
+template< typename V >
+void VisitPointers( RgMeshPrimitiveSwapchainedEXT& s, V& v, ChainContext& ctx )
+{
+    v.Data( s.pViewport, 1 );
+    v.Data( s.pView, 16 );
+    v.Data( s.pProjection, 16 );
+    v.Data( s.pViewProjection, 16 );
+}
+
+template< typename V >
+void VisitPointers( RgMeshPrimitiveSkinningEXT& s, V& v, ChainContext& ctx )
+{
+    v.Data( s.pSkinWeights, ctx.vertexCount );
+    v.Data( s.pBoneTransforms, s.boneCount );
+}
+
+template< typename V >
+void VisitPointers( RgMeshPrimitiveParticlesEXT& s, V& v, ChainContext& ctx )
+{
+    v.Data( s.pParticles, s.particleCount );
+}
+
+template< typename V >
+void VisitPointers( RgLensFlareInfo& s, V& v, ChainContext& ctx )
+{
+    v.Data( s.pVertices, s.vertexCount );
+    v.Data( s.pIndices, s.indexCount );
+    v.String( s.pTextureName );
+}
+
+template< typename V >
+void VisitPointers( RgCameraInfo& s, V& v, ChainContext& ctx )
+{
+    v.Data( s.pView, 16 );
+}
+
+// additional cameras must have no pointers, so they are captured as plain data
+template< typename V >
+void VisitPointers( RgDrawFrameViewsParams& s, V& v, ChainContext& ctx )
+{
+    v.Data( s.pAdditionalCameras, s.additionalCameraCount );
+}
+
+template< typename V >
+void VisitPointers( RgDrawFrameAreaVisibilityParams& s, V& v, ChainContext& ctx )
+{
+    const uint32_t wordCount = ( s.areaCount + 31 ) / 32;
+    v.Data( s.pVisibleAreas, wordCount );
+    v.Data( s.pShadowAreas, wordCount );
+}
+
+template< typename V >
+void VisitPointers( RgOriginalTextureInfo& s, V& v, ChainContext& ctx )
+{
+    v.String( s.pTextureName );
+    v.Data( reinterpret_cast< const uint8_t*& >( s.pPixels ), ctx.pixelDataSize );
+}
+
+// the release callback is not stored: the stored pixels are owned by the storage,
+// so the replayed / issued call copies them
+template< typename V >
+void VisitPointers( RgOriginalTextureAsyncEXT& s, V& v, ChainContext& ctx )
+{
+    s.pfnReleasePixels = nullptr;
+    s.pUserData        = nullptr;
+}
+
+template< typename V >
+void VisitPointers( RgStartFrameInfo& s, V& v, ChainContext& ctx )
+{
+    v.String( s.pMapName );
+    v.Data( s.pLightstyleValues8, s.lightstyleValuesCount );
+    v.Output( s.pResultStaticSceneStatus );
+}
+
+template< typename V >
+void VisitPointers( RgDrawFrameIlluminationParams& s, V& v, ChainContext& ctx )
+{
+    v.Data( s.lightUniqueIdIgnoreFirstPersonViewerShadows, 1 );
+}
+
+template< typename V >
+void VisitPointers( RgDrawFrameSkyParams& s, V& v, ChainContext& ctx )
+{
+    v.String( s.pSkyCubemapTextureName );
+}
+
+template< typename V >
+void VisitPointers( RgDrawFramePostEffectsParams& s, V& v, ChainContext& ctx )
+{
+    v.Data( s.pWipe, 1 );
+    v.Data( s.pRadialBlur, 1 );
+    v.Data( s.pChromaticAberration, 1 );
+    v.Data( s.pInverseBlackAndWhite, 1 );
+    v.Data( s.pHueShift, 1 );
+    v.Data( s.pNightVision, 1 );
+    v.Data( s.pDistortedSides, 1 );
+    v.Data( s.pWaves, 1 );
+    v.Data( s.pColorTint, 1 );
+    v.Data( s.pTeleport, 1 );
+    v.Data( s.pCRT, 1 );
+    v.Data( s.pVHS, 1 );
+    v.Data( s.pDither, 1 );
+}
+
+// 0, if the format is not supported
+inline size_t OriginalTextureLevelSize( RgFormat format, uint32_t width, uint32_t height )
+{
+    const size_t blocks = size_t{ ( width + 3 ) / 4 } * ( ( height + 3 ) / 4 );
+
+    switch( format )
+    {
+        case RG_FORMAT_R8_UNORM:
+        case RG_FORMAT_R8_SRGB: return size_t{ width } * height;
+        case RG_FORMAT_R8G8B8A8_UNORM:
+        case RG_FORMAT_R8G8B8A8_SRGB:
+        case RG_FORMAT_B8G8R8A8_UNORM:
+        case RG_FORMAT_B8G8R8A8_SRGB: return size_t{ width } * height * 4;
+        case RG_FORMAT_BC1_RGBA_UNORM:
+        case RG_FORMAT_BC1_RGBA_SRGB:
+        case RG_FORMAT_BC4_UNORM: return blocks * 8;
+        case RG_FORMAT_BC3_UNORM:
+        case RG_FORMAT_BC3_SRGB:
+        case RG_FORMAT_BC5_UNORM:
+        case RG_FORMAT_BC7_UNORM:
+        case RG_FORMAT_BC7_SRGB: return blocks * 16;
+        default: return 0;
+    }
+}
+
+inline RgFormat OriginalTextureFormat( const RgOriginalTextureInfo& info )
+{
+    if( auto details = pnext::find< RgOriginalTextureDetailsEXT >( &info ) )
+    {
+        return details->format;
+    }
+    return RG_FORMAT_R8G8B8A8_SRGB;
+}
+
+inline uint32_t OriginalTextureLevelCount( const RgOriginalTextureInfo& info )
+{
+    if( auto async = pnext::find< RgOriginalTextureAsyncEXT >( &info ) )
+    {
+        return std::max( async->pregeneratedLevelCount, 1u );
+    }
+    return 1;
+}
+
+// Size of RgOriginalTextureInfo::pPixels, including all the pregenerated mip levels
+inline size_t OriginalTextureDataSize( const RgOriginalTextureInfo& info )
+{
+    const RgFormat format = OriginalTextureFormat( info );
+
+    size_t sum = 0;
+    for( uint32_t i = 0; i < OriginalTextureLevelCount( info ); i++ )
+    {
+        sum += OriginalTextureLevelSize( format,
+                                         std::max( info.size.width >> i, 1u ),
+                                         std::max( info.size.height >> i, 1u ) );
+    }
+    return sum;
+}
+
+}
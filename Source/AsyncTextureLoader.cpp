@@ -0,0 +1,137 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "AsyncTextureLoader.h"
+
+#include <ranges>
+
+RTGL1::AsyncTextureLoader::AsyncTextureLoader( uint32_t threadCount )
+{
+    m_workers.reserve( threadCount );
+
+    for( uint32_t i = 0; i < std::max( threadCount, 1u ); i++ )
+    {
+        m_workers.emplace_back( [ this ]( std::stop_token token ) {
+            while( true )
+            {
+                auto request = std::optional< Request >{};
+                {
+                    auto l = std::unique_lock{ m_mutex };
+
+                    if( !m_requestAdded.wait( l, token, [ this ] { return !m_requests.empty(); } ) )
+                    {
+                        // stop was requested
+                        return;
+                    }
+
+                    request = std::move( m_requests.front() );
+                    m_requests.pop_front();
+                }
+
+                Result r = Load( std::move( *request ) );
+                {
+                    auto l = std::lock_guard{ m_mutex };
+                    m_finished.push_back( std::move( r ) );
+                }
+            }
+        } );
+    }
+}
+
+RTGL1::AsyncTextureLoader::~AsyncTextureLoader()
+{
+    for( auto& w : m_workers )
+    {
+        w.request_stop();
+    }
+    m_workers.clear();
+}
+
+void RTGL1::AsyncTextureLoader::Enqueue( Request&& request )
+{
+    {
+        auto l = std::lock_guard{ m_mutex };
+        m_requests.push_back( std::move( request ) );
+    }
+    m_requestAdded.notify_one();
+}
+
+auto RTGL1::AsyncTextureLoader::TakeFinished( size_t maxCount, size_t maxBytes )
+    -> std::vector< Result >
+{
+    auto l = std::lock_guard{ m_mutex };
+
+    auto   taken = std::vector< Result >{};
+    size_t bytes = 0;
+
+    while( !m_finished.empty() && taken.size() < maxCount )
+    {
+        if( !taken.empty() && bytes + m_finished.front().dataSize > maxBytes )
+        {
+            break;
+        }
+
+        bytes += m_finished.front().dataSize;
+        taken.push_back( std::move( m_finished.front() ) );
+        m_finished.pop_front();
+    }
+    return taken;
+}
+
+auto RTGL1::AsyncTextureLoader::Load( Request&& request ) -> Result
+{
+    // loaders are created per request, as they are not thread-safe
+    auto r = Result{
+        .materialName       = std::move( request.materialName ),
+        .materialGeneration = request.materialGeneration,
+        .loaderKtx          = std::make_unique< ImageLoader >(),
+        .loaderRaw          = std::make_unique< ImageLoaderDev >(),
+        .textures           = {},
+        .hotReload          = std::move( request.hotReload ),
+        .dataSize           = 0,
+    };
+
+    for( uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++ )
+    {
+        const auto& path = request.paths[ i ];
+
+        if( path.empty() )
+        {
+            continue;
+        }
+
+        const bool isKtx = std::ranges::any_of( ImageLoader::GetExtensions(), [ & ]( auto ext ) {
+            return path.extension() == ext;
+        } );
+
+        auto loader = isKtx ? TextureOverrides::Loader{ std::tuple{ r.loaderKtx.get() } }
+                            : TextureOverrides::Loader{ std::tuple{ r.loaderRaw.get() } };
+
+        r.textures[ i ] =
+            std::make_unique< TextureOverrides >( path, request.isSRGB[ i ], std::move( loader ) );
+
+        if( r.textures[ i ]->result )
+        {
+            r.dataSize += r.textures[ i ]->result->dataSize;
+        }
+    }
+
+    return r;
+}
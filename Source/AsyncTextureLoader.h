@@ -0,0 +1,106 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ImageLoader.h"
+#include "ImageLoaderDev.h"
+#include "Material.h"
+#include "TextureOverrides.h"
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+namespace RTGL1
+{
+
+// Decodes material texture files on worker threads.
+// Only file reading is done asynchronously, uploading must be done by the owner
+class AsyncTextureLoader
+{
+public:
+    struct HotReload
+    {
+        uint32_t              textureIndex;
+        // to discard the result, if the slot was reused meanwhile
+        std::filesystem::path prevPath;
+    };
+
+    struct Request
+    {
+        std::string materialName;
+        // to discard the result, if material was destroyed / recreated meanwhile
+        uint64_t    materialGeneration;
+        // empty path, if texture doesn't need to be loaded
+        std::filesystem::path paths[ TEXTURES_PER_MATERIAL_COUNT ];
+        bool                  isSRGB[ TEXTURES_PER_MATERIAL_COUNT ];
+
+        // if set, paths[0] is a new version of the file that is in the texture slot
+        std::optional< HotReload > hotReload;
+    };
+
+    struct Result
+    {
+        std::string materialName;
+        uint64_t    materialGeneration;
+
+        // loaders are owned by the result, as the loaded data is freed on their destruction
+        std::unique_ptr< ImageLoader >    loaderKtx;
+        std::unique_ptr< ImageLoaderDev > loaderRaw;
+        // null, if texture wasn't requested
+        std::array< std::unique_ptr< TextureOverrides >, TEXTURES_PER_MATERIAL_COUNT > textures;
+
+        std::optional< HotReload > hotReload;
+        // sum of the loaded image data sizes
+        size_t                     dataSize;
+    };
+
+public:
+    explicit AsyncTextureLoader( uint32_t threadCount );
+    ~AsyncTextureLoader();
+
+    AsyncTextureLoader( const AsyncTextureLoader& other )                = delete;
+    AsyncTextureLoader( AsyncTextureLoader&& other ) noexcept            = delete;
+    AsyncTextureLoader& operator=( const AsyncTextureLoader& other )     = delete;
+    AsyncTextureLoader& operator=( AsyncTextureLoader&& other ) noexcept = delete;
+
+    void Enqueue( Request&& request );
+    // At least one result is taken, even if it's larger than maxBytes
+    auto TakeFinished( size_t maxCount, size_t maxBytes ) -> std::vector< Result >;
+
+private:
+    static Result Load( Request&& request );
+
+private:
+    std::mutex                  m_mutex;
+    std::condition_variable_any m_requestAdded;
+    std::deque< Request >       m_requests;
+    std::deque< Result >        m_finished;
+
+    // must be last, to join the threads before destroying the queues
+    std::vector< std::jthread > m_workers;
+};
+
+}
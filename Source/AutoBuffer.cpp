@@ -35,7 +35,7 @@ void RTGL1::AutoBuffer::Create( VkDeviceSize       size,
                                 const std::string& debugName,
                                 uint32_t           frameCount )
 {
-    assert( frameCount > 0 && frameCount <= MAX_FRAMES_IN_FLIGHT );
+    assert( frameCount > 0 && frameCount <= FramesInFlight() );
 
     const std::string debugNameStaging = debugName + " - staging";
 
@@ -42,7 +42,7 @@ public:
     void            Create( VkDeviceSize       size,
                             VkBufferUsageFlags usage,
                             const std::string& debugName,
-                            uint32_t           frameCount = MAX_FRAMES_IN_FLIGHT );
+                            uint32_t           frameCount = FramesInFlight() );
     void            Destroy();
 
     void            CopyFromStaging( VkCommandBuffer cmd,
@@ -0,0 +1,408 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BLASDiskCache.h"
+
+#include "CmdLabel.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+
+constexpr char     CACHE_MAGIC[ 4 ] = { 'R', 'G', 'A', 'S' };
+constexpr uint32_t CACHE_VERSION    = 1;
+
+// required for the device addresses of serialized AS data
+constexpr VkDeviceSize SERIALIZED_ALIGN = 256;
+
+// beginning of the serialized AS data, as defined by the spec:
+// driverUUID, compatibility UUID, serialized size, deserialized size, handle count
+constexpr size_t SERIALIZED_HEADER_SIZE   = 2 * VK_UUID_SIZE + 3 * sizeof( uint64_t );
+constexpr size_t DESERIALIZED_SIZE_OFFSET = 2 * VK_UUID_SIZE + sizeof( uint64_t );
+
+struct FileHeader
+{
+    char     magic[ 4 ];
+    uint32_t version;
+    uint64_t key;
+    uint8_t  deviceUUID[ VK_UUID_SIZE ];
+    uint64_t count;
+};
+
+struct FileEntry
+{
+    uint64_t fingerprint;
+    uint64_t offset;
+    uint64_t size;
+};
+
+auto MakeStagingOffsets( std::span< const uint64_t > sizes, VkDeviceSize& outTotal )
+    -> std::vector< VkDeviceSize >
+{
+    auto offsets = std::vector< VkDeviceSize >{};
+    offsets.reserve( sizes.size() );
+
+    outTotal = 0;
+    for( uint64_t sz : sizes )
+    {
+        offsets.push_back( outTotal );
+        outTotal = RTGL1::Utils::Align( outTotal + sz, SERIALIZED_ALIGN );
+    }
+    return offsets;
+}
+
+void ASBuildToASReadBarrier( VkCommandBuffer cmd )
+{
+    auto barrier = VkMemoryBarrier{
+        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+        .dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR,
+    };
+
+    vkCmdPipelineBarrier( cmd,
+                          VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                          VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                          0,
+                          1,
+                          &barrier,
+                          0,
+                          nullptr,
+                          0,
+                          nullptr );
+}
+
+}
+
+RTGL1::BLASDiskCache::BLASDiskCache( VkDevice                           _device,
+                                     const PhysicalDevice&              _physDevice,
+                                     std::shared_ptr< MemoryAllocator > _allocator )
+    : device{ _device }, allocator{ std::move( _allocator ) }
+{
+    auto id = VkPhysicalDeviceIDProperties{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+        .pNext = nullptr,
+    };
+
+    auto info = VkPhysicalDeviceProperties2{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &id,
+    };
+
+    vkGetPhysicalDeviceProperties2( _physDevice.Get(), &info );
+
+    static_assert( sizeof( deviceUUID ) == sizeof( id.deviceUUID ) );
+    memcpy( deviceUUID, id.deviceUUID, sizeof( deviceUUID ) );
+}
+
+bool RTGL1::BLASDiskCache::TryRecordLoad( VkCommandBuffer           cmd,
+                                          const BLASCacheFile&      file,
+                                          std::span< const Target > targets )
+{
+    assert( !staging.IsInitted() );
+
+    if( targets.empty() )
+    {
+        return false;
+    }
+
+    auto f = std::ifstream( file.path, std::ios::binary );
+    if( !f )
+    {
+        return false;
+    }
+
+    auto header = FileHeader{};
+    f.read( reinterpret_cast< char* >( &header ), sizeof( header ) );
+
+    if( !f || memcmp( header.magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) ) != 0 ||
+        header.version != CACHE_VERSION || header.key != file.key ||
+        memcmp( header.deviceUUID, deviceUUID, sizeof( deviceUUID ) ) != 0 ||
+        header.count != targets.size() )
+    {
+        debug::Info( "BLAS cache is outdated: {}", file.path.string() );
+        return false;
+    }
+
+    auto entries = std::vector< FileEntry >( targets.size() );
+    f.read( reinterpret_cast< char* >( entries.data() ), entries.size() * sizeof( FileEntry ) );
+    if( !f )
+    {
+        return false;
+    }
+
+    auto sizes = std::vector< uint64_t >{};
+    sizes.reserve( entries.size() );
+    for( size_t i = 0; i < entries.size(); i++ )
+    {
+        if( entries[ i ].fingerprint != targets[ i ].fingerprint ||
+            entries[ i ].size < SERIALIZED_HEADER_SIZE )
+        {
+            debug::Info( "BLAS cache is outdated: {}", file.path.string() );
+            return false;
+        }
+        sizes.push_back( entries[ i ].size );
+    }
+
+    VkDeviceSize totalSize = 0;
+    const auto   offsets   = MakeStagingOffsets( sizes, totalSize );
+
+    staging.Init( *allocator,
+                  totalSize,
+                  VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+                      VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  "BLAS cache staging" );
+
+    bool valid = true;
+    {
+        auto mapped = static_cast< uint8_t* >( staging.Map() );
+
+        for( size_t i = 0; i < entries.size(); i++ )
+        {
+            uint8_t* dst = mapped + offsets[ i ];
+
+            f.seekg( static_cast< std::streamoff >( entries[ i ].offset ) );
+            f.read( reinterpret_cast< char* >( dst ),
+                    static_cast< std::streamsize >( entries[ i ].size ) );
+            if( !f )
+            {
+                valid = false;
+                break;
+            }
+
+            // version data is the two UUIDs at the start
+            auto versionInfo = VkAccelerationStructureVersionInfoKHR{
+                .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_VERSION_INFO_KHR,
+                .pVersionData = dst,
+            };
+
+            auto compatibility = VK_ACCELERATION_STRUCTURE_COMPATIBILITY_INCOMPATIBLE_KHR;
+            svkGetDeviceAccelerationStructureCompatibilityKHR(
+                device, &versionInfo, &compatibility );
+
+            if( compatibility != VK_ACCELERATION_STRUCTURE_COMPATIBILITY_COMPATIBLE_KHR )
+            {
+                debug::Info( "BLAS cache is incompatible with the current driver: {}",
+                             file.path.string() );
+                valid = false;
+                break;
+            }
+
+            // destination is created for a regular build, so it must fit
+            uint64_t deserializedSize = 0;
+            memcpy( &deserializedSize, dst + DESERIALIZED_SIZE_OFFSET, sizeof( uint64_t ) );
+
+            if( deserializedSize > targets[ i ].blas->GetASSize() )
+            {
+                valid = false;
+                break;
+            }
+        }
+
+        staging.Unmap();
+    }
+
+    if( !valid )
+    {
+        staging.Destroy();
+        return false;
+    }
+
+    {
+        auto label = CmdLabel{ cmd, "Deserialize BLAS" };
+
+        const VkDeviceAddress base = staging.GetAddress();
+
+        for( size_t i = 0; i < targets.size(); i++ )
+        {
+            auto copyInfo = VkCopyMemoryToAccelerationStructureInfoKHR{
+                .sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_ACCELERATION_STRUCTURE_INFO_KHR,
+                .src   = { .deviceAddress = base + offsets[ i ] },
+                .dst   = targets[ i ].blas->GetAS(),
+                .mode  = VK_COPY_ACCELERATION_STRUCTURE_MODE_DESERIALIZE_KHR,
+            };
+
+            svkCmdCopyMemoryToAccelerationStructureKHR( cmd, &copyInfo );
+        }
+    }
+
+    debug::Info( "Loaded {} BLAS-es from cache: {}", targets.size(), file.path.string() );
+    return true;
+}
+
+void RTGL1::BLASDiskCache::FreeStaging()
+{
+    staging.Destroy();
+}
+
+void RTGL1::BLASDiskCache::Save( CommandBufferManager&     cmdManager,
+                                 VkFence                   fence,
+                                 const BLASCacheFile&      file,
+                                 std::span< const Target > targets )
+{
+    if( targets.empty() )
+    {
+        return;
+    }
+
+    auto handles = std::vector< VkAccelerationStructureKHR >{};
+    handles.reserve( targets.size() );
+    for( const auto& t : targets )
+    {
+        handles.push_back( t.blas->GetAS() );
+    }
+
+    auto sizes = std::vector< uint64_t >( targets.size() );
+    {
+        auto poolInfo = VkQueryPoolCreateInfo{
+            .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+            .queryType  = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_SERIALIZATION_SIZE_KHR,
+            .queryCount = static_cast< uint32_t >( targets.size() ),
+        };
+
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        VkResult    r         = vkCreateQueryPool( device, &poolInfo, nullptr, &queryPool );
+        VK_CHECKERROR( r );
+
+        SET_DEBUG_NAME( device, queryPool, VK_OBJECT_TYPE_QUERY_POOL, "BLAS serialization sizes" );
+
+        VkCommandBuffer cmd = cmdManager.StartGraphicsCmd();
+        {
+            vkCmdResetQueryPool( cmd, queryPool, 0, poolInfo.queryCount );
+
+            ASBuildToASReadBarrier( cmd );
+
+            svkCmdWriteAccelerationStructuresPropertiesKHR(
+                cmd,
+                static_cast< uint32_t >( handles.size() ),
+                handles.data(),
+                VK_QUERY_TYPE_ACCELERATION_STRUCTURE_SERIALIZATION_SIZE_KHR,
+                queryPool,
+                0 );
+        }
+        cmdManager.Submit( cmd, fence );
+        Utils::WaitAndResetFence( device, fence );
+
+        r = vkGetQueryPoolResults( device,
+                                   queryPool,
+                                   0,
+                                   poolInfo.queryCount,
+                                   sizes.size() * sizeof( uint64_t ),
+                                   sizes.data(),
+                                   sizeof( uint64_t ),
+                                   VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT );
+        VK_CHECKERROR( r );
+
+        vkDestroyQueryPool( device, queryPool, nullptr );
+    }
+
+    if( std::ranges::any_of( sizes, []( uint64_t sz ) { return sz < SERIALIZED_HEADER_SIZE; } ) )
+    {
+        debug::Warning( "BLAS cache was not saved: got invalid serialization size" );
+        return;
+    }
+
+    VkDeviceSize totalSize = 0;
+    const auto   offsets   = MakeStagingOffsets( sizes, totalSize );
+
+    auto readback = Buffer{};
+    readback.Init( *allocator,
+                   totalSize,
+                   VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                   "BLAS cache readback" );
+    {
+        VkCommandBuffer cmd = cmdManager.StartGraphicsCmd();
+        {
+            auto label = CmdLabel{ cmd, "Serialize BLAS" };
+
+            const VkDeviceAddress base = readback.GetAddress();
+
+            for( size_t i = 0; i < targets.size(); i++ )
+            {
+                auto copyInfo = VkCopyAccelerationStructureToMemoryInfoKHR{
+                    .sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_TO_MEMORY_INFO_KHR,
+                    .src   = handles[ i ],
+                    .dst   = { .deviceAddress = base + offsets[ i ] },
+                    .mode  = VK_COPY_ACCELERATION_STRUCTURE_MODE_SERIALIZE_KHR,
+                };
+
+                svkCmdCopyAccelerationStructureToMemoryKHR( cmd, &copyInfo );
+            }
+        }
+        cmdManager.Submit( cmd, fence );
+        Utils::WaitAndResetFence( device, fence );
+    }
+
+    auto f = std::ofstream( file.path, std::ios::binary | std::ios::trunc );
+    if( !f )
+    {
+        debug::Warning( "Can't write BLAS cache: {}", file.path.string() );
+        return;
+    }
+
+    auto header = FileHeader{
+        .version = CACHE_VERSION,
+        .key     = file.key,
+        .count   = targets.size(),
+    };
+    memcpy( header.magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) );
+    memcpy( header.deviceUUID, deviceUUID, sizeof( deviceUUID ) );
+
+    auto entries = std::vector< FileEntry >{};
+    entries.reserve( targets.size() );
+    {
+        uint64_t fileOffset = sizeof( FileHeader ) + targets.size() * sizeof( FileEntry );
+        for( size_t i = 0; i < targets.size(); i++ )
+        {
+            entries.push_back( FileEntry{
+                .fingerprint = targets[ i ].fingerprint,
+                .offset      = fileOffset,
+                .size        = sizes[ i ],
+            } );
+            fileOffset += sizes[ i ];
+        }
+    }
+
+    f.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    f.write( reinterpret_cast< const char* >( entries.data() ),
+             entries.size() * sizeof( FileEntry ) );
+    {
+        auto mapped = static_cast< const uint8_t* >( readback.Map() );
+        for( size_t i = 0; i < targets.size(); i++ )
+        {
+            f.write( reinterpret_cast< const char* >( mapped + offsets[ i ] ),
+                     static_cast< std::streamsize >( sizes[ i ] ) );
+        }
+        readback.Unmap();
+    }
+
+    if( !f )
+    {
+        debug::Warning( "Can't write BLAS cache: {}", file.path.string() );
+        return;
+    }
+
+    debug::Info( "Saved {} BLAS-es to cache: {}", targets.size(), file.path.string() );
+}
@@ -0,0 +1,86 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ASComponent.h"
+#include "Buffer.h"
+#include "CommandBufferManager.h"
+#include "PhysicalDevice.h"
+
+#include <filesystem>
+#include <span>
+
+namespace RTGL1
+{
+
+// Location and identity of the serialized BLAS-es of a scene.
+// Key must change, if the source data of the BLAS-es is changed
+struct BLASCacheFile
+{
+    std::filesystem::path path;
+    uint64_t              key;
+};
+
+// Serialized static BLAS-es on disk, so they can be deserialized on the next load
+// instead of being built. Valid only for the same device and a compatible driver
+class BLASDiskCache
+{
+public:
+    BLASDiskCache( VkDevice                           device,
+                   const PhysicalDevice&              physDevice,
+                   std::shared_ptr< MemoryAllocator > allocator );
+    ~BLASDiskCache() = default;
+
+    BLASDiskCache( const BLASDiskCache& other )                = delete;
+    BLASDiskCache( BLASDiskCache&& other ) noexcept            = delete;
+    BLASDiskCache& operator=( const BLASDiskCache& other )     = delete;
+    BLASDiskCache& operator=( BLASDiskCache&& other ) noexcept = delete;
+
+    struct Target
+    {
+        BLASComponent* blas;
+        // to reject the file, if the BLAS-es were made from different geometry
+        uint64_t       fingerprint;
+    };
+
+    // If all targets can be restored from the file, record deserialization to 'cmd' and
+    // return true; the BLAS-es must not be built then. Staging data must be alive until
+    // 'cmd' is completed, see FreeStaging
+    bool TryRecordLoad( VkCommandBuffer           cmd,
+                        const BLASCacheFile&      file,
+                        std::span< const Target > targets );
+    void FreeStaging();
+
+    // Targets must be already built. Waits on CPU for the serialization
+    void Save( CommandBufferManager&     cmdManager,
+               VkFence                   fence,
+               const BLASCacheFile&      file,
+               std::span< const Target > targets );
+
+private:
+    VkDevice                           device;
+    std::shared_ptr< MemoryAllocator > allocator;
+    uint8_t                            deviceUUID[ VK_UUID_SIZE ]{};
+
+    Buffer staging;
+};
+
+}
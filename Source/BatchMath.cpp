@@ -0,0 +1,342 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BatchMath.h"
+
+#include "Utils.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #define RG_BATCH_SSE2 1
+    #include <emmintrin.h>
+#elif defined( __aarch64__ ) || defined( _M_ARM64 )
+    #define RG_BATCH_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace
+{
+
+#if RG_BATCH_SSE2
+
+// 4 normals in SoA, the same steps as Utils::PackNormal
+__m128i PackNormals4( __m128 x, __m128 y, __m128 z )
+{
+    const __m128 zero    = _mm_setzero_ps();
+    const __m128 one     = _mm_set1_ps( 1.0f );
+    const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7FFFFFFF ) );
+
+    auto select = []( __m128 mask, __m128 a, __m128 b ) {
+        return _mm_or_ps( _mm_and_ps( mask, a ), _mm_andnot_ps( mask, b ) );
+    };
+
+    // TryNormalize
+    {
+        __m128 sq    = _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) );
+        __m128 len   = _mm_sqrt_ps( _mm_add_ps( sq, _mm_mul_ps( z, z ) ) );
+        __m128 valid = _mm_cmpge_ps( len, _mm_set1_ps( 0.001f ) );
+
+        x = select( valid, _mm_div_ps( x, len ), x );
+        y = select( valid, _mm_div_ps( y, len ), y );
+        z = select( valid, _mm_div_ps( z, len ), z );
+    }
+
+    // vec3_to_oct
+    __m128 ax = _mm_and_ps( x, absMask );
+    __m128 ay = _mm_and_ps( y, absMask );
+    __m128 az = _mm_and_ps( z, absMask );
+    {
+        __m128 ab    = _mm_add_ps( _mm_add_ps( ax, ay ), az );
+        __m128 valid = _mm_cmpgt_ps( ab, _mm_set1_ps( 0.000001f ) );
+
+        x  = select( valid, _mm_div_ps( x, ab ), x );
+        y  = select( valid, _mm_div_ps( y, ab ), y );
+        z  = select( valid, _mm_div_ps( z, ab ), z );
+        ax = _mm_and_ps( x, absMask );
+        ay = _mm_and_ps( y, absMask );
+    }
+
+    // signNotZero
+    __m128 sx = select( _mm_cmplt_ps( x, zero ), _mm_set1_ps( -1.0f ), one );
+    __m128 sy = select( _mm_cmplt_ps( y, zero ), _mm_set1_ps( -1.0f ), one );
+
+    __m128 upper = _mm_cmpge_ps( z, zero );
+    __m128 ox    = select( upper, x, _mm_mul_ps( _mm_sub_ps( one, ay ), sx ) );
+    __m128 oy    = select( upper, y, _mm_mul_ps( _mm_sub_ps( one, ax ), sy ) );
+
+    const __m128 half = _mm_set1_ps( 0.5f );
+    ox                = _mm_add_ps( _mm_mul_ps( ox, half ), half );
+    oy                = _mm_add_ps( _mm_mul_ps( oy, half ), half );
+
+    // vec2_to_uint
+    const __m128 maxValue = _mm_set1_ps( 65535.f );
+    ox = _mm_min_ps( _mm_max_ps( _mm_mul_ps( ox, maxValue ), zero ), maxValue );
+    oy = _mm_min_ps( _mm_max_ps( _mm_mul_ps( oy, maxValue ), zero ), maxValue );
+
+    return _mm_or_si128( _mm_cvttps_epi32( ox ), _mm_slli_epi32( _mm_cvttps_epi32( oy ), 16 ) );
+}
+
+#elif RG_BATCH_NEON
+
+uint32x4_t PackNormals4( float32x4_t x, float32x4_t y, float32x4_t z )
+{
+    const float32x4_t zero = vdupq_n_f32( 0.0f );
+    const float32x4_t one  = vdupq_n_f32( 1.0f );
+
+    // TryNormalize
+    {
+        float32x4_t sq    = vaddq_f32( vmulq_f32( x, x ), vmulq_f32( y, y ) );
+        float32x4_t len   = vsqrtq_f32( vaddq_f32( sq, vmulq_f32( z, z ) ) );
+        uint32x4_t  valid = vcgeq_f32( len, vdupq_n_f32( 0.001f ) );
+
+        x = vbslq_f32( valid, vdivq_f32( x, len ), x );
+        y = vbslq_f32( valid, vdivq_f32( y, len ), y );
+        z = vbslq_f32( valid, vdivq_f32( z, len ), z );
+    }
+
+    // vec3_to_oct
+    {
+        float32x4_t ab = vaddq_f32( vaddq_f32( vabsq_f32( x ), vabsq_f32( y ) ), vabsq_f32( z ) );
+        uint32x4_t  valid = vcgtq_f32( ab, vdupq_n_f32( 0.000001f ) );
+
+        x = vbslq_f32( valid, vdivq_f32( x, ab ), x );
+        y = vbslq_f32( valid, vdivq_f32( y, ab ), y );
+        z = vbslq_f32( valid, vdivq_f32( z, ab ), z );
+    }
+
+    // signNotZero
+    float32x4_t sx = vbslq_f32( vcltq_f32( x, zero ), vdupq_n_f32( -1.0f ), one );
+    float32x4_t sy = vbslq_f32( vcltq_f32( y, zero ), vdupq_n_f32( -1.0f ), one );
+
+    uint32x4_t  upper = vcgeq_f32( z, zero );
+    float32x4_t ox    = vbslq_f32( upper, x, vmulq_f32( vsubq_f32( one, vabsq_f32( y ) ), sx ) );
+    float32x4_t oy    = vbslq_f32( upper, y, vmulq_f32( vsubq_f32( one, vabsq_f32( x ) ), sy ) );
+
+    const float32x4_t half = vdupq_n_f32( 0.5f );
+    ox                     = vaddq_f32( vmulq_f32( ox, half ), half );
+    oy                     = vaddq_f32( vmulq_f32( oy, half ), half );
+
+    // vec2_to_uint
+    const float32x4_t maxValue = vdupq_n_f32( 65535.f );
+    ox = vminq_f32( vmaxq_f32( vmulq_f32( ox, maxValue ), zero ), maxValue );
+    oy = vminq_f32( vmaxq_f32( vmulq_f32( oy, maxValue ), zero ), maxValue );
+
+    return vorrq_u32( vcvtq_u32_f32( ox ), vshlq_n_u32( vcvtq_u32_f32( oy ), 16 ) );
+}
+
+#endif
+
+}
+
+void RTGL1::BatchMath::PackNormals( const RgFloat3D*  src,
+                                    size_t            count,
+                                    RgNormalPacked32* dst,
+                                    size_t            dstStride )
+{
+    auto dstAt = [ dst, dstStride ]( size_t i ) -> RgNormalPacked32& {
+        return *reinterpret_cast< RgNormalPacked32* >( reinterpret_cast< uint8_t* >( dst ) +
+                                                       i * dstStride );
+    };
+
+    size_t i = 0;
+
+#if RG_BATCH_SSE2 || RG_BATCH_NEON
+    for( ; i + 4 <= count; i += 4 )
+    {
+        const RgFloat3D* s = &src[ i ];
+
+        alignas( 16 ) uint32_t packed[ 4 ];
+    #if RG_BATCH_SSE2
+        auto component = [ s ]( int c ) {
+            return _mm_setr_ps(
+                s[ 0 ].data[ c ], s[ 1 ].data[ c ], s[ 2 ].data[ c ], s[ 3 ].data[ c ] );
+        };
+        _mm_store_si128( reinterpret_cast< __m128i* >( packed ),
+                         PackNormals4( component( 0 ), component( 1 ), component( 2 ) ) );
+    #else
+        float32x4x3_t xyz = vld3q_f32( s[ 0 ].data );
+        vst1q_u32( packed, PackNormals4( xyz.val[ 0 ], xyz.val[ 1 ], xyz.val[ 2 ] ) );
+    #endif
+
+        dstAt( i + 0 ) = packed[ 0 ];
+        dstAt( i + 1 ) = packed[ 1 ];
+        dstAt( i + 2 ) = packed[ 2 ];
+        dstAt( i + 3 ) = packed[ 3 ];
+    }
+#endif
+
+    for( ; i < count; i++ )
+    {
+        dstAt( i ) = Utils::PackNormal( src[ i ] );
+    }
+}
+
+void RTGL1::BatchMath::ToVkTransforms( const RgTransform*    src,
+                                       size_t                count,
+                                       VkTransformMatrixKHR* dst )
+{
+    // both are row-major 3x4
+    static_assert( sizeof( RgTransform ) == sizeof( VkTransformMatrixKHR ) );
+    static_assert( sizeof( RgTransform::matrix ) == sizeof( VkTransformMatrixKHR::matrix ) );
+
+    if( count > 0 )
+    {
+        memcpy( dst, src, count * sizeof( RgTransform ) );
+    }
+}
+
+auto RTGL1::BatchMath::ComputeBounds( const RgPrimitiveVertex* vertices, size_t count ) -> Bounds
+{
+#if RG_BATCH_SSE2 || RG_BATCH_NEON
+    // position is followed by other members, so 4 floats can be loaded; the 4th is ignored
+    static_assert( offsetof( RgPrimitiveVertex, position ) + 4 * sizeof( float ) <=
+                   sizeof( RgPrimitiveVertex ) );
+
+    alignas( 16 ) float mn[ 4 ];
+    alignas( 16 ) float mx[ 4 ];
+
+    #if RG_BATCH_SSE2
+    __m128 vmin = _mm_set1_ps( FLT_MAX );
+    __m128 vmax = _mm_set1_ps( -FLT_MAX );
+    for( size_t v = 0; v < count; v++ )
+    {
+        __m128 p = _mm_loadu_ps( vertices[ v ].position );
+        vmin     = _mm_min_ps( vmin, p );
+        vmax     = _mm_max_ps( vmax, p );
+    }
+    _mm_store_ps( mn, vmin );
+    _mm_store_ps( mx, vmax );
+    #else
+    float32x4_t vmin = vdupq_n_f32( FLT_MAX );
+    float32x4_t vmax = vdupq_n_f32( -FLT_MAX );
+    for( size_t v = 0; v < count; v++ )
+    {
+        float32x4_t p = vld1q_f32( vertices[ v ].position );
+        vmin          = vminq_f32( vmin, p );
+        vmax          = vmaxq_f32( vmax, p );
+    }
+    vst1q_f32( mn, vmin );
+    vst1q_f32( mx, vmax );
+    #endif
+
+    return Bounds{
+        .min = { mn[ 0 ], mn[ 1 ], mn[ 2 ] },
+        .max = { mx[ 0 ], mx[ 1 ], mx[ 2 ] },
+    };
+#else
+    auto b = Bounds{
+        .min = { FLT_MAX, FLT_MAX, FLT_MAX },
+        .max = { -FLT_MAX, -FLT_MAX, -FLT_MAX },
+    };
+    for( size_t v = 0; v < count; v++ )
+    {
+        for( int i = 0; i < 3; i++ )
+        {
+            b.min[ i ] = std::min( b.min[ i ], vertices[ v ].position[ i ] );
+            b.max[ i ] = std::max( b.max[ i ], vertices[ v ].position[ i ] );
+        }
+    }
+    return b;
+#endif
+}
+
+auto RTGL1::BatchMath::TransformBoundsUnion( const RgTransform* transforms,
+                                             size_t             count,
+                                             const Bounds&      local ) -> Bounds
+{
+    const float c[] = {
+        ( local.min[ 0 ] + local.max[ 0 ] ) * 0.5f,
+        ( local.min[ 1 ] + local.max[ 1 ] ) * 0.5f,
+        ( local.min[ 2 ] + local.max[ 2 ] ) * 0.5f,
+    };
+    const float e[] = {
+        ( local.max[ 0 ] - local.min[ 0 ] ) * 0.5f,
+        ( local.max[ 1 ] - local.min[ 1 ] ) * 0.5f,
+        ( local.max[ 2 ] - local.min[ 2 ] ) * 0.5f,
+    };
+
+#if RG_BATCH_SSE2
+    const __m128 absMask = _mm_castsi128_ps( _mm_set1_epi32( 0x7FFFFFFF ) );
+    const __m128 cx      = _mm_set1_ps( c[ 0 ] );
+    const __m128 cy      = _mm_set1_ps( c[ 1 ] );
+    const __m128 cz      = _mm_set1_ps( c[ 2 ] );
+    const __m128 ex      = _mm_set1_ps( e[ 0 ] );
+    const __m128 ey      = _mm_set1_ps( e[ 1 ] );
+    const __m128 ez      = _mm_set1_ps( e[ 2 ] );
+
+    __m128 vmin = _mm_set1_ps( FLT_MAX );
+    __m128 vmax = _mm_set1_ps( -FLT_MAX );
+
+    for( size_t t = 0; t < count; t++ )
+    {
+        const auto& m = transforms[ t ].matrix;
+
+        // columns of the 3x4 matrix, so each lane is a row
+        __m128 col0 = _mm_setr_ps( m[ 0 ][ 0 ], m[ 1 ][ 0 ], m[ 2 ][ 0 ], 0 );
+        __m128 col1 = _mm_setr_ps( m[ 0 ][ 1 ], m[ 1 ][ 1 ], m[ 2 ][ 1 ], 0 );
+        __m128 col2 = _mm_setr_ps( m[ 0 ][ 2 ], m[ 1 ][ 2 ], m[ 2 ][ 2 ], 0 );
+        __m128 col3 = _mm_setr_ps( m[ 0 ][ 3 ], m[ 1 ][ 3 ], m[ 2 ][ 3 ], 0 );
+
+        __m128 center = _mm_add_ps( _mm_add_ps( _mm_mul_ps( col0, cx ), _mm_mul_ps( col1, cy ) ),
+                                    _mm_add_ps( _mm_mul_ps( col2, cz ), col3 ) );
+        __m128 ext    = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_and_ps( col0, absMask ), ex ),
+                                             _mm_mul_ps( _mm_and_ps( col1, absMask ), ey ) ),
+                                 _mm_mul_ps( _mm_and_ps( col2, absMask ), ez ) );
+
+        vmin = _mm_min_ps( vmin, _mm_sub_ps( center, ext ) );
+        vmax = _mm_max_ps( vmax, _mm_add_ps( center, ext ) );
+    }
+
+    alignas( 16 ) float mn[ 4 ];
+    alignas( 16 ) float mx[ 4 ];
+    _mm_store_ps( mn, vmin );
+    _mm_store_ps( mx, vmax );
+
+    return Bounds{
+        .min = { mn[ 0 ], mn[ 1 ], mn[ 2 ] },
+        .max = { mx[ 0 ], mx[ 1 ], mx[ 2 ] },
+    };
+#else
+    auto b = Bounds{
+        .min = { FLT_MAX, FLT_MAX, FLT_MAX },
+        .max = { -FLT_MAX, -FLT_MAX, -FLT_MAX },
+    };
+    for( size_t t = 0; t < count; t++ )
+    {
+        const auto& m = transforms[ t ].matrix;
+
+        for( int i = 0; i < 3; i++ )
+        {
+            float center = m[ i ][ 0 ] * c[ 0 ] + m[ i ][ 1 ] * c[ 1 ] + m[ i ][ 2 ] * c[ 2 ] +
+                           m[ i ][ 3 ];
+            float ext = std::abs( m[ i ][ 0 ] ) * e[ 0 ] + std::abs( m[ i ][ 1 ] ) * e[ 1 ] +
+                        std::abs( m[ i ][ 2 ] ) * e[ 2 ];
+
+            b.min[ i ] = std::min( b.min[ i ], center - ext );
+            b.max[ i ] = std::max( b.max[ i ], center + ext );
+        }
+    }
+    return b;
+#endif
+}
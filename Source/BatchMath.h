@@ -0,0 +1,60 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <RTGL1/RTGL1.h>
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+
+namespace RTGL1
+{
+
+// Functions for arrays, vectorized where the target has SSE2 or NEON.
+// Results must be the same as of the scalar functions in Utils / Matrix
+namespace BatchMath
+{
+    struct Bounds
+    {
+        std::array< float, 3 > min;
+        std::array< float, 3 > max;
+    };
+
+    // Same as Utils::PackNormal for each. 'dstStride' is in bytes,
+    // so the packed normals can be written directly into vertices
+    void PackNormals( const RgFloat3D*  src,
+                      size_t            count,
+                      RgNormalPacked32* dst,
+                      size_t            dstStride = sizeof( RgNormalPacked32 ) );
+
+    void ToVkTransforms( const RgTransform* src, size_t count, VkTransformMatrixKHR* dst );
+
+    // AABB of vertex positions. If 'count' is 0, min is FLT_MAX and max is -FLT_MAX
+    auto ComputeBounds( const RgPrimitiveVertex* vertices, size_t count ) -> Bounds;
+
+    // AABB that contains 'local' transformed by each of the transforms
+    auto TransformBoundsUnion( const RgTransform* transforms, size_t count, const Bounds& local )
+        -> Bounds;
+}
+
+}
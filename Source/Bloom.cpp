@@ -21,6 +21,7 @@
 #include "Bloom.h"
 
 #include "CmdLabel.h"
+#include "FramebufferGraph.h"
 #include "RenderResolutionHelper.h"
 #include "TextureManager.h"
 #include "Utils.h"
@@ -48,9 +49,33 @@ VkPipelineLayout CreatePipelineLayout( VkDevice                           device
 
     return layout;
 }
+
+// enough for the tiles of levels 2..7, if upscaled resolution is up to 16384x16384
+constexpr uint32_t BLOOM_MAX_TILE_COUNTERS = 32768;
+
+[[maybe_unused]] uint32_t GetTileCounterCount( uint32_t upscaledWidth, uint32_t upscaledHeight )
+{
+    using namespace RTGL1;
+
+    constexpr FramebufferImageIndex levelsWithCounter[] = {
+        FB_IMAGE_INDEX_BLOOM_MIP2, FB_IMAGE_INDEX_BLOOM_MIP3, FB_IMAGE_INDEX_BLOOM_MIP4,
+        FB_IMAGE_INDEX_BLOOM_MIP5, FB_IMAGE_INDEX_BLOOM_MIP6, FB_IMAGE_INDEX_BLOOM_MIP7,
+    };
+
+    uint32_t count = 0;
+    for( FramebufferImageIndex level : levelsWithCounter )
+    {
+        VkExtent2D sz = Bloom::MakeSize( upscaledWidth, upscaledHeight, level );
+
+        count += Utils::GetWorkGroupCount( sz.width, COMPUTE_BLOOM_DOWNSAMPLE_GROUP_SIZE_X ) *
+                 Utils::GetWorkGroupCount( sz.height, COMPUTE_BLOOM_DOWNSAMPLE_GROUP_SIZE_Y );
+    }
+    return count;
+}
 }
 
 RTGL1::Bloom::Bloom( VkDevice                        _device,
+                     MemoryAllocator&                _allocator,
                      std::shared_ptr< Framebuffers > _framebuffers,
                      const ShaderManager&            _shaderManager,
                      const GlobalUniform&            _uniform,
@@ -58,18 +83,31 @@ RTGL1::Bloom::Bloom( VkDevice                        _device,
                      const Tonemapping&              _tonemapping )
     : device( _device )
     , framebuffers( std::move( _framebuffers ) )
+    , countersCleared( false )
+    , descPool( VK_NULL_HANDLE )
+    , descSetLayout( VK_NULL_HANDLE )
+    , descSet( VK_NULL_HANDLE )
     , pipelineLayout( VK_NULL_HANDLE )
-    , downsamplePipelines{}
+    , downsamplePipeline( VK_NULL_HANDLE )
     , upsamplePipelines{}
     , preloadPipelines{}
     , applyPipelines{}
 {
+    counters.Init( _allocator,
+                   BLOOM_MAX_TILE_COUNTERS * sizeof( uint32_t ),
+                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                   "Bloom downsample counters" );
+
+    CreateDescriptors();
+
     {
         VkDescriptorSetLayout setLayouts[] = {
             framebuffers->GetDescSetLayout(),
             _uniform.GetDescSetLayout(),
             _tonemapping.GetDescSetLayout(),
             _textureManager.GetDescSetLayout(),
+            descSetLayout,
         };
         pipelineLayout = CreatePipelineLayout( device, setLayouts, "Bloom layout" );
     }
@@ -82,6 +120,81 @@ RTGL1::Bloom::~Bloom()
 {
     vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
     DestroyPipelines();
+    vkDestroyDescriptorPool( device, descPool, nullptr );
+    vkDestroyDescriptorSetLayout( device, descSetLayout, nullptr );
+}
+
+void RTGL1::Bloom::CreateDescriptors()
+{
+    VkResult r;
+
+    {
+        auto binding = VkDescriptorSetLayoutBinding{
+            .binding         = BINDING_BLOOM_DOWNSAMPLE_COUNTERS,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        };
+
+        auto info = VkDescriptorSetLayoutCreateInfo{
+            .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .bindingCount = 1,
+            .pBindings    = &binding,
+        };
+
+        r = vkCreateDescriptorSetLayout( device, &info, nullptr, &descSetLayout );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME(
+            device, descSetLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "Bloom Desc set layout" );
+    }
+    {
+        auto poolSize = VkDescriptorPoolSize{
+            .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+        };
+
+        auto info = VkDescriptorPoolCreateInfo{
+            .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets       = 1,
+            .poolSizeCount = 1,
+            .pPoolSizes    = &poolSize,
+        };
+
+        r = vkCreateDescriptorPool( device, &info, nullptr, &descPool );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device, descPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Bloom Desc pool" );
+    }
+    {
+        auto info = VkDescriptorSetAllocateInfo{
+            .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool     = descPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts        = &descSetLayout,
+        };
+
+        r = vkAllocateDescriptorSets( device, &info, &descSet );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device, descSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Bloom Desc set" );
+    }
+    {
+        auto bufInfo = VkDescriptorBufferInfo{
+            .buffer = counters.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        };
+
+        auto wrt = VkWriteDescriptorSet{
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_BLOOM_DOWNSAMPLE_COUNTERS,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufInfo,
+        };
+
+        vkUpdateDescriptorSets( device, 1, &wrt, 0, nullptr );
+    }
 }
 
 RTGL1::FramebufferImageIndex RTGL1::Bloom::Apply( VkCommandBuffer       cmd,
@@ -95,20 +208,9 @@ RTGL1::FramebufferImageIndex RTGL1::Bloom::Apply( VkCommandBuffer       cmd,
 {
     auto blabel = CmdLabel{ cmd, "Bloom" };
 
-    // SHIPPING_HACK - this barrier is too strict, but at some point,
-    //                 there were bugs with incorrect sync between bloom passes
-    auto memoryBarrier = VkMemoryBarrier2KHR{
-        .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR,
-        .srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
-        .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
-        .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
-        .dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT_KHR | VK_ACCESS_2_SHADER_READ_BIT_KHR,
-    };
-    auto dependencyInfo = VkDependencyInfoKHR{
-        .sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
-        .memoryBarrierCount = 1,
-        .pMemoryBarriers    = &memoryBarrier,
-    };
+    // upsample passes also read their destination, which was written by the downsample,
+    // so the barriers are generated from the declared reads and writes of each pass
+    auto graph = FramebufferGraph{ cmd, frameIndex, *framebuffers };
 
     // bind desc sets
     VkDescriptorSet sets[] = {
@@ -116,6 +218,7 @@ RTGL1::FramebufferImageIndex RTGL1::Bloom::Apply( VkCommandBuffer       cmd,
         uniform.GetDescSet( frameIndex ),
         tonemapping.GetDescSet(),
         textureManager.GetDescSet( frameIndex ),
+        descSet,
     };
 
     vkCmdBindDescriptorSets( cmd,
@@ -128,6 +231,27 @@ RTGL1::FramebufferImageIndex RTGL1::Bloom::Apply( VkCommandBuffer       cmd,
                              nullptr );
 
 
+    if( !countersCleared )
+    {
+        vkCmdFillBuffer( cmd, counters.GetBuffer(), 0, VK_WHOLE_SIZE, 0 );
+
+        auto b = VkMemoryBarrier2KHR{
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+            .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+        };
+        auto dep = VkDependencyInfoKHR{
+            .sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+
+        countersCleared = true;
+    }
+
     {
         const auto src = inputFramebuf;
         const auto dst = FB_IMAGE_INDEX_BLOOM;
@@ -136,51 +260,66 @@ RTGL1::FramebufferImageIndex RTGL1::Bloom::Apply( VkCommandBuffer       cmd,
         assert( src == FB_IMAGE_INDEX_UPSCALED_PING || src == FB_IMAGE_INDEX_UPSCALED_PONG );
         bool isSourcePing = ( src == FB_IMAGE_INDEX_UPSCALED_PING ? 1 : 0 );
 
-        framebuffers->BarrierOne( cmd, frameIndex, src );
+        FramebufferImageIndex reads[]  = { src };
+        FramebufferImageIndex writes[] = { dst };
+        graph.Pass( reads, writes );
 
         vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, preloadPipelines[ isSourcePing ] );
-        vkCmdDispatch( cmd,
-                       Utils::GetWorkGroupCount( sz.width, COMPUTE_BLOOM_APPLY_GROUP_SIZE_X ),
-                       Utils::GetWorkGroupCount( sz.height, COMPUTE_BLOOM_APPLY_GROUP_SIZE_Y ),
-                       1 );
+        Utils::DispatchFullscreen( cmd,
+                                   sz.width,
+                                   sz.height,
+                                   COMPUTE_BLOOM_APPLY_GROUP_SIZE_X,
+                                   COMPUTE_BLOOM_APPLY_GROUP_SIZE_Y );
     }
 
 
-    svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
-
-
-    for( int i = 0; i < COMPUTE_BLOOM_STEP_COUNT; i++ )
+    // all levels in one dispatch, see CmBloomDownsample.comp
     {
         auto label = CmdLabel{ cmd, "Bloom downsample" };
 
-        // clang-format off
-        auto src = FramebufferImageIndex{};
-        auto dst = FramebufferImageIndex{};
-        switch( i )
-        {
-            case 0: src = FB_IMAGE_INDEX_BLOOM;      dst = FB_IMAGE_INDEX_BLOOM_MIP1; break;
-            case 1: src = FB_IMAGE_INDEX_BLOOM_MIP1; dst = FB_IMAGE_INDEX_BLOOM_MIP2; break;
-            case 2: src = FB_IMAGE_INDEX_BLOOM_MIP2; dst = FB_IMAGE_INDEX_BLOOM_MIP3; break;
-            case 3: src = FB_IMAGE_INDEX_BLOOM_MIP3; dst = FB_IMAGE_INDEX_BLOOM_MIP4; break;
-            case 4: src = FB_IMAGE_INDEX_BLOOM_MIP4; dst = FB_IMAGE_INDEX_BLOOM_MIP5; break;
-            case 5: src = FB_IMAGE_INDEX_BLOOM_MIP5; dst = FB_IMAGE_INDEX_BLOOM_MIP6; break;
-            case 6: src = FB_IMAGE_INDEX_BLOOM_MIP6; dst = FB_IMAGE_INDEX_BLOOM_MIP7; break;
-            default: assert( 0 );
-        }
-        // clang-format on
-        const auto sz = MakeSize( upscaledWidth, upscaledHeight, dst );
+        const auto sz = MakeSize( upscaledWidth, upscaledHeight, FB_IMAGE_INDEX_BLOOM_MIP1 );
 
-        framebuffers->BarrierOne( cmd, frameIndex, src );
+        assert( GetTileCounterCount( upscaledWidth, upscaledHeight ) <= BLOOM_MAX_TILE_COUNTERS );
 
-        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, downsamplePipelines[ i ] );
-        vkCmdDispatch( cmd,
-                       Utils::GetWorkGroupCount( sz.width, COMPUTE_BLOOM_DOWNSAMPLE_GROUP_SIZE_X ),
-                       Utils::GetWorkGroupCount( sz.height, COMPUTE_BLOOM_DOWNSAMPLE_GROUP_SIZE_Y ),
-                       1 );
+        FramebufferImageIndex reads[]  = { FB_IMAGE_INDEX_BLOOM };
+        FramebufferImageIndex writes[] = {
+            FB_IMAGE_INDEX_BLOOM_MIP1, FB_IMAGE_INDEX_BLOOM_MIP2, FB_IMAGE_INDEX_BLOOM_MIP3,
+            FB_IMAGE_INDEX_BLOOM_MIP4, FB_IMAGE_INDEX_BLOOM_MIP5, FB_IMAGE_INDEX_BLOOM_MIP6,
+            FB_IMAGE_INDEX_BLOOM_MIP7,
+        };
+        graph.Pass( reads, writes );
+
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, downsamplePipeline );
+        Utils::DispatchFullscreen( cmd,
+                                   sz.width,
+                                   sz.height,
+                                   COMPUTE_BLOOM_DOWNSAMPLE_GROUP_SIZE_X,
+                                   COMPUTE_BLOOM_DOWNSAMPLE_GROUP_SIZE_Y );
     }
 
 
-    svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
+    // makes the reset counters visible to the next frame
+    {
+        auto b = VkBufferMemoryBarrier2KHR{
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+            .srcAccessMask       = VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+            .dstAccessMask =
+                VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = counters.GetBuffer(),
+            .offset              = 0,
+            .size                = VK_WHOLE_SIZE,
+        };
+        auto dep = VkDependencyInfoKHR{
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
 
 
     // start from the other side
@@ -205,42 +344,55 @@ RTGL1::FramebufferImageIndex RTGL1::Bloom::Apply( VkCommandBuffer       cmd,
         // clang-format on
         const auto sz = MakeSize( upscaledWidth, upscaledHeight, dst );
 
-        framebuffers->BarrierOne( cmd, frameIndex, src );
+        // levels except the last one accumulate into the downsampled values
+        FramebufferImageIndex reads[]  = { src };
+        FramebufferImageIndex writes[] = { dst };
+        graph.Pass( reads, writes );
 
         vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, upsamplePipelines[ i ] );
-        vkCmdDispatch( cmd,
-                       Utils::GetWorkGroupCount( sz.width, COMPUTE_BLOOM_UPSAMPLE_GROUP_SIZE_X ),
-                       Utils::GetWorkGroupCount( sz.height, COMPUTE_BLOOM_UPSAMPLE_GROUP_SIZE_Y ),
-                       1 );
+        Utils::DispatchFullscreen( cmd,
+                                   sz.width,
+                                   sz.height,
+                                   COMPUTE_BLOOM_UPSAMPLE_GROUP_SIZE_X,
+                                   COMPUTE_BLOOM_UPSAMPLE_GROUP_SIZE_Y );
     }
 
 
-    svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
-
-
     FramebufferImageIndex result;
     {
         uint32_t isSourcePing = ( inputFramebuf == FB_IMAGE_INDEX_UPSCALED_PING ? 1 : 0 );
 
         vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, applyPipelines[ isSourcePing ] );
 
-        FramebufferImageIndex fs[] = {
+        result = isSourcePing ? FB_IMAGE_INDEX_UPSCALED_PONG : FB_IMAGE_INDEX_UPSCALED_PING;
+
+        FramebufferImageIndex reads[] = {
             inputFramebuf,
             FB_IMAGE_INDEX_BLOOM,
+            FB_IMAGE_INDEX_BLOOM_MIP7,
         };
-        framebuffers->BarrierMultiple( cmd, frameIndex, fs );
-
-        vkCmdDispatch( cmd,
-                       Utils::GetWorkGroupCount( upscaledWidth, COMPUTE_BLOOM_APPLY_GROUP_SIZE_X ),
-                       Utils::GetWorkGroupCount( upscaledHeight, COMPUTE_BLOOM_APPLY_GROUP_SIZE_Y ),
-                       1 );
-        result = isSourcePing ? FB_IMAGE_INDEX_UPSCALED_PONG : FB_IMAGE_INDEX_UPSCALED_PING;
+        FramebufferImageIndex writes[] = { result };
+        graph.Pass( reads, writes );
+
+        Utils::DispatchFullscreen( cmd,
+                                   upscaledWidth,
+                                   upscaledHeight,
+                                   COMPUTE_BLOOM_APPLY_GROUP_SIZE_X,
+                                   COMPUTE_BLOOM_APPLY_GROUP_SIZE_Y );
     }
     return result;
 }
 
 void RTGL1::Bloom::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { "CBloomDownsample",
+                                      "CBloomUpsample",
+                                      "CBloomPreload",
+                                      "CBloomApply" } ) )
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines( shaderManager );
 }
@@ -254,10 +406,28 @@ void RTGL1::Bloom::CreatePipelines( const ShaderManager* shaderManager )
 void RTGL1::Bloom::CreateStepPipelines( const ShaderManager* shaderManager )
 {
     assert( pipelineLayout != VK_NULL_HANDLE );
+    assert( downsamplePipeline == VK_NULL_HANDLE );
+
+    {
+        auto info = VkComputePipelineCreateInfo{
+            .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .stage  = shaderManager->GetStageInfo( "CBloomDownsample" ),
+            .layout = pipelineLayout,
+        };
+
+        VkResult r = vkCreateComputePipelines( device,
+                                               shaderManager->GetPipelineCache(),
+                                               1,
+                                               &info,
+                                               nullptr,
+                                               &downsamplePipeline );
+
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device, downsamplePipeline, VK_OBJECT_TYPE_PIPELINE, "Bloom downsample" );
+    }
 
     for( uint32_t i = 0; i < COMPUTE_BLOOM_STEP_COUNT; i++ )
     {
-        assert( downsamplePipelines[ i ] == VK_NULL_HANDLE );
         assert( upsamplePipelines[ i ] == VK_NULL_HANDLE );
 
         auto specEntry = VkSpecializationMapEntry{
@@ -272,24 +442,6 @@ void RTGL1::Bloom::CreateStepPipelines( const ShaderManager* shaderManager )
             .pData         = &i,
         };
 
-        {
-            auto info = VkComputePipelineCreateInfo{
-                .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-                .stage  = shaderManager->GetStageInfo( "CBloomDownsample" ),
-                .layout = pipelineLayout,
-            };
-            info.stage.pSpecializationInfo = &specInfo;
-
-            VkResult r = vkCreateComputePipelines(
-                device, VK_NULL_HANDLE, 1, &info, nullptr, &downsamplePipelines[ i ] );
-
-            VK_CHECKERROR( r );
-            SET_DEBUG_NAME( device,
-                            downsamplePipelines[ i ],
-                            VK_OBJECT_TYPE_PIPELINE,
-                            std::format( "Bloom downsample ({})", i ).c_str() );
-        }
-
         {
             auto info = VkComputePipelineCreateInfo{
                 .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
@@ -298,8 +450,12 @@ void RTGL1::Bloom::CreateStepPipelines( const ShaderManager* shaderManager )
             };
             info.stage.pSpecializationInfo = &specInfo;
 
-            VkResult r = vkCreateComputePipelines(
-                device, VK_NULL_HANDLE, 1, &info, nullptr, &upsamplePipelines[ i ] );
+            VkResult r = vkCreateComputePipelines( device,
+                                                   shaderManager->GetPipelineCache(),
+                                                   1,
+                                                   &info,
+                                                   nullptr,
+                                                   &upsamplePipelines[ i ] );
 
             VK_CHECKERROR( r );
             SET_DEBUG_NAME( device,
@@ -345,8 +501,12 @@ void RTGL1::Bloom::CreateApplyPipelines( const ShaderManager* shaderManager )
             };
             info.stage.pSpecializationInfo = &specInfo;
 
-            VkResult r = vkCreateComputePipelines(
-                device, VK_NULL_HANDLE, 1, &info, nullptr, &preloadPipelines[ isSourcePing ] );
+            VkResult r = vkCreateComputePipelines( device,
+                                                   shaderManager->GetPipelineCache(),
+                                                   1,
+                                                   &info,
+                                                   nullptr,
+                                                   &preloadPipelines[ isSourcePing ] );
 
             VK_CHECKERROR( r );
             SET_DEBUG_NAME(
@@ -363,8 +523,12 @@ void RTGL1::Bloom::CreateApplyPipelines( const ShaderManager* shaderManager )
             };
             info.stage.pSpecializationInfo = &specInfo;
 
-            VkResult r = vkCreateComputePipelines(
-                device, VK_NULL_HANDLE, 1, &info, nullptr, &applyPipelines[ isSourcePing ] );
+            VkResult r = vkCreateComputePipelines( device,
+                                                   shaderManager->GetPipelineCache(),
+                                                   1,
+                                                   &info,
+                                                   nullptr,
+                                                   &applyPipelines[ isSourcePing ] );
 
             VK_CHECKERROR( r );
             SET_DEBUG_NAME(
@@ -378,11 +542,8 @@ void RTGL1::Bloom::CreateApplyPipelines( const ShaderManager* shaderManager )
 
 void RTGL1::Bloom::DestroyPipelines()
 {
-    for( VkPipeline& p : downsamplePipelines )
-    {
-        vkDestroyPipeline( device, p, nullptr );
-        p = VK_NULL_HANDLE;
-    }
+    vkDestroyPipeline( device, downsamplePipeline, nullptr );
+    downsamplePipeline = VK_NULL_HANDLE;
 
     for( VkPipeline& p : upsamplePipelines )
     {
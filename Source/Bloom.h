@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include "Buffer.h"
 #include "Common.h"
 #include "ShaderManager.h"
 #include "Framebuffers.h"
@@ -38,6 +39,7 @@ class Bloom final : public IShaderDependency
 {
 public:
     Bloom( VkDevice                        device,
+           MemoryAllocator&                allocator,
            std::shared_ptr< Framebuffers > framebuffers,
            const ShaderManager&            shaderManager,
            const GlobalUniform&            uniform,
@@ -66,6 +68,7 @@ public:
                                 FramebufferImageIndex index );
 
 private:
+    void CreateDescriptors();
     void CreatePipelines( const ShaderManager* shaderManager );
     void CreateStepPipelines( const ShaderManager* shaderManager );
     void CreateApplyPipelines( const ShaderManager* shaderManager );
@@ -78,9 +81,17 @@ private:
 
     std::shared_ptr< Framebuffers > framebuffers;
 
+    // per-tile counters of the single pass downsampler,
+    // each is reset to 0 by the shader, so must be cleared only once
+    Buffer                counters;
+    bool                  countersCleared;
+    VkDescriptorPool      descPool;
+    VkDescriptorSetLayout descSetLayout;
+    VkDescriptorSet       descSet;
+
     VkPipelineLayout pipelineLayout;
 
-    VkPipeline downsamplePipelines[ StepCount ];
+    VkPipeline downsamplePipeline;
     VkPipeline upsamplePipelines[ StepCount ];
 
     VkPipeline preloadPipelines[ 2 ];
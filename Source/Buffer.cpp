@@ -40,8 +40,9 @@ VkDeviceSize findCommonAlignment( VkDeviceSize align_0, VkDeviceSize align_1 )
 
 Buffer::Buffer()
     : device( VK_NULL_HANDLE )
+    , allocator( nullptr )
     , buffer( VK_NULL_HANDLE )
-    , memory( VK_NULL_HANDLE )
+    , allocation( VK_NULL_HANDLE )
     , address( 0 )
     , size( 0 )
     , isMapped( false )
@@ -53,7 +54,7 @@ Buffer::~Buffer()
     Destroy();
 }
 
-void Buffer::Init( MemoryAllocator&      allocator,
+void Buffer::Init( MemoryAllocator&      _allocator,
                    VkDeviceSize          bsize,
                    VkBufferUsageFlags    usage,
                    VkMemoryPropertyFlags properties,
@@ -65,7 +66,8 @@ void Buffer::Init( MemoryAllocator&      allocator,
         return;
     }
 
-    device = allocator.GetDevice();
+    device    = _allocator.GetDevice();
+    allocator = &_allocator;
 
     VkResult r;
 
@@ -78,14 +80,7 @@ void Buffer::Init( MemoryAllocator&      allocator,
     r = vkCreateBuffer( device, &bufferInfo, nullptr, &buffer );
     VK_CHECKERROR( r );
 
-    VkMemoryRequirements memReq = {};
-    vkGetBufferMemoryRequirements( device, buffer, &memReq );
-
-    memory = allocator.AllocDedicated(
-        memReq, properties, MemoryAllocator::AllocType::WITH_ADDRESS_QUERY, debugName );
-
-    r = vkBindBufferMemory( device, buffer, memory, 0 );
-    VK_CHECKERROR( r );
+    allocation = allocator->AllocForBuffer( buffer, properties, debugName );
 
     if( bufferInfo.usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT )
     {
@@ -110,19 +105,19 @@ void Buffer::Destroy()
         return;
     }
 
-    // memory is guaranteed to be dedicated
-    if( memory != VK_NULL_HANDLE )
-    {
-        MemoryAllocator::FreeDedicated( device, memory );
-        memory = VK_NULL_HANDLE;
-    }
-
     if( buffer != VK_NULL_HANDLE )
     {
         vkDestroyBuffer( device, buffer, nullptr );
         buffer = VK_NULL_HANDLE;
     }
 
+    if( allocation != VK_NULL_HANDLE )
+    {
+        assert( allocator );
+        allocator->FreeForBuffer( allocation );
+        allocation = VK_NULL_HANDLE;
+    }
+
     address = 0;
     size    = 0;
 }
@@ -131,15 +126,10 @@ void* Buffer::Map()
 {
     assert( device != VK_NULL_HANDLE );
     assert( !isMapped );
-    assert( memory != VK_NULL_HANDLE && size > 0 );
+    assert( allocation != VK_NULL_HANDLE && size > 0 );
 
     isMapped = true;
-    void* mapped;
-
-    VkResult r = vkMapMemory( device, memory, 0, size, 0, &mapped );
-    VK_CHECKERROR( r );
-
-    return mapped;
+    return allocator->MapBufferMemory( allocation );
 }
 
 void Buffer::Unmap()
@@ -147,7 +137,7 @@ void Buffer::Unmap()
     assert( device != VK_NULL_HANDLE );
     assert( isMapped );
     isMapped = false;
-    vkUnmapMemory( device, memory );
+    allocator->UnmapBufferMemory( allocation );
 }
 
 bool Buffer::TryUnmap()
@@ -169,12 +159,6 @@ VkBuffer Buffer::GetBuffer() const
     return buffer;
 }
 
-VkDeviceMemory Buffer::GetMemory() const
-{
-    assert( memory != VK_NULL_HANDLE );
-    return memory;
-}
-
 VkDeviceAddress Buffer::GetAddress() const
 {
     assert( address != 0 );
@@ -195,5 +179,5 @@ bool Buffer::IsMapped() const
 
 bool Buffer::IsInitted() const
 {
-    return buffer != VK_NULL_HANDLE && memory != VK_NULL_HANDLE;
+    return buffer != VK_NULL_HANDLE && allocation != VK_NULL_HANDLE;
 }
@@ -46,7 +46,6 @@ public:
 
 
     VkBuffer        GetBuffer() const;
-    VkDeviceMemory  GetMemory() const;
     // To get address usage flags must contain VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT
     VkDeviceAddress GetAddress() const;
     VkDeviceSize    GetSize() const;
@@ -54,11 +53,13 @@ public:
     bool            IsInitted() const;
 
 protected:
-    VkDevice        device;
-    VkBuffer        buffer;
-    VkDeviceMemory  memory;
-    VkDeviceAddress address;
-    VkDeviceSize    size;
+    VkDevice         device;
+    // not owned, must outlive the buffer
+    MemoryAllocator* allocator;
+    VkBuffer         buffer;
+    VmaAllocation    allocation;
+    VkDeviceAddress  address;
+    VkDeviceSize     size;
 
 private:
     bool isMapped;
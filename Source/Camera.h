@@ -24,6 +24,8 @@ SOFTWARE.
 
 #pragma once
 
+#include "RTGL1/RTGL1.h"
+
 namespace RTGL1
 {
 
@@ -39,4 +41,7 @@ struct Camera
     float cameraFar{ 1000.0f };
 };
 
+// RgCameraInfo::pView is ignored
+Camera MakeCamera( const RgCameraInfo& info );
+
 }
@@ -24,7 +24,7 @@
 RTGL1::CommandBufferManager::CommandBufferManager( VkDevice                  _device,
                                                    std::shared_ptr< Queues > _queues )
     : device( _device )
-    , currentFrameIndex( MAX_FRAMES_IN_FLIGHT - 1 )
+    , currentFrameIndex( FramesInFlight() - 1 )
     , queues( std::move( _queues ) )
 {
     VkCommandPoolCreateInfo cmdPoolInfo = {};
@@ -46,6 +46,13 @@ RTGL1::CommandBufferManager::CommandBufferManager( VkDevice                  _de
         cmdPoolInfo.queueFamilyIndex = queues->GetIndexTransfer();
         r = vkCreateCommandPool( device, &cmdPoolInfo, nullptr, &transferCmds[ i ].pool );
         VK_CHECKERROR( r );
+
+        cmdPoolInfo.queueFamilyIndex = queues->GetIndexGraphics();
+        for( auto& secondary : secondaryCmds[ i ] )
+        {
+            r = vkCreateCommandPool( device, &cmdPoolInfo, nullptr, &secondary.pool );
+            VK_CHECKERROR( r );
+        }
     }
 }
 
@@ -58,6 +65,11 @@ RTGL1::CommandBufferManager::~CommandBufferManager()
         vkDestroyCommandPool( device, graphicsCmds[ i ].pool, nullptr );
         vkDestroyCommandPool( device, computeCmds[ i ].pool, nullptr );
         vkDestroyCommandPool( device, transferCmds[ i ].pool, nullptr );
+
+        for( auto& secondary : secondaryCmds[ i ] )
+        {
+            vkDestroyCommandPool( device, secondary.pool, nullptr );
+        }
     }
 }
 
@@ -73,15 +85,21 @@ void RTGL1::CommandBufferManager::PrepareForFrame( uint32_t frameIndex )
     computeCmds[ frameIndex ].curCount  = 0;
     transferCmds[ frameIndex ].curCount = 0;
 
+    for( auto& secondary : secondaryCmds[ frameIndex ] )
+    {
+        if( secondary.curCount > 0 )
+        {
+            vkResetCommandPool( device, secondary.pool, 0 );
+            secondary.curCount = 0;
+        }
+    }
+
     currentFrameIndex = frameIndex;
 }
 
-VkCommandBuffer RTGL1::CommandBufferManager::StartCmd( uint32_t       frameIndex,
-                                                       AllocatedCmds& allocated,
-                                                       VkQueue        queue )
+VkCommandBuffer RTGL1::CommandBufferManager::AllocateCmd( AllocatedCmds&       allocated,
+                                                          VkCommandBufferLevel level )
 {
-    VkResult r;
-
     size_t oldCount = allocated.cmds.size();
 
     // if not enough, allocate new buffers
@@ -92,22 +110,31 @@ VkCommandBuffer RTGL1::CommandBufferManager::StartCmd( uint32_t       frameIndex
         VkCommandBufferAllocateInfo allocInfo = {};
         allocInfo.sType                       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         allocInfo.commandPool                 = allocated.pool;
-        allocInfo.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.level                       = level;
         allocInfo.commandBufferCount          = cmdAllocStep;
 
-        r = vkAllocateCommandBuffers( device, &allocInfo, &allocated.cmds[ oldCount ] );
+        VkResult r = vkAllocateCommandBuffers( device, &allocInfo, &allocated.cmds[ oldCount ] );
         VK_CHECKERROR( r );
     }
 
     VkCommandBuffer cmd = allocated.cmds[ allocated.curCount ];
     allocated.curCount++;
 
+    return cmd;
+}
+
+VkCommandBuffer RTGL1::CommandBufferManager::StartCmd( uint32_t       frameIndex,
+                                                       AllocatedCmds& allocated,
+                                                       VkQueue        queue )
+{
+    VkCommandBuffer cmd = AllocateCmd( allocated, VK_COMMAND_BUFFER_LEVEL_PRIMARY );
+
     VkCommandBufferBeginInfo beginInfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
         .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
     };
 
-    r = vkBeginCommandBuffer( cmd, &beginInfo );
+    VkResult r = vkBeginCommandBuffer( cmd, &beginInfo );
     VK_CHECKERROR( r );
 
     cmdQueues[ frameIndex ][ cmd ] = queue;
@@ -146,6 +173,71 @@ VkCommandBuffer RTGL1::CommandBufferManager::StartTransferCmd()
         currentFrameIndex, transferCmds[ currentFrameIndex ], queues->GetTransfer() );
 }
 
+VkCommandBuffer RTGL1::CommandBufferManager::StartAsyncComputeCmd()
+{
+    assert( HasAsyncCompute() );
+
+    // same queue family, so the graphics pool can be used
+    return StartCmd(
+        currentFrameIndex, graphicsCmds[ currentFrameIndex ], queues->GetAsyncCompute() );
+}
+
+VkCommandBuffer RTGL1::CommandBufferManager::StartSecondaryGraphicsCmd( uint32_t      workerIndex,
+                                                                        VkRenderPass  renderPass,
+                                                                        VkFramebuffer framebuffer )
+{
+    assert( workerIndex < MAX_RECORD_WORKERS );
+
+    VkCommandBuffer cmd = AllocateCmd( secondaryCmds[ currentFrameIndex ][ workerIndex ],
+                                       VK_COMMAND_BUFFER_LEVEL_SECONDARY );
+
+    VkCommandBufferInheritanceInfo inheritance = {
+        .sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass  = renderPass,
+        .subpass     = 0,
+        .framebuffer = framebuffer,
+    };
+
+    VkCommandBufferBeginInfo beginInfo = {
+        .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+        .pInheritanceInfo = &inheritance,
+    };
+
+    VkResult r = vkBeginCommandBuffer( cmd, &beginInfo );
+    VK_CHECKERROR( r );
+
+    // not added to 'cmdQueues', as secondary cmds are not submitted directly
+    return cmd;
+}
+
+void RTGL1::CommandBufferManager::EndSecondaryCmd( VkCommandBuffer cmd )
+{
+    VkResult r = vkEndCommandBuffer( cmd );
+    VK_CHECKERROR( r );
+}
+
+bool RTGL1::CommandBufferManager::HasAsyncCompute() const
+{
+    return queues->GetAsyncCompute() != VK_NULL_HANDLE;
+}
+
+bool RTGL1::CommandBufferManager::HasDedicatedTransfer() const
+{
+    return queues->GetIndexTransfer() != queues->GetIndexGraphics();
+}
+
+uint32_t RTGL1::CommandBufferManager::GetGraphicsFamily() const
+{
+    return queues->GetIndexGraphics();
+}
+
+uint32_t RTGL1::CommandBufferManager::GetTransferFamily() const
+{
+    return queues->GetIndexTransfer();
+}
+
 void RTGL1::CommandBufferManager::Submit( VkCommandBuffer cmd, VkFence fence )
 {
     VkResult r = vkEndCommandBuffer( cmd );
@@ -197,7 +289,7 @@ void RTGL1::CommandBufferManager::Submit_Binary( VkCommandBuffer          cmd,
         .pWaitDstStageMask    = DefaultStages,
         .commandBufferCount   = 1,
         .pCommandBuffers      = &cmd,
-        .signalSemaphoreCount = 1,
+        .signalSemaphoreCount = signalSemaphore ? 1u : 0u,
         .pSignalSemaphores    = &signalSemaphore,
     };
 
@@ -243,6 +335,68 @@ void RTGL1::CommandBufferManager::Submit_TimelineInternal( VkCommandBuffer
     VK_CHECKERROR( r );
 }
 
+void RTGL1::CommandBufferManager::WaitSemaphoreOnGraphics( VkSemaphore          semaphore,
+                                                           VkPipelineStageFlags waitStages )
+{
+    // a batch without command buffers: its wait also orders
+    // the commands that are submitted later to the queue
+    auto submitInfo = VkSubmitInfo{
+        .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .waitSemaphoreCount = 1,
+        .pWaitSemaphores    = &semaphore,
+        .pWaitDstStageMask  = &waitStages,
+        .commandBufferCount = 0,
+    };
+
+    VkResult r = vkQueueSubmit( queues->GetGraphics(), 1, &submitInfo, VK_NULL_HANDLE );
+    VK_CHECKERROR( r );
+}
+
+void RTGL1::CommandBufferManager::WaitSemaphoreOnGraphics( VkSemaphore timelineSemaphore,
+                                                           uint64_t    waitValue,
+                                                           VkPipelineStageFlags waitStages )
+{
+    auto timelineInfo = VkTimelineSemaphoreSubmitInfo{
+        .sType                   = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount = 1,
+        .pWaitSemaphoreValues    = &waitValue,
+    };
+
+    auto submitInfo = VkSubmitInfo{
+        .sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext              = &timelineInfo,
+        .waitSemaphoreCount = 1,
+        .pWaitSemaphores    = &timelineSemaphore,
+        .pWaitDstStageMask  = &waitStages,
+        .commandBufferCount = 0,
+    };
+
+    VkResult r = vkQueueSubmit( queues->GetGraphics(), 1, &submitInfo, VK_NULL_HANDLE );
+    VK_CHECKERROR( r );
+}
+
+void RTGL1::CommandBufferManager::SignalSemaphoreOnGraphics( VkSemaphore timelineSemaphore,
+                                                             uint64_t    signalValue )
+{
+    auto timelineInfo = VkTimelineSemaphoreSubmitInfo{
+        .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .signalSemaphoreValueCount = 1,
+        .pSignalSemaphoreValues    = &signalValue,
+    };
+
+    // a batch without command buffers: signaled after all previously submitted work
+    auto submitInfo = VkSubmitInfo{
+        .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext                = &timelineInfo,
+        .commandBufferCount   = 0,
+        .signalSemaphoreCount = 1,
+        .pSignalSemaphores    = &timelineSemaphore,
+    };
+
+    VkResult r = vkQueueSubmit( queues->GetGraphics(), 1, &submitInfo, VK_NULL_HANDLE );
+    VK_CHECKERROR( r );
+}
+
 void RTGL1::CommandBufferManager::WaitGraphicsIdle()
 {
     VkResult r = vkQueueWaitIdle( queues->GetGraphics() );
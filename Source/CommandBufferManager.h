@@ -32,6 +32,9 @@ namespace RTGL1
 
 #define SEMAPHORE_IS_BINARY 0
 
+// Max count of threads that record secondary command buffers at once
+constexpr uint32_t MAX_RECORD_WORKERS = 8;
+
 struct ToWait
 {
     VkSemaphore semaphore;
@@ -63,6 +66,21 @@ public:
     VkCommandBuffer       StartComputeCmd();
     // Start transfer command buffer for current frame index
     VkCommandBuffer       StartTransferCmd();
+    // Start command buffer for current frame index, that is submitted
+    // to the second queue of the graphics family. Valid only if HasAsyncCompute()
+    VkCommandBuffer       StartAsyncComputeCmd();
+    // Start secondary command buffer for current frame index, that continues the render pass.
+    // Command pools are externally synchronized, so each thread must use its own 'workerIndex'
+    VkCommandBuffer       StartSecondaryGraphicsCmd( uint32_t      workerIndex,
+                                                     VkRenderPass  renderPass,
+                                                     VkFramebuffer framebuffer );
+    void                  EndSecondaryCmd( VkCommandBuffer cmd );
+    bool                  HasAsyncCompute() const;
+    // If transfer queue is of a different family than graphics,
+    // resources require queue family ownership transfers
+    bool                  HasDedicatedTransfer() const;
+    uint32_t              GetGraphicsFamily() const;
+    uint32_t              GetTransferFamily() const;
 
     void Submit( VkCommandBuffer cmd, VkFence fence = VK_NULL_HANDLE );
     void Submit_Binary( VkCommandBuffer          cmd,
@@ -79,6 +97,15 @@ public:
     void Submit_Timeline(
         VkCommandBuffer cmd, VkFence fence, ToWait towait0, ToWait towait1, ToSignal tosignal );
 
+    // Make all subsequent submissions to the graphics queue
+    // wait for the semaphore at the specified stages
+    void WaitSemaphoreOnGraphics( VkSemaphore semaphore, VkPipelineStageFlags waitStages );
+    void WaitSemaphoreOnGraphics( VkSemaphore          timelineSemaphore,
+                                  uint64_t             waitValue,
+                                  VkPipelineStageFlags waitStages );
+    // Signal the semaphore, when all previous submissions to the graphics queue are complete
+    void SignalSemaphoreOnGraphics( VkSemaphore timelineSemaphore, uint64_t signalValue );
+
     void                  WaitGraphicsIdle();
     void                  WaitComputeIdle();
     void                  WaitTransferIdle();
@@ -94,6 +121,7 @@ private:
 
 private:
     VkCommandBuffer StartCmd( uint32_t frameIndex, AllocatedCmds& cmds, VkQueue queue );
+    VkCommandBuffer AllocateCmd( AllocatedCmds& allocated, VkCommandBufferLevel level );
 
     VkQueue PopQueueOfCmd( VkCommandBuffer cmd );
 
@@ -108,6 +136,8 @@ private:
     AllocatedCmds                                  graphicsCmds[ MAX_FRAMES_IN_FLIGHT ];
     AllocatedCmds                                  computeCmds[ MAX_FRAMES_IN_FLIGHT ];
     AllocatedCmds                                  transferCmds[ MAX_FRAMES_IN_FLIGHT ];
+    // a pool per worker thread, to record render pass contents in parallel
+    AllocatedCmds secondaryCmds[ MAX_FRAMES_IN_FLIGHT ][ MAX_RECORD_WORKERS ];
 
     std::shared_ptr< Queues >                      queues;
     rgl::unordered_map< VkCommandBuffer, VkQueue > cmdQueues[ MAX_FRAMES_IN_FLIGHT ];
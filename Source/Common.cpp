@@ -30,6 +30,11 @@ namespace RTGL1
 VK_INSTANCE_DEBUG_UTILS_FUNCTION_LIST
 VK_DEVICE_FUNCTION_LIST
 VK_DEVICE_DEBUG_UTILS_FUNCTION_LIST
+VK_DEVICE_OPACITY_MICROMAP_FUNCTION_LIST
+VK_DEVICE_MEMORY_DECOMPRESSION_FUNCTION_LIST
+VK_DEVICE_LOW_LATENCY2_FUNCTION_LIST
+VK_DEVICE_PRESENT_WAIT_FUNCTION_LIST
+VK_DEVICE_ANTI_LAG_FUNCTION_LIST
 VK_DEVICE_WIN32_FUNCTION_LIST
 #undef VK_EXTENSION_FUNCTION
 }
@@ -64,6 +69,56 @@ void RTGL1::InitDeviceExtensionFunctions_DebugUtils( VkDevice device )
 #undef VK_EXTENSION_FUNCTION
 }
 
+void RTGL1::InitDeviceExtensionFunctions_OpacityMicromap( VkDevice device )
+{
+#define VK_EXTENSION_FUNCTION( fname )                               \
+    s##fname = ( PFN_##fname )vkGetDeviceProcAddr( device, #fname ); \
+    assert( s##fname != nullptr );
+
+    VK_DEVICE_OPACITY_MICROMAP_FUNCTION_LIST
+#undef VK_EXTENSION_FUNCTION
+}
+
+void RTGL1::InitDeviceExtensionFunctions_MemoryDecompression( VkDevice device )
+{
+#define VK_EXTENSION_FUNCTION( fname )                               \
+    s##fname = ( PFN_##fname )vkGetDeviceProcAddr( device, #fname ); \
+    assert( s##fname != nullptr );
+
+    VK_DEVICE_MEMORY_DECOMPRESSION_FUNCTION_LIST
+#undef VK_EXTENSION_FUNCTION
+}
+
+void RTGL1::InitDeviceExtensionFunctions_LowLatency2( VkDevice device )
+{
+#define VK_EXTENSION_FUNCTION( fname )                               \
+    s##fname = ( PFN_##fname )vkGetDeviceProcAddr( device, #fname ); \
+    assert( s##fname != nullptr );
+
+    VK_DEVICE_LOW_LATENCY2_FUNCTION_LIST
+#undef VK_EXTENSION_FUNCTION
+}
+
+void RTGL1::InitDeviceExtensionFunctions_PresentWait( VkDevice device )
+{
+#define VK_EXTENSION_FUNCTION( fname )                               \
+    s##fname = ( PFN_##fname )vkGetDeviceProcAddr( device, #fname ); \
+    assert( s##fname != nullptr );
+
+    VK_DEVICE_PRESENT_WAIT_FUNCTION_LIST
+#undef VK_EXTENSION_FUNCTION
+}
+
+void RTGL1::InitDeviceExtensionFunctions_AntiLag( VkDevice device )
+{
+#define VK_EXTENSION_FUNCTION( fname )                               \
+    s##fname = ( PFN_##fname )vkGetDeviceProcAddr( device, #fname ); \
+    assert( s##fname != nullptr );
+
+    VK_DEVICE_ANTI_LAG_FUNCTION_LIST
+#undef VK_EXTENSION_FUNCTION
+}
+
 bool RTGL1::InitDeviceExtensionFunctions_Win32( VkDevice device )
 {
     //
@@ -81,6 +136,22 @@ bool RTGL1::InitDeviceExtensionFunctions_Win32( VkDevice device )
 #undef VK_EXTENSION_FUNCTION
 }
 
+namespace
+{
+uint32_t g_framesInFlight = RTGL1::DEFAULT_FRAMES_IN_FLIGHT;
+}
+
+uint32_t RTGL1::FramesInFlight()
+{
+    return g_framesInFlight;
+}
+
+void RTGL1::SetFramesInFlight( uint32_t count )
+{
+    assert( count >= 2 && count <= MAX_FRAMES_IN_FLIGHT );
+    g_framesInFlight = count;
+}
+
 void RTGL1::AddDebugName( VkDevice device, uint64_t obj, VkObjectType type, const char* pName )
 {
     if( svkSetDebugUtilsObjectNameEXT == nullptr || pName == nullptr )
@@ -36,7 +36,14 @@
 namespace RTGL1
 {
 
-constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+// Capacity of per-frame arrays. The actual count is selected at rgCreateInstance
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT     = 3;
+constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
+
+// Count of frames that can be recorded on CPU while GPU processes the previous ones.
+// Frame indices are in [0..FramesInFlight()-1]. Constant during an instance lifetime
+uint32_t FramesInFlight();
+void     SetFramesInFlight( uint32_t count );
 
 #pragma region extension functions
 
@@ -45,22 +52,54 @@ constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
     VK_EXTENSION_FUNCTION( vkCreateDebugUtilsMessengerEXT ) \
     VK_EXTENSION_FUNCTION( vkDestroyDebugUtilsMessengerEXT )
 
-#define VK_DEVICE_FUNCTION_LIST                                         \
-    VK_EXTENSION_FUNCTION( vkCmdPipelineBarrier2KHR )                   \
-    VK_EXTENSION_FUNCTION( vkCreateAccelerationStructureKHR )           \
-    VK_EXTENSION_FUNCTION( vkDestroyAccelerationStructureKHR )          \
-    VK_EXTENSION_FUNCTION( vkGetRayTracingShaderGroupHandlesKHR )       \
-    VK_EXTENSION_FUNCTION( vkCreateRayTracingPipelinesKHR )             \
-    VK_EXTENSION_FUNCTION( vkGetAccelerationStructureDeviceAddressKHR ) \
-    VK_EXTENSION_FUNCTION( vkGetAccelerationStructureBuildSizesKHR )    \
-    VK_EXTENSION_FUNCTION( vkCmdBuildAccelerationStructuresKHR )        \
-    VK_EXTENSION_FUNCTION( vkCmdTraceRaysKHR )
+#define VK_DEVICE_FUNCTION_LIST                                               \
+    VK_EXTENSION_FUNCTION( vkCmdPipelineBarrier2KHR )                         \
+    VK_EXTENSION_FUNCTION( vkCreateAccelerationStructureKHR )                 \
+    VK_EXTENSION_FUNCTION( vkDestroyAccelerationStructureKHR )                \
+    VK_EXTENSION_FUNCTION( vkGetRayTracingShaderGroupHandlesKHR )             \
+    VK_EXTENSION_FUNCTION( vkCreateRayTracingPipelinesKHR )                   \
+    VK_EXTENSION_FUNCTION( vkGetAccelerationStructureDeviceAddressKHR )       \
+    VK_EXTENSION_FUNCTION( vkGetAccelerationStructureBuildSizesKHR )          \
+    VK_EXTENSION_FUNCTION( vkCmdBuildAccelerationStructuresKHR )              \
+    VK_EXTENSION_FUNCTION( vkCmdWriteAccelerationStructuresPropertiesKHR )    \
+    VK_EXTENSION_FUNCTION( vkCmdCopyAccelerationStructureKHR )                \
+    VK_EXTENSION_FUNCTION( vkCmdCopyAccelerationStructureToMemoryKHR )        \
+    VK_EXTENSION_FUNCTION( vkCmdCopyMemoryToAccelerationStructureKHR )        \
+    VK_EXTENSION_FUNCTION( vkGetDeviceAccelerationStructureCompatibilityKHR ) \
+    VK_EXTENSION_FUNCTION( vkCmdTraceRaysKHR )                                \
+    VK_EXTENSION_FUNCTION( vkCreateDeferredOperationKHR )                     \
+    VK_EXTENSION_FUNCTION( vkDestroyDeferredOperationKHR )                    \
+    VK_EXTENSION_FUNCTION( vkGetDeferredOperationMaxConcurrencyKHR )          \
+    VK_EXTENSION_FUNCTION( vkGetDeferredOperationResultKHR )                  \
+    VK_EXTENSION_FUNCTION( vkDeferredOperationJoinKHR )
 
 #define VK_DEVICE_DEBUG_UTILS_FUNCTION_LIST               \
     VK_EXTENSION_FUNCTION( vkSetDebugUtilsObjectNameEXT ) \
     VK_EXTENSION_FUNCTION( vkCmdBeginDebugUtilsLabelEXT ) \
     VK_EXTENSION_FUNCTION( vkCmdEndDebugUtilsLabelEXT )
 
+#define VK_DEVICE_OPACITY_MICROMAP_FUNCTION_LIST        \
+    VK_EXTENSION_FUNCTION( vkCreateMicromapEXT )        \
+    VK_EXTENSION_FUNCTION( vkDestroyMicromapEXT )       \
+    VK_EXTENSION_FUNCTION( vkGetMicromapBuildSizesEXT ) \
+    VK_EXTENSION_FUNCTION( vkCmdBuildMicromapsEXT )
+
+#define VK_DEVICE_MEMORY_DECOMPRESSION_FUNCTION_LIST \
+    VK_EXTENSION_FUNCTION( vkCmdDecompressMemoryNV )
+
+#define VK_DEVICE_LOW_LATENCY2_FUNCTION_LIST         \
+    VK_EXTENSION_FUNCTION( vkSetLatencySleepModeNV ) \
+    VK_EXTENSION_FUNCTION( vkLatencySleepNV )        \
+    VK_EXTENSION_FUNCTION( vkSetLatencyMarkerNV )
+
+#define VK_DEVICE_PRESENT_WAIT_FUNCTION_LIST VK_EXTENSION_FUNCTION( vkWaitForPresentKHR )
+
+#ifdef VK_AMD_anti_lag
+#define VK_DEVICE_ANTI_LAG_FUNCTION_LIST VK_EXTENSION_FUNCTION( vkAntiLagUpdateAMD )
+#else
+#define VK_DEVICE_ANTI_LAG_FUNCTION_LIST
+#endif
+
 #define VK_DEVICE_WIN32_FUNCTION_LIST                     \
     VK_EXTENSION_FUNCTION( vkGetMemoryWin32HandleKHR )    \
     VK_EXTENSION_FUNCTION( vkGetSemaphoreWin32HandleKHR ) \
@@ -71,12 +110,22 @@ constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 VK_INSTANCE_DEBUG_UTILS_FUNCTION_LIST
 VK_DEVICE_FUNCTION_LIST
 VK_DEVICE_DEBUG_UTILS_FUNCTION_LIST
+VK_DEVICE_OPACITY_MICROMAP_FUNCTION_LIST
+VK_DEVICE_MEMORY_DECOMPRESSION_FUNCTION_LIST
+VK_DEVICE_LOW_LATENCY2_FUNCTION_LIST
+VK_DEVICE_PRESENT_WAIT_FUNCTION_LIST
+VK_DEVICE_ANTI_LAG_FUNCTION_LIST
 VK_DEVICE_WIN32_FUNCTION_LIST
 #undef VK_EXTENSION_FUNCTION
 
 void InitInstanceExtensionFunctions_DebugUtils( VkInstance instance );
 void InitDeviceExtensionFunctions( VkDevice device );
 void InitDeviceExtensionFunctions_DebugUtils( VkDevice device );
+void InitDeviceExtensionFunctions_OpacityMicromap( VkDevice device );
+void InitDeviceExtensionFunctions_MemoryDecompression( VkDevice device );
+void InitDeviceExtensionFunctions_LowLatency2( VkDevice device );
+void InitDeviceExtensionFunctions_PresentWait( VkDevice device );
+void InitDeviceExtensionFunctions_AntiLag( VkDevice device );
 bool InitDeviceExtensionFunctions_Win32( VkDevice device );
 
 #pragma endregion
@@ -26,6 +26,7 @@ namespace RTGL1
 {
 
 constexpr uint32_t ALLOCATOR_BLOCK_SIZE_STAGING_TEXTURES = 64 * 512 * 512 * 4;
+constexpr uint64_t TEXTURE_STAGING_RING_DEFAULT_SIZE     = 16 * 1024 * 1024;
 constexpr uint32_t ALLOCATOR_BLOCK_SIZE_TEXTURES         = 64 * 512 * 512 * 4;
 
 constexpr uint32_t TEXTURE_FILE_PATH_MAX_LENGTH      = 512;
@@ -53,6 +54,21 @@ constexpr uint32_t MAX_PREGENERATED_MIPMAP_LEVELS = 20;
 
 constexpr float MESH_TRANSLUCENT_ALPHA_THRESHOLD = 0.98f;
 
+// Simplified versions of the imported primitives, each has ~half of the previous triangles.
+// Primitives with fewer indices are not simplified
+constexpr uint32_t MESH_LOD_MAX_COUNT       = 3;
+constexpr uint32_t MESH_LOD_MIN_INDEX_COUNT = 3 * 2048;
+// The coarsest LOD, whose geometric error on the screen is less than this, is traced
+constexpr float    MESH_LOD_MAX_PIXEL_ERROR = 1.0f;
+
+// Static primitives are merged into one BLAS, until it reaches any of these limits
+constexpr uint32_t STATIC_CLUSTER_MAX_TRIANGLE_COUNT = 1 << 16;
+constexpr uint32_t STATIC_CLUSTER_MAX_GEOMETRY_COUNT = 256;
+
+// A triangle is split, if the surface area of its AABB is that many times larger than its area
+constexpr float    TRIANGLE_SPLIT_MIN_AABB_RATIO = 16.0f;
+constexpr uint32_t TRIANGLE_SPLIT_MAX_PASSES     = 3;
+
 #define RTGL1_MAIN_ROOT_NODE "rtgl1_main_root"
 
 constexpr std::string_view TEXTURES_FOLDER           = "mat";
@@ -63,6 +79,15 @@ constexpr std::string_view REPLACEMENTS_FOLDER       = "replace";
 constexpr std::string_view SHADERS_FOLDER            = "shaders";
 constexpr std::string_view DATABASE_FOLDER           = "data";
 
+// relative to the override folder
+constexpr std::string_view PIPELINE_CACHE_FILE = "pipelines.rgcache";
+
+// relative to the shaders folder, all .spv files packed by GenerateShaders.py -pack
+constexpr std::string_view SHADERS_ARCHIVE_FILE = "shaders.rgpack";
+
+// relative to the folder of a dev texture
+constexpr std::string_view DEV_TEXTURE_CACHE_FOLDER = ".rgcache";
+
 constexpr std::string_view TEXTURES_FOLDER_JUNCTION        = "mat_junction";
 constexpr std::wstring_view TEXTURES_FOLDER_JUNCTION_W     = L"mat_junction";
 constexpr std::string_view TEXTURES_FOLDER_JUNCTION_PREFIX = "mat_junction/";
@@ -70,6 +95,13 @@ constexpr std::string_view TEXTURES_FOLDER_EXTERNAL        = "ext";
 
 constexpr std::wstring_view SCENE_PATCH_SUFFIX = L"_patch";
 
+// Static scene can be split into "<scene>_cell_<x>_<y>_<z>.gltf" files,
+// that are streamed in and out around the camera. Radii are in cells
+constexpr std::wstring_view SCENE_CELL_SUFFIX        = L"_cell_";
+constexpr float             SCENE_CELL_SIZE_METERS   = 64.0f;
+constexpr int               SCENE_CELL_LOAD_RADIUS   = 2;
+constexpr int               SCENE_CELL_UNLOAD_RADIUS = 3;
+
 constexpr const char* MATERIAL_NAME_SCENEBUILDINGWARNING = "_rgscenewarn";
 
 }
\ No newline at end of file
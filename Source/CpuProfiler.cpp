@@ -0,0 +1,163 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "CpuProfiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t EventRingSize = 4096;
+
+struct State
+{
+    std::mutex mutex;
+
+    uint64_t          frameId{ 0 };
+    Clock::time_point frameStart{ Clock::now() };
+
+    // accumulated for the current frame, and the summary of the previous one
+    std::vector< RgUtilCpuZone > current;
+    std::vector< RgUtilCpuZone > lastFrame;
+
+    std::array< RTGL1::cpuprofiler::ZoneEvent, EventRingSize > ring{};
+    uint64_t                                                   ringWritten{ 0 };
+
+    std::atomic_uint32_t threadCounter{ 0 };
+};
+
+State& GetState()
+{
+    static State s{};
+    return s;
+}
+
+uint32_t GetThreadIndex()
+{
+    thread_local uint32_t index = GetState().threadCounter.fetch_add( 1 );
+    return index;
+}
+
+float ToMs( Clock::duration d )
+{
+    return std::chrono::duration< float, std::milli >( d ).count();
+}
+
+}
+
+void RTGL1::cpuprofiler::BeginFrame( uint64_t frameId )
+{
+    if constexpr( !IsEnabled() )
+    {
+        return;
+    }
+
+    State& s    = GetState();
+    auto   lock = std::lock_guard{ s.mutex };
+
+    std::swap( s.lastFrame, s.current );
+    s.current.clear();
+
+    s.frameId    = frameId;
+    s.frameStart = Clock::now();
+}
+
+void RTGL1::cpuprofiler::EndFrame()
+{
+#if defined( RG_USE_CPU_PROFILING ) && defined( RG_USE_TRACY )
+    FrameMark;
+#endif
+}
+
+uint32_t RTGL1::cpuprofiler::GetLastFrameZones( RgUtilCpuZone* pOutZones, uint32_t maxZoneCount )
+{
+    State& s    = GetState();
+    auto   lock = std::lock_guard{ s.mutex };
+
+    auto count = std::min( maxZoneCount, uint32_t( s.lastFrame.size() ) );
+    if( pOutZones )
+    {
+        std::copy_n( s.lastFrame.begin(), count, pOutZones );
+    }
+    return count;
+}
+
+uint32_t RTGL1::cpuprofiler::GetRecentEvents( ZoneEvent* pOutEvents, uint32_t maxEventCount )
+{
+    State& s    = GetState();
+    auto   lock = std::lock_guard{ s.mutex };
+
+    uint64_t available = std::min< uint64_t >( s.ringWritten, EventRingSize );
+    auto     count     = uint32_t( std::min< uint64_t >( available, maxEventCount ) );
+
+    for( uint32_t i = 0; i < count; i++ )
+    {
+        pOutEvents[ i ] = s.ring[ ( s.ringWritten - count + i ) % EventRingSize ];
+    }
+    return count;
+}
+
+RTGL1::cpuprofiler::Zone::Zone( const char* pName ) : name( pName ), begin( Clock::now() ) {}
+
+RTGL1::cpuprofiler::Zone::~Zone()
+{
+    const auto end = Clock::now();
+
+    State& s    = GetState();
+    auto   lock = std::lock_guard{ s.mutex };
+
+    const float durationMs = ToMs( end - begin );
+
+    // names are literals, so compare pointers first
+    auto found = std::ranges::find_if( s.current, [ this ]( const RgUtilCpuZone& z ) {
+        return z.pName == name || std::strcmp( z.pName, name ) == 0;
+    } );
+
+    if( found != s.current.end() )
+    {
+        found->timeMs += durationMs;
+        found->callCount++;
+    }
+    else
+    {
+        s.current.push_back( RgUtilCpuZone{
+            .pName     = name,
+            .timeMs    = durationMs,
+            .callCount = 1,
+        } );
+    }
+
+    s.ring[ s.ringWritten % EventRingSize ] = ZoneEvent{
+        .name        = name,
+        .frameId     = s.frameId,
+        .threadIndex = GetThreadIndex(),
+        .beginMs     = ToMs( begin - s.frameStart ),
+        .durationMs  = durationMs,
+    };
+    s.ringWritten++;
+}
@@ -0,0 +1,96 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Common.h"
+
+#include <chrono>
+
+#if defined( RG_USE_CPU_PROFILING ) && defined( RG_USE_TRACY )
+#include <tracy/Tracy.hpp>
+#endif
+
+namespace RTGL1
+{
+namespace cpuprofiler
+{
+    struct ZoneEvent
+    {
+        const char* name;
+        uint64_t    frameId;
+        uint32_t    threadIndex;
+        // relative to the start of the frame
+        float beginMs;
+        float durationMs;
+    };
+
+    constexpr bool IsEnabled()
+    {
+#ifdef RG_USE_CPU_PROFILING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Summarize the zones of the previous frame, and start accumulating for a new one
+    void BeginFrame( uint64_t frameId );
+    void EndFrame();
+
+    // Zones of the last finished frame, summed by name. Returns the count written
+    uint32_t GetLastFrameZones( RgUtilCpuZone* pOutZones, uint32_t maxZoneCount );
+    // The most recent raw events, oldest first. Returns the count written
+    uint32_t GetRecentEvents( ZoneEvent* pOutEvents, uint32_t maxEventCount );
+
+    class Zone
+    {
+    public:
+        explicit Zone( const char* pName );
+        ~Zone();
+
+        Zone( const Zone& other )                = delete;
+        Zone( Zone&& other ) noexcept            = delete;
+        Zone& operator=( const Zone& other )     = delete;
+        Zone& operator=( Zone&& other ) noexcept = delete;
+
+    private:
+        const char*                           name;
+        std::chrono::steady_clock::time_point begin;
+    };
+}
+}
+
+#define RG_CPU_ZONE_CONCAT_( a, b ) a##b
+#define RG_CPU_ZONE_CONCAT( a, b )  RG_CPU_ZONE_CONCAT_( a, b )
+
+// Measure CPU time of the current scope. 'name' must be a string literal
+#ifdef RG_USE_CPU_PROFILING
+#ifdef RG_USE_TRACY
+#define RG_CPU_ZONE( name ) \
+    ZoneScopedN( name );    \
+    RTGL1::cpuprofiler::Zone RG_CPU_ZONE_CONCAT( rgCpuZone_, __LINE__ )( name )
+#else
+#define RG_CPU_ZONE( name ) \
+    RTGL1::cpuprofiler::Zone RG_CPU_ZONE_CONCAT( rgCpuZone_, __LINE__ )( name )
+#endif
+#else
+#define RG_CPU_ZONE( name ) ( void )0
+#endif
@@ -20,6 +20,8 @@
 
 #include "CubemapManager.h"
 
+#include <algorithm>
+
 #include "Generated/ShaderCommonC.h"
 #include "Const.h"
 #include "TextureOverrides.h"
@@ -38,14 +40,23 @@ constexpr const T* DefaultIfNull( const T* pData, const T* pDefault )
 }
 
 void CheckIfFaceCorrect( const RTGL1::ImageLoader::ResultInfo& face,
-                         RgExtent2D                            commonSize,
-                         VkFormat                              commonFormat,
+                         const RTGL1::ImageLoader::ResultInfo& first,
                          const char*                           pDebugName )
 {
     using namespace std::string_literals;
 
     assert( face.pData != nullptr );
-    const auto& sz = face.baseSize;
+    const auto& sz           = face.baseSize;
+    const auto& commonSize   = first.baseSize;
+    const auto& commonFormat = first.format;
+
+    // faces are uploaded as one staging region, without inflating on GPU
+    if( face.IsGDeflate() )
+    {
+        throw RTGL1::RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT,
+                                  "Cubemap faces must not be GDeflate-compressed. Failed on: "s +
+                                      pDebugName );
+    }
 
     if( face.format != commonFormat )
     {
@@ -73,31 +84,50 @@ void CheckIfFaceCorrect( const RTGL1::ImageLoader::ResultInfo& face,
                 std::to_string( commonSize.width ) + ", " + std::to_string( commonSize.height ) +
                 ") like on " + pDebugName );
     }
+
+    // faces are copied with the same level offsets
+    if( face.isPregenerated != first.isPregenerated || face.levelCount != first.levelCount ||
+        face.dataSize != first.dataSize ||
+        !std::equal( face.levelOffsets, face.levelOffsets + face.levelCount, first.levelOffsets ) )
+    {
+        throw RTGL1::RgException(
+            RG_RESULT_WRONG_FUNCTION_ARGUMENT,
+            "Cubemap faces must have the same mip levels. Failed on: "s + pDebugName );
+    }
 }
 
 }
 
 
-RTGL1::CubemapManager::CubemapManager( VkDevice                           _device,
-                                       std::shared_ptr< MemoryAllocator > _allocator,
-                                       std::shared_ptr< SamplerManager >  _samplerManager,
-                                       CommandBufferManager&              _cmdManager )
+RTGL1::CubemapManager::CubemapManager( VkDevice                                _device,
+                                       std::shared_ptr< MemoryAllocator >      _allocator,
+                                       std::shared_ptr< SamplerManager >       _samplerManager,
+                                       std::shared_ptr< CommandBufferManager > _cmdManager,
+                                       std::shared_ptr< DeletionQueue >        _deletionQueue,
+                                       uint64_t                                _stagingRingSize )
     : device( _device )
     , allocator( std::move( _allocator ) )
     , samplerManager( std::move( _samplerManager ) )
+    , deletionQueue( std::move( _deletionQueue ) )
     , cubemaps( MAX_CUBEMAP_COUNT )
 {
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_CUBEMAPS };
+
     imageLoader = std::make_shared< ImageLoader >();
     cubemapDesc = std::make_shared< TextureDescriptors >(
         device, samplerManager, MAX_CUBEMAP_COUNT, BINDING_CUBEMAPS );
-    cubemapUploader = std::make_shared< CubemapUploader >( device, allocator );
+    cubemapUploader = std::make_shared< CubemapUploader >(
+        device,
+        allocator,
+        _cmdManager,
+        _stagingRingSize > 0 ? _stagingRingSize : TEXTURE_STAGING_RING_DEFAULT_SIZE );
 
-    VkCommandBuffer cmd = _cmdManager.StartGraphicsCmd();
+    VkCommandBuffer cmd = _cmdManager->StartGraphicsCmd();
     {
         CreateEmptyCubemap( cmd );
     }
-    _cmdManager.Submit( cmd );
-    _cmdManager.WaitGraphicsIdle();
+    _cmdManager->Submit( cmd );
+    _cmdManager->WaitGraphicsIdle();
 }
 
 void RTGL1::CubemapManager::CreateEmptyCubemap( VkCommandBuffer cmd )
@@ -136,20 +166,6 @@ RTGL1::CubemapManager::~CubemapManager()
             cubemapUploader->DestroyImage( t.image, t.view );
         }
     }
-
-    for( const std::vector< Texture >& vec : cubemapsToDestroy )
-    {
-        for( const auto& t : vec )
-        {
-            assert( ( t.image == VK_NULL_HANDLE && t.view == VK_NULL_HANDLE ) ||
-                    ( t.image != VK_NULL_HANDLE && t.view != VK_NULL_HANDLE ) );
-
-            if( t.image != VK_NULL_HANDLE )
-            {
-                cubemapUploader->DestroyImage( t.image, t.view );
-            }
-        }
-    }
 }
 
 bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
@@ -157,6 +173,8 @@ bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
                                               const RgOriginalCubemapInfo& info,
                                               const std::filesystem::path& ovrdFolder )
 {
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_CUBEMAPS };
+
     TextureUploader::UploadInfo upload = {
         .cmd          = cmd,
         .frameIndex   = frameIndex,
@@ -182,12 +200,12 @@ bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
 
     // clang-format off
     TextureOverrides ovrd[] = {
-        TextureOverrides( ovrdFolder, faceNames[ 0 ], "", facePixels[ 0 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 1 ], "", facePixels[ 1 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 2 ], "", facePixels[ 2 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 3 ], "", facePixels[ 3 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 4 ], "", facePixels[ 4 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
-        TextureOverrides( ovrdFolder, faceNames[ 5 ], "", facePixels[ 5 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders ),
+        TextureOverrides( ovrdFolder, faceNames[ 0 ], "", facePixels[ 0 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders, nullptr ),
+        TextureOverrides( ovrdFolder, faceNames[ 1 ], "", facePixels[ 1 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders, nullptr ),
+        TextureOverrides( ovrdFolder, faceNames[ 2 ], "", facePixels[ 2 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders, nullptr ),
+        TextureOverrides( ovrdFolder, faceNames[ 3 ], "", facePixels[ 3 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders, nullptr ),
+        TextureOverrides( ovrdFolder, faceNames[ 4 ], "", facePixels[ 4 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders, nullptr ),
+        TextureOverrides( ovrdFolder, faceNames[ 5 ], "", facePixels[ 5 ], size, VK_FORMAT_R8G8B8A8_SRGB, loaders, nullptr ),
     };
     // clang-format on
 
@@ -195,30 +213,18 @@ bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
     bool useOvrd = true;
 
 
-    RgExtent2D commonSize   = {};
-    VkFormat   commonFormat = VK_FORMAT_UNDEFINED;
+    if( !ovrd[ 0 ].result )
     {
-        if( ovrd[ 0 ].result )
-        {
-            commonSize = {
-                ovrd[ 0 ].result->baseSize.width,
-                ovrd[ 0 ].result->baseSize.height,
-            };
-            commonFormat = ovrd[ 0 ].result->format;
-        }
-        else
-        {
-            useOvrd = false;
-        }
+        useOvrd = false;
     }
 
 
     // check if all entries are correct
     for( const auto& o : ovrd )
     {
-        if( o.result )
+        if( o.result && ovrd[ 0 ].result )
         {
-            CheckIfFaceCorrect( *o.result, commonSize, commonFormat, o.debugname );
+            CheckIfFaceCorrect( *o.result, *ovrd[ 0 ].result, o.debugname );
         }
         else
         {
@@ -229,7 +235,16 @@ bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
 
     if( useOvrd )
     {
-        upload.pDebugName = ovrd[ 0 ].debugname;
+        // any format, e.g. BC1-BC7 or HDR BC6H, with the mip levels stored in the file
+        const ImageLoader::ResultInfo& first = *ovrd[ 0 ].result;
+
+        upload.pDebugName             = ovrd[ 0 ].debugname;
+        upload.format                 = first.format;
+        upload.baseSize               = first.baseSize;
+        upload.dataSize               = first.dataSize;
+        upload.pregeneratedLevelCount = first.isPregenerated ? first.levelCount : 0;
+        upload.pLevelDataOffsets      = first.levelOffsets;
+        upload.pLevelDataSizes        = first.levelSizes;
 
         for( uint32_t i = 0; i < 6; i++ )
         {
@@ -239,8 +254,9 @@ bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
     else
     {
         // use data provided by user
-        commonSize   = { info.sideSize, info.sideSize };
-        commonFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        upload.format   = VK_FORMAT_R8G8B8A8_SRGB;
+        upload.baseSize = { info.sideSize, info.sideSize };
+        upload.dataSize = size_t{ 4 } * info.sideSize * info.sideSize;
 
 
         if( info.sideSize == 0 )
@@ -263,18 +279,6 @@ bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
 
 
 
-    // TODO: KTX cubemap image uploading with proper formats
-    upload.format = commonFormat;
-    if( commonFormat != VK_FORMAT_R8G8B8A8_SRGB && commonFormat != VK_FORMAT_R8G8B8A8_UNORM )
-    {
-        assert( false && "For now, cubemaps only support only R8G8B8A8 formats!" );
-        return false;
-    }
-    upload.baseSize = commonSize;
-    upload.dataSize = size_t{ 4 } * commonSize.width * commonSize.height;
-    //
-
-
     auto i = cubemapUploader->UploadImage( upload );
     if( !i.wasUploaded )
     {
@@ -299,7 +303,8 @@ bool RTGL1::CubemapManager::TryCreateCubemap( VkCommandBuffer              cmd,
     {
         Texture& existing = iter->second;
 
-        // destroy old, overwrite with new
+        // the old one is sampled until this frame, which acquires the new image after
+        // its transfer is done; so destroy old, overwrite with new
         AddForDeletion( frameIndex, existing );
         existing = txd;
     }
@@ -312,8 +317,11 @@ void RTGL1::CubemapManager::AddForDeletion( uint32_t frameIndex, Texture& txd )
     assert( txd.image != VK_NULL_HANDLE );
     assert( txd.view != VK_NULL_HANDLE );
 
-    // destroy later
-    cubemapsToDestroy[ frameIndex ].push_back( txd );
+    // destroy, when the frames that might sample it are finished
+    deletionQueue->Push( frameIndex,
+                         [ uploader = cubemapUploader, image = txd.image, view = txd.view ]() {
+                             uploader->DestroyImage( image, view );
+                         } );
 
     // nullify
     txd = {};
@@ -350,20 +358,20 @@ VkDescriptorSet RTGL1::CubemapManager::GetDescSet( uint32_t frameIndex ) const
 
 void RTGL1::CubemapManager::PrepareForFrame( uint32_t frameIndex )
 {
-    // destroy delayed textures
-    for( const Texture& t : cubemapsToDestroy[ frameIndex ] )
-    {
-        vkDestroyImage( device, t.image, nullptr );
-        vkDestroyImageView( device, t.view, nullptr );
-    }
-    cubemapsToDestroy[ frameIndex ].clear();
-
     // clear staging buffer that are not in use
     cubemapUploader->ClearStaging( frameIndex );
+    cubemapUploader->BeginTransferUploads();
+}
+
+void RTGL1::CubemapManager::SubmitTransferUploads()
+{
+    cubemapUploader->SubmitTransferUploads();
 }
 
 void RTGL1::CubemapManager::SubmitDescriptors( uint32_t frameIndex )
 {
+    cubemapDesc->UpdateSamplers( frameIndex );
+
     // update desc set with current values
     uint32_t iter = 0;
     for( const auto& [ name, cubetxd ] : cubemaps )
@@ -31,6 +31,7 @@
 #include "TextureDescriptors.h"
 #include "CubemapUploader.h"
 #include "CommandBufferManager.h"
+#include "DeletionQueue.h"
 #include "ImageLoader.h"
 
 namespace RTGL1
@@ -57,10 +58,12 @@ typedef struct RgOriginalCubemapInfo
 class CubemapManager
 {
 public:
-    CubemapManager( VkDevice                           device,
-                    std::shared_ptr< MemoryAllocator > allocator,
-                    std::shared_ptr< SamplerManager >  samplerManager,
-                    CommandBufferManager&              cmdManager );
+    CubemapManager( VkDevice                                device,
+                    std::shared_ptr< MemoryAllocator >      allocator,
+                    std::shared_ptr< SamplerManager >       samplerManager,
+                    std::shared_ptr< CommandBufferManager > cmdManager,
+                    std::shared_ptr< DeletionQueue >        deletionQueue,
+                    uint64_t                                stagingRingSize );
     ~CubemapManager();
 
     CubemapManager( const CubemapManager& other )                = delete;
@@ -83,6 +86,8 @@ public:
     VkDescriptorSet       GetDescSet( uint32_t frameIndex ) const;
 
     void PrepareForFrame( uint32_t frameIndex );
+    // Must be called before submitting the frame's command buffer
+    void SubmitTransferUploads();
     void SubmitDescriptors( uint32_t frameIndex );
 
     bool IsCubemapValid( uint32_t cubemapIndex ) const;
@@ -99,9 +104,9 @@ private:
     std::shared_ptr< SamplerManager >     samplerManager;
     std::shared_ptr< TextureDescriptors > cubemapDesc;
     std::shared_ptr< CubemapUploader >    cubemapUploader;
+    std::shared_ptr< DeletionQueue >      deletionQueue;
 
-    rgl::string_map< Texture >                 cubemaps;
-    std::vector< Texture >                     cubemapsToDestroy[ MAX_FRAMES_IN_FLIGHT ];
+    rgl::string_map< Texture > cubemaps;
 };
 
 }
\ No newline at end of file
@@ -20,6 +20,8 @@
 
 #include "CubemapUploader.h"
 
+#include <algorithm>
+
 RTGL1::TextureUploader::UploadResult RTGL1::CubemapUploader::UploadImage( const UploadInfo& info )
 {
     assert( info.isCubemap );
@@ -28,38 +30,39 @@ RTGL1::TextureUploader::UploadResult RTGL1::CubemapUploader::UploadImage( const
 
     constexpr uint32_t FaceCount = 6;
 
-    VkImage            image;
-    VkBuffer           stagingBuffers[ FaceCount ] = {};
-    void*              mappedData[ FaceCount ]     = {};
+    VkImage      image;
+    VkBuffer     stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceSize stagingOffset = 0;
+    void*        mappedData    = nullptr;
 
 
-    // allocate and fill buffer
-    const auto         faceSize = VkDeviceSize( info.dataSize );
+    // allocate and fill buffer: faces are contiguous, each with all of its mip levels
+    const auto faceSize = VkDeviceSize( info.dataSize );
 
-    VkBufferCreateInfo stagingInfo = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size  = faceSize,
-        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-    };
+    std::optional< VkDeviceSize > inRing =
+        AllocFromStagingRing( info.frameIndex, FaceCount * faceSize );
 
-    for( uint32_t i = 0; i < FaceCount; i++ )
+    if( inRing )
     {
-        stagingBuffers[ i ] = memAllocator->CreateStagingSrcTextureBuffer(
-            &stagingInfo, info.pDebugName, &mappedData[ i ] );
-
-        // if couldn't allocate memory
-        if( stagingBuffers[ i ] == VK_NULL_HANDLE )
+        mappedData    = stagingRing[ info.frameIndex ].mapped + *inRing;
+        stagingBuffer = stagingRing[ info.frameIndex ].buffer;
+        stagingOffset = *inRing;
+    }
+    else
+    {
+        VkBufferCreateInfo stagingInfo = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size  = FaceCount * faceSize,
+            .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        };
+
+        stagingBuffer = memAllocator->CreateStagingSrcTextureBuffer(
+            &stagingInfo, info.pDebugName, &mappedData );
+        if( stagingBuffer == VK_NULL_HANDLE )
         {
-            // clear allocated
-            for( uint32_t j = 0; j < i; j++ )
-            {
-                memAllocator->DestroyStagingSrcTextureBuffer( stagingBuffers[ j ] );
-            }
-
             return UploadResult{};
         }
-
-        SET_DEBUG_NAME( device, stagingBuffers[ i ], VK_OBJECT_TYPE_BUFFER, info.pDebugName );
+        SET_DEBUG_NAME( device, stagingBuffer, VK_OBJECT_TYPE_BUFFER, info.pDebugName );
     }
 
 
@@ -67,11 +70,10 @@ RTGL1::TextureUploader::UploadResult RTGL1::CubemapUploader::UploadImage( const
     if( !wasCreated )
     {
         // clean created resources
-        for( VkBuffer b : stagingBuffers )
+        if( !inRing )
         {
-            memAllocator->DestroyStagingSrcTextureBuffer( b );
+            memAllocator->DestroyStagingSrcTextureBuffer( stagingBuffer );
         }
-
         return UploadResult{};
     }
 
@@ -79,12 +81,24 @@ RTGL1::TextureUploader::UploadResult RTGL1::CubemapUploader::UploadImage( const
     // copy image data to buffer
     for( uint32_t i = 0; i < FaceCount; i++ )
     {
-        memcpy( mappedData[ i ], info.cubemap.pFaces[ i ], faceSize );
+        memcpy( static_cast< uint8_t* >( mappedData ) + i * faceSize,
+                info.cubemap.pFaces[ i ],
+                faceSize );
     }
 
 
     // and copy it to image
-    PrepareImage( image, stagingBuffers, info, ImagePrepareType::INIT );
+    if( CanUploadOnTransferQueue( info ) )
+    {
+        PrepareImageOnTransferQueue( image, stagingBuffer, stagingOffset, info );
+    }
+    else
+    {
+        VkBuffer perFace[ FaceCount ];
+        std::ranges::fill( perFace, stagingBuffer );
+
+        PrepareImage( image, perFace, info, ImagePrepareType::INIT, stagingOffset, faceSize );
+    }
 
 
     // create image view
@@ -97,9 +111,9 @@ RTGL1::TextureUploader::UploadResult RTGL1::CubemapUploader::UploadImage( const
 
 
     // push staging buffer to be deleted when it won't be in use
-    for( VkBuffer b : stagingBuffers )
+    if( !inRing )
     {
-        stagingToFree[ info.frameIndex ].push_back( b );
+        stagingToFree[ info.frameIndex ].push_back( stagingBuffer );
     }
 
 
@@ -30,12 +30,15 @@ SOFTWARE.
 #include "RTGL1/RTGL1.h"
 
 #include "CmdLabel.h"
+#include "HitchRecorder.h"
 #include "LibraryConfig.h"
 #include "RenderResolutionHelper.h"
+#include "UpscalerInputs.h"
 #include "Utils.h"
 
 #include <nvsdk_ngx_helpers_vk.h>
 #include <nvsdk_ngx_helpers.h>
+#include <nvsdk_ngx_helpers_dlssd_vk.h>
 
 #include <filesystem>
 
@@ -202,6 +205,17 @@ RTGL1::DLSS2::DLSS2( VkInstance       instance,
             return;
         }
     }
+    {
+        int isDlssdSupported = 0;
+
+        r = m_params->Get( NVSDK_NGX_Parameter_SuperSamplingDenoising_Available,
+                           &isDlssdSupported );
+        if( NVSDK_NGX_FAILED( r ) || !isDlssdSupported )
+        {
+            debug::Info( "DLSS2: Ray Reconstruction is not available on this hardware/platform" );
+        }
+        m_rayReconstructionAvailable = NVSDK_NGX_SUCCEED( r ) && isDlssdSupported;
+    }
 }
 
 
@@ -210,6 +224,11 @@ bool RTGL1::DLSS2::Valid() const
     return m_initialized && m_params;
 }
 
+bool RTGL1::DLSS2::IsRayReconstructionAvailable() const
+{
+    return Valid() && m_rayReconstructionAvailable;
+}
+
 RTGL1::DLSS2::~DLSS2()
 {
     Destroy();
@@ -250,6 +269,7 @@ namespace
                             VkDevice               device,
                             VkCommandBuffer        cmd,
                             const ResolutionState& resolution,
+                            bool                   rayReconstruction,
                             NVSDK_NGX_Handle*      oldFeature ) -> NVSDK_NGX_Handle*
     {
         auto dlssParams = NVSDK_NGX_DLSS_Create_Params{
@@ -279,6 +299,8 @@ namespace
         // destroy previous one
         if( oldFeature != nullptr )
         {
+            RG_HITCH_MARKER( "Wait idle: DLSS feature recreation" );
+
             vkDeviceWaitIdle( device );
 
             NVSDK_NGX_Result r = NVSDK_NGX_VULKAN_ReleaseFeature( oldFeature );
@@ -302,6 +324,38 @@ namespace
         // clang-format on
 
         NVSDK_NGX_Handle* newFeature{ nullptr };
+
+        if( rayReconstruction )
+        {
+            auto dlssdParams = NVSDK_NGX_DLSSD_Create_Params{
+                .InDenoiseMode          = NVSDK_NGX_DLSS_Denoise_Mode_DLUnified,
+                // roughness is in the alpha channel of the normals
+                .InRoughnessMode        = NVSDK_NGX_DLSS_Roughness_Mode_Packed,
+                .InUseHWDepth           = NVSDK_NGX_DLSS_Depth_Type_HW,
+                .InWidth                = resolution.renderWidth,
+                .InHeight               = resolution.renderHeight,
+                .InTargetWidth          = resolution.upscaledWidth,
+                .InTargetHeight         = resolution.upscaledHeight,
+                .InFeatureCreateFlags   = dlssParams.InFeatureCreateFlags,
+                .InEnableOutputSubrects = false,
+            };
+
+            NVSDK_NGX_Result r = NGX_VULKAN_CREATE_DLSSD_EXT1( device,
+                                                               cmd,
+                                                               creationNodeMask,
+                                                               visibilityNodeMask,
+                                                               &newFeature,
+                                                               params,
+                                                               &dlssdParams );
+            if( NVSDK_NGX_FAILED( r ) )
+            {
+                debug::Warning( "DLSS2: NGX_VULKAN_CREATE_DLSSD_EXT1 fail: {}",
+                                static_cast< int >( r ) );
+                return nullptr;
+            }
+            return newFeature;
+        }
+
         NVSDK_NGX_Result  r = NGX_VULKAN_CREATE_DLSS_EXT( cmd, //
                                                          creationNodeMask,
                                                          visibilityNodeMask,
@@ -316,11 +370,15 @@ namespace
         return newFeature;
     }
 
+    // in addition to the common UPSCALER_INPUT_IMAGES
     constexpr FramebufferImageIndex INPUT_IMAGES[] = {
-        FB_IMAGE_INDEX_FINAL,
-        FB_IMAGE_INDEX_DEPTH_NDC,
         FB_IMAGE_INDEX_DEPTH_WORLD,
-        FB_IMAGE_INDEX_MOTION_DLSS,
+    };
+    // additional guides, if Ray Reconstruction is used
+    constexpr FramebufferImageIndex INPUT_IMAGES_RAY_RECON[] = {
+        FB_IMAGE_INDEX_RAY_RECON_NORMAL_ROUGHNESS,
+        FB_IMAGE_INDEX_RAY_RECON_DIFFUSE_ALBEDO,
+        FB_IMAGE_INDEX_RAY_RECON_SPECULAR_ALBEDO,
     };
     constexpr FramebufferImageIndex OUTPUT_IMAGE = RTGL1::FB_IMAGE_INDEX_UPSCALED_PONG;
 
@@ -330,7 +388,10 @@ namespace
                                          NVSDK_NGX_Dimensions  size,
                                          bool                  withWriteAccess = false )
     {
-        assert( fbImage == OUTPUT_IMAGE || std::ranges::contains( INPUT_IMAGES, fbImage ) );
+        assert( fbImage == OUTPUT_IMAGE ||
+                std::ranges::contains( UPSCALER_INPUT_IMAGES, fbImage ) ||
+                std::ranges::contains( INPUT_IMAGES, fbImage ) ||
+                std::ranges::contains( INPUT_IMAGES_RAY_RECON, fbImage ) );
 
         auto [ image, view, format ] = framebuffers.GetImageHandles( fbImage, frameIndex );
 
@@ -360,7 +421,8 @@ auto RTGL1::DLSS2::Apply( VkCommandBuffer               cmd,
                           const RenderResolutionHelper& renderResolution,
                           RgFloat2D                     jitterOffset,
                           double                        timeDelta,
-                          bool                          resetAccumulation ) -> FramebufferImageIndex
+                          bool                          resetAccumulation,
+                          const Camera&                 camera ) -> FramebufferImageIndex
 {
     auto label = CmdLabel{ cmd, "DLSS2" };
 
@@ -371,12 +433,19 @@ auto RTGL1::DLSS2::Apply( VkCommandBuffer               cmd,
         return OUTPUT_IMAGE;
     }
 
+    const bool rayReconstruction = renderResolution.IsNvDlssRayReconstructionEnabled();
+
     {
-        auto newResolution = renderResolution.GetResolutionState();
-        if( m_prevResolution != newResolution )
+        // with dynamic resolution, the feature is created for the max size, and
+        // the actual size is provided as a subrect of the input images
+        auto newResolution = renderResolution.GetAllocationState();
+        if( m_prevResolution != newResolution ||
+            m_featureIsRayReconstruction != rayReconstruction )
         {
-            m_prevResolution = newResolution;
-            m_feature = CreateDlssFeature( m_params, m_device, cmd, newResolution, m_feature );
+            m_prevResolution             = newResolution;
+            m_featureIsRayReconstruction = rayReconstruction;
+            m_feature                    = CreateDlssFeature(
+                m_params, m_device, cmd, newResolution, rayReconstruction, m_feature );
 
             if( !m_feature )
             {
@@ -386,10 +455,21 @@ auto RTGL1::DLSS2::Apply( VkCommandBuffer               cmd,
         }
     }
 
+    framebuffers.BarrierMultiple( cmd, //
+                                  frameIndex,
+                                  UPSCALER_INPUT_IMAGES,
+                                  Framebuffers::BarrierType::Storage );
     framebuffers.BarrierMultiple( cmd, //
                                   frameIndex,
                                   INPUT_IMAGES,
                                   Framebuffers::BarrierType::Storage );
+    if( rayReconstruction )
+    {
+        framebuffers.BarrierMultiple( cmd, //
+                                      frameIndex,
+                                      INPUT_IMAGES_RAY_RECON,
+                                      Framebuffers::BarrierType::Storage );
+    }
 
 
     auto sourceOffset = NVSDK_NGX_Coordinates{
@@ -404,35 +484,103 @@ auto RTGL1::DLSS2::Apply( VkCommandBuffer               cmd,
         renderResolution.UpscaledWidth(),
         renderResolution.UpscaledHeight(),
     };
+    auto allocatedSize = NVSDK_NGX_Dimensions{
+        framebuffers.GetAllocatedResolution().renderWidth,
+        framebuffers.GetAllocatedResolution().renderHeight,
+    };
 
     // clang-format off
-    NVSDK_NGX_Resource_VK unresolvedColorResource = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_FINAL, sourceSize );
+    NVSDK_NGX_Resource_VK unresolvedColorResource = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_FINAL, allocatedSize );
     NVSDK_NGX_Resource_VK resolvedColorResource   = ToNGXResource( framebuffers, frameIndex, OUTPUT_IMAGE, targetSize, true );
-    NVSDK_NGX_Resource_VK motionVectorsResource   = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_MOTION_DLSS, sourceSize );
-    NVSDK_NGX_Resource_VK depthResource           = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_DEPTH_NDC, sourceSize );
-    NVSDK_NGX_Resource_VK rayLengthResource       = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_DEPTH_WORLD, sourceSize );
+    NVSDK_NGX_Resource_VK motionVectorsResource   = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_MOTION_DLSS, allocatedSize );
+    NVSDK_NGX_Resource_VK depthResource           = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_DEPTH_NDC, allocatedSize );
+    NVSDK_NGX_Resource_VK rayLengthResource       = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_DEPTH_WORLD, allocatedSize );
+    NVSDK_NGX_Resource_VK reactiveResource        = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_REACTIVITY, allocatedSize );
     // clang-format on
 
 
+    if( rayReconstruction )
+    {
+        // clang-format off
+        NVSDK_NGX_Resource_VK normalRoughnessResource = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_RAY_RECON_NORMAL_ROUGHNESS, allocatedSize );
+        NVSDK_NGX_Resource_VK diffuseAlbedoResource   = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_RAY_RECON_DIFFUSE_ALBEDO, allocatedSize );
+        NVSDK_NGX_Resource_VK specularAlbedoResource  = ToNGXResource( framebuffers, frameIndex, FB_IMAGE_INDEX_RAY_RECON_SPECULAR_ALBEDO, allocatedSize );
+        // clang-format on
+
+        // NGX expects row-major matrices
+        auto toNgxMatrix = []( const float* m, float* dst ) {
+            for( int i = 0; i < 4; i++ )
+            {
+                for( int j = 0; j < 4; j++ )
+                {
+                    dst[ i * 4 + j ] = m[ j * 4 + i ];
+                }
+            }
+        };
+
+        float worldToView[ 16 ];
+        float viewToClip[ 16 ];
+        toNgxMatrix( camera.view, worldToView );
+        toNgxMatrix( camera.projection, viewToClip );
+
+        auto evalParams = NVSDK_NGX_VK_DLSSD_Eval_Params{
+            .pInDiffuseAlbedo          = &diffuseAlbedoResource,
+            .pInSpecularAlbedo         = &specularAlbedoResource,
+            .pInNormals                = &normalRoughnessResource,
+            .pInColor                  = &unresolvedColorResource,
+            .pInOutput                 = &resolvedColorResource,
+            .pInDepth                  = &depthResource,
+            .pInMotionVectors          = &motionVectorsResource,
+            .InJitterOffsetX           = jitterOffset.data[ 0 ] * ( -1 ),
+            .InJitterOffsetY           = jitterOffset.data[ 1 ] * ( -1 ),
+            .InRenderSubrectDimensions = sourceSize,
+            .InReset                   = resetAccumulation ? 1 : 0,
+            .InMVScaleX                = float( sourceSize.Width ),
+            .InMVScaleY                = float( sourceSize.Height ),
+            .InColorSubrectBase        = sourceOffset,
+            .InDepthSubrectBase        = sourceOffset,
+            .InMVSubrectBase           = sourceOffset,
+            .InPreExposure             = 1.0f,
+            .InExposureScale           = 1.0f,
+            .InToneMapperType          = NVSDK_NGX_TONEMAPPER_ONEOVERLUMA,
+            .InFrameTimeDeltaInMsec    = float( timeDelta * 1000.0 ),
+            .pInRayTracingHitDistance  = &rayLengthResource,
+            .pInWorldToViewMatrix      = worldToView,
+            .pInViewToClipMatrix       = viewToClip,
+        };
+
+        NVSDK_NGX_Result r =
+            NGX_VULKAN_EVALUATE_DLSSD_EXT( cmd, m_feature, m_params, &evalParams );
+
+        if( NVSDK_NGX_FAILED( r ) )
+        {
+            debug::Warning( "DLSS2: NGX_VULKAN_EVALUATE_DLSSD_EXT fail: {}",
+                            static_cast< int >( r ) );
+        }
+        return OUTPUT_IMAGE;
+    }
+
     auto evalParams = NVSDK_NGX_VK_DLSS_Eval_Params{
         .Feature  = { .pInColor = &unresolvedColorResource, .pInOutput = &resolvedColorResource },
         .pInDepth = &depthResource,
-        .pInMotionVectors          = &motionVectorsResource,
-        .InJitterOffsetX           = jitterOffset.data[ 0 ] * ( -1 ),
-        .InJitterOffsetY           = jitterOffset.data[ 1 ] * ( -1 ),
-        .InRenderSubrectDimensions = sourceSize,
-        .InReset                   = resetAccumulation ? 1 : 0,
-        .InMVScaleX                = float( sourceSize.Width ),
-        .InMVScaleY                = float( sourceSize.Height ),
-        .InColorSubrectBase        = sourceOffset,
-        .InDepthSubrectBase        = sourceOffset,
-        .InMVSubrectBase           = sourceOffset,
-        .InTranslucencySubrectBase = sourceOffset,
-        .InPreExposure             = 1.0f,
-        .InExposureScale           = 1.0f,
-        .InToneMapperType          = NVSDK_NGX_TONEMAPPER_ONEOVERLUMA,
-        .InFrameTimeDeltaInMsec    = float( timeDelta * 1000.0 ),
-        .pInRayTracingHitDistance  = &rayLengthResource,
+        .pInMotionVectors              = &motionVectorsResource,
+        .InJitterOffsetX               = jitterOffset.data[ 0 ] * ( -1 ),
+        .InJitterOffsetY               = jitterOffset.data[ 1 ] * ( -1 ),
+        .InRenderSubrectDimensions     = sourceSize,
+        .InReset                       = resetAccumulation ? 1 : 0,
+        .InMVScaleX                    = float( sourceSize.Width ),
+        .InMVScaleY                    = float( sourceSize.Height ),
+        .pInBiasCurrentColorMask       = &reactiveResource,
+        .InColorSubrectBase            = sourceOffset,
+        .InDepthSubrectBase            = sourceOffset,
+        .InMVSubrectBase               = sourceOffset,
+        .InTranslucencySubrectBase     = sourceOffset,
+        .InBiasCurrentColorSubrectBase = sourceOffset,
+        .InPreExposure                 = 1.0f,
+        .InExposureScale               = 1.0f,
+        .InToneMapperType              = NVSDK_NGX_TONEMAPPER_ONEOVERLUMA,
+        .InFrameTimeDeltaInMsec        = float( timeDelta * 1000.0 ),
+        .pInRayTracingHitDistance      = &rayLengthResource,
     };
 
     NVSDK_NGX_Result r = NGX_VULKAN_EVALUATE_DLSS_EXT( cmd, m_feature, m_params, &evalParams );
@@ -626,7 +774,8 @@ auto RTGL1::DLSS2::Apply( VkCommandBuffer,
                           const RenderResolutionHelper&,
                           RgFloat2D,
                           double,
-                          bool ) -> FramebufferImageIndex
+                          bool,
+                          const Camera& ) -> FramebufferImageIndex
 {
     assert( 0 );
     return FB_IMAGE_INDEX_UPSCALED_PONG;
@@ -653,6 +802,10 @@ bool RTGL1::DLSS2::Valid() const
 {
     return false;
 }
+bool RTGL1::DLSS2::IsRayReconstructionAvailable() const
+{
+    return false;
+}
 void RTGL1::DLSS2::Destroy()
 {
 }
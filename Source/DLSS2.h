@@ -66,12 +66,16 @@ public:
                 const RenderResolutionHelper& renderResolution,
                 RgFloat2D                     jitterOffset,
                 double                        timeDelta,
-                bool                          resetAccumulation ) -> FramebufferImageIndex;
+                bool                          resetAccumulation,
+                const Camera&                 camera ) -> FramebufferImageIndex;
 
     auto GetOptimalSettings( uint32_t               userWidth,
                              uint32_t               userHeight,
                              RgRenderResolutionMode mode ) const -> std::pair< uint32_t, uint32_t >;
 
+    // DLSS Ray Reconstruction: denoising and upscaling in one pass
+    bool IsRayReconstructionAvailable() const;
+
     static auto RequiredVulkanExtensions_Instance() -> std::optional< std::vector< const char* > >;
     static auto RequiredVulkanExtensions_Device( VkPhysicalDevice physDevice )
         -> std::optional< std::vector< const char* > >;
@@ -88,6 +92,9 @@ private:
 
     NVSDK_NGX_Handle* m_feature{ nullptr };
     ResolutionState   m_prevResolution{};
+
+    bool m_rayReconstructionAvailable{ false };
+    bool m_featureIsRayReconstruction{ false };
 };
 
 }
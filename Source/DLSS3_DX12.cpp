@@ -33,6 +33,7 @@ SOFTWARE.
 #include "DynamicSdk.h"
 #include "RenderResolutionHelper.h"
 #include "Scene.h"
+#include "UpscalerInputs.h"
 #include "Utils.h"
 
 #include "DX12_CopyFramebuf.h"
@@ -164,11 +165,7 @@ auto LoadDllFunctions( const std::filesystem::path& folder ) -> DynamicSdk< Stre
 }
 
 
-constexpr RTGL1::FramebufferImageIndex INPUT_IMAGES[] = {
-    RTGL1::FB_IMAGE_INDEX_FINAL,
-    RTGL1::FB_IMAGE_INDEX_DEPTH_NDC,
-    RTGL1::FB_IMAGE_INDEX_MOTION_DLSS,
-};
+constexpr const auto& INPUT_IMAGES = RTGL1::UPSCALER_INPUT_IMAGES;
 
 constexpr RTGL1::FramebufferImageIndex OUTPUT_IMAGE = RTGL1::FB_IMAGE_INDEX_UPSCALED_PONG;
 
@@ -563,7 +560,7 @@ sl::Resource ToSlResource( const RTGL1::Framebuffers&   framebuffers,
 
     // if fails, need support for .._Prev framebufs
     assert( framebuffers.GetImage( fbImage, frameIndex ) ==
-            framebuffers.GetImage( fbImage, ( frameIndex + 1 ) % RTGL1::MAX_FRAMES_IN_FLIGHT ) );
+            framebuffers.GetImage( fbImage, RTGL1::Utils::PrevFrame( frameIndex ) ) );
 
     auto sharedImage = RTGL1::dxgi::Framebuf_GetVkDx12Shared( fbImage );
 
@@ -687,6 +684,7 @@ auto RTGL1::DLSS3_DX12::Apply( ID3D12CommandList*            dx12cmd,
         auto colorOut  = ToSlResource( framebuffers, frameIndex, OUTPUT_IMAGE,               targetSize, true);
         auto depth     = ToSlResource( framebuffers, frameIndex, FB_IMAGE_INDEX_DEPTH_NDC,   sourceSize );
         auto motion    = ToSlResource( framebuffers, frameIndex, FB_IMAGE_INDEX_MOTION_DLSS, sourceSize );
+        auto reactive  = ToSlResource( framebuffers, frameIndex, FB_IMAGE_INDEX_REACTIVITY,  sourceSize );
         // auto rayLength = ToSlResource( framebuffers, frameIndex, FB_IMAGE_INDEX_DEPTH_WORLD, sourceSize );
         // auto hud       = ToSlResource( framebuffers, frameIndex, FB_IMAGE_INDEX_HUD_ONLY,    targetSize );
 
@@ -700,6 +698,7 @@ auto RTGL1::DLSS3_DX12::Apply( ID3D12CommandList*            dx12cmd,
             sl::ResourceTag{ &colorOut,  sl::kBufferTypeScalingOutputColor, sl::ResourceLifecycle::eValidUntilPresent },
             sl::ResourceTag{ &depth,     sl::kBufferTypeDepth,              sl::ResourceLifecycle::eValidUntilPresent },
             sl::ResourceTag{ &motion,    sl::kBufferTypeMotionVectors,      sl::ResourceLifecycle::eValidUntilPresent },
+            sl::ResourceTag{ &reactive,  sl::kBufferTypeBiasCurrentColorHint, sl::ResourceLifecycle::eValidUntilPresent },
             // sl::ResourceTag{ &rayLength, sl::kBufferTypeRaytracingDistance, sl::ResourceLifecycle::eOnlyValidNow      },
             sl::ResourceTag{ &colorOut,  sl::kBufferTypeHUDLessColor,    sl::ResourceLifecycle::eValidUntilPresent },
             // sl::ResourceTag{ &hud,       sl::kBufferTypeUIColorAndAlpha,    sl::ResourceLifecycle::eValidUntilEvaluate },
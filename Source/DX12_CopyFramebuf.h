@@ -31,6 +31,7 @@ SOFTWARE.
 
 #include "DX12_Interop.h"
 
+#include <algorithm>
 #include <ranges>
 
 namespace RTGL1
@@ -96,6 +97,105 @@ namespace detail
 
         svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
     }
+
+    // If a framebuffer is the shared image itself, there's nothing to copy:
+    // the shared semaphore orders the APIs, just make the writes visible
+    inline void InsertBarrierForShared( VkCommandBuffer cmd )
+    {
+        auto barrier = VkMemoryBarrier2{
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+            .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT,
+        };
+
+        auto dependencyInfo = VkDependencyInfoKHR{
+            .sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers    = &barrier,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
+    }
+
+    template< size_t N >
+    void CopyImages( VkCommandBuffer cmd,
+                     const VkImage ( &src )[ N ],
+                     const VkImage ( &dst )[ N ],
+                     uint32_t        width,
+                     uint32_t        height )
+    {
+        constexpr auto subres = VkImageSubresourceLayers{
+            .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel       = 0,
+            .baseArrayLayer = 0,
+            .layerCount     = 1,
+        };
+        const auto region = VkImageCopy{
+            .srcSubresource = subres,
+            .srcOffset      = {},
+            .dstSubresource = subres,
+            .dstOffset      = {},
+            .extent         = { width, height, 1 },
+        };
+
+        const size_t sharedCount =
+            std::ranges::count_if( std::views::zip( src, dst ), []( const auto& sd ) {
+                return std::get< 0 >( sd ) == std::get< 1 >( sd );
+            } );
+
+        if( sharedCount > 0 )
+        {
+            InsertBarrierForShared( cmd );
+        }
+
+        if( sharedCount == N )
+        {
+            return;
+        }
+
+        if( sharedCount == 0 )
+        {
+            InsertBarriersForCopy< false >( cmd, src, dst );
+
+            for( auto [ s, d ] : std::views::zip( src, dst ) )
+            {
+                vkCmdCopyImage( cmd,
+                                s,
+                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                d,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                1,
+                                &region );
+            }
+
+            InsertBarriersForCopy< true >( cmd, src, dst );
+            return;
+        }
+
+        // mixed, if some framebuffers couldn't use the shared image (e.g. compact format)
+        for( auto [ s, d ] : std::views::zip( src, dst ) )
+        {
+            if( s == d )
+            {
+                continue;
+            }
+
+            const VkImage s1[] = { s };
+            const VkImage d1[] = { d };
+
+            InsertBarriersForCopy< false >( cmd, s1, d1 );
+            vkCmdCopyImage( cmd,
+                            s,
+                            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                            d,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            1,
+                            &region );
+            InsertBarriersForCopy< true >( cmd, s1, d1 );
+        }
+    }
 }
 
 template< size_t N >
@@ -106,20 +206,6 @@ void Framebuf_CopyVkToDX12( VkCommandBuffer     cmd,
                             uint32_t            height,
                             const FramebufferImageIndex ( &imagesToDX12 )[ N ] )
 {
-    constexpr auto subres = VkImageSubresourceLayers{
-        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-        .mipLevel       = 0,
-        .baseArrayLayer = 0,
-        .layerCount     = 1,
-    };
-    const auto region = VkImageCopy{
-        .srcSubresource = subres,
-        .srcOffset      = {},
-        .dstSubresource = subres,
-        .dstOffset      = {},
-        .extent         = { width, height, 1 },
-    };
-
     VkImage src[ N ];
     VkImage dst[ N ];
     for( size_t i = 0; i < N; i++ )
@@ -128,21 +214,7 @@ void Framebuf_CopyVkToDX12( VkCommandBuffer     cmd,
         dst[ i ] = dxgi::Framebuf_GetVkDx12Shared( imagesToDX12[ i ] ).vkimage;
     }
 
-
-    detail::InsertBarriersForCopy< false >( cmd, src, dst );
-
-    for( auto [ s, d ] : std::views::zip( src, dst ) )
-    {
-        vkCmdCopyImage( cmd,
-                        s,
-                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                        d,
-                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        1,
-                        &region );
-    }
-
-    detail::InsertBarriersForCopy< true >( cmd, src, dst );
+    detail::CopyImages( cmd, src, dst, width, height );
 }
 
 template< size_t N >
@@ -153,20 +225,6 @@ void Framebuf_CopyDX12ToVk( VkCommandBuffer     cmd,
                             uint32_t            height,
                             const FramebufferImageIndex ( &imagesToVk )[ N ] )
 {
-    constexpr auto subres = VkImageSubresourceLayers{
-        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-        .mipLevel       = 0,
-        .baseArrayLayer = 0,
-        .layerCount     = 1,
-    };
-    const auto region = VkImageCopy{
-        .srcSubresource = subres,
-        .srcOffset      = {},
-        .dstSubresource = subres,
-        .dstOffset      = {},
-        .extent         = { width, height, 1 },
-    };
-
     VkImage src[ N ] = {};
     VkImage dst[ N ] = {};
     for( size_t i = 0; i < N; i++ )
@@ -175,18 +233,7 @@ void Framebuf_CopyDX12ToVk( VkCommandBuffer     cmd,
         dst[ i ] = framebuffers.GetImage( imagesToVk[ i ], frameIndex );
     }
 
-
-    detail::InsertBarriersForCopy< false >( cmd, src, dst );
-
-    vkCmdCopyImage( cmd,
-                    src[ 0 ],
-                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                    dst[ 0 ],
-                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                    1,
-                    &region );
-
-    detail::InsertBarriersForCopy< true >( cmd, src, dst );
+    detail::CopyImages( cmd, src, dst, width, height );
 }
 
 }
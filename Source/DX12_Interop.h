@@ -59,6 +59,7 @@ class MemoryAllocator;
 
 namespace RTGL1::dxgi
 {
+// Independent of FramesInFlight(): WaitAndPrepareForFrame waits for the previous DX12 frame
 constexpr uint32_t MAX_FRAMES_IN_FLIGHT_DX12 = 2;
 
 bool DX12Supported();
@@ -153,7 +154,10 @@ void Framebuf_CreateDX12Resources( CommandBufferManager&  vkcmds,
                                    const ResolutionState& resolution );
 void Framebuf_Destroy();
 auto Framebuf_GetVkDx12Shared( int framebufImageIndex ) -> SharedImage;
+// Null, if the framebuffer image doesn't have a shared copy
+auto Framebuf_TryGetVkDx12Shared( int framebufImageIndex ) -> std::optional< SharedImage >;
 bool Framebuf_HasSharedImages();
+// Framebuffers use the shared images directly, if size and format match.
 // Look Framebuf_CopyVkToDX12 / Framebuf_CopyDX12ToVk in DX12_CopyFramebuf.h
 
 }
@@ -39,8 +39,6 @@ SOFTWARE.
 namespace RTGL1::dxgi
 {
 
-static_assert( MAX_FRAMES_IN_FLIGHT_DX12 == MAX_FRAMES_IN_FLIGHT );
-
 namespace
 {
     auto CreateSharedSemaphore( VkDevice         vkdevice,
@@ -306,6 +304,7 @@ namespace
                             DXGI_FORMAT      dxgiformat,
                             uint32_t         width,
                             uint32_t         height,
+                            bool             allowRenderTarget,
                             const char*      debugname ) -> std::optional< SharedImage >
     {
         SharedImage dst{};
@@ -332,6 +331,12 @@ namespace
 
         // DX12
         {
+            D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+            if( allowRenderTarget )
+            {
+                flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+            }
+
             auto desc = D3D12_RESOURCE_DESC{
                 .Dimension        = D3D12_RESOURCE_DIMENSION_TEXTURE2D,
                 .Width            = width,
@@ -341,7 +346,7 @@ namespace
                 .Format           = dxgiformat,
                 .SampleDesc       = { .Count = 1, .Quality = 0 },
                 .Layout           = D3D12_TEXTURE_LAYOUT_UNKNOWN,
-                .Flags            = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+                .Flags            = flags,
             };
 
             auto heapProps = D3D12_HEAP_PROPERTIES{
@@ -399,7 +404,10 @@ namespace
                 .arrayLayers = 1,
                 .samples     = VK_SAMPLE_COUNT_1_BIT,
                 .tiling      = VK_IMAGE_TILING_OPTIMAL,
-                .usage       = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                // same as framebuffers, so the image can be used as one directly
+                .usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                         VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                         ( allowRenderTarget ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT : 0u ),
                 .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
                 .queueFamilyIndexCount = 0,
                 .pQueueFamilyIndices   = nullptr,
@@ -711,6 +719,8 @@ void Framebuf_CreateDX12Resources( CommandBufferManager&  vkcmds,
                                     dxgiformat,
                                     width,
                                     height,
+                                    ShFramebuffers_Flags[ index ] &
+                                        FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_IS_ATTACHMENT,
                                     name.c_str() );
         if( !s )
         {
@@ -830,6 +840,21 @@ auto Framebuf_GetVkDx12Shared( int framebufImageIndex ) -> SharedImage
     return s;
 }
 
+auto Framebuf_TryGetVkDx12Shared( int framebufImageIndex ) -> std::optional< SharedImage >
+{
+    if( framebufImageIndex < 0 || framebufImageIndex >= int( std::size( g_images ) ) )
+    {
+        return std::nullopt;
+    }
+
+    const SharedImage& s = g_images[ framebufImageIndex ];
+    if( !s.vkimage || !s.vkmemory )
+    {
+        return std::nullopt;
+    }
+    return s;
+}
+
 bool Framebuf_HasSharedImages()
 {
     return HasDX12Instance() && !std::ranges::all_of( g_images, IsDefault< SharedImage > );
@@ -333,6 +333,11 @@ void RTGL1::DecalManager::CopyAttachmentsToRtGBuffer( VkCommandBuffer      cmd,
 
 void RTGL1::DecalManager::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { "DecalNormalsCopy", "VertDecal", "FragDecal" } ) )
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines( shaderManager );
 }
@@ -504,8 +509,12 @@ void RTGL1::DecalManager::CreatePipelines( const ShaderManager* shaderManager )
         {
             copyFromDecalToGbuffer = 0;
 
-            VkResult r = vkCreateComputePipelines(
-                device, VK_NULL_HANDLE, 1, &copyingInfo, nullptr, &copyNormalsToAttachment );
+            VkResult r = vkCreateComputePipelines( device,
+                                                   shaderManager->GetPipelineCache(),
+                                                   1,
+                                                   &copyingInfo,
+                                                   nullptr,
+                                                   &copyNormalsToAttachment );
 
             VK_CHECKERROR( r );
             SET_DEBUG_NAME( device,
@@ -516,8 +525,12 @@ void RTGL1::DecalManager::CreatePipelines( const ShaderManager* shaderManager )
         {
             copyFromDecalToGbuffer = 1;
 
-            VkResult r = vkCreateComputePipelines(
-                device, VK_NULL_HANDLE, 1, &copyingInfo, nullptr, &copyNormalsToGbuffer );
+            VkResult r = vkCreateComputePipelines( device,
+                                                   shaderManager->GetPipelineCache(),
+                                                   1,
+                                                   &copyingInfo,
+                                                   nullptr,
+                                                   &copyNormalsToGbuffer );
 
             VK_CHECKERROR( r );
             SET_DEBUG_NAME( device,
@@ -661,7 +674,12 @@ void RTGL1::DecalManager::CreatePipelines( const ShaderManager* shaderManager )
         .basePipelineHandle  = VK_NULL_HANDLE,
     };
 
-    VkResult r = vkCreateGraphicsPipelines( device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline );
+    VkResult r = vkCreateGraphicsPipelines( device,
+                                            shaderManager->GetPipelineCache(),
+                                            1,
+                                            &info,
+                                            nullptr,
+                                            &pipeline );
     VK_CHECKERROR( r );
 }
 
@@ -0,0 +1,62 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "DeletionQueue.h"
+
+RTGL1::DeletionQueue::~DeletionQueue()
+{
+    // owners must flush, while the objects that are referenced by the callbacks are alive
+    for( const auto& p : pending )
+    {
+        assert( p.empty() );
+    }
+}
+
+void RTGL1::DeletionQueue::Flush( uint32_t frameIndex )
+{
+    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
+
+    for( auto& destroy : pending[ frameIndex ] )
+    {
+        destroy();
+    }
+    pending[ frameIndex ].clear();
+}
+
+void RTGL1::DeletionQueue::FlushAll()
+{
+    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        Flush( i );
+    }
+}
+
+void RTGL1::DeletionQueue::Push( uint32_t frameIndex, std::move_only_function< void() > destroy )
+{
+    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
+    assert( destroy );
+
+    pending[ frameIndex ].push_back( std::move( destroy ) );
+}
+
+void RTGL1::DeletionQueue::PushSampler( uint32_t frameIndex, VkDevice device, VkSampler sampler )
+{
+    Push( frameIndex, [ device, sampler ]() { vkDestroySampler( device, sampler, nullptr ); } );
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Common.h"
+
+#include <functional>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Resources that might be in use by the frames in flight are pushed here,
+// and are destroyed in bulk, when the GPU has finished the frame with the same index
+class DeletionQueue
+{
+public:
+    DeletionQueue() = default;
+    ~DeletionQueue();
+
+    DeletionQueue( const DeletionQueue& other )                = delete;
+    DeletionQueue( DeletionQueue&& other ) noexcept            = delete;
+    DeletionQueue& operator=( const DeletionQueue& other )     = delete;
+    DeletionQueue& operator=( DeletionQueue&& other ) noexcept = delete;
+
+    // The frame's fence must be already waited
+    void Flush( uint32_t frameIndex );
+    // The device must be idle
+    void FlushAll();
+
+    void Push( uint32_t frameIndex, std::move_only_function< void() > destroy );
+
+    void PushSampler( uint32_t frameIndex, VkDevice device, VkSampler sampler );
+
+private:
+    std::vector< std::move_only_function< void() > > pending[ MAX_FRAMES_IN_FLIGHT ];
+};
+
+}
@@ -33,9 +33,9 @@ RTGL1::Denoiser::Denoiser( VkDevice                        _device,
     , framebuffers( std::move( _framebuffers ) )
     , pipelineLayout( VK_NULL_HANDLE )
     , gradientAtrous{}
-    , antifirefly( VK_NULL_HANDLE )
     , temporalAccumulation( VK_NULL_HANDLE )
     , varianceEstimation( VK_NULL_HANDLE )
+    , sampleBudget( VK_NULL_HANDLE )
     , atrous{}
 {
     static_assert( sizeof( atrous ) / sizeof( VkPipeline ) == COMPUTE_SVGF_ATROUS_ITERATION_COUNT,
@@ -91,13 +91,6 @@ void RTGL1::Denoiser::Denoise( VkCommandBuffer                               cmd
 
         for( uint32_t i = 0; i < COMPUTE_ASVGF_GRADIENT_ATROUS_ITERATION_COUNT; i++ )
         {
-            uint32_t wgGradCountX = Utils::GetWorkGroupCount(
-                uniform->GetData()->renderWidth / COMPUTE_ASVGF_STRATA_SIZE,
-                COMPUTE_GRADIENT_ATROUS_GROUP_SIZE_X );
-            uint32_t wgGradCountY = Utils::GetWorkGroupCount(
-                uniform->GetData()->renderHeight / COMPUTE_ASVGF_STRATA_SIZE,
-                COMPUTE_GRADIENT_ATROUS_GROUP_SIZE_X );
-
             if( i % 2 == 0 )
             {
                 FI fs[] = {
@@ -114,7 +107,11 @@ void RTGL1::Denoiser::Denoise( VkCommandBuffer                               cmd
             }
 
             vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, gradientAtrous[ i ] );
-            vkCmdDispatch( cmd, wgGradCountX, wgGradCountY, 1 );
+            Utils::DispatchFullscreen( cmd,
+                                       uniform->GetData()->renderWidth / COMPUTE_ASVGF_STRATA_SIZE,
+                                       uniform->GetData()->renderHeight / COMPUTE_ASVGF_STRATA_SIZE,
+                                       COMPUTE_GRADIENT_ATROUS_GROUP_SIZE_X,
+                                       COMPUTE_GRADIENT_ATROUS_GROUP_SIZE_X );
         }
     }
 #endif // GRADIENT_ESTIMATION_ENABLED
@@ -122,11 +119,6 @@ void RTGL1::Denoiser::Denoise( VkCommandBuffer                               cmd
 
     // temporal accumulation
     {
-        uint32_t wgCountX = Utils::GetWorkGroupCount( uniform->GetData()->renderWidth,
-                                                      COMPUTE_SVGF_TEMPORAL_GROUP_SIZE_X );
-        uint32_t wgCountY = Utils::GetWorkGroupCount( uniform->GetData()->renderHeight,
-                                                      COMPUTE_SVGF_TEMPORAL_GROUP_SIZE_X );
-
         CmdLabel label( cmd, "Temporal accumulation" );
 
         FI fs[] = {
@@ -148,47 +140,53 @@ void RTGL1::Denoiser::Denoise( VkCommandBuffer                               cmd
         framebuffers->BarrierMultiple( cmd, frameIndex, fs );
 
         vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, temporalAccumulation );
-        vkCmdDispatch( cmd, wgCountX, wgCountY, 1 );
+        Utils::DispatchFullscreen( cmd,
+                                   uniform->GetData()->renderWidth,
+                                   uniform->GetData()->renderHeight,
+                                   COMPUTE_SVGF_TEMPORAL_GROUP_SIZE_X,
+                                   COMPUTE_SVGF_TEMPORAL_GROUP_SIZE_X );
     }
 
 
-    // antifirefly
+    // antifirefly and variance estimation
     {
-        uint32_t x = Utils::GetWorkGroupCount( uniform->GetData()->renderWidth,
-                                               COMPUTE_ANTIFIREFLY_GROUP_SIZE_X );
-        uint32_t y = Utils::GetWorkGroupCount( uniform->GetData()->renderHeight,
-                                               COMPUTE_ANTIFIREFLY_GROUP_SIZE_X );
-
-        CmdLabel label( cmd, "Antifirefly" );
+        CmdLabel label( cmd, "SVGF Antifirefly and variance estimation" );
 
-        FI fs[] = {
-            FI::FB_IMAGE_INDEX_DIFF_ACCUM_COLOR,
-            FI::FB_IMAGE_INDEX_SPEC_ACCUM_COLOR,
-            FI::FB_IMAGE_INDEX_INDIR_ACCUM,
-        };
+        FI fs[] = { FI::FB_IMAGE_INDEX_DIFF_TEMPORARY,
+                    FI::FB_IMAGE_INDEX_SPEC_ACCUM_COLOR,
+                    FI::FB_IMAGE_INDEX_INDIR_ACCUM,
+                    FI::FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS,
+                    FI::FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH };
         framebuffers->BarrierMultiple( cmd, frameIndex, fs );
 
-
-        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, antifirefly );
-        vkCmdDispatch( cmd, x, y, 1 );
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, varianceEstimation );
+        Utils::DispatchFullscreen( cmd,
+                                   uniform->GetData()->renderWidth,
+                                   uniform->GetData()->renderHeight,
+                                   COMPUTE_SVGF_VARIANCE_GROUP_SIZE_X,
+                                   COMPUTE_SVGF_VARIANCE_GROUP_SIZE_X );
     }
 
 
-    // variance estimation
+    // sample budget for the next frame
+    if( uniform->GetData()->adaptiveSamplingEnable )
     {
-        uint32_t wgCountX = Utils::GetWorkGroupCount( uniform->GetData()->renderWidth,
-                                                      COMPUTE_SVGF_VARIANCE_GROUP_SIZE_X );
-        uint32_t wgCountY = Utils::GetWorkGroupCount( uniform->GetData()->renderHeight,
-                                                      COMPUTE_SVGF_VARIANCE_GROUP_SIZE_X );
+        uint32_t wgCountX = Utils::GetWorkGroupCount(
+            Utils::GetWorkGroupCount( uniform->GetData()->renderWidth, COMPUTE_ASVGF_STRATA_SIZE ),
+            COMPUTE_SAMPLE_BUDGET_GROUP_SIZE_X );
+        uint32_t wgCountY = Utils::GetWorkGroupCount(
+            Utils::GetWorkGroupCount( uniform->GetData()->renderHeight, COMPUTE_ASVGF_STRATA_SIZE ),
+            COMPUTE_SAMPLE_BUDGET_GROUP_SIZE_X );
 
-        CmdLabel label( cmd, "SVGF Variance estimation" );
+        CmdLabel label( cmd, "Sample budget" );
 
-        FI fs[] = { FI::FB_IMAGE_INDEX_DIFF_ACCUM_COLOR,
-                    FI::FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS,
-                    FI::FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH };
+        FI fs[] = {
+            FI::FB_IMAGE_INDEX_DIFF_PING_COLOR_AND_VARIANCE,
+            FI::FB_IMAGE_INDEX_INDIR_ACCUM,
+        };
         framebuffers->BarrierMultiple( cmd, frameIndex, fs );
 
-        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, varianceEstimation );
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, sampleBudget );
         vkCmdDispatch( cmd, wgCountX, wgCountY, 1 );
     }
 
@@ -197,10 +195,11 @@ void RTGL1::Denoiser::Denoise( VkCommandBuffer                               cmd
 
     for( uint32_t i = 0; i < COMPUTE_SVGF_ATROUS_ITERATION_COUNT; i++ )
     {
-        uint32_t wgCountX = Utils::GetWorkGroupCount( uniform->GetData()->renderWidth,
-                                                      COMPUTE_SVGF_ATROUS_GROUP_SIZE_X );
-        uint32_t wgCountY = Utils::GetWorkGroupCount( uniform->GetData()->renderHeight,
-                                                      COMPUTE_SVGF_ATROUS_GROUP_SIZE_X );
+        // iteration 1 is fused into iteration 0
+        if( i == 1 )
+        {
+            continue;
+        }
 
         CmdLabel label( cmd, "SVGF Atrous" );
 
@@ -216,8 +215,8 @@ void RTGL1::Denoiser::Denoise( VkCommandBuffer                               cmd
                 framebuffers->BarrierMultiple( cmd, frameIndex, fs );
                 break;
             }
-            case 1: {
-                FI fs[] = { FI::FB_IMAGE_INDEX_DIFF_COLOR_HISTORY,
+            case 2: {
+                FI fs[] = { FI::FB_IMAGE_INDEX_DIFF_PONG_COLOR_AND_VARIANCE,
                             FI::FB_IMAGE_INDEX_SPEC_PONG_COLOR,
                             FI::FB_IMAGE_INDEX_INDIR_PONG,
                             // on iteration 0 prefiltered variance was calculated
@@ -226,18 +225,10 @@ void RTGL1::Denoiser::Denoise( VkCommandBuffer                               cmd
                 framebuffers->BarrierMultiple( cmd, frameIndex, fs );
                 break;
             }
-            case 2: {
+            case 3: {
                 FI fs[] = { FI::FB_IMAGE_INDEX_DIFF_PING_COLOR_AND_VARIANCE,
                             FI::FB_IMAGE_INDEX_SPEC_PING_COLOR,
-                            FI::FB_IMAGE_INDEX_INDIR_PING };
-
-                framebuffers->BarrierMultiple( cmd, frameIndex, fs );
-                break;
-            }
-            case 3: {
-                FI fs[] = { FI::FB_IMAGE_INDEX_DIFF_PONG_COLOR_AND_VARIANCE,
-                            FI::FB_IMAGE_INDEX_SPEC_PONG_COLOR,
-                            FI::FB_IMAGE_INDEX_INDIR_PONG,
+                            FI::FB_IMAGE_INDEX_INDIR_PING,
                             FI::FB_IMAGE_INDEX_THROUGHPUT };
 
                 framebuffers->BarrierMultiple( cmd, frameIndex, fs );
@@ -250,12 +241,26 @@ void RTGL1::Denoiser::Denoise( VkCommandBuffer                               cmd
         }
 
         vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, atrous[ i ] );
-        vkCmdDispatch( cmd, wgCountX, wgCountY, 1 );
+        Utils::DispatchFullscreen( cmd,
+                                   uniform->GetData()->renderWidth,
+                                   uniform->GetData()->renderHeight,
+                                   COMPUTE_SVGF_ATROUS_GROUP_SIZE_X,
+                                   COMPUTE_SVGF_ATROUS_GROUP_SIZE_X );
     }
 }
 
 void RTGL1::Denoiser::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { "CASVGFGradientAtrous",
+                                      "CSVGFTemporalAccum",
+                                      "CSVGFVarianceEstim",
+                                      "CSampleBudget",
+                                      "CSVGFAtrous_Iter01",
+                                      "CSVGFAtrous" } ) )
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines( shaderManager );
 }
@@ -278,9 +283,9 @@ void RTGL1::Denoiser::CreatePipelineLayout( VkDescriptorSetLayout* pSetLayouts,
 
 void RTGL1::Denoiser::DestroyPipelines()
 {
-    vkDestroyPipeline( device, antifirefly, nullptr );
     vkDestroyPipeline( device, temporalAccumulation, nullptr );
     vkDestroyPipeline( device, varianceEstimation, nullptr );
+    vkDestroyPipeline( device, sampleBudget, nullptr );
 
     for( VkPipeline& p : gradientAtrous )
     {
@@ -294,9 +299,9 @@ void RTGL1::Denoiser::DestroyPipelines()
         p = VK_NULL_HANDLE;
     }
 
-    antifirefly          = VK_NULL_HANDLE;
     temporalAccumulation = VK_NULL_HANDLE;
     varianceEstimation   = VK_NULL_HANDLE;
+    sampleBudget         = VK_NULL_HANDLE;
 }
 
 void RTGL1::Denoiser::CreatePipelines( const ShaderManager* shaderManager )
@@ -335,8 +340,12 @@ void RTGL1::Denoiser::CreatePipelines( const ShaderManager* shaderManager )
         {
             gAtrousIteration = i;
 
-            VkResult r = vkCreateComputePipelines(
-                device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &gradientAtrous[ i ] );
+            VkResult r = vkCreateComputePipelines( device,
+                                                   shaderManager->GetPipelineCache(),
+                                                   1,
+                                                   &plInfo,
+                                                   nullptr,
+                                                   &gradientAtrous[ i ] );
 
             VK_CHECKERROR( r );
             SET_DEBUG_NAME( device, gradientAtrous[ i ], VK_OBJECT_TYPE_PIPELINE, debugNames[ i ] );
@@ -351,7 +360,7 @@ void RTGL1::Denoiser::CreatePipelines( const ShaderManager* shaderManager )
         };
 
         VkResult r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &temporalAccumulation );
+            device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &temporalAccumulation );
 
         VK_CHECKERROR( r );
         SET_DEBUG_NAME( device,
@@ -363,52 +372,53 @@ void RTGL1::Denoiser::CreatePipelines( const ShaderManager* shaderManager )
     {
         VkComputePipelineCreateInfo plInfo = {
             .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-            .stage  = shaderManager->GetStageInfo( "CAntiFirefly" ),
+            .stage  = shaderManager->GetStageInfo( "CSVGFVarianceEstim" ),
             .layout = pipelineLayout,
         };
 
-        VkResult r =
-            vkCreateComputePipelines( device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &antifirefly );
-        VK_CHECKERROR( r );
+        VkResult r = vkCreateComputePipelines(
+            device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &varianceEstimation );
 
-        SET_DEBUG_NAME( device, antifirefly, VK_OBJECT_TYPE_PIPELINE, "Antifirefly pipeline" );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device,
+                        varianceEstimation,
+                        VK_OBJECT_TYPE_PIPELINE,
+                        "SVGF Variance estimation pipeline" );
     }
 
     {
         VkComputePipelineCreateInfo plInfo = {
             .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-            .stage  = shaderManager->GetStageInfo( "CSVGFVarianceEstim" ),
+            .stage  = shaderManager->GetStageInfo( "CSampleBudget" ),
             .layout = pipelineLayout,
         };
 
         VkResult r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &varianceEstimation );
+            device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &sampleBudget );
 
         VK_CHECKERROR( r );
-        SET_DEBUG_NAME( device,
-                        varianceEstimation,
-                        VK_OBJECT_TYPE_PIPELINE,
-                        "SVGF Variance estimation pipeline" );
+        SET_DEBUG_NAME( device, sampleBudget, VK_OBJECT_TYPE_PIPELINE, "Sample budget pipeline" );
     }
 
     {
         const char* debugNames[ COMPUTE_SVGF_ATROUS_ITERATION_COUNT ] = {
-            "SVGF Atrous iteration #0 pipeline",
-            "SVGF Atrous iteration #1 pipeline",
+            "SVGF Atrous iterations #0 and #1 pipeline",
+            nullptr,
             "SVGF Atrous iteration #2 pipeline",
             "SVGF Atrous iteration #3 pipeline",
         };
 
-        // special iteration 0
+        // special iterations 0 and 1, fused into one dispatch;
+        // so atrous[ 1 ] is not used
         {
             VkComputePipelineCreateInfo plInfo = {
                 .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-                .stage  = shaderManager->GetStageInfo( "CSVGFAtrous_Iter0" ),
+                .stage  = shaderManager->GetStageInfo( "CSVGFAtrous_Iter01" ),
                 .layout = pipelineLayout,
             };
 
             VkResult r = vkCreateComputePipelines(
-                device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &atrous[ 0 ] );
+                device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &atrous[ 0 ] );
 
             VK_CHECKERROR( r );
             SET_DEBUG_NAME( device, atrous[ 0 ], VK_OBJECT_TYPE_PIPELINE, debugNames[ 0 ] );
@@ -422,12 +432,12 @@ void RTGL1::Denoiser::CreatePipelines( const ShaderManager* shaderManager )
             };
             plInfo.stage.pSpecializationInfo = &specInfo;
 
-            for( uint32_t i = 1; i < COMPUTE_SVGF_ATROUS_ITERATION_COUNT; i++ )
+            for( uint32_t i = 2; i < COMPUTE_SVGF_ATROUS_ITERATION_COUNT; i++ )
             {
                 gAtrousIteration = i;
 
                 VkResult r = vkCreateComputePipelines(
-                    device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &atrous[ i ] );
+                    device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &atrous[ i ] );
 
                 VK_CHECKERROR( r );
                 SET_DEBUG_NAME( device, atrous[ i ], VK_OBJECT_TYPE_PIPELINE, debugNames[ i ] );
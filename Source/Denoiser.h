@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include "IDenoiser.h"
 #include "ShaderManager.h"
 #include "Framebuffers.h"
 #include "GlobalUniform.h"
@@ -28,7 +29,8 @@
 namespace RTGL1
 {
 
-class Denoiser final : public IShaderDependency
+// Spatiotemporal variance-guided filtering
+class Denoiser final : public IDenoiser, public IShaderDependency
 {
 public:
     Denoiser( VkDevice                                      device,
@@ -44,7 +46,7 @@ public:
 
     void      Denoise( VkCommandBuffer                               cmd,
                        uint32_t                                      frameIndex,
-                       const std::shared_ptr< const GlobalUniform >& uniform );
+                       const std::shared_ptr< const GlobalUniform >& uniform ) override;
 
     void      OnShaderReload( const ShaderManager* shaderManager ) override;
 
@@ -62,9 +64,9 @@ private:
 
     VkPipeline                      gradientAtrous[ 4 ];
 
-    VkPipeline                      antifirefly;
     VkPipeline                      temporalAccumulation;
     VkPipeline                      varianceEstimation;
+    VkPipeline                      sampleBudget;
     VkPipeline                      atrous[ 4 ];
 };
 
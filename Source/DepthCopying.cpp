@@ -135,6 +135,11 @@ void RTGL1::DepthCopying::Process( VkCommandBuffer     cmd,
 
 void RTGL1::DepthCopying::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { SHADER_VERT, SHADER_FRAG } ) )
+    {
+        return;
+    }
+
     vkDestroyPipeline( device, pipeline, nullptr );
     pipeline = VK_NULL_HANDLE;
 
@@ -352,7 +357,12 @@ void RTGL1::DepthCopying::CreatePipeline( const ShaderManager* shaderManager )
         .basePipelineHandle  = VK_NULL_HANDLE,
     };
 
-    VkResult r = vkCreateGraphicsPipelines( device, nullptr, 1, &plInfo, nullptr, &pipeline );
+    VkResult r = vkCreateGraphicsPipelines( device,
+                                            shaderManager->GetPipelineCache(),
+                                            1,
+                                            &plInfo,
+                                            nullptr,
+                                            &pipeline );
 
     VK_CHECKERROR( r );
     SET_DEBUG_NAME( device, pipeline, VK_OBJECT_TYPE_PIPELINE, "Rasterizer raster draw pipeline" );
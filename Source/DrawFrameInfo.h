@@ -22,6 +22,8 @@
 
 #include "InternalExtensions.inl"
 
+#include <tuple>
+
 namespace RTGL1
 {
 
@@ -78,6 +80,11 @@ namespace detail
     template<> constexpr auto TypeToStructureType< RgMeshPrimitivePBREXT                > = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_PBR_EXT               ;
     template<> constexpr auto TypeToStructureType< RgMeshPrimitiveAttachedLightEXT      > = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_ATTACHED_LIGHT_EXT    ;
     template<> constexpr auto TypeToStructureType< RgMeshPrimitiveSwapchainedEXT        > = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_SWAPCHAINED_EXT       ;
+    template<> constexpr auto TypeToStructureType< RgMeshPrimitiveSkinningEXT           > = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_SKINNING_EXT          ;
+    template<> constexpr auto TypeToStructureType< RgMeshPrimitiveParticlesEXT          > = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_PARTICLES_EXT         ;
+    template<> constexpr auto TypeToStructureType< RgMeshPrimitiveNameHandleEXT         > = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_NAME_HANDLE_EXT       ;
+    template<> constexpr auto TypeToStructureType< RgMeshNameHandleEXT                  > = RG_STRUCTURE_TYPE_MESH_NAME_HANDLE_EXT                 ;
+    template<> constexpr auto TypeToStructureType< RgMeshAreaEXT                        > = RG_STRUCTURE_TYPE_MESH_AREA_EXT                        ;
     template<> constexpr auto TypeToStructureType< RgLensFlareInfo                      > = RG_STRUCTURE_TYPE_LENS_FLARE_INFO                      ;
     template<> constexpr auto TypeToStructureType< RgLightInfo                          > = RG_STRUCTURE_TYPE_LIGHT_INFO                           ;
     template<> constexpr auto TypeToStructureType< RgLightAdditionalEXT                 > = RG_STRUCTURE_TYPE_LIGHT_ADDITIONAL_EXT                 ;
@@ -91,8 +98,16 @@ namespace detail
     template<> constexpr auto TypeToStructureType< RgCameraInfo                         > = RG_STRUCTURE_TYPE_CAMERA_INFO                          ;
     template<> constexpr auto TypeToStructureType< RgCameraInfoReadbackEXT              > = RG_STRUCTURE_TYPE_CAMERA_INFO_READ_BACK_EXT            ;
     template<> constexpr auto TypeToStructureType< RgOriginalTextureDetailsEXT          > = RG_STRUCTURE_TYPE_ORIGINAL_TEXTURE_DETAILS_EXT         ;
+    template<> constexpr auto TypeToStructureType< RgOriginalTextureAsyncEXT            > = RG_STRUCTURE_TYPE_ORIGINAL_TEXTURE_ASYNC_EXT           ;
     template<> constexpr auto TypeToStructureType< RgSpawnFluidInfo                     > = RG_STRUCTURE_TYPE_SPAWN_FLUID_INFO                     ;
+    template<> constexpr auto TypeToStructureType< RgReadbackRequestInfo                > = RG_STRUCTURE_TYPE_READBACK_REQUEST_INFO                ;
     template<> constexpr auto TypeToStructureType< RgStartFrameFluidParams              > = RG_STRUCTURE_TYPE_START_FRAME_FLUID_PARAMS             ;
+    template<> constexpr auto TypeToStructureType< RgStartFrameStereoParams             > = RG_STRUCTURE_TYPE_START_FRAME_STEREO_PARAMS            ;
+    template<> constexpr auto TypeToStructureType< RgStartFrameViewsParams              > = RG_STRUCTURE_TYPE_START_FRAME_VIEWS_PARAMS             ;
+    template<> constexpr auto TypeToStructureType< RgStartFrameFramePacingParams        > = RG_STRUCTURE_TYPE_START_FRAME_FRAME_PACING_PARAMS      ;
+    template<> constexpr auto TypeToStructureType< RgDrawFrameViewsParams               > = RG_STRUCTURE_TYPE_DRAW_FRAME_VIEWS_PARAMS              ;
+    template<> constexpr auto TypeToStructureType< RgDrawFrameInstanceCullingParams     > = RG_STRUCTURE_TYPE_DRAW_FRAME_INSTANCE_CULLING_PARAMS   ;
+    template<> constexpr auto TypeToStructureType< RgDrawFrameAreaVisibilityParams      > = RG_STRUCTURE_TYPE_DRAW_FRAME_AREA_VISIBILITY_PARAMS    ;
     // clang-format on
 
     template< typename T >
@@ -121,6 +136,11 @@ namespace detail
     static_assert( CheckMembers< RgMeshPrimitivePBREXT >() );
     static_assert( CheckMembers< RgMeshPrimitiveAttachedLightEXT >() );
     static_assert( CheckMembers< RgMeshPrimitiveSwapchainedEXT >() );
+    static_assert( CheckMembers< RgMeshPrimitiveSkinningEXT >() );
+    static_assert( CheckMembers< RgMeshPrimitiveParticlesEXT >() );
+    static_assert( CheckMembers< RgMeshPrimitiveNameHandleEXT >() );
+    static_assert( CheckMembers< RgMeshNameHandleEXT >() );
+    static_assert( CheckMembers< RgMeshAreaEXT >() );
     static_assert( CheckMembers< RgLensFlareInfo >() );
     static_assert( CheckMembers< RgLightInfo >() );
     static_assert( CheckMembers< RgLightAdditionalEXT >() );
@@ -134,8 +154,16 @@ namespace detail
     static_assert( CheckMembers< RgCameraInfo >() );
     static_assert( CheckMembers< RgCameraInfoReadbackEXT >() );
     static_assert( CheckMembers< RgOriginalTextureDetailsEXT >() );
+    static_assert( CheckMembers< RgOriginalTextureAsyncEXT >() );
     static_assert( CheckMembers< RgSpawnFluidInfo >() );
+    static_assert( CheckMembers< RgReadbackRequestInfo >() );
     static_assert( CheckMembers< RgStartFrameFluidParams >() );
+    static_assert( CheckMembers< RgStartFrameStereoParams >() );
+    static_assert( CheckMembers< RgStartFrameFramePacingParams >() );
+    static_assert( CheckMembers< RgStartFrameViewsParams >() );
+    static_assert( CheckMembers< RgDrawFrameViewsParams >() );
+    static_assert( CheckMembers< RgDrawFrameInstanceCullingParams >() );
+    static_assert( CheckMembers< RgDrawFrameAreaVisibilityParams >() );
 
 
     template< typename T >
@@ -150,7 +178,13 @@ namespace detail
     template<> struct LinkRootHelper< RgMeshPrimitivePBREXT              >{ using Root = RgMeshPrimitiveInfo; };
     template<> struct LinkRootHelper< RgMeshPrimitiveAttachedLightEXT    >{ using Root = RgMeshPrimitiveInfo; };
     template<> struct LinkRootHelper< RgMeshPrimitiveSwapchainedEXT      >{ using Root = RgMeshPrimitiveInfo; };
+    template<> struct LinkRootHelper< RgMeshPrimitiveSkinningEXT         >{ using Root = RgMeshPrimitiveInfo; };
+    template<> struct LinkRootHelper< RgMeshPrimitiveParticlesEXT        >{ using Root = RgMeshPrimitiveInfo; };
+    template<> struct LinkRootHelper< RgMeshPrimitiveNameHandleEXT       >{ using Root = RgMeshPrimitiveInfo; };
+    template<> struct LinkRootHelper< RgMeshNameHandleEXT                >{ using Root = RgMeshInfo; };
+    template<> struct LinkRootHelper< RgMeshAreaEXT                      >{ using Root = RgMeshInfo; };
     template<> struct LinkRootHelper< RgOriginalTextureDetailsEXT        >{ using Root = RgOriginalTextureInfo; };
+    template<> struct LinkRootHelper< RgOriginalTextureAsyncEXT          >{ using Root = RgOriginalTextureInfo; };
     template<> struct LinkRootHelper< RgLightAdditionalEXT               >{ using Root = RgLightInfo; };
     template<> struct LinkRootHelper< RgLightDirectionalEXT              >{ using Root = RgLightInfo; };
     template<> struct LinkRootHelper< RgLightSphericalEXT                >{ using Root = RgLightInfo; };
@@ -159,6 +193,10 @@ namespace detail
     template<> struct LinkRootHelper< RgCameraInfoReadbackEXT            >{ using Root = RgCameraInfo; };
     template<> struct LinkRootHelper< RgStartFrameRenderResolutionParams >{ using Root = RgStartFrameInfo; };
     template<> struct LinkRootHelper< RgStartFrameFluidParams            >{ using Root = RgStartFrameInfo; };
+    template<> struct LinkRootHelper< RgStartFrameStereoParams           >{ using Root = RgStartFrameInfo; };
+    template<> struct LinkRootHelper< RgStartFrameViewsParams            >{ using Root = RgStartFrameInfo; };
+    template<> struct LinkRootHelper< RgStartFrameFramePacingParams      >{ using Root = RgStartFrameInfo; };
+    template<> struct LinkRootHelper< RgDrawFrameViewsParams             >{ using Root = RgDrawFrameInfo; };
     template<> struct LinkRootHelper< RgDrawFrameIlluminationParams      >{ using Root = RgDrawFrameInfo; };
     template<> struct LinkRootHelper< RgDrawFrameVolumetricParams        >{ using Root = RgDrawFrameInfo; };
     template<> struct LinkRootHelper< RgDrawFrameTonemappingParams       >{ using Root = RgDrawFrameInfo; };
@@ -167,6 +205,8 @@ namespace detail
     template<> struct LinkRootHelper< RgDrawFrameSkyParams               >{ using Root = RgDrawFrameInfo; };
     template<> struct LinkRootHelper< RgDrawFrameTexturesParams          >{ using Root = RgDrawFrameInfo; };
     template<> struct LinkRootHelper< RgDrawFramePostEffectsParams       >{ using Root = RgDrawFrameInfo; };
+    template<> struct LinkRootHelper< RgDrawFrameInstanceCullingParams   >{ using Root = RgDrawFrameInfo; };
+    template<> struct LinkRootHelper< RgDrawFrameAreaVisibilityParams    >{ using Root = RgDrawFrameInfo; };
     // clang-format on
 
     template< typename T >
@@ -225,6 +265,39 @@ namespace pnext
 
         return static_cast< ReturnType >( nullptr );
     }
+
+    // Same as find() for each of Ts, but with one pass over the chain
+    template< typename... Ts, typename SourceType >
+        requires( ( ( detail::TypeToStructureType< Ts > != RG_STRUCTURE_TYPE_NONE ) && ... ) &&
+                  ( detail::AreLinkable< Ts, SourceType > && ... ) )
+    auto findAll( const SourceType* listStart ) noexcept -> std::tuple< const Ts*... >
+    {
+        auto result = std::tuple< const Ts*... >{};
+
+        auto next = static_cast< const void* >( listStart );
+
+        while( next )
+        {
+            RgStructureType sType = detail::GetStructureType( next );
+
+            auto trySet = [ & ]< typename T >( const T*& dst ) {
+                if( !dst && sType == detail::TypeToStructureType< T > )
+                {
+                    dst = static_cast< const T* >( next );
+                }
+            };
+            std::apply( [ & ]( auto&... dst ) { ( trySet( dst ), ... ); }, result );
+
+            if( sType == RG_STRUCTURE_TYPE_NONE )
+            {
+                debug::Error( "Found sType=RG_STRUCTURE_TYPE_NONE on {:#x}", uint64_t( next ) );
+            }
+
+            next = detail::GetPNext( next );
+        }
+
+        return result;
+    }
 }
 
 namespace detail
@@ -241,16 +314,20 @@ namespace detail
             detail::TypeToStructureType< RgStartFrameRenderResolutionParams >;
 
         constexpr static RgStartFrameRenderResolutionParams value = {
-            .sType                     = sType,
-            .pNext                     = nullptr,
-            .upscaleTechnique          = RG_RENDER_UPSCALE_TECHNIQUE_AMD_FSR2,
-            .resolutionMode            = RG_RENDER_RESOLUTION_MODE_QUALITY,
-            .frameGeneration           = RG_FRAME_GENERATION_MODE_OFF,
-            .preferDxgiPresent         = false,
-            .sharpenTechnique          = RG_RENDER_SHARPEN_TECHNIQUE_NONE,
-            .customRenderSize          = {},
-            .pixelizedRenderSizeEnable = false,
-            .pixelizedRenderSize       = {},
+            .sType                            = sType,
+            .pNext                            = nullptr,
+            .upscaleTechnique                 = RG_RENDER_UPSCALE_TECHNIQUE_AMD_FSR2,
+            .resolutionMode                   = RG_RENDER_RESOLUTION_MODE_QUALITY,
+            .frameGeneration                  = RG_FRAME_GENERATION_MODE_OFF,
+            .preferDxgiPresent                = false,
+            .sharpenTechnique                 = RG_RENDER_SHARPEN_TECHNIQUE_NONE,
+            .customRenderSize                 = {},
+            .pixelizedRenderSizeEnable        = false,
+            .pixelizedRenderSize              = {},
+            .dlssRayReconstruction            = false,
+            .dynamicResolution                = false,
+            .dynamicResolutionTargetFrameTime = 16.6f,
+            .dynamicResolutionMinScale        = 0.5f,
         };
     };
 
@@ -271,6 +348,45 @@ namespace detail
         };
     };
 
+    template<>
+    struct DefaultParams< RgStartFrameStereoParams >
+    {
+        constexpr static auto sType = detail::TypeToStructureType< RgStartFrameStereoParams >;
+
+        constexpr static RgStartFrameStereoParams value = {
+            .sType                  = sType,
+            .pNext                  = nullptr,
+            .sideBySide             = false,
+            .interpupillaryDistance = 0.064f,
+        };
+    };
+
+    template<>
+    struct DefaultParams< RgStartFrameViewsParams >
+    {
+        constexpr static auto sType = detail::TypeToStructureType< RgStartFrameViewsParams >;
+
+        constexpr static RgStartFrameViewsParams value = {
+            .sType     = sType,
+            .pNext     = nullptr,
+            .viewCount = 1,
+        };
+    };
+
+    template<>
+    struct DefaultParams< RgStartFrameFramePacingParams >
+    {
+        constexpr static auto sType = detail::TypeToStructureType< RgStartFrameFramePacingParams >;
+
+        constexpr static RgStartFrameFramePacingParams value = {
+            .sType           = sType,
+            .pNext           = nullptr,
+            .enable          = false,
+            .maxQueuedFrames = 1,
+            .targetFrameTime = 0,
+        };
+    };
+
     template<>
     struct DefaultParams< RgDrawFrameIlluminationParams >
     {
@@ -287,6 +403,21 @@ namespace detail
             .specularSensitivityToChange                 = 0.5f,
             .polygonalLightSpotlightFactor               = 2.0f,
             .lightUniqueIdIgnoreFirstPersonViewerShadows = nullptr,
+            .enableLightGrid                             = false,
+            .indirectResolution                          = RG_INDIRECT_ILLUMINATION_RESOLUTION_FULL,
+            .enableAdaptiveSampling                      = false,
+            .enableIrradianceCache                       = false,
+            .irradianceCacheCellSize                     = 0.5f,
+            .irradianceCacheUpdateRate                   = 0.25f,
+            .sampleSequence                              = RG_SAMPLE_SEQUENCE_WHITE_NOISE,
+            .enableSunShadowCache                        = false,
+            .sunShadowCacheUpdateRate                    = 0.125f,
+            .restirDirectCandidateCountMin               = 4,
+            .restirDirectCandidateCountMax               = 8,
+            .restirDirectSpatialCountMin                 = 2,
+            .restirDirectSpatialCountMax                 = 8,
+            .restirIndirectSpatialCountMin               = 1,
+            .restirIndirectSpatialCountMax               = 2,
         };
     };
 
@@ -308,6 +439,10 @@ namespace detail
             .fallbackSourceColor     = { 0, 0, 0 },
             .fallbackSourceDirection = { 0, -1, 0 },
             .lightMultiplier         = 1.0f,
+            .gridWidth               = 0,
+            .gridHeight              = 0,
+            .gridDepth               = 0,
+            .temporalReprojection    = false,
         };
     };
 
@@ -369,6 +504,10 @@ namespace detail
             .waterWaveTextureDerivativesMultiplier = 1.0f,
             .waterTextureAreaScale                 = 1.0f,
             .portalNormalTwirl                     = false,
+            .minReflectRefractThroughput           = 0.01f,
+            .maxReflectRefractRoughness            = 1.0f,
+            .maxReflectRefractDistance             = 0.0f,
+            .skyOnReflectRefractTermination        = false,
         };
     };
 
@@ -387,6 +526,8 @@ namespace detail
             .skyViewerPosition           = {},
             .pSkyCubemapTextureName      = nullptr,
             .skyCubemapRotationTransform = {},
+            .rasterizedSkyUpdate         = RG_SKY_CUBEMAP_UPDATE_EVERY_FRAME,
+            .rasterizedSkyDirty          = false,
         };
     };
 
@@ -430,6 +571,50 @@ namespace detail
         };
     };
 
+    template<>
+    struct DefaultParams< RgDrawFrameInstanceCullingParams >
+    {
+        constexpr static auto sType =
+            detail::TypeToStructureType< RgDrawFrameInstanceCullingParams >;
+
+        constexpr static RgDrawFrameInstanceCullingParams value = {
+            .sType         = sType,
+            .pNext         = nullptr,
+            .enable        = false,
+            .maxDistance   = 0.0f,
+            .frustumMargin = -1.0f,
+        };
+    };
+
+    template<>
+    struct DefaultParams< RgDrawFrameAreaVisibilityParams >
+    {
+        constexpr static auto sType =
+            detail::TypeToStructureType< RgDrawFrameAreaVisibilityParams >;
+
+        constexpr static RgDrawFrameAreaVisibilityParams value = {
+            .sType         = sType,
+            .pNext         = nullptr,
+            .enable        = false,
+            .areaCount     = 0,
+            .pVisibleAreas = nullptr,
+            .pShadowAreas  = nullptr,
+        };
+    };
+
+    template<>
+    struct DefaultParams< RgDrawFrameViewsParams >
+    {
+        constexpr static auto sType = detail::TypeToStructureType< RgDrawFrameViewsParams >;
+
+        constexpr static RgDrawFrameViewsParams value = {
+            .sType                 = sType,
+            .pNext                 = nullptr,
+            .additionalCameraCount = 0,
+            .pAdditionalCameras    = nullptr,
+        };
+    };
+
     template< typename T >
     concept HasDefaultParams = requires( DefaultParams< T > t ) { t.value; };
 }
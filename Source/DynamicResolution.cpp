@@ -0,0 +1,120 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+// steps are small, as each change recreates the framebuffers
+// and invalidates the temporal history of the upscaler
+constexpr float    ScaleStep          = 0.05f;
+constexpr float    DefaultMinScale    = 0.5f;
+constexpr float    AbsoluteMinScale   = 0.25f;
+constexpr uint32_t MinSampleCount     = 8;
+constexpr uint32_t CooldownFrameCount = 30;
+constexpr float    AverageWeight      = 0.1f;
+
+// hysteresis: decrease if above, increase only if the predicted time is below
+constexpr float DecreaseThreshold = 0.95f;
+constexpr float IncreaseThreshold = 0.85f;
+
+}
+
+void RTGL1::DynamicResolution::ResetStatistics()
+{
+    averageGpuTimeMs = 0.0f;
+    sampleCount      = 0;
+}
+
+auto RTGL1::DynamicResolution::Update( const RgStartFrameRenderResolutionParams& params,
+                                       std::optional< float >                    gpuFrameTimeMs )
+    -> std::optional< float >
+{
+    if( !params.dynamicResolution || params.dynamicResolutionTargetFrameTime <= 0.0f )
+    {
+        scale    = 1.0f;
+        cooldown = 0;
+        ResetStatistics();
+        return std::nullopt;
+    }
+
+    const float minScale = params.dynamicResolutionMinScale > 0.0f
+                               ? std::clamp( params.dynamicResolutionMinScale, //
+                                             AbsoluteMinScale,
+                                             1.0f )
+                               : DefaultMinScale;
+    scale = std::clamp( scale, minScale, 1.0f );
+
+    if( !gpuFrameTimeMs )
+    {
+        return scale;
+    }
+
+    // the frames right after a resize are not representative
+    if( cooldown > 0 )
+    {
+        cooldown--;
+        return scale;
+    }
+
+    const float gpuTime = *gpuFrameTimeMs;
+
+    averageGpuTimeMs = sampleCount == 0 //
+                           ? gpuTime
+                           : std::lerp( averageGpuTimeMs, gpuTime, AverageWeight );
+    sampleCount++;
+
+    if( sampleCount < MinSampleCount )
+    {
+        return scale;
+    }
+
+    const float target   = params.dynamicResolutionTargetFrameTime;
+    float       newScale = scale;
+
+    if( averageGpuTimeMs > target * DecreaseThreshold )
+    {
+        newScale = std::max( scale - ScaleStep, minScale );
+    }
+    else
+    {
+        // the cost is roughly proportional to the pixel count
+        float up        = std::min( scale + ScaleStep, 1.0f );
+        float predicted = averageGpuTimeMs * ( up * up ) / ( scale * scale );
+
+        if( predicted < target * IncreaseThreshold )
+        {
+            newScale = up;
+        }
+    }
+
+    if( std::abs( newScale - scale ) > 0.001f )
+    {
+        scale    = newScale;
+        cooldown = CooldownFrameCount;
+        ResetStatistics();
+    }
+
+    return scale;
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Common.h"
+
+namespace RTGL1
+{
+
+// Closed-loop controller for the render resolution scale.
+// Measured GPU frame time is fed into it, and the scale
+// is changed in small steps to keep the time under the target.
+class DynamicResolution
+{
+public:
+    DynamicResolution()  = default;
+    ~DynamicResolution() = default;
+
+    DynamicResolution( const DynamicResolution& other )                = delete;
+    DynamicResolution( DynamicResolution&& other ) noexcept            = delete;
+    DynamicResolution& operator=( const DynamicResolution& other )     = delete;
+    DynamicResolution& operator=( DynamicResolution&& other ) noexcept = delete;
+
+    // 'gpuFrameTimeMs' is a new sample, if it was read back since the previous call.
+    // Returns the scale to apply to the output size, or nullopt if disabled.
+    auto Update( const RgStartFrameRenderResolutionParams& params,
+                 std::optional< float >                    gpuFrameTimeMs )
+        -> std::optional< float >;
+
+    float GetGpuTimeMs() const { return averageGpuTimeMs; }
+
+private:
+    void ResetStatistics();
+
+private:
+    float    scale{ 1.0f };
+    float    averageGpuTimeMs{ 0.0f };
+    uint32_t sampleCount{ 0 };
+    uint32_t cooldown{ 0 };
+};
+
+}
@@ -21,8 +21,8 @@
 #include "EffectBase.h"
 #include "Generated/ShaderCommonC.h"
 
-RTGL1::EffectBase::EffectBase( VkDevice _device )
-    : device( _device ), pipelineLayout( VK_NULL_HANDLE ), pipelines{}
+RTGL1::EffectBase::EffectBase( VkDevice _device, uint32_t _permutation )
+    : device( _device ), pipelineLayout( VK_NULL_HANDLE ), pipelines{}, permutation( _permutation )
 {
 }
 
@@ -34,6 +34,11 @@ RTGL1::EffectBase::~EffectBase()
 
 void RTGL1::EffectBase::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { GetShaderName() } ) )
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines( shaderManager );
 }
@@ -45,19 +50,34 @@ void RTGL1::EffectBase::CreatePipelines( const ShaderManager* shaderManager )
         assert( t == VK_NULL_HANDLE );
     }
 
-    uint32_t isSourcePing = 0;
+    struct
+    {
+        uint32_t isSourcePing;
+        uint32_t permutation;
+    } specData = {
+        .isSourcePing = 0,
+        .permutation  = permutation,
+    };
 
-    VkSpecializationMapEntry specEntry = {
-        .constantID = 0,
-        .offset     = 0,
-        .size       = sizeof( isSourcePing ),
+    // constant_id = 1 is optional, and ignored by the shaders that don't declare it
+    VkSpecializationMapEntry specEntries[] = {
+        {
+            .constantID = 0,
+            .offset     = 0,
+            .size       = sizeof( specData.isSourcePing ),
+        },
+        {
+            .constantID = 1,
+            .offset     = sizeof( specData.isSourcePing ),
+            .size       = sizeof( specData.permutation ),
+        },
     };
 
     VkSpecializationInfo specInfo = {
-        .mapEntryCount = 1,
-        .pMapEntries   = &specEntry,
-        .dataSize      = sizeof( isSourcePing ),
-        .pData         = &isSourcePing,
+        .mapEntryCount = uint32_t( std::size( specEntries ) ),
+        .pMapEntries   = specEntries,
+        .dataSize      = sizeof( specData ),
+        .pData         = &specData,
     };
 
     VkComputePipelineCreateInfo plInfo = {
@@ -70,17 +90,23 @@ void RTGL1::EffectBase::CreatePipelines( const ShaderManager* shaderManager )
     for( int b = 0; b <= 1; b++ )
     {
         // modify specInfo.pData
-        isSourcePing = b;
-
-        VkResult r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &pipelines[ isSourcePing ] );
+        specData.isSourcePing = b;
+
+        VkResult r = vkCreateComputePipelines( device,
+                                               shaderManager->GetPipelineCache(),
+                                               1,
+                                               &plInfo,
+                                               nullptr,
+                                               &pipelines[ specData.isSourcePing ] );
         VK_CHECKERROR( r );
 
-        SET_DEBUG_NAME(
-            device,
-            pipelines[ isSourcePing ],
-            VK_OBJECT_TYPE_PIPELINE,
-            std::format( "{} from {}", GetShaderName(), isSourcePing ? "Ping" : "Pong" ).c_str() );
+        SET_DEBUG_NAME( device,
+                        pipelines[ specData.isSourcePing ],
+                        VK_OBJECT_TYPE_PIPELINE,
+                        std::format( "{} from {}",
+                                     GetShaderName(),
+                                     specData.isSourcePing ? "Ping" : "Pong" )
+                            .c_str() );
     }
 }
 
@@ -109,10 +135,6 @@ auto RTGL1::EffectBase::Dispatch( VkCommandBuffer                        cmd,
     uint32_t isSourcePing = inputFramebuf == FB_IMAGE_INDEX_UPSCALED_PING;
 
 
-    const uint32_t wgCountX = Utils::GetWorkGroupCount( width, COMPUTE_EFFECT_GROUP_SIZE_X );
-    const uint32_t wgCountY = Utils::GetWorkGroupCount( height, COMPUTE_EFFECT_GROUP_SIZE_Y );
-
-
     vkCmdBindDescriptorSets( cmd,
                              VK_PIPELINE_BIND_POINT_COMPUTE,
                              pipelineLayout,
@@ -137,7 +159,8 @@ auto RTGL1::EffectBase::Dispatch( VkCommandBuffer                        cmd,
     };
     framebuffers->BarrierMultiple( cmd, frameIndex, fs );
 
-    vkCmdDispatch( cmd, wgCountX, wgCountY, 1 );
+    Utils::DispatchFullscreen(
+        cmd, width, height, COMPUTE_EFFECT_GROUP_SIZE_X, COMPUTE_EFFECT_GROUP_SIZE_Y );
 
 
     return isSourcePing ? FB_IMAGE_INDEX_UPSCALED_PONG : FB_IMAGE_INDEX_UPSCALED_PING;
@@ -34,7 +34,8 @@ namespace RTGL1
 class EffectBase : public IShaderDependency
 {
 public:
-    explicit EffectBase( VkDevice _device );
+    // Permutation is passed to a shader as a specialization constant with constant_id = 1
+    explicit EffectBase( VkDevice _device, uint32_t _permutation = 0 );
 
     ~EffectBase() override;
 
@@ -78,6 +79,7 @@ private:
     VkDevice         device;
     VkPipelineLayout pipelineLayout;
     VkPipeline       pipelines[ 2 ];
+    uint32_t         permutation;
 };
 
 
@@ -36,13 +36,25 @@ struct EmptyPushConst
 {
 };
 
+// Must be in sync with EffectTransition in EfFusedPointwise.comp and EfHDRPrepare.comp
+struct EffectTransition
+{
+    uint32_t transitionType;
+    float    transitionBeginTime;
+    float    transitionDuration;
+};
+
 template< typename PushConst, StringLiteral ShaderName >
 struct EffectSimple : EffectBase
 {
     explicit EffectSimple( VkDevice                           device,
                            const ShaderManager&               shaderManager,
-                           std::span< VkDescriptorSetLayout > setLayouts )
-        : EffectBase{ device }, push{}, isCurrentlyActive{ false }, shaderName{ ShaderName.value }
+                           std::span< VkDescriptorSetLayout > setLayouts,
+                           uint32_t                           permutation = 0 )
+        : EffectBase{ device, permutation }
+        , push{}
+        , isCurrentlyActive{ false }
+        , shaderName{ ShaderName.value }
     {
         InitBase( shaderManager, setLayouts, push );
     }
@@ -50,8 +62,12 @@ struct EffectSimple : EffectBase
     explicit EffectSimple( VkDevice             device,
                            const ShaderManager& shaderManager,
                            const Framebuffers&  framebuffers,
-                           const GlobalUniform& uniform )
-        : EffectBase{ device }, push{}, isCurrentlyActive{ false }, shaderName{ ShaderName.value }
+                           const GlobalUniform& uniform,
+                           uint32_t             permutation = 0 )
+        : EffectBase{ device, permutation }
+        , push{}
+        , isCurrentlyActive{ false }
+        , shaderName{ ShaderName.value }
     {
         VkDescriptorSetLayout setLayouts[] = {
             framebuffers.GetDescSetLayout(),
@@ -119,6 +135,16 @@ public:
         return Apply( descSets, args, inputFramebuf );
     }
 
+    // To apply the effect within a fused dispatch
+    EffectTransition GetTransition() const
+    {
+        return EffectTransition{
+            .transitionType      = push.transitionType,
+            .transitionBeginTime = push.transitionBeginTime,
+            .transitionDuration  = push.transitionDuration,
+        };
+    }
+
 protected:
     bool GetPushConstData( uint8_t ( &pData )[ 128 ], uint32_t* pDataSize ) const override
     {
@@ -71,6 +71,8 @@ struct EffectChromaticAberration final
         return EffectSimple::Setup(
             args, params->isActive, params->transitionDurationIn, params->transitionDurationOut );
     }
+
+    float GetIntensity() const { return push.custom.intensity; }
 };
 
 
@@ -208,6 +210,50 @@ struct EffectNightVision final : EffectSimple< EmptyPushConst, "EffectNightVisio
 // ------------------ //
 
 
+// Must be in sync with EfFusedPointwise.comp
+enum EffectFusedPointwise_Bits : uint32_t
+{
+    EFFECT_FUSED_TELEPORT     = 1,
+    EFFECT_FUSED_HUE_SHIFT    = 2,
+    EFFECT_FUSED_NIGHT_VISION = 4,
+};
+constexpr uint32_t EFFECT_FUSED_PERMUTATION_COUNT = 8;
+
+struct EffectFusedPointwise_PushConst
+{
+    EffectTransition teleport;
+    EffectTransition hueShift;
+    EffectTransition nightVision;
+};
+
+// Applies consecutive pointwise effects (that don't read neighbor pixels) in one dispatch.
+// Each instance is a permutation for a specific set of EffectFusedPointwise_Bits
+struct EffectFusedPointwise final
+    : EffectSimple< EffectFusedPointwise_PushConst, "EffectFusedPointwise" >
+{
+    explicit EffectFusedPointwise( VkDevice             device,
+                                   const ShaderManager& shaderManager,
+                                   const Framebuffers&  framebuffers,
+                                   const GlobalUniform& uniform,
+                                   uint32_t             fusedEffects )
+        : EffectSimple{ device, shaderManager, framebuffers, uniform, fusedEffects }
+    {
+    }
+
+    void Setup( const EffectTeleport&    teleport,
+                const EffectHueShift&    hueShift,
+                const EffectNightVision& nightVision )
+    {
+        GetPush().teleport    = teleport.GetTransition();
+        GetPush().hueShift    = hueShift.GetTransition();
+        GetPush().nightVision = nightVision.GetTransition();
+    }
+};
+
+
+// ------------------ //
+
+
 struct EffectCrtDemodulateEncode final : EffectSimple< EmptyPushConst, "EffectCrtDemodulateEncode" >
 {
     using EffectSimple::EffectSimple;
@@ -285,6 +331,8 @@ struct EffectVHS final : EffectSimple< EffectVHS_PushConst, "EffectVHS" >
         return EffectSimple::Setup(
             args, params->isActive, params->transitionDurationIn, params->transitionDurationOut );
     }
+
+    float GetIntensity() const { return push.custom.intensity; }
 };
 
 
@@ -311,6 +359,8 @@ struct EffectDither final : EffectSimple< EffectDither_PushConst, "EffectDither"
         return EffectSimple::Setup(
             args, params->isActive, params->transitionDurationIn, params->transitionDurationOut );
     }
+
+    float GetIntensity() const { return push.custom.intensity; }
 };
 
 
@@ -319,26 +369,37 @@ struct EffectDither final : EffectSimple< EffectDither_PushConst, "EffectDither"
 
 struct EffectHDRPrepare_PushConst
 {
-    float crosstalk_r;
-    float crosstalk_g;
-    float crosstalk_b;
-    float hdrBrightnessMult;
+    float            crosstalk_r;
+    float            crosstalk_g;
+    float            crosstalk_b;
+    float            hdrBrightnessMult;
+    EffectTransition dither;
+    float            ditherIntensity;
 };
 
 struct EffectHDRPrepare final : EffectSimple< EffectHDRPrepare_PushConst, "EffectHDRPrepare" >
 {
     using EffectSimple::EffectSimple;
 
-    bool Setup( const CommonnlyUsedEffectArguments& args, const RgDrawFrameTonemappingParams& tnmp )
+    // Permutation to apply dither in the same dispatch
+    constexpr static uint32_t PERMUTATION_WITH_DITHER = 1;
+
+    // If 'fusedDither' is not null, this instance must be
+    // created with PERMUTATION_WITH_DITHER, and 'fusedDither' must be set up
+    bool Setup( const CommonnlyUsedEffectArguments& args,
+                const RgDrawFrameTonemappingParams& tnmp,
+                const EffectDither*                 fusedDither = nullptr )
     {
         GetPush() = EffectHDRPrepare_PushConst{
             .crosstalk_r       = tnmp.crosstalk.data[ 0 ],
             .crosstalk_g       = tnmp.crosstalk.data[ 1 ],
             .crosstalk_b       = tnmp.crosstalk.data[ 2 ],
             .hdrBrightnessMult = tnmp.hdrBrightness,
+            .dither            = fusedDither ? fusedDither->GetTransition() : EffectTransition{},
+            .ditherIntensity   = fusedDither ? fusedDither->GetIntensity() : 0.0f,
         };
         return EffectSimple::Setup( args, true, 0, 0 );
     }
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,246 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "EmissiveTriangles.h"
+
+#include "RgException.h"
+#include "Utils.h"
+
+#include <cassert>
+#include <cmath>
+#include <span>
+
+namespace
+{
+
+float TriangleArea( const RgFloat3D& a, const RgFloat3D& b, const RgFloat3D& c )
+{
+    const float e1[] = {
+        b.data[ 0 ] - a.data[ 0 ],
+        b.data[ 1 ] - a.data[ 1 ],
+        b.data[ 2 ] - a.data[ 2 ],
+    };
+    const float e2[] = {
+        c.data[ 0 ] - a.data[ 0 ],
+        c.data[ 1 ] - a.data[ 1 ],
+        c.data[ 2 ] - a.data[ 2 ],
+    };
+    const float cr[] = {
+        e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ],
+        e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ],
+        e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ],
+    };
+    return 0.5f * std::sqrt( RTGL1::Utils::Dot( cr, cr ) );
+}
+
+// Vose's alias method
+void FillAliasTable( std::span< RTGL1::ShEmissiveTriangle > dst, std::span< const float > power )
+{
+    assert( dst.size() == power.size() );
+
+    double sum = 0;
+    for( float p : power )
+    {
+        sum += p;
+    }
+    assert( sum > 0 );
+
+    const auto n = uint32_t( dst.size() );
+
+    auto scaled = std::vector< double >( n );
+    auto small  = std::vector< uint32_t >{};
+    auto large  = std::vector< uint32_t >{};
+
+    for( uint32_t i = 0; i < n; i++ )
+    {
+        dst[ i ].selectPdf = float( double( power[ i ] ) / sum );
+
+        scaled[ i ] = double( power[ i ] ) / sum * n;
+        ( scaled[ i ] < 1.0 ? small : large ).push_back( i );
+    }
+
+    while( !small.empty() && !large.empty() )
+    {
+        const uint32_t s = small.back();
+        const uint32_t l = large.back();
+        small.pop_back();
+        large.pop_back();
+
+        dst[ s ].aliasProb  = float( scaled[ s ] );
+        dst[ s ].aliasIndex = l;
+
+        scaled[ l ] = ( scaled[ l ] + scaled[ s ] ) - 1.0;
+        ( scaled[ l ] < 1.0 ? small : large ).push_back( l );
+    }
+
+    // remaining are 1.0, up to a precision
+    for( auto rest : { &small, &large } )
+    {
+        for( uint32_t i : *rest )
+        {
+            dst[ i ].aliasProb  = 1.0f;
+            dst[ i ].aliasIndex = i;
+        }
+    }
+}
+
+}
+
+RTGL1::EmissiveTriangles::EmissiveTriangles( std::shared_ptr< MemoryAllocator > allocator )
+{
+    buffer = std::make_unique< AutoBuffer >( std::move( allocator ) );
+    buffer->Create( sizeof( ShEmissiveTriangle ) * MAX_EMISSIVE_TRIANGLE_COUNT,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    "Emissive triangles",
+                    1 );
+}
+
+bool RTGL1::EmissiveTriangles::IsEmissive( const RgMeshPrimitiveInfo& primitive,
+                                           const MaterialTextures&    baseTextures )
+{
+    return primitive.emissive > 0.0f ||
+           baseTextures.indices[ TEXTURE_EMISSIVE_INDEX ] != EMPTY_TEXTURE_INDEX;
+}
+
+void RTGL1::EmissiveTriangles::Reset()
+{
+    triangles.clear();
+    power.clear();
+}
+
+bool RTGL1::EmissiveTriangles::Add( const RgTransform&         transform,
+                                    const RgMeshPrimitiveInfo& primitive,
+                                    const MaterialTextures&    baseTextures,
+                                    RgColor4DPacked32          baseColor )
+{
+    const uint32_t triangleCount =
+        ( Utils::HasIndices( primitive ) ? primitive.indexCount : primitive.vertexCount ) / 3;
+
+    if( triangleCount == 0 || !primitive.pVertices )
+    {
+        return false;
+    }
+
+    if( triangles.size() + triangleCount > MAX_EMISSIVE_TRIANGLE_COUNT )
+    {
+        debug::Warning( "Too many emissive triangles: the limit is {}. "
+                        "Others won't be importance sampled",
+                        MAX_EMISSIVE_TRIANGLE_COUNT );
+        return false;
+    }
+
+    const uint32_t texEmissive = baseTextures.indices[ TEXTURE_EMISSIVE_INDEX ];
+    const float    emissive    = Utils::Saturate( primitive.emissive );
+    const RgFloat4D colorBase  = Utils::UnpackColor4DPacked32( baseColor );
+
+    // emissive texture is not known on CPU, so assume its average as 1
+    const float mult = texEmissive != EMPTY_TEXTURE_INDEX ? 1.0f : emissive;
+
+    for( uint32_t t = 0; t < triangleCount; t++ )
+    {
+        const RgPrimitiveVertex* v[] = {
+            &primitive.pVertices[ Utils::GetIndex( primitive, t * 3 + 0 ) ],
+            &primitive.pVertices[ Utils::GetIndex( primitive, t * 3 + 1 ) ],
+            &primitive.pVertices[ Utils::GetIndex( primitive, t * 3 + 2 ) ],
+        };
+
+        const RgFloat3D p[] = {
+            Utils::ApplyTransform( transform, RgFloat3D{ RG_ACCESS_VEC3( v[ 0 ]->position ) } ),
+            Utils::ApplyTransform( transform, RgFloat3D{ RG_ACCESS_VEC3( v[ 1 ]->position ) } ),
+            Utils::ApplyTransform( transform, RgFloat3D{ RG_ACCESS_VEC3( v[ 2 ]->position ) } ),
+        };
+
+        // vertex colors are averaged over a triangle
+        float color[ 3 ] = {};
+        for( const auto* vert : v )
+        {
+            const RgFloat3D c = Utils::UnpackColor4DPacked32< RgFloat3D >( vert->color );
+            for( int i = 0; i < 3; i++ )
+            {
+                color[ i ] += colorBase.data[ i ] * c.data[ i ] / 3.0f;
+            }
+        }
+
+        const float area = TriangleArea( p[ 0 ], p[ 1 ], p[ 2 ] );
+        const float pw   = area * mult * Utils::Luminance( color );
+
+        if( !( pw > 0.0f ) || !std::isfinite( pw ) )
+        {
+            continue;
+        }
+
+        triangles.push_back( ShEmissiveTriangle{
+            .p0_x           = p[ 0 ].data[ 0 ],
+            .p0_y           = p[ 0 ].data[ 1 ],
+            .p0_z           = p[ 0 ].data[ 2 ],
+            .p1_x           = p[ 1 ].data[ 0 ],
+            .p1_y           = p[ 1 ].data[ 1 ],
+            .p1_z           = p[ 1 ].data[ 2 ],
+            .p2_x           = p[ 2 ].data[ 0 ],
+            .p2_y           = p[ 2 ].data[ 1 ],
+            .p2_z           = p[ 2 ].data[ 2 ],
+            .u0             = v[ 0 ]->texCoord[ 0 ],
+            .v0             = v[ 0 ]->texCoord[ 1 ],
+            .u1             = v[ 1 ]->texCoord[ 0 ],
+            .v1             = v[ 1 ]->texCoord[ 1 ],
+            .u2             = v[ 2 ]->texCoord[ 0 ],
+            .v2             = v[ 2 ]->texCoord[ 1 ],
+            .texture_base   = baseTextures.indices[ TEXTURE_ALBEDO_ALPHA_INDEX ],
+            .texture_base_E = texEmissive,
+            .colorFactor    = Utils::PackColorFromFloat( color[ 0 ], color[ 1 ], color[ 2 ], 1 ),
+            .emissiveMult   = emissive,
+            .selectPdf      = { /* set in Upload */ },
+            .aliasProb      = { /* set in Upload */ },
+            .aliasIndex     = { /* set in Upload */ },
+        } );
+        power.push_back( pw );
+    }
+
+    return true;
+}
+
+void RTGL1::EmissiveTriangles::Upload( VkCommandBuffer cmd )
+{
+    uploadedCount = 0;
+
+    if( triangles.empty() )
+    {
+        return;
+    }
+
+    FillAliasTable( triangles, power );
+
+    const VkDeviceSize size = sizeof( ShEmissiveTriangle ) * triangles.size();
+
+    memcpy( buffer->GetMapped( 0 ), triangles.data(), size );
+    buffer->CopyFromStaging( cmd, 0, size );
+
+    uploadedCount = uint32_t( triangles.size() );
+}
+
+VkBuffer RTGL1::EmissiveTriangles::GetBuffer() const
+{
+    return buffer->GetDeviceLocal();
+}
+
+uint32_t RTGL1::EmissiveTriangles::GetCount() const
+{
+    return uploadedCount;
+}
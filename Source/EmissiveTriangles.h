@@ -0,0 +1,69 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "AutoBuffer.h"
+#include "Generated/ShaderCommonC.h"
+#include "Material.h"
+
+#include <vector>
+
+namespace RTGL1
+{
+
+// World-space triangles of the static emissive primitives, with an alias table
+// to importance sample them by their approximate power in the direct illumination.
+// Rebuilt on each static geometry upload.
+class EmissiveTriangles
+{
+public:
+    explicit EmissiveTriangles( std::shared_ptr< MemoryAllocator > allocator );
+    ~EmissiveTriangles() = default;
+
+    EmissiveTriangles( const EmissiveTriangles& other )                = delete;
+    EmissiveTriangles( EmissiveTriangles&& other ) noexcept            = delete;
+    EmissiveTriangles& operator=( const EmissiveTriangles& other )     = delete;
+    EmissiveTriangles& operator=( EmissiveTriangles&& other ) noexcept = delete;
+
+    static bool IsEmissive( const RgMeshPrimitiveInfo& primitive,
+                            const MaterialTextures&    baseTextures );
+
+    void Reset();
+    // Returns false, if the primitive wasn't added, e.g. the limit was reached
+    bool Add( const RgTransform&         transform,
+              const RgMeshPrimitiveInfo& primitive,
+              const MaterialTextures&    baseTextures,
+              RgColor4DPacked32          baseColor );
+    void Upload( VkCommandBuffer cmd );
+
+    VkBuffer GetBuffer() const;
+    // Count of triangles that were uploaded to the device
+    uint32_t GetCount() const;
+
+private:
+    std::vector< ShEmissiveTriangle > triangles;
+    std::vector< float >              power;
+
+    std::unique_ptr< AutoBuffer > buffer;
+    uint32_t                      uploadedCount{ 0 };
+};
+
+}
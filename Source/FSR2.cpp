@@ -213,12 +213,7 @@ RTGL1::FSR2::FSR2( VkDevice _device, VkPhysicalDevice _physDevice )
 
 RTGL1::FSR2::~FSR2()
 {
-    if( m_context )
-    {
-        pfn.ffxFsr2ContextDestroy( m_context );
-        delete m_context;
-    }
-
+    DestroyContext();
     FreeDlls( m_loadedDlls );
 }
 
@@ -238,17 +233,28 @@ auto RTGL1::FSR2::MakeInstance( VkDevice device, VkPhysicalDevice physDevice )
     return inst;
 }
 
-void RTGL1::FSR2::OnFramebuffersSizeChange( const ResolutionState& resolutionState )
+void RTGL1::FSR2::DestroyContext()
 {
     if( m_context )
     {
         pfn.ffxFsr2ContextDestroy( m_context );
-        *m_context = {};
-    }
-    else
-    {
-        m_context = new FfxFsr2Context{};
+        delete m_context;
+        m_context = nullptr;
     }
+    m_scratchBuffer.clear();
+    m_scratchBuffer.shrink_to_fit();
+}
+
+void RTGL1::FSR2::OnFramebuffersSizeChange( const ResolutionState& resolutionState )
+{
+    // don't allocate FSR2 internal resources, until FSR2 is actually used
+    DestroyContext();
+}
+
+void RTGL1::FSR2::CreateContext( const ResolutionState& resolutionState )
+{
+    assert( !m_context );
+    m_context = new FfxFsr2Context{};
 
     FfxErrorCode r{};
 
@@ -387,6 +393,11 @@ RTGL1::FramebufferImageIndex RTGL1::FSR2::Apply( VkCommandBuffer               c
 {
     assert( nearPlane > 0.0f && nearPlane < farPlane );
 
+    if( !m_context )
+    {
+        CreateContext( renderResolution.GetAllocationState() );
+    }
+
     using FI = FramebufferImageIndex;
 
     FI rs[] = {
@@ -398,13 +409,13 @@ RTGL1::FramebufferImageIndex RTGL1::FSR2::Apply( VkCommandBuffer               c
     // clang-format off
     FfxFsr2DispatchDescription info = {
         .commandList                = pfn.ffxGetCommandListVK( cmd ),
-        .color                      = ToFSRResource( FI::FB_IMAGE_INDEX_FINAL, frameIndex, m_context, framebuffers, renderResolution.GetResolutionState() ),
-        .depth                      = ToFSRResource( FI::FB_IMAGE_INDEX_DEPTH_NDC, frameIndex, m_context, framebuffers, renderResolution.GetResolutionState() ),
-        .motionVectors              = ToFSRResource( FI::FB_IMAGE_INDEX_MOTION_DLSS, frameIndex, m_context, framebuffers, renderResolution.GetResolutionState() ),
+        .color                      = ToFSRResource( FI::FB_IMAGE_INDEX_FINAL, frameIndex, m_context, framebuffers, framebuffers.GetAllocatedResolution() ),
+        .depth                      = ToFSRResource( FI::FB_IMAGE_INDEX_DEPTH_NDC, frameIndex, m_context, framebuffers, framebuffers.GetAllocatedResolution() ),
+        .motionVectors              = ToFSRResource( FI::FB_IMAGE_INDEX_MOTION_DLSS, frameIndex, m_context, framebuffers, framebuffers.GetAllocatedResolution() ),
         .exposure                   = {},
-        .reactive                   = ToFSRResource( FI::FB_IMAGE_INDEX_REACTIVITY, frameIndex, m_context, framebuffers, renderResolution.GetResolutionState() ),
+        .reactive                   = ToFSRResource( FI::FB_IMAGE_INDEX_REACTIVITY, frameIndex, m_context, framebuffers, framebuffers.GetAllocatedResolution() ),
         .transparencyAndComposition = {},
-        .output                     = ToFSRResource( OUTPUT_IMAGE_INDEX, frameIndex, m_context, framebuffers, renderResolution.GetResolutionState() ),
+        .output                     = ToFSRResource( OUTPUT_IMAGE_INDEX, frameIndex, m_context, framebuffers, framebuffers.GetAllocatedResolution() ),
         .jitterOffset               = { -jitterOffset.data[ 0 ], -jitterOffset.data[ 1 ] },
         .motionVectorScale          = { float( renderResolution.GetResolutionState().renderWidth ), float( renderResolution.GetResolutionState().renderHeight ) },
         .renderSize                 = { renderResolution.GetResolutionState().renderWidth, renderResolution.GetResolutionState().renderHeight },
@@ -62,6 +62,8 @@ public:
 
 private:
     bool Valid() const;
+    void CreateContext( const ResolutionState& resolutionState );
+    void DestroyContext();
 
 private:
     VkDevice         device;
@@ -24,6 +24,7 @@
 #include "LibraryConfig.h"
 #include "RenderResolutionHelper.h"
 #include "RgException.h"
+#include "UpscalerInputs.h"
 #include "Utils.h"
 
 #include "DX12_CopyFramebuf.h"
@@ -331,12 +332,7 @@ RTGL1::FSR3_DX12::~FSR3_DX12()
 namespace
 {
 
-constexpr RTGL1::FramebufferImageIndex INPUT_IMAGE_INDICES[] = {
-    RTGL1::FB_IMAGE_INDEX_FINAL,
-    RTGL1::FB_IMAGE_INDEX_DEPTH_NDC,
-    RTGL1::FB_IMAGE_INDEX_MOTION_DLSS,
-    RTGL1::FB_IMAGE_INDEX_REACTIVITY,
-};
+constexpr const auto& INPUT_IMAGE_INDICES = RTGL1::UPSCALER_INPUT_IMAGES;
 
 constexpr RTGL1::FramebufferImageIndex OUTPUT_IMAGE_INDEX = RTGL1::FB_IMAGE_INDEX_UPSCALED_PONG;
 
@@ -501,12 +497,11 @@ void RTGL1::FSR3_DX12::CopyVkInputsToDX12( VkCommandBuffer        cmd,
     // if fails, need support for .._Prev framebufs
     {
         assert( framebuffers.GetImage( OUTPUT_IMAGE_INDEX, frameIndex ) ==
-                framebuffers.GetImage( OUTPUT_IMAGE_INDEX,
-                                       ( frameIndex + 1 ) % RTGL1::MAX_FRAMES_IN_FLIGHT ) );
+                framebuffers.GetImage( OUTPUT_IMAGE_INDEX, Utils::PrevFrame( frameIndex ) ) );
         for( auto f : INPUT_IMAGE_INDICES )
         {
             assert( framebuffers.GetImage( f, frameIndex ) ==
-                    framebuffers.GetImage( f, ( frameIndex + 1 ) % RTGL1::MAX_FRAMES_IN_FLIGHT ) );
+                    framebuffers.GetImage( f, Utils::PrevFrame( frameIndex ) ) );
         }
     }
 
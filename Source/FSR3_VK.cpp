@@ -0,0 +1,609 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FSR3_VK.h"
+
+#include "LibraryConfig.h"
+#include "RenderResolutionHelper.h"
+#include "Utils.h"
+
+#include "Generated/ShaderCommonC.h"
+
+#include <FidelityFX/host/ffx_fsr3.h>
+#include <FidelityFX/host/backends/vk/ffx_vk.h>
+
+namespace
+{
+#define DECLARE_DLL_FUNC( f ) decltype( &( f ) ) f = nullptr
+
+struct FsrSdk
+{
+    DECLARE_DLL_FUNC( ffxFsr3ConfigureFrameGeneration );
+    DECLARE_DLL_FUNC( ffxFsr3ContextCreate );
+    DECLARE_DLL_FUNC( ffxFsr3ContextDestroy );
+    DECLARE_DLL_FUNC( ffxFsr3ContextDispatchUpscale );
+    DECLARE_DLL_FUNC( ffxFsr3DispatchFrameGeneration );
+    DECLARE_DLL_FUNC( ffxFsr3GetJitterOffset );
+    DECLARE_DLL_FUNC( ffxFsr3GetJitterPhaseCount );
+
+    DECLARE_DLL_FUNC( ffxGetCommandListVK );
+    DECLARE_DLL_FUNC( ffxGetDeviceVK );
+    DECLARE_DLL_FUNC( ffxGetInterfaceVK );
+    DECLARE_DLL_FUNC( ffxGetResourceVK );
+    DECLARE_DLL_FUNC( ffxGetScratchMemorySizeVK );
+};
+
+FfxSurfaceFormat ToFfxFormat( VkFormat f )
+{
+    switch( f )
+    {
+        case VK_FORMAT_R32G32B32A32_UINT: return FFX_SURFACE_FORMAT_R32G32B32A32_UINT;
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return FFX_SURFACE_FORMAT_R32G32B32A32_FLOAT;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return FFX_SURFACE_FORMAT_R16G16B16A16_FLOAT;
+        case VK_FORMAT_R32G32_SFLOAT: return FFX_SURFACE_FORMAT_R32G32_FLOAT;
+        case VK_FORMAT_R8_UINT: return FFX_SURFACE_FORMAT_R8_UINT;
+        case VK_FORMAT_R32_UINT: return FFX_SURFACE_FORMAT_R32_UINT;
+        case VK_FORMAT_R8G8B8A8_UNORM: return FFX_SURFACE_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_R8G8B8A8_SNORM: return FFX_SURFACE_FORMAT_R8G8B8A8_SNORM;
+        case VK_FORMAT_R8G8B8A8_SRGB: return FFX_SURFACE_FORMAT_R8G8B8A8_SRGB;
+        case VK_FORMAT_R16G16_SFLOAT: return FFX_SURFACE_FORMAT_R16G16_FLOAT;
+        case VK_FORMAT_R16G16_UINT: return FFX_SURFACE_FORMAT_R16G16_UINT;
+        case VK_FORMAT_R16G16_SINT: return FFX_SURFACE_FORMAT_R16G16_SINT;
+        case VK_FORMAT_R16_SFLOAT: return FFX_SURFACE_FORMAT_R16_FLOAT;
+        case VK_FORMAT_R16_UINT: return FFX_SURFACE_FORMAT_R16_UINT;
+        case VK_FORMAT_R16_UNORM: return FFX_SURFACE_FORMAT_R16_UNORM;
+        case VK_FORMAT_R16_SNORM: return FFX_SURFACE_FORMAT_R16_SNORM;
+        case VK_FORMAT_R8_UNORM: return FFX_SURFACE_FORMAT_R8_UNORM;
+        case VK_FORMAT_R8G8_UNORM: return FFX_SURFACE_FORMAT_R8G8_UNORM;
+        case VK_FORMAT_R8G8_UINT: return FFX_SURFACE_FORMAT_R8G8_UINT;
+        case VK_FORMAT_R32_SFLOAT: return FFX_SURFACE_FORMAT_R32_FLOAT;
+        default: assert( 0 ); return FFX_SURFACE_FORMAT_UNKNOWN;
+    }
+}
+
+void PrintFfxMessage( FfxMsgType type, const wchar_t* message )
+{
+    using namespace RTGL1;
+
+    if( !message )
+    {
+        return;
+    }
+
+    char   str[ 256 ];
+    size_t len{ 0 };
+    if( wcstombs_s( &len, str, message, std::size( str ) ) != 0 )
+    {
+        debug::Error( "PrintFfxMessage: wcstombs_s failed" );
+    }
+    str[ std::size( str ) - 1 ] = '\0';
+
+    switch( type )
+    {
+        case FFX_MESSAGE_TYPE_ERROR: debug::Error( str ); break;
+        case FFX_MESSAGE_TYPE_WARNING: debug::Warning( str ); break;
+        case FFX_MESSAGE_TYPE_COUNT:
+        default: assert( 0 );
+    }
+}
+
+// Wrapper to keep path lifetime
+HMODULE LoadLibrary_Path( const std::filesystem::path& p )
+{
+    // FSR3's dll has other dlls as dependencies, find them in the same folder
+    HMODULE dll = LoadLibraryExW( p.c_str(), nullptr, LOAD_WITH_ALTERED_SEARCH_PATH );
+    if( !dll )
+    {
+        RTGL1::debug::Error( "FSR3: Failed to load DLL \'{}\'", p.string() );
+    }
+    return dll;
+}
+
+FsrSdk pfn{};
+
+void FreeDlls( const std::vector< void* >& dlls )
+{
+    for( void* ptr : dlls )
+    {
+        FreeLibrary( static_cast< HMODULE >( ptr ) );
+    }
+}
+
+#define RETURN_FAIL         \
+    pfn = {};               \
+    FreeDlls( loadedDlls ); \
+    return {}
+
+#define GET_FUNC( dll, f )                                                          \
+    do                                                                              \
+    {                                                                               \
+        pfn.f = reinterpret_cast< decltype( pfn.f ) >( GetProcAddress( dll, #f ) ); \
+        if( !pfn.f )                                                                \
+        {                                                                           \
+            RTGL1::debug::Error( "FSR3: Failed to load DLL function: \'" #f "\'" ); \
+            RETURN_FAIL;                                                            \
+        }                                                                           \
+    } while( 0 )
+
+auto LoadDllFunctions( const std::filesystem::path& folder ) -> std::vector< void* >
+{
+    auto loadedDlls = std::vector< void* >{};
+
+    if( auto fsr3dll = LoadLibrary_Path( folder / "ffx_fsr3_x64.dll" ) )
+    {
+        loadedDlls.push_back( fsr3dll );
+        GET_FUNC( fsr3dll, ffxFsr3ConfigureFrameGeneration );
+        GET_FUNC( fsr3dll, ffxFsr3ContextCreate );
+        GET_FUNC( fsr3dll, ffxFsr3ContextDestroy );
+        GET_FUNC( fsr3dll, ffxFsr3ContextDispatchUpscale );
+        GET_FUNC( fsr3dll, ffxFsr3DispatchFrameGeneration );
+        GET_FUNC( fsr3dll, ffxFsr3GetJitterOffset );
+        GET_FUNC( fsr3dll, ffxFsr3GetJitterPhaseCount );
+    }
+    else
+    {
+        RETURN_FAIL;
+    }
+
+    if( auto vkdll = LoadLibrary_Path( folder / "ffx_backend_vk_x64.dll" ) )
+    {
+        loadedDlls.push_back( vkdll );
+        GET_FUNC( vkdll, ffxGetCommandListVK );
+        GET_FUNC( vkdll, ffxGetDeviceVK );
+        GET_FUNC( vkdll, ffxGetInterfaceVK );
+        GET_FUNC( vkdll, ffxGetResourceVK );
+        GET_FUNC( vkdll, ffxGetScratchMemorySizeVK );
+    }
+    else
+    {
+        RETURN_FAIL;
+    }
+
+    return loadedDlls;
+}
+
+}
+
+RTGL1::FSR3_VK::FSR3_VK( VkDevice _device, VkPhysicalDevice _physDevice )
+    : device{ _device } //
+    , physDevice{ _physDevice }
+{
+    m_loadedDlls = LoadDllFunctions( Utils::FindBinFolder() );
+    if( m_loadedDlls.empty() )
+    {
+        debug::Error( "FSR3: Failed to initialize DLL-s. "
+                      "Vulkan FSR3 frame generation will not be available." );
+    }
+}
+
+RTGL1::FSR3_VK::~FSR3_VK()
+{
+    DestroyContext();
+    FreeDlls( m_loadedDlls );
+}
+
+bool RTGL1::FSR3_VK::Valid() const
+{
+    return !m_loadedDlls.empty();
+}
+
+bool RTGL1::FSR3_VK::IsAvailable() const
+{
+    return Valid() && !m_failed;
+}
+
+auto RTGL1::FSR3_VK::MakeInstance( VkDevice device, VkPhysicalDevice physDevice )
+    -> std::shared_ptr< FSR3_VK >
+{
+    auto inst = std::make_shared< FSR3_VK >( device, physDevice );
+    if( !inst || !inst->Valid() )
+    {
+        return {};
+    }
+    return inst;
+}
+
+void RTGL1::FSR3_VK::DestroyContext()
+{
+    if( m_context )
+    {
+        pfn.ffxFsr3ContextDestroy( m_context );
+        delete m_context;
+        m_context = nullptr;
+    }
+    m_frameGenerationEnabled = false;
+    m_lastFrameId            = std::nullopt;
+    m_resetInterpolation     = true;
+}
+
+void RTGL1::FSR3_VK::OnFramebuffersSizeChange( const ResolutionState& resolutionState )
+{
+    // FSR3 context is heavy, so create it lazily: only if frame generation is actually used
+    DestroyContext();
+}
+
+bool RTGL1::FSR3_VK::CreateContext( const ResolutionState& resolutionState, VkFormat presentFormat )
+{
+    assert( !m_context );
+
+    auto contextDevice = VkDeviceContext{
+        device,
+        physDevice,
+        vkGetDeviceProcAddr,
+    };
+
+    // maxContexts are hardcoded from the SDK sample
+    auto l_fetchInterface = [ this ]( FfxErrorCode&           err,
+                                      FfxDevice               d,
+                                      uint32_t                maxContexts,
+                                      std::vector< uint8_t >& scratch ) -> FfxInterface {
+        if( err == FFX_OK )
+        {
+            scratch.resize( pfn.ffxGetScratchMemorySizeVK( physDevice, maxContexts ) );
+            std::ranges::fill( scratch, 0 );
+
+            FfxInterface interf{};
+            err = pfn.ffxGetInterfaceVK( &interf, //
+                                         d,
+                                         scratch.data(),
+                                         scratch.size(),
+                                         maxContexts );
+            return interf;
+        }
+        return {};
+    };
+
+    auto r = FfxErrorCode{ FFX_OK };
+    auto d = FfxDevice{ pfn.ffxGetDeviceVK( &contextDevice ) };
+
+    // clang-format off
+    auto contextDesc = FfxFsr3ContextDescription{
+        .flags             = FFX_FSR3_ENABLE_AUTO_EXPOSURE |
+                             FFX_FSR3_ENABLE_HIGH_DYNAMIC_RANGE |
+                             ( LibConfig().fsrValidation ? FFX_FSR3_ENABLE_DEBUG_CHECKING : 0u ),
+        .maxRenderSize     = { resolutionState.renderWidth, resolutionState.renderHeight },
+        .upscaleOutputSize = { resolutionState.upscaledWidth, resolutionState.upscaledHeight },
+        .displaySize       = { resolutionState.upscaledWidth, resolutionState.upscaledHeight },
+        .backendInterfaceSharedResources    = l_fetchInterface( r, d, 1, m_scratchBufferSharedResources ),
+        .backendInterfaceUpscaling          = l_fetchInterface( r, d, 1, m_scratchBufferUpscaling ),
+        .backendInterfaceFrameInterpolation = l_fetchInterface( r, d, 2, m_scratchBufferFrameInterpolation ),
+        .fpMessage                          = PrintFfxMessage,
+        .backBufferFormat                   = ToFfxFormat( presentFormat ),
+    };
+    // clang-format on
+    if( r != FFX_OK )
+    {
+        debug::Error( "FSR3: ffxGetInterfaceVK fail: {}", int( r ) );
+        return false;
+    }
+
+    m_context = new FfxFsr3Context{};
+
+    r = pfn.ffxFsr3ContextCreate( m_context, &contextDesc );
+    if( r != FFX_OK )
+    {
+        debug::Error( "FSR3: ffxFsr3ContextCreate fail: {}", int( r ) );
+        delete m_context;
+        m_context = nullptr;
+        return false;
+    }
+
+    m_frameGenerationEnabled = false;
+    m_lastFrameId            = std::nullopt;
+    m_resetInterpolation     = true;
+    return true;
+}
+
+namespace
+{
+
+constexpr RTGL1::FramebufferImageIndex OUTPUT_IMAGE_INDEX = RTGL1::FB_IMAGE_INDEX_UPSCALED_PONG;
+constexpr RTGL1::FramebufferImageIndex GENERATED_IMAGE_INDEX =
+    RTGL1::FB_IMAGE_INDEX_FRAME_GENERATED;
+
+FfxResource ToFSRResource( RTGL1::FramebufferImageIndex  fbImage,
+                           uint32_t                      frameIndex,
+                           const RTGL1::Framebuffers&    framebuffers,
+                           const RTGL1::ResolutionState& resolutionState,
+                           bool                          isOutput )
+{
+    auto [ image, view, format, sz ] =
+        framebuffers.GetImageHandles( fbImage, frameIndex, resolutionState );
+
+    auto desc = FfxResourceDescription{
+        .type     = FFX_RESOURCE_TYPE_TEXTURE2D,
+        .format   = ToFfxFormat( format ),
+        .width    = sz.width,
+        .height   = sz.height,
+        .depth    = 1,
+        .mipCount = 1,
+        .flags    = FFX_RESOURCE_FLAGS_NONE,
+        .usage    = isOutput ? FFX_RESOURCE_USAGE_UAV : FFX_RESOURCE_USAGE_READ_ONLY,
+    };
+
+    FfxResourceStates state =
+        isOutput ? FFX_RESOURCE_STATE_UNORDERED_ACCESS : FFX_RESOURCE_STATE_COMPUTE_READ;
+
+    wchar_t name[ 64 ];
+    wcscpy_s( name, RTGL1::ShFramebuffers_DebugNamesW[ fbImage ] );
+    name[ std::size( name ) - 1 ] = '\0';
+
+    return pfn.ffxGetResourceVK( image, desc, name, state );
+}
+
+template< size_t N >
+void InsertBarriers( VkCommandBuffer                    cmd,
+                     uint32_t                           frameIndex,
+                     const RTGL1::Framebuffers&         framebuffers,
+                     const RTGL1::FramebufferImageIndex ( &inputsAndOutput )[ N ],
+                     RTGL1::FramebufferImageIndex       output,
+                     bool                               isBackwards )
+{
+    assert( std::ranges::contains( inputsAndOutput, output ) );
+
+    VkImageMemoryBarrier2 barriers[ N ];
+
+    for( size_t i = 0; i < N; i++ )
+    {
+        barriers[ i ] = {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .srcAccessMask       = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask       = inputsAndOutput[ i ] == output ? VK_ACCESS_2_SHADER_WRITE_BIT : VK_ACCESS_2_SHADER_READ_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_GENERAL,
+            .newLayout           = inputsAndOutput[ i ] == output ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = framebuffers.GetImage( inputsAndOutput[ i ], frameIndex ),
+            .subresourceRange    = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .baseMipLevel = 0,
+                .levelCount = 1,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+        };
+
+        if( isBackwards )
+        {
+            auto& b = barriers[ i ];
+
+            std::swap( b.srcStageMask, b.dstStageMask );
+            std::swap( b.srcAccessMask, b.dstAccessMask );
+            std::swap( b.oldLayout, b.newLayout );
+            std::swap( b.srcQueueFamilyIndex, b.dstQueueFamilyIndex );
+        }
+    }
+
+    VkDependencyInfoKHR dependencyInfo = {
+        .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+        .imageMemoryBarrierCount = uint32_t( std::size( barriers ) ),
+        .pImageMemoryBarriers    = barriers,
+    };
+
+    RTGL1::svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
+}
+
+}
+
+auto RTGL1::FSR3_VK::Apply( VkCommandBuffer               cmd,
+                            uint32_t                      frameIndex,
+                            const Framebuffers&           framebuffers,
+                            const RenderResolutionHelper& renderResolution,
+                            RgFloat2D                     jitterOffset,
+                            double                        timeDelta,
+                            float                         nearPlane,
+                            float                         farPlane,
+                            float                         fovVerticalRad,
+                            bool                          resetAccumulation,
+                            float                         oneGameUnitInMeters,
+                            uint32_t                      frameId,
+                            bool skipGeneratedFrame ) -> std::optional< FramebufferImageIndex >
+{
+    if( !IsAvailable() )
+    {
+        assert( 0 );
+        return {};
+    }
+
+    assert( nearPlane > 0.0f && nearPlane < farPlane );
+    const auto& resolution = renderResolution.GetResolutionState();
+    const auto& allocation = framebuffers.GetAllocatedResolution();
+
+    if( !m_context )
+    {
+        auto [ img, view, presentFormat ] =
+            framebuffers.GetImageHandles( GENERATED_IMAGE_INDEX, frameIndex );
+
+        if( !CreateContext( renderResolution.GetAllocationState(), presentFormat ) )
+        {
+            m_failed = true;
+            return {};
+        }
+    }
+
+    const bool frameGeneration = !skipGeneratedFrame;
+
+    if( m_frameGenerationEnabled != frameGeneration )
+    {
+        // no swapchain: the generated frame is dispatched by Interpolate()
+        auto framegenConfig = FfxFrameGenerationConfig{
+            .swapChain               = nullptr,
+            .presentCallback         = nullptr,
+            .frameGenerationCallback = pfn.ffxFsr3DispatchFrameGeneration,
+            .frameGenerationEnabled  = frameGeneration,
+            .allowAsyncWorkloads     = false,
+            .HUDLessColor            = FfxResource{},
+            .flags                   = 0,
+            .onlyPresentInterpolated = false,
+        };
+
+        FfxErrorCode r = pfn.ffxFsr3ConfigureFrameGeneration( m_context, &framegenConfig );
+        if( r != FFX_OK )
+        {
+            debug::Error( "FSR3: ffxFsr3ConfigureFrameGeneration fail: {}", int( r ) );
+            m_failed = true;
+            return {};
+        }
+
+        m_frameGenerationEnabled = frameGeneration;
+        m_resetInterpolation     = true;
+    }
+
+    // history is invalid, if there was a gap (e.g. FSR2 was used in between)
+    const bool reset = resetAccumulation || !m_lastFrameId || *m_lastFrameId + 1 != frameId;
+    m_lastFrameId    = frameId;
+    m_resetInterpolation |= reset;
+
+    using FI = FramebufferImageIndex;
+
+    FI rs[] = {
+        FI::FB_IMAGE_INDEX_FINAL,      FI::FB_IMAGE_INDEX_DEPTH_NDC, FI::FB_IMAGE_INDEX_MOTION_DLSS,
+        FI::FB_IMAGE_INDEX_REACTIVITY, OUTPUT_IMAGE_INDEX,
+    };
+    InsertBarriers( cmd, frameIndex, framebuffers, rs, OUTPUT_IMAGE_INDEX, false );
+
+    // clang-format off
+    auto info = FfxFsr3DispatchUpscaleDescription{
+        .commandList                   = pfn.ffxGetCommandListVK( cmd ),
+        .color                         = ToFSRResource( FI::FB_IMAGE_INDEX_FINAL, frameIndex, framebuffers, allocation, false ),
+        .depth                         = ToFSRResource( FI::FB_IMAGE_INDEX_DEPTH_NDC, frameIndex, framebuffers, allocation, false ),
+        .motionVectors                 = ToFSRResource( FI::FB_IMAGE_INDEX_MOTION_DLSS, frameIndex, framebuffers, allocation, false ),
+        .exposure                      = FfxResource{},
+        .reactive                      = ToFSRResource( FI::FB_IMAGE_INDEX_REACTIVITY, frameIndex, framebuffers, allocation, false ),
+        .transparencyAndComposition    = FfxResource{},
+        .upscaleOutput                 = ToFSRResource( OUTPUT_IMAGE_INDEX, frameIndex, framebuffers, allocation, true ),
+        .jitterOffset                  = { -jitterOffset.data[ 0 ], -jitterOffset.data[ 1 ] },
+        .motionVectorScale             = { float( resolution.renderWidth ), float( resolution.renderHeight ) },
+        .renderSize                    = { resolution.renderWidth, resolution.renderHeight },
+        .enableSharpening              = renderResolution.IsCASInsideFSR2(),
+        .sharpness                     = renderResolution.GetSharpeningIntensity(),
+        .frameTimeDelta                = float( timeDelta * 1000.0 ),
+        .preExposure                   = 1.0f,
+        .reset                         = reset,
+        .cameraNear                    = nearPlane,
+        .cameraFar                     = farPlane,
+        .cameraFovAngleVertical        = fovVerticalRad,
+        .viewSpaceToMetersFactor       = oneGameUnitInMeters,
+    };
+    // clang-format on
+
+    FfxErrorCode r = pfn.ffxFsr3ContextDispatchUpscale( m_context, &info );
+    if( r != FFX_OK )
+    {
+        debug::Error( "FSR3: ffxFsr3ContextDispatchUpscale fail: {}", int( r ) );
+        m_failed = true;
+        return {};
+    }
+
+    InsertBarriers( cmd, frameIndex, framebuffers, rs, OUTPUT_IMAGE_INDEX, true );
+
+    return OUTPUT_IMAGE_INDEX;
+}
+
+auto RTGL1::FSR3_VK::Interpolate( VkCommandBuffer        cmd,
+                                  uint32_t               frameIndex,
+                                  const Framebuffers&    framebuffers,
+                                  const ResolutionState& resolutionState,
+                                  FramebufferImageIndex  presented,
+                                  uint32_t hdrDisplay ) -> std::optional< FramebufferImageIndex >
+{
+    if( !IsAvailable() || !m_context || !m_frameGenerationEnabled )
+    {
+        return {};
+    }
+
+    {
+        auto [ i1, v1, presentFormat ] = framebuffers.GetImageHandles( presented, frameIndex );
+        auto [ i2, v2, generatedFormat ] =
+            framebuffers.GetImageHandles( GENERATED_IMAGE_INDEX, frameIndex );
+
+        VkExtent2D presentSize = framebuffers.GetFramebufSize( resolutionState, presented );
+        VkExtent2D generatedSize =
+            framebuffers.GetFramebufSize( resolutionState, GENERATED_IMAGE_INDEX );
+
+        if( presentFormat != generatedFormat || presentSize.width != generatedSize.width ||
+            presentSize.height != generatedSize.height )
+        {
+            debug::Warning( "FSR3: Skipping frame generation, as the presented image {} "
+                            "doesn't match the back buffer description",
+                            ShFramebuffers_DebugNames[ presented ] );
+            return {};
+        }
+    }
+
+    auto transfer = FFX_BACKBUFFER_TRANSFER_FUNCTION_SRGB;
+    switch( hdrDisplay )
+    {
+        case HDR_DISPLAY_ST2084: transfer = FFX_BACKBUFFER_TRANSFER_FUNCTION_PQ; break;
+        case HDR_DISPLAY_LINEAR: transfer = FFX_BACKBUFFER_TRANSFER_FUNCTION_SCRGB; break;
+        default: break;
+    }
+
+    FramebufferImageIndex rs[] = { presented, GENERATED_IMAGE_INDEX };
+    InsertBarriers( cmd, frameIndex, framebuffers, rs, GENERATED_IMAGE_INDEX, false );
+
+    // clang-format off
+    auto desc = FfxFrameGenerationDispatchDescription{
+        .commandList                = pfn.ffxGetCommandListVK( cmd ),
+        .presentColor               = ToFSRResource( presented, frameIndex, framebuffers, resolutionState, false ),
+        .outputs                    = { ToFSRResource( GENERATED_IMAGE_INDEX, frameIndex, framebuffers, resolutionState, true ) },
+        .numInterpolatedFrames      = 1,
+        .reset                      = m_resetInterpolation,
+        .backBufferTransferFunction = transfer,
+        .minMaxLuminance            = { 0.0f, 1000.0f },
+    };
+    // clang-format on
+
+    FfxErrorCode r = pfn.ffxFsr3DispatchFrameGeneration( &desc );
+
+    InsertBarriers( cmd, frameIndex, framebuffers, rs, GENERATED_IMAGE_INDEX, true );
+
+    if( r != FFX_OK )
+    {
+        debug::Error( "FSR3: ffxFsr3DispatchFrameGeneration fail: {}", int( r ) );
+        return {};
+    }
+
+    m_resetInterpolation = false;
+    return GENERATED_IMAGE_INDEX;
+}
+
+RgFloat2D RTGL1::FSR3_VK::GetJitter( const ResolutionState& resolutionState,
+                                     uint32_t               frameId ) const
+{
+    if( !pfn.ffxFsr3GetJitterPhaseCount || !pfn.ffxFsr3GetJitterOffset )
+    {
+        assert( 0 );
+        return {};
+    }
+
+    int32_t id    = int32_t( frameId % uint32_t{ INT32_MAX } );
+    int32_t phase = pfn.ffxFsr3GetJitterPhaseCount( int32_t( resolutionState.renderWidth ),
+                                                    int32_t( resolutionState.upscaledWidth ) );
+
+    float x = 0, y = 0;
+
+    FfxErrorCode r = pfn.ffxFsr3GetJitterOffset( &x, &y, id, phase );
+    assert( r == FFX_OK );
+
+    return { x, y };
+}
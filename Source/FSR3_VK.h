@@ -0,0 +1,102 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Framebuffers.h"
+
+#include <optional>
+
+struct FfxFsr3Context;
+
+namespace RTGL1
+{
+class RenderResolutionHelper;
+
+// FSR3 upscaling and frame interpolation on the Vulkan backend of FidelityFX SDK.
+// Unlike FSR3_DX12, there's no frame interpolation swapchain: the generated frame
+// is written to FB_IMAGE_INDEX_FRAME_GENERATED, and presenting / pacing it is up to the caller.
+class FSR3_VK final : public IFramebuffersDependency
+{
+public:
+    static auto MakeInstance( VkDevice device, VkPhysicalDevice physDevice )
+        -> std::shared_ptr< FSR3_VK >;
+
+    FSR3_VK( VkDevice device, VkPhysicalDevice physDevice );
+    ~FSR3_VK() override;
+
+    FSR3_VK( const FSR3_VK& )                = delete;
+    FSR3_VK( FSR3_VK&& ) noexcept            = delete;
+    FSR3_VK& operator=( const FSR3_VK& )     = delete;
+    FSR3_VK& operator=( FSR3_VK&& ) noexcept = delete;
+
+    void OnFramebuffersSizeChange( const ResolutionState& resolutionState ) override;
+
+    // Null, if failed: then the instance should not be used anymore
+    auto Apply( VkCommandBuffer               cmd,
+                uint32_t                      frameIndex,
+                const Framebuffers&           framebuffers,
+                const RenderResolutionHelper& renderResolution,
+                RgFloat2D                     jitterOffset,
+                double                        timeDelta,
+                float                         nearPlane,
+                float                         farPlane,
+                float                         fovVerticalRad,
+                bool                          resetAccumulation,
+                float                         oneGameUnitInMeters,
+                uint32_t                      frameId,
+                bool skipGeneratedFrame ) -> std::optional< FramebufferImageIndex >;
+
+    // Must be called after Apply(), when the image to present is finalized.
+    // Returns the image that should be presented before 'presented'
+    auto Interpolate( VkCommandBuffer        cmd,
+                      uint32_t               frameIndex,
+                      const Framebuffers&    framebuffers,
+                      const ResolutionState& resolutionState,
+                      FramebufferImageIndex  presented,
+                      uint32_t               hdrDisplay ) -> std::optional< FramebufferImageIndex >;
+
+    RgFloat2D GetJitter( const ResolutionState& resolutionState, uint32_t frameId ) const;
+
+    bool IsAvailable() const;
+
+private:
+    bool Valid() const;
+    bool CreateContext( const ResolutionState& resolutionState, VkFormat presentFormat );
+    void DestroyContext();
+
+private:
+    VkDevice         device;
+    VkPhysicalDevice physDevice;
+
+    FfxFsr3Context*        m_context{};
+    std::vector< uint8_t > m_scratchBufferSharedResources{};
+    std::vector< uint8_t > m_scratchBufferUpscaling{};
+    std::vector< uint8_t > m_scratchBufferFrameInterpolation{};
+
+    bool                      m_frameGenerationEnabled{ false };
+    bool                      m_failed{ false };
+    std::optional< uint32_t > m_lastFrameId{};
+    bool                      m_resetInterpolation{ true };
+
+    std::vector< void* > m_loadedDlls{};
+};
+
+}
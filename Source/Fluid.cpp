@@ -26,6 +26,7 @@ SOFTWARE.
 
 #include "CmdLabel.h"
 #include "CommandBufferManager.h"
+#include "LibraryConfig.h"
 #include "Matrix.h"
 #include "MemoryAllocator.h"
 #include "RenderResolutionHelper.h"
@@ -52,6 +53,11 @@ namespace
     using IdToSource               = uint8_t;
     constexpr uint32_t MAX_SOURCES = std::numeric_limits< IdToSource >::max();
 
+    // level of detail: far sources and a high GPU frame time reduce spawn counts
+    constexpr float MIN_SPAWN_SCALE         = 1.0f / 16.0f;
+    constexpr float BUDGET_SCALE_DECREASE   = 0.9f;
+    constexpr float BUDGET_SCALE_INCREASE   = 1.02f;
+
     // visualization
 
     constexpr uint32_t QUAD_VERTEX_COUNT = 4;
@@ -67,6 +73,7 @@ namespace
 
     using uint = uint32_t;
     using vec3 = RgFloat3D;
+    using mat4 = std::array< float, 16 >;
 
     struct PARTICLESPUSH_T;
 
@@ -77,6 +84,26 @@ namespace
         float    zNear;
         float    zFar;
     };
+
+    void computeToComputeBarrier( VkCommandBuffer cmd )
+    {
+        auto b = VkMemoryBarrier2{
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext         = nullptr,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+        };
+        auto dpd = VkDependencyInfo{
+            .sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext              = nullptr,
+            .dependencyFlags    = 0,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dpd );
+    }
 }
 
 uint32_t RingBuf::length() const
@@ -177,6 +204,8 @@ RTGL1::Fluid::Fluid( VkDevice                                device,
     , m_sources{ allocator }
     , m_particleRadius{ std::clamp( particleRadius, 0.01f, 1.0f ) }
 {
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_FLUID };
+
     {
         fluidBudget = std::clamp( fluidBudget, 4096u, MAX_PARTICLES_DEFAULT );
         fluidBudget = Utils::Align( fluidBudget, 4096u );
@@ -189,6 +218,65 @@ RTGL1::Fluid::Fluid( VkDevice                                device,
                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                            "Fluid Particles" );
 
+    {
+        static_assert( 4096 % FLUID_HASH_SCAN_BLOCK_SIZE == 0,
+                       "Bucket count must be a multiple of a scan block" );
+        static_assert( MAX_PARTICLES_DEFAULT / FLUID_HASH_SCAN_BLOCK_SIZE <=
+                           FLUID_HASH_SCAN_BLOCK_SIZE,
+                       "Block totals must be scanned by a single workgroup" );
+
+        // bucket count is MAX_PARTICLES
+        m_cellCount.Init( *allocator,
+                          MAX_PARTICLES * sizeof( uint32_t ),
+                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                          "Fluid Hash Cell Count" );
+        m_cellStart.Init( *allocator,
+                          MAX_PARTICLES * sizeof( uint32_t ),
+                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                          "Fluid Hash Cell Start" );
+        m_cellBlockSums.Init( *allocator,
+                              MAX_PARTICLES / FLUID_HASH_SCAN_BLOCK_SIZE * sizeof( uint32_t ),
+                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                              "Fluid Hash Cell Block Sums" );
+        m_particleCell.Init( *allocator,
+                             MAX_PARTICLES * sizeof( uint32_t ) * 2,
+                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                             "Fluid Hash Particle Cell" );
+        m_sortedParticles.Init( *allocator,
+                                MAX_PARTICLES * sizeof( ShParticleDef ),
+                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                "Fluid Hash Sorted Particles" );
+    }
+
+    {
+        constexpr VkDeviceSize countersSize = 2 * sizeof( uint32_t );
+
+        m_counters.Init( *allocator,
+                         countersSize,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                             VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                         "Fluid Counters" );
+
+        for( auto& readback : m_countersReadback )
+        {
+            readback.Init( *allocator,
+                           countersSize,
+                           VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                           "Fluid Counters readback" );
+
+            memset( readback.Map(), 0, countersSize );
+            readback.Unmap();
+        }
+    }
+
     m_generateIdToSource.Create( MAX_PARTICLES * sizeof( IdToSource ),
                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                                  "Fluid Generate: Particle ID to Source" );
@@ -226,6 +314,25 @@ RTGL1::Fluid::Fluid( VkDevice                                device,
 
     CreatePipelineLayouts( tlasLayout );
     CreatePipelines( shaderManager );
+
+    m_asyncSimulate = LibConfig().asyncFluidSimulation && m_cmdManager->HasAsyncCompute();
+    if( m_asyncSimulate )
+    {
+        auto timelineInfo = VkSemaphoreTypeCreateInfo{
+            .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            .initialValue  = 0,
+        };
+        auto semaphoreInfo = VkSemaphoreCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &timelineInfo,
+        };
+
+        VkResult r = vkCreateSemaphore( m_device, &semaphoreInfo, nullptr, &m_asyncTimeline );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME(
+            m_device, m_asyncTimeline, VK_OBJECT_TYPE_SEMAPHORE, "Fluid async timeline" );
+    }
 }
 
 RTGL1::Fluid::~Fluid()
@@ -237,13 +344,27 @@ RTGL1::Fluid::~Fluid()
     vkDestroyPipelineLayout( m_device, m_visualizePipelineLayout, nullptr );
     vkDestroyPipelineLayout( m_device, m_smoothPipelineLayout, nullptr );
     vkDestroyRenderPass( m_device, m_renderPass, nullptr );
+    vkDestroySemaphore( m_device, m_asyncTimeline, nullptr );
     DestroyFramebuffers();
     DestroyPipelines();
 }
 
-void RTGL1::Fluid::PrepareForFrame( bool reset )
+void RTGL1::Fluid::PrepareForFrame( const RgStartFrameFluidParams& params, float gpuFrameTimeMs )
 {
-    if( reset )
+    m_lodDistance = std::max( 0.0f, params.lodDistance );
+
+    if( params.targetFrameTime > 0 && gpuFrameTimeMs > 0 )
+    {
+        m_budgetScale *= gpuFrameTimeMs > params.targetFrameTime ? BUDGET_SCALE_DECREASE
+                                                                 : BUDGET_SCALE_INCREASE;
+        m_budgetScale = std::clamp( m_budgetScale, MIN_SPAWN_SCALE, 1.0f );
+    }
+    else
+    {
+        m_budgetScale = 1.0f;
+    }
+
+    if( params.reset )
     {
         m_sourcesCached.clear();
         m_sourcesCachedCnt.clear();
@@ -252,6 +373,23 @@ void RTGL1::Fluid::PrepareForFrame( bool reset )
     }
 }
 
+float RTGL1::Fluid::SpawnScale( const RgFloat3D& position ) const
+{
+    float distanceScale = 1.0f;
+    if( m_lodDistance > 0 )
+    {
+        const float dx = position.data[ 0 ] - m_cameraPosition.data[ 0 ];
+        const float dy = position.data[ 1 ] - m_cameraPosition.data[ 1 ];
+        const float dz = position.data[ 2 ] - m_cameraPosition.data[ 2 ];
+
+        // screen area of a source falls off with the squared distance
+        const float distSq = dx * dx + dy * dy + dz * dz;
+        distanceScale      = std::min( 1.0f, m_lodDistance * m_lodDistance / distSq );
+    }
+
+    return std::clamp( distanceScale * m_budgetScale, MIN_SPAWN_SCALE, 1.0f );
+}
+
 void RTGL1::Fluid::AddSource( const RgSpawnFluidInfo& src )
 {
     if( src.count == 0 )
@@ -271,6 +409,10 @@ void RTGL1::Fluid::AddSource( const RgSpawnFluidInfo& src )
         return;
     }
     
+    // camera position is of the last simulated frame
+    const uint32_t count =
+        std::max( 1u, static_cast< uint32_t >( float( src.count ) * SpawnScale( src.position ) ) );
+
     m_sourcesCached.push_back( ShParticleSourceDef{
         .position_dispersionAngle = glm::packHalf4x16( {
             src.position.data[ 0 ],
@@ -284,8 +426,11 @@ void RTGL1::Fluid::AddSource( const RgSpawnFluidInfo& src )
             src.velocity.data[ 2 ],
             std::clamp( src.dispersionVelocity, 0.f, 1.f ),
         } ),
+        // fewer particles are larger, to keep the volume
+        .radiusScale = std::cbrt( float( src.count ) / float( count ) ),
+        .pad0        = 0,
     } );
-    m_sourcesCachedCnt.push_back( src.count );
+    m_sourcesCachedCnt.push_back( count );
 }
 
 bool RTGL1::Fluid::Active() const
@@ -293,17 +438,95 @@ bool RTGL1::Fluid::Active() const
     return m_active.length() > 0 || !m_sourcesCached.empty();
 }
 
+auto RTGL1::Fluid::GetStats() const -> Stats
+{
+    return m_stats;
+}
+
 void RTGL1::Fluid::Simulate( VkCommandBuffer  cmd,
                              uint32_t         frameIndex,
                              VkDescriptorSet  tlasDescSet,
+                             VkDescriptorSet  prevTlasDescSet,
                              float            deltaTime,
-                             const RgFloat3D& gravity )
+                             const RgFloat3D& gravity,
+                             const float*     view,
+                             const float*     proj )
 {
+    // previous frame's TLAS exists only if there was a previous frame
+    const bool prevTlasValid = std::exchange( m_simulatedBefore, true );
+
+    if( m_asyncToWaitBeforeASBuild > 0 )
+    {
+        m_cmdManager->WaitSemaphoreOnGraphics(
+            m_asyncTimeline,
+            m_asyncToWaitBeforeASBuild,
+            VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR );
+        m_asyncToWaitBeforeASBuild = 0;
+    }
+
+    {
+        float viewInverse[ 16 ];
+        Matrix::Inverse( viewInverse, view );
+        m_cameraPosition = { viewInverse[ 12 ], viewInverse[ 13 ], viewInverse[ 14 ] };
+    }
+
+    // readback was written FramesInFlight ago, the GPU has already finished that frame
+    m_stats = {};
+    if( std::exchange( m_countersWritten[ frameIndex ], false ) )
+    {
+        Buffer& readback = m_countersReadback[ frameIndex ];
+
+        const auto* counters = static_cast< const uint32_t* >( readback.Map() );
+        m_stats              = Stats{
+                         .particleCount = counters[ 0 ],
+                         .culledCount   = counters[ 1 ],
+        };
+        readback.Unmap();
+    }
+
     if( !Active() )
     {
         return;
     }
 
+    // column-major proj * view
+    float viewProj[ 16 ];
+    Matrix::Multiply( viewProj, view, proj );
+
+    if( !m_asyncSimulate || !prevTlasValid )
+    {
+        RecordSimulation( cmd, frameIndex, tlasDescSet, deltaTime, gravity, viewProj );
+        return;
+    }
+
+    // start after all graphics work of the previous frames:
+    // its TLAS is built, and particles are not read by Visualize anymore
+    const uint64_t graphicsFinished = ++m_asyncTimelineValue;
+    m_cmdManager->SignalSemaphoreOnGraphics( m_asyncTimeline, graphicsFinished );
+
+    VkCommandBuffer asyncCmd = m_cmdManager->StartAsyncComputeCmd();
+    RecordSimulation( asyncCmd, frameIndex, prevTlasDescSet, deltaTime, gravity, viewProj );
+
+    const uint64_t simulated = ++m_asyncTimelineValue;
+    m_cmdManager->Submit_Timeline( asyncCmd,
+                                   VK_NULL_HANDLE,
+                                   ToWait{ m_asyncTimeline, graphicsFinished },
+                                   ToSignal{ m_asyncTimeline, simulated } );
+
+    // only Visualize waits, so rasterization and AS builds of
+    // this frame are overlapped with the simulation
+    m_cmdManager->WaitSemaphoreOnGraphics(
+        m_asyncTimeline, simulated, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT );
+    m_asyncToWaitBeforeASBuild = simulated;
+}
+
+void RTGL1::Fluid::RecordSimulation( VkCommandBuffer  cmd,
+                                     uint32_t         frameIndex,
+                                     VkDescriptorSet  tlasDescSet,
+                                     float            deltaTime,
+                                     const RgFloat3D& gravity,
+                                     const float*     viewProj )
+{
     auto label = CmdLabel{ cmd, "Fluid Particles Simulate" };
 
 
@@ -372,6 +595,30 @@ void RTGL1::Fluid::Simulate( VkCommandBuffer  cmd,
     }
 
 
+    // buckets and counters are refilled every frame
+    {
+        vkCmdFillBuffer( cmd, m_cellCount.GetBuffer(), 0, VK_WHOLE_SIZE, 0 );
+        vkCmdFillBuffer( cmd, m_counters.GetBuffer(), 0, VK_WHOLE_SIZE, 0 );
+
+        auto b = VkMemoryBarrier2{
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext         = nullptr,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+        };
+        auto dpd = VkDependencyInfo{
+            .sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext              = nullptr,
+            .dependencyFlags    = 0,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dpd );
+    }
+
+
     VkDescriptorSet sets[] = {
         m_descSet,
         tlasDescSet,
@@ -385,7 +632,7 @@ void RTGL1::Fluid::Simulate( VkCommandBuffer  cmd,
                              0,
                              nullptr );
 
-    const auto push = ParticlesPush_T{
+    auto push = ParticlesPush_T{
         .gravity            = gravity,
         .deltaTime          = deltaTime,
         .activeRingBegin    = m_active.ringBegin,
@@ -393,7 +640,8 @@ void RTGL1::Fluid::Simulate( VkCommandBuffer  cmd,
         .generateRingBegin  = generateIdToSource_copy.ringBegin,
         .generateRingLength = generateIdToSource_copy.length(),
     };
-    static_assert( sizeof( push ) == 32 );
+    memcpy( push.viewProj.data(), viewProj, sizeof( push.viewProj ) );
+    static_assert( sizeof( push ) == 96 );
 
     vkCmdPushConstants( cmd, //
                         m_particlesPipelineLayout,
@@ -445,12 +693,81 @@ void RTGL1::Fluid::Simulate( VkCommandBuffer  cmd,
         }
     }
 
+    // spatial hash, so SPH passes only visit the neighbouring cells
+    {
+        auto hlabel = CmdLabel{ cmd, "Fluid Spatial Hash" };
+
+        const uint32_t activeGroups =
+            Utils::GetWorkGroupCount( m_active.length(), COMPUTE_FLUID_PARTICLES_GROUP_SIZE_X );
+
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_hashCountPipeline );
+        vkCmdDispatch( cmd, activeGroups, 1, 1 );
+        computeToComputeBarrier( cmd );
+
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_hashScanPipeline );
+        vkCmdDispatch( cmd, MAX_PARTICLES / FLUID_HASH_SCAN_BLOCK_SIZE, 1, 1 );
+        computeToComputeBarrier( cmd );
+
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_hashScanBlocksPipeline );
+        vkCmdDispatch( cmd, 1, 1, 1 );
+        computeToComputeBarrier( cmd );
+
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_hashReorderPipeline );
+        vkCmdDispatch( cmd, activeGroups, 1, 1 );
+        computeToComputeBarrier( cmd );
+
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_densityPipeline );
+        vkCmdDispatch( cmd, activeGroups, 1, 1 );
+        computeToComputeBarrier( cmd );
+    }
+
     vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, m_particlesPipeline );
     vkCmdDispatch(
         cmd,
         Utils::GetWorkGroupCount( m_active.length(), COMPUTE_FLUID_PARTICLES_GROUP_SIZE_X ),
         1,
         1 );
+
+    // counters for the stats
+    {
+        auto toTransfer = VkMemoryBarrier2{
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext         = nullptr,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT,
+        };
+        auto dpd = VkDependencyInfo{
+            .sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .pNext              = nullptr,
+            .dependencyFlags    = 0,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers    = &toTransfer,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dpd );
+
+        auto region = VkBufferCopy{
+            .srcOffset = 0,
+            .dstOffset = 0,
+            .size      = m_counters.GetSize(),
+        };
+        vkCmdCopyBuffer(
+            cmd, m_counters.GetBuffer(), m_countersReadback[ frameIndex ].GetBuffer(), 1, &region );
+
+        auto toHost = VkMemoryBarrier2{
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .pNext         = nullptr,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_HOST_BIT,
+            .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+        };
+        dpd.pMemoryBarriers = &toHost;
+        svkCmdPipelineBarrier2KHR( cmd, &dpd );
+
+        m_countersWritten[ frameIndex ] = true;
+    }
 }
 
 void RTGL1::Fluid::Visualize( VkCommandBuffer               cmd,
@@ -584,6 +901,20 @@ void RTGL1::Fluid::Visualize( VkCommandBuffer               cmd,
 
 void RTGL1::Fluid::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { "Fluid_Particles",
+                                      "Fluid_Generate",
+                                      "Fluid_HashCount",
+                                      "Fluid_HashScan",
+                                      "Fluid_HashScanBlocks",
+                                      "Fluid_HashReorder",
+                                      "Fluid_Density",
+                                      "Fluid_DepthSmooth",
+                                      "Fluid_VisualizeVert",
+                                      "Fluid_VisualizeFrag" } ) )
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines( *shaderManager );
 }
@@ -617,6 +948,42 @@ void RTGL1::Fluid::CreateDescriptors()
             .descriptorCount = 1,
             .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT,
         },
+        {
+            .binding         = BINDING_FLUID_CELL_COUNT,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_FLUID_CELL_START,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_FLUID_CELL_BLOCK_SUMS,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_FLUID_PARTICLE_CELL,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_FLUID_SORTED_PARTICLES,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_FLUID_COUNTERS,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
     };
 
     auto layoutInfo = VkDescriptorSetLayoutCreateInfo{
@@ -679,8 +1046,37 @@ void RTGL1::Fluid::UpdateDescriptors()
             .offset = 0,
             .range  = VK_WHOLE_SIZE,
         },
+        {
+            .buffer = m_cellCount.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = m_cellStart.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = m_cellBlockSums.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = m_particleCell.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = m_sortedParticles.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = m_counters.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
     };
-    static_assert( MAX_FRAMES_IN_FLIGHT == 2 );
 
     VkWriteDescriptorSet wrts[] = {
         {
@@ -710,6 +1106,60 @@ void RTGL1::Fluid::UpdateDescriptors()
             .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
             .pBufferInfo     = &bufs[ BINDING_FLUID_SOURCES ],
         },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = m_descSet,
+            .dstBinding      = BINDING_FLUID_CELL_COUNT,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_FLUID_CELL_COUNT ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = m_descSet,
+            .dstBinding      = BINDING_FLUID_CELL_START,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_FLUID_CELL_START ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = m_descSet,
+            .dstBinding      = BINDING_FLUID_CELL_BLOCK_SUMS,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_FLUID_CELL_BLOCK_SUMS ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = m_descSet,
+            .dstBinding      = BINDING_FLUID_PARTICLE_CELL,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_FLUID_PARTICLE_CELL ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = m_descSet,
+            .dstBinding      = BINDING_FLUID_SORTED_PARTICLES,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_FLUID_SORTED_PARTICLES ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = m_descSet,
+            .dstBinding      = BINDING_FLUID_COUNTERS,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_FLUID_COUNTERS ],
+        },
     };
     static_assert( std::size( wrts ) == std::size( bufs ) );
 
@@ -858,7 +1308,7 @@ void RTGL1::Fluid::CreatePipelines( const ShaderManager& shaderManager )
         info.stage.pSpecializationInfo = &tableSpec;
 
         VkResult r = vkCreateComputePipelines(
-            m_device, VK_NULL_HANDLE, 1, &info, nullptr, &m_particlesPipeline );
+            m_device, shaderManager.GetPipelineCache(), 1, &info, nullptr, &m_particlesPipeline );
         VK_CHECKERROR( r );
 
         SET_DEBUG_NAME(
@@ -878,13 +1328,51 @@ void RTGL1::Fluid::CreatePipelines( const ShaderManager& shaderManager )
         info.stage.pSpecializationInfo = &tableSpec;
 
         VkResult r = vkCreateComputePipelines(
-            m_device, VK_NULL_HANDLE, 1, &info, nullptr, &m_generatePipeline );
+            m_device, shaderManager.GetPipelineCache(), 1, &info, nullptr, &m_generatePipeline );
         VK_CHECKERROR( r );
 
         SET_DEBUG_NAME(
             m_device, m_generatePipeline, VK_OBJECT_TYPE_PIPELINE, "Fluid Generate pipeline" );
     }
 
+    assert( m_particlesPipelineLayout != VK_NULL_HANDLE );
+    {
+        struct
+        {
+            const char* shaderName;
+            VkPipeline* pipeline;
+            const char* debugName;
+        } hashPasses[] = {
+            { "Fluid_HashCount", &m_hashCountPipeline, "Fluid Hash Count pipeline" },
+            { "Fluid_HashScan", &m_hashScanPipeline, "Fluid Hash Scan pipeline" },
+            { "Fluid_HashScanBlocks",
+              &m_hashScanBlocksPipeline,
+              "Fluid Hash Scan Blocks pipeline" },
+            { "Fluid_HashReorder", &m_hashReorderPipeline, "Fluid Hash Reorder pipeline" },
+            { "Fluid_Density", &m_densityPipeline, "Fluid Density pipeline" },
+        };
+
+        for( const auto& pass : hashPasses )
+        {
+            assert( *pass.pipeline == VK_NULL_HANDLE );
+
+            auto info = VkComputePipelineCreateInfo{
+                .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+                .pNext  = nullptr,
+                .flags  = 0,
+                .stage  = shaderManager.GetStageInfo( pass.shaderName ),
+                .layout = m_particlesPipelineLayout,
+            };
+            info.stage.pSpecializationInfo = &tableSpec;
+
+            VkResult r = vkCreateComputePipelines(
+                m_device, shaderManager.GetPipelineCache(), 1, &info, nullptr, pass.pipeline );
+            VK_CHECKERROR( r );
+
+            SET_DEBUG_NAME( m_device, *pass.pipeline, VK_OBJECT_TYPE_PIPELINE, pass.debugName );
+        }
+    }
+
     assert( m_smoothPipelineLayout != VK_NULL_HANDLE );
     for( uint32_t iter = 0; iter < std::size( m_smoothPipelines ); iter++ )
     {
@@ -911,8 +1399,12 @@ void RTGL1::Fluid::CreatePipelines( const ShaderManager& shaderManager )
         };
         info.stage.pSpecializationInfo = &iterSpec;
 
-        VkResult r = vkCreateComputePipelines(
-            m_device, VK_NULL_HANDLE, 1, &info, nullptr, &m_smoothPipelines[ iter ] );
+        VkResult r = vkCreateComputePipelines( m_device,
+                                               shaderManager.GetPipelineCache(),
+                                               1,
+                                               &info,
+                                               nullptr,
+                                               &m_smoothPipelines[ iter ] );
         VK_CHECKERROR( r );
 
         SET_DEBUG_NAME( m_device,
@@ -1042,8 +1534,12 @@ void RTGL1::Fluid::CreatePipelines( const ShaderManager& shaderManager )
             .basePipelineIndex   = 0,
         };
 
-        VkResult r =
-            vkCreateGraphicsPipelines( m_device, nullptr, 1, &info, nullptr, &m_visualizePipeline );
+        VkResult r = vkCreateGraphicsPipelines( m_device,
+                                                shaderManager.GetPipelineCache(),
+                                                1,
+                                                &info,
+                                                nullptr,
+                                                &m_visualizePipeline );
         VK_CHECKERROR( r );
 
         SET_DEBUG_NAME(
@@ -1263,6 +1759,15 @@ void RTGL1::Fluid::DestroyPipelines()
     m_particlesPipeline = VK_NULL_HANDLE;
     vkDestroyPipeline( m_device, m_generatePipeline, nullptr );
     m_generatePipeline = VK_NULL_HANDLE;
+    for( VkPipeline* p : { &m_hashCountPipeline,
+                           &m_hashScanPipeline,
+                           &m_hashScanBlocksPipeline,
+                           &m_hashReorderPipeline,
+                           &m_densityPipeline } )
+    {
+        vkDestroyPipeline( m_device, *p, nullptr );
+        *p = VK_NULL_HANDLE;
+    }
     vkDestroyPipeline( m_device, m_visualizePipeline, nullptr );
     m_visualizePipeline = VK_NULL_HANDLE;
     for( auto& p : m_smoothPipelines )
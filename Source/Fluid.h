@@ -71,15 +71,20 @@ public:
     Fluid& operator=( const Fluid& )     = delete;
     Fluid& operator=( Fluid&& ) noexcept = delete;
 
-    void PrepareForFrame( bool reset );
+    void PrepareForFrame( const RgStartFrameFluidParams& params, float gpuFrameTimeMs );
 
     void AddSource( const RgSpawnFluidInfo& src );
 
+    // If async simulation is enabled, it's submitted to the async compute queue
+    // and uses the TLAS of the previous frame, so 'cmd' is not used
     void Simulate( VkCommandBuffer  cmd,
                    uint32_t         frameIndex,
                    VkDescriptorSet  tlasDescSet,
+                   VkDescriptorSet  prevTlasDescSet,
                    float            deltaTime,
-                   const RgFloat3D& gravity );
+                   const RgFloat3D& gravity,
+                   const float*     view,
+                   const float*     proj );
     void Visualize( VkCommandBuffer               cmd,
                     uint32_t                      frameIndex,
                     const float*                  view,
@@ -93,7 +98,25 @@ public:
 
     bool Active() const;
 
+    struct Stats
+    {
+        uint32_t particleCount;
+        uint32_t culledCount;
+    };
+    // Of a frame that was simulated a few frames ago
+    auto GetStats() const -> Stats;
+
 private:
+    void RecordSimulation( VkCommandBuffer  cmd,
+                           uint32_t         frameIndex,
+                           VkDescriptorSet  tlasDescSet,
+                           float            deltaTime,
+                           const RgFloat3D& gravity,
+                           const float*     viewProj );
+
+    // Fraction of requested particles to spawn at the position
+    float SpawnScale( const RgFloat3D& position ) const;
+
     void CreateDescriptors();
     void UpdateDescriptors();
 
@@ -130,6 +153,18 @@ private:
     std::vector< ShParticleSourceDef > m_sourcesCached; // because sources can be added out-of-frame
     std::vector< uint32_t >            m_sourcesCachedCnt;
 
+    // spatial hash, see Fluid_SpatialHash.inl
+    Buffer m_cellCount{};
+    Buffer m_cellStart{};
+    Buffer m_cellBlockSums{};
+    Buffer m_particleCell{};
+    Buffer m_sortedParticles{};
+
+    Buffer m_counters{};
+    Buffer m_countersReadback[ MAX_FRAMES_IN_FLIGHT ]{};
+    bool   m_countersWritten[ MAX_FRAMES_IN_FLIGHT ]{};
+    Stats  m_stats{};
+
     VkDescriptorPool      m_descPool{ VK_NULL_HANDLE };
     VkDescriptorSetLayout m_descLayout{ VK_NULL_HANDLE };
     VkDescriptorSet       m_descSet{ VK_NULL_HANDLE };
@@ -137,6 +172,11 @@ private:
     VkPipelineLayout m_particlesPipelineLayout{ VK_NULL_HANDLE };
     VkPipeline       m_generatePipeline{ VK_NULL_HANDLE };
     VkPipeline       m_particlesPipeline{ VK_NULL_HANDLE };
+    VkPipeline       m_hashCountPipeline{ VK_NULL_HANDLE };
+    VkPipeline       m_hashScanPipeline{ VK_NULL_HANDLE };
+    VkPipeline       m_hashScanBlocksPipeline{ VK_NULL_HANDLE };
+    VkPipeline       m_hashReorderPipeline{ VK_NULL_HANDLE };
+    VkPipeline       m_densityPipeline{ VK_NULL_HANDLE };
 
     VkPipelineLayout m_visualizePipelineLayout{ VK_NULL_HANDLE };
     VkPipeline       m_visualizePipeline{ VK_NULL_HANDLE };
@@ -151,6 +191,17 @@ private:
     RingBuf m_active{};
 
     float m_particleRadius{ 0.1f };
+
+    float     m_lodDistance{ 0 };
+    float     m_budgetScale{ 1.0f };
+    RgFloat3D m_cameraPosition{};
+
+    bool        m_asyncSimulate{ false };
+    bool        m_simulatedBefore{ false };
+    VkSemaphore m_asyncTimeline{ VK_NULL_HANDLE };
+    uint64_t    m_asyncTimelineValue{ 0 };
+    // TLAS that is read by the async simulation must not be rebuilt until it's finished
+    uint64_t    m_asyncToWaitBeforeASBuild{ 0 };
 };
 
 }
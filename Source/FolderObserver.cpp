@@ -20,9 +20,22 @@
 
 #include "FolderObserver.h"
 
+#include <functional>
 #include <future>
 
 #include "Const.h"
+#include "DebugPrint.h"
+
+#if defined( _WIN32 )
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined( __linux__ )
+    #include <poll.h>
+    #include <sys/inotify.h>
+    #include <unistd.h>
+#endif
 
 namespace fs = std::filesystem;
 
@@ -51,6 +64,16 @@ namespace
     };
 
 
+    using ChangedFiles = std::vector< std::pair< FileType, std::filesystem::path > >;
+
+
+    bool IsIgnoredFolder( const fs::path& folder )
+    {
+        return folder.filename() == TEXTURES_FOLDER_JUNCTION ||
+               folder.filename() == DEV_TEXTURE_CACHE_FOLDER;
+    }
+
+
     void InsertAllFolderFiles( std::deque< DependentFile >& dst, const fs::path& folder )
     {
         if( !fs::exists( folder ) )
@@ -76,8 +99,7 @@ namespace
             }
             else if( entry.is_directory() )
             {
-                // ignore
-                if( entry.path().filename() == TEXTURES_FOLDER_JUNCTION )
+                if( IsIgnoredFolder( entry.path() ) )
                 {
                     continue;
                 }
@@ -86,6 +108,273 @@ namespace
             }
         }
     }
+
+
+    // OS notifications, so there's no cost while nothing changes.
+    // Returns false, if couldn't be started: then folders should be polled
+#if defined( __linux__ )
+    bool WatchNative( const std::vector< fs::path >&                folders,
+                      const std::stop_token&                        token,
+                      const std::function< void( ChangedFiles&& ) >& onChanged )
+    {
+        int fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+        if( fd < 0 )
+        {
+            debug::Warning( "inotify_init1 failed: {}", errno );
+            return false;
+        }
+
+        // inotify is not recursive, so each subfolder is watched separately
+        constexpr uint32_t mask    = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+        auto               watched = rgl::unordered_map< int, fs::path >{};
+
+        auto addWatch = [ & ]( const fs::path& folder, auto&& self ) -> void {
+            int wd = inotify_add_watch( fd, folder.c_str(), mask );
+            if( wd < 0 )
+            {
+                debug::Warning( "inotify_add_watch failed: {}: {}", errno, folder.string() );
+                return;
+            }
+            watched[ wd ] = folder;
+
+            std::error_code ec;
+            for( const fs::directory_entry& entry : fs::directory_iterator( folder, ec ) )
+            {
+                if( entry.is_directory() && !IsIgnoredFolder( entry.path() ) )
+                {
+                    self( entry.path(), self );
+                }
+            }
+        };
+
+        for( const fs::path& f : folders )
+        {
+            if( fs::exists( f ) )
+            {
+                addWatch( f, addWatch );
+            }
+        }
+
+        if( watched.empty() )
+        {
+            close( fd );
+            return false;
+        }
+
+        alignas( inotify_event ) char buffer[ 16 * 1024 ];
+
+        while( !token.stop_requested() )
+        {
+            // timeout is only to check the stop token
+            auto p = pollfd{ .fd = fd, .events = POLLIN, .revents = 0 };
+            if( poll( &p, 1, int( CHECK_FREQUENCY.count() ) ) <= 0 )
+            {
+                continue;
+            }
+
+            auto changed = ChangedFiles{};
+
+            ssize_t len;
+            while( ( len = read( fd, buffer, sizeof( buffer ) ) ) > 0 )
+            {
+                for( char* ptr = buffer; ptr < buffer + len; )
+                {
+                    const auto* ev = reinterpret_cast< const inotify_event* >( ptr );
+                    ptr += sizeof( inotify_event ) + ev->len;
+
+                    auto dir = watched.find( ev->wd );
+                    if( dir == watched.end() || ev->len == 0 )
+                    {
+                        continue;
+                    }
+                    const fs::path path = dir->second / ev->name;
+
+                    if( ev->mask & IN_ISDIR )
+                    {
+                        if( !IsIgnoredFolder( path ) )
+                        {
+                            addWatch( path, addWatch );
+                        }
+                        continue;
+                    }
+
+                    // a created file is reported on IN_CLOSE_WRITE, when it's complete
+                    if( ev->mask & ( IN_CLOSE_WRITE | IN_MOVED_TO ) )
+                    {
+                        FileType type = MakeFileType( path );
+                        if( type != FileType::Unknown )
+                        {
+                            changed.emplace_back( type, path );
+                        }
+                    }
+                }
+            }
+
+            if( !changed.empty() )
+            {
+                onChanged( std::move( changed ) );
+            }
+        }
+
+        close( fd );
+        return true;
+    }
+#elif defined( _WIN32 )
+    bool IsInIgnoredFolder( const fs::path& relativePath )
+    {
+        for( const fs::path& part : relativePath.parent_path() )
+        {
+            if( IsIgnoredFolder( part ) )
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool WatchNative( const std::vector< fs::path >&                folders,
+                      const std::stop_token&                        token,
+                      const std::function< void( ChangedFiles&& ) >& onChanged )
+    {
+        struct Watch
+        {
+            fs::path   folder{};
+            HANDLE     dir{ INVALID_HANDLE_VALUE };
+            OVERLAPPED overlapped{};
+            alignas( DWORD ) uint8_t buffer[ 32 * 1024 ];
+        };
+
+        constexpr DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+        auto issueRead = [ filter ]( Watch& w ) {
+            return ReadDirectoryChangesW( w.dir,
+                                          w.buffer,
+                                          sizeof( w.buffer ),
+                                          TRUE,
+                                          filter,
+                                          nullptr,
+                                          &w.overlapped,
+                                          nullptr );
+        };
+
+        auto watches = std::vector< std::unique_ptr< Watch > >{};
+        auto events  = std::vector< HANDLE >{};
+
+        for( const fs::path& f : folders )
+        {
+            if( !fs::exists( f ) )
+            {
+                continue;
+            }
+
+            auto w    = std::make_unique< Watch >();
+            w->folder = f;
+            w->dir    = CreateFileW( f.c_str(),
+                                  FILE_LIST_DIRECTORY,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                  nullptr,
+                                  OPEN_EXISTING,
+                                  FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED,
+                                  nullptr );
+            if( w->dir == INVALID_HANDLE_VALUE )
+            {
+                debug::Warning( "CreateFileW failed: {}: {}", GetLastError(), f.string() );
+                continue;
+            }
+
+            w->overlapped.hEvent = CreateEventW( nullptr, FALSE, FALSE, nullptr );
+            if( !issueRead( *w ) )
+            {
+                debug::Warning(
+                    "ReadDirectoryChangesW failed: {}: {}", GetLastError(), f.string() );
+                CloseHandle( w->overlapped.hEvent );
+                CloseHandle( w->dir );
+                continue;
+            }
+
+            events.push_back( w->overlapped.hEvent );
+            watches.push_back( std::move( w ) );
+        }
+
+        if( watches.empty() )
+        {
+            return false;
+        }
+
+        while( !token.stop_requested() )
+        {
+            // timeout is only to check the stop token
+            DWORD r = WaitForMultipleObjects(
+                DWORD( events.size() ), events.data(), FALSE, DWORD( CHECK_FREQUENCY.count() ) );
+            if( r < WAIT_OBJECT_0 || r >= WAIT_OBJECT_0 + events.size() )
+            {
+                continue;
+            }
+
+            Watch& w       = *watches[ r - WAIT_OBJECT_0 ];
+            DWORD  bytes   = 0;
+            auto   changed = ChangedFiles{};
+
+            if( !GetOverlappedResult( w.dir, &w.overlapped, &bytes, FALSE ) || bytes == 0 )
+            {
+                debug::Warning( "File change notifications were lost: {}", w.folder.string() );
+            }
+            else
+            {
+                auto* info = reinterpret_cast< const FILE_NOTIFY_INFORMATION* >( w.buffer );
+                while( true )
+                {
+                    if( info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                        info->Action == FILE_ACTION_RENAMED_NEW_NAME )
+                    {
+                        const auto relative = fs::path{ std::wstring_view{
+                            info->FileName, info->FileNameLength / sizeof( WCHAR ) } };
+
+                        if( !IsInIgnoredFolder( relative ) )
+                        {
+                            FileType type = MakeFileType( w.folder / relative );
+                            if( type != FileType::Unknown )
+                            {
+                                changed.emplace_back( type, w.folder / relative );
+                            }
+                        }
+                    }
+
+                    if( info->NextEntryOffset == 0 )
+                    {
+                        break;
+                    }
+                    info = reinterpret_cast< const FILE_NOTIFY_INFORMATION* >(
+                        reinterpret_cast< const uint8_t* >( info ) + info->NextEntryOffset );
+                }
+            }
+
+            issueRead( w );
+
+            if( !changed.empty() )
+            {
+                onChanged( std::move( changed ) );
+            }
+        }
+
+        for( auto& w : watches )
+        {
+            DWORD bytes = 0;
+            CancelIoEx( w->dir, &w->overlapped );
+            GetOverlappedResult( w->dir, &w->overlapped, &bytes, TRUE );
+            CloseHandle( w->overlapped.hEvent );
+            CloseHandle( w->dir );
+        }
+        return true;
+    }
+#else
+    bool WatchNative( const std::vector< fs::path >&,
+                      const std::stop_token&,
+                      const std::function< void( ChangedFiles&& ) >& )
+    {
+        return false;
+    }
+#endif
 }
 }
 
@@ -106,6 +395,14 @@ RTGL1::FolderObserver::FolderObserver( const fs::path& ovrdFolder )
             const std::vector< std::filesystem::path > foldersToCheck, //
             std::stop_token                            token           //
         ) {
+            if( WatchNative( foldersToCheck, token, [ this ]( ChangedFiles&& changed ) {
+                    AddChangedFiles( std::move( changed ) );
+                } ) )
+            {
+                return;
+            }
+            debug::Verbose( "Polling override folders for file changes" );
+
             auto s_lastCheck    = std::optional< Clock::time_point >{};
             auto s_prevAllFiles = std::deque< DependentFile >{};
 
@@ -114,7 +411,7 @@ RTGL1::FolderObserver::FolderObserver( const fs::path& ovrdFolder )
                 std::this_thread::sleep_for( CHECK_FREQUENCY );
 
                 auto curAllFiles = std::deque< DependentFile >{};
-                auto changed     = std::vector< std::pair< FileType, std::filesystem::path > >{};
+                auto changed     = ChangedFiles{};
                 {
                     for( const fs::path& f : foldersToCheck )
                     {
@@ -152,22 +449,7 @@ RTGL1::FolderObserver::FolderObserver( const fs::path& ovrdFolder )
                     }
                 }
 
-                {
-                    auto l = std::lock_guard{ this->m_mutex };
-
-                    for( auto& f : changed )
-                    {
-                        bool alreadyContains =
-                            std::ranges::find_if( this->m_changedFiles, [ &f ]( const auto& o ) {
-                                return o.second == f.second;
-                            } ) != this->m_changedFiles.end();
-
-                        if( !alreadyContains )
-                        {
-                            this->m_changedFiles.emplace_back( std::move( f ) );
-                        }
-                    }
-                }
+                AddChangedFiles( std::move( changed ) );
 
                 s_prevAllFiles = std::move( curAllFiles );
                 s_lastCheck    = Clock::now();
@@ -182,6 +464,25 @@ RTGL1::FolderObserver::~FolderObserver()
     m_asyncStopSource.request_stop();
 }
 
+void RTGL1::FolderObserver::AddChangedFiles(
+    std::vector< std::pair< FileType, std::filesystem::path > >&& changed )
+{
+    auto l = std::lock_guard{ this->m_mutex };
+
+    for( auto& f : changed )
+    {
+        bool alreadyContains =
+            std::ranges::find_if( this->m_changedFiles, [ &f ]( const auto& o ) {
+                return o.second == f.second;
+            } ) != this->m_changedFiles.end();
+
+        if( !alreadyContains )
+        {
+            this->m_changedFiles.emplace_back( std::move( f ) );
+        }
+    }
+}
+
 void RTGL1::FolderObserver::RecheckFiles()
 {
     auto l = std::lock_guard{ this->m_mutex };
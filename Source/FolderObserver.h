@@ -49,6 +49,9 @@ public:
     }
 
 private:
+    // Called from the checker thread
+    void AddChangedFiles( std::vector< std::pair< FileType, std::filesystem::path > >&& changed );
+
     template< typename Func, typename... Args >
     auto CallSubsbribers( Func f, Args&&... args )
     {
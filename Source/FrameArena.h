@@ -0,0 +1,93 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Storage for objects that live until a frame in flight is finished: they are constructed
+// in place in fixed-size chunks, and the chunks are kept on reset, so after a few frames
+// no heap allocations are made. Pointers are stable until the reset
+template< typename T, size_t ChunkSize = 256 >
+class FrameArena
+{
+public:
+    FrameArena() = default;
+    ~FrameArena() { Reset(); }
+
+    FrameArena( const FrameArena& other )                = delete;
+    FrameArena( FrameArena&& other ) noexcept            = delete;
+    FrameArena& operator=( const FrameArena& other )     = delete;
+    FrameArena& operator=( FrameArena&& other ) noexcept = delete;
+
+    // 'make' returns T by value, which is constructed directly in the arena,
+    // so T doesn't need to be movable
+    template< typename MakeFunc >
+    T* Emplace( MakeFunc&& make )
+    {
+        const size_t chunk = count / ChunkSize;
+        if( chunk == chunks.size() )
+        {
+            chunks.push_back( std::make_unique< Slot[] >( ChunkSize ) );
+        }
+
+        T* obj = ::new( chunks[ chunk ][ count % ChunkSize ].data ) T( make() );
+        count++;
+        return obj;
+    }
+
+    // Destroy the objects in the reverse order, but keep the memory
+    void Reset()
+    {
+        for( size_t i = count; i-- > 0; )
+        {
+            At( i )->~T();
+        }
+        count = 0;
+    }
+
+    size_t Size() const { return count; }
+    size_t Capacity() const { return chunks.size() * ChunkSize; }
+
+private:
+    struct Slot
+    {
+        alignas( T ) std::byte data[ sizeof( T ) ];
+    };
+
+    T* At( size_t i )
+    {
+        Slot& slot = chunks[ i / ChunkSize ][ i % ChunkSize ];
+        return std::launder( reinterpret_cast< T* >( slot.data ) );
+    }
+
+private:
+    std::vector< std::unique_ptr< Slot[] > > chunks{};
+    size_t                                   count{ 0 };
+};
+
+}
@@ -0,0 +1,143 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FramePacer.h"
+
+#include <thread>
+
+namespace
+{
+
+// don't hang, if a present is never going to be displayed
+constexpr uint64_t PresentWaitTimeoutNs = 1'000'000'000;
+
+}
+
+RTGL1::FramePacer::FramePacer( VkDevice _device, bool _withPresentWait )
+    : device{ _device }, withPresentWait{ _withPresentWait }
+{
+}
+
+void RTGL1::FramePacer::Wait( VkSwapchainKHR                       swapchain,
+                              const RgStartFrameFramePacingParams& params )
+{
+    active = params.enable && withPresentWait && swapchain != VK_NULL_HANDLE;
+
+    // present ids are per swapchain, the old one could have been destroyed
+    if( !active || swapchain != presentSwapchain )
+    {
+        presentSwapchain = VK_NULL_HANDLE;
+        lastPresentId    = 0;
+        lastWaitedId     = 0;
+        presentLatencyMs = 0;
+    }
+
+    if( active && lastPresentId > params.maxQueuedFrames )
+    {
+        WaitForPresent( lastPresentId - params.maxQueuedFrames );
+    }
+
+    if( params.enable )
+    {
+        Throttle( params.targetFrameTime );
+    }
+    else
+    {
+        prevFrameStart = std::nullopt;
+    }
+}
+
+void RTGL1::FramePacer::WaitForPresent( uint64_t presentId )
+{
+    assert( presentSwapchain != VK_NULL_HANDLE );
+
+    if( presentId <= lastWaitedId )
+    {
+        return;
+    }
+
+    VkResult r = svkWaitForPresentKHR( device, presentSwapchain, presentId, PresentWaitTimeoutNs );
+    if( r != VK_SUCCESS )
+    {
+        // out of date, surface lost or timeout: start over with the next swapchain
+        presentSwapchain = VK_NULL_HANDLE;
+        lastPresentId    = 0;
+        lastWaitedId     = 0;
+        return;
+    }
+    lastWaitedId = presentId;
+
+    // if it was displayed before the wait, the value is an upper bound
+    const Submitted& s = submitted[ presentId % std::size( submitted ) ];
+    if( s.presentId == presentId )
+    {
+        presentLatencyMs =
+            std::chrono::duration< float, std::milli >( Clock::now() - s.time ).count();
+    }
+}
+
+void RTGL1::FramePacer::Throttle( float targetFrameTimeMs )
+{
+    if( targetFrameTimeMs <= 0 )
+    {
+        prevFrameStart = std::nullopt;
+        return;
+    }
+
+    const auto interval = std::chrono::duration_cast< Clock::duration >(
+        std::chrono::duration< float, std::milli >( targetFrameTimeMs ) );
+
+    auto now = Clock::now();
+    if( prevFrameStart && now < *prevFrameStart + interval )
+    {
+        std::this_thread::sleep_until( *prevFrameStart + interval );
+
+        // count from the scheduled time, so the oversleeping doesn't accumulate
+        now = *prevFrameStart + interval;
+    }
+    prevFrameStart = now;
+}
+
+auto RTGL1::FramePacer::GetPresentId( uint64_t frameId ) const -> std::optional< uint64_t >
+{
+    if( active )
+    {
+        // same as the low latency markers use
+        return frameId + 1;
+    }
+    return std::nullopt;
+}
+
+void RTGL1::FramePacer::OnPresent( VkSwapchainKHR swapchain, uint64_t presentId )
+{
+    if( !active )
+    {
+        return;
+    }
+
+    presentSwapchain = swapchain;
+    lastPresentId    = presentId;
+
+    submitted[ presentId % std::size( submitted ) ] = Submitted{
+        .presentId = presentId,
+        .time      = Clock::now(),
+    };
+}
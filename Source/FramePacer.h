@@ -0,0 +1,83 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Common.h"
+
+#include <chrono>
+
+namespace RTGL1
+{
+
+// Aligns the start of a frame to the display on a Vulkan swapchain with VK_KHR_present_wait:
+// a frame doesn't start, until the older presents are on the display, so no extra frames
+// are buffered in the presentation queue. Optionally, frame starts are throttled to a target
+// interval. The time from vkQueuePresentKHR to the display is measured for the waited presents.
+class FramePacer
+{
+public:
+    FramePacer( VkDevice device, bool withPresentWait );
+    ~FramePacer() = default;
+
+    FramePacer( const FramePacer& other )                = delete;
+    FramePacer( FramePacer&& other ) noexcept            = delete;
+    FramePacer& operator=( const FramePacer& other )     = delete;
+    FramePacer& operator=( FramePacer&& other ) noexcept = delete;
+
+    // Call before waiting for the frame fence, 'swapchain' is the one that is going to be used
+    void Wait( VkSwapchainKHR swapchain, const RgStartFrameFramePacingParams& params );
+
+    // Value for VkPresentIdKHR. Null if pacing is not active in the current frame
+    auto GetPresentId( uint64_t frameId ) const -> std::optional< uint64_t >;
+    void OnPresent( VkSwapchainKHR swapchain, uint64_t presentId );
+
+    // In milliseconds, zero if not measured
+    float GetPresentLatency() const { return presentLatencyMs; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void WaitForPresent( uint64_t presentId );
+    void Throttle( float targetFrameTimeMs );
+
+private:
+    VkDevice device;
+    bool     withPresentWait;
+    bool     active{ false };
+
+    // the swapchain that the present ids belong to
+    VkSwapchainKHR presentSwapchain{ VK_NULL_HANDLE };
+    uint64_t       lastPresentId{ 0 };
+    uint64_t       lastWaitedId{ 0 };
+
+    struct Submitted
+    {
+        uint64_t          presentId{ 0 };
+        Clock::time_point time{};
+    };
+    Submitted submitted[ 8 ]{};
+
+    std::optional< Clock::time_point > prevFrameStart{};
+    float                              presentLatencyMs{ 0 };
+};
+
+}
@@ -0,0 +1,744 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "FrameReadback.h"
+
+#include "CmdLabel.h"
+#include "Generated/ShaderCommonC.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+constexpr VkFormat ReadbackFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+struct ReadbackNV12Push
+{
+    uint32_t width;
+    uint32_t height;
+};
+
+auto SourceToFramebuffer( RgReadbackSource source, RTGL1::FramebufferImageIndex final )
+    -> std::optional< RTGL1::FramebufferImageIndex >
+{
+    switch( source )
+    {
+        case RG_READBACK_SOURCE_FINAL: return final;
+        case RG_READBACK_SOURCE_ALBEDO: return RTGL1::FB_IMAGE_INDEX_ALBEDO;
+        case RG_READBACK_SOURCE_METALLIC_ROUGHNESS: return RTGL1::FB_IMAGE_INDEX_METALLIC_ROUGHNESS;
+        case RG_READBACK_SOURCE_SCREEN_EMISSION: return RTGL1::FB_IMAGE_INDEX_SCREEN_EMISSION;
+        default: return std::nullopt;
+    }
+}
+
+VkExtent2D FitInto( const VkExtent2D& src, const RgExtent2D& maxSize )
+{
+    float scale = 1.0f;
+    if( maxSize.width > 0 )
+    {
+        scale = std::min( scale, float( maxSize.width ) / float( src.width ) );
+    }
+    if( maxSize.height > 0 )
+    {
+        scale = std::min( scale, float( maxSize.height ) / float( src.height ) );
+    }
+
+    return VkExtent2D{
+        std::max( 1u, uint32_t( std::round( float( src.width ) * scale ) ) ),
+        std::max( 1u, uint32_t( std::round( float( src.height ) * scale ) ) ),
+    };
+}
+
+// a shader invocation writes 4x2 pixels, and chroma is subsampled by 2x2
+VkExtent2D AlignForNV12( const VkExtent2D& extent )
+{
+    return VkExtent2D{
+        std::max( 4u, extent.width & ~3u ),
+        std::max( 2u, extent.height & ~1u ),
+    };
+}
+
+VkDeviceSize GetBufferSize( const VkExtent2D& extent, RgReadbackFormat format )
+{
+    const VkDeviceSize pixelCount = VkDeviceSize{ extent.width } * extent.height;
+
+    switch( format )
+    {
+        case RG_READBACK_FORMAT_NV12: return pixelCount + pixelCount / 2;
+        default: return pixelCount * 4;
+    }
+}
+
+}
+
+RTGL1::FrameReadback::FrameReadback( VkDevice                           _device,
+                                     VkPhysicalDevice                   _physDevice,
+                                     std::shared_ptr< MemoryAllocator > _allocator,
+                                     const ShaderManager&               _shaderManager )
+    : device{ _device }, physDevice{ _physDevice }, allocator{ std::move( _allocator ) }
+{
+    // only texelFetch is used
+    VkSamplerCreateInfo samplerInfo = {
+        .sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter               = VK_FILTER_NEAREST,
+        .minFilter               = VK_FILTER_NEAREST,
+        .mipmapMode              = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .minLod                  = 0.0f,
+        .maxLod                  = 0.0f,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+    VkResult r = vkCreateSampler( device, &samplerInfo, nullptr, &sampler );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, sampler, VK_OBJECT_TYPE_SAMPLER, "Readback sampler" );
+
+    CreateDescriptors();
+    CreatePipelineLayout();
+    CreatePipeline( &_shaderManager );
+}
+
+RTGL1::FrameReadback::~FrameReadback()
+{
+    // the device is idle, but the results are not waited: just notify that they're not going
+    // to be delivered, so the application can free the user data
+    for( auto& perFrame : targets )
+    {
+        for( Target& t : perFrame )
+        {
+            if( t.request )
+            {
+                Call( *t.request, RgReadbackResult{ .frameNumber = t.frameNumber } );
+            }
+            DestroyTarget( t );
+        }
+    }
+
+    for( const RgReadbackRequestInfo& r : requests )
+    {
+        Call( r, RgReadbackResult{} );
+    }
+
+    vkDestroyDescriptorPool( device, descPool, nullptr );
+    vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
+    DestroyPipeline();
+    vkDestroyDescriptorSetLayout( device, descSetLayout, nullptr );
+    vkDestroySampler( device, sampler, nullptr );
+}
+
+void RTGL1::FrameReadback::Request( const RgReadbackRequestInfo& info )
+{
+    assert( info.pfnCallback );
+
+    auto l = std::lock_guard{ requestsMutex };
+
+    auto& r = requests.emplace_back( info );
+    // the chain is not copied
+    r.pNext = nullptr;
+}
+
+void RTGL1::FrameReadback::Deliver( uint32_t frameIndex )
+{
+    for( Target& t : targets[ frameIndex ] )
+    {
+        if( !t.request )
+        {
+            continue;
+        }
+
+        const auto request = *std::exchange( t.request, std::nullopt );
+
+        if( t.failed )
+        {
+            Call( request, RgReadbackResult{ .frameNumber = t.frameNumber } );
+            continue;
+        }
+
+        Call( request,
+              RgReadbackResult{
+                  .pPixels     = t.buffer.Map(),
+                  .width       = t.extent.width,
+                  .height      = t.extent.height,
+                  .frameNumber = t.frameNumber,
+                  .format      = t.format,
+              } );
+        t.buffer.Unmap();
+    }
+}
+
+void RTGL1::FrameReadback::Call( const RgReadbackRequestInfo& request,
+                                 const RgReadbackResult&      result )
+{
+    assert( request.pfnCallback );
+    request.pfnCallback( &result, request.pUserData );
+}
+
+void RTGL1::FrameReadback::PrepareTarget( Target&           target,
+                                          const VkExtent2D& extent,
+                                          RgReadbackFormat  format )
+{
+    if( target.image != VK_NULL_HANDLE && target.extent.width == extent.width &&
+        target.extent.height == extent.height && target.format == format )
+    {
+        return;
+    }
+
+    const bool nv12 = ( format == RG_READBACK_FORMAT_NV12 );
+
+    // the previous copy was already delivered, as the fence of this frame index was waited
+    DestroyTarget( target );
+
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_STAGING };
+
+    auto info = VkImageCreateInfo{
+        .sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType     = VK_IMAGE_TYPE_2D,
+        .format        = ReadbackFormat,
+        .extent        = { extent.width, extent.height, 1 },
+        .mipLevels     = 1,
+        .arrayLayers   = 1,
+        .samples       = VK_SAMPLE_COUNT_1_BIT,
+        .tiling        = VK_IMAGE_TILING_OPTIMAL,
+        .usage         = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                 ( nv12 ? VK_IMAGE_USAGE_SAMPLED_BIT : 0u ),
+        .sharingMode   = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    VkResult r = vkCreateImage( device, &info, nullptr, &target.image );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, target.image, VK_OBJECT_TYPE_IMAGE, "Readback image" );
+
+    VkMemoryRequirements memReqs = {};
+    vkGetImageMemoryRequirements( device, target.image, &memReqs );
+
+    target.memory = allocator->AllocDedicated( memReqs,
+                                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                               MemoryAllocator::AllocType::DEFAULT,
+                                               "Readback image memory" );
+
+    r = vkBindImageMemory( device, target.image, target.memory, 0 );
+    VK_CHECKERROR( r );
+
+    // NV12 is written by the conversion shader, RGBA is copied from the image
+    const VkBufferUsageFlags bufferUsage =
+        nv12 ? VK_BUFFER_USAGE_STORAGE_BUFFER_BIT : VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+    target.buffer.Init( *allocator,
+                        GetBufferSize( extent, format ),
+                        bufferUsage,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                        "Readback buffer" );
+
+    target.extent = extent;
+    target.format = format;
+
+    if( nv12 )
+    {
+        auto viewInfo = VkImageViewCreateInfo{
+            .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+            .image            = target.image,
+            .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+            .format           = ReadbackFormat,
+            .components       = {},
+            .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
+        };
+
+        r = vkCreateImageView( device, &viewInfo, nullptr, &target.view );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device, target.view, VK_OBJECT_TYPE_IMAGE_VIEW, "Readback image view" );
+
+        auto src = VkDescriptorImageInfo{
+            .sampler     = sampler,
+            .imageView   = target.view,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+
+        auto dst = VkDescriptorBufferInfo{
+            .buffer = target.buffer.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        };
+
+        VkWriteDescriptorSet wrts[] = {
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = target.descSet,
+                .dstBinding      = BINDING_READBACK_NV12_SRC,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo      = &src,
+            },
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = target.descSet,
+                .dstBinding      = BINDING_READBACK_NV12_DST,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo     = &dst,
+            },
+        };
+
+        // the set is not in use, as the fence of this frame index was waited
+        vkUpdateDescriptorSets( device, std::size( wrts ), wrts, 0, nullptr );
+    }
+}
+
+void RTGL1::FrameReadback::DestroyTarget( Target& target )
+{
+    if( target.view != VK_NULL_HANDLE )
+    {
+        vkDestroyImageView( device, target.view, nullptr );
+        target.view = VK_NULL_HANDLE;
+    }
+    if( target.image != VK_NULL_HANDLE )
+    {
+        vkDestroyImage( device, target.image, nullptr );
+        target.image = VK_NULL_HANDLE;
+    }
+    if( target.memory != VK_NULL_HANDLE )
+    {
+        MemoryAllocator::FreeDedicated( device, target.memory );
+        target.memory = VK_NULL_HANDLE;
+    }
+    target.buffer.Destroy();
+    target.extent = {};
+}
+
+void RTGL1::FrameReadback::CopyForReadback( VkCommandBuffer        cmd,
+                                            uint32_t               frameIndex,
+                                            uint64_t               frameNumber,
+                                            Framebuffers&          framebuffers,
+                                            const ResolutionState& resolutionState,
+                                            FramebufferImageIndex  final )
+{
+    std::vector< RgReadbackRequestInfo > toCopy;
+    {
+        auto l = std::lock_guard{ requestsMutex };
+
+        const size_t count = std::min< size_t >( requests.size(), MaxRequestsPerFrame );
+
+        toCopy.assign( requests.begin(), requests.begin() + count );
+        requests.erase( requests.begin(), requests.begin() + count );
+    }
+
+    if( toCopy.empty() )
+    {
+        return;
+    }
+
+    constexpr auto subresource = VkImageSubresourceRange{
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel   = 0,
+        .levelCount     = 1,
+        .baseArrayLayer = 0,
+        .layerCount     = 1,
+    };
+
+    constexpr auto subresourceLayers = VkImageSubresourceLayers{
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .mipLevel       = 0,
+        .baseArrayLayer = 0,
+        .layerCount     = 1,
+    };
+
+    for( uint32_t i = 0; i < toCopy.size(); i++ )
+    {
+        Target& t = targets[ frameIndex ][ i ];
+        assert( !t.request );
+
+        t.request     = toCopy[ i ];
+        t.frameNumber = frameNumber;
+        t.failed      = true;
+
+        auto fb = SourceToFramebuffer( toCopy[ i ].source, final );
+        if( !fb )
+        {
+            debug::Warning( "rgRequestReadback: unknown RgReadbackSource {}",
+                            int( toCopy[ i ].source ) );
+            continue;
+        }
+
+        auto [ srcImage, srcView, srcFormat, srcExtent ] =
+            framebuffers.GetImageHandles( *fb, frameIndex, resolutionState );
+
+        VkFormatProperties props = {};
+        vkGetPhysicalDeviceFormatProperties( physDevice, srcFormat, &props );
+
+        if( !( props.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT ) )
+        {
+            debug::Warning( "rgRequestReadback: the image can't be converted on GPU" );
+            continue;
+        }
+
+        const bool nv12 = ( toCopy[ i ].format == RG_READBACK_FORMAT_NV12 );
+        if( !nv12 && toCopy[ i ].format != RG_READBACK_FORMAT_R8G8B8A8_SRGB )
+        {
+            debug::Warning( "rgRequestReadback: unknown RgReadbackFormat {}",
+                            int( toCopy[ i ].format ) );
+            continue;
+        }
+
+        const VkExtent2D fitExtent = FitInto( srcExtent, toCopy[ i ].maxSize );
+        const VkExtent2D dstExtent = nv12 ? AlignForNV12( fitExtent ) : fitExtent;
+        const bool       linear =
+            ( dstExtent.width != srcExtent.width || dstExtent.height != srcExtent.height ) &&
+            ( props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT );
+
+        PrepareTarget( t, dstExtent, toCopy[ i ].format );
+        t.failed = false;
+
+        framebuffers.BarrierOne( cmd, frameIndex, *fb );
+
+        {
+            auto b = VkImageMemoryBarrier2{
+                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask        = VK_PIPELINE_STAGE_2_NONE,
+                .srcAccessMask       = VK_ACCESS_2_NONE,
+                .dstStageMask        = VK_PIPELINE_STAGE_2_BLIT_BIT,
+                .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image               = t.image,
+                .subresourceRange    = subresource,
+            };
+
+            auto dep = VkDependencyInfo{
+                .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .imageMemoryBarrierCount = 1,
+                .pImageMemoryBarriers    = &b,
+            };
+
+            svkCmdPipelineBarrier2KHR( cmd, &dep );
+        }
+
+        // blit converts to sRGB and downscales
+        {
+            const auto srcEnd = VkOffset3D{
+                int32_t( srcExtent.width ),
+                int32_t( srcExtent.height ),
+                1,
+            };
+            const auto dstEnd = VkOffset3D{
+                int32_t( dstExtent.width ),
+                int32_t( dstExtent.height ),
+                1,
+            };
+
+            auto region = VkImageBlit{
+                .srcSubresource = subresourceLayers,
+                .srcOffsets     = { {}, srcEnd },
+                .dstSubresource = subresourceLayers,
+                .dstOffsets     = { {}, dstEnd },
+            };
+
+            vkCmdBlitImage( cmd,
+                            srcImage,
+                            VK_IMAGE_LAYOUT_GENERAL,
+                            t.image,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            1,
+                            &region,
+                            linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST );
+        }
+
+        if( nv12 )
+        {
+            ConvertToNV12( cmd, t );
+            continue;
+        }
+
+        {
+            auto b = VkImageMemoryBarrier2{
+                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask        = VK_PIPELINE_STAGE_2_BLIT_BIT,
+                .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                .dstStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+                .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+                .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image               = t.image,
+                .subresourceRange    = subresource,
+            };
+
+            auto dep = VkDependencyInfo{
+                .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .imageMemoryBarrierCount = 1,
+                .pImageMemoryBarriers    = &b,
+            };
+
+            svkCmdPipelineBarrier2KHR( cmd, &dep );
+        }
+
+        {
+            auto region = VkBufferImageCopy{
+                .bufferOffset      = 0,
+                .bufferRowLength   = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource  = subresourceLayers,
+                .imageOffset       = {},
+                .imageExtent       = { dstExtent.width, dstExtent.height, 1 },
+            };
+
+            vkCmdCopyImageToBuffer( cmd,
+                                    t.image,
+                                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                    t.buffer.GetBuffer(),
+                                    1,
+                                    &region );
+        }
+
+        {
+            auto b = VkBufferMemoryBarrier2{
+                .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+                .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+                .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                .dstStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,
+                .dstAccessMask       = VK_ACCESS_2_HOST_READ_BIT,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .buffer              = t.buffer.GetBuffer(),
+                .offset              = 0,
+                .size                = VK_WHOLE_SIZE,
+            };
+
+            auto dep = VkDependencyInfo{
+                .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                .bufferMemoryBarrierCount = 1,
+                .pBufferMemoryBarriers    = &b,
+            };
+
+            svkCmdPipelineBarrier2KHR( cmd, &dep );
+        }
+    }
+}
+
+void RTGL1::FrameReadback::ConvertToNV12( VkCommandBuffer cmd, const Target& target )
+{
+    assert( target.format == RG_READBACK_FORMAT_NV12 );
+    assert( target.extent.width % 4 == 0 && target.extent.height % 2 == 0 );
+
+    CmdLabel label( cmd, "Readback NV12" );
+
+    {
+        auto b = VkImageMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_BLIT_BIT,
+            .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = target.image,
+            .subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
+        };
+
+        auto dep = VkDependencyInfo{
+            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers    = &b,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    static_assert( sizeof( ReadbackNV12Push ) == 2 * sizeof( uint32_t ),
+                   "Must match CmReadbackNV12.comp" );
+
+    const auto push = ReadbackNV12Push{
+        .width  = target.extent.width,
+        .height = target.extent.height,
+    };
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineNV12 );
+    vkCmdBindDescriptorSets(
+        cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &target.descSet, 0, nullptr );
+    vkCmdPushConstants(
+        cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( push ), &push );
+    vkCmdDispatch(
+        cmd,
+        Utils::GetWorkGroupCount( target.extent.width / 4, COMPUTE_READBACK_NV12_GROUP_SIZE ),
+        Utils::GetWorkGroupCount( target.extent.height / 2, COMPUTE_READBACK_NV12_GROUP_SIZE ),
+        1 );
+
+    {
+        auto b = VkBufferMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask       = VK_ACCESS_2_SHADER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,
+            .dstAccessMask       = VK_ACCESS_2_HOST_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = target.buffer.GetBuffer(),
+            .offset              = 0,
+            .size                = VK_WHOLE_SIZE,
+        };
+
+        auto dep = VkDependencyInfo{
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+}
+
+void RTGL1::FrameReadback::OnShaderReload( const ShaderManager* shaderManager )
+{
+    if( !shaderManager->AnyChanged( { "CReadbackNV12" } ) )
+    {
+        return;
+    }
+
+    DestroyPipeline();
+    CreatePipeline( shaderManager );
+}
+
+void RTGL1::FrameReadback::CreateDescriptors()
+{
+    VkDescriptorSetLayoutBinding bindings[] = {
+        {
+            .binding         = BINDING_READBACK_NV12_SRC,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_READBACK_NV12_DST,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = std::size( bindings ),
+        .pBindings    = bindings,
+    };
+
+    VkResult r = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descSetLayout );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME(
+        device, descSetLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "Readback Desc set layout" );
+
+    // a set per target, so they are never reallocated
+    constexpr uint32_t setCount = MAX_FRAMES_IN_FLIGHT * MaxRequestsPerFrame;
+
+    VkDescriptorPoolSize poolSizes[] = {
+        {
+            .type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = setCount,
+        },
+        {
+            .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = setCount,
+        },
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo = {
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets       = setCount,
+        .poolSizeCount = std::size( poolSizes ),
+        .pPoolSizes    = poolSizes,
+    };
+
+    r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &descPool );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, descPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Readback Desc pool" );
+
+    for( auto& perFrame : targets )
+    {
+        for( Target& t : perFrame )
+        {
+            VkDescriptorSetAllocateInfo allocInfo = {
+                .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                .descriptorPool     = descPool,
+                .descriptorSetCount = 1,
+                .pSetLayouts        = &descSetLayout,
+            };
+
+            r = vkAllocateDescriptorSets( device, &allocInfo, &t.descSet );
+            VK_CHECKERROR( r );
+            SET_DEBUG_NAME( device, t.descSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Readback Desc set" );
+        }
+    }
+}
+
+void RTGL1::FrameReadback::CreatePipelineLayout()
+{
+    VkPushConstantRange push = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset     = 0,
+        .size       = sizeof( ReadbackNV12Push ),
+    };
+
+    VkPipelineLayoutCreateInfo plLayoutInfo = {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount         = 1,
+        .pSetLayouts            = &descSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &push,
+    };
+
+    VkResult r = vkCreatePipelineLayout( device, &plLayoutInfo, nullptr, &pipelineLayout );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME(
+        device, pipelineLayout, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "Readback pipeline layout" );
+}
+
+void RTGL1::FrameReadback::CreatePipeline( const ShaderManager* shaderManager )
+{
+    VkComputePipelineCreateInfo plInfo = {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = shaderManager->GetStageInfo( "CReadbackNV12" ),
+        .layout = pipelineLayout,
+    };
+
+    VkResult r = vkCreateComputePipelines( device,
+                                           shaderManager->GetPipelineCache(),
+                                           1,
+                                           &plInfo,
+                                           nullptr,
+                                           &pipelineNV12 );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, pipelineNV12, VK_OBJECT_TYPE_PIPELINE, "Readback NV12 pipeline" );
+}
+
+void RTGL1::FrameReadback::DestroyPipeline()
+{
+    vkDestroyPipeline( device, pipelineNV12, nullptr );
+    pipelineNV12 = VK_NULL_HANDLE;
+}
@@ -0,0 +1,118 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Buffer.h"
+#include "Framebuffers.h"
+#include "ShaderManager.h"
+
+#include <mutex>
+
+namespace RTGL1
+{
+
+// Copies of the frame images requested by rgRequestReadback. A requested image is blitted
+// into an R8G8B8A8 image, optionally downscaled, and copied to a host-visible buffer.
+// The callback is called when the fence of that frame index is waited,
+// so the render thread is never stalled. Images and buffers are pooled per frame index.
+// For NV12, the blitted image is converted by a compute shader instead of the copy.
+class FrameReadback : public IShaderDependency
+{
+public:
+    FrameReadback( VkDevice                           device,
+                   VkPhysicalDevice                   physDevice,
+                   std::shared_ptr< MemoryAllocator > allocator,
+                   const ShaderManager&               shaderManager );
+    ~FrameReadback() override;
+
+    FrameReadback( const FrameReadback& other )                = delete;
+    FrameReadback( FrameReadback&& other ) noexcept            = delete;
+    FrameReadback& operator=( const FrameReadback& other )     = delete;
+    FrameReadback& operator=( FrameReadback&& other ) noexcept = delete;
+
+    // Can be called from any thread
+    void Request( const RgReadbackRequestInfo& info );
+
+    // Must be called after the fence of 'frameIndex' was waited
+    void Deliver( uint32_t frameIndex );
+
+    // Must be called after the frame was fully rendered, 'final' is the presented image
+    void CopyForReadback( VkCommandBuffer        cmd,
+                          uint32_t               frameIndex,
+                          uint64_t               frameNumber,
+                          Framebuffers&          framebuffers,
+                          const ResolutionState& resolutionState,
+                          FramebufferImageIndex  final );
+
+    void OnShaderReload( const ShaderManager* shaderManager ) override;
+
+private:
+    struct Target
+    {
+        VkImage          image{ VK_NULL_HANDLE };
+        VkDeviceMemory   memory{ VK_NULL_HANDLE };
+        VkImageView      view{ VK_NULL_HANDLE };
+        Buffer           buffer{};
+        VkExtent2D       extent{};
+        RgReadbackFormat format{ RG_READBACK_FORMAT_R8G8B8A8_SRGB };
+        // preallocated, written only for NV12
+        VkDescriptorSet  descSet{ VK_NULL_HANDLE };
+
+        // set, if the copy was recorded into this target
+        std::optional< RgReadbackRequestInfo > request{};
+        uint64_t                               frameNumber{ 0 };
+        bool                                   failed{ false };
+    };
+
+    void PrepareTarget( Target& target, const VkExtent2D& extent, RgReadbackFormat format );
+    void DestroyTarget( Target& target );
+
+    void ConvertToNV12( VkCommandBuffer cmd, const Target& target );
+
+    void CreateDescriptors();
+    void CreatePipelineLayout();
+    void CreatePipeline( const ShaderManager* shaderManager );
+    void DestroyPipeline();
+
+    static void Call( const RgReadbackRequestInfo& request, const RgReadbackResult& result );
+
+private:
+    VkDevice                           device;
+    VkPhysicalDevice                   physDevice;
+    std::shared_ptr< MemoryAllocator > allocator;
+
+    std::mutex                           requestsMutex{};
+    std::vector< RgReadbackRequestInfo > requests{};
+
+    // other requests are kept until the next frame
+    constexpr static uint32_t MaxRequestsPerFrame = 4;
+
+    Target targets[ MAX_FRAMES_IN_FLIGHT ][ MaxRequestsPerFrame ]{};
+
+    VkSampler             sampler{ VK_NULL_HANDLE };
+    VkDescriptorSetLayout descSetLayout{ VK_NULL_HANDLE };
+    VkDescriptorPool      descPool{ VK_NULL_HANDLE };
+    VkPipelineLayout      pipelineLayout{ VK_NULL_HANDLE };
+    VkPipeline            pipelineNV12{ VK_NULL_HANDLE };
+};
+
+}
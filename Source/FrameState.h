@@ -30,7 +30,7 @@ namespace RTGL1
 struct FrameState
 {
 private:
-    // [0..MAX_FRAMES_IN_FLIGHT-1]
+    // [0..FramesInFlight()-1]
     uint32_t        frameIndex;
     VkCommandBuffer frameCmd;
     VkSemaphore     semaphoreToWait;
@@ -41,7 +41,7 @@ private:
 
 public:
     FrameState()
-        : frameIndex( MAX_FRAMES_IN_FLIGHT - 1 )
+        : frameIndex( 0 )
         , frameCmd( VK_NULL_HANDLE )
         , semaphoreToWait( VK_NULL_HANDLE )
         , preFrameCmd( VK_NULL_HANDLE )
@@ -53,22 +53,29 @@ public:
     FrameState& operator=( const FrameState& other ) = delete;
     FrameState& operator=( FrameState&& other ) noexcept = delete;
 
+    // Must be called after SetFramesInFlight, so the first frame has index 0,
+    // and out-of-frame calls before it use the last valid one
+    void ResetFrameIndex()
+    {
+        frameIndex = FramesInFlight() - 1;
+    }
+
     uint32_t    IncrementFrameIndexAndGet()
     {
-        frameIndex = ( frameIndex + 1 ) % MAX_FRAMES_IN_FLIGHT;
+        frameIndex = ( frameIndex + 1 ) % FramesInFlight();
         return frameIndex;
     }
 
     uint32_t GetFrameIndex() const
     {
-        assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
+        assert( frameIndex < FramesInFlight() );
         return frameIndex;
     }
 
     static uint32_t GetPrevFrameIndex( uint32_t frameIndex )
     {
-        assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
-        return ( frameIndex + ( MAX_FRAMES_IN_FLIGHT - 1 ) ) % MAX_FRAMES_IN_FLIGHT;
+        assert( frameIndex < FramesInFlight() );
+        return ( frameIndex + ( FramesInFlight() - 1 ) ) % FramesInFlight();
     }
 
     void OnBeginFrame( VkCommandBuffer cmd )
@@ -0,0 +1,144 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FramebufferGraph.h"
+
+namespace
+{
+
+// same as Framebuffers::BarrierType::All
+constexpr VkPipelineStageFlags2 UnknownSrcStage =
+    VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT | VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR |
+    VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT;
+constexpr VkAccessFlags2 UnknownSrcAccess = VK_ACCESS_2_SHADER_WRITE_BIT |
+                                            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                                            VK_ACCESS_2_TRANSFER_WRITE_BIT;
+
+}
+
+RTGL1::FramebufferGraph::FramebufferGraph( VkCommandBuffer       _cmd,
+                                           uint32_t              _frameIndex,
+                                           const Framebuffers&   _framebuffers,
+                                           VkPipelineStageFlags2 _stage )
+    : cmd( _cmd ), frameIndex( _frameIndex ), framebuffers( _framebuffers ), stage( _stage )
+{
+}
+
+auto RTGL1::FramebufferGraph::GetState( FramebufferImageIndex index ) -> ImageState&
+{
+    // history framebuffers are resolved, so the same image is tracked by any of its indices
+    VkImage image = framebuffers.GetImage( index, frameIndex );
+
+    for( ImageState& s : states )
+    {
+        if( s.image == image )
+        {
+            return s;
+        }
+    }
+    return states.emplace_back( ImageState{ .image = image } );
+}
+
+bool RTGL1::FramebufferGraph::Pass( std::span< const FramebufferImageIndex > reads,
+                                    std::span< const FramebufferImageIndex > writes )
+{
+    barriers.clear();
+
+    auto addBarrier = [ this ]( VkImage               image,
+                                VkPipelineStageFlags2 srcStage,
+                                VkAccessFlags2        srcAccess,
+                                VkAccessFlags2        dstAccess ) {
+        barriers.push_back( VkImageMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask        = srcStage,
+            .srcAccessMask       = srcAccess,
+            .dstStageMask        = stage,
+            .dstAccessMask       = dstAccess,
+            .oldLayout           = VK_IMAGE_LAYOUT_GENERAL,
+            .newLayout           = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = image,
+            .subresourceRange    = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                                     .baseMipLevel   = 0,
+                                     .levelCount     = 1,
+                                     .baseArrayLayer = 0,
+                                     .layerCount     = 1 },
+        } );
+    };
+
+    for( FramebufferImageIndex r : reads )
+    {
+        assert( std::ranges::find( writes, r ) == writes.end() );
+        ImageState& s = GetState( r );
+
+        if( !s.known )
+        {
+            addBarrier( s.image, UnknownSrcStage, UnknownSrcAccess, VK_ACCESS_2_SHADER_READ_BIT );
+            s = ImageState{ .image = s.image, .known = true };
+        }
+        // read-after-write
+        else if( s.pendingWrite != 0 && ( s.visibleTo & stage ) != stage )
+        {
+            addBarrier( s.image,
+                        s.pendingWrite,
+                        VK_ACCESS_2_SHADER_WRITE_BIT,
+                        VK_ACCESS_2_SHADER_READ_BIT );
+            s.visibleTo |= stage;
+        }
+        s.readers |= stage;
+    }
+
+    for( FramebufferImageIndex w : writes )
+    {
+        ImageState& s = GetState( w );
+
+        constexpr VkAccessFlags2 dstAccess =
+            VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT;
+
+        if( !s.known )
+        {
+            addBarrier( s.image, UnknownSrcStage, UnknownSrcAccess, dstAccess );
+        }
+        // write-after-write, write-after-read
+        else if( s.pendingWrite != 0 || s.readers != 0 )
+        {
+            addBarrier( s.image,
+                        s.pendingWrite | s.readers,
+                        s.pendingWrite != 0 ? VK_ACCESS_2_SHADER_WRITE_BIT : VK_ACCESS_2_NONE,
+                        dstAccess );
+        }
+        s = ImageState{ .image = s.image, .known = true, .pendingWrite = stage };
+    }
+
+    if( barriers.empty() )
+    {
+        return false;
+    }
+
+    auto dependencyInfo = VkDependencyInfo{
+        .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .imageMemoryBarrierCount = uint32_t( barriers.size() ),
+        .pImageMemoryBarriers    = barriers.data(),
+    };
+    svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
+
+    return true;
+}
@@ -0,0 +1,82 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "Framebuffers.h"
+
+namespace RTGL1
+{
+
+// Records framebuffer reads and writes of consecutive passes, and inserts only
+// the barriers that are required between them, batched into one call per pass.
+// An image starts in an unknown state, so its first access waits for any previous
+// work, as Framebuffers::BarrierMultiple does. Within the graph's lifetime, its
+// images must not be accessed by the passes that are not declared in it.
+class FramebufferGraph
+{
+public:
+    // 'stage' is where all of the passes access the images
+    FramebufferGraph( VkCommandBuffer       cmd,
+                      uint32_t              frameIndex,
+                      const Framebuffers&   framebuffers,
+                      VkPipelineStageFlags2 stage = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT );
+    ~FramebufferGraph() = default;
+
+    FramebufferGraph( const FramebufferGraph& other )                = delete;
+    FramebufferGraph( FramebufferGraph&& other ) noexcept            = delete;
+    FramebufferGraph& operator=( const FramebufferGraph& other )     = delete;
+    FramebufferGraph& operator=( FramebufferGraph&& other ) noexcept = delete;
+
+    // Must be called before recording the pass. An image that is both read and
+    // written should be only in 'writes'. Returns false, if the pass doesn't depend
+    // on the previous ones, i.e. it may run concurrently with them
+    bool Pass( std::span< const FramebufferImageIndex > reads,
+               std::span< const FramebufferImageIndex > writes );
+
+private:
+    struct ImageState
+    {
+        VkImage               image{ VK_NULL_HANDLE };
+        bool                  known{ false };
+        // stage of the last write, if it's not visible to all of the subsequent readers
+        VkPipelineStageFlags2 pendingWrite{ 0 };
+        // stages that already wait for the pending write
+        VkPipelineStageFlags2 visibleTo{ 0 };
+        // stages that read the image since the last write
+        VkPipelineStageFlags2 readers{ 0 };
+    };
+
+    ImageState& GetState( FramebufferImageIndex index );
+
+private:
+    VkCommandBuffer       cmd;
+    uint32_t              frameIndex;
+    const Framebuffers&   framebuffers;
+    VkPipelineStageFlags2 stage;
+
+    std::vector< ImageState >            states;
+    std::vector< VkImageMemoryBarrier2 > barriers;
+};
+
+}
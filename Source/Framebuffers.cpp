@@ -28,17 +28,142 @@ using namespace RTGL1;
 #include "Bloom.h"
 
 #include "DX12_Interop.h"
+#include "HitchRecorder.h"
+#include "LibraryConfig.h"
 
+#include <algorithm>
 #include <vector>
 
-static_assert( MAX_FRAMES_IN_FLIGHT == FRAMEBUFFERS_HISTORY_LENGTH,
-               "Framebuffers class logic must be changed if history length is not equal to max "
-               "frames in flight" );
+static_assert( FRAMEBUFFERS_HISTORY_LENGTH == 2,
+               "Framebuffers class logic must be changed if history length is not 2" );
+
+namespace
+{
+
+struct TransientLifetime
+{
+    FramebufferImageIndex index;
+    FramebufferPass       first;
+    FramebufferPass       last;
+};
+
+using FP = FramebufferPass;
+
+// Framebuffers that are written and fully consumed within one frame, in [first, last] passes.
+// Not listed ones (history, attachments, transfer sources, etc) always have their own memory.
+// When changing which passes access these images, update the table.
+constexpr TransientLifetime TransientLifetimes[] = {
+    // ReSTIR initial samples
+    { FB_IMAGE_INDEX_RESERVOIRS_INITIAL, FP::DirectIllumination, FP::DirectIllumination },
+    { FB_IMAGE_INDEX_INDIRECT_RESERVOIRS_INITIAL,
+      FP::IndirectIllumination,
+      FP::IndirectIllumination },
+    // noisy illumination, debug views read it on composition
+    { FB_IMAGE_INDEX_UNFILTERED_DIRECT, FP::DirectIllumination, FP::Composition },
+    { FB_IMAGE_INDEX_UNFILTERED_SPECULAR, FP::DirectIllumination, FP::Composition },
+    { FB_IMAGE_INDEX_UNFILTERED_INDIR, FP::IndirectIllumination, FP::Composition },
+    // SVGF intermediates, the last atrous iteration outputs to PreFinal
+    { FB_IMAGE_INDEX_DIFF_TEMPORARY, FP::Denoise, FP::Denoise },
+    { FB_IMAGE_INDEX_DIFF_PING_COLOR_AND_VARIANCE, FP::Denoise, FP::Denoise },
+    { FB_IMAGE_INDEX_DIFF_PONG_COLOR_AND_VARIANCE, FP::Denoise, FP::Denoise },
+    { FB_IMAGE_INDEX_SPEC_PING_COLOR, FP::Denoise, FP::Denoise },
+    { FB_IMAGE_INDEX_SPEC_PONG_COLOR, FP::Denoise, FP::Denoise },
+    { FB_IMAGE_INDEX_INDIR_PING, FP::Denoise, FP::Denoise },
+    { FB_IMAGE_INDEX_INDIR_PONG, FP::Denoise, FP::Denoise },
+    { FB_IMAGE_INDEX_ATROUS_FILTERED_VARIANCE, FP::Denoise, FP::Denoise },
+    // bloom mip chain
+    { FB_IMAGE_INDEX_BLOOM, FP::Bloom, FP::Bloom },
+    { FB_IMAGE_INDEX_BLOOM_MIP1, FP::Bloom, FP::Bloom },
+    { FB_IMAGE_INDEX_BLOOM_MIP2, FP::Bloom, FP::Bloom },
+    { FB_IMAGE_INDEX_BLOOM_MIP3, FP::Bloom, FP::Bloom },
+    { FB_IMAGE_INDEX_BLOOM_MIP4, FP::Bloom, FP::Bloom },
+    { FB_IMAGE_INDEX_BLOOM_MIP5, FP::Bloom, FP::Bloom },
+    { FB_IMAGE_INDEX_BLOOM_MIP6, FP::Bloom, FP::Bloom },
+    { FB_IMAGE_INDEX_BLOOM_MIP7, FP::Bloom, FP::Bloom },
+};
+
+bool Overlap( const TransientLifetime& a, const TransientLifetime& b )
+{
+    return a.first <= b.last && b.first <= a.last;
+}
+
+struct AliasedBlock
+{
+    std::vector< const TransientLifetime* > users;
+    VkMemoryRequirements                    memReqs;
+};
+
+// Greedy: the biggest images are placed first, then smaller ones
+// reuse a block, if they're not alive at the same time as any of its users
+std::vector< AliasedBlock > PlanAliasedBlocks( const std::vector< VkMemoryRequirements >& memReqs )
+{
+    std::vector< const TransientLifetime* > sorted;
+    for( const auto& t : TransientLifetimes )
+    {
+        assert( ( ShFramebuffers_Flags[ t.index ] &
+                  ( FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_STORE_PREV |
+                    FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_IS_ATTACHMENT |
+                    FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_USAGE_TRANSFER ) ) == 0 );
+        sorted.push_back( &t );
+    }
+
+    std::ranges::stable_sort(
+        sorted, [ & ]( const TransientLifetime* a, const TransientLifetime* b ) {
+            return memReqs[ a->index ].size > memReqs[ b->index ].size;
+        } );
+
+    std::vector< AliasedBlock > blocks;
+
+    for( const TransientLifetime* t : sorted )
+    {
+        const VkMemoryRequirements& req = memReqs[ t->index ];
+
+        auto l_fits = [ & ]( const AliasedBlock& b ) {
+            return ( b.memReqs.memoryTypeBits & req.memoryTypeBits ) != 0 &&
+                   std::ranges::none_of( b.users, [ & ]( const TransientLifetime* other ) {
+                       return Overlap( *t, *other );
+                   } );
+        };
+
+        auto found = std::ranges::find_if( blocks, l_fits );
+        if( found == blocks.end() )
+        {
+            blocks.push_back( AliasedBlock{ .users = { t }, .memReqs = req } );
+        }
+        else
+        {
+            found->users.push_back( t );
+            found->memReqs.size           = std::max( found->memReqs.size, req.size );
+            found->memReqs.alignment      = std::max( found->memReqs.alignment, req.alignment );
+            found->memReqs.memoryTypeBits = found->memReqs.memoryTypeBits & req.memoryTypeBits;
+        }
+    }
+
+    return blocks;
+}
+
+bool IsCompactFormatSupported( VkPhysicalDevice physDevice, uint32_t index )
+{
+    VkFormatProperties props = {};
+    vkGetPhysicalDeviceFormatProperties(
+        physDevice, ShFramebuffers_FormatsCompact[ index ], &props );
+
+    VkFormatFeatureFlags required =
+        VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    if( ShFramebuffers_Flags[ index ] & FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_BILINEAR_SAMPLER )
+    {
+        required |= VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    }
+
+    return ( props.optimalTilingFeatures & required ) == required;
+}
+
+}
 
 FramebufferImageIndex Framebuffers::FrameIndexToFBIndex(
-    FramebufferImageIndex framebufferImageIndex, uint32_t frameIndex )
+    FramebufferImageIndex framebufferImageIndex, uint32_t frameIndex ) const
 {
-    assert( frameIndex < FRAMEBUFFERS_HISTORY_LENGTH );
+    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
     assert( framebufferImageIndex >= 0 && framebufferImageIndex < ShFramebuffers_Count );
 
     // if framubuffer with given index can be swapped,
@@ -46,7 +171,7 @@ FramebufferImageIndex Framebuffers::FrameIndexToFBIndex(
     if( ShFramebuffers_Bindings[ framebufferImageIndex ] !=
         ShFramebuffers_BindingsSwapped[ framebufferImageIndex ] )
     {
-        return ( FramebufferImageIndex )( framebufferImageIndex + frameIndex );
+        return ( FramebufferImageIndex )( framebufferImageIndex + historyIndex[ frameIndex ] );
     }
 
     return framebufferImageIndex;
@@ -65,6 +190,7 @@ Framebuffers::Framebuffers( VkDevice                                _device,
     , allocator( std::move( _allocator ) )
     , cmdManager( std::move( _cmdManager ) )
     , currentResolution{}
+    , allocatedResolution{}
     , descSetLayout( VK_NULL_HANDLE )
     , descPool( VK_NULL_HANDLE )
     , descSets{}
@@ -72,6 +198,30 @@ Framebuffers::Framebuffers( VkDevice                                _device,
     images.resize( ShFramebuffers_Count );
     imageMemories.resize( ShFramebuffers_Count );
     imageViews.resize( ShFramebuffers_Count );
+    isAliased.resize( ShFramebuffers_Count );
+    isShared.resize( ShFramebuffers_Count );
+
+    formats.assign( ShFramebuffers_Formats, ShFramebuffers_Formats + ShFramebuffers_Count );
+    if( info.compactFramebuffers )
+    {
+        for( uint32_t i = 0; i < ShFramebuffers_Count; i++ )
+        {
+            if( ShFramebuffers_FormatsCompact[ i ] == ShFramebuffers_Formats[ i ] )
+            {
+                continue;
+            }
+
+            if( IsCompactFormatSupported( physDevice, i ) )
+            {
+                formats[ i ] = ShFramebuffers_FormatsCompact[ i ];
+            }
+            else
+            {
+                debug::Warning( "{}: compact format is not supported, using the default one",
+                                ShFramebuffers_DebugNames[ i ] );
+            }
+        }
+    }
 
     CreateDescriptors();
     CreateSamplers();
@@ -106,8 +256,9 @@ void Framebuffers::CreateDescriptors()
                     .binding         = ShFramebuffers_Bindings[ i ],
                     .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
                     .descriptorCount = 1,
+                    // any-hit, for the ray cost counters
                     .stageFlags = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT |
-                                  VK_SHADER_STAGE_FRAGMENT_BIT,
+                                  VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_ANY_HIT_BIT_KHR,
                 };
         }
 
@@ -218,23 +369,91 @@ void RTGL1::Framebuffers::CreateSamplers()
     }
 }
 
-bool Framebuffers::PrepareForSize( ResolutionState resolutionState, bool needShared )
+void Framebuffers::PrepareForFrame( uint32_t frameIndex )
+{
+    // there might be more frames in flight than history images,
+    // so alternate them by frame, and not by frame index
+    historyIndex[ frameIndex ] =
+        ( historyIndex[ Utils::PrevFrame( frameIndex ) ] + 1 ) % FRAMEBUFFERS_HISTORY_LENGTH;
+}
+
+bool Framebuffers::PrepareForSize( ResolutionState resolutionState,
+                                   ResolutionState allocation,
+                                   bool            needShared )
 {
+    assert( resolutionState.renderWidth <= allocation.renderWidth &&
+            resolutionState.renderHeight <= allocation.renderHeight );
+
     const bool sharedExist = dxgi::Framebuf_HasSharedImages();
-    if( currentResolution == resolutionState && sharedExist == needShared )
+    // shared images might have been destroyed with a DXGI swapchain
+    const bool sharedLost = !sharedExist && std::ranges::any_of( isShared, std::identity{} );
+
+    currentResolution = resolutionState;
+
+    if( allocatedResolution == allocation && sharedExist == needShared && !sharedLost )
     {
         return false;
     }
 
+    RG_HITCH_MARKER( "Wait idle: framebuffers reallocation" );
+
     vkDeviceWaitIdle( device );
 
-    CreateImages( resolutionState, sharedExist, needShared );
+    CreateImages( allocation, needShared );
     ReportMemoryUsage( physDevice );
 
-    assert( currentResolution == resolutionState );
+    assert( allocatedResolution == allocation );
     return true;
 }
 
+void Framebuffers::BeginPass( VkCommandBuffer cmd, FramebufferPass pass )
+{
+    VkImageMemoryBarrier2KHR barriers[ std::size( TransientLifetimes ) ];
+    uint32_t                 count = 0;
+
+    for( const auto& t : TransientLifetimes )
+    {
+        if( t.first != pass || !isAliased[ t.index ] )
+        {
+            continue;
+        }
+
+        // previous contents belong to another image, so discard them;
+        // wait for everything, as the memory might be still in use by the previous frame
+        barriers[ count++ ] = {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR,
+            .srcAccessMask       = VK_ACCESS_2_MEMORY_WRITE_BIT_KHR,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR,
+            .dstAccessMask =
+                VK_ACCESS_2_MEMORY_READ_BIT_KHR | VK_ACCESS_2_MEMORY_WRITE_BIT_KHR,
+            .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+            .newLayout           = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = images[ t.index ],
+            .subresourceRange    = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                                     .baseMipLevel   = 0,
+                                     .levelCount     = 1,
+                                     .baseArrayLayer = 0,
+                                     .layerCount     = 1 },
+        };
+    }
+
+    if( count == 0 )
+    {
+        return;
+    }
+
+    VkDependencyInfoKHR dependencyInfo = {
+        .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+        .imageMemoryBarrierCount = count,
+        .pImageMemoryBarriers    = barriers,
+    };
+
+    svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
+}
+
 void RTGL1::Framebuffers::BarrierOne( VkCommandBuffer       cmd,
                                       uint32_t              frameIndex,
                                       FramebufferImageIndex framebufImageIndex,
@@ -575,7 +794,8 @@ RTGL1::FramebufferImageIndex RTGL1::Framebuffers::BlitForEffects(
 
 VkDescriptorSet Framebuffers::GetDescSet( uint32_t frameIndex ) const
 {
-    return descSets[ frameIndex ];
+    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
+    return descSets[ historyIndex[ frameIndex ] ];
 }
 
 VkDescriptorSetLayout Framebuffers::GetDescSetLayout() const
@@ -603,7 +823,7 @@ std::tuple< VkImage, VkImageView, VkFormat > RTGL1::Framebuffers::GetImageHandle
 
     return std::make_tuple( images[ fbImageIndex ],
                             imageViews[ fbImageIndex ],
-                            ShFramebuffers_Formats[ fbImageIndex ] );
+                            formats[ fbImageIndex ] );
 }
 
 std::tuple< VkImage, VkImageView, VkFormat, VkExtent2D > Framebuffers::GetImageHandles(
@@ -620,9 +840,9 @@ auto Framebuffers::GetImageForAlias( FramebufferImageIndex fbImageIndex, uint32_
     -> std::tuple< VkFormat, VkDeviceMemory >
 {
     fbImageIndex = FrameIndexToFBIndex( fbImageIndex, frameIndex );
+    assert( !isAliased[ fbImageIndex ] );
 
-    return std::make_tuple( ShFramebuffers_Formats[ fbImageIndex ],
-                            imageMemories[ fbImageIndex ] );
+    return std::make_tuple( formats[ fbImageIndex ], imageMemories[ fbImageIndex ] );
 }
 
 VkExtent2D RTGL1::Framebuffers::GetFramebufSize( const ResolutionState& resolutionState,
@@ -673,36 +893,40 @@ VkExtent2D RTGL1::Framebuffers::GetFramebufSize( const ResolutionState& resoluti
     return base;
 }
 
-void Framebuffers::CreateImages( ResolutionState resolutionState,
-                                 bool            sharedExist,
-                                 bool            needShared )
+void Framebuffers::CreateImages( ResolutionState resolutionState, bool needShared )
 {
-    const bool recreateOnlyShared = ( currentResolution == resolutionState && //
-                                      sharedExist != needShared );
-    if( recreateOnlyShared )
-    {
-        dxgi::Framebuf_Destroy();
-        if( needShared )
-        {
-            dxgi::Framebuf_CreateDX12Resources( *cmdManager, *allocator, resolutionState );
-        }
-        NotifySubscribersAboutResize( resolutionState );
+    // even if only the shared images are toggled, recreate everything,
+    // as the framebuffers point to the shared images directly
+    DestroyImages();
 
-        return;
+    if( needShared )
+    {
+        dxgi::Framebuf_CreateDX12Resources( *cmdManager, *allocator, resolutionState );
     }
 
-    DestroyImages();
-
     VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
 
     for( uint32_t i = 0; i < ShFramebuffers_Count; i++ )
     {
-        VkFormat              format = ShFramebuffers_Formats[ i ];
+        VkFormat              format = formats[ i ];
         FramebufferImageFlags flags  = ShFramebuffers_Flags[ i ];
 
         const VkExtent2D extent =
             GetFramebufSize( resolutionState, static_cast< FramebufferImageIndex >( i ) );
 
+        // use the image that is already visible to DX12, so no copies are required
+        if( auto shared = dxgi::Framebuf_TryGetVkDx12Shared( int( i ) ) )
+        {
+            if( shared->vkformat == int( format ) && shared->width == extent.width &&
+                shared->height == extent.height )
+            {
+                images[ i ]        = shared->vkimage;
+                imageMemories[ i ] = shared->vkmemory;
+                isShared[ i ]      = true;
+                continue;
+            }
+        }
+
         // create image
         {
             VkImageCreateInfo imageInfo = {
@@ -736,20 +960,13 @@ void Framebuffers::CreateImages( ResolutionState resolutionState,
             SET_DEBUG_NAME(
                 device, images[ i ], VK_OBJECT_TYPE_IMAGE, ShFramebuffers_DebugNames[ i ] );
         }
+    }
 
-        // allocate dedicated memory
-        {
-            VkMemoryRequirements memReqs;
-            vkGetImageMemoryRequirements( device, images[ i ], &memReqs );
-
-            imageMemories[ i ] = allocator->AllocDedicated( memReqs,
-                                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-                                                            MemoryAllocator::AllocType::DEFAULT,
-                                                            ShFramebuffers_DebugNames[ i ] );
+    AllocateMemory();
 
-            VkResult r = vkBindImageMemory( device, images[ i ], imageMemories[ i ], 0 );
-            VK_CHECKERROR( r );
-        }
+    for( uint32_t i = 0; i < ShFramebuffers_Count; i++ )
+    {
+        VkFormat format = formats[ i ];
 
         // create image view
         {
@@ -783,18 +1000,79 @@ void Framebuffers::CreateImages( ResolutionState resolutionState,
                              VK_IMAGE_LAYOUT_GENERAL );
     }
 
-    // image creation happens rarely
+    // no need to wait: the frame's cmd is submitted to the same queue after this one
     cmdManager->Submit( cmd );
-    cmdManager->WaitGraphicsIdle();
 
-    if( needShared )
+    allocatedResolution = resolutionState;
+    UpdateDescriptors();
+    NotifySubscribersAboutResize( resolutionState );
+}
+
+void Framebuffers::AllocateMemory()
+{
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_FRAMEBUFFERS };
+
+    std::vector< VkMemoryRequirements > memReqs( ShFramebuffers_Count );
+    for( uint32_t i = 0; i < ShFramebuffers_Count; i++ )
     {
-        dxgi::Framebuf_CreateDX12Resources( *cmdManager, *allocator, resolutionState );
+        if( isShared[ i ] )
+        {
+            continue;
+        }
+        vkGetImageMemoryRequirements( device, images[ i ], &memReqs[ i ] );
     }
 
-    currentResolution = resolutionState;
-    UpdateDescriptors();
-    NotifySubscribersAboutResize( resolutionState );
+    std::ranges::fill( isAliased, false );
+
+    if( LibConfig().framebufferAliasing )
+    {
+        VkDeviceSize saved = 0;
+
+        for( const AliasedBlock& b : PlanAliasedBlocks( memReqs ) )
+        {
+            if( b.users.size() < 2 )
+            {
+                continue;
+            }
+
+            VkDeviceMemory mem = allocator->AllocDedicated( b.memReqs,
+                                                            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                            MemoryAllocator::AllocType::DEFAULT,
+                                                            "Framebuffers aliased memory" );
+            aliasedMemories.push_back( mem );
+
+            for( const TransientLifetime* t : b.users )
+            {
+                imageMemories[ t->index ] = mem;
+                isAliased[ t->index ]     = true;
+                saved += memReqs[ t->index ].size;
+
+                VkResult r = vkBindImageMemory( device, images[ t->index ], mem, 0 );
+                VK_CHECKERROR( r );
+            }
+            saved -= b.memReqs.size;
+        }
+
+        debug::Info( "Framebuffers: aliasing of transient images saved {} MB",
+                        saved / 1024 / 1024 );
+    }
+
+    // the rest have dedicated memory
+    for( uint32_t i = 0; i < ShFramebuffers_Count; i++ )
+    {
+        if( isAliased[ i ] || isShared[ i ] )
+        {
+            continue;
+        }
+
+        imageMemories[ i ] = allocator->AllocDedicated( memReqs[ i ],
+                                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                        MemoryAllocator::AllocType::DEFAULT,
+                                                        ShFramebuffers_DebugNames[ i ] );
+
+        VkResult r = vkBindImageMemory( device, images[ i ], imageMemories[ i ], 0 );
+        VK_CHECKERROR( r );
+    }
 }
 
 void Framebuffers::UpdateDescriptors()
@@ -878,25 +1156,36 @@ void Framebuffers::UpdateDescriptors()
 
 void Framebuffers::DestroyImages()
 {
-    dxgi::Framebuf_Destroy();
-
-    for( auto& i : images )
+    for( uint32_t i = 0; i < ShFramebuffers_Count; i++ )
     {
-        if( i != VK_NULL_HANDLE )
+        if( images[ i ] != VK_NULL_HANDLE )
         {
-            vkDestroyImage( device, i, nullptr );
-            i = VK_NULL_HANDLE;
+            if( !isShared[ i ] )
+            {
+                vkDestroyImage( device, images[ i ], nullptr );
+            }
+            images[ i ] = VK_NULL_HANDLE;
         }
     }
 
-    for( auto& m : imageMemories )
+    for( uint32_t i = 0; i < ShFramebuffers_Count; i++ )
     {
-        if( m != VK_NULL_HANDLE )
+        if( imageMemories[ i ] != VK_NULL_HANDLE )
         {
-            MemoryAllocator::FreeDedicated( device, m );
-            m = VK_NULL_HANDLE;
+            if( !isAliased[ i ] && !isShared[ i ] )
+            {
+                MemoryAllocator::FreeDedicated( device, imageMemories[ i ] );
+            }
+            imageMemories[ i ] = VK_NULL_HANDLE;
         }
     }
+    std::ranges::fill( isShared, false );
+
+    for( VkDeviceMemory m : aliasedMemories )
+    {
+        MemoryAllocator::FreeDedicated( device, m );
+    }
+    aliasedMemories.clear();
 
     for( auto& v : imageViews )
     {
@@ -906,6 +1195,8 @@ void Framebuffers::DestroyImages()
             v = VK_NULL_HANDLE;
         }
     }
+
+    dxgi::Framebuf_Destroy();
 }
 
 void Framebuffers::NotifySubscribersAboutResize( const ResolutionState& resolutionState )
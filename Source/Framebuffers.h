@@ -39,6 +39,18 @@ class Swapchain;
 // Hold info for previous and current frames
 #define FRAMEBUFFERS_HISTORY_LENGTH 2
 
+// Groups of passes, in the order they are recorded within a frame.
+// Transient framebuffers define their lifetimes with them,
+// so the images that are never alive at the same time can share memory
+enum class FramebufferPass : uint32_t
+{
+    DirectIllumination,
+    IndirectIllumination,
+    Denoise,
+    Composition,
+    Bloom,
+};
+
 class Framebuffers
 {
 public:
@@ -54,7 +66,17 @@ public:
     Framebuffers& operator=( const Framebuffers& other ) = delete;
     Framebuffers& operator=( Framebuffers&& other ) noexcept = delete;
 
-    bool PrepareForSize( ResolutionState resolutionState, bool needShared );
+    // Selects history images for the frame
+    void PrepareForFrame( uint32_t frameIndex );
+    // Images are recreated only if 'allocation' is changed, a smaller 'resolutionState'
+    // is rendered into the top-left subregion of the allocated images
+    bool PrepareForSize( ResolutionState resolutionState,
+                         ResolutionState allocation,
+                         bool            needShared );
+
+    // Must be called before the pass, so the aliased images that begin
+    // their lifetime in it are transitioned from an undefined state
+    void BeginPass( VkCommandBuffer cmd, FramebufferPass pass );
 
     enum class BarrierType
     {
@@ -98,6 +120,7 @@ public:
 
     VkExtent2D GetFramebufSize( const ResolutionState& resolutionState,
                                 FramebufferImageIndex  index ) const;
+    const ResolutionState& GetAllocatedResolution() const { return allocatedResolution; }
 
     // Subscribe to framebuffers' size change event.
     // shared_ptr will be transformed to weak_ptr
@@ -105,13 +128,14 @@ public:
     void Unsubscribe( const IFramebuffersDependency* subscriber );
 
 private:
-    static FramebufferImageIndex FrameIndexToFBIndex( FramebufferImageIndex framebufferImageIndex,
-                                                      uint32_t              frameIndex );
+    FramebufferImageIndex FrameIndexToFBIndex( FramebufferImageIndex framebufferImageIndex,
+                                               uint32_t              frameIndex ) const;
 
     void CreateDescriptors();
     void CreateSamplers();
 
-    void CreateImages( ResolutionState resolutionState, bool sharedExist, bool needShared );
+    void CreateImages( ResolutionState resolutionState, bool needShared );
+    void AllocateMemory();
     void UpdateDescriptors();
 
     void DestroyImages();
@@ -130,14 +154,24 @@ private:
     std::shared_ptr< CommandBufferManager >               cmdManager;
 
     ResolutionState                                       currentResolution;
+    ResolutionState                                       allocatedResolution;
 
+    // default or compact, if it was requested and supported
+    std::vector< VkFormat >                               formats;
     std::vector< VkImage >                                images;
     std::vector< VkDeviceMemory >                         imageMemories;
+    // memory that is shared between transient images
+    std::vector< VkDeviceMemory >                         aliasedMemories;
+    std::vector< bool >                                   isAliased;
+    // image and memory are owned by dxgi, to avoid copies to DX12 for frame generation
+    std::vector< bool >                                   isShared;
     std::vector< VkImageView >                            imageViews;
 
     VkDescriptorSetLayout                                 descSetLayout;
     VkDescriptorPool                                      descPool;
     VkDescriptorSet                                       descSets[ FRAMEBUFFERS_HISTORY_LENGTH ];
+    // which history image is current, for each frame index
+    uint32_t                                              historyIndex[ MAX_FRAMES_IN_FLIGHT ]{};
 
     std::list< std::weak_ptr< IFramebuffersDependency > > subscribers;
 };
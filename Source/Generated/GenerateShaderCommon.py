@@ -220,6 +220,10 @@ CONST_TO_EVALUATE = "CONST VALUE MUST BE EVALUATED"
 # --------------------------------------------------------------------------------------------- #
 
 GRADIENT_ESTIMATION_ENABLED = True
+# per-pixel ray traversal counters for the ray cost debug views
+RAY_COST_STATS_ENABLED = True
+# views that share one frame: each one is a column of the render target
+MAX_VIEW_COUNT = 4
 FRAMEBUF_IGNORE_ATTACHMENTS_DEFINE = "FRAMEBUF_IGNORE_ATTACHMENTS" # define this, to not specify framebufs that are used as attachments
 def BIT( i ):
     return "1 << " + str( i )
@@ -242,9 +246,15 @@ CONST = {
     "BINDING_DYNAMIC_TEXCOORD_LAYER_1"          : 11,
     "BINDING_DYNAMIC_TEXCOORD_LAYER_2"          : 12,
     "BINDING_DYNAMIC_TEXCOORD_LAYER_3"          : 13,
+    "BINDING_EMISSIVE_TRIANGLES"                : 14,
+    "BINDING_GEOMETRY_INSTANCES_PREV"           : 15,
+    "BINDING_GEOMETRY_MATERIALS"                : 16,
     "BINDING_GLOBAL_UNIFORM"                    : 0,
     "BINDING_ACCELERATION_STRUCTURE_MAIN"       : 0,
     "BINDING_TEXTURES"                          : 0,
+    "BINDING_TEXTURE_STREAMING_FEEDBACK"        : 1,
+    "BINDING_TEXTURE_SAMPLERS"                  : 2,
+    "BINDING_TEXTURE_SAMPLER_INDICES"           : 3,
     "BINDING_CUBEMAPS"                          : 0,
     "BINDING_RENDER_CUBEMAP"                    : 0,
     "BINDING_BLUE_NOISE"                        : 0,
@@ -253,33 +263,66 @@ CONST = {
     "BINDING_LIGHT_SOURCES_PREV"                : 1,
     "BINDING_LIGHT_SOURCES_INDEX_PREV_TO_CUR"   : 2,
     "BINDING_LIGHT_SOURCES_INDEX_CUR_TO_PREV"   : 3,
-    "BINDING_INITIAL_LIGHTS_GRID"               : 4,
-    "BINDING_INITIAL_LIGHTS_GRID_PREV"          : 5,
+    "BINDING_LIGHT_TREE"                        : 4,
+    "BINDING_LIGHTSTYLES"                       : 5,
+    "BINDING_INITIAL_LIGHTS_GRID"               : 6,
+    "BINDING_INITIAL_LIGHTS_GRID_PREV"          : 7,
     "BINDING_LENS_FLARES_CULLING_INPUT"         : 0,
     "BINDING_LENS_FLARES_DRAW_CMDS"             : 1,
+    "BINDING_LENS_FLARES_SOURCE_INDICES"        : 2,
+    "BINDING_LENS_FLARES_VISIBLE_INDICES"       : 3,
     "BINDING_DRAW_LENS_FLARES_INSTANCES"        : 0,
+    "BINDING_DRAW_LENS_FLARES_VERTEX_INSTANCES" : 1,
+    "BINDING_RASTERIZED_DRAWS"                  : 0,
     "BINDING_PORTAL_INSTANCES"                  : 0,
     "BINDING_LPM_PARAMS"                        : 0,
     "BINDING_RESTIR_INDIRECT_RESERVOIRS"        : 2,
     "BINDING_RESTIR_INDIRECT_RESERVOIRS_PREV"   : 1,
+    "BINDING_RESTIR_INDIRECT_IRRADIANCE_CACHE"  : 3,
     "BINDING_VOLUMETRIC_STORAGE"                : 0,
     "BINDING_VOLUMETRIC_SAMPLER"                : 1,
     "BINDING_VOLUMETRIC_SAMPLER_PREV"           : 2,
+    "BINDING_VOLUMETRIC_RAW_STORAGE"            : 5,
+    "BINDING_VOLUMETRIC_RAW_SAMPLER_PREV"       : 6,
 #   "BINDING_VOLUMETRIC_ILLUMINATION"           : 3,
 #   "BINDING_VOLUMETRIC_ILLUMINATION_SAMPLER"   : 4,
     "BINDING_FLUID_PARTICLES_ARRAY"             : 0,
     "BINDING_FLUID_GENERATE_ID_TO_SOURCE"       : 1,
     "BINDING_FLUID_SOURCES"                     : 2,
+    "BINDING_FLUID_CELL_COUNT"                  : 3,
+    "BINDING_FLUID_CELL_START"                  : 4,
+    "BINDING_FLUID_CELL_BLOCK_SUMS"             : 5,
+    "BINDING_FLUID_PARTICLE_CELL"               : 6,
+    "BINDING_FLUID_SORTED_PARTICLES"            : 7,
+    "BINDING_FLUID_COUNTERS"                    : 8,
+    "BINDING_SKIN_BIND_POSE"                    : 0,
+    "BINDING_SKIN_BONES"                        : 1,
+    "BINDING_SKIN_JOBS"                         : 2,
+    "BINDING_PARTICLES"                         : 0,
+    "BINDING_PARTICLE_JOBS"                     : 1,
+    "BINDING_VERT_PREPROC_ITEMS"                : 0,
+    "BINDING_MIPMAP_SRC"                        : 0,
+    "BINDING_MIPMAP_DST"                        : 1,
+    "BINDING_MIPMAP_COUNTER"                    : 2,
+    "BINDING_BLOOM_DOWNSAMPLE_COUNTERS"         : 0,
+    "BINDING_SKY_PREFILTER_SRC"                 : 0,
+    "BINDING_SKY_PREFILTER_DST"                 : 1,
+    "BINDING_READBACK_NV12_SRC"                 : 0,
+    "BINDING_READBACK_NV12_DST"                 : 1,
+    "BINDING_TLAS_INSTANCE_SOURCES"             : 0,
+    "BINDING_TLAS_INSTANCES"                    : 1,
+    "BINDING_TLAS_INSTANCES_CULLED"             : 2,
 
     "INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON"           : BIT( 0 ),
     "INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER"    : BIT( 1 ),
     "INSTANCE_CUSTOM_INDEX_FLAG_SKY"                    : BIT( 2 ),
+    "INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC"                : BIT( 3 ),
 
     "INSTANCE_MASK_WORLD_0"                 : BIT( 0 ),
     "INSTANCE_MASK_WORLD_1"                 : BIT( 1 ),
     "INSTANCE_MASK_WORLD_2"                 : BIT( 2 ),
-    "INSTANCE_MASK_RESERVED_0"              : BIT( 3 ),
-    "INSTANCE_MASK_RESERVED_1"              : BIT( 4 ),
+    "INSTANCE_MASK_AREA_SHADOW_ONLY"        : BIT( 3 ),
+    "INSTANCE_MASK_WORLD_0_DYNAMIC"         : BIT( 4 ),
     "INSTANCE_MASK_REFRACT"                 : BIT( 5 ),
     "INSTANCE_MASK_FIRST_PERSON"            : BIT( 6 ),
     "INSTANCE_MASK_FIRST_PERSON_VIEWER"     : BIT( 7 ),
@@ -301,6 +344,8 @@ CONST = {
     "SBT_INDEX_HITGROUP_ALPHA_TESTED"       : 1,
     
     "MATERIAL_NO_TEXTURE"                   : 0,
+    # must be the same as SamplerManager::SamplerTableSize
+    "TEXTURE_SAMPLER_TABLE_SIZE"            : 8,
 
     "MATERIAL_BLENDING_TYPE_OPAQUE"         : 0,
     "MATERIAL_BLENDING_TYPE_ALPHA"          : 1,
@@ -312,9 +357,9 @@ CONST = {
     "GEOM_INST_FLAG_BLENDING_LAYER_COUNT"   : 4,         
     # first 8 bits (MATERIAL_BLENDING_TYPE_BIT_COUNT * GEOM_INST_FLAG_BLENDING_LAYER_COUNT)
     # are for the blending flags per each layer, others can be used
-    "GEOM_INST_FLAG_RESERVED_0"             : BIT( 8 ),
-    "GEOM_INST_FLAG_RESERVED_1"             : BIT( 9 ),
-    "GEOM_INST_FLAG_RESERVED_2"             : BIT( 10 ),
+    "GEOM_INST_FLAG_QUANTIZED_VERTICES"     : BIT( 8 ),
+    "GEOM_INST_FLAG_INDICES_16BIT"          : BIT( 9 ),
+    "GEOM_INST_FLAG_PREV_INDICES_16BIT"     : BIT( 10 ),
     "GEOM_INST_FLAG_RESERVED_3"             : BIT( 11 ),
     "GEOM_INST_FLAG_RESERVED_4"             : BIT( 12 ),
     "GEOM_INST_FLAG_GLASS_IF_SMOOTH"        : BIT( 13 ),
@@ -325,7 +370,7 @@ CONST = {
     "GEOM_INST_FLAG_MEDIA_TYPE_ACID"        : BIT( 18 ),
     "GEOM_INST_FLAG_EXACT_NORMALS"          : BIT( 19 ),
     "GEOM_INST_FLAG_IGNORE_REFRACT_AFTER"   : BIT( 20 ),
-    "GEOM_INST_FLAG_RESERVED_5"             : BIT( 21 ),
+    "GEOM_INST_FLAG_EMISSIVE_SAMPLED"       : BIT( 21 ),
     "GEOM_INST_FLAG_RESERVED_6"             : BIT( 22 ),
     "GEOM_INST_FLAG_THIN_MEDIA"             : BIT( 23 ),
     "GEOM_INST_FLAG_REFRACT"                : BIT( 24 ),
@@ -348,6 +393,10 @@ CONST = {
     "BLUE_NOISE_TEXTURE_SIZE"               : 128,
     "BLUE_NOISE_TEXTURE_SIZE_POW"           : CONST_TO_EVALUATE,
 
+    "SAMPLE_SEQUENCE_WHITE_NOISE"           : 0,
+    "SAMPLE_SEQUENCE_BLUE_NOISE"            : 1,
+    "SAMPLE_SEQUENCE_SOBOL"                 : 2,
+
     "COMPUTE_COMPOSE_GROUP_SIZE_X"          : 16,
     "COMPUTE_COMPOSE_GROUP_SIZE_Y"          : 16,
 
@@ -367,15 +416,33 @@ CONST = {
     "COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_X"    : 16,
     "COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_Y"    : 16,
     "COMPUTE_LUM_HISTOGRAM_BIN_COUNT"       : 256,
+    "COMPUTE_LUM_HISTOGRAM_DOWNSAMPLE"      : 2,
 
     "COMPUTE_VERT_PREPROC_GROUP_SIZE_X"     : 256,
     "VERT_PREPROC_MODE_ONLY_DYNAMIC"        : 0,
     "VERT_PREPROC_MODE_DYNAMIC_AND_MOVABLE" : 1,
     "VERT_PREPROC_MODE_ALL"                 : 2,
 
+    "COMPUTE_SKINNING_GROUP_SIZE_X"         : 64,
+    "COMPUTE_PARTICLE_EXPAND_GROUP_SIZE_X"  : 64,
+
+    "COMPUTE_MIPMAP_GROUP_SIZE_X"           : 256,
+    "COMPUTE_MIPMAP_TILE_SIZE"              : 64,
+    "COMPUTE_MIPMAP_MAX_DST_LEVELS"         : 12,
+    "MIPMAP_FLAG_SRGB"                      : BIT( 0 ),
+    "MIPMAP_FLAG_NORMAL_MAP"                : BIT( 1 ),
+
+    "COMPUTE_SKY_PREFILTER_GROUP_SIZE"      : 8,
+    "SKY_PREFILTER_SAMPLE_COUNT"            : 32,
+    # mip 0 is the rasterized sky itself, the last one has roughness 1.0
+    "SKY_PREFILTER_MAX_MIP_COUNT"           : 6,
+
+    # each invocation converts a 4x2 pixel block
+    "COMPUTE_READBACK_NV12_GROUP_SIZE"      : 8,
+    "COMPUTE_TLAS_INSTANCES_GROUP_SIZE_X"   : 256,
+
     "GRADIENT_ESTIMATION_ENABLED"           : int(GRADIENT_ESTIMATION_ENABLED),
     "COMPUTE_GRADIENT_ATROUS_GROUP_SIZE_X"  : 16,
-    "COMPUTE_ANTIFIREFLY_GROUP_SIZE_X"      : 16,
     "COMPUTE_SVGF_TEMPORAL_GROUP_SIZE_X"    : 16,
     "COMPUTE_SVGF_VARIANCE_GROUP_SIZE_X"    : 16,
     "COMPUTE_SVGF_ATROUS_GROUP_SIZE_X"      : 16,
@@ -383,12 +450,17 @@ CONST = {
 
     "COMPUTE_ASVGF_STRATA_SIZE"                         : 3,
     "COMPUTE_ASVGF_GRADIENT_ATROUS_ITERATION_COUNT"     : 4,  
+    "COMPUTE_SAMPLE_BUDGET_GROUP_SIZE_X"                : 16,
 
     "COMPUTE_INDIRECT_DRAW_FLARES_GROUP_SIZE_X"         : 256,
     "LENS_FLARES_MAX_DRAW_CMD_COUNT"                    : 512,
+    "LENS_FLARES_MAX_VERTEX_COUNT"                      : 65536,
+    "LENS_FLARES_MAX_INDEX_COUNT"                       : 262144,
 
     "COMPUTE_FLUID_PARTICLES_GROUP_SIZE_X"              : 256,
     "COMPUTE_FLUID_PARTICLES_GENERATE_GROUP_SIZE_X"     : 256,
+    "COMPUTE_FLUID_HASH_SCAN_GROUP_SIZE_X"              : 256,
+    "FLUID_HASH_SCAN_BLOCK_SIZE"                        : 1024,
 
     "DEBUG_SHOW_FLAG_MOTION_VECTORS"        : BIT( 0 ),
     "DEBUG_SHOW_FLAG_GRADIENTS"             : BIT( 1 ),
@@ -402,6 +474,15 @@ CONST = {
     "DEBUG_SHOW_FLAG_ALBEDO_WHITE"          : BIT( 9 ),
     "DEBUG_SHOW_FLAG_NORMALS"               : BIT( 10 ),
     "DEBUG_SHOW_FLAG_BLOOM"                 : BIT( 11 ),
+    "DEBUG_SHOW_FLAG_RAY_COST"              : BIT( 12 ),
+    "DEBUG_SHOW_FLAG_ANY_HIT"               : BIT( 13 ),
+    "DEBUG_SHOW_FLAG_TRANSLUCENT_OVERDRAW"  : BIT( 14 ),
+
+    "RAY_COST_STATS_ENABLED"                : int(RAY_COST_STATS_ENABLED),
+    # packing of a per-pixel ray cost: traced rays, any-hit invocations, translucent layers
+    "RAY_COST_RAYS_BITS"                    : 10,
+    "RAY_COST_ANY_HITS_BITS"                : 14,
+    "RAY_COST_LAYERS_BITS"                  : 8,
     
     "MAX_RAY_LENGTH"                        : "10000.0",
 
@@ -418,6 +499,10 @@ CONST = {
     "LIGHT_TYPE_SPHERE"                     : 2,
     "LIGHT_TYPE_SPOT"                       : 3,
     "LIGHT_TYPE_TRIANGLE"                   : 4,
+    # lightType's upper bits: lightstyle index + 1, or 0 if none
+    "LIGHT_TYPE_MASK"                       : 255,
+    "LIGHT_TYPE_LIGHTSTYLE_SHIFT"           : 8,
+    "LIGHTSTYLE_MAX_COUNT"                  : 1024,
 
     "TRIANGLE_LIGHTS"                       : 0,
 
@@ -426,18 +511,38 @@ CONST = {
 
     "LIGHT_INDEX_NONE"                      : ((1 << 15) - 1),
 
-    "LIGHT_GRID_ENABLED"                    : 0, # no effect on enabling?
-#   "LIGHT_GRID_SIZE_X"                     : 16,
-#   "LIGHT_GRID_SIZE_Y"                     : 16,
-#   "LIGHT_GRID_SIZE_Z"                     : 16,
-#   "LIGHT_GRID_CELL_SIZE"                  : 128,
-#   "COMPUTE_LIGHT_GRID_GROUP_SIZE_X"       : 256,
+    "LIGHT_TREE_NODE_LEAF_BIT"              : (1 << 30),
+    "LIGHT_TREE_MAX_DEPTH"                  : 32,
+    "MAX_EMISSIVE_TRIANGLE_COUNT"           : 1 << 16,
+
+    # must be the same as LIGHT_GRID_ENABLED_ in LightManager.h,
+    # the grid itself is enabled at runtime, see lightGridEnable
+    "LIGHT_GRID_ENABLED"                    : 1,
+    "LIGHT_GRID_SIZE_X"                     : 16,
+    "LIGHT_GRID_SIZE_Y"                     : 16,
+    "LIGHT_GRID_SIZE_Z"                     : 16,
+    "LIGHT_GRID_CELL_SIZE"                  : 128,
+    "COMPUTE_LIGHT_GRID_GROUP_SIZE_X"       : 256,
 
     "PORTAL_INDEX_NONE"                     : 63,
     "PORTAL_MAX_COUNT"                      : 63,
 
-    "PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS" : 5,
+    "MAX_VIEW_COUNT"                        : MAX_VIEW_COUNT,
 
+    "PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS" : 4,
+    "RESTIR_INDIRECT_RESERVOIR_TILE_SIZE"     : 8,
+
+    # world-space hashed grid, cells are found by linear probing
+    "IRRADIANCE_CACHE_CELL_COUNT"           : 1 << 18,
+    "IRRADIANCE_CACHE_PROBE_COUNT"          : 8,
+    # a cell can be used instead of tracing, if it has at least this many samples
+    "IRRADIANCE_CACHE_MIN_SAMPLES"          : 4,
+    "IRRADIANCE_CACHE_MAX_SAMPLES"          : 64,
+    # frames without use, after which a cell is freed
+    "IRRADIANCE_CACHE_MAX_AGE"              : 256,
+    "COMPUTE_IRRADIANCE_CACHE_GROUP_SIZE_X" : 256,
+
+    # max size of the froxel grid, the actual one is in globalUniform.volumeSize*
     "VOLUMETRIC_SIZE_X"                     : 160,
     "VOLUMETRIC_SIZE_Y"                     : 88,
     "VOLUMETRIC_SIZE_Z"                     : 64,
@@ -457,6 +562,12 @@ CONST = {
 
     "COMPUTE_INDIRECT_FINAL_GROUP_SIZE_X"   : 16,
     "COMPUTE_INDIRECT_FINAL_GROUP_SIZE_Y"   : 16,
+
+    "COMPUTE_RAY_QUERY_PRIMARY_GROUP_SIZE_X": 8,
+    "COMPUTE_RAY_QUERY_PRIMARY_GROUP_SIZE_Y": 8,
+
+    "COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_X": 8,
+    "COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_Y": 8,
 }
 
 CONST_GLSL_ONLY = {
@@ -507,6 +618,80 @@ VERTEX_COMPACT_STRUCT = [
     (TYPE_UINT32 ,      1,     "normalPacked",          1),
 ]
 
+# Position is snorm16 relative to primitive's bounds, w is unused;
+# texCoord is half-float
+VERTEX_QUANTIZED_STRUCT = [
+    (TYPE_UINT32,       1,     "positionXY",            1),
+    (TYPE_UINT32,       1,     "positionZW",            1),
+    (TYPE_UINT32,       1,     "normalPacked",          1),
+    (TYPE_UINT32,       1,     "texCoordPacked",        1),
+    (TYPE_UINT32,       1,     "color",                 1),
+]
+
+# Bind pose vertex; joints are 4x uint8, weights are 4x unorm8
+SKIN_VERTEX_STRUCT = [
+    (TYPE_FLOAT32,      3,     "position",              1),
+    (TYPE_UINT32 ,      1,     "normalPacked",          1),
+    (TYPE_FLOAT32,      2,     "texCoord",              1),
+    (TYPE_UINT32,       1,     "color",                 1),
+    (TYPE_UINT32,       1,     "jointsPacked",          1),
+    (TYPE_UINT32,       1,     "weightsPacked",         1),
+    (TYPE_UINT32,       1,     "_pad0",                 1),
+    (TYPE_UINT32,       1,     "_pad1",                 1),
+    (TYPE_UINT32,       1,     "_pad2",                 1),
+]
+
+# One workgroup skins 'vertexCount' vertices of a primitive
+SKIN_JOB_STRUCT = [
+    (TYPE_UINT32,       1,     "bindPoseOffset",        1),
+    (TYPE_UINT32,       1,     "dstVertexIndex",        1),
+    (TYPE_UINT32,       1,     "vertexCount",           1),
+    (TYPE_UINT32,       1,     "boneOffset",            1),
+]
+
+# Geometry which triangles are processed by the threads
+# in [firstTriangle, next item's firstTriangle)
+VERT_PREPROC_ITEM_STRUCT = [
+    (TYPE_UINT32,       1,     "tlasInstanceIndex",     1),
+    (TYPE_UINT32,       1,     "firstTriangle",         1),
+]
+
+# TLAS instance, which transform is taken from the geometry instance of the same index.
+# Bounds are in world space; negative radius, if the instance must not be culled
+TLAS_INSTANCE_SOURCE_STRUCT = [
+    (TYPE_FLOAT32,      3,     "boundsCenter",          1),
+    (TYPE_FLOAT32,      1,     "boundsRadius",          1),
+    (TYPE_UINT32,       2,     "blasAddress",           1),
+    (TYPE_UINT32,       1,     "customIndexAndMask",    1),
+    (TYPE_UINT32,       1,     "sbtOffsetAndFlags",     1),
+]
+
+# Expanded into a camera-facing quad of 6 vertices
+PARTICLE_STRUCT = [
+    (TYPE_FLOAT32,      3,     "position",              1),
+    (TYPE_FLOAT32,      1,     "size",                  1),
+    (TYPE_FLOAT32,      1,     "rotation",              1),
+    (TYPE_UINT32,       1,     "color",                 1),
+    (TYPE_UINT32,       1,     "frame",                 1),
+    (TYPE_UINT32,       1,     "_pad0",                 1),
+]
+
+# One workgroup expands 'particleCount' particles of a primitive;
+# model rows are needed to make quads face the camera in mesh space
+PARTICLE_JOB_STRUCT = [
+    (TYPE_UINT32,       1,     "particleOffset",        1),
+    (TYPE_UINT32,       1,     "dstVertexIndex",        1),
+    (TYPE_UINT32,       1,     "particleCount",         1),
+    (TYPE_UINT32,       1,     "flipbookColumns",       1),
+    (TYPE_UINT32,       1,     "flipbookRows",          1),
+    (TYPE_UINT32,       1,     "_pad0",                 1),
+    (TYPE_UINT32,       1,     "_pad1",                 1),
+    (TYPE_UINT32,       1,     "_pad2",                 1),
+    (TYPE_FLOAT32,      4,     "model_0",               1),
+    (TYPE_FLOAT32,      4,     "model_1",               1),
+    (TYPE_FLOAT32,      4,     "model_2",               1),
+]
+
 # Must be careful with std140 offsets! They are set manually.
 # Other structs are using std430 and padding is done automatically.
 GLOBAL_UNIFORM_STRUCT = [
@@ -599,7 +784,7 @@ GLOBAL_UNIFORM_STRUCT = [
 
     (TYPE_UINT32,       1,      "rayCullMaskWorld_Shadow",          1),
     (TYPE_UINT32,       1,      "volumeAllowTintUnderwater",        1),
-    (TYPE_UINT32,       1,      "_unused2",                         1),
+    (TYPE_UINT32,       1,      "lightTreeLeafCount",               1),
     (TYPE_UINT32,       1,      "twirlPortalNormal",                1),
 
     (TYPE_UINT32,       1,      "lightIndexIgnoreFPVShadows",       1),
@@ -625,33 +810,127 @@ GLOBAL_UNIFORM_STRUCT = [
     (TYPE_UINT32,       1,      "hdrDisplay",                       1),
     (TYPE_FLOAT32,      1,      "parallaxMaxDepth",                 1),
     (TYPE_UINT32,       1,      "fluidEnabled",                     1),
-    (TYPE_FLOAT32,      1,      "_pad3",                            1),
+    (TYPE_UINT32,       1,      "lightGridEnable",                  1),
 
     (TYPE_FLOAT32,      4,      "fluidColor",                       1),
 
-    #(TYPE_FLOAT32,      1,      "_pad0",                            1),
-    #(TYPE_FLOAT32,      1,      "_pad1",                            1),
-    #(TYPE_FLOAT32,      1,      "_pad2",                            1),
-    #(TYPE_FLOAT32,      1,      "_pad3",                            1),
+    (TYPE_UINT32,       1,      "emissiveTriangleCount",            1),
+    (TYPE_UINT32,       1,      "textureStreamingEnable",           1),
+    (TYPE_UINT32,       1,      "indirStride",                      1),
+    (TYPE_UINT32,       1,      "indirTraceOffset",                 1),
+
+    (TYPE_UINT32,       1,      "adaptiveSamplingEnable",           1),
+    (TYPE_UINT32,       1,      "volumeSizeX",                      1),
+    (TYPE_UINT32,       1,      "volumeSizeY",                      1),
+    (TYPE_UINT32,       1,      "volumeSizeZ",                      1),
+
+    (TYPE_UINT32,       1,      "volumeReprojection",               1),
+    (TYPE_UINT32,       1,      "viewCount",                        1),
+    (TYPE_UINT32,       1,      "irradianceCacheEnable",            1),
+    (TYPE_FLOAT32,      1,      "irradianceCacheCellSize",          1),
+
+    (TYPE_FLOAT32,      1,      "irradianceCacheUpdateRate",        1),
+    (TYPE_UINT32,       1,      "indirCheckerboard",                1),
+    (TYPE_FLOAT32,      1,      "reflectRefractMinThroughput",      1),
+    (TYPE_FLOAT32,      1,      "reflectRefractMaxRoughness",       1),
+
+    (TYPE_FLOAT32,      1,      "reflectRefractMaxDistance",        1),
+    (TYPE_UINT32,       1,      "reflectRefractSkyOnTermination",   1),
+    (TYPE_UINT32,       1,      "sampleSequence",                   1),
+    (TYPE_UINT32,       1,      "primaryVisibilityBuffer",          1),
+
+    (TYPE_UINT32,       1,      "sunShadowCacheEnable",             1),
+    (TYPE_FLOAT32,      1,      "sunShadowCacheUpdateRate",         1),
+    (TYPE_UINT32,       1,      "restirDirectCandidatesMin",        1),
+    (TYPE_UINT32,       1,      "restirDirectCandidatesMax",        1),
+
+    (TYPE_UINT32,       1,      "restirDirectSpatialMin",           1),
+    (TYPE_UINT32,       1,      "restirDirectSpatialMax",           1),
+    (TYPE_UINT32,       1,      "restirIndirectSpatialMin",         1),
+    (TYPE_UINT32,       1,      "restirIndirectSpatialMax",         1),
+
+    (TYPE_FLOAT32,      1,      "renderWidthPrev",                  1),
+    (TYPE_FLOAT32,      1,      "renderHeightPrev",                 1),
+    (TYPE_FLOAT32,      1,      "renderAllocWidth",                 1),
+    (TYPE_FLOAT32,      1,      "renderAllocHeight",                1),
 
     # for std140
     (TYPE_FLOAT32,     44,      "viewProjCubemap",              6),
     (TYPE_FLOAT32,     44,      "skyCubemapRotationTransform",  1),
+
+    # per view, 'viewCount' are valid; view 0 is the main camera
+    (TYPE_FLOAT32,     44,      "viewsView",                    MAX_VIEW_COUNT),
+    (TYPE_FLOAT32,     44,      "viewsInvView",                 MAX_VIEW_COUNT),
+    (TYPE_FLOAT32,     44,      "viewsViewPrev",                MAX_VIEW_COUNT),
+    (TYPE_FLOAT32,     44,      "viewsProjection",              MAX_VIEW_COUNT),
+    (TYPE_FLOAT32,     44,      "viewsInvProjection",           MAX_VIEW_COUNT),
+    (TYPE_FLOAT32,     44,      "viewsProjectionPrev",          MAX_VIEW_COUNT),
+    (TYPE_FLOAT32,      4,      "viewsCameraPosition",          MAX_VIEW_COUNT),
 ]
 
+# Radiance is accumulated with atomics in fixed point, and blended into 'radianceE5'
+# by a resolve pass, once per frame
+IRRADIANCE_CACHE_CELL_STRUCT = [
+    (TYPE_UINT32,       1,      "checksum",             1),
+    (TYPE_UINT32,       1,      "radianceE5",           1),
+    (TYPE_UINT32,       1,      "sampleCount",          1),
+    (TYPE_UINT32,       1,      "lastUsedFrame",        1),
+    (TYPE_UINT32,       1,      "accumR",               1),
+    (TYPE_UINT32,       1,      "accumG",               1),
+    (TYPE_UINT32,       1,      "accumB",               1),
+    (TYPE_UINT32,       1,      "accumCount",           1),
+]
+
+# per-hit data; material is in a separate deduplicated table, 'materialIndex' points to it
 GEOM_INSTANCE_STRUCT = [
     (TYPE_FLOAT32,      4,      "model_0",              1),
     (TYPE_FLOAT32,      4,      "model_1",              1),
     (TYPE_FLOAT32,      4,      "model_2",              1),
+
+    (TYPE_UINT32,       1,      "flags",                1),
+    (TYPE_UINT32,       1,      "materialIndex",        1),
+    (TYPE_UINT32,       1,      "baseVertexIndex",      1),
+    (TYPE_UINT32,       1,      "baseIndexIndex",       1),
+
+    (TYPE_UINT32,       1,      "vertexCount",          1),
+    (TYPE_UINT32,       1,      "indexCount",           1),
+    (TYPE_UINT32,       1,      "firstVertex_Layer1",   1),
+    (TYPE_UINT32,       1,      "firstVertex_Layer2",   1),
+
+    (TYPE_UINT32,       1,      "firstVertex_Layer3",   1),
+    (TYPE_UINT32,       1,      "_pad0",                1),
+    # device addresses of the first vertex and the first index of the geometry, for buffer_reference
+    (TYPE_UINT32,       2,      "vertexBufferAddress",  1),
+    (TYPE_UINT32,       2,      "indexBufferAddress",   1),
+    (TYPE_UINT32,       1,      "_pad1",                1),
+    (TYPE_UINT32,       1,      "_pad2",                1),
+
+    # if GEOM_INST_FLAG_QUANTIZED_VERTICES: local position = center + extent * snorm
+    (TYPE_FLOAT32,      4,      "dequantCenter",        1),
+    (TYPE_FLOAT32,      4,      "dequantExtent",        1),
+]
+
+# previous frame's data of a geometry instance, only for motion vectors;
+# same indexing as geometry instances
+GEOM_INSTANCE_PREV_STRUCT = [
     (TYPE_FLOAT32,      4,      "prevModel_0",          1),
     (TYPE_FLOAT32,      4,      "prevModel_1",          1),
     (TYPE_FLOAT32,      4,      "prevModel_2",          1),
 
-    (TYPE_UINT32,       1,      "flags",                1),
+    # UINT32_MAX, if there's no previous frame's data
+    (TYPE_UINT32,       1,      "prevBaseVertexIndex",  1),
+    (TYPE_UINT32,       1,      "prevBaseIndexIndex",   1),
+    (TYPE_UINT32,       1,      "_pad0",                1),
+    (TYPE_UINT32,       1,      "_pad1",                1),
+]
+
+GEOM_MATERIAL_STRUCT = [
     (TYPE_UINT32,       1,      "texture_base",         1),
     (TYPE_UINT32,       1,      "texture_base_ORM",     1),
     (TYPE_UINT32,       1,      "texture_base_N",       1),
     (TYPE_UINT32,       1,      "texture_base_E",       1),
+
+    (TYPE_UINT32,       1,      "texture_base_D",       1),
     (TYPE_UINT32,       1,      "texture_layer1",       1),
     (TYPE_UINT32,       1,      "texture_layer2",       1),
     (TYPE_UINT32,       1,      "texture_layer3",       1),
@@ -661,20 +940,10 @@ GEOM_INSTANCE_STRUCT = [
     (TYPE_UINT32,       1,      "colorFactor_layer2",   1),
     (TYPE_UINT32,       1,      "colorFactor_layer3",   1),
 
-    (TYPE_UINT32,       1,      "baseVertexIndex",      1),
-    (TYPE_UINT32,       1,      "baseIndexIndex",       1),
-    (TYPE_UINT32,       1,      "prevBaseVertexIndex",  1),
-    (TYPE_UINT32,       1,      "prevBaseIndexIndex",   1),
-
-    (TYPE_UINT32,       1,      "vertexCount",          1),
-    (TYPE_UINT32,       1,      "indexCount",           1),
-    (TYPE_UINT32,       1,      "texture_base_D",       1),
     (TYPE_UINT32,       1,      "roughnessDefault_metallicDefault", 1),
-
     (TYPE_FLOAT32,      1,      "emissiveMult",         1),
-    (TYPE_UINT32,       1,      "firstVertex_Layer1",   1),
-    (TYPE_UINT32,       1,      "firstVertex_Layer2",   1),
-    (TYPE_UINT32,       1,      "firstVertex_Layer3",   1),
+    (TYPE_UINT32,       1,      "_pad0",                1),
+    (TYPE_UINT32,       1,      "_pad1",                1),
 ]
 
 # TODO: make more compact
@@ -694,9 +963,57 @@ LIGHT_IN_CELL = [
     (TYPE_FLOAT32,      1,      "weightSum",            1),
 ]
 
+# if LIGHT_TREE_NODE_LEAF_BIT is set in childOrLight, it's a light index,
+# otherwise it's an index of the left child, and the right one is right after it
+LIGHT_TREE_NODE_STRUCT = [
+    (TYPE_FLOAT32,      1,      "bbMin_x",              1),
+    (TYPE_FLOAT32,      1,      "bbMin_y",              1),
+    (TYPE_FLOAT32,      1,      "bbMin_z",              1),
+    (TYPE_UINT32,       1,      "childOrLight",         1),
+    (TYPE_FLOAT32,      1,      "bbMax_x",              1),
+    (TYPE_FLOAT32,      1,      "bbMax_y",              1),
+    (TYPE_FLOAT32,      1,      "bbMax_z",              1),
+    (TYPE_FLOAT32,      1,      "energy",               1),
+    (TYPE_FLOAT32,      1,      "coneAxis_x",           1),
+    (TYPE_FLOAT32,      1,      "coneAxis_y",           1),
+    (TYPE_FLOAT32,      1,      "coneAxis_z",           1),
+    (TYPE_FLOAT32,      1,      "coneCosTheta",         1),
+]
+
+# World-space triangle of a static emissive primitive;
+# 'selectPdf' is a probability to choose this triangle, 'aliasProb' and 'aliasIndex'
+# form an alias table over all triangles
+EMISSIVE_TRIANGLE_STRUCT = [
+    (TYPE_FLOAT32,      1,      "p0_x",                 1),
+    (TYPE_FLOAT32,      1,      "p0_y",                 1),
+    (TYPE_FLOAT32,      1,      "p0_z",                 1),
+    (TYPE_FLOAT32,      1,      "p1_x",                 1),
+    (TYPE_FLOAT32,      1,      "p1_y",                 1),
+    (TYPE_FLOAT32,      1,      "p1_z",                 1),
+    (TYPE_FLOAT32,      1,      "p2_x",                 1),
+    (TYPE_FLOAT32,      1,      "p2_y",                 1),
+    (TYPE_FLOAT32,      1,      "p2_z",                 1),
+    (TYPE_FLOAT32,      1,      "u0",                   1),
+    (TYPE_FLOAT32,      1,      "v0",                   1),
+    (TYPE_FLOAT32,      1,      "u1",                   1),
+    (TYPE_FLOAT32,      1,      "v1",                   1),
+    (TYPE_FLOAT32,      1,      "u2",                   1),
+    (TYPE_FLOAT32,      1,      "v2",                   1),
+    (TYPE_UINT32,       1,      "texture_base",         1),
+    (TYPE_UINT32,       1,      "texture_base_E",       1),
+    (TYPE_UINT32,       1,      "colorFactor",          1),
+    (TYPE_FLOAT32,      1,      "emissiveMult",         1),
+    (TYPE_FLOAT32,      1,      "selectPdf",            1),
+    (TYPE_FLOAT32,      1,      "aliasProb",            1),
+    (TYPE_UINT32,       1,      "aliasIndex",           1),
+    (TYPE_UINT32,       1,      "_pad0",                1),
+    (TYPE_UINT32,       1,      "_pad1",                1),
+]
+
 TONEMAPPING_STRUCT = [
     (TYPE_UINT32,       1,      "histogram",            CONST["COMPUTE_LUM_HISTOGRAM_BIN_COUNT"]),
     (TYPE_FLOAT32,      1,      "avgLuminance",         1),
+    (TYPE_UINT32,       1,      "finishedGroupCount",   1),
 ]
 
 INDIRECT_DRAW_CMD_STRUCT = [
@@ -717,6 +1034,18 @@ LENS_FLARES_INSTANCE_STRUCT = [
     (TYPE_FLOAT32,      1,      "emissiveMult",         1),
 ]
 
+RASTERIZED_DRAW_STRUCT = [
+    (TYPE_FLOAT32,     44,      "transform",            1),
+    (TYPE_UINT32,       1,      "packedColor",          1),
+    (TYPE_UINT32,       1,      "textureIndex",         1),
+    (TYPE_UINT32,       1,      "emissiveTextureIndex", 1),
+    (TYPE_FLOAT32,      1,      "emissiveMult",         1),
+    (TYPE_UINT32,       1,      "normalTextureIndex",   1),
+    (TYPE_UINT32,       1,      "transformIsViewProj",  1),
+    (TYPE_UINT32,       1,      "_pad0",                1),
+    (TYPE_UINT32,       1,      "_pad1",                1),
+]
+
 PORTAL_INSTANCE_STRUCT = [
     (TYPE_FLOAT32,      4,      "inPosition",               1),
     (TYPE_FLOAT32,      4,      "outPosition",              1),
@@ -739,15 +1068,28 @@ STRUCT_BREAK_TYPE_ONLY_C    = 2
 STRUCTS = {
     "ShVertex":                 (VERTEX_STRUCT,                 False,  STRUCT_ALIGNMENT_STD140,    0),
     "ShVertexCompact":          (VERTEX_COMPACT_STRUCT,         False,  STRUCT_ALIGNMENT_STD140,    0),
+    "ShVertexQuantized":        (VERTEX_QUANTIZED_STRUCT,       False,  0,                          0),
     "ShGlobalUniform":          (GLOBAL_UNIFORM_STRUCT,         False,  STRUCT_ALIGNMENT_STD140,    STRUCT_BREAK_TYPE_ONLY_C),
     "ShGeometryInstance":       (GEOM_INSTANCE_STRUCT,          False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShGeometryInstancePrev":   (GEOM_INSTANCE_PREV_STRUCT,     False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShGeometryMaterial":       (GEOM_MATERIAL_STRUCT,          False,  STRUCT_ALIGNMENT_STD430,    0),
     "ShTonemapping":            (TONEMAPPING_STRUCT,            False,  0,                          0),
     "ShLightEncoded":           (LIGHT_ENCODED_STRUCT,          False,  0,                          0),
     "ShLightInCell":            (LIGHT_IN_CELL,                 False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShLightTreeNode":          (LIGHT_TREE_NODE_STRUCT,        False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShEmissiveTriangle":       (EMISSIVE_TRIANGLE_STRUCT,      False,  STRUCT_ALIGNMENT_STD430,    0),
     "ShIndirectDrawCommand":    (INDIRECT_DRAW_CMD_STRUCT,      False,  STRUCT_ALIGNMENT_STD430,    0),
     # TODO: should be STRUCT_ALIGNMENT_STD430, but current generator is not great as it just adds pads at the end, so it's 0
     "ShLensFlareInstance":      (LENS_FLARES_INSTANCE_STRUCT,   False,  0,                          0),
+    "ShRasterizedDraw":         (RASTERIZED_DRAW_STRUCT,        False,  STRUCT_ALIGNMENT_STD430,    0),
     "ShPortalInstance":         (PORTAL_INSTANCE_STRUCT,        False,  STRUCT_ALIGNMENT_STD140,    0),
+    "ShSkinVertex":             (SKIN_VERTEX_STRUCT,            False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShSkinJob":                (SKIN_JOB_STRUCT,               False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShParticle":               (PARTICLE_STRUCT,               False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShVertPreprocItem":        (VERT_PREPROC_ITEM_STRUCT,      False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShTlasInstanceSource":     (TLAS_INSTANCE_SOURCE_STRUCT,   False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShParticleJob":            (PARTICLE_JOB_STRUCT,           False,  STRUCT_ALIGNMENT_STD430,    0),
+    "ShIrradianceCacheCell":    (IRRADIANCE_CACHE_CELL_STRUCT,  False,  STRUCT_ALIGNMENT_STD430,    0),
 }
 
 # --------------------------------------------------------------------------------------------- #
@@ -822,14 +1164,18 @@ FRAMEBUFFERS = {
 
     # for upscalers
     "MotionDlss"                        : (TYPE_FLOAT16,    COMPONENT_RG,   0),
+    # guides for DLSS Ray Reconstruction, in regular pixels (not checkerboarded)
+    "RayReconNormalRoughness"           : (TYPE_FLOAT16,    COMPONENT_RGBA, 0),
+    "RayReconDiffuseAlbedo"             : (TYPE_PACK_11,    COMPONENT_RGB,  0),
+    "RayReconSpecularAlbedo"            : (TYPE_PACK_11,    COMPONENT_RGB,  0),
     "Reactivity"                        : (TYPE_UNORM8,     COMPONENT_R,    FRAMEBUF_FLAGS_IS_ATTACHMENT),
     "HudOnly"                           : (TYPE_UNORM8,     COMPONENT_RGBA, FRAMEBUF_FLAGS_IS_ATTACHMENT | FRAMEBUF_FLAGS_UPSCALED_SIZE | FRAMEBUF_FLAGS_USAGE_TRANSFER),  # src for framegen
+    "FrameGenerated"                    : (TYPE_FLOAT16,    COMPONENT_RGBA, FRAMEBUF_FLAGS_NO_SAMPLER | FRAMEBUF_FLAGS_UPSCALED_SIZE | FRAMEBUF_FLAGS_USAGE_TRANSFER),  # dst for native FSR3 frame interpolation
 
     "AccumHistoryLength"                : (TYPE_FLOAT16,    COMPONENT_RGBA, FRAMEBUF_FLAGS_STORE_PREV),
     
     # TODO: pack float16 to e5
     "DiffTemporary"                     : (TYPE_PACK_E5,    COMPONENT_RGB,  0),
-    "DiffAccumColor"                    : (TYPE_PACK_E5,    COMPONENT_RGB,  FRAMEBUF_FLAGS_STORE_PREV),
     "DiffAccumMoments"                  : (TYPE_FLOAT16,    COMPONENT_RG,   FRAMEBUF_FLAGS_STORE_PREV),
     "DiffColorHistory"                  : (TYPE_FLOAT16,    COMPONENT_RGBA, 0),
     "DiffPingColorAndVariance"          : (TYPE_FLOAT16,    COMPONENT_RGBA, 0),
@@ -868,7 +1214,28 @@ FRAMEBUFFERS = {
     "Reservoirs"                        : (TYPE_UINT32,     COMPONENT_RG,   FRAMEBUF_FLAGS_STORE_PREV),
     "ReservoirsInitial"                 : (TYPE_UINT32,     COMPONENT_RG,   0),
 
+    # visibility of the directional light from the static geometry, and 1.0 if it's valid
+    "SunVisibility"                     : (TYPE_UNORM8,     COMPONENT_RG,   FRAMEBUF_FLAGS_STORE_PREV),
+
     "IndirectReservoirsInitial"         : (TYPE_UINT32,     COMPONENT_RGBA, 0),
+
+    # per 3x3 strata, how many samples are worth spending on it in the next frame
+    "SampleBudget"                      : (TYPE_UNORM8,     COMPONENT_R,    FRAMEBUF_FLAGS_FORCE_SIZE_1_3),
+}
+
+# Smaller formats for framebuffers, if compact framebuffers were requested on instance creation.
+# Only positive HDR colors with an unused alpha, that are written only by imageStore
+# and read only through samplers, as their storage images are declared without a format
+FRAMEBUFFERS_COMPACT = {
+    "PreFinal"                          : (TYPE_PACK_11,    COMPONENT_RGB),
+    "Bloom"                             : (TYPE_PACK_11,    COMPONENT_RGB),
+    "Bloom_Mip1"                        : (TYPE_PACK_11,    COMPONENT_RGB),
+    "Bloom_Mip2"                        : (TYPE_PACK_11,    COMPONENT_RGB),
+    "Bloom_Mip3"                        : (TYPE_PACK_11,    COMPONENT_RGB),
+    "Bloom_Mip4"                        : (TYPE_PACK_11,    COMPONENT_RGB),
+    "Bloom_Mip5"                        : (TYPE_PACK_11,    COMPONENT_RGB),
+    "Bloom_Mip6"                        : (TYPE_PACK_11,    COMPONENT_RGB),
+    "Bloom_Mip7"                        : (TYPE_PACK_11,    COMPONENT_RGB),
 }
 
 if GRADIENT_ESTIMATION_ENABLED:
@@ -880,6 +1247,14 @@ if GRADIENT_ESTIMATION_ENABLED:
         "GradientPrevPix"               : (TYPE_UINT8,      COMPONENT_R,    FRAMEBUF_FLAGS_FORCE_SIZE_1_3),
     })
 
+if RAY_COST_STATS_ENABLED:
+    FRAMEBUFFERS.update({
+        # packed counters, in checkerboarded pixels; copied to CPU for the totals
+        "RayCost"                       : (TYPE_UINT32,     COMPONENT_R,    FRAMEBUF_FLAGS_NO_SAMPLER | FRAMEBUF_FLAGS_USAGE_TRANSFER),
+        # any-hit invocations of the current ray, indexed by a launch ID
+        "RayCostAnyHit"                 : (TYPE_UINT32,     COMPONENT_R,    FRAMEBUF_FLAGS_NO_SAMPLER),
+    })
+
 
 # ---
 # User defined structs END
@@ -1012,7 +1387,7 @@ def capitalizeFirstLetter(s):
 
 CURRENT_FRAMEBUF_BINDING_COUNT = 0
 
-def getGLSLFramebufDeclaration(name, baseFormat, components, flags):
+def getGLSLFramebufDeclaration(name, baseFormat, components, flags, withoutFormat = False):
     global CURRENT_FRAMEBUF_BINDING_COUNT
 
     binding = FRAMEBUF_BASE_BINDING + CURRENT_FRAMEBUF_BINDING_COUNT
@@ -1023,11 +1398,19 @@ def getGLSLFramebufDeclaration(name, baseFormat, components, flags):
     if flags & FRAMEBUF_FLAGS_IS_ATTACHMENT:
         r += "#ifndef " + FRAMEBUF_IGNORE_ATTACHMENTS_DEFINE + "\n"
 
-    template = ("layout(set = %s, binding = %d, %s) uniform %s %s;")
+    if withoutFormat:
+        # format is chosen at runtime, so the image can only be written
+        assert not (flags & FRAMEBUF_FLAGS_STORE_PREV)
+        templateNoFormat = ("layout(set = %s, binding = %d) uniform writeonly %s %s;")
+
+        r += templateNoFormat % (FRAMEBUF_DESC_SET_NAME, binding,
+            GLSL_IMAGE_2D_TYPE[baseFormat], name)
+    else:
+        template = ("layout(set = %s, binding = %d, %s) uniform %s %s;")
 
-    r += template % (FRAMEBUF_DESC_SET_NAME, binding, 
-        GLSL_IMAGE_FORMATS[(baseFormat, components)], 
-        GLSL_IMAGE_2D_TYPE[baseFormat], name)
+        r += template % (FRAMEBUF_DESC_SET_NAME, binding, 
+            GLSL_IMAGE_FORMATS[(baseFormat, components)], 
+            GLSL_IMAGE_2D_TYPE[baseFormat], name)
 
     if flags & FRAMEBUF_FLAGS_STORE_PREV:
         r += "\n"
@@ -1095,7 +1478,8 @@ def getAllGLSLFramebufDeclarations():
         + "\n\n// framebuffers\n" \
         \
         + "\n".join(
-            getGLSLFramebufDeclaration(FRAMEBUF_PREFIX + name, baseFormat, components, flags)
+            getGLSLFramebufDeclaration(FRAMEBUF_PREFIX + name, baseFormat, components, flags,
+                                       name in FRAMEBUFFERS_COMPACT)
             for name, (baseFormat, components, flags) in FRAMEBUFFERS.items()
         ) \
         \
@@ -1174,6 +1558,7 @@ _ShFramebuffers_Count = 0
 def getAllVulkanFramebufDeclarations():
     return ("constexpr uint32_t ShFramebuffers_Count = %s;\n"
             "extern const VkFormat ShFramebuffers_Formats[];\n"
+            "extern const VkFormat ShFramebuffers_FormatsCompact[];\n"
             "extern const FramebufferImageFlags ShFramebuffers_Flags[];\n"
             "extern const uint32_t ShFramebuffers_Bindings[];\n"
             "extern const uint32_t ShFramebuffers_BindingsSwapped[];\n"
@@ -1185,6 +1570,7 @@ def getAllVulkanFramebufDeclarations():
 
 def getAllVulkanFramebufDefinitions():
     template = ("const VkFormat RTGL1::ShFramebuffers_Formats[] = \n{\n%s};\n\n"
+                "const VkFormat RTGL1::ShFramebuffers_FormatsCompact[] = \n{\n%s};\n\n"
                 "const RTGL1::FramebufferImageFlags RTGL1::ShFramebuffers_Flags[] = \n{\n%s};\n\n"
                 "const uint32_t RTGL1::ShFramebuffers_Bindings[] = \n{\n%s};\n\n"
                 "const uint32_t RTGL1::ShFramebuffers_BindingsSwapped[] = \n{\n%s};\n\n"
@@ -1194,6 +1580,7 @@ def getAllVulkanFramebufDefinitions():
                 "const wchar_t *const RTGL1::ShFramebuffers_DebugNamesW[] = \n{\n%s};\n\n")
     TAB_STR = "    "
     formats = ""
+    formatsCompact = ""
     count = 0
     publicFlags = ""
     samplerCount = 0
@@ -1204,6 +1591,7 @@ def getAllVulkanFramebufDefinitions():
     names = ""
     for name, (baseFormat, components, flags) in FRAMEBUFFERS.items():
         formats += TAB_STR + VULKAN_IMAGE_FORMATS[(baseFormat, components)] + ", // " + name + "\n"
+        formatsCompact += TAB_STR + VULKAN_IMAGE_FORMATS[FRAMEBUFFERS_COMPACT.get(name, (baseFormat, components))] + ", // " + name + "\n"
         names += TAB_STR + "\"" + FRAMEBUF_DEBUG_NAME_PREFIX + name + "\",\n"
         publicFlags += TAB_STR + getPublicFlags(flags) + ", // " + name + "\n"
 
@@ -1217,6 +1605,7 @@ def getAllVulkanFramebufDefinitions():
             bindingsSwapped         += TAB_STR + str(count)         + ",\n"
             
             formats += TAB_STR + VULKAN_IMAGE_FORMATS[(baseFormat, components)] + ", // " + name + FRAMEBUF_STORE_PREV_POSTFIX + "\n"
+            formatsCompact += TAB_STR + VULKAN_IMAGE_FORMATS[(baseFormat, components)] + ", // " + name + FRAMEBUF_STORE_PREV_POSTFIX + "\n"
             names += TAB_STR + "\"" + FRAMEBUF_DEBUG_NAME_PREFIX + name + FRAMEBUF_STORE_PREV_POSTFIX + "\",\n"
             publicFlags += TAB_STR + getPublicFlags(flags) + ", // " + name + FRAMEBUF_STORE_PREV_POSTFIX + "\n"
             count += 1
@@ -1247,7 +1636,7 @@ def getAllVulkanFramebufDefinitions():
     global _ShFramebuffers_Count
     _ShFramebuffers_Count = count
 
-    return template % (formats, publicFlags, bindings, bindingsSwapped, samplerBindings, samplerBindingsSwapped, names, wnames)
+    return template % (formats, formatsCompact, publicFlags, bindings, bindingsSwapped, samplerBindings, samplerBindingsSwapped, names, wnames)
 
 
 FILE_HEADER = "// This file was generated by GenerateShaderCommon.py\n\n"
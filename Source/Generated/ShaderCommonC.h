@@ -23,9 +23,15 @@ namespace RTGL1
 #define BINDING_DYNAMIC_TEXCOORD_LAYER_1 (11)
 #define BINDING_DYNAMIC_TEXCOORD_LAYER_2 (12)
 #define BINDING_DYNAMIC_TEXCOORD_LAYER_3 (13)
+#define BINDING_EMISSIVE_TRIANGLES (14)
+#define BINDING_GEOMETRY_INSTANCES_PREV (15)
+#define BINDING_GEOMETRY_MATERIALS (16)
 #define BINDING_GLOBAL_UNIFORM (0)
 #define BINDING_ACCELERATION_STRUCTURE_MAIN (0)
 #define BINDING_TEXTURES (0)
+#define BINDING_TEXTURE_STREAMING_FEEDBACK (1)
+#define BINDING_TEXTURE_SAMPLERS (2)
+#define BINDING_TEXTURE_SAMPLER_INDICES (3)
 #define BINDING_CUBEMAPS (0)
 #define BINDING_RENDER_CUBEMAP (0)
 #define BINDING_BLUE_NOISE (0)
@@ -34,29 +40,62 @@ namespace RTGL1
 #define BINDING_LIGHT_SOURCES_PREV (1)
 #define BINDING_LIGHT_SOURCES_INDEX_PREV_TO_CUR (2)
 #define BINDING_LIGHT_SOURCES_INDEX_CUR_TO_PREV (3)
-#define BINDING_INITIAL_LIGHTS_GRID (4)
-#define BINDING_INITIAL_LIGHTS_GRID_PREV (5)
+#define BINDING_LIGHT_TREE (4)
+#define BINDING_LIGHTSTYLES (5)
+#define BINDING_INITIAL_LIGHTS_GRID (6)
+#define BINDING_INITIAL_LIGHTS_GRID_PREV (7)
 #define BINDING_LENS_FLARES_CULLING_INPUT (0)
 #define BINDING_LENS_FLARES_DRAW_CMDS (1)
+#define BINDING_LENS_FLARES_SOURCE_INDICES (2)
+#define BINDING_LENS_FLARES_VISIBLE_INDICES (3)
 #define BINDING_DRAW_LENS_FLARES_INSTANCES (0)
+#define BINDING_DRAW_LENS_FLARES_VERTEX_INSTANCES (1)
+#define BINDING_RASTERIZED_DRAWS (0)
 #define BINDING_PORTAL_INSTANCES (0)
 #define BINDING_LPM_PARAMS (0)
 #define BINDING_RESTIR_INDIRECT_RESERVOIRS (2)
 #define BINDING_RESTIR_INDIRECT_RESERVOIRS_PREV (1)
+#define BINDING_RESTIR_INDIRECT_IRRADIANCE_CACHE (3)
 #define BINDING_VOLUMETRIC_STORAGE (0)
 #define BINDING_VOLUMETRIC_SAMPLER (1)
 #define BINDING_VOLUMETRIC_SAMPLER_PREV (2)
+#define BINDING_VOLUMETRIC_RAW_STORAGE (5)
+#define BINDING_VOLUMETRIC_RAW_SAMPLER_PREV (6)
 #define BINDING_FLUID_PARTICLES_ARRAY (0)
 #define BINDING_FLUID_GENERATE_ID_TO_SOURCE (1)
 #define BINDING_FLUID_SOURCES (2)
+#define BINDING_FLUID_CELL_COUNT (3)
+#define BINDING_FLUID_CELL_START (4)
+#define BINDING_FLUID_CELL_BLOCK_SUMS (5)
+#define BINDING_FLUID_PARTICLE_CELL (6)
+#define BINDING_FLUID_SORTED_PARTICLES (7)
+#define BINDING_FLUID_COUNTERS (8)
+#define BINDING_SKIN_BIND_POSE (0)
+#define BINDING_SKIN_BONES (1)
+#define BINDING_SKIN_JOBS (2)
+#define BINDING_PARTICLES (0)
+#define BINDING_PARTICLE_JOBS (1)
+#define BINDING_VERT_PREPROC_ITEMS (0)
+#define BINDING_MIPMAP_SRC (0)
+#define BINDING_MIPMAP_DST (1)
+#define BINDING_MIPMAP_COUNTER (2)
+#define BINDING_BLOOM_DOWNSAMPLE_COUNTERS (0)
+#define BINDING_SKY_PREFILTER_SRC (0)
+#define BINDING_SKY_PREFILTER_DST (1)
+#define BINDING_READBACK_NV12_SRC (0)
+#define BINDING_READBACK_NV12_DST (1)
+#define BINDING_TLAS_INSTANCE_SOURCES (0)
+#define BINDING_TLAS_INSTANCES (1)
+#define BINDING_TLAS_INSTANCES_CULLED (2)
 #define INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON (1 << 0)
 #define INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER (1 << 1)
 #define INSTANCE_CUSTOM_INDEX_FLAG_SKY (1 << 2)
+#define INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC (1 << 3)
 #define INSTANCE_MASK_WORLD_0 (1 << 0)
 #define INSTANCE_MASK_WORLD_1 (1 << 1)
 #define INSTANCE_MASK_WORLD_2 (1 << 2)
-#define INSTANCE_MASK_RESERVED_0 (1 << 3)
-#define INSTANCE_MASK_RESERVED_1 (1 << 4)
+#define INSTANCE_MASK_AREA_SHADOW_ONLY (1 << 3)
+#define INSTANCE_MASK_WORLD_0_DYNAMIC (1 << 4)
 #define INSTANCE_MASK_REFRACT (1 << 5)
 #define INSTANCE_MASK_FIRST_PERSON (1 << 6)
 #define INSTANCE_MASK_FIRST_PERSON_VIEWER (1 << 7)
@@ -74,6 +113,7 @@ namespace RTGL1
 #define SBT_INDEX_HITGROUP_FULLY_OPAQUE (0)
 #define SBT_INDEX_HITGROUP_ALPHA_TESTED (1)
 #define MATERIAL_NO_TEXTURE (0)
+#define TEXTURE_SAMPLER_TABLE_SIZE (8)
 #define MATERIAL_BLENDING_TYPE_OPAQUE (0)
 #define MATERIAL_BLENDING_TYPE_ALPHA (1)
 #define MATERIAL_BLENDING_TYPE_ADD (2)
@@ -81,9 +121,9 @@ namespace RTGL1
 #define MATERIAL_BLENDING_TYPE_BIT_COUNT (2)
 #define MATERIAL_BLENDING_TYPE_BIT_MASK (3)
 #define GEOM_INST_FLAG_BLENDING_LAYER_COUNT (4)
-#define GEOM_INST_FLAG_RESERVED_0 (1 << 8)
-#define GEOM_INST_FLAG_RESERVED_1 (1 << 9)
-#define GEOM_INST_FLAG_RESERVED_2 (1 << 10)
+#define GEOM_INST_FLAG_QUANTIZED_VERTICES (1 << 8)
+#define GEOM_INST_FLAG_INDICES_16BIT (1 << 9)
+#define GEOM_INST_FLAG_PREV_INDICES_16BIT (1 << 10)
 #define GEOM_INST_FLAG_RESERVED_3 (1 << 11)
 #define GEOM_INST_FLAG_RESERVED_4 (1 << 12)
 #define GEOM_INST_FLAG_GLASS_IF_SMOOTH (1 << 13)
@@ -94,7 +134,7 @@ namespace RTGL1
 #define GEOM_INST_FLAG_MEDIA_TYPE_ACID (1 << 18)
 #define GEOM_INST_FLAG_EXACT_NORMALS (1 << 19)
 #define GEOM_INST_FLAG_IGNORE_REFRACT_AFTER (1 << 20)
-#define GEOM_INST_FLAG_RESERVED_5 (1 << 21)
+#define GEOM_INST_FLAG_EMISSIVE_SAMPLED (1 << 21)
 #define GEOM_INST_FLAG_RESERVED_6 (1 << 22)
 #define GEOM_INST_FLAG_THIN_MEDIA (1 << 23)
 #define GEOM_INST_FLAG_REFRACT (1 << 24)
@@ -112,6 +152,9 @@ namespace RTGL1
 #define BLUE_NOISE_TEXTURE_COUNT (128)
 #define BLUE_NOISE_TEXTURE_SIZE (128)
 #define BLUE_NOISE_TEXTURE_SIZE_POW (7)
+#define SAMPLE_SEQUENCE_WHITE_NOISE (0)
+#define SAMPLE_SEQUENCE_BLUE_NOISE (1)
+#define SAMPLE_SEQUENCE_SOBOL (2)
 #define COMPUTE_COMPOSE_GROUP_SIZE_X (16)
 #define COMPUTE_COMPOSE_GROUP_SIZE_Y (16)
 #define COMPUTE_DECAL_APPLY_GROUP_SIZE_X (16)
@@ -127,23 +170,40 @@ namespace RTGL1
 #define COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_X (16)
 #define COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_Y (16)
 #define COMPUTE_LUM_HISTOGRAM_BIN_COUNT (256)
+#define COMPUTE_LUM_HISTOGRAM_DOWNSAMPLE (2)
 #define COMPUTE_VERT_PREPROC_GROUP_SIZE_X (256)
 #define VERT_PREPROC_MODE_ONLY_DYNAMIC (0)
 #define VERT_PREPROC_MODE_DYNAMIC_AND_MOVABLE (1)
 #define VERT_PREPROC_MODE_ALL (2)
+#define COMPUTE_SKINNING_GROUP_SIZE_X (64)
+#define COMPUTE_PARTICLE_EXPAND_GROUP_SIZE_X (64)
+#define COMPUTE_MIPMAP_GROUP_SIZE_X (256)
+#define COMPUTE_MIPMAP_TILE_SIZE (64)
+#define COMPUTE_MIPMAP_MAX_DST_LEVELS (12)
+#define MIPMAP_FLAG_SRGB (1 << 0)
+#define MIPMAP_FLAG_NORMAL_MAP (1 << 1)
+#define COMPUTE_SKY_PREFILTER_GROUP_SIZE (8)
+#define SKY_PREFILTER_SAMPLE_COUNT (32)
+#define SKY_PREFILTER_MAX_MIP_COUNT (6)
+#define COMPUTE_READBACK_NV12_GROUP_SIZE (8)
+#define COMPUTE_TLAS_INSTANCES_GROUP_SIZE_X (256)
 #define GRADIENT_ESTIMATION_ENABLED (1)
 #define COMPUTE_GRADIENT_ATROUS_GROUP_SIZE_X (16)
-#define COMPUTE_ANTIFIREFLY_GROUP_SIZE_X (16)
 #define COMPUTE_SVGF_TEMPORAL_GROUP_SIZE_X (16)
 #define COMPUTE_SVGF_VARIANCE_GROUP_SIZE_X (16)
 #define COMPUTE_SVGF_ATROUS_GROUP_SIZE_X (16)
 #define COMPUTE_SVGF_ATROUS_ITERATION_COUNT (4)
 #define COMPUTE_ASVGF_STRATA_SIZE (3)
 #define COMPUTE_ASVGF_GRADIENT_ATROUS_ITERATION_COUNT (4)
+#define COMPUTE_SAMPLE_BUDGET_GROUP_SIZE_X (16)
 #define COMPUTE_INDIRECT_DRAW_FLARES_GROUP_SIZE_X (256)
 #define LENS_FLARES_MAX_DRAW_CMD_COUNT (512)
+#define LENS_FLARES_MAX_VERTEX_COUNT (65536)
+#define LENS_FLARES_MAX_INDEX_COUNT (262144)
 #define COMPUTE_FLUID_PARTICLES_GROUP_SIZE_X (256)
 #define COMPUTE_FLUID_PARTICLES_GENERATE_GROUP_SIZE_X (256)
+#define COMPUTE_FLUID_HASH_SCAN_GROUP_SIZE_X (256)
+#define FLUID_HASH_SCAN_BLOCK_SIZE (1024)
 #define DEBUG_SHOW_FLAG_MOTION_VECTORS (1 << 0)
 #define DEBUG_SHOW_FLAG_GRADIENTS (1 << 1)
 #define DEBUG_SHOW_FLAG_UNFILTERED_DIFFUSE (1 << 2)
@@ -156,6 +216,13 @@ namespace RTGL1
 #define DEBUG_SHOW_FLAG_ALBEDO_WHITE (1 << 9)
 #define DEBUG_SHOW_FLAG_NORMALS (1 << 10)
 #define DEBUG_SHOW_FLAG_BLOOM (1 << 11)
+#define DEBUG_SHOW_FLAG_RAY_COST (1 << 12)
+#define DEBUG_SHOW_FLAG_ANY_HIT (1 << 13)
+#define DEBUG_SHOW_FLAG_TRANSLUCENT_OVERDRAW (1 << 14)
+#define RAY_COST_STATS_ENABLED (1)
+#define RAY_COST_RAYS_BITS (10)
+#define RAY_COST_ANY_HITS_BITS (14)
+#define RAY_COST_LAYERS_BITS (8)
 #define MAX_RAY_LENGTH (10000.0)
 #define MEDIA_TYPE_VACUUM (0)
 #define MEDIA_TYPE_WATER (1)
@@ -168,14 +235,33 @@ namespace RTGL1
 #define LIGHT_TYPE_SPHERE (2)
 #define LIGHT_TYPE_SPOT (3)
 #define LIGHT_TYPE_TRIANGLE (4)
+#define LIGHT_TYPE_MASK (255)
+#define LIGHT_TYPE_LIGHTSTYLE_SHIFT (8)
+#define LIGHTSTYLE_MAX_COUNT (1024)
 #define TRIANGLE_LIGHTS (0)
 #define LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET (0)
 #define LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET (1)
 #define LIGHT_INDEX_NONE (32767)
-#define LIGHT_GRID_ENABLED (0)
+#define LIGHT_TREE_NODE_LEAF_BIT (1073741824)
+#define LIGHT_TREE_MAX_DEPTH (32)
+#define MAX_EMISSIVE_TRIANGLE_COUNT (65536)
+#define LIGHT_GRID_ENABLED (1)
+#define LIGHT_GRID_SIZE_X (16)
+#define LIGHT_GRID_SIZE_Y (16)
+#define LIGHT_GRID_SIZE_Z (16)
+#define LIGHT_GRID_CELL_SIZE (128)
+#define COMPUTE_LIGHT_GRID_GROUP_SIZE_X (256)
 #define PORTAL_INDEX_NONE (63)
 #define PORTAL_MAX_COUNT (63)
-#define PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS (5)
+#define MAX_VIEW_COUNT (4)
+#define PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS (4)
+#define RESTIR_INDIRECT_RESERVOIR_TILE_SIZE (8)
+#define IRRADIANCE_CACHE_CELL_COUNT (262144)
+#define IRRADIANCE_CACHE_PROBE_COUNT (8)
+#define IRRADIANCE_CACHE_MIN_SAMPLES (4)
+#define IRRADIANCE_CACHE_MAX_SAMPLES (64)
+#define IRRADIANCE_CACHE_MAX_AGE (256)
+#define COMPUTE_IRRADIANCE_CACHE_GROUP_SIZE_X (256)
 #define VOLUMETRIC_SIZE_X (160)
 #define VOLUMETRIC_SIZE_Y (88)
 #define VOLUMETRIC_SIZE_Z (64)
@@ -191,6 +277,10 @@ namespace RTGL1
 #define ILLUMINATION_VOLUME (0)
 #define COMPUTE_INDIRECT_FINAL_GROUP_SIZE_X (16)
 #define COMPUTE_INDIRECT_FINAL_GROUP_SIZE_Y (16)
+#define COMPUTE_RAY_QUERY_PRIMARY_GROUP_SIZE_X (8)
+#define COMPUTE_RAY_QUERY_PRIMARY_GROUP_SIZE_Y (8)
+#define COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_X (8)
+#define COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_Y (8)
 
 struct ShVertex
 {
@@ -207,6 +297,15 @@ struct ShVertexCompact
     uint32_t normalPacked;
 };
 
+struct ShVertexQuantized
+{
+    uint32_t positionXY;
+    uint32_t positionZW;
+    uint32_t normalPacked;
+    uint32_t texCoordPacked;
+    uint32_t color;
+};
+
 struct ShGlobalUniform
 {
     float view[16];
@@ -279,7 +378,7 @@ struct ShGlobalUniform
     float primaryRayMinDist;
     uint32_t rayCullMaskWorld_Shadow;
     uint32_t volumeAllowTintUnderwater;
-    uint32_t _unused2;
+    uint32_t lightTreeLeafCount;
     uint32_t twirlPortalNormal;
     uint32_t lightIndexIgnoreFPVShadows;
     float gradientMultDiffuse;
@@ -300,10 +399,49 @@ struct ShGlobalUniform
     uint32_t hdrDisplay;
     float parallaxMaxDepth;
     uint32_t fluidEnabled;
-    float _pad3;
+    uint32_t lightGridEnable;
     float fluidColor[4];
+    uint32_t emissiveTriangleCount;
+    uint32_t textureStreamingEnable;
+    uint32_t indirStride;
+    uint32_t indirTraceOffset;
+    uint32_t adaptiveSamplingEnable;
+    uint32_t volumeSizeX;
+    uint32_t volumeSizeY;
+    uint32_t volumeSizeZ;
+    uint32_t volumeReprojection;
+    uint32_t viewCount;
+    uint32_t irradianceCacheEnable;
+    float irradianceCacheCellSize;
+    float irradianceCacheUpdateRate;
+    uint32_t indirCheckerboard;
+    float reflectRefractMinThroughput;
+    float reflectRefractMaxRoughness;
+    float reflectRefractMaxDistance;
+    uint32_t reflectRefractSkyOnTermination;
+    uint32_t sampleSequence;
+    uint32_t primaryVisibilityBuffer;
+    uint32_t sunShadowCacheEnable;
+    float sunShadowCacheUpdateRate;
+    uint32_t restirDirectCandidatesMin;
+    uint32_t restirDirectCandidatesMax;
+    uint32_t restirDirectSpatialMin;
+    uint32_t restirDirectSpatialMax;
+    uint32_t restirIndirectSpatialMin;
+    uint32_t restirIndirectSpatialMax;
+    float renderWidthPrev;
+    float renderHeightPrev;
+    float renderAllocWidth;
+    float renderAllocHeight;
     float viewProjCubemap[96];
     float skyCubemapRotationTransform[16];
+    float viewsView[64];
+    float viewsInvView[64];
+    float viewsViewPrev[64];
+    float viewsProjection[64];
+    float viewsInvProjection[64];
+    float viewsProjectionPrev[64];
+    float viewsCameraPosition[16];
 };
 
 struct ShGeometryInstance
@@ -311,14 +449,42 @@ struct ShGeometryInstance
     float model_0[4];
     float model_1[4];
     float model_2[4];
+    uint32_t flags;
+    uint32_t materialIndex;
+    uint32_t baseVertexIndex;
+    uint32_t baseIndexIndex;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t firstVertex_Layer1;
+    uint32_t firstVertex_Layer2;
+    uint32_t firstVertex_Layer3;
+    uint32_t _pad0;
+    uint32_t vertexBufferAddress[2];
+    uint32_t indexBufferAddress[2];
+    uint32_t _pad1;
+    uint32_t _pad2;
+    float dequantCenter[4];
+    float dequantExtent[4];
+};
+
+struct ShGeometryInstancePrev
+{
     float prevModel_0[4];
     float prevModel_1[4];
     float prevModel_2[4];
-    uint32_t flags;
+    uint32_t prevBaseVertexIndex;
+    uint32_t prevBaseIndexIndex;
+    uint32_t _pad0;
+    uint32_t _pad1;
+};
+
+struct ShGeometryMaterial
+{
     uint32_t texture_base;
     uint32_t texture_base_ORM;
     uint32_t texture_base_N;
     uint32_t texture_base_E;
+    uint32_t texture_base_D;
     uint32_t texture_layer1;
     uint32_t texture_layer2;
     uint32_t texture_layer3;
@@ -326,24 +492,17 @@ struct ShGeometryInstance
     uint32_t colorFactor_layer1;
     uint32_t colorFactor_layer2;
     uint32_t colorFactor_layer3;
-    uint32_t baseVertexIndex;
-    uint32_t baseIndexIndex;
-    uint32_t prevBaseVertexIndex;
-    uint32_t prevBaseIndexIndex;
-    uint32_t vertexCount;
-    uint32_t indexCount;
-    uint32_t texture_base_D;
     uint32_t roughnessDefault_metallicDefault;
     float emissiveMult;
-    uint32_t firstVertex_Layer1;
-    uint32_t firstVertex_Layer2;
-    uint32_t firstVertex_Layer3;
+    uint32_t _pad0;
+    uint32_t _pad1;
 };
 
 struct ShTonemapping
 {
     uint32_t histogram[256];
     float avgLuminance;
+    uint32_t finishedGroupCount;
 };
 
 struct ShLightEncoded
@@ -364,6 +523,50 @@ struct ShLightInCell
     uint32_t __pad0;
 };
 
+struct ShLightTreeNode
+{
+    float bbMin_x;
+    float bbMin_y;
+    float bbMin_z;
+    uint32_t childOrLight;
+    float bbMax_x;
+    float bbMax_y;
+    float bbMax_z;
+    float energy;
+    float coneAxis_x;
+    float coneAxis_y;
+    float coneAxis_z;
+    float coneCosTheta;
+};
+
+struct ShEmissiveTriangle
+{
+    float p0_x;
+    float p0_y;
+    float p0_z;
+    float p1_x;
+    float p1_y;
+    float p1_z;
+    float p2_x;
+    float p2_y;
+    float p2_z;
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+    float u2;
+    float v2;
+    uint32_t texture_base;
+    uint32_t texture_base_E;
+    uint32_t colorFactor;
+    float emissiveMult;
+    float selectPdf;
+    float aliasProb;
+    uint32_t aliasIndex;
+    uint32_t _pad0;
+    uint32_t _pad1;
+};
+
 struct ShIndirectDrawCommand
 {
     uint32_t indexCount;
@@ -384,6 +587,19 @@ struct ShLensFlareInstance
     float emissiveMult;
 };
 
+struct ShRasterizedDraw
+{
+    float transform[16];
+    uint32_t packedColor;
+    uint32_t textureIndex;
+    uint32_t emissiveTextureIndex;
+    float emissiveMult;
+    uint32_t normalTextureIndex;
+    uint32_t transformIsViewProj;
+    uint32_t _pad0;
+    uint32_t _pad1;
+};
+
 struct ShPortalInstance
 {
     float inPosition[4];
@@ -392,4 +608,79 @@ struct ShPortalInstance
     float outUp[4];
 };
 
+struct ShSkinVertex
+{
+    float position[3];
+    uint32_t normalPacked;
+    float texCoord[2];
+    uint32_t color;
+    uint32_t jointsPacked;
+    uint32_t weightsPacked;
+    uint32_t _pad0;
+    uint32_t _pad1;
+    uint32_t _pad2;
+};
+
+struct ShSkinJob
+{
+    uint32_t bindPoseOffset;
+    uint32_t dstVertexIndex;
+    uint32_t vertexCount;
+    uint32_t boneOffset;
+};
+
+struct ShParticle
+{
+    float position[3];
+    float size;
+    float rotation;
+    uint32_t color;
+    uint32_t frame;
+    uint32_t _pad0;
+};
+
+struct ShVertPreprocItem
+{
+    uint32_t tlasInstanceIndex;
+    uint32_t firstTriangle;
+    uint32_t __pad0;
+    uint32_t __pad1;
+};
+
+struct ShTlasInstanceSource
+{
+    float boundsCenter[3];
+    float boundsRadius;
+    uint32_t blasAddress[2];
+    uint32_t customIndexAndMask;
+    uint32_t sbtOffsetAndFlags;
+};
+
+struct ShParticleJob
+{
+    uint32_t particleOffset;
+    uint32_t dstVertexIndex;
+    uint32_t particleCount;
+    uint32_t flipbookColumns;
+    uint32_t flipbookRows;
+    uint32_t _pad0;
+    uint32_t _pad1;
+    uint32_t _pad2;
+    float model_0[4];
+    float model_1[4];
+    float model_2[4];
+};
+
+struct ShIrradianceCacheCell
+{
+    uint32_t checksum;
+    uint32_t radianceE5;
+    uint32_t sampleCount;
+    uint32_t lastUsedFrame;
+    uint32_t accumR;
+    uint32_t accumG;
+    uint32_t accumB;
+    uint32_t accumCount;
+};
+
 }
\ No newline at end of file
@@ -35,13 +35,15 @@ const VkFormat RTGL1::ShFramebuffers_Formats[] =
     VK_FORMAT_R16G16B16A16_SFLOAT, // UpscaledPing
     VK_FORMAT_R16G16B16A16_SFLOAT, // UpscaledPong
     VK_FORMAT_R16G16_SFLOAT, // MotionDlss
+    VK_FORMAT_R16G16B16A16_SFLOAT, // RayReconNormalRoughness
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // RayReconDiffuseAlbedo
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // RayReconSpecularAlbedo
     VK_FORMAT_R8_UNORM, // Reactivity
     VK_FORMAT_R8G8B8A8_UNORM, // HudOnly
+    VK_FORMAT_R16G16B16A16_SFLOAT, // FrameGenerated
     VK_FORMAT_R16G16B16A16_SFLOAT, // AccumHistoryLength
     VK_FORMAT_R16G16B16A16_SFLOAT, // AccumHistoryLength_Prev
     VK_FORMAT_R32_UINT, // DiffTemporary
-    VK_FORMAT_R32_UINT, // DiffAccumColor
-    VK_FORMAT_R32_UINT, // DiffAccumColor_Prev
     VK_FORMAT_R16G16_SFLOAT, // DiffAccumMoments
     VK_FORMAT_R16G16_SFLOAT, // DiffAccumMoments_Prev
     VK_FORMAT_R16G16B16A16_SFLOAT, // DiffColorHistory
@@ -75,13 +77,107 @@ const VkFormat RTGL1::ShFramebuffers_Formats[] =
     VK_FORMAT_R32G32_UINT, // Reservoirs
     VK_FORMAT_R32G32_UINT, // Reservoirs_Prev
     VK_FORMAT_R32G32_UINT, // ReservoirsInitial
+    VK_FORMAT_R8G8_UNORM, // SunVisibility
+    VK_FORMAT_R8G8_UNORM, // SunVisibility_Prev
     VK_FORMAT_R32G32B32A32_UINT, // IndirectReservoirsInitial
+    VK_FORMAT_R8_UNORM, // SampleBudget
     VK_FORMAT_R16G16_SFLOAT, // GradientInputs
     VK_FORMAT_R16G16_SFLOAT, // GradientInputs_Prev
     VK_FORMAT_R8G8B8A8_UNORM, // DISPingGradient
     VK_FORMAT_R8G8B8A8_UNORM, // DISPongGradient
     VK_FORMAT_R8G8B8A8_UNORM, // DISGradientHistory
     VK_FORMAT_R8_UINT, // GradientPrevPix
+    VK_FORMAT_R32_UINT, // RayCost
+    VK_FORMAT_R32_UINT, // RayCostAnyHit
+};
+
+const VkFormat RTGL1::ShFramebuffers_FormatsCompact[] = 
+{
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // Albedo
+    VK_FORMAT_R8_UINT, // IsSky
+    VK_FORMAT_R32_UINT, // Normal
+    VK_FORMAT_R32_UINT, // Normal_Prev
+    VK_FORMAT_R8G8_UNORM, // MetallicRoughness
+    VK_FORMAT_R8G8_UNORM, // MetallicRoughness_Prev
+    VK_FORMAT_R16_SFLOAT, // DepthWorld
+    VK_FORMAT_R16_SFLOAT, // DepthWorld_Prev
+    VK_FORMAT_R16_SFLOAT, // DepthGrad
+    VK_FORMAT_R32_SFLOAT, // DepthNdc
+    VK_FORMAT_R32_SFLOAT, // DepthFluid
+    VK_FORMAT_R32_SFLOAT, // DepthFluidTemp
+    VK_FORMAT_R32_UINT, // FluidNormal
+    VK_FORMAT_R32_UINT, // FluidNormalTemp
+    VK_FORMAT_R16G16B16A16_SFLOAT, // Motion
+    VK_FORMAT_R32_UINT, // UnfilteredDirect
+    VK_FORMAT_R32_UINT, // UnfilteredSpecular
+    VK_FORMAT_R32_UINT, // UnfilteredIndir
+    VK_FORMAT_R32G32B32A32_SFLOAT, // SurfacePosition
+    VK_FORMAT_R32G32B32A32_SFLOAT, // SurfacePosition_Prev
+    VK_FORMAT_R32G32B32A32_SFLOAT, // VisibilityBuffer
+    VK_FORMAT_R32G32B32A32_SFLOAT, // VisibilityBuffer_Prev
+    VK_FORMAT_R16G16B16A16_SFLOAT, // ViewDirection
+    VK_FORMAT_R16G16B16A16_SFLOAT, // ViewDirection_Prev
+    VK_FORMAT_R32G32B32A32_UINT, // PrimaryToReflRefr
+    VK_FORMAT_R16G16B16A16_SFLOAT, // Throughput
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // PreFinal
+    VK_FORMAT_R16G16B16A16_SFLOAT, // Final
+    VK_FORMAT_R16G16B16A16_SFLOAT, // UpscaledPing
+    VK_FORMAT_R16G16B16A16_SFLOAT, // UpscaledPong
+    VK_FORMAT_R16G16_SFLOAT, // MotionDlss
+    VK_FORMAT_R16G16B16A16_SFLOAT, // RayReconNormalRoughness
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // RayReconDiffuseAlbedo
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // RayReconSpecularAlbedo
+    VK_FORMAT_R8_UNORM, // Reactivity
+    VK_FORMAT_R8G8B8A8_UNORM, // HudOnly
+    VK_FORMAT_R16G16B16A16_SFLOAT, // FrameGenerated
+    VK_FORMAT_R16G16B16A16_SFLOAT, // AccumHistoryLength
+    VK_FORMAT_R16G16B16A16_SFLOAT, // AccumHistoryLength_Prev
+    VK_FORMAT_R32_UINT, // DiffTemporary
+    VK_FORMAT_R16G16_SFLOAT, // DiffAccumMoments
+    VK_FORMAT_R16G16_SFLOAT, // DiffAccumMoments_Prev
+    VK_FORMAT_R16G16B16A16_SFLOAT, // DiffColorHistory
+    VK_FORMAT_R16G16B16A16_SFLOAT, // DiffPingColorAndVariance
+    VK_FORMAT_R16G16B16A16_SFLOAT, // DiffPongColorAndVariance
+    VK_FORMAT_R32_UINT, // SpecAccumColor
+    VK_FORMAT_R32_UINT, // SpecAccumColor_Prev
+    VK_FORMAT_R32_UINT, // SpecPingColor
+    VK_FORMAT_R32_UINT, // SpecPongColor
+    VK_FORMAT_R32_UINT, // IndirAccum
+    VK_FORMAT_R32_UINT, // IndirAccum_Prev
+    VK_FORMAT_R32_UINT, // IndirPing
+    VK_FORMAT_R32_UINT, // IndirPong
+    VK_FORMAT_R16_SFLOAT, // AtrousFilteredVariance
+    VK_FORMAT_R32_UINT, // NormalDecal
+    VK_FORMAT_R16G16B16A16_SFLOAT, // Scattering
+    VK_FORMAT_R16G16B16A16_SFLOAT, // Scattering_Prev
+    VK_FORMAT_R16_SFLOAT, // ScatteringHistory
+    VK_FORMAT_R16_SFLOAT, // ScatteringHistory_Prev
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // ScreenEmisRT
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // ScreenEmission
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // Bloom
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // Bloom_Mip1
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // Bloom_Mip2
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // Bloom_Mip3
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // Bloom_Mip4
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // Bloom_Mip5
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // Bloom_Mip6
+    VK_FORMAT_B10G11R11_UFLOAT_PACK32, // Bloom_Mip7
+    VK_FORMAT_R16G16B16A16_SFLOAT, // WipeEffectSource
+    VK_FORMAT_R32G32_UINT, // Reservoirs
+    VK_FORMAT_R32G32_UINT, // Reservoirs_Prev
+    VK_FORMAT_R32G32_UINT, // ReservoirsInitial
+    VK_FORMAT_R8G8_UNORM, // SunVisibility
+    VK_FORMAT_R8G8_UNORM, // SunVisibility_Prev
+    VK_FORMAT_R32G32B32A32_UINT, // IndirectReservoirsInitial
+    VK_FORMAT_R8_UNORM, // SampleBudget
+    VK_FORMAT_R16G16_SFLOAT, // GradientInputs
+    VK_FORMAT_R16G16_SFLOAT, // GradientInputs_Prev
+    VK_FORMAT_R8G8B8A8_UNORM, // DISPingGradient
+    VK_FORMAT_R8G8B8A8_UNORM, // DISPongGradient
+    VK_FORMAT_R8G8B8A8_UNORM, // DISGradientHistory
+    VK_FORMAT_R8_UINT, // GradientPrevPix
+    VK_FORMAT_R32_UINT, // RayCost
+    VK_FORMAT_R32_UINT, // RayCostAnyHit
 };
 
 const RTGL1::FramebufferImageFlags RTGL1::ShFramebuffers_Flags[] = 
@@ -117,13 +213,15 @@ const RTGL1::FramebufferImageFlags RTGL1::ShFramebuffers_Flags[] =
     RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_IS_ATTACHMENT | RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_UPSCALED_SIZE | RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_USAGE_TRANSFER, // UpscaledPing
     RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_IS_ATTACHMENT | RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_UPSCALED_SIZE | RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_USAGE_TRANSFER, // UpscaledPong
     0, // MotionDlss
+    0, // RayReconNormalRoughness
+    0, // RayReconDiffuseAlbedo
+    0, // RayReconSpecularAlbedo
     RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_IS_ATTACHMENT, // Reactivity
     RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_IS_ATTACHMENT | RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_UPSCALED_SIZE | RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_USAGE_TRANSFER, // HudOnly
+    RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_UPSCALED_SIZE | RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_USAGE_TRANSFER, // FrameGenerated
     0, // AccumHistoryLength
     0, // AccumHistoryLength_Prev
     0, // DiffTemporary
-    0, // DiffAccumColor
-    0, // DiffAccumColor_Prev
     0, // DiffAccumMoments
     0, // DiffAccumMoments_Prev
     0, // DiffColorHistory
@@ -157,13 +255,18 @@ const RTGL1::FramebufferImageFlags RTGL1::ShFramebuffers_Flags[] =
     0, // Reservoirs
     0, // Reservoirs_Prev
     0, // ReservoirsInitial
+    0, // SunVisibility
+    0, // SunVisibility_Prev
     0, // IndirectReservoirsInitial
+    RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_FORCE_SIZE_1_3, // SampleBudget
     0, // GradientInputs
     0, // GradientInputs_Prev
     RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_FORCE_SIZE_1_3, // DISPingGradient
     RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_FORCE_SIZE_1_3, // DISPongGradient
     RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_FORCE_SIZE_1_3, // DISGradientHistory
     RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_FORCE_SIZE_1_3, // GradientPrevPix
+    RTGL1::FB_IMAGE_FLAGS_FRAMEBUF_FLAGS_USAGE_TRANSFER, // RayCost
+    0, // RayCostAnyHit
 };
 
 const uint32_t RTGL1::ShFramebuffers_Bindings[] = 
@@ -246,6 +349,13 @@ const uint32_t RTGL1::ShFramebuffers_Bindings[] =
     75,
     76,
     77,
+    78,
+    79,
+    80,
+    81,
+    82,
+    83,
+    84,
 };
 
 const uint32_t RTGL1::ShFramebuffers_BindingsSwapped[] = 
@@ -283,32 +393,32 @@ const uint32_t RTGL1::ShFramebuffers_BindingsSwapped[] =
     30,
     31,
     32,
-    34,
     33,
+    34,
     35,
-    37,
     36,
-    39,
     38,
-    40,
+    37,
+    39,
     41,
+    40,
     42,
-    44,
     43,
-    45,
+    44,
     46,
-    48,
+    45,
     47,
-    49,
+    48,
     50,
+    49,
     51,
     52,
-    54,
     53,
+    54,
     56,
     55,
-    57,
     58,
+    57,
     59,
     60,
     61,
@@ -318,27 +428,27 @@ const uint32_t RTGL1::ShFramebuffers_BindingsSwapped[] =
     65,
     66,
     67,
-    69,
     68,
-    70,
+    69,
     71,
-    73,
+    70,
     72,
     74,
+    73,
     75,
     76,
-    77,
-};
-
-const uint32_t RTGL1::ShFramebuffers_Sampler_Bindings[] = 
-{
     78,
+    77,
     79,
     80,
     81,
     82,
     83,
     84,
+};
+
+const uint32_t RTGL1::ShFramebuffers_Sampler_Bindings[] = 
+{
     85,
     86,
     87,
@@ -375,7 +485,7 @@ const uint32_t RTGL1::ShFramebuffers_Sampler_Bindings[] =
     118,
     119,
     120,
-    121,
+    FB_SAMPLER_INVALID_BINDING,
     122,
     123,
     124,
@@ -410,88 +520,109 @@ const uint32_t RTGL1::ShFramebuffers_Sampler_Bindings[] =
     153,
     154,
     155,
+    156,
+    157,
+    158,
+    159,
+    160,
+    161,
+    162,
+    163,
+    164,
+    165,
+    166,
+    167,
+    FB_SAMPLER_INVALID_BINDING,
+    FB_SAMPLER_INVALID_BINDING,
 };
 
 const uint32_t RTGL1::ShFramebuffers_Sampler_BindingsSwapped[] = 
 {
-    78,
-    79,
-    81,
-    80,
-    83,
-    82,
     85,
-    84,
     86,
-    87,
     88,
-    89,
+    87,
     90,
-    91,
+    89,
     92,
+    91,
     93,
     94,
     95,
-    97,
     96,
-    99,
+    97,
     98,
-    101,
+    99,
     100,
+    101,
     102,
-    103,
     104,
-    105,
+    103,
     106,
-    107,
+    105,
     108,
+    107,
     109,
     110,
-    112,
     111,
+    112,
     113,
-    115,
     114,
-    117,
+    115,
     116,
+    117,
     118,
     119,
     120,
-    122,
-    121,
+    FB_SAMPLER_INVALID_BINDING,
     123,
+    122,
     124,
     126,
     125,
     127,
     128,
     129,
+    131,
     130,
     132,
-    131,
-    134,
     133,
     135,
+    134,
     136,
     137,
     138,
     139,
-    140,
     141,
-    142,
+    140,
     143,
+    142,
     144,
     145,
-    147,
     146,
+    147,
     148,
     149,
-    151,
     150,
+    151,
     152,
     153,
     154,
+    156,
     155,
+    157,
+    159,
+    158,
+    160,
+    161,
+    163,
+    162,
+    164,
+    165,
+    166,
+    167,
+    FB_SAMPLER_INVALID_BINDING,
+    FB_SAMPLER_INVALID_BINDING,
 };
 
 const char *const RTGL1::ShFramebuffers_DebugNames[] = 
@@ -527,13 +658,15 @@ const char *const RTGL1::ShFramebuffers_DebugNames[] =
     "Framebuf UpscaledPing",
     "Framebuf UpscaledPong",
     "Framebuf MotionDlss",
+    "Framebuf RayReconNormalRoughness",
+    "Framebuf RayReconDiffuseAlbedo",
+    "Framebuf RayReconSpecularAlbedo",
     "Framebuf Reactivity",
     "Framebuf HudOnly",
+    "Framebuf FrameGenerated",
     "Framebuf AccumHistoryLength",
     "Framebuf AccumHistoryLength_Prev",
     "Framebuf DiffTemporary",
-    "Framebuf DiffAccumColor",
-    "Framebuf DiffAccumColor_Prev",
     "Framebuf DiffAccumMoments",
     "Framebuf DiffAccumMoments_Prev",
     "Framebuf DiffColorHistory",
@@ -567,13 +700,18 @@ const char *const RTGL1::ShFramebuffers_DebugNames[] =
     "Framebuf Reservoirs",
     "Framebuf Reservoirs_Prev",
     "Framebuf ReservoirsInitial",
+    "Framebuf SunVisibility",
+    "Framebuf SunVisibility_Prev",
     "Framebuf IndirectReservoirsInitial",
+    "Framebuf SampleBudget",
     "Framebuf GradientInputs",
     "Framebuf GradientInputs_Prev",
     "Framebuf DISPingGradient",
     "Framebuf DISPongGradient",
     "Framebuf DISGradientHistory",
     "Framebuf GradientPrevPix",
+    "Framebuf RayCost",
+    "Framebuf RayCostAnyHit",
 };
 
 const wchar_t *const RTGL1::ShFramebuffers_DebugNamesW[] = 
@@ -609,13 +747,15 @@ const wchar_t *const RTGL1::ShFramebuffers_DebugNamesW[] =
     L"Framebuf UpscaledPing",
     L"Framebuf UpscaledPong",
     L"Framebuf MotionDlss",
+    L"Framebuf RayReconNormalRoughness",
+    L"Framebuf RayReconDiffuseAlbedo",
+    L"Framebuf RayReconSpecularAlbedo",
     L"Framebuf Reactivity",
     L"Framebuf HudOnly",
+    L"Framebuf FrameGenerated",
     L"Framebuf AccumHistoryLength",
     L"Framebuf AccumHistoryLength_Prev",
     L"Framebuf DiffTemporary",
-    L"Framebuf DiffAccumColor",
-    L"Framebuf DiffAccumColor_Prev",
     L"Framebuf DiffAccumMoments",
     L"Framebuf DiffAccumMoments_Prev",
     L"Framebuf DiffColorHistory",
@@ -649,12 +789,17 @@ const wchar_t *const RTGL1::ShFramebuffers_DebugNamesW[] =
     L"Framebuf Reservoirs",
     L"Framebuf Reservoirs_Prev",
     L"Framebuf ReservoirsInitial",
+    L"Framebuf SunVisibility",
+    L"Framebuf SunVisibility_Prev",
     L"Framebuf IndirectReservoirsInitial",
+    L"Framebuf SampleBudget",
     L"Framebuf GradientInputs",
     L"Framebuf GradientInputs_Prev",
     L"Framebuf DISPingGradient",
     L"Framebuf DISPongGradient",
     L"Framebuf DISGradientHistory",
     L"Framebuf GradientPrevPix",
+    L"Framebuf RayCost",
+    L"Framebuf RayCostAnyHit",
 };
 
@@ -42,53 +42,60 @@ enum FramebufferImageIndex
     FB_IMAGE_INDEX_UPSCALED_PING = 28,
     FB_IMAGE_INDEX_UPSCALED_PONG = 29,
     FB_IMAGE_INDEX_MOTION_DLSS = 30,
-    FB_IMAGE_INDEX_REACTIVITY = 31,
-    FB_IMAGE_INDEX_HUD_ONLY = 32,
-    FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH = 33,
-    FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH_PREV = 34,
-    FB_IMAGE_INDEX_DIFF_TEMPORARY = 35,
-    FB_IMAGE_INDEX_DIFF_ACCUM_COLOR = 36,
-    FB_IMAGE_INDEX_DIFF_ACCUM_COLOR_PREV = 37,
-    FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS = 38,
-    FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS_PREV = 39,
-    FB_IMAGE_INDEX_DIFF_COLOR_HISTORY = 40,
-    FB_IMAGE_INDEX_DIFF_PING_COLOR_AND_VARIANCE = 41,
-    FB_IMAGE_INDEX_DIFF_PONG_COLOR_AND_VARIANCE = 42,
-    FB_IMAGE_INDEX_SPEC_ACCUM_COLOR = 43,
-    FB_IMAGE_INDEX_SPEC_ACCUM_COLOR_PREV = 44,
-    FB_IMAGE_INDEX_SPEC_PING_COLOR = 45,
-    FB_IMAGE_INDEX_SPEC_PONG_COLOR = 46,
-    FB_IMAGE_INDEX_INDIR_ACCUM = 47,
-    FB_IMAGE_INDEX_INDIR_ACCUM_PREV = 48,
-    FB_IMAGE_INDEX_INDIR_PING = 49,
-    FB_IMAGE_INDEX_INDIR_PONG = 50,
-    FB_IMAGE_INDEX_ATROUS_FILTERED_VARIANCE = 51,
-    FB_IMAGE_INDEX_NORMAL_DECAL = 52,
-    FB_IMAGE_INDEX_SCATTERING = 53,
-    FB_IMAGE_INDEX_SCATTERING_PREV = 54,
-    FB_IMAGE_INDEX_SCATTERING_HISTORY = 55,
-    FB_IMAGE_INDEX_SCATTERING_HISTORY_PREV = 56,
-    FB_IMAGE_INDEX_SCREEN_EMIS_R_T = 57,
-    FB_IMAGE_INDEX_SCREEN_EMISSION = 58,
-    FB_IMAGE_INDEX_BLOOM = 59,
-    FB_IMAGE_INDEX_BLOOM_MIP1 = 60,
-    FB_IMAGE_INDEX_BLOOM_MIP2 = 61,
-    FB_IMAGE_INDEX_BLOOM_MIP3 = 62,
-    FB_IMAGE_INDEX_BLOOM_MIP4 = 63,
-    FB_IMAGE_INDEX_BLOOM_MIP5 = 64,
-    FB_IMAGE_INDEX_BLOOM_MIP6 = 65,
-    FB_IMAGE_INDEX_BLOOM_MIP7 = 66,
-    FB_IMAGE_INDEX_WIPE_EFFECT_SOURCE = 67,
-    FB_IMAGE_INDEX_RESERVOIRS = 68,
-    FB_IMAGE_INDEX_RESERVOIRS_PREV = 69,
-    FB_IMAGE_INDEX_RESERVOIRS_INITIAL = 70,
-    FB_IMAGE_INDEX_INDIRECT_RESERVOIRS_INITIAL = 71,
-    FB_IMAGE_INDEX_GRADIENT_INPUTS = 72,
-    FB_IMAGE_INDEX_GRADIENT_INPUTS_PREV = 73,
-    FB_IMAGE_INDEX_D_I_S_PING_GRADIENT = 74,
-    FB_IMAGE_INDEX_D_I_S_PONG_GRADIENT = 75,
-    FB_IMAGE_INDEX_D_I_S_GRADIENT_HISTORY = 76,
-    FB_IMAGE_INDEX_GRADIENT_PREV_PIX = 77,
+    FB_IMAGE_INDEX_RAY_RECON_NORMAL_ROUGHNESS = 31,
+    FB_IMAGE_INDEX_RAY_RECON_DIFFUSE_ALBEDO = 32,
+    FB_IMAGE_INDEX_RAY_RECON_SPECULAR_ALBEDO = 33,
+    FB_IMAGE_INDEX_REACTIVITY = 34,
+    FB_IMAGE_INDEX_HUD_ONLY = 35,
+    FB_IMAGE_INDEX_FRAME_GENERATED = 36,
+    FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH = 37,
+    FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH_PREV = 38,
+    FB_IMAGE_INDEX_DIFF_TEMPORARY = 39,
+    FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS = 40,
+    FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS_PREV = 41,
+    FB_IMAGE_INDEX_DIFF_COLOR_HISTORY = 42,
+    FB_IMAGE_INDEX_DIFF_PING_COLOR_AND_VARIANCE = 43,
+    FB_IMAGE_INDEX_DIFF_PONG_COLOR_AND_VARIANCE = 44,
+    FB_IMAGE_INDEX_SPEC_ACCUM_COLOR = 45,
+    FB_IMAGE_INDEX_SPEC_ACCUM_COLOR_PREV = 46,
+    FB_IMAGE_INDEX_SPEC_PING_COLOR = 47,
+    FB_IMAGE_INDEX_SPEC_PONG_COLOR = 48,
+    FB_IMAGE_INDEX_INDIR_ACCUM = 49,
+    FB_IMAGE_INDEX_INDIR_ACCUM_PREV = 50,
+    FB_IMAGE_INDEX_INDIR_PING = 51,
+    FB_IMAGE_INDEX_INDIR_PONG = 52,
+    FB_IMAGE_INDEX_ATROUS_FILTERED_VARIANCE = 53,
+    FB_IMAGE_INDEX_NORMAL_DECAL = 54,
+    FB_IMAGE_INDEX_SCATTERING = 55,
+    FB_IMAGE_INDEX_SCATTERING_PREV = 56,
+    FB_IMAGE_INDEX_SCATTERING_HISTORY = 57,
+    FB_IMAGE_INDEX_SCATTERING_HISTORY_PREV = 58,
+    FB_IMAGE_INDEX_SCREEN_EMIS_R_T = 59,
+    FB_IMAGE_INDEX_SCREEN_EMISSION = 60,
+    FB_IMAGE_INDEX_BLOOM = 61,
+    FB_IMAGE_INDEX_BLOOM_MIP1 = 62,
+    FB_IMAGE_INDEX_BLOOM_MIP2 = 63,
+    FB_IMAGE_INDEX_BLOOM_MIP3 = 64,
+    FB_IMAGE_INDEX_BLOOM_MIP4 = 65,
+    FB_IMAGE_INDEX_BLOOM_MIP5 = 66,
+    FB_IMAGE_INDEX_BLOOM_MIP6 = 67,
+    FB_IMAGE_INDEX_BLOOM_MIP7 = 68,
+    FB_IMAGE_INDEX_WIPE_EFFECT_SOURCE = 69,
+    FB_IMAGE_INDEX_RESERVOIRS = 70,
+    FB_IMAGE_INDEX_RESERVOIRS_PREV = 71,
+    FB_IMAGE_INDEX_RESERVOIRS_INITIAL = 72,
+    FB_IMAGE_INDEX_SUN_VISIBILITY = 73,
+    FB_IMAGE_INDEX_SUN_VISIBILITY_PREV = 74,
+    FB_IMAGE_INDEX_INDIRECT_RESERVOIRS_INITIAL = 75,
+    FB_IMAGE_INDEX_SAMPLE_BUDGET = 76,
+    FB_IMAGE_INDEX_GRADIENT_INPUTS = 77,
+    FB_IMAGE_INDEX_GRADIENT_INPUTS_PREV = 78,
+    FB_IMAGE_INDEX_D_I_S_PING_GRADIENT = 79,
+    FB_IMAGE_INDEX_D_I_S_PONG_GRADIENT = 80,
+    FB_IMAGE_INDEX_D_I_S_GRADIENT_HISTORY = 81,
+    FB_IMAGE_INDEX_GRADIENT_PREV_PIX = 82,
+    FB_IMAGE_INDEX_RAY_COST = 83,
+    FB_IMAGE_INDEX_RAY_COST_ANY_HIT = 84,
 };
 
 enum FramebufferImageFlagBits
@@ -103,8 +110,9 @@ enum FramebufferImageFlagBits
 };
 typedef uint32_t FramebufferImageFlags;
 
-constexpr uint32_t ShFramebuffers_Count = 78;
+constexpr uint32_t ShFramebuffers_Count = 85;
 extern const VkFormat ShFramebuffers_Formats[];
+extern const VkFormat ShFramebuffers_FormatsCompact[];
 extern const FramebufferImageFlags ShFramebuffers_Flags[];
 extern const uint32_t ShFramebuffers_Bindings[];
 extern const uint32_t ShFramebuffers_BindingsSwapped[];
@@ -16,9 +16,15 @@
 #define BINDING_DYNAMIC_TEXCOORD_LAYER_1 (11)
 #define BINDING_DYNAMIC_TEXCOORD_LAYER_2 (12)
 #define BINDING_DYNAMIC_TEXCOORD_LAYER_3 (13)
+#define BINDING_EMISSIVE_TRIANGLES (14)
+#define BINDING_GEOMETRY_INSTANCES_PREV (15)
+#define BINDING_GEOMETRY_MATERIALS (16)
 #define BINDING_GLOBAL_UNIFORM (0)
 #define BINDING_ACCELERATION_STRUCTURE_MAIN (0)
 #define BINDING_TEXTURES (0)
+#define BINDING_TEXTURE_STREAMING_FEEDBACK (1)
+#define BINDING_TEXTURE_SAMPLERS (2)
+#define BINDING_TEXTURE_SAMPLER_INDICES (3)
 #define BINDING_CUBEMAPS (0)
 #define BINDING_RENDER_CUBEMAP (0)
 #define BINDING_BLUE_NOISE (0)
@@ -27,29 +33,62 @@
 #define BINDING_LIGHT_SOURCES_PREV (1)
 #define BINDING_LIGHT_SOURCES_INDEX_PREV_TO_CUR (2)
 #define BINDING_LIGHT_SOURCES_INDEX_CUR_TO_PREV (3)
-#define BINDING_INITIAL_LIGHTS_GRID (4)
-#define BINDING_INITIAL_LIGHTS_GRID_PREV (5)
+#define BINDING_LIGHT_TREE (4)
+#define BINDING_LIGHTSTYLES (5)
+#define BINDING_INITIAL_LIGHTS_GRID (6)
+#define BINDING_INITIAL_LIGHTS_GRID_PREV (7)
 #define BINDING_LENS_FLARES_CULLING_INPUT (0)
 #define BINDING_LENS_FLARES_DRAW_CMDS (1)
+#define BINDING_LENS_FLARES_SOURCE_INDICES (2)
+#define BINDING_LENS_FLARES_VISIBLE_INDICES (3)
 #define BINDING_DRAW_LENS_FLARES_INSTANCES (0)
+#define BINDING_DRAW_LENS_FLARES_VERTEX_INSTANCES (1)
+#define BINDING_RASTERIZED_DRAWS (0)
 #define BINDING_PORTAL_INSTANCES (0)
 #define BINDING_LPM_PARAMS (0)
 #define BINDING_RESTIR_INDIRECT_RESERVOIRS (2)
 #define BINDING_RESTIR_INDIRECT_RESERVOIRS_PREV (1)
+#define BINDING_RESTIR_INDIRECT_IRRADIANCE_CACHE (3)
 #define BINDING_VOLUMETRIC_STORAGE (0)
 #define BINDING_VOLUMETRIC_SAMPLER (1)
 #define BINDING_VOLUMETRIC_SAMPLER_PREV (2)
+#define BINDING_VOLUMETRIC_RAW_STORAGE (5)
+#define BINDING_VOLUMETRIC_RAW_SAMPLER_PREV (6)
 #define BINDING_FLUID_PARTICLES_ARRAY (0)
 #define BINDING_FLUID_GENERATE_ID_TO_SOURCE (1)
 #define BINDING_FLUID_SOURCES (2)
+#define BINDING_FLUID_CELL_COUNT (3)
+#define BINDING_FLUID_CELL_START (4)
+#define BINDING_FLUID_CELL_BLOCK_SUMS (5)
+#define BINDING_FLUID_PARTICLE_CELL (6)
+#define BINDING_FLUID_SORTED_PARTICLES (7)
+#define BINDING_FLUID_COUNTERS (8)
+#define BINDING_SKIN_BIND_POSE (0)
+#define BINDING_SKIN_BONES (1)
+#define BINDING_SKIN_JOBS (2)
+#define BINDING_PARTICLES (0)
+#define BINDING_PARTICLE_JOBS (1)
+#define BINDING_VERT_PREPROC_ITEMS (0)
+#define BINDING_MIPMAP_SRC (0)
+#define BINDING_MIPMAP_DST (1)
+#define BINDING_MIPMAP_COUNTER (2)
+#define BINDING_BLOOM_DOWNSAMPLE_COUNTERS (0)
+#define BINDING_SKY_PREFILTER_SRC (0)
+#define BINDING_SKY_PREFILTER_DST (1)
+#define BINDING_READBACK_NV12_SRC (0)
+#define BINDING_READBACK_NV12_DST (1)
+#define BINDING_TLAS_INSTANCE_SOURCES (0)
+#define BINDING_TLAS_INSTANCES (1)
+#define BINDING_TLAS_INSTANCES_CULLED (2)
 #define INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON (1 << 0)
 #define INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER (1 << 1)
 #define INSTANCE_CUSTOM_INDEX_FLAG_SKY (1 << 2)
+#define INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC (1 << 3)
 #define INSTANCE_MASK_WORLD_0 (1 << 0)
 #define INSTANCE_MASK_WORLD_1 (1 << 1)
 #define INSTANCE_MASK_WORLD_2 (1 << 2)
-#define INSTANCE_MASK_RESERVED_0 (1 << 3)
-#define INSTANCE_MASK_RESERVED_1 (1 << 4)
+#define INSTANCE_MASK_AREA_SHADOW_ONLY (1 << 3)
+#define INSTANCE_MASK_WORLD_0_DYNAMIC (1 << 4)
 #define INSTANCE_MASK_REFRACT (1 << 5)
 #define INSTANCE_MASK_FIRST_PERSON (1 << 6)
 #define INSTANCE_MASK_FIRST_PERSON_VIEWER (1 << 7)
@@ -67,6 +106,7 @@
 #define SBT_INDEX_HITGROUP_FULLY_OPAQUE (0)
 #define SBT_INDEX_HITGROUP_ALPHA_TESTED (1)
 #define MATERIAL_NO_TEXTURE (0)
+#define TEXTURE_SAMPLER_TABLE_SIZE (8)
 #define MATERIAL_BLENDING_TYPE_OPAQUE (0)
 #define MATERIAL_BLENDING_TYPE_ALPHA (1)
 #define MATERIAL_BLENDING_TYPE_ADD (2)
@@ -74,9 +114,9 @@
 #define MATERIAL_BLENDING_TYPE_BIT_COUNT (2)
 #define MATERIAL_BLENDING_TYPE_BIT_MASK (3)
 #define GEOM_INST_FLAG_BLENDING_LAYER_COUNT (4)
-#define GEOM_INST_FLAG_RESERVED_0 (1 << 8)
-#define GEOM_INST_FLAG_RESERVED_1 (1 << 9)
-#define GEOM_INST_FLAG_RESERVED_2 (1 << 10)
+#define GEOM_INST_FLAG_QUANTIZED_VERTICES (1 << 8)
+#define GEOM_INST_FLAG_INDICES_16BIT (1 << 9)
+#define GEOM_INST_FLAG_PREV_INDICES_16BIT (1 << 10)
 #define GEOM_INST_FLAG_RESERVED_3 (1 << 11)
 #define GEOM_INST_FLAG_RESERVED_4 (1 << 12)
 #define GEOM_INST_FLAG_GLASS_IF_SMOOTH (1 << 13)
@@ -87,7 +127,7 @@
 #define GEOM_INST_FLAG_MEDIA_TYPE_ACID (1 << 18)
 #define GEOM_INST_FLAG_EXACT_NORMALS (1 << 19)
 #define GEOM_INST_FLAG_IGNORE_REFRACT_AFTER (1 << 20)
-#define GEOM_INST_FLAG_RESERVED_5 (1 << 21)
+#define GEOM_INST_FLAG_EMISSIVE_SAMPLED (1 << 21)
 #define GEOM_INST_FLAG_RESERVED_6 (1 << 22)
 #define GEOM_INST_FLAG_THIN_MEDIA (1 << 23)
 #define GEOM_INST_FLAG_REFRACT (1 << 24)
@@ -105,6 +145,9 @@
 #define BLUE_NOISE_TEXTURE_COUNT (128)
 #define BLUE_NOISE_TEXTURE_SIZE (128)
 #define BLUE_NOISE_TEXTURE_SIZE_POW (7)
+#define SAMPLE_SEQUENCE_WHITE_NOISE (0)
+#define SAMPLE_SEQUENCE_BLUE_NOISE (1)
+#define SAMPLE_SEQUENCE_SOBOL (2)
 #define COMPUTE_COMPOSE_GROUP_SIZE_X (16)
 #define COMPUTE_COMPOSE_GROUP_SIZE_Y (16)
 #define COMPUTE_DECAL_APPLY_GROUP_SIZE_X (16)
@@ -120,23 +163,40 @@
 #define COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_X (16)
 #define COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_Y (16)
 #define COMPUTE_LUM_HISTOGRAM_BIN_COUNT (256)
+#define COMPUTE_LUM_HISTOGRAM_DOWNSAMPLE (2)
 #define COMPUTE_VERT_PREPROC_GROUP_SIZE_X (256)
 #define VERT_PREPROC_MODE_ONLY_DYNAMIC (0)
 #define VERT_PREPROC_MODE_DYNAMIC_AND_MOVABLE (1)
 #define VERT_PREPROC_MODE_ALL (2)
+#define COMPUTE_SKINNING_GROUP_SIZE_X (64)
+#define COMPUTE_PARTICLE_EXPAND_GROUP_SIZE_X (64)
+#define COMPUTE_MIPMAP_GROUP_SIZE_X (256)
+#define COMPUTE_MIPMAP_TILE_SIZE (64)
+#define COMPUTE_MIPMAP_MAX_DST_LEVELS (12)
+#define MIPMAP_FLAG_SRGB (1 << 0)
+#define MIPMAP_FLAG_NORMAL_MAP (1 << 1)
+#define COMPUTE_SKY_PREFILTER_GROUP_SIZE (8)
+#define SKY_PREFILTER_SAMPLE_COUNT (32)
+#define SKY_PREFILTER_MAX_MIP_COUNT (6)
+#define COMPUTE_READBACK_NV12_GROUP_SIZE (8)
+#define COMPUTE_TLAS_INSTANCES_GROUP_SIZE_X (256)
 #define GRADIENT_ESTIMATION_ENABLED (1)
 #define COMPUTE_GRADIENT_ATROUS_GROUP_SIZE_X (16)
-#define COMPUTE_ANTIFIREFLY_GROUP_SIZE_X (16)
 #define COMPUTE_SVGF_TEMPORAL_GROUP_SIZE_X (16)
 #define COMPUTE_SVGF_VARIANCE_GROUP_SIZE_X (16)
 #define COMPUTE_SVGF_ATROUS_GROUP_SIZE_X (16)
 #define COMPUTE_SVGF_ATROUS_ITERATION_COUNT (4)
 #define COMPUTE_ASVGF_STRATA_SIZE (3)
 #define COMPUTE_ASVGF_GRADIENT_ATROUS_ITERATION_COUNT (4)
+#define COMPUTE_SAMPLE_BUDGET_GROUP_SIZE_X (16)
 #define COMPUTE_INDIRECT_DRAW_FLARES_GROUP_SIZE_X (256)
 #define LENS_FLARES_MAX_DRAW_CMD_COUNT (512)
+#define LENS_FLARES_MAX_VERTEX_COUNT (65536)
+#define LENS_FLARES_MAX_INDEX_COUNT (262144)
 #define COMPUTE_FLUID_PARTICLES_GROUP_SIZE_X (256)
 #define COMPUTE_FLUID_PARTICLES_GENERATE_GROUP_SIZE_X (256)
+#define COMPUTE_FLUID_HASH_SCAN_GROUP_SIZE_X (256)
+#define FLUID_HASH_SCAN_BLOCK_SIZE (1024)
 #define DEBUG_SHOW_FLAG_MOTION_VECTORS (1 << 0)
 #define DEBUG_SHOW_FLAG_GRADIENTS (1 << 1)
 #define DEBUG_SHOW_FLAG_UNFILTERED_DIFFUSE (1 << 2)
@@ -149,6 +209,13 @@
 #define DEBUG_SHOW_FLAG_ALBEDO_WHITE (1 << 9)
 #define DEBUG_SHOW_FLAG_NORMALS (1 << 10)
 #define DEBUG_SHOW_FLAG_BLOOM (1 << 11)
+#define DEBUG_SHOW_FLAG_RAY_COST (1 << 12)
+#define DEBUG_SHOW_FLAG_ANY_HIT (1 << 13)
+#define DEBUG_SHOW_FLAG_TRANSLUCENT_OVERDRAW (1 << 14)
+#define RAY_COST_STATS_ENABLED (1)
+#define RAY_COST_RAYS_BITS (10)
+#define RAY_COST_ANY_HITS_BITS (14)
+#define RAY_COST_LAYERS_BITS (8)
 #define MAX_RAY_LENGTH (10000.0)
 #define MEDIA_TYPE_VACUUM (0)
 #define MEDIA_TYPE_WATER (1)
@@ -161,14 +228,33 @@
 #define LIGHT_TYPE_SPHERE (2)
 #define LIGHT_TYPE_SPOT (3)
 #define LIGHT_TYPE_TRIANGLE (4)
+#define LIGHT_TYPE_MASK (255)
+#define LIGHT_TYPE_LIGHTSTYLE_SHIFT (8)
+#define LIGHTSTYLE_MAX_COUNT (1024)
 #define TRIANGLE_LIGHTS (0)
 #define LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET (0)
 #define LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET (1)
 #define LIGHT_INDEX_NONE (32767)
-#define LIGHT_GRID_ENABLED (0)
+#define LIGHT_TREE_NODE_LEAF_BIT (1073741824)
+#define LIGHT_TREE_MAX_DEPTH (32)
+#define MAX_EMISSIVE_TRIANGLE_COUNT (65536)
+#define LIGHT_GRID_ENABLED (1)
+#define LIGHT_GRID_SIZE_X (16)
+#define LIGHT_GRID_SIZE_Y (16)
+#define LIGHT_GRID_SIZE_Z (16)
+#define LIGHT_GRID_CELL_SIZE (128)
+#define COMPUTE_LIGHT_GRID_GROUP_SIZE_X (256)
 #define PORTAL_INDEX_NONE (63)
 #define PORTAL_MAX_COUNT (63)
-#define PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS (5)
+#define MAX_VIEW_COUNT (4)
+#define PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS (4)
+#define RESTIR_INDIRECT_RESERVOIR_TILE_SIZE (8)
+#define IRRADIANCE_CACHE_CELL_COUNT (262144)
+#define IRRADIANCE_CACHE_PROBE_COUNT (8)
+#define IRRADIANCE_CACHE_MIN_SAMPLES (4)
+#define IRRADIANCE_CACHE_MAX_SAMPLES (64)
+#define IRRADIANCE_CACHE_MAX_AGE (256)
+#define COMPUTE_IRRADIANCE_CACHE_GROUP_SIZE_X (256)
 #define VOLUMETRIC_SIZE_X (160)
 #define VOLUMETRIC_SIZE_Y (88)
 #define VOLUMETRIC_SIZE_Z (64)
@@ -184,6 +270,10 @@
 #define ILLUMINATION_VOLUME (0)
 #define COMPUTE_INDIRECT_FINAL_GROUP_SIZE_X (16)
 #define COMPUTE_INDIRECT_FINAL_GROUP_SIZE_Y (16)
+#define COMPUTE_RAY_QUERY_PRIMARY_GROUP_SIZE_X (8)
+#define COMPUTE_RAY_QUERY_PRIMARY_GROUP_SIZE_Y (8)
+#define COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_X (8)
+#define COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_Y (8)
 
 #define SURFACE_POSITION_INCORRECT (10000000.0)
 
@@ -202,6 +292,15 @@ struct ShVertexCompact
     uint normalPacked;
 };
 
+struct ShVertexQuantized
+{
+    uint positionXY;
+    uint positionZW;
+    uint normalPacked;
+    uint texCoordPacked;
+    uint color;
+};
+
 struct ShGlobalUniform
 {
     mat4 view;
@@ -274,7 +373,7 @@ struct ShGlobalUniform
     float primaryRayMinDist;
     uint rayCullMaskWorld_Shadow;
     uint volumeAllowTintUnderwater;
-    uint _unused2;
+    uint lightTreeLeafCount;
     uint twirlPortalNormal;
     uint lightIndexIgnoreFPVShadows;
     float gradientMultDiffuse;
@@ -295,10 +394,49 @@ struct ShGlobalUniform
     uint hdrDisplay;
     float parallaxMaxDepth;
     uint fluidEnabled;
-    float _pad3;
+    uint lightGridEnable;
     vec4 fluidColor;
+    uint emissiveTriangleCount;
+    uint textureStreamingEnable;
+    uint indirStride;
+    uint indirTraceOffset;
+    uint adaptiveSamplingEnable;
+    uint volumeSizeX;
+    uint volumeSizeY;
+    uint volumeSizeZ;
+    uint volumeReprojection;
+    uint viewCount;
+    uint irradianceCacheEnable;
+    float irradianceCacheCellSize;
+    float irradianceCacheUpdateRate;
+    uint indirCheckerboard;
+    float reflectRefractMinThroughput;
+    float reflectRefractMaxRoughness;
+    float reflectRefractMaxDistance;
+    uint reflectRefractSkyOnTermination;
+    uint sampleSequence;
+    uint primaryVisibilityBuffer;
+    uint sunShadowCacheEnable;
+    float sunShadowCacheUpdateRate;
+    uint restirDirectCandidatesMin;
+    uint restirDirectCandidatesMax;
+    uint restirDirectSpatialMin;
+    uint restirDirectSpatialMax;
+    uint restirIndirectSpatialMin;
+    uint restirIndirectSpatialMax;
+    float renderWidthPrev;
+    float renderHeightPrev;
+    float renderAllocWidth;
+    float renderAllocHeight;
     mat4 viewProjCubemap[6];
     mat4 skyCubemapRotationTransform;
+    mat4 viewsView[4];
+    mat4 viewsInvView[4];
+    mat4 viewsViewPrev[4];
+    mat4 viewsProjection[4];
+    mat4 viewsInvProjection[4];
+    mat4 viewsProjectionPrev[4];
+    vec4 viewsCameraPosition[4];
 };
 
 struct ShGeometryInstance
@@ -306,14 +444,42 @@ struct ShGeometryInstance
     vec4 model_0;
     vec4 model_1;
     vec4 model_2;
+    uint flags;
+    uint materialIndex;
+    uint baseVertexIndex;
+    uint baseIndexIndex;
+    uint vertexCount;
+    uint indexCount;
+    uint firstVertex_Layer1;
+    uint firstVertex_Layer2;
+    uint firstVertex_Layer3;
+    uint _pad0;
+    uvec2 vertexBufferAddress;
+    uvec2 indexBufferAddress;
+    uint _pad1;
+    uint _pad2;
+    vec4 dequantCenter;
+    vec4 dequantExtent;
+};
+
+struct ShGeometryInstancePrev
+{
     vec4 prevModel_0;
     vec4 prevModel_1;
     vec4 prevModel_2;
-    uint flags;
+    uint prevBaseVertexIndex;
+    uint prevBaseIndexIndex;
+    uint _pad0;
+    uint _pad1;
+};
+
+struct ShGeometryMaterial
+{
     uint texture_base;
     uint texture_base_ORM;
     uint texture_base_N;
     uint texture_base_E;
+    uint texture_base_D;
     uint texture_layer1;
     uint texture_layer2;
     uint texture_layer3;
@@ -321,24 +487,17 @@ struct ShGeometryInstance
     uint colorFactor_layer1;
     uint colorFactor_layer2;
     uint colorFactor_layer3;
-    uint baseVertexIndex;
-    uint baseIndexIndex;
-    uint prevBaseVertexIndex;
-    uint prevBaseIndexIndex;
-    uint vertexCount;
-    uint indexCount;
-    uint texture_base_D;
     uint roughnessDefault_metallicDefault;
     float emissiveMult;
-    uint firstVertex_Layer1;
-    uint firstVertex_Layer2;
-    uint firstVertex_Layer3;
+    uint _pad0;
+    uint _pad1;
 };
 
 struct ShTonemapping
 {
     uint histogram[256];
     float avgLuminance;
+    uint finishedGroupCount;
 };
 
 struct ShLightEncoded
@@ -359,6 +518,50 @@ struct ShLightInCell
     uint __pad0;
 };
 
+struct ShLightTreeNode
+{
+    float bbMin_x;
+    float bbMin_y;
+    float bbMin_z;
+    uint childOrLight;
+    float bbMax_x;
+    float bbMax_y;
+    float bbMax_z;
+    float energy;
+    float coneAxis_x;
+    float coneAxis_y;
+    float coneAxis_z;
+    float coneCosTheta;
+};
+
+struct ShEmissiveTriangle
+{
+    float p0_x;
+    float p0_y;
+    float p0_z;
+    float p1_x;
+    float p1_y;
+    float p1_z;
+    float p2_x;
+    float p2_y;
+    float p2_z;
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+    float u2;
+    float v2;
+    uint texture_base;
+    uint texture_base_E;
+    uint colorFactor;
+    float emissiveMult;
+    float selectPdf;
+    float aliasProb;
+    uint aliasIndex;
+    uint _pad0;
+    uint _pad1;
+};
+
 struct ShIndirectDrawCommand
 {
     uint indexCount;
@@ -379,6 +582,19 @@ struct ShLensFlareInstance
     float emissiveMult;
 };
 
+struct ShRasterizedDraw
+{
+    mat4 transform;
+    uint packedColor;
+    uint textureIndex;
+    uint emissiveTextureIndex;
+    float emissiveMult;
+    uint normalTextureIndex;
+    uint transformIsViewProj;
+    uint _pad0;
+    uint _pad1;
+};
+
 struct ShPortalInstance
 {
     vec4 inPosition;
@@ -387,6 +603,81 @@ struct ShPortalInstance
     vec4 outUp;
 };
 
+struct ShSkinVertex
+{
+    vec3 position;
+    uint normalPacked;
+    vec2 texCoord;
+    uint color;
+    uint jointsPacked;
+    uint weightsPacked;
+    uint _pad0;
+    uint _pad1;
+    uint _pad2;
+};
+
+struct ShSkinJob
+{
+    uint bindPoseOffset;
+    uint dstVertexIndex;
+    uint vertexCount;
+    uint boneOffset;
+};
+
+struct ShParticle
+{
+    vec3 position;
+    float size;
+    float rotation;
+    uint color;
+    uint frame;
+    uint _pad0;
+};
+
+struct ShVertPreprocItem
+{
+    uint tlasInstanceIndex;
+    uint firstTriangle;
+    uint __pad0;
+    uint __pad1;
+};
+
+struct ShTlasInstanceSource
+{
+    vec3 boundsCenter;
+    float boundsRadius;
+    uvec2 blasAddress;
+    uint customIndexAndMask;
+    uint sbtOffsetAndFlags;
+};
+
+struct ShParticleJob
+{
+    uint particleOffset;
+    uint dstVertexIndex;
+    uint particleCount;
+    uint flipbookColumns;
+    uint flipbookRows;
+    uint _pad0;
+    uint _pad1;
+    uint _pad2;
+    vec4 model_0;
+    vec4 model_1;
+    vec4 model_2;
+};
+
+struct ShIrradianceCacheCell
+{
+    uint checksum;
+    uint radianceE5;
+    uint sampleCount;
+    uint lastUsedFrame;
+    uint accumR;
+    uint accumG;
+    uint accumB;
+    uint accumCount;
+};
+
 #ifdef DESC_SET_FRAMEBUFFERS
 
 // framebuffer indices
@@ -421,53 +712,60 @@ struct ShPortalInstance
 #define FB_IMAGE_INDEX_UPSCALED_PING 28
 #define FB_IMAGE_INDEX_UPSCALED_PONG 29
 #define FB_IMAGE_INDEX_MOTION_DLSS 30
-#define FB_IMAGE_INDEX_REACTIVITY 31
-#define FB_IMAGE_INDEX_HUD_ONLY 32
-#define FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH 33
-#define FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH_PREV 34
-#define FB_IMAGE_INDEX_DIFF_TEMPORARY 35
-#define FB_IMAGE_INDEX_DIFF_ACCUM_COLOR 36
-#define FB_IMAGE_INDEX_DIFF_ACCUM_COLOR_PREV 37
-#define FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS 38
-#define FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS_PREV 39
-#define FB_IMAGE_INDEX_DIFF_COLOR_HISTORY 40
-#define FB_IMAGE_INDEX_DIFF_PING_COLOR_AND_VARIANCE 41
-#define FB_IMAGE_INDEX_DIFF_PONG_COLOR_AND_VARIANCE 42
-#define FB_IMAGE_INDEX_SPEC_ACCUM_COLOR 43
-#define FB_IMAGE_INDEX_SPEC_ACCUM_COLOR_PREV 44
-#define FB_IMAGE_INDEX_SPEC_PING_COLOR 45
-#define FB_IMAGE_INDEX_SPEC_PONG_COLOR 46
-#define FB_IMAGE_INDEX_INDIR_ACCUM 47
-#define FB_IMAGE_INDEX_INDIR_ACCUM_PREV 48
-#define FB_IMAGE_INDEX_INDIR_PING 49
-#define FB_IMAGE_INDEX_INDIR_PONG 50
-#define FB_IMAGE_INDEX_ATROUS_FILTERED_VARIANCE 51
-#define FB_IMAGE_INDEX_NORMAL_DECAL 52
-#define FB_IMAGE_INDEX_SCATTERING 53
-#define FB_IMAGE_INDEX_SCATTERING_PREV 54
-#define FB_IMAGE_INDEX_SCATTERING_HISTORY 55
-#define FB_IMAGE_INDEX_SCATTERING_HISTORY_PREV 56
-#define FB_IMAGE_INDEX_SCREEN_EMIS_R_T 57
-#define FB_IMAGE_INDEX_SCREEN_EMISSION 58
-#define FB_IMAGE_INDEX_BLOOM 59
-#define FB_IMAGE_INDEX_BLOOM_MIP1 60
-#define FB_IMAGE_INDEX_BLOOM_MIP2 61
-#define FB_IMAGE_INDEX_BLOOM_MIP3 62
-#define FB_IMAGE_INDEX_BLOOM_MIP4 63
-#define FB_IMAGE_INDEX_BLOOM_MIP5 64
-#define FB_IMAGE_INDEX_BLOOM_MIP6 65
-#define FB_IMAGE_INDEX_BLOOM_MIP7 66
-#define FB_IMAGE_INDEX_WIPE_EFFECT_SOURCE 67
-#define FB_IMAGE_INDEX_RESERVOIRS 68
-#define FB_IMAGE_INDEX_RESERVOIRS_PREV 69
-#define FB_IMAGE_INDEX_RESERVOIRS_INITIAL 70
-#define FB_IMAGE_INDEX_INDIRECT_RESERVOIRS_INITIAL 71
-#define FB_IMAGE_INDEX_GRADIENT_INPUTS 72
-#define FB_IMAGE_INDEX_GRADIENT_INPUTS_PREV 73
-#define FB_IMAGE_INDEX_D_I_S_PING_GRADIENT 74
-#define FB_IMAGE_INDEX_D_I_S_PONG_GRADIENT 75
-#define FB_IMAGE_INDEX_D_I_S_GRADIENT_HISTORY 76
-#define FB_IMAGE_INDEX_GRADIENT_PREV_PIX 77
+#define FB_IMAGE_INDEX_RAY_RECON_NORMAL_ROUGHNESS 31
+#define FB_IMAGE_INDEX_RAY_RECON_DIFFUSE_ALBEDO 32
+#define FB_IMAGE_INDEX_RAY_RECON_SPECULAR_ALBEDO 33
+#define FB_IMAGE_INDEX_REACTIVITY 34
+#define FB_IMAGE_INDEX_HUD_ONLY 35
+#define FB_IMAGE_INDEX_FRAME_GENERATED 36
+#define FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH 37
+#define FB_IMAGE_INDEX_ACCUM_HISTORY_LENGTH_PREV 38
+#define FB_IMAGE_INDEX_DIFF_TEMPORARY 39
+#define FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS 40
+#define FB_IMAGE_INDEX_DIFF_ACCUM_MOMENTS_PREV 41
+#define FB_IMAGE_INDEX_DIFF_COLOR_HISTORY 42
+#define FB_IMAGE_INDEX_DIFF_PING_COLOR_AND_VARIANCE 43
+#define FB_IMAGE_INDEX_DIFF_PONG_COLOR_AND_VARIANCE 44
+#define FB_IMAGE_INDEX_SPEC_ACCUM_COLOR 45
+#define FB_IMAGE_INDEX_SPEC_ACCUM_COLOR_PREV 46
+#define FB_IMAGE_INDEX_SPEC_PING_COLOR 47
+#define FB_IMAGE_INDEX_SPEC_PONG_COLOR 48
+#define FB_IMAGE_INDEX_INDIR_ACCUM 49
+#define FB_IMAGE_INDEX_INDIR_ACCUM_PREV 50
+#define FB_IMAGE_INDEX_INDIR_PING 51
+#define FB_IMAGE_INDEX_INDIR_PONG 52
+#define FB_IMAGE_INDEX_ATROUS_FILTERED_VARIANCE 53
+#define FB_IMAGE_INDEX_NORMAL_DECAL 54
+#define FB_IMAGE_INDEX_SCATTERING 55
+#define FB_IMAGE_INDEX_SCATTERING_PREV 56
+#define FB_IMAGE_INDEX_SCATTERING_HISTORY 57
+#define FB_IMAGE_INDEX_SCATTERING_HISTORY_PREV 58
+#define FB_IMAGE_INDEX_SCREEN_EMIS_R_T 59
+#define FB_IMAGE_INDEX_SCREEN_EMISSION 60
+#define FB_IMAGE_INDEX_BLOOM 61
+#define FB_IMAGE_INDEX_BLOOM_MIP1 62
+#define FB_IMAGE_INDEX_BLOOM_MIP2 63
+#define FB_IMAGE_INDEX_BLOOM_MIP3 64
+#define FB_IMAGE_INDEX_BLOOM_MIP4 65
+#define FB_IMAGE_INDEX_BLOOM_MIP5 66
+#define FB_IMAGE_INDEX_BLOOM_MIP6 67
+#define FB_IMAGE_INDEX_BLOOM_MIP7 68
+#define FB_IMAGE_INDEX_WIPE_EFFECT_SOURCE 69
+#define FB_IMAGE_INDEX_RESERVOIRS 70
+#define FB_IMAGE_INDEX_RESERVOIRS_PREV 71
+#define FB_IMAGE_INDEX_RESERVOIRS_INITIAL 72
+#define FB_IMAGE_INDEX_SUN_VISIBILITY 73
+#define FB_IMAGE_INDEX_SUN_VISIBILITY_PREV 74
+#define FB_IMAGE_INDEX_INDIRECT_RESERVOIRS_INITIAL 75
+#define FB_IMAGE_INDEX_SAMPLE_BUDGET 76
+#define FB_IMAGE_INDEX_GRADIENT_INPUTS 77
+#define FB_IMAGE_INDEX_GRADIENT_INPUTS_PREV 78
+#define FB_IMAGE_INDEX_D_I_S_PING_GRADIENT 79
+#define FB_IMAGE_INDEX_D_I_S_PONG_GRADIENT 80
+#define FB_IMAGE_INDEX_D_I_S_GRADIENT_HISTORY 81
+#define FB_IMAGE_INDEX_GRADIENT_PREV_PIX 82
+#define FB_IMAGE_INDEX_RAY_COST 83
+#define FB_IMAGE_INDEX_RAY_COST_ANY_HIT 84
 
 // framebuffers
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
@@ -500,7 +798,7 @@ layout(set = DESC_SET_FRAMEBUFFERS, binding = 22, rgba16f) uniform image2D frame
 layout(set = DESC_SET_FRAMEBUFFERS, binding = 23, rgba16f) uniform image2D framebufViewDirection_Prev;
 layout(set = DESC_SET_FRAMEBUFFERS, binding = 24, rgba32ui) uniform uimage2D framebufPrimaryToReflRefr;
 layout(set = DESC_SET_FRAMEBUFFERS, binding = 25, rgba16f) uniform image2D framebufThroughput;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 26, rgba16f) uniform image2D framebufPreFinal;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 26) uniform writeonly image2D framebufPreFinal;
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
 layout(set = DESC_SET_FRAMEBUFFERS, binding = 27, rgba16f) uniform image2D framebufFinal;
 #endif
@@ -511,159 +809,170 @@ layout(set = DESC_SET_FRAMEBUFFERS, binding = 28, rgba16f) uniform image2D frame
 layout(set = DESC_SET_FRAMEBUFFERS, binding = 29, rgba16f) uniform image2D framebufUpscaledPong;
 #endif
 layout(set = DESC_SET_FRAMEBUFFERS, binding = 30, rg16f) uniform image2D framebufMotionDlss;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 31, rgba16f) uniform image2D framebufRayReconNormalRoughness;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 32, r11f_g11f_b10f) uniform image2D framebufRayReconDiffuseAlbedo;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 33, r11f_g11f_b10f) uniform image2D framebufRayReconSpecularAlbedo;
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 31, r8) uniform image2D framebufReactivity;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 34, r8) uniform image2D framebufReactivity;
 #endif
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 32, rgba8) uniform image2D framebufHudOnly;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 35, rgba8) uniform image2D framebufHudOnly;
 #endif
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 33, rgba16f) uniform image2D framebufAccumHistoryLength;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 34, rgba16f) uniform image2D framebufAccumHistoryLength_Prev;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 35, r32ui) uniform uimage2D framebufDiffTemporary;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 36, r32ui) uniform uimage2D framebufDiffAccumColor;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 37, r32ui) uniform uimage2D framebufDiffAccumColor_Prev;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 38, rg16f) uniform image2D framebufDiffAccumMoments;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 39, rg16f) uniform image2D framebufDiffAccumMoments_Prev;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 40, rgba16f) uniform image2D framebufDiffColorHistory;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 41, rgba16f) uniform image2D framebufDiffPingColorAndVariance;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 42, rgba16f) uniform image2D framebufDiffPongColorAndVariance;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 43, r32ui) uniform uimage2D framebufSpecAccumColor;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 44, r32ui) uniform uimage2D framebufSpecAccumColor_Prev;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 45, r32ui) uniform uimage2D framebufSpecPingColor;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 46, r32ui) uniform uimage2D framebufSpecPongColor;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 47, r32ui) uniform uimage2D framebufIndirAccum;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 48, r32ui) uniform uimage2D framebufIndirAccum_Prev;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 49, r32ui) uniform uimage2D framebufIndirPing;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 50, r32ui) uniform uimage2D framebufIndirPong;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 51, r16f) uniform image2D framebufAtrousFilteredVariance;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 36, rgba16f) uniform image2D framebufFrameGenerated;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 37, rgba16f) uniform image2D framebufAccumHistoryLength;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 38, rgba16f) uniform image2D framebufAccumHistoryLength_Prev;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 39, r32ui) uniform uimage2D framebufDiffTemporary;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 40, rg16f) uniform image2D framebufDiffAccumMoments;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 41, rg16f) uniform image2D framebufDiffAccumMoments_Prev;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 42, rgba16f) uniform image2D framebufDiffColorHistory;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 43, rgba16f) uniform image2D framebufDiffPingColorAndVariance;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 44, rgba16f) uniform image2D framebufDiffPongColorAndVariance;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 45, r32ui) uniform uimage2D framebufSpecAccumColor;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 46, r32ui) uniform uimage2D framebufSpecAccumColor_Prev;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 47, r32ui) uniform uimage2D framebufSpecPingColor;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 48, r32ui) uniform uimage2D framebufSpecPongColor;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 49, r32ui) uniform uimage2D framebufIndirAccum;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 50, r32ui) uniform uimage2D framebufIndirAccum_Prev;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 51, r32ui) uniform uimage2D framebufIndirPing;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 52, r32ui) uniform uimage2D framebufIndirPong;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 53, r16f) uniform image2D framebufAtrousFilteredVariance;
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 52, r32ui) uniform uimage2D framebufNormalDecal;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 54, r32ui) uniform uimage2D framebufNormalDecal;
 #endif
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 53, rgba16f) uniform image2D framebufScattering;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 54, rgba16f) uniform image2D framebufScattering_Prev;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 55, r16f) uniform image2D framebufScatteringHistory;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 56, r16f) uniform image2D framebufScatteringHistory_Prev;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 57, r11f_g11f_b10f) uniform image2D framebufScreenEmisRT;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 55, rgba16f) uniform image2D framebufScattering;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 56, rgba16f) uniform image2D framebufScattering_Prev;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 57, r16f) uniform image2D framebufScatteringHistory;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 58, r16f) uniform image2D framebufScatteringHistory_Prev;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 59, r11f_g11f_b10f) uniform image2D framebufScreenEmisRT;
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 58, r11f_g11f_b10f) uniform image2D framebufScreenEmission;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 60, r11f_g11f_b10f) uniform image2D framebufScreenEmission;
 #endif
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 59, rgba16f) uniform image2D framebufBloom;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 60, rgba16f) uniform image2D framebufBloom_Mip1;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 61, rgba16f) uniform image2D framebufBloom_Mip2;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 62, rgba16f) uniform image2D framebufBloom_Mip3;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 63, rgba16f) uniform image2D framebufBloom_Mip4;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 64, rgba16f) uniform image2D framebufBloom_Mip5;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 65, rgba16f) uniform image2D framebufBloom_Mip6;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 66, rgba16f) uniform image2D framebufBloom_Mip7;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 67, rgba16f) uniform image2D framebufWipeEffectSource;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 68, rg32ui) uniform uimage2D framebufReservoirs;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 69, rg32ui) uniform uimage2D framebufReservoirs_Prev;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 70, rg32ui) uniform uimage2D framebufReservoirsInitial;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 71, rgba32ui) uniform uimage2D framebufIndirectReservoirsInitial;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 72, rg16f) uniform image2D framebufGradientInputs;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 73, rg16f) uniform image2D framebufGradientInputs_Prev;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 74, rgba8) uniform image2D framebufDISPingGradient;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 75, rgba8) uniform image2D framebufDISPongGradient;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 76, rgba8) uniform image2D framebufDISGradientHistory;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 77, r8ui) uniform uimage2D framebufGradientPrevPix;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 61) uniform writeonly image2D framebufBloom;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 62) uniform writeonly image2D framebufBloom_Mip1;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 63) uniform writeonly image2D framebufBloom_Mip2;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 64) uniform writeonly image2D framebufBloom_Mip3;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 65) uniform writeonly image2D framebufBloom_Mip4;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 66) uniform writeonly image2D framebufBloom_Mip5;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 67) uniform writeonly image2D framebufBloom_Mip6;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 68) uniform writeonly image2D framebufBloom_Mip7;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 69, rgba16f) uniform image2D framebufWipeEffectSource;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 70, rg32ui) uniform uimage2D framebufReservoirs;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 71, rg32ui) uniform uimage2D framebufReservoirs_Prev;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 72, rg32ui) uniform uimage2D framebufReservoirsInitial;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 73, rg8) uniform image2D framebufSunVisibility;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 74, rg8) uniform image2D framebufSunVisibility_Prev;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 75, rgba32ui) uniform uimage2D framebufIndirectReservoirsInitial;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 76, r8) uniform image2D framebufSampleBudget;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 77, rg16f) uniform image2D framebufGradientInputs;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 78, rg16f) uniform image2D framebufGradientInputs_Prev;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 79, rgba8) uniform image2D framebufDISPingGradient;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 80, rgba8) uniform image2D framebufDISPongGradient;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 81, rgba8) uniform image2D framebufDISGradientHistory;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 82, r8ui) uniform uimage2D framebufGradientPrevPix;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 83, r32ui) uniform uimage2D framebufRayCost;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 84, r32ui) uniform uimage2D framebufRayCostAnyHit;
 
 // samplers
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 78) uniform sampler2D framebufAlbedo_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 85) uniform sampler2D framebufAlbedo_Sampler;
 #endif
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 79) uniform usampler2D framebufIsSky_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 80) uniform usampler2D framebufNormal_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 81) uniform usampler2D framebufNormal_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 82) uniform sampler2D framebufMetallicRoughness_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 83) uniform sampler2D framebufMetallicRoughness_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 84) uniform sampler2D framebufDepthWorld_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 85) uniform sampler2D framebufDepthWorld_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 86) uniform sampler2D framebufDepthGrad_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 87) uniform sampler2D framebufDepthNdc_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 88) uniform sampler2D framebufDepthFluid_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 89) uniform sampler2D framebufDepthFluidTemp_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 86) uniform usampler2D framebufIsSky_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 87) uniform usampler2D framebufNormal_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 88) uniform usampler2D framebufNormal_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 89) uniform sampler2D framebufMetallicRoughness_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 90) uniform sampler2D framebufMetallicRoughness_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 91) uniform sampler2D framebufDepthWorld_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 92) uniform sampler2D framebufDepthWorld_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 93) uniform sampler2D framebufDepthGrad_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 94) uniform sampler2D framebufDepthNdc_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 95) uniform sampler2D framebufDepthFluid_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 96) uniform sampler2D framebufDepthFluidTemp_Sampler;
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 90) uniform usampler2D framebufFluidNormal_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 97) uniform usampler2D framebufFluidNormal_Sampler;
 #endif
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 91) uniform usampler2D framebufFluidNormalTemp_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 92) uniform sampler2D framebufMotion_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 93) uniform usampler2D framebufUnfilteredDirect_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 94) uniform usampler2D framebufUnfilteredSpecular_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 95) uniform usampler2D framebufUnfilteredIndir_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 96) uniform sampler2D framebufSurfacePosition_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 97) uniform sampler2D framebufSurfacePosition_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 98) uniform sampler2D framebufVisibilityBuffer_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 99) uniform sampler2D framebufVisibilityBuffer_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 100) uniform sampler2D framebufViewDirection_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 101) uniform sampler2D framebufViewDirection_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 102) uniform usampler2D framebufPrimaryToReflRefr_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 103) uniform sampler2D framebufThroughput_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 104) uniform sampler2D framebufPreFinal_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 98) uniform usampler2D framebufFluidNormalTemp_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 99) uniform sampler2D framebufMotion_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 100) uniform usampler2D framebufUnfilteredDirect_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 101) uniform usampler2D framebufUnfilteredSpecular_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 102) uniform usampler2D framebufUnfilteredIndir_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 103) uniform sampler2D framebufSurfacePosition_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 104) uniform sampler2D framebufSurfacePosition_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 105) uniform sampler2D framebufVisibilityBuffer_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 106) uniform sampler2D framebufVisibilityBuffer_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 107) uniform sampler2D framebufViewDirection_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 108) uniform sampler2D framebufViewDirection_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 109) uniform usampler2D framebufPrimaryToReflRefr_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 110) uniform sampler2D framebufThroughput_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 111) uniform sampler2D framebufPreFinal_Sampler;
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 105) uniform sampler2D framebufFinal_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 112) uniform sampler2D framebufFinal_Sampler;
 #endif
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 106) uniform sampler2D framebufUpscaledPing_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 113) uniform sampler2D framebufUpscaledPing_Sampler;
 #endif
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 107) uniform sampler2D framebufUpscaledPong_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 114) uniform sampler2D framebufUpscaledPong_Sampler;
 #endif
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 108) uniform sampler2D framebufMotionDlss_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 115) uniform sampler2D framebufMotionDlss_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 116) uniform sampler2D framebufRayReconNormalRoughness_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 117) uniform sampler2D framebufRayReconDiffuseAlbedo_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 118) uniform sampler2D framebufRayReconSpecularAlbedo_Sampler;
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 109) uniform sampler2D framebufReactivity_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 119) uniform sampler2D framebufReactivity_Sampler;
 #endif
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 110) uniform sampler2D framebufHudOnly_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 120) uniform sampler2D framebufHudOnly_Sampler;
 #endif
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 111) uniform sampler2D framebufAccumHistoryLength_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 112) uniform sampler2D framebufAccumHistoryLength_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 113) uniform usampler2D framebufDiffTemporary_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 114) uniform usampler2D framebufDiffAccumColor_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 115) uniform usampler2D framebufDiffAccumColor_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 116) uniform sampler2D framebufDiffAccumMoments_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 117) uniform sampler2D framebufDiffAccumMoments_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 118) uniform sampler2D framebufDiffColorHistory_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 119) uniform sampler2D framebufDiffPingColorAndVariance_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 120) uniform sampler2D framebufDiffPongColorAndVariance_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 121) uniform usampler2D framebufSpecAccumColor_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 122) uniform usampler2D framebufSpecAccumColor_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 123) uniform usampler2D framebufSpecPingColor_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 124) uniform usampler2D framebufSpecPongColor_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 125) uniform usampler2D framebufIndirAccum_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 126) uniform usampler2D framebufIndirAccum_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 127) uniform usampler2D framebufIndirPing_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 128) uniform usampler2D framebufIndirPong_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 129) uniform sampler2D framebufAtrousFilteredVariance_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 121) uniform sampler2D framebufAccumHistoryLength_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 122) uniform sampler2D framebufAccumHistoryLength_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 123) uniform usampler2D framebufDiffTemporary_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 124) uniform sampler2D framebufDiffAccumMoments_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 125) uniform sampler2D framebufDiffAccumMoments_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 126) uniform sampler2D framebufDiffColorHistory_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 127) uniform sampler2D framebufDiffPingColorAndVariance_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 128) uniform sampler2D framebufDiffPongColorAndVariance_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 129) uniform usampler2D framebufSpecAccumColor_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 130) uniform usampler2D framebufSpecAccumColor_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 131) uniform usampler2D framebufSpecPingColor_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 132) uniform usampler2D framebufSpecPongColor_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 133) uniform usampler2D framebufIndirAccum_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 134) uniform usampler2D framebufIndirAccum_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 135) uniform usampler2D framebufIndirPing_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 136) uniform usampler2D framebufIndirPong_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 137) uniform sampler2D framebufAtrousFilteredVariance_Sampler;
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 130) uniform usampler2D framebufNormalDecal_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 138) uniform usampler2D framebufNormalDecal_Sampler;
 #endif
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 131) uniform sampler2D framebufScattering_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 132) uniform sampler2D framebufScattering_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 133) uniform sampler2D framebufScatteringHistory_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 134) uniform sampler2D framebufScatteringHistory_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 135) uniform sampler2D framebufScreenEmisRT_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 139) uniform sampler2D framebufScattering_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 140) uniform sampler2D framebufScattering_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 141) uniform sampler2D framebufScatteringHistory_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 142) uniform sampler2D framebufScatteringHistory_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 143) uniform sampler2D framebufScreenEmisRT_Sampler;
 #ifndef FRAMEBUF_IGNORE_ATTACHMENTS
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 136) uniform sampler2D framebufScreenEmission_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 144) uniform sampler2D framebufScreenEmission_Sampler;
 #endif
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 137) uniform sampler2D framebufBloom_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 138) uniform sampler2D framebufBloom_Mip1_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 139) uniform sampler2D framebufBloom_Mip2_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 140) uniform sampler2D framebufBloom_Mip3_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 141) uniform sampler2D framebufBloom_Mip4_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 142) uniform sampler2D framebufBloom_Mip5_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 143) uniform sampler2D framebufBloom_Mip6_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 144) uniform sampler2D framebufBloom_Mip7_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 145) uniform sampler2D framebufWipeEffectSource_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 146) uniform usampler2D framebufReservoirs_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 147) uniform usampler2D framebufReservoirs_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 148) uniform usampler2D framebufReservoirsInitial_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 149) uniform usampler2D framebufIndirectReservoirsInitial_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 150) uniform sampler2D framebufGradientInputs_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 151) uniform sampler2D framebufGradientInputs_Prev_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 152) uniform sampler2D framebufDISPingGradient_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 153) uniform sampler2D framebufDISPongGradient_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 154) uniform sampler2D framebufDISGradientHistory_Sampler;
-layout(set = DESC_SET_FRAMEBUFFERS, binding = 155) uniform usampler2D framebufGradientPrevPix_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 145) uniform sampler2D framebufBloom_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 146) uniform sampler2D framebufBloom_Mip1_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 147) uniform sampler2D framebufBloom_Mip2_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 148) uniform sampler2D framebufBloom_Mip3_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 149) uniform sampler2D framebufBloom_Mip4_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 150) uniform sampler2D framebufBloom_Mip5_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 151) uniform sampler2D framebufBloom_Mip6_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 152) uniform sampler2D framebufBloom_Mip7_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 153) uniform sampler2D framebufWipeEffectSource_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 154) uniform usampler2D framebufReservoirs_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 155) uniform usampler2D framebufReservoirs_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 156) uniform usampler2D framebufReservoirsInitial_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 157) uniform sampler2D framebufSunVisibility_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 158) uniform sampler2D framebufSunVisibility_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 159) uniform usampler2D framebufIndirectReservoirsInitial_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 160) uniform sampler2D framebufSampleBudget_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 161) uniform sampler2D framebufGradientInputs_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 162) uniform sampler2D framebufGradientInputs_Prev_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 163) uniform sampler2D framebufDISPingGradient_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 164) uniform sampler2D framebufDISPongGradient_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 165) uniform sampler2D framebufDISGradientHistory_Sampler;
+layout(set = DESC_SET_FRAMEBUFFERS, binding = 166) uniform usampler2D framebufGradientPrevPix_Sampler;
 
 // pack/unpack formats
 void imageStoreUnfilteredDirect(const ivec2 pix, const vec3 unpacked) { imageStore(framebufUnfilteredDirect, pix, uvec4(encodeE5B9G9R9(unpacked))); }
@@ -678,10 +987,6 @@ vec3 texelFetchUnfilteredIndir(const ivec2 pix){ return decodeE5B9G9R9(texelFetc
 void imageStoreDiffTemporary(const ivec2 pix, const vec3 unpacked) { imageStore(framebufDiffTemporary, pix, uvec4(encodeE5B9G9R9(unpacked))); }
 vec3 texelFetchDiffTemporary(const ivec2 pix){ return decodeE5B9G9R9(texelFetch(framebufDiffTemporary_Sampler, pix, 0).r); }
 
-void imageStoreDiffAccumColor(const ivec2 pix, const vec3 unpacked) { imageStore(framebufDiffAccumColor, pix, uvec4(encodeE5B9G9R9(unpacked))); }
-vec3 texelFetchDiffAccumColor(const ivec2 pix){ return decodeE5B9G9R9(texelFetch(framebufDiffAccumColor_Sampler, pix, 0).r); }
-vec3 texelFetchDiffAccumColor_Prev(const ivec2 pix){ return decodeE5B9G9R9(texelFetch(framebufDiffAccumColor_Prev_Sampler, pix, 0).r); }
-
 void imageStoreSpecAccumColor(const ivec2 pix, const vec3 unpacked) { imageStore(framebufSpecAccumColor, pix, uvec4(encodeE5B9G9R9(unpacked))); }
 vec3 texelFetchSpecAccumColor(const ivec2 pix){ return decodeE5B9G9R9(texelFetch(framebufSpecAccumColor_Sampler, pix, 0).r); }
 vec3 texelFetchSpecAccumColor_Prev(const ivec2 pix){ return decodeE5B9G9R9(texelFetch(framebufSpecAccumColor_Prev_Sampler, pix, 0).r); }
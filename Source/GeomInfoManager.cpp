@@ -27,18 +27,26 @@
 #include "VertexCollectorFilterType.h"
 #include "Generated/ShaderCommonC.h"
 #include "CmdLabel.h"
+#include "CpuProfiler.h"
 #include "Utils.h"
 
 #include <ranges>
 
 static_assert( sizeof( RTGL1::ShGeometryInstance ) % 16 == 0,
                "Std430 structs must be aligned by 16 bytes" );
+static_assert( sizeof( RTGL1::ShGeometryInstancePrev ) % 16 == 0,
+               "Std430 structs must be aligned by 16 bytes" );
+static_assert( sizeof( RTGL1::ShGeometryMaterial ) % 16 == 0,
+               "Std430 structs must be aligned by 16 bytes" );
 
 namespace
 {
 
 constexpr auto MatchPrevInvalidValue = RTGL1::GeomInfoManager::MatchPrevIndexType{ -1 };
 
+constexpr uint32_t DefaultMaterialIndex = 0;
+constexpr uint32_t NoMaterialIndex      = UINT32_MAX;
+
 #if !SUPPRESS_TEXLAYERS
 uint32_t GetMaterialBlendFlags( const RgTextureLayerBlendType* blend, uint32_t layerIndex )
 {
@@ -205,25 +213,57 @@ uint32_t RTGL1::GeomInfoManager::GetPrimitiveFlags( const RgMeshInfo*          m
 }
 
 RTGL1::GeomInfoManager::GeomInfoManager( VkDevice                            _device,
-                                         std::shared_ptr< MemoryAllocator >& _allocator )
-    : device( _device )
+                                         std::shared_ptr< MemoryAllocator >& _allocator,
+                                         uint32_t                            _maxGeomInfoCount )
+    : device( _device ), maxCount( _maxGeomInfoCount )
 {
-    buffer    = std::make_shared< AutoBuffer >( _allocator );
-    matchPrev = std::make_shared< AutoBuffer >( _allocator );
+    buffer          = std::make_shared< AutoBuffer >( _allocator );
+    prevBuffer      = std::make_shared< AutoBuffer >( _allocator );
+    materialsBuffer = std::make_shared< AutoBuffer >( _allocator );
+    matchPrev       = std::make_shared< AutoBuffer >( _allocator );
 
-    buffer->Create( MAX_GEOM_INFO_COUNT * sizeof( ShGeometryInstance ),
+    buffer->Create( VkDeviceSize{ maxCount } * sizeof( ShGeometryInstance ),
                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                     "Geometry info buffer" );
 
-    matchPrev->Create( MAX_GEOM_INFO_COUNT * sizeof( MatchPrevIndexType ),
+    prevBuffer->Create( VkDeviceSize{ maxCount } * sizeof( ShGeometryInstancePrev ),
+                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                        "Geometry info prev buffer" );
+
+    materialsBuffer->Create( VkDeviceSize{ maxCount } * sizeof( ShGeometryMaterial ),
+                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                             "Geometry materials buffer" );
+
+    matchPrev->Create( VkDeviceSize{ maxCount } * sizeof( MatchPrevIndexType ),
                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                        "Match previous Geometry infos buffer" );
-    matchPrevShadow = std::make_unique< MatchPrevIndexType[] >( MAX_GEOM_INFO_COUNT );
+    matchPrevShadow = std::make_unique< MatchPrevIndexType[] >( maxCount );
 
-    for( int i = 0; i < MAX_GEOM_INFO_COUNT; i++ )
+    for( uint32_t i = 0; i < maxCount; i++ )
     {
         matchPrevShadow[ i ] = MatchPrevInvalidValue;
     }
+
+    // fallback, if there's no space for a new material
+    materials.push_back( ShGeometryMaterial{
+        .texture_base                     = MATERIAL_NO_TEXTURE,
+        .texture_base_ORM                 = MATERIAL_NO_TEXTURE,
+        .texture_base_N                   = MATERIAL_NO_TEXTURE,
+        .texture_base_E                   = MATERIAL_NO_TEXTURE,
+        .texture_base_D                   = MATERIAL_NO_TEXTURE,
+        .texture_layer1                   = MATERIAL_NO_TEXTURE,
+        .texture_layer2                   = MATERIAL_NO_TEXTURE,
+        .texture_layer3                   = MATERIAL_NO_TEXTURE,
+        .colorFactor_base                 = Utils::PackColor( 255, 255, 255, 255 ),
+        .colorFactor_layer1               = Utils::PackColor( 255, 255, 255, 255 ),
+        .colorFactor_layer2               = Utils::PackColor( 255, 255, 255, 255 ),
+        .colorFactor_layer3               = Utils::PackColor( 255, 255, 255, 255 ),
+        .roughnessDefault_metallicDefault = 255,
+        .emissiveMult                     = 0.0f,
+    } );
+    materialRefCounts.push_back( 1 );
+    materialsDirty.add( DefaultMaterialIndex );
+    static_assert( DefaultMaterialIndex == 0 );
 }
 
 bool RTGL1::GeomInfoManager::CopyFromStaging( VkCommandBuffer    cmd,
@@ -235,44 +275,38 @@ bool RTGL1::GeomInfoManager::CopyFromStaging( VkCommandBuffer    cmd,
 
     auto matchprev_range = CopyRange{};
     auto geominfo_range  = CopyRange{};
+    auto material_range  = std::exchange( materialsDirty, CopyRange{} );
 
 
-    auto prevIndexToCurIndexArr = static_cast< MatchPrevIndexType* >( matchPrevShadow.get() );
-    {
-        for( const auto& [ uniqueID, prev ] : tlas_prev )
-        {
-            MatchPrevIndexType src;
-            {
-                auto foundCurrentIdOfPrev = tlas.find( uniqueID );
-                if( foundCurrentIdOfPrev != tlas.end() )
-                {
-                    // save index to access ShGeometryInfo using a previous frame's TLAS Instance ID
-                    src = MatchPrevIndexType( foundCurrentIdOfPrev->second );
-                }
-                else
-                {
-                    // if existed in prev frame, but not in the current, invalidate
-                    src = MatchPrevInvalidValue;
-                }
-            }
+    auto newTlasPrev = std::vector< PrevTlasInstance >{};
+    newTlasPrev.reserve( tlas.size() );
 
-            prevIndexToCurIndexArr[ prev ] = src;
-            matchprev_range.add( prev );
-        }
-    }
+    preprocessCandidates.clear();
 
-    auto geomInfos = buffer->GetMappedAs< ShGeometryInstance* >( frameIndex );
+    auto geomInfos     = buffer->GetMappedAs< ShGeometryInstance* >( frameIndex );
+    auto geomInfosPrev = prevBuffer->GetMappedAs< ShGeometryInstancePrev* >( frameIndex );
     {
         for( const auto& [ uniqueID, tlasInstanceID ] : tlas )
         {
-            const ShGeometryInstance* src;
+            const ShGeometryInstance*     src;
+            const ShGeometryInstancePrev* srcPrev;
             {
-                auto found = curFrame_IdToInfo.find( uniqueID );
-                if( found != curFrame_IdToInfo.end() )
+                auto found = idToSlot.find( uniqueID );
+                if( found != idToSlot.end() && slots[ found->second ].hasCurInfo )
                 {
-                    static_assert(
-                        std::is_same_v< ShGeometryInstance, decltype( found->second ) > );
-                    src = &found->second;
+                    Slot& slot = slots[ found->second ];
+
+                    src     = &slot.curInfo;
+                    srcPrev = &slot.curPrev;
+
+                    slot.tlasInstanceID = tlasInstanceID;
+                    slot.tlasFrame      = frameCounter;
+
+                    newTlasPrev.push_back( PrevTlasInstance{
+                        .tlasInstanceID = tlasInstanceID,
+                        .slot           = found->second,
+                        .generation     = slot.generation,
+                    } );
                 }
                 else
                 {
@@ -280,18 +314,64 @@ bool RTGL1::GeomInfoManager::CopyFromStaging( VkCommandBuffer    cmd,
                     debug::Error( "ShGeometryInstance was not registered for {}-{}",
                                   uniqueID.objectId,
                                   uniqueID.primitiveIndex );
-                    constexpr static auto null{ ShGeometryInstance{} };
-                    src = &null;
+                    constexpr static auto null{ ShGeometryInstance{
+                        .materialIndex = DefaultMaterialIndex,
+                    } };
+                    constexpr static auto nullPrev{ ShGeometryInstancePrev{
+                        .prevBaseVertexIndex = UINT32_MAX,
+                        .prevBaseIndexIndex  = UINT32_MAX,
+                    } };
+                    src     = &null;
+                    srcPrev = &nullPrev;
                 }
             }
 
             memcpy( &geomInfos[ tlasInstanceID ], src, sizeof( ShGeometryInstance ) );
+            memcpy( &geomInfosPrev[ tlasInstanceID ], srcPrev, sizeof( ShGeometryInstancePrev ) );
             geominfo_range.add( tlasInstanceID );
+
+            // only normal generation is done in vertex preprocessing
+            if( ( src->flags & GEOM_INST_FLAG_GENERATE_NORMALS ) &&
+                !( src->flags & GEOM_INST_FLAG_EXACT_NORMALS ) )
+            {
+                const uint32_t triangleCount =
+                    ( src->baseIndexIndex != UINT32_MAX ? src->indexCount : src->vertexCount ) / 3;
+
+                if( triangleCount > 0 )
+                {
+                    preprocessCandidates.push_back( PreprocessCandidate{
+                        .tlasInstanceID = tlasInstanceID,
+                        .triangleCount  = triangleCount,
+                        .isDynamic      = ( src->flags & GEOM_INST_FLAG_IS_DYNAMIC ) != 0,
+                    } );
+                }
+            }
+        }
+    }
+
+
+    auto prevIndexToCurIndexArr = static_cast< MatchPrevIndexType* >( matchPrevShadow.get() );
+    {
+        // current TLAS instance IDs are already in the slots, so no lookups
+        for( const PrevTlasInstance& prev : tlas_prev )
+        {
+            const Slot& slot = slots[ prev.slot ];
+
+            // save index to access ShGeometryInfo using a previous frame's TLAS Instance ID;
+            // if existed in prev frame, but not in the current, invalidate
+            const MatchPrevIndexType src =
+                slot.generation == prev.generation && slot.tlasFrame == frameCounter
+                    ? MatchPrevIndexType( slot.tlasInstanceID )
+                    : MatchPrevInvalidValue;
+
+            prevIndexToCurIndexArr[ prev.tlasInstanceID ] = src;
+            matchprev_range.add( prev.tlasInstanceID );
         }
     }
 
 
-    tlas_prev = std::move( tlas );
+    tlas_prev = std::move( newTlasPrev );
+    tlas.clear();
 
 
     if( matchprev_range.valid() )
@@ -328,6 +408,35 @@ bool RTGL1::GeomInfoManager::CopyFromStaging( VkCommandBuffer    cmd,
 
         // TODO: remove VkBufferMemoryBarrier from CopyFromStaging and add barrier here
         buffer->CopyFromStaging( cmd, frameIndex, &vcopy, 1 );
+
+        auto vcopyPrev = VkBufferCopy{
+            .srcOffset = geominfo_range.first() * sizeof( ShGeometryInstancePrev ),
+            .dstOffset = geominfo_range.first() * sizeof( ShGeometryInstancePrev ),
+            .size      = geominfo_range.count() * sizeof( ShGeometryInstancePrev ),
+        };
+
+        prevBuffer->CopyFromStaging( cmd, frameIndex, &vcopyPrev, 1 );
+    }
+
+    if( material_range.valid() )
+    {
+        // copy to staging, only changed materials
+        {
+            auto dst = materialsBuffer->GetMappedAs< ShGeometryMaterial* >( frameIndex );
+
+            memcpy( &dst[ material_range.first() ],
+                    &materials[ material_range.first() ],
+                    material_range.count() * sizeof( ShGeometryMaterial ) );
+        }
+
+        // copy from staging
+        auto vcopy = VkBufferCopy{
+            .srcOffset = material_range.first() * sizeof( ShGeometryMaterial ),
+            .dstOffset = material_range.first() * sizeof( ShGeometryMaterial ),
+            .size      = material_range.count() * sizeof( ShGeometryMaterial ),
+        };
+
+        materialsBuffer->CopyFromStaging( cmd, frameIndex, &vcopy, 1 );
     }
 
     return true;
@@ -335,83 +444,259 @@ bool RTGL1::GeomInfoManager::CopyFromStaging( VkCommandBuffer    cmd,
 
 void RTGL1::GeomInfoManager::ResetOnlyStatic()
 {
-    for( const auto& idToErase : staticUniqueIds )
+    // also clears history, as generation is changed
+    for( uint32_t slot : staticSlots )
     {
-        curFrame_IdToInfo.erase( idToErase );
+        FreeSlot( slot );
+    }
+    staticSlots.clear();
+}
+
+void RTGL1::GeomInfoManager::PrepareForFrame( uint32_t frameIndex )
+{
+    frameCounter++;
 
-        // clear history
-        for( auto& h : idToPrevInfo )
+    // reset only dynamic
+    for( uint32_t slot : dynamicSlots[ Utils::PrevFrame( frameIndex ) ] )
+    {
+        slots[ slot ].hasCurInfo = false;
+    }
+
+    // clear history at N-2
+    for( uint32_t slot : dynamicSlots[ frameIndex ] )
+    {
+        prevInfos[ frameIndex ][ slot ].generation = UINT32_MAX;
+
+        // if wasn't uploaded in the previous frame, it has no history anymore
+        if( slots[ slot ].lastWrittenFrame + 2 <= frameCounter )
         {
-            h.erase( idToErase );
+            FreeSlot( slot );
         }
     }
-    assert( std::ranges::any_of( dynamicUniqueIds, [ & ]( const auto& oneof_dynamicUniqueIds ) {
-        return curFrame_IdToInfo.size() == oneof_dynamicUniqueIds.size();
-    } ) );
+    dynamicSlots[ frameIndex ].clear();
+}
 
-    staticUniqueIds.clear();
+uint32_t RTGL1::GeomInfoManager::AcquireSlot( const PrimitiveUniqueID& geomUniqueID,
+                                              bool                     isStatic )
+{
+    auto [ iter, isnew ] = idToSlot.try_emplace( geomUniqueID, 0 );
+    if( !isnew )
+    {
+        return iter->second;
+    }
+
+    uint32_t slot;
+    if( !freeSlots.empty() )
+    {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+
+        slots[ slot ].uniqueID = geomUniqueID;
+    }
+    else
+    {
+        slot = static_cast< uint32_t >( slots.size() );
+
+        slots.push_back( Slot{
+            .uniqueID         = geomUniqueID,
+            .generation       = 0,
+            .isStatic         = false,
+            .hasCurInfo       = false,
+            .noMotionVectors  = false,
+            .curInfo          = { .materialIndex = NoMaterialIndex },
+            .curPrev          = {},
+            .lastWrittenFrame = 0,
+            .tlasInstanceID   = 0,
+            .tlasFrame        = 0,
+        } );
+        for( auto& h : prevInfos )
+        {
+            h.push_back( PrevInfo{ .generation = UINT32_MAX } );
+        }
+    }
+
+    slots[ slot ].isStatic = isStatic;
+    iter->second           = slot;
+    return slot;
 }
 
-void RTGL1::GeomInfoManager::PrepareForFrame( uint32_t frameIndex )
+void RTGL1::GeomInfoManager::FreeSlot( uint32_t slot )
 {
-    // reset only dynamic
-    for( const auto& idToErase : dynamicUniqueIds[ Utils::PrevFrame( frameIndex ) ] )
+    Slot& s = slots[ slot ];
+
+    idToSlot.erase( s.uniqueID );
+
+    ReleaseMaterial( s.curInfo.materialIndex );
+    s.curInfo.materialIndex = NoMaterialIndex;
+
+    s.generation++;
+    s.hasCurInfo = false;
+    freeSlots.push_back( slot );
+}
+
+auto RTGL1::GeomInfoManager::FindStaticSlot( const PrimitiveUniqueID& geomUniqueID ) -> Slot*
+{
+    auto found = idToSlot.find( geomUniqueID );
+    if( found == idToSlot.end() || !slots[ found->second ].isStatic )
     {
-        curFrame_IdToInfo.erase( idToErase );
+        return nullptr;
     }
-    assert( curFrame_IdToInfo.size() == staticUniqueIds.size() );
+    return &slots[ found->second ];
+}
 
-    // clear history at N-2
-    for( const auto& idToErase : dynamicUniqueIds[ frameIndex ] )
+uint32_t RTGL1::GeomInfoManager::AcquireMaterial( const ShGeometryMaterial& material )
+{
+    auto [ iter, isnew ] = materialToIndex.try_emplace( material, 0 );
+    if( !isnew )
     {
-        idToPrevInfo[ frameIndex ].erase( idToErase );
+        materialRefCounts[ iter->second ]++;
+        return iter->second;
     }
-    dynamicUniqueIds[ frameIndex ].clear();
+
+    uint32_t index;
+    if( !freeMaterials.empty() )
+    {
+        index = freeMaterials.back();
+        freeMaterials.pop_back();
+    }
+    else if( materials.size() < maxCount )
+    {
+        index = static_cast< uint32_t >( materials.size() );
+
+        materials.emplace_back();
+        materialRefCounts.push_back( 0 );
+    }
+    else
+    {
+        debug::Error( "Geometry material table is full, max is {}", maxCount );
+        materialToIndex.erase( iter );
+        return DefaultMaterialIndex;
+    }
+
+    materials[ index ]         = material;
+    materialRefCounts[ index ] = 1;
+    iter->second               = index;
+
+    materialsDirty.add( index );
+    return index;
 }
 
-void RTGL1::GeomInfoManager::WriteGeomInfo( uint32_t                 frameIndex,
-                                            const PrimitiveUniqueID& geomUniqueID,
-                                            ShGeometryInstance&      src,
-                                            bool                     isStatic,
-                                            bool                     noMotionVectors )
+void RTGL1::GeomInfoManager::ReleaseMaterial( uint32_t materialIndex )
 {
+    if( materialIndex == NoMaterialIndex || materialIndex == DefaultMaterialIndex )
+    {
+        return;
+    }
+
+    assert( materialRefCounts[ materialIndex ] > 0 );
+    if( --materialRefCounts[ materialIndex ] > 0 )
+    {
+        return;
+    }
+
+    // a patched material might have a duplicate in the map
+    auto found = materialToIndex.find( materials[ materialIndex ] );
+    if( found != materialToIndex.end() && found->second == materialIndex )
+    {
+        materialToIndex.erase( found );
+    }
+    freeMaterials.push_back( materialIndex );
+}
+
+void RTGL1::GeomInfoManager::WriteGeomInfo( uint32_t                  frameIndex,
+                                            const PrimitiveUniqueID&  geomUniqueID,
+                                            ShGeometryInstance&       src,
+                                            const ShGeometryMaterial& material,
+                                            bool                      isStatic,
+                                            bool                      noMotionVectors )
+{
+    RG_CPU_ZONE( "GeomInfoManager::WriteGeomInfo" );
+
     // must be aligned for per-triangle vertex attributes
     assert( src.baseVertexIndex % 3 == 0 );
     assert( src.baseIndexIndex % 3 == 0 );
 
     assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
 
+    const uint32_t slot = AcquireSlot( geomUniqueID, isStatic );
+
+    // IDs must be unique
+    assert( !slots[ slot ].hasCurInfo );
+    ( isStatic ? staticSlots : dynamicSlots[ frameIndex ] ).push_back( slot );
+
+    const auto srcPrev =
+        MakePrev( FindPrevFrameData( slot, src, frameIndex, noMotionVectors ), src );
+
+    // register
     {
-        auto& dstIDs = isStatic ? staticUniqueIds : dynamicUniqueIds[ frameIndex ];
+        Slot& dst = slots[ slot ];
+
+        // acquire first, so the same material is not freed and added again
+        const uint32_t oldMaterial = dst.curInfo.materialIndex;
+        src.materialIndex          = AcquireMaterial( material );
+        ReleaseMaterial( oldMaterial );
 
-        auto [ iter, isnew ] = dstIDs.insert( geomUniqueID );
-        assert( isnew );
+        dst.curInfo          = src;
+        dst.curPrev          = srcPrev;
+        dst.hasCurInfo       = true;
+        dst.noMotionVectors  = noMotionVectors;
+        dst.lastWrittenFrame = frameCounter;
     }
 
-    if( auto prev = FindPrevFrameData( geomUniqueID, src, frameIndex, noMotionVectors ) )
+    WritePrevForNextFrame( slot, src, frameIndex );
+}
+
+void RTGL1::GeomInfoManager::PatchGeometry( uint32_t                  frameIndex,
+                                            const PrimitiveUniqueID&  geomUniqueID,
+                                            const ShGeometryInstance& geometry )
+{
+    auto found = idToSlot.find( geomUniqueID );
+    if( found == idToSlot.end() || !slots[ found->second ].hasCurInfo )
     {
-        // copy data from previous frame to current ShGeometryInstance
-        src.prevBaseVertexIndex = prev->baseVertexIndex;
-        src.prevBaseIndexIndex  = prev->baseIndexIndex;
-        static_assert( sizeof( src.prevModel_0 ) == sizeof( float ) * 4 );
-        static_assert( sizeof( prev->model_0 ) == sizeof( float ) * 4 );
-        memcpy( src.prevModel_0, prev->model_0, sizeof( src.prevModel_0 ) );
-        memcpy( src.prevModel_1, prev->model_1, sizeof( src.prevModel_1 ) );
-        memcpy( src.prevModel_2, prev->model_2, sizeof( src.prevModel_2 ) );
+        debug::Error( "Failed to patch geometry of geominfo: "
+                      "info with specified ID was not uploaded" );
+        return;
     }
-    else
+
+    const uint32_t slot = found->second;
+    Slot&          s    = slots[ slot ];
     {
-        // no prev
-        src.prevBaseVertexIndex = UINT32_MAX;
+        ShGeometryInstance& dst = s.curInfo;
+
+        constexpr uint32_t geometryFlags =
+            GEOM_INST_FLAG_INDICES_16BIT | GEOM_INST_FLAG_QUANTIZED_VERTICES;
+
+        dst.flags = ( dst.flags & ~( geometryFlags | GEOM_INST_FLAG_PREV_INDICES_16BIT ) ) |
+                    ( geometry.flags & geometryFlags );
+
+        dst.baseVertexIndex    = geometry.baseVertexIndex;
+        dst.baseIndexIndex     = geometry.baseIndexIndex;
+        dst.vertexCount        = geometry.vertexCount;
+        dst.indexCount         = geometry.indexCount;
+        dst.firstVertex_Layer1 = geometry.firstVertex_Layer1;
+        dst.firstVertex_Layer2 = geometry.firstVertex_Layer2;
+        dst.firstVertex_Layer3 = geometry.firstVertex_Layer3;
+
+        memcpy( dst.vertexBufferAddress,
+                geometry.vertexBufferAddress,
+                sizeof( dst.vertexBufferAddress ) );
+        memcpy(
+            dst.indexBufferAddress, geometry.indexBufferAddress, sizeof( dst.indexBufferAddress ) );
+        memcpy( dst.dequantCenter, geometry.dequantCenter, sizeof( dst.dequantCenter ) );
+        memcpy( dst.dequantExtent, geometry.dequantExtent, sizeof( dst.dequantExtent ) );
     }
 
-    // register
+    // static geometry doesn't have the previous frame's data
+    if( s.isStatic )
     {
-        assert( !curFrame_IdToInfo.contains( geomUniqueID ) );
-        curFrame_IdToInfo[ geomUniqueID ] = src;
+        s.curPrev = MakePrev( nullptr, s.curInfo );
+        return;
     }
 
-    WritePrevForNextFrame( geomUniqueID, src, frameIndex );
+    // previous frame's data is valid only if it was of the same geometry
+    s.curPrev = MakePrev( FindPrevFrameData( slot, s.curInfo, frameIndex, s.noMotionVectors ),
+                          s.curInfo );
+    WritePrevForNextFrame( slot, s.curInfo, frameIndex );
 }
 
 void RTGL1::GeomInfoManager::Hack_PatchGeomInfoTexturesForStatic(
@@ -422,54 +707,73 @@ void RTGL1::GeomInfoManager::Hack_PatchGeomInfoTexturesForStatic(
     uint32_t                 texture_base_E,
     uint32_t                 texture_base_D )
 {
+    Slot* f = FindStaticSlot( geomUniqueID );
+    if( !f )
     {
-        const auto f = staticUniqueIds.find( geomUniqueID );
-        if( f == staticUniqueIds.end() )
-        {
-            debug::Error( "Failed to patch textures for static geominfo: ID is not for static" );
-            return;
-        }
+        debug::Error( "Failed to patch textures for static geominfo: ID is not for static" );
+        return;
     }
 
-    const auto f = curFrame_IdToInfo.find( geomUniqueID );
-    if( f == curFrame_IdToInfo.end() )
+    if( !f->hasCurInfo )
     {
         debug::Error( "Failed to patch textures for static geominfo: "
                       "info with specified ID was not uploaded" );
         return;
     }
 
-    ShGeometryInstance& dst = f->second;
+    const uint32_t materialIndex = f->curInfo.materialIndex;
+
+    ShGeometryMaterial patched = materials[ materialIndex ];
+    {
+        patched.texture_base     = texture_base;
+        patched.texture_base_ORM = texture_base_ORM;
+        patched.texture_base_N   = texture_base_N;
+        patched.texture_base_E   = texture_base_E;
+        patched.texture_base_D   = texture_base_D;
+    }
+
+    // already patched through another geometry that shares the material
+    if( MaterialEqual{}( patched, materials[ materialIndex ] ) )
+    {
+        return;
+    }
+
+    if( materialIndex == DefaultMaterialIndex )
+    {
+        f->curInfo.materialIndex = AcquireMaterial( patched );
+        return;
+    }
+
+    // patch in-place, so all geometries that reference the material are updated at once
+    auto found = materialToIndex.find( materials[ materialIndex ] );
+    if( found != materialToIndex.end() && found->second == materialIndex )
     {
-        dst.texture_base     = texture_base;
-        dst.texture_base_ORM = texture_base_ORM;
-        dst.texture_base_N   = texture_base_N;
-        dst.texture_base_E   = texture_base_E;
-        dst.texture_base_D   = texture_base_D;
+        materialToIndex.erase( found );
     }
+    materialToIndex.try_emplace( patched, materialIndex );
+
+    materials[ materialIndex ] = patched;
+    materialsDirty.add( materialIndex );
 }
 
 void RTGL1::GeomInfoManager::Hack_PatchGeomInfoTransformForStatic(
     const PrimitiveUniqueID& geomUniqueID, const RgTransform& transform )
 {
+    Slot* f = FindStaticSlot( geomUniqueID );
+    if( !f )
     {
-        const auto f = staticUniqueIds.find( geomUniqueID );
-        if( f == staticUniqueIds.end() )
-        {
-            debug::Warning( "Failed to patch transform for static geominfo: ID is not for static" );
-            return;
-        }
+        debug::Warning( "Failed to patch transform for static geominfo: ID is not for static" );
+        return;
     }
 
-    const auto f = curFrame_IdToInfo.find( geomUniqueID );
-    if( f == curFrame_IdToInfo.end() )
+    if( !f->hasCurInfo )
     {
         debug::Error( "Failed to patch transform for static geominfo: "
                       "info with specified ID was not uploaded" );
         return;
     }
 
-    ShGeometryInstance& dst = f->second;
+    ShGeometryInstance& dst = f->curInfo;
     {
         static_assert( sizeof( dst.model_0 ) == sizeof( transform.matrix[ 0 ] ) );
         static_assert( sizeof( dst.model_1 ) == sizeof( transform.matrix[ 1 ] ) );
@@ -481,7 +785,7 @@ void RTGL1::GeomInfoManager::Hack_PatchGeomInfoTransformForStatic(
     }
 }
 
-auto RTGL1::GeomInfoManager::FindPrevFrameData( const PrimitiveUniqueID&  geomUniqueID,
+auto RTGL1::GeomInfoManager::FindPrevFrameData( uint32_t                  slot,
                                                 const ShGeometryInstance& target,
                                                 uint32_t                  frameIndex,
                                                 bool noMotionVectors ) const -> const PrevInfo*
@@ -491,15 +795,13 @@ auto RTGL1::GeomInfoManager::FindPrevFrameData( const PrimitiveUniqueID&  geomUn
         return nullptr;
     }
 
-    auto& idToInfo_prev = idToPrevInfo[ Utils::PrevFrame( frameIndex ) ];
+    const PrevInfo& prev = prevInfos[ Utils::PrevFrame( frameIndex ) ][ slot ];
 
     // if geomUniqueId existed in prev frame
-    auto iter = idToInfo_prev.find( geomUniqueID );
-    if( iter == idToInfo_prev.end() )
+    if( prev.generation != slots[ slot ].generation )
     {
         return nullptr;
     }
-    auto& prev = iter->second;
 
     // if counts are not the same
     if( prev.vertexCount != target.vertexCount || prev.indexCount != target.indexCount )
@@ -511,22 +813,49 @@ auto RTGL1::GeomInfoManager::FindPrevFrameData( const PrimitiveUniqueID&  geomUn
 }
 
 
-void RTGL1::GeomInfoManager::WritePrevForNextFrame( const PrimitiveUniqueID&  geomUniqueID,
-                                                    const ShGeometryInstance& src,
-                                                    uint32_t                  frameIndex )
+auto RTGL1::GeomInfoManager::MakePrev( const PrevInfo* prev, ShGeometryInstance& src )
+    -> ShGeometryInstancePrev
 {
-    auto& idToInfo_cur = idToPrevInfo[ frameIndex ];
+    auto srcPrev = ShGeometryInstancePrev{};
 
-    // IDs must be unique
-    assert( !idToInfo_cur.contains( geomUniqueID ) );
+    if( prev )
+    {
+        // copy data from previous frame
+        srcPrev.prevBaseVertexIndex = prev->baseVertexIndex;
+        srcPrev.prevBaseIndexIndex  = prev->baseIndexIndex;
+        if( prev->flags & GEOM_INST_FLAG_INDICES_16BIT )
+        {
+            src.flags |= GEOM_INST_FLAG_PREV_INDICES_16BIT;
+        }
+        static_assert( sizeof( srcPrev.prevModel_0 ) == sizeof( float ) * 4 );
+        static_assert( sizeof( prev->model_0 ) == sizeof( float ) * 4 );
+        memcpy( srcPrev.prevModel_0, prev->model_0, sizeof( srcPrev.prevModel_0 ) );
+        memcpy( srcPrev.prevModel_1, prev->model_1, sizeof( srcPrev.prevModel_1 ) );
+        memcpy( srcPrev.prevModel_2, prev->model_2, sizeof( srcPrev.prevModel_2 ) );
+    }
+    else
+    {
+        // no prev
+        srcPrev.prevBaseVertexIndex = UINT32_MAX;
+        srcPrev.prevBaseIndexIndex  = UINT32_MAX;
+    }
 
-    auto& dst = idToInfo_cur[ geomUniqueID ];
+    return srcPrev;
+}
+
+void RTGL1::GeomInfoManager::WritePrevForNextFrame( uint32_t                  slot,
+                                                    const ShGeometryInstance& src,
+                                                    uint32_t                  frameIndex )
+{
+    auto& dst = prevInfos[ frameIndex ][ slot ];
     {
         dst = PrevInfo{
             .baseVertexIndex = src.baseVertexIndex,
             .baseIndexIndex  = src.baseIndexIndex,
             .vertexCount     = src.vertexCount,
             .indexCount      = src.indexCount,
+            .flags           = src.flags,
+            .generation      = slots[ slot ].generation,
         };
         static_assert( sizeof dst.model_0 == sizeof( float ) * 4 );
         static_assert( sizeof src.model_0 == sizeof( float ) * 4 );
@@ -541,6 +870,16 @@ VkBuffer RTGL1::GeomInfoManager::GetBuffer() const
     return buffer->GetDeviceLocal();
 }
 
+VkBuffer RTGL1::GeomInfoManager::GetPrevBuffer() const
+{
+    return prevBuffer->GetDeviceLocal();
+}
+
+VkBuffer RTGL1::GeomInfoManager::GetMaterialsBuffer() const
+{
+    return materialsBuffer->GetDeviceLocal();
+}
+
 VkBuffer RTGL1::GeomInfoManager::GetMatchPrevBuffer() const
 {
     return matchPrev->GetDeviceLocal();
@@ -548,7 +887,11 @@ VkBuffer RTGL1::GeomInfoManager::GetMatchPrevBuffer() const
 
 uint32_t RTGL1::GeomInfoManager::GetCount( uint32_t frameIndex ) const
 {
-    assert( curFrame_IdToInfo.size() ==
-            staticUniqueIds.size() + dynamicUniqueIds[ frameIndex ].size() );
-    return static_cast< uint32_t >( curFrame_IdToInfo.size() );
+    return static_cast< uint32_t >( staticSlots.size() + dynamicSlots[ frameIndex ].size() );
+}
+
+auto RTGL1::GeomInfoManager::GetPreprocessCandidates() const
+    -> std::span< const PreprocessCandidate >
+{
+    return preprocessCandidates;
 }
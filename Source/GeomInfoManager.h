@@ -42,7 +42,9 @@ namespace RTGL1
 class GeomInfoManager
 {
 public:
-    explicit GeomInfoManager( VkDevice device, std::shared_ptr< MemoryAllocator >& allocator );
+    GeomInfoManager( VkDevice                            device,
+                     std::shared_ptr< MemoryAllocator >& allocator,
+                     uint32_t                            maxGeomInfoCount );
     ~GeomInfoManager() = default;
 
     GeomInfoManager( const GeomInfoManager& other )                = delete;
@@ -56,13 +58,21 @@ public:
 
 
     // Save instance for copying into buffer and fill previous frame's data.
+    // Material is deduplicated, 'src.materialIndex' is set to its index in the material table.
     // For dynamic geometry it should be called every frame,
     // and for static geometry -- only when whole static scene was changed.
-    void WriteGeomInfo( uint32_t                 frameIndex,
-                        const PrimitiveUniqueID& geomUniqueID,
-                        ShGeometryInstance&      src,
-                        bool                     isStatic,
-                        bool                     noMotionVectors );
+    void WriteGeomInfo( uint32_t                  frameIndex,
+                        const PrimitiveUniqueID&  geomUniqueID,
+                        ShGeometryInstance&       src,
+                        const ShGeometryMaterial& material,
+                        bool                      isStatic,
+                        bool                      noMotionVectors );
+
+    // Replace where the vertices and indices of the geometry are, e.g. to switch its LOD.
+    // Dynamic geometry must be written by WriteGeomInfo in this frame before it
+    void PatchGeometry( uint32_t                  frameIndex,
+                        const PrimitiveUniqueID&  geomUniqueID,
+                        const ShGeometryInstance& geometry );
 
     void Hack_PatchGeomInfoTexturesForStatic( const PrimitiveUniqueID& geomUniqueID,
                                               uint32_t                 texture_base,
@@ -76,12 +86,25 @@ public:
 
     bool CopyFromStaging( VkCommandBuffer cmd, uint32_t frameIndex, UniqueIDToTlasID&& tlas );
 
+    // Geometry of the last CopyFromStaging, which vertices must be processed on GPU
+    struct PreprocessCandidate
+    {
+        uint32_t tlasInstanceID;
+        uint32_t triangleCount;
+        bool     isDynamic;
+    };
+    auto GetPreprocessCandidates() const -> std::span< const PreprocessCandidate >;
+
 
     VkBuffer GetBuffer() const;
+    VkBuffer GetPrevBuffer() const;
+    VkBuffer GetMaterialsBuffer() const;
     VkBuffer GetMatchPrevBuffer() const;
 
 
     uint32_t GetCount( uint32_t frameIndex ) const;
+    // Capacity of the geometry info and material buffers
+    uint32_t GetMaxCount() const { return maxCount; }
 
 
     static bool     LayerExists( const RgMeshPrimitiveInfo& info, uint32_t layerIndex );
@@ -104,38 +127,114 @@ private:
         uint32_t baseIndexIndex;
         uint32_t vertexCount;
         uint32_t indexCount;
+        uint32_t flags;
+        // valid only if equals to the generation of its slot
+        uint32_t generation;
+    };
+
+    // Geometry has the same slot while it's uploaded each frame (or until the static
+    // scene is reset), so its current and previous frame's data are accessed by index
+    struct Slot
+    {
+        PrimitiveUniqueID  uniqueID;
+        // incremented when the slot is freed
+        uint32_t           generation;
+        bool               isStatic;
+        // if was registered in the current frame; static ones are kept between frames
+        bool                   hasCurInfo;
+        bool                   noMotionVectors;
+        ShGeometryInstance     curInfo;
+        ShGeometryInstancePrev curPrev;
+        uint64_t               lastWrittenFrame;
+        // TLAS instance ID in the frame 'tlasFrame'
+        uint32_t               tlasInstanceID;
+        uint64_t               tlasFrame;
+    };
+
+    struct MaterialHash
+    {
+        using is_avalanching = void;
+
+        auto operator()( const ShGeometryMaterial& m ) const noexcept -> uint64_t
+        {
+            return ankerl::unordered_dense::detail::wyhash::hash( &m, sizeof( m ) );
+        }
+    };
+
+    struct MaterialEqual
+    {
+        bool operator()( const ShGeometryMaterial& a, const ShGeometryMaterial& b ) const noexcept
+        {
+            return std::memcmp( &a, &b, sizeof( ShGeometryMaterial ) ) == 0;
+        }
+    };
+
+    struct PrevTlasInstance
+    {
+        uint32_t tlasInstanceID;
+        uint32_t slot;
+        uint32_t generation;
     };
 
 private:
-    auto FindPrevFrameData( const PrimitiveUniqueID&  geomUniqueID,
+    uint32_t AcquireSlot( const PrimitiveUniqueID& geomUniqueID, bool isStatic );
+    void     FreeSlot( uint32_t slot );
+    auto     FindStaticSlot( const PrimitiveUniqueID& geomUniqueID ) -> Slot*;
+
+    auto FindPrevFrameData( uint32_t                  slot,
                             const ShGeometryInstance& target,
                             uint32_t                  frameIndex,
                             bool                      noMotionVectors ) const -> const PrevInfo*;
 
-    void WritePrevForNextFrame( const PrimitiveUniqueID&  geomUniqueID,
-                                const ShGeometryInstance& src,
-                                uint32_t                  frameIndex );
+    void WritePrevForNextFrame( uint32_t slot, const ShGeometryInstance& src, uint32_t frameIndex );
+    static auto MakePrev( const PrevInfo* prev, ShGeometryInstance& src )
+        -> ShGeometryInstancePrev;
+
+    uint32_t AcquireMaterial( const ShGeometryMaterial& material );
+    void     ReleaseMaterial( uint32_t materialIndex );
 
 private:
     VkDevice device;
+    uint32_t maxCount;
 
     // buffer for getting info for geometry in BLAS
     std::shared_ptr< AutoBuffer > buffer;
+    // same indexing as 'buffer', previous frame's data for motion vectors
+    std::shared_ptr< AutoBuffer > prevBuffer;
+
+    // materials are shared by all geometries with the same data;
+    // the first one is a default, it's never freed
+    std::shared_ptr< AutoBuffer >      materialsBuffer;
+    std::vector< ShGeometryMaterial >  materials;
+    // count of slots referencing a material; if 0, the entry is free
+    std::vector< uint32_t >            materialRefCounts;
+    std::vector< uint32_t >            freeMaterials;
+    ankerl::unordered_dense::
+        map< ShGeometryMaterial, uint32_t, MaterialHash, MaterialEqual > materialToIndex;
+    // entries of 'materials' that were changed, but not copied to the GPU yet
+    CopyRange                          materialsDirty;
 
     std::shared_ptr< AutoBuffer >           matchPrev;
     // special CPU side buffer to reduce granular writes to staging
     std::unique_ptr< MatchPrevIndexType[] > matchPrevShadow;
 
-    // geometry's uniqueID to geom frame info,
-    // used for getting info from previous frame
-    rgl::unordered_map< PrimitiveUniqueID, PrevInfo > idToPrevInfo[ MAX_FRAMES_IN_FLIGHT ];
+    // the only hash lookup per geometry, other data is indexed by a slot
+    rgl::unordered_map< PrimitiveUniqueID, uint32_t > idToSlot;
+    std::vector< Slot >                               slots;
+    std::vector< uint32_t >                           freeSlots;
+
+    // by slot, geometry info of a frame for using it in the next one
+    std::vector< PrevInfo > prevInfos[ MAX_FRAMES_IN_FLIGHT ];
+
+    std::vector< uint32_t > staticSlots;
+    std::vector< uint32_t > dynamicSlots[ MAX_FRAMES_IN_FLIGHT ];
 
-    rgl::unordered_set< PrimitiveUniqueID > staticUniqueIds;
-    rgl::unordered_set< PrimitiveUniqueID > dynamicUniqueIds[ MAX_FRAMES_IN_FLIGHT ];
+    // by previous frame's TLAS instance ID order, to fill matchPrev linearly
+    std::vector< PrevTlasInstance > tlas_prev;
 
-    rgl::unordered_map< PrimitiveUniqueID, ShGeometryInstance > curFrame_IdToInfo;
+    std::vector< PreprocessCandidate > preprocessCandidates;
 
-    UniqueIDToTlasID tlas_prev;
+    uint64_t frameCounter{ 0 };
 };
 
 inline RgColor4DPacked32 PackEmissiveFactorAndStrength( RgColor4DPacked32 factor, float strength )
@@ -22,17 +22,21 @@
 
 #include "Generated/ShaderCommonC.h"
 #include "CmdLabel.h"
+
+#include <algorithm>
 #include <cstring>
 
 using namespace RTGL1;
 
 GlobalUniform::GlobalUniform( VkDevice _device, std::shared_ptr< MemoryAllocator > _allocator )
     : device( _device )
+    , uploadedValid( false )
     , descPool( VK_NULL_HANDLE )
     , descSetLayout( VK_NULL_HANDLE )
     , descSet( VK_NULL_HANDLE )
 {
-    uniformData = std::make_shared< ShGlobalUniform >();
+    uniformData  = std::make_shared< ShGlobalUniform >();
+    uploadedData = std::make_shared< ShGlobalUniform >();
 
     uniformBuffer = std::make_shared< AutoBuffer >( std::move( _allocator ) );
     uniformBuffer->Create(
@@ -125,8 +129,53 @@ void GlobalUniform::Upload( VkCommandBuffer cmd, uint32_t frameIndex )
 {
     CmdLabel label( cmd, "Copying uniform" );
 
-    SetData( frameIndex, uniformData.get(), sizeof( ShGlobalUniform ) );
-    uniformBuffer->CopyFromStaging( cmd, frameIndex, sizeof( ShGlobalUniform ) );
+    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
+    assert( uniformBuffer->GetSize() >= sizeof( ShGlobalUniform ) );
+
+    constexpr VkDeviceSize totalSize = sizeof( ShGlobalUniform );
+    constexpr uint32_t     maxBlocks = ( totalSize + UploadBlockSize - 1 ) / UploadBlockSize;
+
+    const auto* src      = reinterpret_cast< const uint8_t* >( uniformData.get() );
+    auto*       uploaded = reinterpret_cast< uint8_t* >( uploadedData.get() );
+    auto*       mapped   = uniformBuffer->GetMappedAs< uint8_t* >( frameIndex );
+
+    // most of the settings are the same between frames, so the device local
+    // buffer keeps them, and only the changed blocks go through the staging
+    VkBufferCopy copies[ maxBlocks ];
+    uint32_t     copyCount = 0;
+
+    for( VkDeviceSize offset = 0; offset < totalSize; offset += UploadBlockSize )
+    {
+        const VkDeviceSize size = std::min( UploadBlockSize, totalSize - offset );
+
+        if( uploadedValid && memcmp( &src[ offset ], &uploaded[ offset ], size ) == 0 )
+        {
+            continue;
+        }
+
+        memcpy( &mapped[ offset ], &src[ offset ], size );
+        memcpy( &uploaded[ offset ], &src[ offset ], size );
+
+        VkBufferCopy* prev = copyCount > 0 ? &copies[ copyCount - 1 ] : nullptr;
+
+        // merge with the previous block, if adjacent
+        if( prev && prev->srcOffset + prev->size == offset )
+        {
+            prev->size += size;
+        }
+        else
+        {
+            copies[ copyCount ] = VkBufferCopy{
+                .srcOffset = offset,
+                .dstOffset = offset,
+                .size      = size,
+            };
+            copyCount++;
+        }
+    }
+
+    uniformBuffer->CopyFromStaging( cmd, frameIndex, copies, copyCount );
+    uploadedValid = true;
 }
 
 ShGlobalUniform* GlobalUniform::GetData()
@@ -148,12 +197,3 @@ VkDescriptorSetLayout GlobalUniform::GetDescSetLayout() const
 {
     return descSetLayout;
 }
-
-void GlobalUniform::SetData( uint32_t frameIndex, const void* data, VkDeviceSize dataSize )
-{
-    assert( frameIndex < MAX_FRAMES_IN_FLIGHT );
-    assert( uniformBuffer->GetSize() <= dataSize );
-
-    void* mapped = uniformBuffer->GetMapped( frameIndex );
-    memcpy( mapped, data, dataSize );
-}
@@ -38,7 +38,7 @@ public:
     GlobalUniform&         operator=( const GlobalUniform& other ) = delete;
     GlobalUniform&         operator=( GlobalUniform&& other ) noexcept = delete;
 
-    // Send current data
+    // Send current data. Only the blocks that differ from the previous upload are copied
     void                   Upload( VkCommandBuffer cmd, uint32_t frameIndex );
 
     // Getters for modifying uniform buffer data that will be uploaded
@@ -49,14 +49,18 @@ public:
     VkDescriptorSetLayout  GetDescSetLayout() const;
 
 private:
+    static constexpr VkDeviceSize UploadBlockSize = 256;
+
     void CreateDescriptors();
-    void SetData( uint32_t frameIndex, const void* data, VkDeviceSize dataSize );
 
 private:
     VkDevice                           device;
 
     std::shared_ptr< ShGlobalUniform > uniformData;
     std::shared_ptr< AutoBuffer >      uniformBuffer;
+    // copy of the device local buffer contents
+    std::shared_ptr< ShGlobalUniform > uploadedData;
+    bool                               uploadedValid;
 
     VkDescriptorPool                   descPool;
     VkDescriptorSetLayout              descSetLayout;
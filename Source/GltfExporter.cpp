@@ -36,12 +36,20 @@
 
 #include "cgltf/cgltf_write.h"
 
+#if RG_USE_MESHOPTIMIZER
+#include <meshoptimizer.h>
+#endif
+
 #include <array>
 #include <cassert>
+#include <cfloat>
 #include <fstream>
+#include <future>
+#include <map>
 #include <queue>
 #include <span>
 #include <type_traits>
+#include <utility>
 
 namespace
 {
@@ -273,7 +281,6 @@ struct DeepCopyOfPrimitive
         }
 
         auto fromVertices = std::span{ c.pVertices, c.vertexCount };
-        auto fromIndices  = std::span{ c.pIndices, c.indexCount };
         // for copying
         static_assert(
             std::is_same_v< decltype( c.pIndices ), decltype( pIndices )::const_pointer > );
@@ -295,7 +302,12 @@ struct DeepCopyOfPrimitive
                 .color    = src.color,
             };
         }
-        pIndices.assign( fromIndices.begin(), fromIndices.end() );
+        // 16-bit indices are widened, so exporter deals only with 32-bit ones
+        pIndices.resize( Utils::HasIndices( c ) ? c.indexCount : 0 );
+        for( size_t i = 0; i < pIndices.size(); i++ )
+        {
+            pIndices[ i ] = Utils::GetIndex( c, uint32_t( i ) );
+        }
 
         if( !( c.flags & RG_MESH_PRIMITIVE_DONT_GENERATE_NORMALS ) )
         {
@@ -385,6 +397,7 @@ private:
         inout.info.pTextureName = inout.pTextureName.data();
         inout.info.pVertices    = nullptr; // because of RgPrimitiveVertex_Unpacked
         inout.info.pIndices     = inout.pIndices.data();
+        inout.info.pIndices16   = nullptr; // widened on copy
 
         assert( inout.info.vertexCount == inout.pVertices.size() );
         assert( inout.info.indexCount == inout.pIndices.size() );
@@ -440,16 +453,27 @@ struct GltfBin
         assert( file );
     }
 
+    // First is the .bin file. Second, if present, is a fallback buffer of EXT_meshopt_compression:
+    // it has no data, and only gives the space for the decompressed buffer views
     cgltf_buffer* Get()
     {
-        storage = cgltf_buffer{
+        storage[ 0 ] = cgltf_buffer{
             .name = nullptr,
             .size = fileOffset,
             .uri  = const_cast< char* >( uri.c_str() ),
         };
-        return &storage;
+        storage[ 1 ] = cgltf_buffer{
+            .name = nullptr,
+            .size = fallbackOffset,
+            .uri  = nullptr,
+        };
+        return storage;
     }
 
+    cgltf_buffer* GetFallback() { return &Get()[ 1 ]; }
+
+    size_t BufferCount() const { return fallbackOffset > 0 ? 2 : 1; }
+
     // Returns begin of written data.
     template< typename T >
     size_t Write( std::span< T > bytes )
@@ -460,6 +484,22 @@ struct GltfBin
                     std::streamsize( bytes.size_bytes() ) );
         fileOffset += bytes.size_bytes();
 
+        // meshopt requires 4 byte alignment for its data
+        constexpr char zeros[ 4 ] = {};
+        if( size_t pad = RTGL1::Utils::Align( fileOffset, size_t{ 4 } ) - fileOffset )
+        {
+            file.write( zeros, std::streamsize( pad ) );
+            fileOffset += pad;
+        }
+
+        return begin;
+    }
+
+    // Returns begin of the region in the fallback buffer.
+    size_t ReserveFallback( size_t size )
+    {
+        size_t begin = fallbackOffset;
+        fallbackOffset += RTGL1::Utils::Align( size, size_t{ 4 } );
         return begin;
     }
 
@@ -467,31 +507,103 @@ private:
     std::string   uri;
     std::ofstream file;
     size_t        fileOffset;
-    cgltf_buffer  storage;
+    size_t        fallbackOffset{ 0 };
+    cgltf_buffer  storage[ 2 ];
 };
 
 
+#if RG_USE_MESHOPTIMIZER
+// EXT_meshopt_compression: compressed data is written to the .bin file,
+// and the buffer view itself points to the fallback buffer
+template< typename T >
+void CompressBufferView( GltfBin& fbin, cgltf_buffer_view& view, std::span< const T > src )
+{
+    const bool isIndices = view.type == cgltf_buffer_view_type_indices;
+
+    // EXT_meshopt_compression accepts only triangle lists for index compression
+    if( src.empty() || ( isIndices && src.size() % 3 != 0 ) )
+    {
+        return;
+    }
+
+    auto encoded = std::vector< uint8_t >{};
+    if( isIndices )
+    {
+        static_assert( std::is_same_v< T, uint32_t > );
+
+        encoded.resize( meshopt_encodeIndexBufferBound(
+            src.size(), *std::ranges::max_element( src ) + 1 ) );
+        encoded.resize( meshopt_encodeIndexBuffer(
+            encoded.data(), encoded.size(), src.data(), src.size() ) );
+    }
+    else
+    {
+        static_assert( sizeof( T ) % 4 == 0 && sizeof( T ) <= 256 );
+
+        encoded.resize( meshopt_encodeVertexBufferBound( src.size(), sizeof( T ) ) );
+        encoded.resize( meshopt_encodeVertexBuffer(
+            encoded.data(), encoded.size(), src.data(), src.size(), sizeof( T ) ) );
+    }
+
+    if( encoded.empty() )
+    {
+        return;
+    }
+
+    view.buffer                  = fbin.GetFallback();
+    view.offset                  = fbin.ReserveFallback( src.size_bytes() );
+    view.has_meshopt_compression = true;
+
+    view.meshopt_compression = cgltf_meshopt_compression{
+        .buffer = fbin.Get(),
+        .offset = fbin.Write( std::span{ std::as_const( encoded ) } ),
+        .size   = encoded.size(),
+        .stride = sizeof( T ),
+        .count  = src.size(),
+        .mode   = isIndices ? cgltf_meshopt_compression_mode_triangles
+                            : cgltf_meshopt_compression_mode_attributes,
+        .filter = cgltf_meshopt_compression_filter_none,
+    };
+}
+#endif
+
+template< typename T >
+cgltf_buffer_view MakeBufferView( GltfBin&               fbin,
+                                  std::span< const T >   src,
+                                  cgltf_buffer_view_type type )
+{
+    auto view = cgltf_buffer_view{
+        .name   = nullptr,
+        .buffer = fbin.Get(),
+        .offset = 0,
+        .size   = src.size_bytes(),
+        .stride = sizeof( T ),
+        .type   = type,
+    };
+
+#if RG_USE_MESHOPTIMIZER
+    if( RTGL1::LibConfig().exportMeshopt )
+    {
+        CompressBufferView( fbin, view, src );
+        if( view.has_meshopt_compression )
+        {
+            return view;
+        }
+    }
+#endif
+
+    view.offset = fbin.Write( src );
+    return view;
+}
+
+
 auto MakeBufferViews( GltfBin& fbin, const RTGL1::DeepCopyOfPrimitive& prim )
 {
     return std::to_array( {
 #define BUFFER_VIEW_VERTICES 0
-        cgltf_buffer_view{
-            .name   = nullptr,
-            .buffer = fbin.Get(),
-            .offset = fbin.Write( prim.Vertices() ),
-            .size   = prim.Vertices().size_bytes(),
-            .stride = sizeof( decltype( prim.Vertices() )::element_type ),
-            .type   = cgltf_buffer_view_type_vertices,
-        },
+        MakeBufferView( fbin, prim.Vertices(), cgltf_buffer_view_type_vertices ),
 #define BUFFER_VIEW_INDICES 1
-        cgltf_buffer_view{
-            .name   = nullptr,
-            .buffer = fbin.Get(),
-            .offset = fbin.Write( prim.Indices() ),
-            .size   = prim.Indices().size_bytes(),
-            .stride = sizeof( decltype( prim.Indices() )::element_type ),
-            .type   = cgltf_buffer_view_type_indices,
-        },
+        MakeBufferView( fbin, prim.Indices(), cgltf_buffer_view_type_indices ),
     } );
 }
 constexpr size_t BufferViewsPerPrim =
@@ -791,13 +903,9 @@ struct GltfTextures
         }
     }
 
-    explicit GltfTextures( const std::set< std::string >& sceneMaterials,
-                           const std::filesystem::path&   gltfPath,
-                           const RTGL1::TextureManager&   textureManager,
-                           const std::filesystem::path&   texLookupFolder )
+    explicit GltfTextures( const std::set< std::string >&     sceneMaterials,
+                           const RTGL1::GltfExportedTextures& exported )
     {
-        RTGL1::debug::Info( "Exporting textures..." );
-
         // alloc max and lock pointers
         allocStrings.resize( RTGL1::TEXTURES_PER_MATERIAL_COUNT * sceneMaterials.size() );
         allocImages.resize( RTGL1::TEXTURES_PER_MATERIAL_COUNT * sceneMaterials.size() );
@@ -858,19 +966,17 @@ struct GltfTextures
         const auto originalsFolder = std::string{ RTGL1::TEXTURES_FOLDER_JUNCTION } + '/';
         const auto externalFolder  = std::string{ RTGL1::TEXTURES_FOLDER_EXTERNAL } + '/';
 
-        const auto originalsFolderExportPath = GetGltfFolder( gltfPath ) / originalsFolder;
-        const auto externalFolderExportPath  = GetGltfFolder( gltfPath ) / externalFolder;
-
 
         // resolve
         for( const auto& materialName : sceneMaterials )
         {
-            if( materialName.empty() )
+            auto found = exported.find( materialName );
+            if( materialName.empty() || found == exported.end() )
             {
                 continue;
             }
 
-            const bool asExternal = textureManager.ShouldExportAsExternal( materialName.c_str() );
+            const bool asExternal = found->second.asExternal;
 
             static_assert( RTGL1::TEXTURES_PER_MATERIAL_COUNT == 5 );
             static_assert( RTGL1::TEXTURE_ALBEDO_ALPHA_INDEX == 0 );
@@ -878,11 +984,7 @@ struct GltfTextures
             static_assert( RTGL1::TEXTURE_NORMAL_INDEX == 2 );
             static_assert( RTGL1::TEXTURE_EMISSIVE_INDEX == 3 );
             static_assert( RTGL1::TEXTURE_HEIGHT_INDEX == 4 );
-            auto [ albedo, orm, normal, emissive, height ] = textureManager.ExportMaterialTextures(
-                materialName.c_str(),
-                asExternal ? externalFolderExportPath : originalsFolderExportPath,
-                false,
-                &texLookupFolder );
+            auto [ albedo, orm, normal, emissive, height ] = found->second.textures;
 
             auto tryMakeCgltfTexture = [ & ]( RTGL1::TextureManager::ExportResult&& r,
                                               bool nameMustBeMaterialName =
@@ -966,6 +1068,45 @@ private:
     rgl::string_map< TextureSet > materialAccess;
 };
 
+// Must be on the render thread, as it reads the texture manager and records texture readbacks
+auto ExportTextures( const std::set< std::string >& sceneMaterials,
+                     const std::filesystem::path&   gltfPath,
+                     const RTGL1::TextureManager&   textureManager,
+                     const std::filesystem::path&   texLookupFolder,
+                     RTGL1::TextureExporter&        textureWrites ) -> RTGL1::GltfExportedTextures
+{
+    RTGL1::debug::Info( "Exporting textures..." );
+
+    const auto originalsFolderExportPath =
+        GetGltfFolder( gltfPath ) / RTGL1::TEXTURES_FOLDER_JUNCTION;
+    const auto externalFolderExportPath =
+        GetGltfFolder( gltfPath ) / RTGL1::TEXTURES_FOLDER_EXTERNAL;
+
+    auto exported = RTGL1::GltfExportedTextures{};
+
+    for( const auto& materialName : sceneMaterials )
+    {
+        if( materialName.empty() )
+        {
+            continue;
+        }
+
+        const bool asExternal = textureManager.ShouldExportAsExternal( materialName.c_str() );
+
+        exported[ materialName ] = RTGL1::GltfExportedMaterial{
+            .asExternal = asExternal,
+            .textures   = textureManager.ExportMaterialTextures(
+                materialName.c_str(),
+                asExternal ? externalFolderExportPath : originalsFolderExportPath,
+                false,
+                &texLookupFolder,
+                &textureWrites ),
+        };
+    }
+
+    return exported;
+}
+
 cgltf_material MakeMaterial( const RTGL1::DeepCopyOfPrimitive& rgprim,
                              const GltfTextures&               textureStorage )
 {
@@ -1410,9 +1551,9 @@ void MakeLightsForPrimitive( const RgMeshInfo&                      mesh,
     for( uint32_t tri = 0; tri < prim.indexCount / 3; tri++ )
     {
         Tri local = {
-            toFloat3( prim.pVertices[ prim.pIndices[ tri * 3 + 0 ] ].position ),
-            toFloat3( prim.pVertices[ prim.pIndices[ tri * 3 + 1 ] ].position ),
-            toFloat3( prim.pVertices[ prim.pIndices[ tri * 3 + 2 ] ].position ),
+            toFloat3( prim.pVertices[ Utils::GetIndex( prim, tri * 3 + 0 ) ].position ),
+            toFloat3( prim.pVertices[ Utils::GetIndex( prim, tri * 3 + 1 ) ].position ),
+            toFloat3( prim.pVertices[ Utils::GetIndex( prim, tri * 3 + 2 ) ].position ),
         };
 
         Tri global = {
@@ -1655,7 +1796,7 @@ void RTGL1::GltfExporter::AddPrimitive( const RgMeshInfo&          mesh,
         return;
     }
 
-    if( primitive.indexCount == 0 || primitive.pIndices == nullptr )
+    if( !Utils::HasIndices( primitive ) )
     {
         debug::Warning( "Exporter doesn't support primitives without index buffer: "
                         "{} (with ID: {} - {})",
@@ -1781,28 +1922,29 @@ void TransformWorldToGltf( std::span< cgltf_node* > nodes, const RgTransform& wo
 }
 }
 
-void RTGL1::GltfExporter::ExportToFiles( const std::filesystem::path& gltfPath,
-                                         const TextureManager&        textureManager,
-                                         const std::filesystem::path& ovrdFolder,
-                                         bool                         isSceneGltf )
+auto RTGL1::GltfExporter::ExportToFiles( std::unique_ptr< GltfExporter > exporter,
+                                         const std::filesystem::path&    gltfPath,
+                                         const TextureManager&           textureManager,
+                                         const std::filesystem::path&    ovrdFolder,
+                                         bool isSceneGltf ) -> std::future< bool >
 {
-    if( scene.empty() )
+    if( !exporter || exporter->scene.empty() )
     {
         debug::Warning( "Nothing to export. Check uploaded primitives window" );
-        return;
+        return {};
     }
 
     if( gltfPath.empty() )
     {
         debug::Warning( "Can't export: Destination path is empty" );
-        return;
+        return {};
     }
 
     if( !PrepareFolder( gltfPath, isSceneGltf, ovrdFolder ) )
     {
         debug::Warning( "Denied to write to the folder {}",
                         std::filesystem::absolute( GetGltfFolder( gltfPath ) ).string() );
-        return;
+        return {};
     }
 
     if( !isSceneGltf )
@@ -1811,30 +1953,161 @@ void RTGL1::GltfExporter::ExportToFiles( const std::filesystem::path& gltfPath,
         {
             debug::Warning( "Won't export .gltf, as corresponding file already exists: {}",
                             absolute( gltfPath ).string() );
-            return;
+            return {};
         }
         if( exists( GetGltfBinPath( gltfPath ) ) )
         {
             debug::Warning( "Won't export .gltf, as corresponding .bin file already exists: {}",
                             absolute( GetGltfBinPath( gltfPath ) ).string() );
-            return;
+            return {};
         }
     }
 
 
-    const char* sceneExtrasExample = nullptr; // "{ tonemapping_enable\" : 1 }";
+    debug::Info( "Export start..." );
 
+    // readbacks are submitted on the render thread, but waited and written on the worker
+    auto textureWrites = std::make_unique< TextureExporter >();
+    auto textures      = ExportTextures( exporter->sceneMaterials,
+                                         gltfPath,
+                                         textureManager,
+                                         ovrdFolder / TEXTURES_FOLDER_DEV,
+                                         *textureWrites );
+
+    return std::async( std::launch::async,
+                       [ exporter      = std::move( exporter ),
+                         textureWrites = std::move( textureWrites ),
+                         textures      = std::move( textures ),
+                         gltfPath,
+                         isSceneGltf ]() {
+                           return exporter->WriteFiles(
+                               gltfPath, textures, *textureWrites, isSceneGltf );
+                       } );
+}
 
-    debug::Info( "Export start..." );
+bool RTGL1::GltfExporter::WriteFiles( const std::filesystem::path& gltfPath,
+                                      const GltfExportedTextures&  textures,
+                                      TextureExporter&             textureWrites,
+                                      bool                         isSceneGltf ) const
+{
+    if( !textureWrites.WriteFinished() )
+    {
+        debug::Warning( "Some of the textures were not exported" );
+    }
+
+    if( isSceneGltf && LibConfig().exportSceneCells )
+    {
+        if( !ExportCells( gltfPath, textures ) )
+        {
+            return false;
+        }
+
+        // meshes are in the cells, the scene file keeps only the lights
+        if( !WriteGltf( gltfPath, {}, {}, sceneLights, textures ) )
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if( !WriteGltf( gltfPath, scene, sceneMaterials, sceneLights, textures ) )
+        {
+            return false;
+        }
+    }
+
+    debug::Info( "Export successful: {}",
+                 std::filesystem::absolute( GetGltfFolder( gltfPath ) ).string() );
+    return true;
+}
+
+bool RTGL1::GltfExporter::ExportCells( const std::filesystem::path& gltfPath,
+                                       const GltfExportedTextures&  textures ) const
+{
+    const float cellSize =
+        SCENE_CELL_SIZE_METERS / std::max( params.oneGameUnitInMeters, 0.0001f );
+
+    struct Cell
+    {
+        MeshesToTheirPrimitives meshes{};
+        std::set< std::string > materials{};
+    };
+    auto cells = std::map< std::array< int, 3 >, Cell >{};
+
+    for( const auto& [ node, prims ] : scene )
+    {
+        // a node is not split, it's put into the cell that contains its bounding box center
+        auto bboxMin = RgFloat3D{ FLT_MAX, FLT_MAX, FLT_MAX };
+        auto bboxMax = RgFloat3D{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        for( const auto& prim : prims )
+        {
+            for( const RgPrimitiveVertex_Unpacked& v : prim->Vertices() )
+            {
+                const RgFloat3D pos = Utils::ApplyTransform(
+                    node.transform, { v.position[ 0 ], v.position[ 1 ], v.position[ 2 ] } );
+
+                for( int i = 0; i < 3; i++ )
+                {
+                    bboxMin.data[ i ] = std::min( bboxMin.data[ i ], pos.data[ i ] );
+                    bboxMax.data[ i ] = std::max( bboxMax.data[ i ], pos.data[ i ] );
+                }
+            }
+        }
+
+        auto coords = std::array< int, 3 >{};
+        if( bboxMin.data[ 0 ] <= bboxMax.data[ 0 ] )
+        {
+            for( int i = 0; i < 3; i++ )
+            {
+                const float center = 0.5f * ( bboxMin.data[ i ] + bboxMax.data[ i ] );
+                coords[ i ]        = static_cast< int >( std::floor( center / cellSize ) );
+            }
+        }
+
+        Cell& dst = cells[ coords ];
+        dst.meshes.emplace( node, prims );
+        for( const auto& prim : prims )
+        {
+            if( !prim->MaterialName().empty() )
+            {
+                dst.materials.emplace( prim->MaterialName() );
+            }
+        }
+    }
+
+    for( const auto& [ coords, cell ] : cells )
+    {
+        const auto cellPath = AddSuffix(
+            gltfPath,
+            std::format(
+                L"{}{}_{}_{}", SCENE_CELL_SUFFIX, coords[ 0 ], coords[ 1 ], coords[ 2 ] ) );
+
+        if( !WriteGltf( cellPath, cell.meshes, cell.materials, {}, textures ) )
+        {
+            return false;
+        }
+    }
+
+    debug::Info( "Exported {} scene cells", cells.size() );
+    return true;
+}
+
+bool RTGL1::GltfExporter::WriteGltf( const std::filesystem::path&    gltfPath,
+                                     const MeshesToTheirPrimitives&  meshes,
+                                     const std::set< std::string >&  materials,
+                                     const std::vector< LightCopy >& lights,
+                                     const GltfExportedTextures&     textures ) const
+{
+    const char* sceneExtrasExample = nullptr; // "{ tonemapping_enable\" : 1 }";
 
 
     // lock pointers
-    auto fbin    = GltfBin{ gltfPath };
-    auto storage = GltfStorage{ scene, sceneLights.size() };
-    auto textureStorage =
-        GltfTextures{ sceneMaterials, gltfPath, textureManager, ovrdFolder / TEXTURES_FOLDER_DEV };
-    auto lightStorage = GltfLights{ sceneLights, storage.lightNodes };
-    auto strStorage   = std::vector< std::string >{};
+    auto fbin           = GltfBin{ gltfPath };
+    auto storage        = GltfStorage{ meshes, lights.size() };
+    auto textureStorage = GltfTextures{ materials, textures };
+    auto lightStorage   = GltfLights{ lights, storage.lightNodes };
+    auto strStorage     = std::vector< std::string >{};
 
 
     auto materialcount = 0u;
@@ -1971,7 +2244,7 @@ void RTGL1::GltfExporter::ExportToFiles( const std::filesystem::path& gltfPath,
         .buffer_views       = std::data( storage.allBufferViews ),
         .buffer_views_count = std::size( storage.allBufferViews ),
         .buffers            = fbin.Get(),
-        .buffers_count      = 1,
+        .buffers_count      = fbin.BufferCount(),
         .images             = std::data( textureStorage.Images() ),
         .images_count       = std::size( textureStorage.Images() ),
         .textures           = std::data( textureStorage.Textures() ),
@@ -2023,18 +2296,17 @@ void RTGL1::GltfExporter::ExportToFiles( const std::filesystem::path& gltfPath,
     if( r != cgltf_result_success )
     {
         debug::Warning( "cgltf_validate fail" );
-        return;
+        return false;
     }
 
     r = cgltf_write_file( &options, gltfPath.string().c_str(), &data );
     if( r != cgltf_result_success )
     {
         debug::Warning( "cgltf_write_file fail" );
-        return;
+        return false;
     }
 
-    debug::Info( "Export successful: {}",
-                 std::filesystem::absolute( GetGltfFolder( gltfPath ) ).string() );
+    return true;
 }
 
 bool RTGL1::GltfMeshNode::operator==( const GltfMeshNode& other ) const
@@ -22,10 +22,12 @@
 
 #include "Common.h"
 #include "Containers.h"
+#include "TextureExporter.h"
 #include "TextureManager.h"
 
 #include <filesystem>
 #include <functional>
+#include <future>
 #include <set>
 
 namespace RTGL1
@@ -61,6 +63,14 @@ namespace RTGL1
 using MeshesToTheirPrimitives =
     rgl::unordered_map< GltfMeshNode, std::vector< std::shared_ptr< DeepCopyOfPrimitive > > >;
 
+// Texture files of a material, their readbacks are recorded on the render thread
+struct GltfExportedMaterial
+{
+    bool                                                                    asExternal{ false };
+    std::array< TextureManager::ExportResult, TEXTURES_PER_MATERIAL_COUNT > textures{};
+};
+using GltfExportedTextures = rgl::string_map< GltfExportedMaterial >;
+
 class GltfExporter
 {
 public:
@@ -76,10 +86,13 @@ public:
     void AddPrimitiveLights( const RgMeshInfo& mesh, const RgMeshPrimitiveInfo& primitive );
     void AddLight( const LightCopy& light );
 
-    void ExportToFiles( const std::filesystem::path& gltfPath,
-                        const TextureManager&        textureManager,
-                        const std::filesystem::path& ovrdFolder,
-                        bool                         isSceneGltf );
+    // Prepares the folder and submits texture readbacks on the calling thread, then writes
+    // the files on a worker thread, that owns the exporter. Invalid future, if not started
+    static auto ExportToFiles( std::unique_ptr< GltfExporter > exporter,
+                               const std::filesystem::path&    gltfPath,
+                               const TextureManager&           textureManager,
+                               const std::filesystem::path&    ovrdFolder,
+                               bool isSceneGltf ) -> std::future< bool >;
 
     // TODO: allocators, to not pass references
     static void MakeLightsForPrimitiveDynamic( const RgMeshInfo&              mesh,
@@ -88,6 +101,22 @@ public:
                                                std::vector< PositionNormal >& tempStorage,
                                                std::vector< AnyLightEXT >&    resultStorage );
 
+private:
+    bool WriteFiles( const std::filesystem::path& gltfPath,
+                     const GltfExportedTextures&  textures,
+                     TextureExporter&             textureWrites,
+                     bool                         isSceneGltf ) const;
+
+    // Write meshes into separate files, partitioned by spatial cells
+    bool ExportCells( const std::filesystem::path& gltfPath,
+                      const GltfExportedTextures&  textures ) const;
+
+    bool WriteGltf( const std::filesystem::path&    gltfPath,
+                    const MeshesToTheirPrimitives&  meshes,
+                    const std::set< std::string >&  materials,
+                    const std::vector< LightCopy >& lights,
+                    const GltfExportedTextures&     textures ) const;
+
 private:
     MeshesToTheirPrimitives  scene;
     std::set< std::string >  sceneMaterials;
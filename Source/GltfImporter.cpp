@@ -20,11 +20,14 @@
 
 #include "GltfImporter.h"
 
+#include "BatchMath.h"
 #include "Const.h"
 #include "DrawFrameInfo.h"
 #include "JsonParser.h"
+#include "LibraryConfig.h"
 #include "Matrix.h"
 #include "SamplerManager.h"
+#include "SceneCache.h"
 #include "TextureManager.h"
 #include "TextureMeta.h"
 #include "Utils.h"
@@ -33,13 +36,20 @@
 
 #include "cgltf/cgltf.h"
 
+#if RG_USE_MESHOPTIMIZER
+#include <meshoptimizer.h>
+#endif
+
 #if 0
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #endif
 
+#include <atomic>
 #include <format>
+#include <future>
 #include <span>
+#include <thread>
 
 #define NEED_TANGENT 0
 
@@ -270,6 +280,205 @@ namespace
 #undef RTGL1_CGLTF_RESULT_NAME
     }
 
+    // EXT_meshopt_compression: decompressed data is stored in cgltf_buffer_view::data,
+    // so cgltf_accessor_read_* use it instead of the buffer. It's freed by cgltf_free.
+    // KHR_mesh_quantization doesn't need any special handling, as cgltf_accessor_read_float
+    // dequantizes the integer attributes, and the dequantization transform is in the nodes
+    bool DecodeMeshoptBuffers( cgltf_data* data, std::string_view gltfPath )
+    {
+        for( cgltf_buffer_view& view : std::span{ data->buffer_views, data->buffer_views_count } )
+        {
+            if( !view.has_meshopt_compression )
+            {
+                continue;
+            }
+
+#if RG_USE_MESHOPTIMIZER
+            const cgltf_meshopt_compression& mc = view.meshopt_compression;
+
+            if( !mc.buffer || !mc.buffer->data || mc.offset + mc.size > mc.buffer->size )
+            {
+                debug::Warning( "EXT_meshopt_compression: Invalid buffer. {}", gltfPath );
+                return false;
+            }
+
+            const auto* src = static_cast< const uint8_t* >( mc.buffer->data ) + mc.offset;
+            void*       dst = malloc( mc.count * mc.stride );
+            if( !dst )
+            {
+                return false;
+            }
+
+            int r = -1;
+            switch( mc.mode )
+            {
+                case cgltf_meshopt_compression_mode_attributes:
+                    r = meshopt_decodeVertexBuffer( dst, mc.count, mc.stride, src, mc.size );
+                    break;
+                case cgltf_meshopt_compression_mode_triangles:
+                    r = meshopt_decodeIndexBuffer( dst, mc.count, mc.stride, src, mc.size );
+                    break;
+                case cgltf_meshopt_compression_mode_indices:
+                    r = meshopt_decodeIndexSequence( dst, mc.count, mc.stride, src, mc.size );
+                    break;
+                default: break;
+            }
+
+            if( r != 0 )
+            {
+                free( dst );
+                debug::Warning( "EXT_meshopt_compression: Decode failed. {}", gltfPath );
+                return false;
+            }
+
+            switch( mc.filter )
+            {
+                case cgltf_meshopt_compression_filter_octahedral:
+                    meshopt_decodeFilterOct( dst, mc.count, mc.stride );
+                    break;
+                case cgltf_meshopt_compression_filter_quaternion:
+                    meshopt_decodeFilterQuat( dst, mc.count, mc.stride );
+                    break;
+                case cgltf_meshopt_compression_filter_exponential:
+                    meshopt_decodeFilterExp( dst, mc.count, mc.stride );
+                    break;
+                default: break;
+            }
+
+            view.data = dst;
+#else
+            debug::Warning( "EXT_meshopt_compression is not supported, "
+                            "RTGL1 must be built with RG_WITH_MESHOPTIMIZER. {}",
+                            gltfPath );
+            return false;
+#endif
+        }
+        return true;
+    }
+
+    // Reorder triangles for the post-transform vertex cache, and vertices by their first use,
+    // for the fetch locality. The triangles stay the same. Duplicated vertices are merged
+    // only if 'mergeVertices', as generated flat normals need the vertices to be separate
+    void OptimizeVertexOrder( std::vector< RgPrimitiveVertex >& vertices,
+                              std::vector< uint32_t >&          indices,
+                              bool                              mergeVertices )
+    {
+#if RG_USE_MESHOPTIMIZER
+        if( !LibConfig().meshOptimization || vertices.empty() || indices.empty() ||
+            indices.size() % 3 != 0 )
+        {
+            return;
+        }
+
+        if( mergeVertices )
+        {
+            auto remap = std::vector< uint32_t >( vertices.size() );
+
+            // vertices are compared bytewise, '_pad0' is zeroed on gather
+            const size_t uniqueCount = meshopt_generateVertexRemap( remap.data(),
+                                                                    indices.data(),
+                                                                    indices.size(),
+                                                                    vertices.data(),
+                                                                    vertices.size(),
+                                                                    sizeof( RgPrimitiveVertex ) );
+
+            auto unique = std::vector< RgPrimitiveVertex >( uniqueCount );
+            meshopt_remapVertexBuffer( unique.data(),
+                                       vertices.data(),
+                                       vertices.size(),
+                                       sizeof( RgPrimitiveVertex ),
+                                       remap.data() );
+            meshopt_remapIndexBuffer(
+                indices.data(), indices.data(), indices.size(), remap.data() );
+
+            vertices = std::move( unique );
+        }
+
+        meshopt_optimizeVertexCache(
+            indices.data(), indices.data(), indices.size(), vertices.size() );
+
+        // unreferenced vertices are removed
+        auto ordered = std::vector< RgPrimitiveVertex >( vertices.size() );
+        ordered.resize( meshopt_optimizeVertexFetch( ordered.data(),
+                                                     indices.data(),
+                                                     indices.size(),
+                                                     vertices.data(),
+                                                     vertices.size(),
+                                                     sizeof( RgPrimitiveVertex ) ) );
+        vertices = std::move( ordered );
+#endif
+    }
+
+    // Each LOD has ~half of the triangles of the previous one, and its vertices are compacted,
+    // so a coarser BLAS doesn't reference the unused ones
+    auto GenerateLods( const std::vector< RgPrimitiveVertex >& vertices,
+                       const std::vector< uint32_t >&          indices )
+        -> std::vector< WholeModelFile::RawLodData >
+    {
+        auto lods = std::vector< WholeModelFile::RawLodData >{};
+
+#if RG_USE_MESHOPTIMIZER
+        if( !LibConfig().meshLods || indices.size() < MESH_LOD_MIN_INDEX_COUNT ||
+            vertices.empty() )
+        {
+            return lods;
+        }
+
+        static_assert( offsetof( RgPrimitiveVertex, position ) == 0 );
+        const float* positions = vertices[ 0 ].position;
+
+        // meshopt errors are relative to the mesh extent
+        const float errorScale =
+            meshopt_simplifyScale( positions, vertices.size(), sizeof( RgPrimitiveVertex ) );
+
+        size_t prevIndexCount = indices.size();
+
+        for( uint32_t i = 0; i < MESH_LOD_MAX_COUNT; i++ )
+        {
+            auto  lodIndices = std::vector< uint32_t >( indices.size() );
+            float error      = 0;
+
+            // borders are locked, as a model's primitives are adjacent to each other
+            const size_t indexCount = meshopt_simplify( lodIndices.data(),
+                                                        indices.data(),
+                                                        indices.size(),
+                                                        positions,
+                                                        vertices.size(),
+                                                        sizeof( RgPrimitiveVertex ),
+                                                        indices.size() >> ( i + 1 ),
+                                                        0.05f,
+                                                        meshopt_SimplifyLockBorder,
+                                                        &error );
+
+            // not worth another BLAS
+            if( indexCount == 0 || indexCount > prevIndexCount * 3 / 4 )
+            {
+                break;
+            }
+            prevIndexCount = indexCount;
+            lodIndices.resize( indexCount );
+            meshopt_optimizeVertexCache(
+                lodIndices.data(), lodIndices.data(), lodIndices.size(), vertices.size() );
+
+            auto lodVertices = std::vector< RgPrimitiveVertex >( vertices.size() );
+            lodVertices.resize( meshopt_optimizeVertexFetch( lodVertices.data(),
+                                                             lodIndices.data(),
+                                                             lodIndices.size(),
+                                                             vertices.data(),
+                                                             vertices.size(),
+                                                             sizeof( RgPrimitiveVertex ) ) );
+
+            lods.push_back( WholeModelFile::RawLodData{
+                .vertices = std::move( lodVertices ),
+                .indices  = std::move( lodIndices ),
+                .error    = error * errorScale,
+            } );
+        }
+#endif
+
+        return lods;
+    }
+
     template< size_t N >
     cgltf_bool cgltf_accessor_read_float_h( const cgltf_accessor* accessor,
                                             cgltf_size            index,
@@ -452,16 +661,21 @@ namespace
                     }
                     break;
 
-                case cgltf_attribute_type_normal:
+                case cgltf_attribute_type_normal: {
+                    auto normals = std::vector< RgFloat3D >( primVertices.size() );
                     for( size_t i = 0; i < primVertices.size(); i++ )
                     {
-                        float n[ 3 ];
-                        ok &= cgltf_accessor_read_float_h( attr.data, i, n );
-
-                        primVertices[ i ].normalPacked =
-                            Utils::PackNormal( n[ 0 ], n[ 1 ], n[ 2 ] );
+                        ok &= cgltf_accessor_read_float_h( attr.data, i, normals[ i ].data );
+                    }
+                    if( !primVertices.empty() )
+                    {
+                        BatchMath::PackNormals( normals.data(),
+                                                normals.size(),
+                                                &primVertices[ 0 ].normalPacked,
+                                                sizeof( RgPrimitiveVertex ) );
                     }
                     break;
+                }
 
 #if NEED_TANGENT
                 case cgltf_attribute_type_tangent:
@@ -1224,6 +1438,14 @@ RTGL1::GltfImporter::GltfImporter( const std::filesystem::path& _gltfPath,
     , parsedModel{}
     , isParsed{ false }
 {
+    const auto cacheFile = MakeSceneCacheFile( _gltfPath, _params, _textureMeta, _isReplacement );
+    if( auto cached = LoadSceneCache( cacheFile ) )
+    {
+        parsedModel = std::move( *cached );
+        isParsed    = true;
+        return;
+    }
+
     cgltf_result  r{ cgltf_result_success };
     cgltf_options options{};
     cgltf_data*   parsedData{ nullptr };
@@ -1262,6 +1484,11 @@ RTGL1::GltfImporter::GltfImporter( const std::filesystem::path& _gltfPath,
         return;
     }
 
+    if( !DecodeMeshoptBuffers( parsedData, gltfPath ) )
+    {
+        return;
+    }
+
     r = cgltf_validate( parsedData );
     if( r != cgltf_result_success )
     {
@@ -1292,6 +1519,50 @@ RTGL1::GltfImporter::GltfImporter( const std::filesystem::path& _gltfPath,
     TransformFromGltfToWorld( std::span{ &mainNode, 1 }, params.worldTransform );
     
     ParseFile( parsedData, _isReplacement, _textureMeta );
+
+    if( isParsed )
+    {
+        SaveSceneCache( cacheFile, parsedModel );
+    }
+}
+
+auto RTGL1::GltfImporter::ReadModelNames( const std::filesystem::path& gltfPath )
+    -> std::vector< std::string >
+{
+    cgltf_options options{};
+    cgltf_data*   data{ nullptr };
+
+    // only json, buffers are not loaded
+    if( cgltf_parse_file( &options, gltfPath.string().c_str(), &data ) != cgltf_result_success )
+    {
+        return {};
+    }
+
+    if( !data->scene && data->scenes_count > 0 )
+    {
+        data->scene = &data->scenes[ 0 ];
+    }
+
+    auto names = std::vector< std::string >{};
+    if( cgltf_node* mainNode = FindMainRootNode( data ) )
+    {
+        for( cgltf_node* srcNode : std::span{ mainNode->children, mainNode->children_count } )
+        {
+            if( !srcNode || nodeName( srcNode ).empty() )
+            {
+                continue;
+            }
+            // global lights are not models
+            if( srcNode->light && srcNode->children_count == 0 )
+            {
+                continue;
+            }
+            names.emplace_back( nodeName( srcNode ) );
+        }
+    }
+
+    cgltf_free( data );
+    return names;
 }
 
 void RTGL1::GltfImporter::ParseFile( cgltf_data*               data,
@@ -1329,6 +1600,185 @@ void RTGL1::GltfImporter::ParseFile( cgltf_data*               data,
 
     const cgltf_node* anim_camnode = nullptr;
 
+    // primitives of a mesh node, must not modify any shared state, as called concurrently
+    auto AppendMeshPrimitives =
+        [ this, &isReplacement, &textureMeta ](
+            std::vector< WholeModelFile::RawPrimitiveData >& target,
+            std::vector< WholeModelFile::RawMaterialData >&  targetMaterials,
+            const cgltf_node*                                atnode,
+            const RgTransform*                               transform ) {
+            if( !atnode || !atnode->mesh )
+            {
+                return;
+            }
+
+            const auto primitiveExtra_node = json_parser::ReadStringAs< PrimitiveExtraInfo >(
+                Utils::SafeCstr( atnode->extras.data ) );
+
+            // primitives
+            for( uint32_t i = 0; i < atnode->mesh->primitives_count; i++ )
+            {
+                const cgltf_primitive& srcPrim = atnode->mesh->primitives[ i ];
+
+
+                auto vertices = GatherVertices(
+                    srcPrim, gltfPath, nodeName( atnode ), nodeName( atnode->parent ) );
+                if( vertices.empty() )
+                {
+                    continue;
+                }
+                if( transform )
+                {
+                    for( auto& v : vertices )
+                    {
+                        ApplyTransformToPosition( transform, v.position );
+                        v.normalPacked = Utils::PackNormal( ApplyTransformToDirection(
+                            transform, Utils::UnpackNormal( v.normalPacked ) ) );
+                    }
+                }
+
+
+                auto indices = GatherIndices(
+                    srcPrim, gltfPath, nodeName( atnode ), nodeName( atnode->parent ) );
+                if( indices.empty() )
+                {
+                    continue;
+                }
+
+
+                const auto primitiveExtra_prim =
+                    json_parser::ReadStringAs< PrimitiveExtraInfo >(
+                        Utils::SafeCstr( srcPrim.extras.data ) );
+
+
+                RgMeshPrimitiveFlags dstFlags = 0;
+
+                if( srcPrim.material )
+                {
+                    if( srcPrim.material->alpha_mode == cgltf_alpha_mode_mask )
+                    {
+                        dstFlags |= RG_MESH_PRIMITIVE_ALPHA_TESTED;
+                    }
+                    else if( srcPrim.material->alpha_mode == cgltf_alpha_mode_blend )
+                    {
+                        debug::Warning(
+                            "Ignoring primitive of ...->{}->{}: Found blend material, "
+                            "so it requires to be uploaded each frame, and not once on load. "
+                            "{}",
+                            nodeName( atnode->parent ),
+                            nodeName( atnode ),
+                            gltfPath );
+                        continue;
+                        dstFlags |= RG_MESH_PRIMITIVE_TRANSLUCENT;
+                    }
+                }
+
+
+                auto matinfo = UploadTextures( srcPrim.material, //
+                                               isReplacement,
+                                               gltfFolder,
+                                               gltfPath );
+
+                // dummy to get flags, color, texture
+                auto dummy = RgMeshPrimitiveInfo{
+                    .sType        = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO,
+                    .flags        = dstFlags,
+                    .pTextureName = matinfo.toRegister.pTextureName.c_str(),
+                    .color        = matinfo.color,
+                    .emissive     = matinfo.emissiveMult,
+                };
+
+
+                auto extAttachedLight = std::optional< RgMeshPrimitiveAttachedLightEXT >{};
+                auto extPbr           = std::optional< RgMeshPrimitivePBREXT >{};
+
+                // use texture meta as fallback
+                {
+                    textureMeta.Modify( dummy, extAttachedLight, extPbr, true );
+                }
+
+                // gltf info has a higher priority, so overwrite
+                {
+                    extPbr = RgMeshPrimitivePBREXT{
+                        .sType            = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_PBR_EXT,
+                        .pNext            = nullptr,
+                        .metallicDefault  = matinfo.metallicFactor,
+                        .roughnessDefault = matinfo.roughnessFactor,
+                    };
+
+                    if( primitiveExtra_node.isGlass || primitiveExtra_prim.isGlass )
+                    {
+                        dummy.flags |= RG_MESH_PRIMITIVE_GLASS;
+                    }
+
+                    if( primitiveExtra_node.isMirror || primitiveExtra_prim.isMirror )
+                    {
+                        dummy.flags |= RG_MESH_PRIMITIVE_MIRROR;
+                    }
+
+                    if( primitiveExtra_node.isWater || primitiveExtra_prim.isWater )
+                    {
+                        dummy.flags |= RG_MESH_PRIMITIVE_WATER;
+                    }
+
+                    if( primitiveExtra_node.isSkyVisibility || primitiveExtra_prim.isSkyVisibility )
+                    {
+                        dummy.flags |= RG_MESH_PRIMITIVE_SKY_VISIBILITY;
+                    }
+
+                    if( primitiveExtra_node.isAcid || primitiveExtra_prim.isAcid )
+                    {
+                        dummy.flags |= RG_MESH_PRIMITIVE_ACID;
+                    }
+
+                    if( primitiveExtra_node.isThinMedia || primitiveExtra_prim.isThinMedia )
+                    {
+                        dummy.flags |= RG_MESH_PRIMITIVE_THIN_MEDIA;
+                    }
+
+                    if( primitiveExtra_node.noShadow || primitiveExtra_prim.noShadow )
+                    {
+                        dummy.flags |= RG_MESH_PRIMITIVE_NO_SHADOW;
+                    }
+                }
+
+
+                // flat normals are generated per triangle, if not provided
+                const bool exactNormals =
+                    dummy.flags & ( RG_MESH_PRIMITIVE_DONT_GENERATE_NORMALS |
+                                    RG_MESH_PRIMITIVE_FORCE_EXACT_NORMALS );
+
+                OptimizeVertexOrder( vertices, indices, exactNormals );
+
+                auto lods = GenerateLods( vertices, indices );
+
+                target.push_back( WholeModelFile::RawPrimitiveData{
+                    .vertices      = std::move( vertices ),
+                    .indices       = std::move( indices ),
+                    .flags         = dummy.flags,
+                    .textureName   = Utils::SafeCstr( dummy.pTextureName ),
+                    .color         = dummy.color,
+                    .emissive      = dummy.emissive,
+                    .attachedLight = extAttachedLight,
+                    .pbr           = extPbr,
+                    .portal        = {},
+                    .lods          = std::move( lods ),
+                } );
+                targetMaterials.push_back( std::move( matinfo.toRegister ) );
+            }
+        };
+
+    // heavy per-node conversion is deferred, to be run on multiple threads
+    struct MeshNodeJob
+    {
+        size_t                                          modelIndex;
+        const cgltf_node*                               node;
+        std::optional< RgTransform >                    transform;
+        std::vector< WholeModelFile::RawPrimitiveData > primitives{};
+        std::vector< WholeModelFile::RawMaterialData >  materials{};
+    };
+    auto meshNodeJobs = std::vector< MeshNodeJob >{};
+
 
     for( cgltf_node* srcNode : std::span{ mainNode->children, mainNode->children_count } )
     {
@@ -1397,171 +1847,18 @@ void RTGL1::GltfImporter::ParseFile( cgltf_data*               data,
                                        .animobj        = ParseNodeAnim( data, srcNode ),
                                    } );
         assert( isNew );
-        auto& result_dstModel = iter->second;
-
-
-        // mesh
-        auto AppendMeshPrimitives =
-            [ this, &isReplacement, &textureMeta ](
-                std::vector< WholeModelFile::RawPrimitiveData >& target,
-                std::vector< WholeModelFile::RawMaterialData >&  targetMaterials,
-                const cgltf_node*                                atnode,
-                const RgTransform*                               transform ) {
-                if( !atnode || !atnode->mesh )
-                {
-                    return;
-                }
-
-                const auto primitiveExtra_node = json_parser::ReadStringAs< PrimitiveExtraInfo >(
-                    Utils::SafeCstr( atnode->extras.data ) );
-
-                // primitives
-                for( uint32_t i = 0; i < atnode->mesh->primitives_count; i++ )
-                {
-                    const cgltf_primitive& srcPrim = atnode->mesh->primitives[ i ];
-
-
-                    auto vertices = GatherVertices(
-                        srcPrim, gltfPath, nodeName( atnode ), nodeName( atnode->parent ) );
-                    if( vertices.empty() )
-                    {
-                        continue;
-                    }
-                    if( transform )
-                    {
-                        for( auto& v : vertices )
-                        {
-                            ApplyTransformToPosition( transform, v.position );
-                            v.normalPacked = Utils::PackNormal( ApplyTransformToDirection(
-                                transform, Utils::UnpackNormal( v.normalPacked ) ) );
-                        }
-                    }
-
-
-                    auto indices = GatherIndices(
-                        srcPrim, gltfPath, nodeName( atnode ), nodeName( atnode->parent ) );
-                    if( indices.empty() )
-                    {
-                        continue;
-                    }
-
-
-                    const auto primitiveExtra_prim =
-                        json_parser::ReadStringAs< PrimitiveExtraInfo >(
-                            Utils::SafeCstr( srcPrim.extras.data ) );
-
-
-                    RgMeshPrimitiveFlags dstFlags = 0;
-
-                    if( srcPrim.material )
-                    {
-                        if( srcPrim.material->alpha_mode == cgltf_alpha_mode_mask )
-                        {
-                            dstFlags |= RG_MESH_PRIMITIVE_ALPHA_TESTED;
-                        }
-                        else if( srcPrim.material->alpha_mode == cgltf_alpha_mode_blend )
-                        {
-                            debug::Warning(
-                                "Ignoring primitive of ...->{}->{}: Found blend material, "
-                                "so it requires to be uploaded each frame, and not once on load. "
-                                "{}",
-                                nodeName( atnode->parent ),
-                                nodeName( atnode ),
-                                gltfPath );
-                            continue;
-                            dstFlags |= RG_MESH_PRIMITIVE_TRANSLUCENT;
-                        }
-                    }
-
-
-                    auto matinfo = UploadTextures( srcPrim.material, //
-                                                   isReplacement,
-                                                   gltfFolder,
-                                                   gltfPath );
-
-                    // dummy to get flags, color, texture
-                    auto dummy = RgMeshPrimitiveInfo{
-                        .sType        = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO,
-                        .flags        = dstFlags,
-                        .pTextureName = matinfo.toRegister.pTextureName.c_str(),
-                        .color        = matinfo.color,
-                        .emissive     = matinfo.emissiveMult,
-                    };
-
-
-                    auto extAttachedLight = std::optional< RgMeshPrimitiveAttachedLightEXT >{};
-                    auto extPbr           = std::optional< RgMeshPrimitivePBREXT >{};
-
-                    // use texture meta as fallback
-                    {
-                        textureMeta.Modify( dummy, extAttachedLight, extPbr, true );
-                    }
-
-                    // gltf info has a higher priority, so overwrite
-                    {
-                        extPbr = RgMeshPrimitivePBREXT{
-                            .sType            = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_PBR_EXT,
-                            .pNext            = nullptr,
-                            .metallicDefault  = matinfo.metallicFactor,
-                            .roughnessDefault = matinfo.roughnessFactor,
-                        };
-
-                        if( primitiveExtra_node.isGlass || primitiveExtra_prim.isGlass )
-                        {
-                            dummy.flags |= RG_MESH_PRIMITIVE_GLASS;
-                        }
-
-                        if( primitiveExtra_node.isMirror || primitiveExtra_prim.isMirror )
-                        {
-                            dummy.flags |= RG_MESH_PRIMITIVE_MIRROR;
-                        }
-
-                        if( primitiveExtra_node.isWater || primitiveExtra_prim.isWater )
-                        {
-                            dummy.flags |= RG_MESH_PRIMITIVE_WATER;
-                        }
-
-                        if( primitiveExtra_node.isSkyVisibility || primitiveExtra_prim.isSkyVisibility )
-                        {
-                            dummy.flags |= RG_MESH_PRIMITIVE_SKY_VISIBILITY;
-                        }
-
-                        if( primitiveExtra_node.isAcid || primitiveExtra_prim.isAcid )
-                        {
-                            dummy.flags |= RG_MESH_PRIMITIVE_ACID;
-                        }
-
-                        if( primitiveExtra_node.isThinMedia || primitiveExtra_prim.isThinMedia )
-                        {
-                            dummy.flags |= RG_MESH_PRIMITIVE_THIN_MEDIA;
-                        }
+        auto&      result_dstModel = iter->second;
+        const auto modelIndex      = size_t( std::distance( result.models.begin(), iter ) );
 
-                        if( primitiveExtra_node.noShadow || primitiveExtra_prim.noShadow )
-                        {
-                            dummy.flags |= RG_MESH_PRIMITIVE_NO_SHADOW;
-                        }
-                    }
 
-
-                    target.push_back( WholeModelFile::RawPrimitiveData{
-                        .vertices      = std::move( vertices ),
-                        .indices       = std::move( indices ),
-                        .flags         = dummy.flags,
-                        .textureName   = Utils::SafeCstr( dummy.pTextureName ),
-                        .color         = dummy.color,
-                        .emissive      = dummy.emissive,
-                        .attachedLight = extAttachedLight,
-                        .pbr           = extPbr,
-                        .portal        = {},
-                    } );
-                    targetMaterials.push_back( std::move( matinfo.toRegister ) );
-                }
-            };
-
-        AppendMeshPrimitives( result_dstModel.primitives, //
-                              result.materials,
-                              srcNode,
-                              nullptr );
+        if( srcNode->mesh )
+        {
+            meshNodeJobs.push_back( MeshNodeJob{
+                .modelIndex = modelIndex,
+                .node       = srcNode,
+                .transform  = std::nullopt,
+            } );
+        }
 
         ForEachChildNodeRecursively(
             [ & ]( const cgltf_node& child ) {
@@ -1569,11 +1866,16 @@ void RTGL1::GltfImporter::ParseFile( cgltf_data*               data,
                 const auto relativeTransform = MakeRgTransformRelativeTo( &child, srcNode );
 
                 // child meshes
-                AppendMeshPrimitives( result_dstModel.primitives,
-                                      result.materials,
-                                      &child,
-                                      IsAlmostIdentity( relativeTransform ) ? nullptr
-                                                                            : &relativeTransform );
+                if( child.mesh )
+                {
+                    meshNodeJobs.push_back( MeshNodeJob{
+                        .modelIndex = modelIndex,
+                        .node       = &child,
+                        .transform  = IsAlmostIdentity( relativeTransform )
+                                          ? std::nullopt
+                                          : std::optional{ relativeTransform },
+                    } );
+                }
 
                 // local lights
                 if( auto l = ParseNodeAsLight(
@@ -1586,6 +1888,49 @@ void RTGL1::GltfImporter::ParseFile( cgltf_data*               data,
     }
 
 
+    {
+        auto next = std::atomic_size_t{ 0 };
+
+        auto convertJob = [ & ]() {
+            for( size_t i = next++; i < meshNodeJobs.size(); i = next++ )
+            {
+                MeshNodeJob& job = meshNodeJobs[ i ];
+                AppendMeshPrimitives( job.primitives,
+                                      job.materials,
+                                      job.node,
+                                      job.transform ? &job.transform.value() : nullptr );
+            }
+        };
+
+        const uint32_t threadCount =
+            std::clamp( std::thread::hardware_concurrency(),
+                        1u,
+                        uint32_t( std::max< size_t >( meshNodeJobs.size(), 1 ) ) );
+
+        auto workers = std::vector< std::future< void > >{};
+        for( uint32_t t = 1; t < threadCount; t++ )
+        {
+            workers.push_back( std::async( std::launch::async, convertJob ) );
+        }
+
+        // current thread participates too
+        convertJob();
+        for( auto& w : workers )
+        {
+            w.get();
+        }
+
+        // append in the traversal order, so the result doesn't depend on the scheduling
+        for( MeshNodeJob& job : meshNodeJobs )
+        {
+            auto& dstModel = ( result.models.begin() + job.modelIndex )->second;
+
+            std::ranges::move( job.primitives, std::back_inserter( dstModel.primitives ) );
+            std::ranges::move( job.materials, std::back_inserter( result.materials ) );
+        }
+    }
+
+
     if( anim_camnode )
     {
         result.animcamera = ParseNodeAnim( data, anim_camnode );
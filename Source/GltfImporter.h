@@ -95,6 +95,15 @@ struct WholeModelFile
         bool trackOriginalTexture{ false };
     };
 
+    // Simplified version of a primitive, with its own compacted vertices
+    struct RawLodData
+    {
+        std::vector< RgPrimitiveVertex > vertices;
+        std::vector< uint32_t >          indices;
+        // max deviation from the original surface, in the local units of the primitive
+        float                            error;
+    };
+
     struct RawPrimitiveData
     {
         std::vector< RgPrimitiveVertex >                 vertices;
@@ -106,6 +115,8 @@ struct WholeModelFile
         std::optional< RgMeshPrimitiveAttachedLightEXT > attachedLight;
         std::optional< RgMeshPrimitivePBREXT >           pbr;
         std::optional< RgMeshPrimitivePortalEXT >        portal;
+        // from finer to coarser
+        std::vector< RawLodData >                        lods{};
     };
 
     struct RawModelData
@@ -139,6 +150,10 @@ public:
     GltfImporter& operator=( const GltfImporter& )     = delete;
     GltfImporter& operator=( GltfImporter&& ) noexcept = delete;
 
+    // Names of the models in a file, without loading its buffers
+    static auto ReadModelNames( const std::filesystem::path& gltfPath )
+        -> std::vector< std::string >;
+
     [[nodiscard]] auto FilePath() const { return std::string_view{ gltfPath }; }
 
     explicit operator bool() const { return isParsed; }
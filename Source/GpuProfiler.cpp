@@ -0,0 +1,353 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "GpuProfiler.h"
+
+#include <vector>
+
+namespace
+{
+
+constexpr VkQueryPipelineStatisticFlags PipelineStatisticsFlags =
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+static_assert( sizeof( RTGL1::GpuPassStatistics ) == 4 * sizeof( uint64_t ),
+               "Must match the count of bits in PipelineStatisticsFlags" );
+
+}
+
+const char* RTGL1::GpuPassName( GpuPass pass )
+{
+    switch( pass )
+    {
+        case GpuPass::AccelerationStructures: return "Acceleration structures";
+        case GpuPass::VertexPreprocessing: return "Vertex preprocessing";
+        case GpuPass::PrimaryRays: return "Primary rays";
+        case GpuPass::ReflectRefract: return "Reflections / refractions";
+        case GpuPass::DirectIllumination: return "Direct illumination";
+        case GpuPass::IndirectIllumination: return "Indirect illumination";
+        case GpuPass::Volumetric: return "Volumetric";
+        case GpuPass::Denoiser: return "Denoiser";
+        case GpuPass::Upscaler: return "Upscaler";
+        case GpuPass::Bloom: return "Bloom";
+        case GpuPass::PostEffects: return "Post effects";
+        case GpuPass::Rasterization: return "Rasterization";
+        case GpuPass::Tonemapping: return "Tonemapping";
+        case GpuPass::Fluid: return "Fluid";
+        case GpuPass::Count:
+        default: assert( 0 ); return "";
+    }
+}
+
+RTGL1::GpuProfiler::GpuProfiler( VkDevice         _device,
+                                 VkPhysicalDevice _physDevice,
+                                 uint32_t         _graphicsQueueFamilyIndex )
+    : device( _device )
+    , queryPool( VK_NULL_HANDLE )
+    , timestampPeriodNs( 0.0f )
+    , timestampMask( 0 )
+    , statsPool( VK_NULL_HANDLE )
+    , statsRequested( false )
+    , currentFrameIndex( 0 )
+    , frameActive( false )
+    , perFrame{}
+    , frameTimeMs( 0.0f )
+    , passTimeMs{}
+    , passStatistics{}
+    , history{}
+    , historyOffset( 0 )
+{
+    VkPhysicalDeviceProperties props = {};
+    vkGetPhysicalDeviceProperties( _physDevice, &props );
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties( _physDevice, &familyCount, nullptr );
+    std::vector< VkQueueFamilyProperties > families( familyCount );
+    vkGetPhysicalDeviceQueueFamilyProperties( _physDevice, &familyCount, families.data() );
+
+    const uint32_t validBits = _graphicsQueueFamilyIndex < familyCount
+                                   ? families[ _graphicsQueueFamilyIndex ].timestampValidBits
+                                   : 0;
+
+    if( validBits == 0 || props.limits.timestampPeriod <= 0.0f )
+    {
+        debug::Warning( "GPU timings are not available: "
+                        "timestamp queries are not supported on the graphics queue" );
+        return;
+    }
+
+    timestampPeriodNs = props.limits.timestampPeriod;
+    timestampMask     = validBits >= 64 ? UINT64_MAX : ( uint64_t( 1 ) << validBits ) - 1;
+
+    auto info = VkQueryPoolCreateInfo{
+        .sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType  = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = QueriesPerFrame * MAX_FRAMES_IN_FLIGHT,
+    };
+
+    VkResult r = vkCreateQueryPool( device, &info, nullptr, &queryPool );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, queryPool, VK_OBJECT_TYPE_QUERY_POOL, "GPU profiler timestamps" );
+
+    VkPhysicalDeviceFeatures features = {};
+    vkGetPhysicalDeviceFeatures( _physDevice, &features );
+
+    if( !features.pipelineStatisticsQuery )
+    {
+        debug::Info( "GPU pass pipeline statistics are not available" );
+        return;
+    }
+
+    auto statsInfo = VkQueryPoolCreateInfo{
+        .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType          = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+        .queryCount         = MaxScopesPerFrame * MAX_FRAMES_IN_FLIGHT,
+        .pipelineStatistics = PipelineStatisticsFlags,
+    };
+
+    r = vkCreateQueryPool( device, &statsInfo, nullptr, &statsPool );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, statsPool, VK_OBJECT_TYPE_QUERY_POOL, "GPU profiler statistics" );
+}
+
+RTGL1::GpuProfiler::~GpuProfiler()
+{
+    if( queryPool != VK_NULL_HANDLE )
+    {
+        vkDestroyQueryPool( device, queryPool, nullptr );
+    }
+    if( statsPool != VK_NULL_HANDLE )
+    {
+        vkDestroyQueryPool( device, statsPool, nullptr );
+    }
+}
+
+bool RTGL1::GpuProfiler::ReadBack( uint32_t frameIndex )
+{
+    PerFrame& f = perFrame[ frameIndex ];
+
+    if( !IsAvailable() || !f.written || f.scopeCount == 0 )
+    {
+        return false;
+    }
+    f.written = false;
+
+    uint64_t timestamps[ QueriesPerFrame ];
+
+    VkResult r = vkGetQueryPoolResults( device,
+                                        queryPool,
+                                        QueriesPerFrame * frameIndex,
+                                        2 * f.scopeCount,
+                                        sizeof( timestamps ),
+                                        timestamps,
+                                        sizeof( uint64_t ),
+                                        VK_QUERY_RESULT_64_BIT );
+    if( r != VK_SUCCESS )
+    {
+        return false;
+    }
+
+    auto l_toMs = [ this ]( uint64_t begin, uint64_t end ) {
+        uint64_t delta = ( end - begin ) & timestampMask;
+        return float( double( delta ) * double( timestampPeriodNs ) / 1000000.0 );
+    };
+
+    frameTimeMs = l_toMs( timestamps[ 0 ], timestamps[ 1 ] );
+    passTimeMs.fill( 0.0f );
+
+    // a pass might be split into several scopes
+    for( uint32_t i = 1; i < f.scopeCount; i++ )
+    {
+        passTimeMs[ uint32_t( f.passes[ i ] ) ] +=
+            l_toMs( timestamps[ 2 * i ], timestamps[ 2 * i + 1 ] );
+    }
+
+    history[ historyOffset ] = frameTimeMs;
+    historyOffset            = ( historyOffset + 1 ) % HistoryLength;
+
+    if( !ReadBackStatistics( frameIndex ) )
+    {
+        passStatistics = {};
+    }
+
+    return true;
+}
+
+bool RTGL1::GpuProfiler::ReadBackStatistics( uint32_t frameIndex )
+{
+    const PerFrame& f = perFrame[ frameIndex ];
+
+    if( !f.withStatistics || f.scopeCount <= 1 )
+    {
+        return false;
+    }
+
+    GpuPassStatistics stats[ MaxScopesPerFrame ];
+
+    VkResult r = vkGetQueryPoolResults( device,
+                                        statsPool,
+                                        MaxScopesPerFrame * frameIndex + 1,
+                                        f.scopeCount - 1,
+                                        sizeof( stats ),
+                                        stats,
+                                        sizeof( GpuPassStatistics ),
+                                        VK_QUERY_RESULT_64_BIT );
+    if( r != VK_SUCCESS )
+    {
+        return false;
+    }
+
+    passStatistics = {};
+
+    for( uint32_t i = 1; i < f.scopeCount; i++ )
+    {
+        const GpuPassStatistics& src = stats[ i - 1 ];
+        GpuPassStatistics&       dst = passStatistics[ uint32_t( f.passes[ i ] ) ];
+
+        dst.vertexInvocations += src.vertexInvocations;
+        dst.clippingPrimitives += src.clippingPrimitives;
+        dst.fragmentInvocations += src.fragmentInvocations;
+        dst.computeInvocations += src.computeInvocations;
+    }
+
+    return true;
+}
+
+void RTGL1::GpuProfiler::BeginFrame( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    currentFrameIndex = frameIndex;
+    frameActive       = false;
+
+    if( !IsAvailable() )
+    {
+        return;
+    }
+
+    PerFrame& f = perFrame[ frameIndex ];
+
+    f.written        = false;
+    f.scopeCount     = 1;
+    f.withStatistics = statsRequested && IsPipelineStatisticsAvailable();
+
+    const uint32_t base = QueriesPerFrame * frameIndex;
+
+    vkCmdResetQueryPool( cmd, queryPool, base, QueriesPerFrame );
+    if( f.withStatistics )
+    {
+        vkCmdResetQueryPool( cmd, statsPool, MaxScopesPerFrame * frameIndex, MaxScopesPerFrame );
+    }
+    vkCmdWriteTimestamp( cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, base );
+
+    frameActive = true;
+}
+
+void RTGL1::GpuProfiler::EndFrame( VkCommandBuffer cmd )
+{
+    if( !frameActive )
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp( cmd,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         queryPool,
+                         QueriesPerFrame * currentFrameIndex + 1 );
+
+    perFrame[ currentFrameIndex ].written = true;
+    frameActive                           = false;
+}
+
+uint32_t RTGL1::GpuProfiler::AllocateScope( VkCommandBuffer cmd, GpuPass pass )
+{
+    if( !frameActive )
+    {
+        return UINT32_MAX;
+    }
+
+    PerFrame& f = perFrame[ currentFrameIndex ];
+    if( f.scopeCount >= MaxScopesPerFrame )
+    {
+        return UINT32_MAX;
+    }
+
+    f.passes[ f.scopeCount ] = pass;
+
+    // BOTTOM_OF_PIPE: wait for the previous work, so the scopes don't overlap
+    uint32_t query = QueriesPerFrame * currentFrameIndex + 2 * f.scopeCount;
+    vkCmdWriteTimestamp( cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, query );
+
+    if( f.withStatistics )
+    {
+        vkCmdBeginQuery( cmd, statsPool, MaxScopesPerFrame * currentFrameIndex + f.scopeCount, 0 );
+    }
+
+    f.scopeCount++;
+    return query;
+}
+
+void RTGL1::GpuProfiler::FinishScope( VkCommandBuffer cmd, uint32_t query )
+{
+    if( query == UINT32_MAX || !frameActive )
+    {
+        return;
+    }
+
+    if( perFrame[ currentFrameIndex ].withStatistics )
+    {
+        uint32_t scope = ( query - QueriesPerFrame * currentFrameIndex ) / 2;
+        vkCmdEndQuery( cmd, statsPool, MaxScopesPerFrame * currentFrameIndex + scope );
+    }
+
+    vkCmdWriteTimestamp( cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, query + 1 );
+}
+
+RTGL1::GpuProfiler::Scope::Scope( GpuProfiler& _profiler, VkCommandBuffer _cmd, GpuPass _pass )
+    : profiler( &_profiler ), cmd( _cmd ), query( _profiler.AllocateScope( _cmd, _pass ) )
+{
+}
+
+RTGL1::GpuProfiler::Scope::~Scope()
+{
+    profiler->FinishScope( cmd, query );
+}
+
+RgUtilFrameTimings RTGL1::GpuProfiler::GetTimings() const
+{
+    auto l_get = [ this ]( GpuPass p ) { return GetPassTimeMs( p ); };
+
+    return RgUtilFrameTimings{
+        .frame                  = frameTimeMs,
+        .accelerationStructures = l_get( GpuPass::AccelerationStructures ),
+        .vertexPreprocessing    = l_get( GpuPass::VertexPreprocessing ),
+        .primaryRays            = l_get( GpuPass::PrimaryRays ),
+        .reflectRefract         = l_get( GpuPass::ReflectRefract ),
+        .directIllumination     = l_get( GpuPass::DirectIllumination ),
+        .indirectIllumination   = l_get( GpuPass::IndirectIllumination ),
+        .volumetric             = l_get( GpuPass::Volumetric ),
+        .denoiser               = l_get( GpuPass::Denoiser ),
+        .upscaler               = l_get( GpuPass::Upscaler ),
+        .bloom                  = l_get( GpuPass::Bloom ),
+        .postEffects            = l_get( GpuPass::PostEffects ),
+        .rasterization          = l_get( GpuPass::Rasterization ),
+    };
+}
@@ -0,0 +1,162 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+
+namespace RTGL1
+{
+
+enum class GpuPass : uint32_t
+{
+    AccelerationStructures,
+    VertexPreprocessing,
+    PrimaryRays,
+    ReflectRefract,
+    DirectIllumination,
+    IndirectIllumination,
+    Volumetric,
+    Denoiser,
+    Upscaler,
+    Bloom,
+    PostEffects,
+    Rasterization,
+    Tonemapping,
+    Fluid,
+
+    Count
+};
+
+const char* GpuPassName( GpuPass pass );
+
+// Subset of VkQueryPipelineStatisticFlagBits, in the order Vulkan writes them.
+// Ray tracing stages have no pipeline statistics, so traced passes report zeros
+struct GpuPassStatistics
+{
+    uint64_t vertexInvocations;
+    uint64_t clippingPrimitives;
+    uint64_t fragmentInvocations;
+    uint64_t computeInvocations;
+};
+
+// Measures GPU time of the frame and its passes with timestamp queries.
+// The results are read back with MAX_FRAMES_IN_FLIGHT latency, so no stall is introduced.
+// Optionally, pipeline statistics queries are recorded around each scope: they have a cost
+// on some drivers, so they are disabled by default.
+class GpuProfiler
+{
+public:
+    GpuProfiler( VkDevice device, VkPhysicalDevice physDevice, uint32_t graphicsQueueFamilyIndex );
+    ~GpuProfiler();
+
+    GpuProfiler( const GpuProfiler& other )                = delete;
+    GpuProfiler( GpuProfiler&& other ) noexcept            = delete;
+    GpuProfiler& operator=( const GpuProfiler& other )     = delete;
+    GpuProfiler& operator=( GpuProfiler&& other ) noexcept = delete;
+
+    // Must be called after the fence of 'frameIndex' was waited.
+    // Returns true, if new timings were read.
+    bool ReadBack( uint32_t frameIndex );
+
+    void BeginFrame( VkCommandBuffer cmd, uint32_t frameIndex );
+    void EndFrame( VkCommandBuffer cmd );
+
+    class Scope
+    {
+    public:
+        Scope( GpuProfiler& profiler, VkCommandBuffer cmd, GpuPass pass );
+        ~Scope();
+
+        Scope( const Scope& other )                = delete;
+        Scope( Scope&& other ) noexcept            = delete;
+        Scope& operator=( const Scope& other )     = delete;
+        Scope& operator=( Scope&& other ) noexcept = delete;
+
+    private:
+        GpuProfiler*    profiler;
+        VkCommandBuffer cmd;
+        uint32_t        query;
+    };
+
+    // Takes effect from the next BeginFrame
+    void SetPipelineStatisticsEnabled( bool enable ) { statsRequested = enable; }
+    bool IsPipelineStatisticsAvailable() const { return statsPool != VK_NULL_HANDLE; }
+    bool IsPipelineStatisticsEnabled() const { return statsRequested; }
+
+    bool  IsAvailable() const { return queryPool != VK_NULL_HANDLE; }
+    float GetFrameTimeMs() const { return frameTimeMs; }
+    float GetPassTimeMs( GpuPass pass ) const { return passTimeMs[ uint32_t( pass ) ]; }
+    const GpuPassStatistics& GetPassStatistics( GpuPass pass ) const
+    {
+        return passStatistics[ uint32_t( pass ) ];
+    }
+
+    RgUtilFrameTimings GetTimings() const;
+
+    constexpr static uint32_t HistoryLength = 128;
+    // Frame times in a ring buffer, 'GetHistoryOffset' is the oldest
+    const float* GetHistory() const { return history.data(); }
+    uint32_t     GetHistoryOffset() const { return historyOffset; }
+
+private:
+    uint32_t AllocateScope( VkCommandBuffer cmd, GpuPass pass );
+    void     FinishScope( VkCommandBuffer cmd, uint32_t query );
+    bool     ReadBackStatistics( uint32_t frameIndex );
+
+private:
+    // the first pair is the whole frame
+    constexpr static uint32_t MaxScopesPerFrame = 64;
+    constexpr static uint32_t QueriesPerFrame   = 2 * MaxScopesPerFrame;
+
+    VkDevice    device;
+    VkQueryPool queryPool;
+    float       timestampPeriodNs;
+    uint64_t    timestampMask;
+
+    // one query per scope, the first one (whole frame) is unused,
+    // as pipeline statistics queries of a pool can't be nested
+    VkQueryPool statsPool;
+    bool        statsRequested;
+
+    uint32_t currentFrameIndex;
+    bool     frameActive;
+
+    struct PerFrame
+    {
+        bool                                     written;
+        uint32_t                                 scopeCount;
+        std::array< GpuPass, MaxScopesPerFrame > passes;
+        bool                                     withStatistics;
+    };
+    PerFrame perFrame[ MAX_FRAMES_IN_FLIGHT ];
+
+    float                                           frameTimeMs;
+    std::array< float, uint32_t( GpuPass::Count ) > passTimeMs;
+
+    std::array< GpuPassStatistics, uint32_t( GpuPass::Count ) > passStatistics;
+
+    std::array< float, HistoryLength > history;
+    uint32_t                           historyOffset;
+};
+
+}
@@ -0,0 +1,447 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "HitchRecorder.h"
+
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+using Clock = std::chrono::steady_clock;
+
+// the frames after a hitch are also dumped, to catch the late GPU timings of the hitch frame
+constexpr uint32_t FramesAfterHitch = 8;
+// to not fill the disk, if the hitches are persistent
+constexpr uint32_t MaxDumpCount = 32;
+
+struct MarkerEvent
+{
+    const char*       name;
+    uint32_t          threadIndex;
+    Clock::time_point begin;
+    float             durationMs;
+};
+
+struct FrameRecord
+{
+    uint64_t                   frameId{ 0 };
+    Clock::time_point          start{};
+    float                      cpuMs{ -1.0f };
+    std::vector< MarkerEvent > markers{};
+
+    bool                                                   hasGpu{ false };
+    uint64_t                                               gpuFrameId{ 0 };
+    float                                                  gpuFrameMs{ 0 };
+    std::array< float, uint32_t( RTGL1::GpuPass::Count ) > gpuPassMs{};
+};
+
+struct State
+{
+    std::mutex       mutex;
+    std::atomic_bool enabled{ false };
+
+    std::filesystem::path folder{};
+    float                 thresholdMs{ 0 };
+
+    std::array< FrameRecord, RTGL1::hitchrecorder::HistoryFrameCount > frames{};
+    uint64_t                                                           frameCount{ 0 };
+
+    // frames that exceeded the threshold, waiting for the dump
+    std::vector< uint64_t > hitchFrameIds{};
+    uint64_t                dumpAtFrameCount{ UINT64_MAX };
+    uint32_t                dumpCount{ 0 };
+    std::future< void >     pendingWrite{};
+
+    std::atomic_uint32_t threadCounter{ 0 };
+};
+
+State& GetState()
+{
+    static State s{};
+    return s;
+}
+
+uint32_t GetThreadIndex()
+{
+    thread_local uint32_t index = GetState().threadCounter.fetch_add( 1 );
+    return index;
+}
+
+float ToMs( Clock::duration d )
+{
+    return std::chrono::duration< float, std::milli >( d ).count();
+}
+
+FrameRecord* CurrentFrame( State& s )
+{
+    return s.frameCount > 0 ? &s.frames[ ( s.frameCount - 1 ) % s.frames.size() ] : nullptr;
+}
+
+void MarkAsHitch( State& s, uint64_t frameId )
+{
+    if( s.dumpCount >= MaxDumpCount )
+    {
+        return;
+    }
+
+    s.hitchFrameIds.push_back( frameId );
+    if( s.dumpAtFrameCount == UINT64_MAX )
+    {
+        s.dumpAtFrameCount = s.frameCount + FramesAfterHitch;
+    }
+}
+
+// Chrome trace event format: open in chrome://tracing or ui.perfetto.dev
+std::string MakeTrace( const State& s )
+{
+    auto records = std::vector< const FrameRecord* >{};
+    for( uint64_t i = s.frameCount - std::min< uint64_t >( s.frameCount, s.frames.size() );
+         i < s.frameCount;
+         i++ )
+    {
+        records.push_back( &s.frames[ i % s.frames.size() ] );
+    }
+    if( records.empty() )
+    {
+        return {};
+    }
+
+    const Clock::time_point origin = records.front()->start;
+
+    auto l_us = [ &origin ]( Clock::time_point t ) {
+        return std::chrono::duration< double, std::micro >( t - origin ).count();
+    };
+    auto l_findStart = [ &records ]( uint64_t frameId ) -> const Clock::time_point* {
+        for( const FrameRecord* r : records )
+        {
+            if( r->frameId == frameId )
+            {
+                return &r->start;
+            }
+        }
+        return nullptr;
+    };
+
+    auto str = std::string{};
+    str.reserve( 256 * 1024 );
+
+    auto l_event = [ &str ]( std::string_view name,
+                             std::string_view cat,
+                             uint32_t         pid,
+                             uint32_t         tid,
+                             double           tsUs,
+                             double           durUs ) {
+        std::format_to( std::back_inserter( str ),
+                        R"(  {{"name":"{}","cat":"{}","ph":"X","pid":{},"tid":{},)"
+                        R"("ts":{:.3f},"dur":{:.3f}}},)"
+                        "\n",
+                        name,
+                        cat,
+                        pid,
+                        tid,
+                        tsUs,
+                        durUs );
+    };
+
+    str += "{\n";
+    str += R"("displayTimeUnit":"ms",)";
+    str += "\n";
+    std::format_to(
+        std::back_inserter( str ), R"("otherData":{{"thresholdMs":{:.3f}}},)", s.thresholdMs );
+    str += "\n";
+    str += R"("traceEvents":[)";
+    str += "\n";
+    str += R"(  {"name":"process_name","ph":"M","pid":0,"args":{"name":"CPU"}},)";
+    str += "\n";
+    str += R"(  {"name":"process_name","ph":"M","pid":1,"args":{"name":"GPU"}},)";
+    str += "\n";
+    // thread indices of the CPU profiler are not the same as of the markers
+    str += R"(  {"name":"process_name","ph":"M","pid":2,"args":{"name":"CPU zones"}},)";
+    str += "\n";
+
+    for( const FrameRecord* r : records )
+    {
+        const bool isHitch =
+            std::ranges::find( s.hitchFrameIds, r->frameId ) != s.hitchFrameIds.end();
+
+        // the last frame is not finished yet
+        if( r->cpuMs >= 0 )
+        {
+            l_event( std::format( "Frame {}{}", r->frameId, isHitch ? " (hitch)" : "" ),
+                     "frame",
+                     0,
+                     0,
+                     l_us( r->start ),
+                     r->cpuMs * 1000.0 );
+        }
+
+        for( const MarkerEvent& m : r->markers )
+        {
+            l_event(
+                m.name, "marker", 0, m.threadIndex + 1, l_us( m.begin ), m.durationMs * 1000.0 );
+        }
+
+        if( r->hasGpu )
+        {
+            if( const Clock::time_point* gpuStart = l_findStart( r->gpuFrameId ) )
+            {
+                double ts = l_us( *gpuStart );
+                l_event( std::format( "GPU frame {}", r->gpuFrameId ),
+                         "gpu",
+                         1,
+                         0,
+                         ts,
+                         r->gpuFrameMs * 1000.0 );
+
+                // only the durations are known, so lay the passes out sequentially
+                for( uint32_t p = 0; p < r->gpuPassMs.size(); p++ )
+                {
+                    if( r->gpuPassMs[ p ] > 0 )
+                    {
+                        l_event( RTGL1::GpuPassName( RTGL1::GpuPass( p ) ),
+                                 "gpu",
+                                 1,
+                                 1,
+                                 ts,
+                                 r->gpuPassMs[ p ] * 1000.0 );
+                        ts += r->gpuPassMs[ p ] * 1000.0;
+                    }
+                }
+            }
+        }
+    }
+
+    if constexpr( RTGL1::cpuprofiler::IsEnabled() )
+    {
+        auto events = std::vector< RTGL1::cpuprofiler::ZoneEvent >( 4096 );
+        events.resize( RTGL1::cpuprofiler::GetRecentEvents( events.data(), events.size() ) );
+
+        for( const auto& e : events )
+        {
+            if( const Clock::time_point* frameStart = l_findStart( e.frameId ) )
+            {
+                l_event( e.name,
+                         "zone",
+                         2,
+                         e.threadIndex,
+                         l_us( *frameStart ) + e.beginMs * 1000.0,
+                         e.durationMs * 1000.0 );
+            }
+        }
+    }
+
+    // remove the trailing comma
+    if( str.ends_with( ",\n" ) )
+    {
+        str.resize( str.size() - 2 );
+        str += "\n";
+    }
+    str += "]\n}\n";
+    return str;
+}
+
+void Dump( State& s )
+{
+    std::string trace = MakeTrace( s );
+    if( trace.empty() )
+    {
+        return;
+    }
+
+    const uint64_t firstHitch = s.hitchFrameIds.empty() ? 0 : s.hitchFrameIds[ 0 ];
+    const auto     path       = s.folder / std::format( "hitch_{}.json", firstHitch );
+
+    RTGL1::debug::Info( "Hitch recorder: {} frame(s) over {:.1f} ms, writing {}",
+                        s.hitchFrameIds.size(),
+                        s.thresholdMs,
+                        path.string() );
+
+    // a previous write might still be in progress
+    if( s.pendingWrite.valid() )
+    {
+        s.pendingWrite.wait();
+    }
+
+    // don't add a stall on top of the hitch
+    s.pendingWrite = std::async(
+        std::launch::async, [ path, folder = s.folder, trace = std::move( trace ) ]() {
+            std::error_code ec;
+            std::filesystem::create_directories( folder, ec );
+
+            auto f = std::ofstream( path, std::ios::trunc );
+            if( !f )
+            {
+                RTGL1::debug::Warning( "Hitch recorder: failed to write {}", path.string() );
+                return;
+            }
+            f << trace;
+        } );
+
+    s.dumpCount++;
+}
+
+}
+
+void RTGL1::hitchrecorder::Enable( const std::filesystem::path& outputFolder, float thresholdMs )
+{
+    State& s    = GetState();
+    auto   lock = std::lock_guard{ s.mutex };
+
+    s.folder      = outputFolder;
+    s.thresholdMs = std::max( thresholdMs, 1.0f );
+    s.frameCount  = 0;
+    s.hitchFrameIds.clear();
+    s.dumpAtFrameCount = UINT64_MAX;
+    s.dumpCount        = 0;
+
+    s.enabled.store( true );
+}
+
+void RTGL1::hitchrecorder::Disable()
+{
+    State& s    = GetState();
+    auto   lock = std::lock_guard{ s.mutex };
+
+    s.enabled.store( false );
+
+    if( s.pendingWrite.valid() )
+    {
+        s.pendingWrite.wait();
+    }
+}
+
+bool RTGL1::hitchrecorder::IsEnabled()
+{
+    return GetState().enabled.load( std::memory_order_relaxed );
+}
+
+void RTGL1::hitchrecorder::BeginFrame( uint64_t frameId )
+{
+    if( !IsEnabled() )
+    {
+        return;
+    }
+
+    const auto now = Clock::now();
+
+    State& s    = GetState();
+    auto   lock = std::lock_guard{ s.mutex };
+
+    if( FrameRecord* prev = CurrentFrame( s ) )
+    {
+        prev->cpuMs = ToMs( now - prev->start );
+
+        if( prev->cpuMs > s.thresholdMs )
+        {
+            MarkAsHitch( s, prev->frameId );
+        }
+    }
+
+    if( s.frameCount >= s.dumpAtFrameCount )
+    {
+        Dump( s );
+        s.hitchFrameIds.clear();
+        s.dumpAtFrameCount = UINT64_MAX;
+    }
+
+    FrameRecord& r = s.frames[ s.frameCount % s.frames.size() ];
+    {
+        r.frameId = frameId;
+        r.start   = now;
+        r.cpuMs   = -1.0f;
+        r.markers.clear();
+        r.hasGpu = false;
+    }
+    s.frameCount++;
+}
+
+void RTGL1::hitchrecorder::AddGpuTimings( uint64_t gpuFrameId, const GpuProfiler& gpuProfiler )
+{
+    if( !IsEnabled() )
+    {
+        return;
+    }
+
+    State& s    = GetState();
+    auto   lock = std::lock_guard{ s.mutex };
+
+    FrameRecord* r = CurrentFrame( s );
+    if( !r )
+    {
+        return;
+    }
+
+    r->hasGpu     = true;
+    r->gpuFrameId = gpuFrameId;
+    r->gpuFrameMs = gpuProfiler.GetFrameTimeMs();
+    for( uint32_t p = 0; p < r->gpuPassMs.size(); p++ )
+    {
+        r->gpuPassMs[ p ] = gpuProfiler.GetPassTimeMs( GpuPass( p ) );
+    }
+
+    if( r->gpuFrameMs > s.thresholdMs )
+    {
+        MarkAsHitch( s, gpuFrameId );
+    }
+}
+
+RTGL1::hitchrecorder::Marker::Marker( const char* pName )
+    : name( pName ), begin{}, active( IsEnabled() )
+{
+    if( active )
+    {
+        begin = Clock::now();
+    }
+}
+
+RTGL1::hitchrecorder::Marker::~Marker()
+{
+    if( !active )
+    {
+        return;
+    }
+
+    const auto end = Clock::now();
+
+    State& s    = GetState();
+    auto   lock = std::lock_guard{ s.mutex };
+
+    // attributed to the frame where the marker has ended
+    if( FrameRecord* r = CurrentFrame( s ) )
+    {
+        r->markers.push_back( MarkerEvent{
+            .name        = name,
+            .threadIndex = GetThreadIndex(),
+            .begin       = begin,
+            .durationMs  = ToMs( end - begin ),
+        } );
+    }
+}
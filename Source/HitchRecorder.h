@@ -0,0 +1,74 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "CpuProfiler.h"
+
+#include <chrono>
+#include <filesystem>
+
+namespace RTGL1
+{
+
+class GpuProfiler;
+
+// Keeps the last frames' markers, CPU zones and GPU pass timings in a ring buffer.
+// If a frame takes longer than the threshold, the buffer is written to a file
+// in the Chrome trace event format, to see which subsystem stalled.
+// Unlike the CPU profiler, the markers are always compiled in, and cost
+// a single atomic load, if the recorder is disabled
+namespace hitchrecorder
+{
+    constexpr uint32_t HistoryFrameCount = 120;
+
+    void Enable( const std::filesystem::path& outputFolder, float thresholdMs );
+    void Disable();
+    bool IsEnabled();
+
+    // Finish the previous frame: if it was a hitch, dump the history
+    void BeginFrame( uint64_t frameId );
+    // 'gpuFrameId' is the frame which the timings were measured for
+    void AddGpuTimings( uint64_t gpuFrameId, const GpuProfiler& gpuProfiler );
+
+    class Marker
+    {
+    public:
+        explicit Marker( const char* pName );
+        ~Marker();
+
+        Marker( const Marker& other )                = delete;
+        Marker( Marker&& other ) noexcept            = delete;
+        Marker& operator=( const Marker& other )     = delete;
+        Marker& operator=( Marker&& other ) noexcept = delete;
+
+    private:
+        const char*                           name;
+        std::chrono::steady_clock::time_point begin;
+        bool                                  active;
+    };
+}
+}
+
+// Mark the current scope as a potential stall source: recorded by the hitch recorder,
+// and measured as a CPU zone. 'name' must be a string literal
+#define RG_HITCH_MARKER( name ) \
+    RG_CPU_ZONE( name );        \
+    RTGL1::hitchrecorder::Marker RG_CPU_ZONE_CONCAT( rgHitchMarker_, __LINE__ )( name )
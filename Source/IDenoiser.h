@@ -0,0 +1,45 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Common.h"
+
+namespace RTGL1
+{
+
+class GlobalUniform;
+
+// A denoiser backend. It's called after the illumination is traced and the gradients
+// are calculated; must read the unfiltered direct diffuse, specular and indirect
+// illumination, the G-buffer and motion vectors, and write the denoised
+// and composed illumination to FB_IMAGE_INDEX_PRE_FINAL.
+// All framebuffers that are accessed must be synchronized by the backend itself.
+class IDenoiser
+{
+public:
+    virtual ~IDenoiser() = default;
+
+    virtual void Denoise( VkCommandBuffer                               cmd,
+                          uint32_t                                      frameIndex,
+                          const std::shared_ptr< const GlobalUniform >& uniform ) = 0;
+};
+
+}
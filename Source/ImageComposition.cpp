@@ -92,6 +92,11 @@ void RTGL1::ImageComposition::PrepareForRaster( VkCommandBuffer      cmd,
 
 void RTGL1::ImageComposition::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { "CPrepareFinal", "CCheckerboard" } ) )
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines( shaderManager );
 }
@@ -137,11 +142,11 @@ void RTGL1::ImageComposition::Finalize( VkCommandBuffer                     cmd,
                              nullptr );
 
 
-    vkCmdDispatch(
-        cmd,
-        Utils::GetWorkGroupCount( uniform.GetData()->renderWidth, COMPUTE_COMPOSE_GROUP_SIZE_X ),
-        Utils::GetWorkGroupCount( uniform.GetData()->renderHeight, COMPUTE_COMPOSE_GROUP_SIZE_Y ),
-        1 );
+    Utils::DispatchFullscreen( cmd,
+                               uniform.GetData()->renderWidth,
+                               uniform.GetData()->renderHeight,
+                               COMPUTE_COMPOSE_GROUP_SIZE_X,
+                               COMPUTE_COMPOSE_GROUP_SIZE_Y );
 }
 
 void RTGL1::ImageComposition::ProcessCheckerboard( VkCommandBuffer      cmd,
@@ -181,12 +186,11 @@ void RTGL1::ImageComposition::ProcessCheckerboard( VkCommandBuffer      cmd,
 
 
     // start compute shader
-    uint32_t wgCountX =
-        Utils::GetWorkGroupCount( uniform->GetData()->renderWidth, COMPUTE_COMPOSE_GROUP_SIZE_X );
-    uint32_t wgCountY =
-        Utils::GetWorkGroupCount( uniform->GetData()->renderHeight, COMPUTE_COMPOSE_GROUP_SIZE_Y );
-
-    vkCmdDispatch( cmd, wgCountX, wgCountY, 1 );
+    Utils::DispatchFullscreen( cmd,
+                               uniform->GetData()->renderWidth,
+                               uniform->GetData()->renderHeight,
+                               COMPUTE_COMPOSE_GROUP_SIZE_X,
+                               COMPUTE_COMPOSE_GROUP_SIZE_Y );
 }
 
 VkPipelineLayout RTGL1::ImageComposition::CreatePipelineLayout( VkDevice               device,
@@ -294,7 +298,7 @@ void RTGL1::ImageComposition::CreatePipelines( const ShaderManager* shaderManage
         };
 
         VkResult r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &composePipeline );
+            device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &composePipeline );
 
         VK_CHECKERROR( r );
         SET_DEBUG_NAME( device, composePipeline, VK_OBJECT_TYPE_PIPELINE, "Composition pipeline" );
@@ -307,7 +311,7 @@ void RTGL1::ImageComposition::CreatePipelines( const ShaderManager* shaderManage
         };
 
         VkResult r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &checkerboardPipeline );
+            device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &checkerboardPipeline );
 
         VK_CHECKERROR( r );
         SET_DEBUG_NAME(
@@ -20,15 +20,129 @@
 
 #include "ImageLoader.h"
 
+#include "Utils.h"
+
 #include <ktx.h>
 #include <ktxvulkan.h>
+#include <KHR/khr_df.h>
 
 #include <algorithm>
 #include <cassert>
+#include <fstream>
+#include <mutex>
+
+namespace RTGL1
+{
+extern bool g_supportsMemoryDecompression;
+}
+
+namespace
+{
+
+struct Ktx2Header
+{
+    uint8_t  identifier[ 12 ];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+static_assert( sizeof( Ktx2Header ) == 80 );
+
+struct Ktx2LevelIndex
+{
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+static_assert( sizeof( Ktx2LevelIndex ) == 24 );
+
+constexpr uint8_t Ktx2Identifier[] = {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A,
+};
+static_assert( sizeof( Ktx2Identifier ) == sizeof( Ktx2Header::identifier ) );
+
+// Vendor scheme: each level is split into pages of ImageLoader::GDeflatePageSize bytes,
+// every page is compressed as a separate GDeflate stream, streams are stored contiguously.
+// Supercompression global data is an array of uint32 compressed page sizes,
+// for all pages of level 0, then of level 1, etc
+constexpr uint32_t Ktx2SupercompressionGDeflate = 0x10001;
+
+// Basis Universal (ETC1S / UASTC) textures must be transcoded to a GPU format.
+// Zstd supercompression is inflated by libktx on load
+bool TranscodeIfNeeded( ktxTexture* pTexture, const std::filesystem::path& path )
+{
+    if( pTexture->classId != ktxTexture2_c )
+    {
+        return true;
+    }
+
+    auto ktx2 = reinterpret_cast< ktxTexture2* >( pTexture );
+
+    if( !ktxTexture2_NeedsTranscoding( ktx2 ) )
+    {
+        return true;
+    }
+
+#if RG_USE_BASIS_TRANSCODER
+    // the channel count is used as a hint of the texture's role:
+    // height maps have 1 channel, normal maps (encoded with normal mode) have 2
+    const bool isSRGB = ktxTexture2_GetOETF( ktx2 ) == KHR_DF_TRANSFER_SRGB;
+
+    ktx_transcode_fmt_e target;
+    switch( ktxTexture2_GetNumComponents( ktx2 ) )
+    {
+        case 1: target = isSRGB ? KTX_TTF_BC7_RGBA : KTX_TTF_BC4_R; break;
+        case 2: target = isSRGB ? KTX_TTF_BC7_RGBA : KTX_TTF_BC5_RG; break;
+        default: target = KTX_TTF_BC7_RGBA; break;
+    }
+
+    // transcoder initializes its global tables on the first call
+    static std::once_flag s_init;
+
+    auto r       = KTX_error_code{ KTX_SUCCESS };
+    bool wasInit = false;
+    std::call_once( s_init, [ & ] {
+        r       = ktxTexture2_TranscodeBasis( ktx2, target, 0 );
+        wasInit = true;
+    } );
+    if( !wasInit )
+    {
+        r = ktxTexture2_TranscodeBasis( ktx2, target, 0 );
+    }
+
+    if( r != KTX_SUCCESS )
+    {
+        RTGL1::debug::Warning(
+            "Failed to transcode {}: {}", path.string(), ktxErrorString( r ) );
+        return false;
+    }
+    return true;
+#else
+    RTGL1::debug::Warning( "Basis Universal textures are not supported, "
+                           "build with RG_WITH_BASIS_TRANSCODER: {}",
+                           path.string() );
+    return false;
+#endif
+}
+
+}
 
 RTGL1::ImageLoader::~ImageLoader()
 {
     assert( loadedImages.empty() );
+    assert( mappedFiles.empty() );
 }
 
 bool RTGL1::ImageLoader::LoadTextureFile( const std::filesystem::path& path,
@@ -37,7 +151,162 @@ bool RTGL1::ImageLoader::LoadTextureFile( const std::filesystem::path& path,
     KTX_error_code r = ktxTexture_CreateFromNamedFile(
         path.string().c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, ppTexture );
 
-    return r == KTX_SUCCESS;
+    if( r != KTX_SUCCESS )
+    {
+        return false;
+    }
+
+    if( !TranscodeIfNeeded( *ppTexture, path ) )
+    {
+        ktxTexture_Destroy( *ppTexture );
+        *ppTexture = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoader::LoadMapped(
+    const std::filesystem::path& path )
+{
+    MappedFile f = {};
+    if( !Utils::MapFile( path, &f.view, &f.size, &f.handle ) )
+    {
+        return std::nullopt;
+    }
+
+    const auto* bytes = static_cast< const uint8_t* >( f.view );
+
+    const auto isDirectlyUsable = [ & ]( const Ktx2Header& h ) {
+        if( std::memcmp( h.identifier, Ktx2Identifier, sizeof( Ktx2Identifier ) ) != 0 )
+        {
+            return false;
+        }
+        // Basis Universal and supercompressed data must go through libktx
+        if( h.vkFormat == VK_FORMAT_UNDEFINED )
+        {
+            return false;
+        }
+        if( h.supercompressionScheme == Ktx2SupercompressionGDeflate )
+        {
+            if( !g_supportsMemoryDecompression )
+            {
+                debug::Warning( "GDeflate textures require VK_NV_memory_decompression: {}",
+                                path.string() );
+                return false;
+            }
+            if( h.sgdByteOffset % alignof( uint32_t ) != 0 || h.sgdByteOffset > f.size ||
+                h.sgdByteLength > f.size - h.sgdByteOffset )
+            {
+                return false;
+            }
+        }
+        else if( h.supercompressionScheme != 0 )
+        {
+            return false;
+        }
+        if( h.pixelWidth == 0 || h.pixelHeight == 0 || h.pixelDepth > 1 )
+        {
+            return false;
+        }
+        if( h.layerCount > 1 || h.faceCount != 1 )
+        {
+            return false;
+        }
+        const auto levelCount = std::max( h.levelCount, 1u );
+        return sizeof( Ktx2Header ) + levelCount * sizeof( Ktx2LevelIndex ) <= f.size;
+    };
+
+    Ktx2Header header = {};
+    if( f.size < sizeof( Ktx2Header ) )
+    {
+        Utils::UnmapFile( f.view, f.size, f.handle );
+        return std::nullopt;
+    }
+    std::memcpy( &header, bytes, sizeof( Ktx2Header ) );
+
+    if( !isDirectlyUsable( header ) )
+    {
+        Utils::UnmapFile( f.view, f.size, f.handle );
+        return std::nullopt;
+    }
+
+    // levelCount=0 requests runtime mipmap generation
+    const uint32_t levelCount =
+        std::min( std::max( header.levelCount, 1u ), MAX_PREGENERATED_MIPMAP_LEVELS );
+
+    Ktx2LevelIndex levels[ MAX_PREGENERATED_MIPMAP_LEVELS ] = {};
+    std::memcpy( levels, bytes + sizeof( Ktx2Header ), levelCount * sizeof( Ktx2LevelIndex ) );
+
+    // level data is stored from the smallest mip to the largest
+    uint64_t begin = UINT64_MAX;
+    uint64_t end   = 0;
+    for( uint32_t i = 0; i < levelCount; i++ )
+    {
+        if( levels[ i ].byteLength == 0 || levels[ i ].byteOffset > f.size ||
+            levels[ i ].byteLength > f.size - levels[ i ].byteOffset )
+        {
+            Utils::UnmapFile( f.view, f.size, f.handle );
+            return std::nullopt;
+        }
+        begin = std::min( begin, levels[ i ].byteOffset );
+        end   = std::max( end, levels[ i ].byteOffset + levels[ i ].byteLength );
+    }
+
+    ResultInfo result = {
+        .levelOffsets   = {},
+        .levelSizes     = {},
+        .levelCount     = levelCount,
+        .isPregenerated = true,
+        .pData          = bytes + begin,
+        .dataSize       = size_t( end - begin ),
+        .baseSize       = { header.pixelWidth, header.pixelHeight },
+        .format         = VkFormat( header.vkFormat ),
+    };
+
+    for( uint32_t i = 0; i < levelCount; i++ )
+    {
+        result.levelOffsets[ i ] = size_t( levels[ i ].byteOffset - begin );
+        result.levelSizes[ i ]   = size_t( levels[ i ].byteLength );
+    }
+
+    if( header.supercompressionScheme == Ktx2SupercompressionGDeflate )
+    {
+        const auto* pageSizes =
+            reinterpret_cast< const uint32_t* >( bytes + header.sgdByteOffset );
+
+        const uint64_t pageSizesCount = header.sgdByteLength / sizeof( uint32_t );
+
+        uint64_t firstPage = 0;
+        for( uint32_t i = 0; i < levelCount; i++ )
+        {
+            const uint64_t pageCount =
+                GDeflatePageCount( size_t( levels[ i ].uncompressedByteLength ) );
+
+            uint64_t compressedSize = 0;
+            for( uint64_t p = firstPage; p < firstPage + pageCount && p < pageSizesCount; p++ )
+            {
+                compressedSize += pageSizes[ p ];
+            }
+
+            // streams must exactly cover the level data
+            if( pageCount == 0 || firstPage + pageCount > pageSizesCount ||
+                compressedSize != levels[ i ].byteLength )
+            {
+                debug::Warning( "Malformed GDeflate page table in {}", path.string() );
+                Utils::UnmapFile( f.view, f.size, f.handle );
+                return std::nullopt;
+            }
+
+            result.levelPageSizes[ i ]         = pageSizes + firstPage;
+            result.levelDecompressedSizes[ i ] = size_t( levels[ i ].uncompressedByteLength );
+
+            firstPage += pageCount;
+        }
+    }
+
+    mappedFiles.push_back( f );
+    return result;
 }
 
 std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoader::Load(
@@ -48,6 +317,12 @@ std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoader::Load(
         return std::nullopt;
     }
 
+    // avoid reading the whole file into a temporary heap allocation
+    if( auto mapped = LoadMapped( path ) )
+    {
+        return mapped;
+    }
+
     ktxTexture* pTexture = nullptr;
     bool        loaded   = LoadTextureFile( path, &pTexture );
 
@@ -151,4 +426,102 @@ void RTGL1::ImageLoader::FreeLoaded()
     }
 
     loadedImages.clear();
+
+    for( const MappedFile& f : mappedFiles )
+    {
+        Utils::UnmapFile( f.view, f.size, f.handle );
+    }
+
+    mappedFiles.clear();
+}
+
+bool RTGL1::ImageLoader::WriteRGBA8( const std::filesystem::path& path,
+                                     const uint8_t*               pData,
+                                     const RgExtent2D&            size,
+                                     bool                         isSRGB )
+{
+    constexpr uint32_t SampleCount = 4;
+    constexpr uint32_t DfdWords    = 1 + KHR_DFDSIZEWORDS( SampleCount );
+
+    // data format descriptor of VK_FORMAT_R8G8B8A8_*, as vk2dfd would make it
+    uint32_t dfd[ DfdWords ] = {};
+    {
+        dfd[ 0 ]      = sizeof( dfd );
+        uint32_t* bdb = &dfd[ 1 ];
+
+        KHR_DFDSETVAL( bdb, VENDORID, KHR_DF_VENDORID_KHRONOS );
+        KHR_DFDSETVAL( bdb, DESCRIPTORTYPE, KHR_DF_KHR_DESCRIPTORTYPE_BASICFORMAT );
+        KHR_DFDSETVAL( bdb, VERSIONNUMBER, KHR_DF_VERSIONNUMBER_LATEST );
+        KHR_DFDSETVAL( bdb, DESCRIPTORBLOCKSIZE, uint32_t( sizeof( dfd ) - sizeof( dfd[ 0 ] ) ) );
+        KHR_DFDSETVAL( bdb, MODEL, KHR_DF_MODEL_RGBSDA );
+        KHR_DFDSETVAL( bdb, PRIMARIES, KHR_DF_PRIMARIES_BT709 );
+        KHR_DFDSETVAL( bdb, TRANSFER, isSRGB ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR );
+        KHR_DFDSETVAL( bdb, FLAGS, KHR_DF_FLAG_ALPHA_STRAIGHT );
+        KHR_DFDSETVAL( bdb, BYTESPLANE0, 4 );
+
+        constexpr uint32_t channels[ SampleCount ] = {
+            KHR_DF_CHANNEL_RGBSDA_RED,
+            KHR_DF_CHANNEL_RGBSDA_GREEN,
+            KHR_DF_CHANNEL_RGBSDA_BLUE,
+            KHR_DF_CHANNEL_RGBSDA_ALPHA,
+        };
+        for( uint32_t s = 0; s < SampleCount; s++ )
+        {
+            KHR_DFDSETSVAL( bdb, s, BITOFFSET, s * 8 );
+            KHR_DFDSETSVAL( bdb, s, BITLENGTH, 8 - 1 );
+            KHR_DFDSETSVAL( bdb, s, CHANNELID, channels[ s ] );
+            // alpha is never sRGB-encoded
+            if( isSRGB && channels[ s ] == KHR_DF_CHANNEL_RGBSDA_ALPHA )
+            {
+                KHR_DFDSETSVAL( bdb, s, QUALIFIERS, KHR_DF_SAMPLE_DATATYPE_LINEAR );
+            }
+            KHR_DFDSETSVAL( bdb, s, SAMPLELOWER, 0 );
+            KHR_DFDSETSVAL( bdb, s, SAMPLEUPPER, 255 );
+        }
+    }
+
+    const uint64_t dataSize   = uint64_t{ size.width } * size.height * 4;
+    const uint32_t dfdOffset  = sizeof( Ktx2Header ) + sizeof( Ktx2LevelIndex );
+    const uint64_t dataOffset = dfdOffset + sizeof( dfd );
+    static_assert( ( sizeof( Ktx2Header ) + sizeof( Ktx2LevelIndex ) + sizeof( dfd ) ) % 4 == 0,
+                   "Level data must be aligned to the texel size" );
+
+    auto header = Ktx2Header{
+        .identifier             = {},
+        .vkFormat               = isSRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM,
+        .typeSize               = 1,
+        .pixelWidth             = size.width,
+        .pixelHeight            = size.height,
+        .pixelDepth             = 0,
+        .layerCount             = 0,
+        .faceCount              = 1,
+        .levelCount             = 1,
+        .supercompressionScheme = 0,
+        .dfdByteOffset          = dfdOffset,
+        .dfdByteLength          = sizeof( dfd ),
+        .kvdByteOffset          = 0,
+        .kvdByteLength          = 0,
+        .sgdByteOffset          = 0,
+        .sgdByteLength          = 0,
+    };
+    std::memcpy( header.identifier, Ktx2Identifier, sizeof( Ktx2Identifier ) );
+
+    auto level = Ktx2LevelIndex{
+        .byteOffset             = dataOffset,
+        .byteLength             = dataSize,
+        .uncompressedByteLength = dataSize,
+    };
+
+    auto file = std::ofstream( path, std::ios::binary | std::ios::trunc );
+    if( !file )
+    {
+        return false;
+    }
+
+    file.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    file.write( reinterpret_cast< const char* >( &level ), sizeof( level ) );
+    file.write( reinterpret_cast< const char* >( dfd ), sizeof( dfd ) );
+    file.write( reinterpret_cast< const char* >( pData ), std::streamsize( dataSize ) );
+
+    return file.good();
 }
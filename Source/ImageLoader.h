@@ -48,8 +48,24 @@ public:
         size_t         dataSize;
         RgExtent2D     baseSize;
         VkFormat       format;
+
+        // If not null, the level is a sequence of GDeflate streams, each inflates to
+        // GDeflatePageSize bytes (except the last one): these are their compressed sizes.
+        // Then levelSizes are the compressed sizes of the levels
+        const uint32_t* levelPageSizes[ MAX_PREGENERATED_MIPMAP_LEVELS ]         = {};
+        size_t          levelDecompressedSizes[ MAX_PREGENERATED_MIPMAP_LEVELS ] = {};
+
+        bool IsGDeflate() const { return levelPageSizes[ 0 ] != nullptr; }
     };
 
+    // Max size of a memory region that VK_NV_memory_decompression inflates at once
+    constexpr static size_t GDeflatePageSize = 65536;
+
+    static size_t GDeflatePageCount( size_t decompressedSize )
+    {
+        return ( decompressedSize + GDeflatePageSize - 1 ) / GDeflatePageSize;
+    }
+
     struct LayeredResultInfo
     {
         std::vector< const uint8_t* > layerData;
@@ -73,6 +89,12 @@ public:
     // Must be called after using the loaded data to free the allocated memory
     void FreeLoaded();
 
+    // Write a KTX2 file with a single uncompressed level, that can be read by Load
+    static bool WriteRGBA8( const std::filesystem::path& path,
+                            const uint8_t*               pData,
+                            const RgExtent2D&            size,
+                            bool                         isSRGB );
+
     static auto GetExtensions()
     {
         static const char* arr[] = { ".ktx2" };
@@ -83,8 +105,21 @@ public:
 private:
     bool LoadTextureFile( const std::filesystem::path& path, ktxTexture** ppTexture );
 
+    // Parse KTX2 header of a memory-mapped file, and reference level data
+    // without copying, if the file doesn't require inflation / transcoding.
+    // GDeflate level data is referenced as is, to be inflated on GPU
+    std::optional< ResultInfo > LoadMapped( const std::filesystem::path& path );
+
+    struct MappedFile
+    {
+        void*  view;
+        size_t size;
+        void*  handle;
+    };
+
 private:
     std::vector< ktxTexture* > loadedImages;
+    std::vector< MappedFile >  mappedFiles;
 };
 
 }
\ No newline at end of file
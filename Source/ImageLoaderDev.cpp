@@ -20,7 +20,11 @@
 
 #include "ImageLoaderDev.h"
 
+#include "Containers.h"
+
 #include <cassert>
+#include <format>
+#include <thread>
 
 #include "Stb/stb_image.h"
 
@@ -29,6 +33,79 @@ RTGL1::ImageLoaderDev::~ImageLoaderDev()
     assert( loadedImages.empty() );
 }
 
+namespace
+{
+
+// Increment, if the contents of cache files change, so the old ones are not read
+constexpr uint32_t DEV_TEXTURE_CACHE_VERSION = 1;
+
+// Length of the key in a cache file name
+constexpr size_t DEV_TEXTURE_CACHE_KEY_LENGTH = 16;
+constexpr auto   DEV_TEXTURE_CACHE_EXTENSION  = std::string_view{ ".ktx2" };
+
+// Cache files of the source file, other than 'keep', are outdated
+void RemoveOutdatedCacheFiles( const std::filesystem::path& sourcePath,
+                               const std::filesystem::path& keep )
+{
+    const auto prefix = sourcePath.filename().string() + ".";
+
+    std::error_code ec;
+    for( const auto& entry : std::filesystem::directory_iterator( keep.parent_path(), ec ) )
+    {
+        const auto name = entry.path().filename().string();
+
+        // temporary files have another extension, so they're not matched
+        const bool sameSource =
+            name.size() == prefix.size() + DEV_TEXTURE_CACHE_KEY_LENGTH +
+                               DEV_TEXTURE_CACHE_EXTENSION.size() &&
+            name.starts_with( prefix ) && name.ends_with( DEV_TEXTURE_CACHE_EXTENSION );
+
+        if( sameSource && entry.path() != keep )
+        {
+            std::error_code ecRemove;
+            std::filesystem::remove( entry.path(), ecRemove );
+        }
+    }
+}
+
+}
+
+auto RTGL1::ImageLoaderDev::GetCachePath( const std::filesystem::path& path )
+    -> std::filesystem::path
+{
+    std::error_code ec;
+
+    const auto fileSize = std::filesystem::file_size( path, ec );
+    if( ec )
+    {
+        return {};
+    }
+
+    const auto writeTime = std::filesystem::last_write_time( path, ec );
+    if( ec )
+    {
+        return {};
+    }
+
+    using ankerl::unordered_dense::detail::wyhash::hash;
+
+    // std::hash is not guaranteed to be the same between runs and builds
+    const auto pathStr = path.generic_u8string();
+
+    // a changed file has a different key, so the outdated entry is not read
+    const uint64_t values[] = {
+        hash( pathStr.data(), pathStr.size() ),
+        uint64_t( fileSize ),
+        uint64_t( writeTime.time_since_epoch().count() ),
+        DEV_TEXTURE_CACHE_VERSION,
+    };
+    const uint64_t key = hash( values, sizeof( values ) );
+
+    return path.parent_path() / DEV_TEXTURE_CACHE_FOLDER /
+           std::format(
+               "{}.{:016x}{}", path.filename().string(), key, DEV_TEXTURE_CACHE_EXTENSION );
+}
+
 std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoaderDev::Load( const std::filesystem::path& path )
 {
     if( path.empty() )
@@ -36,6 +113,21 @@ std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoaderDev::Load( con
         return std::nullopt;
     }
 
+    const auto cachePath = GetCachePath( path );
+
+    if( !cachePath.empty() && std::filesystem::is_regular_file( cachePath ) )
+    {
+        if( auto cached = cacheLoader.Load( cachePath ) )
+        {
+            // only the base level is stored, others are generated as for a raw file
+            if( cached->levelCount == 1 )
+            {
+                cached->isPregenerated = false;
+                return cached;
+            }
+        }
+    }
+
     int                x = 0, y = 0;
     constexpr uint32_t Channels = 4;
 
@@ -69,6 +161,34 @@ std::optional< RTGL1::ImageLoader::ResultInfo > RTGL1::ImageLoaderDev::Load( con
     };
 
     loadedImages.push_back( static_cast< void* >( pData ) );
+
+    if( !cachePath.empty() )
+    {
+        std::error_code ec;
+        std::filesystem::create_directories( cachePath.parent_path(), ec );
+
+        // write to a temporary file, as other threads may read the same path
+        const auto threadId = std::hash< std::thread::id >{}( std::this_thread::get_id() );
+        const auto tmpPath =
+            std::filesystem::path( cachePath ).concat( std::format( ".{}.tmp", threadId ) );
+
+        bool written = !ec && ImageLoader::WriteRGBA8( tmpPath, pData, result.baseSize, true );
+        if( written )
+        {
+            std::filesystem::rename( tmpPath, cachePath, ec );
+        }
+        if( !written || ec )
+        {
+            std::filesystem::remove( tmpPath, ec );
+            debug::Verbose( "Failed to write texture cache: {}", cachePath.string() );
+        }
+        else
+        {
+            // the source file was changed, or the cache version is different
+            RemoveOutdatedCacheFiles( path, cachePath );
+        }
+    }
+
     return result;
 }
 
@@ -79,4 +199,6 @@ void RTGL1::ImageLoaderDev::FreeLoaded()
         stbi_image_free( pData );
     }
     loadedImages.clear();
+
+    cacheLoader.FreeLoaded();
 }
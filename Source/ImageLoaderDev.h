@@ -50,8 +50,13 @@ public:
     }
     static auto GetFolder() { return TEXTURES_FOLDER_DEV; }
 
+private:
+    // Decoded images are cached as KTX2 files, so the next launch doesn't decode them again
+    static auto GetCachePath( const std::filesystem::path& path ) -> std::filesystem::path;
+
 private:
     std::vector< void* > loadedImages;
+    ImageLoader          cacheLoader;
 };
 
 }
@@ -0,0 +1,222 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "IrradianceCache.h"
+
+#include "CmdLabel.h"
+#include "ShaderManager.h"
+#include "Utils.h"
+#include "Generated/ShaderCommonC.h"
+
+RTGL1::IrradianceCache::IrradianceCache( VkDevice             _device,
+                                         const ShaderManager& _shaderManager,
+                                         const GlobalUniform& _uniform,
+                                         const RestirBuffers& _restirBuffers )
+    : device( _device )
+{
+    CreatePipelineLayout( _uniform, _restirBuffers );
+    CreatePipelines( _shaderManager );
+}
+
+RTGL1::IrradianceCache::~IrradianceCache()
+{
+    vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
+    DestroyPipelines();
+}
+
+void RTGL1::IrradianceCache::Prepare( VkCommandBuffer      cmd,
+                                      const RestirBuffers& restirBuffers,
+                                      bool                 enable,
+                                      bool                 resetHistory )
+{
+    const bool clear = enable && ( resetHistory || !wasEnabled );
+    wasEnabled       = enable;
+
+    if( !clear )
+    {
+        return;
+    }
+
+    CmdLabel label( cmd, "Irradiance cache clear" );
+
+    // zero checksum means an empty cell
+    vkCmdFillBuffer( cmd, restirBuffers.GetIrradianceCacheBuffer(), 0, VK_WHOLE_SIZE, 0 );
+
+    VkBufferMemoryBarrier2KHR b = {
+        .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+        .srcStageMask  = VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+        .dstStageMask  = VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+        .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+        .buffer        = restirBuffers.GetIrradianceCacheBuffer(),
+        .offset        = 0,
+        .size          = VK_WHOLE_SIZE,
+    };
+
+    VkDependencyInfoKHR info = {
+        .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers    = &b,
+    };
+
+    svkCmdPipelineBarrier2KHR( cmd, &info );
+}
+
+void RTGL1::IrradianceCache::Resolve( VkCommandBuffer      cmd,
+                                      uint32_t             frameIndex,
+                                      const GlobalUniform& uniform,
+                                      const RestirBuffers& restirBuffers )
+{
+    if( !wasEnabled )
+    {
+        return;
+    }
+
+    CmdLabel label( cmd, "Irradiance cache resolve" );
+
+    // wait for indirect rays
+    {
+        VkBufferMemoryBarrier2KHR b = {
+            .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+            .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+            .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+            .buffer        = restirBuffers.GetIrradianceCacheBuffer(),
+            .offset        = 0,
+            .size          = VK_WHOLE_SIZE,
+        };
+
+        VkDependencyInfoKHR info = {
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &info );
+    }
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, resolvePipeline );
+
+    VkDescriptorSet sets[] = {
+        uniform.GetDescSet( frameIndex ),
+        restirBuffers.GetDescSet( frameIndex ),
+    };
+    vkCmdBindDescriptorSets( cmd,
+                             VK_PIPELINE_BIND_POINT_COMPUTE,
+                             pipelineLayout,
+                             0,
+                             std::size( sets ),
+                             sets,
+                             0,
+                             nullptr );
+
+    vkCmdDispatch( cmd,
+                   Utils::GetWorkGroupCount( uint32_t( IRRADIANCE_CACHE_CELL_COUNT ),
+                                             uint32_t( COMPUTE_IRRADIANCE_CACHE_GROUP_SIZE_X ) ),
+                   1,
+                   1 );
+
+    // for the next frame's indirect rays
+    {
+        VkBufferMemoryBarrier2KHR b = {
+            .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+            .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR |
+                            VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR,
+            .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR |
+                             VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+            .buffer        = restirBuffers.GetIrradianceCacheBuffer(),
+            .offset        = 0,
+            .size          = VK_WHOLE_SIZE,
+        };
+
+        VkDependencyInfoKHR info = {
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &info );
+    }
+}
+
+void RTGL1::IrradianceCache::OnShaderReload( const ShaderManager* shaderManager )
+{
+    if( !shaderManager->AnyChanged( { "CIrradianceCacheResolve" } ) )
+    {
+        return;
+    }
+
+    DestroyPipelines();
+    CreatePipelines( *shaderManager );
+}
+
+void RTGL1::IrradianceCache::CreatePipelineLayout( const GlobalUniform& uniform,
+                                                   const RestirBuffers& restirBuffers )
+{
+    VkDescriptorSetLayout sets[] = {
+        uniform.GetDescSetLayout(),
+        restirBuffers.GetDescSetLayout(),
+    };
+
+    VkPipelineLayoutCreateInfo info = {
+        .sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .pNext          = nullptr,
+        .flags          = 0,
+        .setLayoutCount = std::size( sets ),
+        .pSetLayouts    = sets,
+    };
+
+    VkResult r = vkCreatePipelineLayout( device, &info, nullptr, &pipelineLayout );
+    VK_CHECKERROR( r );
+
+    SET_DEBUG_NAME( device,
+                    pipelineLayout,
+                    VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+                    "Irradiance cache pipeline layout" );
+}
+
+void RTGL1::IrradianceCache::CreatePipelines( const ShaderManager& shaderManager )
+{
+    assert( resolvePipeline == VK_NULL_HANDLE );
+
+    VkComputePipelineCreateInfo info = {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .pNext  = nullptr,
+        .flags  = 0,
+        .stage  = shaderManager.GetStageInfo( "CIrradianceCacheResolve" ),
+        .layout = pipelineLayout,
+    };
+
+    VkResult r = vkCreateComputePipelines(
+        device, shaderManager.GetPipelineCache(), 1, &info, nullptr, &resolvePipeline );
+    VK_CHECKERROR( r );
+
+    SET_DEBUG_NAME(
+        device, resolvePipeline, VK_OBJECT_TYPE_PIPELINE, "Irradiance cache resolve pipeline" );
+}
+
+void RTGL1::IrradianceCache::DestroyPipelines()
+{
+    vkDestroyPipeline( device, resolvePipeline, nullptr );
+    resolvePipeline = VK_NULL_HANDLE;
+}
@@ -0,0 +1,73 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "GlobalUniform.h"
+#include "IShaderDependency.h"
+#include "RestirBuffers.h"
+
+namespace RTGL1
+{
+// World-space hashed grid of indirect diffuse radiance, stored in RestirBuffers.
+// Indirect rays terminate into it and accumulate to it (see IrradianceCache.h shader),
+// this class only clears the cache and resolves the accumulated values once per frame.
+class IrradianceCache : public IShaderDependency
+{
+public:
+    IrradianceCache( VkDevice             device,
+                     const ShaderManager& shaderManager,
+                     const GlobalUniform& uniform,
+                     const RestirBuffers& restirBuffers );
+    ~IrradianceCache() override;
+
+    IrradianceCache( const IrradianceCache& other )                = delete;
+    IrradianceCache( IrradianceCache&& other ) noexcept            = delete;
+    IrradianceCache& operator=( const IrradianceCache& other )     = delete;
+    IrradianceCache& operator=( IrradianceCache&& other ) noexcept = delete;
+
+    // Must be called before tracing indirect illumination
+    void Prepare( VkCommandBuffer      cmd,
+                  const RestirBuffers& restirBuffers,
+                  bool                 enable,
+                  bool                 resetHistory );
+    // Must be called after tracing indirect illumination
+    void Resolve( VkCommandBuffer      cmd,
+                  uint32_t             frameIndex,
+                  const GlobalUniform& uniform,
+                  const RestirBuffers& restirBuffers );
+
+    void OnShaderReload( const ShaderManager* shaderManager ) override;
+
+private:
+    void CreatePipelineLayout( const GlobalUniform& uniform, const RestirBuffers& restirBuffers );
+    void CreatePipelines( const ShaderManager& shaderManager );
+    void DestroyPipelines();
+
+private:
+    VkDevice device{ VK_NULL_HANDLE };
+
+    VkPipelineLayout pipelineLayout{ VK_NULL_HANDLE };
+    VkPipeline       resolvePipeline{ VK_NULL_HANDLE };
+
+    // if was disabled, the cache contains outdated values
+    bool wasEnabled{ false };
+};
+}
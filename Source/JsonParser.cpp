@@ -227,12 +227,44 @@ JSON_TYPE( RTGL1::LibraryConfig )
     , "dlssForceDefaultPreset", &T::dlssForceDefaultPreset
     , "fpsMonitor", &T::fpsMonitor
     , "fsr3async", &T::fsr3async
+    , "fsr3native", &T::fsr3native
     , "dxgiToVkSwapchainSwitchHack", &T::dxgiToVkSwapchainSwitchHack
     , "dx12Validation", &T::dx12Validation
     , "fsrValidation", &T::fsrValidation
+    , "blasCompaction", &T::blasCompaction
+    , "dynamicBlasCache", &T::dynamicBlasCache
+    , "adaptiveBlasFlags", &T::adaptiveBlasFlags
+    , "asyncBlasBuild", &T::asyncBlasBuild
+    , "asyncFluidSimulation", &T::asyncFluidSimulation
+    , "asyncLightGrid", &T::asyncLightGrid
+    , "opacityMicromaps", &T::opacityMicromaps
+    , "invocationReorder", &T::invocationReorder
+    , "rayQueryPrimary", &T::rayQueryPrimary
+    , "staticBlasCache", &T::staticBlasCache
+    , "tlasRefit", &T::tlasRefit
+    , "gpuTlasInstances", &T::gpuTlasInstances
+    , "dynamicPromotion", &T::dynamicPromotion
+    , "dynamicBatching", &T::dynamicBatching
+    , "dynamicInstancing", &T::dynamicInstancing
+    , "textureStreaming", &T::textureStreaming
+    , "framebufferAliasing", &T::framebufferAliasing
+    , "exportMeshopt", &T::exportMeshopt
+    , "lazyReplacements", &T::lazyReplacements
+    , "exportSceneCells", &T::exportSceneCells
+    , "resizableBarWrites", &T::resizableBarWrites
+    , "parallelRasterRecording", &T::parallelRasterRecording
+    , "primaryVisibilityBuffer", &T::primaryVisibilityBuffer
+    , "meshLods", &T::meshLods
+    , "meshOptimization", &T::meshOptimization
+    , "staticBlasClustering", &T::staticBlasClustering
+    , "staticTriangleSplitting", &T::staticTriangleSplitting
+    , "rayTracingPipelineLibraries", &T::rayTracingPipelineLibraries
+    , "hitchRecorder", &T::hitchRecorder
+    , "memoryDecompression", &T::memoryDecompression
+    , "hitchThresholdMs", &T::hitchThresholdMs
 JSON_TYPE_END;
 // clang-format on
-static_assert( sizeof( RTGL1::LibraryConfig ) == 9, "Add definitions to parser" );
+static_assert( sizeof( RTGL1::LibraryConfig ) == 44, "Add definitions to parser" );
 
 auto RTGL1::json_parser::detail::ReadLibraryConfig( const std::filesystem::path& path )
     -> std::optional< LibraryConfig >
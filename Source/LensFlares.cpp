@@ -29,25 +29,17 @@ namespace
 constexpr bool LENSFLARES_IN_WORLDSPACE = true;
 
 
-constexpr VkDeviceSize MAX_VERTEX_COUNT = 1 << 16;
-constexpr VkDeviceSize MAX_INDEX_COUNT  = 1 << 18;
+constexpr VkDeviceSize MAX_VERTEX_COUNT = LENS_FLARES_MAX_VERTEX_COUNT;
+constexpr VkDeviceSize MAX_INDEX_COUNT  = LENS_FLARES_MAX_INDEX_COUNT;
 
 
-// indirectDrawCommands: one uint32_t - for count, the rest - cmds
-constexpr VkDeviceSize GetIndirectDrawCommandsOffset()
-{
-    return 0;
-}
-constexpr VkDeviceSize GetIndirectDrawCountOffset()
-{
-    return LENS_FLARES_MAX_DRAW_CMD_COUNT * sizeof( RTGL1::ShIndirectDrawCommand );
-}
-constexpr RTGL1::ShIndirectDrawCommand* GetIndirectDrawCommandsArrayStart(
-    void* pCullingInputBuffer )
-{
-    return ( RTGL1::ShIndirectDrawCommand* )( ( void* )( ( uint8_t* )pCullingInputBuffer +
-                                                         GetIndirectDrawCommandsOffset() ) );
-}
+constexpr VkDrawIndexedIndirectCommand EmptyDrawCommand = {
+    .indexCount    = 0,
+    .instanceCount = 1,
+    .firstIndex    = 0,
+    .vertexOffset  = 0,
+    .firstInstance = 0,
+};
 
 
 static_assert( offsetof( RTGL1::ShIndirectDrawCommand, indexCount ) ==
@@ -76,7 +68,7 @@ RTGL1::LensFlares::LensFlares( VkDevice                            _device,
                                const GlobalUniform&                _uniform,
                                const Framebuffers&                 _framebuffers,
                                const TextureManager&               _textureManager,
-                               const RgInstanceCreateInfo&         _instanceInfo )
+                               bool                                _rasterizedVertexColorGamma )
     : device( _device )
     , cullingInputCount( 0 )
     , vertexCount( 0 )
@@ -92,35 +84,47 @@ RTGL1::LensFlares::LensFlares( VkDevice                            _device,
     , cullDescSetLayout( VK_NULL_HANDLE )
     , isPointToCheckInScreenSpace( !LENSFLARES_IN_WORLDSPACE )
 {
-    cullingInput   = std::make_unique< AutoBuffer >( _allocator );
-    vertexBuffer   = std::make_unique< AutoBuffer >( _allocator );
-    indexBuffer    = std::make_unique< AutoBuffer >( _allocator );
-    instanceBuffer = std::make_unique< AutoBuffer >( _allocator );
+    cullingInput         = std::make_unique< AutoBuffer >( _allocator );
+    vertexBuffer         = std::make_unique< AutoBuffer >( _allocator );
+    indexBuffer          = std::make_unique< AutoBuffer >( _allocator );
+    instanceBuffer       = std::make_unique< AutoBuffer >( _allocator );
+    vertexInstanceBuffer = std::make_unique< AutoBuffer >( _allocator );
 
 
     cullingInput->Create( LENS_FLARES_MAX_DRAW_CMD_COUNT * sizeof( ShIndirectDrawCommand ),
                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                           "Lens flares culling input" );
 
-    indirectDrawCommands.Init(
-        *_allocator,
-        LENS_FLARES_MAX_DRAW_CMD_COUNT * sizeof( ShIndirectDrawCommand ) + sizeof( uint32_t ),
-        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        "Lens flares draw cmds" );
+    indirectDrawCommand.Init( *_allocator,
+                              sizeof( VkDrawIndexedIndirectCommand ),
+                              VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                              VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                              "Lens flares draw cmd" );
+
+    visibleIndexBuffer.Init( *_allocator,
+                             MAX_INDEX_COUNT * sizeof( uint32_t ),
+                             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                             "Lens flares visible index buffer" );
 
     vertexBuffer->Create( MAX_VERTEX_COUNT * sizeof( ShVertex ),
                           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                           "Lens flares vertex buffer" );
 
     indexBuffer->Create( MAX_INDEX_COUNT * sizeof( uint32_t ),
-                         VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                          "Lens flares index buffer" );
 
     instanceBuffer->Create( LENS_FLARES_MAX_DRAW_CMD_COUNT * sizeof( ShLensFlareInstance ),
                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
                             "Lens flares instance buffer" );
 
+    vertexInstanceBuffer->Create( MAX_VERTEX_COUNT * sizeof( uint32_t ),
+                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                  "Lens flares vertex instance buffer" );
+
 
     CreateCullDescriptors();
     CreateRasterDescriptors();
@@ -141,7 +145,7 @@ RTGL1::LensFlares::LensFlares( VkDevice                            _device,
                                                  "VertLensFlare",
                                                  "FragLensFlare",
                                                  1 /* emission, for compatibility */,
-                                                 _instanceInfo.rasterizedVertexColorGamma );
+                                                 _rasterizedVertexColorGamma );
 
     CreatePipelines( &_shaderManager );
 }
@@ -224,6 +228,14 @@ void RTGL1::LensFlares::Upload( uint32_t                     frameIndex,
     }
 
 
+    // instance index for each vertex, as all flares are drawn at once
+    {
+        auto* dst = vertexInstanceBuffer->GetMappedAs< uint32_t* >( frameIndex );
+        std::fill(
+            &dst[ vertexIndex ], &dst[ vertexIndex + uploadInfo.vertexCount ], instanceIndex );
+    }
+
+
     // instances
     auto tex = textureManager.GetMaterialTextures( uploadInfo.pTextureName );
 
@@ -240,21 +252,20 @@ void RTGL1::LensFlares::Upload( uint32_t                     frameIndex,
     }
 
 
-    // draw cmds
+    // culling input, indices of visible ones are appended to a single draw
     ShIndirectDrawCommand input = {
         .indexCount        = uploadInfo.indexCount,
         .instanceCount     = 1,
         .firstIndex        = indexIndex,
         .vertexOffset      = int32_t( vertexIndex ),
-        .firstInstance     = instanceIndex, // to access instance buffer with gl_InstanceIndex
+        .firstInstance     = instanceIndex,
         .positionToCheck_X = uploadInfo.pointToCheck.data[ 0 ],
         .positionToCheck_Y = uploadInfo.pointToCheck.data[ 1 ],
         .positionToCheck_Z = uploadInfo.pointToCheck.data[ 2 ],
     };
 
     {
-        ShIndirectDrawCommand* dst =
-            GetIndirectDrawCommandsArrayStart( cullingInput->GetMapped( frameIndex ) );
+        auto* dst = cullingInput->GetMappedAs< ShIndirectDrawCommand* >( frameIndex );
         memcpy( &dst[ instanceIndex ], &input, sizeof( ShIndirectDrawCommand ) );
     }
 }
@@ -272,6 +283,7 @@ void RTGL1::LensFlares::SubmitForFrame( VkCommandBuffer cmd, uint32_t frameIndex
     indexBuffer->CopyFromStaging( cmd, frameIndex, indexCount * sizeof( uint32_t ) );
     instanceBuffer->CopyFromStaging(
         cmd, frameIndex, cullingInputCount * sizeof( ShLensFlareInstance ) );
+    vertexInstanceBuffer->CopyFromStaging( cmd, frameIndex, vertexCount * sizeof( uint32_t ) );
 }
 
 void RTGL1::LensFlares::Cull( VkCommandBuffer      cmd,
@@ -284,6 +296,34 @@ void RTGL1::LensFlares::Cull( VkCommandBuffer      cmd,
         return;
     }
 
+    // the draw of the previous frame must have read the command before resetting it
+    {
+        VkBufferMemoryBarrier2KHR b = {
+            .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR,
+            .srcAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT_KHR,
+            .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+            .buffer        = indirectDrawCommand.GetBuffer(),
+            .offset        = 0,
+            .size          = VK_WHOLE_SIZE,
+        };
+
+        VkDependencyInfoKHR info = {
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &info );
+    }
+
+    vkCmdUpdateBuffer( cmd,
+                       indirectDrawCommand.GetBuffer(),
+                       0,
+                       sizeof( EmptyDrawCommand ),
+                       &EmptyDrawCommand );
+
     // sync
     {
         VkBufferMemoryBarrier2KHR bs[] = {
@@ -297,6 +337,37 @@ void RTGL1::LensFlares::Cull( VkCommandBuffer      cmd,
                 .offset        = 0,
                 .size          = cullingInputCount * sizeof( ShIndirectDrawCommand ),
             },
+            {
+                .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+                .srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT_KHR,
+                .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+                .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+                .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT_KHR,
+                .buffer        = indexBuffer->GetDeviceLocal(),
+                .offset        = 0,
+                .size          = indexCount * sizeof( uint32_t ),
+            },
+            {
+                .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+                .srcStageMask  = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT_KHR,
+                .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
+                .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+                .dstAccessMask =
+                    VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+                .buffer = indirectDrawCommand.GetBuffer(),
+                .offset = 0,
+                .size   = VK_WHOLE_SIZE,
+            },
+            {
+                .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
+                .srcStageMask  = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR,
+                .srcAccessMask = VK_ACCESS_2_NONE_KHR,
+                .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+                .dstAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
+                .buffer        = visibleIndexBuffer.GetBuffer(),
+                .offset        = 0,
+                .size          = VK_WHOLE_SIZE,
+            },
         };
 
         VkDependencyInfoKHR info = {
@@ -352,19 +423,19 @@ void RTGL1::LensFlares::SyncForDraw( VkCommandBuffer cmd, uint32_t frameIndex )
             .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
             .dstStageMask  = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR,
             .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR,
-            .buffer        = indirectDrawCommands.GetBuffer(),
-            .offset        = GetIndirectDrawCommandsOffset(),
-            .size          = cullingInputCount * sizeof( ShIndirectDrawCommand ),
+            .buffer        = indirectDrawCommand.GetBuffer(),
+            .offset        = 0,
+            .size          = VK_WHOLE_SIZE,
         },
         {
             .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
             .srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
             .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT_KHR,
-            .dstStageMask  = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR,
-            .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR,
-            .buffer        = indirectDrawCommands.GetBuffer(),
-            .offset        = GetIndirectDrawCountOffset(),
-            .size          = sizeof( uint32_t ),
+            .dstStageMask  = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR,
+            .dstAccessMask = VK_ACCESS_2_INDEX_READ_BIT_KHR,
+            .buffer        = visibleIndexBuffer.GetBuffer(),
+            .offset        = 0,
+            .size          = indexCount * sizeof( uint32_t ),
         },
         {
             .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
@@ -380,21 +451,21 @@ void RTGL1::LensFlares::SyncForDraw( VkCommandBuffer cmd, uint32_t frameIndex )
             .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
             .srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT_KHR,
             .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
-            .dstStageMask  = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT_KHR,
-            .dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT_KHR,
-            .buffer        = vertexBuffer->GetDeviceLocal(),
+            .dstStageMask  = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR,
+            .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR,
+            .buffer        = vertexInstanceBuffer->GetDeviceLocal(),
             .offset        = 0,
-            .size          = vertexCount * sizeof( ShVertex ),
+            .size          = vertexCount * sizeof( uint32_t ),
         },
         {
             .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR,
             .srcStageMask  = VK_PIPELINE_STAGE_2_COPY_BIT_KHR,
             .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR,
-            .dstStageMask  = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR,
-            .dstAccessMask = VK_ACCESS_2_INDEX_READ_BIT_KHR,
-            .buffer        = indexBuffer->GetDeviceLocal(),
+            .dstStageMask  = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT_KHR,
+            .dstAccessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT_KHR,
+            .buffer        = vertexBuffer->GetDeviceLocal(),
             .offset        = 0,
-            .size          = indexCount * sizeof( uint32_t ),
+            .size          = vertexCount * sizeof( ShVertex ),
         },
     };
 
@@ -451,15 +522,11 @@ void RTGL1::LensFlares::Draw( VkCommandBuffer       cmd,
     VkBuffer     vb     = vertexBuffer->GetDeviceLocal();
     VkDeviceSize offset = 0;
     vkCmdBindVertexBuffers( cmd, 0, 1, &vb, &offset );
-    vkCmdBindIndexBuffer( cmd, indexBuffer->GetDeviceLocal(), 0, VK_INDEX_TYPE_UINT32 );
-
-    vkCmdDrawIndexedIndirectCount( cmd,
-                                   indirectDrawCommands.GetBuffer(),
-                                   GetIndirectDrawCommandsOffset(),
-                                   indirectDrawCommands.GetBuffer(),
-                                   GetIndirectDrawCountOffset(),
-                                   LENS_FLARES_MAX_DRAW_CMD_COUNT,
-                                   sizeof( ShIndirectDrawCommand ) );
+    vkCmdBindIndexBuffer( cmd, visibleIndexBuffer.GetBuffer(), 0, VK_INDEX_TYPE_UINT32 );
+
+    // index count is the sum of visible flares' index counts
+    vkCmdDrawIndexedIndirect(
+        cmd, indirectDrawCommand.GetBuffer(), 0, 1, sizeof( VkDrawIndexedIndirectCommand ) );
 }
 
 uint32_t RTGL1::LensFlares::GetCullingInputCount() const
@@ -555,7 +622,12 @@ void RTGL1::LensFlares::CreatePipelines( const ShaderManager* shaderManager )
     };
     info.stage.pSpecializationInfo = &spec;
 
-    VkResult r = vkCreateComputePipelines( device, nullptr, 1, &info, nullptr, &cullPipeline );
+    VkResult r = vkCreateComputePipelines( device,
+                                           shaderManager->GetPipelineCache(),
+                                           1,
+                                           &info,
+                                           nullptr,
+                                           &cullPipeline );
     VK_CHECKERROR( r );
 }
 
@@ -571,6 +643,11 @@ void RTGL1::LensFlares::OnShaderReload( const ShaderManager* shaderManager )
 {
     rasterPipelines->OnShaderReload( shaderManager );
 
+    if( !shaderManager->AnyChanged( { "CCullLensFlares" } ) )
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines( shaderManager );
 }
@@ -580,7 +657,7 @@ void RTGL1::LensFlares::CreateCullDescriptors()
     {
         VkDescriptorPoolSize poolSize = {
             .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            .descriptorCount = 2,
+            .descriptorCount = 4,
         };
 
         VkDescriptorPoolCreateInfo poolInfo = {
@@ -610,6 +687,18 @@ void RTGL1::LensFlares::CreateCullDescriptors()
                 .descriptorCount = 1,
                 .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
             },
+            {
+                .binding         = BINDING_LENS_FLARES_SOURCE_INDICES,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+            },
+            {
+                .binding         = BINDING_LENS_FLARES_VISIBLE_INDICES,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+            },
         };
 
         VkDescriptorSetLayoutCreateInfo info = {
@@ -649,7 +738,17 @@ void RTGL1::LensFlares::CreateCullDescriptors()
                 .range  = VK_WHOLE_SIZE,
             },
             {
-                .buffer = indirectDrawCommands.GetBuffer(),
+                .buffer = indirectDrawCommand.GetBuffer(),
+                .offset = 0,
+                .range  = VK_WHOLE_SIZE,
+            },
+            {
+                .buffer = indexBuffer->GetDeviceLocal(),
+                .offset = 0,
+                .range  = VK_WHOLE_SIZE,
+            },
+            {
+                .buffer = visibleIndexBuffer.GetBuffer(),
                 .offset = 0,
                 .range  = VK_WHOLE_SIZE,
             },
@@ -674,6 +773,24 @@ void RTGL1::LensFlares::CreateCullDescriptors()
                 .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
                 .pBufferInfo     = &bufs[ BINDING_LENS_FLARES_DRAW_CMDS ],
             },
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = cullDescSet,
+                .dstBinding      = BINDING_LENS_FLARES_SOURCE_INDICES,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo     = &bufs[ BINDING_LENS_FLARES_SOURCE_INDICES ],
+            },
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = cullDescSet,
+                .dstBinding      = BINDING_LENS_FLARES_VISIBLE_INDICES,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo     = &bufs[ BINDING_LENS_FLARES_VISIBLE_INDICES ],
+            },
         };
 
         vkUpdateDescriptorSets( device, std::size( writes ), writes, 0, nullptr );
@@ -685,7 +802,7 @@ void RTGL1::LensFlares::CreateRasterDescriptors()
     {
         VkDescriptorPoolSize poolSize = {
             .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            .descriptorCount = 1,
+            .descriptorCount = 2,
         };
 
         VkDescriptorPoolCreateInfo poolInfo = {
@@ -702,17 +819,25 @@ void RTGL1::LensFlares::CreateRasterDescriptors()
             device, rasterDescPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Lens flare raster desc pool" );
     }
     {
-        VkDescriptorSetLayoutBinding binding = {
-            .binding         = BINDING_DRAW_LENS_FLARES_INSTANCES,
-            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            .descriptorCount = 1,
-            .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+        VkDescriptorSetLayoutBinding binding[] = {
+            {
+                .binding         = BINDING_DRAW_LENS_FLARES_INSTANCES,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+            },
+            {
+                .binding         = BINDING_DRAW_LENS_FLARES_VERTEX_INSTANCES,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT,
+            },
         };
 
         VkDescriptorSetLayoutCreateInfo info = {
             .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-            .bindingCount = 1,
-            .pBindings    = &binding,
+            .bindingCount = std::size( binding ),
+            .pBindings    = binding,
         };
 
         VkResult r = vkCreateDescriptorSetLayout( device, &info, nullptr, &rasterDescSetLayout );
@@ -739,22 +864,40 @@ void RTGL1::LensFlares::CreateRasterDescriptors()
             device, rasterDescSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Lens flare raster desc set" );
     }
     {
-        VkDescriptorBufferInfo b = {
-            .buffer = instanceBuffer->GetDeviceLocal(),
-            .offset = 0,
-            .range  = VK_WHOLE_SIZE,
+        VkDescriptorBufferInfo bufs[] = {
+            {
+                .buffer = instanceBuffer->GetDeviceLocal(),
+                .offset = 0,
+                .range  = VK_WHOLE_SIZE,
+            },
+            {
+                .buffer = vertexInstanceBuffer->GetDeviceLocal(),
+                .offset = 0,
+                .range  = VK_WHOLE_SIZE,
+            },
         };
 
-        VkWriteDescriptorSet w = {
-            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-            .dstSet          = rasterDescSet,
-            .dstBinding      = BINDING_DRAW_LENS_FLARES_INSTANCES,
-            .dstArrayElement = 0,
-            .descriptorCount = 1,
-            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-            .pBufferInfo     = &b,
+        VkWriteDescriptorSet writes[] = {
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = rasterDescSet,
+                .dstBinding      = BINDING_DRAW_LENS_FLARES_INSTANCES,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo     = &bufs[ BINDING_DRAW_LENS_FLARES_INSTANCES ],
+            },
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = rasterDescSet,
+                .dstBinding      = BINDING_DRAW_LENS_FLARES_VERTEX_INSTANCES,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo     = &bufs[ BINDING_DRAW_LENS_FLARES_VERTEX_INSTANCES ],
+            },
         };
 
-        vkUpdateDescriptorSets( device, 1, &w, 0, nullptr );
+        vkUpdateDescriptorSets( device, std::size( writes ), writes, 0, nullptr );
     }
 }
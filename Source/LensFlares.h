@@ -40,7 +40,7 @@ public:
                 const GlobalUniform&                uniform,
                 const Framebuffers&                 framebuffers,
                 const TextureManager&               textureManager,
-                const RgInstanceCreateInfo&         instanceInfo );
+                bool                                rasterizedVertexColorGamma );
     ~LensFlares() override;
 
     LensFlares( const LensFlares& other )                = delete;
@@ -83,11 +83,14 @@ private:
     VkDevice device;
 
     std::unique_ptr< AutoBuffer > cullingInput;
-    Buffer                        indirectDrawCommands;
+    // one indexed draw for all visible flares, written by the culling
+    Buffer                        indirectDrawCommand;
+    Buffer                        visibleIndexBuffer;
 
     std::unique_ptr< AutoBuffer > vertexBuffer;
     std::unique_ptr< AutoBuffer > indexBuffer;
     std::unique_ptr< AutoBuffer > instanceBuffer;
+    std::unique_ptr< AutoBuffer > vertexInstanceBuffer;
 
     uint32_t cullingInputCount;
     uint32_t vertexCount;
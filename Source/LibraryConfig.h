@@ -39,9 +39,43 @@ struct LibraryConfig
     bool fpsMonitor                  = false;
     bool fsrValidation               = false;
     bool fsr3async                   = false;
+    bool fsr3native                  = false;
     bool dx12Validation              = false;
     bool dxgiToVkSwapchainSwitchHack = true;
     bool dlssForceDefaultPreset      = false;
+    bool blasCompaction              = false;
+    bool dynamicBlasCache            = false;
+    bool adaptiveBlasFlags           = true;
+    bool asyncBlasBuild              = false;
+    bool asyncFluidSimulation        = false;
+    bool asyncLightGrid              = false;
+    bool opacityMicromaps            = false;
+    bool invocationReorder           = true;
+    bool rayQueryPrimary             = false;
+    bool staticBlasCache             = false;
+    bool tlasRefit                   = false;
+    bool gpuTlasInstances            = false;
+    bool dynamicPromotion            = false;
+    bool dynamicBatching             = false;
+    bool dynamicInstancing           = false;
+    bool textureStreaming            = false;
+    bool framebufferAliasing         = true;
+    bool exportMeshopt               = false;
+    bool lazyReplacements            = false;
+    bool exportSceneCells            = false;
+    bool resizableBarWrites          = false;
+    bool parallelRasterRecording     = false;
+    bool primaryVisibilityBuffer     = false;
+    bool meshLods                    = false;
+    bool meshOptimization            = true;
+    bool staticBlasClustering        = false;
+    bool staticTriangleSplitting     = false;
+    bool rayTracingPipelineLibraries = false;
+    bool hitchRecorder               = false;
+    bool memoryDecompression         = true;
+
+    // frames longer than that are dumped by the hitch recorder
+    float hitchThresholdMs = 50.0f;
 
     // When adding fields, modify the entry in JsonParser.cpp
 };
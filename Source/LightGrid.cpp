@@ -21,11 +21,13 @@
 #include "LightGrid.h"
 
 #include "CmdLabel.h"
+#include "LibraryConfig.h"
 #include "Utils.h"
 #include "Generated/ShaderCommonC.h"
 
 RTGL1::LightGrid::LightGrid(
     VkDevice _device,
+    std::shared_ptr<CommandBufferManager> _cmdManager,
     const std::shared_ptr<ShaderManager> &_shaderManager,
     const std::shared_ptr<GlobalUniform> &_uniform,
     const std::shared_ptr<BlueNoise> &_blueNoise,
@@ -35,6 +37,11 @@ RTGL1::LightGrid::LightGrid(
     : device(_device)
     , pipelineLayout(VK_NULL_HANDLE)
     , gridBuildPipeline(VK_NULL_HANDLE)
+    , lastBuiltFrameId(std::nullopt)
+    , cmdManager(std::move(_cmdManager))
+    , asyncBuild(false)
+    , asyncTimeline(VK_NULL_HANDLE)
+    , asyncTimelineValue(0)
 #endif
 {
 #if LIGHT_GRID_ENABLED_
@@ -57,6 +64,25 @@ RTGL1::LightGrid::LightGrid(
 
 
     CreatePipelines(_shaderManager.get());
+
+
+    asyncBuild = LibConfig().asyncLightGrid && cmdManager->HasAsyncCompute();
+    if (asyncBuild)
+    {
+        VkSemaphoreTypeCreateInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        timelineInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        timelineInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &timelineInfo;
+
+        r = vkCreateSemaphore(device, &semaphoreInfo, nullptr, &asyncTimeline);
+        VK_CHECKERROR(r);
+
+        SET_DEBUG_NAME(device, asyncTimeline, VK_OBJECT_TYPE_SEMAPHORE, "Light grid async timeline");
+    }
 #endif
 }
 
@@ -64,6 +90,7 @@ RTGL1::LightGrid::~LightGrid()
 {
 #if LIGHT_GRID_ENABLED_
     vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    vkDestroySemaphore(device, asyncTimeline, nullptr);
     DestroyPipelines();
 #endif
 }
@@ -81,6 +108,13 @@ void RTGL1::LightGrid::Build(
     // no barriers here, as lightManager has a AutoBuffer kludge
 
 
+    const uint32_t frameId = uniform->GetData()->frameId;
+    if (!lastBuiltFrameId || *lastBuiltFrameId + 1 != frameId)
+    {
+        lightManager->ClearLightGridHistory(cmd, frameIndex);
+    }
+    lastBuiltFrameId = frameId;
+
     VkDescriptorSet sets[] =
     {
         uniform->GetDescSet(frameIndex),
@@ -101,9 +135,52 @@ void RTGL1::LightGrid::Build(
 #endif
 }
 
+void RTGL1::LightGrid::BuildAsync(
+    uint32_t frameIndex,
+    const std::shared_ptr<GlobalUniform> &uniform,
+    const std::shared_ptr<BlueNoise> &blueNoise,
+    const std::shared_ptr<LightManager> &lightManager)
+{
+#if LIGHT_GRID_ENABLED_
+    assert(asyncBuild);
+
+    // lights and uniform are uploaded by the graphics queue,
+    // and the grid of this frame index is not read by the previous frames anymore
+    const uint64_t uploaded = ++asyncTimelineValue;
+    cmdManager->SignalSemaphoreOnGraphics(asyncTimeline, uploaded);
+
+    VkCommandBuffer asyncCmd = cmdManager->StartAsyncComputeCmd();
+    Build(asyncCmd, frameIndex, uniform, blueNoise, lightManager);
+
+    const uint64_t built = ++asyncTimelineValue;
+    cmdManager->Submit_Timeline(asyncCmd,
+                                VK_NULL_HANDLE,
+                                ToWait{ asyncTimeline, uploaded },
+                                ToSignal{ asyncTimeline, built });
+
+    // rasterization of the frame is overlapped with the build
+    cmdManager->WaitSemaphoreOnGraphics(asyncTimeline, built,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
+#endif
+}
+
+bool RTGL1::LightGrid::IsAsync() const
+{
+#if LIGHT_GRID_ENABLED_
+    return asyncBuild;
+#else
+    return false;
+#endif
+}
+
 void RTGL1::LightGrid::OnShaderReload(const ShaderManager* shaderManager)
 {
 #if LIGHT_GRID_ENABLED_
+    if (!shaderManager->AnyChanged({ "CLightGridBuild" }))
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines(shaderManager);
 #endif
@@ -117,7 +194,12 @@ void RTGL1::LightGrid::CreatePipelines(const ShaderManager* shaderManager)
     plInfo.layout = pipelineLayout;
     plInfo.stage = shaderManager->GetStageInfo("CLightGridBuild");
 
-    VkResult r = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &gridBuildPipeline);
+    VkResult r = vkCreateComputePipelines( device,
+                                           shaderManager->GetPipelineCache(),
+                                           1,
+                                           &plInfo,
+                                           nullptr,
+                                           &gridBuildPipeline );
     VK_CHECKERROR(r);
 
     SET_DEBUG_NAME(device, gridBuildPipeline, VK_OBJECT_TYPE_PIPELINE, "Light grid build pipeline");
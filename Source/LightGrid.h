@@ -21,6 +21,7 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "CommandBufferManager.h"
 #include "GlobalUniform.h"
 #include "BlueNoise.h"
 #include "LightManager.h"
@@ -32,6 +33,7 @@ namespace RTGL1
     public:
         LightGrid(
             VkDevice device,
+            std::shared_ptr<CommandBufferManager> cmdManager,
             const std::shared_ptr<ShaderManager> &shaderManager,
             const std::shared_ptr<GlobalUniform> &uniform,
             const std::shared_ptr<BlueNoise> &blueNoise,
@@ -49,6 +51,16 @@ namespace RTGL1
             const std::shared_ptr<BlueNoise> &blueNoise,
             const std::shared_ptr<LightManager> &lightManager);
 
+        // Build on the async compute queue, after all work that was submitted
+        // to the graphics queue. Subsequent graphics submissions wait for it
+        // only at the compute and ray tracing stages
+        void BuildAsync(
+            uint32_t frameIndex,
+            const std::shared_ptr<GlobalUniform> &uniform,
+            const std::shared_ptr<BlueNoise> &blueNoise,
+            const std::shared_ptr<LightManager> &lightManager);
+        bool IsAsync() const;
+
         void OnShaderReload(const ShaderManager *shaderManager) override;
 
     private:
@@ -62,6 +74,14 @@ namespace RTGL1
 
         VkPipelineLayout pipelineLayout;
         VkPipeline gridBuildPipeline;
+
+        // grid can be disabled at runtime, so its history might be outdated
+        std::optional<uint32_t> lastBuiltFrameId;
+
+        std::shared_ptr<CommandBufferManager> cmdManager;
+        bool asyncBuild;
+        VkSemaphore asyncTimeline;
+        uint64_t asyncTimelineValue;
 #endif
 
     };
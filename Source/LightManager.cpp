@@ -25,6 +25,8 @@
 
 #include "Generated/ShaderCommonC.h"
 #include "CmdLabel.h"
+#include "CpuProfiler.h"
+#include "LightTree.h"
 #include "RgException.h"
 #include "Utils.h"
 
@@ -51,10 +53,17 @@ static uint32_t packHalf2x16( const float& x, const float& y );
 RTGL1::LightManager::LightManager( VkDevice                            _device,
                                    std::shared_ptr< MemoryAllocator >& _allocator )
     : device( _device )
+    , dynamicFirstFreeSlot( 0 )
+    , dynamicBase_Prev( LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET )
+    , frameCounter( 0 )
     , regLightCount( 0 )
     , regLightCount_Prev( 0 )
     , dirLightCount( 0 )
     , dirLightCount_Prev( 0 )
+    , staticLightsVersion( std::nullopt )
+    , staticRegLightCount( 0 )
+    , staticUploadPending( false )
+    , lightTreeNodeCount( 0 )
     , descSetLayout( VK_NULL_HANDLE )
     , descPool( VK_NULL_HANDLE )
     , descSets{}
@@ -76,12 +85,22 @@ RTGL1::LightManager::LightManager( VkDevice                            _device,
     {
         buf.Init( *_allocator,
                   sizeof( ShLightInCell ) * GRID_LIGHTS_COUNT,
-                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                   "Lights grid" );
     }
 #endif
 
+    lightTreeBuffer = std::make_shared< AutoBuffer >( _allocator );
+    lightTreeBuffer->Create( sizeof( ShLightTreeNode ) * ( 2 * LIGHT_ARRAY_MAX_SIZE - 1 ),
+                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                             "Lights tree" );
+
+    lightstylesBuffer = std::make_shared< AutoBuffer >( _allocator );
+    lightstylesBuffer->Create( sizeof( float ) * LIGHTSTYLE_MAX_COUNT,
+                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                               "Lightstyles" );
+
     prevToCurIndex = std::make_shared< AutoBuffer >( _allocator );
     prevToCurIndex->Create( sizeof( uint32_t ) * LIGHT_ARRAY_MAX_SIZE,
                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
@@ -106,6 +125,11 @@ namespace
 
 static_assert( sizeof( RTGL1::ShLightEncoded ) == 24, "Change encoding" );
 
+uint32_t GetLightType( const RTGL1::ShLightEncoded& encoded )
+{
+    return encoded.lightType & LIGHT_TYPE_MASK;
+}
+
 
 RTGL1::ShLightEncoded EncodeAsDirectionalLight( const RgLightDirectionalEXT& info,
                                                 float                        mult,
@@ -295,6 +319,76 @@ RTGL1::ShLightEncoded EncodeAsSpotLight( const RgLightSpotEXT& info,
     return lt;
 }
 
+float ApproxPower( RgColor4DPacked32 color, float intensity )
+{
+    auto c = RTGL1::Utils::UnpackColor4DPacked32< RgFloat3D >( color );
+    return intensity * RTGL1::Utils::Luminance( c.data );
+}
+
+RgFloat3D Offset( const RgFloat3D& p, float d )
+{
+    return RgFloat3D{ p.data[ 0 ] + d, p.data[ 1 ] + d, p.data[ 2 ] + d };
+}
+
+// Bounds of a light for the light tree, the same as used by encoding functions
+std::optional< RTGL1::LightTreeInput > MakeLightTreeInput( const RTGL1::LightCopy& light,
+                                                           uint32_t lightIndex )
+{
+    constexpr auto anyDirection = RgFloat3D{ 0, 1, 0 };
+
+    return std::visit(
+        RTGL1::ext::overloaded{
+            []( const RgLightDirectionalEXT& ) -> std::optional< RTGL1::LightTreeInput > {
+                return std::nullopt;
+            },
+            [ & ]( const RgLightSphericalEXT& lext ) -> std::optional< RTGL1::LightTreeInput > {
+                float radius = std::max( MIN_SPHERE_RADIUS, lext.radius );
+                return RTGL1::LightTreeInput{
+                    .bbMin        = Offset( lext.position, -radius ),
+                    .bbMax        = Offset( lext.position, radius ),
+                    .energy       = ApproxPower( lext.color, lext.intensity ),
+                    .coneAxis     = anyDirection,
+                    .coneCosTheta = -1.0f,
+                    .lightIndex   = lightIndex,
+                };
+            },
+            [ & ]( const RgLightSpotEXT& lext ) -> std::optional< RTGL1::LightTreeInput > {
+                float radius = std::max( MIN_SPHERE_RADIUS, lext.radius );
+                return RTGL1::LightTreeInput{
+                    .bbMin        = Offset( lext.position, -radius ),
+                    .bbMax        = Offset( lext.position, radius ),
+                    .energy       = ApproxPower( lext.color, lext.intensity ),
+                    .coneAxis     = RTGL1::Utils::Normalize( lext.direction ),
+                    .coneCosTheta = std::cos( std::clamp( lext.angleOuter, 0.0f, float( RG_PI ) ) ),
+                    .lightIndex   = lightIndex,
+                };
+            },
+            [ & ]( const RgLightPolygonalEXT& lext ) -> std::optional< RTGL1::LightTreeInput > {
+                RgFloat3D mn = lext.positions[ 0 ];
+                RgFloat3D mx = lext.positions[ 0 ];
+                for( const RgFloat3D& p : lext.positions )
+                {
+                    for( int i = 0; i < 3; i++ )
+                    {
+                        mn.data[ i ] = std::min( mn.data[ i ], p.data[ i ] );
+                        mx.data[ i ] = std::max( mx.data[ i ], p.data[ i ] );
+                    }
+                }
+                return RTGL1::LightTreeInput{
+                    .bbMin    = mn,
+                    .bbMax    = mx,
+                    .energy   = ApproxPower( lext.color, lext.intensity ),
+                    .coneAxis = RTGL1::Utils::SafeNormalize(
+                        RTGL1::Utils::GetUnnormalizedNormal( lext.positions ), anyDirection ),
+                    // one-sided
+                    .coneCosTheta = 0.0f,
+                    .lightIndex   = lightIndex,
+                };
+            },
+        },
+        light.extension );
+}
+
 uint32_t GetLightArrayEnd( uint32_t regCount, uint32_t dirCount )
 {
     // assuming that reg lights are always after directional ones
@@ -307,9 +401,12 @@ void RTGL1::LightManager::PrepareForFrame( VkCommandBuffer cmd, uint32_t frameIn
 {
     regLightCount_Prev = regLightCount;
     dirLightCount_Prev = dirLightCount;
+    dynamicBase_Prev   = GetDynamicBase();
+    dirLightID_Prev    = dirLightID;
 
-    regLightCount = 0;
     dirLightCount = 0;
+    dirLightID    = std::nullopt;
+    frameCounter++;
 
     // TODO: similar system to just swap desc sets, instead of actual copying
     if( GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev ) > 0 )
@@ -330,7 +427,29 @@ void RTGL1::LightManager::PrepareForFrame( VkCommandBuffer cmd, uint32_t frameIn
             sizeof( uint32_t ) * GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev ) );
     // no need to clear curToPrevIndex, as it'll be filled in the cur frame
 
-    uniqueIDToArrayIndex[ frameIndex ].clear();
+    dynamicSlotOfLight_Compacted.clear();
+    // too many holes are wasted samples
+    if( dynamicSlots.size() >= 64 && dynamicSlotOfLight.size() * 2 < dynamicSlots.size() )
+    {
+        CompactDynamicSlots();
+    }
+    // static lights are kept at the beginning of the regular light range, then dynamic slots
+    regLightCount = staticRegLightCount + uint32_t( dynamicSlots.size() );
+
+    // if the static set is not changed, its lights have the same indices
+    staticIDToArrayIndex[ frameIndex ] = staticIDToArrayIndex[ Utils::PrevFrame( frameIndex ) ];
+    {
+        auto* prev2cur = prevToCurIndex->GetMappedAs< uint32_t* >( frameIndex );
+        auto* cur2prev = curToPrevIndex->GetMappedAs< uint32_t* >( frameIndex );
+
+        for( uint32_t i = LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET;
+             i < GetLightArrayEnd( staticRegLightCount, 0 );
+             i++ )
+        {
+            prev2cur[ i ] = i;
+            cur2prev[ i ] = i;
+        }
+    }
 }
 
 void RTGL1::LightManager::Reset()
@@ -348,62 +467,158 @@ void RTGL1::LightManager::Reset()
                     std::max( GetLightArrayEnd( regLightCount, dirLightCount ),
                               GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev ) ) );
 
-        uniqueIDToArrayIndex[ i ].clear();
+        staticIDToArrayIndex[ i ].reset();
     }
 
     regLightCount_Prev = regLightCount = 0;
     dirLightCount_Prev = dirLightCount = 0;
+
+    dynamicSlots.clear();
+    dynamicSlotOfLight.clear();
+    dynamicSlotOfLight_Compacted.clear();
+    dynamicFirstFreeSlot = 0;
+    dynamicBase_Prev     = LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET;
+    dirLightID_Prev = dirLightID = std::nullopt;
+
+    // force to re-encode static lights
+    staticLightsVersion = std::nullopt;
+    staticRegLightCount = 0;
+    staticUploadPending = false;
+    lightTreeNodeCount  = 0;
 }
 
-RTGL1::LightArrayIndex RTGL1::LightManager::GetIndex( const ShLightEncoded& encodedLight ) const
+auto RTGL1::LightManager::GetDynamicBase() const -> uint32_t
 {
-    switch( encodedLight.lightType )
+    return GetLightArrayEnd( staticRegLightCount, 0 );
+}
+
+auto RTGL1::LightManager::AcquireDynamicSlot( UniqueLightID uniqueID ) -> std::optional< uint32_t >
+{
+    // same slot, as long as the light is added each frame
+    auto f = dynamicSlotOfLight.find( uniqueID );
+    if( f != dynamicSlotOfLight.end() )
     {
-        case LIGHT_TYPE_DIRECTIONAL:
-            return LightArrayIndex{ LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET + dirLightCount };
-        case LIGHT_TYPE_SPHERE:
-        case LIGHT_TYPE_TRIANGLE:
-        case LIGHT_TYPE_SPOT:
-            return LightArrayIndex{ LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + regLightCount };
-        default: assert( 0 ); return LightArrayIndex{ 0 };
+        return f->second;
     }
+
+    // prefer the lowest free slot, to keep the range dense
+    while( dynamicFirstFreeSlot < dynamicSlots.size() &&
+           dynamicSlots[ dynamicFirstFreeSlot ].occupied )
+    {
+        dynamicFirstFreeSlot++;
+    }
+
+    const uint32_t slot = dynamicFirstFreeSlot;
+    if( slot == dynamicSlots.size() )
+    {
+        if( GetDynamicBase() + slot >= LIGHT_ARRAY_MAX_SIZE )
+        {
+            return std::nullopt;
+        }
+        dynamicSlots.push_back( {} );
+    }
+
+    dynamicSlots[ slot ] = DynamicSlot{
+        .owner          = uniqueID,
+        .lastAddedFrame = frameCounter,
+        .occupied       = true,
+    };
+    dynamicSlotOfLight[ uniqueID ] = slot;
+    dynamicFirstFreeSlot           = slot + 1;
+
+    return slot;
 }
 
-void RTGL1::LightManager::IncrementCount( const ShLightEncoded& encodedLight )
+void RTGL1::LightManager::ReleaseUnusedDynamicSlots( uint32_t frameIndex )
 {
-    switch( encodedLight.lightType )
+    auto* dst      = lightsBuffer->GetMappedAs< ShLightEncoded* >( frameIndex );
+    auto* cur2prev = curToPrevIndex->GetMappedAs< uint32_t* >( frameIndex );
+
+    for( uint32_t s = 0; s < dynamicSlots.size(); s++ )
     {
-        case LIGHT_TYPE_DIRECTIONAL: dirLightCount++; break;
-        case LIGHT_TYPE_SPHERE:
-        case LIGHT_TYPE_TRIANGLE:
-        case LIGHT_TYPE_SPOT: regLightCount++; break;
-        default: assert( 0 );
+        DynamicSlot& slot = dynamicSlots[ s ];
+
+        if( slot.occupied )
+        {
+            if( slot.lastAddedFrame == frameCounter )
+            {
+                continue;
+            }
+
+            // light was not added in this frame
+            dynamicSlotOfLight.erase( slot.owner );
+            slot.occupied        = false;
+            dynamicFirstFreeSlot = std::min( dynamicFirstFreeSlot, s );
+        }
+
+        // each frame has its own staging, so holes must be written every frame
+        const uint32_t index = GetDynamicBase() + s;
+
+        dst[ index ]           = ShLightEncoded{};
+        dst[ index ].lightType = LIGHT_TYPE_NONE;
+        cur2prev[ index ]      = UINT32_MAX;
     }
+
+    while( !dynamicSlots.empty() && !dynamicSlots.back().occupied )
+    {
+        dynamicSlots.pop_back();
+    }
+    dynamicFirstFreeSlot = std::min( dynamicFirstFreeSlot, uint32_t( dynamicSlots.size() ) );
+
+    regLightCount = staticRegLightCount + uint32_t( dynamicSlots.size() );
+}
+
+void RTGL1::LightManager::CompactDynamicSlots()
+{
+    // must be called before any dynamic light is added in this frame,
+    // so all slots belong to the lights of the previous frame
+    for( const auto& [ uniqueID, slot ] : dynamicSlotOfLight )
+    {
+        dynamicSlotOfLight_Compacted[ uniqueID ] = slot;
+    }
+
+    dynamicSlots.clear();
+    dynamicSlotOfLight.clear();
+    dynamicFirstFreeSlot = 0;
 }
 
 void RTGL1::LightManager::AddInternal( uint32_t              frameIndex,
                                        uint64_t              uniqueId,
                                        const ShLightEncoded& encodedLight )
 {
-    if( GetLightArrayEnd( regLightCount, dirLightCount ) >= LIGHT_ARRAY_MAX_SIZE )
+    // must be unique
+    assert( !FindIndex( frameIndex, uniqueId ) );
+
+    auto index = LightArrayIndex{};
+    auto slot  = std::optional< uint32_t >{};
+
+    if( GetLightType( encodedLight ) == LIGHT_TYPE_DIRECTIONAL )
     {
-        assert( 0 );
-        return;
+        index = LightArrayIndex{ LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET };
+        dirLightCount++;
+        dirLightID = uniqueId;
+    }
+    else
+    {
+        slot = AcquireDynamicSlot( uniqueId );
+        if( !slot )
+        {
+            assert( 0 );
+            return;
+        }
+        index         = LightArrayIndex{ GetDynamicBase() + *slot };
+        regLightCount = staticRegLightCount + uint32_t( dynamicSlots.size() );
     }
-
-    const LightArrayIndex index = GetIndex( encodedLight );
-    IncrementCount( encodedLight );
 
     auto* dst = lightsBuffer->GetMappedAs< ShLightEncoded* >( frameIndex );
     memcpy( &dst[ index.GetArrayIndex() ], &encodedLight, sizeof( ShLightEncoded ) );
 
-
     FillMatchPrev( frameIndex, index, uniqueId );
-    // must be unique
-    assert( uniqueIDToArrayIndex[ frameIndex ].find( uniqueId ) ==
-            uniqueIDToArrayIndex[ frameIndex ].end() );
-    // save index for the next frame
-    uniqueIDToArrayIndex[ frameIndex ][ uniqueId ] = index;
+
+    if( slot )
+    {
+        dynamicSlots[ *slot ].lastAddedFrame = frameCounter;
+    }
 }
 
 namespace
@@ -425,6 +640,24 @@ bool IsLightColorTooDim( const T& l )
     return false;
 }
 
+// Lightstyle multiplier is applied in shaders, so the light doesn't need re-encoding
+// when the value changes
+uint32_t EncodeLightStyle( const std::optional< RgLightAdditionalEXT >& extra )
+{
+    if( extra && ( extra->flags & RG_LIGHT_ADDITIONAL_LIGHTSTYLE ) )
+    {
+        if( extra->lightstyle >= 0 && extra->lightstyle < LIGHTSTYLE_MAX_COUNT )
+        {
+            return uint32_t( extra->lightstyle + 1 ) << LIGHT_TYPE_LIGHTSTYLE_SHIFT;
+        }
+        else
+        {
+            assert( 0 );
+        }
+    }
+    return 0;
+}
+
 float CalculateLightStyle( const std::optional< RgLightAdditionalEXT >& extra,
                            std::span< const uint8_t >                   lightstyles )
 {
@@ -444,90 +677,238 @@ float CalculateLightStyle( const std::optional< RgLightAdditionalEXT >& extra,
 
 }
 
-void RTGL1::LightManager::Add( uint32_t           frameIndex,
-                               const LightCopy&   light,
-                               const RgTransform* transform )
+auto RTGL1::LightManager::Encode( const LightCopy& light, const RgTransform* transform ) const
+    -> std::optional< ShLightEncoded >
 {
-    std::visit(
+    std::optional< ShLightEncoded > encoded = std::visit(
         ext::overloaded{
-            [ & ]( const RgLightDirectionalEXT& lext ) {
+            [ & ]( const RgLightDirectionalEXT& lext ) -> std::optional< ShLightEncoded > {
                 if( IsLightColorTooDim( lext ) )
                 {
-                    return;
+                    return std::nullopt;
                 }
 
-                if( dirLightCount > 0 )
-                {
-                    debug::Error( "Only one directional light is allowed" );
-                    return;
-                }
-
-                AddInternal(
-                    frameIndex,
-                    light.base.uniqueID,
-                    EncodeAsDirectionalLight(
-                        lext, CalculateLightStyle( light.additional, lightstyles ), transform ) );
+                return EncodeAsDirectionalLight( lext, 1.0f, transform );
             },
-            [ & ]( const RgLightSphericalEXT& lext ) {
+            [ & ]( const RgLightSphericalEXT& lext ) -> std::optional< ShLightEncoded > {
                 if( IsLightColorTooDim( lext ) )
                 {
-                    return;
+                    return std::nullopt;
                 }
 
-                AddInternal(
-                    frameIndex,
-                    light.base.uniqueID,
-                    EncodeAsSphereLight(
-                        lext, CalculateLightStyle( light.additional, lightstyles ), transform ) );
+                return EncodeAsSphereLight( lext, 1.0f, transform );
             },
-            [ & ]( const RgLightSpotEXT& lext ) {
+            [ & ]( const RgLightSpotEXT& lext ) -> std::optional< ShLightEncoded > {
                 if( IsLightColorTooDim( lext ) )
                 {
-                    return;
+                    return std::nullopt;
                 }
 
-                AddInternal(
-                    frameIndex,
-                    light.base.uniqueID,
-                    EncodeAsSpotLight(
-                        lext, CalculateLightStyle( light.additional, lightstyles ), transform ) );
+                return EncodeAsSpotLight( lext, 1.0f, transform );
             },
-            [ & ]( const RgLightPolygonalEXT& lext ) {
+            [ & ]( const RgLightPolygonalEXT& lext ) -> std::optional< ShLightEncoded > {
 #if TRIANGLE_LIGHTS
                 if( IsLightColorTooDim( lext ) )
                 {
-                    return;
+                    return std::nullopt;
                 }
 
                 RgFloat3D unnormalizedNormal = Utils::GetUnnormalizedNormal( lext.positions );
                 if( Utils::Dot( unnormalizedNormal.data, unnormalizedNormal.data ) <= 0.0f )
                 {
-                    return;
+                    return std::nullopt;
                 }
 
-                AddInternal(
-                    frameIndex,
-                    light.base.uniqueID,
-                    EncodeAsTriangleLight( lext,
-                                           unnormalizedNormal,
-                                           CalculateLightStyle( light.additional, lightstyles ),
-                                           transform ) );
+                return EncodeAsTriangleLight( lext, unnormalizedNormal, 1.0f, transform );
 #else
                 debug::Error( "Polygonal / triangle lights are not supported" );
+                return std::nullopt;
 #endif
             },
         },
         light.extension );
+
+    if( encoded )
+    {
+        encoded->lightType |= EncodeLightStyle( light.additional );
+    }
+    return encoded;
+}
+
+void RTGL1::LightManager::Add( uint32_t           frameIndex,
+                               const LightCopy&   light,
+                               const RgTransform* transform )
+{
+    RG_CPU_ZONE( "LightManager::Add" );
+
+    std::optional< ShLightEncoded > encoded = Encode( light, transform );
+    if( !encoded )
+    {
+        return;
+    }
+
+    if( GetLightType( *encoded ) == LIGHT_TYPE_DIRECTIONAL && dirLightCount > 0 )
+    {
+        debug::Error( "Only one directional light is allowed" );
+        return;
+    }
+
+    AddInternal( frameIndex, light.base.uniqueID, *encoded );
+}
+
+bool RTGL1::LightManager::IsCachedAsStatic( const LightCopy& light )
+{
+    // directional light occupies its own slot;
+    // lightstyles are fine, as they are resolved in shaders
+    return !std::holds_alternative< RgLightDirectionalEXT >( light.extension );
+}
+
+void RTGL1::LightManager::SetStaticLights( uint32_t                     frameIndex,
+                                           std::span< const LightCopy > lights,
+                                           uint64_t                     version )
+{
+    if( staticLightsVersion == version )
+    {
+        return;
+    }
+    // must be called before any other light is added in this frame
+    assert( dirLightCount == 0 );
+
+    auto newIDToIndex = std::make_shared< rgl::unordered_map< UniqueLightID, LightArrayIndex > >();
+    auto* dst         = lightsBuffer->GetMappedAs< ShLightEncoded* >( frameIndex );
+
+    // light indices of the previous static set are not valid anymore
+    memset( prevToCurIndex->GetMapped( frameIndex ),
+            0xFF,
+            sizeof( uint32_t ) * GetLightArrayEnd( regLightCount_Prev, dirLightCount_Prev ) );
+
+    std::vector< LightTreeInput > treeInputs;
+
+    staticLightsVersion = version;
+    staticRegLightCount = 0;
+    // so FillMatchPrev searches for a static light only in the previous frame's static set
+    staticIDToArrayIndex[ frameIndex ] = newIDToIndex;
+
+    for( const LightCopy& l : lights )
+    {
+        if( !IsCachedAsStatic( l ) )
+        {
+            continue;
+        }
+
+        std::optional< ShLightEncoded > encoded = Encode( l, nullptr );
+        if( !encoded )
+        {
+            continue;
+        }
+
+        if( GetLightArrayEnd( staticRegLightCount, 0 ) >= LIGHT_ARRAY_MAX_SIZE )
+        {
+            debug::Error( "Too many static lights, max is {}", LIGHT_ARRAY_MAX_SIZE );
+            break;
+        }
+
+        const auto index =
+            LightArrayIndex{ LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + staticRegLightCount };
+        staticRegLightCount++;
+
+        memcpy( &dst[ index.GetArrayIndex() ], &encoded.value(), sizeof( ShLightEncoded ) );
+
+        FillMatchPrev( frameIndex, index, l.base.uniqueID );
+
+        assert( !newIDToIndex->contains( l.base.uniqueID ) );
+        ( *newIDToIndex )[ l.base.uniqueID ] = index;
+
+        if( auto input = MakeLightTreeInput( l, index.GetArrayIndex() ) )
+        {
+            treeInputs.push_back( *input );
+        }
+    }
+
+    // all static lights must be in the tree, as the tree covers the whole static range
+    if( treeInputs.size() == staticRegLightCount )
+    {
+        std::vector< ShLightTreeNode > nodes = BuildLightTree( treeInputs );
+        assert( nodes.size() <= 2 * LIGHT_ARRAY_MAX_SIZE - 1 );
+
+        memcpy( lightTreeBuffer->GetMapped( frameIndex ),
+                nodes.data(),
+                sizeof( ShLightTreeNode ) * nodes.size() );
+        lightTreeNodeCount = static_cast< uint32_t >( nodes.size() );
+    }
+    else
+    {
+        assert( 0 );
+        lightTreeNodeCount = 0;
+    }
+
+    // dynamic slots are after the static ones, so they might not fit anymore
+    if( GetDynamicBase() + dynamicSlots.size() > LIGHT_ARRAY_MAX_SIZE )
+    {
+        CompactDynamicSlots();
+    }
+
+    regLightCount       = staticRegLightCount + uint32_t( dynamicSlots.size() );
+    staticUploadPending = true;
 }
 
 void RTGL1::LightManager::SubmitForFrame( VkCommandBuffer cmd, uint32_t frameIndex )
 {
+    RG_CPU_ZONE( "LightManager::SubmitForFrame" );
+
     CmdLabel label( cmd, "Copying lights" );
 
-    lightsBuffer->CopyFromStaging( cmd,
-                                   frameIndex,
-                                   sizeof( ShLightEncoded ) *
-                                       GetLightArrayEnd( regLightCount, dirLightCount ) );
+    ReleaseUnusedDynamicSlots( frameIndex );
+
+    {
+        // static lights persist in the device-local buffer, so copy them only if changed
+        const uint32_t staticBegin =
+            staticUploadPending ? LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET
+                                : GetLightArrayEnd( staticRegLightCount, 0 );
+        const uint32_t end = GetLightArrayEnd( regLightCount, dirLightCount );
+
+        VkBufferCopy copies[ 2 ];
+        uint32_t     copyCount = 0;
+
+        if( LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET > 0 )
+        {
+            copies[ copyCount++ ] = VkBufferCopy{
+                .srcOffset = 0,
+                .dstOffset = 0,
+                .size      = sizeof( ShLightEncoded ) * LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET,
+            };
+        }
+        if( end > staticBegin )
+        {
+            copies[ copyCount++ ] = VkBufferCopy{
+                .srcOffset = sizeof( ShLightEncoded ) * staticBegin,
+                .dstOffset = sizeof( ShLightEncoded ) * staticBegin,
+                .size      = sizeof( ShLightEncoded ) * ( end - staticBegin ),
+            };
+        }
+
+        lightsBuffer->CopyFromStaging( cmd, frameIndex, copies, copyCount );
+
+        if( staticUploadPending )
+        {
+            lightTreeBuffer->CopyFromStaging(
+                cmd, frameIndex, sizeof( ShLightTreeNode ) * lightTreeNodeCount );
+        }
+        staticUploadPending = false;
+    }
+
+    {
+        auto* dst = lightstylesBuffer->GetMappedAs< float* >( frameIndex );
+
+        // out of range values don't affect a light
+        const size_t count = std::min< size_t >( lightstyles.size(), LIGHTSTYLE_MAX_COUNT );
+        for( size_t i = 0; i < LIGHTSTYLE_MAX_COUNT; i++ )
+        {
+            dst[ i ] = i < count ? float( lightstyles[ i ] ) / 255.0f : 1.0f;
+        }
+
+        lightstylesBuffer->CopyFromStaging( cmd, frameIndex );
+    }
 
     prevToCurIndex->CopyFromStaging(
         cmd,
@@ -572,6 +953,38 @@ void RTGL1::LightManager::BarrierLightGrid( VkCommandBuffer cmd, uint32_t frameI
 #endif
 }
 
+void RTGL1::LightManager::ClearLightGridHistory( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+#if LIGHT_GRID_ENABLED
+    // zeroed cells have zero weight, so temporal reuse of them has no effect
+    VkBuffer prevGrid = initialLightsGrid[ Utils::PrevFrame( frameIndex ) ].GetBuffer();
+
+    vkCmdFillBuffer( cmd, prevGrid, 0, VK_WHOLE_SIZE, 0 );
+
+    VkBufferMemoryBarrier2 barrier = {
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .pNext               = nullptr,
+        .srcStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+        .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+        .dstAccessMask       = VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer              = prevGrid,
+        .offset              = 0,
+        .size                = VK_WHOLE_SIZE,
+    };
+
+    VkDependencyInfo dependency = {
+        .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers    = &barrier,
+    };
+
+    svkCmdPipelineBarrier2KHR( cmd, &dependency );
+#endif
+}
+
 VkDescriptorSetLayout RTGL1::LightManager::GetDescSetLayout() const
 {
     return descSetLayout;
@@ -586,23 +999,82 @@ void RTGL1::LightManager::FillMatchPrev( uint32_t        curFrameIndex,
                                          LightArrayIndex lightIndexInCurFrame,
                                          UniqueLightID   uniqueID )
 {
-    uint32_t prevFrame = ( curFrameIndex + 1 ) % MAX_FRAMES_IN_FLIGHT;
-    const rgl::unordered_map< UniqueLightID, LightArrayIndex >& uniqueToPrevIndex =
-        uniqueIDToArrayIndex[ prevFrame ];
+    std::optional< LightArrayIndex > lightIndexInPrevFrame =
+        FindIndexInPrevFrame( curFrameIndex, uniqueID );
+
+    auto* cur2prev = curToPrevIndex->GetMappedAs< uint32_t* >( curFrameIndex );
+    cur2prev[ lightIndexInCurFrame.GetArrayIndex() ] =
+        lightIndexInPrevFrame ? lightIndexInPrevFrame->GetArrayIndex() : UINT32_MAX;
+
+    if( lightIndexInPrevFrame )
+    {
+        auto* prev2cur = prevToCurIndex->GetMappedAs< uint32_t* >( curFrameIndex );
+        prev2cur[ lightIndexInPrevFrame->GetArrayIndex() ] = lightIndexInCurFrame.GetArrayIndex();
+    }
+}
+
+auto RTGL1::LightManager::FindIndex( uint32_t frameIndex, UniqueLightID uniqueID ) const
+    -> std::optional< LightArrayIndex >
+{
+    if( dirLightID == uniqueID )
+    {
+        return LightArrayIndex{ LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET };
+    }
 
-    auto found = uniqueToPrevIndex.find( uniqueID );
-    if( found == uniqueToPrevIndex.end() )
+    if( const auto* staticIDToIndex = staticIDToArrayIndex[ frameIndex ].get() )
     {
-        return;
+        auto s = staticIDToIndex->find( uniqueID );
+        if( s != staticIDToIndex->end() )
+        {
+            return s->second;
+        }
     }
 
-    LightArrayIndex lightIndexInPrevFrame = found->second;
+    auto d = dynamicSlotOfLight.find( uniqueID );
+    if( d != dynamicSlotOfLight.end() && dynamicSlots[ d->second ].lastAddedFrame == frameCounter )
+    {
+        return LightArrayIndex{ GetDynamicBase() + d->second };
+    }
 
-    auto* prev2cur = prevToCurIndex->GetMappedAs< uint32_t* >( curFrameIndex );
-    prev2cur[ lightIndexInPrevFrame.GetArrayIndex() ] = lightIndexInCurFrame.GetArrayIndex();
+    return std::nullopt;
+}
 
-    auto* cur2prev = curToPrevIndex->GetMappedAs< uint32_t* >( curFrameIndex );
-    cur2prev[ lightIndexInCurFrame.GetArrayIndex() ] = lightIndexInPrevFrame.GetArrayIndex();
+auto RTGL1::LightManager::FindIndexInPrevFrame( uint32_t      curFrameIndex,
+                                                UniqueLightID uniqueID ) const
+    -> std::optional< LightArrayIndex >
+{
+    if( dirLightID_Prev == uniqueID )
+    {
+        return LightArrayIndex{ LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET };
+    }
+
+    const uint32_t prevFrame = Utils::PrevFrame( curFrameIndex );
+
+    if( const auto* staticIDToIndex = staticIDToArrayIndex[ prevFrame ].get() )
+    {
+        auto s = staticIDToIndex->find( uniqueID );
+        if( s != staticIDToIndex->end() )
+        {
+            return s->second;
+        }
+    }
+
+    auto c = dynamicSlotOfLight_Compacted.find( uniqueID );
+    if( c != dynamicSlotOfLight_Compacted.end() )
+    {
+        return LightArrayIndex{ dynamicBase_Prev + c->second };
+    }
+
+    // slots are released at the end of a frame, if a light wasn't added,
+    // so a slot with the previous frame mark is the same one
+    auto d = dynamicSlotOfLight.find( uniqueID );
+    if( d != dynamicSlotOfLight.end() &&
+        dynamicSlots[ d->second ].lastAddedFrame + 1 == frameCounter )
+    {
+        return LightArrayIndex{ dynamicBase_Prev + d->second };
+    }
+
+    return std::nullopt;
 }
 
 constexpr uint32_t BINDINGS[] = {
@@ -610,6 +1082,8 @@ constexpr uint32_t BINDINGS[] = {
     BINDING_LIGHT_SOURCES_PREV,
     BINDING_LIGHT_SOURCES_INDEX_PREV_TO_CUR,
     BINDING_LIGHT_SOURCES_INDEX_CUR_TO_PREV,
+    BINDING_LIGHT_TREE,
+    BINDING_LIGHTSTYLES,
 #if LIGHT_GRID_ENABLED
     BINDING_INITIAL_LIGHTS_GRID,
     BINDING_INITIAL_LIGHTS_GRID_PREV,
@@ -697,9 +1171,11 @@ void RTGL1::LightManager::UpdateDescriptors( uint32_t frameIndex )
         lightsBuffer_Prev.GetBuffer(),
         prevToCurIndex->GetDeviceLocal(),
         curToPrevIndex->GetDeviceLocal(),
+        lightTreeBuffer->GetDeviceLocal(),
+        lightstylesBuffer->GetDeviceLocal(),
 #if LIGHT_GRID_ENABLED
         initialLightsGrid[ frameIndex ].GetBuffer(),
-        initialLightsGrid[ Utils::GetPreviousByModulo( frameIndex, MAX_FRAMES_IN_FLIGHT ) ]
+        initialLightsGrid[ Utils::GetPreviousByModulo( frameIndex, FramesInFlight() ) ]
             .GetBuffer(),
 #endif
     };
@@ -746,6 +1222,12 @@ uint32_t RTGL1::LightManager::GetLightCountPrev() const
 }
 
 
+uint32_t RTGL1::LightManager::GetLightTreeLeafCount() const
+{
+    // tree is over the static lights that are placed at the beginning
+    return lightTreeNodeCount > 0 ? staticRegLightCount : 0;
+}
+
 uint32_t RTGL1::LightManager::DoesDirectionalLightExist() const
 {
     return dirLightCount > 0 ? 1 : 0;
@@ -760,105 +1242,21 @@ uint32_t RTGL1::LightManager::GetLightIndexForShaders( uint32_t        frameInde
     }
     UniqueLightID uniqueId = { *pLightUniqueId };
 
-    const auto f = uniqueIDToArrayIndex[ frameIndex ].find( uniqueId );
-    if( f == uniqueIDToArrayIndex[ frameIndex ].end() )
+    std::optional< LightArrayIndex > index = FindIndex( frameIndex, uniqueId );
+    if( !index )
     {
         return LIGHT_INDEX_NONE;
     }
 
-    return f->second.GetArrayIndex();
+    return index->GetArrayIndex();
 }
 
-auto RTGL1::LightManager::TryGetVolumetricLight( const RgFloat3D&                 cameraPos,
-                                                 const std::vector< LightCopy >&  from,
-                                                 const std::optional< uint64_t >& fallback ) const
-    -> std::optional< uint64_t >
+float RTGL1::LightManager::ApproxVolumetricIntensity( const LightCopy& light ) const
 {
-    static auto l_isVolumetric = []( const LightCopy& l ) {
-        return l.additional && ( l.additional->flags & RG_LIGHT_ADDITIONAL_VOLUMETRIC );
-    };
-
-    auto l_approxVolumetricIntensity = [ this ]( const LightCopy& l ) {
-        assert( l_isVolumetric( l ) );
-
-        float intensity =
-            std::visit( []( const auto& lext ) { return lext.intensity; }, l.extension );
-
-        return intensity * CalculateLightStyle( l.additional, lightstyles );
-    };
-    auto l_approxDistanceSq = []( const LightCopy& l, const RgFloat3D& from ) -> float {
-        // clang-format off
-        return std::visit( ext::overloaded{
-            [ & ]( const RgLightDirectionalEXT& lext ) { return 0.f; },
-            [ & ]( const RgLightSphericalEXT&   lext ) { return Utils::SqrDistanceR( lext.position, from ); },
-            [ & ]( const RgLightSpotEXT&        lext ) { return Utils::SqrDistanceR( lext.position, from ); },
-            [ & ]( const RgLightPolygonalEXT&   lext ) { assert( 0 ); return -1.f; },
-        }, l.extension );
-        // clang-format on
-    };
-
-    struct Candidate
-    {
-        uint64_t id;
-        float    distanceSq;
-    };
-    auto best = std::optional< Candidate >{};
-    auto any  = std::optional< Candidate >{};
-
-    for( const auto& l : from )
-    {
-        if( !l_isVolumetric( l ) )
-        {
-            continue;
-        }
-        
-        if( l_approxVolumetricIntensity( l ) > 0.0f )
-        {
-            float distSq = l_approxDistanceSq( l, cameraPos );
-            if( distSq >= 0 )
-            {
-                // choose closest
-                if( !best || distSq < best->distanceSq )
-                {
-                    best = Candidate{
-                        .id         = l.base.uniqueID,
-                        .distanceSq = distSq,
-                    };
-                }
-            }
-        }
-
-        if( !any )
-        {
-            any = Candidate{
-                .id         = l.base.uniqueID,
-                .distanceSq = 0,
-            };
-        }
-    }
-
-    if( best )
-    {
-        return best->id;
-    }
-
-    // SHIPPING_HACK: don't fallback to sun, if at least
-    // one light is marked as isVolumetric, but has 0 intensity
-    if( any )
-    {
-        return any->id;
-    }
-
-    // if nothing, just try find the sun in the provided list
-    for( const auto& l : from )
-    {
-        if( auto sun = std::get_if< RgLightDirectionalEXT >( &l.extension ) )
-        {
-            return l.base.uniqueID;
-        }
-    }
+    float intensity =
+        std::visit( []( const auto& lext ) { return lext.intensity; }, light.extension );
 
-    return fallback;
+    return intensity * CalculateLightStyle( light.additional, lightstyles );
 }
 
 void RTGL1::LightManager::SetLightstyles( const RgStartFrameInfo& params )
@@ -872,7 +1270,6 @@ void RTGL1::LightManager::SetLightstyles( const RgStartFrameInfo& params )
     lightstyles.assign( values.begin(), values.end() );
 }
 
-static_assert( RTGL1::MAX_FRAMES_IN_FLIGHT == 2 );
 
 
 #include "glm/glm.hpp"
@@ -29,7 +29,7 @@
 #include <optional>
 #include <span>
 
-#define LIGHT_GRID_ENABLED_ 0
+#define LIGHT_GRID_ENABLED_ 1
 
 namespace RTGL1
 {
@@ -52,31 +52,50 @@ public:
 
     uint32_t GetLightCount() const;
     uint32_t GetLightCountPrev() const;
+    uint32_t GetLightTreeLeafCount() const;
     uint32_t DoesDirectionalLightExist() const;
 
     uint32_t GetLightIndexForShaders( uint32_t frameIndex, const uint64_t* pLightUniqueId ) const;
 
     void Add( uint32_t frameIndex, const LightCopy& light, const RgTransform* transform = nullptr );
 
+    // Encode and upload static lights only if 'version' differs from the previous call.
+    // Lights that are not IsCachedAsStatic must be added each frame via Add.
+    // Lightstyles don't require re-encoding, their values are applied in shaders.
+    void        SetStaticLights( uint32_t                     frameIndex,
+                                 std::span< const LightCopy > lights,
+                                 uint64_t                     version );
+    static bool IsCachedAsStatic( const LightCopy& light );
+
     void SubmitForFrame( VkCommandBuffer cmd, uint32_t frameIndex );
     void BarrierLightGrid( VkCommandBuffer cmd, uint32_t frameIndex );
+    // Must be called if the grid was not built in the previous frame
+    void ClearLightGridHistory( VkCommandBuffer cmd, uint32_t frameIndex );
 
     VkDescriptorSetLayout GetDescSetLayout() const;
     VkDescriptorSet       GetDescSet( uint32_t frameIndex ) const;
 
     void SetLightstyles( const RgStartFrameInfo& params );
 
-    auto TryGetVolumetricLight( const RgFloat3D&                 cameraPos,
-                                const std::vector< LightCopy >&  from,
-                                const std::optional< uint64_t >& fallback ) const
-        -> std::optional< uint64_t >;
+    // Intensity with the current lightstyle applied
+    float ApproxVolumetricIntensity( const LightCopy& light ) const;
 
 private:
-    LightArrayIndex GetIndex( const ShLightEncoded& encodedLight ) const;
-    void            IncrementCount( const ShLightEncoded& encodedLight );
-
     void AddInternal( uint32_t frameIndex, uint64_t uniqueId, const ShLightEncoded& encodedLight );
 
+    auto Encode( const LightCopy& light, const RgTransform* transform ) const
+        -> std::optional< ShLightEncoded >;
+
+    auto AcquireDynamicSlot( UniqueLightID uniqueID ) -> std::optional< uint32_t >;
+    void ReleaseUnusedDynamicSlots( uint32_t frameIndex );
+    void CompactDynamicSlots();
+    auto GetDynamicBase() const -> uint32_t;
+
+    auto FindIndex( uint32_t frameIndex, UniqueLightID uniqueID ) const
+        -> std::optional< LightArrayIndex >;
+    auto FindIndexInPrevFrame( uint32_t curFrameIndex, UniqueLightID uniqueID ) const
+        -> std::optional< LightArrayIndex >;
+
     void FillMatchPrev( uint32_t        curFrameIndex,
                         LightArrayIndex lightIndexInCurFrame,
                         UniqueLightID   uniqueID );
@@ -97,14 +116,46 @@ private:
     std::shared_ptr< AutoBuffer > prevToCurIndex;
     std::shared_ptr< AutoBuffer > curToPrevIndex;
 
-    rgl::unordered_map< UniqueLightID, LightArrayIndex >
-        uniqueIDToArrayIndex[ MAX_FRAMES_IN_FLIGHT ];
+    // Dynamic lights keep their slot while they are added each frame, so their array index
+    // is the same across frames, and the prev/cur remap is mostly identity.
+    // Slots are placed right after the static lights, free ones are encoded as LIGHT_TYPE_NONE.
+    struct DynamicSlot
+    {
+        UniqueLightID owner;
+        uint64_t      lastAddedFrame;
+        bool          occupied;
+    };
+    std::vector< DynamicSlot >                    dynamicSlots;
+    rgl::unordered_map< UniqueLightID, uint32_t > dynamicSlotOfLight;
+    uint32_t                                      dynamicFirstFreeSlot;
+    uint32_t                                      dynamicBase_Prev;
+    // slots before the compaction in this frame, to match the indices with the previous frame
+    rgl::unordered_map< UniqueLightID, uint32_t > dynamicSlotOfLight_Compacted;
+    uint64_t                                      frameCounter;
+
+    std::optional< UniqueLightID > dirLightID;
+    std::optional< UniqueLightID > dirLightID_Prev;
 
     uint32_t regLightCount;
     uint32_t regLightCount_Prev;
     uint32_t dirLightCount;
     uint32_t dirLightCount_Prev;
 
+    // Static lights are encoded once into the beginning of the regular light range,
+    // and stay in the device-local buffer until the static set changes
+    std::optional< uint64_t > staticLightsVersion;
+    uint32_t                  staticRegLightCount;
+    bool                      staticUploadPending;
+    std::shared_ptr< const rgl::unordered_map< UniqueLightID, LightArrayIndex > >
+        staticIDToArrayIndex[ MAX_FRAMES_IN_FLIGHT ];
+
+    // Built over the static lights, when the static set changes
+    std::shared_ptr< AutoBuffer > lightTreeBuffer;
+    uint32_t                      lightTreeNodeCount;
+
+    // Lightstyle values, lights store only an index
+    std::shared_ptr< AutoBuffer > lightstylesBuffer;
+
     VkDescriptorSetLayout descSetLayout;
     VkDescriptorPool      descPool;
     VkDescriptorSet       descSets[ MAX_FRAMES_IN_FLIGHT ];
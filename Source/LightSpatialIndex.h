@@ -0,0 +1,264 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Containers.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Uniform grid over point-like lights, to find the ones near a point without visiting
+// all of them. Cells are hashed, so the grid is unbounded and only occupied cells are stored.
+// Cell size only affects the query speed, not the results
+class LightSpatialIndex
+{
+public:
+    explicit LightSpatialIndex( float _cellSize = 32.0f )
+        : cellSize( std::max( _cellSize, 0.001f ) ), invCellSize( 1.0f / cellSize )
+    {
+    }
+
+    void Insert( uint32_t lightIndex, const RgFloat3D& position )
+    {
+        const Coord c = ToCoord( position );
+
+        cells[ Pack( c ) ].push_back( Entry{ .lightIndex = lightIndex, .position = position } );
+
+        for( int a = 0; a < 3; a++ )
+        {
+            boundsMin[ a ] = std::min( boundsMin[ a ], c[ a ] );
+            boundsMax[ a ] = std::max( boundsMax[ a ], c[ a ] );
+        }
+    }
+
+    void Clear()
+    {
+        cells.clear();
+        boundsMin = { INT32_MAX, INT32_MAX, INT32_MAX };
+        boundsMax = { INT32_MIN, INT32_MIN, INT32_MIN };
+    }
+
+    bool Empty() const { return cells.empty(); }
+
+    // Call 'f( lightIndex, distanceSq )' for each light within 'radius' from 'center'
+    template< typename F >
+    void ForEachInRadius( const RgFloat3D& center, float radius, F&& f ) const
+    {
+        if( Empty() || radius < 0 )
+        {
+            return;
+        }
+
+        const float radiusSq = radius * radius;
+        const Coord cmin     = ToCoord( { center.data[ 0 ] - radius,
+                                          center.data[ 1 ] - radius,
+                                          center.data[ 2 ] - radius } );
+        const Coord cmax     = ToCoord( { center.data[ 0 ] + radius,
+                                          center.data[ 1 ] + radius,
+                                          center.data[ 2 ] + radius } );
+
+        auto l_visitCell = [ & ]( const std::vector< Entry >& entries ) {
+            for( const Entry& e : entries )
+            {
+                const float distSq = Utils::SqrDistanceR( e.position, center );
+                if( distSq <= radiusSq )
+                {
+                    f( e.lightIndex, distSq );
+                }
+            }
+        };
+
+        if( CellCount( cmin, cmax ) > cells.size() )
+        {
+            for( const auto& [ key, entries ] : cells )
+            {
+                l_visitCell( entries );
+            }
+            return;
+        }
+
+        for( int32_t z = std::max( cmin[ 2 ], boundsMin[ 2 ] );
+             z <= std::min( cmax[ 2 ], boundsMax[ 2 ] );
+             z++ )
+        {
+            for( int32_t y = std::max( cmin[ 1 ], boundsMin[ 1 ] );
+                 y <= std::min( cmax[ 1 ], boundsMax[ 1 ] );
+                 y++ )
+            {
+                for( int32_t x = std::max( cmin[ 0 ], boundsMin[ 0 ] );
+                     x <= std::min( cmax[ 0 ], boundsMax[ 0 ] );
+                     x++ )
+                {
+                    if( auto found = cells.find( Pack( { x, y, z } ) ); found != cells.end() )
+                    {
+                        l_visitCell( found->second );
+                    }
+                }
+            }
+        }
+    }
+
+    // Closest light to 'center' among the ones for which 'filter( lightIndex )' is true.
+    // On equal distance, the light with the lowest index is chosen
+    template< typename Filter >
+    auto FindNearest( const RgFloat3D& center, Filter&& filter ) const -> std::optional< uint32_t >
+    {
+        struct Candidate
+        {
+            uint32_t lightIndex;
+            float    distanceSq;
+        };
+        auto best = std::optional< Candidate >{};
+
+        auto l_visitCell = [ & ]( const std::vector< Entry >& entries ) {
+            for( const Entry& e : entries )
+            {
+                const float distSq = Utils::SqrDistanceR( e.position, center );
+
+                if( best && std::pair{ distSq, e.lightIndex } >=
+                                std::pair{ best->distanceSq, best->lightIndex } )
+                {
+                    continue;
+                }
+                if( filter( e.lightIndex ) )
+                {
+                    best = Candidate{ .lightIndex = e.lightIndex, .distanceSq = distSq };
+                }
+            }
+        };
+
+        if( Empty() )
+        {
+            return std::nullopt;
+        }
+
+        const Coord c = ToCoord( center );
+
+        int32_t maxRing = 0;
+        for( int a = 0; a < 3; a++ )
+        {
+            maxRing = std::max( { maxRing, c[ a ] - boundsMin[ a ], boundsMax[ a ] - c[ a ] } );
+        }
+
+        // visit cells ring by ring, where a ring is the surface of a cube around the center cell
+        for( int32_t r = 0; r <= maxRing; r++ )
+        {
+            // lights outside of the visited cells are at least that far
+            const float reachedDist = float( r - 1 ) * cellSize;
+            if( best && r > 0 && best->distanceSq < reachedDist * reachedDist )
+            {
+                break;
+            }
+
+            const Coord rmin = { c[ 0 ] - r, c[ 1 ] - r, c[ 2 ] - r };
+            const Coord rmax = { c[ 0 ] + r, c[ 1 ] + r, c[ 2 ] + r };
+
+            // too sparse to visit cell by cell
+            if( CellCount( rmin, rmax ) > cells.size() * 2 )
+            {
+                for( const auto& [ key, entries ] : cells )
+                {
+                    l_visitCell( entries );
+                }
+                break;
+            }
+
+            for( int32_t z = rmin[ 2 ]; z <= rmax[ 2 ]; z++ )
+            {
+                for( int32_t y = rmin[ 1 ]; y <= rmax[ 1 ]; y++ )
+                {
+                    const bool onFace = ( z == rmin[ 2 ] || z == rmax[ 2 ] || y == rmin[ 1 ] ||
+                                          y == rmax[ 1 ] );
+
+                    // inner rows of the ring have only two cells
+                    const int32_t step = onFace ? 1 : std::max( 1, 2 * r );
+
+                    for( int32_t x = rmin[ 0 ]; x <= rmax[ 0 ]; x += step )
+                    {
+                        if( auto found = cells.find( Pack( { x, y, z } ) ); found != cells.end() )
+                        {
+                            l_visitCell( found->second );
+                        }
+                    }
+                }
+            }
+        }
+
+        return best ? std::optional{ best->lightIndex } : std::nullopt;
+    }
+
+private:
+    using Coord = std::array< int32_t, 3 >;
+
+    // 21 bits per axis
+    constexpr static int32_t CoordLimit = ( 1 << 20 ) - 1;
+
+    Coord ToCoord( const RgFloat3D& p ) const
+    {
+        Coord c{};
+        for( int a = 0; a < 3; a++ )
+        {
+            const float f = std::floor( p.data[ a ] * invCellSize );
+            c[ a ] = int32_t( std::clamp( f, float( -CoordLimit ), float( CoordLimit ) ) );
+        }
+        return c;
+    }
+
+    static uint64_t Pack( const Coord& c )
+    {
+        constexpr uint64_t mask = ( 1ull << 21 ) - 1;
+        return ( uint64_t( c[ 0 ] ) & mask ) | ( ( uint64_t( c[ 1 ] ) & mask ) << 21 ) |
+               ( ( uint64_t( c[ 2 ] ) & mask ) << 42 );
+    }
+
+    static uint64_t CellCount( const Coord& cmin, const Coord& cmax )
+    {
+        uint64_t count = 1;
+        for( int a = 0; a < 3; a++ )
+        {
+            count *= uint64_t( int64_t{ cmax[ a ] } - cmin[ a ] + 1 );
+        }
+        return count;
+    }
+
+private:
+    struct Entry
+    {
+        uint32_t  lightIndex;
+        RgFloat3D position;
+    };
+
+    float cellSize;
+    float invCellSize;
+
+    rgl::unordered_map< uint64_t, std::vector< Entry > > cells{};
+    Coord boundsMin{ INT32_MAX, INT32_MAX, INT32_MAX };
+    Coord boundsMax{ INT32_MIN, INT32_MIN, INT32_MIN };
+};
+
+}
@@ -0,0 +1,221 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "LightTree.h"
+
+#include "Utils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+namespace
+{
+
+struct Cone
+{
+    RgFloat3D axis;
+    float     theta;
+};
+
+RgFloat3D Centroid( const RTGL1::LightTreeInput& l )
+{
+    return RgFloat3D{
+        0.5f * ( l.bbMin.data[ 0 ] + l.bbMax.data[ 0 ] ),
+        0.5f * ( l.bbMin.data[ 1 ] + l.bbMax.data[ 1 ] ),
+        0.5f * ( l.bbMin.data[ 2 ] + l.bbMax.data[ 2 ] ),
+    };
+}
+
+// smallest cone that contains both
+Cone Union( const Cone& x, const Cone& y )
+{
+    constexpr float pi = std::numbers::pi_v< float >;
+
+    const Cone& a = x.theta >= y.theta ? x : y;
+    const Cone& b = x.theta >= y.theta ? y : x;
+
+    if( a.theta >= pi )
+    {
+        return a;
+    }
+
+    float cosD   = std::clamp( RTGL1::Utils::Dot( a.axis, b.axis ), -1.0f, 1.0f );
+    float thetaD = std::acos( cosD );
+
+    if( std::min( thetaD + b.theta, pi ) <= a.theta )
+    {
+        return a;
+    }
+
+    float thetaO = 0.5f * ( a.theta + thetaD + b.theta );
+    if( thetaO >= pi )
+    {
+        return Cone{ .axis = a.axis, .theta = pi };
+    }
+
+    // rotate 'a.axis' towards 'b.axis'
+    RgFloat3D ortho = {
+        b.axis.data[ 0 ] - a.axis.data[ 0 ] * cosD,
+        b.axis.data[ 1 ] - a.axis.data[ 1 ] * cosD,
+        b.axis.data[ 2 ] - a.axis.data[ 2 ] * cosD,
+    };
+    float orthoLen = RTGL1::Utils::Length( ortho.data );
+    if( orthoLen < 0.0001f )
+    {
+        return Cone{ .axis = a.axis, .theta = pi };
+    }
+
+    float thetaR = thetaO - a.theta;
+    float c      = std::cos( thetaR );
+    float s      = std::sin( thetaR ) / orthoLen;
+
+    return Cone{
+        .axis =
+            RTGL1::Utils::Normalize( RgFloat3D{
+                a.axis.data[ 0 ] * c + ortho.data[ 0 ] * s,
+                a.axis.data[ 1 ] * c + ortho.data[ 1 ] * s,
+                a.axis.data[ 2 ] * c + ortho.data[ 2 ] * s,
+            } ),
+        .theta = thetaO,
+    };
+}
+
+RTGL1::ShLightTreeNode MakeNode( const RgFloat3D& mn,
+                                 const RgFloat3D& mx,
+                                 float            energy,
+                                 const Cone&      cone,
+                                 uint32_t         childOrLight )
+{
+    return RTGL1::ShLightTreeNode{
+        .bbMin_x      = mn.data[ 0 ],
+        .bbMin_y      = mn.data[ 1 ],
+        .bbMin_z      = mn.data[ 2 ],
+        .childOrLight = childOrLight,
+        .bbMax_x      = mx.data[ 0 ],
+        .bbMax_y      = mx.data[ 1 ],
+        .bbMax_z      = mx.data[ 2 ],
+        .energy       = energy,
+        .coneAxis_x   = cone.axis.data[ 0 ],
+        .coneAxis_y   = cone.axis.data[ 1 ],
+        .coneAxis_z   = cone.axis.data[ 2 ],
+        .coneCosTheta = std::cos( cone.theta ),
+    };
+}
+
+Cone BuildNode( std::span< RTGL1::LightTreeInput >      lights,
+                uint32_t                                nodeIndex,
+                uint32_t                                depth,
+                std::vector< RTGL1::ShLightTreeNode >& nodes )
+{
+    assert( !lights.empty() );
+
+    if( lights.size() == 1 )
+    {
+        const RTGL1::LightTreeInput& l = lights[ 0 ];
+
+        auto cone = Cone{
+            .axis  = l.coneAxis,
+            .theta = std::acos( std::clamp( l.coneCosTheta, -1.0f, 1.0f ) ),
+        };
+        nodes[ nodeIndex ] = MakeNode(
+            l.bbMin, l.bbMax, l.energy, cone, l.lightIndex | LIGHT_TREE_NODE_LEAF_BIT );
+        return cone;
+    }
+
+    // split by the median centroid along the longest axis
+    {
+        RgFloat3D cmin = Centroid( lights[ 0 ] );
+        RgFloat3D cmax = cmin;
+        for( const auto& l : lights )
+        {
+            RgFloat3D c = Centroid( l );
+            for( int i = 0; i < 3; i++ )
+            {
+                cmin.data[ i ] = std::min( cmin.data[ i ], c.data[ i ] );
+                cmax.data[ i ] = std::max( cmax.data[ i ], c.data[ i ] );
+            }
+        }
+
+        int axis = 0;
+        for( int i = 1; i < 3; i++ )
+        {
+            if( cmax.data[ i ] - cmin.data[ i ] > cmax.data[ axis ] - cmin.data[ axis ] )
+            {
+                axis = i;
+            }
+        }
+
+        std::ranges::nth_element(
+            lights,
+            lights.begin() + lights.size() / 2,
+            [ axis ]( const RTGL1::LightTreeInput& a, const RTGL1::LightTreeInput& b ) {
+                return Centroid( a ).data[ axis ] < Centroid( b ).data[ axis ];
+            } );
+    }
+
+    // median split guarantees the depth to be log2
+    assert( depth < LIGHT_TREE_MAX_DEPTH );
+
+    const auto leftIndex = static_cast< uint32_t >( nodes.size() );
+    nodes.resize( nodes.size() + 2 );
+
+    const auto half  = lights.size() / 2;
+    Cone       left  = BuildNode( lights.subspan( 0, half ), leftIndex, depth + 1, nodes );
+    Cone       right = BuildNode( lights.subspan( half ), leftIndex + 1, depth + 1, nodes );
+
+    const RTGL1::ShLightTreeNode& l = nodes[ leftIndex ];
+    const RTGL1::ShLightTreeNode& r = nodes[ leftIndex + 1 ];
+
+    auto mn = RgFloat3D{
+        std::min( l.bbMin_x, r.bbMin_x ),
+        std::min( l.bbMin_y, r.bbMin_y ),
+        std::min( l.bbMin_z, r.bbMin_z ),
+    };
+    auto mx = RgFloat3D{
+        std::max( l.bbMax_x, r.bbMax_x ),
+        std::max( l.bbMax_y, r.bbMax_y ),
+        std::max( l.bbMax_z, r.bbMax_z ),
+    };
+
+    Cone cone          = Union( left, right );
+    nodes[ nodeIndex ] = MakeNode( mn, mx, l.energy + r.energy, cone, leftIndex );
+    return cone;
+}
+
+}
+
+auto RTGL1::BuildLightTree( std::span< LightTreeInput > lights ) -> std::vector< ShLightTreeNode >
+{
+    if( lights.empty() )
+    {
+        return {};
+    }
+
+    std::vector< ShLightTreeNode > nodes;
+    nodes.reserve( lights.size() * 2 - 1 );
+    nodes.resize( 1 );
+
+    BuildNode( lights, 0, 0, nodes );
+
+    assert( nodes.size() == lights.size() * 2 - 1 );
+    return nodes;
+}
@@ -0,0 +1,49 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include "RTGL1/RTGL1.h"
+#include "Generated/ShaderCommonC.h"
+
+namespace RTGL1
+{
+
+struct LightTreeInput
+{
+    RgFloat3D bbMin;
+    RgFloat3D bbMax;
+    // approximate power, used to importance sample a node
+    float     energy;
+    // emission directions are inside the cone
+    RgFloat3D coneAxis;
+    float     coneCosTheta;
+    uint32_t  lightIndex;
+};
+
+// Binary tree over lights, with spatial and orientation bounds in each node.
+// Root is at index 0, leaves contain one light. Built on CPU, so intended only for
+// the light sets that change rarely, e.g. the static ones.
+auto BuildLightTree( std::span< LightTreeInput > lights ) -> std::vector< ShLightTreeNode >;
+
+}
@@ -0,0 +1,230 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "LowLatency.h"
+
+RTGL1::LowLatency::LowLatency( VkDevice _device,
+                               bool     withLowLatency2,
+                               bool     withAntiLag,
+                               bool     _withPresentId )
+    : device{ _device }
+    , backend{ withLowLatency2 ? Backend::NvLowLatency2
+               : withAntiLag   ? Backend::AmdAntiLag
+                               : Backend::None }
+    , withPresentId{ _withPresentId }
+{
+    if( backend == Backend::NvLowLatency2 )
+    {
+        auto timelineInfo = VkSemaphoreTypeCreateInfo{
+            .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            .initialValue  = 0,
+        };
+        auto semaphoreInfo = VkSemaphoreCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &timelineInfo,
+        };
+
+        VkResult r = vkCreateSemaphore( device, &semaphoreInfo, nullptr, &sleepSemaphore );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device, sleepSemaphore, VK_OBJECT_TYPE_SEMAPHORE, "Latency sleep" );
+    }
+}
+
+RTGL1::LowLatency::~LowLatency()
+{
+    if( sleepSemaphore != VK_NULL_HANDLE )
+    {
+        vkDestroySemaphore( device, sleepSemaphore, nullptr );
+    }
+}
+
+void RTGL1::LowLatency::SetMode( VkSwapchainKHR swapchain, bool enable )
+{
+    if( modeSwapchain == swapchain && modeEnabled == enable )
+    {
+        return;
+    }
+
+    switch( backend )
+    {
+        case Backend::NvLowLatency2: {
+            // sleep mode is a state of a swapchain, so it must be set again after recreation
+            auto info = VkLatencySleepModeInfoNV{
+                .sType             = VK_STRUCTURE_TYPE_LATENCY_SLEEP_MODE_INFO_NV,
+                .lowLatencyMode    = enable,
+                .lowLatencyBoost   = enable,
+                .minimumIntervalUs = 0,
+            };
+            VkResult r = svkSetLatencySleepModeNV( device, swapchain, &info );
+            if( r != VK_SUCCESS )
+            {
+                debug::Warning( "vkSetLatencySleepModeNV failed: {}", int( r ) );
+            }
+            break;
+        }
+        case Backend::AmdAntiLag: {
+#ifdef VK_AMD_anti_lag
+            if( !enable )
+            {
+                auto data = VkAntiLagDataAMD{
+                    .sType             = VK_STRUCTURE_TYPE_ANTI_LAG_DATA_AMD,
+                    .mode              = VK_ANTI_LAG_MODE_OFF_AMD,
+                    .maxFPS            = 0,
+                    .pPresentationInfo = nullptr,
+                };
+                svkAntiLagUpdateAMD( device, &data );
+            }
+#endif
+            break;
+        }
+        default: break;
+    }
+
+    modeSwapchain = swapchain;
+    modeEnabled   = enable;
+}
+
+void RTGL1::LowLatency::Sleep( VkSwapchainKHR swapchain, bool enable, uint64_t frameId )
+{
+    active    = false;
+    presentId = frameId + 1;
+
+    if( backend == Backend::None || swapchain == VK_NULL_HANDLE )
+    {
+        return;
+    }
+
+    SetMode( swapchain, enable );
+
+    if( !enable )
+    {
+        return;
+    }
+    active = true;
+
+    switch( backend )
+    {
+        case Backend::NvLowLatency2: {
+            sleepValue++;
+
+            auto sleepInfo = VkLatencySleepInfoNV{
+                .sType           = VK_STRUCTURE_TYPE_LATENCY_SLEEP_INFO_NV,
+                .signalSemaphore = sleepSemaphore,
+                .value           = sleepValue,
+            };
+            VkResult r = svkLatencySleepNV( device, swapchain, &sleepInfo );
+
+            if( r == VK_SUCCESS )
+            {
+                auto waitInfo = VkSemaphoreWaitInfo{
+                    .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                    .semaphoreCount = 1,
+                    .pSemaphores    = &sleepSemaphore,
+                    .pValues        = &sleepValue,
+                };
+                r = vkWaitSemaphores( device, &waitInfo, UINT64_MAX );
+                VK_CHECKERROR( r );
+            }
+            else
+            {
+                debug::Warning( "vkLatencySleepNV failed: {}", int( r ) );
+            }
+            break;
+        }
+        case Backend::AmdAntiLag: {
+#ifdef VK_AMD_anti_lag
+            // the driver delays this call, if the CPU is ahead of the GPU
+            auto presentation = VkAntiLagPresentationInfoAMD{
+                .sType      = VK_STRUCTURE_TYPE_ANTI_LAG_PRESENTATION_INFO_AMD,
+                .stage      = VK_ANTI_LAG_STAGE_INPUT_AMD,
+                .frameIndex = presentId,
+            };
+            auto data = VkAntiLagDataAMD{
+                .sType             = VK_STRUCTURE_TYPE_ANTI_LAG_DATA_AMD,
+                .mode              = VK_ANTI_LAG_MODE_ON_AMD,
+                .maxFPS            = 0,
+                .pPresentationInfo = &presentation,
+            };
+            svkAntiLagUpdateAMD( device, &data );
+#endif
+            break;
+        }
+        default: break;
+    }
+
+    Marker( swapchain, VK_LATENCY_MARKER_SIMULATION_START_NV );
+    Marker( swapchain, VK_LATENCY_MARKER_INPUT_SAMPLE_NV );
+}
+
+void RTGL1::LowLatency::Marker( VkSwapchainKHR swapchain, VkLatencyMarkerNV marker )
+{
+    if( !active || swapchain == VK_NULL_HANDLE )
+    {
+        return;
+    }
+
+    switch( backend )
+    {
+        case Backend::NvLowLatency2: {
+            // swapchain could have been recreated after the sleep
+            SetMode( swapchain, true );
+
+            auto info = VkSetLatencyMarkerInfoNV{
+                .sType     = VK_STRUCTURE_TYPE_SET_LATENCY_MARKER_INFO_NV,
+                .presentID = presentId,
+                .marker    = marker,
+            };
+            svkSetLatencyMarkerNV( device, swapchain, &info );
+            break;
+        }
+        case Backend::AmdAntiLag: {
+#ifdef VK_AMD_anti_lag
+            // anti-lag has only two points: input (in Sleep) and present
+            if( marker == VK_LATENCY_MARKER_PRESENT_START_NV )
+            {
+                auto presentation = VkAntiLagPresentationInfoAMD{
+                    .sType      = VK_STRUCTURE_TYPE_ANTI_LAG_PRESENTATION_INFO_AMD,
+                    .stage      = VK_ANTI_LAG_STAGE_PRESENT_AMD,
+                    .frameIndex = presentId,
+                };
+                auto data = VkAntiLagDataAMD{
+                    .sType             = VK_STRUCTURE_TYPE_ANTI_LAG_DATA_AMD,
+                    .mode              = VK_ANTI_LAG_MODE_ON_AMD,
+                    .maxFPS            = 0,
+                    .pPresentationInfo = &presentation,
+                };
+                svkAntiLagUpdateAMD( device, &data );
+            }
+#endif
+            break;
+        }
+        default: break;
+    }
+}
+
+auto RTGL1::LowLatency::GetPresentId() const -> std::optional< uint64_t >
+{
+    if( active && withPresentId )
+    {
+        return presentId;
+    }
+    return std::nullopt;
+}
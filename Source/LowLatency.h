@@ -0,0 +1,79 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Common.h"
+
+namespace RTGL1
+{
+
+// Native low-latency mode for the Vulkan swapchain, with VK_NV_low_latency2 or VK_AMD_anti_lag.
+// DXGI swapchains are handled by Reflex in DLSS3_DX12 instead.
+class LowLatency
+{
+public:
+    enum class Backend
+    {
+        None,
+        NvLowLatency2,
+        AmdAntiLag,
+    };
+
+    LowLatency( VkDevice device, bool withLowLatency2, bool withAntiLag, bool withPresentId );
+    ~LowLatency();
+
+    LowLatency( const LowLatency& other )                = delete;
+    LowLatency( LowLatency&& other ) noexcept            = delete;
+    LowLatency& operator=( const LowLatency& other )     = delete;
+    LowLatency& operator=( LowLatency&& other ) noexcept = delete;
+
+    // Call before waiting for the frame fence: blocks the CPU,
+    // so the input is sampled as late as possible
+    void Sleep( VkSwapchainKHR swapchain, bool enable, uint64_t frameId );
+    void Marker( VkSwapchainKHR swapchain, VkLatencyMarkerNV marker );
+
+    // Value for VkPresentIdKHR, to match the markers with a present.
+    // Null if low latency is not active in the current frame, or if present id is not supported
+    auto GetPresentId() const -> std::optional< uint64_t >;
+
+    bool    IsAvailable() const { return backend != Backend::None; }
+    bool    IsActive() const { return active; }
+    Backend GetBackend() const { return backend; }
+
+private:
+    void SetMode( VkSwapchainKHR swapchain, bool enable );
+
+private:
+    VkDevice device;
+    Backend  backend;
+    bool     withPresentId;
+
+    VkSemaphore sleepSemaphore{ VK_NULL_HANDLE };
+    uint64_t    sleepValue{ 0 };
+
+    VkSwapchainKHR modeSwapchain{ VK_NULL_HANDLE };
+    bool           modeEnabled{ false };
+
+    bool     active{ false };
+    uint64_t presentId{ 0 };
+};
+
+}
@@ -38,6 +38,11 @@ struct Texture
     SamplerManager::Handle              samplerHandle = SamplerManager::Handle();
     std::optional< RgTextureSwizzling > swizzling     = std::nullopt;
     std::filesystem::path               filepath      = {};
+    bool                                isNormalMap   = false;
+    // if not 0, image and view are shared with other textures of the same contents
+    uint64_t                            contentHash   = 0;
+    // if true, the slot is waiting for an asynchronously loaded image
+    bool                                reserved      = false;
 };
 
 
@@ -24,20 +24,108 @@
 #include "RgException.h"
 #include "Utils.h"
 
+#include <algorithm>
+#include <mutex>
+
+namespace
+{
+
+thread_local RgUtilMemoryCategory g_currentCategory = RG_UTIL_MEMORY_CATEGORY_OTHER;
+
+// Global, as FreeDedicated doesn't have an instance
+struct MemoryAccounting
+{
+    struct Entry
+    {
+        RgUtilMemoryCategory category;
+        VkDeviceSize         size;
+    };
+
+    void Add( uint64_t handle, RgUtilMemoryCategory category, VkDeviceSize size )
+    {
+        auto l = std::lock_guard{ mutex };
+
+        entries[ handle ] = Entry{ category, size };
+
+        auto& u   = usage[ category ];
+        u.current = u.current + size;
+        u.peak    = std::max( u.peak, u.current );
+    }
+
+    void Remove( uint64_t handle )
+    {
+        auto l = std::lock_guard{ mutex };
+
+        auto found = entries.find( handle );
+        if( found == entries.end() )
+        {
+            return;
+        }
+
+        auto& u = usage[ found->second.category ];
+        assert( u.current >= found->second.size );
+        u.current -= found->second.size;
+
+        entries.erase( found );
+    }
+
+    void ResetPeaks()
+    {
+        auto l = std::lock_guard{ mutex };
+
+        for( auto& u : usage )
+        {
+            u.peak = u.current;
+        }
+    }
+
+    std::mutex mutex;
+    // key: VkDeviceMemory of dedicated allocations, or VmaAllocation
+    rgl::unordered_map< uint64_t, Entry > entries;
+    RgUtilMemoryCategoryUsage             usage[ RG_UTIL_MEMORY_CATEGORY_COUNT ]{};
+};
+
+MemoryAccounting g_accounting;
+
+template< typename T >
+uint64_t ToKey( T handle )
+{
+    return reinterpret_cast< uint64_t >( handle );
+}
+
+}
+
+RTGL1::MemoryCategoryScope::MemoryCategoryScope( RgUtilMemoryCategory category )
+    : prev( g_currentCategory )
+{
+    g_currentCategory = category;
+}
+
+RTGL1::MemoryCategoryScope::~MemoryCategoryScope()
+{
+    g_currentCategory = prev;
+}
+
 RTGL1::MemoryAllocator::MemoryAllocator( VkInstance                        _instance,
                                          VkDevice                          _device,
                                          std::shared_ptr< PhysicalDevice > _physDevice )
     : device( _device )
     , physDevice( std::move( _physDevice ) )
     , allocator( VK_NULL_HANDLE )
+    , resizableBar( false )
     , texturesStagingPool( VK_NULL_HANDLE )
     , texturesFinalPool( VK_NULL_HANDLE )
+    , texturesDefrag( VK_NULL_HANDLE )
+    , texturesDefragPass{}
+    , texturesDefragPassActive( false )
 {
     VmaAllocatorCreateInfo allocatorInfo = {
         .flags = VMA_ALLOCATOR_CREATE_EXTERNALLY_SYNCHRONIZED_BIT | // currently, the library uses
                                                                     // only one thread,
-                 VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT, // if buffer/image requires a
-                                                                    // dedicated allocation
+                 VMA_ALLOCATOR_CREATE_KHR_DEDICATED_ALLOCATION_BIT | // if buffer/image requires a
+                                                                     // dedicated allocation
+                 VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT |
+                 VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT,
         .physicalDevice   = physDevice->Get(),
         .device           = device,
         .instance         = _instance,
@@ -47,13 +135,38 @@ RTGL1::MemoryAllocator::MemoryAllocator( VkInstance                        _inst
     VkResult r = vmaCreateAllocator( &allocatorInfo, &allocator );
     VK_CHECKERROR( r );
 
+    g_accounting.ResetPeaks();
+
     CreateTexturesStagingPool();
     CreateTexturesFinalPool();
+
+    // without Resizable BAR, host-visible device-local heap is at most 256 MB
+    constexpr VkDeviceSize          SmallBarSize = 256 * 1024 * 1024;
+    constexpr VkMemoryPropertyFlags Required     = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    const VkPhysicalDeviceMemoryProperties& props = physDevice->GetMemoryProperties();
+    for( uint32_t i = 0; i < props.memoryTypeCount; i++ )
+    {
+        const VkMemoryType& t = props.memoryTypes[ i ];
+
+        if( ( t.propertyFlags & Required ) == Required &&
+            props.memoryHeaps[ t.heapIndex ].size > SmallBarSize )
+        {
+            resizableBar = true;
+            break;
+        }
+    }
+    debug::Verbose( "Resizable BAR: {}", resizableBar ? "yes" : "no" );
 }
 
 RTGL1::MemoryAllocator::~MemoryAllocator()
 {
     assert( bufAllocs.empty() );
+    assert( !texturesDefragPassActive );
+
+    EndTexturesDefragmentation();
 
     vmaDestroyPool( allocator, texturesStagingPool );
     vmaDestroyPool( allocator, texturesFinalPool );
@@ -92,6 +205,8 @@ VkBuffer RTGL1::MemoryAllocator::CreateStagingSrcTextureBuffer( const VkBufferCr
     auto [ iter, isNew ] = bufAllocs.emplace( buffer, resultAlloc );
     assert( isNew );
 
+    g_accounting.Add( ToKey( resultAlloc ), RG_UTIL_MEMORY_CATEGORY_STAGING, resultAllocInfo.size );
+
     if( outMemory != nullptr )
     {
         *outMemory = resultAllocInfo.deviceMemory;
@@ -130,9 +245,21 @@ VkImage RTGL1::MemoryAllocator::CreateDstTextureImage( const VkImageCreateInfo*
         return VK_NULL_HANDLE;
     }
     
-    auto [ iter, isNew ] = imgAllocs.emplace( image, resultAlloc );
+    auto imageInfo                  = *info;
+    imageInfo.pNext                 = nullptr;
+    imageInfo.queueFamilyIndexCount = 0;
+    imageInfo.pQueueFamilyIndices   = nullptr;
+    assert( imageInfo.sharingMode == VK_SHARING_MODE_EXCLUSIVE );
+
+    auto [ iter, isNew ] = imgAllocs.emplace( image, ImageAlloc{ resultAlloc, imageInfo } );
     assert( isNew );
 
+    g_accounting.Add( ToKey( resultAlloc ),
+                      g_currentCategory != RG_UTIL_MEMORY_CATEGORY_OTHER
+                          ? g_currentCategory
+                          : RG_UTIL_MEMORY_CATEGORY_TEXTURES,
+                      resultAllocInfo.size );
+
     if( outMemory != nullptr )
     {
         *outMemory = resultAllocInfo.deviceMemory;
@@ -150,6 +277,7 @@ void RTGL1::MemoryAllocator::DestroyStagingSrcTextureBuffer( VkBuffer buffer )
         return;
     }
 
+    g_accounting.Remove( ToKey( vmaAllocation->second ) );
     vmaDestroyBuffer( allocator, buffer, vmaAllocation->second );
     bufAllocs.erase( buffer );
 }
@@ -163,10 +291,169 @@ void RTGL1::MemoryAllocator::DestroyTextureImage( VkImage image )
         return;
     }
 
-    vmaDestroyImage( allocator, image, vmaAllocation->second );
+    g_accounting.Remove( ToKey( vmaAllocation->second.allocation ) );
+    vmaDestroyImage( allocator, image, vmaAllocation->second.allocation );
     imgAllocs.erase( image );
 }
 
+void RTGL1::MemoryAllocator::BeginTexturesDefragmentation( VkDeviceSize maxBytesPerPass )
+{
+    if( texturesDefrag != VK_NULL_HANDLE )
+    {
+        return;
+    }
+
+    VmaDefragmentationInfo info = {
+        .flags           = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT,
+        .pool            = texturesFinalPool,
+        .maxBytesPerPass = maxBytesPerPass,
+    };
+
+    VkResult r = vmaBeginDefragmentation( allocator, &info, &texturesDefrag );
+    VK_CHECKERROR( r );
+
+    if( r != VK_SUCCESS )
+    {
+        texturesDefrag = VK_NULL_HANDLE;
+    }
+}
+
+void RTGL1::MemoryAllocator::EndTexturesDefragmentation()
+{
+    if( texturesDefrag == VK_NULL_HANDLE )
+    {
+        return;
+    }
+    assert( !texturesDefragPassActive );
+
+    VmaDefragmentationStats stats = {};
+    vmaEndDefragmentation( allocator, texturesDefrag, &stats );
+    texturesDefrag = VK_NULL_HANDLE;
+
+    if( stats.allocationsMoved > 0 || stats.bytesFreed > 0 )
+    {
+        debug::Info( "Texture memory defragmentation: moved {} images ({:.2f} MB), "
+                     "released {} blocks ({:.2f} MB)",
+                     stats.allocationsMoved,
+                     double( stats.bytesMoved ) / 1024.0 / 1024.0,
+                     stats.deviceMemoryBlocksFreed,
+                     double( stats.bytesFreed ) / 1024.0 / 1024.0 );
+    }
+}
+
+bool RTGL1::MemoryAllocator::IsTexturesDefragmentationActive() const
+{
+    return texturesDefrag != VK_NULL_HANDLE;
+}
+
+auto RTGL1::MemoryAllocator::BeginTexturesDefragmentationPass(
+    const std::function< bool( VkImage ) >& canMove ) -> std::span< const TextureImageMove >
+{
+    assert( texturesDefrag != VK_NULL_HANDLE && !texturesDefragPassActive );
+    assert( texturesDefragMoves.empty() );
+
+    texturesDefragPass = {};
+
+    VkResult r = vmaBeginDefragmentationPass( allocator, texturesDefrag, &texturesDefragPass );
+
+    // nothing to move anymore
+    if( r != VK_INCOMPLETE )
+    {
+        VK_CHECKERROR( r );
+        EndTexturesDefragmentation();
+        return {};
+    }
+    texturesDefragPassActive = true;
+
+    auto allocToImage = rgl::unordered_map< VmaAllocation, VkImage >{};
+    for( const auto& [ image, a ] : imgAllocs )
+    {
+        allocToImage.emplace( a.allocation, image );
+    }
+
+    for( uint32_t i = 0; i < texturesDefragPass.moveCount; i++ )
+    {
+        VmaDefragmentationMove& move = texturesDefragPass.pMoves[ i ];
+        move.operation               = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+
+        auto found = allocToImage.find( move.srcAllocation );
+        if( found == allocToImage.end() || !canMove( found->second ) )
+        {
+            continue;
+        }
+
+        const VkImageCreateInfo& imageInfo = imgAllocs[ found->second ].info;
+
+        VkImage newImage = VK_NULL_HANDLE;
+        if( vkCreateImage( device, &imageInfo, nullptr, &newImage ) != VK_SUCCESS )
+        {
+            continue;
+        }
+
+        if( vmaBindImageMemory( allocator, move.dstTmpAllocation, newImage ) != VK_SUCCESS )
+        {
+            vkDestroyImage( device, newImage, nullptr );
+            continue;
+        }
+
+        VmaAllocationInfo srcInfo = {};
+        vmaGetAllocationInfo( allocator, move.srcAllocation, &srcInfo );
+        SET_DEBUG_NAME( device, newImage, VK_OBJECT_TYPE_IMAGE, srcInfo.pName );
+
+        move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_COPY;
+        texturesDefragMoves.push_back( TextureImageMove{
+            .oldImage = found->second,
+            .newImage = newImage,
+            .info     = imageInfo,
+        } );
+    }
+
+    return texturesDefragMoves;
+}
+
+void RTGL1::MemoryAllocator::EndTexturesDefragmentationPass()
+{
+    if( !texturesDefragPassActive )
+    {
+        return;
+    }
+
+    for( const TextureImageMove& m : texturesDefragMoves )
+    {
+        auto found = imgAllocs.find( m.oldImage );
+        assert( found != imgAllocs.end() );
+
+        // the allocation will point to the new place after vmaEndDefragmentationPass
+        ImageAlloc a = found->second;
+        imgAllocs.erase( found );
+        imgAllocs.emplace( m.newImage, a );
+
+        vkDestroyImage( device, m.oldImage, nullptr );
+    }
+    texturesDefragMoves.clear();
+    texturesDefragPassActive = false;
+
+    VkResult r = vmaEndDefragmentationPass( allocator, texturesDefrag, &texturesDefragPass );
+
+    // no more passes are required
+    if( r == VK_SUCCESS )
+    {
+        EndTexturesDefragmentation();
+    }
+}
+
+bool RTGL1::MemoryAllocator::IsTexturesDefragmentationPassActive() const
+{
+    return texturesDefragPassActive;
+}
+
+void RTGL1::MemoryAllocator::GetCategoryUsage(
+    RgUtilMemoryCategoryUsage ( &out )[ RG_UTIL_MEMORY_CATEGORY_COUNT ] )
+{
+    auto l = std::lock_guard{ g_accounting.mutex };
+    std::ranges::copy( g_accounting.usage, out );
+}
+
 auto RTGL1::MemoryAllocator::GetMemoryTypeIndex( uint32_t              memoryTypeBits,
                                                  VkMemoryPropertyFlags requirementsMask ) const
     -> std::optional< uint32_t >
@@ -174,6 +461,32 @@ auto RTGL1::MemoryAllocator::GetMemoryTypeIndex( uint32_t              memoryTyp
     return physDevice->GetMemoryTypeIndex( memoryTypeBits, requirementsMask );
 }
 
+void RTGL1::MemoryAllocator::SetCurrentFrameIndex( uint32_t frameId )
+{
+    // budget is fetched from the driver, when frame index changes
+    vmaSetCurrentFrameIndex( allocator, frameId );
+}
+
+auto RTGL1::MemoryAllocator::GetDeviceLocalBudget() const -> Budget
+{
+    const VkPhysicalDeviceMemoryProperties* props = nullptr;
+    vmaGetMemoryProperties( allocator, &props );
+
+    VmaBudget budgets[ VK_MAX_MEMORY_HEAPS ] = {};
+    vmaGetHeapBudgets( allocator, budgets );
+
+    auto result = Budget{};
+    for( uint32_t i = 0; i < props->memoryHeapCount; i++ )
+    {
+        if( props->memoryHeaps[ i ].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT )
+        {
+            result.usage += budgets[ i ].usage;
+            result.budget += budgets[ i ].budget;
+        }
+    }
+    return result;
+}
+
 void RTGL1::MemoryAllocator::CreateTexturesStagingPool()
 {
     VkResult           r;
@@ -299,6 +612,15 @@ VkDeviceMemory RTGL1::MemoryAllocator::AllocDedicated( const VkMemoryRequirement
 
     VK_CHECKERROR( r );
     SET_DEBUG_NAME( device, memory, VK_OBJECT_TYPE_DEVICE_MEMORY, pDebugName );
+
+    if( r == VK_SUCCESS )
+    {
+        g_accounting.Add( ToKey( memory ),
+                          properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                              ? g_currentCategory
+                              : RG_UTIL_MEMORY_CATEGORY_STAGING,
+                          memAllocInfo.allocationSize );
+    }
     return memory;
 }
 
@@ -312,5 +634,77 @@ VkDeviceMemory RTGL1::MemoryAllocator::AllocDedicated( const VkMemoryRequirement
 
 void RTGL1::MemoryAllocator::FreeDedicated( VkDevice device, VkDeviceMemory memory )
 {
+    g_accounting.Remove( ToKey( memory ) );
     vkFreeMemory( device, memory, nullptr );
 }
+
+VmaAllocation RTGL1::MemoryAllocator::AllocForBuffer( VkBuffer              buffer,
+                                                      VkMemoryPropertyFlags properties,
+                                                      const char*           pDebugName )
+{
+    VkMemoryRequirements memReqs = {};
+    vkGetBufferMemoryRequirements( device, buffer, &memReqs );
+
+    // same memory type as for a dedicated allocation
+    auto memoryTypeIndex = GetMemoryTypeIndex( memReqs.memoryTypeBits, properties );
+    if( !memoryTypeIndex )
+    {
+        throw RgException{ RG_RESULT_GRAPHICS_API_ERROR, "GetMemoryTypeIndex failure" };
+    }
+
+    VmaAllocationCreateFlags flags = VMA_ALLOCATION_CREATE_USER_DATA_COPY_STRING_BIT;
+    if( memReqs.size >= BufferDedicatedMinSize )
+    {
+        flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+    }
+
+    VmaAllocationCreateInfo allocInfo = {
+        .flags          = flags,
+        .requiredFlags  = properties,
+        .memoryTypeBits = 1u << *memoryTypeIndex,
+        .pUserData      = const_cast< char* >( pDebugName ),
+    };
+
+    VmaAllocation     resultAlloc     = VK_NULL_HANDLE;
+    VmaAllocationInfo resultAllocInfo = {};
+
+    VkResult r =
+        vmaAllocateMemoryForBuffer( allocator, buffer, &allocInfo, &resultAlloc, &resultAllocInfo );
+    if( r != VK_SUCCESS )
+    {
+        throw RgException{ RG_RESULT_GRAPHICS_API_ERROR,
+                           std::string( "Buffer memory allocation failure: " ) +
+                               ( pDebugName ? pDebugName : "" ) };
+    }
+
+    r = vmaBindBufferMemory( allocator, resultAlloc, buffer );
+    VK_CHECKERROR( r );
+
+    g_accounting.Add( ToKey( resultAlloc ),
+                      properties & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+                          ? g_currentCategory
+                          : RG_UTIL_MEMORY_CATEGORY_STAGING,
+                      resultAllocInfo.size );
+
+    return resultAlloc;
+}
+
+void RTGL1::MemoryAllocator::FreeForBuffer( VmaAllocation allocation )
+{
+    g_accounting.Remove( ToKey( allocation ) );
+    vmaFreeMemory( allocator, allocation );
+}
+
+void* RTGL1::MemoryAllocator::MapBufferMemory( VmaAllocation allocation )
+{
+    void*    mapped = nullptr;
+    VkResult r      = vmaMapMemory( allocator, allocation, &mapped );
+    VK_CHECKERROR( r );
+
+    return mapped;
+}
+
+void RTGL1::MemoryAllocator::UnmapBufferMemory( VmaAllocation allocation )
+{
+    vmaUnmapMemory( allocator, allocation );
+}
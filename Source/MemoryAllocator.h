@@ -25,9 +25,28 @@
 #include "PhysicalDevice.h"
 #include "Vma/vk_mem_alloc.h"
 
+#include <span>
+
 namespace RTGL1
 {
 
+// Device memory allocated on this thread while the scope is alive
+// is accounted in the category. Nested scopes override the outer ones
+class MemoryCategoryScope
+{
+public:
+    explicit MemoryCategoryScope( RgUtilMemoryCategory category );
+    ~MemoryCategoryScope();
+
+    MemoryCategoryScope( const MemoryCategoryScope& other )                = delete;
+    MemoryCategoryScope( MemoryCategoryScope&& other ) noexcept            = delete;
+    MemoryCategoryScope& operator=( const MemoryCategoryScope& other )     = delete;
+    MemoryCategoryScope& operator=( MemoryCategoryScope&& other ) noexcept = delete;
+
+private:
+    RgUtilMemoryCategory prev;
+};
+
 // Device memory allocator.
 class MemoryAllocator
 {
@@ -65,6 +84,17 @@ public:
     static void      FreeDedicated( VkDevice device, VkDeviceMemory memory );
 
 
+    // Suballocate memory for the buffer from the shared blocks, and bind it.
+    // Only the largest buffers get their own VkDeviceMemory.
+    // Blocks are allocated with VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
+    VmaAllocation    AllocForBuffer( VkBuffer              buffer,
+                                     VkMemoryPropertyFlags properties,
+                                     const char*           pDebugName = nullptr );
+    void             FreeForBuffer( VmaAllocation allocation );
+    void*            MapBufferMemory( VmaAllocation allocation );
+    void             UnmapBufferMemory( VmaAllocation allocation );
+
+
     VkBuffer         CreateStagingSrcTextureBuffer( const VkBufferCreateInfo* info,
                                                     const char*               pDebugName,
                                                     void**                    pOutMappedData,
@@ -80,7 +110,53 @@ public:
     auto GetMemoryTypeIndex( uint32_t memoryTypeBits, VkMemoryPropertyFlags requirementsMask ) const
         -> std::optional< uint32_t >;
 
+    // Must be called once per frame to refresh the values of GetDeviceLocalBudget
+    void SetCurrentFrameIndex( uint32_t frameId );
+
+    struct Budget
+    {
+        VkDeviceSize usage{ 0 };
+        VkDeviceSize budget{ 0 };
+    };
+    // Sum over DEVICE_LOCAL heaps, reported by VK_EXT_memory_budget
+    auto GetDeviceLocalBudget() const -> Budget;
+
+    // If CPU can map most of the VRAM (Resizable BAR), not just a 256 MB window.
+    // Then DEVICE_LOCAL | HOST_VISIBLE | HOST_COHERENT can be used for big buffers
+    bool HasResizableBar() const { return resizableBar; }
+
+    // Memory that was allocated through this class, per category
+    static void GetCategoryUsage(
+        RgUtilMemoryCategoryUsage ( &out )[ RG_UTIL_MEMORY_CATEGORY_COUNT ] );
+
+
+    // Incremental defragmentation of the texture images pool
+    struct TextureImageMove
+    {
+        VkImage           oldImage;
+        // bound to the new place in memory, contents are undefined
+        VkImage           newImage;
+        // same for both images
+        VkImageCreateInfo info;
+    };
+
+    void BeginTexturesDefragmentation( VkDeviceSize maxBytesPerPass );
+    void EndTexturesDefragmentation();
+    bool IsTexturesDefragmentationActive() const;
+
+    // Images for which 'canMove' returns false are left in place.
+    // The caller must copy the contents of each old image into the new one
+    auto BeginTexturesDefragmentationPass( const std::function< bool( VkImage ) >& canMove )
+        -> std::span< const TextureImageMove >;
+    // Must be called when the GPU has finished the copies, and the old images are not in use
+    // anymore: they are destroyed, and the new ones take their allocations
+    void EndTexturesDefragmentationPass();
+    bool IsTexturesDefragmentationPassActive() const;
+
 private:
+    // Buffers that are larger than this, are not suballocated
+    static constexpr VkDeviceSize BufferDedicatedMinSize = 64 * 1024 * 1024;
+
     void CreateTexturesStagingPool();
     void CreateTexturesFinalPool();
 
@@ -89,6 +165,7 @@ private:
     std::shared_ptr< PhysicalDevice >             physDevice;
 
     VmaAllocator                                  allocator;
+    bool                                          resizableBar;
 
     // pool for staging buffers for texture data, CPU_ONLY
     VmaPool                                       texturesStagingPool;
@@ -96,9 +173,21 @@ private:
     // texture data will be copied from staging to this memory
     VmaPool                                       texturesFinalPool;
 
+    struct ImageAlloc
+    {
+        VmaAllocation     allocation;
+        // to recreate the image, if it's moved by the defragmentation
+        VkImageCreateInfo info;
+    };
+
     // maps for freeing corresponding allocations
     rgl::unordered_map< VkBuffer, VmaAllocation > bufAllocs;
-    rgl::unordered_map< VkImage, VmaAllocation >  imgAllocs;
+    rgl::unordered_map< VkImage, ImageAlloc >     imgAllocs;
+
+    VmaDefragmentationContext                     texturesDefrag;
+    VmaDefragmentationPassMoveInfo                texturesDefragPass;
+    bool                                          texturesDefragPassActive;
+    std::vector< TextureImageMove >               texturesDefragMoves;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,558 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MipmapGenerator.h"
+
+#include "CmdLabel.h"
+#include "Generated/ShaderCommonC.h"
+#include "Utils.h"
+
+namespace
+{
+
+// levels of a tile are made by its workgroup, and the rest by the last workgroup
+// from a single tile, so the base level can be at most 64*64
+constexpr uint32_t MIPMAP_MAX_SIZE = COMPUTE_MIPMAP_TILE_SIZE * COMPUTE_MIPMAP_TILE_SIZE;
+
+constexpr uint32_t MIPMAP_SETS_PER_POOL = 64;
+
+struct MipmapsPush
+{
+    uint32_t baseWidth;
+    uint32_t baseHeight;
+    uint32_t dstLevelCount;
+    uint32_t flags;
+    uint32_t groupCount;
+};
+
+}
+
+RTGL1::MipmapGenerator::MipmapGenerator( VkDevice                           _device,
+                                         VkPhysicalDevice                   _physDevice,
+                                         std::shared_ptr< MemoryAllocator > _allocator,
+                                         const ShaderManager&               _shaderManager )
+    : device( _device )
+    , physDevice( _physDevice )
+    , sampler( VK_NULL_HANDLE )
+    , descSetLayout( VK_NULL_HANDLE )
+    , pipelineLayout( VK_NULL_HANDLE )
+    , pipeline( VK_NULL_HANDLE )
+{
+    counter.Init( *_allocator,
+                  sizeof( uint32_t ),
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  "Mipmap generation counter" );
+    {
+        auto* mapped = static_cast< uint32_t* >( counter.Map() );
+        *mapped      = 0;
+        counter.Unmap();
+    }
+
+    // only texelFetch is used
+    VkSamplerCreateInfo samplerInfo = {
+        .sType                   = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter               = VK_FILTER_NEAREST,
+        .minFilter               = VK_FILTER_NEAREST,
+        .mipmapMode              = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW            = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .minLod                  = 0.0f,
+        .maxLod                  = 0.0f,
+        .unnormalizedCoordinates = VK_FALSE,
+    };
+    VkResult r = vkCreateSampler( device, &samplerInfo, nullptr, &sampler );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, sampler, VK_OBJECT_TYPE_SAMPLER, "Mipmap generation sampler" );
+
+    CreateDescriptorSetLayout();
+    CreatePipelineLayout();
+    CreatePipeline( &_shaderManager );
+}
+
+RTGL1::MipmapGenerator::~MipmapGenerator()
+{
+    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        PrepareForFrame( i );
+
+        for( VkDescriptorPool p : perFrame[ i ].pools )
+        {
+            vkDestroyDescriptorPool( device, p, nullptr );
+        }
+    }
+
+    vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
+    DestroyPipeline();
+    vkDestroyDescriptorSetLayout( device, descSetLayout, nullptr );
+    vkDestroySampler( device, sampler, nullptr );
+}
+
+void RTGL1::MipmapGenerator::PrepareForFrame( uint32_t frameIndex )
+{
+    PerFrame& f = perFrame[ frameIndex ];
+
+    for( VkImageView v : f.views )
+    {
+        vkDestroyImageView( device, v, nullptr );
+    }
+    f.views.clear();
+
+    for( VkDescriptorPool p : f.pools )
+    {
+        vkResetDescriptorPool( device, p, 0 );
+    }
+    f.currentPool       = 0;
+    f.setsInCurrentPool = 0;
+}
+
+VkFormat RTGL1::MipmapGenerator::GetStorageFormat( VkFormat format )
+{
+    switch( format )
+    {
+        // storage images can't be sRGB, so encoding is done in the shader
+        case VK_FORMAT_R8_SRGB: return VK_FORMAT_R8_UNORM;
+        case VK_FORMAT_R8G8_SRGB: return VK_FORMAT_R8G8_UNORM;
+        case VK_FORMAT_R8G8B8A8_SRGB: return VK_FORMAT_R8G8B8A8_UNORM;
+        case VK_FORMAT_B8G8R8A8_SRGB: return VK_FORMAT_B8G8R8A8_UNORM;
+        case VK_FORMAT_A8B8G8R8_SRGB_PACK32: return VK_FORMAT_A8B8G8R8_UNORM_PACK32;
+
+        // must be a float image2D in shader
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SNORM:
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SNORM:
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SNORM:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+        case VK_FORMAT_A8B8G8R8_SNORM_PACK32:
+        case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+        case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+        case VK_FORMAT_R16_UNORM:
+        case VK_FORMAT_R16_SNORM:
+        case VK_FORMAT_R16_SFLOAT:
+        case VK_FORMAT_R16G16_UNORM:
+        case VK_FORMAT_R16G16_SNORM:
+        case VK_FORMAT_R16G16_SFLOAT:
+        case VK_FORMAT_R16G16B16A16_UNORM:
+        case VK_FORMAT_R16G16B16A16_SNORM:
+        case VK_FORMAT_R16G16B16A16_SFLOAT:
+        case VK_FORMAT_R32_SFLOAT:
+        case VK_FORMAT_R32G32_SFLOAT:
+        case VK_FORMAT_R32G32B32A32_SFLOAT:
+        case VK_FORMAT_B10G11R11_UFLOAT_PACK32: return format;
+
+        default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+bool RTGL1::MipmapGenerator::IsSupported( VkFormat format, const RgExtent2D& size ) const
+{
+    if( size.width > MIPMAP_MAX_SIZE || size.height > MIPMAP_MAX_SIZE )
+    {
+        return false;
+    }
+
+    VkFormat storageFormat = GetStorageFormat( format );
+    if( storageFormat == VK_FORMAT_UNDEFINED )
+    {
+        return false;
+    }
+
+    auto found = storageSupport.find( storageFormat );
+    if( found == storageSupport.end() )
+    {
+        VkFormatProperties props = {};
+        vkGetPhysicalDeviceFormatProperties( physDevice, storageFormat, &props );
+
+        bool supported =
+            ( props.optimalTilingFeatures & VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT ) != 0;
+
+        found = storageSupport.emplace( storageFormat, supported ).first;
+    }
+    return found->second;
+}
+
+void RTGL1::MipmapGenerator::Generate( VkCommandBuffer   cmd,
+                                       uint32_t          frameIndex,
+                                       VkImage           image,
+                                       VkFormat          format,
+                                       const RgExtent2D& size,
+                                       uint32_t          mipmapCount,
+                                       bool              isNormalMap )
+{
+    assert( IsSupported( format, size ) );
+    assert( mipmapCount > 1 && mipmapCount <= COMPUTE_MIPMAP_MAX_DST_LEVELS + 1 );
+
+    CmdLabel label( cmd, "Mipmap generation" );
+
+    const VkFormat storageFormat = GetStorageFormat( format );
+    static_assert( sizeof( MipmapsPush ) == 5 * sizeof( uint32_t ), "Must match CmMipmaps.comp" );
+
+    {
+        VkImageMemoryBarrier2 bs[] = {
+            {
+                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask        = VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                .dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT,
+                .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image               = image,
+                .subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
+            },
+            {
+                .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask        = VK_PIPELINE_STAGE_2_NONE,
+                .srcAccessMask       = VK_ACCESS_2_NONE,
+                .dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+                .oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout           = VK_IMAGE_LAYOUT_GENERAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image               = image,
+                .subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 1, mipmapCount - 1, 0, 1 },
+            },
+        };
+
+        VkDependencyInfo dep = {
+            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = std::size( bs ),
+            .pImageMemoryBarriers    = bs,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    VkDescriptorSet descSet = AllocateDescriptorSet( frameIndex );
+    {
+        VkDescriptorImageInfo src = {
+            .sampler     = sampler,
+            .imageView   = CreateView( frameIndex, image, format, 0, VK_IMAGE_USAGE_SAMPLED_BIT ),
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+
+        VkDescriptorImageInfo dst[ COMPUTE_MIPMAP_MAX_DST_LEVELS ] = {};
+        for( uint32_t i = 0; i < COMPUTE_MIPMAP_MAX_DST_LEVELS; i++ )
+        {
+            if( i + 1 < mipmapCount )
+            {
+                dst[ i ] = {
+                    .sampler     = VK_NULL_HANDLE,
+                    .imageView   = CreateView( frameIndex,
+                                               image,
+                                               storageFormat,
+                                               i + 1,
+                                               VK_IMAGE_USAGE_STORAGE_BIT ),
+                    .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+                };
+            }
+            else
+            {
+                // all must be valid, but the ones after the last level are not accessed
+                dst[ i ] = dst[ mipmapCount - 2 ];
+            }
+        }
+
+        VkDescriptorBufferInfo cnt = {
+            .buffer = counter.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        };
+
+        VkWriteDescriptorSet wrts[] = {
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = descSet,
+                .dstBinding      = BINDING_MIPMAP_SRC,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo      = &src,
+            },
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = descSet,
+                .dstBinding      = BINDING_MIPMAP_DST,
+                .dstArrayElement = 0,
+                .descriptorCount = std::size( dst ),
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo      = dst,
+            },
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = descSet,
+                .dstBinding      = BINDING_MIPMAP_COUNTER,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .pBufferInfo     = &cnt,
+            },
+        };
+
+        vkUpdateDescriptorSets( device, std::size( wrts ), wrts, 0, nullptr );
+    }
+
+    const uint32_t groupsX = Utils::GetWorkGroupCount( size.width, COMPUTE_MIPMAP_TILE_SIZE );
+    const uint32_t groupsY = Utils::GetWorkGroupCount( size.height, COMPUTE_MIPMAP_TILE_SIZE );
+
+    const auto push = MipmapsPush{
+        .baseWidth     = size.width,
+        .baseHeight    = size.height,
+        .dstLevelCount = mipmapCount - 1,
+        .flags         = ( Utils::IsSRGB( format ) ? MIPMAP_FLAG_SRGB : 0u ) |
+                 ( isNormalMap ? MIPMAP_FLAG_NORMAL_MAP : 0u ),
+        .groupCount = groupsX * groupsY,
+    };
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+    vkCmdBindDescriptorSets(
+        cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descSet, 0, nullptr );
+    vkCmdPushConstants(
+        cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( push ), &push );
+    vkCmdDispatch( cmd, groupsX, groupsY, 1 );
+
+    {
+        // the next dispatch reuses the counter
+        VkMemoryBarrier2 counterBarrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+        };
+
+        VkImageMemoryBarrier2 b = {
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+            .srcAccessMask       = VK_ACCESS_2_SHADER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR |
+                            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+            .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_GENERAL,
+            .newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = image,
+            .subresourceRange    = { VK_IMAGE_ASPECT_COLOR_BIT, 1, mipmapCount - 1, 0, 1 },
+        };
+
+        VkDependencyInfo dep = {
+            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .memoryBarrierCount      = 1,
+            .pMemoryBarriers         = &counterBarrier,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+}
+
+void RTGL1::MipmapGenerator::OnShaderReload( const ShaderManager* shaderManager )
+{
+    if( !shaderManager->AnyChanged( { "CMipmaps" } ) )
+    {
+        return;
+    }
+
+    DestroyPipeline();
+    CreatePipeline( shaderManager );
+}
+
+void RTGL1::MipmapGenerator::CreateDescriptorSetLayout()
+{
+    VkDescriptorSetLayoutBinding bindings[] = {
+        {
+            .binding         = BINDING_MIPMAP_SRC,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_MIPMAP_DST,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = COMPUTE_MIPMAP_MAX_DST_LEVELS,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_MIPMAP_COUNTER,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = std::size( bindings ),
+        .pBindings    = bindings,
+    };
+
+    VkResult r = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descSetLayout );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device,
+                    descSetLayout,
+                    VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+                    "Mipmap generation Desc set layout" );
+}
+
+auto RTGL1::MipmapGenerator::AllocateDescriptorSet( uint32_t frameIndex ) -> VkDescriptorSet
+{
+    PerFrame& f = perFrame[ frameIndex ];
+    VkResult  r;
+
+    if( f.setsInCurrentPool >= MIPMAP_SETS_PER_POOL )
+    {
+        f.currentPool++;
+        f.setsInCurrentPool = 0;
+    }
+
+    if( f.currentPool >= f.pools.size() )
+    {
+        VkDescriptorPoolSize poolSizes[] = {
+            {
+                .type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .descriptorCount = MIPMAP_SETS_PER_POOL,
+            },
+            {
+                .type            = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .descriptorCount = MIPMAP_SETS_PER_POOL * COMPUTE_MIPMAP_MAX_DST_LEVELS,
+            },
+            {
+                .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = MIPMAP_SETS_PER_POOL,
+            },
+        };
+
+        VkDescriptorPoolCreateInfo poolInfo = {
+            .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets       = MIPMAP_SETS_PER_POOL,
+            .poolSizeCount = std::size( poolSizes ),
+            .pPoolSizes    = poolSizes,
+        };
+
+        VkDescriptorPool pool;
+        r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &pool );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME(
+            device, pool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Mipmap generation Desc pool" );
+
+        f.pools.push_back( pool );
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool     = f.pools[ f.currentPool ],
+        .descriptorSetCount = 1,
+        .pSetLayouts        = &descSetLayout,
+    };
+
+    VkDescriptorSet descSet;
+    r = vkAllocateDescriptorSets( device, &allocInfo, &descSet );
+    VK_CHECKERROR( r );
+
+    f.setsInCurrentPool++;
+    return descSet;
+}
+
+auto RTGL1::MipmapGenerator::CreateView( uint32_t          frameIndex,
+                                         VkImage           image,
+                                         VkFormat          format,
+                                         uint32_t          mipLevel,
+                                         VkImageUsageFlags usage ) -> VkImageView
+{
+    // image has both sampled and storage usage, but a format may support only one of them
+    VkImageViewUsageCreateInfo usageInfo = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO,
+        .usage = usage,
+    };
+
+    VkImageViewCreateInfo viewInfo = {
+        .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .pNext            = &usageInfo,
+        .image            = image,
+        .viewType         = VK_IMAGE_VIEW_TYPE_2D,
+        .format           = format,
+        .components       = {},
+        .subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, mipLevel, 1, 0, 1 },
+    };
+
+    VkImageView view;
+    VkResult    r = vkCreateImageView( device, &viewInfo, nullptr, &view );
+    VK_CHECKERROR( r );
+
+    perFrame[ frameIndex ].views.push_back( view );
+    return view;
+}
+
+void RTGL1::MipmapGenerator::CreatePipelineLayout()
+{
+    VkPushConstantRange push = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset     = 0,
+        .size       = sizeof( MipmapsPush ),
+    };
+
+    VkPipelineLayoutCreateInfo plLayoutInfo = {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount         = 1,
+        .pSetLayouts            = &descSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &push,
+    };
+
+    VkResult r = vkCreatePipelineLayout( device, &plLayoutInfo, nullptr, &pipelineLayout );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device,
+                    pipelineLayout,
+                    VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+                    "Mipmap generation pipeline layout" );
+}
+
+void RTGL1::MipmapGenerator::CreatePipeline( const ShaderManager* shaderManager )
+{
+    VkComputePipelineCreateInfo plInfo = {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = shaderManager->GetStageInfo( "CMipmaps" ),
+        .layout = pipelineLayout,
+    };
+
+    VkResult r = vkCreateComputePipelines( device,
+                                           shaderManager->GetPipelineCache(),
+                                           1,
+                                           &plInfo,
+                                           nullptr,
+                                           &pipeline );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, pipeline, VK_OBJECT_TYPE_PIPELINE, "Mipmap generation pipeline" );
+}
+
+void RTGL1::MipmapGenerator::DestroyPipeline()
+{
+    vkDestroyPipeline( device, pipeline, nullptr );
+    pipeline = VK_NULL_HANDLE;
+}
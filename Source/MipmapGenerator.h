@@ -0,0 +1,107 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Buffer.h"
+#include "Common.h"
+#include "Containers.h"
+#include "ShaderManager.h"
+
+namespace RTGL1
+{
+
+// Generates all mip levels of a texture in a single compute dispatch.
+// Unlike blit, filters sRGB textures in linear space, renormalizes normal maps,
+// and works for formats that don't support blit.
+class MipmapGenerator : public IShaderDependency
+{
+public:
+    MipmapGenerator( VkDevice                           device,
+                     VkPhysicalDevice                   physDevice,
+                     std::shared_ptr< MemoryAllocator > allocator,
+                     const ShaderManager&               shaderManager );
+    ~MipmapGenerator() override;
+
+    MipmapGenerator( const MipmapGenerator& other )                = delete;
+    MipmapGenerator( MipmapGenerator&& other ) noexcept            = delete;
+    MipmapGenerator& operator=( const MipmapGenerator& other )     = delete;
+    MipmapGenerator& operator=( MipmapGenerator&& other ) noexcept = delete;
+
+    // Views and descriptor sets of the frame must not be in use
+    void PrepareForFrame( uint32_t frameIndex );
+
+    bool IsSupported( VkFormat format, const RgExtent2D& size ) const;
+    // If not the same as format, the image must be created
+    // with VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT and VK_IMAGE_CREATE_EXTENDED_USAGE_BIT
+    static VkFormat GetStorageFormat( VkFormat format );
+
+    // The first mip level must be in TRANSFER_DST_OPTIMAL after a transfer write,
+    // other levels are discarded. After the call, all levels are in SHADER_READ_ONLY_OPTIMAL
+    void Generate( VkCommandBuffer   cmd,
+                   uint32_t          frameIndex,
+                   VkImage           image,
+                   VkFormat          format,
+                   const RgExtent2D& size,
+                   uint32_t          mipmapCount,
+                   bool              isNormalMap );
+
+    void OnShaderReload( const ShaderManager* shaderManager ) override;
+
+private:
+    void CreateDescriptorSetLayout();
+    auto AllocateDescriptorSet( uint32_t frameIndex ) -> VkDescriptorSet;
+    auto CreateView( uint32_t          frameIndex,
+                     VkImage           image,
+                     VkFormat          format,
+                     uint32_t          mipLevel,
+                     VkImageUsageFlags usage ) -> VkImageView;
+    void CreatePipelineLayout();
+    void CreatePipeline( const ShaderManager* shaderManager );
+    void DestroyPipeline();
+
+private:
+    VkDevice         device;
+    VkPhysicalDevice physDevice;
+
+    // format -> if it can be a storage image
+    mutable rgl::unordered_map< VkFormat, bool > storageSupport;
+
+    // counts finished workgroups, is reset to 0 by the last one
+    Buffer counter;
+
+    VkSampler             sampler;
+    VkDescriptorSetLayout descSetLayout;
+
+    struct PerFrame
+    {
+        // reset each frame, so their count only grows to the max uploads per frame
+        std::vector< VkDescriptorPool > pools;
+        uint32_t                        currentPool{ 0 };
+        uint32_t                        setsInCurrentPool{ 0 };
+        std::vector< VkImageView >      views;
+    };
+    PerFrame perFrame[ MAX_FRAMES_IN_FLIGHT ];
+
+    VkPipelineLayout pipelineLayout;
+    VkPipeline       pipeline;
+};
+
+}
@@ -0,0 +1,109 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Containers.h"
+
+#include <RTGL1/RTGL1.h>
+
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Strings that are passed as RgNameHandle. Not thread-safe
+class NameRegistry
+{
+public:
+    RgNameHandle Register( std::string_view name )
+    {
+        if( name.empty() )
+        {
+            return 0;
+        }
+
+        auto found = handles.find( name );
+        if( found != handles.end() )
+        {
+            return found->second;
+        }
+
+        // deque, so c-strings of the registered names are stable
+        names.emplace_back( name );
+        auto h = RgNameHandle( names.size() );
+
+        handles.emplace( std::string{ name }, h );
+        return h;
+    }
+
+    // Null, if handle is 0 or invalid
+    const char* Get( RgNameHandle handle ) const
+    {
+        if( handle == 0 || handle > names.size() )
+        {
+            return nullptr;
+        }
+        return names[ handle - 1 ].c_str();
+    }
+
+private:
+    std::deque< std::string >       names;
+    rgl::string_map< RgNameHandle > handles;
+};
+
+
+// Result of a lookup by name, remembered for each handle.
+// Must be cleared, if the data that the lookup reads is changed
+template< typename T >
+class NameHandleCache
+{
+public:
+    template< typename Lookup >
+    T Get( RgNameHandle handle, Lookup&& lookup )
+    {
+        if( handle == 0 )
+        {
+            return lookup();
+        }
+
+        if( handle >= entries.size() )
+        {
+            entries.resize( handle + 1 );
+        }
+
+        std::optional< T >& e = entries[ handle ];
+        if( !e )
+        {
+            e = lookup();
+        }
+        return *e;
+    }
+
+    void Clear() { entries.clear(); }
+
+private:
+    std::vector< std::optional< T > > entries;
+};
+
+}
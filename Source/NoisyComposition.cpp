@@ -0,0 +1,136 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "NoisyComposition.h"
+
+#include "Generated/ShaderCommonC.h"
+#include "CmdLabel.h"
+#include "Utils.h"
+
+RTGL1::NoisyComposition::NoisyComposition( VkDevice                        _device,
+                                           std::shared_ptr< Framebuffers > _framebuffers,
+                                           const ShaderManager&            _shaderManager,
+                                           const GlobalUniform&            _uniform )
+    : device( _device )
+    , framebuffers( std::move( _framebuffers ) )
+    , pipelineLayout( VK_NULL_HANDLE )
+    , pipeline( VK_NULL_HANDLE )
+{
+    VkDescriptorSetLayout setLayouts[] = {
+        framebuffers->GetDescSetLayout(),
+        _uniform.GetDescSetLayout(),
+    };
+
+    VkPipelineLayoutCreateInfo plLayoutInfo = {
+        .sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = std::size( setLayouts ),
+        .pSetLayouts    = setLayouts,
+    };
+
+    VkResult r = vkCreatePipelineLayout( device, &plLayoutInfo, nullptr, &pipelineLayout );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device,
+                    pipelineLayout,
+                    VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+                    "Noisy composition pipeline layout" );
+
+    CreatePipelines( &_shaderManager );
+}
+
+RTGL1::NoisyComposition::~NoisyComposition()
+{
+    vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
+    DestroyPipelines();
+}
+
+void RTGL1::NoisyComposition::Denoise( VkCommandBuffer                               cmd,
+                                       uint32_t                                      frameIndex,
+                                       const std::shared_ptr< const GlobalUniform >& uniform )
+{
+    typedef FramebufferImageIndex FI;
+
+    CmdLabel label( cmd, "Noisy composition" );
+
+    FI fs[] = {
+        FI::FB_IMAGE_INDEX_UNFILTERED_DIRECT,
+        FI::FB_IMAGE_INDEX_UNFILTERED_SPECULAR,
+        FI::FB_IMAGE_INDEX_UNFILTERED_INDIR,
+        FI::FB_IMAGE_INDEX_METALLIC_ROUGHNESS,
+        FI::FB_IMAGE_INDEX_THROUGHPUT,
+    };
+    framebuffers->BarrierMultiple( cmd, frameIndex, fs );
+
+    VkDescriptorSet sets[] = {
+        framebuffers->GetDescSet( frameIndex ),
+        uniform->GetDescSet( frameIndex ),
+    };
+
+    vkCmdBindDescriptorSets( cmd,
+                             VK_PIPELINE_BIND_POINT_COMPUTE,
+                             pipelineLayout,
+                             0,
+                             std::size( sets ),
+                             sets,
+                             0,
+                             nullptr );
+
+    uint32_t wgCountX = Utils::GetWorkGroupCount( uniform->GetData()->renderWidth,
+                                                  COMPUTE_SVGF_ATROUS_GROUP_SIZE_X );
+    uint32_t wgCountY = Utils::GetWorkGroupCount( uniform->GetData()->renderHeight,
+                                                  COMPUTE_SVGF_ATROUS_GROUP_SIZE_X );
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+    vkCmdDispatch( cmd, wgCountX, wgCountY, 1 );
+}
+
+void RTGL1::NoisyComposition::OnShaderReload( const ShaderManager* shaderManager )
+{
+    if( !shaderManager->AnyChanged( { "CNoisyComposition" } ) )
+    {
+        return;
+    }
+
+    DestroyPipelines();
+    CreatePipelines( shaderManager );
+}
+
+void RTGL1::NoisyComposition::CreatePipelines( const ShaderManager* shaderManager )
+{
+    assert( pipeline == VK_NULL_HANDLE );
+
+    VkComputePipelineCreateInfo plInfo = {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = shaderManager->GetStageInfo( "CNoisyComposition" ),
+        .layout = pipelineLayout,
+    };
+
+    VkResult r = vkCreateComputePipelines(
+        device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &pipeline );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, pipeline, VK_OBJECT_TYPE_PIPELINE, "Noisy composition pipeline" );
+}
+
+void RTGL1::NoisyComposition::DestroyPipelines()
+{
+    vkDestroyPipeline( device, pipeline, nullptr );
+    pipeline = VK_NULL_HANDLE;
+}
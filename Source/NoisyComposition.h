@@ -0,0 +1,66 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "IDenoiser.h"
+#include "ShaderManager.h"
+#include "Framebuffers.h"
+#include "GlobalUniform.h"
+
+namespace RTGL1
+{
+
+// Doesn't filter anything: composes the noisy illumination into PRE_FINAL
+// and prepares the guides, so a denoising upscaler (DLSS Ray Reconstruction)
+// can do both denoising and upscaling in one pass
+class NoisyComposition final : public IDenoiser, public IShaderDependency
+{
+public:
+    NoisyComposition( VkDevice                        device,
+                      std::shared_ptr< Framebuffers > framebuffers,
+                      const ShaderManager&            shaderManager,
+                      const GlobalUniform&            uniform );
+    ~NoisyComposition() override;
+
+    NoisyComposition( const NoisyComposition& other )                = delete;
+    NoisyComposition( NoisyComposition&& other ) noexcept            = delete;
+    NoisyComposition& operator=( const NoisyComposition& other )     = delete;
+    NoisyComposition& operator=( NoisyComposition&& other ) noexcept = delete;
+
+    void Denoise( VkCommandBuffer                               cmd,
+                  uint32_t                                      frameIndex,
+                  const std::shared_ptr< const GlobalUniform >& uniform ) override;
+
+    void OnShaderReload( const ShaderManager* shaderManager ) override;
+
+private:
+    void CreatePipelines( const ShaderManager* shaderManager );
+    void DestroyPipelines();
+
+private:
+    VkDevice                        device;
+    std::shared_ptr< Framebuffers > framebuffers;
+
+    VkPipelineLayout                pipelineLayout;
+    VkPipeline                      pipeline;
+};
+
+}
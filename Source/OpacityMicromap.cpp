@@ -0,0 +1,569 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "OpacityMicromap.h"
+
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+// same as in RtAlphaTest.rahit
+constexpr float ALPHA_THRESHOLD = 0.5f;
+
+constexpr uint32_t MAX_MASK_SIZE         = 256;
+constexpr uint32_t MAX_SUBDIVISION_LEVEL = 5;
+constexpr uint32_t MICROMAP_INPUT_ALIGN  = 256;
+
+// encoding of VK_OPACITY_MICROMAP_FORMAT_4_STATE_EXT
+enum MicroState : uint8_t
+{
+    MICRO_STATE_TRANSPARENT         = 0,
+    MICRO_STATE_OPAQUE              = 1,
+    MICRO_STATE_UNKNOWN_TRANSPARENT = 2,
+};
+
+bool IsOpaqueTexel( const uint8_t* rgba )
+{
+    const float avg = ( float( rgba[ 0 ] ) + float( rgba[ 1 ] ) + float( rgba[ 2 ] ) ) / 3.0f;
+    const float a   = float( rgba[ 3 ] ) / 255.0f;
+
+    return avg / 255.0f * a + a >= ALPHA_THRESHOLD;
+}
+
+uint32_t ExtractEvenBits( uint32_t x )
+{
+    x &= 0x55555555;
+    x = ( x | ( x >> 1 ) ) & 0x33333333;
+    x = ( x | ( x >> 2 ) ) & 0x0f0f0f0f;
+    x = ( x | ( x >> 4 ) ) & 0x00ff00ff;
+    x = ( x | ( x >> 8 ) ) & 0x0000ffff;
+    return x;
+}
+
+uint32_t PrefixEor( uint32_t x )
+{
+    x ^= ( x >> 1 );
+    x ^= ( x >> 2 );
+    x ^= ( x >> 4 );
+    x ^= ( x >> 8 );
+    return x;
+}
+
+struct MicroTriangle
+{
+    RgFloat2D bary[ 3 ];
+};
+
+// Barycentrics of a micro-triangle, its index is a distance along
+// the space-filling curve that is defined by the Vulkan specification
+MicroTriangle IndexToBarycentrics( uint32_t index, uint32_t subdivisionLevel )
+{
+    if( subdivisionLevel == 0 )
+    {
+        return MicroTriangle{ { { 0, 0 }, { 1, 0 }, { 0, 1 } } };
+    }
+
+    const uint32_t b0 = ExtractEvenBits( index );
+    const uint32_t b1 = ExtractEvenBits( index >> 1 );
+
+    const uint32_t fx = PrefixEor( b0 );
+    const uint32_t fy = PrefixEor( b0 & ~b1 );
+    const uint32_t t  = fy ^ b1;
+
+    const uint32_t levelMask = ( 1u << subdivisionLevel ) - 1;
+
+    uint32_t iu = ( ( fx & ~t ) | ( b0 & ~t ) | ( ~b0 & ~fx & t ) ) & levelMask;
+    uint32_t iv = ( fy ^ b0 ) & levelMask;
+    uint32_t iw = ( ( ~fx & ~t ) | ( b0 & ~t ) | ( ~b0 & fx & t ) ) & levelMask;
+
+    const bool upright = ( iu & 1 ) ^ ( iv & 1 ) ^ ( iw & 1 );
+    if( !upright )
+    {
+        iu = iu + 1;
+        iv = iv + 1;
+    }
+
+    const float scale = 1.0f / float( 1u << subdivisionLevel );
+    const float d     = upright ? scale : -scale;
+
+    const float u = float( iu ) * scale;
+    const float v = float( iv ) * scale;
+
+    return MicroTriangle{ { { u, v }, { u + d, v }, { u, v + d } } };
+}
+
+RgFloat2D Interpolate( const RgFloat2D ( &tc )[ 3 ], const RgFloat2D& bary )
+{
+    const float w = 1.0f - bary.data[ 0 ] - bary.data[ 1 ];
+    return RgFloat2D{
+        w * tc[ 0 ].data[ 0 ] + bary.data[ 0 ] * tc[ 1 ].data[ 0 ] +
+            bary.data[ 1 ] * tc[ 2 ].data[ 0 ],
+        w * tc[ 0 ].data[ 1 ] + bary.data[ 0 ] * tc[ 1 ].data[ 1 ] +
+            bary.data[ 1 ] * tc[ 2 ].data[ 1 ],
+    };
+}
+
+RgFloat2D Midpoint( const RgFloat2D& a, const RgFloat2D& b )
+{
+    return RgFloat2D{ 0.5f * ( a.data[ 0 ] + b.data[ 0 ] ), 0.5f * ( a.data[ 1 ] + b.data[ 1 ] ) };
+}
+
+MicroState ClassifyMicroTriangle( const RTGL1::OpacityMask& mask,
+                                  const RgFloat2D ( &tc )[ 3 ],
+                                  const MicroTriangle&      micro )
+{
+    const RgFloat2D& b0 = micro.bary[ 0 ];
+    const RgFloat2D& b1 = micro.bary[ 1 ];
+    const RgFloat2D& b2 = micro.bary[ 2 ];
+
+    const RgFloat2D samples[] = {
+        b0,
+        b1,
+        b2,
+        Midpoint( b0, b1 ),
+        Midpoint( b1, b2 ),
+        Midpoint( b2, b0 ),
+        RgFloat2D{ ( b0.data[ 0 ] + b1.data[ 0 ] + b2.data[ 0 ] ) / 3.0f,
+                   ( b0.data[ 1 ] + b1.data[ 1 ] + b2.data[ 1 ] ) / 3.0f },
+    };
+
+    uint32_t opaqueCount      = 0;
+    uint32_t transparentCount = 0;
+
+    for( const RgFloat2D& b : samples )
+    {
+        RgFloat2D uv = Interpolate( tc, b );
+
+        switch( mask.Get( uv.data[ 0 ], uv.data[ 1 ] ) )
+        {
+            case RTGL1::OpacityMask::Opaque: opaqueCount++; break;
+            case RTGL1::OpacityMask::Transparent: transparentCount++; break;
+            default: return MICRO_STATE_UNKNOWN_TRANSPARENT;
+        }
+    }
+
+    if( opaqueCount == std::size( samples ) )
+    {
+        return MICRO_STATE_OPAQUE;
+    }
+    if( transparentCount == std::size( samples ) )
+    {
+        return MICRO_STATE_TRANSPARENT;
+    }
+    // any-hit will resolve
+    return MICRO_STATE_UNKNOWN_TRANSPARENT;
+}
+
+uint32_t ChooseSubdivisionLevel( const RTGL1::OpacityMask& mask, const RgFloat2D ( &tc )[ 3 ] )
+{
+    const float e1[] = {
+        tc[ 1 ].data[ 0 ] - tc[ 0 ].data[ 0 ],
+        tc[ 1 ].data[ 1 ] - tc[ 0 ].data[ 1 ],
+    };
+    const float e2[] = {
+        tc[ 2 ].data[ 0 ] - tc[ 0 ].data[ 0 ],
+        tc[ 2 ].data[ 1 ] - tc[ 0 ].data[ 1 ],
+    };
+
+    // area in mask cells, each cell should be covered by a few micro-triangles
+    const float areaInCells = 0.5f * std::abs( e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ] ) *
+                              float( mask.GetWidth() ) * float( mask.GetHeight() );
+
+    uint32_t level = 1;
+    while( level < MAX_SUBDIVISION_LEVEL && float( 1u << ( 2 * level ) ) < areaInCells * 2.0f )
+    {
+        level++;
+    }
+    return level;
+}
+
+}
+
+auto RTGL1::OpacityMask::FromRGBA8( const uint8_t* pixels, RgExtent2D size )
+    -> std::shared_ptr< const OpacityMask >
+{
+    if( !pixels || size.width == 0 || size.height == 0 )
+    {
+        return {};
+    }
+
+    const uint32_t w = std::min( size.width, MAX_MASK_SIZE );
+    const uint32_t h = std::min( size.height, MAX_MASK_SIZE );
+
+    // raw state of each cell
+    auto raw = std::vector< State >( size_t{ w } * h );
+    for( uint32_t cy = 0; cy < h; cy++ )
+    {
+        for( uint32_t cx = 0; cx < w; cx++ )
+        {
+            const uint32_t x0 = cx * size.width / w;
+            const uint32_t x1 = std::max( x0 + 1, ( cx + 1 ) * size.width / w );
+            const uint32_t y0 = cy * size.height / h;
+            const uint32_t y1 = std::max( y0 + 1, ( cy + 1 ) * size.height / h );
+
+            bool anyOpaque = false, anyTransparent = false;
+            for( uint32_t y = y0; y < y1; y++ )
+            {
+                for( uint32_t x = x0; x < x1; x++ )
+                {
+                    const uint8_t* rgba = &pixels[ ( size_t{ y } * size.width + x ) * 4 ];
+                    ( IsOpaqueTexel( rgba ) ? anyOpaque : anyTransparent ) = true;
+                }
+            }
+
+            raw[ size_t{ cy } * w + cx ] = anyOpaque && anyTransparent ? Mixed
+                                           : anyOpaque                 ? Opaque
+                                                                       : Transparent;
+        }
+    }
+
+    auto mask    = std::make_shared< OpacityMask >();
+    mask->width  = w;
+    mask->height = h;
+    mask->cells.resize( raw.size() );
+
+    // dilate mixed cells to neighbors
+    for( uint32_t cy = 0; cy < h; cy++ )
+    {
+        for( uint32_t cx = 0; cx < w; cx++ )
+        {
+            State s = raw[ size_t{ cy } * w + cx ];
+
+            for( int dy = -1; dy <= 1 && s != Mixed; dy++ )
+            {
+                for( int dx = -1; dx <= 1 && s != Mixed; dx++ )
+                {
+                    const auto nx = uint32_t( int( cx ) + dx + int( w ) ) % w;
+                    const auto ny = uint32_t( int( cy ) + dy + int( h ) ) % h;
+
+                    if( raw[ size_t{ ny } * w + nx ] != s )
+                    {
+                        s = Mixed;
+                    }
+                }
+            }
+
+            mask->cells[ size_t{ cy } * w + cx ] = s;
+        }
+    }
+
+    return mask;
+}
+
+auto RTGL1::OpacityMask::Get( float u, float v ) const -> State
+{
+    if( !( u >= 0.0f && u <= 1.0f && v >= 0.0f && v <= 1.0f ) )
+    {
+        return Mixed;
+    }
+
+    const auto x = std::min( uint32_t( u * float( width ) ), width - 1 );
+    const auto y = std::min( uint32_t( v * float( height ) ), height - 1 );
+
+    return cells[ size_t{ y } * width + x ];
+}
+
+RTGL1::OpacityMicromap::OpacityMicromap( VkDevice                          _device,
+                                         std::vector< VkMicromapUsageEXT > _usageCounts )
+    : device( _device )
+    , micromap( VK_NULL_HANDLE )
+    , usageCounts( std::move( _usageCounts ) )
+    , attachment{
+          .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_TRIANGLES_OPACITY_MICROMAP_EXT,
+          .pNext            = nullptr,
+          .indexType        = VK_INDEX_TYPE_UINT32,
+          .indexBuffer      = {},
+          .indexStride      = sizeof( uint32_t ),
+          .baseTriangle     = 0,
+          .usageCountsCount = static_cast< uint32_t >( usageCounts.size() ),
+          .pUsageCounts     = usageCounts.data(),
+          .ppUsageCounts    = nullptr,
+          .micromap         = VK_NULL_HANDLE,
+      }
+{
+}
+
+RTGL1::OpacityMicromap::~OpacityMicromap()
+{
+    if( micromap != VK_NULL_HANDLE )
+    {
+        svkDestroyMicromapEXT( device, micromap, nullptr );
+    }
+}
+
+RTGL1::OpacityMicromapBuilder::OpacityMicromapBuilder(
+    VkDevice                                 _device,
+    std::shared_ptr< MemoryAllocator >       _allocator,
+    std::shared_ptr< ChunkedStackAllocator > _scratchAllocator )
+    : device( _device ), allocator( _allocator ), scratch( std::move( _scratchAllocator ) )
+{
+}
+
+auto RTGL1::OpacityMicromapBuilder::Add( const RgMeshPrimitiveInfo& primitive,
+                                         const OpacityMask&         mask,
+                                         ChunkedStackAllocator&     storage )
+    -> std::shared_ptr< OpacityMicromap >
+{
+    const bool     useIndices = Utils::HasIndices( primitive );
+    const uint32_t triangleCount =
+        useIndices ? primitive.indexCount / 3 : primitive.vertexCount / 3;
+    if( triangleCount == 0 )
+    {
+        return {};
+    }
+
+    auto getVertex = [ &primitive, useIndices ]( uint32_t i ) -> const RgPrimitiveVertex& {
+        return primitive.pVertices[ useIndices ? Utils::GetIndex( primitive, i ) : i ];
+    };
+
+    auto triangles = std::vector< VkMicromapTriangleEXT >{};
+    auto data      = std::vector< uint8_t >{};
+    auto indices   = std::vector< int32_t >( triangleCount );
+
+    uint32_t countPerLevel[ MAX_SUBDIVISION_LEVEL + 1 ] = {};
+    bool     anyResolved                                = false;
+
+    for( uint32_t t = 0; t < triangleCount; t++ )
+    {
+        const RgFloat2D tc[] = {
+            RgFloat2D{ getVertex( t * 3 + 0 ).texCoord[ 0 ], getVertex( t * 3 + 0 ).texCoord[ 1 ] },
+            RgFloat2D{ getVertex( t * 3 + 1 ).texCoord[ 0 ], getVertex( t * 3 + 1 ).texCoord[ 1 ] },
+            RgFloat2D{ getVertex( t * 3 + 2 ).texCoord[ 0 ], getVertex( t * 3 + 2 ).texCoord[ 1 ] },
+        };
+
+        const uint32_t level      = ChooseSubdivisionLevel( mask, tc );
+        const uint32_t microCount = 1u << ( 2 * level );
+
+        // 2 bits per micro-triangle
+        const size_t dataOffset = data.size();
+        data.resize( dataOffset + std::max( 1u, microCount / 4 ), 0 );
+
+        uint32_t opaqueCount = 0, transparentCount = 0;
+        for( uint32_t m = 0; m < microCount; m++ )
+        {
+            const auto state = ClassifyMicroTriangle( mask, tc, IndexToBarycentrics( m, level ) );
+
+            opaqueCount += state == MICRO_STATE_OPAQUE ? 1 : 0;
+            transparentCount += state == MICRO_STATE_TRANSPARENT ? 1 : 0;
+
+            data[ dataOffset + m / 4 ] |= uint8_t( state << ( 2 * ( m % 4 ) ) );
+        }
+
+        if( opaqueCount == microCount || transparentCount == microCount )
+        {
+            // whole triangle is resolved, no data is needed
+            data.resize( dataOffset );
+            indices[ t ] = opaqueCount == microCount
+                               ? VK_OPACITY_MICROMAP_SPECIAL_INDEX_FULLY_OPAQUE_EXT
+                               : VK_OPACITY_MICROMAP_SPECIAL_INDEX_FULLY_TRANSPARENT_EXT;
+            anyResolved  = true;
+            continue;
+        }
+
+        anyResolved = anyResolved || opaqueCount > 0 || transparentCount > 0;
+
+        indices[ t ] = int32_t( triangles.size() );
+        triangles.push_back( VkMicromapTriangleEXT{
+            .dataOffset       = uint32_t( dataOffset ),
+            .subdivisionLevel = uint16_t( level ),
+            .format           = VK_OPACITY_MICROMAP_FORMAT_4_STATE_EXT,
+        } );
+        countPerLevel[ level ]++;
+    }
+
+    if( !anyResolved )
+    {
+        // any-hit would be invoked anyway
+        return {};
+    }
+
+    // counts of triangles in the BLAS that reference the micromap
+    auto usageCounts = std::vector< VkMicromapUsageEXT >{};
+    for( uint32_t level = 0; level <= MAX_SUBDIVISION_LEVEL; level++ )
+    {
+        if( countPerLevel[ level ] > 0 )
+        {
+            usageCounts.push_back( VkMicromapUsageEXT{
+                .count            = countPerLevel[ level ],
+                .subdivisionLevel = level,
+                .format           = VK_OPACITY_MICROMAP_FORMAT_4_STATE_EXT,
+            } );
+        }
+    }
+
+    // micromap can't be empty, even if all triangles have special indices
+    auto buildUsageCounts = usageCounts;
+    if( triangles.empty() )
+    {
+        triangles.push_back( VkMicromapTriangleEXT{
+            .dataOffset       = uint32_t( data.size() ),
+            .subdivisionLevel = 0,
+            .format           = VK_OPACITY_MICROMAP_FORMAT_4_STATE_EXT,
+        } );
+        data.push_back( uint8_t( MICRO_STATE_UNKNOWN_TRANSPARENT ) );
+        buildUsageCounts.push_back( VkMicromapUsageEXT{
+            .count            = 1,
+            .subdivisionLevel = 0,
+            .format           = VK_OPACITY_MICROMAP_FORMAT_4_STATE_EXT,
+        } );
+    }
+
+    auto buildInfo = VkMicromapBuildInfoEXT{
+        .sType            = VK_STRUCTURE_TYPE_MICROMAP_BUILD_INFO_EXT,
+        .type             = VK_MICROMAP_TYPE_OPACITY_MICROMAP_EXT,
+        .flags            = VK_BUILD_MICROMAP_PREFER_FAST_TRACE_BIT_EXT,
+        .mode             = VK_BUILD_MICROMAP_MODE_BUILD_EXT,
+        .usageCountsCount = static_cast< uint32_t >( buildUsageCounts.size() ),
+        .pUsageCounts     = buildUsageCounts.data(),
+    };
+
+    auto sizes = VkMicromapBuildSizesInfoEXT{
+        .sType = VK_STRUCTURE_TYPE_MICROMAP_BUILD_SIZES_INFO_EXT,
+    };
+    svkGetMicromapBuildSizesEXT(
+        device, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, &buildInfo, &sizes );
+
+    auto omm = std::make_shared< OpacityMicromap >( device, std::move( usageCounts ) );
+    {
+        const auto place = storage.Push( sizes.micromapSize );
+
+        auto info = VkMicromapCreateInfoEXT{
+            .sType  = VK_STRUCTURE_TYPE_MICROMAP_CREATE_INFO_EXT,
+            .buffer = place.buffer,
+            .offset = place.offsetInBuffer,
+            .size   = sizes.micromapSize,
+            .type   = VK_MICROMAP_TYPE_OPACITY_MICROMAP_EXT,
+        };
+
+        VkResult r = svkCreateMicromapEXT( device, &info, nullptr, &omm->micromap );
+        VK_CHECKERROR( r );
+
+        omm->attachment.micromap = omm->micromap;
+    }
+
+    auto append = [ this ]( const void* src, size_t size ) {
+        const size_t offset = Utils::Align( stagingData.size(), size_t{ MICROMAP_INPUT_ALIGN } );
+        stagingData.resize( offset + size );
+        memcpy( &stagingData[ offset ], src, size );
+        return VkDeviceSize{ offset };
+    };
+
+    pending.push_back( Pending{
+        .omm              = omm,
+        .buildUsageCounts = std::move( buildUsageCounts ),
+        .trianglesOffset =
+            append( triangles.data(), triangles.size() * sizeof( VkMicromapTriangleEXT ) ),
+        .dataOffset    = append( data.data(), data.size() ),
+        .indicesOffset = append( indices.data(), indices.size() * sizeof( int32_t ) ),
+        .scratchSize   = sizes.buildScratchSize,
+    } );
+
+    return omm;
+}
+
+bool RTGL1::OpacityMicromapBuilder::Build( VkCommandBuffer cmd )
+{
+    if( pending.empty() )
+    {
+        return false;
+    }
+
+    auto alloc = allocator.lock();
+    if( !alloc )
+    {
+        assert( 0 );
+        return false;
+    }
+
+    staging.Destroy();
+    staging.Init( *alloc,
+                  stagingData.size(),
+                  VK_BUFFER_USAGE_MICROMAP_BUILD_INPUT_READ_ONLY_BIT_EXT |
+                      VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+                      VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  "Opacity micromap input" );
+    {
+        void* mapped = staging.Map();
+        memcpy( mapped, stagingData.data(), stagingData.size() );
+        staging.Unmap();
+    }
+    const VkDeviceAddress base = staging.GetAddress();
+
+    auto infos = std::vector< VkMicromapBuildInfoEXT >{};
+    infos.reserve( pending.size() );
+
+    for( Pending& p : pending )
+    {
+        p.omm->attachment.indexBuffer.deviceAddress = base + p.indicesOffset;
+
+        infos.push_back( VkMicromapBuildInfoEXT{
+            .sType               = VK_STRUCTURE_TYPE_MICROMAP_BUILD_INFO_EXT,
+            .type                = VK_MICROMAP_TYPE_OPACITY_MICROMAP_EXT,
+            .flags               = VK_BUILD_MICROMAP_PREFER_FAST_TRACE_BIT_EXT,
+            .mode                = VK_BUILD_MICROMAP_MODE_BUILD_EXT,
+            .dstMicromap         = p.omm->micromap,
+            .usageCountsCount    = static_cast< uint32_t >( p.buildUsageCounts.size() ),
+            .pUsageCounts        = p.buildUsageCounts.data(),
+            .data                = { .deviceAddress = base + p.dataOffset },
+            .scratchData         = { .deviceAddress = scratch->Push( p.scratchSize ).address },
+            .triangleArray       = { .deviceAddress = base + p.trianglesOffset },
+            .triangleArrayStride = sizeof( VkMicromapTriangleEXT ),
+        } );
+    }
+
+    svkCmdBuildMicromapsEXT( cmd, static_cast< uint32_t >( infos.size() ), infos.data() );
+
+    // micromaps are read by BLAS build
+    {
+        auto barrier = VkMemoryBarrier2{
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_MICROMAP_BUILD_BIT_EXT,
+            .srcAccessMask = VK_ACCESS_2_MICROMAP_WRITE_BIT_EXT,
+            .dstStageMask  = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+            .dstAccessMask = VK_ACCESS_2_MICROMAP_READ_BIT_EXT,
+        };
+        auto dep = VkDependencyInfo{
+            .sType              = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers    = &barrier,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    pending.clear();
+    stagingData.clear();
+    return true;
+}
+
+void RTGL1::OpacityMicromapBuilder::DeleteStaging()
+{
+    staging.Destroy();
+}
+
+bool RTGL1::OpacityMicromapBuilder::IsEmpty() const
+{
+    return pending.empty();
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "Buffer.h"
+#include "ScratchBuffer.h"
+
+namespace RTGL1
+{
+
+// Per-cell opacity of an albedo texture, with the same test as in RtAlphaTest.rahit.
+// A cell is Opaque / Transparent only if all of its texels and its neighbors' are,
+// so filtering and mipmapping don't change the result of the test.
+class OpacityMask
+{
+public:
+    enum State : uint8_t
+    {
+        Transparent,
+        Opaque,
+        Mixed,
+    };
+
+    static auto FromRGBA8( const uint8_t* pixels, RgExtent2D size )
+        -> std::shared_ptr< const OpacityMask >;
+
+    // Mixed, if outside of [0,1], as a sampler's address mode is not known
+    State Get( float u, float v ) const;
+
+    uint32_t GetWidth() const { return width; }
+    uint32_t GetHeight() const { return height; }
+
+private:
+    uint32_t             width{ 0 };
+    uint32_t             height{ 0 };
+    std::vector< State > cells{};
+};
+
+// Opacity micromap of one primitive. Triangles that are fully opaque / transparent
+// are marked with special indices, so any-hit shader is invoked only for partial ones
+class OpacityMicromap
+{
+public:
+    OpacityMicromap( VkDevice device, std::vector< VkMicromapUsageEXT > usageCounts );
+    ~OpacityMicromap();
+
+    OpacityMicromap( const OpacityMicromap& other )                = delete;
+    OpacityMicromap( OpacityMicromap&& other ) noexcept            = delete;
+    OpacityMicromap& operator=( const OpacityMicromap& other )     = delete;
+    OpacityMicromap& operator=( OpacityMicromap&& other ) noexcept = delete;
+
+    // To be linked to VkAccelerationStructureGeometryTrianglesDataKHR::pNext
+    auto GetAttachment() -> VkAccelerationStructureTrianglesOpacityMicromapEXT*
+    {
+        return &attachment;
+    }
+
+private:
+    friend class OpacityMicromapBuilder;
+
+    VkDevice                                           device;
+    VkMicromapEXT                                      micromap;
+    std::vector< VkMicromapUsageEXT >                  usageCounts;
+    VkAccelerationStructureTrianglesOpacityMicromapEXT attachment;
+};
+
+class OpacityMicromapBuilder
+{
+public:
+    OpacityMicromapBuilder( VkDevice                                 device,
+                            std::shared_ptr< MemoryAllocator >       allocator,
+                            std::shared_ptr< ChunkedStackAllocator > scratchAllocator );
+    ~OpacityMicromapBuilder() = default;
+
+    OpacityMicromapBuilder( const OpacityMicromapBuilder& other )                = delete;
+    OpacityMicromapBuilder( OpacityMicromapBuilder&& other ) noexcept            = delete;
+    OpacityMicromapBuilder& operator=( const OpacityMicromapBuilder& other )     = delete;
+    OpacityMicromapBuilder& operator=( OpacityMicromapBuilder&& other ) noexcept = delete;
+
+    // Bake micromap on CPU from texture coordinates of the primitive.
+    // Returns null, if no triangles can be resolved by the micromap.
+    // Micromap must be alive while BLAS that references it is in use.
+    auto Add( const RgMeshPrimitiveInfo& primitive,
+              const OpacityMask&         mask,
+              ChunkedStackAllocator&     storage ) -> std::shared_ptr< OpacityMicromap >;
+
+    // Must be recorded before building BLAS-es that reference the added micromaps
+    bool Build( VkCommandBuffer cmd );
+    // Free input data, when the building is complete
+    void DeleteStaging();
+
+    bool IsEmpty() const;
+
+private:
+    struct Pending
+    {
+        std::shared_ptr< OpacityMicromap > omm;
+        std::vector< VkMicromapUsageEXT >  buildUsageCounts;
+        VkDeviceSize                       trianglesOffset;
+        VkDeviceSize                       dataOffset;
+        VkDeviceSize                       indicesOffset;
+        VkDeviceSize                       scratchSize;
+    };
+
+private:
+    VkDevice                                 device;
+    std::weak_ptr< MemoryAllocator >         allocator;
+    std::shared_ptr< ChunkedStackAllocator > scratch;
+
+    std::vector< Pending > pending;
+    // triangle arrays, micromap data, and BLAS indices of all pending micromaps
+    std::vector< uint8_t > stagingData;
+    Buffer                 staging;
+};
+
+}
@@ -0,0 +1,549 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "ParticleExpansion.h"
+
+#include "CmdLabel.h"
+#include "Generated/ShaderCommonC.h"
+#include "Utils.h"
+
+#include <cmath>
+#include <numbers>
+
+namespace
+{
+
+// per frame
+constexpr uint32_t PARTICLE_MAX_COUNT     = 1 << 18;
+constexpr uint32_t PARTICLE_MAX_JOB_COUNT = 1 << 12;
+
+// must be same as in CmParticleExpand.comp
+struct ParticleExpandPush
+{
+    float cameraRight[ 4 ];
+    float cameraUp[ 4 ];
+};
+
+// two triangles of a quad, in units of the particle size
+constexpr float QUAD_CORNERS[ RTGL1::ParticleExpansion::VERTICES_PER_PARTICLE ][ 2 ] = {
+    { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f },
+    { -0.5f, -0.5f }, { 0.5f, 0.5f },  { -0.5f, 0.5f },
+};
+
+RgFloat3D Normalize( const RgFloat3D& v )
+{
+    const float len = std::sqrt( v.data[ 0 ] * v.data[ 0 ] + v.data[ 1 ] * v.data[ 1 ] +
+                                 v.data[ 2 ] * v.data[ 2 ] );
+    if( len < 0.0001f )
+    {
+        return RgFloat3D{ 0, 0, 0 };
+    }
+    return RgFloat3D{ v.data[ 0 ] / len, v.data[ 1 ] / len, v.data[ 2 ] / len };
+}
+
+RgFloat3D Cross( const RgFloat3D& a, const RgFloat3D& b )
+{
+    return RgFloat3D{
+        a.data[ 1 ] * b.data[ 2 ] - a.data[ 2 ] * b.data[ 1 ],
+        a.data[ 2 ] * b.data[ 0 ] - a.data[ 0 ] * b.data[ 2 ],
+        a.data[ 0 ] * b.data[ 1 ] - a.data[ 1 ] * b.data[ 0 ],
+    };
+}
+
+// world-space direction to mesh space, i.e. multiply by the inverse of the 3x3 part
+RgFloat3D ToMeshSpace( const RgTransform& transform, const RgFloat3D& v )
+{
+    const auto& m = transform.matrix;
+
+    const RgFloat3D c0 = { m[ 0 ][ 0 ], m[ 1 ][ 0 ], m[ 2 ][ 0 ] };
+    const RgFloat3D c1 = { m[ 0 ][ 1 ], m[ 1 ][ 1 ], m[ 2 ][ 1 ] };
+    const RgFloat3D c2 = { m[ 0 ][ 2 ], m[ 1 ][ 2 ], m[ 2 ][ 2 ] };
+
+    // rows of the inverse are the cross products of the columns, divided by the determinant
+    const RgFloat3D r0 = Cross( c1, c2 );
+    const RgFloat3D r1 = Cross( c2, c0 );
+    const RgFloat3D r2 = Cross( c0, c1 );
+
+    auto dot = []( const RgFloat3D& a, const RgFloat3D& b ) {
+        return a.data[ 0 ] * b.data[ 0 ] + a.data[ 1 ] * b.data[ 1 ] + a.data[ 2 ] * b.data[ 2 ];
+    };
+
+    // the result is normalized, so the determinant only matters for its sign
+    const float det = dot( c0, r0 ) < 0 ? -1.0f : 1.0f;
+    return RgFloat3D{ det * dot( r0, v ), det * dot( r1, v ), det * dot( r2, v ) };
+}
+
+RTGL1::ShParticle MakeParticle( const RgParticle& p )
+{
+    return RTGL1::ShParticle{
+        .position = { p.position.data[ 0 ], p.position.data[ 1 ], p.position.data[ 2 ] },
+        .size     = p.size,
+        .rotation = p.rotation,
+        .color    = p.color,
+        .frame    = p.frame,
+    };
+}
+
+}
+
+RTGL1::ParticleExpansion::ParticleExpansion( VkDevice                           _device,
+                                             std::shared_ptr< MemoryAllocator > _allocator,
+                                             const GlobalUniform&               _uniform,
+                                             VkDescriptorSetLayout _vertexDataSetLayout,
+                                             const ShaderManager&  _shaderManager )
+    : device( _device )
+    , descPool( VK_NULL_HANDLE )
+    , descSetLayout( VK_NULL_HANDLE )
+    , descSet( VK_NULL_HANDLE )
+    , pipelineLayout( VK_NULL_HANDLE )
+    , pipeline( VK_NULL_HANDLE )
+{
+    particleData = std::make_unique< AutoBuffer >( _allocator );
+    particleData->Create( PARTICLE_MAX_COUNT * sizeof( ShParticle ),
+                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                          "Particles" );
+
+    jobs = std::make_unique< AutoBuffer >( std::move( _allocator ) );
+    jobs->Create( PARTICLE_MAX_JOB_COUNT * sizeof( ShParticleJob ),
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                  "Particle jobs" );
+
+    CreateDescriptors();
+
+    VkDescriptorSetLayout setLayouts[] = {
+        _uniform.GetDescSetLayout(),
+        _vertexDataSetLayout,
+        descSetLayout,
+    };
+
+    CreatePipelineLayout( setLayouts, std::size( setLayouts ) );
+    CreatePipeline( &_shaderManager );
+}
+
+RTGL1::ParticleExpansion::~ParticleExpansion()
+{
+    vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
+    DestroyPipeline();
+    vkDestroyDescriptorPool( device, descPool, nullptr );
+    vkDestroyDescriptorSetLayout( device, descSetLayout, nullptr );
+}
+
+void RTGL1::ParticleExpansion::BeginFrame( uint32_t frameIndex )
+{
+    particleCount = 0;
+    jobCount      = 0;
+}
+
+auto RTGL1::ParticleExpansion::PrepareParticles( uint32_t                           frameIndex,
+                                                 const RgMeshPrimitiveParticlesEXT& particles )
+    -> std::optional< uint32_t >
+{
+    if( !particles.pParticles || particles.particleCount == 0 )
+    {
+        return std::nullopt;
+    }
+
+    if( jobCount >= PARTICLE_MAX_JOB_COUNT ||
+        particleCount + particles.particleCount > PARTICLE_MAX_COUNT )
+    {
+        debug::Warning( "Too many particles in a frame, the limits are: {} primitives, "
+                        "{} particles",
+                        PARTICLE_MAX_JOB_COUNT,
+                        PARTICLE_MAX_COUNT );
+        return std::nullopt;
+    }
+
+    const uint32_t offset = particleCount;
+    particleCount += particles.particleCount;
+
+    auto* dst = particleData->GetMappedAs< ShParticle* >( frameIndex );
+    for( uint32_t i = 0; i < particles.particleCount; i++ )
+    {
+        dst[ offset + i ] = MakeParticle( particles.pParticles[ i ] );
+    }
+
+    return offset;
+}
+
+void RTGL1::ParticleExpansion::AddJob( uint32_t                           frameIndex,
+                                       uint32_t                           particleOffset,
+                                       const RgMeshPrimitiveParticlesEXT& particles,
+                                       const RgTransform&                 transform,
+                                       uint32_t                           dstVertexIndex )
+{
+    assert( jobCount < PARTICLE_MAX_JOB_COUNT );
+    assert( particleOffset + particles.particleCount <= particleCount );
+
+    auto* dstJobs = jobs->GetMappedAs< ShParticleJob* >( frameIndex );
+    dstJobs[ jobCount ] = ShParticleJob{
+        .particleOffset  = particleOffset,
+        .dstVertexIndex  = dstVertexIndex,
+        .particleCount   = particles.particleCount,
+        .flipbookColumns = std::max( 1u, particles.flipbookColumns ),
+        .flipbookRows    = std::max( 1u, particles.flipbookRows ),
+        .model_0         = { RG_ACCESS_VEC4( transform.matrix[ 0 ] ) },
+        .model_1         = { RG_ACCESS_VEC4( transform.matrix[ 1 ] ) },
+        .model_2         = { RG_ACCESS_VEC4( transform.matrix[ 2 ] ) },
+    };
+
+    jobCount++;
+}
+
+void RTGL1::ParticleExpansion::Dispatch( VkCommandBuffer      cmd,
+                                         uint32_t             frameIndex,
+                                         const GlobalUniform& uniform,
+                                         VkDescriptorSet      vertexDataSet )
+{
+    if( jobCount == 0 )
+    {
+        return;
+    }
+
+    CmdLabel label( cmd, "Particle expansion" );
+
+    {
+        // particles and jobs might still be read by the previous frame
+        VkMemoryBarrier barrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = 0,
+        };
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              0,
+                              1,
+                              &barrier,
+                              0,
+                              nullptr,
+                              0,
+                              nullptr );
+    }
+
+    particleData->CopyFromStaging( cmd, frameIndex, particleCount * sizeof( ShParticle ) );
+    jobs->CopyFromStaging( cmd, frameIndex, jobCount * sizeof( ShParticleJob ) );
+
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+
+    VkDescriptorSet sets[] = {
+        uniform.GetDescSet( frameIndex ),
+        vertexDataSet,
+        descSet,
+    };
+
+    vkCmdBindDescriptorSets( cmd,
+                             VK_PIPELINE_BIND_POINT_COMPUTE,
+                             pipelineLayout,
+                             0,
+                             std::size( sets ),
+                             sets,
+                             0,
+                             nullptr );
+
+    {
+        // the global uniform buffer might be not uploaded yet, if on async compute;
+        // but its CPU side is already filled, columns of the inverse view are the camera axes
+        const float* invView = uniform.GetData()->invView;
+
+        ParticleExpandPush push = {
+            .cameraRight = { invView[ 0 ], invView[ 1 ], invView[ 2 ], 0 },
+            .cameraUp    = { invView[ 4 ], invView[ 5 ], invView[ 6 ], 0 },
+        };
+
+        vkCmdPushConstants(
+            cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( push ), &push );
+    }
+
+    vkCmdDispatch( cmd, jobCount, 1, 1 );
+
+
+    {
+        // expanded vertices are used for BLAS build, vertex preprocessing
+        // and as the previous frame's vertices
+        VkMemoryBarrier barrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR |
+                             VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+        };
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                  VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR |
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              0,
+                              1,
+                              &barrier,
+                              0,
+                              nullptr,
+                              0,
+                              nullptr );
+    }
+}
+
+void RTGL1::ParticleExpansion::OnShaderReload( const ShaderManager* shaderManager )
+{
+    if( !shaderManager->AnyChanged( { "CParticleExpand" } ) )
+    {
+        return;
+    }
+
+    DestroyPipeline();
+    CreatePipeline( shaderManager );
+}
+
+void RTGL1::ParticleExpansion::ExpandOnCPU( const RgMeshPrimitiveParticlesEXT& particles,
+                                            const RgTransform&                 transform,
+                                            const float*                       view,
+                                            std::vector< RgPrimitiveVertex >&  dst )
+{
+    dst.clear();
+
+    if( !particles.pParticles || particles.particleCount == 0 )
+    {
+        return;
+    }
+
+    // rows of the view matrix are the camera axes in world space
+    const RgFloat3D right =
+        Normalize( ToMeshSpace( transform, { view[ 0 ], view[ 4 ], view[ 8 ] } ) );
+    const RgFloat3D up =
+        Normalize( ToMeshSpace( transform, { view[ 1 ], view[ 5 ], view[ 9 ] } ) );
+
+    const RgFloat3D        toCamera = Normalize( Cross( right, up ) );
+    const RgNormalPacked32 normal =
+        Utils::PackNormal( toCamera.data[ 0 ], toCamera.data[ 1 ], toCamera.data[ 2 ] );
+
+    const uint32_t columns = std::max( 1u, particles.flipbookColumns );
+    const uint32_t rows    = std::max( 1u, particles.flipbookRows );
+
+    dst.reserve( size_t{ particles.particleCount } * VERTICES_PER_PARTICLE );
+
+    for( uint32_t i = 0; i < particles.particleCount; i++ )
+    {
+        const RgParticle& p = particles.pParticles[ i ];
+
+        const float cs = std::cos( p.rotation );
+        const float sn = std::sin( p.rotation );
+
+        const uint32_t frame = p.frame % ( columns * rows );
+        const float    cellU = float( frame % columns );
+        const float    cellV = float( frame / columns );
+
+        for( const auto& [ x, y ] : QUAD_CORNERS )
+        {
+            const float ox = p.size * ( cs * x - sn * y );
+            const float oy = p.size * ( sn * x + cs * y );
+
+            dst.push_back( RgPrimitiveVertex{
+                .position     = { p.position.data[ 0 ] + ox * right.data[ 0 ] + oy * up.data[ 0 ],
+                                  p.position.data[ 1 ] + ox * right.data[ 1 ] + oy * up.data[ 1 ],
+                                  p.position.data[ 2 ] + ox * right.data[ 2 ] + oy * up.data[ 2 ] },
+                .normalPacked = normal,
+                .texCoord     = { ( cellU + x + 0.5f ) / float( columns ),
+                                  ( cellV + 0.5f - y ) / float( rows ) },
+                .color        = p.color,
+            } );
+        }
+    }
+}
+
+auto RTGL1::ParticleExpansion::MakeLocalBounds( const RgMeshPrimitiveParticlesEXT& particles )
+    -> std::pair< std::array< float, 3 >, std::array< float, 3 > >
+{
+    if( !particles.pParticles || particles.particleCount == 0 )
+    {
+        return {};
+    }
+
+    auto mn = std::array{ FLT_MAX, FLT_MAX, FLT_MAX };
+    auto mx = std::array{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for( uint32_t i = 0; i < particles.particleCount; i++ )
+    {
+        const RgParticle& p = particles.pParticles[ i ];
+
+        // half of the quad's diagonal
+        const float r = std::abs( p.size ) * 0.5f * std::numbers::sqrt2_v< float >;
+
+        for( int a = 0; a < 3; a++ )
+        {
+            mn[ a ] = std::min( mn[ a ], p.position.data[ a ] - r );
+            mx[ a ] = std::max( mx[ a ], p.position.data[ a ] + r );
+        }
+    }
+
+    return { mn, mx };
+}
+
+void RTGL1::ParticleExpansion::CreateDescriptors()
+{
+    VkResult r;
+
+    VkDescriptorSetLayoutBinding bindings[] = {
+        {
+            .binding         = BINDING_PARTICLES,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_PARTICLE_JOBS,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = std::size( bindings ),
+        .pBindings    = bindings,
+    };
+
+    r = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descSetLayout );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device,
+                    descSetLayout,
+                    VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+                    "Particle expansion Desc set layout" );
+
+    VkDescriptorPoolSize poolSize = {
+        .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = std::size( bindings ),
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo = {
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets       = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes    = &poolSize,
+    };
+
+    r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &descPool );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME(
+        device, descPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Particle expansion Desc pool" );
+
+    VkDescriptorSetAllocateInfo allocInfo = {
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool     = descPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts        = &descSetLayout,
+    };
+
+    r = vkAllocateDescriptorSets( device, &allocInfo, &descSet );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, descSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Particle expansion Desc set" );
+
+
+    VkDescriptorBufferInfo bufs[] = {
+        {
+            .buffer = particleData->GetDeviceLocal(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = jobs->GetDeviceLocal(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+    };
+
+    VkWriteDescriptorSet wrts[] = {
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_PARTICLES,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_PARTICLES ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_PARTICLE_JOBS,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_PARTICLE_JOBS ],
+        },
+    };
+    static_assert( std::size( wrts ) == std::size( bufs ) );
+
+    vkUpdateDescriptorSets( device, std::size( wrts ), wrts, 0, nullptr );
+}
+
+void RTGL1::ParticleExpansion::CreatePipelineLayout( const VkDescriptorSetLayout* pSetLayouts,
+                                                     uint32_t setLayoutCount )
+{
+    VkPushConstantRange push = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset     = 0,
+        .size       = sizeof( ParticleExpandPush ),
+    };
+
+    VkPipelineLayoutCreateInfo plLayoutInfo = {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount         = setLayoutCount,
+        .pSetLayouts            = pSetLayouts,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &push,
+    };
+
+    VkResult r = vkCreatePipelineLayout( device, &plLayoutInfo, nullptr, &pipelineLayout );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device,
+                    pipelineLayout,
+                    VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+                    "Particle expansion pipeline layout" );
+}
+
+void RTGL1::ParticleExpansion::CreatePipeline( const ShaderManager* shaderManager )
+{
+    VkComputePipelineCreateInfo plInfo = {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = shaderManager->GetStageInfo( "CParticleExpand" ),
+        .layout = pipelineLayout,
+    };
+
+    VkResult r = vkCreateComputePipelines( device,
+                                           shaderManager->GetPipelineCache(),
+                                           1,
+                                           &plInfo,
+                                           nullptr,
+                                           &pipeline );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, pipeline, VK_OBJECT_TYPE_PIPELINE, "Particle expansion pipeline" );
+}
+
+void RTGL1::ParticleExpansion::DestroyPipeline()
+{
+    vkDestroyPipeline( device, pipeline, nullptr );
+    pipeline = VK_NULL_HANDLE;
+}
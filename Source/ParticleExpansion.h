@@ -0,0 +1,107 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "AutoBuffer.h"
+#include "GlobalUniform.h"
+#include "ShaderManager.h"
+
+namespace RTGL1
+{
+
+// Dynamic primitives with RgMeshPrimitiveParticlesEXT are uploaded as compact particle
+// records, and expanded into camera-facing quads on GPU. The quads are written directly
+// into the dynamic vertex buffer as non-indexed triangles, 6 vertices per particle.
+class ParticleExpansion : public IShaderDependency
+{
+public:
+    static constexpr uint32_t VERTICES_PER_PARTICLE = 6;
+
+    ParticleExpansion( VkDevice                           device,
+                       std::shared_ptr< MemoryAllocator > allocator,
+                       const GlobalUniform&               uniform,
+                       VkDescriptorSetLayout              vertexDataSetLayout,
+                       const ShaderManager&               shaderManager );
+    ~ParticleExpansion() override;
+
+    ParticleExpansion( const ParticleExpansion& other )                = delete;
+    ParticleExpansion( ParticleExpansion&& other ) noexcept            = delete;
+    ParticleExpansion& operator=( const ParticleExpansion& other )     = delete;
+    ParticleExpansion& operator=( ParticleExpansion&& other ) noexcept = delete;
+
+    void BeginFrame( uint32_t frameIndex );
+
+    // Upload the particles of this frame. Returns their offset in the particle buffer;
+    // null, if the limits are exceeded, then the primitive should be skipped
+    auto PrepareParticles( uint32_t frameIndex, const RgMeshPrimitiveParticlesEXT& particles )
+        -> std::optional< uint32_t >;
+    // Must be called after successful PrepareParticles of the same primitive
+    void AddJob( uint32_t                           frameIndex,
+                 uint32_t                           particleOffset,
+                 const RgMeshPrimitiveParticlesEXT& particles,
+                 const RgTransform&                 transform,
+                 uint32_t                           dstVertexIndex );
+    bool HasJobs() const { return jobCount > 0; }
+
+    // Must be called after dynamic vertex data is copied from staging,
+    // and before BLAS-es that use the expanded vertices are built.
+    // Camera is read from the CPU side of 'uniform'
+    void Dispatch( VkCommandBuffer      cmd,
+                   uint32_t             frameIndex,
+                   const GlobalUniform& uniform,
+                   VkDescriptorSet      vertexDataSet );
+
+    void OnShaderReload( const ShaderManager* shaderManager ) override;
+
+    // Same expansion on CPU, for the rasterized primitives. 'view' is a column-major 4x4
+    static void ExpandOnCPU( const RgMeshPrimitiveParticlesEXT& particles,
+                             const RgTransform&                 transform,
+                             const float*                       view,
+                             std::vector< RgPrimitiveVertex >&  dst );
+    // Mesh-space bounds of the quads for any camera orientation
+    static auto MakeLocalBounds( const RgMeshPrimitiveParticlesEXT& particles )
+        -> std::pair< std::array< float, 3 >, std::array< float, 3 > >;
+
+private:
+    void CreateDescriptors();
+    void CreatePipelineLayout( const VkDescriptorSetLayout* pSetLayouts, uint32_t setLayoutCount );
+    void CreatePipeline( const ShaderManager* shaderManager );
+    void DestroyPipeline();
+
+private:
+    VkDevice device;
+
+    std::unique_ptr< AutoBuffer > particleData;
+    std::unique_ptr< AutoBuffer > jobs;
+
+    uint32_t particleCount{ 0 };
+    uint32_t jobCount{ 0 };
+
+    VkDescriptorPool      descPool;
+    VkDescriptorSetLayout descSetLayout;
+    VkDescriptorSet       descSet;
+
+    VkPipelineLayout pipelineLayout;
+    VkPipeline       pipeline;
+};
+
+}
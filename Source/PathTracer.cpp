@@ -99,7 +99,8 @@ PathTracer::TraceParams PathTracer::BindRayTracing( VkCommandBuffer
 {
     vkCmdBindPipeline( cmd,
                        VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
-                       rtPipeline->GetShaderTableSafely_RayTracing( cmd ) );
+                       rtPipeline->GetShaderTableSafely_RayTracing(
+                           cmd, uniform.GetData()->reflectRefractMaxDepth ) );
 
     BindDescSet( VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR,
                  cmd,
@@ -116,13 +117,47 @@ PathTracer::TraceParams PathTracer::BindRayTracing( VkCommandBuffer
                  portalList,
                  volumetric );
 
-    TraceParams p   = {};
-    p.cmd           = cmd;
-    p.frameIndex    = frameIndex;
-    p.width         = width;
-    p.height        = height;
-    p.framebuffers  = std::move( framebuffers );
-    p.restirBuffers = std::move( restirBuffers );
+    // bound to a separate bind point, so it can coexist with the ray tracing pipeline
+    VkPipeline primaryCompute = rtPipeline->GetPipelinePrimary_Compute();
+    VkPipeline resolveCompute = rtPipeline->GetPipelineVisibilityResolve_Compute();
+    if( primaryCompute || resolveCompute )
+    {
+        if( primaryCompute )
+        {
+            vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, primaryCompute );
+        }
+
+        // layout is shared, so the sets stay valid after binding the resolve pipeline
+        BindDescSet( VK_PIPELINE_BIND_POINT_COMPUTE,
+                     cmd,
+                     frameIndex,
+                     scene,
+                     uniform,
+                     textureManager,
+                     *framebuffers,
+                     *restirBuffers,
+                     blueNoise,
+                     lightManager,
+                     cubemapManager,
+                     renderCubemap,
+                     portalList,
+                     volumetric );
+    }
+
+    TraceParams p              = {};
+    p.cmd                      = cmd;
+    p.frameIndex               = frameIndex;
+    p.width                    = width;
+    p.height                   = height;
+    p.framebuffers             = std::move( framebuffers );
+    p.restirBuffers            = std::move( restirBuffers );
+    p.primaryRayQuery          = primaryCompute != VK_NULL_HANDLE;
+    p.primaryVisibilityResolve = resolveCompute != VK_NULL_HANDLE;
+    p.indirStride              = std::max( uniform.GetData()->indirStride, 1u );
+    p.indirCheckerboard        = uniform.GetData()->indirCheckerboard != 0;
+    p.volumeSize[ 0 ]          = uniform.GetData()->volumeSizeX;
+    p.volumeSize[ 1 ]          = uniform.GetData()->volumeSizeY;
+    p.volumeSize[ 2 ]          = uniform.GetData()->volumeSizeZ;
 
     return p;
 }
@@ -161,7 +196,37 @@ void PathTracer::TracePrimaryRays( const TraceParams& params )
     params.framebuffers->BarrierMultiple( params.cmd, params.frameIndex, fs );
 
 
-    TraceRays( params.cmd, SBT_INDEX_RAYGEN_PRIMARY, params.width, params.height );
+    if( params.primaryRayQuery )
+    {
+        // compute pipeline was bound in BindRayTracing
+        vkCmdDispatch(
+            params.cmd,
+            Utils::GetWorkGroupCount( params.width, COMPUTE_RAY_QUERY_PRIMARY_GROUP_SIZE_X ),
+            Utils::GetWorkGroupCount( params.height, COMPUTE_RAY_QUERY_PRIMARY_GROUP_SIZE_Y ),
+            1 );
+    }
+    else
+    {
+        TraceRays( params.cmd, SBT_INDEX_RAYGEN_PRIMARY, params.width, params.height );
+    }
+
+    if( params.primaryVisibilityResolve )
+    {
+        // the pass above wrote only the visibility buffer
+        auto resolveLabel = CmdLabel{ params.cmd, "Visibility buffer resolve" };
+
+        params.framebuffers->BarrierOne(
+            params.cmd, params.frameIndex, FI::FB_IMAGE_INDEX_VISIBILITY_BUFFER );
+
+        vkCmdBindPipeline( params.cmd,
+                           VK_PIPELINE_BIND_POINT_COMPUTE,
+                           rtPipeline->GetPipelineVisibilityResolve_Compute() );
+        vkCmdDispatch(
+            params.cmd,
+            Utils::GetWorkGroupCount( params.width, COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_X ),
+            Utils::GetWorkGroupCount( params.height, COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_Y ),
+            1 );
+    }
 }
 
 void PathTracer::TraceReflectionRefractionRays( const TraceParams& params )
@@ -263,7 +328,13 @@ void PathTracer::TraceIndirectllumination( const TraceParams& params )
     params.framebuffers->BarrierMultiple( params.cmd, params.frameIndex, fs );
 
 
-    TraceRays( params.cmd, SBT_INDEX_RAYGEN_INDIRECT_INIT, params.width, params.height );
+    // one ray per indirStride x indirStride block, or per 2x1 block if checkerboarded
+    TraceRays( params.cmd,
+               SBT_INDEX_RAYGEN_INDIRECT_INIT,
+               Utils::GetWorkGroupCount( params.width, params.indirStride ),
+               params.indirCheckerboard
+                   ? params.height
+                   : Utils::GetWorkGroupCount( params.height, params.indirStride ) );
 }
 
 void PathTracer::FinalizeIndirectIllumination_Compute( VkCommandBuffer       cmd,
@@ -319,7 +390,7 @@ void PathTracer::TraceVolumetric( const TraceParams& params )
 
     TraceRays( params.cmd,
                SBT_INDEX_RAYGEN_VOLUMETRIC,
-               VOLUMETRIC_SIZE_X,
-               VOLUMETRIC_SIZE_Y,
-               VOLUMETRIC_SIZE_Z );
+               params.volumeSize[ 0 ],
+               params.volumeSize[ 1 ],
+               params.volumeSize[ 2 ] );
 }
@@ -46,6 +46,11 @@ public:
         uint32_t                         height     = 0;
         std::shared_ptr< Framebuffers >  framebuffers;
         std::shared_ptr< RestirBuffers > restirBuffers;
+        bool                             primaryRayQuery          = false;
+        bool                             primaryVisibilityResolve = false;
+        uint32_t                         indirStride              = 1;
+        bool                             indirCheckerboard        = false;
+        uint32_t                         volumeSize[ 3 ]          = {};
     };
 
 public:
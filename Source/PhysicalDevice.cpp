@@ -51,9 +51,40 @@ PhysicalDevice::PhysicalDevice( VkInstance instance )
 
     for( VkPhysicalDevice p : physicalDevices )
     {
+        auto memoryDecompressionFeatures = VkPhysicalDeviceMemoryDecompressionFeaturesNV{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_DECOMPRESSION_FEATURES_NV,
+            .pNext = nullptr,
+        };
+        auto presentWaitFeatures = VkPhysicalDevicePresentWaitFeaturesKHR{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+            .pNext = &memoryDecompressionFeatures,
+        };
+#ifdef VK_AMD_anti_lag
+        auto antiLagFeatures = VkPhysicalDeviceAntiLagFeaturesAMD{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ANTI_LAG_FEATURES_AMD,
+            .pNext = &presentWaitFeatures,
+        };
+        auto presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+            .pNext = &antiLagFeatures,
+        };
+#else
+        auto presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+            .pNext = &presentWaitFeatures,
+        };
+#endif
+        auto invocationReorderFeatures = VkPhysicalDeviceRayTracingInvocationReorderFeaturesNV{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_INVOCATION_REORDER_FEATURES_NV,
+            .pNext = &presentIdFeatures,
+        };
+        auto opacityMicromapFeatures = VkPhysicalDeviceOpacityMicromapFeaturesEXT{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_OPACITY_MICROMAP_FEATURES_EXT,
+            .pNext = &invocationReorderFeatures,
+        };
         auto positionFetchFeatures = VkPhysicalDeviceRayTracingPositionFetchFeaturesKHR{
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_POSITION_FETCH_FEATURES_KHR,
-            .pNext = nullptr,
+            .pNext = &opacityMicromapFeatures,
         };
         auto rayQueryFeatures = VkPhysicalDeviceRayQueryFeaturesKHR{
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR,
@@ -63,9 +94,13 @@ PhysicalDevice::PhysicalDevice( VkInstance instance )
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR,
             .pNext = &rayQueryFeatures,
         };
+        auto vulkan12Features = VkPhysicalDeviceVulkan12Features{
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+            .pNext = &rtFeatures,
+        };
         auto deviceFeatures2 = VkPhysicalDeviceFeatures2{
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
-            .pNext = &rtFeatures,
+            .pNext = &vulkan12Features,
         };
         vkGetPhysicalDeviceFeatures2( p, &deviceFeatures2 );
 
@@ -74,8 +109,20 @@ PhysicalDevice::PhysicalDevice( VkInstance instance )
         {
             physDevice = p;
 
-            supportsRayQuery      = rayQueryFeatures.rayQuery;
-            supportsPositionFetch = positionFetchFeatures.rayTracingPositionFetch;
+            supportsRayQuery        = rayQueryFeatures.rayQuery;
+            supportsPositionFetch   = positionFetchFeatures.rayTracingPositionFetch;
+            supportsOpacityMicromap = opacityMicromapFeatures.micromap;
+            supportsInvocationReorder =
+                invocationReorderFeatures.rayTracingInvocationReorder;
+            supportsPresentId = presentIdFeatures.presentId;
+            supportsPresentWait = presentWaitFeatures.presentWait;
+            supportsUpdateAfterBind =
+                vulkan12Features.descriptorBindingPartiallyBound &&
+                vulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+                vulkan12Features.descriptorBindingUpdateUnusedWhilePending;
+#ifdef VK_AMD_anti_lag
+            supportsAntiLag = antiLagFeatures.antiLag;
+#endif
 
             asProperties = VkPhysicalDeviceAccelerationStructurePropertiesKHR{
                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR
@@ -84,14 +131,25 @@ PhysicalDevice::PhysicalDevice( VkInstance instance )
                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_PROPERTIES_KHR,
                 .pNext = &asProperties,
             };
+            auto memoryDecompressionProperties = VkPhysicalDeviceMemoryDecompressionPropertiesNV{
+                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_DECOMPRESSION_PROPERTIES_NV,
+                .pNext = &rtPipelineProperties,
+            };
             auto deviceProp2 = VkPhysicalDeviceProperties2{
                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
-                .pNext = &rtPipelineProperties,
+                .pNext = memoryDecompressionFeatures.memoryDecompression
+                             ? static_cast< void* >( &memoryDecompressionProperties )
+                             : static_cast< void* >( &rtPipelineProperties ),
             };
 
             vkGetPhysicalDeviceProperties2( physDevice, &deviceProp2 );
             vkGetPhysicalDeviceMemoryProperties( physDevice, &memoryProperties );
 
+            // only GDeflate streams are produced for the assets
+            supportsMemoryDecompression = memoryDecompressionFeatures.memoryDecompression &&
+                                          ( memoryDecompressionProperties.decompressionMethods &
+                                            VK_MEMORY_DECOMPRESSION_METHOD_GDEFLATE_1_0_BIT_NV );
+
             break;
         }
     }
@@ -113,7 +171,13 @@ auto PhysicalDevice::GetMemoryTypeIndex( uint32_t memoryTypeBits, VkFlags requir
 {
     VkMemoryPropertyFlags flagsToIgnore = 0;
 
-    if( requirementsMask & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
+    if( ( requirementsMask & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT ) &&
+        ( requirementsMask & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ) )
+    {
+        // explicitly requested CPU-writable VRAM
+        flagsToIgnore = 0;
+    }
+    else if( requirementsMask & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT )
     {
         // device-local memory must not be host visible
         flagsToIgnore = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
@@ -134,7 +198,8 @@ auto PhysicalDevice::GetMemoryTypeIndex( uint32_t memoryTypeBits, VkFlags requir
             VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[ i ].propertyFlags;
 
             bool                  isSuitable = ( flags & requirementsMask ) == requirementsMask;
-            bool                  isIgnored  = ( flags & flagsToIgnore ) == flagsToIgnore;
+            bool                  isIgnored =
+                flagsToIgnore != 0 && ( flags & flagsToIgnore ) == flagsToIgnore;
 
             if( isSuitable && !isIgnored )
             {
@@ -49,6 +49,14 @@ public:
 
     bool SupportsRayQuery() const { return supportsRayQuery; }
     bool SupportsPositionFetch() const { return supportsPositionFetch; }
+    bool SupportsOpacityMicromap() const { return supportsOpacityMicromap; }
+    bool SupportsInvocationReorder() const { return supportsInvocationReorder; }
+    bool SupportsPresentId() const { return supportsPresentId; }
+    bool SupportsPresentWait() const { return supportsPresentWait; }
+    bool SupportsAntiLag() const { return supportsAntiLag; }
+    bool SupportsMemoryDecompression() const { return supportsMemoryDecompression; }
+    // Partially bound sampled image arrays, that can be updated after binding
+    bool SupportsUpdateAfterBind() const { return supportsUpdateAfterBind; }
 
 private:
     // selected physical device
@@ -59,6 +67,13 @@ private:
 
     bool supportsRayQuery{ false };
     bool supportsPositionFetch{ false };
+    bool supportsOpacityMicromap{ false };
+    bool supportsInvocationReorder{ false };
+    bool supportsPresentId{ false };
+    bool supportsPresentWait{ false };
+    bool supportsAntiLag{ false };
+    bool supportsMemoryDecompression{ false };
+    bool supportsUpdateAfterBind{ false };
 };
 
 }
\ No newline at end of file
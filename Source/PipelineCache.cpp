@@ -0,0 +1,202 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "PipelineCache.h"
+
+#include "RgException.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+
+constexpr char     CACHE_MAGIC[ 4 ] = { 'R', 'G', 'P', 'C' };
+constexpr uint32_t CACHE_VERSION    = 1;
+
+struct FileHeader
+{
+    char     magic[ 4 ];
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t  pipelineCacheUUID[ VK_UUID_SIZE ];
+    uint64_t dataSize;
+};
+
+}
+
+RTGL1::PipelineCache::PipelineCache( VkDevice              _device,
+                                     const PhysicalDevice& _physDevice,
+                                     std::filesystem::path _filePath )
+    : device{ _device }, filePath{ std::move( _filePath ) }
+{
+    {
+        VkPhysicalDeviceProperties props = {};
+        vkGetPhysicalDeviceProperties( _physDevice.Get(), &props );
+
+        vendorID      = props.vendorID;
+        deviceID      = props.deviceID;
+        driverVersion = props.driverVersion;
+
+        static_assert( sizeof( pipelineCacheUUID ) == sizeof( props.pipelineCacheUUID ) );
+        memcpy( pipelineCacheUUID, props.pipelineCacheUUID, sizeof( pipelineCacheUUID ) );
+    }
+
+    const auto initialData = LoadFile();
+
+    VkPipelineCacheCreateInfo info = {
+        .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = initialData.size(),
+        .pInitialData    = initialData.empty() ? nullptr : initialData.data(),
+    };
+
+    VkResult r = vkCreatePipelineCache( device, &info, nullptr, &cache );
+    if( r != VK_SUCCESS && !initialData.empty() )
+    {
+        debug::Warning( "Pipeline cache was rejected by the driver: {}", filePath.string() );
+
+        info.initialDataSize = 0;
+        info.pInitialData    = nullptr;
+
+        r = vkCreatePipelineCache( device, &info, nullptr, &cache );
+    }
+    VK_CHECKERROR( r );
+
+    SET_DEBUG_NAME( device, cache, VK_OBJECT_TYPE_PIPELINE_CACHE, "Shared pipeline cache" );
+}
+
+RTGL1::PipelineCache::~PipelineCache()
+{
+    vkDestroyPipelineCache( device, cache, nullptr );
+}
+
+auto RTGL1::PipelineCache::LoadFile() const -> std::vector< uint8_t >
+{
+    if( filePath.empty() )
+    {
+        return {};
+    }
+
+    auto f = std::ifstream( filePath, std::ios::binary );
+    if( !f )
+    {
+        return {};
+    }
+
+    auto header = FileHeader{};
+    f.read( reinterpret_cast< char* >( &header ), sizeof( header ) );
+
+    if( !f || memcmp( header.magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) ) != 0 ||
+        header.version != CACHE_VERSION || header.vendorID != vendorID ||
+        header.deviceID != deviceID || header.driverVersion != driverVersion ||
+        memcmp( header.pipelineCacheUUID, pipelineCacheUUID, sizeof( pipelineCacheUUID ) ) != 0 ||
+        header.dataSize < sizeof( VkPipelineCacheHeaderVersionOne ) )
+    {
+        debug::Info( "Pipeline cache is outdated: {}", filePath.string() );
+        return {};
+    }
+
+    auto data = std::vector< uint8_t >( header.dataSize );
+    f.read( reinterpret_cast< char* >( data.data() ),
+            static_cast< std::streamsize >( data.size() ) );
+    if( !f )
+    {
+        return {};
+    }
+
+    // the driver must validate the data itself, but don't rely on that
+    auto vkHeader = VkPipelineCacheHeaderVersionOne{};
+    memcpy( &vkHeader, data.data(), sizeof( vkHeader ) );
+
+    if( vkHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        vkHeader.vendorID != vendorID || vkHeader.deviceID != deviceID ||
+        memcmp( vkHeader.pipelineCacheUUID, pipelineCacheUUID, sizeof( pipelineCacheUUID ) ) != 0 )
+    {
+        debug::Info( "Pipeline cache is outdated: {}", filePath.string() );
+        return {};
+    }
+
+    debug::Info( "Loaded pipeline cache: {}", filePath.string() );
+    return data;
+}
+
+void RTGL1::PipelineCache::Save() const
+{
+    if( filePath.empty() )
+    {
+        return;
+    }
+
+    size_t   dataSize = 0;
+    VkResult r        = vkGetPipelineCacheData( device, cache, &dataSize, nullptr );
+    if( r != VK_SUCCESS || dataSize == 0 )
+    {
+        return;
+    }
+
+    auto data = std::vector< uint8_t >( dataSize );
+    r         = vkGetPipelineCacheData( device, cache, &dataSize, data.data() );
+    if( r != VK_SUCCESS )
+    {
+        debug::Warning( "Pipeline cache was not saved: can't get the data" );
+        return;
+    }
+
+    auto header = FileHeader{
+        .version       = CACHE_VERSION,
+        .vendorID      = vendorID,
+        .deviceID      = deviceID,
+        .driverVersion = driverVersion,
+        .dataSize      = dataSize,
+    };
+    memcpy( header.magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) );
+    memcpy( header.pipelineCacheUUID, pipelineCacheUUID, sizeof( pipelineCacheUUID ) );
+
+    // write to a temporary file, so an interrupted write doesn't leave a broken cache
+    const auto tmpPath = std::filesystem::path( filePath ).concat( ".tmp" );
+    {
+        auto f = std::ofstream( tmpPath, std::ios::binary | std::ios::trunc );
+        if( f )
+        {
+            f.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+            f.write( reinterpret_cast< const char* >( data.data() ),
+                     static_cast< std::streamsize >( dataSize ) );
+        }
+
+        if( !f )
+        {
+            debug::Warning( "Can't write pipeline cache: {}", filePath.string() );
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename( tmpPath, filePath, ec );
+    if( ec )
+    {
+        std::filesystem::remove( tmpPath, ec );
+        debug::Warning( "Can't write pipeline cache: {}", filePath.string() );
+        return;
+    }
+
+    debug::Verbose( "Saved pipeline cache: {}", filePath.string() );
+}
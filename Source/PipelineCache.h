@@ -0,0 +1,63 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "PhysicalDevice.h"
+
+#include <filesystem>
+
+namespace RTGL1
+{
+
+// Driver pipeline cache shared by all pipelines, persisted between launches.
+// File is rejected, if it was made by another device or driver version
+class PipelineCache
+{
+public:
+    PipelineCache( VkDevice              device,
+                   const PhysicalDevice& physDevice,
+                   std::filesystem::path filePath );
+    ~PipelineCache();
+
+    PipelineCache( const PipelineCache& other )                = delete;
+    PipelineCache( PipelineCache&& other ) noexcept            = delete;
+    PipelineCache& operator=( const PipelineCache& other )     = delete;
+    PipelineCache& operator=( PipelineCache&& other ) noexcept = delete;
+
+    VkPipelineCache Get() const { return cache; }
+
+    void Save() const;
+
+private:
+    auto LoadFile() const -> std::vector< uint8_t >;
+
+private:
+    VkDevice              device;
+    std::filesystem::path filePath;
+    VkPipelineCache       cache{ VK_NULL_HANDLE };
+
+    uint32_t vendorID{ 0 };
+    uint32_t deviceID{ 0 };
+    uint32_t driverVersion{ 0 };
+    uint8_t  pipelineCacheUUID[ VK_UUID_SIZE ]{};
+};
+
+}
@@ -52,14 +52,22 @@ VkQueue Queues::GetTransfer() const
     return transfer;
 }
 
-Queues::Queues( VkPhysicalDevice physDevice, VkSurfaceKHR surface )
+VkQueue Queues::GetAsyncCompute() const
+{
+    return asyncCompute;
+}
+
+Queues::Queues( VkPhysicalDevice physDevice, VkSurfaceKHR surface, bool requestAsyncCompute )
     : defaultQueuePriority( 0 )
+    , graphicsQueuePriorities{ 0, 0 }
     , indexGraphics( UINT32_MAX )
     , indexCompute( UINT32_MAX )
     , indexTransfer( UINT32_MAX )
+    , hasAsyncCompute( false )
     , graphics( VK_NULL_HANDLE )
     , compute( VK_NULL_HANDLE )
     , transfer( VK_NULL_HANDLE )
+    , asyncCompute( VK_NULL_HANDLE )
 {
     uint32_t queueFamilyCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties( physDevice, &queueFamilyCount, nullptr );
@@ -73,10 +81,14 @@ Queues::Queues( VkPhysicalDevice physDevice, VkSurfaceKHR surface )
     {
         auto     flags = queueFamilyProperties[ i ].queueFlags;
 
-        VkBool32 presentSupported;
-        VkResult r =
-            vkGetPhysicalDeviceSurfaceSupportKHR( physDevice, i, surface, &presentSupported );
-        VK_CHECKERROR( r );
+        // headless, if no surface: any graphics queue fits
+        VkBool32 presentSupported = VK_TRUE;
+        if( surface != VK_NULL_HANDLE )
+        {
+            VkResult r =
+                vkGetPhysicalDeviceSurfaceSupportKHR( physDevice, i, surface, &presentSupported );
+            VK_CHECKERROR( r );
+        }
 
         if( ( flags & VK_QUEUE_GRAPHICS_BIT ) != 0 && ( flags & VK_QUEUE_COMPUTE_BIT ) != 0 &&
             ( flags & VK_QUEUE_TRANSFER_BIT ) != 0 && presentSupported )
@@ -108,6 +120,9 @@ Queues::Queues( VkPhysicalDevice physDevice, VkSurfaceKHR surface )
     {
         indexTransfer = indexGraphics;
     }
+
+    hasAsyncCompute =
+        requestAsyncCompute && queueFamilyProperties[ indexGraphics ].queueCount > 1;
 }
 
 void Queues::SetDevice( VkDevice device )
@@ -115,6 +130,11 @@ void Queues::SetDevice( VkDevice device )
     vkGetDeviceQueue( device, indexGraphics, 0, &graphics );
     vkGetDeviceQueue( device, indexCompute, 0, &compute );
     vkGetDeviceQueue( device, indexTransfer, 0, &transfer );
+
+    if( hasAsyncCompute )
+    {
+        vkGetDeviceQueue( device, indexGraphics, 1, &asyncCompute );
+    }
 }
 
 std::vector< VkDeviceQueueCreateInfo > Queues::GetDeviceQueueCreateInfos() const
@@ -125,8 +145,8 @@ std::vector< VkDeviceQueueCreateInfo > Queues::GetDeviceQueueCreateInfos() const
         VkDeviceQueueCreateInfo i = {
             .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
             .queueFamilyIndex = indexGraphics,
-            .queueCount       = 1,
-            .pQueuePriorities = &defaultQueuePriority,
+            .queueCount       = hasAsyncCompute ? 2u : 1u,
+            .pQueuePriorities = graphicsQueuePriorities,
         };
 
         infos.push_back( i );
@@ -29,7 +29,9 @@ namespace RTGL1
 class Queues
 {
 public:
-    explicit Queues( VkPhysicalDevice physDevice, VkSurfaceKHR surface );
+    // If requestAsyncCompute, a second queue of the graphics family is created (if available):
+    // it runs concurrently with the graphics one, but doesn't require ownership transfers
+    explicit Queues( VkPhysicalDevice physDevice, VkSurfaceKHR surface, bool requestAsyncCompute );
     ~Queues() = default;
 
     Queues( const Queues& other )                  = delete;
@@ -47,18 +49,23 @@ public:
     VkQueue                                GetGraphics() const;
     VkQueue                                GetCompute() const;
     VkQueue                                GetTransfer() const;
+    // Queue of the graphics family, or null if not available
+    VkQueue                                GetAsyncCompute() const;
 
 private:
     std::vector< VkQueueFamilyProperties > queueFamilyProperties;
     float                                  defaultQueuePriority;
+    float                                  graphicsQueuePriorities[ 2 ];
 
     uint32_t                               indexGraphics;
     uint32_t                               indexCompute;
     uint32_t                               indexTransfer;
+    bool                                   hasAsyncCompute;
 
     VkQueue                                graphics;
     VkQueue                                compute;
     VkQueue                                transfer;
+    VkQueue                                asyncCompute;
 };
 
 }
\ No newline at end of file
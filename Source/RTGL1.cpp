@@ -19,10 +19,15 @@
 // SOFTWARE.
 
 #include "VulkanDevice.h"
+#include "ApiCapture.h"
+#include "CpuProfiler.h"
+#include "RenderThread.h"
 #include "RgException.h"
 
 #include "TextureExporter.h"
 
+#include <cstring>
+
 
 namespace RTGL1::debug::detail
 {
@@ -40,6 +45,12 @@ namespace
 using Device = RTGL1::VulkanDevice;
 std::unique_ptr< Device > g_device{};
 
+std::unique_ptr< RTGL1::ApiCaptureWriter > g_capture{};
+// if not null, the frame calls are recorded, and issued to the device later
+std::unique_ptr< RTGL1::RenderThread > g_renderThread{};
+// to replay captures through the same entry points
+RgInterface g_interface{};
+
 Device* TryGetDevice()
 {
     if( g_device )
@@ -67,6 +78,8 @@ RgResult RGAPI_CALL rgDestroyInstance()
 
     try
     {
+        g_capture.reset();
+        g_renderThread.reset();
         g_device.reset();
     }
     catch( RTGL1::RgException& e )
@@ -83,7 +96,10 @@ RgResult RGAPI_CALL rgDestroyInstance()
     return RG_RESULT_SUCCESS;
 }
 
-template< typename Func, typename Result = std::invoke_result_t< Func, Device& > >
+// WaitRenderThread=false only for the functions that don't touch the state of the render thread
+template< bool WaitRenderThread = true,
+          typename Func,
+          typename Result = std::invoke_result_t< Func, Device& > >
     requires( std::is_default_constructible_v< Result > || std::is_same_v< Result, void > )
 auto Call( Func&& f )
 {
@@ -95,6 +111,12 @@ auto Call( Func&& f )
         Device& dev = GetDevice();
 
         {
+            // the device is accessed directly, so the queued calls must be issued first
+            if( WaitRenderThread && g_renderThread )
+            {
+                g_renderThread->WaitIdle();
+            }
+
             if constexpr( std::is_same_v< Result, void > )
             {
                 f( dev );
@@ -113,62 +135,172 @@ auto Call( Func&& f )
     return WrappedResult{};
 }
 
+// Record the call to issue it on the render thread, if it exists. Otherwise, call immediately
+template< typename Func, typename FuncDeferred >
+RgResult Defer( Func&& f, FuncDeferred&& fDeferred )
+{
+    if( !g_renderThread )
+    {
+        return Call( std::forward< Func >( f ) );
+    }
+
+    try
+    {
+        fDeferred( *g_renderThread );
+    }
+    catch( RTGL1::RgException& e )
+    {
+        RTGL1::debug::Error( e.what() );
+    }
+    return RG_RESULT_SUCCESS;
+}
+
+template< typename Func >
+void Capture( Func&& f )
+{
+    if( g_capture )
+    {
+        f( *g_capture );
+    }
+}
+
 
 
 RgResult RGAPI_CALL rgUploadMeshPrimitive( const RgMeshInfo*          pMesh,
                                            const RgMeshPrimitiveInfo* pPrimitive )
 {
-    return Call( [ & ]( Device& d ) { d.UploadMeshPrimitive( pMesh, pPrimitive ); } );
+    Capture( [ & ]( auto& c ) { c.UploadMeshPrimitive( pMesh, pPrimitive ); } );
+    return Defer( [ & ]( Device& d ) { d.UploadMeshPrimitive( pMesh, pPrimitive ); },
+                  [ & ]( auto& r ) { r.UploadMeshPrimitive( pMesh, pPrimitive ); } );
+}
+
+RgResult RGAPI_CALL rgUploadMeshPrimitives( const RgMeshInfo*          pMesh,
+                                            const RgMeshPrimitiveInfo* pPrimitives,
+                                            uint32_t                   primitiveCount )
+{
+    Capture( [ & ]( auto& c ) {
+        for( uint32_t i = 0; pPrimitives && i < primitiveCount; i++ )
+        {
+            c.UploadMeshPrimitive( pMesh, &pPrimitives[ i ] );
+        }
+    } );
+    return Defer(
+        [ & ]( Device& d ) { d.UploadMeshPrimitives( pMesh, pPrimitives, primitiveCount ); },
+        [ & ]( auto& r ) { r.UploadMeshPrimitives( pMesh, pPrimitives, primitiveCount ); } );
+}
+
+RgNameHandle RGAPI_CALL rgRegisterName( const char* pName )
+{
+    Capture( [ & ]( auto& c ) { c.RegisterName( pName ); } );
+    return Call( [ & ]( Device& d ) { return d.RegisterName( pName ); } );
+}
+
+RgResult RGAPI_CALL rgCreateMesh( const RgMeshInfo*          pMesh,
+                                  const RgMeshPrimitiveInfo* pPrimitives,
+                                  uint32_t                   primitiveCount,
+                                  RgMeshHandle*              pOutMesh )
+{
+    return Call(
+        [ & ]( Device& d ) { d.CreateMesh( pMesh, pPrimitives, primitiveCount, pOutMesh ); } );
+}
+
+RgResult RGAPI_CALL rgUpdateMeshTransform( RgMeshHandle       mesh,
+                                           const RgTransform* pTransform,
+                                           RgMeshInfoFlags    flags )
+{
+    return Defer( [ & ]( Device& d ) { d.UpdateMeshTransform( mesh, pTransform, flags ); },
+                  [ & ]( auto& r ) { r.UpdateMeshTransform( mesh, pTransform, flags ); } );
+}
+
+RgResult RGAPI_CALL rgDestroyMesh( RgMeshHandle mesh )
+{
+    return Defer( [ & ]( Device& d ) { d.DestroyMesh( mesh ); },
+                  [ & ]( auto& r ) { r.DestroyMesh( mesh ); } );
 }
 
 RgResult RGAPI_CALL rgUploadLensFlare( const RgLensFlareInfo* pInfo )
 {
-    return Call( [ & ]( Device& d ) { d.UploadLensFlare( pInfo ); } );
+    return Defer( [ & ]( Device& d ) { d.UploadLensFlare( pInfo ); },
+                  [ & ]( auto& r ) { r.UploadLensFlare( pInfo ); } );
 }
 
 RgResult RGAPI_CALL rgSpawnFluid( const RgSpawnFluidInfo* pInfo )
 {
-    return Call( [ & ]( Device& d ) { d.SpawnFluid( pInfo ); } );
+    return Defer( [ & ]( Device& d ) { d.SpawnFluid( pInfo ); },
+                  [ & ]( auto& r ) { r.SpawnFluid( pInfo ); } );
+}
+
+RgResult RGAPI_CALL rgRequestReadback( const RgReadbackRequestInfo* pInfo )
+{
+    // thread-safe, the request is taken by the next rgDrawFrame
+    return Call< false >( [ & ]( Device& d ) { d.RequestReadback( pInfo ); } );
 }
 
 RgResult RGAPI_CALL rgUploadCamera( const RgCameraInfo* pInfo )
 {
-    return Call( [ & ]( Device& d ) { d.UploadCamera( pInfo ); } );
+    Capture( [ & ]( auto& c ) { c.UploadCamera( pInfo ); } );
+    return Defer( [ & ]( Device& d ) { d.UploadCamera( pInfo ); },
+                  [ & ]( auto& r ) { r.UploadCamera( pInfo ); } );
 }
 
 RgResult RGAPI_CALL rgUploadLight( const RgLightInfo* pInfo )
 {
-    return Call( [ & ]( Device& d ) { d.UploadLight( pInfo ); } );
+    Capture( [ & ]( auto& c ) { c.UploadLight( pInfo ); } );
+    return Defer( [ & ]( Device& d ) { d.UploadLight( pInfo ); },
+                  [ & ]( auto& r ) { r.UploadLight( pInfo ); } );
 }
 
 RgResult RGAPI_CALL rgProvideOriginalTexture( const RgOriginalTextureInfo* pInfo )
 {
-    return Call( [ & ]( Device& d ) { d.ProvideOriginalTexture( pInfo ); } );
+    Capture( [ & ]( auto& c ) { c.ProvideOriginalTexture( pInfo ); } );
+    // the asynchronous variant is thread-safe, and doesn't wait for the render thread
+    if( RTGL1::pnext::find< RgOriginalTextureAsyncEXT >( pInfo ) )
+    {
+        return Call< false >( [ & ]( Device& d ) { d.ProvideOriginalTexture( pInfo ); } );
+    }
+    return Defer( [ & ]( Device& d ) { d.ProvideOriginalTexture( pInfo ); },
+                  [ & ]( auto& r ) { r.ProvideOriginalTexture( pInfo ); } );
 }
 
 RgResult RGAPI_CALL rgMarkOriginalTextureAsDeleted( const char* pTextureName )
 {
-    return Call( [ & ]( Device& d ) { d.MarkOriginalTextureAsDeleted( pTextureName ); } );
+    Capture( [ & ]( auto& c ) { c.MarkOriginalTextureAsDeleted( pTextureName ); } );
+    return Defer( [ & ]( Device& d ) { d.MarkOriginalTextureAsDeleted( pTextureName ); },
+                  [ & ]( auto& r ) { r.MarkOriginalTextureAsDeleted( pTextureName ); } );
 }
 
 RgResult RGAPI_CALL rgStartFrame( const RgStartFrameInfo* pInfo )
 {
-    return Call( [ & ]( Device& d ) { d.StartFrame( pInfo ); } );
+    Capture( [ & ]( auto& c ) { c.StartFrame( pInfo ); } );
+    return Defer( [ & ]( Device& d ) { d.StartFrame( pInfo ); },
+                  [ & ]( auto& r ) { r.StartFrame( pInfo ); } );
 }
 
 RgResult RGAPI_CALL rgDrawFrame( const RgDrawFrameInfo* pInfo )
 {
-    return Call( [ & ]( Device& d ) { d.DrawFrame( pInfo ); } );
+    Capture( [ & ]( auto& c ) { c.DrawFrame( pInfo ); } );
+    return Defer( [ & ]( Device& d ) { d.DrawFrame( pInfo ); },
+                  [ & ]( auto& r ) { r.DrawFrame( pInfo ); } );
 }
 
 RgPrimitiveVertex* RGAPI_CALL rgUtilScratchAllocForVertices( uint32_t vertexCount )
 {
-    return Call( [ & ]( Device& d ) { return d.ScratchAllocForVertices( vertexCount ); } );
+    return Call< false >(
+        [ & ]( Device& d ) { return d.ScratchAllocForVertices( vertexCount ); } );
 }
 
 void RGAPI_CALL rgUtilScratchFree( const RgPrimitiveVertex* pPointer )
 {
-    Call( [ & ]( Device& d ) { d.ScratchFree( pPointer ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchFree( pPointer ); } );
+}
+
+RgPrimitiveVertex* RGAPI_CALL rgUtilStagingAllocForVertices( uint32_t vertexCount )
+{
+    if( g_renderThread )
+    {
+        return g_renderThread->AllocForVertices( vertexCount );
+    }
+    return Call( [ & ]( Device& d ) { return d.StagingAllocForVertices( vertexCount ); } );
 }
 
 void RGAPI_CALL rgUtilScratchGetIndices( RgUtilImScratchTopology topology,
@@ -176,7 +308,7 @@ void RGAPI_CALL rgUtilScratchGetIndices( RgUtilImScratchTopology topology,
                                          const uint32_t**        ppOutIndices,
                                          uint32_t*               pOutIndexCount )
 {
-    Call( [ & ]( Device& d ) {
+    Call< false >( [ & ]( Device& d ) {
         const auto indices = d.ScratchIm().GetIndices( topology, vertexCount );
         *ppOutIndices      = indices.data();
         *pOutIndexCount    = uint32_t( indices.size() );
@@ -185,58 +317,69 @@ void RGAPI_CALL rgUtilScratchGetIndices( RgUtilImScratchTopology topology,
 
 void RGAPI_CALL rgUtilImScratchClear()
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().Clear(); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().Clear(); } );
 }
 
 void RGAPI_CALL rgUtilImScratchStart( RgUtilImScratchTopology topology )
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().StartPrimitive( topology ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().StartPrimitive( topology ); } );
 }
 
 void RGAPI_CALL rgUtilImScratchEnd()
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().EndPrimitive(); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().EndPrimitive(); } );
 }
 
 void RGAPI_CALL rgUtilImScratchVertex( float x, float y, float z )
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().Vertex( x, y, z ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().Vertex( x, y, z ); } );
+}
+
+void RGAPI_CALL rgUtilImScratchVertices( const float*             pPositions,
+                                         const float*             pNormals,
+                                         const float*             pTexCoords,
+                                         const RgColor4DPacked32* pColors,
+                                         uint32_t                 count )
+{
+    Call< false >( [ & ]( Device& d ) {
+        d.ScratchIm().Vertices( pPositions, pNormals, pTexCoords, pColors, count );
+    } );
 }
 
 
 void RGAPI_CALL rgUtilImScratchNormal( float x, float y, float z )
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().Normal( x, y, z ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().Normal( x, y, z ); } );
 }
 
 void RGAPI_CALL rgUtilImScratchTexCoord( float u, float v )
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().TexCoord( u, v ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().TexCoord( u, v ); } );
 }
 
 void RGAPI_CALL rgUtilImScratchTexCoord_Layer1( float u, float v )
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().TexCoord_Layer1( u, v ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().TexCoord_Layer1( u, v ); } );
 }
 
 void RGAPI_CALL rgUtilImScratchTexCoord_Layer2( float u, float v )
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().TexCoord_Layer2( u, v ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().TexCoord_Layer2( u, v ); } );
 }
 
 void RGAPI_CALL rgUtilImScratchTexCoord_Layer3( float u, float v )
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().TexCoord_Layer3( u, v ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().TexCoord_Layer3( u, v ); } );
 }
 
 void RGAPI_CALL rgUtilImScratchColor( RgColor4DPacked32 color )
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().Color( color ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().Color( color ); } );
 }
 
 void RGAPI_CALL rgUtilImScratchSetToPrimitive( RgMeshPrimitiveInfo* pTarget )
 {
-    Call( [ & ]( Device& d ) { d.ScratchIm().SetToPrimitive( pTarget ); } );
+    Call< false >( [ & ]( Device& d ) { d.ScratchIm().SetToPrimitive( pTarget ); } );
 }
 
 RgBool32 RGAPI_CALL rgUtilIsUpscaleTechniqueAvailable( RgRenderUpscaleTechnique technique,
@@ -263,6 +406,41 @@ RgUtilMemoryUsage RGAPI_CALL rgUtilRequestMemoryUsage()
     return Call( [ & ]( Device& d ) { return d.RequestMemoryUsage(); } );
 }
 
+RgUtilFrameTimings RGAPI_CALL rgUtilGetFrameTimings()
+{
+    if( g_renderThread )
+    {
+        return g_renderThread->GetFrameTimings();
+    }
+    return Call( [ & ]( Device& d ) { return d.GetFrameTimings(); } );
+}
+
+RgUtilHeadlessFrame RGAPI_CALL rgUtilGetHeadlessFrame()
+{
+    return Call( [ & ]( Device& d ) { return d.GetHeadlessFrame(); } );
+}
+
+RgResult RGAPI_CALL rgUtilReplayCapture( const char*             pCaptureFilePath,
+                                        PFN_rgUtilReplayOnFrame pfnOnFrame,
+                                        void*                   pUserData )
+{
+    if( !TryGetDevice() )
+    {
+        return RG_RESULT_NOT_INITIALIZED;
+    }
+    if( !pCaptureFilePath )
+    {
+        return RG_RESULT_WRONG_FUNCTION_ARGUMENT;
+    }
+    return RTGL1::ReplayApiCapture( pCaptureFilePath, g_interface, pfnOnFrame, pUserData );
+}
+
+uint32_t RGAPI_CALL rgUtilGetCpuZones( RgUtilCpuZone* pOutZones, uint32_t maxZoneCount )
+{
+    return RTGL1::cpuprofiler::GetLastFrameZones( pOutZones,
+                                                  pOutZones ? maxZoneCount : UINT32_MAX );
+}
+
 const char* RGAPI_CALL rgUtilGetResultDescription( RgResult result )
 {
     return RTGL1::RgException::GetRgResultName( result );
@@ -305,6 +483,12 @@ RGAPI RgResult RGCONV RGAPI_CALL rgCreateInstance( const RgInstanceCreateInfo* p
         return RG_RESULT_WRONG_FUNCTION_ARGUMENT;
     }
 
+    // structs are extended in place, so a header of another version has different layouts
+    if( pInfo->version == nullptr || strcmp( pInfo->version, RG_RTGL_VERSION_API ) != 0 )
+    {
+        return RG_RESULT_WRONG_FUNCTION_ARGUMENT;
+    }
+
     if( TryGetDevice() )
     {
         return RG_RESULT_ALREADY_INITIALIZED;
@@ -362,6 +546,18 @@ RGAPI RgResult RGCONV RGAPI_CALL rgCreateInstance( const RgInstanceCreateInfo* p
             .rgUtilExportAsTGA                 = rgUtilExportAsTGA,
             .rgUtilGetSupportedFeatures        = rgUtilGetSupportedFeatures,
             .rgSpawnFluid                      = rgSpawnFluid,
+            .rgUtilGetFrameTimings             = rgUtilGetFrameTimings,
+            .rgUtilGetCpuZones                 = rgUtilGetCpuZones,
+            .rgRegisterName                    = rgRegisterName,
+            .rgCreateMesh                      = rgCreateMesh,
+            .rgUpdateMeshTransform             = rgUpdateMeshTransform,
+            .rgDestroyMesh                     = rgDestroyMesh,
+            .rgUtilImScratchVertices           = rgUtilImScratchVertices,
+            .rgUtilGetHeadlessFrame            = rgUtilGetHeadlessFrame,
+            .rgUtilReplayCapture               = rgUtilReplayCapture,
+            .rgRequestReadback                 = rgRequestReadback,
+            .rgUploadMeshPrimitives            = rgUploadMeshPrimitives,
+            .rgUtilStagingAllocForVertices     = rgUtilStagingAllocForVertices,
         };
 
         // error if DLL has less functionality, otherwise, warning
@@ -382,9 +578,21 @@ RGAPI RgResult RGCONV RGAPI_CALL rgCreateInstance( const RgInstanceCreateInfo* p
         }
 
         memcpy( pInterface, &interf, std::min( sizeof( RgInterface ), pInfo->sizeOfRgInterface ) );
+        g_interface = interf;
 
         // initialize everything
         g_device = std::make_unique< Device >( pInfo );
+
+        if( pInfo->renderOnSeparateThread || pInfo->deferFrameUploads )
+        {
+            g_renderThread = std::make_unique< RTGL1::RenderThread >(
+                *g_device, pInfo->renderOnSeparateThread );
+        }
+
+        if( pInfo->pApiCaptureFilePath )
+        {
+            g_capture = std::make_unique< RTGL1::ApiCaptureWriter >( pInfo->pApiCaptureFilePath );
+        }
     }
     // TODO: Device must clean all the resources if initialization failed!
     // So for now exceptions must not happen. But if they did, target application must be closed.
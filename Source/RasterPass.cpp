@@ -615,6 +615,8 @@ auto RTGL1::RasterPass::CreateDepthBuffers( uint32_t              width,
                                             MemoryAllocator&      allocator,
                                             CommandBufferManager& cmdManager ) -> DepthBuffer
 {
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_FRAMEBUFFERS };
+
     VkDevice device = allocator.GetDevice();
 
     auto result = DepthBuffer{};
@@ -21,14 +21,18 @@
 #include "RasterizedDataCollector.h"
 
 #include <algorithm>
+#include <tuple>
 
 #include "DrawFrameInfo.h"
 #include "GeomInfoManager.h"
+#include "Matrix.h"
 #include "RgException.h"
 #include "Utils.h"
 
 #include "Generated/ShaderCommonC.h"
 
+#include "ankerl/unordered_dense.h"
+
 std::array< VkVertexInputAttributeDescription, 3 > RTGL1::RasterizedDataCollector::GetVertexLayout()
 {
     return { {
@@ -58,29 +62,210 @@ uint32_t RTGL1::RasterizedDataCollector::GetVertexStride()
     return static_cast< uint32_t >( sizeof( ShVertex ) );
 }
 
+namespace RTGL1
+{
+namespace
+{
+    // Max count of rasterized primitives in a frame, over all GeometryRasterType-s
+    constexpr uint32_t MAX_RASTERIZED_DRAW_COUNT = 16384;
+
+    constexpr uint32_t MIN_RASTERIZED_CAPACITY = 64;
+    // buffers are halved (but not below the initial capacity),
+    // if less than a quarter was used for this count of frames
+    constexpr uint32_t RASTERIZED_SHRINK_FRAME_COUNT = 600;
+
+    std::optional< uint32_t > ChooseCapacity( uint32_t  required,
+                                              uint32_t  capacity,
+                                              uint32_t  minCapacity,
+                                              uint32_t& lowUsageFrames )
+    {
+        if( required > capacity )
+        {
+            lowUsageFrames = 0;
+
+            // with a reserve, so the growth is amortized
+            const uint64_t grown =
+                std::max( uint64_t{ capacity } * 2, uint64_t{ required } + required / 2 );
+            return uint32_t( std::min< uint64_t >( grown, UINT32_MAX ) );
+        }
+
+        if( required < capacity / 4 && capacity / 2 >= minCapacity )
+        {
+            lowUsageFrames++;
+            if( lowUsageFrames >= RASTERIZED_SHRINK_FRAME_COUNT )
+            {
+                lowUsageFrames = 0;
+                return capacity / 2;
+            }
+        }
+        else
+        {
+            lowUsageFrames = 0;
+        }
+
+        return std::nullopt;
+    }
+
+    // Indexed and non-indexed commands share the stride, so the draws of one raster type
+    // are in one contiguous range
+    union IndirectDrawCommand
+    {
+        VkDrawIndexedIndirectCommand indexed;
+        VkDrawIndirectCommand        nonIndexed;
+    };
+}
+}
+
+uint32_t RTGL1::RasterizedDataCollector::GetIndirectDrawStride()
+{
+    return static_cast< uint32_t >( sizeof( IndirectDrawCommand ) );
+}
+
 RTGL1::RasterizedDataCollector::RasterizedDataCollector(
     VkDevice                           _device,
     std::shared_ptr< MemoryAllocator > _allocator,
     std::shared_ptr< TextureManager >  _textureMgr,
-    uint32_t                           _maxVertexCount,
-    uint32_t                           _maxIndexCount )
+    std::shared_ptr< DeletionQueue >   _deletionQueue,
+    uint32_t                           _initialVertexCount,
+    uint32_t                           _initialIndexCount,
+    bool                               _sortDraws )
     : device( _device )
+    , allocator( std::move( _allocator ) )
     , textureMgr( std::move( _textureMgr ) )
+    , deletionQueue( std::move( _deletionQueue ) )
+    , initialVertexCapacity( std::max( _initialVertexCount, MIN_RASTERIZED_CAPACITY ) )
+    , initialIndexCapacity( std::max( _initialIndexCount, MIN_RASTERIZED_CAPACITY ) )
+    , vertexCapacity( 0 )
+    , indexCapacity( 0 )
     , curVertexCount( 0 )
     , curIndexCount( 0 )
+    , curDrawCount( 0 )
+    , overflowVertexCount( 0 )
+    , overflowIndexCount( 0 )
+    , droppedCount( 0 )
+    , vertexLowUsageFrames( 0 )
+    , indexLowUsageFrames( 0 )
+    , lastFrameUsage{}
+    , sortDraws( _sortDraws )
+    , skyGeometryHash( 0 )
+    , firstDraw{}
+    , descPool( VK_NULL_HANDLE )
+    , descSetLayout( VK_NULL_HANDLE )
+    , descSet( VK_NULL_HANDLE )
 {
-    vertexBuffer = std::make_shared< AutoBuffer >( _allocator );
-    indexBuffer  = std::make_shared< AutoBuffer >( _allocator );
+    drawBuffer     = std::make_shared< AutoBuffer >( allocator );
+    indirectBuffer = std::make_shared< AutoBuffer >( allocator );
+
+    CreateGeometryBuffers( initialVertexCapacity, initialIndexCapacity );
+    drawBuffer->Create( MAX_RASTERIZED_DRAW_COUNT * sizeof( ShRasterizedDraw ),
+                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                        "Rasterizer draw buffer" );
+    indirectBuffer->Create( MAX_RASTERIZED_DRAW_COUNT * sizeof( IndirectDrawCommand ),
+                            VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                            "Rasterizer indirect buffer" );
+
+    CreateDescriptors();
+}
 
-    _maxVertexCount = std::max( _maxVertexCount, 64u );
-    _maxIndexCount  = std::max( _maxIndexCount, 64u );
+void RTGL1::RasterizedDataCollector::CreateGeometryBuffers( uint32_t _vertexCapacity,
+                                                            uint32_t _indexCapacity )
+{
+    vertexBuffer = std::make_shared< AutoBuffer >( allocator );
+    indexBuffer  = std::make_shared< AutoBuffer >( allocator );
 
-    vertexBuffer->Create( _maxVertexCount * sizeof( ShVertex ),
+    vertexBuffer->Create( VkDeviceSize{ _vertexCapacity } * sizeof( ShVertex ),
                           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
                           "Rasterizer vertex buffer" );
-    indexBuffer->Create( _maxIndexCount * sizeof( uint32_t ),
+    indexBuffer->Create( VkDeviceSize{ _indexCapacity } * sizeof( uint32_t ),
                          VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
                          "Rasterizer index buffer" );
+
+    vertexCapacity = _vertexCapacity;
+    indexCapacity  = _indexCapacity;
+}
+
+RTGL1::RasterizedDataCollector::~RasterizedDataCollector()
+{
+    vkDestroyDescriptorPool( device, descPool, nullptr );
+    vkDestroyDescriptorSetLayout( device, descSetLayout, nullptr );
+}
+
+void RTGL1::RasterizedDataCollector::CreateDescriptors()
+{
+    {
+        VkDescriptorPoolSize poolSize = {
+            .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+        };
+
+        VkDescriptorPoolCreateInfo poolInfo = {
+            .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets       = 1,
+            .poolSizeCount = 1,
+            .pPoolSizes    = &poolSize,
+        };
+
+        VkResult r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &descPool );
+        VK_CHECKERROR( r );
+
+        SET_DEBUG_NAME(
+            device, descPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Rasterizer draws desc pool" );
+    }
+    {
+        VkDescriptorSetLayoutBinding binding = {
+            .binding         = BINDING_RASTERIZED_DRAWS,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_VERTEX_BIT,
+        };
+
+        VkDescriptorSetLayoutCreateInfo info = {
+            .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .bindingCount = 1,
+            .pBindings    = &binding,
+        };
+
+        VkResult r = vkCreateDescriptorSetLayout( device, &info, nullptr, &descSetLayout );
+        VK_CHECKERROR( r );
+
+        SET_DEBUG_NAME( device,
+                        descSetLayout,
+                        VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+                        "Rasterizer draws desc set layout" );
+    }
+    {
+        VkDescriptorSetAllocateInfo allocInfo = {
+            .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool     = descPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts        = &descSetLayout,
+        };
+
+        VkResult r = vkAllocateDescriptorSets( device, &allocInfo, &descSet );
+        VK_CHECKERROR( r );
+
+        SET_DEBUG_NAME(
+            device, descSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Rasterizer draws desc set" );
+    }
+    {
+        VkDescriptorBufferInfo b = {
+            .buffer = drawBuffer->GetDeviceLocal(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        };
+
+        VkWriteDescriptorSet w = {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_RASTERIZED_DRAWS,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &b,
+        };
+
+        vkUpdateDescriptorSets( device, 1, &w, 0, nullptr );
+    }
 }
 
 namespace RTGL1
@@ -176,13 +361,33 @@ namespace
 
     bool IndicesExist( const RgMeshPrimitiveInfo& info )
     {
-        return info.indexCount > 0 && info.pIndices != nullptr;
+        return Utils::HasIndices( info );
     }
     void CopyIndices( const RgMeshPrimitiveInfo& info, uint32_t* dstIndices )
     {
         assert( IndicesExist( info ) && dstIndices );
+        if( info.pIndices16 )
+        {
+            // rasterizer's index buffer is 32-bit, widen
+            std::copy_n( info.pIndices16, info.indexCount, dstIndices );
+            return;
+        }
         memcpy( dstIndices, info.pIndices, info.indexCount * sizeof( uint32_t ) );
     }
+
+    uint64_t HashGeometry( const RgMeshPrimitiveInfo& info )
+    {
+        using ankerl::unordered_dense::detail::wyhash::hash;
+
+        uint64_t h = hash( info.pVertices, sizeof( RgPrimitiveVertex ) * info.vertexCount );
+
+        if( IndicesExist( info ) )
+        {
+            h ^= info.pIndices16 ? hash( info.pIndices16, sizeof( uint16_t ) * info.indexCount )
+                                 : hash( info.pIndices, sizeof( uint32_t ) * info.indexCount );
+        }
+        return h;
+    }
 }
 }
 
@@ -195,22 +400,21 @@ void RTGL1::RasterizedDataCollector::AddPrimitive( uint32_t                   fr
 {
     assert( info.vertexCount > 0 && info.pVertices != nullptr );
 
-    if( curVertexCount + info.vertexCount >= vertexBuffer->GetSize() / sizeof( ShVertex ) )
+    if( curDrawCount >= MAX_RASTERIZED_DRAW_COUNT )
     {
-        assert( 0 && "Increase the size of \"rasterizedMaxVertexCount\". Vertex buffer size "
-                     "reached the limit." );
+        assert( 0 && "Rasterized draw count reached the limit" );
+        droppedCount++;
         return;
     }
 
-    if( IndicesExist( info ) )
+    // skipped only for this frame, the buffers grow on the next Clear
+    if( uint64_t{ curVertexCount } + info.vertexCount > vertexCapacity ||
+        ( IndicesExist( info ) && uint64_t{ curIndexCount } + info.indexCount > indexCapacity ) )
     {
-        if( curIndexCount + info.indexCount >= indexBuffer->GetSize() / sizeof( uint32_t ) )
-        {
-            assert( 0 &&
-                    "Increase the size of \"rasterizedMaxIndexCount\". Index buffer size reached "
-                    "the limit." );
-            return;
-        }
+        overflowVertexCount += info.vertexCount;
+        overflowIndexCount += IndicesExist( info ) ? info.indexCount : 0;
+        droppedCount++;
+        return;
     }
 
 
@@ -289,8 +493,16 @@ void RTGL1::RasterizedDataCollector::AddPrimitive( uint32_t                   fr
         .pipelineState = ToPipelineState( rasterType, info ),
     } );
 
-    curVertexCount += info.vertexCount;
-    curIndexCount += info.indexCount;
+    curVertexCount += vertexCount;
+    curIndexCount += indexCount;
+    curDrawCount++;
+
+    if( rasterType == GeometryRasterType::SKY )
+    {
+        // order-dependent, as the draw order matters
+        skyGeometryHash =
+            skyGeometryHash * 0x100000001b3ull ^ ( HashGeometry( info ) + vertexCount );
+    }
 }
 
 void RTGL1::RasterizedDataCollector::Clear( uint32_t frameIndex )
@@ -300,14 +512,157 @@ void RTGL1::RasterizedDataCollector::Clear( uint32_t frameIndex )
         is.clear();
     }
 
-    curVertexCount = 0;
-    curIndexCount  = 0;
+    lastFrameUsage = Usage{
+        .vertexCount    = curVertexCount + overflowVertexCount,
+        .vertexCapacity = vertexCapacity,
+        .indexCount     = curIndexCount + overflowIndexCount,
+        .indexCapacity  = indexCapacity,
+        .droppedCount   = droppedCount,
+    };
+
+    ResizeGeometryBuffers( frameIndex );
+
+    curVertexCount      = 0;
+    curIndexCount       = 0;
+    curDrawCount        = 0;
+    overflowVertexCount = 0;
+    overflowIndexCount  = 0;
+    droppedCount        = 0;
+    skyGeometryHash     = 0;
+}
+
+void RTGL1::RasterizedDataCollector::ResizeGeometryBuffers( uint32_t frameIndex )
+{
+    const auto newVertexCapacity = ChooseCapacity(
+        lastFrameUsage.vertexCount, vertexCapacity, initialVertexCapacity, vertexLowUsageFrames );
+    const auto newIndexCapacity  = ChooseCapacity(
+        lastFrameUsage.indexCount, indexCapacity, initialIndexCapacity, indexLowUsageFrames );
+
+    if( !newVertexCapacity && !newIndexCapacity )
+    {
+        return;
+    }
+
+    debug::Verbose( "Resizing rasterizer buffers: {} -> {} vertices, {} -> {} indices",
+                    vertexCapacity,
+                    newVertexCapacity.value_or( vertexCapacity ),
+                    indexCapacity,
+                    newIndexCapacity.value_or( indexCapacity ) );
+
+    // the previous frames might still read from the old buffers
+    deletionQueue->Push(
+        frameIndex, [ v = std::move( vertexBuffer ), i = std::move( indexBuffer ) ]() mutable {
+            v.reset();
+            i.reset();
+        } );
+
+    CreateGeometryBuffers( newVertexCapacity.value_or( vertexCapacity ),
+                           newIndexCapacity.value_or( indexCapacity ) );
+}
+
+uint64_t RTGL1::RasterizedDataCollector::GetSkyGeometryHash() const
+{
+    return skyGeometryHash;
+}
+
+void RTGL1::RasterizedDataCollector::SortDrawInfos()
+{
+    auto l_isOpaque = []( const DrawInfo& d ) {
+        return !( d.pipelineState & PipelineStateFlagBits::TRANSLUCENT );
+    };
+    auto l_byStateAndMaterial = []( const DrawInfo& a, const DrawInfo& b ) {
+        return std::tie( a.pipelineState, a.texture_base, a.texture_base_E, a.texture_base_N ) <
+               std::tie( b.pipelineState, b.texture_base, b.texture_base_E, b.texture_base_N );
+    };
+
+    // draw order of sky, swapchain and decal (alpha-blended) geometry is defined by a user;
+    // translucent world geometry must be drawn after opaque, in the order of submission
+    for( auto t : { GeometryRasterType::WORLD, GeometryRasterType::WORLD_CLASSIC } )
+    {
+        auto& infos = rasterDrawInfos[ static_cast< int >( t ) ];
+
+        auto firstTranslucent = std::stable_partition( infos.begin(), infos.end(), l_isOpaque );
+        std::stable_sort( infos.begin(), firstTranslucent, l_byStateAndMaterial );
+    }
+}
+
+void RTGL1::RasterizedDataCollector::WriteDraws( uint32_t frameIndex )
+{
+    auto* dstDraws = drawBuffer->GetMappedAs< ShRasterizedDraw* >( frameIndex );
+    auto* dstCmds  = indirectBuffer->GetMappedAs< IndirectDrawCommand* >( frameIndex );
+
+    uint32_t drawIndex = 0;
+
+    for( size_t t = 0; t < GeometryRasterType_Count; t++ )
+    {
+        firstDraw[ t ] = drawIndex;
+
+        for( const DrawInfo& info : rasterDrawInfos[ t ] )
+        {
+            assert( drawIndex < MAX_RASTERIZED_DRAW_COUNT );
+
+            ShRasterizedDraw& dst = dstDraws[ drawIndex ];
+            {
+                if( info.viewProj )
+                {
+                    float model[ 16 ];
+                    Matrix::ToMat4Transposed( model, info.transform );
+                    Matrix::Multiply( dst.transform, model, info.viewProj->Get() );
+                }
+                else
+                {
+                    Matrix::ToMat4Transposed( dst.transform, info.transform );
+                }
+
+                dst.packedColor          = info.colorFactor_base;
+                dst.textureIndex         = info.texture_base;
+                dst.emissiveTextureIndex = info.texture_base_E;
+                dst.emissiveMult         = info.emissive;
+                dst.normalTextureIndex   = info.texture_base_N;
+                dst.transformIsViewProj  = info.viewProj ? 1 : 0;
+            }
+
+            IndirectDrawCommand& cmd = dstCmds[ drawIndex ];
+            if( info.indexCount > 0 )
+            {
+                cmd.indexed = VkDrawIndexedIndirectCommand{
+                    .indexCount    = info.indexCount,
+                    .instanceCount = 1,
+                    .firstIndex    = info.firstIndex,
+                    .vertexOffset  = int32_t( info.firstVertex ),
+                    .firstInstance = drawIndex,
+                };
+            }
+            else
+            {
+                cmd.nonIndexed = VkDrawIndirectCommand{
+                    .vertexCount   = info.vertexCount,
+                    .instanceCount = 1,
+                    .firstVertex   = info.firstVertex,
+                    .firstInstance = drawIndex,
+                };
+            }
+
+            drawIndex++;
+        }
+    }
+
+    assert( drawIndex == curDrawCount );
 }
 
 void RTGL1::RasterizedDataCollector::CopyFromStaging( VkCommandBuffer cmd, uint32_t frameIndex )
 {
+    if( sortDraws )
+    {
+        SortDrawInfos();
+    }
+    WriteDraws( frameIndex );
+
     vertexBuffer->CopyFromStaging( cmd, frameIndex, sizeof( ShVertex ) * curVertexCount );
     indexBuffer->CopyFromStaging( cmd, frameIndex, sizeof( uint32_t ) * curIndexCount );
+    drawBuffer->CopyFromStaging( cmd, frameIndex, sizeof( ShRasterizedDraw ) * curDrawCount );
+    indirectBuffer->CopyFromStaging(
+        cmd, frameIndex, sizeof( IndirectDrawCommand ) * curDrawCount );
 }
 
 VkBuffer RTGL1::RasterizedDataCollector::GetVertexBuffer() const
@@ -319,3 +674,23 @@ VkBuffer RTGL1::RasterizedDataCollector::GetIndexBuffer() const
 {
     return indexBuffer->GetDeviceLocal();
 }
+
+VkBuffer RTGL1::RasterizedDataCollector::GetIndirectBuffer() const
+{
+    return indirectBuffer->GetDeviceLocal();
+}
+
+VkDeviceSize RTGL1::RasterizedDataCollector::GetIndirectDrawOffset( GeometryRasterType t ) const
+{
+    return VkDeviceSize{ firstDraw[ static_cast< int >( t ) ] } * GetIndirectDrawStride();
+}
+
+VkDescriptorSetLayout RTGL1::RasterizedDataCollector::GetDrawsDescSetLayout() const
+{
+    return descSetLayout;
+}
+
+VkDescriptorSet RTGL1::RasterizedDataCollector::GetDrawsDescSet() const
+{
+    return descSet;
+}
@@ -26,6 +26,7 @@
 
 #include "AutoBuffer.h"
 #include "Common.h"
+#include "DeletionQueue.h"
 #include "TextureManager.h"
 #include "Utils.h"
 
@@ -108,12 +109,27 @@ public:
     };
 
 public:
+    struct Usage
+    {
+        // requested in a frame, including the dropped primitives
+        uint32_t vertexCount;
+        uint32_t vertexCapacity;
+        uint32_t indexCount;
+        uint32_t indexCapacity;
+        // primitives that didn't fit into the buffers
+        uint32_t droppedCount;
+    };
+
+public:
+    // Vertex and index buffers are created with the initial capacities, and grow on demand
     explicit RasterizedDataCollector( VkDevice                           device,
                                       std::shared_ptr< MemoryAllocator > allocator,
                                       std::shared_ptr< TextureManager >  textureMgr,
-                                      uint32_t                           maxVertexCount,
-                                      uint32_t                           maxIndexCount );
-    ~RasterizedDataCollector() = default;
+                                      std::shared_ptr< DeletionQueue >   deletionQueue,
+                                      uint32_t                           initialVertexCount,
+                                      uint32_t                           initialIndexCount,
+                                      bool                               sortDraws );
+    ~RasterizedDataCollector();
 
     RasterizedDataCollector( const RasterizedDataCollector& other )     = delete;
     RasterizedDataCollector( RasterizedDataCollector&& other ) noexcept = delete;
@@ -127,30 +143,79 @@ public:
                                            const float*               pViewProjection,
                                            const RgViewport*          pViewport );
 
+    // Frame boundary: if the last frame didn't fit, the buffers are reallocated
     void                     Clear( uint32_t frameIndex );
 
+    // Must be called after all primitives are added. If 'sortDraws', opaque world draws
+    // are grouped by pipeline state and material. Then per-draw data and indirect
+    // commands are uploaded
     void                     CopyFromStaging( VkCommandBuffer cmd, uint32_t frameIndex );
 
     [[nodiscard]] VkBuffer   GetVertexBuffer() const;
     [[nodiscard]] VkBuffer   GetIndexBuffer() const;
 
+    // Indirect command of GetDrawInfos(t)[i] is at GetIndirectDrawOffset(t) + i * stride.
+    // Its firstInstance is the index of ShRasterizedDraw in the draws desc set
+    [[nodiscard]] VkBuffer     GetIndirectBuffer() const;
+    [[nodiscard]] VkDeviceSize GetIndirectDrawOffset( GeometryRasterType t ) const;
+    static uint32_t            GetIndirectDrawStride();
+
+    [[nodiscard]] VkDescriptorSetLayout GetDrawsDescSetLayout() const;
+    [[nodiscard]] VkDescriptorSet       GetDrawsDescSet() const;
+
     static uint32_t          GetVertexStride();
     static std::array< VkVertexInputAttributeDescription, 3 > GetVertexLayout();
 
+    // Hash of vertex and index data of all SKY primitives added since Clear
+    [[nodiscard]] uint64_t   GetSkyGeometryHash() const;
+    // Of the frame before the last Clear
+    [[nodiscard]] Usage      GetLastFrameUsage() const { return lastFrameUsage; }
+
     std::span< const DrawInfo > GetDrawInfos( GeometryRasterType t ) const
     {
         return rasterDrawInfos[ static_cast< int >( t ) ];
     }
 
 private:
-    VkDevice                          device;
-    std::shared_ptr< TextureManager > textureMgr;
+    void SortDrawInfos();
+    void WriteDraws( uint32_t frameIndex );
+    void CreateDescriptors();
+    void CreateGeometryBuffers( uint32_t vertexCapacity, uint32_t indexCapacity );
+    void ResizeGeometryBuffers( uint32_t frameIndex );
+
+private:
+    VkDevice                           device;
+    std::shared_ptr< MemoryAllocator > allocator;
+    std::shared_ptr< TextureManager >  textureMgr;
+    std::shared_ptr< DeletionQueue >   deletionQueue;
 
     std::shared_ptr< AutoBuffer >     vertexBuffer;
     std::shared_ptr< AutoBuffer >     indexBuffer;
+    std::shared_ptr< AutoBuffer >     drawBuffer;
+    std::shared_ptr< AutoBuffer >     indirectBuffer;
 
+    uint32_t                          initialVertexCapacity;
+    uint32_t                          initialIndexCapacity;
+    uint32_t                          vertexCapacity;
+    uint32_t                          indexCapacity;
     uint32_t                          curVertexCount;
     uint32_t                          curIndexCount;
+    uint32_t                          curDrawCount;
+    // what didn't fit in the current frame, to grow to the required size
+    uint32_t                          overflowVertexCount;
+    uint32_t                          overflowIndexCount;
+    uint32_t                          droppedCount;
+    uint32_t                          vertexLowUsageFrames;
+    uint32_t                          indexLowUsageFrames;
+    Usage                             lastFrameUsage;
+    bool                              sortDraws;
+    uint64_t                          skyGeometryHash;
+
+    uint32_t                          firstDraw[ GeometryRasterType_Count ];
+
+    VkDescriptorPool                  descPool;
+    VkDescriptorSetLayout             descSetLayout;
+    VkDescriptorSet                   descSet;
 
     std::vector< DrawInfo > rasterDrawInfos[ GeometryRasterType_Count ];
 };
@@ -20,50 +20,36 @@
 
 #include "Rasterizer.h"
 
+#include <algorithm>
+#include <future>
+#include <thread>
+
 #include "Swapchain.h"
 #include "Matrix.h"
 #include "Utils.h"
 #include "CmdLabel.h"
 #include "RenderResolutionHelper.h"
+#include "LibraryConfig.h"
 
 namespace
 {
 
-// A duplicate of GLSL's RasterizerFrag_BT
+// A duplicate of GLSL's RasterizerVert_BT and RasterizerFrag_BT.
+// Per-draw data is in ShRasterizedDraw, so it's pushed once per pass
 struct RasterizedPushConst
 {
-    float    vp[ 16 ];
-    uint32_t packedColor;
-    uint32_t textureIndex;
-    uint32_t emissiveTextureIndex;
-    float    emissiveMult;
-    uint32_t normalTextureIndex;
+    float    viewProj[ 16 ];
     uint32_t manualSrgb;
-
-    explicit RasterizedPushConst( const RTGL1::RasterizedDataCollector::DrawInfo& info,
-                                  const float*                                    defaultViewProj,
-                                  bool                                            _manualSrgb )
-        : vp{}
-        , packedColor{ info.colorFactor_base }
-        , textureIndex( info.texture_base )
-        , emissiveTextureIndex( info.texture_base_E )
-        , emissiveMult( info.emissive )
-        , normalTextureIndex( info.texture_base_N )
-        , manualSrgb( _manualSrgb )
-    {
-        float model[ 16 ] = RG_MATRIX_TRANSPOSED( info.transform );
-        RTGL1::Matrix::Multiply(
-            vp, model, info.viewProj ? info.viewProj->Get() : defaultViewProj );
-    }
 };
 
-static_assert( offsetof( RasterizedPushConst, vp ) == 0 );
-static_assert( offsetof( RasterizedPushConst, packedColor ) == 64 );
-static_assert( offsetof( RasterizedPushConst, textureIndex ) == 68 );
-static_assert( offsetof( RasterizedPushConst, emissiveTextureIndex ) == 72 );
-static_assert( offsetof( RasterizedPushConst, emissiveMult ) == 76 );
-static_assert( offsetof( RasterizedPushConst, normalTextureIndex ) == 80 );
-static_assert( sizeof( RasterizedPushConst ) == 88 );
+static_assert( offsetof( RasterizedPushConst, viewProj ) == 0 );
+static_assert( offsetof( RasterizedPushConst, manualSrgb ) == 64 );
+static_assert( sizeof( RasterizedPushConst ) == 68 );
+
+// Must be same as DESC_SET_RASTERIZED_DRAWS in the vertex shaders
+constexpr uint32_t RASTER_PASS_DRAWS_DESC_SET_INDEX    = 4;
+constexpr uint32_t SWAPCHAIN_PASS_DRAWS_DESC_SET_INDEX = 1;
+constexpr uint32_t DECAL_DRAWS_DESC_SET_INDEX          = 3;
 
 VkPipelineLayout CreatePipelineLayout( VkDevice                           device,
                                        std::span< VkDescriptorSetLayout > descs,
@@ -104,34 +90,45 @@ RTGL1::Rasterizer::Rasterizer( VkDevice                                _device,
                                std::shared_ptr< MemoryAllocator >      _allocator,
                                std::shared_ptr< Framebuffers >         _storageFramebuffers,
                                std::shared_ptr< CommandBufferManager > _cmdManager,
+                               std::shared_ptr< DeletionQueue >        _deletionQueue,
                                const RgInstanceCreateInfo&             _instanceInfo )
     : device( _device )
     , rasterPassPipelineLayout( VK_NULL_HANDLE )
     , swapchainPassPipelineLayout( VK_NULL_HANDLE )
     , allocator( std::move( _allocator ) )
     , cmdManager( std::move( _cmdManager ) )
+    , deletionQueue( std::move( _deletionQueue ) )
     , storageFramebuffers( std::move( _storageFramebuffers ) )
+    , shaderManager( &_shaderManager )
+    , uniform( &_uniform )
+    , rasterizedVertexColorGamma( _instanceInfo.rasterizedVertexColorGamma )
 {
     collector =
         std::make_shared< RasterizedDataCollector >( device,
                                                      allocator,
                                                      _textureManager,
+                                                     deletionQueue,
                                                      _instanceInfo.rasterizedMaxVertexCount,
-                                                     _instanceInfo.rasterizedMaxIndexCount );
+                                                     _instanceInfo.rasterizedMaxIndexCount,
+                                                     _instanceInfo.rasterizedSortDraws );
     {
         VkDescriptorSetLayout ls[] = {
             _textureManager->GetDescSetLayout(),
             _uniform.GetDescSetLayout(),
             _tonemapping.GetDescSetLayout(),
             _volumetric.GetDescSetLayout(),
+            collector->GetDrawsDescSetLayout(),
         };
+        static_assert( std::size( ls ) == RASTER_PASS_DRAWS_DESC_SET_INDEX + 1 );
         rasterPassPipelineLayout =
             CreatePipelineLayout( device, ls, "Raster pass Pipeline layout" );
     }
     {
         VkDescriptorSetLayout ls[] = {
             _textureManager->GetDescSetLayout(),
+            collector->GetDrawsDescSetLayout(),
         };
+        static_assert( std::size( ls ) == SWAPCHAIN_PASS_DRAWS_DESC_SET_INDEX + 1 );
         swapchainPassPipelineLayout =
             CreatePipelineLayout( device, ls, "Swapchain pass Pipeline layout" );
     }
@@ -155,21 +152,14 @@ RTGL1::Rasterizer::Rasterizer( VkDevice                                _device,
                                                        *cmdManager,
                                                        _instanceInfo );
 
-    lensFlares = std::make_unique< LensFlares >( device,
-                                                 allocator,
-                                                 _shaderManager,
-                                                 rasterPass->GetWorldRenderPass(),
-                                                 _uniform,
-                                                 *storageFramebuffers,
-                                                 *_textureManager,
-                                                 _instanceInfo );
-
     {
         VkDescriptorSetLayout ls[] = {
             _uniform.GetDescSetLayout(),
             storageFramebuffers->GetDescSetLayout(),
             _textureManager->GetDescSetLayout(),
+            collector->GetDrawsDescSetLayout(),
         };
+        static_assert( std::size( ls ) == DECAL_DRAWS_DESC_SET_INDEX + 1 );
         auto decalPipelineLayout = CreatePipelineLayout( device, ls, "Decal Pipeline layout" );
 
         decalManager = std::make_unique< DecalManager >( device,
@@ -189,8 +179,28 @@ RTGL1::Rasterizer::~Rasterizer()
 
 void RTGL1::Rasterizer::PrepareForFrame( uint32_t frameIndex )
 {
+    lastDrawStats = curDrawStats;
+    curDrawStats  = {};
+
     collector->Clear( frameIndex );
-    lensFlares->PrepareForFrame( frameIndex );
+    lastDrawStats.storage = collector->GetLastFrameUsage();
+
+    if( lensFlares )
+    {
+        if( lensFlaresIdleFrames >= LensFlaresReleaseAfterIdleFrames )
+        {
+            debug::Verbose( "Releasing lens flares resources after {} frames without uploads",
+                            lensFlaresIdleFrames );
+            deletionQueue->Push( frameIndex, [ retired = std::move( lensFlares ) ]() mutable {
+                retired.reset();
+            } );
+        }
+        else
+        {
+            lensFlares->PrepareForFrame( frameIndex );
+            lensFlaresIdleFrames++;
+        }
+    }
 }
 
 void RTGL1::Rasterizer::Upload( uint32_t                   frameIndex,
@@ -208,6 +218,20 @@ void RTGL1::Rasterizer::UploadLensFlare( uint32_t               frameIndex,
                                          float                  emissiveMult,
                                          const TextureManager&  textureManager )
 {
+    if( !lensFlares )
+    {
+        // lens flares are rarely used, so allocate their buffers only on demand
+        lensFlares = std::make_unique< LensFlares >( device,
+                                                     allocator,
+                                                     *shaderManager,
+                                                     rasterPass->GetWorldRenderPass(),
+                                                     *uniform,
+                                                     *storageFramebuffers,
+                                                     textureManager,
+                                                     rasterizedVertexColorGamma );
+    }
+    lensFlaresIdleFrames = 0;
+
     lensFlares->Upload( frameIndex, info, emissiveMult, textureManager );
 }
 
@@ -216,17 +240,27 @@ void RTGL1::Rasterizer::SubmitForFrame( VkCommandBuffer cmd, uint32_t frameIndex
     CmdLabel label( cmd, "Copying rasterizer data" );
 
     collector->CopyFromStaging( cmd, frameIndex );
-    lensFlares->SubmitForFrame( cmd, frameIndex );
+    if( lensFlares )
+    {
+        lensFlares->SubmitForFrame( cmd, frameIndex );
+    }
 }
 
-void RTGL1::Rasterizer::DrawSkyToCubemap( VkCommandBuffer       cmd,
-                                          uint32_t              frameIndex,
-                                          const TextureManager& textureManager,
-                                          const GlobalUniform&  uniform )
+void RTGL1::Rasterizer::DrawSkyToCubemap( VkCommandBuffer             cmd,
+                                          uint32_t                    frameIndex,
+                                          const TextureManager&       textureManager,
+                                          const GlobalUniform&        uniform,
+                                          const RgDrawFrameSkyParams& skyParams )
 {
     CmdLabel label( cmd, "Rasterized sky to cubemap" );
 
-    renderCubemap->Draw( cmd, frameIndex, *collector, textureManager, uniform );
+    renderCubemap->Draw( cmd,
+                         frameIndex,
+                         *collector,
+                         textureManager,
+                         uniform,
+                         skyParams.rasterizedSkyUpdate,
+                         skyParams.rasterizedSkyDirty );
 }
 
 namespace RTGL1
@@ -246,6 +280,71 @@ namespace
             curViewport = newViewport;
         }
     }
+
+    // If 'anyPipelineState', draws use one pipeline regardless of their pipeline state,
+    // e.g. all decals are drawn with a standalone pipeline
+    bool CanDrawInOneBatch( const RasterizedDataCollector::DrawInfo& a,
+                            const RasterizedDataCollector::DrawInfo& b,
+                            const VkViewport&                        defaultViewport,
+                            bool                                     anyPipelineState )
+    {
+        return ( anyPipelineState || a.pipelineState == b.pipelineState ) &&
+               ( a.indexCount > 0 ) == ( b.indexCount > 0 ) &&
+               Utils::AreViewportsSame( a.viewport.value_or( defaultViewport ),
+                                        b.viewport.value_or( defaultViewport ) );
+    }
+
+    // Each view is drawn to its column of the render target
+    struct ViewsViewProj
+    {
+        uint32_t count;
+        float    viewProj[ MAX_VIEW_COUNT ][ 16 ];
+    };
+
+    // If 'skyViewerPos' is not null, the views are moved to the sky, keeping their offsets
+    // from view 0
+    auto MakeViewsViewProj( const GlobalUniform&          uniform,
+                            const RgFloat2D&              jitter,
+                            const RenderResolutionHelper& renderResolution,
+                            const RgFloat3D*              skyViewerPos = nullptr )
+        -> std::optional< ViewsViewProj >
+    {
+        if( !renderResolution.IsMultiView() )
+        {
+            return std::nullopt;
+        }
+
+        const ShGlobalUniform& gu = *uniform.GetData();
+
+        auto result = ViewsViewProj{ .count = renderResolution.ViewCount() };
+        for( uint32_t v = 0; v < result.count; v++ )
+        {
+            const float* view = &gu.viewsView[ 16 * v ];
+
+            float skyView[ 16 ];
+            if( skyViewerPos )
+            {
+                const float* pos  = &gu.viewsCameraPosition[ 4 * v ];
+                const float* pos0 = &gu.viewsCameraPosition[ 0 ];
+
+                const RgFloat3D p = { skyViewerPos->data[ 0 ] + pos[ 0 ] - pos0[ 0 ],
+                                      skyViewerPos->data[ 1 ] + pos[ 1 ] - pos0[ 1 ],
+                                      skyViewerPos->data[ 2 ] + pos[ 2 ] - pos0[ 2 ] };
+
+                Matrix::SetNewViewerPosition( skyView, view, p.data );
+                view = skyView;
+            }
+
+            // jitter is in pixels, so relative to the viewport of one view
+            auto jitterredProj = ApplyJitter( &gu.viewsProjection[ 16 * v ],
+                                              jitter,
+                                              renderResolution.ViewWidth(),
+                                              renderResolution.Height() );
+
+            Matrix::Multiply( result.viewProj[ v ], view, jitterredProj.data() );
+        }
+        return result;
+    }
 }
 }
 
@@ -263,7 +362,7 @@ struct RasterDrawParams
     VkPipeline           standalonePipeline{ nullptr };
     VkPipelineLayout     standalonePipelineLayout{ nullptr };
 
-    std::span< const RasterizedDataCollector::DrawInfo > drawInfos{};
+    GeometryRasterType rasterType{ GeometryRasterType::WORLD };
 
     VkRenderPass                      renderPass{ VK_NULL_HANDLE };
     VkFramebuffer                     framebuffer{ VK_NULL_HANDLE };
@@ -272,7 +371,10 @@ struct RasterDrawParams
     VkBuffer                          vertexBuffer{ VK_NULL_HANDLE };
     VkBuffer                          indexBuffer{ VK_NULL_HANDLE };
     std::span< VkDescriptorSet >      descSets{};
+    uint32_t                          drawsDescSetIndex{ 0 };
     float*                            defaultViewProj{ nullptr };
+    // if not null, 'defaultViewProj' is ignored
+    const ViewsViewProj*              views{ nullptr };
     // not the best way to optionally draw lens flares with a world pass
     std::optional< RasterLensFlares > flaresParams{};
     std::optional< float >            classic{};
@@ -305,6 +407,8 @@ void RTGL1::Rasterizer::DrawDecals( VkCommandBuffer               cmd,
     float defaultViewProj[ 16 ];
     Matrix::Multiply( defaultViewProj, view, jitterredProj.data() );
 
+    const auto views = MakeViewsViewProj( uniform, jitter, renderResolution );
+
     VkDescriptorSet sets[] = {
         uniform.GetDescSet( frameIndex ),
         storageFramebuffers->GetDescSet( frameIndex ),
@@ -314,7 +418,7 @@ void RTGL1::Rasterizer::DrawDecals( VkCommandBuffer               cmd,
     const RasterDrawParams params = {
         .standalonePipeline       = decalManager->GetDrawPipeline(),
         .standalonePipelineLayout = decalManager->GetDrawPipelineLayout(),
-        .drawInfos                = collector->GetDrawInfos( GeometryRasterType::DECAL ),
+        .rasterType               = GeometryRasterType::DECAL,
         .renderPass               = decalManager->GetRenderPass(),
         .framebuffer              = decalManager->GetFramebuffer( frameIndex ),
         .width                    = renderResolution.Width(),
@@ -322,7 +426,9 @@ void RTGL1::Rasterizer::DrawDecals( VkCommandBuffer               cmd,
         .vertexBuffer             = collector->GetVertexBuffer(),
         .indexBuffer              = collector->GetIndexBuffer(),
         .descSets                 = sets,
+        .drawsDescSetIndex        = DECAL_DRAWS_DESC_SET_INDEX,
         .defaultViewProj          = defaultViewProj,
+        .views                    = views ? &*views : nullptr,
     };
 
     Draw( cmd, frameIndex, params );
@@ -333,6 +439,7 @@ void RTGL1::Rasterizer::DrawDecals( VkCommandBuffer               cmd,
 void RTGL1::Rasterizer::DrawSkyToAlbedo( VkCommandBuffer               cmd,
                                          uint32_t                      frameIndex,
                                          const TextureManager&         textureManager,
+                                         const GlobalUniform&          uniform,
                                          const float*                  view,
                                          const RgFloat3D&              skyViewerPos,
                                          const float*                  proj,
@@ -355,22 +462,26 @@ void RTGL1::Rasterizer::DrawSkyToAlbedo( VkCommandBuffer               cmd,
     float defaultSkyViewProj[ 16 ];
     Matrix::Multiply( defaultSkyViewProj, skyView, jitterredProj.data() );
 
+    const auto views = MakeViewsViewProj( uniform, jitter, renderResolution, &skyViewerPos );
+
 
     VkDescriptorSet sets[] = {
         textureManager.GetDescSet( frameIndex ),
     };
 
     const RasterDrawParams params = {
-        .pipelines       = rasterPass->GetSkyRasterPipelines().get(),
-        .drawInfos       = collector->GetDrawInfos( GeometryRasterType::SKY ),
-        .renderPass      = rasterPass->GetSkyRenderPass(),
-        .framebuffer     = rasterPass->GetSkyFramebuffer(),
-        .width           = renderResolution.Width(),
-        .height          = renderResolution.Height(),
-        .vertexBuffer    = collector->GetVertexBuffer(),
-        .indexBuffer     = collector->GetIndexBuffer(),
-        .descSets        = sets,
-        .defaultViewProj = defaultSkyViewProj,
+        .pipelines         = rasterPass->GetSkyRasterPipelines().get(),
+        .rasterType        = GeometryRasterType::SKY,
+        .renderPass        = rasterPass->GetSkyRenderPass(),
+        .framebuffer       = rasterPass->GetSkyFramebuffer(),
+        .width             = renderResolution.Width(),
+        .height            = renderResolution.Height(),
+        .vertexBuffer      = collector->GetVertexBuffer(),
+        .indexBuffer       = collector->GetIndexBuffer(),
+        .descSets          = sets,
+        .drawsDescSetIndex = RASTER_PASS_DRAWS_DESC_SET_INDEX,
+        .defaultViewProj   = defaultSkyViewProj,
+        .views             = views ? &*views : nullptr,
     };
 
     Draw( cmd, frameIndex, params );
@@ -400,7 +511,10 @@ void RTGL1::Rasterizer::DrawToFinalImage( VkCommandBuffer               cmd,
 
 
     // prepare lens flares draw commands
-    lensFlares->Cull( cmd, frameIndex, uniform, *storageFramebuffers );
+    if( lensFlares && !renderResolution.IsMultiView() )
+    {
+        lensFlares->Cull( cmd, frameIndex, uniform, *storageFramebuffers );
+    }
 
 
     // copy depth buffer
@@ -417,6 +531,8 @@ void RTGL1::Rasterizer::DrawToFinalImage( VkCommandBuffer               cmd,
     float defaultViewProj[ 16 ];
     Matrix::Multiply( defaultViewProj, view, jitterredProj.data() );
 
+    const auto views = MakeViewsViewProj( uniform, jitter, renderResolution );
+
     VkDescriptorSet sets[] = {
         textureManager.GetDescSet( frameIndex ),
         uniform.GetDescSet( frameIndex ),
@@ -424,19 +540,26 @@ void RTGL1::Rasterizer::DrawToFinalImage( VkCommandBuffer               cmd,
         volumetric.GetDescSet( frameIndex ),
     };
 
+    // lens flares are culled for one camera
+    const bool withFlares = !views;
+
     const RasterDrawParams params = {
-        .pipelines       = rasterPass->GetRasterPipelines().get(),
-        .drawInfos       = collector->GetDrawInfos( GeometryRasterType::WORLD ),
-        .renderPass      = rasterPass->GetWorldRenderPass(),
-        .framebuffer     = rasterPass->GetWorldFramebuffer(),
-        .width           = renderResolution.Width(),
-        .height          = renderResolution.Height(),
-        .vertexBuffer    = collector->GetVertexBuffer(),
-        .indexBuffer     = collector->GetIndexBuffer(),
-        .descSets        = sets,
-        .defaultViewProj = defaultViewProj,
-        .flaresParams    = RasterLensFlares{ .textureManager = &textureManager },
-        .classic         = -lightmapScreenCoverage,
+        .pipelines         = rasterPass->GetRasterPipelines().get(),
+        .rasterType        = GeometryRasterType::WORLD,
+        .renderPass        = rasterPass->GetWorldRenderPass(),
+        .framebuffer       = rasterPass->GetWorldFramebuffer(),
+        .width             = renderResolution.Width(),
+        .height            = renderResolution.Height(),
+        .vertexBuffer      = collector->GetVertexBuffer(),
+        .indexBuffer       = collector->GetIndexBuffer(),
+        .descSets          = sets,
+        .drawsDescSetIndex = RASTER_PASS_DRAWS_DESC_SET_INDEX,
+        .defaultViewProj   = defaultViewProj,
+        .views             = views ? &*views : nullptr,
+        .flaresParams      = withFlares ? std::optional{ RasterLensFlares{
+                                              .textureManager = &textureManager } }
+                                        : std::nullopt,
+        .classic           = -lightmapScreenCoverage,
     };
 
     Draw( cmd, frameIndex, params );
@@ -480,17 +603,18 @@ void RTGL1::Rasterizer::DrawClassic( VkCommandBuffer               cmd,
         
         const RasterDrawParams params = {
             .pipelines   = rasterPass->GetClassicRasterPipelines().get(),
-            .drawInfos   = collector->GetDrawInfos( GeometryRasterType::SKY ),
+            .rasterType  = GeometryRasterType::SKY,
             .renderPass  = rasterPass->GetClassicRenderPass(),
             .framebuffer = rasterPass->GetClassicFramebuffer( destination ),
             .width       = upscaled ? renderResolution.UpscaledWidth() : renderResolution.Width(),
             .height      = upscaled ? renderResolution.UpscaledHeight() : renderResolution.Height(),
-            .vertexBuffer    = collector->GetVertexBuffer(),
-            .indexBuffer     = collector->GetIndexBuffer(),
-            .descSets        = sets,
-            .defaultViewProj = defaultSkyViewProj,
-            .flaresParams    = {},
-            .classic         = lightmapScreenCoverage,
+            .vertexBuffer      = collector->GetVertexBuffer(),
+            .indexBuffer       = collector->GetIndexBuffer(),
+            .descSets          = sets,
+            .drawsDescSetIndex = RASTER_PASS_DRAWS_DESC_SET_INDEX,
+            .defaultViewProj   = defaultSkyViewProj,
+            .flaresParams      = {},
+            .classic           = lightmapScreenCoverage,
         };
 
         Draw( cmd, frameIndex, params );
@@ -513,17 +637,18 @@ void RTGL1::Rasterizer::DrawClassic( VkCommandBuffer               cmd,
 
     const RasterDrawParams params = {
         .pipelines   = rasterPass->GetClassicRasterPipelines().get(),
-        .drawInfos   = collector->GetDrawInfos( GeometryRasterType::WORLD_CLASSIC ),
+        .rasterType  = GeometryRasterType::WORLD_CLASSIC,
         .renderPass  = rasterPass->GetClassicRenderPass(),
         .framebuffer = rasterPass->GetClassicFramebuffer( destination ),
         .width  = upscaled ? renderResolution.UpscaledWidth() : renderResolution.Width(),
         .height = upscaled ? renderResolution.UpscaledHeight() : renderResolution.Height(),
-        .vertexBuffer    = collector->GetVertexBuffer(),
-        .indexBuffer     = collector->GetIndexBuffer(),
-        .descSets        = sets,
-        .defaultViewProj = defaultViewProj,
-        .flaresParams    = {},
-        .classic         = lightmapScreenCoverage,
+        .vertexBuffer      = collector->GetVertexBuffer(),
+        .indexBuffer       = collector->GetIndexBuffer(),
+        .descSets          = sets,
+        .drawsDescSetIndex = RASTER_PASS_DRAWS_DESC_SET_INDEX,
+        .defaultViewProj   = defaultViewProj,
+        .flaresParams      = {},
+        .classic           = lightmapScreenCoverage,
     };
 
     Draw( cmd, frameIndex, params );
@@ -551,17 +676,18 @@ void RTGL1::Rasterizer::DrawToSwapchain( VkCommandBuffer       cmd,
     };
 
     const RasterDrawParams params = {
-        .pipelines       = swapchainPass->GetSwapchainPipelines( imageToDrawIn ),
-        .drawInfos       = collector->GetDrawInfos( GeometryRasterType::SWAPCHAIN ),
-        .renderPass      = swapchainPass->GetSwapchainRenderPass( imageToDrawIn ),
-        .framebuffer     = swapchainPass->GetSwapchainFramebuffer( imageToDrawIn ),
-        .width           = swapchainWidth,
-        .height          = swapchainHeight,
-        .vertexBuffer    = collector->GetVertexBuffer(),
-        .indexBuffer     = collector->GetIndexBuffer(),
-        .descSets        = sets,
-        .defaultViewProj = defaultViewProj,
-        .manualSrgb      = ( imageToDrawIn == FB_IMAGE_INDEX_HUD_ONLY && !isHdr ),
+        .pipelines         = swapchainPass->GetSwapchainPipelines( imageToDrawIn ),
+        .rasterType        = GeometryRasterType::SWAPCHAIN,
+        .renderPass        = swapchainPass->GetSwapchainRenderPass( imageToDrawIn ),
+        .framebuffer       = swapchainPass->GetSwapchainFramebuffer( imageToDrawIn ),
+        .width             = swapchainWidth,
+        .height            = swapchainHeight,
+        .vertexBuffer      = collector->GetVertexBuffer(),
+        .indexBuffer       = collector->GetIndexBuffer(),
+        .descSets          = sets,
+        .drawsDescSetIndex = SWAPCHAIN_PASS_DRAWS_DESC_SET_INDEX,
+        .defaultViewProj   = defaultViewProj,
+        .manualSrgb        = ( imageToDrawIn == FB_IMAGE_INDEX_HUD_ONLY && !isHdr ),
     };
 
     Draw( cmd, frameIndex, params );
@@ -573,8 +699,10 @@ void RTGL1::Rasterizer::Draw( VkCommandBuffer         cmd,
 {
     assert( drawParams.framebuffer != VK_NULL_HANDLE );
 
-    const bool draw           = !drawParams.drawInfos.empty();
-    const bool drawLensFlares = drawParams.flaresParams && lensFlares->GetCullingInputCount() > 0;
+    const auto drawInfos      = collector->GetDrawInfos( drawParams.rasterType );
+    const bool draw           = !drawInfos.empty();
+    const bool drawLensFlares =
+        drawParams.flaresParams && lensFlares && lensFlares->GetCullingInputCount() > 0;
 
     if( !draw && !drawLensFlares )
     {
@@ -641,89 +769,249 @@ void RTGL1::Rasterizer::Draw( VkCommandBuffer         cmd,
         .pClearValues    = clear,
     };
 
-    vkCmdBeginRenderPass( cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE );
+    const VkPipelineLayout layout = drawParams.pipelines
+                                        ? drawParams.pipelines->GetPipelineLayout()
+                                        : drawParams.standalonePipelineLayout;
 
+    const VkBuffer     indirectBuffer = collector->GetIndirectBuffer();
+    const uint32_t     indirectStride = RasterizedDataCollector::GetIndirectDrawStride();
+    const VkDeviceSize indirectOffset = collector->GetIndirectDrawOffset( drawParams.rasterType );
 
-    if( draw )
-    {
+    // record drawInfos[begin..end) to 'target', for each view
+    auto l_drawRange = [ & ]( VkCommandBuffer target, size_t begin, size_t end, DrawStats& stats ) {
         auto curPipeline = VkPipeline{ nullptr };
 
         if( drawParams.pipelines )
         {
             curPipeline = drawParams.pipelines->BindPipelineIfNew(
-                cmd, VK_NULL_HANDLE, drawParams.drawInfos[ 0 ].pipelineState );
+                target, VK_NULL_HANDLE, drawInfos[ begin ].pipelineState );
         }
         else
         {
             vkCmdBindPipeline(
-                cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, drawParams.standalonePipeline );
+                target, VK_PIPELINE_BIND_POINT_GRAPHICS, drawParams.standalonePipeline );
         }
 
-        vkCmdBindDescriptorSets( cmd,
+        vkCmdBindDescriptorSets( target,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                 drawParams.pipelines ? drawParams.pipelines->GetPipelineLayout()
-                                                      : drawParams.standalonePipelineLayout,
+                                 layout,
                                  0,
                                  uint32_t( drawParams.descSets.size() ),
                                  drawParams.descSets.data(),
                                  0,
                                  nullptr );
 
-        VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers( cmd, 0, 1, &drawParams.vertexBuffer, &offset );
-        vkCmdBindIndexBuffer( cmd, drawParams.indexBuffer, offset, VK_INDEX_TYPE_UINT32 );
-
-
-        vkCmdSetScissor( cmd, 0, 1, &defaultRenderArea );
-        vkCmdSetViewport( cmd, 0, 1, &defaultViewport );
-        VkViewport curViewport = defaultViewport;
-
+        VkDescriptorSet drawsSet = collector->GetDrawsDescSet();
+        vkCmdBindDescriptorSets( target,
+                                 VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                 layout,
+                                 drawParams.drawsDescSetIndex,
+                                 1,
+                                 &drawsSet,
+                                 0,
+                                 nullptr );
 
-        for( const auto& info : drawParams.drawInfos )
-        {
-            SetViewportIfNew( cmd, info, defaultViewport, curViewport );
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers( target, 0, 1, &drawParams.vertexBuffer, &offset );
+        vkCmdBindIndexBuffer( target, drawParams.indexBuffer, offset, VK_INDEX_TYPE_UINT32 );
 
-            if( drawParams.pipelines )
-            {
-                curPipeline =
-                    drawParams.pipelines->BindPipelineIfNew( cmd, curPipeline, info.pipelineState );
-            }
 
+        auto l_drawAll = [ & ]( const VkViewport& viewport,
+                                const VkRect2D&   scissor,
+                                const float*      viewProj ) {
             // push const
             {
-                auto push =
-                    RasterizedPushConst{ info, drawParams.defaultViewProj, drawParams.manualSrgb };
+                auto push = RasterizedPushConst{
+                    .manualSrgb = drawParams.manualSrgb,
+                };
+                memcpy( push.viewProj, viewProj, sizeof( push.viewProj ) );
 
-                vkCmdPushConstants( cmd,
-                                    drawParams.pipelines ? drawParams.pipelines->GetPipelineLayout()
-                                                         : drawParams.standalonePipelineLayout,
+                vkCmdPushConstants( target,
+                                    layout,
                                     VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                                     0,
                                     sizeof( push ),
                                     &push );
             }
 
-            // draw
-            if( info.indexCount > 0 )
+            vkCmdSetScissor( target, 0, 1, &scissor );
+            vkCmdSetViewport( target, 0, 1, &viewport );
+            VkViewport curViewport = viewport;
+
+            // consecutive draws with the same state are issued by one indirect call
+            for( size_t first = begin; first < end; )
             {
-                vkCmdDrawIndexed(
-                    cmd, info.indexCount, 1, info.firstIndex, int32_t( info.firstVertex ), 0 );
+                const auto& info = drawInfos[ first ];
+
+                size_t count = 1;
+                while( first + count < end &&
+                       CanDrawInOneBatch( info,
+                                          drawInfos[ first + count ],
+                                          viewport,
+                                          drawParams.pipelines == nullptr ) )
+                {
+                    count++;
+                }
+
+                SetViewportIfNew( target, info, viewport, curViewport );
+
+                if( drawParams.pipelines )
+                {
+                    VkPipeline prev = curPipeline;
+                    curPipeline     = drawParams.pipelines->BindPipelineIfNew(
+                        target, curPipeline, info.pipelineState );
+
+                    stats.pipelineSwitches += ( curPipeline != prev ) ? 1 : 0;
+                }
+
+                // draw
+                const VkDeviceSize cmdOffset = indirectOffset + first * indirectStride;
+                if( info.indexCount > 0 )
+                {
+                    vkCmdDrawIndexedIndirect(
+                        target, indirectBuffer, cmdOffset, uint32_t( count ), indirectStride );
+                }
+                else
+                {
+                    vkCmdDrawIndirect(
+                        target, indirectBuffer, cmdOffset, uint32_t( count ), indirectStride );
+                }
+
+                stats.drawCount += uint32_t( count );
+                stats.drawCallCount++;
+
+                first += count;
             }
-            else
+        };
+
+        if( drawParams.views )
+        {
+            // same draws for each view, only the viewport and the camera are different
+            const uint32_t viewWidth = drawParams.width / drawParams.views->count;
+
+            for( uint32_t v = 0; v < drawParams.views->count; v++ )
             {
-                vkCmdDraw( cmd, info.vertexCount, 1, info.firstVertex, 0 );
+                const auto viewViewport = VkViewport{
+                    .x        = static_cast< float >( v * viewWidth ),
+                    .y        = 0,
+                    .width    = static_cast< float >( viewWidth ),
+                    .height   = static_cast< float >( drawParams.height ),
+                    .minDepth = 0.0f,
+                    .maxDepth = 1.0f,
+                };
+                const auto viewScissor = VkRect2D{
+                    .offset = { int32_t( v * viewWidth ), 0 },
+                    .extent = { viewWidth, drawParams.height },
+                };
+
+                l_drawAll( viewViewport, viewScissor, drawParams.views->viewProj[ v ] );
             }
         }
-    }
+        else
+        {
+            l_drawAll( defaultViewport, defaultRenderArea, drawParams.defaultViewProj );
+        }
+    };
 
+    auto l_drawLensFlares = [ & ]( VkCommandBuffer target ) {
+        vkCmdSetScissor( target, 0, 1, &defaultRenderArea );
+        vkCmdSetViewport( target, 0, 1, &defaultViewport );
 
-    if( drawLensFlares )
+        lensFlares->Draw( target,
+                          frameIndex,
+                          *drawParams.flaresParams->textureManager,
+                          drawParams.defaultViewProj );
+    };
+
+
+    const uint32_t workerCount = [ & ]() -> uint32_t {
+        if( !LibConfig().parallelRasterRecording || !draw )
+        {
+            return 1;
+        }
+        return std::clamp( uint32_t( drawInfos.size() / ParallelRecordMinDrawsPerWorker ),
+                           1u,
+                           std::min( std::thread::hardware_concurrency(), MAX_RECORD_WORKERS ) );
+    }();
+
+    if( workerCount <= 1 )
     {
-        vkCmdSetScissor( cmd, 0, 1, &defaultRenderArea );
-        vkCmdSetViewport( cmd, 0, 1, &defaultViewport );
+        vkCmdBeginRenderPass( cmd, &beginInfo, VK_SUBPASS_CONTENTS_INLINE );
+
+        if( draw )
+        {
+            l_drawRange( cmd, 0, drawInfos.size(), curDrawStats );
+        }
 
-        lensFlares->Draw(
-            cmd, frameIndex, *drawParams.flaresParams->textureManager, drawParams.defaultViewProj );
+        if( drawLensFlares )
+        {
+            l_drawLensFlares( cmd );
+        }
+    }
+    else
+    {
+        // create missing pipelines here, so the workers only read the pipeline map
+        if( drawParams.pipelines )
+        {
+            for( const auto& info : drawInfos )
+            {
+                drawParams.pipelines->GetPipeline( info.pipelineState );
+            }
+        }
+
+        VkCommandBuffer secondaries[ MAX_RECORD_WORKERS + 1 ] = {};
+        DrawStats       stats[ MAX_RECORD_WORKERS ]           = {};
+
+        auto l_record = [ & ]( uint32_t workerIndex ) {
+            const size_t perWorker = ( drawInfos.size() + workerCount - 1 ) / workerCount;
+            const size_t begin     = std::min( drawInfos.size(), workerIndex * perWorker );
+            const size_t end       = std::min( drawInfos.size(), begin + perWorker );
+
+            VkCommandBuffer secondary = cmdManager->StartSecondaryGraphicsCmd(
+                workerIndex, drawParams.renderPass, drawParams.framebuffer );
+            if( begin < end )
+            {
+                l_drawRange( secondary, begin, end, stats[ workerIndex ] );
+            }
+            cmdManager->EndSecondaryCmd( secondary );
+
+            secondaries[ workerIndex ] = secondary;
+        };
+
+        std::vector< std::future< void > > workers;
+        workers.reserve( workerCount - 1 );
+        for( uint32_t i = 1; i < workerCount; i++ )
+        {
+            workers.push_back( std::async( std::launch::async, l_record, i ) );
+        }
+        // current thread records the first part
+        l_record( 0 );
+        for( auto& w : workers )
+        {
+            w.get();
+        }
+
+        uint32_t secondaryCount = workerCount;
+        if( drawLensFlares )
+        {
+            // workers are joined, so the pool of the first one is free to use
+            VkCommandBuffer secondary = cmdManager->StartSecondaryGraphicsCmd(
+                0, drawParams.renderPass, drawParams.framebuffer );
+            l_drawLensFlares( secondary );
+            cmdManager->EndSecondaryCmd( secondary );
+
+            secondaries[ secondaryCount++ ] = secondary;
+        }
+
+        vkCmdBeginRenderPass( cmd, &beginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS );
+        vkCmdExecuteCommands( cmd, secondaryCount, secondaries );
+
+        for( uint32_t i = 0; i < workerCount; i++ )
+        {
+            curDrawStats.drawCount += stats[ i ].drawCount;
+            curDrawStats.drawCallCount += stats[ i ].drawCallCount;
+            curDrawStats.pipelineSwitches += stats[ i ].pipelineSwitches;
+        }
     }
 
 
@@ -740,7 +1028,11 @@ void RTGL1::Rasterizer::OnShaderReload( const ShaderManager* shaderManager )
     rasterPass->OnShaderReload( shaderManager );
     swapchainPass->OnShaderReload( shaderManager );
     renderCubemap->OnShaderReload( shaderManager );
-    lensFlares->OnShaderReload( shaderManager );
+    this->shaderManager = shaderManager;
+    if( lensFlares )
+    {
+        lensFlares->OnShaderReload( shaderManager );
+    }
     decalManager->OnShaderReload( shaderManager );
 }
 
@@ -22,6 +22,7 @@
 
 #include "Common.h"
 #include "DecalManager.h"
+#include "DeletionQueue.h"
 #include "Framebuffers.h"
 #include "GlobalUniform.h"
 #include "IFramebuffersDependency.h"
@@ -60,6 +61,7 @@ public:
                          std::shared_ptr< MemoryAllocator >      allocator,
                          std::shared_ptr< Framebuffers >         storageFramebuffers,
                          std::shared_ptr< CommandBufferManager > cmdManager,
+                         std::shared_ptr< DeletionQueue >        deletionQueue,
                          const RgInstanceCreateInfo&             instanceInfo );
     ~Rasterizer() override;
 
@@ -81,10 +83,11 @@ public:
                           const TextureManager&        textureManager );
     void SubmitForFrame( VkCommandBuffer cmd, uint32_t frameIndex );
 
-    void DrawSkyToCubemap( VkCommandBuffer       cmd,
-                           uint32_t              frameIndex,
-                           const TextureManager& textureManager,
-                           const GlobalUniform&  uniform );
+    void DrawSkyToCubemap( VkCommandBuffer             cmd,
+                           uint32_t                    frameIndex,
+                           const TextureManager&       textureManager,
+                           const GlobalUniform&        uniform,
+                           const RgDrawFrameSkyParams& skyParams );
 
     void DrawDecals( VkCommandBuffer               cmd,
                      uint32_t                      frameIndex,
@@ -98,6 +101,7 @@ public:
     void DrawSkyToAlbedo( VkCommandBuffer               cmd,
                           uint32_t                      frameIndex,
                           const TextureManager&         textureManager,
+                          const GlobalUniform&          uniform,
                           const float*                  view,
                           const RgFloat3D&              skyViewerPos,
                           const float*                  proj,
@@ -146,7 +150,23 @@ public:
 
     uint32_t GetLensFlareCullingInputCount() const;
 
+    struct DrawStats
+    {
+        uint32_t drawCount;
+        uint32_t drawCallCount;
+        uint32_t pipelineSwitches;
+
+        RasterizedDataCollector::Usage storage;
+    };
+    // Of the last frame
+    DrawStats GetDrawStats() const { return lastDrawStats; }
+
 private:
+    static constexpr uint32_t LensFlaresReleaseAfterIdleFrames = 600;
+    // If 'parallelRasterRecording', a pass is split between
+    // worker threads only if each of them gets at least this amount of draws
+    static constexpr uint32_t ParallelRecordMinDrawsPerWorker = 256;
+
     void Draw( VkCommandBuffer cmd, uint32_t frameIndex, const RasterDrawParams& drawParams );
 
 private:
@@ -156,6 +176,7 @@ private:
 
     std::shared_ptr< MemoryAllocator >      allocator;
     std::shared_ptr< CommandBufferManager > cmdManager;
+    std::shared_ptr< DeletionQueue >        deletionQueue;
     std::shared_ptr< Framebuffers >         storageFramebuffers;
 
     std::shared_ptr< RasterPass >    rasterPass;
@@ -165,8 +186,17 @@ private:
 
     std::shared_ptr< RenderCubemap > renderCubemap;
 
+    // Created on the first lens flare upload, released after being unused for a while
     std::unique_ptr< LensFlares > lensFlares;
+    uint32_t                      lensFlaresIdleFrames{ 0 };
+    const ShaderManager*          shaderManager;
+    const GlobalUniform*          uniform;
+    bool                          rasterizedVertexColorGamma;
+
     std::unique_ptr< DecalManager > decalManager;
+
+    DrawStats curDrawStats{};
+    DrawStats lastDrawStats{};
 };
 
 }
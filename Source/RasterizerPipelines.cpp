@@ -20,11 +20,67 @@
 
 #include "RasterizerPipelines.h"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <future>
+#include <thread>
 
+#include "HitchRecorder.h"
 #include "RasterizedDataCollector.h"
 #include "RgException.h"
 
+namespace RTGL1
+{
+namespace
+{
+
+    // States that RasterizedDataCollector's ToPipelineState can produce:
+    // world / sky geometry is always depth tested, swapchained one may be drawn as lines
+    auto GetKnownPipelineStates( bool withDepth )
+    {
+        auto states = std::vector< PipelineStateFlags >{};
+
+        for( PipelineStateFlags alpha : { 0u, uint32_t( PipelineStateFlagBits::ALPHA_TEST ) } )
+        {
+            for( PipelineStateFlags blend :
+                 { 0u,
+                   uint32_t( PipelineStateFlagBits::TRANSLUCENT ),
+                   PipelineStateFlagBits::TRANSLUCENT | PipelineStateFlagBits::ADDITIVE } )
+            {
+                for( PipelineStateFlags sky :
+                     { 0u, uint32_t( PipelineStateFlagBits::SKY_VISIBILITY ) } )
+                {
+                    for( PipelineStateFlags lines :
+                         { 0u, uint32_t( PipelineStateFlagBits::DRAW_AS_LINES ) } )
+                    {
+                        if( withDepth && lines )
+                        {
+                            continue;
+                        }
+
+                        PipelineStateFlags depth = 0;
+                        if( withDepth )
+                        {
+                            depth = depth | PipelineStateFlagBits::DEPTH_TEST;
+                            if( !( blend & PipelineStateFlagBits::TRANSLUCENT ) )
+                            {
+                                depth = depth | PipelineStateFlagBits::DEPTH_WRITE;
+                            }
+                        }
+
+                        states.push_back( alpha | blend | sky | lines | depth );
+                    }
+                }
+            }
+        }
+
+        return states;
+    }
+
+}
+}
+
 RTGL1::RasterizerPipelines::RasterizerPipelines( VkDevice             _device,
                                                  VkPipelineLayout     _pipelineLayout,
                                                  VkRenderPass         _renderPass,
@@ -42,24 +98,18 @@ RTGL1::RasterizerPipelines::RasterizerPipelines( VkDevice             _device,
     , renderPass{ _renderPass }
     , vertShaderStage{}
     , fragShaderStage{}
-    , pipelineCache{ VK_NULL_HANDLE }
+    , pipelineCache{ _shaderManager.GetPipelineCache() }
     , nonDynamicViewport{ _pViewport ? std::optional( *_pViewport ) : std::nullopt }
     , nonDynamicScissors{ _pScissors ? std::optional( *_pScissors ) : std::nullopt }
     , applyVertexColorGamma{ _applyVertexColorGamma }
     , onlyColorAttachment{ !_notOnlyColorAttachment }
 {
-    VkPipelineCacheCreateInfo info = { .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
-
-    VkResult r = vkCreatePipelineCache( device, &info, nullptr, &pipelineCache );
-    VK_CHECKERROR( r );
-
-    OnShaderReload( &_shaderManager );
+    CreateAllPipelines( &_shaderManager );
 }
 
 RTGL1::RasterizerPipelines::~RasterizerPipelines()
 {
     DestroyAllPipelines();
-    vkDestroyPipelineCache( device, pipelineCache, nullptr );
 }
 
 void RTGL1::RasterizerPipelines::DestroyAllPipelines()
@@ -74,10 +124,64 @@ void RTGL1::RasterizerPipelines::DestroyAllPipelines()
 
 void RTGL1::RasterizerPipelines::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { shaderNameVert, shaderNameFrag } ) )
+    {
+        return;
+    }
+
     DestroyAllPipelines();
+    CreateAllPipelines( shaderManager );
+}
+
+void RTGL1::RasterizerPipelines::CreateAllPipelines( const ShaderManager* shaderManager )
+{
+    assert( pipelines.empty() );
 
     vertShaderStage = shaderManager->GetStageInfo( shaderNameVert.c_str() );
     fragShaderStage = shaderManager->GetStageInfo( shaderNameFrag.c_str() );
+
+    PrecompilePipelines();
+}
+
+void RTGL1::RasterizerPipelines::PrecompilePipelines()
+{
+    auto states = GetKnownPipelineStates( false );
+    {
+        auto withDepth = GetKnownPipelineStates( true );
+        states.insert( states.end(), withDepth.begin(), withDepth.end() );
+    }
+
+    auto compiled = std::vector< VkPipeline >( states.size(), VK_NULL_HANDLE );
+    auto next     = std::atomic_size_t{ 0 };
+
+    // pipeline cache is internally synchronized, so the permutations can be built concurrently
+    auto compileJob = [ & ]() {
+        for( size_t i = next++; i < states.size(); i = next++ )
+        {
+            compiled[ i ] = CreatePipeline( states[ i ] );
+        }
+    };
+
+    const uint32_t threadCount =
+        std::clamp( std::thread::hardware_concurrency(), 1u, uint32_t( states.size() ) );
+
+    auto workers = std::vector< std::future< void > >{};
+    for( uint32_t t = 1; t < threadCount; t++ )
+    {
+        workers.push_back( std::async( std::launch::async, compileJob ) );
+    }
+
+    // current thread participates too
+    compileJob();
+    for( auto& w : workers )
+    {
+        w.get();
+    }
+
+    for( size_t i = 0; i < states.size(); i++ )
+    {
+        pipelines[ states[ i ] ] = compiled[ i ];
+    }
 }
 
 VkPipeline RTGL1::RasterizerPipelines::GetPipeline( PipelineStateFlags pipelineState )
@@ -102,6 +206,8 @@ VkPipelineLayout RTGL1::RasterizerPipelines::GetPipelineLayout()
 
 VkPipeline RTGL1::RasterizerPipelines::CreatePipeline( PipelineStateFlags pipelineState ) const
 {
+    RG_HITCH_MARKER( "Pipeline creation: rasterizer" );
+
     assert( vertShaderStage.sType != 0 && fragShaderStage.sType != 0 );
 
 
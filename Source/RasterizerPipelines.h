@@ -55,11 +55,15 @@ public:
     VkPipeline BindPipelineIfNew( VkCommandBuffer    cmd,
                                   VkPipeline         oldPipeline,
                                   PipelineStateFlags pipelineState );
+    // Creates the pipeline, if it doesn't exist. Not thread-safe in that case,
+    // so call it before recording from several threads with BindPipelineIfNew
+    VkPipeline GetPipeline( PipelineStateFlags pipelineState );
 
 
 private:
     [[nodiscard]] VkPipeline CreatePipeline( PipelineStateFlags pipelineState ) const;
-    VkPipeline               GetPipeline( PipelineStateFlags pipelineState );
+    void                     CreateAllPipelines( const ShaderManager* shaderManager );
+    void                     PrecompilePipelines();
     void                     DestroyAllPipelines();
 
 private:
@@ -74,6 +78,7 @@ private:
     VkPipelineShaderStageCreateInfo fragShaderStage;
 
     rgl::unordered_map< PipelineStateFlags, VkPipeline > pipelines;
+    // not owned
     VkPipelineCache                                      pipelineCache;
 
     std::optional< VkViewport > nonDynamicViewport;
@@ -0,0 +1,193 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "RayCostStats.h"
+
+#include <algorithm>
+#include <utility>
+
+RTGL1::RayCostStats::RayCostStats( std::shared_ptr< MemoryAllocator > _allocator )
+    : allocator{ std::move( _allocator ) }
+{
+}
+
+void RTGL1::RayCostStats::ReadBack( uint32_t frameIndex )
+{
+    const VkExtent2D extent = std::exchange( copiedExtent[ frameIndex ], VkExtent2D{} );
+    if( extent.width == 0 || extent.height == 0 )
+    {
+        // keep the previous totals, if the view was just disabled
+        return;
+    }
+
+    const auto* src = static_cast< const uint32_t* >( readback[ frameIndex ].Map() );
+
+    auto t = Totals{
+        .pixelCount = extent.width * extent.height,
+    };
+
+    // must match packRayCost in ShaderCommonGLSLFunc.h
+    constexpr uint32_t raysMask    = ( 1u << RAY_COST_RAYS_BITS ) - 1;
+    constexpr uint32_t anyHitsMask = ( 1u << RAY_COST_ANY_HITS_BITS ) - 1;
+    constexpr uint32_t layersMask  = ( 1u << RAY_COST_LAYERS_BITS ) - 1;
+
+    for( uint32_t i = 0; i < t.pixelCount; i++ )
+    {
+        const uint32_t packed  = src[ i ];
+        const uint32_t rays    = packed & raysMask;
+        const uint32_t anyHits = ( packed >> RAY_COST_RAYS_BITS ) & anyHitsMask;
+        const uint32_t layers =
+            ( packed >> ( RAY_COST_RAYS_BITS + RAY_COST_ANY_HITS_BITS ) ) & layersMask;
+
+        t.rays += rays;
+        t.anyHits += anyHits;
+        t.translucentLayers += layers;
+        t.maxRaysPerPixel              = std::max( t.maxRaysPerPixel, rays );
+        t.maxAnyHitsPerPixel           = std::max( t.maxAnyHitsPerPixel, anyHits );
+        t.maxTranslucentLayersPerPixel = std::max( t.maxTranslucentLayersPerPixel, layers );
+        t.anyHitPixelCount += anyHits > 0 ? 1 : 0;
+    }
+
+    readback[ frameIndex ].Unmap();
+    totals = t;
+}
+
+void RTGL1::RayCostStats::CopyForReadback( VkCommandBuffer        cmd,
+                                           uint32_t               frameIndex,
+                                           const Framebuffers&    framebuffers,
+                                           const ResolutionState& resolutionState )
+{
+#if RAY_COST_STATS_ENABLED
+    auto [ image, view, format, extent ] =
+        framebuffers.GetImageHandles( FB_IMAGE_INDEX_RAY_COST, frameIndex, resolutionState );
+
+    const VkDeviceSize size = VkDeviceSize( extent.width ) * extent.height * sizeof( uint32_t );
+
+    Buffer& dst = readback[ frameIndex ];
+    if( dst.GetSize() < size )
+    {
+        auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_STAGING };
+
+        // allocated only when a ray cost view is shown for the first time
+        dst.Destroy();
+        dst.Init( *allocator,
+                  size,
+                  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                  "Ray cost readback" );
+    }
+
+    constexpr VkPipelineStageFlags2 shaderStages =
+        VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+
+    constexpr auto subresource = VkImageSubresourceRange{
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel   = 0,
+        .levelCount     = 1,
+        .baseArrayLayer = 0,
+        .layerCount     = 1,
+    };
+
+    {
+        auto b = VkImageMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext               = nullptr,
+            .srcStageMask        = shaderStages,
+            .srcAccessMask       = VK_ACCESS_2_SHADER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_GENERAL,
+            .newLayout           = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = image,
+            .subresourceRange    = subresource,
+        };
+
+        auto dep = VkDependencyInfo{
+            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers    = &b,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    auto region = VkBufferImageCopy{
+        .bufferOffset      = 0,
+        .bufferRowLength   = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource  = {
+             .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+             .mipLevel       = 0,
+             .baseArrayLayer = 0,
+             .layerCount     = 1,
+        },
+        .imageOffset = {},
+        .imageExtent = { extent.width, extent.height, 1 },
+    };
+
+    vkCmdCopyImageToBuffer( cmd, image, VK_IMAGE_LAYOUT_GENERAL, dst.GetBuffer(), 1, &region );
+
+    {
+        // the next frame's ray tracing passes overwrite the image
+        auto ib = VkImageMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext               = nullptr,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .srcAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+            .dstStageMask        = shaderStages,
+            .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT,
+            .oldLayout           = VK_IMAGE_LAYOUT_GENERAL,
+            .newLayout           = VK_IMAGE_LAYOUT_GENERAL,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = image,
+            .subresourceRange    = subresource,
+        };
+
+        auto bb = VkBufferMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,
+            .dstAccessMask       = VK_ACCESS_2_HOST_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = dst.GetBuffer(),
+            .offset              = 0,
+            .size                = VK_WHOLE_SIZE,
+        };
+
+        auto dep = VkDependencyInfo{
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &bb,
+            .imageMemoryBarrierCount  = 1,
+            .pImageMemoryBarriers     = &ib,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    copiedExtent[ frameIndex ] = extent;
+#endif
+}
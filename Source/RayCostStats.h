@@ -0,0 +1,83 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Buffer.h"
+#include "Framebuffers.h"
+
+#include "Generated/ShaderCommonC.h"
+
+namespace RTGL1
+{
+
+// Totals of the per-pixel ray cost counters (traced rays, any-hit invocations,
+// translucent layers), that are written by the ray tracing passes to FB_IMAGE_INDEX_RAY_COST.
+// The image is copied to the host only while a ray cost debug view is shown,
+// and is read back with MAX_FRAMES_IN_FLIGHT latency, so no stall is introduced.
+class RayCostStats
+{
+public:
+    struct Totals
+    {
+        uint32_t pixelCount;
+        uint64_t rays;
+        uint64_t anyHits;
+        uint64_t translucentLayers;
+        uint32_t maxRaysPerPixel;
+        uint32_t maxAnyHitsPerPixel;
+        uint32_t maxTranslucentLayersPerPixel;
+        // pixels that have at least one any-hit invocation
+        uint32_t anyHitPixelCount;
+    };
+
+    static constexpr uint32_t DebugShowFlags = DEBUG_SHOW_FLAG_RAY_COST | DEBUG_SHOW_FLAG_ANY_HIT |
+                                               DEBUG_SHOW_FLAG_TRANSLUCENT_OVERDRAW;
+
+    explicit RayCostStats( std::shared_ptr< MemoryAllocator > allocator );
+    ~RayCostStats() = default;
+
+    RayCostStats( const RayCostStats& other )                = delete;
+    RayCostStats( RayCostStats&& other ) noexcept            = delete;
+    RayCostStats& operator=( const RayCostStats& other )     = delete;
+    RayCostStats& operator=( RayCostStats&& other ) noexcept = delete;
+
+    // Must be called after the fence of 'frameIndex' was waited
+    void ReadBack( uint32_t frameIndex );
+
+    // Must be called after the last ray tracing pass of the frame
+    void CopyForReadback( VkCommandBuffer        cmd,
+                          uint32_t               frameIndex,
+                          const Framebuffers&    framebuffers,
+                          const ResolutionState& resolutionState );
+
+    const std::optional< Totals >& GetTotals() const { return totals; }
+
+private:
+    std::shared_ptr< MemoryAllocator > allocator;
+
+    Buffer     readback[ MAX_FRAMES_IN_FLIGHT ]{};
+    VkExtent2D copiedExtent[ MAX_FRAMES_IN_FLIGHT ]{};
+
+    std::optional< Totals > totals{};
+};
+
+}
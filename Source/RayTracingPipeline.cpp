@@ -21,15 +21,29 @@
 #include "RayTracingPipeline.h"
 
 #include "Generated/ShaderCommonC.h"
+#include "HitchRecorder.h"
+#include "LibraryConfig.h"
 #include "Utils.h"
 
+#include <algorithm>
 #include <cstring>
+#include <future>
+#include <thread>
 
 namespace RTGL1
 {
+extern bool g_supportsOpacityMicromap;
+
 namespace
 {
 
+    constexpr uint32_t VENDOR_ID_AMD = 0x1002;
+
+    // for pipeline libraries: the largest payload is ShPayload (vec2, uint, uint),
+    // the hit attribute is vec2 barycentrics; see Shaders/Structs.h
+    constexpr uint32_t MAX_RAY_PAYLOAD_SIZE       = 16;
+    constexpr uint32_t MAX_RAY_HIT_ATTRIBUTE_SIZE = 8;
+
     template< uint32_t Count >
     VkPipelineLayout CreatePipelineLayout( VkDevice device,
                                            const VkDescriptorSetLayout ( &setLayouts )[ Count ] )
@@ -49,6 +63,76 @@ namespace
         return layout;
     }
 
+    // Let the driver spread the work of a deferred operation across the worker threads
+    VkResult JoinDeferredOperation( VkDevice device, VkDeferredOperationKHR op )
+    {
+        const uint32_t threadCount =
+            std::clamp( std::min( svkGetDeferredOperationMaxConcurrencyKHR( device, op ),
+                                  std::thread::hardware_concurrency() ),
+                        1u,
+                        16u );
+
+        auto join = [ device, op ]() {
+            VkResult r;
+            while( ( r = svkDeferredOperationJoinKHR( device, op ) ) == VK_THREAD_IDLE_KHR )
+            {
+                std::this_thread::yield();
+            }
+            return r;
+        };
+
+        auto workers = std::vector< std::future< VkResult > >{};
+        for( uint32_t i = 1; i < threadCount; i++ )
+        {
+            workers.push_back( std::async( std::launch::async, join ) );
+        }
+
+        // current thread participates too
+        join();
+        for( auto& w : workers )
+        {
+            w.wait();
+        }
+
+        return svkGetDeferredOperationResultKHR( device, op );
+    }
+
+    VkPipeline CreateRayTracingPipeline( VkDevice                                 device,
+                                         VkPipelineCache                          cache,
+                                         const VkRayTracingPipelineCreateInfoKHR& info,
+                                         bool                                     deferred )
+    {
+        VkPipeline             pipeline   = VK_NULL_HANDLE;
+        VkDeferredOperationKHR deferredOp = VK_NULL_HANDLE;
+
+        if( deferred )
+        {
+            VkResult r = svkCreateDeferredOperationKHR( device, nullptr, &deferredOp );
+            VK_CHECKERROR( r );
+        }
+
+        VkResult r = svkCreateRayTracingPipelinesKHR(
+            device, deferredOp, cache, 1, &info, nullptr, &pipeline );
+
+        if( r == VK_OPERATION_DEFERRED_KHR )
+        {
+            // everything that 'info' points to must be alive until the operation is complete
+            r = JoinDeferredOperation( device, deferredOp );
+        }
+        else if( r == VK_OPERATION_NOT_DEFERRED_KHR )
+        {
+            r = VK_SUCCESS;
+        }
+
+        if( deferredOp != VK_NULL_HANDLE )
+        {
+            svkDestroyDeferredOperationKHR( device, deferredOp, nullptr );
+        }
+
+        VK_CHECKERROR( r );
+        return pipeline;
+    }
+
 }
 }
 
@@ -71,9 +155,10 @@ RTGL1::RayTracingPipeline::RayTracingPipeline( VkDevice
                                                const RgInstanceCreateInfo&        _rgInfo )
     : device( _device )
     , physDevice( std::move( _physDevice ) )
+    , allocator( std::move( _allocator ) )
+    , pipelineCache( _shaderManager.GetPipelineCache() )
     , rtPipelineLayout( VK_NULL_HANDLE )
-    , rtPipeline( VK_NULL_HANDLE )
-    , copySBTFromStaging( false )
+    , activeVariantKey( SPEC_DYNAMIC )
     , groupBaseAlignment( 0 )
     , handleSize( 0 )
     , alignedHandleSize( 0 )
@@ -81,8 +166,6 @@ RTGL1::RayTracingPipeline::RayTracingPipeline( VkDevice
     , hitGroupCount( 0 )
     , missShaderCount( 0 )
 {
-    shaderBindingTable = std::make_shared< AutoBuffer >( std::move( _allocator ) );
-
     // all set layouts to be used
     VkDescriptorSetLayout setLayouts[] = {
         // ray tracing acceleration structures
@@ -123,14 +206,25 @@ RTGL1::RayTracingPipeline::RayTracingPipeline( VkDevice
             ? _rgInfo.lightmapTexCoordLayerIndex
             : 0xFF;
 
+    primarySpecConst =
+        SpecConst{ _rgInfo.primaryRaysMaxAlbedoLayers, lightmapLayerIndex, SPEC_DYNAMIC };
+
+    {
+        VkPhysicalDeviceProperties props = {};
+        vkGetPhysicalDeviceProperties( physDevice->Get(), &props );
+
+        // on AMD, inline ray queries are usually faster for coherent rays
+        preferRayQueryPrimary = LibConfig().rayQueryPrimary || props.vendorID == VENDOR_ID_AMD;
+    }
+
     // clang-format off
     // shader modules in the pipeline will have the exact order
     shaderStageInfos = {
-        ShaderStageInfo{ "RGenPrimary",         SpecConst{ _rgInfo.primaryRaysMaxAlbedoLayers, lightmapLayerIndex } },
-        ShaderStageInfo{ "RGenReflRefr",        SpecConst{ _rgInfo.primaryRaysMaxAlbedoLayers, lightmapLayerIndex } },
+        ShaderStageInfo{ "RGenPrimary",         SpecConst{ _rgInfo.primaryRaysMaxAlbedoLayers, lightmapLayerIndex, SPEC_DYNAMIC } },
+        ShaderStageInfo{ "RGenReflRefr",        SpecConst{ _rgInfo.primaryRaysMaxAlbedoLayers, lightmapLayerIndex, SPEC_DYNAMIC } },
         ShaderStageInfo{ "RGenDirect",          {} },
-        ShaderStageInfo{ "RGenIndirectInit",    SpecConst{ _rgInfo.indirectIlluminationMaxAlbedoLayers, lightmapLayerIndex } },
-    //  ShaderStageInfo{ "RGenIndirectFinal",   SpecConst{ _rgInfo.indirectIlluminationMaxAlbedoLayers, lightmapLayerIndex } },
+        ShaderStageInfo{ "RGenIndirectInit",    SpecConst{ _rgInfo.indirectIlluminationMaxAlbedoLayers, lightmapLayerIndex, SPEC_DYNAMIC } },
+    //  ShaderStageInfo{ "RGenIndirectFinal",   SpecConst{ _rgInfo.indirectIlluminationMaxAlbedoLayers, lightmapLayerIndex, SPEC_DYNAMIC } },
         ShaderStageInfo{ "RGenGradients",       {} },
         ShaderStageInfo{ "RInitialReservoirs",  {} },
         ShaderStageInfo{ "RVolumetric",         {} },
@@ -177,24 +271,42 @@ RTGL1::RayTracingPipeline::RayTracingPipeline( VkDevice
     // alpha tested and then opaque
     AddHitGroup( toIndex( "RClsOpaque" ), toIndex( "RAlphaTest" ) ); assert( hitGroupCount - 1 == SBT_INDEX_HITGROUP_ALPHA_TESTED );
 
+    useLibraries = LibConfig().rayTracingPipelineLibraries;
+    if( useLibraries )
+    {
+        CreateLibraryInfos();
+    }
+
     CreatePipeline( &_shaderManager );
-    CreateSBT();
 }
 
 RTGL1::RayTracingPipeline::~RayTracingPipeline()
 {
     DestroyPipeline();
+    DestroyLibraries( nullptr );
     vkDestroyPipelineLayout( device, rtPipelineLayout, nullptr );
 }
 
 void RTGL1::RayTracingPipeline::CreatePipeline( const ShaderManager* shaderManager )
 {
-    std::vector< VkPipelineShaderStageCreateInfo > stages;
+    assert( variants.empty() && !pendingVariant.valid() );
+
+    stageModules.clear();
     for( const auto& s : shaderStageInfos )
     {
-        stages.push_back( shaderManager->GetStageInfo( s.name ) );
+        stageModules.push_back( shaderManager->GetStageInfo( s.name ) );
     }
 
+    // uber-shader: always available, reads the settings from the global uniform
+    AddVariant( SPEC_DYNAMIC, CompilePipeline( stageModules, SPEC_DYNAMIC ) );
+
+    CreateComputePipelines( shaderManager );
+}
+
+VkPipeline RTGL1::RayTracingPipeline::CompilePipeline(
+    std::vector< VkPipelineShaderStageCreateInfo > stages, uint32_t reflRefrMaxDepth )
+{
+    RG_HITCH_MARKER( "Pipeline creation: ray tracing" );
 
     constexpr VkSpecializationMapEntry specEntryCommonDef[ SpecConst::MemberCount ] = {
         {
@@ -207,12 +319,22 @@ void RTGL1::RayTracingPipeline::CreatePipeline( const ShaderManager* shaderManag
             .offset     = offsetof( SpecConst, lightmapLayerIndex ),
             .size       = sizeof( SpecConst::lightmapLayerIndex ),
         },
+        {
+            .constantID = 2,
+            .offset     = offsetof( SpecConst, reflRefrMaxDepth ),
+            .size       = sizeof( SpecConst::reflRefrMaxDepth ),
+        },
     };
-    static_assert( SpecConst::MemberCount == 2 );
-    static_assert( specEntryCommonDef[ 0 ].size + specEntryCommonDef[ 1 ].size ==
+    static_assert( SpecConst::MemberCount == 3 );
+    static_assert( specEntryCommonDef[ 0 ].size + specEntryCommonDef[ 1 ].size +
+                       specEntryCommonDef[ 2 ].size ==
                    sizeof( SpecConst ) );
 
 
+    // per-variant copies, must be alive until the pipeline is compiled
+    std::vector< SpecConst > specData;
+    specData.reserve( shaderStageInfos.size() );
+
     std::vector< VkSpecializationInfo > specInfos;
     for( const auto& s : shaderStageInfos )
     {
@@ -220,12 +342,15 @@ void RTGL1::RayTracingPipeline::CreatePipeline( const ShaderManager* shaderManag
 
         if( s.specConst )
         {
+            SpecConst& data       = specData.emplace_back( s.specConst.value() );
+            data.reflRefrMaxDepth = reflRefrMaxDepth;
+
             specInfo = {
                 .mapEntryCount = std::size( specEntryCommonDef ),
                 .pMapEntries   = specEntryCommonDef,
-                .dataSize      = sizeof( s.specConst.value() ),
+                .dataSize      = sizeof( data ),
                 // need to be careful with addresses
-                .pData = &( s.specConst.value() ),
+                .pData = &data,
             };
         }
         else
@@ -247,12 +372,23 @@ void RTGL1::RayTracingPipeline::CreatePipeline( const ShaderManager* shaderManag
         }
     }
 
+    // to resolve alpha test directly in traversal
+    const VkPipelineCreateFlags flags =
+        g_supportsOpacityMicromap ? VK_PIPELINE_CREATE_RAY_TRACING_OPACITY_MICROMAP_BIT_EXT : 0;
+
+    if( useLibraries )
+    {
+        // 'stages', 'specInfos' and 'specData' must be alive until the libraries are compiled
+        return LinkLibraries( stages, reflRefrMaxDepth, flags );
+    }
+
     VkPipelineLibraryCreateInfoKHR libInfo = {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
     };
 
     VkRayTracingPipelineCreateInfoKHR pipelineInfo = {
         .sType                        = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR,
+        .flags                        = flags,
         .stageCount                   = static_cast< uint32_t >( stages.size() ),
         .pStages                      = stages.data(),
         .groupCount                   = static_cast< uint32_t >( shaderGroups.size() ),
@@ -267,13 +403,206 @@ void RTGL1::RayTracingPipeline::CreatePipeline( const ShaderManager* shaderManag
         .layout                       = rtPipelineLayout,
     };
 
-    VkResult r = svkCreateRayTracingPipelinesKHR(
-        device, VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &rtPipeline );
+    // 'stages', 'specInfos' and 'specData' must be alive until the operation is complete
+    VkPipeline rtPipeline = CreateRayTracingPipeline( device, pipelineCache, pipelineInfo, true );
 
-    VK_CHECKERROR( r );
-    SET_DEBUG_NAME( device, rtPipeline, VK_OBJECT_TYPE_PIPELINE, "Ray tracing pipeline" );
+    SET_DEBUG_NAME( device,
+                    rtPipeline,
+                    VK_OBJECT_TYPE_PIPELINE,
+                    reflRefrMaxDepth == SPEC_DYNAMIC ? "Ray tracing pipeline"
+                                                     : "Ray tracing pipeline (specialized)" );
 
-    CreateComputePipelines( shaderManager );
+    return rtPipeline;
+}
+
+void RTGL1::RayTracingPipeline::CreateLibraryInfos()
+{
+    assert( libraryInfos.empty() );
+
+    auto addStage = [ this ]( LibraryInfo& lib, uint32_t stageIndex ) {
+        if( stageIndex == VK_SHADER_UNUSED_KHR )
+        {
+            return VK_SHADER_UNUSED_KHR;
+        }
+
+        auto f = std::ranges::find( lib.stages, stageIndex );
+        if( f != lib.stages.end() )
+        {
+            return uint32_t( std::distance( lib.stages.begin(), f ) );
+        }
+
+        lib.stages.push_back( stageIndex );
+        lib.specialized |= shaderStageInfos[ stageIndex ].specConst.has_value();
+        return uint32_t( lib.stages.size() - 1 );
+    };
+
+    auto addGroup = [ &addStage ]( LibraryInfo& lib, VkRayTracingShaderGroupCreateInfoKHR group ) {
+        group.generalShader      = addStage( lib, group.generalShader );
+        group.closestHitShader   = addStage( lib, group.closestHitShader );
+        group.anyHitShader       = addStage( lib, group.anyHitShader );
+        group.intersectionShader = addStage( lib, group.intersectionShader );
+
+        lib.groups.push_back( group );
+    };
+
+    // a library per raygen, so reloading / specializing one of them doesn't touch the others
+    for( uint32_t i = 0; i < raygenShaderCount; i++ )
+    {
+        addGroup( libraryInfos.emplace_back(), shaderGroups[ i ] );
+    }
+
+    // miss and hit groups are shared by all raygens
+    LibraryInfo& shared = libraryInfos.emplace_back();
+    for( uint32_t i = raygenShaderCount; i < shaderGroups.size(); i++ )
+    {
+        addGroup( shared, shaderGroups[ i ] );
+    }
+}
+
+VkPipeline RTGL1::RayTracingPipeline::CompileLibrary(
+    uint32_t                                              libraryIndex,
+    const std::vector< VkPipelineShaderStageCreateInfo >& stages,
+    VkPipelineCreateFlags                                 flags ) const
+{
+    RG_HITCH_MARKER( "Pipeline creation: ray tracing library" );
+
+    const LibraryInfo& lib = libraryInfos[ libraryIndex ];
+
+    auto libStages = std::vector< VkPipelineShaderStageCreateInfo >{};
+    for( uint32_t s : lib.stages )
+    {
+        libStages.push_back( stages[ s ] );
+    }
+
+    VkRayTracingPipelineInterfaceCreateInfoKHR interfaceInfo = {
+        .sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_INTERFACE_CREATE_INFO_KHR,
+        .maxPipelineRayPayloadSize      = MAX_RAY_PAYLOAD_SIZE,
+        .maxPipelineRayHitAttributeSize = MAX_RAY_HIT_ATTRIBUTE_SIZE,
+    };
+
+    VkRayTracingPipelineCreateInfoKHR libraryInfo = {
+        .sType                        = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR,
+        .flags                        = flags | VK_PIPELINE_CREATE_LIBRARY_BIT_KHR,
+        .stageCount                   = static_cast< uint32_t >( libStages.size() ),
+        .pStages                      = libStages.data(),
+        .groupCount                   = static_cast< uint32_t >( lib.groups.size() ),
+        .pGroups                      = lib.groups.data(),
+        .maxPipelineRayRecursionDepth = 1,
+        .pLibraryInterface            = &interfaceInfo,
+        .layout                       = rtPipelineLayout,
+    };
+
+    // libraries are already compiled in parallel, no need to defer
+    VkPipeline library = CreateRayTracingPipeline( device, pipelineCache, libraryInfo, false );
+
+    SET_DEBUG_NAME( device,
+                    library,
+                    VK_OBJECT_TYPE_PIPELINE,
+                    libraryIndex < raygenShaderCount
+                        ? shaderStageInfos[ lib.stages[ 0 ] ].name.data()
+                        : "Ray tracing pipeline library: miss and hit groups" );
+
+    return library;
+}
+
+VkPipeline RTGL1::RayTracingPipeline::LinkLibraries(
+    const std::vector< VkPipelineShaderStageCreateInfo >& stages,
+    uint32_t                                              reflRefrMaxDepth,
+    VkPipelineCreateFlags                                 flags )
+{
+    auto makeKey = [ this, reflRefrMaxDepth ]( uint32_t libraryIndex ) {
+        uint32_t spec = libraryInfos[ libraryIndex ].specialized ? reflRefrMaxDepth : SPEC_DYNAMIC;
+        return uint64_t( libraryIndex ) << 32 | spec;
+    };
+
+    // compile the missing ones, each on its own thread
+    {
+        auto compiling = std::vector< std::pair< uint64_t, std::future< VkPipeline > > >{};
+
+        for( uint32_t i = 0; i < libraryInfos.size(); i++ )
+        {
+            if( !libraries.contains( makeKey( i ) ) )
+            {
+                compiling.emplace_back( makeKey( i ),
+                                        std::async( std::launch::async,
+                                                    &RayTracingPipeline::CompileLibrary,
+                                                    this,
+                                                    i,
+                                                    std::cref( stages ),
+                                                    flags ) );
+            }
+        }
+
+        for( auto& [ key, f ] : compiling )
+        {
+            libraries[ key ] = f.get();
+        }
+    }
+
+    // in the order of 'shaderGroups', so the SBT layout is the same as for a monolithic pipeline
+    auto toLink = std::vector< VkPipeline >{};
+    for( uint32_t i = 0; i < libraryInfos.size(); i++ )
+    {
+        toLink.push_back( libraries.at( makeKey( i ) ) );
+    }
+
+    VkPipelineLibraryCreateInfoKHR libInfo = {
+        .sType        = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+        .libraryCount = static_cast< uint32_t >( toLink.size() ),
+        .pLibraries   = toLink.data(),
+    };
+
+    VkRayTracingPipelineInterfaceCreateInfoKHR interfaceInfo = {
+        .sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_INTERFACE_CREATE_INFO_KHR,
+        .maxPipelineRayPayloadSize      = MAX_RAY_PAYLOAD_SIZE,
+        .maxPipelineRayHitAttributeSize = MAX_RAY_HIT_ATTRIBUTE_SIZE,
+    };
+
+    VkRayTracingPipelineCreateInfoKHR pipelineInfo = {
+        .sType                        = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR,
+        .flags                        = flags,
+        .stageCount                   = 0,
+        .groupCount                   = 0,
+        .maxPipelineRayRecursionDepth = 1,
+        .pLibraryInfo                 = &libInfo,
+        .pLibraryInterface            = &interfaceInfo,
+        .layout                       = rtPipelineLayout,
+    };
+
+    VkPipeline rtPipeline = CreateRayTracingPipeline( device, pipelineCache, pipelineInfo, true );
+
+    SET_DEBUG_NAME( device,
+                    rtPipeline,
+                    VK_OBJECT_TYPE_PIPELINE,
+                    reflRefrMaxDepth == SPEC_DYNAMIC
+                        ? "Ray tracing pipeline (linked)"
+                        : "Ray tracing pipeline (linked, specialized)" );
+
+    return rtPipeline;
+}
+
+void RTGL1::RayTracingPipeline::DestroyLibraries( const ShaderManager* changedIn )
+{
+    std::erase_if( libraries, [ & ]( const auto& kv ) {
+        const auto& [ key, library ] = kv;
+
+        if( changedIn )
+        {
+            const LibraryInfo& lib = libraryInfos[ key >> 32 ];
+
+            bool changed = std::ranges::any_of( lib.stages, [ & ]( uint32_t s ) {
+                return changedIn->AnyChanged( { shaderStageInfos[ s ].name } );
+            } );
+
+            if( !changed )
+            {
+                return false;
+            }
+        }
+
+        vkDestroyPipeline( device, library, nullptr );
+        return true;
+    } );
 }
 
 void RTGL1::RayTracingPipeline::CreateComputePipelines( const ShaderManager* shaderManager )
@@ -287,24 +616,116 @@ void RTGL1::RayTracingPipeline::CreateComputePipelines( const ShaderManager* sha
             .layout = rtPipelineLayout,
         };
 
-        VkResult r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &info, nullptr, &compPipelineIndirectFinal );
+        VkResult r = vkCreateComputePipelines( device,
+                                               shaderManager->GetPipelineCache(),
+                                               1,
+                                               &info,
+                                               nullptr,
+                                               &compPipelineIndirectFinal );
         VK_CHECKERROR( r );
         SET_DEBUG_NAME(
             device, compPipelineIndirectFinal, VK_OBJECT_TYPE_PIPELINE, "CmIndirectFinal" );
     }
+
+    constexpr VkSpecializationMapEntry primarySpecEntries[] = {
+        {
+            .constantID = 0,
+            .offset     = offsetof( SpecConst, maxAlbedoLayers ),
+            .size       = sizeof( SpecConst::maxAlbedoLayers ),
+        },
+        {
+            .constantID = 1,
+            .offset     = offsetof( SpecConst, lightmapLayerIndex ),
+            .size       = sizeof( SpecConst::lightmapLayerIndex ),
+        },
+    };
+
+    const VkSpecializationInfo primarySpecInfo = {
+        .mapEntryCount = std::size( primarySpecEntries ),
+        .pMapEntries   = primarySpecEntries,
+        .dataSize      = sizeof( primarySpecConst ),
+        .pData         = &primarySpecConst,
+    };
+
+    // not loaded, if ray queries are not supported
+    if( preferRayQueryPrimary && shaderManager->GetShaderModule( "CRayQueryPrimary" ) )
+    {
+        VkComputePipelineCreateInfo info = {
+            .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .pNext  = nullptr,
+            .flags  = 0,
+            .stage  = shaderManager->GetStageInfo( "CRayQueryPrimary" ),
+            .layout = rtPipelineLayout,
+        };
+        info.stage.pSpecializationInfo = &primarySpecInfo;
+
+        VkResult r = vkCreateComputePipelines( device,
+                                               shaderManager->GetPipelineCache(),
+                                               1,
+                                               &info,
+                                               nullptr,
+                                               &compPipelinePrimary );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME(
+            device, compPipelinePrimary, VK_OBJECT_TYPE_PIPELINE, "CRayQueryPrimary" );
+    }
+
+    // not loaded, if ray queries are not supported
+    if( LibConfig().primaryVisibilityBuffer &&
+        shaderManager->GetShaderModule( "CVisibilityResolve" ) )
+    {
+        VkComputePipelineCreateInfo info = {
+            .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+            .pNext  = nullptr,
+            .flags  = 0,
+            .stage  = shaderManager->GetStageInfo( "CVisibilityResolve" ),
+            .layout = rtPipelineLayout,
+        };
+        info.stage.pSpecializationInfo = &primarySpecInfo;
+
+        VkResult r = vkCreateComputePipelines( device,
+                                               shaderManager->GetPipelineCache(),
+                                               1,
+                                               &info,
+                                               nullptr,
+                                               &compPipelineVisibilityResolve );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device,
+                        compPipelineVisibilityResolve,
+                        VK_OBJECT_TYPE_PIPELINE,
+                        "CVisibilityResolve" );
+    }
 }
 
 void RTGL1::RayTracingPipeline::DestroyPipeline()
 {
-    vkDestroyPipeline( device, rtPipeline, nullptr );
-    rtPipeline = VK_NULL_HANDLE;
+    if( pendingVariant.valid() )
+    {
+        vkDestroyPipeline( device, pendingVariant.get(), nullptr );
+    }
+
+    for( auto& [ key, v ] : variants )
+    {
+        v.shaderBindingTable->Destroy();
+        vkDestroyPipeline( device, v.pipeline, nullptr );
+    }
+    variants.clear();
+    activeVariantKey = SPEC_DYNAMIC;
+
     vkDestroyPipeline( device, compPipelineIndirectFinal, nullptr );
     compPipelineIndirectFinal = VK_NULL_HANDLE;
+
+    vkDestroyPipeline( device, compPipelinePrimary, nullptr );
+    compPipelinePrimary = VK_NULL_HANDLE;
+
+    vkDestroyPipeline( device, compPipelineVisibilityResolve, nullptr );
+    compPipelineVisibilityResolve = VK_NULL_HANDLE;
 }
 
-void RTGL1::RayTracingPipeline::CreateSBT()
+void RTGL1::RayTracingPipeline::AddVariant( uint32_t reflRefrMaxDepth, VkPipeline pipeline )
 {
+    assert( !variants.contains( reflRefrMaxDepth ) );
+
     uint32_t groupCount = uint32_t( shaderGroups.size() );
     groupBaseAlignment  = physDevice->GetRTPipelineProperties().shaderGroupBaseAlignment;
 
@@ -313,18 +734,19 @@ void RTGL1::RayTracingPipeline::CreateSBT()
 
     uint32_t sbtSize = alignedHandleSize * groupCount;
 
-    shaderBindingTable->Create( sbtSize,
-                                VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR |
-                                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-                                "SBT",
-                                1 );
+    auto sbt = std::make_shared< AutoBuffer >( allocator );
+    sbt->Create( sbtSize,
+                 VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR |
+                     VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                 "SBT",
+                 1 );
 
     std::vector< uint8_t > shaderHandles( uint64_t( handleSize * groupCount ) );
     VkResult               r = svkGetRayTracingShaderGroupHandlesKHR(
-        device, rtPipeline, 0, groupCount, shaderHandles.size(), shaderHandles.data() );
+        device, pipeline, 0, groupCount, shaderHandles.size(), shaderHandles.data() );
     VK_CHECKERROR( r );
 
-    auto* mapped = shaderBindingTable->GetMappedAs< uint8_t* >( 0 );
+    auto* mapped = sbt->GetMappedAs< uint8_t* >( 0 );
 
     for( uint32_t i = 0; i < groupCount; i++ )
     {
@@ -333,23 +755,52 @@ void RTGL1::RayTracingPipeline::CreateSBT()
                 handleSize );
     }
 
-    copySBTFromStaging = true;
+    variants[ reflRefrMaxDepth ] = Variant{
+        .pipeline           = pipeline,
+        .shaderBindingTable = std::move( sbt ),
+        .copySBTFromStaging = true,
+    };
 }
 
-void RTGL1::RayTracingPipeline::DestroySBT()
+auto RTGL1::RayTracingPipeline::GetShaderTableSafely_RayTracing( VkCommandBuffer cmd,
+                                                                 uint32_t reflRefrMaxDepth )
+    -> VkPipeline
 {
-    shaderBindingTable->Destroy();
-}
+    if( pendingVariant.valid() &&
+        pendingVariant.wait_for( std::chrono::seconds( 0 ) ) == std::future_status::ready )
+    {
+        AddVariant( pendingVariantKey, pendingVariant.get() );
+    }
 
-auto RTGL1::RayTracingPipeline::GetShaderTableSafely_RayTracing( VkCommandBuffer cmd ) -> VkPipeline
-{
-    if( copySBTFromStaging )
+    auto f = variants.find( reflRefrMaxDepth );
+
+    if( f == variants.end() )
     {
-        shaderBindingTable->CopyFromStaging( cmd, 0 );
-        copySBTFromStaging = false;
+        // compile in background, use the uber-shader meanwhile
+        if( !pendingVariant.valid() )
+        {
+            pendingVariantKey = reflRefrMaxDepth;
+            pendingVariant    = std::async( std::launch::async,
+                                         &RayTracingPipeline::CompilePipeline,
+                                         this,
+                                         stageModules,
+                                         reflRefrMaxDepth );
+        }
+
+        f = variants.find( SPEC_DYNAMIC );
+        assert( f != variants.end() );
     }
 
-    return rtPipeline;
+    activeVariantKey = f->first;
+    Variant& active  = f->second;
+
+    if( active.copySBTFromStaging )
+    {
+        active.shaderBindingTable->CopyFromStaging( cmd, 0 );
+        active.copySBTFromStaging = false;
+    }
+
+    return active.pipeline;
 }
 
 auto RTGL1::RayTracingPipeline::GetPipelineIndirectFinal_Compute() -> VkPipeline
@@ -357,6 +808,16 @@ auto RTGL1::RayTracingPipeline::GetPipelineIndirectFinal_Compute() -> VkPipeline
     return compPipelineIndirectFinal;
 }
 
+auto RTGL1::RayTracingPipeline::GetPipelinePrimary_Compute() -> VkPipeline
+{
+    return compPipelinePrimary;
+}
+
+auto RTGL1::RayTracingPipeline::GetPipelineVisibilityResolve_Compute() -> VkPipeline
+{
+    return compPipelineVisibilityResolve;
+}
+
 void RTGL1::RayTracingPipeline::GetEntries( uint32_t                         sbtRayGenIndex,
                                             VkStridedDeviceAddressRegionKHR& raygenEntry,
                                             VkStridedDeviceAddressRegionKHR& missEntry,
@@ -372,7 +833,11 @@ void RTGL1::RayTracingPipeline::GetEntries( uint32_t                         sbt
             sbtRayGenIndex == SBT_INDEX_RAYGEN_INITIAL_RESERVOIRS ||
             sbtRayGenIndex == SBT_INDEX_RAYGEN_VOLUMETRIC );
 
-    VkDeviceAddress bufferAddress = shaderBindingTable->GetDeviceAddress();
+    // entries of the variant that was bound in GetShaderTableSafely_RayTracing
+    const auto active = variants.find( activeVariantKey );
+    assert( active != variants.end() );
+
+    VkDeviceAddress bufferAddress = active->second.shaderBindingTable->GetDeviceAddress();
 
     uint64_t        offset = 0;
 
@@ -412,11 +877,32 @@ VkPipelineLayout RTGL1::RayTracingPipeline::GetLayout() const
 
 void RTGL1::RayTracingPipeline::OnShaderReload( const ShaderManager* shaderManager )
 {
-    DestroySBT();
-    DestroyPipeline();
+    const bool rtChanged =
+        std::ranges::any_of( shaderStageInfos, [ & ]( const ShaderStageInfo& s ) {
+            return shaderManager->AnyChanged( { s.name } );
+        } );
 
-    CreatePipeline( shaderManager );
-    CreateSBT();
+    if( rtChanged )
+    {
+        // all variants are dropped, and will be compiled again on demand
+        DestroyPipeline();
+        // unchanged libraries are kept, so the pipeline is only relinked with the changed ones
+        DestroyLibraries( shaderManager );
+        CreatePipeline( shaderManager );
+    }
+    else if( shaderManager->AnyChanged(
+                 { "CmIndirectFinal", "CRayQueryPrimary", "CVisibilityResolve" } ) )
+    {
+        // ray tracing pipeline is not affected, keep it
+        vkDestroyPipeline( device, compPipelineIndirectFinal, nullptr );
+        compPipelineIndirectFinal = VK_NULL_HANDLE;
+        vkDestroyPipeline( device, compPipelinePrimary, nullptr );
+        compPipelinePrimary = VK_NULL_HANDLE;
+        vkDestroyPipeline( device, compPipelineVisibilityResolve, nullptr );
+        compPipelineVisibilityResolve = VK_NULL_HANDLE;
+
+        CreateComputePipelines( shaderManager );
+    }
 }
 
 void RTGL1::RayTracingPipeline::AddGeneralGroup( uint32_t generalIndex )
@@ -31,6 +31,8 @@
 #include "RestirBuffers.h"
 #include "Volumetric.h"
 
+#include <future>
+
 namespace RTGL1
 {
 
@@ -60,8 +62,16 @@ public:
     RayTracingPipeline& operator=( const RayTracingPipeline& other ) = delete;
     RayTracingPipeline& operator=( RayTracingPipeline&& other ) noexcept = delete;
 
-    auto GetShaderTableSafely_RayTracing( VkCommandBuffer cmd ) -> VkPipeline;
+    // Returns a pipeline specialized for the given settings, if it's already compiled.
+    // Otherwise, starts its compilation and returns the uber-shader pipeline
+    auto GetShaderTableSafely_RayTracing( VkCommandBuffer cmd, uint32_t reflRefrMaxDepth )
+        -> VkPipeline;
     auto GetPipelineIndirectFinal_Compute() -> VkPipeline;
+    // Inline ray query variant of primary rays, null if the ray tracing pipeline should be used
+    auto GetPipelinePrimary_Compute() -> VkPipeline;
+    // Material evaluation of primary surfaces from the visibility buffer; if not null,
+    // primary rays only write the visibility buffer
+    auto GetPipelineVisibilityResolve_Compute() -> VkPipeline;
 
     void                GetEntries( uint32_t                         sbtRayGenIndex,
                                     VkStridedDeviceAddressRegionKHR& raygenEntry,
@@ -76,8 +86,21 @@ private:
     void CreatePipeline( const ShaderManager* shaderManager );
     void CreateComputePipelines( const ShaderManager* shaderManager );
     void DestroyPipeline();
-    void CreateSBT();
-    void DestroySBT();
+
+    VkPipeline CompilePipeline( std::vector< VkPipelineShaderStageCreateInfo > stages,
+                                uint32_t                                       reflRefrMaxDepth );
+    void       AddVariant( uint32_t reflRefrMaxDepth, VkPipeline pipeline );
+
+    // Link the pipeline from the libraries, the missing ones are compiled in parallel.
+    // 'stages' must be already specialized for 'reflRefrMaxDepth'
+    VkPipeline LinkLibraries( const std::vector< VkPipelineShaderStageCreateInfo >& stages,
+                              uint32_t              reflRefrMaxDepth,
+                              VkPipelineCreateFlags flags );
+    VkPipeline CompileLibrary( uint32_t                                              libraryIndex,
+                               const std::vector< VkPipelineShaderStageCreateInfo >& stages,
+                               VkPipelineCreateFlags                                 flags ) const;
+    void       CreateLibraryInfos();
+    void       DestroyLibraries( const ShaderManager* changedIn );
 
     void AddGeneralGroup( uint32_t generalIndex );
 
@@ -89,12 +112,23 @@ private:
     void AddHitGroup( uint32_t closestHitIndex, uint32_t anyHitIndex, uint32_t intersectionIndex );
 
 private:
+    // Value of a specialization constant to make the shader read it from the global uniform
+    constexpr static uint32_t SPEC_DYNAMIC = 0xFFFFFFFF;
+
     struct SpecConst
     {
         uint32_t maxAlbedoLayers{ 0 };
         uint32_t lightmapLayerIndex{ 0 };
+        uint32_t reflRefrMaxDepth{ SPEC_DYNAMIC };
+
+        constexpr static int MemberCount = 3;
+    };
 
-        constexpr static int MemberCount = 2;
+    struct Variant
+    {
+        VkPipeline                    pipeline{ VK_NULL_HANDLE };
+        std::shared_ptr< AutoBuffer > shaderBindingTable{};
+        bool                          copySBTFromStaging{ false };
     };
 
     struct ShaderStageInfo
@@ -105,19 +139,43 @@ private:
         std::optional< SpecConst > specConst{};
     };
 
+    struct LibraryInfo
+    {
+        // indices in 'shaderStageInfos'
+        std::vector< uint32_t >                             stages{};
+        // shader indices are local to 'stages'
+        std::vector< VkRayTracingShaderGroupCreateInfoKHR > groups{};
+        bool                                                specialized{ false };
+    };
+
 private:
     VkDevice                                            device;
     std::shared_ptr< PhysicalDevice >                   physDevice;
+    std::shared_ptr< MemoryAllocator >                  allocator;
+    VkPipelineCache                                     pipelineCache;
 
     std::vector< ShaderStageInfo >                      shaderStageInfos;
+    std::vector< VkPipelineShaderStageCreateInfo >      stageModules;
 
     std::vector< VkRayTracingShaderGroupCreateInfoKHR > shaderGroups;
+    // a library per raygen and one for all miss and hit groups, in the order of 'shaderGroups'
+    bool                                                useLibraries{ false };
+    std::vector< LibraryInfo >                          libraryInfos;
+    // key is (library index, reflRefrMaxDepth), SPEC_DYNAMIC for non-specialized libraries;
+    // kept between shader reloads, only the libraries with changed shaders are recompiled
+    rgl::unordered_map< uint64_t, VkPipeline >          libraries;
     VkPipelineLayout                                    rtPipelineLayout;
-    VkPipeline                                          rtPipeline;
     VkPipeline                                          compPipelineIndirectFinal{};
-
-    std::shared_ptr< AutoBuffer >                       shaderBindingTable;
-    bool                                                copySBTFromStaging;
+    VkPipeline                                          compPipelinePrimary{};
+    VkPipeline                                          compPipelineVisibilityResolve{};
+    bool                                                preferRayQueryPrimary{ false };
+    SpecConst                                           primarySpecConst{};
+
+    // key is reflRefrMaxDepth, SPEC_DYNAMIC for the uber-shader
+    rgl::unordered_map< uint32_t, Variant >             variants;
+    uint32_t                                            activeVariantKey;
+    std::future< VkPipeline >                           pendingVariant;
+    uint32_t                                            pendingVariantKey{ SPEC_DYNAMIC };
 
     uint32_t                                            groupBaseAlignment;
     uint32_t                                            handleSize;
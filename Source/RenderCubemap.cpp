@@ -21,7 +21,9 @@
 #include "RenderCubemap.h"
 
 #include <algorithm>
+#include <bit>
 
+#include "CmdLabel.h"
 #include "Matrix.h"
 #include "RasterizedDataCollector.h"
 #include "Generated/ShaderCommonC.h"
@@ -46,6 +48,35 @@ namespace
         }
     };
 
+    struct SkyPrefilterPush
+    {
+        uint32_t dstSize;
+        float    alpha;
+    };
+
+    uint32_t GetCubemapMipCount( uint32_t sideSize )
+    {
+        // the smallest mip is at least 4x4
+        const uint32_t count = std::max( uint32_t( std::bit_width( sideSize ) ), 3u ) - 2;
+        return std::min( count, uint32_t( SKY_PREFILTER_MAX_MIP_COUNT ) );
+    }
+
+    // Mip 'm' has roughness m/(mipCount-1), and it's filtered from mip 'm-1',
+    // so only the missing part of a GGX lobe is applied
+    float GetIncrementalAlpha( uint32_t mip, uint32_t mipCount )
+    {
+        assert( mip > 0 && mipCount > 1 );
+
+        auto alpha = [ mipCount ]( uint32_t m ) {
+            float roughness = float( m ) / float( mipCount - 1 );
+            return roughness * roughness;
+        };
+
+        const float a     = alpha( mip );
+        const float aPrev = alpha( mip - 1 );
+        return std::max( std::sqrt( a * a - aPrev * aPrev ), 0.001f );
+    }
+
     VkMemoryRequirements GetImageMemoryRequirements( VkDevice device, VkImage image )
     {
         VkMemoryRequirements memReqs;
@@ -70,9 +101,15 @@ RTGL1::RenderCubemap::RenderCubemap( VkDevice                    _device,
     , cubemapDepth{}
     , cubemapFramebuffer( VK_NULL_HANDLE )
     , cubemapSize( std::max( _instanceInfo.rasterizedSkyCubemapSize, 16u ) )
+    , cubemapMipCount( GetCubemapMipCount( cubemapSize ) )
+    , cubemapAttchView( VK_NULL_HANDLE )
     , descSetLayout( VK_NULL_HANDLE )
     , descPool( VK_NULL_HANDLE )
     , descSet( VK_NULL_HANDLE )
+    , prefilterSetLayout( VK_NULL_HANDLE )
+    , prefilterPool( VK_NULL_HANDLE )
+    , prefilterPipelineLayout( VK_NULL_HANDLE )
+    , prefilterPipeline( VK_NULL_HANDLE )
 {
     CreatePipelineLayout( _textureManager.GetDescSetLayout(), _uniform.GetDescSetLayout() );
     CreateRenderPass();
@@ -80,14 +117,25 @@ RTGL1::RenderCubemap::RenderCubemap( VkDevice                    _device,
 
     VkCommandBuffer cmd = _cmdManager.StartGraphicsCmd();
     {
-        cubemap      = CreateAttch( _allocator, cmd, cubemapSize, false );
-        cubemapDepth = CreateAttch( _allocator, cmd, cubemapSize, true );
+        cubemap      = CreateAttch( _allocator, cmd, cubemapSize, cubemapMipCount, false );
+        cubemapDepth = CreateAttch( _allocator, cmd, cubemapSize, 1, true );
     }
     _cmdManager.Submit( cmd );
     _cmdManager.WaitGraphicsIdle();
 
+    if( cubemap.image != VK_NULL_HANDLE )
+    {
+        cubemapAttchView = CreateMipView( VK_IMAGE_VIEW_TYPE_2D_ARRAY, 0 );
+    }
+
     CreateFramebuffer( cubemapSize );
     CreateDescriptors( _samplerManager );
+
+    if( cubemapMipCount > 1 && cubemap.image != VK_NULL_HANDLE )
+    {
+        CreatePrefilterDescriptors( _samplerManager );
+        CreatePrefilterPipeline( _shaderManager );
+    }
 }
 
 RTGL1::RenderCubemap::~RenderCubemap()
@@ -97,8 +145,19 @@ RTGL1::RenderCubemap::~RenderCubemap()
     vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
     vkDestroyRenderPass( device, multiviewRenderPass, nullptr );
 
+    vkDestroyPipeline( device, prefilterPipeline, nullptr );
+    vkDestroyPipelineLayout( device, prefilterPipelineLayout, nullptr );
+    vkDestroyDescriptorPool( device, prefilterPool, nullptr );
+    vkDestroyDescriptorSetLayout( device, prefilterSetLayout, nullptr );
+    for( const PrefilterMip& m : prefilterMips )
+    {
+        vkDestroyImageView( device, m.srcView, nullptr );
+        vkDestroyImageView( device, m.dstView, nullptr );
+    }
+
     vkDestroyImage( device, cubemap.image, nullptr );
     vkDestroyImageView( device, cubemap.view, nullptr );
+    vkDestroyImageView( device, cubemapAttchView, nullptr );
     MemoryAllocator::FreeDedicated( device, cubemap.memory );
 
     vkDestroyImage( device, cubemapDepth.image, nullptr );
@@ -111,20 +170,81 @@ RTGL1::RenderCubemap::~RenderCubemap()
 void RTGL1::RenderCubemap::OnShaderReload( const ShaderManager* shaderManager )
 {
     pipelines->OnShaderReload( shaderManager );
+
+    if( !shaderManager->AnyChanged( { "VertDefaultMultiview", "FragSky", "CSkyPrefilter" } ) )
+    {
+        return;
+    }
+    drawnContentHash = std::nullopt;
+
+    if( prefilterPipelineLayout != VK_NULL_HANDLE &&
+        shaderManager->AnyChanged( { "CSkyPrefilter" } ) )
+    {
+        vkDestroyPipeline( device, prefilterPipeline, nullptr );
+        prefilterPipeline = VK_NULL_HANDLE;
+
+        CreatePrefilterPipeline( *shaderManager );
+    }
+}
+
+uint64_t RTGL1::RenderCubemap::HashSkyContent( const RasterizedDataCollector& skyDataCollector,
+                                               const TextureManager&          textureManager,
+                                               const GlobalUniform&           uniform ) const
+{
+    using ankerl::unordered_dense::detail::wyhash::hash;
+
+    auto hashCombine = []< typename T >( uint64_t& seed, const T& v ) {
+        seed ^= std::hash< T >{}( v ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+    };
+
+    // viewer position and near / far planes
+    const auto& viewProjCubemap = uniform.GetData()->viewProjCubemap;
+
+    uint64_t h = hash( viewProjCubemap, sizeof( viewProjCubemap ) );
+    hashCombine( h, skyDataCollector.GetSkyGeometryHash() );
+
+    // only the values that are used by RasterizedMultiviewPushConst
+    for( const auto& info : skyDataCollector.GetDrawInfos( GeometryRasterType::SKY ) )
+    {
+        hashCombine( h, hash( &info.transform, sizeof( info.transform ) ) );
+        hashCombine( h, info.colorFactor_base );
+        hashCombine( h, info.texture_base );
+        hashCombine( h, info.pipelineState );
+        hashCombine( h, reinterpret_cast< uintptr_t >(
+                            textureManager.GetTextureView( info.texture_base ) ) );
+    }
+
+    return h;
 }
 
 void RTGL1::RenderCubemap::Draw( VkCommandBuffer                cmd,
                                  uint32_t                       frameIndex,
                                  const RasterizedDataCollector& skyDataCollector,
                                  const TextureManager&          textureManager,
-                                 const GlobalUniform&           uniform )
+                                 const GlobalUniform&           uniform,
+                                 RgSkyCubemapUpdate             updateMode,
+                                 bool                           forceUpdate )
 {
     const auto& drawInfos = skyDataCollector.GetDrawInfos( GeometryRasterType::SKY );
     if( drawInfos.empty() )
     {
+        drawnContentHash = std::nullopt;
         return;
     }
 
+    // cubemap persists between frames, so redraw only if something has changed
+    const uint64_t contentHash = updateMode == RG_SKY_CUBEMAP_UPDATE_IF_CHANGED
+                                     ? HashSkyContent( skyDataCollector, textureManager, uniform )
+                                     : 0;
+
+    if( !forceUpdate && updateMode != RG_SKY_CUBEMAP_UPDATE_EVERY_FRAME &&
+        drawnContentHash == contentHash )
+    {
+        return;
+    }
+    // if the mode is changed to IF_CHANGED, the cubemap will be redrawn once
+    drawnContentHash = contentHash;
+
     VkDescriptorSet descSets[] = {
         textureManager.GetDescSet( frameIndex ),
         uniform.GetDescSet( frameIndex ),
@@ -203,6 +323,146 @@ void RTGL1::RenderCubemap::Draw( VkCommandBuffer                cmd,
     }
 
     vkCmdEndRenderPass( cmd );
+
+    Prefilter( cmd );
+}
+
+void RTGL1::RenderCubemap::Prefilter( VkCommandBuffer cmd )
+{
+    if( prefilterMips.empty() || prefilterPipeline == VK_NULL_HANDLE )
+    {
+        return;
+    }
+
+    CmdLabel label( cmd, "Sky cubemap prefilter" );
+
+    auto makeBarrier = [ this ]( uint32_t      baseMip,
+                                 uint32_t      mipCount,
+                                 VkAccessFlags srcAccess,
+                                 VkImageLayout oldLayout,
+                                 VkImageLayout newLayout ) {
+        return VkImageMemoryBarrier{
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+            .srcAccessMask       = srcAccess,
+            .dstAccessMask       = newLayout == VK_IMAGE_LAYOUT_GENERAL
+                                       ? VkAccessFlags( VK_ACCESS_SHADER_WRITE_BIT )
+                                       : VkAccessFlags( VK_ACCESS_SHADER_READ_BIT ),
+            .oldLayout           = oldLayout,
+            .newLayout           = newLayout,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = cubemap.image,
+            .subresourceRange    = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                                     .baseMipLevel   = baseMip,
+                                     .levelCount     = mipCount,
+                                     .baseArrayLayer = 0,
+                                     .layerCount     = 6 },
+        };
+    };
+
+    const uint32_t lastMip = cubemapMipCount - 1;
+
+    // rendered mip 0 is read, previous contents of the other mips are discarded
+    {
+        VkImageMemoryBarrier bs[] = {
+            makeBarrier( 0,
+                         1,
+                         VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ),
+            makeBarrier(
+                1, lastMip, 0, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL ),
+        };
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              0,
+                              0,
+                              nullptr,
+                              0,
+                              nullptr,
+                              std::size( bs ),
+                              bs );
+    }
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, prefilterPipeline );
+
+    for( uint32_t mip = 1; mip <= lastMip; mip++ )
+    {
+        if( mip > 1 )
+        {
+            // previous mip is a source now
+            VkImageMemoryBarrier b = makeBarrier( mip - 1,
+                                                  1,
+                                                  VK_ACCESS_SHADER_WRITE_BIT,
+                                                  VK_IMAGE_LAYOUT_GENERAL,
+                                                  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL );
+
+            vkCmdPipelineBarrier( cmd,
+                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                  0,
+                                  0,
+                                  nullptr,
+                                  0,
+                                  nullptr,
+                                  1,
+                                  &b );
+        }
+
+        vkCmdBindDescriptorSets( cmd,
+                                 VK_PIPELINE_BIND_POINT_COMPUTE,
+                                 prefilterPipelineLayout,
+                                 0,
+                                 1,
+                                 &prefilterMips[ mip - 1 ].descSet,
+                                 0,
+                                 nullptr );
+
+        SkyPrefilterPush push = {
+            .dstSize = std::max( cubemapSize >> mip, 1u ),
+            .alpha   = GetIncrementalAlpha( mip, cubemapMipCount ),
+        };
+
+        vkCmdPushConstants( cmd,
+                            prefilterPipelineLayout,
+                            VK_SHADER_STAGE_COMPUTE_BIT,
+                            0,
+                            sizeof( push ),
+                            &push );
+
+        const uint32_t groups = Utils::GetWorkGroupCount( push.dstSize,
+                                                          COMPUTE_SKY_PREFILTER_GROUP_SIZE );
+        vkCmdDispatch( cmd, groups, groups, 6 );
+    }
+
+    // make all of the prefiltered mips visible to ray tracing
+    {
+        VkImageMemoryBarrier bs[] = {
+            makeBarrier( lastMip,
+                         1,
+                         VK_ACCESS_SHADER_WRITE_BIT,
+                         VK_IMAGE_LAYOUT_GENERAL,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ),
+            makeBarrier( 1,
+                         lastMip - 1,
+                         VK_ACCESS_SHADER_WRITE_BIT,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL ),
+        };
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                              0,
+                              0,
+                              nullptr,
+                              0,
+                              nullptr,
+                              lastMip > 1 ? 2 : 1,
+                              bs );
+    }
 }
 
 VkDescriptorSetLayout RTGL1::RenderCubemap::GetDescSetLayout() const
@@ -363,8 +623,13 @@ void RTGL1::RenderCubemap::InitPipelines( const ShaderManager& shaderManager,
 RTGL1::RenderCubemap::Attachment RTGL1::RenderCubemap::CreateAttch( MemoryAllocator& allocator,
                                                                     VkCommandBuffer  cmd,
                                                                     uint32_t         sideSize,
+                                                                    uint32_t         mipCount,
                                                                     bool             isDepth )
 {
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_CUBEMAPS };
+
+    assert( !isDepth || mipCount == 1 );
+
     VkImage image;
     {
         VkImageCreateInfo imageInfo = {
@@ -373,13 +638,15 @@ RTGL1::RenderCubemap::Attachment RTGL1::RenderCubemap::CreateAttch( MemoryAlloca
             .imageType   = VK_IMAGE_TYPE_2D,
             .format      = isDepth ? CUBEMAP_DEPTH_FORMAT : CUBEMAP_FORMAT,
             .extent      = { sideSize, sideSize, 1 },
-            .mipLevels   = 1,
+            .mipLevels   = mipCount,
             .arrayLayers = 6,
             .samples     = VK_SAMPLE_COUNT_1_BIT,
             .tiling      = VK_IMAGE_TILING_OPTIMAL,
             .usage = isDepth ? VkImageUsageFlags( VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT )
                              : VkImageUsageFlags( VK_IMAGE_USAGE_SAMPLED_BIT |
-                                                  VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT ),
+                                                  VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+                                                  ( mipCount > 1 ? VK_IMAGE_USAGE_STORAGE_BIT
+                                                                 : 0 ) ),
             .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
         };
 
@@ -421,7 +688,7 @@ RTGL1::RenderCubemap::Attachment RTGL1::RenderCubemap::CreateAttch( MemoryAlloca
                                       isDepth ? VkImageAspectFlags( VK_IMAGE_ASPECT_DEPTH_BIT )
                                               : VkImageAspectFlags( VK_IMAGE_ASPECT_COLOR_BIT ),
                                   .baseMipLevel   = 0,
-                                  .levelCount     = 1,
+                                  .levelCount     = mipCount,
                                   .baseArrayLayer = 0,
                                   .layerCount     = 6 },
         };
@@ -470,7 +737,7 @@ RTGL1::RenderCubemap::Attachment RTGL1::RenderCubemap::CreateAttch( MemoryAlloca
             .image               = image,
             .subresourceRange    = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
                                      .baseMipLevel   = 0,
-                                     .levelCount     = 1,
+                                     .levelCount     = mipCount,
                                      .baseArrayLayer = 0,
                                      .layerCount     = 6 },
         };
@@ -496,16 +763,39 @@ RTGL1::RenderCubemap::Attachment RTGL1::RenderCubemap::CreateAttch( MemoryAlloca
     };
 }
 
+VkImageView RTGL1::RenderCubemap::CreateMipView( VkImageViewType viewType, uint32_t mip ) const
+{
+    VkImageViewCreateInfo viewInfo = {
+        .sType            = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image            = cubemap.image,
+        .viewType         = viewType,
+        .format           = CUBEMAP_FORMAT,
+        .subresourceRange = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                              .baseMipLevel   = mip,
+                              .levelCount     = 1,
+                              .baseArrayLayer = 0,
+                              .layerCount     = 6 },
+    };
+
+    VkImageView view;
+    VkResult    r = vkCreateImageView( device, &viewInfo, nullptr, &view );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, view, VK_OBJECT_TYPE_IMAGE_VIEW, "Render cubemap mip view" );
+
+    return view;
+}
+
 void RTGL1::RenderCubemap::CreateFramebuffer( uint32_t sideSize )
 {
-    if( cubemap.image == VK_NULL_HANDLE || cubemap.view == VK_NULL_HANDLE ||
+    if( cubemap.image == VK_NULL_HANDLE || cubemapAttchView == VK_NULL_HANDLE ||
         cubemapDepth.image == VK_NULL_HANDLE || cubemapDepth.view == VK_NULL_HANDLE )
     {
         return;
     }
 
     VkImageView attchs[] = {
-        cubemap.view,
+        cubemapAttchView,
         cubemapDepth.view,
     };
 
@@ -604,3 +894,174 @@ void RTGL1::RenderCubemap::CreateDescriptors( const SamplerManager& samplerManag
         vkUpdateDescriptorSets( device, 1, &wrt, 0, nullptr );
     }
 }
+
+void RTGL1::RenderCubemap::CreatePrefilterDescriptors( const SamplerManager& samplerManager )
+{
+    assert( cubemapMipCount > 1 );
+    const uint32_t setCount = cubemapMipCount - 1;
+
+    {
+        VkDescriptorSetLayoutBinding bindings[] = {
+            {
+                .binding         = BINDING_SKY_PREFILTER_SRC,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+            },
+            {
+                .binding         = BINDING_SKY_PREFILTER_DST,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+            },
+        };
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo = {
+            .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+            .bindingCount = std::size( bindings ),
+            .pBindings    = bindings,
+        };
+
+        VkResult r =
+            vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &prefilterSetLayout );
+
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device,
+                        prefilterSetLayout,
+                        VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+                        "Sky prefilter Desc set layout" );
+    }
+    {
+        VkDescriptorPoolSize poolSizes[] = {
+            {
+                .type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .descriptorCount = setCount,
+            },
+            {
+                .type            = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .descriptorCount = setCount,
+            },
+        };
+
+        VkDescriptorPoolCreateInfo poolInfo = {
+            .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets       = setCount,
+            .poolSizeCount = std::size( poolSizes ),
+            .pPoolSizes    = poolSizes,
+        };
+
+        VkResult r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &prefilterPool );
+
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME(
+            device, prefilterPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Sky prefilter Desc pool" );
+    }
+
+    const VkSampler sampler = samplerManager.GetSampler(
+        RG_SAMPLER_FILTER_LINEAR, RG_SAMPLER_ADDRESS_MODE_CLAMP, RG_SAMPLER_ADDRESS_MODE_CLAMP );
+
+    for( uint32_t mip = 1; mip < cubemapMipCount; mip++ )
+    {
+        PrefilterMip m = {
+            .srcView = CreateMipView( VK_IMAGE_VIEW_TYPE_CUBE, mip - 1 ),
+            .dstView = CreateMipView( VK_IMAGE_VIEW_TYPE_2D_ARRAY, mip ),
+            .descSet = VK_NULL_HANDLE,
+        };
+
+        VkDescriptorSetAllocateInfo setInfo = {
+            .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool     = prefilterPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts        = &prefilterSetLayout,
+        };
+
+        VkResult r = vkAllocateDescriptorSets( device, &setInfo, &m.descSet );
+
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME(
+            device, m.descSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Sky prefilter desc set" );
+
+        VkDescriptorImageInfo src = {
+            .sampler     = sampler,
+            .imageView   = m.srcView,
+            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        };
+
+        VkDescriptorImageInfo dst = {
+            .sampler     = VK_NULL_HANDLE,
+            .imageView   = m.dstView,
+            .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+        };
+
+        VkWriteDescriptorSet wrts[] = {
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = m.descSet,
+                .dstBinding      = BINDING_SKY_PREFILTER_SRC,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo      = &src,
+            },
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = m.descSet,
+                .dstBinding      = BINDING_SKY_PREFILTER_DST,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo      = &dst,
+            },
+        };
+
+        vkUpdateDescriptorSets( device, std::size( wrts ), wrts, 0, nullptr );
+
+        prefilterMips.push_back( m );
+    }
+
+    {
+        VkPushConstantRange push = {
+            .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+            .offset     = 0,
+            .size       = sizeof( SkyPrefilterPush ),
+        };
+
+        VkPipelineLayoutCreateInfo plLayoutInfo = {
+            .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+            .setLayoutCount         = 1,
+            .pSetLayouts            = &prefilterSetLayout,
+            .pushConstantRangeCount = 1,
+            .pPushConstantRanges    = &push,
+        };
+
+        VkResult r =
+            vkCreatePipelineLayout( device, &plLayoutInfo, nullptr, &prefilterPipelineLayout );
+
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device,
+                        prefilterPipelineLayout,
+                        VK_OBJECT_TYPE_PIPELINE_LAYOUT,
+                        "Sky prefilter pipeline layout" );
+    }
+}
+
+void RTGL1::RenderCubemap::CreatePrefilterPipeline( const ShaderManager& shaderManager )
+{
+    assert( prefilterPipelineLayout != VK_NULL_HANDLE && prefilterPipeline == VK_NULL_HANDLE );
+
+    VkComputePipelineCreateInfo plInfo = {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = shaderManager.GetStageInfo( "CSkyPrefilter" ),
+        .layout = prefilterPipelineLayout,
+    };
+
+    VkResult r = vkCreateComputePipelines( device,
+                                           shaderManager.GetPipelineCache(),
+                                           1,
+                                           &plInfo,
+                                           nullptr,
+                                           &prefilterPipeline );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, prefilterPipeline, VK_OBJECT_TYPE_PIPELINE, "Sky prefilter pipeline" );
+}
@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "Common.h"
 #include "GlobalUniform.h"
 #include "MemoryAllocator.h"
@@ -48,12 +50,14 @@ public:
     RenderCubemap&        operator=( const RenderCubemap& other ) = delete;
     RenderCubemap&        operator=( RenderCubemap&& other ) noexcept = delete;
 
-    // Draw to a cubemap
+    // Draw to a cubemap. Skipped, if the cubemap is up to date according to the update mode
     void                  Draw( VkCommandBuffer                cmd,
                                 uint32_t                       frameIndex,
                                 const RasterizedDataCollector& skyDataCollector,
                                 const TextureManager&          textureManager,
-                                const GlobalUniform&           uniform );
+                                const GlobalUniform&           uniform,
+                                RgSkyCubemapUpdate             updateMode,
+                                bool                           forceUpdate );
 
     VkDescriptorSetLayout GetDescSetLayout() const;
     VkDescriptorSet       GetDescSet() const;
@@ -79,9 +83,18 @@ private:
     [[nodiscard]] Attachment CreateAttch( MemoryAllocator& allocator,
                                           VkCommandBuffer  cmd,
                                           uint32_t         sideSize,
+                                          uint32_t         mipCount,
                                           bool             isDepth );
+    [[nodiscard]] VkImageView
+                             CreateMipView( VkImageViewType viewType, uint32_t mip ) const;
     void                     CreateFramebuffer( uint32_t sideSize );
     void                     CreateDescriptors( const SamplerManager& samplerManager );
+    void                     CreatePrefilterDescriptors( const SamplerManager& samplerManager );
+    void                     CreatePrefilterPipeline( const ShaderManager& shaderManager );
+    void                     Prefilter( VkCommandBuffer cmd );
+    [[nodiscard]] uint64_t   HashSkyContent( const RasterizedDataCollector& skyDataCollector,
+                                             const TextureManager&          textureManager,
+                                             const GlobalUniform&           uniform ) const;
 
 private:
     VkDevice                               device;
@@ -97,10 +110,32 @@ private:
     VkFramebuffer                          cubemapFramebuffer;
 
     uint32_t                               cubemapSize;
+    // mip 0 is rendered, others are GGX-prefiltered with increasing roughness
+    uint32_t                               cubemapMipCount;
+    // mip 0 only, as framebuffer attachments must have one mip
+    VkImageView                            cubemapAttchView;
 
     VkDescriptorSetLayout                  descSetLayout;
     VkDescriptorPool                       descPool;
     VkDescriptorSet                        descSet;
+
+    // null, if the cubemap must be redrawn
+    std::optional< uint64_t >              drawnContentHash;
+
+    struct PrefilterMip
+    {
+        // previous mip as a cube, current mip as an array of faces
+        VkImageView     srcView;
+        VkImageView     dstView;
+        VkDescriptorSet descSet;
+    };
+
+    // for mips 1 .. cubemapMipCount-1
+    std::vector< PrefilterMip >            prefilterMips;
+    VkDescriptorSetLayout                  prefilterSetLayout;
+    VkDescriptorPool                       prefilterPool;
+    VkPipelineLayout                       prefilterPipelineLayout;
+    VkPipeline                             prefilterPipeline;
 };
 
 }
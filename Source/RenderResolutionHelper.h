@@ -20,14 +20,17 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <optional>
 
 #include "DLSS2.h"
 #include "DLSS3_DX12.h"
 #include "FSR2.h"
 #include "FSR3_DX12.h"
 #include "RgException.h"
+#include "Generated/ShaderCommonC.h"
 #include "ResolutionState.h"
 
 #ifdef _MSC_VER
@@ -55,7 +58,8 @@ public:
                 const FSR2*                               fsr2,
                 const FSR3_DX12*                          fsr3dx12,
                 const DLSS2*                              dlss2,
-                const DLSS3_DX12*                         dlss3dx12 )
+                const DLSS3_DX12*                         dlss3dx12,
+                std::optional< float >                    dynamicScale )
     {
         // HACKHACK: render into something when the window is minimized
         if( windowWidth == 0 || windowHeight == 0 )
@@ -67,6 +71,9 @@ public:
         renderWidth  = windowWidth;
         renderHeight = windowHeight;
 
+        maxDynamicWidth  = 0;
+        maxDynamicHeight = 0;
+
         upscaledWidth  = windowWidth;
         upscaledHeight = windowHeight;
 
@@ -179,6 +186,24 @@ public:
                 renderHeight = params.customRenderSize.height;
             }
         }
+
+        // dynamic resolution overrides the size, but the mode is kept for the upscalers
+        if( dynamicScale )
+        {
+            renderWidth = std::max(
+                8u, static_cast< uint32_t >( static_cast< float >( windowWidth ) * *dynamicScale ) );
+            renderHeight = std::max(
+                8u, static_cast< uint32_t >( static_cast< float >( windowHeight ) * *dynamicScale ) );
+
+            // scale is at most 1, so the window size bounds any render size
+            maxDynamicWidth  = std::max( windowWidth, renderWidth );
+            maxDynamicHeight = std::max( windowHeight, renderHeight );
+        }
+
+        // only native DLSS has Ray Reconstruction
+        dlssRayReconstruction = params.dlssRayReconstruction &&
+                                upscaleTechnique == RG_RENDER_UPSCALE_TECHNIQUE_NVIDIA_DLSS &&
+                                dlss2 && !dlss3dx12 && dlss2->IsRayReconstructionAvailable();
     }
 
     float GetMipLodBias( float nativeBias = 0.0f ) const
@@ -197,7 +222,13 @@ public:
     }
 
     // Render width always must be even for checkerboarding!
-    uint32_t Width() const { return renderWidth + renderWidth % 2; }
+    // With multiple views, the width of each view must be even
+    uint32_t Width() const
+    {
+        const uint32_t a = 2 * viewCount;
+        return ( renderWidth + a - 1 ) / a * a;
+    }
+    uint32_t ViewWidth() const { return Width() / viewCount; }
     uint32_t Height() const { return renderHeight; }
 
     uint32_t UpscaledWidth() const { return upscaledWidth; }
@@ -209,7 +240,8 @@ public:
         {
             return 1.0f;
         }
-        return float( UpscaledWidth() ) / float( UpscaledHeight() );
+        // of one view
+        return float( UpscaledWidth() ) / float( viewCount ) / float( UpscaledHeight() );
     }
 
     bool IsAmdFsr2Enabled() const
@@ -220,7 +252,36 @@ public:
     {
         return upscaleTechnique == RG_RENDER_UPSCALE_TECHNIQUE_NVIDIA_DLSS;
     }
+    // Stereo is two views, and it overrides 'views'
+    void SetupViews( const RgStartFrameViewsParams& views, const RgStartFrameStereoParams& stereo )
+    {
+        if( stereo.sideBySide )
+        {
+            viewCount     = 2;
+            stereoHalfIpd = 0.5f * std::max( 0.0f, stereo.interpupillaryDistance );
+        }
+        else
+        {
+            viewCount     = std::clamp< uint32_t >( views.viewCount, 1, MAX_VIEW_COUNT );
+            stereoHalfIpd = std::nullopt;
+        }
+    }
+
+    // Side-by-side stereo: the left eye is in the left half of the render target.
+    // Value is the offset of each eye from the camera, along its right vector
+    std::optional< float > GetStereoHalfIpd() const { return stereoHalfIpd; }
+    bool                   IsStereoEnabled() const { return stereoHalfIpd.has_value(); }
+
+    // Views are the equal columns of the render target, from left to right
+    uint32_t ViewCount() const { return viewCount; }
+    bool     IsMultiView() const { return viewCount > 1; }
+
     bool IsUpscaleEnabled() const { return IsAmdFsr2Enabled() || IsNvDlssEnabled(); }
+    // If true, DLSS denoises too, so the built-in denoiser must be skipped
+    bool IsNvDlssRayReconstructionEnabled() const
+    {
+        return IsNvDlssEnabled() && dlssRayReconstruction;
+    }
 
     float GetAmdFsrSharpness() const { return 1.0f; } // 0.0 - max, 1.0 - min
 
@@ -252,16 +313,41 @@ public:
         return ResolutionState{ Width(), Height(), UpscaledWidth(), UpscaledHeight() };
     }
 
+    // Size to allocate the render-sized resources with. With dynamic resolution, it's the max
+    // size that the scale can reach, so changing the scale only changes the rendered subregion
+    ResolutionState GetAllocationState() const
+    {
+        if( maxDynamicWidth == 0 || maxDynamicHeight == 0 )
+        {
+            return GetResolutionState();
+        }
+
+        const uint32_t a = 2 * viewCount;
+        return ResolutionState{
+            .renderWidth    = std::max( ( maxDynamicWidth + a - 1 ) / a * a, Width() ),
+            .renderHeight   = std::max( maxDynamicHeight, Height() ),
+            .upscaledWidth  = UpscaledWidth(),
+            .upscaledHeight = UpscaledHeight(),
+        };
+    }
+
 private:
     uint32_t renderWidth  = 0;
     uint32_t renderHeight = 0;
 
+    // 0, if dynamic resolution is disabled
+    uint32_t maxDynamicWidth  = 0;
+    uint32_t maxDynamicHeight = 0;
+
     uint32_t upscaledWidth  = 0;
     uint32_t upscaledHeight = 0;
 
-    RgRenderUpscaleTechnique upscaleTechnique = RG_RENDER_UPSCALE_TECHNIQUE_LINEAR;
-    RgRenderSharpenTechnique sharpenTechnique = RG_RENDER_SHARPEN_TECHNIQUE_NONE;
-    RgRenderResolutionMode   resolutionMode   = RG_RENDER_RESOLUTION_MODE_CUSTOM;
+    RgRenderUpscaleTechnique upscaleTechnique      = RG_RENDER_UPSCALE_TECHNIQUE_LINEAR;
+    RgRenderSharpenTechnique sharpenTechnique      = RG_RENDER_SHARPEN_TECHNIQUE_NONE;
+    RgRenderResolutionMode   resolutionMode        = RG_RENDER_RESOLUTION_MODE_CUSTOM;
+    bool                     dlssRayReconstruction = false;
+    std::optional< float >   stereoHalfIpd         = std::nullopt;
+    uint32_t                 viewCount             = 1;
 };
 
 }
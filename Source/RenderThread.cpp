@@ -0,0 +1,507 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RenderThread.h"
+
+#include "ApiChains.h"
+#include "RgException.h"
+#include "VulkanDevice.h"
+
+#include <cstring>
+
+namespace
+{
+
+constexpr size_t ARENA_BLOCK_SIZE = 4 * 1024 * 1024;
+
+// Copies the pointed data into the arena, and replaces the pointers
+template< typename Arena >
+struct ArenaCopyVisitor
+{
+    Arena& arena;
+
+    template< typename T >
+    void Data( const T*& p, size_t count )
+    {
+        if( !p || count == 0 )
+        {
+            p = nullptr;
+            return;
+        }
+
+        T* dst = arena.template Allocate< T >( count );
+        memcpy( dst, p, sizeof( T ) * count );
+        p = dst;
+    }
+
+    void String( const char*& p )
+    {
+        if( p )
+        {
+            Data( p, strlen( p ) + 1 );
+        }
+    }
+
+    void Layer( RgTextureLayer*& p, uint32_t vertexCount )
+    {
+        if( !p )
+        {
+            return;
+        }
+
+        auto dst = arena.template Allocate< RgTextureLayer >();
+        *dst     = *p;
+        p        = dst;
+
+        Data( dst->pTexCoord, vertexCount );
+        String( dst->pTextureName );
+    }
+
+    template< typename T >
+    void Output( T*& p )
+    {
+        // set by the caller, if needed
+        p = nullptr;
+    }
+};
+
+}
+
+
+void* RTGL1::RenderThread::Arena::Allocate( size_t size, size_t alignment )
+{
+    for( ; current < blocks.size(); current++, offset = 0 )
+    {
+        const size_t start = Utils::Align( offset, alignment );
+        if( start + size <= blocks[ current ].size )
+        {
+            offset = start + size;
+            return &blocks[ current ].data[ start ];
+        }
+    }
+
+    const size_t blockSize = std::max( size, ARENA_BLOCK_SIZE );
+    blocks.push_back( Block{
+        .data = std::make_unique< uint8_t[] >( blockSize ),
+        .size = blockSize,
+    } );
+
+    current = blocks.size() - 1;
+    offset  = size;
+    return blocks.back().data.get();
+}
+
+void RTGL1::RenderThread::Arena::Reset()
+{
+    current = 0;
+    offset  = 0;
+}
+
+
+RTGL1::RenderThread::RenderThread( VulkanDevice& _device, bool ownThread )
+    : device{ _device }
+    , thread{ ownThread ? std::thread{ [ this ]() { Run(); } } : std::thread{} }
+{
+}
+
+RTGL1::RenderThread::~RenderThread()
+{
+    WaitIdle();
+
+    if( !thread.joinable() )
+    {
+        return;
+    }
+
+    // an empty slot to wake up the render thread
+    stopRequested.store( true, std::memory_order_release );
+    {
+        auto lock = std::lock_guard{ recordMutex };
+        Recording();
+        Submit();
+    }
+
+    thread.join();
+}
+
+auto RTGL1::RenderThread::Recording() -> Slot&
+{
+    if( !recording )
+    {
+        // the slot must be issued by the render thread, before it's reused
+        const uint64_t s = submitted.load( std::memory_order_relaxed );
+        for( uint64_t i = issued.load( std::memory_order_acquire ); s - i >= SlotCount;
+             i          = issued.load( std::memory_order_acquire ) )
+        {
+            issued.wait( i, std::memory_order_acquire );
+        }
+
+        recording = &slots[ s % SlotCount ];
+        recording->commands.clear();
+        recording->arena.Reset();
+    }
+    return *recording;
+}
+
+void RTGL1::RenderThread::Submit()
+{
+    assert( recording );
+    const Slot& slot = *recording;
+    recording        = nullptr;
+
+    if( !thread.joinable() )
+    {
+        Issue( slot );
+
+        submitted.fetch_add( 1, std::memory_order_relaxed );
+        issued.fetch_add( 1, std::memory_order_release );
+        return;
+    }
+
+    submitted.fetch_add( 1, std::memory_order_release );
+    submitted.notify_one();
+}
+
+void RTGL1::RenderThread::WaitIdle()
+{
+    {
+        auto lock = std::lock_guard{ recordMutex };
+        if( recording )
+        {
+            Submit();
+        }
+    }
+
+    const uint64_t s = submitted.load( std::memory_order_relaxed );
+    for( uint64_t i = issued.load( std::memory_order_acquire ); i < s;
+         i          = issued.load( std::memory_order_acquire ) )
+    {
+        issued.wait( i, std::memory_order_acquire );
+    }
+}
+
+const void* RTGL1::RenderThread::CopyChain( const void* pRoot )
+{
+    Arena& arena = Recording().arena;
+
+    auto ctx = apichain::ChainContext{};
+    if( auto tex = pnext::cast< RgOriginalTextureInfo >( pRoot ) )
+    {
+        ctx.pixelDataSize = apichain::OriginalTextureDataSize( *tex );
+    }
+
+    void* root = nullptr;
+    void* last = nullptr;
+
+    for( const void* node = pRoot; node; node = detail::GetPNext( node ) )
+    {
+        const RgStructureType sType = detail::GetStructureType( node );
+
+        void* copy = nullptr;
+        apichain::ForChainType( sType, [ & ]< typename T >() {
+            T* s     = arena.Allocate< T >();
+            *s       = *static_cast< const T* >( node );
+            s->pNext = nullptr;
+
+            auto v = ArenaCopyVisitor< Arena >{ arena };
+            apichain::VisitPointers( *s, v, ctx );
+            copy = s;
+        } );
+
+        if( !copy )
+        {
+            debug::Warning( "Render thread: sType={} can't be deferred, skipping", int( sType ) );
+            continue;
+        }
+
+        if( last )
+        {
+            static_cast< detail::AnyInfoPrototype* >( last )->pNext = copy;
+        }
+        else
+        {
+            root = copy;
+        }
+        last = copy;
+    }
+
+    return root;
+}
+
+const char* RTGL1::RenderThread::CopyString( const char* pStr )
+{
+    auto v = ArenaCopyVisitor< Arena >{ Recording().arena };
+    v.String( pStr );
+    return pStr;
+}
+
+void RTGL1::RenderThread::Record( const Command& cmd )
+{
+    Recording().commands.push_back( cmd );
+}
+
+void RTGL1::RenderThread::StartFrame( const RgStartFrameInfo* pInfo )
+{
+    if( pInfo == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    // results of the render thread are one frame late
+    if( pInfo->pResultStaticSceneStatus )
+    {
+        *pInfo->pResultStaticSceneStatus = lastStaticSceneStatus.load( std::memory_order_relaxed );
+    }
+
+    auto lock = std::lock_guard{ recordMutex };
+
+    auto copy = static_cast< const RgStartFrameInfo* >( CopyChain( pInfo ) );
+    if( auto root = const_cast< RgStartFrameInfo* >( copy ) )
+    {
+        root->pResultStaticSceneStatus = &Recording().staticSceneStatus;
+    }
+
+    Record( Command{ .op = Op::StartFrame, .pArg = copy } );
+}
+
+void RTGL1::RenderThread::UploadCamera( const RgCameraInfo* pInfo )
+{
+    if( pInfo == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto lock = std::lock_guard{ recordMutex };
+    Record( Command{ .op = Op::UploadCamera, .pArg = CopyChain( pInfo ) } );
+}
+
+void RTGL1::RenderThread::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
+                                               const RgMeshPrimitiveInfo* pPrimitive )
+{
+    UploadMeshPrimitives( pMesh, pPrimitive, 1 );
+}
+
+void RTGL1::RenderThread::UploadMeshPrimitives( const RgMeshInfo*          pMesh,
+                                                const RgMeshPrimitiveInfo* pPrimitives,
+                                                uint32_t                   primitiveCount )
+{
+    if( pMesh == nullptr || ( pPrimitives == nullptr && primitiveCount > 0 ) )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto lock = std::lock_guard{ recordMutex };
+
+    // mesh info is shared by the primitives
+    const void* mesh = CopyChain( pMesh );
+
+    for( uint32_t i = 0; i < primitiveCount; i++ )
+    {
+        Record( Command{
+            .op    = Op::UploadMeshPrimitive,
+            .pArg  = mesh,
+            .pArg2 = CopyChain( &pPrimitives[ i ] ),
+        } );
+    }
+}
+
+void RTGL1::RenderThread::UploadLensFlare( const RgLensFlareInfo* pInfo )
+{
+    if( pInfo == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto lock = std::lock_guard{ recordMutex };
+    Record( Command{ .op = Op::UploadLensFlare, .pArg = CopyChain( pInfo ) } );
+}
+
+void RTGL1::RenderThread::SpawnFluid( const RgSpawnFluidInfo* pInfo )
+{
+    if( pInfo == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto lock = std::lock_guard{ recordMutex };
+    Record( Command{ .op = Op::SpawnFluid, .pArg = CopyChain( pInfo ) } );
+}
+
+void RTGL1::RenderThread::UploadLight( const RgLightInfo* pInfo )
+{
+    if( pInfo == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto lock = std::lock_guard{ recordMutex };
+    Record( Command{ .op = Op::UploadLight, .pArg = CopyChain( pInfo ) } );
+}
+
+void RTGL1::RenderThread::ProvideOriginalTexture( const RgOriginalTextureInfo* pInfo )
+{
+    if( pInfo == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto lock = std::lock_guard{ recordMutex };
+    Record( Command{ .op = Op::ProvideOriginalTexture, .pArg = CopyChain( pInfo ) } );
+}
+
+void RTGL1::RenderThread::MarkOriginalTextureAsDeleted( const char* pTextureName )
+{
+    auto lock = std::lock_guard{ recordMutex };
+    Record( Command{ .op = Op::MarkOriginalTextureAsDeleted, .pArg = CopyString( pTextureName ) } );
+}
+
+void RTGL1::RenderThread::UpdateMeshTransform( RgMeshHandle       mesh,
+                                               const RgTransform* pTransform,
+                                               RgMeshInfoFlags    flags )
+{
+    if( pTransform == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto lock = std::lock_guard{ recordMutex };
+
+    auto transform = Recording().arena.Allocate< RgTransform >();
+    *transform     = *pTransform;
+
+    Record( Command{
+        .op    = Op::UpdateMeshTransform,
+        .mesh  = mesh,
+        .flags = flags,
+        .pArg  = transform,
+    } );
+}
+
+void RTGL1::RenderThread::DestroyMesh( RgMeshHandle mesh )
+{
+    auto lock = std::lock_guard{ recordMutex };
+    Record( Command{ .op = Op::DestroyMesh, .mesh = mesh } );
+}
+
+void RTGL1::RenderThread::DrawFrame( const RgDrawFrameInfo* pInfo )
+{
+    if( pInfo == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto lock = std::lock_guard{ recordMutex };
+    Record( Command{ .op = Op::DrawFrame, .pArg = CopyChain( pInfo ) } );
+    Submit();
+}
+
+RgPrimitiveVertex* RTGL1::RenderThread::AllocForVertices( uint32_t vertexCount )
+{
+    auto lock = std::lock_guard{ recordMutex };
+    return Recording().arena.Allocate< RgPrimitiveVertex >( vertexCount );
+}
+
+RgUtilFrameTimings RTGL1::RenderThread::GetFrameTimings() const
+{
+    auto lock = std::lock_guard{ timingsMutex };
+    return lastTimings;
+}
+
+void RTGL1::RenderThread::Run()
+{
+    uint64_t next = 0;
+
+    while( true )
+    {
+        submitted.wait( next, std::memory_order_acquire );
+
+        for( const uint64_t s = submitted.load( std::memory_order_acquire ); next < s; next++ )
+        {
+            Issue( slots[ next % SlotCount ] );
+
+            issued.store( next + 1, std::memory_order_release );
+            issued.notify_all();
+        }
+
+        if( stopRequested.load( std::memory_order_acquire ) )
+        {
+            return;
+        }
+    }
+}
+
+void RTGL1::RenderThread::Issue( const Slot& slot )
+{
+    for( const Command& cmd : slot.commands )
+    {
+        try
+        {
+            switch( cmd.op )
+            {
+                case Op::StartFrame:
+                    device.StartFrame( static_cast< const RgStartFrameInfo* >( cmd.pArg ) );
+                    lastStaticSceneStatus.store( slot.staticSceneStatus,
+                                                 std::memory_order_relaxed );
+                    break;
+                case Op::UploadCamera:
+                    device.UploadCamera( static_cast< const RgCameraInfo* >( cmd.pArg ) );
+                    break;
+                case Op::UploadMeshPrimitive:
+                    device.UploadMeshPrimitive(
+                        static_cast< const RgMeshInfo* >( cmd.pArg ),
+                        static_cast< const RgMeshPrimitiveInfo* >( cmd.pArg2 ) );
+                    break;
+                case Op::UploadLensFlare:
+                    device.UploadLensFlare( static_cast< const RgLensFlareInfo* >( cmd.pArg ) );
+                    break;
+                case Op::SpawnFluid:
+                    device.SpawnFluid( static_cast< const RgSpawnFluidInfo* >( cmd.pArg ) );
+                    break;
+                case Op::UploadLight:
+                    device.UploadLight( static_cast< const RgLightInfo* >( cmd.pArg ) );
+                    break;
+                case Op::ProvideOriginalTexture:
+                    device.ProvideOriginalTexture(
+                        static_cast< const RgOriginalTextureInfo* >( cmd.pArg ) );
+                    break;
+                case Op::MarkOriginalTextureAsDeleted:
+                    device.MarkOriginalTextureAsDeleted( static_cast< const char* >( cmd.pArg ) );
+                    break;
+                case Op::UpdateMeshTransform:
+                    device.UpdateMeshTransform(
+                        cmd.mesh, static_cast< const RgTransform* >( cmd.pArg ), cmd.flags );
+                    break;
+                case Op::DestroyMesh: device.DestroyMesh( cmd.mesh ); break;
+                case Op::DrawFrame: {
+                    device.DrawFrame( static_cast< const RgDrawFrameInfo* >( cmd.pArg ) );
+
+                    auto lock   = std::lock_guard{ timingsMutex };
+                    lastTimings = device.GetFrameTimings();
+                    break;
+                }
+                default: assert( 0 ); break;
+            }
+        }
+        catch( RgException& e )
+        {
+            debug::Error( e.what() );
+        }
+    }
+}
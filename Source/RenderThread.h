@@ -0,0 +1,175 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Common.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RTGL1
+{
+
+class VulkanDevice;
+
+// Deferred submission: the API calls of a frame are copied with the data they point to
+// into the frame's arena, and are issued to the device on a library-owned thread.
+// Frames are handed over through a single-producer / single-consumer ring of two slots,
+// so the application records the next frame, while the current one is being rendered.
+// Without its own thread, the calls are issued on the application thread in rgDrawFrame:
+// the frame fence is waited there, and not in rgStartFrame before the uploads.
+class RenderThread
+{
+public:
+    RenderThread( VulkanDevice& device, bool ownThread );
+    ~RenderThread();
+
+    RenderThread( const RenderThread& other )                = delete;
+    RenderThread( RenderThread&& other ) noexcept            = delete;
+    RenderThread& operator=( const RenderThread& other )     = delete;
+    RenderThread& operator=( RenderThread&& other ) noexcept = delete;
+
+    void StartFrame( const RgStartFrameInfo* pInfo );
+    void UploadCamera( const RgCameraInfo* pInfo );
+    void UploadMeshPrimitive( const RgMeshInfo* pMesh, const RgMeshPrimitiveInfo* pPrimitive );
+    void UploadMeshPrimitives( const RgMeshInfo*          pMesh,
+                               const RgMeshPrimitiveInfo* pPrimitives,
+                               uint32_t                   primitiveCount );
+    void UploadLensFlare( const RgLensFlareInfo* pInfo );
+    void SpawnFluid( const RgSpawnFluidInfo* pInfo );
+    void UploadLight( const RgLightInfo* pInfo );
+    void ProvideOriginalTexture( const RgOriginalTextureInfo* pInfo );
+    void MarkOriginalTextureAsDeleted( const char* pTextureName );
+    void UpdateMeshTransform( RgMeshHandle       mesh,
+                              const RgTransform* pTransform,
+                              RgMeshInfoFlags    flags );
+    void DestroyMesh( RgMeshHandle mesh );
+    // Hands the frame over to the render thread
+    void DrawFrame( const RgDrawFrameInfo* pInfo );
+
+    // Valid until the frame is issued
+    RgPrimitiveVertex* AllocForVertices( uint32_t vertexCount );
+
+    // Hands over the calls recorded so far, and blocks until the render thread has issued them.
+    // Must be called before accessing the device from the application threads
+    void WaitIdle();
+
+    RgUtilFrameTimings GetFrameTimings() const;
+
+private:
+    enum class Op : uint32_t
+    {
+        StartFrame,
+        UploadCamera,
+        UploadMeshPrimitive,
+        UploadLensFlare,
+        SpawnFluid,
+        UploadLight,
+        ProvideOriginalTexture,
+        MarkOriginalTextureAsDeleted,
+        UpdateMeshTransform,
+        DestroyMesh,
+        DrawFrame,
+    };
+
+    struct Command
+    {
+        Op           op;
+        RgMeshHandle mesh;
+        uint32_t     flags;
+        const void*  pArg;
+        const void*  pArg2;
+    };
+
+    // Bump allocator, its blocks are reused by the next frames in this slot
+    class Arena
+    {
+    public:
+        void* Allocate( size_t size, size_t alignment );
+        void  Reset();
+
+        template< typename T >
+        T* Allocate( size_t count = 1 )
+        {
+            return static_cast< T* >( Allocate( sizeof( T ) * count, alignof( T ) ) );
+        }
+
+    private:
+        struct Block
+        {
+            std::unique_ptr< uint8_t[] > data;
+            size_t                       size;
+        };
+        std::vector< Block > blocks;
+        size_t               current{ 0 };
+        size_t               offset{ 0 };
+    };
+
+    struct Slot
+    {
+        std::vector< Command > commands;
+        Arena                  arena;
+        // render thread writes the result of rgStartFrame here
+        RgStaticSceneStatusFlags staticSceneStatus{ 0 };
+    };
+
+    static constexpr uint64_t SlotCount = 2;
+
+private:
+    // Must be called with 'recordMutex' locked
+    Slot&       Recording();
+    void        Submit();
+    const void* CopyChain( const void* pRoot );
+    const char* CopyString( const char* pStr );
+    void        Record( const Command& cmd );
+
+    void Run();
+    void Issue( const Slot& slot );
+
+private:
+    VulkanDevice& device;
+
+    std::array< Slot, SlotCount > slots;
+
+    // count of the slots handed over to the render thread; written only by the application
+    std::atomic< uint64_t > submitted{ 0 };
+    // count of the slots issued to the device; written only by the render thread
+    std::atomic< uint64_t > issued{ 0 };
+    std::atomic< bool >     stopRequested{ false };
+
+    // null, if no calls were recorded since the last submit
+    Slot*      recording{ nullptr };
+    // uploads can be made from multiple threads within a frame
+    std::mutex recordMutex;
+
+    std::atomic< RgStaticSceneStatusFlags > lastStaticSceneStatus{ 0 };
+
+    mutable std::mutex timingsMutex;
+    RgUtilFrameTimings lastTimings{};
+
+    // not joinable, if the calls are issued on the application thread
+    std::thread thread;
+};
+
+}
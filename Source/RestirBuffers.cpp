@@ -23,50 +23,23 @@
 #include "Utils.h"
 #include "Generated/ShaderCommonC.h"
 
-RTGL1::RestirBuffers::RestirBuffers( VkDevice                           _device,
-                                     std::shared_ptr< MemoryAllocator > _allocator )
-    : device( _device ), allocator( std::move( _allocator ) )
-{
-    CreateDescriptors();
-}
-
-RTGL1::RestirBuffers::~RestirBuffers()
-{
-    DestroyBuffers();
-    vkDestroyDescriptorSetLayout( device, descLayout, nullptr );
-    vkDestroyDescriptorPool( device, descPool, nullptr );
-}
-
-VkDescriptorSet RTGL1::RestirBuffers::GetDescSet( uint32_t frameIndex ) const
-{
-    return descSets[ frameIndex ];
-}
-
-VkDescriptorSetLayout RTGL1::RestirBuffers::GetDescSetLayout() const
-{
-    return descLayout;
-}
-
-void RTGL1::RestirBuffers::OnFramebuffersSizeChange( const ResolutionState& resolutionState )
-{
-    DestroyBuffers();
-    CreateBuffers( resolutionState.renderWidth, resolutionState.renderHeight );
-}
-
 namespace
 {
 auto MakeBuffer( const std::shared_ptr< RTGL1::MemoryAllocator >& allocator,
                  VkDeviceSize                                     size,
-                 const char*                                      name )
+                 const char*                                      name,
+                 VkBufferUsageFlags                               extraUsage = 0 )
 {
     using namespace RTGL1;
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_RESTIR };
+
     VkResult                 r;
     RestirBuffers::BufferDef result = {};
 
     VkBufferCreateInfo       bufferInfo = {
               .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
               .size        = size,
-              .usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+              .usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | extraUsage,
               .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
     };
 
@@ -85,15 +58,77 @@ auto MakeBuffer( const std::shared_ptr< RTGL1::MemoryAllocator >& allocator,
 
     return result;
 }
+
+void DestroyBuffer( VkDevice device, RTGL1::RestirBuffers::BufferDef& b )
+{
+    if( b.buffer )
+    {
+        vkDestroyBuffer( device, b.buffer, nullptr );
+    }
+
+    if( b.memory )
+    {
+        RTGL1::MemoryAllocator::FreeDedicated( device, b.memory );
+    }
+
+    b = {};
+}
+}
+
+RTGL1::RestirBuffers::RestirBuffers( VkDevice                           _device,
+                                     std::shared_ptr< MemoryAllocator > _allocator )
+    : device( _device ), allocator( std::move( _allocator ) )
+{
+    CreateDescriptors();
+    irradianceCache = MakeBuffer( allocator,
+                                  sizeof( ShIrradianceCacheCell ) * IRRADIANCE_CACHE_CELL_COUNT,
+                                  "Restir Indirect - Irradiance cache",
+                                  VK_BUFFER_USAGE_TRANSFER_DST_BIT );
+}
+
+RTGL1::RestirBuffers::~RestirBuffers()
+{
+    DestroyBuffers();
+    DestroyBuffer( device, irradianceCache );
+    vkDestroyDescriptorSetLayout( device, descLayout, nullptr );
+    vkDestroyDescriptorPool( device, descPool, nullptr );
+}
+
+VkDescriptorSet RTGL1::RestirBuffers::GetDescSet( uint32_t frameIndex ) const
+{
+    return descSets[ frameIndex ];
+}
+
+VkDescriptorSetLayout RTGL1::RestirBuffers::GetDescSetLayout() const
+{
+    return descLayout;
+}
+
+VkBuffer RTGL1::RestirBuffers::GetIrradianceCacheBuffer() const
+{
+    return irradianceCache.buffer;
+}
+
+void RTGL1::RestirBuffers::OnFramebuffersSizeChange( const ResolutionState& resolutionState )
+{
+    DestroyBuffers();
+    CreateBuffers( resolutionState.renderWidth, resolutionState.renderHeight );
 }
 
 void RTGL1::RestirBuffers::CreateBuffers( uint32_t renderWidth, uint32_t renderHeight )
 {
+    // reservoirs are stored in tiles, so the size must be aligned
+    uint32_t tileCountX =
+        Utils::GetWorkGroupCount( renderWidth, RESTIR_INDIRECT_RESERVOIR_TILE_SIZE );
+    uint32_t tileCountY =
+        Utils::GetWorkGroupCount( renderHeight, RESTIR_INDIRECT_RESERVOIR_TILE_SIZE );
+
     for( auto& r : reservoirs )
     {
         r = MakeBuffer( allocator,
-                        sizeof( uint32_t ) * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS * renderWidth *
-                            renderHeight,
+                        sizeof( uint32_t ) * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS * tileCountX *
+                            tileCountY * RESTIR_INDIRECT_RESERVOIR_TILE_SIZE *
+                            RESTIR_INDIRECT_RESERVOIR_TILE_SIZE,
                         "Restir Indirect - Reservois" );
     }
 
@@ -102,25 +137,9 @@ void RTGL1::RestirBuffers::CreateBuffers( uint32_t renderWidth, uint32_t renderH
 
 void RTGL1::RestirBuffers::DestroyBuffers()
 {
-    BufferDef* allBufs[] = {
-        &reservoirs[ 0 ],
-        &reservoirs[ 1 ],
-    };
-    static_assert( sizeof( reservoirs ) / sizeof( reservoirs[ 0 ] ) == 2 );
-
-    for( auto* b : allBufs )
+    for( auto& r : reservoirs )
     {
-        if( b->buffer )
-        {
-            vkDestroyBuffer( device, b->buffer, nullptr );
-        }
-
-        if( b->memory )
-        {
-            MemoryAllocator::FreeDedicated( device, b->memory );
-        }
-
-        *b = {};
+        DestroyBuffer( device, r );
     }
 }
 
@@ -141,6 +160,12 @@ void RTGL1::RestirBuffers::CreateDescriptors()
             .descriptorCount = 1,
             .stageFlags      = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT,
         },
+        {
+            .binding         = BINDING_RESTIR_INDIRECT_IRRADIANCE_CACHE,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT,
+        },
     };
 
     VkDescriptorSetLayoutCreateInfo layoutInfo = {
@@ -160,7 +185,7 @@ void RTGL1::RestirBuffers::CreateDescriptors()
                     "Restir Indirect Desc set layout" );
 
     VkDescriptorPoolSize poolSize = {
-        .type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+        .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
         .descriptorCount = std::size( bindings ) * MAX_FRAMES_IN_FLIGHT,
     };
 
@@ -198,11 +223,13 @@ void RTGL1::RestirBuffers::UpdateDescriptors()
     {
         VkBuffer bufs[] = {
             reservoirs[ i ].buffer,
-            reservoirs[ Utils::GetPreviousByModulo( i, MAX_FRAMES_IN_FLIGHT ) ].buffer,
+            reservoirs[ Utils::GetPreviousByModulo( i, FramesInFlight() ) ].buffer,
+            irradianceCache.buffer,
         };
         uint32_t bnds[] = {
             BINDING_RESTIR_INDIRECT_RESERVOIRS,
             BINDING_RESTIR_INDIRECT_RESERVOIRS_PREV,
+            BINDING_RESTIR_INDIRECT_IRRADIANCE_CACHE,
         };
         static_assert( std::size( bufs ) == std::size( bnds ) );
 
@@ -38,6 +38,7 @@ public:
 
     VkDescriptorSet       GetDescSet( uint32_t frameIndex ) const;
     VkDescriptorSetLayout GetDescSetLayout() const;
+    VkBuffer              GetIrradianceCacheBuffer() const;
 
     void OnFramebuffersSizeChange( const ResolutionState& resolutionState ) override;
 
@@ -64,5 +65,7 @@ private:
     VkDescriptorSet                    descSets[ MAX_FRAMES_IN_FLIGHT ] = {};
 
     BufferDef                          reservoirs[ MAX_FRAMES_IN_FLIGHT ] = {};
+    // not frame-dependent, and not resized: its cells are in world space
+    BufferDef                          irradianceCache = {};
 };
 }
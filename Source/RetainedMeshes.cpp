@@ -0,0 +1,152 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RetainedMeshes.h"
+
+#include "DebugPrint.h"
+#include "DrawFrameInfo.h"
+#include "Utils.h"
+
+auto RTGL1::RetainedMeshes::Create( const RgMeshInfo&                      mesh,
+                                    std::span< const RgMeshPrimitiveInfo > primitives,
+                                    const NameRegistry&                    names ) -> RgMeshHandle
+{
+    auto m = std::make_unique< Mesh >();
+
+    m->info       = mesh;
+    m->info.pNext = nullptr;
+    if( auto areaExt = pnext::find< RgMeshAreaEXT >( &mesh ) )
+    {
+        m->area        = *areaExt;
+        m->area->pNext = nullptr;
+        m->info.pNext  = &*m->area;
+    }
+    if( auto handleExt = pnext::find< RgMeshNameHandleEXT >( &mesh );
+        handleExt && handleExt->meshName != 0 )
+    {
+        m->meshName = Utils::SafeCstr( names.Get( handleExt->meshName ) );
+    }
+    else
+    {
+        m->meshName = Utils::SafeCstr( mesh.pMeshName );
+    }
+
+    m->primitives.reserve( primitives.size() );
+    m->infos.reserve( primitives.size() );
+
+    for( const RgMeshPrimitiveInfo& src : primitives )
+    {
+        if( pnext::find< RgMeshPrimitiveTextureLayersEXT >( &src ) ||
+            pnext::find< RgMeshPrimitivePortalEXT >( &src ) ||
+            pnext::find< RgMeshPrimitiveSkinningEXT >( &src ) ||
+            pnext::find< RgMeshPrimitiveParticlesEXT >( &src ) )
+        {
+            debug::Warning( "rgCreateMesh: texture layers, portals, skinning and particles are not "
+                            "retained, ignoring them for mesh \"{}\"",
+                            m->meshName );
+        }
+
+        auto& p = m->primitives.emplace_back( Primitive{
+            .vertices = { src.pVertices, src.pVertices + src.vertexCount },
+        } );
+
+        if( auto handleExt = pnext::find< RgMeshPrimitiveNameHandleEXT >( &src );
+            handleExt && handleExt->textureName != 0 )
+        {
+            p.textureName = Utils::SafeCstr( names.Get( handleExt->textureName ) );
+        }
+        else
+        {
+            p.textureName = Utils::SafeCstr( src.pTextureName );
+        }
+
+        if( Utils::HasIndices( src ) )
+        {
+            p.indices.reserve( src.indexCount );
+            for( uint32_t i = 0; i < src.indexCount; i++ )
+            {
+                p.indices.push_back( Utils::GetIndex( src, i ) );
+            }
+        }
+
+        if( auto pbr = pnext::find< RgMeshPrimitivePBREXT >( &src ) )
+        {
+            p.pbr = *pbr;
+        }
+        if( auto attachedLight = pnext::find< RgMeshPrimitiveAttachedLightEXT >( &src ) )
+        {
+            p.attachedLight = *attachedLight;
+        }
+    }
+
+    // all storage is in place, now make the structs that point to it
+    for( size_t i = 0; i < primitives.size(); i++ )
+    {
+        Primitive& p = m->primitives[ i ];
+
+        void* pNext = nullptr;
+        if( p.attachedLight )
+        {
+            p.attachedLight->pNext = pNext;
+            pNext                  = &p.attachedLight.value();
+        }
+        if( p.pbr )
+        {
+            p.pbr->pNext = pNext;
+            pNext        = &p.pbr.value();
+        }
+
+        RgMeshPrimitiveInfo& info = m->infos.emplace_back( primitives[ i ] );
+
+        info.pNext        = pNext;
+        info.pVertices    = p.vertices.data();
+        info.vertexCount  = uint32_t( p.vertices.size() );
+        info.pIndices     = p.indices.empty() ? nullptr : p.indices.data();
+        info.indexCount   = uint32_t( p.indices.size() );
+        info.pIndices16   = nullptr;
+        info.pTextureName = p.textureName.empty() ? nullptr : p.textureName.c_str();
+    }
+
+    m->info.pMeshName = m->meshName.empty() ? nullptr : m->meshName.c_str();
+
+    RgMeshHandle handle = ++lastHandle;
+    meshes.emplace( handle, std::move( m ) );
+    return handle;
+}
+
+bool RTGL1::RetainedMeshes::SetTransform( RgMeshHandle       handle,
+                                          const RgTransform& transform,
+                                          RgMeshInfoFlags    flags )
+{
+    auto found = meshes.find( handle );
+    if( found == meshes.end() )
+    {
+        return false;
+    }
+
+    found->second->info.transform = transform;
+    found->second->info.flags     = flags;
+    return true;
+}
+
+bool RTGL1::RetainedMeshes::Destroy( RgMeshHandle handle )
+{
+    return meshes.erase( handle ) > 0;
+}
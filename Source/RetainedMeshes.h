@@ -0,0 +1,88 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Containers.h"
+#include "NameRegistry.h"
+
+#include <RTGL1/RTGL1.h>
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Meshes that are created once with rgCreateMesh, and then uploaded by the library
+// each frame with their latest transform. Their content doesn't change, so dynamic
+// promotion keeps their vertex data and BLAS-es on GPU. Not thread-safe
+class RetainedMeshes
+{
+public:
+    // Copies the mesh, its primitives and their vertex data.
+    // Registered names are resolved to strings
+    auto Create( const RgMeshInfo&                      mesh,
+                 std::span< const RgMeshPrimitiveInfo > primitives,
+                 const NameRegistry&                    names ) -> RgMeshHandle;
+    bool SetTransform( RgMeshHandle handle, const RgTransform& transform, RgMeshInfoFlags flags );
+    bool Destroy( RgMeshHandle handle );
+
+    template< typename Func >
+        requires( std::is_invocable_v< Func,
+                                       const RgMeshInfo&,
+                                       std::span< const RgMeshPrimitiveInfo > > )
+    void ForEach( Func&& func ) const
+    {
+        for( const auto& [ handle, m ] : meshes )
+        {
+            func( m->info, std::span< const RgMeshPrimitiveInfo >{ m->infos } );
+        }
+    }
+
+private:
+    struct Primitive
+    {
+        std::string                                      textureName;
+        std::vector< RgPrimitiveVertex >                 vertices;
+        std::vector< uint32_t >                          indices;
+        std::optional< RgMeshPrimitivePBREXT >           pbr;
+        std::optional< RgMeshPrimitiveAttachedLightEXT > attachedLight;
+    };
+
+    struct Mesh
+    {
+        RgMeshInfo               info;
+        std::string              meshName;
+        // 'info.pNext' points to it, if present
+        std::optional< RgMeshAreaEXT > area;
+        std::vector< Primitive > primitives;
+        // point to the data in 'primitives', so it must not be modified after creation
+        std::vector< RgMeshPrimitiveInfo > infos;
+    };
+
+    rgl::unordered_map< RgMeshHandle, std::unique_ptr< Mesh > > meshes;
+    RgMeshHandle                                                lastHandle{ 0 };
+};
+
+}
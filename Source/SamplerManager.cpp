@@ -20,6 +20,7 @@
 
 #include "SamplerManager.h"
 
+#include <algorithm>
 #include <string>
 
 #include "RgException.h"
@@ -171,6 +172,15 @@ namespace
                         RgAddressModeToVk( addressModeV ) );
     }
 
+    uint32_t ToSamplerTableIndex( uint32_t index )
+    {
+        auto [ u, v ] = GetRgAddressModesFromIndex( index );
+
+        return ( GetRgFilterFromIndex( index ) == RG_SAMPLER_FILTER_LINEAR ? 4 : 0 ) |
+               ( u == RG_SAMPLER_ADDRESS_MODE_CLAMP ? 2 : 0 ) |
+               ( v == RG_SAMPLER_ADDRESS_MODE_CLAMP ? 1 : 0 );
+    }
+
     uint32_t SwapFilterInIndex( uint32_t srcIndex, RgSamplerFilter newFilter )
     {
         // clear previous filter type
@@ -194,11 +204,14 @@ namespace
 }
 
 
-RTGL1::SamplerManager::SamplerManager( VkDevice _device,
-                                       uint32_t _anisotropy,
-                                       bool     _forceMinificationFilterLinear )
+RTGL1::SamplerManager::SamplerManager( VkDevice                         _device,
+                                       std::shared_ptr< DeletionQueue > _deletionQueue,
+                                       uint32_t                         _anisotropy,
+                                       bool _forceMinificationFilterLinear )
     : device( _device )
+    , deletionQueue( std::move( _deletionQueue ) )
     , mipLodBias( 0.0f )
+    , generation( 0 )
     , anisotropy( _anisotropy )
     , forceMinificationFilterLinear( _forceMinificationFilterLinear )
 {
@@ -211,16 +224,6 @@ RTGL1::SamplerManager::~SamplerManager()
     {
         vkDestroySampler( device, p.second, nullptr );
     }
-
-    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
-    {
-        for( VkSampler s : samplersToDelete[ i ] )
-        {
-            vkDestroySampler( device, s, nullptr );
-        }
-
-        samplersToDelete[ i ].clear();
-    };
     samplers.clear();
 }
 
@@ -283,22 +286,12 @@ void RTGL1::SamplerManager::AddAllSamplersToDestroy( uint32_t frameIndex )
 {
     for( auto& p : samplers )
     {
-        samplersToDelete[ frameIndex ].push_back( p.second );
+        deletionQueue->PushSampler( frameIndex, device, p.second );
     }
 
     samplers.clear();
 }
 
-void RTGL1::SamplerManager::PrepareForFrame( uint32_t frameIndex )
-{
-    for( VkSampler s : samplersToDelete[ frameIndex ] )
-    {
-        vkDestroySampler( device, s, nullptr );
-    }
-
-    samplersToDelete[ frameIndex ].clear();
-}
-
 VkSampler RTGL1::SamplerManager::GetSampler( RgSamplerFilter      filter,
                                              RgSamplerAddressMode addressModeU,
                                              RgSamplerAddressMode addressModeV ) const
@@ -344,9 +337,34 @@ bool RTGL1::SamplerManager::TryChangeMipLodBias( uint32_t frameIndex, float newM
     CreateAllSamplers( anisotropy, newMipLodBias );
 
     mipLodBias = newMipLodBias;
+    generation++;
     return true;
 }
 
+uint32_t RTGL1::SamplerManager::GetSamplerTableIndex( const Handle& handle ) const
+{
+    assert( handle.internalIndex != 0 );
+    return ToSamplerTableIndex( handle.internalIndex );
+}
+
+auto RTGL1::SamplerManager::GetSamplerTable() const -> SamplerTable
+{
+    SamplerTable table = {};
+
+    for( const auto& [ index, sampler ] : samplers )
+    {
+        table[ ToSamplerTableIndex( index ) ] = sampler;
+    }
+
+    assert( std::ranges::none_of( table, []( VkSampler s ) { return s == VK_NULL_HANDLE; } ) );
+    return table;
+}
+
+uint32_t RTGL1::SamplerManager::GetGeneration() const
+{
+    return generation;
+}
+
 auto RTGL1::SamplerManager::Deconstruct( const Handle& handle ) const
     -> std::tuple< RgSamplerAddressMode, RgSamplerAddressMode, RgSamplerFilter >
 {
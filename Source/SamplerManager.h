@@ -20,10 +20,12 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include "Common.h"
 #include "Containers.h"
+#include "DeletionQueue.h"
 #include "RTGL1/RTGL1.h"
 
 namespace RTGL1
@@ -56,7 +58,15 @@ public:
     };
 
 public:
-    SamplerManager( VkDevice device, uint32_t anisotropy, bool forceMinificationFilterLinear );
+    // All samplers that can be addressed by a Handle, in a stable order
+    static constexpr uint32_t SamplerTableSize = 8;
+    using SamplerTable                         = std::array< VkSampler, SamplerTableSize >;
+
+public:
+    SamplerManager( VkDevice                         device,
+                    std::shared_ptr< DeletionQueue > deletionQueue,
+                    uint32_t                         anisotropy,
+                    bool                             forceMinificationFilterLinear );
     ~SamplerManager();
 
     SamplerManager( const SamplerManager& other )                = delete;
@@ -64,8 +74,6 @@ public:
     SamplerManager& operator=( const SamplerManager& other )     = delete;
     SamplerManager& operator=( SamplerManager&& other ) noexcept = delete;
 
-    void PrepareForFrame( uint32_t frameIndex );
-
     VkSampler GetSampler( RgSamplerFilter      filter,
                           RgSamplerAddressMode addressModeU,
                           RgSamplerAddressMode addressModeV ) const;
@@ -73,9 +81,16 @@ public:
     // In case, if mip load bias was updated and a fresh sampler is required
     VkSampler GetSampler( const Handle& handle ) const;
 
-    // Wait idle and recreate all the samplers with new lod bias
+    // Recreate all the samplers with new lod bias,
+    // the old ones are destroyed when the frames in flight are finished
     bool TryChangeMipLodBias( uint32_t frameIndex, float newMipLodBias );
 
+    // Index of the handle's sampler in GetSamplerTable()
+    uint32_t     GetSamplerTableIndex( const Handle& handle ) const;
+    SamplerTable GetSamplerTable() const;
+    // Incremented each time the samplers are recreated
+    uint32_t     GetGeneration() const;
+
     auto Deconstruct( const Handle& handle ) const
         -> std::tuple< RgSamplerAddressMode, RgSamplerAddressMode, RgSamplerFilter >;
 
@@ -84,11 +99,12 @@ private:
     void AddAllSamplersToDestroy( uint32_t frameIndex );
 
 private:
-    VkDevice device;
+    VkDevice                         device;
+    std::shared_ptr< DeletionQueue > deletionQueue;
 
     rgl::unordered_map< uint32_t, VkSampler > samplers;
-    std::vector< VkSampler >                  samplersToDelete[ MAX_FRAMES_IN_FLIGHT ];
     float                                     mipLodBias;
+    uint32_t                                  generation;
     uint32_t                                  anisotropy;
     bool                                      forceMinificationFilterLinear;
 };
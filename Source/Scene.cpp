@@ -23,8 +23,11 @@
 #include "Scene.h"
 
 #include "CmdLabel.h"
+#include "CpuProfiler.h"
+#include "HitchRecorder.h"
 #include "GeomInfoManager.h"
 #include "GltfImporter.h"
+#include "LibraryConfig.h"
 #include "Matrix.h"
 #include "RgException.h"
 #include "UniqueID.h"
@@ -33,6 +36,7 @@
 
 #include <glm/gtc/quaternion.hpp>
 
+#include <cwchar>
 #include <future>
 #include <ranges>
 
@@ -73,6 +77,30 @@ auto MakeGltfPath( const std::filesystem::path& base, std::string_view meshName
     }
 }
 
+// LODs share everything with the base primitive, except the geometry
+auto MakePrimitiveLods( const RgMeshPrimitiveInfo&                     base,
+                        const RTGL1::WholeModelFile::RawPrimitiveData& src )
+    -> std::vector< RTGL1::ASManager::PrimitiveLod >
+{
+    auto lods = std::vector< RTGL1::ASManager::PrimitiveLod >{};
+    lods.reserve( src.lods.size() );
+
+    for( const auto& l : src.lods )
+    {
+        auto prim        = base;
+        prim.pVertices   = l.vertices.data();
+        prim.vertexCount = static_cast< uint32_t >( l.vertices.size() );
+        prim.pIndices    = l.indices.data();
+        prim.indexCount  = static_cast< uint32_t >( l.indices.size() );
+
+        lods.push_back( RTGL1::ASManager::PrimitiveLod{
+            .primitive = prim,
+            .error     = l.error,
+        } );
+    }
+    return lods;
+}
+
 auto SanitizePathToShow( const std::filesystem::path& p )
 {
     auto s = p.string();
@@ -158,6 +186,11 @@ auto FindNextReplaceFileNameInFolder( const std::filesystem::path& folder ) -> s
     return std::string{ prefix } + std::to_string( largest + 1 );
 }
 
+bool IsRunning( const std::future< bool >& job )
+{
+    return job.valid() && job.wait_for( std::chrono::seconds{ 0 } ) != std::future_status::ready;
+}
+
 auto GetGltfFilesSortedAlphabetically( const std::filesystem::path& folder )
     -> std::set< std::filesystem::path >
 {
@@ -192,6 +225,62 @@ auto GetGltfFilesSortedAlphabetically( const std::filesystem::path& folder )
 
     return gltfs;
 }
+
+// Static BLAS-es depend on the scene files and, if they are reimported, on the replacements.
+// Files are identified by their size and modification time, not to read them twice
+auto MakeBLASCacheFile( const std::filesystem::path& staticSceneGltfPath,
+                        const std::filesystem::path* replacementsFolder ) -> RTGL1::BLASCacheFile
+{
+    using ankerl::unordered_dense::detail::wyhash::hash;
+
+    uint64_t key = 0;
+
+    const auto addFile = [ &key ]( const std::filesystem::path& path ) {
+        std::error_code ec;
+
+        const auto size = file_size( path, ec );
+        const auto time = last_write_time( path, ec );
+        if( ec )
+        {
+            return;
+        }
+
+        const auto     str      = path.generic_string();
+        const uint64_t values[] = {
+            hash( str.data(), str.size() ),
+            size,
+            static_cast< uint64_t >( time.time_since_epoch().count() ),
+        };
+
+        const uint64_t h = hash( values, sizeof( values ) );
+        key ^= h + 0x9e3779b9 + ( key << 6 ) + ( key >> 2 );
+    };
+
+    const auto addGltf = [ &addFile ]( const std::filesystem::path& gltf ) {
+        addFile( gltf );
+        addFile( std::filesystem::path{ gltf }.replace_extension( ".bin" ) );
+    };
+
+    addGltf( staticSceneGltfPath );
+    addGltf( RTGL1::AddSuffix( staticSceneGltfPath, RTGL1::SCENE_PATCH_SUFFIX ) );
+
+    if( replacementsFolder )
+    {
+        for( const auto& p : GetGltfFilesSortedAlphabetically( *replacementsFolder ) )
+        {
+            addGltf( p );
+        }
+    }
+
+    // separate files, as replacements are built only on the first load
+    auto path = std::filesystem::path{ staticSceneGltfPath }.replace_extension(
+        replacementsFolder ? ".withreplacements.blascache" : ".blascache" );
+
+    return RTGL1::BLASCacheFile{
+        .path = std::move( path ),
+        .key  = key,
+    };
+}
 }
 
 RTGL1::Scene::Scene( VkDevice                                _device,
@@ -202,60 +291,67 @@ RTGL1::Scene::Scene( VkDevice                                _device,
                      const ShaderManager&                    _shaderManager,
                      uint64_t                                _maxReplacementsVerts,
                      uint64_t                                _maxDynamicVerts,
+                     uint32_t                                _maxInstanceCount,
+                     uint32_t                                _maxGeometryCount,
                      bool                                    _enableTexCoordLayer1,
                      bool                                    _enableTexCoordLayer2,
-                     bool                                    _enableTexCoordLayer3 )
+                     bool                                    _enableTexCoordLayer3,
+                     bool                                    _quantizeStaticVertices )
 {
-    geomInfoMgr = std::make_shared< GeomInfoManager >( _device, _allocator );
+    geomInfoMgr = std::make_shared< GeomInfoManager >( _device, _allocator, _maxGeometryCount );
 
     asManager = std::make_shared< ASManager >( _device,
                                                _physDevice,
                                                _allocator,
                                                std::move( _cmdManager ),
                                                geomInfoMgr,
+                                               _uniform,
+                                               _shaderManager,
                                                _maxReplacementsVerts,
                                                _maxDynamicVerts,
+                                               _maxInstanceCount,
                                                _enableTexCoordLayer1,
                                                _enableTexCoordLayer2,
-                                               _enableTexCoordLayer3 );
+                                               _enableTexCoordLayer3,
+                                               _quantizeStaticVertices );
 
-    vertPreproc =
-        std::make_shared< VertexPreprocessing >( _device, _uniform, *asManager, _shaderManager );
+    vertPreproc = std::make_shared< VertexPreprocessing >(
+        _device, _allocator, _uniform, *asManager, _shaderManager, _maxGeometryCount );
 }
 
-namespace RTGL1
+RTGL1::Camera RTGL1::MakeCamera( const RgCameraInfo& info )
 {
-namespace
-{
-    Camera MakeCamera( const RgCameraInfo& info )
+    auto cameraInfo = Camera{
+        .aspect      = info.aspect,
+        .fovYRadians = info.fovYRadians,
+        .cameraNear  = info.cameraNear,
+        .cameraFar   = info.cameraFar,
+    };
     {
-        auto cameraInfo = Camera{
-            .aspect      = info.aspect,
-            .fovYRadians = info.fovYRadians,
-            .cameraNear  = info.cameraNear,
-            .cameraFar   = info.cameraFar,
-        };
-        {
-            static_assert( sizeof cameraInfo.projection == 16 * sizeof( float ) );
-            static_assert( sizeof cameraInfo.view == 16 * sizeof( float ) );
-            static_assert( sizeof cameraInfo.projectionInverse == 16 * sizeof( float ) );
-            static_assert( sizeof cameraInfo.viewInverse == 16 * sizeof( float ) );
-            static_assert( sizeof info.position == 3 * sizeof( float ) );
-            static_assert( sizeof info.right == 3 * sizeof( float ) );
-            static_assert( sizeof info.up == 3 * sizeof( float ) );
-
-            Matrix::MakeViewMatrix( cameraInfo.view, info.position, info.right, info.up );
-            Matrix::MakeProjectionMatrix( cameraInfo.projection,
-                                          cameraInfo.aspect,
-                                          cameraInfo.fovYRadians,
-                                          cameraInfo.cameraNear,
-                                          cameraInfo.cameraFar );
-        }
-        Matrix::Inverse( cameraInfo.viewInverse, cameraInfo.view );
-        Matrix::Inverse( cameraInfo.projectionInverse, cameraInfo.projection );
-        return cameraInfo;
+        static_assert( sizeof cameraInfo.projection == 16 * sizeof( float ) );
+        static_assert( sizeof cameraInfo.view == 16 * sizeof( float ) );
+        static_assert( sizeof cameraInfo.projectionInverse == 16 * sizeof( float ) );
+        static_assert( sizeof cameraInfo.viewInverse == 16 * sizeof( float ) );
+        static_assert( sizeof info.position == 3 * sizeof( float ) );
+        static_assert( sizeof info.right == 3 * sizeof( float ) );
+        static_assert( sizeof info.up == 3 * sizeof( float ) );
+
+        Matrix::MakeViewMatrix( cameraInfo.view, info.position, info.right, info.up );
+        Matrix::MakeProjectionMatrix( cameraInfo.projection,
+                                      cameraInfo.aspect,
+                                      cameraInfo.fovYRadians,
+                                      cameraInfo.cameraNear,
+                                      cameraInfo.cameraFar );
     }
+    Matrix::Inverse( cameraInfo.viewInverse, cameraInfo.view );
+    Matrix::Inverse( cameraInfo.projectionInverse, cameraInfo.projection );
+    return cameraInfo;
+}
 
+namespace RTGL1
+{
+namespace
+{
     template< typename T >
     T linear_interp( const T& a, const T& b, float t ) = delete;
 
@@ -340,39 +436,39 @@ namespace
             return std::nullopt;
         }
 
-        for( size_t i = 0; i < chan.frames.size() - 1; i++ )
-        {
-            const AnimationFrame< T >& a = chan.frames[ i ];
-            const AnimationFrame< T >& b = chan.frames[ i + 1 ];
-
-            const float t0 = a.seconds;
-            const float t1 = b.seconds;
+        // frames are sorted by time, find the last one that starts not later than 't'
+        auto next = std::ranges::upper_bound(
+            chan.frames, t, std::less{}, &AnimationFrame< T >::seconds );
 
-            if( t0 <= t && t <= t1 )
-            {
-                if( a.interpolation == ANIMATION_INTERPOLATION_STEP )
-                {
-                    return a.value;
-                }
-                if( b.interpolation == ANIMATION_INTERPOLATION_STEP )
-                {
-                    return b.value;
-                }
-
-                // TODO: cubic
-                assert( a.interpolation == ANIMATION_INTERPOLATION_LINEAR );
+        if( next == chan.frames.begin() )
+        {
+            return chan.frames.front().value;
+        }
+        if( next == chan.frames.end() )
+        {
+            return chan.frames.back().value;
+        }
 
-                const float factor = t0 < t1 ? ( t - t0 ) / ( t1 - t0 ) : 0;
+        const AnimationFrame< T >& a = *std::prev( next );
+        const AnimationFrame< T >& b = *next;
 
-                return linear_interp( a.value, b.value, factor );
-            }
+        if( a.interpolation == ANIMATION_INTERPOLATION_STEP )
+        {
+            return a.value;
         }
-
-        if( t < chan.frames.front().seconds )
+        if( b.interpolation == ANIMATION_INTERPOLATION_STEP )
         {
-            return chan.frames.front().value;
+            return b.value;
         }
-        return chan.frames.back().value;
+
+        // TODO: cubic
+        assert( a.interpolation == ANIMATION_INTERPOLATION_LINEAR );
+
+        const float t0     = a.seconds;
+        const float t1     = b.seconds;
+        const float factor = t0 < t1 ? ( t - t0 ) / ( t1 - t0 ) : 0;
+
+        return linear_interp( a.value, b.value, factor );
     }
 
     RgCameraInfo SampleAnimation( const AnimationData& anim, const RgCameraInfo& base, float t )
@@ -513,16 +609,42 @@ void RTGL1::Scene::PrepareForFrame( VkCommandBuffer cmd,
     alreadyReplacedUniqueObjectIDs.clear();
     lastDynamicSun_uniqueId = std::nullopt;
 
+    if( curFrameCamera )
+    {
+        lastCameraPosition = MakeCameraPosition( *curFrameCamera );
+    }
     curFrameCamera     = {};
     cameraInfo_Default = {};
 
     m_staticSceneAnimationTime = staticSceneAnimationTime;
 
     // SHIPPING_HACK
-    for( const auto& [ obj, basetransf, anim ] : m_obj_ImportedAnim )
+    if( !m_obj_ImportedAnim.empty() )
     {
-        asManager->Hack_PatchGeomInfoTransformForStatic(
-            obj, SampleAnimationObj( anim, basetransf, m_staticSceneAnimationTime ) );
+        m_obj_ImportedAnimTransforms.clear();
+        for( const auto& [ obj, basetransf, anim ] : m_obj_ImportedAnim )
+        {
+            m_obj_ImportedAnimTransforms.emplace_back( obj, basetransf );
+        }
+
+        // small batches are sampled on the current thread
+        constexpr size_t BatchSize  = 256;
+        const size_t     batchCount = ( m_obj_ImportedAnim.size() + BatchSize - 1 ) / BatchSize;
+
+        Utils::ParallelFor( batchCount, [ this ]( size_t batch ) {
+            const size_t begin = batch * BatchSize;
+            const size_t end   = std::min( begin + BatchSize, m_obj_ImportedAnim.size() );
+
+            for( size_t i = begin; i < end; i++ )
+            {
+                const auto& [ obj, basetransf, anim ] = m_obj_ImportedAnim[ i ];
+
+                m_obj_ImportedAnimTransforms[ i ].second =
+                    SampleAnimationObj( anim, basetransf, m_staticSceneAnimationTime );
+            }
+        } );
+
+        asManager->Hack_PatchGeomInfoTransformsForStatic( m_obj_ImportedAnimTransforms );
     }
 }
 
@@ -530,24 +652,47 @@ void RTGL1::Scene::SubmitForFrame( VkCommandBuffer                         cmd,
                                    uint32_t                                frameIndex,
                                    const std::shared_ptr< GlobalUniform >& uniform,
                                    uint32_t uniformData_rayCullMaskWorld,
-                                   bool     disableRTGeometry )
+                                   bool     disableRTGeometry,
+                                   const RgDrawFrameInstanceCullingParams& culling,
+                                   const RgDrawFrameAreaVisibilityParams&  areas,
+                                   const TextureManager&                   textureManager,
+                                   GpuProfiler&                            profiler )
 {
+    asManager->FlushDynamicBatches( frameIndex, textureManager, *geomInfoMgr );
+
     // always submit dynamic geometry on the frame ending
-    asManager->SubmitDynamicGeometry( makingDynamic, cmd, frameIndex );
+    {
+        auto t = GpuProfiler::Scope{ profiler, cmd, GpuPass::AccelerationStructures };
+        asManager->SubmitDynamicGeometry( makingDynamic, cmd, frameIndex, *uniform );
+    }
+
+    asManager->CullDynamicInstances( *uniform, culling );
+    asManager->SelectLods( frameIndex, *uniform );
+    asManager->ApplyAreaVisibility( areas );
 
     // geom infos must be ready before vertex preprocessing
-    auto tlas     = asManager->MakeUniqueIDToTlasID( disableRTGeometry );
-    auto tlasSize = static_cast< uint32_t >( tlas.size() );
+    auto tlas = asManager->MakeUniqueIDToTlasID( disableRTGeometry );
 
     geomInfoMgr->CopyFromStaging( cmd, frameIndex, std::move( tlas ) );
 
-    vertPreproc->Preprocess(
-        cmd, frameIndex, VERT_PREPROC_MODE_ONLY_DYNAMIC, *uniform, *asManager, tlasSize );
+    {
+        auto t = GpuProfiler::Scope{ profiler, cmd, GpuPass::VertexPreprocessing };
+        vertPreproc->Preprocess( cmd,
+                                 frameIndex,
+                                 VERT_PREPROC_MODE_ONLY_DYNAMIC,
+                                 *uniform,
+                                 *asManager,
+                                 geomInfoMgr->GetPreprocessCandidates() );
+    }
 
-    asManager->BuildTLAS( cmd,
-                          frameIndex,
-                          uniformData_rayCullMaskWorld,
-                          disableRTGeometry );
+    {
+        auto t = GpuProfiler::Scope{ profiler, cmd, GpuPass::AccelerationStructures };
+        asManager->BuildTLAS( cmd,
+                              frameIndex,
+                              *uniform,
+                              uniformData_rayCullMaskWorld,
+                              disableRTGeometry );
+    }
 }
 
 bool RTGL1::Scene::ReplacementExists( const RgMeshInfo& mesh ) const
@@ -556,25 +701,33 @@ bool RTGL1::Scene::ReplacementExists( const RgMeshInfo& mesh ) const
     {
         if( mesh.flags & RG_MESH_EXPORT_AS_SEPARATE_FILE )
         {
-            return find_p( replacements, mesh.pMeshName );
+            return find_p( replacements, mesh.pMeshName ) ||
+                   lazyReplacementIndex.contains( std::string_view{ mesh.pMeshName } );
         }
     }
     return false;
 }
 
-RTGL1::UploadResult RTGL1::Scene::UploadPrimitive( uint32_t                   frameIndex,
-                                                   const RgMeshInfo&          mesh,
-                                                   const RgMeshPrimitiveInfo& primitive,
-                                                   const TextureManager&      textureManager,
-                                                   LightManager&              lightManager,
-                                                   bool                       isStatic )
+RTGL1::UploadResult RTGL1::Scene::UploadPrimitive(
+    uint32_t                                   frameIndex,
+    const RgMeshInfo&                          mesh,
+    const RgMeshPrimitiveInfo&                 primitive,
+    const TextureManager&                      textureManager,
+    LightManager&                              lightManager,
+    bool                                       isStatic,
+    std::span< const ASManager::PrimitiveLod > lods,
+    bool                                       allowBatching )
 {
+    RG_CPU_ZONE( "Scene::UploadPrimitive" );
+
     const auto uniqueID = PrimitiveUniqueID{ mesh, primitive };
 
     auto replacement = static_cast< const WholeModelFile::RawModelData* >( nullptr );
 
     if( !ignoreExternalGeometry )
     {
+        RG_CPU_ZONE( "Scene::UploadPrimitive replacement lookup" );
+
         if( !isStatic && mesh.isExportable && !Utils::IsCstrEmpty( mesh.pMeshName ) )
         {
             // if dynamic-exportable was already uploaded
@@ -588,6 +741,12 @@ RTGL1::UploadResult RTGL1::Scene::UploadPrimitive( uint32_t                   fr
             if( mesh.flags & RG_MESH_EXPORT_AS_SEPARATE_FILE )
             {
                 replacement = find_p( replacements, mesh.pMeshName );
+
+                // original geometry is drawn, until the replacement is loaded
+                if( !replacement && lazyReplacements )
+                {
+                    RequestReplacement( mesh.pMeshName );
+                }
             }
         }
     }
@@ -606,7 +765,9 @@ RTGL1::UploadResult RTGL1::Scene::UploadPrimitive( uint32_t                   fr
                                           isStatic,
                                           false,
                                           textureManager,
-                                          *geomInfoMgr ) )
+                                          *geomInfoMgr,
+                                          allowBatching,
+                                          lods ) )
         {
             return UploadResult::Fail;
         }
@@ -619,7 +780,9 @@ RTGL1::UploadResult RTGL1::Scene::UploadPrimitive( uint32_t                   fr
         // if a replacement for a mesh is present, upload it once
         if( !alreadyReplacedUniqueObjectIDs.contains( mesh.uniqueObjectID ) )
         {
-            constexpr bool isReplacement = true;
+            // lazily loaded replacements have no prebuilt BLAS,
+            // they are uploaded as dynamic geometry instead
+            const bool isReplacement = !lazyReplacements;
 
             for( uint32_t i = 0; i < replacement->primitives.size(); i++ )
             {
@@ -726,8 +889,16 @@ void RTGL1::Scene::SubmitStaticLights( uint32_t          frameIndex,
                                        bool              isUnderwater,
                                        RgColor4DPacked32 underwaterColor ) const
 {
+    lightManager.SetStaticLights( frameIndex, staticLights, staticLightsVersion );
+
     for( const LightCopy& l : staticLights )
     {
+        // others are already in the light manager
+        if( LightManager::IsCachedAsStatic( l ) )
+        {
+            continue;
+        }
+
         // SHIPPING_HACK begin - tint sun if underwater
         if( isUnderwater )
         {
@@ -798,12 +969,7 @@ bool RTGL1::Scene::InsertLightInfo( bool isStatic, const LightCopy& light )
     if( isStatic )
     {
         // just check that there's no id collision
-        auto foundSameId =
-            std::ranges::find_if( staticLights, [ &light ]( const LightCopy& other ) {
-                return other.base.uniqueID == light.base.uniqueID;
-            } );
-
-        if( foundSameId != staticLights.end() )
+        if( !staticLightLookup.uniqueIDs.emplace( light.base.uniqueID ).second )
         {
             debug::Warning(
                 "Trying add a static light with a uniqueID {} that other light already has",
@@ -811,8 +977,35 @@ bool RTGL1::Scene::InsertLightInfo( bool isStatic, const LightCopy& light )
             return false;
         }
 
+        const auto index = uint32_t( staticLights.size() );
+        auto&      lookup = staticLightLookup;
+
+        if( light.additional && ( light.additional->flags & RG_LIGHT_ADDITIONAL_VOLUMETRIC ) )
+        {
+            // clang-format off
+            std::visit( ext::overloaded{
+                [ & ]( const RgLightDirectionalEXT& lext ) { lookup.volumetricDirectional.push_back( index ); },
+                [ & ]( const RgLightSphericalEXT&   lext ) { lookup.volumetricPositional.Insert( index, lext.position ); },
+                [ & ]( const RgLightSpotEXT&        lext ) { lookup.volumetricPositional.Insert( index, lext.position ); },
+                [ & ]( const RgLightPolygonalEXT&   lext ) {},
+            }, light.extension );
+            // clang-format on
+
+            if( !lookup.firstVolumetric )
+            {
+                lookup.firstVolumetric = index;
+            }
+        }
+
+        if( !lookup.firstDirectional &&
+            std::holds_alternative< RgLightDirectionalEXT >( light.extension ) )
+        {
+            lookup.firstDirectional = index;
+        }
+
         // add to the list
         staticLights.push_back( light );
+        staticLightsVersion++;
         return true;
     }
     else
@@ -821,6 +1014,376 @@ bool RTGL1::Scene::InsertLightInfo( bool isStatic, const LightCopy& light )
     }
 }
 
+void RTGL1::Scene::IndexReplacements( const std::filesystem::path& replacementsFolder )
+{
+    // wait for the pending imports, as they reference the previous state
+    lazyReplacementFiles.clear();
+    lazyReplacementIndex.clear();
+    replacements.clear();
+
+    lazyReplacements = true;
+
+    debug::Verbose( "Indexing replacements..." );
+
+    // reverse alphabetical -- last ones have more priority
+    for( const auto& p :
+         std::ranges::reverse_view{ GetGltfFilesSortedAlphabetically( replacementsFolder ) } )
+    {
+        const size_t fileIndex = lazyReplacementFiles.size();
+        auto         meshNames = GltfImporter::ReadModelNames( p );
+
+        for( const auto& meshName : meshNames )
+        {
+            auto [ iter, isNew ] = lazyReplacementIndex.emplace( meshName, fileIndex );
+            if( !isNew )
+            {
+                debug::Warning( "Ignoring a replacement as it was already read "
+                                "from another .gltf file. \'{}\' - \'{}\'",
+                                meshName,
+                                p.string() );
+            }
+        }
+
+        lazyReplacementFiles.push_back( LazyReplacementFile{
+            .path      = p,
+            .meshNames = std::move( meshNames ),
+        } );
+    }
+
+    debug::Verbose( "Indexed {} replacements in {} files",
+                    lazyReplacementIndex.size(),
+                    lazyReplacementFiles.size() );
+}
+
+bool RTGL1::Scene::ReindexReplacementFile( const std::filesystem::path& path )
+{
+    // non-lazy replacements are baked into the static geometry
+    if( !lazyReplacements )
+    {
+        return false;
+    }
+
+    auto file = std::ranges::find_if( lazyReplacementFiles, [ &path ]( const auto& f ) {
+        std::error_code ec;
+        return std::filesystem::equivalent( f.path, path, ec );
+    } );
+
+    // a new file changes the priorities of the others
+    if( file == lazyReplacementFiles.end() )
+    {
+        return false;
+    }
+
+    const size_t fileIndex = std::distance( lazyReplacementFiles.begin(), file );
+
+    if( file->loading.valid() )
+    {
+        file->loading.wait();
+        file->loading = {};
+    }
+    file->requested = false;
+
+    // lazy replacements are uploaded each frame, so dropping the loaded data is enough
+    for( const auto& meshName : file->meshNames )
+    {
+        auto owner = lazyReplacementIndex.find( meshName );
+        if( owner != lazyReplacementIndex.end() && owner->second == fileIndex )
+        {
+            lazyReplacementIndex.erase( owner );
+            if( auto loaded = replacements.find( meshName ); loaded != replacements.end() )
+            {
+                replacements.erase( loaded );
+            }
+        }
+    }
+
+    file->meshNames = GltfImporter::ReadModelNames( path );
+
+    // files are in the priority order; a lower index wins
+    auto l_claim = [ this ]( const std::string& meshName, size_t index ) {
+        auto owner = lazyReplacementIndex.find( meshName );
+        if( owner == lazyReplacementIndex.end() )
+        {
+            lazyReplacementIndex.emplace( meshName, index );
+            return true;
+        }
+        if( owner->second > index )
+        {
+            owner->second = index;
+            if( auto loaded = replacements.find( meshName ); loaded != replacements.end() )
+            {
+                replacements.erase( loaded );
+            }
+            return true;
+        }
+        return false;
+    };
+
+    for( const auto& meshName : file->meshNames )
+    {
+        l_claim( meshName, fileIndex );
+    }
+
+    // meshes removed from the file fall back to the other files
+    for( size_t other = 0; other < lazyReplacementFiles.size(); other++ )
+    {
+        LazyReplacementFile& f = lazyReplacementFiles[ other ];
+        if( other == fileIndex )
+        {
+            continue;
+        }
+
+        bool claimed = false;
+        for( const auto& meshName : f.meshNames )
+        {
+            claimed |= l_claim( meshName, other );
+        }
+
+        // load again to get the claimed meshes
+        if( claimed && f.requested && !f.loading.valid() )
+        {
+            f.requested = false;
+        }
+    }
+
+    debug::Verbose( "Reindexed replacements from \'{}\'", path.string() );
+    return true;
+}
+
+void RTGL1::Scene::RequestReplacement( std::string_view meshName )
+{
+    auto found = lazyReplacementIndex.find( meshName );
+    if( found == lazyReplacementIndex.end() )
+    {
+        return;
+    }
+
+    LazyReplacementFile& f = lazyReplacementFiles[ found->second ];
+    if( f.requested )
+    {
+        return;
+    }
+    f.requested = true;
+
+    assert( importParams && importTextureMeta );
+    f.loading = std::async(
+        std::launch::async,
+        [ path = f.path, params = *importParams, textureMeta = importTextureMeta ]()
+            -> std::unique_ptr< WholeModelFile > //
+        {
+            if( auto i = GltfImporter{ path, params, *textureMeta, true } )
+            {
+                return std::make_unique< WholeModelFile >( i.Move() );
+            }
+            return {};
+        } );
+
+    debug::Verbose( "Loading replacements from \'{}\'", f.path.string() );
+}
+
+void RTGL1::Scene::TakeLoadedReplacements( VkCommandBuffer cmd,
+                                           uint32_t        frameIndex,
+                                           TextureManager& textureManager )
+{
+    for( size_t fileIndex = 0; fileIndex < lazyReplacementFiles.size(); fileIndex++ )
+    {
+        LazyReplacementFile& f = lazyReplacementFiles[ fileIndex ];
+
+        if( !f.loading.valid() ||
+            f.loading.wait_for( std::chrono::seconds{ 0 } ) != std::future_status::ready )
+        {
+            continue;
+        }
+
+        auto wholeGltf = f.loading.get();
+        if( !wholeGltf )
+        {
+            continue;
+        }
+
+        if( !wholeGltf->lights.empty() )
+        {
+            debug::Warning( "Ignoring non-attached lights from \'{}\'", f.path.string() );
+        }
+
+        for( const auto& mat : wholeGltf->materials )
+        {
+            textureManager.TryCreateImportedMaterial( cmd,
+                                                      frameIndex,
+                                                      mat.pTextureName,
+                                                      mat.fullPaths,
+                                                      mat.samplers,
+                                                      mat.pbrSwizzling,
+                                                      mat.isReplacement );
+        }
+
+        for( auto& [ meshName, meshSrc ] : wholeGltf->models )
+        {
+            // a file with more priority owns the name
+            auto owner = lazyReplacementIndex.find( std::string_view{ meshName } );
+            if( owner == lazyReplacementIndex.end() || owner->second != fileIndex )
+            {
+                continue;
+            }
+
+            // vertices are kept, as lazy replacements are uploaded each frame
+            replacements.emplace( meshName, std::move( meshSrc ) );
+        }
+    }
+}
+
+void RTGL1::Scene::WaitForAsyncImports()
+{
+    for( auto& f : lazyReplacementFiles )
+    {
+        if( f.loading.valid() )
+        {
+            f.loading.wait();
+        }
+    }
+    for( auto& c : sceneCells )
+    {
+        if( c.loading.valid() )
+        {
+            c.loading.wait();
+        }
+    }
+}
+
+void RTGL1::Scene::IndexSceneCells( const std::filesystem::path& staticSceneGltfPath )
+{
+    assert( sceneCells.empty() && importParams );
+
+    sceneCellSize =
+        SCENE_CELL_SIZE_METERS / std::max( importParams->oneGameUnitInMeters, 0.0001f );
+
+    const auto prefix = staticSceneGltfPath.stem().wstring() + std::wstring{ SCENE_CELL_SUFFIX };
+
+    for( const auto& p : GetGltfFilesSortedAlphabetically( staticSceneGltfPath.parent_path() ) )
+    {
+        const auto stem = p.stem().wstring();
+        if( !stem.starts_with( prefix ) )
+        {
+            continue;
+        }
+
+        auto coords = std::array< int, 3 >{};
+        if( std::swscanf( stem.c_str() + prefix.size(),
+                          L"%d_%d_%d",
+                          &coords[ 0 ],
+                          &coords[ 1 ],
+                          &coords[ 2 ] ) != 3 )
+        {
+            debug::Warning( "Ignoring a scene cell with invalid coordinates: {}", p.string() );
+            continue;
+        }
+
+        // so the game doesn't upload its own version of the meshes
+        for( const auto& meshName : GltfImporter::ReadModelNames( p ) )
+        {
+            staticMeshNames.emplace( meshName );
+        }
+
+        sceneCells.push_back( SceneCell{ .coords = coords, .path = p } );
+    }
+
+    if( !sceneCells.empty() )
+    {
+        debug::Verbose( "Found {} static scene cells", sceneCells.size() );
+    }
+}
+
+void RTGL1::Scene::StreamSceneCells( VkCommandBuffer cmd,
+                                     uint32_t        frameIndex,
+                                     TextureManager& textureManager,
+                                     LightManager&   lightManager )
+{
+    if( sceneCells.empty() )
+    {
+        return;
+    }
+
+    RG_CPU_ZONE( "Scene::StreamSceneCells" );
+
+    for( SceneCell& c : sceneCells )
+    {
+        // camera of the previous frame, as the current one is not known yet
+        int dist = SCENE_CELL_UNLOAD_RADIUS + 1;
+        if( lastCameraPosition )
+        {
+            dist = 0;
+            for( int i = 0; i < 3; i++ )
+            {
+                const auto camCoord = static_cast< int >(
+                    std::floor( lastCameraPosition->data[ i ] / sceneCellSize ) );
+                dist = std::max( dist, std::abs( c.coords[ i ] - camCoord ) );
+            }
+        }
+
+        if( dist <= SCENE_CELL_LOAD_RADIUS && !c.loaded && !c.loading.valid() )
+        {
+            assert( importParams && importTextureMeta );
+            c.loading = std::async(
+                std::launch::async,
+                [ path = c.path, params = *importParams, textureMeta = importTextureMeta ]()
+                    -> std::unique_ptr< WholeModelFile > //
+                {
+                    if( auto i = GltfImporter{ path, params, *textureMeta, false } )
+                    {
+                        return std::make_unique< WholeModelFile >( i.Move() );
+                    }
+                    return {};
+                } );
+        }
+
+        if( c.loading.valid() &&
+            c.loading.wait_for( std::chrono::seconds{ 0 } ) == std::future_status::ready )
+        {
+            c.loaded = c.loading.get();
+
+            if( c.loaded )
+            {
+                for( const auto& mat : c.loaded->materials )
+                {
+                    textureManager.TryCreateImportedMaterial( cmd,
+                                                              frameIndex,
+                                                              mat.pTextureName,
+                                                              mat.fullPaths,
+                                                              mat.samplers,
+                                                              mat.pbrSwizzling,
+                                                              mat.isReplacement );
+                }
+            }
+        }
+
+        // far cells are dropped, their BLAS-es are not referenced anymore
+        if( dist > SCENE_CELL_UNLOAD_RADIUS )
+        {
+            c.loaded.reset();
+            continue;
+        }
+
+        if( !c.loaded )
+        {
+            continue;
+        }
+
+        for( const auto& [ name, m ] : c.loaded->models )
+        {
+            const auto mesh = MakeMeshInfoFrom( name.c_str(), m );
+
+            for( uint32_t i = 0; i < m.primitives.size(); i++ )
+            {
+                MakeMeshPrimitiveInfoAndProcess(
+                    m.primitives[ i ], i, [ & ]( const RgMeshPrimitiveInfo& prim ) {
+                        UploadPrimitive(
+                            frameIndex, mesh, prim, textureManager, lightManager, false );
+                    } );
+            }
+        }
+    }
+}
+
 void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
                              uint32_t                     frameIndex,
                              const ImportExportParams&    params,
@@ -832,12 +1395,20 @@ void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
 {
     const bool reimportReplacements = !!replacementsFolder;
 
+    // wait for the pending imports, as they reference the previous state
+    sceneCells.clear();
+    importParams      = params;
+    importTextureMeta = &textureMeta;
+
     staticUniqueIDs.clear();
     staticMeshNames.clear();
     staticLights.clear();
+    staticLightsVersion++;
+    staticLightLookup = {};
     cameraInfo_Imported = {};
     m_cameraInfo_ImportedAnim = {};
     m_obj_ImportedAnim        = {};
+    m_obj_ImportedAnimTransforms.clear();
 
     {
         textureManager.FreeAllImportedMaterials( frameIndex, reimportReplacements );
@@ -846,9 +1417,16 @@ void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
     assert( !makingStatic );
     makingStatic = asManager->BeginStaticGeometry( reimportReplacements );
 
-    if( reimportReplacements )
+    if( reimportReplacements && LibConfig().lazyReplacements )
+    {
+        IndexReplacements( *replacementsFolder );
+    }
+    else if( reimportReplacements )
     {
         replacements.clear();
+        lazyReplacements = false;
+        lazyReplacementFiles.clear();
+        lazyReplacementIndex.clear();
 
         debug::Verbose( "Reading replacements..." );
         const auto gltfs = GetGltfFilesSortedAlphabetically( *replacementsFolder );
@@ -914,12 +1492,17 @@ void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
                         MakeMeshPrimitiveInfoAndProcess(
                             m.primitives[ index ], index, [ & ]( const RgMeshPrimitiveInfo& prim ) {
                                 asManager->CacheReplacement(
-                                    std::string_view{ meshName }, prim, index );
+                                    std::string_view{ meshName },
+                                    prim,
+                                    index,
+                                    textureManager,
+                                    MakePrimitiveLods( prim, m.primitives[ index ] ) );
                             } );
 
                         // save up some memory by not storing - as we uploaded already
                         m.primitives[ index ].vertices = {};
                         m.primitives[ index ].indices  = {};
+                        m.primitives[ index ].lods     = {};
                     }
 
                     if( m.primitives.empty() && m.localLights.empty() )
@@ -1018,8 +1601,16 @@ void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
                     m.primitives[ i ],
                     i, //
                     [ & ]( const RgMeshPrimitiveInfo& prim ) {
-                        UploadResult ur = this->UploadPrimitive(
-                            frameIndex, mesh, prim, textureManager, lightManager, true );
+                        // animated primitives are moved by their own instance transform
+                        UploadResult ur =
+                            this->UploadPrimitive( frameIndex,
+                                                   mesh,
+                                                   prim,
+                                                   textureManager,
+                                                   lightManager,
+                                                   true,
+                                                   MakePrimitiveLods( prim, m.primitives[ i ] ),
+                                                   IsAnimDataEmpty( m.animobj ) );
 
                         // SHIPPING_HACK begin
                         if( ( ur == UploadResult::ExportableStatic ||
@@ -1089,8 +1680,18 @@ void RTGL1::Scene::NewScene( VkCommandBuffer              cmd,
         debug::Info( "New scene is empty" );
     }
 
-    debug::Verbose( "Rebuilding static geometry. Waiting device idle..." );
-    asManager->SubmitStaticGeometry( makingStatic, reimportReplacements );
+    IndexSceneCells( staticSceneGltfPath );
+
+    debug::Verbose( "Rebuilding static geometry..." );
+    if( LibConfig().staticBlasCache && exists( staticSceneGltfPath ) )
+    {
+        const auto cacheFile = MakeBLASCacheFile( staticSceneGltfPath, replacementsFolder );
+        asManager->SubmitStaticGeometry( makingStatic, reimportReplacements, &cacheFile );
+    }
+    else
+    {
+        asManager->SubmitStaticGeometry( makingStatic, reimportReplacements );
+    }
 
     debug::Info( "Static geometry was rebuilt" );
 }
@@ -1109,7 +1710,40 @@ auto RTGL1::Scene::TryGetVolumetricLight( const LightManager& lightManager,
                                           const RgFloat3D&    cameraPos ) const
     -> std::optional< uint64_t >
 {
-    return lightManager.TryGetVolumetricLight( cameraPos, staticLights, lastDynamicSun_uniqueId );
+    const StaticLightLookup& lookup = staticLightLookup;
+
+    auto l_hasIntensity = [ & ]( uint32_t index ) {
+        return lightManager.ApproxVolumetricIntensity( staticLights[ index ] ) > 0.0f;
+    };
+
+    // directional lights are at zero distance, so the first one with intensity is the closest
+    for( uint32_t index : lookup.volumetricDirectional )
+    {
+        if( l_hasIntensity( index ) )
+        {
+            return staticLights[ index ].base.uniqueID;
+        }
+    }
+
+    if( auto closest = lookup.volumetricPositional.FindNearest( cameraPos, l_hasIntensity ) )
+    {
+        return staticLights[ *closest ].base.uniqueID;
+    }
+
+    // SHIPPING_HACK: don't fallback to sun, if at least
+    // one light is marked as isVolumetric, but has 0 intensity
+    if( lookup.firstVolumetric )
+    {
+        return staticLights[ *lookup.firstVolumetric ].base.uniqueID;
+    }
+
+    // if nothing, just try find the sun
+    if( lookup.firstDirectional )
+    {
+        return staticLights[ *lookup.firstDirectional ].base.uniqueID;
+    }
+
+    return lastDynamicSun_uniqueId;
 }
 
 bool RTGL1::Scene::StaticMeshExists( const RgMeshInfo& mesh ) const
@@ -1180,7 +1814,8 @@ void RTGL1::SceneImportExport::PrepareForFrame( std::string_view mapName,
 {
     // import
 
-    if( reimportStaticInNextFrame )
+    // if auto-exported, wait until the files are written
+    if( reimportStaticInNextFrame && !IsRunning( sceneExportJob ) )
     {
         reimportStatic            = true;
         reimportStaticInNextFrame = false;
@@ -1238,10 +1873,29 @@ void RTGL1::SceneImportExport::TryImportIfNew( VkCommandBuffer           cmd,
                                                LightManager&             lightManager,
                                                RgStaticSceneStatusFlags* out_staticSceneStatus )
 {
+    RG_HITCH_MARKER( "Scene import" );
+
     const bool newSceneRequested = reimportStatic || reimportStaticInNextFrame;
 
+    if( !reimportReplacements && !changedReplacements.empty() )
+    {
+        for( const auto& path : changedReplacements )
+        {
+            if( !scene.ReindexReplacementFile( path ) )
+            {
+                reimportReplacements = true;
+                break;
+            }
+        }
+    }
+    changedReplacements.clear();
+
     if( reimportReplacements || reimportStatic )
     {
+        // lazy replacements and scene cells are importing on other threads,
+        // and read texture properties
+        scene.WaitForAsyncImports();
+
         // before importer, as it relies on texture properties
         textureMeta.RereadFromFiles( GetImportMapName() );
 
@@ -1258,6 +1912,9 @@ void RTGL1::SceneImportExport::TryImportIfNew( VkCommandBuffer           cmd,
         reimportStatic       = false;
     }
 
+    scene.TakeLoadedReplacements( cmd, frameIndex, textureManager );
+    scene.StreamSceneCells( cmd, frameIndex, textureManager, lightManager );
+
     if( out_staticSceneStatus )
     {
         *out_staticSceneStatus = 0;
@@ -1274,28 +1931,57 @@ void RTGL1::SceneImportExport::TryImportIfNew( VkCommandBuffer           cmd,
         {
             ( *out_staticSceneStatus ) |= RG_STATIC_SCENE_STATUS_EXPORT_STARTED;
         }
+        if( IsRunning( sceneExportJob ) || IsRunning( replacementsExportJob ) )
+        {
+            ( *out_staticSceneStatus ) |= RG_STATIC_SCENE_STATUS_EXPORT_IN_PROGRESS;
+        }
+        else if( sceneExportJob.valid() || replacementsExportJob.valid() )
+        {
+            // reported once
+            bool success = true;
+            for( auto* job : { &sceneExportJob, &replacementsExportJob } )
+            {
+                if( job->valid() )
+                {
+                    success &= job->get();
+                }
+            }
+
+            if( success )
+            {
+                ( *out_staticSceneStatus ) |= RG_STATIC_SCENE_STATUS_EXPORT_FINISHED;
+            }
+        }
     }
 }
 
 void RTGL1::SceneImportExport::TryExport( const TextureManager&        textureManager,
                                           const std::filesystem::path& ovrdFolder )
 {
+    // files are written on worker threads; a previous export is waited, if it's still running
+
     if( sceneExporter )
     {
-        sceneExporter->ExportToFiles( MakeGltfPath< true >( scenesFolder, GetExportMapName() ),
-                                      textureManager,
-                                      ovrdFolder,
-                                      true );
-        sceneExporter.reset();
+        sceneExportJob = {};
+        sceneExportJob =
+            GltfExporter::ExportToFiles( std::move( sceneExporter ),
+                                         MakeGltfPath< true >( scenesFolder, GetExportMapName() ),
+                                         textureManager,
+                                         ovrdFolder,
+                                         true );
     }
 
     if( replacementsExporter && ( exportReplacementsRequest == ExportState::FinilizeIntoFile ||
                                   exportReplacementsRequest == ExportState::OneFrame ) )
     {
+        // the next free name is known only when the previous set is written
+        replacementsExportJob = {};
+
         auto setname = FindNextReplaceFileNameInFolder( replacementsFolder );
         if( !setname.empty() )
         {
-            replacementsExporter->ExportToFiles(
+            replacementsExportJob = GltfExporter::ExportToFiles(
+                std::move( replacementsExporter ),
                 MakeGltfPath< false >( replacementsFolder, setname ),
                 textureManager,
                 ovrdFolder,
@@ -1319,7 +2005,10 @@ void RTGL1::SceneImportExport::OnFileChanged( FileType type, const std::filesyst
         {
             debug::Info( "Hot-reloading GLTF replacements..." );
             debug::Info( "Triggered by: {}", SanitizePathToShow( filepath ) );
-            RequestReplacementsReimport();
+            if( std::ranges::find( changedReplacements, filepath ) == changedReplacements.end() )
+            {
+                changedReplacements.push_back( filepath );
+            }
         }
     }
 }
@@ -24,11 +24,15 @@
 #include "Camera.h"
 #include "GltfExporter.h"
 #include "GltfImporter.h"
+#include "GpuProfiler.h"
 #include "LightManager.h"
+#include "LightSpatialIndex.h"
 #include "VertexPreprocessing.h"
 #include "TextureMeta.h"
 #include "UniqueID.h"
 
+#include <future>
+
 namespace RTGL1
 {
 
@@ -61,9 +65,12 @@ public:
                     const ShaderManager&                    shaderManager,
                     uint64_t                                maxReplacementsVerts,
                     uint64_t                                maxDynamicVerts,
+                    uint32_t                                maxInstanceCount,
+                    uint32_t                                maxGeometryCount,
                     bool                                    enableTexCoordLayer1,
                     bool                                    enableTexCoordLayer2,
-                    bool                                    enableTexCoordLayer3 );
+                    bool                                    enableTexCoordLayer3,
+                    bool                                    quantizeStaticVertices );
     ~Scene() = default;
 
     Scene( const Scene& other )                = delete;
@@ -79,14 +86,20 @@ public:
                          uint32_t                                frameIndex,
                          const std::shared_ptr< GlobalUniform >& uniform,
                          uint32_t                                uniformData_rayCullMaskWorld,
-                         bool                                    disableRTGeometry );
-
-    UploadResult UploadPrimitive( uint32_t                   frameIndex,
-                                  const RgMeshInfo&          mesh,
-                                  const RgMeshPrimitiveInfo& primitive,
-                                  const TextureManager&      textureManager,
-                                  LightManager&              lightManager,
-                                  bool                       isStatic );
+                         bool                                    disableRTGeometry,
+                         const RgDrawFrameInstanceCullingParams& culling,
+                         const RgDrawFrameAreaVisibilityParams&  areas,
+                         const TextureManager&                   textureManager,
+                         GpuProfiler&                            profiler );
+
+    UploadResult UploadPrimitive( uint32_t                                   frameIndex,
+                                  const RgMeshInfo&                          mesh,
+                                  const RgMeshPrimitiveInfo&                 primitive,
+                                  const TextureManager&                      textureManager,
+                                  LightManager&                              lightManager,
+                                  bool                                       isStatic,
+                                  std::span< const ASManager::PrimitiveLod > lods = {},
+                                  bool                                       allowBatching = true );
 
     UploadResult UploadLight( uint32_t           frameIndex,
                               const LightCopy&   light,
@@ -116,6 +129,20 @@ public:
 
     bool ReplacementExists( const RgMeshInfo& mesh ) const;
 
+    // Register replacements that finished loading on other threads, if lazy
+    void TakeLoadedReplacements( VkCommandBuffer cmd,
+                                 uint32_t        frameIndex,
+                                 TextureManager& textureManager );
+    // Load static scene cells around the camera, drop far ones, and upload the loaded ones
+    void StreamSceneCells( VkCommandBuffer cmd,
+                           uint32_t        frameIndex,
+                           TextureManager& textureManager,
+                           LightManager&   lightManager );
+    void WaitForAsyncImports();
+    // Reload only one replacement file, if replacements are lazy and the file was indexed.
+    // Returns false, if the whole replacements folder must be reimported
+    bool ReindexReplacementFile( const std::filesystem::path& path );
+
     void          AddDefaultCamera( const RgCameraInfo& info );
     const Camera& GetCamera( float fallbackAspect );
 
@@ -132,6 +159,11 @@ private:
 
     bool InsertLightInfo( bool isStatic, const LightCopy& light );
 
+    void IndexReplacements( const std::filesystem::path& replacementsFolder );
+    void RequestReplacement( std::string_view meshName );
+
+    void IndexSceneCells( const std::filesystem::path& staticSceneGltfPath );
+
 private:
     std::shared_ptr< ASManager >           asManager;
     std::shared_ptr< GeomInfoManager >     geomInfoMgr;
@@ -144,6 +176,18 @@ private:
     rgl::unordered_set< PrimitiveUniqueID > staticUniqueIDs;
     rgl::string_set                         staticMeshNames;
     std::vector< LightCopy >                staticLights;
+    uint64_t                                staticLightsVersion{ 0 };
+    // Filled on insertion, so per-frame queries don't scan all static lights
+    struct StaticLightLookup
+    {
+        rgl::unordered_set< uint64_t > uniqueIDs{};
+        // indices in 'staticLights' of the volumetric ones
+        LightSpatialIndex              volumetricPositional{};
+        std::vector< uint32_t >        volumetricDirectional{};
+        std::optional< uint32_t >      firstVolumetric{};
+        std::optional< uint32_t >      firstDirectional{};
+    };
+    StaticLightLookup                       staticLightLookup{};
     std::optional< uint64_t >               lastDynamicSun_uniqueId{};
 
     std::optional< Camera >       curFrameCamera{};
@@ -152,12 +196,43 @@ private:
 
     rgl::string_map< WholeModelFile::RawModelData > replacements;
 
+    // If lazy, only mesh names are read on reimport; a file is imported when any
+    // of its meshes is requested, the original geometry is drawn meanwhile
+    struct LazyReplacementFile
+    {
+        std::filesystem::path                            path{};
+        std::vector< std::string >                       meshNames{};
+        std::future< std::unique_ptr< WholeModelFile > > loading{};
+        bool                                             requested{ false };
+    };
+    bool                               lazyReplacements{ false };
+    std::vector< LazyReplacementFile > lazyReplacementFiles{};
+    rgl::string_map< size_t >          lazyReplacementIndex{};
+
+    // Static scene cells are uploaded as dynamic geometry, while they're near the camera
+    struct SceneCell
+    {
+        std::array< int, 3 >                             coords{};
+        std::filesystem::path                            path{};
+        std::future< std::unique_ptr< WholeModelFile > > loading{};
+        std::unique_ptr< WholeModelFile >                loaded{};
+    };
+    std::vector< SceneCell >   sceneCells{};
+    float                      sceneCellSize{ 1.0f };
+    std::optional< RgFloat3D > lastCameraPosition{};
+
+    // For the imports on other threads
+    std::optional< ImportExportParams > importParams{};
+    const TextureMetaManager*           importTextureMeta{ nullptr };
+
     StaticGeometryToken  makingStatic{};
     DynamicGeometryToken makingDynamic{};
 
     bool ignoreExternalGeometry{};
 
     std::vector< std::tuple< PrimitiveUniqueID, RgTransform, AnimationData > > m_obj_ImportedAnim{};
+    // sampled from 'm_obj_ImportedAnim' each frame, in the same order
+    std::vector< std::pair< PrimitiveUniqueID, RgTransform > > m_obj_ImportedAnimTransforms{};
     AnimationData m_cameraInfo_ImportedAnim{};
     float         m_staticSceneAnimationTime{ 0 };
 
@@ -218,6 +293,8 @@ private:
 
     bool reimportStatic;
     bool reimportReplacements;
+    // replacement files to reload separately, if the whole folder is not reimported
+    std::vector< std::filesystem::path > changedReplacements{};
 
     bool reimportStaticInNextFrame;
 
@@ -233,6 +310,8 @@ private:
     ExportState                     exportReplacementsRequest{ ExportState::None };
     std::unique_ptr< GltfExporter > sceneExporter{};
     std::unique_ptr< GltfExporter > replacementsExporter{};
+    std::future< bool >             sceneExportJob{};
+    std::future< bool >             replacementsExportJob{};
 
     std::string currentMap{};
     RgFloat3D   worldUp;
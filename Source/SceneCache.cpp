@@ -0,0 +1,542 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "SceneCache.h"
+
+#include "LibraryConfig.h"
+#include "TextureMeta.h"
+#include "Utils.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+
+constexpr char     CACHE_MAGIC[ 4 ] = { 'R', 'G', 'S', 'C' };
+constexpr uint32_t CACHE_VERSION    = 2;
+
+// arrays are aligned in the file, so they are copied from the mapped memory efficiently
+constexpr size_t ARRAY_ALIGN = 16;
+
+struct FileHeader
+{
+    char     magic[ 4 ];
+    uint32_t version;
+    uint64_t key;
+    // to reject the file, if it wasn't fully written
+    uint64_t payloadSize;
+    // to reject the file, if the layout of the vertices is changed
+    uint32_t vertexSize;
+    uint32_t reserved;
+};
+static_assert( sizeof( FileHeader ) % ARRAY_ALIGN == 0 );
+
+class Writer
+{
+public:
+    template< typename T >
+    void Value( const T& v )
+    {
+        static_assert( std::is_trivially_copyable_v< T > );
+        Bytes( &v, sizeof( T ) );
+    }
+
+    template< typename Container >
+    void Array( const Container& arr )
+    {
+        using T = typename Container::value_type;
+        static_assert( std::is_trivially_copyable_v< T > );
+
+        Value( uint64_t{ arr.size() } );
+        data.resize( RTGL1::Utils::Align( data.size(), ARRAY_ALIGN ) );
+        Bytes( arr.data(), arr.size() * sizeof( T ) );
+    }
+
+    template< typename T >
+    void Optional( const std::optional< T >& v )
+    {
+        Value( uint8_t{ v.has_value() } );
+        if( v )
+        {
+            Value( *v );
+        }
+    }
+
+    void Path( const std::filesystem::path& p ) { Array( p.generic_u8string() ); }
+
+    std::vector< uint8_t > data;
+
+private:
+    void Bytes( const void* src, size_t size )
+    {
+        const auto* b = static_cast< const uint8_t* >( src );
+        data.insert( data.end(), b, b + size );
+    }
+};
+
+// All reads are bounds-checked, a corrupted file makes the read fail
+class Reader
+{
+public:
+    explicit Reader( std::span< const uint8_t > _src ) : src{ _src } {}
+
+    template< typename T >
+    [[nodiscard]] bool Value( T& dst )
+    {
+        static_assert( std::is_trivially_copyable_v< T > );
+        if( sizeof( T ) > src.size() - offset )
+        {
+            return false;
+        }
+
+        memcpy( &dst, src.data() + offset, sizeof( T ) );
+        offset += sizeof( T );
+
+        // pointers are not valid anymore
+        if constexpr( requires { dst.pNext; } )
+        {
+            dst.pNext = nullptr;
+        }
+        return true;
+    }
+
+    template< typename Container >
+    [[nodiscard]] bool Array( Container& dst )
+    {
+        using T = typename Container::value_type;
+        static_assert( std::is_trivially_copyable_v< T > );
+
+        uint64_t count = 0;
+        if( !Value( count ) )
+        {
+            return false;
+        }
+
+        offset = RTGL1::Utils::Align( offset, ARRAY_ALIGN );
+        if( offset > src.size() || count > ( src.size() - offset ) / sizeof( T ) )
+        {
+            return false;
+        }
+
+        dst.resize( size_t( count ) );
+        memcpy( dst.data(), src.data() + offset, size_t( count ) * sizeof( T ) );
+        offset += size_t( count ) * sizeof( T );
+        return true;
+    }
+
+    template< typename T >
+    [[nodiscard]] bool Optional( std::optional< T >& dst )
+    {
+        uint8_t has = 0;
+        if( !Value( has ) )
+        {
+            return false;
+        }
+
+        dst.reset();
+        if( has )
+        {
+            return Value( dst.emplace() );
+        }
+        return true;
+    }
+
+    [[nodiscard]] bool Path( std::filesystem::path& dst )
+    {
+        auto str = std::u8string{};
+        if( !Array( str ) )
+        {
+            return false;
+        }
+
+        dst = std::filesystem::path{ str };
+        return true;
+    }
+
+    bool IsAtEnd() const { return offset == src.size(); }
+
+private:
+    std::span< const uint8_t > src;
+    size_t                     offset{ 0 };
+};
+
+template< size_t I = 0 >
+bool ReadLightExtension( Reader& r, uint8_t index, RTGL1::AnyLightEXT& dst )
+{
+    if constexpr( I < std::variant_size_v< RTGL1::AnyLightEXT > )
+    {
+        if( index == I )
+        {
+            return r.Value( dst.emplace< I >() );
+        }
+        return ReadLightExtension< I + 1 >( r, index, dst );
+    }
+    else
+    {
+        return false;
+    }
+}
+
+
+void Write( Writer& w, const RTGL1::LightCopy& light )
+{
+    w.Value( light.base );
+    w.Value( uint8_t( light.extension.index() ) );
+    std::visit( [ &w ]( const auto& ext ) { w.Value( ext ); }, light.extension );
+    w.Optional( light.additional );
+}
+
+bool Read( Reader& r, RTGL1::LightCopy& light )
+{
+    uint8_t index = 0;
+    return r.Value( light.base ) && r.Value( index ) &&
+           ReadLightExtension( r, index, light.extension ) && r.Optional( light.additional );
+}
+
+void Write( Writer& w, const RTGL1::AnimationData& anim )
+{
+    w.Array( anim.position.frames );
+    w.Array( anim.quaternion.frames );
+    w.Array( anim.fovYRadians.frames );
+    // if adding a new AnimationChannel, add it also here
+}
+
+bool Read( Reader& r, RTGL1::AnimationData& anim )
+{
+    return r.Array( anim.position.frames ) && r.Array( anim.quaternion.frames ) &&
+           r.Array( anim.fovYRadians.frames );
+}
+
+template< typename T >
+void WriteVector( Writer& w, const std::vector< T >& arr );
+template< typename T >
+bool ReadVector( Reader& r, std::vector< T >& arr );
+
+void Write( Writer& w, const RTGL1::WholeModelFile::RawLodData& lod )
+{
+    w.Array( lod.vertices );
+    w.Array( lod.indices );
+    w.Value( lod.error );
+}
+
+bool Read( Reader& r, RTGL1::WholeModelFile::RawLodData& lod )
+{
+    return r.Array( lod.vertices ) && r.Array( lod.indices ) && r.Value( lod.error );
+}
+
+void Write( Writer& w, const RTGL1::WholeModelFile::RawPrimitiveData& prim )
+{
+    w.Array( prim.vertices );
+    w.Array( prim.indices );
+    w.Value( prim.flags );
+    w.Array( prim.textureName );
+    w.Value( prim.color );
+    w.Value( prim.emissive );
+    w.Optional( prim.attachedLight );
+    w.Optional( prim.pbr );
+    w.Optional( prim.portal );
+    WriteVector( w, prim.lods );
+}
+
+bool Read( Reader& r, RTGL1::WholeModelFile::RawPrimitiveData& prim )
+{
+    return r.Array( prim.vertices ) && r.Array( prim.indices ) && r.Value( prim.flags ) &&
+           r.Array( prim.textureName ) && r.Value( prim.color ) && r.Value( prim.emissive ) &&
+           r.Optional( prim.attachedLight ) && r.Optional( prim.pbr ) &&
+           r.Optional( prim.portal ) && ReadVector( r, prim.lods );
+}
+
+void Write( Writer& w, const RTGL1::WholeModelFile::RawMaterialData& mat )
+{
+    w.Value( uint8_t{ mat.isReplacement } );
+    w.Value( mat.pbrSwizzling );
+    w.Array( mat.pTextureName );
+    for( const auto& p : mat.fullPaths )
+    {
+        w.Path( p );
+    }
+    for( const auto& s : mat.samplers )
+    {
+        w.Value( s );
+    }
+    w.Value( uint8_t{ mat.trackOriginalTexture } );
+}
+
+bool Read( Reader& r, RTGL1::WholeModelFile::RawMaterialData& mat )
+{
+    uint8_t isReplacement = 0, trackOriginalTexture = 0;
+
+    if( !r.Value( isReplacement ) || !r.Value( mat.pbrSwizzling ) ||
+        !r.Array( mat.pTextureName ) )
+    {
+        return false;
+    }
+    for( auto& p : mat.fullPaths )
+    {
+        if( !r.Path( p ) )
+        {
+            return false;
+        }
+    }
+    for( auto& s : mat.samplers )
+    {
+        if( !r.Value( s ) )
+        {
+            return false;
+        }
+    }
+    if( !r.Value( trackOriginalTexture ) )
+    {
+        return false;
+    }
+
+    mat.isReplacement        = isReplacement != 0;
+    mat.trackOriginalTexture = trackOriginalTexture != 0;
+    return true;
+}
+
+template< typename T >
+void WriteVector( Writer& w, const std::vector< T >& arr )
+{
+    w.Value( uint64_t{ arr.size() } );
+    for( const T& v : arr )
+    {
+        Write( w, v );
+    }
+}
+
+template< typename T >
+bool ReadVector( Reader& r, std::vector< T >& arr )
+{
+    uint64_t count = 0;
+    if( !r.Value( count ) )
+    {
+        return false;
+    }
+
+    arr.clear();
+    for( uint64_t i = 0; i < count; i++ )
+    {
+        if( !Read( r, arr.emplace_back() ) )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Write( Writer& w, const RTGL1::WholeModelFile::RawModelData& model )
+{
+    w.Value( model.uniqueObjectID );
+    w.Value( model.meshTransform );
+    WriteVector( w, model.primitives );
+    WriteVector( w, model.localLights );
+    Write( w, model.animobj );
+}
+
+bool Read( Reader& r, RTGL1::WholeModelFile::RawModelData& model )
+{
+    return r.Value( model.uniqueObjectID ) && r.Value( model.meshTransform ) &&
+           ReadVector( r, model.primitives ) && ReadVector( r, model.localLights ) &&
+           Read( r, model.animobj );
+}
+
+void Write( Writer& w, const RTGL1::WholeModelFile& model )
+{
+    // string_map preserves the insertion order, so the models are restored in the same order
+    w.Value( uint64_t{ model.models.size() } );
+    for( const auto& [ name, m ] : model.models )
+    {
+        w.Array( name );
+        Write( w, m );
+    }
+    WriteVector( w, model.lights );
+    w.Optional( model.camera );
+    Write( w, model.animcamera );
+    WriteVector( w, model.materials );
+}
+
+bool Read( Reader& r, RTGL1::WholeModelFile& model )
+{
+    uint64_t modelCount = 0;
+    if( !r.Value( modelCount ) )
+    {
+        return false;
+    }
+
+    for( uint64_t i = 0; i < modelCount; i++ )
+    {
+        auto name = std::string{};
+        auto m    = RTGL1::WholeModelFile::RawModelData{};
+        if( !r.Array( name ) || !Read( r, m ) )
+        {
+            return false;
+        }
+        model.models.emplace( std::move( name ), std::move( m ) );
+    }
+
+    if( !ReadVector( r, model.lights ) || !r.Optional( model.camera ) ||
+        !Read( r, model.animcamera ) || !ReadVector( r, model.materials ) )
+    {
+        return false;
+    }
+
+    if( model.camera )
+    {
+        model.camera->pView = nullptr;
+    }
+    return true;
+}
+
+}
+
+auto RTGL1::MakeSceneCacheFile( const std::filesystem::path& gltfPath,
+                                const ImportExportParams&    params,
+                                const TextureMetaManager&    textureMeta,
+                                bool                         isReplacement ) -> SceneCacheFile
+{
+    using ankerl::unordered_dense::detail::wyhash::hash;
+
+    uint64_t key = 0;
+
+    const auto combine = [ &key ]( uint64_t h ) {
+        key ^= h + 0x9e3779b9 + ( key << 6 ) + ( key >> 2 );
+    };
+
+    const auto addFile = [ &combine ]( const std::filesystem::path& path ) {
+        std::error_code ec;
+
+        const auto size = file_size( path, ec );
+        const auto time = last_write_time( path, ec );
+        if( ec )
+        {
+            return;
+        }
+
+        const auto     str      = path.generic_string();
+        const uint64_t values[] = {
+            hash( str.data(), str.size() ),
+            size,
+            static_cast< uint64_t >( time.time_since_epoch().count() ),
+        };
+
+        combine( hash( values, sizeof( values ) ) );
+    };
+
+    addFile( gltfPath );
+    addFile( std::filesystem::path{ gltfPath }.replace_extension( ".bin" ) );
+
+    // texture meta is applied to the primitives on import
+    for( const auto& p : textureMeta.SourceFiles() )
+    {
+        addFile( p );
+    }
+
+    static_assert( std::is_trivially_copyable_v< ImportExportParams > );
+    combine( hash( &params, sizeof( params ) ) );
+    combine( isReplacement ? 1 : 0 );
+    // LODs are generated and vertices are reordered on import
+    combine( LibConfig().meshLods ? 1 : 0 );
+    combine( LibConfig().meshOptimization ? 1 : 0 );
+
+    return SceneCacheFile{
+        .path = std::filesystem::path{ gltfPath }.replace_extension( ".scenecache" ),
+        .key  = key,
+    };
+}
+
+auto RTGL1::LoadSceneCache( const SceneCacheFile& file ) -> std::optional< WholeModelFile >
+{
+    void*  view   = nullptr;
+    size_t size   = 0;
+    void*  handle = nullptr;
+    if( !Utils::MapFile( file.path, &view, &size, &handle ) )
+    {
+        return std::nullopt;
+    }
+
+    const auto* bytes = static_cast< const uint8_t* >( view );
+
+    auto header = FileHeader{};
+    if( size >= sizeof( FileHeader ) )
+    {
+        memcpy( &header, bytes, sizeof( FileHeader ) );
+    }
+
+    if( size < sizeof( FileHeader ) ||
+        memcmp( header.magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) ) != 0 ||
+        header.version != CACHE_VERSION || header.key != file.key ||
+        header.vertexSize != sizeof( RgPrimitiveVertex ) ||
+        header.payloadSize != size - sizeof( FileHeader ) )
+    {
+        Utils::UnmapFile( view, size, handle );
+        return std::nullopt;
+    }
+
+    auto r     = Reader{ std::span{ bytes + sizeof( FileHeader ), size - sizeof( FileHeader ) } };
+    auto model = WholeModelFile{};
+
+    const bool ok = Read( r, model ) && r.IsAtEnd();
+    Utils::UnmapFile( view, size, handle );
+
+    if( !ok )
+    {
+        debug::Warning( "Scene cache is corrupted, ignoring: {}", file.path.string() );
+        return std::nullopt;
+    }
+
+    debug::Verbose( "Loaded scene from cache: {}", file.path.string() );
+    return model;
+}
+
+void RTGL1::SaveSceneCache( const SceneCacheFile& file, const WholeModelFile& model )
+{
+    auto w = Writer{};
+    Write( w, model );
+
+    auto header = FileHeader{
+        .version     = CACHE_VERSION,
+        .key         = file.key,
+        .payloadSize = w.data.size(),
+        .vertexSize  = sizeof( RgPrimitiveVertex ),
+        .reserved    = 0,
+    };
+    memcpy( header.magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) );
+
+    auto f = std::ofstream( file.path, std::ios::binary | std::ios::trunc );
+    if( !f )
+    {
+        debug::Warning( "Can't write scene cache: {}", file.path.string() );
+        return;
+    }
+
+    f.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+    f.write( reinterpret_cast< const char* >( w.data.data() ),
+             static_cast< std::streamsize >( w.data.size() ) );
+
+    if( !f )
+    {
+        debug::Warning( "Can't write scene cache: {}", file.path.string() );
+        return;
+    }
+
+    debug::Verbose( "Saved scene to cache: {}", file.path.string() );
+}
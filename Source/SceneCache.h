@@ -0,0 +1,51 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "GltfImporter.h"
+
+#include <filesystem>
+
+namespace RTGL1
+{
+
+// Location and identity of the converted gltf scene.
+// Key must change, if the gltf files or the import parameters are changed
+struct SceneCacheFile
+{
+    std::filesystem::path path;
+    uint64_t              key;
+};
+
+// Cache file is stored next to the .gltf. Files are identified by their size and
+// modification time, not to read them twice
+auto MakeSceneCacheFile( const std::filesystem::path& gltfPath,
+                         const ImportExportParams&    params,
+                         const TextureMetaManager&    textureMeta,
+                         bool                         isReplacement ) -> SceneCacheFile;
+
+// Memory-map the cache and restore the model from it, without any gltf parsing.
+// Null, if the file is missing, is of an older version or its key doesn't match
+auto LoadSceneCache( const SceneCacheFile& file ) -> std::optional< WholeModelFile >;
+
+void SaveSceneCache( const SceneCacheFile& file, const WholeModelFile& model );
+
+}
@@ -29,11 +29,13 @@ RTGL1::ChunkedStackAllocator::ChunkedStackAllocator( std::shared_ptr< MemoryAllo
                                                      VkBufferUsageFlags                  _usage,
                                                      VkDeviceSize     _initialChunkSize,
                                                      VkDeviceSize     _alignment,
-                                                     std::string_view _debugName )
+                                                     std::string_view _debugName,
+                                                     uint32_t         _trimAfterIdleResets )
     : allocator{ _allocator }
     , usage{ _usage }
     , chunkAllocSize{ Utils::Align( _initialChunkSize, _alignment ) }
     , alignment{ _alignment }
+    , trimAfterIdleResets{ _trimAfterIdleResets }
     , debugName{ _debugName }
 {
 }
@@ -68,16 +70,78 @@ auto RTGL1::ChunkedStackAllocator::Push( VkDeviceSize size ) -> PushResult
 
 void RTGL1::ChunkedStackAllocator::Reset()
 {
+    VkDeviceSize used   = 0;
+    VkDeviceSize wasted = 0;
+
     for( auto& c : chunks )
     {
+        if( c.currentOffset > 0 )
+        {
+            used += c.currentOffset;
+            wasted += c.buffer.GetSize() - c.currentOffset;
+            c.idleResets = 0;
+        }
+        else
+        {
+            c.idleResets++;
+        }
         c.currentOffset = 0;
     }
+
+    peakUsedSize   = std::max( peakUsedSize, used );
+    lastWastedSize = wasted;
+
+    if( trimAfterIdleResets > 0 )
+    {
+        // chunks are taken in order, so idle ones are beyond the recent high-water mark
+        chunks.remove_if(
+            [ this ]( const ChunkBuffer& c ) { return c.idleResets >= trimAfterIdleResets; } );
+    }
+}
+
+void RTGL1::ChunkedStackAllocator::Free()
+{
+    chunks.clear();
+}
+
+auto RTGL1::ChunkedStackAllocator::GetAllocatedSize() const -> VkDeviceSize
+{
+    VkDeviceSize total = 0;
+    for( const auto& c : chunks )
+    {
+        total += c.buffer.GetSize();
+    }
+    return total;
+}
+
+auto RTGL1::ChunkedStackAllocator::GetStats() const -> Stats
+{
+    VkDeviceSize used = 0;
+    for( const auto& c : chunks )
+    {
+        used += c.currentOffset;
+    }
+
+    return Stats{
+        .allocatedSize = GetAllocatedSize(),
+        .peakUsedSize  = std::max( peakUsedSize, used ),
+        .wastedSize    = lastWastedSize,
+        .chunkCount    = uint32_t( chunks.size() ),
+    };
 }
 
 auto RTGL1::ChunkedStackAllocator::AllocateChunk( VkDeviceSize size ) -> PushResult
 {
     const auto chunkSize = std::max( chunkAllocSize, Utils::Align( size, alignment ) );
 
+    constexpr VkBufferUsageFlags storageUsage =
+        VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
+        VK_BUFFER_USAGE_MICROMAP_STORAGE_BIT_EXT;
+
+    auto memoryScope = MemoryCategoryScope{ usage & storageUsage
+                                                ? RG_UTIL_MEMORY_CATEGORY_ACCELERATION_STRUCTURES
+                                                : RG_UTIL_MEMORY_CATEGORY_SCRATCH };
+
     if( const auto alloc = allocator.lock() )
     {
         auto& c = chunks.emplace_back();
@@ -110,3 +174,170 @@ auto RTGL1::ChunkedStackAllocator::AllocateChunk( VkDeviceSize size ) -> PushRes
     assert( 0 );
     return {};
 }
+
+RTGL1::ChunkedPoolAllocator::ChunkedPoolAllocator( std::shared_ptr< MemoryAllocator >& _allocator,
+                                                   VkBufferUsageFlags                  _usage,
+                                                   VkDeviceSize                        _chunkSize,
+                                                   VkDeviceSize                        _alignment,
+                                                   std::string_view                    _debugName )
+    : allocator{ _allocator }
+    , usage{ _usage }
+    , chunkAllocSize{ Utils::Align( _chunkSize, _alignment ) }
+    , alignment{ _alignment }
+    , debugName{ _debugName }
+{
+}
+
+RTGL1::ChunkedPoolAllocator::~ChunkedPoolAllocator()
+{
+    assert( usedSize == 0 && "All allocations must be freed before the pool" );
+
+    for( auto& c : chunks )
+    {
+        DestroyChunk( c );
+    }
+}
+
+void RTGL1::ChunkedPoolAllocator::DestroyChunk( Chunk& c )
+{
+    if( c.block != VK_NULL_HANDLE )
+    {
+        vmaClearVirtualBlock( c.block );
+        vmaDestroyVirtualBlock( c.block );
+        c.block = VK_NULL_HANDLE;
+    }
+    c.buffer.Destroy();
+}
+
+auto RTGL1::ChunkedPoolAllocator::TryAlloc( Chunk& c, VkDeviceSize alignedSize )
+    -> std::optional< Allocation >
+{
+    auto info = VmaVirtualAllocationCreateInfo{
+        .size      = alignedSize,
+        .alignment = alignment,
+    };
+
+    VmaVirtualAllocation handle = VK_NULL_HANDLE;
+    VkDeviceSize         offset = 0;
+
+    if( vmaVirtualAllocate( c.block, &info, &handle, &offset ) != VK_SUCCESS )
+    {
+        return std::nullopt;
+    }
+
+    c.usedSize += alignedSize;
+    usedSize += alignedSize;
+    peakUsedSize = std::max( peakUsedSize, usedSize );
+
+    const auto result = Allocation{
+        .address        = c.buffer.GetAddress() + offset,
+        .buffer         = c.buffer.GetBuffer(),
+        .offsetInBuffer = offset,
+        .size           = alignedSize,
+        .handle         = handle,
+        .chunk          = &c,
+    };
+
+    assert( result.offsetInBuffer % alignment == 0 );
+    assert( result.address % alignment == 0 );
+
+    return result;
+}
+
+auto RTGL1::ChunkedPoolAllocator::Alloc( VkDeviceSize size ) -> Allocation
+{
+    const VkDeviceSize alignedSize = Utils::Align( size, alignment );
+
+    // find a chunk with a fitting free range
+    for( auto& c : chunks )
+    {
+        if( auto result = TryAlloc( c, alignedSize ) )
+        {
+            return *result;
+        }
+    }
+
+    // couldn't find chunk, create new one
+    const auto alloc = allocator.lock();
+    if( !alloc )
+    {
+        assert( 0 );
+        return {};
+    }
+
+    const auto chunkSize = std::max( chunkAllocSize, alignedSize );
+
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_ACCELERATION_STRUCTURES };
+
+    auto& c = chunks.emplace_back();
+    c.buffer.Init( *alloc,
+                   chunkSize,
+                   VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | usage,
+                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                   debugName.c_str() );
+
+    if( c.buffer.GetAddress() % alignment != 0 )
+    {
+        throw RgException( RG_RESULT_ERROR_MEMORY_ALIGNMENT,
+                           "Allocated VkBuffer's address was not aligned" );
+    }
+
+    auto blockInfo = VmaVirtualBlockCreateInfo{
+        .size = chunkSize,
+    };
+    VkResult r = vmaCreateVirtualBlock( &blockInfo, &c.block );
+    VK_CHECKERROR( r );
+
+    auto result = TryAlloc( c, alignedSize );
+    assert( result );
+
+    return result ? *result : Allocation{};
+}
+
+void RTGL1::ChunkedPoolAllocator::Free( const Allocation& allocation )
+{
+    if( allocation.handle == VK_NULL_HANDLE )
+    {
+        return;
+    }
+
+    for( auto it = chunks.begin(); it != chunks.end(); ++it )
+    {
+        if( &( *it ) != allocation.chunk )
+        {
+            continue;
+        }
+
+        vmaVirtualFree( it->block, allocation.handle );
+
+        assert( it->usedSize >= allocation.size && usedSize >= allocation.size );
+        it->usedSize -= allocation.size;
+        usedSize -= allocation.size;
+
+        // keep one chunk, so a mesh that appears every other frame doesn't recreate it
+        if( it->usedSize == 0 && chunks.size() > 1 )
+        {
+            DestroyChunk( *it );
+            chunks.erase( it );
+        }
+        return;
+    }
+
+    assert( 0 && "Allocation doesn't belong to this pool" );
+}
+
+auto RTGL1::ChunkedPoolAllocator::GetStats() const -> ChunkedStackAllocator::Stats
+{
+    VkDeviceSize allocated = 0;
+    for( const auto& c : chunks )
+    {
+        allocated += c.buffer.GetSize();
+    }
+
+    return ChunkedStackAllocator::Stats{
+        .allocatedSize = allocated,
+        .peakUsedSize  = peakUsedSize,
+        .wastedSize    = allocated - usedSize,
+        .chunkCount    = uint32_t( chunks.size() ),
+    };
+}
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <list>
+#include <optional>
 
 #include "Buffer.h"
 
@@ -30,6 +31,8 @@ namespace RTGL1
 // Each chunk is a buffer that acts like a stack.
 // This class is a list of such chunks.
 // All returned addresses are guaranteed to be valid until reset.
+// If trimAfterIdleResets is not 0, chunks that were not used during that count of resets
+// are released on reset, so a single heavy frame doesn't keep the memory until shutdown.
 class ChunkedStackAllocator
 {
 public:
@@ -37,7 +40,8 @@ public:
                                     VkBufferUsageFlags                  usage,
                                     VkDeviceSize                        initialChunkSize,
                                     VkDeviceSize                        alignment,
-                                    std::string_view                    debugName );
+                                    std::string_view                    debugName,
+                                    uint32_t                            trimAfterIdleResets = 0 );
     ~ChunkedStackAllocator() = default;
 
     ChunkedStackAllocator( const ChunkedStackAllocator& other )                = delete;
@@ -54,6 +58,21 @@ public:
 
     auto Push( VkDeviceSize size ) -> PushResult;
     void Reset();
+    // Release the memory of all chunks
+    void Free();
+
+    auto GetAllocatedSize() const -> VkDeviceSize;
+
+    struct Stats
+    {
+        VkDeviceSize allocatedSize;
+        // max of pushed bytes between resets
+        VkDeviceSize peakUsedSize;
+        // unused tails of chunks, that had allocations before the last reset
+        VkDeviceSize wastedSize;
+        uint32_t     chunkCount;
+    };
+    auto GetStats() const -> Stats;
 
 private:
     auto AllocateChunk( VkDeviceSize size ) -> PushResult;
@@ -63,6 +82,7 @@ private:
     {
         Buffer       buffer{};
         VkDeviceSize currentOffset{ 0 };
+        uint32_t     idleResets{ 0 };
     };
 
     std::weak_ptr< MemoryAllocator > allocator;
@@ -72,6 +92,70 @@ private:
 
     const VkDeviceSize chunkAllocSize;
     const VkDeviceSize alignment;
+    const uint32_t     trimAfterIdleResets;
+
+    VkDeviceSize peakUsedSize{ 0 };
+    VkDeviceSize lastWastedSize{ 0 };
+
+    std::string debugName;
+};
+
+// Chunks of buffers, where each allocation can be freed individually.
+// Suballocates objects with their own lifetimes, so they don't need a buffer each.
+// Chunks that became empty are released, except the last one.
+class ChunkedPoolAllocator
+{
+public:
+    explicit ChunkedPoolAllocator( std::shared_ptr< MemoryAllocator >& allocator,
+                                   VkBufferUsageFlags                  usage,
+                                   VkDeviceSize                        chunkSize,
+                                   VkDeviceSize                        alignment,
+                                   std::string_view                    debugName );
+    ~ChunkedPoolAllocator();
+
+    ChunkedPoolAllocator( const ChunkedPoolAllocator& other )                = delete;
+    ChunkedPoolAllocator( ChunkedPoolAllocator&& other ) noexcept            = delete;
+    ChunkedPoolAllocator& operator=( const ChunkedPoolAllocator& other )     = delete;
+    ChunkedPoolAllocator& operator=( ChunkedPoolAllocator&& other ) noexcept = delete;
+
+    struct Allocation
+    {
+        VkDeviceAddress      address;
+        VkBuffer             buffer;
+        VkDeviceSize         offsetInBuffer;
+        VkDeviceSize         size;
+        VmaVirtualAllocation handle;
+        const void*          chunk;
+    };
+
+    auto Alloc( VkDeviceSize size ) -> Allocation;
+    // Must be called only after the GPU stopped using the allocation
+    void Free( const Allocation& allocation );
+
+    auto GetStats() const -> ChunkedStackAllocator::Stats;
+
+private:
+    struct Chunk
+    {
+        Buffer          buffer{};
+        VmaVirtualBlock block{ VK_NULL_HANDLE };
+        VkDeviceSize    usedSize{ 0 };
+    };
+
+    auto        TryAlloc( Chunk& c, VkDeviceSize alignedSize ) -> std::optional< Allocation >;
+    static void DestroyChunk( Chunk& c );
+
+private:
+    std::weak_ptr< MemoryAllocator > allocator;
+    std::list< Chunk >               chunks;
+
+    VkBufferUsageFlags usage;
+
+    const VkDeviceSize chunkAllocSize;
+    const VkDeviceSize alignment;
+
+    VkDeviceSize usedSize{ 0 };
+    VkDeviceSize peakUsedSize{ 0 };
 
     std::string debugName;
 };
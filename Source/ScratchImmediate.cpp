@@ -22,6 +22,7 @@
 
 #include <cassert>
 
+#include "BatchMath.h"
 #include "Common.h"
 #include "DrawFrameInfo.h"
 #include "RgException.h"
@@ -253,14 +254,80 @@ void RTGL1::ScratchImmediate::EndPrimitive()
     assert( lastbatch->startVertex <= lastbatch->end );
 
     auto localIndices = GetIndices( *accumTopology, lastbatch->Count() );
-    for( const auto i : localIndices )
+
+    const size_t start = accumIndices.size();
+    accumIndices.resize( start + localIndices.size() );
+
+    uint32_t* dst = accumIndices.data() + start;
+    for( size_t i = 0; i < localIndices.size(); i++ )
     {
-        accumIndices.push_back( lastbatch->startVertex + i );
+        dst[ i ] = lastbatch->startVertex + localIndices[ i ];
     }
 
     lastbatch = std::nullopt;
 }
 
+void RTGL1::ScratchImmediate::Vertices( const float*             pPositions,
+                                        const float*             pNormals,
+                                        const float*             pTexCoords,
+                                        const RgColor4DPacked32* pColors,
+                                        uint32_t                 count )
+{
+    if( count == 0 )
+    {
+        return;
+    }
+
+    if( !pPositions )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "pPositions is null" );
+    }
+
+    const size_t start = verts.size();
+    verts.resize( start + count, accumVertex );
+
+    RgPrimitiveVertex* dst = verts.data() + start;
+    for( uint32_t v = 0; v < count; v++ )
+    {
+        memcpy( dst[ v ].position, &pPositions[ v * 3 ], 3 * sizeof( float ) );
+    }
+    if( pTexCoords )
+    {
+        for( uint32_t v = 0; v < count; v++ )
+        {
+            memcpy( dst[ v ].texCoord, &pTexCoords[ v * 2 ], 2 * sizeof( float ) );
+        }
+    }
+    if( pColors )
+    {
+        for( uint32_t v = 0; v < count; v++ )
+        {
+            dst[ v ].color = pColors[ v ];
+        }
+    }
+    if( pNormals )
+    {
+        static_assert( sizeof( RgFloat3D ) == 3 * sizeof( float ) );
+        BatchMath::PackNormals( reinterpret_cast< const RgFloat3D* >( pNormals ),
+                                count,
+                                &dst[ 0 ].normalPacked,
+                                sizeof( RgPrimitiveVertex ) );
+    }
+
+    if( accumTexLayer1 )
+    {
+        texLayer1.insert( texLayer1.end(), count, *accumTexLayer1 );
+    }
+    if( accumTexLayer2 )
+    {
+        texLayer2.insert( texLayer2.end(), count, *accumTexLayer2 );
+    }
+    if( accumTexLayer3 )
+    {
+        texLayer3.insert( texLayer3.end(), count, *accumTexLayer3 );
+    }
+}
+
 namespace
 {
 
@@ -74,6 +74,13 @@ public:
         verts.push_back( accumVertex );
     }
 
+    // Bulk version of Vertex(), null arrays are taken from the current attributes
+    void Vertices( const float*             pPositions,
+                   const float*             pNormals,
+                   const float*             pTexCoords,
+                   const RgColor4DPacked32* pColors,
+                   uint32_t                 count );
+
     void Normal( float x, float y, float z )
     {
         accumVertex.normalPacked = Utils::PackNormal( x, y, z );
@@ -96,6 +103,7 @@ public:
                                             uint32_t                vertexCount );
 
 private:
+    // cleared, but not freed by Clear(), so the capacity is retained across frames
     std::vector< RgPrimitiveVertex > verts;
     std::vector< RgFloat2D >         texLayer1;
     std::vector< RgFloat2D >         texLayer2;
@@ -23,7 +23,10 @@
 #include <fstream>
 #include <vector>
 #include <cstring>
+#include "Const.h"
+#include "HitchRecorder.h"
 #include "RgException.h"
+#include "Utils.h"
 
 #include "Generated/ShaderCommonC.h"
 
@@ -32,6 +35,8 @@ using namespace RTGL1;
 enum
 {
     USES_RAY_QUERY_OR_POSITION_FETCH = 1,
+    // if shader invocation reordering is supported, "<name>_SER.<ext>.spv" file is used instead
+    HAS_INVOCATION_REORDER_VARIANT = 2,
 };
 
 struct ShaderModuleDefinition
@@ -49,10 +54,12 @@ struct ShaderModuleDefinition
 static ShaderModuleDefinition G_SHADERS[] =
 {
     { "RGenPrimary",                "RtRaygenPrimary.rgen.spv"              },
-    { "RGenReflRefr",               "RtRaygenReflRefr.rgen.spv"             },
+    { "RGenReflRefr",               "RtRaygenReflRefr.rgen.spv"             , HAS_INVOCATION_REORDER_VARIANT },
     { "RGenDirect",                 "RtRaygenDirect.rgen.spv"               },
-    { "RGenIndirectInit",           "RtRaygenIndirectInit.rgen.spv"         },
+    { "RGenIndirectInit",           "RtRaygenIndirectInit.rgen.spv"         , HAS_INVOCATION_REORDER_VARIANT },
     { "CmIndirectFinal",            "RtRaygenIndirectFinal.comp.spv"        },
+    { "CRayQueryPrimary",           "CmRayQueryPrimary.comp.spv"            , USES_RAY_QUERY_OR_POSITION_FETCH },
+    { "CVisibilityResolve",         "CmVisibilityResolve.comp.spv"          , USES_RAY_QUERY_OR_POSITION_FETCH },
     { "RGenGradients",              "RtGradients.rgen.spv"                  },
     { "RInitialReservoirs",         "RtInitialReservoirs.rgen.spv"          },
     { "RVolumetric",                "RtVolumetric.rgen.spv"                 },
@@ -65,10 +72,14 @@ static ShaderModuleDefinition G_SHADERS[] =
 #endif
     { "CPrepareFinal",              "CmPrepareFinal.comp.spv"               },
     { "CLuminanceHistogram",        "CmLuminanceHistogram.comp.spv"         },
-    { "CLuminanceAvg",              "CmLuminanceAvg.comp.spv"               },
     { "CVolumetricProcess",         "CmVolumetricProcess.comp.spv"          },
     { "ScatterAccum",               "CmScatterAccum.comp.spv"               },
     { "Fluid_Generate",             "Fluid_Generate.comp.spv"               },
+    { "Fluid_HashCount",            "Fluid_HashCount.comp.spv"              },
+    { "Fluid_HashScan",             "Fluid_HashScan.comp.spv"               },
+    { "Fluid_HashScanBlocks",       "Fluid_HashScanBlocks.comp.spv"         },
+    { "Fluid_HashReorder",          "Fluid_HashReorder.comp.spv"            },
+    { "Fluid_Density",              "Fluid_Density.comp.spv"                },
     { "Fluid_Particles",            "Fluid_Particles.comp.spv"              , USES_RAY_QUERY_OR_POSITION_FETCH },
     { "Fluid_VisualizeVert",        "Fluid_Visualize.vert.spv"              },
     { "Fluid_VisualizeFrag",        "Fluid_Visualize.frag.spv"              },
@@ -78,15 +89,24 @@ static ShaderModuleDefinition G_SHADERS[] =
     { "FragSky",                    "RsSky.frag.spv"                        },
     { "FragSwapchain",              "RsSwapchain.frag.spv"                  },
     { "VertDefault",                "RsRasterizer.vert.spv"                 },
+    { "VertSwapchain",              "RsRasterizerSwapchain.vert.spv"        },
     { "VertDefaultMultiview",       "RsRasterizerMultiview.vert.spv"        },
     { "VertFullscreenQuad",         "RsFullscreenQuad.vert.spv"             },
     { "FragDepthCopying",           "RsDepthCopying.frag.spv"               },
     { "CVertexPreprocess",          "CmVertexPreprocess.comp.spv"           },
-    { "CAntiFirefly",               "CmAntiFirefly.comp.spv"                },
+    { "CSkinning",                  "CmSkinning.comp.spv"                   },
+    { "CParticleExpand",            "CmParticleExpand.comp.spv"             },
+    { "CMipmaps",                   "CmMipmaps.comp.spv"                    },
+    { "CSkyPrefilter",              "CmSkyPrefilter.comp.spv"               },
+    { "CReadbackNV12",              "CmReadbackNV12.comp.spv"               },
+    { "CTlasInstances",             "CmTlasInstances.comp.spv"              },
     { "CSVGFTemporalAccum",         "CmSVGFTemporalAccumulation.comp.spv"   },
     { "CSVGFVarianceEstim",         "CmSVGFEstimateVariance.comp.spv"       },
+    { "CSampleBudget",              "CmSampleBudget.comp.spv"               },
+    { "CIrradianceCacheResolve",    "CmIrradianceCacheResolve.comp.spv"     },
     { "CSVGFAtrous",                "CmSVGFAtrous.comp.spv"                 },
-    { "CSVGFAtrous_Iter0",          "CmSVGFAtrous_Iter0.comp.spv"           },
+    { "CSVGFAtrous_Iter01",         "CmSVGFAtrous_Iter01.comp.spv"          },
+    { "CNoisyComposition",          "CmNoisyComposition.comp.spv"           },
     { "CASVGFGradientAtrous",       "CmASVGFGradientAtrous.comp.spv"        },
     { "CBloomDownsample",           "CmBloomDownsample.comp.spv"            },
     { "CBloomUpsample",             "CmBloomUpsample.comp.spv"              },
@@ -110,6 +130,7 @@ static ShaderModuleDefinition G_SHADERS[] =
     { "EffectTeleport",             "EfTeleport.comp.spv"                   },
     { "EffectHueShift",             "EfHueShift.comp.spv"                   },
     { "EffectNightVision",          "EfNightVision.comp.spv"                },
+    { "EffectFusedPointwise",       "EfFusedPointwise.comp.spv"             },
     { "EffectCrtDemodulateEncode",  "EfCrtDemodulateEncode.comp.spv"        },
     { "EffectCrtDecode",            "EfCrtDecode.comp.spv"                  },
     { "EffectVHS",                  "EfVHS.comp.spv"                        },
@@ -119,35 +140,100 @@ static ShaderModuleDefinition G_SHADERS[] =
 
 // clang-format on
 
+namespace
+{
+
+// Layout of SHADERS_ARCHIVE_FILE, must match GenerateShaders.py
+constexpr char     ARCHIVE_MAGIC[ 4 ] = { 'R', 'G', 'S', 'P' };
+constexpr uint32_t ARCHIVE_VERSION    = 1;
+
+struct ArchiveHeader
+{
+    char     magic[ 4 ];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+struct ArchiveEntry
+{
+    // null-terminated .spv file name
+    char     filename[ 56 ];
+    // from the beginning of the file, 4-byte aligned to be passed to vkCreateShaderModule as is
+    uint32_t offset;
+    uint32_t size;
+};
+static_assert( sizeof( ArchiveHeader ) == 16 );
+static_assert( sizeof( ArchiveEntry ) == 64 );
+
+}
+
 ShaderManager::ShaderManager( VkDevice              _device,
                               std::filesystem::path _shaderFolderPath,
-                              bool                  _supportsRayQueryAndPositionFetch )
+                              bool                  _supportsRayQueryAndPositionFetch,
+                              bool                  _supportsInvocationReorder,
+                              bool                  _preferLooseFiles,
+                              VkPipelineCache       _pipelineCache )
     : device( _device )
     , shaderFolderPath( std::move( _shaderFolderPath ) )
     , supportsRayQueryAndPositionFetch( _supportsRayQueryAndPositionFetch )
+    , supportsInvocationReorder( _supportsInvocationReorder )
+    , preferLooseFiles( _preferLooseFiles )
+    , pipelineCache( _pipelineCache )
 {
+    OpenArchive();
     LoadShaderModules();
+    changedModules.clear();
 }
 
 ShaderManager::~ShaderManager()
 {
     UnloadShaderModules();
+    CloseArchive();
 }
 
 void ShaderManager::ReloadShaders()
 {
-    vkDeviceWaitIdle( device );
+    RG_HITCH_MARKER( "Shader reload" );
 
-    UnloadShaderModules();
-    LoadShaderModules();
+    changedModules.clear();
+
+    auto replaced = LoadShaderModules();
+
+    if( changedModules.empty() )
+    {
+        debug::Info( "Shaders are up to date" );
+        return;
+    }
+    debug::Info( "Reloading {} shader(s)", changedModules.size() );
 
+    vkDeviceWaitIdle( device );
+
+    // only the pipelines that use changed modules will be recreated by subscribers
     NotifySubscribersAboutReload();
+    changedModules.clear();
+
+    for( VkShaderModule m : replaced )
+    {
+        vkDestroyShaderModule( device, m, nullptr );
+    }
 
     vkDeviceWaitIdle( device );
 }
 
-void ShaderManager::LoadShaderModules()
+std::vector< VkShaderModule > ShaderManager::LoadShaderModules()
 {
+    auto replaced = std::vector< VkShaderModule >{};
+
+    struct ToLoad
+    {
+        const ShaderModuleDefinition* def{};
+        std::filesystem::path         path{};
+        uint64_t                      hash{ 0 };
+        VkShaderModule                module{ VK_NULL_HANDLE };
+    };
+    auto toLoad = std::vector< ToLoad >{};
+
     for( auto& s : G_SHADERS )
     {
         assert( strlen( s.filename ) > 0 );
@@ -172,11 +258,55 @@ void ShaderManager::LoadShaderModules()
 
         auto path = shaderFolderPath / s.filename;
 
-        VkShaderModule m = LoadModuleFromFile( path.c_str() );
-        SET_DEBUG_NAME( device, m, VK_OBJECT_TYPE_SHADER_MODULE, s.name );
+        if( ( s.flags & HAS_INVOCATION_REORDER_VARIANT ) && supportsInvocationReorder )
+        {
+            auto filename = std::string_view{ s.filename };
+            auto dot      = filename.find( '.' );
+
+            path = shaderFolderPath / ( std::string( filename.substr( 0, dot ) ) + "_SER" +
+                                        std::string( filename.substr( dot ) ) );
+        }
+
+        toLoad.push_back( ToLoad{ .def = &s, .path = std::move( path ) } );
+    }
+
+    // reading and module creation are independent for each shader
+    Utils::ParallelFor( toLoad.size(), [ & ]( size_t i ) {
+        ToLoad& l = toLoad[ i ];
+
+        auto       storage = std::vector< uint8_t >{};
+        const auto code    = ReadModule( l.path, storage );
+        l.hash = ankerl::unordered_dense::detail::wyhash::hash( code.data(), code.size() );
+
+        auto existing = modules.find( l.def->name );
+        if( existing != modules.end() && existing->second.contentHash == l.hash )
+        {
+            return;
+        }
+
+        l.module = LoadModuleFromMemory( reinterpret_cast< const uint32_t* >( code.data() ),
+                                         uint32_t( code.size() ) );
+        SET_DEBUG_NAME( device, l.module, VK_OBJECT_TYPE_SHADER_MODULE, l.def->name );
+    } );
+
+    for( const ToLoad& l : toLoad )
+    {
+        if( l.module == VK_NULL_HANDLE )
+        {
+            continue;
+        }
+
+        auto existing = modules.find( l.def->name );
+        if( existing != modules.end() )
+        {
+            replaced.push_back( existing->second.module );
+        }
 
-        modules[ s.name ] = { m, s.stage };
+        modules[ l.def->name ] = { l.module, l.def->stage, l.hash };
+        changedModules.emplace( l.def->name );
     }
+
+    return replaced;
 }
 
 void ShaderManager::UnloadShaderModules()
@@ -221,7 +351,90 @@ VkPipelineShaderStageCreateInfo ShaderManager::GetStageInfo( std::string_view na
     };
 }
 
-VkShaderModule ShaderManager::LoadModuleFromFile( const std::filesystem::path& path )
+void ShaderManager::OpenArchive()
+{
+    const auto path = shaderFolderPath / SHADERS_ARCHIVE_FILE;
+
+    if( !Utils::MapFile( path, &archiveView, &archiveSize, &archiveHandle ) )
+    {
+        archiveView   = nullptr;
+        archiveSize   = 0;
+        archiveHandle = nullptr;
+        return;
+    }
+
+    const auto* bytes = static_cast< const uint8_t* >( archiveView );
+
+    auto header = ArchiveHeader{};
+    if( archiveSize >= sizeof( ArchiveHeader ) )
+    {
+        memcpy( &header, bytes, sizeof( ArchiveHeader ) );
+    }
+
+    const uint64_t indexSize = uint64_t( header.entryCount ) * sizeof( ArchiveEntry );
+
+    if( archiveSize < sizeof( ArchiveHeader ) ||
+        memcmp( header.magic, ARCHIVE_MAGIC, sizeof( ARCHIVE_MAGIC ) ) != 0 ||
+        header.version != ARCHIVE_VERSION || archiveSize < sizeof( ArchiveHeader ) + indexSize )
+    {
+        debug::Warning( "Ignoring invalid shader archive: {}", path.string() );
+        CloseArchive();
+        return;
+    }
+
+    for( uint32_t i = 0; i < header.entryCount; i++ )
+    {
+        auto e = ArchiveEntry{};
+        memcpy( &e, bytes + sizeof( ArchiveHeader ) + i * sizeof( ArchiveEntry ), sizeof( e ) );
+
+        const auto filename =
+            std::string_view{ e.filename, strnlen( e.filename, sizeof( e.filename ) ) };
+
+        if( e.offset % sizeof( uint32_t ) != 0 || uint64_t( e.offset ) + e.size > archiveSize ||
+            filename.empty() )
+        {
+            debug::Warning( "Ignoring invalid shader archive: {}", path.string() );
+            CloseArchive();
+            return;
+        }
+
+        archiveEntries[ std::string( filename ) ] = std::span{ bytes + e.offset, e.size };
+    }
+}
+
+void ShaderManager::CloseArchive()
+{
+    if( archiveView )
+    {
+        Utils::UnmapFile( archiveView, archiveSize, archiveHandle );
+    }
+
+    archiveView   = nullptr;
+    archiveSize   = 0;
+    archiveHandle = nullptr;
+    archiveEntries.clear();
+}
+
+auto ShaderManager::ReadModule( const std::filesystem::path& path,
+                                std::vector< uint8_t >&      storage ) const
+    -> std::span< const uint8_t >
+{
+    const auto packed = archiveEntries.find( path.filename().string() );
+
+    if( packed != archiveEntries.end() )
+    {
+        std::error_code ec;
+        if( !preferLooseFiles || !std::filesystem::exists( path, ec ) )
+        {
+            return packed->second;
+        }
+    }
+
+    storage = ReadModuleFile( path );
+    return storage;
+}
+
+std::vector< uint8_t > ShaderManager::ReadModuleFile( const std::filesystem::path& path )
 {
     std::ifstream          shaderFile( path, std::ios::binary );
     std::vector< uint8_t > shaderSource( std::istreambuf_iterator( shaderFile ), {} );
@@ -232,8 +445,19 @@ VkShaderModule ShaderManager::LoadModuleFromFile( const std::filesystem::path& p
                            "Can't find shader file: \"" + path.string() + "\"" );
     }
 
-    return LoadModuleFromMemory( reinterpret_cast< const uint32_t* >( shaderSource.data() ),
-                                 uint32_t( shaderSource.size() ) );
+    return shaderSource;
+}
+
+bool ShaderManager::AnyChanged( std::initializer_list< std::string_view > names ) const
+{
+    for( std::string_view n : names )
+    {
+        if( changedModules.contains( n ) )
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 VkShaderModule ShaderManager::LoadModuleFromMemory( const uint32_t* pCode, uint32_t codeSize )
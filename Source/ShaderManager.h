@@ -27,6 +27,7 @@
 
 #include <filesystem>
 #include <list>
+#include <span>
 #include <string>
 
 namespace RTGL1
@@ -38,7 +39,10 @@ class ShaderManager
 public:
     explicit ShaderManager( VkDevice              device,
                             std::filesystem::path shaderFolderPath,
-                            bool                  supportsRayQueryAndPositionFetch );
+                            bool                  supportsRayQueryAndPositionFetch,
+                            bool                  supportsInvocationReorder,
+                            bool                  preferLooseFiles,
+                            VkPipelineCache       pipelineCache );
     ~ShaderManager();
 
     ShaderManager( const ShaderManager& other )                = delete;
@@ -46,12 +50,20 @@ public:
     ShaderManager& operator=( const ShaderManager& other )     = delete;
     ShaderManager& operator=( ShaderManager&& other ) noexcept = delete;
 
+    // Recreate only the modules which files were changed, and notify subscribers
     void ReloadShaders();
 
     VkShaderModule                  GetShaderModule( std::string_view name ) const;
     VkShaderStageFlagBits           GetModuleStage( std::string_view name ) const;
     VkPipelineShaderStageCreateInfo GetStageInfo( std::string_view name ) const;
 
+    // Valid during OnShaderReload: true, if any of the modules was replaced in that reload.
+    // Subscribers can use it to skip recreation of the pipelines that don't use those modules
+    bool AnyChanged( std::initializer_list< std::string_view > names ) const;
+
+    // Cache that must be used for the creation of each pipeline
+    VkPipelineCache GetPipelineCache() const { return pipelineCache; }
+
     // Subscribe to shader reload event.
     // shared_ptr will be transformed to weak_ptr
     void Subscribe( std::shared_ptr< IShaderDependency > subscriber );
@@ -61,15 +73,22 @@ private:
     {
         VkShaderModule        module;
         VkShaderStageFlagBits shaderStage;
+        uint64_t              contentHash;
     };
 
 private:
     static VkShaderStageFlagBits GetStageByExtension( std::string_view name );
 
-    VkShaderModule LoadModuleFromFile( const std::filesystem::path& path );
-    VkShaderModule LoadModuleFromMemory( const uint32_t* pCode, uint32_t codeSize );
-    void           LoadShaderModules();
-    void           UnloadShaderModules();
+    static std::vector< uint8_t > ReadModuleFile( const std::filesystem::path& path );
+    // Zero-copy, if the module is taken from the archive, otherwise 'storage' is filled
+    auto ReadModule( const std::filesystem::path& path, std::vector< uint8_t >& storage ) const
+        -> std::span< const uint8_t >;
+    void OpenArchive();
+    void CloseArchive();
+    VkShaderModule                LoadModuleFromMemory( const uint32_t* pCode, uint32_t codeSize );
+    // Returns the old modules that were replaced
+    std::vector< VkShaderModule > LoadShaderModules();
+    void                          UnloadShaderModules();
 
     void NotifySubscribersAboutReload();
 
@@ -77,8 +96,19 @@ private:
     VkDevice              device;
     std::filesystem::path shaderFolderPath;
     bool                  supportsRayQueryAndPositionFetch;
+    bool                  supportsInvocationReorder;
+    // if true, a loose .spv file overrides its copy in the archive, for hot reload
+    bool                  preferLooseFiles;
+    VkPipelineCache       pipelineCache;
+
+    // memory-mapped SHADERS_ARCHIVE_FILE, empty if there's none
+    void*                                         archiveView{ nullptr };
+    size_t                                        archiveSize{ 0 };
+    void*                                         archiveHandle{ nullptr };
+    rgl::string_map< std::span< const uint8_t > > archiveEntries;
 
     rgl::unordered_map< std::filesystem::path, ShaderModule > modules;
+    rgl::string_set                                           changedModules;
 
     std::list< std::weak_ptr< IShaderDependency > > subscribers;
 };
@@ -0,0 +1,78 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef COMPOSE_ILLUMINATION_H_
+#define COMPOSE_ILLUMINATION_H_
+
+#include "BRDF.h"
+
+// Modulate the demodulated illumination with the surface's material.
+// pix -- checkerboarded pixel
+vec3 composeIllumination( const ivec2 pix, const vec3 diffuse, const vec3 specularIn, const vec3 indirect )
+{
+    vec3 albedo = texelFetch( framebufAlbedo_Sampler, getRegularPixFromCheckerboardPix( pix ), 0 ).rgb;
+    vec3 throughput = texelFetch( framebufThroughput_Sampler, pix, 0 ).rgb;
+    if( ( globalUniform.debugShowFlags & DEBUG_SHOW_FLAG_ALBEDO_WHITE ) != 0 )
+    {
+        albedo = vec3( 1.0 );
+    }
+
+    if( isSkyPix( pix ) )
+    {
+        return albedo * throughput;
+    }
+
+    const vec2 mrFb = texelFetch( framebufMetallicRoughness_Sampler, pix, 0 ).xy;
+
+    const float metallic  = mrFb.x;
+    const float roughness = mrFb.y;
+
+    // to prevent noise, specular will be replaced with indir, if the surface is too rough
+    const vec3 specular = mix( specularIn,
+                               indirect,
+                               smoothstep( FAKE_ROUGH_SPECULAR_THRESHOLD,
+                                           FAKE_ROUGH_SPECULAR_THRESHOLD + FAKE_ROUGH_SPECULAR_LENGTH,
+                                           roughness ) );
+
+    const vec3 ro_s = getSpecularColor( albedo, metallic );
+    const vec3 ro_d = albedo * ( 1.0 - metallic );
+
+    vec3 illuminated = ( diffuse + indirect ) * ro_d + specular * ro_s;
+
+    if( ( globalUniform.debugShowFlags & DEBUG_SHOW_FLAG_ONLY_DIRECT_DIFFUSE ) != 0 )
+    {
+        illuminated = diffuse * albedo;
+    }
+    else if( ( globalUniform.debugShowFlags & DEBUG_SHOW_FLAG_ONLY_SPECULAR ) != 0 )
+    {
+        illuminated = specular * getSpecularColor( albedo, metallic );
+    }
+    else if( ( globalUniform.debugShowFlags & DEBUG_SHOW_FLAG_ONLY_INDIRECT_DIFFUSE ) != 0 )
+    {
+        illuminated = indirect;
+    }
+
+    illuminated *= throughput;
+    illuminated *= getMaterialAmbient( albedo );
+
+    return max( vec3( 0.0 ), illuminated );
+}
+
+#endif // COMPOSE_ILLUMINATION_H_
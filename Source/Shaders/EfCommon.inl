@@ -23,6 +23,8 @@
     #error Define EFFECT_SOURCE_IS_PING or EFFECT_SOURCE_IS_PONG to boolean value
 #endif
 
+#include "ThreadGroupSwizzle.h"
+
 
 ivec2 effect_getFramebufSize()
 {
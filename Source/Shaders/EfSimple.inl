@@ -40,15 +40,15 @@ layout(push_constant) uniform EffectSimplePush_BT
 } push;
 
 // 0 - no effect, 1 - full effect
-float getProgress()
+float getProgressOf(uint transitionType, float transitionBeginTime, float transitionDuration)
 {
     float progress = 
-        max(globalUniform.time - push.transitionBeginTime, 0.001) / 
-        max(push.transitionDuration, 0.001);
+        max(globalUniform.time - transitionBeginTime, 0.001) / 
+        max(transitionDuration, 0.001);
 
     progress = clamp(progress, 0, 1);
 
-    if (push.transitionType == 1)
+    if (transitionType == 1)
     {
         return 1.0 - progress;
     }
@@ -57,3 +57,8 @@ float getProgress()
         return progress;
     }
 }
+
+float getProgress()
+{
+    return getProgressOf(push.transitionType, push.transitionBeginTime, push.transitionDuration);
+}
\ No newline at end of file
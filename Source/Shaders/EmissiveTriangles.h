@@ -0,0 +1,97 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef EMISSIVE_TRIANGLES_H_
+#define EMISSIVE_TRIANGLES_H_
+
+#if defined( DESC_SET_VERTEX_DATA ) && defined( DESC_SET_TEXTURES )
+
+// emission is low-frequency, so a coarse mip is enough
+#define EMISSIVE_TRIANGLE_TEXTURE_LOD 2.0
+
+// Choose an emissive triangle proportionally to its power, using an alias table,
+// and a uniformly distributed point on it.
+// 'rnd' -- uniform random numbers: x to select a triangle, yz to select a point
+LightSample sampleEmissiveTriangle( const vec3 surfPosition, const vec3 rnd )
+{
+    const uint count = globalUniform.emissiveTriangleCount;
+
+    const float scaled = rnd.x * 0.99 * float( count );
+
+    ShEmissiveTriangle tri = g_emissiveTriangles[ min( uint( scaled ), count - 1 ) ];
+    if( fract( scaled ) >= tri.aliasProb )
+    {
+        tri = g_emissiveTriangles[ tri.aliasIndex ];
+    }
+
+    const vec3 p0 = vec3( tri.p0_x, tri.p0_y, tri.p0_z );
+    const vec3 p1 = vec3( tri.p1_x, tri.p1_y, tri.p1_z );
+    const vec3 p2 = vec3( tri.p2_x, tri.p2_y, tri.p2_z );
+
+    // same warping as in sampleTriangle, but barycentrics are needed for texture coordinates
+    const float u1    = rnd.y * 0.99;
+    const float u2    = rnd.z * 0.99;
+    const float beta  = 1 - sqrt( u1 );
+    const float gamma = ( 1 - beta ) * u2;
+    const float alpha = 1 - beta - gamma;
+
+    const vec3 position = alpha * p0 + beta * p1 + gamma * p2;
+    const vec2 texCoord = alpha * vec2( tri.u0, tri.v0 ) + //
+                          beta * vec2( tri.u1, tri.v1 ) +  //
+                          gamma * vec2( tri.u2, tri.v2 );
+
+    const vec3  cr   = cross( p1 - p0, p2 - p0 );
+    const float area = length( cr ) * 0.5;
+
+    const vec3  toLight = position - surfPosition;
+    const float distSq  = max( dot( toLight, toLight ), 0.0001 );
+    // emissive surfaces are two-sided
+    const float cosL =
+        abs( dot( cr, toLight ) ) * safePositiveRcp( 2 * area ) * inversesqrt( distSq );
+
+    if( cosL <= 0.0 || tri.selectPdf <= 0.0 )
+    {
+        return emptyLightSample();
+    }
+
+    const float lod = EMISSIVE_TRIANGLE_TEXTURE_LOD;
+
+    vec3 albedo = unpackLittleEndianUintColor( tri.colorFactor ).rgb;
+    if( tri.texture_base != MATERIAL_NO_TEXTURE )
+    {
+        albedo *= getTextureSampleLod( tri.texture_base, texCoord, lod ).rgb;
+    }
+
+    const vec3 emission = tri.texture_base_E != MATERIAL_NO_TEXTURE
+                              ? getTextureSampleLod( tri.texture_base_E, texCoord, lod ).rgb
+                              : albedo * tri.emissiveMult;
+
+    LightSample l;
+    l.position = position;
+    // same as the emission of indirect hits
+    l.color = emission * globalUniform.emissionMapBoost * albedo;
+    // area measure to solid angle
+    l.dw = area * cosL / ( tri.selectPdf * distSq );
+    return l;
+}
+
+#endif // DESC_SET_VERTEX_DATA && DESC_SET_TEXTURES
+
+#endif // EMISSIVE_TRIANGLES_H_
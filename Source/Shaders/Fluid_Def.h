@@ -30,6 +30,7 @@
         uint  activeRingLength;   \
         uint  generateRingBegin;  \
         uint  generateRingLength; \
+        mat4  viewProj;           \
     }
 
 #ifdef __cplusplus
@@ -46,6 +47,8 @@ struct ShParticleSourceDef
 {
     uint64_t position_dispersionAngle;
     uint64_t velocity_dispersion;
+    float    radiusScale;
+    uint32_t pad0;
 };
 
 #else
@@ -64,6 +67,8 @@ struct ShParticleSourceDef
     float16_t velocityDispersionAngle;
     f16vec3   velocity;
     float16_t velocityDispersion;
+    float     radiusScale;
+    uint      pad0;
 };
 
 #define PARTICLE_INVALID 0xFFFFFFFF
@@ -73,6 +78,13 @@ bool particle_isinvalid_unpacked( const ShParticleDef p )
     return isinf( p.position.x ) || isnan( p.position.x );
 }
 
+// In the particles array, pad0 contains a visual radius multiplier
+// that was set by a source, as far sources spawn fewer but larger particles
+float particle_radiusScale( const ShParticleDef p )
+{
+    return uintBitsToFloat( p.pad0 );
+}
+
 const float TargetDensity   = 630;
 
 #if FLUID_DEF_SPEC_CONST
@@ -80,6 +92,15 @@ const float TargetDensity   = 630;
 layout( constant_id = 0 ) const uint g_maxParticleCount = 0;
 layout( constant_id = 1 ) const float SmoothingRadius = 0.1;
 
+bool particle_isoutofview( const mat4 viewProj, const vec3 position )
+{
+    // with a margin, so neighbours of the visible particles are not culled
+    const float margin = SmoothingRadius * 4;
+
+    const vec4 clip = viewProj * vec4( position, 1.0 );
+    return clip.w < -margin || any( greaterThan( abs( clip.xy ), vec2( clip.w * 1.1 + margin ) ) );
+}
+
 #endif // FLUID_DEF_SPEC_CONST
 
 #endif // __cplusplus
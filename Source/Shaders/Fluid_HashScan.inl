@@ -0,0 +1,55 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Prefix sum over a block of FLUID_HASH_SCAN_BLOCK_SIZE values,
+// each invocation of a workgroup is responsible for 4 consecutive values
+
+#if FLUID_HASH_SCAN_BLOCK_SIZE != COMPUTE_FLUID_HASH_SCAN_GROUP_SIZE_X * 4
+    #error Block must be covered by a workgroup
+#endif
+
+shared uint s_scan[ COMPUTE_FLUID_HASH_SCAN_GROUP_SIZE_X ];
+
+// Must be called in uniform control flow
+uvec4 hash_blockExclusiveScan( const uvec4 values, out uint blockTotal )
+{
+    const uint t   = gl_LocalInvocationID.x;
+    const uint sum = values.x + values.y + values.z + values.w;
+
+    s_scan[ t ] = sum;
+    barrier();
+
+    // inclusive, Hillis-Steele
+    for( uint stride = 1; stride < COMPUTE_FLUID_HASH_SCAN_GROUP_SIZE_X; stride *= 2 )
+    {
+        const uint prev = t >= stride ? s_scan[ t - stride ] : 0;
+        barrier();
+        s_scan[ t ] += prev;
+        barrier();
+    }
+
+    const uint before = s_scan[ t ] - sum;
+    blockTotal        = s_scan[ COMPUTE_FLUID_HASH_SCAN_GROUP_SIZE_X - 1 ];
+
+    return before + uvec4( 0, //
+                           values.x,
+                           values.x + values.y,
+                           values.x + values.y + values.z );
+}
@@ -31,7 +31,7 @@ SOFTWARE.
 
 // Smoothed-particle hydrodynamics
 
-#define FLUID_SPH 0
+#define FLUID_SPH 1
 #if FLUID_SPH
 
 const FLT pressureMultiplier     = FLT( 2.88 );
@@ -129,45 +129,28 @@ FLT NearPressureFromDensity(FLT nearDensity)
 	return nearDensity * nearPressureMultiplier;
 }
 
-uint hashCombine( uint seed, uint v )
+const FLT ViscosityStrength = FLT( 0.005 );
+
+float particle_density( const ShParticleDef sorted )
 {
-    seed ^= v + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
-    return seed;
+    return uintBitsToFloat( sorted.pad0 );
 }
 
-#define foreach_neighbour_particle( cur_id )                                             \
-    for( uint rsample = 0; rsample < 8; rsample++ )                                      \
-    {                                                                                    \
-        /* NOTE: rnd01 is a float that must have precision 1/g_particleCount, */         \
-        /*       otherwise, need a better sampling based on particle position region; */ \
-        /*       at the moment, it's very bad 1/60000, and it would sample uniformly */  \
-        const float rnd01 = rnd16( hashCombine( gl_GlobalInvocationID.x, rsample ),      \
-                                   uint( push.deltaTime * 1000000 ) );                   \
-                                                                                         \
-        const uint other_globalId = uint( rnd01 * g_particleCount );                     \
-        if( other_globalId == cur_id )                                                   \
-        {                                                                                \
-            continue;                                                                    \
-        }                                                                                \
-        const ShParticleDef other = g_particlesArray[ other_globalId ];                  \
-        if( particle_isinvalid_unpacked( other ) )                                       \
-        {                                                                                \
-            continue;                                                                    \
-        }
-
-#define foreach_end }
+float particle_nearDensity( const ShParticleDef sorted )
+{
+    return uintBitsToFloat( sorted.pad1 );
+}
 
-void SPH_calcVelocityAndDensityFromOtherParticles( const uint cur_id,
-                                                   const FLT3 cur_position,
-                                                   inout FLT3 cur_velocity,
-                                                   out FLT    cur_density,
-                                                   out FLT    cur_nearDensity )
+// Fluid_SpatialHash.inl must be included
+void SPH_calcDensity( const uint cur_sortedId,
+                      const FLT3 cur_position,
+                      out FLT    cur_density,
+                      out FLT    cur_nearDensity )
 {
-    // Density
     cur_density     = DensityKernel( 0, SmoothingRadius );
     cur_nearDensity = NearDensityKernel( 0, SmoothingRadius );
 
-    foreach_neighbour_particle( cur_id ) // -> other
+    foreach_neighbour_particle( cur_sortedId, cur_position ) // -> other
     {
         const FLT3 offsetToNeighbour = other.position - cur_position;
         const FLT  dst               = length( offsetToNeighbour );
@@ -176,8 +159,16 @@ void SPH_calcVelocityAndDensityFromOtherParticles( const uint cur_id,
         cur_nearDensity += NearDensityKernel( dst, SmoothingRadius );
     }
     foreach_end;
+}
 
-
+// Must be called after Fluid_Density, so the sorted particles contain densities
+void SPH_calcVelocityFromOtherParticles( const uint cur_sortedId,
+                                         const FLT3 cur_position,
+                                         const FLT  cur_density,
+                                         const FLT  cur_nearDensity,
+                                         const FLT  deltaTime,
+                                         inout FLT3 cur_velocity )
+{
     // Pressure / Viscosity
     FLT3 pressureForce  = FLT3( 0 );
     FLT3 viscosityForce = FLT3( 0 );
@@ -185,25 +176,32 @@ void SPH_calcVelocityAndDensityFromOtherParticles( const uint cur_id,
         const FLT cur_pressure     = PressureFromDensity( cur_density );
         const FLT cur_nearPressure = NearPressureFromDensity( cur_nearDensity );
 
-        foreach_neighbour_particle( cur_id ) // -> other
+        foreach_neighbour_particle( cur_sortedId, cur_position ) // -> other
         {
+            const FLT other_density     = FLT( particle_density( other ) );
+            const FLT other_nearDensity = FLT( particle_nearDensity( other ) );
+
             const FLT sharedPressure =
-                ( cur_pressure + PressureFromDensity( FLT( other.density ) ) ) * FLT( 0.5 );
+                ( cur_pressure + PressureFromDensity( other_density ) ) * FLT( 0.5 );
 
             const FLT sharedNearPressure =
-                ( cur_nearPressure + NearPressureFromDensity( FLT( other.nearDensity ) ) ) *
-                FLT( 0.5 );
+                ( cur_nearPressure + NearPressureFromDensity( other_nearDensity ) ) * FLT( 0.5 );
 
             const FLT3 offsetToNeighbour = other.position - cur_position;
 
             const FLT  dst = length( offsetToNeighbour );
             const FLT3 dir = dst > FLT( 0 ) ? offsetToNeighbour / dst : FLT3( 0, 1, 0 );
 
-            pressureForce += dir * DensityDerivative( dst, SmoothingRadius ) * //
-                             sharedPressure / FLT( other.density );
-
-            pressureForce += dir * NearDensityDerivative( dst, SmoothingRadius ) *
-                             sharedNearPressure / FLT( other.nearDensity );
+            if( other_density > FLT( 0.00001 ) )
+            {
+                pressureForce += dir * DensityDerivative( dst, SmoothingRadius ) * //
+                                 sharedPressure / other_density;
+            }
+            if( other_nearDensity > FLT( 0.00001 ) )
+            {
+                pressureForce += dir * NearDensityDerivative( dst, SmoothingRadius ) *
+                                 sharedNearPressure / other_nearDensity;
+            }
 
             viscosityForce += ( other.velocity - cur_velocity ) * //
                               SmoothingKernelPoly6( dst, SmoothingRadius );
@@ -214,10 +212,7 @@ void SPH_calcVelocityAndDensityFromOtherParticles( const uint cur_id,
     FLT3 acceleration = cur_density > 0.00001 ? pressureForce / cur_density : FLT3( 0 );
     acceleration += viscosityForce * ViscosityStrength;
 
-    cur_velocity += acceleration * deltaTime();
+    cur_velocity += acceleration * deltaTime;
 }
 
-#undef foreach_end
-#undef foreach_neighbour_particle
-
 #endif // FLUID_SPH
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Spatial hash over the active particles: a grid with cell size of SmoothingRadius
+// is hashed into g_maxParticleCount buckets, and the particles are sorted by bucket,
+// so the neighbours of a particle are only in the 27 buckets around its cell.
+//
+// Built each frame by:
+//   Fluid_HashCount      -- bucket of each particle and its offset inside the bucket
+//   Fluid_HashScan       -- exclusive prefix sum of bucket sizes, per block
+//   Fluid_HashScanBlocks -- exclusive prefix sum of the blocks' totals
+//   Fluid_HashReorder    -- copy particles into bucket-sorted order
+
+#ifndef DESC_SET_FLUID
+    #error DESC_SET_FLUID must be defined
+#endif
+
+// Limits the work in degenerate cases, when too many particles are packed in one bucket
+#define FLUID_MAX_PARTICLES_PER_BUCKET 64
+
+layout( set = DESC_SET_FLUID, binding = BINDING_FLUID_CELL_COUNT ) buffer CellCount_T
+{
+    uint g_cellCount[];
+};
+
+layout( set = DESC_SET_FLUID, binding = BINDING_FLUID_CELL_START ) buffer CellStart_T
+{
+    uint g_cellStart[];
+};
+
+layout( set = DESC_SET_FLUID, binding = BINDING_FLUID_CELL_BLOCK_SUMS ) buffer CellBlockSums_T
+{
+    uint g_cellBlockSums[];
+};
+
+// For each active particle: bucket and offset inside the bucket
+layout( set = DESC_SET_FLUID, binding = BINDING_FLUID_PARTICLE_CELL ) buffer ParticleCell_T
+{
+    uvec2 g_particleCell[];
+};
+
+// Active particles in bucket-sorted order.
+// Once the density is calculated, pad0 / pad1 contain density / near density as float bits
+layout( set = DESC_SET_FLUID, binding = BINDING_FLUID_SORTED_PARTICLES ) buffer SortedParticles_T
+{
+    ShParticleDef g_sortedParticles[];
+};
+
+ivec3 hash_cellCoord( const vec3 position )
+{
+    return ivec3( floor( position / SmoothingRadius ) );
+}
+
+uint hash_bucket( const ivec3 cell )
+{
+    const uvec3 c = uvec3( cell );
+    return ( ( c.x * 73856093u ) ^ ( c.y * 19349663u ) ^ ( c.z * 83492791u ) ) %
+           g_maxParticleCount;
+}
+
+uint hash_bucketOf( const ShParticleDef p )
+{
+    // invalid particles are still sorted, but neighbour searches skip them
+    return particle_isinvalid_unpacked( p ) ? 0 : hash_bucket( hash_cellCoord( p.position ) );
+}
+
+// Valid after Fluid_HashScanBlocks
+uint hash_bucketStart( const uint bucket )
+{
+    return g_cellStart[ bucket ] + g_cellBlockSums[ bucket / FLUID_HASH_SCAN_BLOCK_SIZE ];
+}
+
+// Valid after Fluid_HashReorder
+uint hash_sortedIndex( const uint activeIndex )
+{
+    const uvec2 bucket_offset = g_particleCell[ activeIndex ];
+    return hash_bucketStart( bucket_offset.x ) + bucket_offset.y;
+}
+
+// Iterate over particles in the 27 cells around the position. Several cells
+// can map to the same bucket, such duplicates are visited only once
+#define foreach_neighbour_particle( cur_sortedId, cur_position )                           \
+    {                                                                                      \
+        const ivec3 _cell = hash_cellCoord( cur_position );                                \
+        uint        _visited[ 27 ];                                                        \
+        uint        _visitedCount = 0;                                                     \
+        for( int _c = 0; _c < 27; _c++ )                                                   \
+        {                                                                                  \
+            const ivec3 _offset = ivec3( _c % 3, ( _c / 3 ) % 3, _c / 9 ) - ivec3( 1 );    \
+            const uint  _bucket = hash_bucket( _cell + _offset );                          \
+            bool _duplicate = false;                                                       \
+            for( uint _v = 0; _v < _visitedCount; _v++ )                                   \
+            {                                                                              \
+                _duplicate = _duplicate || ( _visited[ _v ] == _bucket );                  \
+            }                                                                              \
+            if( _duplicate )                                                               \
+            {                                                                              \
+                continue;                                                                  \
+            }                                                                              \
+            _visited[ _visitedCount++ ] = _bucket;                                         \
+                                                                                           \
+            const uint _begin = hash_bucketStart( _bucket );                               \
+            const uint _end   = _begin + min( g_cellCount[ _bucket ],                      \
+                                            uint( FLUID_MAX_PARTICLES_PER_BUCKET ) );      \
+            for( uint other_sortedId = _begin; other_sortedId < _end; other_sortedId++ )   \
+            {                                                                              \
+                if( other_sortedId == ( cur_sortedId ) )                                   \
+                {                                                                          \
+                    continue;                                                              \
+                }                                                                          \
+                const ShParticleDef other = g_sortedParticles[ other_sortedId ];           \
+                if( particle_isinvalid_unpacked( other ) )                                 \
+                {                                                                          \
+                    continue;                                                              \
+                }
+
+#define foreach_end \
+            }       \
+        }           \
+    }
@@ -29,6 +29,7 @@
 
 layout( location = 0 ) in vec2 in_uv;
 layout( location = 1 ) in vec3 in_center;
+layout( location = 2 ) flat in float in_radius;
 
 layout( location = 0 ) out uint32_t out_normal;
 
@@ -75,7 +76,7 @@ void main()
         vec3 viewSpaceSphereCenter = ( push.view * vec4( in_center, 1 ) ).xyz;
 
         sphereImpostor( viewSpaceSphereCenter, //
-                        SmoothingRadius,
+                        in_radius,
                         viewSpacePos,
                         viewSpaceNormal );
     }
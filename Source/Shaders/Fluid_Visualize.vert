@@ -30,6 +30,7 @@
 
 layout( location = 0 ) out vec2 out_uv;
 layout( location = 1 ) out vec3 out_center;
+layout( location = 2 ) flat out float out_radius;
 
 #define DESC_SET_FLUID 0
 
@@ -65,12 +66,14 @@ void main()
     const uint          id       = gl_InstanceIndex % g_maxParticleCount;
     const ShParticleDef particle = g_particlesArray[ id ];
 
-    const vec3 q = getQuadCornerPosition();
+    const vec3  q      = getQuadCornerPosition();
+    const float radius = SmoothingRadius * particle_radiusScale( particle );
 
     vec3 quadVertex = vec3( particle.position );
-    quadVertex += transpose( mat3( push.view ) ) * q * SmoothingRadius * BoxCorrection;
+    quadVertex += transpose( mat3( push.view ) ) * q * radius * BoxCorrection;
 
     gl_Position = push.proj * push.view * vec4( quadVertex, 1.0 );
     out_uv      = q.xy * BoxCorrection;
     out_center  = vec3( particle.position );
+    out_radius  = radius;
 }
@@ -23,6 +23,7 @@ import sys
 import os
 import subprocess
 import pathlib
+import struct
 
 
 TARGET_FOLDER_PATH           = "../../Build/shaders/"
@@ -42,6 +43,43 @@ DEPENDENCY_IGNORE           = [ "BlueNoiseFileNames.h", "ShaderCommonC.h", "Shad
 CACHE_FILE_DEPENDENCY_MAP_SEPARATOR_LINE = "DEPENDENCY\n"
 
 
+# must match SHADERS_ARCHIVE_FILE and the layout in ShaderManager.cpp
+ARCHIVE_FILE_NAME           = "shaders.rgpack"
+ARCHIVE_MAGIC               = b"RGSP"
+ARCHIVE_VERSION             = 1
+ARCHIVE_FILENAME_SIZE       = 56
+
+
+def packArchive():
+    spvFiles = []
+    for f in sorted(os.listdir(TARGET_FOLDER_PATH)):
+        if not f.endswith(".spv"):
+            continue
+        if len(f.encode()) >= ARCHIVE_FILENAME_SIZE:
+            print("> File name \"" + f + "\" is too long for the archive. Skipping.")
+            continue
+        spvFiles.append(f)
+
+    headerSize = 16 + 64 * len(spvFiles)
+    index = b""
+    data = b""
+
+    for f in spvFiles:
+        with open(TARGET_FOLDER_PATH + f, "rb") as spv:
+            code = spv.read()
+        # SPIR-V is passed to the driver directly from the mapped file, keep it 4-byte aligned
+        data += b"\0" * (-len(data) % 4)
+        index += struct.pack("<56sII", f.encode(), headerSize + len(data), len(code))
+        data += code
+
+    with open(TARGET_FOLDER_PATH + ARCHIVE_FILE_NAME, "wb") as archive:
+        archive.write(struct.pack("<4sIII", ARCHIVE_MAGIC, ARCHIVE_VERSION, len(spvFiles), 0))
+        archive.write(index)
+        archive.write(data)
+
+    print("> Packed " + str(len(spvFiles)) + " shader(s) into " + ARCHIVE_FILE_NAME)
+
+
 MARKED_FILES = []
 def wereDependentModified(dependencyMap, modifiedDependent, cache, baseFile, firstTime=True):
     global MARKED_FILES
@@ -99,6 +137,7 @@ def main():
         print("-rebuild  : clear cache and rebuild all shaders")
         print("-gencomm  : invoke GenerateShaderCommon.py script")
         print("-psout    : use PowerShell for printing colored output")
+        print("-pack     : pack all .spv files into a single archive, loaded at startup")
         print("-r        : same as \"-rebuild\"")
         print("-g        : same as \"-gencomm\"")
         print("-ps       : same as \"-psout\"")
@@ -106,12 +145,15 @@ def main():
 
     forceRebuild = False
     powerShellOutput = False
+    pack = False
     if "-rebuild" in sys.argv or "--rebuild" in sys.argv or "-r" in sys.argv or "--r" in sys.argv:
         forceRebuild = True
     if "-gencomm" in sys.argv or "--gencomm" in sys.argv or "-g" in sys.argv or "--g" in sys.argv:
         subprocess.run(["python", "../Generated/GenerateShaderCommon.py", "--path", "../Generated/"])
     if "-psout" in sys.argv or "--psout" in sys.argv or "-ps" in sys.argv or "--ps" in sys.argv:
         powerShellOutput = True
+    if "-pack" in sys.argv or "--pack" in sys.argv:
+        pack = True
     #elif len(sys.argv) > 1:
     #    print("> Couldn't parse arguments")
     #    return
@@ -275,6 +317,9 @@ def main():
     #if wereDependentModified:
     #    print()
 
+    if pack and msgErrorCount == 0:
+        packArchive()
+
     msg = ""
     color = ""
 
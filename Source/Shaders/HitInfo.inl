@@ -87,6 +87,14 @@ vec3 processAlbedo(
 
         if( layerColorTextures[ i ] != MATERIAL_NO_TEXTURE )
         {
+    #if defined( TEXTURE_STREAMING_FEEDBACK_WRITEABLE )
+        #if defined( HITINFO_INL_PRIM )
+            requestTextureResolution( layerColorTextures[ i ], dPdx[ i ], dPdy[ i ] );
+        #elif defined( HITINFO_INL_RFL )
+            requestTextureResolution( layerColorTextures[ i ], derivSet.u[ i ] );
+        #endif
+    #endif
+
             const vec4 src = unpackUintColor( layerColors[ i ] ) *
     #if defined( HITINFO_INL_PRIM )
                 getTextureSampleGrad( layerColorTextures[ i ], texCoords[ i ], dPdx[ i ], dPdy[ i ] );
@@ -346,37 +354,37 @@ ShHitInfo getHitInfoBounce(
     const vec3 baryCoordsAX = intersectRayTriangle(tr.positions, rayOrigin, rayDirAX);
     const vec3 baryCoordsAY = intersectRayTriangle(tr.positions, rayOrigin, rayDirAY);
 
-    const vec4 viewSpacePosCur   = globalUniform.view     * vec4(h.hitPosition, 1.0);
-    const vec4 viewSpacePosPrev  = globalUniform.viewPrev * vec4(tr.prevPositions * baryCoords, 1.0);
-    const vec4 viewSpacePosAX    = globalUniform.view     * vec4(tr.positions     * baryCoordsAX, 1.0);
-    const vec4 viewSpacePosAY    = globalUniform.view     * vec4(tr.positions     * baryCoordsAY, 1.0);
+    const vec4 viewSpacePosCur   = globalUniform.viewsView    [g_viewIndex] * vec4(h.hitPosition, 1.0);
+    const vec4 viewSpacePosPrev  = globalUniform.viewsViewPrev[g_viewIndex] * vec4(tr.prevPositions * baryCoords, 1.0);
+    const vec4 viewSpacePosAX    = globalUniform.viewsView    [g_viewIndex] * vec4(tr.positions     * baryCoordsAX, 1.0);
+    const vec4 viewSpacePosAY    = globalUniform.viewsView    [g_viewIndex] * vec4(tr.positions     * baryCoordsAY, 1.0);
 
-    const vec4 clipSpacePosCur   = globalUniform.projection     * viewSpacePosCur;
-    const vec4 clipSpacePosPrev  = globalUniform.projectionPrev * viewSpacePosPrev;
+    const vec4 clipSpacePosCur   = globalUniform.viewsProjection    [g_viewIndex] * viewSpacePosCur;
+    const vec4 clipSpacePosPrev  = globalUniform.viewsProjectionPrev[g_viewIndex] * viewSpacePosPrev;
 
     const float clipSpaceDepth   = clipSpacePosCur[2];
-    const float clipSpaceDepthAX = dot(globalUniform.projection[2], viewSpacePosAX);
-    const float clipSpaceDepthAY = dot(globalUniform.projection[2], viewSpacePosAY);
+    const float clipSpaceDepthAX = dot(globalUniform.viewsProjection[g_viewIndex][2], viewSpacePosAX);
+    const float clipSpaceDepthAY = dot(globalUniform.viewsProjection[g_viewIndex][2], viewSpacePosAY);
 
     const vec3 ndcCur            = clipSpacePosCur.xyz  / clipSpacePosCur.w;
     const vec3 ndcPrev           = clipSpacePosPrev.xyz / clipSpacePosPrev.w;
 
-    const vec2 screenSpaceCur    = ndcCur.xy  * 0.5 + 0.5;
-    const vec2 screenSpacePrev   = ndcPrev.xy * 0.5 + 0.5;
+    const vec2 screenSpaceCur    = fromViewUV(ndcCur.xy  * 0.5 + 0.5, g_viewIndex);
+    const vec2 screenSpacePrev   = fromViewUV(ndcPrev.xy * 0.5 + 0.5, g_viewIndex);
 #endif // HITINFO_INL_PRIM
 
 #if defined(HITINFO_INL_RFL) 
     rayLen = length(h.hitPosition - rayOrigin);
     virtualPosForMotion += viewDir * rayLen;
 
-    const vec4 viewSpacePosCur   = globalUniform.view     * vec4(virtualPosForMotion, 1.0);
-    const vec4 viewSpacePosPrev  = globalUniform.viewPrev * vec4(virtualPosForMotion, 1.0);
-    const vec4 clipSpacePosCur   = globalUniform.projection     * viewSpacePosCur;
-    const vec4 clipSpacePosPrev  = globalUniform.projectionPrev * viewSpacePosPrev;
+    const vec4 viewSpacePosCur   = globalUniform.viewsView    [g_viewIndex] * vec4(virtualPosForMotion, 1.0);
+    const vec4 viewSpacePosPrev  = globalUniform.viewsViewPrev[g_viewIndex] * vec4(virtualPosForMotion, 1.0);
+    const vec4 clipSpacePosCur   = globalUniform.viewsProjection    [g_viewIndex] * viewSpacePosCur;
+    const vec4 clipSpacePosPrev  = globalUniform.viewsProjectionPrev[g_viewIndex] * viewSpacePosPrev;
     const vec3 ndcCur            = clipSpacePosCur.xyz  / clipSpacePosCur.w;
     const vec3 ndcPrev           = clipSpacePosPrev.xyz / clipSpacePosPrev.w;
-    const vec2 screenSpaceCur    = ndcCur.xy  * 0.5 + 0.5;
-    const vec2 screenSpacePrev   = ndcPrev.xy * 0.5 + 0.5;
+    const vec2 screenSpaceCur    = fromViewUV(ndcCur.xy  * 0.5 + 0.5, g_viewIndex);
+    const vec2 screenSpacePrev   = fromViewUV(ndcPrev.xy * 0.5 + 0.5, g_viewIndex);
 
     const float clipSpaceDepth   = clipSpacePosCur[2];
 #endif // HITINFO_INL_RFL
@@ -435,6 +443,21 @@ ShHitInfo getHitInfoBounce(
     const DerivativeSet derivSet = getTriangleUVDerivativesFromRayCone(tr, h.normal, rayCone, rayDir);
 #endif
 
+#if defined( TEXTURE_STREAMING_FEEDBACK_WRITEABLE )
+    // albedo layers are requested in processAlbedo
+    #if defined( HITINFO_INL_PRIM )
+    requestTextureResolution( tr.occlusionRougnessMetallicTexture, dTdx[ 0 ], dTdy[ 0 ] );
+    requestTextureResolution( tr.normalTexture, dTdx[ 0 ], dTdy[ 0 ] );
+    requestTextureResolution( tr.emissiveTexture, dTdx[ 0 ], dTdy[ 0 ] );
+    requestTextureResolution( tr.heightTexture, dTdx[ 0 ], dTdy[ 0 ] );
+    #elif defined( HITINFO_INL_RFL )
+    requestTextureResolution( tr.occlusionRougnessMetallicTexture, derivSet.u[ 0 ] );
+    requestTextureResolution( tr.normalTexture, derivSet.u[ 0 ] );
+    requestTextureResolution( tr.emissiveTexture, derivSet.u[ 0 ] );
+    requestTextureResolution( tr.heightTexture, derivSet.u[ 0 ] );
+    #endif
+#endif
+
 
 
     // HEIGHT / NORMAL MAP (ignored for indirect)
@@ -0,0 +1,180 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef IRRADIANCE_CACHE_H_
+#define IRRADIANCE_CACHE_H_
+
+#if !defined( DESC_SET_GLOBAL_UNIFORM ) || !defined( DESC_SET_RESTIR_INDIRECT )
+    #error "Irradiance cache requires global uniform and restir indirect descriptor sets"
+#endif
+
+// World-space hashed grid of incoming diffuse radiance (i.e. not multiplied by albedo).
+// Cells grow with the distance to the camera, and are split by 6 dominant normal directions.
+// Cells are allocated on the first write, and evicted by CmIrradianceCacheResolve.comp,
+// if they were not used for IRRADIANCE_CACHE_MAX_AGE frames.
+
+// fixed point for the atomic accumulation
+#define IRC_ACCUM_SCALE 16.0
+#define IRC_ACCUM_MAX   10000.0
+// bounds the sums in a frame, so they don't overflow
+#define IRC_ACCUM_MAX_COUNT 1024
+// the finest cell size is used up to this amount of cells from the camera
+#define IRC_LOD_CELL_COUNT 16.0
+#define IRC_LOD_MAX 15
+
+
+bool irc_IsEnabled()
+{
+    return globalUniform.irradianceCacheEnable != 0;
+}
+
+uint irc_GetLevel( const vec3 position )
+{
+    const float dist = length( position - globalUniform.cameraPosition.xyz );
+    const float rel  = dist / ( IRC_LOD_CELL_COUNT * globalUniform.irradianceCacheCellSize );
+
+    return uint( clamp( floor( log2( max( rel, 1.0 ) ) ), 0, IRC_LOD_MAX ) );
+}
+
+float irc_GetCellSize( const vec3 position )
+{
+    return globalUniform.irradianceCacheCellSize * exp2( float( irc_GetLevel( position ) ) );
+}
+
+uint irc_GetNormalDirection( const vec3 n )
+{
+    const vec3 a = abs( n );
+    if( a.x >= a.y && a.x >= a.z )
+    {
+        return n.x >= 0 ? 0 : 1;
+    }
+    if( a.y >= a.z )
+    {
+        return n.y >= 0 ? 2 : 3;
+    }
+    return n.z >= 0 ? 4 : 5;
+}
+
+// lowbias32
+uint irc_Hash( uint x )
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+uint irc_HashCell( const ivec3 q, uint levelAndDir, uint seed )
+{
+    uint h = irc_Hash( seed ^ uint( q.x ) );
+    h      = irc_Hash( h ^ uint( q.y ) );
+    h      = irc_Hash( h ^ uint( q.z ) );
+    return irc_Hash( h ^ levelAndDir );
+}
+
+// x: first slot to probe, y: non-zero checksum to identify the cell
+uvec2 irc_MakeKey( const vec3 position, const vec3 normal )
+{
+    const uint  level = irc_GetLevel( position );
+    const float size  = globalUniform.irradianceCacheCellSize * exp2( float( level ) );
+
+    const ivec3 q           = ivec3( floor( position / size ) );
+    const uint  levelAndDir = level | ( irc_GetNormalDirection( normal ) << 4 );
+
+    return uvec2( irc_HashCell( q, levelAndDir, 0 ) % IRRADIANCE_CACHE_CELL_COUNT,
+                  max( irc_HashCell( q, levelAndDir, 0x9e3779b9u ), 1u ) );
+}
+
+uint irc_GetSlot( const uvec2 key, uint probe )
+{
+    return ( key.x + probe ) % IRRADIANCE_CACHE_CELL_COUNT;
+}
+
+// Returns false, if there's no cell, or it doesn't have enough samples yet
+bool irc_Find( const vec3 position, const vec3 normal, out vec3 radiance )
+{
+    radiance = vec3( 0 );
+
+    const uvec2 key = irc_MakeKey( position, normal );
+
+    for( uint i = 0; i < IRRADIANCE_CACHE_PROBE_COUNT; i++ )
+    {
+        const uint slot     = irc_GetSlot( key, i );
+        const uint checksum = g_irradianceCache[ slot ].checksum;
+
+        if( checksum == key.y )
+        {
+            if( g_irradianceCache[ slot ].sampleCount < IRRADIANCE_CACHE_MIN_SAMPLES )
+            {
+                return false;
+            }
+
+            g_irradianceCache[ slot ].lastUsedFrame = globalUniform.frameId;
+            radiance = decodeE5B9G9R9( g_irradianceCache[ slot ].radianceE5 );
+            return true;
+        }
+
+        if( checksum == 0 )
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+// Values are averaged and blended into the cell by CmIrradianceCacheResolve.comp
+void irc_Accumulate( const vec3 position, const vec3 normal, const vec3 radiance )
+{
+    if( any( isnan( radiance ) ) || any( isinf( radiance ) ) )
+    {
+        return;
+    }
+
+    const uvec2 key = irc_MakeKey( position, normal );
+
+    for( uint i = 0; i < IRRADIANCE_CACHE_PROBE_COUNT; i++ )
+    {
+        const uint slot = irc_GetSlot( key, i );
+        const uint prev = atomicCompSwap( g_irradianceCache[ slot ].checksum, 0u, key.y );
+
+        if( prev == 0 || prev == key.y )
+        {
+            if( atomicAdd( g_irradianceCache[ slot ].accumCount, 1u ) >= IRC_ACCUM_MAX_COUNT )
+            {
+                return;
+            }
+
+            const uvec3 v = uvec3( clamp( radiance, vec3( 0 ), vec3( IRC_ACCUM_MAX ) ) *
+                                       IRC_ACCUM_SCALE +
+                                   0.5 );
+
+            atomicAdd( g_irradianceCache[ slot ].accumR, v.r );
+            atomicAdd( g_irradianceCache[ slot ].accumG, v.g );
+            atomicAdd( g_irradianceCache[ slot ].accumB, v.b );
+            return;
+        }
+    }
+    // all probed slots are occupied by other cells
+}
+
+#endif // IRRADIANCE_CACHE_H_
@@ -55,10 +55,25 @@ struct SpotLight
     float cosAngleOuter;
 };
 
+uint getLightType( const ShLightEncoded encoded )
+{
+    return encoded.lightType & LIGHT_TYPE_MASK;
+}
+
+float getLightstyleMult( const ShLightEncoded encoded )
+{
+    const uint lightstyle = encoded.lightType >> LIGHT_TYPE_LIGHTSTYLE_SHIFT;
+#ifdef DESC_SET_LIGHT_SOURCES
+    return lightstyle != 0 ? lightstyleValues[ lightstyle - 1 ] : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
 DirectionalLight decodeAsDirectionalLight(const ShLightEncoded encoded)
 {
     DirectionalLight l;
-    l.color         = decodeE5B9G9R9( encoded.colorE5 );
+    l.color         = decodeE5B9G9R9( encoded.colorE5 ) * getLightstyleMult( encoded );
     l.direction     = vec3( encoded.ldata0, encoded.ldata1, encoded.ldata2 );
     l.angularRadius = encoded.ldata3;
 
@@ -68,7 +83,7 @@ DirectionalLight decodeAsDirectionalLight(const ShLightEncoded encoded)
 SphereLight decodeAsSphereLight(const ShLightEncoded encoded)
 {
     SphereLight l;
-    l.color  = decodeE5B9G9R9( encoded.colorE5 );
+    l.color  = decodeE5B9G9R9( encoded.colorE5 ) * getLightstyleMult( encoded );
     l.center = vec3( encoded.ldata0, encoded.ldata1, encoded.ldata2 );
     {
         const vec2 rn = unpackHalf2x16( floatBitsToUint( encoded.ldata3 ) );
@@ -108,7 +123,7 @@ TriangleLight decodeAsTriangleLight(const ShLightEncoded encoded)
 SpotLight decodeAsSpotLight(const ShLightEncoded encoded)
 {
     SpotLight l;
-    l.color  = decodeE5B9G9R9( encoded.colorE5 );
+    l.color  = decodeE5B9G9R9( encoded.colorE5 ) * getLightstyleMult( encoded );
     l.radius = 0.05; // HARDCODED
     {
         vec4 p0 = vec4( unpackHalf2x16( floatBitsToUint( encoded.ldata0 ) ),
@@ -313,7 +328,7 @@ LightSample sampleSpotLight(const SpotLight l, const vec3 surfPosition, const ve
 
 float getLightWeight(const ShLightEncoded encoded, const vec3 cellCenter, float cellRadius)
 {
-    switch (encoded.lightType)
+    switch (getLightType(encoded))
     {
         case LIGHT_TYPE_DIRECTIONAL:    return getDirectionalLightWeight(decodeAsDirectionalLight   (encoded), cellCenter, cellRadius);
         case LIGHT_TYPE_SPHERE:         return getSphereLightWeight     (decodeAsSphereLight        (encoded), cellCenter, cellRadius);
@@ -327,7 +342,7 @@ float getLightWeight(const ShLightEncoded encoded, const vec3 cellCenter, float
 
 LightSample sampleLight(const ShLightEncoded encoded, const vec3 surfPosition, const vec2 pointRnd)
 {
-    switch (encoded.lightType)
+    switch (getLightType(encoded))
     {
         case LIGHT_TYPE_DIRECTIONAL:    return sampleDirectionalLight   (decodeAsDirectionalLight   (encoded), surfPosition, pointRnd);
         case LIGHT_TYPE_SPHERE:         return sampleSphereLight        (decodeAsSphereLight        (encoded), surfPosition, pointRnd);
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef LIGHT_TREE_H_
+#define LIGHT_TREE_H_
+
+#ifdef DESC_SET_LIGHT_SOURCES
+
+// Upper bound of a node's contribution to a surface point
+float lightTreeNodeImportance(const ShLightTreeNode node, const vec3 surfPosition, const vec3 surfNormal)
+{
+    const vec3  bbMin  = vec3(node.bbMin_x, node.bbMin_y, node.bbMin_z);
+    const vec3  bbMax  = vec3(node.bbMax_x, node.bbMax_y, node.bbMax_z);
+    const vec3  center = (bbMin + bbMax) * 0.5;
+    const float radius = length(bbMax - bbMin) * 0.5;
+
+    const vec3  toCenter = center - surfPosition;
+    const float distSq   = dot(toCenter, toCenter);
+
+    // inside the bounds, any direction is possible
+    if (distSq <= radius * radius)
+    {
+        return node.energy * safePositiveRcp(radius * radius);
+    }
+
+    const float dist = sqrt(distSq);
+    const vec3  dir  = toCenter / dist;
+
+    // angular radius of the bounds
+    const float thetaU = asin(clamp(radius / dist, 0.0, 1.0));
+
+    const float thetaN = acos(clamp(dot(surfNormal, dir), -1.0, 1.0));
+    if (thetaN - thetaU >= M_PI * 0.5)
+    {
+        return 0.0;
+    }
+
+    const vec3  axis   = vec3(node.coneAxis_x, node.coneAxis_y, node.coneAxis_z);
+    const float thetaA = acos(clamp(dot(axis, -dir), -1.0, 1.0));
+    const float thetaO = acos(clamp(node.coneCosTheta, -1.0, 1.0));
+    if (thetaA - thetaO - thetaU > 0.0)
+    {
+        return 0.0;
+    }
+
+    return node.energy * cos(max(thetaN - thetaU, 0.0)) / distSq;
+}
+
+// Returns light index, or LIGHT_INDEX_NONE, if no light can contribute
+uint sampleLightTree(const vec3 surfPosition, const vec3 surfNormal, float rnd, out float pdf)
+{
+    uint node = 0;
+    pdf = 1.0;
+
+    for (int depth = 0; depth < LIGHT_TREE_MAX_DEPTH; depth++)
+    {
+        const uint childOrLight = lightTree[node].childOrLight;
+
+        if ((childOrLight & LIGHT_TREE_NODE_LEAF_BIT) != 0)
+        {
+            return childOrLight & ~LIGHT_TREE_NODE_LEAF_BIT;
+        }
+
+        const float l = lightTreeNodeImportance(lightTree[childOrLight], surfPosition, surfNormal);
+        const float r = lightTreeNodeImportance(lightTree[childOrLight + 1], surfPosition, surfNormal);
+
+        if (l + r <= 0.0)
+        {
+            break;
+        }
+
+        // reuse the random number to choose on the next level
+        const float pLeft = l / (l + r);
+        if (rnd < pLeft)
+        {
+            node = childOrLight;
+            rnd  = rnd / pLeft;
+            pdf *= pLeft;
+        }
+        else
+        {
+            node = childOrLight + 1;
+            rnd  = (rnd - pLeft) / (1.0 - pLeft);
+            pdf *= 1.0 - pLeft;
+        }
+        rnd = min(rnd, 0.99999);
+    }
+
+    pdf = 0.0;
+    return LIGHT_INDEX_NONE;
+}
+
+#endif // DESC_SET_LIGHT_SOURCES
+
+#endif // LIGHT_TREE_H_
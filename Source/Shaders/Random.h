@@ -24,7 +24,12 @@
 #define RANDOM_SALT_DIFF_BOUNCE(bounceIndex) (8 + (bounceIndex))
 #define RANDOM_SALT_SPEC_BOUNCE(bounceIndex) (12 + (bounceIndex))
 #define RANDOM_SALT_POSTEFFECT 16
+#define RANDOM_SALT_EMISSIVE_TRIANGLE_CHOOSE 17
+#define RANDOM_SALT_EMISSIVE_TRIANGLE_POINT 18
+#define RANDOM_SALT_ADAPTIVE_SAMPLING 19
 #define RANDOM_SALT_LIGHT_POINT 20
+#define RANDOM_SALT_IRRADIANCE_CACHE 21
+#define RANDOM_SALT_SUN_SHADOW_CACHE 22
 #define RANDOM_SALT_LIGHT_GRID_BASE 24
 #define RANDOM_SALT_INITIAL_RESERVOIRS_BASE 48
 #define RANDOM_SALT_LIGHT_CHOOSE_DIRECT_BASE 72
@@ -207,9 +212,17 @@ uint packRandomSeed(uint textureIndex, uvec2 offset)
         offset.x;
 }
 
+#if (BLUE_NOISE_TEXTURE_COUNT & (BLUE_NOISE_TEXTURE_COUNT - 1)) != 0
+    #error BLUE_NOISE_TEXTURE_COUNT must be a power of 2
+#endif
+
+// Bits above the texture index, used by the non-white sample sequences
+// to decorrelate the repeating blue noise tiles
+#define RANDOM_SEED_TILE_SHIFT (BLUE_NOISE_TEXTURE_SIZE_POW * 2 + 7)
+
 void unpackRandomSeed(uint seed, out uint textureIndex, out uvec2 offset)
 {
-    textureIndex = seed >> (BLUE_NOISE_TEXTURE_SIZE_POW * 2);
+    textureIndex = (seed >> (BLUE_NOISE_TEXTURE_SIZE_POW * 2)) & (BLUE_NOISE_TEXTURE_COUNT - 1);
     offset.y     = (seed >> BLUE_NOISE_TEXTURE_SIZE_POW) & (BLUE_NOISE_TEXTURE_SIZE - 1);
     offset.x     = seed                                  & (BLUE_NOISE_TEXTURE_SIZE - 1);
 }
@@ -288,6 +301,21 @@ uvec3 murmurHash33(uvec3 src) {
 
 uint getRandomSeed(const ivec2 pix, uint frameIndex)
 {
+#ifdef DESC_SET_GLOBAL_UNIFORM
+    if (globalUniform.sampleSequence != SAMPLE_SEQUENCE_WHITE_NOISE)
+    {
+        // coherent: the neighbor pixels and the consequent frames
+        // must read the neighbor texels and layers of the blue noise
+        const uint  cycle = frameIndex / BLUE_NOISE_TEXTURE_COUNT;
+        const uvec3 hash  = murmurHash33(uvec3(uvec2(pix) / BLUE_NOISE_TEXTURE_SIZE, cycle));
+
+        const uvec2 offset   = (uvec2(pix) + hash.xy) % BLUE_NOISE_TEXTURE_SIZE;
+        const uint  texIndex = frameIndex % BLUE_NOISE_TEXTURE_COUNT;
+
+        return packRandomSeed(texIndex, offset) | (hash.z << RANDOM_SEED_TILE_SHIFT);
+    }
+#endif
+
     uvec3 hash = murmurHash33(uvec3(pix.x, pix.y, frameIndex));
 
     uvec2 offset = uvec2(
@@ -299,4 +327,94 @@ uint getRandomSeed(const ivec2 pix, uint frameIndex)
     return packRandomSeed(texIndex, offset);
 }
 
+
+
+// Second dimension of the Sobol sequence, the first one is bitfieldReverse(i).
+// "Efficient Multidimensional Sampling", Kollig, Keller
+uint sobol2(uint i)
+{
+    uint r = 0;
+    for (uint v = 1u << 31; i != 0; i >>= 1, v ^= v >> 1)
+    {
+        if ((i & 1) != 0)
+        {
+            r ^= v;
+        }
+    }
+    return r;
+}
+
+// "Practical Hash-based Owen Scrambling", Burley
+uint laineKarrasPermutation(uint x, uint seed)
+{
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+uint nestedUniformScramble(uint x, uint seed)
+{
+    x = bitfieldReverse(x);
+    x = laineKarrasPermutation(x, seed);
+    x = bitfieldReverse(x);
+    return x;
+}
+
+// Owen-scrambled and shuffled 2D Sobol point in [0..1)
+vec2 sobolOwen2(uint index, uint seed)
+{
+    index = nestedUniformScramble(index, seed);
+
+    uint x = nestedUniformScramble(bitfieldReverse(index), wellonsLowBias32(seed ^ 0xa511e9b3u));
+    uint y = nestedUniformScramble(sobol2(index), wellonsLowBias32(seed ^ 0x63d83595u));
+
+    return vec2(x >> 8, y >> 8) / float(1 << 24);
+}
+
+// Sample sequence for the stochastic passes, selected by globalUniform.sampleSequence.
+// 'seed' must be from getRandomSeed; 'dimension' is one of RANDOM_SALT_*,
+// it decorrelates the passes and the bounces from each other.
+// Higher dimensions of Sobol are padded from 2D Owen-scrambled ones.
+vec2 rndSample2(uint seed, uint dimension)
+{
+#ifdef DESC_SET_GLOBAL_UNIFORM
+    #ifdef DESC_SET_RANDOM
+    if (globalUniform.sampleSequence == SAMPLE_SEQUENCE_BLUE_NOISE)
+    {
+        uint  texIndex;
+        uvec2 offset;
+        unpackRandomSeed(seed, texIndex, offset);
+
+        // toroidal shift by R2 sequence: each dimension stays blue in space and over frames
+        const uvec2 shift = uvec2(fract(vec2(0.7548776662, 0.5698402910) * float(dimension + 1)) *
+                                  BLUE_NOISE_TEXTURE_SIZE);
+        offset = (offset + shift) % BLUE_NOISE_TEXTURE_SIZE;
+
+        const vec2 bn = texelFetch(blueNoiseTextures, ivec3(offset, texIndex), 0).xy;
+        // dither inside of 1/256, so the result is in [0..1) with a finer precision
+        return (bn * 255.0 + rnd16_2(seed, dimension)) / 256.0;
+    }
+    #endif // DESC_SET_RANDOM
+    if (globalUniform.sampleSequence == SAMPLE_SEQUENCE_SOBOL)
+    {
+        uint  index;
+        uvec2 offset;
+        unpackRandomSeed(seed, index, offset);
+
+        // index by frame, scramble by pixel and dimension
+        const uint pixelBits = seed & ~packRandomSeed(BLUE_NOISE_TEXTURE_COUNT - 1, uvec2(0));
+        return sobolOwen2(index, wellonsLowBias32(pixelBits ^ (dimension * 0x9e3779b9u)));
+    }
+#endif // DESC_SET_GLOBAL_UNIFORM
+    return rnd16_2(seed, dimension);
+}
+
+float rndSample(uint seed, uint dimension)
+{
+    return rndSample2(seed, dimension).x;
+}
+
 #endif // RANDOM_H_
\ No newline at end of file
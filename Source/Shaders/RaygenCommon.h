@@ -21,8 +21,18 @@
 #ifndef RAYGEN_COMMON_H_
 #define RAYGEN_COMMON_H_
 
+#ifdef RAYGEN_RAY_QUERY
+// traversal is done inline, e.g. from a compute shader
+#extension GL_EXT_ray_query : require
+#else
 #extension GL_EXT_ray_tracing : require
+#endif
 #extension GL_EXT_control_flow_attributes : require
+#ifdef SHADER_INVOCATION_REORDER
+#extension GL_NV_shader_invocation_reorder : require
+// the lower the count, the cheaper the sorting
+#define SER_COHERENCE_HINT_BITS 8
+#endif
 
 
 
@@ -53,13 +63,18 @@
 
 #include "Surface.inl"
 #include "Light.h"
+#include "EmissiveTriangles.h"
 #include "LightGrid.h"
+#include "LightTree.h"
 #include "Media.h"
 #include "RayCone.h"
 
 #define GET_TARGET_PDF targetPdfForLightSample
 #include "Reservoir.h"
 
+// View of the current pixel, for the motion vectors with multiple views
+int g_viewIndex = 0;
+
 #define HITINFO_INL_PRIM
     #include "HitInfo.inl"
 #undef HITINFO_INL_PRIM
@@ -92,7 +107,14 @@ layout(set = DESC_SET_PORTALS, binding = BINDING_PORTAL_INSTANCES) uniform reado
 #endif
 
 
+#ifdef RAYGEN_RAY_QUERY
+ShPayload g_payload;
+#if LIGHT_SAMPLE_METHOD != LIGHT_SAMPLE_METHOD_NONE
+    #error Shadow rays are not implemented with RAYGEN_RAY_QUERY
+#endif
+#else
 layout(location = PAYLOAD_INDEX_DEFAULT) rayPayloadEXT ShPayload g_payload;
+#endif
 
 #if LIGHT_SAMPLE_METHOD != LIGHT_SAMPLE_METHOD_NONE
 layout(location = PAYLOAD_INDEX_SHADOW) rayPayloadEXT ShPayloadShadow g_payloadShadow;
@@ -100,6 +122,71 @@ layout(location = PAYLOAD_INDEX_SHADOW) rayPayloadEXT ShPayloadShadow g_payloadS
 
 
 
+#if RAY_COST_STATS_ENABLED && defined( DESC_SET_FRAMEBUFFERS )
+// Pixel to accumulate the cost of traced rays to. Passes that don't set it are not counted
+ivec2 g_rayCostPix = ivec2( -1 );
+
+bool isRayCostEnabled()
+{
+    const uint flags = DEBUG_SHOW_FLAG_RAY_COST | DEBUG_SHOW_FLAG_ANY_HIT |
+                       DEBUG_SHOW_FLAG_TRANSLUCENT_OVERDRAW;
+    return ( globalUniform.debugShowFlags & flags ) != 0;
+}
+
+// Must be called by the first pass that writes to the pixel
+void rayCostReset( const ivec2 pix )
+{
+    g_rayCostPix = pix;
+    if( isRayCostEnabled() )
+    {
+        imageStore( framebufRayCost, pix, uvec4( 0 ) );
+    }
+}
+
+void rayCostSetPix( const ivec2 pix )
+{
+    g_rayCostPix = pix;
+}
+
+void rayCostBeginTrace()
+{
+#ifndef RAYGEN_RAY_QUERY
+    // RtAlphaTest.rahit doesn't know the pixel, so it counts by a launch ID
+    if( isRayCostEnabled() && g_rayCostPix.x >= 0 )
+    {
+        imageStore( framebufRayCostAnyHit, ivec2( gl_LaunchIDEXT.xy ), uvec4( 0 ) );
+    }
+#endif
+}
+
+// 'rayQueryAnyHits' is used only with RAYGEN_RAY_QUERY, as it's counted inline
+void rayCostEndTrace( uint rayQueryAnyHits, uint translucentLayers )
+{
+    if( !isRayCostEnabled() || g_rayCostPix.x < 0 )
+    {
+        return;
+    }
+
+#ifdef RAYGEN_RAY_QUERY
+    const uint anyHits = rayQueryAnyHits;
+#else
+    const uint anyHits = imageLoad( framebufRayCostAnyHit, ivec2( gl_LaunchIDEXT.xy ) ).r;
+#endif
+
+    const uvec3 c = unpackRayCost( imageLoad( framebufRayCost, g_rayCostPix ).r );
+    imageStore( framebufRayCost,
+                g_rayCostPix,
+                uvec4( packRayCost( c + uvec3( 1, anyHits, translucentLayers ) ) ) );
+}
+#else
+void rayCostReset( const ivec2 pix ) {}
+void rayCostSetPix( const ivec2 pix ) {}
+void rayCostBeginTrace() {}
+void rayCostEndTrace( uint rayQueryAnyHits, uint translucentLayers ) {}
+#endif
+
+
+
 uint getPrimaryVisibilityCullMask()
 {
     return globalUniform.rayCullMaskWorld | INSTANCE_MASK_REFRACT | INSTANCE_MASK_FIRST_PERSON;
@@ -214,38 +301,132 @@ void resetPayload()
     g_payload.geomAndPrimIndex = UINT32_MAX;
 }
 
-ShPayload tracePrimaryRay(vec3 origin, vec3 direction)
+// Trace a ray into g_payload. With shader invocation reordering, the invocations
+// are grouped by the material of the hit geometry before the closest hit, so the
+// shading that follows in the raygen shader is less divergent
+void traceDefaultRay(uint cullMask, vec3 origin, float tMin, vec3 direction, float tMax, uint translucentLayers)
 {
-    resetPayload();
+    rayCostBeginTrace();
+    uint rayQueryAnyHits = 0;
 
-    uint cullMask = getPrimaryVisibilityCullMask();
+#if defined(RAYGEN_RAY_QUERY)
+    rayQueryEXT rayQuery;
+    rayQueryInitializeEXT(
+        rayQuery,
+        topLevelAS,
+        getAdditionalRayFlags(),
+        cullMask,
+        origin, tMin, direction, tMax);
+
+    while (rayQueryProceedEXT(rayQuery))
+    {
+        // only non-opaque geometry generates candidates: same as RtAlphaTest.rahit
+        if (rayQueryGetIntersectionTypeEXT(rayQuery, false) != gl_RayQueryCandidateIntersectionTriangleEXT)
+        {
+            continue;
+        }
+        rayQueryAnyHits++;
+
+        const vec2 bary = rayQueryGetIntersectionBarycentricsEXT(rayQuery, false);
+        const ShTriangle tr = getTriangle(
+            getGeometryInstanceIndex(rayQueryGetIntersectionInstanceIdEXT(rayQuery, false),
+                                     rayQueryGetIntersectionGeometryIndexEXT(rayQuery, false)),
+            rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, false),
+            rayQueryGetIntersectionGeometryIndexEXT(rayQuery, false),
+            rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, false));
+
+        const vec2 texCoord = tr.layerTexCoord[0] * vec3(1.0 - bary.x - bary.y, bary.x, bary.y);
+        const vec4 color =
+            getTextureSampleLod(tr.layerColorTextures[0], texCoord, 0.0) *
+            unpackUintColor(tr.layerColors[0]);
+
+        if ((color.r + color.g + color.b) / 3 * color.a + color.a >= 0.5)
+        {
+            rayQueryConfirmIntersectionEXT(rayQuery);
+        }
+    }
 
+    // same as RtClsOpaque.rchit; on miss, the payload stays reset
+    if (rayQueryGetIntersectionTypeEXT(rayQuery, true) == gl_RayQueryCommittedIntersectionTriangleEXT)
+    {
+        g_payload.baryCoords = rayQueryGetIntersectionBarycentricsEXT(rayQuery, true);
+        g_payload.instIdAndIndex = packInstanceIdAndCustomIndex(
+            getGeometryInstanceIndex(rayQueryGetIntersectionInstanceIdEXT(rayQuery, true),
+                                     rayQueryGetIntersectionGeometryIndexEXT(rayQuery, true)),
+            rayQueryGetIntersectionInstanceCustomIndexEXT(rayQuery, true));
+        g_payload.geomAndPrimIndex = packGeometryAndPrimitiveIndex(
+            rayQueryGetIntersectionGeometryIndexEXT(rayQuery, true),
+            rayQueryGetIntersectionPrimitiveIndexEXT(rayQuery, true));
+    }
+#elif defined(SHADER_INVOCATION_REORDER)
+    hitObjectNV hitObject;
+    hitObjectTraceRayNV(
+        hitObject,
+        topLevelAS,
+        getAdditionalRayFlags(), 
+        cullMask, 
+        0, 0,     // sbtRecordOffset, sbtRecordStride
+        SBT_INDEX_MISS_DEFAULT, 
+        origin, tMin, direction, tMax, 
+        PAYLOAD_INDEX_DEFAULT);
+
+    // misses go to the first group, as they all sample the sky
+    uint coherenceHint = 0;
+    if (hitObjectIsHitNV(hitObject))
+    {
+        const ShGeometryInstance inst = geometryInstances[getGeometryInstanceIndex(
+            hitObjectGetInstanceIdNV(hitObject), hitObjectGetGeometryIndexNV(hitObject))];
+        coherenceHint = 1 + (inst.materialIndex % ((1 << SER_COHERENCE_HINT_BITS) - 1));
+    }
+    reorderThreadNV(hitObject, coherenceHint, SER_COHERENCE_HINT_BITS);
+
+    hitObjectExecuteShaderNV(hitObject, PAYLOAD_INDEX_DEFAULT);
+#else
     traceRayEXT(
         topLevelAS,
         getAdditionalRayFlags(), 
         cullMask, 
         0, 0,     // sbtRecordOffset, sbtRecordStride
         SBT_INDEX_MISS_DEFAULT, 
-        origin, globalUniform.primaryRayMinDist, direction, globalUniform.rayLength, 
+        origin, tMin, direction, tMax, 
         PAYLOAD_INDEX_DEFAULT);
+#endif
 
-    return g_payload; 
+    rayCostEndTrace(rayQueryAnyHits, translucentLayers);
 }
 
-ShPayload traceReflectionRefractionRay(vec3 origin, vec3 direction, uint surfInstCustomIndex, uint geometryInstanceFlags, bool isRefraction)
+ShPayload tracePrimaryRay(vec3 origin, vec3 direction)
 {
     resetPayload();
 
-    uint cullMask = getReflectionRefractionCullMask(surfInstCustomIndex, geometryInstanceFlags, isRefraction);
+    uint cullMask = getPrimaryVisibilityCullMask();
 
+#ifdef RAYGEN_RAY_QUERY
+    traceDefaultRay(cullMask, origin, globalUniform.primaryRayMinDist, direction, globalUniform.rayLength, 0);
+#else
+    rayCostBeginTrace();
     traceRayEXT(
         topLevelAS,
         getAdditionalRayFlags(), 
         cullMask, 
         0, 0,     // sbtRecordOffset, sbtRecordStride
         SBT_INDEX_MISS_DEFAULT, 
-        origin, 0.001, direction, globalUniform.rayLength, 
+        origin, globalUniform.primaryRayMinDist, direction, globalUniform.rayLength, 
         PAYLOAD_INDEX_DEFAULT);
+    rayCostEndTrace(0, 0);
+#endif
+
+    return g_payload; 
+}
+
+ShPayload traceReflectionRefractionRay(vec3 origin, vec3 direction, uint surfInstCustomIndex, uint geometryInstanceFlags, bool isRefraction)
+{
+    resetPayload();
+
+    uint cullMask = getReflectionRefractionCullMask(surfInstCustomIndex, geometryInstanceFlags, isRefraction);
+
+    // each reflection or refraction is one more translucent layer
+    traceDefaultRay(cullMask, origin, 0.001, direction, globalUniform.rayLength, 1);
 
     return g_payload; 
 }
@@ -256,14 +437,7 @@ ShPayload traceIndirectRay(uint surfInstCustomIndex, vec3 surfPosition, vec3 bou
 
     uint cullMask = getIndirectIlluminationCullMask(surfInstCustomIndex);
 
-    traceRayEXT(
-        topLevelAS,
-        getAdditionalRayFlags(), 
-        cullMask, 
-        0, 0,     // sbtRecordOffset, sbtRecordStride
-        SBT_INDEX_MISS_DEFAULT, 
-        surfPosition, 0.001, bounceDirection, globalUniform.rayLength, 
-        PAYLOAD_INDEX_DEFAULT); 
+    traceDefaultRay(cullMask, surfPosition, 0.001, bounceDirection, globalUniform.rayLength, 0);
 
     return g_payload;
 }
@@ -288,7 +462,8 @@ vec3 getSkyAlbedo( vec3 direction )
     #ifdef DESC_SET_RENDER_CUBEMAP
     if( globalUniform.skyType == SKY_TYPE_RASTERIZED_GEOMETRY )
     {
-        return texture( renderCubemap, direction ).rgb;
+        // mip 0 is the sharp one, others are prefiltered
+        return textureLod( renderCubemap, direction, 0.0 ).rgb;
     }
     else
     #endif
@@ -306,10 +481,31 @@ vec3 getSkyAlbedo( vec3 direction )
     }
 }
 
+// Sky as seen from a surface with the given roughness, fewer rays are needed
+// for a stable result. Only the rasterized sky has a GGX-prefiltered mip chain,
+// mip 'i' of which corresponds to the roughness i/(mipCount-1)
+vec3 getSkyAlbedo( vec3 direction, float roughness )
+{
+    #ifdef DESC_SET_RENDER_CUBEMAP
+    if( globalUniform.skyType == SKY_TYPE_RASTERIZED_GEOMETRY )
+    {
+        const float lod = roughness * float( textureQueryLevels( renderCubemap ) - 1 );
+        return textureLod( renderCubemap, direction, lod ).rgb;
+    }
+    #endif
+
+    return getSkyAlbedo( direction );
+}
+
 vec3 getSky( vec3 direction )
 {
     return adjustSky( getSkyAlbedo( direction ) );
 }
+
+vec3 getSky( vec3 direction, float roughness )
+{
+    return adjustSky( getSkyAlbedo( direction, roughness ) );
+}
 #endif
 
 
@@ -319,22 +515,16 @@ vec3 getSky( vec3 direction )
 #define SHADOW_RAY_EPS       0.01
 #define RAY_ORIGIN_LEAK_BIAS 0.01    // offset a bit towards a viewer to prevent light leaks from the other side of polygons
 
-bool traceShadowRay(uint surfInstCustomIndex, vec3 start, vec3 end, bool ignoreFirstPersonViewer /* = false */)
+bool traceShadowRayWithMask(uint cullMask, vec3 start, vec3 end)
 {
     // prepare shadow payload
     g_payloadShadow.isShadowed = 1;  
 
-    uint cullMask = getShadowCullMask(surfInstCustomIndex);
-
-    if (ignoreFirstPersonViewer)
-    {
-        cullMask &= ~INSTANCE_MASK_FIRST_PERSON_VIEWER;
-    }
-
     vec3 l = end - start;
     float maxDistance = length(l);
     l /= maxDistance;
 
+    rayCostBeginTrace();
     traceRayEXT(
         topLevelAS, 
         gl_RayFlagsSkipClosestHitShaderEXT | getAdditionalRayFlags(), 
@@ -343,10 +533,23 @@ bool traceShadowRay(uint surfInstCustomIndex, vec3 start, vec3 end, bool ignoreF
         SBT_INDEX_MISS_SHADOW, 		// shadow missIndex
         start, 0.001, l, maxDistance - SHADOW_RAY_EPS, 
         PAYLOAD_INDEX_SHADOW);
+    rayCostEndTrace(0, 0);
 
     return g_payloadShadow.isShadowed == 1;
 }
 
+bool traceShadowRay(uint surfInstCustomIndex, vec3 start, vec3 end, bool ignoreFirstPersonViewer /* = false */)
+{
+    uint cullMask = getShadowCullMask(surfInstCustomIndex);
+
+    if (ignoreFirstPersonViewer)
+    {
+        cullMask &= ~INSTANCE_MASK_FIRST_PERSON_VIEWER;
+    }
+
+    return traceShadowRayWithMask(cullMask, start, end);
+}
+
 float traceVisibility(const Surface surf, const vec3 lightPosition, uint lightIndex)
 {
     const vec3 start = surf.position + surf.toViewerDir * RAY_ORIGIN_LEAK_BIAS;
@@ -361,6 +564,119 @@ float traceVisibility(const Surface surf, const vec3 lightPosition, uint lightIn
 
 
 
+#if LIGHT_SAMPLE_METHOD == LIGHT_SAMPLE_METHOD_DIRECT
+// Visibility of the directional light from the static geometry is reprojected from
+// the previous frame, and only shadows of the movable geometry are traced every frame.
+// x - visibility, y - 1.0 if x is valid
+vec2 g_sunShadowCache        = vec2(0.0);
+bool g_sunShadowCacheRetrace = true;
+
+#define SUN_SHADOW_CACHE_ALPHA 0.25
+
+// Shadow casters that are not cached
+#define SUN_SHADOW_CACHE_DYNAMIC_MASK \
+    (INSTANCE_MASK_WORLD_0_DYNAMIC | INSTANCE_MASK_FIRST_PERSON | INSTANCE_MASK_FIRST_PERSON_VIEWER)
+
+bool isSunShadowCacheable(const Surface surf)
+{
+    if (globalUniform.sunShadowCacheEnable == 0 || surf.isSky)
+    {
+        return false;
+    }
+
+    // movable receivers
+    const uint dynamicFlags = INSTANCE_CUSTOM_INDEX_FLAG_DYNAMIC |
+                              INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON |
+                              INSTANCE_CUSTOM_INDEX_FLAG_FIRST_PERSON_VIEWER;
+    if ((surf.instCustomIndex & dynamicFlags) != 0)
+    {
+        return false;
+    }
+
+    // the directional light must be the same as in the previous frame
+    const ShLightEncoded cur  = lightSources[LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET];
+    const ShLightEncoded prev = lightSources_Prev[LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET];
+
+    return globalUniform.directionalLightExists != 0 &&
+           getLightType(cur) == LIGHT_TYPE_DIRECTIONAL &&
+           getLightType(prev) == LIGHT_TYPE_DIRECTIONAL &&
+           cur.ldata0 == prev.ldata0 && cur.ldata1 == prev.ldata1 && cur.ldata2 == prev.ldata2 &&
+           cur.ldata3 == prev.ldata3;
+}
+
+void loadSunShadowCache(const ivec2 pix, uint seed, const Surface surf)
+{
+    g_sunShadowCache        = vec2(0.0);
+    g_sunShadowCacheRetrace = true;
+
+    if (!isSunShadowCacheable(surf))
+    {
+        return;
+    }
+
+    const ivec3 chRenderArea = getCheckerboardedRenderArea_Prev(pix);
+    const float motionZ      = texelFetch(framebufMotion_Sampler, pix, 0).z;
+    const float depthCur     = texelFetch(framebufDepthWorld_Sampler, pix, 0).r;
+    const ivec2 pp           = ivec2(floor(getPrevScreenPos(framebufMotion_Sampler, pix)));
+    const float depthPrev    = texelFetch(framebufDepthWorld_Prev_Sampler, pp, 0).r;
+
+    if (!testPixInRenderArea(pp, chRenderArea) ||
+        !testReprojectedDepth(depthCur, depthPrev, motionZ) ||
+        !testReprojectedNormal(surf.normal, texelFetchNormal_Prev(pp)))
+    {
+        return;
+    }
+
+    g_sunShadowCache = texelFetch(framebufSunVisibility_Prev_Sampler, pp, 0).rg;
+    g_sunShadowCacheRetrace =
+        g_sunShadowCache.y < 0.5 ||
+        rnd16(seed, RANDOM_SALT_SUN_SHADOW_CACHE) < globalUniform.sunShadowCacheUpdateRate;
+}
+
+void storeSunShadowCache(const ivec2 pix)
+{
+    imageStore(framebufSunVisibility, pix, vec4(g_sunShadowCache, 0.0, 0.0));
+}
+
+float traceSunVisibility_Cached(const Surface surf, const vec3 lightPosition)
+{
+    if (!isSunShadowCacheable(surf))
+    {
+        return traceVisibility(surf, lightPosition, LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET);
+    }
+
+    const vec3 start = surf.position + surf.toViewerDir * RAY_ORIGIN_LEAK_BIAS;
+
+    uint cullMask = getShadowCullMask(surf.instCustomIndex);
+    if (globalUniform.lightIndexIgnoreFPVShadows == LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET)
+    {
+        cullMask &= ~INSTANCE_MASK_FIRST_PERSON_VIEWER;
+    }
+
+    if (g_sunShadowCacheRetrace)
+    {
+        const uint  staticMask = cullMask & ~SUN_SHADOW_CACHE_DYNAMIC_MASK;
+        const float traced     = float(!traceShadowRayWithMask(staticMask, start, lightPosition));
+
+        // accumulate, as light points are different each frame
+        g_sunShadowCache.x = g_sunShadowCache.y > 0.5
+                                 ? mix(g_sunShadowCache.x, traced, SUN_SHADOW_CACHE_ALPHA)
+                                 : traced;
+        g_sunShadowCache.y = 1.0;
+    }
+
+    const uint dynamicMask = cullMask & SUN_SHADOW_CACHE_DYNAMIC_MASK;
+    if (g_sunShadowCache.x <= 0.0 || dynamicMask == 0)
+    {
+        return g_sunShadowCache.x;
+    }
+
+    return traceShadowRayWithMask(dynamicMask, start, lightPosition) ? 0.0 : g_sunShadowCache.x;
+}
+#endif // LIGHT_SAMPLE_METHOD == LIGHT_SAMPLE_METHOD_DIRECT
+
+
+
 void shade(const Surface surf, const LightSample light, float oneOverPdf, out vec3 diffuse, out vec3 specular)
 {
     vec3 l = safeNormalize2(light.position - surf.position, surf.normal);
@@ -396,18 +712,16 @@ float targetPdfForLightSample(uint lightIndex, const Surface surf, const vec2 po
     return targetPdfForLightSample(light, surf);
 }
 
-Reservoir calcInitialReservoir(uint seed, uint salt, const Surface surf, const vec2 pointRnd)
+Reservoir calcInitialReservoir(uint seed, uint salt, const Surface surf, const vec2 pointRnd, int candidateCount)
 {
-    #define INITIAL_SAMPLES 8
-    
     Reservoir regularReservoir = emptyReservoir();
 #if LIGHT_GRID_ENABLED
-    if (isInsideCell(surf.position))
+    if (globalUniform.lightGridEnable != 0 && isInsideCell(surf.position))
     {
         vec3 gridWorldPos = jitterPositionForLightGrid(surf.position, rnd8_4(seed, salt++).xyz);
         int lightGridBase = cellToArrayIndex(worldToCell(gridWorldPos));
 
-        for (int i = 0; i < INITIAL_SAMPLES; i++)
+        for (int i = 0; i < candidateCount; i++)
         {
             // uniform distribution as a coarse source pdf
             float rnd = rnd16(seed, salt++);
@@ -433,12 +747,39 @@ Reservoir calcInitialReservoir(uint seed, uint salt, const Surface surf, const v
     else
 #endif // LIGHT_GRID_ENABLED
     {      
-        for (int i = 0; i < INITIAL_SAMPLES; i++)
+        // static lights are at the beginning and covered by the light tree,
+        // choose between them and the others proportionally to their counts
+        const uint treeCount = min(globalUniform.lightTreeLeafCount, globalUniform.lightCount);
+        const float pTree = float(treeCount) / float(max(globalUniform.lightCount, 1));
+
+        for (int i = 0; i < candidateCount; i++)
         {
-            // uniform distribution as a coarse source pdf
             float rnd = rnd16(seed, salt++);
-            uint xi = LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + clamp(uint(rnd * globalUniform.lightCount), 0, globalUniform.lightCount - 1);
-            float oneOverSourcePdf_xi = globalUniform.lightCount;
+            uint xi;
+            float oneOverSourcePdf_xi;
+
+            if (rnd < pTree)
+            {
+                float treePdf;
+                xi = sampleLightTree(surf.position, surf.normal, rnd / pTree, treePdf);
+                oneOverSourcePdf_xi = safePositiveRcp(pTree * treePdf);
+                if (xi == LIGHT_INDEX_NONE)
+                {
+                    // still counts as a candidate
+                    regularReservoir.M += 1;
+                    salt++;
+                    continue;
+                }
+            }
+            else
+            {
+                // uniform distribution as a coarse source pdf
+                uint dynamicCount = globalUniform.lightCount - treeCount;
+                float r = (rnd - pTree) / (1.0 - pTree);
+                xi = LIGHT_ARRAY_REGULAR_LIGHTS_OFFSET + treeCount + clamp(uint(r * dynamicCount), 0, dynamicCount - 1);
+                // == (1 - pTree) / dynamicCount
+                oneOverSourcePdf_xi = globalUniform.lightCount;
+            }
 
             LightSample lightSample = sampleLight(lightSources[xi], surf.position, pointRnd);
             float targetPdf_xi = targetPdfForLightSample(lightSample, surf);
@@ -509,16 +850,15 @@ Reservoir selectLight_Direct(const ivec2 pix, uint seed, const Surface surf, con
 {
     #define TEMPORAL_SAMPLES 1
     #define TEMPORAL_RADIUS 2
-    #define SPATIAL_SAMPLES 8
     #define SPATIAL_RADIUS 30
 
     const ivec3 chRenderArea = getCheckerboardedRenderArea(pix); // assuming that pix is checkerboarded
+    const ivec3 chRenderAreaPrev = getCheckerboardedRenderArea_Prev(pix);
     const float motionZ = texelFetch(framebufMotion_Sampler, pix, 0).z;
     const float depthCur = texelFetch(framebufDepthWorld_Sampler, pix, 0).r;
     const vec2 posPrev = getPrevScreenPos(framebufMotion_Sampler, pix);
     uint salt = RANDOM_SALT_LIGHT_CHOOSE_DIRECT_BASE;
 
-
     Reservoir initReservoir = imageLoadReservoirInitial(pix);
     
     Reservoir combined;
@@ -528,6 +868,7 @@ Reservoir selectLight_Direct(const ivec2 pix, uint seed, const Surface surf, con
 
 
     // temporal
+    bool temporalFound = false;
     for (int pixIndex = 0; pixIndex < TEMPORAL_SAMPLES; pixIndex++)
     {
         // TODO: need low discrepancy noise
@@ -538,7 +879,7 @@ Reservoir selectLight_Direct(const ivec2 pix, uint seed, const Surface surf, con
             const float depthPrev = texelFetch(framebufDepthWorld_Prev_Sampler, pp, 0).r;
             const vec3 normalPrev = texelFetchNormal_Prev(pp);
 
-            if (!testSurfaceForReuse(chRenderArea, pp, 
+            if (!testSurfaceForReuse(chRenderAreaPrev, pp, 
                                      depthCur, depthPrev - motionZ,
                                      surf.normal, normalPrev))
             {
@@ -566,9 +907,16 @@ Reservoir selectLight_Direct(const ivec2 pix, uint seed, const Surface surf, con
         updateCombinedReservoir_newSurf(
             combined, 
             temporal, temporalTargetPdf_curSurf, rnd);
+        temporalFound = true;
     } 
 
-    for (int pixIndex = 0; pixIndex < SPATIAL_SAMPLES; pixIndex++)
+    // less spatial reuse in converged regions, full -- if there's no history
+    const int spatialSamplesCount = getBudgetedCount(
+        temporalFound ? getSampleBudget(posPrev, depthCur, motionZ) : 1.0,
+        globalUniform.restirDirectSpatialMin,
+        globalUniform.restirDirectSpatialMax);
+
+    for (int pixIndex = 0; pixIndex < spatialSamplesCount; pixIndex++)
     {
         // TODO: need low discrepancy noise
         vec2 rndOffset = rnd8_4(seed, salt++).xy * 2.0 - 1.0;
@@ -623,12 +971,13 @@ Reservoir selectLight_Uniform(uint seed)
 // Select light in world-space for light bounces
 Reservoir selectLight_Indir(uint seed, const Surface surf, const vec2 pointRnd)
 {
-    return calcInitialReservoir(seed, RANDOM_SALT_LIGHT_CHOOSE_INDIRECT_BASE, surf, pointRnd);
+    #define INITIAL_SAMPLES_INDIR 8
+    return calcInitialReservoir(seed, RANDOM_SALT_LIGHT_CHOOSE_INDIRECT_BASE, surf, pointRnd, INITIAL_SAMPLES_INDIR);
 }
 
 vec2 getLightPointRnd(uint seed)
 {
-    return rnd16_2(seed, RANDOM_SALT_LIGHT_POINT) * 0.99;
+    return rndSample2(seed, RANDOM_SALT_LIGHT_POINT) * 0.99;
 }
 
 #if LIGHT_SAMPLE_METHOD != LIGHT_SAMPLE_METHOD_NONE
@@ -664,7 +1013,13 @@ void traceDirectIllumination( const Surface   surf,
 
     if (bounceIndex < globalUniform.maxBounceShadowsLights)
     {
+    #if LIGHT_SAMPLE_METHOD == LIGHT_SAMPLE_METHOD_DIRECT
+        float visibility = reservoir.selected == LIGHT_ARRAY_DIRECTIONAL_LIGHT_OFFSET
+                               ? traceSunVisibility_Cached(surf, light.position)
+                               : traceVisibility(surf, light.position, reservoir.selected);
+    #else
         float visibility = traceVisibility(surf, light.position, reservoir.selected);
+    #endif
 
         out_diffuse  *= visibility;
         out_specular *= visibility;
@@ -681,24 +1036,67 @@ void traceDirectIllumination( const Surface   surf,
 
 
 #if LIGHT_SAMPLE_METHOD == LIGHT_SAMPLE_METHOD_DIRECT
+// Static emissive geometry as an area light, one sample.
+// Only for the surfaces which indirect rays are diffuse, as such rays ignore
+// the sampled emission (see processIndirect); glossy ones get it from the indirect
+void traceEmissiveTriangles(uint seed, const Surface surf, inout vec3 out_diffuse, inout vec3 out_specular)
+{
+    if (globalUniform.emissiveTriangleCount == 0 || surf.roughness < FAKE_ROUGH_SPECULAR_THRESHOLD)
+    {
+        return;
+    }
+
+    const vec3 rnd = vec3(rnd16(seed, RANDOM_SALT_EMISSIVE_TRIANGLE_CHOOSE),
+                          rndSample2(seed, RANDOM_SALT_EMISSIVE_TRIANGLE_POINT));
+
+    const LightSample light = sampleEmissiveTriangle(surf.position, rnd);
+
+    vec3 d, s;
+    shade(surf, light, 1.0, d, s);
+
+    if (getLuminance(d + s) <= 0.0)
+    {
+        return;
+    }
+
+    if (0 < globalUniform.maxBounceShadowsLights)
+    {
+        const float visibility = traceVisibility(surf, light.position, LIGHT_INDEX_NONE);
+
+        d *= visibility;
+        s *= visibility;
+    }
+
+    out_diffuse  += d;
+    out_specular += s;
+}
+
 Reservoir processDirectIllumination(uint seed, const ivec2 pix, const Surface surf, out float out_distance, out vec3 out_diffuse, out vec3 out_specular)
 {
     out_diffuse = out_specular = vec3(0.0);
     out_distance = MAX_RAY_LENGTH;
 
-    if (!isDirectIlluminationValid(0))
+    Reservoir reservoir = emptyReservoir();
+
+    loadSunShadowCache(pix, seed, surf);
+
+    if (isDirectIlluminationValid(0))
     {
-        return emptyReservoir();
+        const vec2 pointRnd = getLightPointRnd(seed);
+
+        reservoir = selectLight_Direct(pix, seed, surf, pointRnd);
+        if (isReservoirValid(reservoir))
+        {
+            traceDirectIllumination(surf, reservoir, pointRnd, 0, out_distance, out_diffuse, out_specular);
+        }
+        else
+        {
+            reservoir = emptyReservoir();
+        }
     }
-    const vec2 pointRnd = getLightPointRnd(seed);
-    
-    const Reservoir reservoir = selectLight_Direct(pix, seed, surf, pointRnd);
-    if (!isReservoirValid(reservoir))
-    {
-        return emptyReservoir();
-    } 
 
-    traceDirectIllumination(surf, reservoir, pointRnd, 0, out_distance, out_diffuse, out_specular);
+    traceEmissiveTriangles(seed, surf, out_diffuse, out_specular);
+    storeSunShadowCache(pix);
     return reservoir;
 }
 #endif
@@ -40,6 +40,9 @@
 #ifndef MATERIAL_LIGHTMAP_LAYER_INDEX
     #error MATERIAL_LIGHTMAP_LAYER_INDEX is not defined
 #endif 
+#if defined(RAYGEN_REFL_REFR_SHADER) && !defined(REFL_REFR_MAX_DEPTH)
+    #define REFL_REFR_MAX_DEPTH globalUniform.reflectRefractMaxDepth
+#endif
 
 
 #define DESC_SET_TLAS 0
@@ -52,6 +55,7 @@
 #define DESC_SET_CUBEMAPS 7
 #define DESC_SET_RENDER_CUBEMAP 8
 #define DESC_SET_PORTALS 9
+#define TEXTURE_STREAMING_FEEDBACK_WRITEABLE
 #define LIGHT_SAMPLE_METHOD (LIGHT_SAMPLE_METHOD_NONE)
 #include "RaygenCommon.h"
 
@@ -67,18 +71,18 @@ vec2 getMotionForInfinitePoint(const ivec2 pix)
     // treat as a point with .w=0, i.e. at infinite distance
     vec3 rayDir = getRayDir(getPixelUVWithJitter(pix));
 
-    vec3 viewSpacePosCur   = mat3(globalUniform.view)     * rayDir;
-    vec3 viewSpacePosPrev  = mat3(globalUniform.viewPrev) * rayDir;
+    vec3 viewSpacePosCur   = mat3(globalUniform.viewsView    [g_viewIndex]) * rayDir;
+    vec3 viewSpacePosPrev  = mat3(globalUniform.viewsViewPrev[g_viewIndex]) * rayDir;
 
-    vec3 clipSpacePosCur   = mat3(globalUniform.projection)     * viewSpacePosCur;
-    vec3 clipSpacePosPrev  = mat3(globalUniform.projectionPrev) * viewSpacePosPrev;
+    vec3 clipSpacePosCur   = mat3(globalUniform.viewsProjection    [g_viewIndex]) * viewSpacePosCur;
+    vec3 clipSpacePosPrev  = mat3(globalUniform.viewsProjectionPrev[g_viewIndex]) * viewSpacePosPrev;
 
     // don't divide by .w
     vec3 ndcCur            = clipSpacePosCur.xyz;
     vec3 ndcPrev           = clipSpacePosPrev.xyz;
 
-    vec2 screenSpaceCur    = ndcCur.xy  * 0.5 + 0.5;
-    vec2 screenSpacePrev   = ndcPrev.xy * 0.5 + 0.5;
+    vec2 screenSpaceCur    = fromViewUV(ndcCur.xy  * 0.5 + 0.5, g_viewIndex);
+    vec2 screenSpacePrev   = fromViewUV(ndcPrev.xy * 0.5 + 0.5, g_viewIndex);
 
     return screenSpacePrev - screenSpaceCur;
 }
@@ -270,6 +274,113 @@ vec3 getNormal( const vec3    position,
 }
 
 #ifdef RAYGEN_PRIMARY_SHADER
+
+#ifdef RAYGEN_VISIBILITY_RESOLVE
+// Pixels of a work group are sorted by their material, so neighboring invocations
+// evaluate the same material: texture fetches are more coherent, and there's less divergence
+#define VISIBILITY_RESOLVE_GROUP_SIZE \
+    ( COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_X * COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_Y )
+#if ( VISIBILITY_RESOLVE_GROUP_SIZE & ( VISIBILITY_RESOLVE_GROUP_SIZE - 1 ) ) != 0 || \
+    VISIBILITY_RESOLVE_GROUP_SIZE > 256
+    #error Visibility resolve group size must be a power of 2, and not larger than 256
+#endif
+// lower bits of a key are for the pixel index in a group
+#define VISIBILITY_RESOLVE_KEY_SHIFT 8
+#define VISIBILITY_RESOLVE_KEY_NO_MATERIAL ( UINT32_MAX >> VISIBILITY_RESOLVE_KEY_SHIFT )
+
+shared uint s_resolveKeys[ VISIBILITY_RESOLVE_GROUP_SIZE ];
+
+ShPayload loadPrimaryPayload( const ivec2 pix )
+{
+    const vec4 v = imageLoad( framebufVisibilityBuffer, pix );
+
+    ShPayload p;
+    p.instIdAndIndex   = floatBitsToUint( v[ 0 ] );
+    p.geomAndPrimIndex = floatBitsToUint( v[ 1 ] );
+    p.baryCoords       = v.zw;
+    return p;
+}
+
+uint getMaterialSortKey( const ivec2 regularPix )
+{
+    if( regularPix.x >= int( globalUniform.renderWidth ) ||
+        regularPix.y >= int( globalUniform.renderHeight ) )
+    {
+        return VISIBILITY_RESOLVE_KEY_NO_MATERIAL;
+    }
+
+    const ShPayload p = loadPrimaryPayload( getCheckerboardPix( regularPix ) );
+    if( !doesPayloadContainHitInfo( p ) )
+    {
+        return VISIBILITY_RESOLVE_KEY_NO_MATERIAL;
+    }
+
+    int instanceID, instCustomIndex;
+    unpackInstanceIdAndCustomIndex( p.instIdAndIndex, instanceID, instCustomIndex );
+
+    return min( geometryInstances[ instanceID ].materialIndex,
+                VISIBILITY_RESOLVE_KEY_NO_MATERIAL - 1 );
+}
+
+// Bitonic sort of the keys in shared memory
+void sortResolveKeys()
+{
+    const uint i = gl_LocalInvocationIndex;
+
+    for( uint k = 2; k <= VISIBILITY_RESOLVE_GROUP_SIZE; k <<= 1 )
+    {
+        for( uint j = k >> 1; j > 0; j >>= 1 )
+        {
+            barrier();
+
+            const uint ixj = i ^ j;
+            if( ixj > i )
+            {
+                const uint a = s_resolveKeys[ i ];
+                const uint b = s_resolveKeys[ ixj ];
+
+                if( ( a > b ) == ( ( i & k ) == 0 ) )
+                {
+                    s_resolveKeys[ i ]   = b;
+                    s_resolveKeys[ ixj ] = a;
+                }
+            }
+        }
+    }
+
+    barrier();
+}
+
+// Must be called in uniform control flow
+ivec2 getSortedResolvePix()
+{
+    const uvec2 groupSize = uvec2( COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_X,
+                                   COMPUTE_VISIBILITY_RESOLVE_GROUP_SIZE_Y );
+    const ivec2 groupBase = ivec2( gl_WorkGroupID.xy * groupSize );
+    const uint  local     = gl_LocalInvocationIndex;
+
+    const ivec2 ownPix = groupBase + ivec2( local % groupSize.x, local / groupSize.x );
+
+    s_resolveKeys[ local ] =
+        ( getMaterialSortKey( ownPix ) << VISIBILITY_RESOLVE_KEY_SHIFT ) | local;
+    sortResolveKeys();
+
+    const uint sorted = s_resolveKeys[ local ] & ( ( 1 << VISIBILITY_RESOLVE_KEY_SHIFT ) - 1 );
+
+    return groupBase + ivec2( sorted % groupSize.x, sorted / groupSize.x );
+}
+#endif // RAYGEN_VISIBILITY_RESOLVE
+
+// If primary rays only write the visibility buffer, and material is evaluated later
+bool isVisibilityBufferOnlyPass()
+{
+#ifdef RAYGEN_VISIBILITY_RESOLVE
+    return false;
+#else
+    return globalUniform.primaryVisibilityBuffer != 0;
+#endif
+}
+
 vec4 makeNdcCoord(const ivec2 pix_regular, float ndcDepth)
 {
     return vec4( ( pix_regular.x + 0.5 ) / float( globalUniform.renderWidth ) * 2.0 - 1.0,
@@ -342,11 +453,35 @@ bool tryAsFluid( const ivec2 pix, const ivec2 pix_regular, const vec3 cameraRayD
 
 void main() 
 {
+#if defined( RAYGEN_VISIBILITY_RESOLVE )
+    const ivec2 regularPix = getSortedResolvePix();
+    if( regularPix.x >= int( globalUniform.renderWidth ) ||
+        regularPix.y >= int( globalUniform.renderHeight ) )
+    {
+        return;
+    }
+#elif defined( RAYGEN_RAY_QUERY )
+    const ivec2 regularPix = ivec2(gl_GlobalInvocationID.xy);
+    if( regularPix.x >= int( globalUniform.renderWidth ) ||
+        regularPix.y >= int( globalUniform.renderHeight ) )
+    {
+        return;
+    }
+#else
     const ivec2 regularPix = ivec2(gl_LaunchIDEXT.xy);
+#endif
     const ivec2 pix = getCheckerboardPix(regularPix);
     const vec2 inUV = getPixelUVWithJitter(regularPix);
 
-    const vec3 cameraOrigin = globalUniform.cameraPosition.xyz;
+#ifdef RAYGEN_VISIBILITY_RESOLVE
+    // was reset by the primary rays
+    rayCostSetPix(pix);
+#else
+    rayCostReset(pix);
+#endif
+    g_viewIndex = getViewIndex(regularPix);
+
+    const vec3 cameraOrigin = getViewCameraPosition(g_viewIndex);
     const vec3 cameraRayDir = getRayDir(inUV);
     const vec3 cameraRayDirAX = getRayDirAX(inUV);
     const vec3 cameraRayDirAY = getRayDirAY(inUV);
@@ -355,6 +490,12 @@ void main()
     if( classicShading( ivec2( regularPix.x + 16, regularPix.y ) ) ||
         globalUniform.lightmapScreenCoverage >= 0.999 )
     {
+        if( isVisibilityBufferOnlyPass() )
+        {
+            imageStore( framebufVisibilityBuffer, pix, packVisibilityBuffer_Invalid() );
+            return;
+        }
+
         storeSky( pix,
                   cameraRayDir,
                   globalUniform.skyType != SKY_TYPE_RASTERIZED_GEOMETRY,
@@ -364,8 +505,23 @@ void main()
     }
 
 
+#ifdef RAYGEN_VISIBILITY_RESOLVE
+    const ShPayload primaryPayload = loadPrimaryPayload(pix);
+#else
     const ShPayload primaryPayload = tracePrimaryRay(cameraOrigin, cameraRayDir);
 
+    if( isVisibilityBufferOnlyPass() )
+    {
+        // the rest is done in CmVisibilityResolve.comp
+        imageStore( framebufVisibilityBuffer,
+                    pix,
+                    doesPayloadContainHitInfo( primaryPayload )
+                        ? packVisibilityBuffer( primaryPayload )
+                        : packVisibilityBuffer_Invalid() );
+        return;
+    }
+#endif
+
 
     const uint currentRayMedia = globalUniform.cameraMediaType;
 
@@ -445,9 +601,34 @@ void main()
 
 
 #ifdef RAYGEN_REFL_REFR_SHADER
+// Per-pixel heuristics to stop the chain before REFL_REFR_MAX_DEPTH:
+// when the rest can't contribute much, when the specular of a rough surface
+// is better handled by the denoised indirect, or when the path is too long
+bool needTerminateReflRefr( const vec3 throughput, float roughness, float pathLength )
+{
+    if( max( throughput.r, max( throughput.g, throughput.b ) ) <
+        globalUniform.reflectRefractMinThroughput )
+    {
+        return true;
+    }
+
+    if( roughness > globalUniform.reflectRefractMaxRoughness )
+    {
+        return true;
+    }
+
+    if( globalUniform.reflectRefractMaxDistance > 0 &&
+        pathLength > globalUniform.reflectRefractMaxDistance )
+    {
+        return true;
+    }
+
+    return false;
+}
+
 void main() 
 {
-    if (globalUniform.reflectRefractMaxDepth == 0)
+    if (REFL_REFR_MAX_DEPTH == 0)
     {
         return;
     }
@@ -459,6 +640,9 @@ void main()
 
     const vec3 cameraRayDir = getRayDir(inUV);
     
+    rayCostSetPix(pix);
+    g_viewIndex = getViewIndex(regularPix);
+
     if (isSkyPix(pix))
     {
         return;
@@ -509,7 +693,7 @@ void main()
 
 
 
-    for (int i = 0; i < globalUniform.reflectRefractMaxDepth; i++)
+    for (int i = 0; i < REFL_REFR_MAX_DEPTH; i++)
     {
         const uint instIndex = unpackInstanceIdAndCustomIndex(currentPayload.instIdAndIndex).y;
 
@@ -531,6 +715,21 @@ void main()
             break;
         }
 
+        if( !isPortal && needTerminateReflRefr( throughput, h.roughness, fullPathLength ) )
+        {
+            if( globalUniform.reflectRefractSkyOnTermination != 0 )
+            {
+                // approximate the rest of the chain with the sky in a mirror direction
+                const vec3 dir = reflect( normalize( rayDir ), h.normal );
+                const vec3 F   = getFresnelSchlick( max( 0, dot( h.normal, dir ) ),
+                                                  getSpecularColor( h.albedo, h.metallic ) );
+
+                storeSky( pix, dir, true, throughput * F, wasSplit );
+                return;
+            }
+            break;
+        }
+
 
         const float curIndexOfRefraction = getIndexOfRefraction(currentRayMedia);
         const float newIndexOfRefraction = getIndexOfRefraction(newRayMedia);
@@ -154,10 +154,39 @@ void updateCombinedReservoirIndirect_newSurf(inout ReservoirIndirect combined, c
 
 #ifdef DESC_SET_GLOBAL_UNIFORM
 #ifdef DESC_SET_RESTIR_INDIRECT
-bool rgi_TryGetPixOffset(const ivec2 pix, out uint offset)
+
+// Reservoirs are stored in tiles of RESTIR_INDIRECT_RESERVOIR_TILE_SIZE^2 texels,
+// with Morton order inside a tile: reprojected / neighbor pixels are close in memory
+uint rgi_MortonInTile( const uvec2 p )
+{
+#if RESTIR_INDIRECT_RESERVOIR_TILE_SIZE != 8
+    #error "Morton code below is for 3 bits per axis"
+#endif
+    uvec2 v = p & 7u;
+    v       = ( v | ( v << 2u ) ) & 0x33u;
+    v       = ( v | ( v << 1u ) ) & 0x55u;
+    return v.x | ( v.y << 1u );
+}
+
+// 'renderSize' is of the frame that wrote the reservoirs, as the tiles depend on it
+bool rgi_TryGetPixOffset(const ivec2 pix, const vec2 renderSize, out uint offset)
 {
-    offset = pix.y * uint(globalUniform.renderWidth) + pix.x;
-    return offset >= 0 && offset < uint(globalUniform.renderWidth) * uint(globalUniform.renderHeight);
+    if( pix.x < 0 || pix.y < 0 || //
+        pix.x >= renderSize.x || pix.y >= renderSize.y )
+    {
+        offset = 0;
+        return false;
+    }
+
+    const uint  tileCountX = ( uint( renderSize.x ) +
+                              RESTIR_INDIRECT_RESERVOIR_TILE_SIZE - 1 ) /
+                            RESTIR_INDIRECT_RESERVOIR_TILE_SIZE;
+    const uvec2 tile       = uvec2( pix ) / RESTIR_INDIRECT_RESERVOIR_TILE_SIZE;
+
+    offset = ( tile.y * tileCountX + tile.x ) * RESTIR_INDIRECT_RESERVOIR_TILE_SIZE *
+                 RESTIR_INDIRECT_RESERVOIR_TILE_SIZE +
+             rgi_MortonInTile( uvec2( pix ) );
+    return true;
 }
 
 void restirIndirect_StoreInitialSample(const ivec2 pix, const SampleIndirect s, float oneOverSourcePdf)
@@ -172,10 +201,39 @@ void restirIndirect_StoreInitialSample(const ivec2 pix, const SampleIndirect s,
 
 #define STORAGE_MULT 100.0
 
+// Unsigned 12-bit float: half without the sign bit and 3 lowest mantissa bits
+uint rgi_PackUFloat12( float v )
+{
+    uint h = packHalf2x16( vec2( max( v, 0.0 ), 0 ) ) & 0x7FFFu;
+    // round to nearest, but don't overflow into inf
+    return min( h + 4u, 0x7BFFu ) >> 3u;
+}
+
+float rgi_UnpackUFloat12( uint p )
+{
+    return unpackHalf2x16( ( p & 0xFFFu ) << 3u ).x;
+}
+
+// 16:16 octahedral normal to 8:8
+uint rgi_PackNormal16( uint normalPacked )
+{
+    return ( ( normalPacked >> 8u ) & 0xFFu ) | ( ( normalPacked >> 16u ) & 0xFF00u );
+}
+
+uint rgi_UnpackNormal16( uint p )
+{
+    return ( ( p & 0xFFu ) * 257u ) | ( ( ( ( p >> 8u ) & 0xFFu ) * 257u ) << 16u );
+}
+
+// Packed reservoir:
+//   [0] position.xy (half2)
+//   [1] position.z (half) | normal (8:8 octahedral)
+//   [2] radiance (E5B9G9R9)
+//   [3] M (8 bits) | targetPdf (ufloat12) | weightSum (ufloat12)
 void restirIndirect_StoreReservoir(const ivec2 pix, ReservoirIndirect r)
 {
     uint offset;
-    if (!rgi_TryGetPixOffset(pix, offset))
+    if (!rgi_TryGetPixOffset(pix, vec2(globalUniform.renderWidth, globalUniform.renderHeight), offset))
     {
         return;
     }
@@ -184,22 +242,21 @@ void restirIndirect_StoreReservoir(const ivec2 pix, ReservoirIndirect r)
 
     if (!isinf(r.weightSum) && !isnan(r.weightSum) && r.weightSum >= 0.0)
     {
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 0] = r.selected.positionXY;
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 1] = packHalf2x16( vec2( unpackHalf2x16( r.selected.positionZ ).x, r.M ) );
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 2] = r.selected.normalPacked;
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 3] = r.selected.radianceE5;
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 4] = packHalf2x16( vec2( r.selected_targetPdf / STORAGE_MULT, r.weightSum / STORAGE_MULT) );
+        const uint zNormal = ( r.selected.positionZ & 0xFFFFu ) |
+                             ( rgi_PackNormal16( r.selected.normalPacked ) << 16u );
+        const uint weights = min( r.M, 255u ) |
+                             ( rgi_PackUFloat12( r.selected_targetPdf / STORAGE_MULT ) << 8u ) |
+                             ( rgi_PackUFloat12( r.weightSum / STORAGE_MULT ) << 20u );
+
+        g_restirIndirectReservoirs[ offset ] =
+            uvec4( r.selected.positionXY, zNormal, r.selected.radianceE5, weights );
     }
     else
     {
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 0] = 0;
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 1] = 0;
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 2] = 0;
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 3] = 0;
-        g_restirIndirectReservoirs[offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 4] = 0;
+        g_restirIndirectReservoirs[ offset ] = uvec4( 0 );
     }
 
-#if PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS != 5
+#if PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS != 4
     #error "Size mismatch"
 #endif
 }
@@ -226,17 +283,17 @@ SampleIndirect restirIndirect_LoadInitialSample( const ivec2 pix, out float oneO
     return s;
 }
 
-#define INDIR_LOAD_RESERVOIR_T(BUFFER_T) \
-    r.selected.positionXY   =               ( BUFFER_T[ offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 0 ] ); \
-    r.selected.positionZ    =               ( BUFFER_T[ offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 1 ] ); \
-    r.selected.normalPacked =               ( BUFFER_T[ offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 2 ] ); \
-    r.selected.radianceE5   =               ( BUFFER_T[ offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 3 ] ); \
-    const vec2 tpws         = unpackHalf2x16( BUFFER_T[ offset * PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS + 4 ] ); \
-    r.selected_targetPdf    = tpws.x * STORAGE_MULT;                                                              \
-    r.weightSum             = tpws.y * STORAGE_MULT;                                                              \
-    r.M                     = uint( unpackHalf2x16( r.selected.positionZ ).y );
-
-#if PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS != 5
+#define INDIR_LOAD_RESERVOIR_T(BUFFER_T)                                                  \
+    const uvec4 rpacked     = BUFFER_T[ offset ];                                         \
+    r.selected.positionXY   = rpacked[ 0 ];                                               \
+    r.selected.positionZ    = rpacked[ 1 ] & 0xFFFFu;                                     \
+    r.selected.normalPacked = rgi_UnpackNormal16( rpacked[ 1 ] >> 16u );                 \
+    r.selected.radianceE5   = rpacked[ 2 ];                                               \
+    r.M                     = rpacked[ 3 ] & 0xFFu;                                       \
+    r.selected_targetPdf    = rgi_UnpackUFloat12( rpacked[ 3 ] >> 8u ) * STORAGE_MULT;    \
+    r.weightSum             = rgi_UnpackUFloat12( rpacked[ 3 ] >> 20u ) * STORAGE_MULT;
+
+#if PACKED_INDIRECT_RESERVOIR_SIZE_IN_WORDS != 4
     #error "Size mismatch"
 #endif
 
@@ -245,7 +302,7 @@ ReservoirIndirect restirIndirect_LoadReservoir(const ivec2 pix)
     ReservoirIndirect r;
 
     uint offset;
-    if (!rgi_TryGetPixOffset(pix, offset))
+    if (!rgi_TryGetPixOffset(pix, vec2(globalUniform.renderWidth, globalUniform.renderHeight), offset))
     {
         r = emptyReservoirIndirect();
         return r;
@@ -259,8 +316,10 @@ ReservoirIndirect restirIndirect_LoadReservoir_Prev(const ivec2 pix)
 {
     ReservoirIndirect r;
 
+    const vec2 renderSizePrev = vec2(globalUniform.renderWidthPrev, globalUniform.renderHeightPrev);
+
     uint offset;
-    if (!rgi_TryGetPixOffset(pix, offset))
+    if (!rgi_TryGetPixOffset(pix, renderSizePrev, offset))
     {
         r = emptyReservoirIndirect();
         return r;
@@ -24,30 +24,25 @@
 #define DESC_SET_GLOBAL_UNIFORM 0
 #define DESC_SET_FRAMEBUFFERS   1
 #define DESC_SET_TEXTURES       2
+#define TEXTURE_STREAMING_FEEDBACK_WRITEABLE
 #include "ShaderCommonGLSLFunc.h"
 #include "Random.h"
 
 layout( location = 0 ) in vec4 vertColor;
 layout( location = 1 ) in vec2 vertTexCoord;
 layout( location = 2 ) in vec3 vertWorldPosition;
+layout( location = 3 ) flat in uint vertTextureIndex;
+layout( location = 4 ) flat in uint vertEmissiveTextureIndex;
+layout( location = 5 ) flat in float vertEmissiveMult;
+layout( location = 6 ) flat in uint vertNormalTextureIndex;
 
 layout( location = 0 ) out vec4 out_albedo;
 layout( location = 1 ) out uint out_normal;
 layout( location = 2 ) out vec3 out_screenEmission;
 
-layout( push_constant ) uniform DecalFrag_BT
-{
-    layout( offset = 64 ) uint  packedColor;
-    layout( offset = 68 ) uint  textureIndex;
-    layout( offset = 72 ) uint  emissiveTextureIndex;
-    layout( offset = 76 ) float emissiveMult;
-    layout( offset = 80 ) uint  normalTextureIndex;
-}
-decal;
-
 vec4 baseColor()
 {
-    return vertColor * unpackUintColor( decal.packedColor );
+    return vertColor;
 }
 
 void main()
@@ -67,17 +62,22 @@ void main()
         }
     }
 
+    requestTextureResolution( vertTextureIndex, dFdx( vertTexCoord ), dFdy( vertTexCoord ) );
+    requestTextureResolution( vertNormalTextureIndex, dFdx( vertTexCoord ), dFdy( vertTexCoord ) );
+    requestTextureResolution(
+        vertEmissiveTextureIndex, dFdx( vertTexCoord ), dFdy( vertTexCoord ) );
+
     {
-        out_albedo = baseColor() * getTextureSample( decal.textureIndex, vertTexCoord );
+        out_albedo = baseColor() * getTextureSample( vertTextureIndex, vertTexCoord );
     }
 
-    if( decal.normalTextureIndex != MATERIAL_NO_TEXTURE )
+    if( vertNormalTextureIndex != MATERIAL_NO_TEXTURE )
     {
         const vec3 underlyingNormal = texelFetchNormal( pix );
 
         mat3 basis = getONB( underlyingNormal );
 
-        vec2 nmap = getTextureSample( decal.normalTextureIndex, vertTexCoord ).xy;
+        vec2 nmap = getTextureSample( vertNormalTextureIndex, vertTexCoord ).xy;
         nmap.xy   = nmap.xy * 2.0 - vec2( 1.0 );
 
         out_normal = encodeNormal( safeNormalize2(
@@ -90,16 +90,16 @@ void main()
 
     {
         vec3 ldrEmis;
-        if( decal.emissiveTextureIndex != MATERIAL_NO_TEXTURE )
+        if( vertEmissiveTextureIndex != MATERIAL_NO_TEXTURE )
         {
             ldrEmis =
-                baseColor().rgb * getTextureSample( decal.emissiveTextureIndex, vertTexCoord ).rgb;
+                baseColor().rgb * getTextureSample( vertEmissiveTextureIndex, vertTexCoord ).rgb;
         }
         else
         {
             ldrEmis = out_albedo.rgb;
         }
-        ldrEmis *= decal.emissiveMult * baseColor().a;
+        ldrEmis *= vertEmissiveMult * baseColor().a;
 
         out_screenEmission = ldrEmis;
     }
@@ -27,6 +27,19 @@ layout( location = 2 ) in vec2 texCoord;
 layout( location = 0 ) out vec4 outColor;
 layout( location = 1 ) out vec2 outTexCoord;
 layout( location = 2 ) out vec3 outWorldPos;
+layout( location = 3 ) flat out uint outTextureIndex;
+layout( location = 4 ) flat out uint outEmissiveTextureIndex;
+layout( location = 5 ) flat out float outEmissiveMult;
+layout( location = 6 ) flat out uint outNormalTextureIndex;
+
+#define DESC_SET_RASTERIZED_DRAWS 3
+#include "ShaderCommonGLSLFunc.h"
+
+layout( set     = DESC_SET_RASTERIZED_DRAWS,
+        binding = BINDING_RASTERIZED_DRAWS ) readonly buffer RasterizedDraws_BT
+{
+    ShRasterizedDraw rasterizedDraws[];
+};
 
 layout( push_constant ) uniform DecalVert_BT
 {
@@ -38,6 +51,8 @@ layout( constant_id = 0 ) const uint applyVertexColorGamma = 0;
 
 void main()
 {
+    const ShRasterizedDraw draw = rasterizedDraws[ gl_InstanceIndex ];
+
     if( applyVertexColorGamma != 0 )
     {
         outColor = vec4( pow( color.rgb, vec3( 2.2 ) ), color.a );
@@ -46,8 +61,18 @@ void main()
     {
         outColor = color;
     }
+    outColor *= unpackUintColor( draw.packedColor );
+
+    outTexCoord             = texCoord;
+    outTextureIndex         = draw.textureIndex;
+    outEmissiveTextureIndex = draw.emissiveTextureIndex;
+    outEmissiveMult         = draw.emissiveMult;
+    outNormalTextureIndex   = draw.normalTextureIndex;
+
+    const mat4 mvp = draw.transformIsViewProj != 0
+                         ? draw.transform
+                         : rasterizerVertInfo.viewProj * draw.transform;
 
-    outTexCoord = texCoord;
     outWorldPos = position;
-    gl_Position = rasterizerVertInfo.viewProj * vec4( position, 1.0 );
+    gl_Position = mvp * vec4( position, 1.0 );
 }
@@ -0,0 +1,72 @@
+// Copyright (c) 2021 Sultim Tsyrendashiev
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+// 
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+layout( location = 0 ) in vec3 position;
+layout( location = 1 ) in vec4 color;
+layout( location = 2 ) in vec2 texCoord;
+
+layout( location = 0 ) out vec4 outColor;
+layout( location = 1 ) out vec2 outTexCoord;
+layout( location = 2 ) flat out uint outTextureIndex;
+layout( location = 3 ) flat out uint outEmissiveTextureIndex;
+layout( location = 4 ) flat out float outEmissiveMult;
+
+#include "ShaderCommonGLSLFunc.h"
+
+layout( set     = DESC_SET_RASTERIZED_DRAWS,
+        binding = BINDING_RASTERIZED_DRAWS ) readonly buffer RasterizedDraws_BT
+{
+    ShRasterizedDraw rasterizedDraws[];
+};
+
+layout( push_constant ) uniform RasterizerVert_BT
+{
+    layout( offset = 0 ) mat4 viewProj;
+}
+rasterizerVertInfo;
+
+layout( constant_id = 0 ) const uint applyVertexColorGamma = 0;
+
+void main()
+{
+    // firstInstance of an indirect draw command is the index of its draw
+    const ShRasterizedDraw draw = rasterizedDraws[ gl_InstanceIndex ];
+
+    if( applyVertexColorGamma != 0 )
+    {
+        outColor = vec4( pow( color.rgb, vec3( 2.2 ) ), color.a );
+    }
+    else
+    {
+        outColor = color;
+    }
+    outColor *= unpackUintColor( draw.packedColor );
+
+    outTexCoord             = texCoord;
+    outTextureIndex         = draw.textureIndex;
+    outEmissiveTextureIndex = draw.emissiveTextureIndex;
+    outEmissiveMult         = draw.emissiveMult;
+
+    const mat4 mvp = draw.transformIsViewProj != 0
+                         ? draw.transform
+                         : rasterizerVertInfo.viewProj * draw.transform;
+
+    gl_Position = mvp * vec4( position, 1.0 );
+}
@@ -39,6 +39,14 @@ layout( set     = DESC_SET_LENS_FLARE_VERTEX_INSTANCES,
     ShLensFlareInstance lensFlareInstances[];
 };
 
+// all flares are in one draw, so instance is found by a vertex
+layout( set     = DESC_SET_LENS_FLARE_VERTEX_INSTANCES,
+        binding = BINDING_DRAW_LENS_FLARES_VERTEX_INSTANCES ) readonly buffer
+    LensFlareVertexInstances_BT
+{
+    uint lensFlareVertexInstances[];
+};
+
 layout( push_constant ) uniform RasterizerVert_BT
 {
     layout( offset = 0 ) mat4 viewProj;
@@ -62,7 +70,8 @@ vec4 baseColor( uint instPackedColor )
 
 void main()
 {
-    const ShLensFlareInstance inst = lensFlareInstances[ gl_InstanceIndex ];
+    const uint                instanceIndex = lensFlareVertexInstances[ gl_VertexIndex ];
+    const ShLensFlareInstance inst          = lensFlareInstances[ instanceIndex ];
 
     out_color                = baseColor( inst.packedColor );
     out_texCoord             = in_texCoord;
@@ -31,10 +31,13 @@ layout (location = 2) in vec2 texCoord;
 
 layout (location = 0) out vec4 outColor;
 layout (location = 1) out vec2 outTexCoord;
+layout (location = 2) flat out uint outTextureIndex;
 
 layout(push_constant) uniform RasterizerVert_BT 
 {
-    layout(offset = 0) mat4 model;
+    layout(offset = 0)  mat4 model;
+    layout(offset = 64) uint packedColor;
+    layout(offset = 68) uint textureIndex;
 } rasterizerVertInfo;
 
 layout (constant_id = 0) const uint applyVertexColorGamma = 0;
@@ -49,8 +52,10 @@ void main()
     {
         outColor = color;
     }
+    outColor *= unpackUintColor(rasterizerVertInfo.packedColor);
 
     outTexCoord = texCoord;
+    outTextureIndex = rasterizerVertInfo.textureIndex;
 
     const mat4 viewProj = globalUniform.viewProjCubemap[gl_ViewIndex];
     gl_Position = viewProj * rasterizerVertInfo.model * vec4(position, 1.0);
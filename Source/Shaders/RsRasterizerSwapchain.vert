@@ -0,0 +1,4 @@
+#version 460
+
+#define DESC_SET_RASTERIZED_DRAWS 1
+#include "RsRasterizer.inl"
@@ -22,21 +22,15 @@
 
 layout (location = 0) in vec4 vertColor;
 layout (location = 1) in vec2 vertTexCoord;
+layout (location = 2) flat in uint vertTextureIndex;
 
 layout (location = 0) out vec4 outColor;
 
 
 #define DESC_SET_TEXTURES 0
+#define TEXTURE_STREAMING_FEEDBACK_WRITEABLE
 #include "ShaderCommonGLSLFunc.h"
 
-layout(push_constant) uniform RasterizerFrag_BT 
-{
-    layout(offset = 64) uint packedColor;
-    layout(offset = 68) uint textureIndex;
-    layout(offset = 72) uint emissiveTextureIndex;
-    layout(offset = 76) uint emissiveMult;
-} rasterizerFragInfo;
-
 layout (constant_id = 0) const uint alphaTest = 0;
 
 #define ALPHA_THRESHOLD 0.5
@@ -44,10 +38,12 @@ layout (constant_id = 0) const uint alphaTest = 0;
 
 void main()
 {
-    vec4 albedoAlpha = getTextureSample(rasterizerFragInfo.textureIndex, vertTexCoord);
+    requestTextureResolution(vertTextureIndex, dFdx(vertTexCoord), dFdy(vertTexCoord));
+
+    vec4 albedoAlpha = getTextureSample(vertTextureIndex, vertTexCoord);
 
 
-    outColor = unpackUintColor( rasterizerFragInfo.packedColor ) * vertColor * albedoAlpha;
+    outColor = vertColor * albedoAlpha;
 
 
     if (alphaTest != 0)
@@ -22,21 +22,18 @@
 
 layout (location = 0) in vec4 vertColor;
 layout (location = 1) in vec2 vertTexCoord;
+layout (location = 2) flat in uint vertTextureIndex;
 
 layout (location = 0) out vec4 outColor;
 
 
 #define DESC_SET_TEXTURES 0
+#define TEXTURE_STREAMING_FEEDBACK_WRITEABLE
 #include "ShaderCommonGLSLFunc.h"
 
 layout(push_constant) uniform RasterizerFrag_BT 
 {
-    layout(offset = 64) uint packedColor;
-    layout(offset = 68) uint textureIndex;
-    layout(offset = 72) uint emissiveTextureIndex;
-    layout(offset = 76) float emissiveMult;
-    layout(offset = 80) uint normalTextureIndex;
-    layout(offset = 84) uint manualSrgb;
+    layout(offset = 64) uint manualSrgb;
 } rasterizerFragInfo;
 
 layout (constant_id = 0) const uint alphaTest = 0;
@@ -46,13 +43,15 @@ layout (constant_id = 0) const uint alphaTest = 0;
 
 void main()
 {
-    vec4 albedoAlpha = getTextureSample(rasterizerFragInfo.textureIndex, vertTexCoord);
+    requestTextureResolution(vertTextureIndex, dFdx(vertTexCoord), dFdy(vertTexCoord));
+
+    vec4 albedoAlpha = getTextureSample(vertTextureIndex, vertTexCoord);
 
 // SHIPPING_HACK begin: ktx2 alpha can be slightly less than actual 1.0
     albedoAlpha.a = min( 1.0, albedoAlpha.a * 1.01 );
 // SHIPPING_HACK end
 
-    outColor = unpackUintColor( rasterizerFragInfo.packedColor ) * vertColor * albedoAlpha;
+    outColor = vertColor * albedoAlpha;
 
 
     if (alphaTest != 0)
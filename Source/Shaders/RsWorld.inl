@@ -20,6 +20,9 @@
 
 layout( location = 0 ) in vec4 vertColor;
 layout( location = 1 ) in vec2 vertTexCoord;
+layout( location = 2 ) flat in uint vertTextureIndex;
+layout( location = 3 ) flat in uint vertEmissiveTextureIndex;
+layout( location = 4 ) flat in float vertEmissiveMult;
 
 layout( location = 0 ) out vec4 outColor;
 #if !RS_WORLD_INL_CLASSIC
@@ -31,19 +34,11 @@ layout( location = 2 ) out float outReactivity;
 #define DESC_SET_GLOBAL_UNIFORM 1
 #define DESC_SET_TONEMAPPING    2
 #define DESC_SET_VOLUMETRIC     3
+#define TEXTURE_STREAMING_FEEDBACK_WRITEABLE
 #include "ShaderCommonGLSLFunc.h"
 #include "Exposure.h"
 #include "Volumetric.h"
 
-layout( push_constant ) uniform RasterizerFrag_BT
-{
-    layout( offset = 64 ) uint  packedColor;
-    layout( offset = 68 ) uint  textureIndex;
-    layout( offset = 72 ) uint  emissiveTextureIndex;
-    layout( offset = 76 ) float emissiveMult;
-}
-rasterizerFragInfo;
-
 layout( constant_id = 0 ) const uint alphaTest       = 0;
 layout( constant_id = 1 ) const uint isSkyVisibility = 0;
 
@@ -51,7 +46,7 @@ layout( constant_id = 1 ) const uint isSkyVisibility = 0;
 
 vec4 baseColor()
 {
-    return vertColor * unpackUintColor( rasterizerFragInfo.packedColor );
+    return vertColor;
 }
 
 void main()
@@ -64,7 +59,12 @@ void main()
     }
 #endif
 
-    vec4 ldrColor = baseColor() * getTextureSample( rasterizerFragInfo.textureIndex, vertTexCoord );
+    // rasterized-only textures get no feedback from the ray traced passes
+    requestTextureResolution( vertTextureIndex, dFdx( vertTexCoord ), dFdy( vertTexCoord ) );
+    requestTextureResolution(
+        vertEmissiveTextureIndex, dFdx( vertTexCoord ), dFdy( vertTexCoord ) );
+
+    vec4 ldrColor = baseColor() * getTextureSample( vertTextureIndex, vertTexCoord );
     outColor      = ldrColor;
 
 #if !RS_WORLD_INL_CLASSIC
@@ -76,15 +76,12 @@ void main()
 #if ILLUMINATION_VOLUME
         if( globalUniform.illumVolumeEnable != 0 )
         {
-            vec4 ndc = vec4( gl_FragCoord.xyz, 1.0 );
-            ndc.xy /= vec2( globalUniform.renderWidth, globalUniform.renderHeight );
-            ndc.xy = ndc.xy * 2.0 - 1.0;
-
-            vec4 worldpos = globalUniform.invView * globalUniform.invProjection * ndc;
-            worldpos.xyz /= worldpos.w;
+            vec3 worldpos = getWorldPosFromScreen(
+                gl_FragCoord.xy / vec2( globalUniform.renderWidth, globalUniform.renderHeight ),
+                gl_FragCoord.z );
 
             vec3 sp = volume_toSamplePosition_T(
-                worldpos.xyz, globalUniform.volumeViewProj, globalUniform.cameraPosition.xyz );
+                worldpos, globalUniform.volumeViewProj, globalUniform.cameraPosition.xyz );
             vec3 illum = textureLod( g_illuminationVolume_Sampler, sp, 0.0 ).rgb;
 
             outColor.rgb *= illum;
@@ -99,16 +96,16 @@ void main()
 
     {
         vec3 ldrEmis;
-        if( rasterizerFragInfo.emissiveTextureIndex != MATERIAL_NO_TEXTURE )
+        if( vertEmissiveTextureIndex != MATERIAL_NO_TEXTURE )
         {
             ldrEmis = baseColor().rgb *
-                      getTextureSample( rasterizerFragInfo.emissiveTextureIndex, vertTexCoord ).rgb;
+                      getTextureSample( vertEmissiveTextureIndex, vertTexCoord ).rgb;
         }
         else
         {
             ldrEmis = ldrColor.rgb;
         }
-        ldrEmis *= rasterizerFragInfo.emissiveMult;
+        ldrEmis *= vertEmissiveMult;
 
 #if RS_WORLD_INL_CLASSIC
         outColor.rgb += ldrEmis * ldrColor.a * globalUniform.emissionMaxScreenColor;
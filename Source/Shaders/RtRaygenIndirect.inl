@@ -45,6 +45,7 @@ layout (constant_id = 1) const uint lightmapLayerIndex = 3;
 #define LIGHT_SAMPLE_METHOD (LIGHT_SAMPLE_METHOD_INDIR)
 #include "RaygenCommon.h"
 #include "ReservoirIndirect.h"
+#include "IrradianceCache.h"
 
 #else // RT_FORCE_COMPUTE
 
@@ -84,32 +85,30 @@ vec3 getSpecularBounce(const uint seed, uint bounceIndex,
                        const vec3 v, 
                        out float oneOverSourcePdf)
 {
-#if OPTIMIZE_MEM
-    const vec2 u = rnd8_4( seed, RANDOM_SALT_SPEC_BOUNCE( bounceIndex ) ).xy;
-#else
-    const vec2 u = rndBlueNoise16_2( seed, RANDOM_SALT_SPEC_BOUNCE( bounceIndex ) );
-#endif
+    const vec2 u = rndSample2( seed, RANDOM_SALT_SPEC_BOUNCE( bounceIndex ) );
     return sampleSmithGGX( n, v, roughness, u[ 0 ], u[ 1 ], oneOverSourcePdf );
 }
 
 // n -- surface normal
 vec3 getDiffuseBounce(const uint seed, uint bounceIndex, const vec3 n, out float oneOverSourcePdf)
 {
-#if OPTIMIZE_MEM
-    const vec2 u = rnd8_4( seed, RANDOM_SALT_DIFF_BOUNCE( bounceIndex ) ).xy;
-#else
-    const vec2 u = rndBlueNoise16_2( seed, RANDOM_SALT_DIFF_BOUNCE( bounceIndex ) );
-#endif
+    const vec2 u = rndSample2( seed, RANDOM_SALT_DIFF_BOUNCE( bounceIndex ) );
     return sampleLambertian( n, u[ 0 ], u[ 1 ], oneOverSourcePdf );
 }
 
 #ifndef RT_FORCE_COMPUTE
 
+// with adaptive sampling, the lowest probabilities to trace a ray in converged regions
+#define INDIR_MIN_SURVIVAL 0.25
+#define INDIR_SECOND_BOUNCE_MIN_SURVIVAL 0.5
+
 #define FIRST_BOUNCE_MIP_BIAS 0
 #define SECOND_BOUNCE_MIP_BIAS 32
 
+// skipSampledEmission -- if emission of a hit was already accounted by the direct illumination
 Surface traceBounce(const vec3 originPosition, float originRoughness, uint originInstCustomIndex,
-                    const vec3 bounceDir, float bounceMipBias, out vec3 out_emission)
+                    const vec3 bounceDir, float bounceMipBias, bool skipSampledEmission,
+                    out vec3 out_emission)
 {
     const ShPayload p = traceIndirectRay(originInstCustomIndex, originPosition, bounceDir); 
 
@@ -120,9 +119,15 @@ Surface traceBounce(const vec3 originPosition, float originRoughness, uint origi
         return s;
     }
 
-    return hitInfoToSurface_Indirect(
-        getHitInfoBounce(p, originPosition, originRoughness, bounceMipBias, out_emission), 
-        bounceDir);
+    const ShHitInfo h =
+        getHitInfoBounce(p, originPosition, originRoughness, bounceMipBias, out_emission);
+
+    if (skipSampledEmission && (h.geometryInstanceFlags & GEOM_INST_FLAG_EMISSIVE_SAMPLED) != 0)
+    {
+        out_emission = vec3(0);
+    }
+
+    return hitInfoToSurface_Indirect(h, bounceDir);
 }
 
 vec3 processSecondDiffuseBounce(const uint seed, const Surface surf, const vec3 bounceDir, float oneOverPdf)
@@ -133,21 +138,32 @@ vec3 processSecondDiffuseBounce(const uint seed, const Surface surf, const vec3
                                         surf.instCustomIndex,
                                         bounceDir,
                                         SECOND_BOUNCE_MIP_BIAS,
+                                        false,
                                         emis);
     emis *= globalUniform.emissionMapBoost;
 
     if (hitSurf.isSky)
     {
-        return getSky(bounceDir) * oneOverPdf;
+        // diffuse bounce, so the roughest prefiltered sky
+        return getSky(bounceDir, 1.0) * oneOverPdf;
     }
 
-    // calculate direct illumination in a hit position
-    const vec3 diffuse = processDirectIllumination(seed, hitSurf, 2);
+    vec3 diffuse;
+    // terminate into the cache, it already contains the further bounces
+    if( !irc_IsEnabled() || !irc_Find( hitSurf.position, hitSurf.normal, diffuse ) )
+    {
+        // calculate direct illumination in a hit position
+        diffuse = processDirectIllumination(seed, hitSurf, 2);
+    }
 
     return (emis + diffuse) * hitSurf.albedo * oneOverPdf;
 }
 
-SampleIndirect processIndirect( const uint seed, const Surface surf, out float oneOverSourcePdf )
+// budget -- see getSampleBudget
+SampleIndirect processIndirect( const uint    seed,
+                                const Surface surf,
+                                float         budget,
+                                out float     oneOverSourcePdf )
 {
     vec3 bounceDir;
 
@@ -180,6 +196,7 @@ SampleIndirect processIndirect( const uint seed, const Surface surf, out float o
                                         surf.instCustomIndex, 
                                         bounceDir, 
                                         FIRST_BOUNCE_MIP_BIAS,
+                                        useDiffuse(surf.roughness),
                                         emis);
     emis *= globalUniform.emissionMapBoost;
 
@@ -188,15 +205,39 @@ SampleIndirect processIndirect( const uint seed, const Surface surf, out float o
         SampleIndirect s = createSampleIndirect( //
             surf.position + bounceDir * MAX_RAY_LENGTH,
             -bounceDir,
-            getSky( bounceDir ) );
+            getSky( bounceDir, useDiffuse( surf.roughness ) ? 1.0 : surf.roughness ) );
         return s;
     }
 
+    if( irc_IsEnabled() )
+    {
+        // distant hits terminate into the cache, except a budgeted fraction
+        // that is traced fully to keep the cache updated
+        const bool update = rnd16_2( seed, RANDOM_SALT_IRRADIANCE_CACHE ).x <
+                            globalUniform.irradianceCacheUpdateRate;
+        const bool distant =
+            length( hitSurf.position - surf.position ) > 2.0 * irc_GetCellSize( hitSurf.position );
+
+        vec3 cached;
+        if( !update && distant && irc_Find( hitSurf.position, hitSurf.normal, cached ) )
+        {
+            SampleIndirect s = createSampleIndirect( //
+                hitSurf.position,
+                hitSurf.normal,
+                ( emis + cached ) * hitSurf.albedo );
+            return s;
+        }
+    }
+
     // calculate direct diffuse illumination in a hit position
     vec3 diffuse = processDirectIllumination(seed, hitSurf, 1);
 
+    // russian roulette for the second bounce, if the pixel is converged
+    const float survival_Second = mix( INDIR_SECOND_BOUNCE_MIN_SURVIVAL, 1.0, budget );
+
     // TODO: investigate why uncommenting this makes diffuse very red
     // if( globalUniform.indirSecondBounce != 0 )
+    if( rnd16_2( seed, RANDOM_SALT_ADAPTIVE_SAMPLING ).y < survival_Second )
     {
         float oneOverPdf_Second;
         const vec3 bounceDir_Second = getDiffuseBounce(seed, 2, hitSurf.normal, oneOverPdf_Second);
@@ -204,7 +245,12 @@ SampleIndirect processIndirect( const uint seed, const Surface surf, out float o
         diffuse += processSecondDiffuseBounce(seed, 
                                               hitSurf,
                                               bounceDir_Second,
-                                              oneOverPdf_Second);
+                                              oneOverPdf_Second / survival_Second);
+    }
+
+    if( irc_IsEnabled() )
+    {
+        irc_Accumulate( hitSurf.position, hitSurf.normal, diffuse );
     }
 
     SampleIndirect s = createSampleIndirect( //
@@ -256,12 +302,46 @@ bool testSurfaceForReuseIndirect(
         (dot(curNormal, otherNormal) > NormalThreshold);
 }
 
+// If indirStride > 1, indirect illumination is traced only for one pixel
+// in each block of indirStride x indirStride, and that pixel changes every frame.
+// If indirCheckerboard, blocks are 2x1, and the traced pixels form a checkerboard
+// that is inverted every frame
+ivec2 getIndirectBlock( const ivec2 pix )
+{
+    if( globalUniform.indirCheckerboard != 0 )
+    {
+        return ivec2( pix.x / 2, pix.y );
+    }
+    return pix / int( max( globalUniform.indirStride, 1u ) );
+}
+
+ivec2 getIndirectTracedPix( const ivec2 block )
+{
+    if( globalUniform.indirCheckerboard != 0 )
+    {
+        const int parity = int( ( uint( block.y ) + globalUniform.indirTraceOffset ) % 2 );
+        return ivec2( block.x * 2 + parity, block.y );
+    }
+
+    const uint stride = max( globalUniform.indirStride, 1u );
+    if( stride == 1 )
+    {
+        return block;
+    }
+
+    // shift per block, to not form a regular pattern on a screen
+    const uvec2 shift  = murmurHash33( uvec3( block.x, block.y, 0 ) ).xy;
+    const uvec2 offset = uvec2( globalUniform.indirTraceOffset % stride,
+                                globalUniform.indirTraceOffset / stride );
+
+    return block * int( stride ) + ivec2( ( offset + shift ) % stride );
+}
+
 
 
 #define TEMPORAL_SAMPLES_INDIR    1
 #define TEMPORAL_RADIUS_INDIR_MAX 8.0
 
-#define SPATIAL_SAMPLES_INDIR 2
 #define SPATIAL_RADIUS_INDIR  mix( 2.0, 8.0, clamp( globalUniform.renderHeight / 1080.0, 0.0, 1.0 ) ) 
 
 #define DEBUG_TRACE_BIAS_CORRECT_RAY 0
@@ -271,7 +351,15 @@ bool testSurfaceForReuseIndirect(
 #ifdef RT_RAYGEN_INDIRECT_INIT
 void main()
 {
-    const ivec2 pix = ivec2(gl_LaunchIDEXT.xy);
+    // one launch per block
+    const ivec2 pix = getIndirectTracedPix(ivec2(gl_LaunchIDEXT.xy));
+    if (pix.x >= int(globalUniform.renderWidth) || pix.y >= int(globalUniform.renderHeight))
+    {
+        return;
+    }
+
+    rayCostSetPix(pix);
+
     const uint seed = getRandomSeed(pix, globalUniform.frameId);
     uint salt = RANDOM_SALT_RESAMPLE_INDIRECT_BASE;
 
@@ -284,10 +372,23 @@ void main()
         return;
     }
 
+    const float budget = getSampleBudget( getPrevScreenPos( framebufMotion_Sampler, pix ),
+                                          texelFetch( framebufDepthWorld_Sampler, pix, 0 ).r,
+                                          texelFetch( framebufMotion_Sampler, pix, 0 ).z );
+
+    // russian roulette: in converged regions, trace only a fraction of the rays,
+    // the survived ones are weighted up to stay unbiased
+    const float survival = mix( INDIR_MIN_SURVIVAL, 1.0, budget );
+    if( rnd16_2( seed, RANDOM_SALT_ADAPTIVE_SAMPLING ).x >= survival )
+    {
+        restirIndirect_StoreInitialSample( pix, emptySampleIndirect(), 0.0 );
+        return;
+    }
+
     float          oneOverSourcePdf;
-    SampleIndirect initial = processIndirect( seed, surf, oneOverSourcePdf );
+    SampleIndirect initial = processIndirect( seed, surf, budget, oneOverSourcePdf );
 
-    restirIndirect_StoreInitialSample( pix, initial, oneOverSourcePdf );
+    restirIndirect_StoreInitialSample( pix, initial, oneOverSourcePdf / survival );
 }
 #endif // RT_RAYGEN_INDIRECT_INIT
 
@@ -305,6 +406,92 @@ ReservoirIndirect loadInitialSampleAsReservoir( const ivec2 pix )
     return r;
 }
 
+// Jacobian of reconnecting the sample of a pixel q to a surface point x1_r
+float getOneOverJacobianIndirect( const vec3 x1_r, const ivec2 pix_q, const SampleIndirect s_q )
+{
+    const vec3 x1_q = texelFetch( framebufSurfacePosition_Sampler, pix_q, 0 ).xyz;
+
+    const vec3 x2_q = unpackSampleIndirectPosition( s_q );
+    const vec3 n2_q = decodeNormal( s_q.normalPacked );
+
+    const DirectionAndLength phi_r = calcDirectionAndLengthSafe( x2_q, x1_r );
+    const DirectionAndLength phi_q = calcDirectionAndLengthSafe( x2_q, x1_q );
+
+    float oneOverJacobian =
+        safePositiveRcp( getGeometryFactorClamped( n2_q, phi_r.dir, phi_r.len ) ) *
+        getGeometryFactorClamped( n2_q, phi_q.dir, phi_q.len );
+
+#if SHIPPING_HACK
+    oneOverJacobian = clamp( oneOverJacobian, 0.0, 1.0 );
+#endif
+    return oneOverJacobian;
+}
+
+// If the pixel wasn't traced, take the initial sample of a traced pixel
+// from the neighboring blocks, which surface is the most similar
+ReservoirIndirect loadInitialSampleAsReservoir_Upsampled( const ivec2   pix,
+                                                          const Surface surf,
+                                                          const ivec3   chRenderArea,
+                                                          float         depthCur )
+{
+    const ivec2 block = getIndirectBlock( pix );
+
+    if( getIndirectTracedPix( block ) == pix )
+    {
+        return loadInitialSampleAsReservoir( pix );
+    }
+
+    ivec2 best      = ivec2( -1 );
+    float bestScore = -1.0;
+
+    for( int dy = -1; dy <= 1; dy++ )
+    {
+        for( int dx = -1; dx <= 1; dx++ )
+        {
+            const ivec2 q = getIndirectTracedPix( block + ivec2( dx, dy ) );
+
+            if( isSkyPix( q ) )
+            {
+                continue;
+            }
+
+            const float depthOther  = texelFetch( framebufDepthWorld_Sampler, q, 0 ).r;
+            const vec3  normalOther = texelFetchNormal( q );
+
+            if( !testSurfaceForReuseIndirect(
+                    chRenderArea, q, depthCur, depthOther, surf.normal, normalOther ) )
+            {
+                continue;
+            }
+
+            // prefer same orientation, then same depth, then the closest on a screen
+            const float score = dot( surf.normal, normalOther ) -
+                                10.0 * abs( depthCur - depthOther ) / abs( depthCur ) -
+                                0.01 * length( vec2( q - pix ) );
+            if( score > bestScore )
+            {
+                best      = q;
+                bestScore = score;
+            }
+        }
+    }
+
+    ReservoirIndirect r = emptyReservoirIndirect();
+
+    if( best.x >= 0 )
+    {
+        const ReservoirIndirect reservoir_q = loadInitialSampleAsReservoir( best );
+
+        const float targetPdf_curSurf =
+            targetPdfForIndirectSample( reservoir_q.selected ) *
+            getOneOverJacobianIndirect( surf.position, best, reservoir_q.selected );
+
+        updateCombinedReservoirIndirect_newSurf( r, reservoir_q, targetPdf_curSurf, 0.0 );
+    }
+
+    return r;
+}
+
 void main()
 {
 #ifndef RT_FORCE_COMPUTE
@@ -326,18 +513,18 @@ void main()
     }
 
 
-    ReservoirIndirect combined = loadInitialSampleAsReservoir( pix );
-
-
     // assuming that pix is checkerboarded
-    const ivec3 chRenderArea = getCheckerboardedRenderArea( pix );
+    const ivec3 chRenderArea      = getCheckerboardedRenderArea( pix );
+    const ivec3 chRenderAreaPrev  = getCheckerboardedRenderArea_Prev( pix );
     const float motionZ           = texelFetch( framebufMotion_Sampler, pix, 0 ).z;
     const float depthCur          = texelFetch( framebufDepthWorld_Sampler, pix, 0 ).r;
     const vec2  posPrev           = getPrevScreenPos( framebufMotion_Sampler, pix );
 
-    int spatialSamplesCount = int( SPATIAL_SAMPLES_INDIR * getDiffuseWeight( surf.roughness ) );
 
+    ReservoirIndirect combined =
+        loadInitialSampleAsReservoir_Upsampled( pix, surf, chRenderArea, depthCur );
 
+    bool temporalFound = false;
     for( int pixIndex = 0; pixIndex < TEMPORAL_SAMPLES_INDIR; pixIndex++ )
     {
         // TODO: need low discrepancy noise
@@ -361,7 +548,7 @@ void main()
             const vec3  normalPrev = texelFetchNormal_Prev( pp );
 
             if( !testSurfaceForReuseIndirect(
-                    chRenderArea, pp, depthCur, depthPrev - motionZ, surf.normal, normalPrev ) )
+                    chRenderAreaPrev, pp, depthCur, depthPrev - motionZ, surf.normal, normalPrev ) )
             {
                 continue;
             }
@@ -384,9 +571,17 @@ void main()
         float rnd = rnd16( seed, salt++ );
         updateCombinedReservoirIndirect( combined, temporal, rnd );
 
+        temporalFound = true;
         break;
     }
 
+    // less spatial reuse in converged regions, full -- if there's no history
+    const int spatialSamplesCount =
+        int( getBudgetedCount( temporalFound ? getSampleBudget( posPrev, depthCur, motionZ ) : 1.0,
+                               globalUniform.restirIndirectSpatialMin,
+                               globalUniform.restirIndirectSpatialMax ) *
+             getDiffuseWeight( surf.roughness ) );
+
 
 
     {
@@ -403,6 +598,9 @@ void main()
                 vec2 rndOffset = rndBlueNoise16_2( seed, salt++ ) * 2.0 - 1.0;
 #endif
                 pp = pix + ivec2( rndOffset * SPATIAL_RADIUS_INDIR );
+
+                // only traced pixels have initial samples
+                pp = getIndirectTracedPix( getIndirectBlock( pp ) );
             }
 
             {
@@ -423,25 +621,8 @@ void main()
 
             ReservoirIndirect reservoir_q = loadInitialSampleAsReservoir( pp );
 
-            float oneOverJacobian;
-            {
-                const vec3 x1_r = surf.position;
-                const vec3 x1_q = texelFetch( framebufSurfacePosition_Sampler, pp, 0 ).xyz;
-
-                const vec3 x2_q = unpackSampleIndirectPosition( reservoir_q.selected );
-                const vec3 n2_q = decodeNormal( reservoir_q.selected.normalPacked );
-
-                const DirectionAndLength phi_r = calcDirectionAndLengthSafe( x2_q, x1_r );
-                const DirectionAndLength phi_q = calcDirectionAndLengthSafe( x2_q, x1_q );
-
-                oneOverJacobian =
-                    safePositiveRcp( getGeometryFactorClamped( n2_q, phi_r.dir, phi_r.len ) ) *
-                    getGeometryFactorClamped( n2_q, phi_q.dir, phi_q.len );
-
-    #if SHIPPING_HACK
-                oneOverJacobian = clamp( oneOverJacobian, 0.0, 1.0 );
-    #endif
-            }
+            const float oneOverJacobian =
+                getOneOverJacobianIndirect( surf.position, pp, reservoir_q.selected );
 
             float targetPdf_curSurf = 0.0;
 
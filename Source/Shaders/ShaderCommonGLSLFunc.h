@@ -31,7 +31,9 @@
 // * DESC_SET_VERTEX_DATA       -- to access geometry data;
 //                                 DESC_SET_GLOBAL_UNIFORM must be defined; 
 //                                 Define VERTEX_BUFFER_WRITEABLE for writing
-// * DESC_SET_TEXTURES          -- to access textures by index
+// * DESC_SET_TEXTURES          -- to access textures by index;
+//                                 define TEXTURE_STREAMING_FEEDBACK_WRITEABLE
+//                                 for requesting texture resolutions
 // * DESC_SET_FRAMEBUFFERS      -- to access framebuffers (defined in ShaderCommonGLSL.h)
 // * DESC_SET_RANDOM            -- to access blue noise (uniform distribution) and sampling points on surfaces
 // * DESC_SET_TONEMAPPING       -- to access histogram and average luminance;
@@ -66,31 +68,99 @@ layout(
 layout(
     set = DESC_SET_TEXTURES,
     binding = BINDING_TEXTURES)
-    uniform sampler2D globalTextures[];
+    uniform texture2D globalTextures[];
+
+// samplers are separate from the images, so changing
+// a sampler (e.g. LOD bias) doesn't rewrite image descriptors
+layout(
+    set = DESC_SET_TEXTURES,
+    binding = BINDING_TEXTURE_SAMPLERS)
+    uniform sampler globalTextureSamplers[TEXTURE_SAMPLER_TABLE_SIZE];
+
+layout(
+    set = DESC_SET_TEXTURES,
+    binding = BINDING_TEXTURE_SAMPLER_INDICES)
+    readonly buffer TextureSamplerIndices_BT
+{
+    // index in globalTextureSamplers for each texture
+    uint textureSamplerIndices[];
+};
+
+#define globalTexture(textureIndex) \
+    sampler2D(globalTextures[nonuniformEXT(textureIndex)], \
+              globalTextureSamplers[nonuniformEXT(textureSamplerIndices[textureIndex])])
 
 ivec2 getTextureSize(uint textureIndex)
 {
-    return textureSize(globalTextures[nonuniformEXT(textureIndex)], 0);
+    return textureSize(globalTexture(textureIndex), 0);
 }
 
 vec4 getTextureSample(uint textureIndex, const vec2 texCoord)
 {
-    return texture(globalTextures[nonuniformEXT(textureIndex)], texCoord);
+    return texture(globalTexture(textureIndex), texCoord);
 }
 
 vec4 getTextureSampleLod(uint textureIndex, const vec2 texCoord, float lod)
 {
-    return textureLod(globalTextures[nonuniformEXT(textureIndex)], texCoord, lod);
+    return textureLod(globalTexture(textureIndex), texCoord, lod);
 }
 
 vec4 getTextureSampleGrad(uint textureIndex, const vec2 texCoord, const vec2 dPdx, const vec2 dPdy)
 {
-    return textureGrad(globalTextures[nonuniformEXT(textureIndex)], texCoord, dPdx, dPdy);
+    return textureGrad(globalTexture(textureIndex), texCoord, dPdx, dPdy);
+}
+
+#ifdef TEXTURE_STREAMING_FEEDBACK_WRITEABLE
+layout(
+    set = DESC_SET_TEXTURES,
+    binding = BINDING_TEXTURE_STREAMING_FEEDBACK)
+    buffer TextureStreamingFeedback_BT
+{
+    // max resolution (in texels) that was requested for each texture
+    uint textureStreamingFeedback[];
+};
+
+// Without DESC_SET_GLOBAL_UNIFORM, requests are written even if streaming is disabled:
+// then the buffer is just not read
+void requestTextureResolution( uint textureIndex, const vec2 dPdx, const vec2 dPdy )
+{
+#ifdef DESC_SET_GLOBAL_UNIFORM
+    if( globalUniform.textureStreamingEnable == 0 )
+    {
+        return;
+    }
+#endif
+    if( textureIndex == MATERIAL_NO_TEXTURE )
+    {
+        return;
+    }
+
+    const float footprint = max( max( length( dPdx ), length( dPdy ) ), 1.0 / 65536.0 );
+    const uint  requested = uint( 1.0 / footprint );
+
+    // most of the pixels request the same, so check before an atomic
+    if( textureStreamingFeedback[ textureIndex ] < requested )
+    {
+        atomicMax( textureStreamingFeedback[ textureIndex ], requested );
+    }
 }
+
+void requestTextureResolution( uint textureIndex, float uDeriv )
+{
+    requestTextureResolution( textureIndex, vec2( uDeriv, 0 ), vec2( 0, uDeriv ) );
+}
+#endif // TEXTURE_STREAMING_FEEDBACK_WRITEABLE
 #endif // DESC_SET_TEXTURES
 
 
 
+// Index in geometry infos. A multi-geometry BLAS (static cluster) is followed by
+// inactive TLAS instances, to reserve the indices for all its geometries
+int getGeometryInstanceIndex(int instanceID, int localGeometryIndex)
+{
+    return instanceID + localGeometryIndex;
+}
+
 uint packInstanceIdAndCustomIndex(int instanceID, int instanceCustomIndexEXT)
 {
     return uint(instanceID << 4) | uint(instanceCustomIndexEXT & 0xF);
@@ -121,6 +191,26 @@ void unpackGeometryAndPrimitiveIndex(uint geomAndPrimIndex, out int geometryInde
     geometryIndex = 0;
 }
 
+// x - traced rays, y - any-hit invocations, z - translucent layers
+uint packRayCost( uvec3 c )
+{
+    const uvec3 maxv = ( uvec3( 1 ) << uvec3( RAY_COST_RAYS_BITS,
+                                              RAY_COST_ANY_HITS_BITS,
+                                              RAY_COST_LAYERS_BITS ) ) - 1;
+    c = min( c, maxv );
+    return c.x | ( c.y << RAY_COST_RAYS_BITS ) |
+           ( c.z << ( RAY_COST_RAYS_BITS + RAY_COST_ANY_HITS_BITS ) );
+}
+
+uvec3 unpackRayCost( uint packed )
+{
+    return uvec3( bitfieldExtract( packed, 0, RAY_COST_RAYS_BITS ),
+                  bitfieldExtract( packed, RAY_COST_RAYS_BITS, RAY_COST_ANY_HITS_BITS ),
+                  bitfieldExtract( packed,
+                                   RAY_COST_RAYS_BITS + RAY_COST_ANY_HITS_BITS,
+                                   RAY_COST_LAYERS_BITS ) );
+}
+
 vec3 transformBy( const ShGeometryInstance inst, const vec4 v )
 {
     // clang-format off
@@ -133,7 +223,7 @@ vec3 transformBy( const ShGeometryInstance inst, const vec4 v )
     // clang-format on
 }
 
-vec3 transformBy_prev( const ShGeometryInstance inst, const vec4 v )
+vec3 transformBy_prev( const ShGeometryInstancePrev inst, const vec4 v )
 {
     // clang-format off
     return mat4x3(
@@ -189,6 +279,16 @@ layout(set = DESC_SET_LIGHT_SOURCES, binding = BINDING_LIGHT_SOURCES_INDEX_CUR_T
     uint lightSources_Index_CurToPrev[];
 };
 
+layout(set = DESC_SET_LIGHT_SOURCES, binding = BINDING_LIGHT_TREE) readonly buffer LightTree_BT
+{
+    ShLightTreeNode lightTree[];
+};
+
+layout(set = DESC_SET_LIGHT_SOURCES, binding = BINDING_LIGHTSTYLES) readonly buffer Lightstyles_BT
+{
+    float lightstyleValues[];
+};
+
 #if LIGHT_GRID_ENABLED
 layout(set = DESC_SET_LIGHT_SOURCES, binding = BINDING_INITIAL_LIGHTS_GRID) 
 #ifndef LIGHT_GRID_WRITE
@@ -211,12 +311,17 @@ layout(set = DESC_SET_LIGHT_SOURCES, binding = BINDING_INITIAL_LIGHTS_GRID_PREV)
 #ifdef DESC_SET_RESTIR_INDIRECT
 layout(set = DESC_SET_RESTIR_INDIRECT, binding = BINDING_RESTIR_INDIRECT_RESERVOIRS) buffer RestirIndirectReservoirs_BT
 {
-    uint g_restirIndirectReservoirs[];
+    uvec4 g_restirIndirectReservoirs[];
 };
 
 layout(set = DESC_SET_RESTIR_INDIRECT, binding = BINDING_RESTIR_INDIRECT_RESERVOIRS_PREV) buffer RestirIndirectReservoirs_Prev_BT
 {
-    uint g_restirIndirectReservoirs_Prev[];
+    uvec4 g_restirIndirectReservoirs_Prev[];
+};
+
+layout(set = DESC_SET_RESTIR_INDIRECT, binding = BINDING_RESTIR_INDIRECT_IRRADIANCE_CACHE) buffer IrradianceCache_BT
+{
+    ShIrradianceCacheCell g_irradianceCache[];
 };
 #endif
 
@@ -232,6 +337,13 @@ uniform sampler3D g_volumetric_Sampler;
 layout(set = DESC_SET_VOLUMETRIC, binding = BINDING_VOLUMETRIC_SAMPLER_PREV) 
 uniform sampler3D g_volumetric_Sampler_Prev;
 
+// per-froxel scattering, before accumulation along the view ray
+layout(set = DESC_SET_VOLUMETRIC, binding = BINDING_VOLUMETRIC_RAW_STORAGE, rgba16f) 
+uniform image3D g_volumetricRaw;
+
+layout(set = DESC_SET_VOLUMETRIC, binding = BINDING_VOLUMETRIC_RAW_SAMPLER_PREV) 
+uniform sampler3D g_volumetricRaw_Sampler_Prev;
+
 #if ILLUMINATION_VOLUME
 layout(set = DESC_SET_VOLUMETRIC, binding = BINDING_VOLUMETRIC_ILLUMINATION, r11f_g11f_b10f) 
 uniform image3D g_illuminationVolume;
@@ -249,10 +361,25 @@ layout(set = DESC_SET_LENS_FLARES, binding = BINDING_LENS_FLARES_CULLING_INPUT)
     ShIndirectDrawCommand lensFlareCullingInput[];
 };
 
+// all visible flares are drawn with one VkDrawIndexedIndirectCommand
 layout(set = DESC_SET_LENS_FLARES, binding = BINDING_LENS_FLARES_DRAW_CMDS) buffer LensFlareDrawCmds_BT
 {
-    ShIndirectDrawCommand lensFlareDrawCmds[LENS_FLARES_MAX_DRAW_CMD_COUNT];
-    uint lensFlareDrawCmdsCount;
+    uint lensFlareDrawIndexCount;
+    uint lensFlareDrawInstanceCount;
+    uint lensFlareDrawFirstIndex;
+    int  lensFlareDrawVertexOffset;
+    uint lensFlareDrawFirstInstance;
+};
+
+layout(set = DESC_SET_LENS_FLARES, binding = BINDING_LENS_FLARES_SOURCE_INDICES) readonly buffer LensFlareSourceIndices_BT
+{
+    uint lensFlareSourceIndices[];
+};
+
+// indices of visible flares, with 'vertexOffset' already applied
+layout(set = DESC_SET_LENS_FLARES, binding = BINDING_LENS_FLARES_VISIBLE_INDICES) writeonly buffer LensFlareVisibleIndices_BT
+{
+    uint lensFlareVisibleIndices[];
 };
 #endif // DESC_SET_LENS_FLARES
 
@@ -262,12 +389,19 @@ layout(set = DESC_SET_LENS_FLARES, binding = BINDING_LENS_FLARES_DRAW_CMDS) buff
 
 #ifdef DESC_SET_GLOBAL_UNIFORM
 #ifdef DESC_SET_FRAMEBUFFERS
+// With dynamic resolution, the previous frame might have been rendered into a subregion
+// of another size, so the position is in the previous frame's checkerboarded layout
 vec2 getPrevScreenPos(const vec2 motionCurToPrev, const ivec2 pix)
 {
     const vec2 screenSize = vec2(globalUniform.renderWidth / float(CHECKERBOARD_SEPARATOR_DIVISOR), globalUniform.renderHeight);
+    const vec2 screenSizePrev = vec2(globalUniform.renderWidthPrev / float(CHECKERBOARD_SEPARATOR_DIVISOR), globalUniform.renderHeightPrev);
     const vec2 invScreenSize = vec2(1.0 / screenSize.x, 1.0 / screenSize.y);
-   
-    return ((vec2(pix) + vec2(0.5)) * invScreenSize + motionCurToPrev) * screenSize;
+
+    // checkerboard half, to keep the reprojected position in the same one
+    const vec2 halfOffset = vec2(float(pix.x >= int(screenSize.x)), 0.0);
+
+    const vec2 uvPrev = (vec2(pix) + vec2(0.5)) * invScreenSize - halfOffset + motionCurToPrev;
+    return (uvPrev + halfOffset) * screenSizePrev;
 }
 
 vec2 getPrevScreenPos(sampler2D motionSampler, const ivec2 pix)
@@ -275,6 +409,40 @@ vec2 getPrevScreenPos(sampler2D motionSampler, const ivec2 pix)
     return getPrevScreenPos(texelFetch(motionSampler, pix, 0).rg, pix);
 }
 
+// Fraction of the max sample count that should be spent on a pixel,
+// calculated by CmSampleBudget.comp in the previous frame.
+// Full budget, if adaptive sampling is disabled or the surface was disoccluded.
+float getSampleBudget(const vec2 posPrev, float depthCur, float motionZ)
+{
+    if (globalUniform.adaptiveSamplingEnable == 0)
+    {
+        return 1.0;
+    }
+
+    const ivec2 pp = ivec2(floor(posPrev));
+
+    if (pp.x < 0 || pp.y < 0 ||
+        pp.x >= int(globalUniform.renderWidthPrev) || pp.y >= int(globalUniform.renderHeightPrev))
+    {
+        return 1.0;
+    }
+
+    const float depthPrev = texelFetch(framebufDepthWorld_Prev_Sampler, pp, 0).r - motionZ;
+
+    if (abs(depthCur - depthPrev) / abs(depthCur) > 0.1)
+    {
+        return 1.0;
+    }
+
+    return texelFetch(framebufSampleBudget_Sampler, pp / COMPUTE_ASVGF_STRATA_SIZE, 0).r;
+}
+
+// Sample count in [countMin, countMax] for the budget from getSampleBudget
+int getBudgetedCount(float budget, uint countMin, uint countMax)
+{
+    return int(round(mix(float(countMin), float(countMax), budget)));
+}
+
 /*
 vec2 getCurScreenPos(sampler2D motionSampler, const ivec2 prevPix)
 {
@@ -352,6 +520,41 @@ ivec3 getCheckerboardedRenderArea(const ivec2 checkerboardPix)
 #endif // CHECKERBOARD_FULL_HEIGHT
 #endif // CHECKERBOARD_FULL_WIDTH
 
+#ifdef DESC_SET_GLOBAL_UNIFORM
+// Same as above, but for a pixel reprojected by getPrevScreenPos into the previous frame,
+// which might have been rendered with another size
+int getCheckerboardSeparatorX_Prev()
+{
+    return int(globalUniform.renderWidthPrev) / CHECKERBOARD_SEPARATOR_DIVISOR;
+}
+
+ivec2 getRegularPixFromCheckerboardPix_Prev(const ivec2 checkerboardPixPrev)
+{
+    const int sep = getCheckerboardSeparatorX_Prev();
+    const int isOdd = int(checkerboardPixPrev.x >= sep);
+
+    int x = checkerboardPixPrev.x - isOdd * sep;
+
+    return ivec2(
+        x * 2 + (isOdd + checkerboardPixPrev.y) % 2,
+        checkerboardPixPrev.y 
+    );
+}
+
+// Render area in the previous frame for a current checkerboarded pixel
+ivec3 getCheckerboardedRenderArea_Prev(const ivec2 checkerboardPix)
+{
+    const int sep = getCheckerboardSeparatorX_Prev();
+    const int isOdd = isCheckerboardPixOdd(checkerboardPix);
+
+    return ivec3(
+        (isOdd + 0) * sep,
+        (isOdd + 1) * sep,
+        int(globalUniform.renderHeightPrev)
+    );
+}
+#endif // DESC_SET_GLOBAL_UNIFORM
+
 bool testPixInRenderArea(const ivec2 pix, const ivec3 renderArea)
 {
     return 
@@ -451,18 +654,71 @@ vec4 unpackEmissiveFactorAndStrength( uint packed )
 
 
 #ifdef DESC_SET_GLOBAL_UNIFORM
-vec3 getRayDir( vec2 inUV )
+// Views are the equal columns of the render target, view 0 is the leftmost one.
+// View 0 is the main camera, i.e. 'globalUniform.view', 'globalUniform.projection', etc
+int getViewCount()
+{
+    return max( int( globalUniform.viewCount ), 1 );
+}
+
+int getViewIndex( const ivec2 regularPix )
+{
+    return clamp( regularPix.x * getViewCount() / int( globalUniform.renderWidth ),
+                  0,
+                  getViewCount() - 1 );
+}
+
+int getViewIndexFromUV( const vec2 screenUV )
+{
+    return clamp( int( screenUV.x * float( getViewCount() ) ), 0, getViewCount() - 1 );
+}
+
+vec3 getViewCameraPosition( int viewIndex )
+{
+    return globalUniform.viewsCameraPosition[ viewIndex ].xyz;
+}
+
+// From the render target UV to the UV inside the view's column
+vec2 toViewUV( vec2 screenUV, int viewIndex )
+{
+    return vec2( screenUV.x * float( getViewCount() ) - float( viewIndex ), screenUV.y );
+}
+
+vec2 fromViewUV( vec2 viewUV, int viewIndex )
+{
+    return vec2( ( viewUV.x + float( viewIndex ) ) / float( getViewCount() ), viewUV.y );
+}
+
+vec3 getWorldPosFromScreen( vec2 screenUV, float depthNdc )
+{
+    const int  v      = getViewIndexFromUV( screenUV );
+    const vec2 viewUV = toViewUV( screenUV, v );
+
+    vec4 viewSpacePos =
+        globalUniform.viewsInvProjection[ v ] * vec4( viewUV * 2.0 - 1.0, depthNdc, 1.0 );
+    viewSpacePos /= viewSpacePos.w;
+
+    return ( globalUniform.viewsInvView[ v ] * viewSpacePos ).xyz;
+}
+
+vec3 getRayDirInView( vec2 viewUV, int viewIndex )
 {
-    inUV = inUV * 2.0 - 1.0;
+    viewUV = viewUV * 2.0 - 1.0;
 
-    vec4 target   = globalUniform.invProjection * vec4( inUV.x, inUV.y, 1, 1 );
+    vec4 target = globalUniform.viewsInvProjection[ viewIndex ] * vec4( viewUV.x, viewUV.y, 1, 1 );
     vec3 localDir = abs( target.w ) < 0.001 ? target.xyz : target.xyz / target.w;
 
-    vec4 rayDir = globalUniform.invView * vec4( normalize( localDir ), 0 );
+    vec4 rayDir = globalUniform.viewsInvView[ viewIndex ] * vec4( normalize( localDir ), 0 );
 
     return rayDir.xyz;
 }
 
+vec3 getRayDir( vec2 inUV )
+{
+    const int v = getViewIndexFromUV( inUV );
+    return getRayDirInView( toViewUV( inUV, v ), v );
+}
+
 vec2 getPixelUVWithJitter( const ivec2 pix )
 {
     const vec2 pixelCenter = vec2( pix ) + vec2( 0.5 );
@@ -471,16 +727,19 @@ vec2 getPixelUVWithJitter( const ivec2 pix )
     return ( pixelCenter + jitter ) / vec2( globalUniform.renderWidth, globalUniform.renderHeight );
 }
 
+// the neighbor must be in the same view, even if it's across the column border
 vec3 getRayDirAX( vec2 inUV )
 {
     const float AX = 1.0 / globalUniform.renderWidth;
-    return getRayDir( inUV + vec2( AX, 0 ) );
+    const int   v  = getViewIndexFromUV( inUV );
+    return getRayDirInView( toViewUV( inUV + vec2( AX, 0 ), v ), v );
 }
 
 vec3 getRayDirAY( vec2 inUV )
 {
     const float AY = 1.0 / globalUniform.renderHeight;
-    return getRayDir( inUV + vec2( 0, AY ) );
+    const int   v  = getViewIndexFromUV( inUV );
+    return getRayDirInView( toViewUV( inUV + vec2( 0, AY ), v ), v );
 }
 
 bool classicShading( ivec2 regularPix )
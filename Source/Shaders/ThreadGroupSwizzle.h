@@ -0,0 +1,60 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef THREAD_GROUP_SWIZZLE_H_
+#define THREAD_GROUP_SWIZZLE_H_
+
+// Full-screen 2D dispatches launch workgroups in row-major order, so the groups
+// that run at the same time form a thin horizontal line across the whole image,
+// and their neighborhood reads don't stay in L2 for the next row.
+// Remap the workgroups into vertical strips of THREAD_GROUP_SWIZZLE_TILE_WIDTH groups:
+// the groups are launched row by row inside a strip, then strip by strip.
+// Must be used only in 2D dispatches, i.e. when gl_NumWorkGroups.z == 1
+
+#ifndef THREAD_GROUP_SWIZZLE_TILE_WIDTH
+    #define THREAD_GROUP_SWIZZLE_TILE_WIDTH 8
+#endif
+
+uvec2 getSwizzledWorkGroupID()
+{
+    const uvec2 groupCount = gl_NumWorkGroups.xy;
+    const uint  tileWidth  = THREAD_GROUP_SWIZZLE_TILE_WIDTH;
+
+    const uint groupsInFullTile = tileWidth * groupCount.y;
+    const uint groupsInAllFull  = ( groupCount.x / tileWidth ) * groupsInFullTile;
+
+    const uint groupIndex  = gl_WorkGroupID.y * groupCount.x + gl_WorkGroupID.x;
+    const uint tileIndex   = groupIndex / groupsInFullTile;
+    const uint indexInTile = groupIndex % groupsInFullTile;
+
+    // the last strip can be narrower
+    const uint curTileWidth = groupIndex < groupsInAllFull ? tileWidth : groupCount.x % tileWidth;
+
+    return uvec2( tileIndex * tileWidth + indexInTile % curTileWidth, //
+                  indexInTile / curTileWidth );
+}
+
+// Use instead of gl_GlobalInvocationID
+uvec2 getSwizzledGlobalInvocationID()
+{
+    return getSwizzledWorkGroupID() * gl_WorkGroupSize.xy + gl_LocalInvocationID.xy;
+}
+
+#endif // THREAD_GROUP_SWIZZLE_H_
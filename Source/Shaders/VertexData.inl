@@ -31,6 +31,18 @@ layout(
     ShVertex g_staticVertices[];
 };
 
+// same buffer, if static vertices are quantized
+layout(
+    set = DESC_SET_VERTEX_DATA,
+    binding = BINDING_VERTEX_BUFFER_STATIC)
+    #ifndef VERTEX_BUFFER_WRITEABLE
+    readonly 
+    #endif
+    buffer VertexBufferStaticQuantized_BT
+{
+    ShVertexQuantized g_staticVerticesQuantized[];
+};
+
 layout(
     set = DESC_SET_VERTEX_DATA,
     binding = BINDING_VERTEX_BUFFER_DYNAMIC)
@@ -69,6 +81,24 @@ layout(
     ShGeometryInstance geometryInstances[];
 };
 
+layout(
+    set = DESC_SET_VERTEX_DATA,
+    binding = BINDING_GEOMETRY_INSTANCES_PREV)
+    readonly 
+    buffer GeometryInstancesPrev_BT
+{
+    ShGeometryInstancePrev geometryInstancesPrev[];
+};
+
+layout(
+    set = DESC_SET_VERTEX_DATA,
+    binding = BINDING_GEOMETRY_MATERIALS)
+    readonly 
+    buffer GeometryMaterials_BT
+{
+    ShGeometryMaterial geometryMaterials[];
+};
+
 layout(
     set = DESC_SET_VERTEX_DATA,
     binding = BINDING_GEOMETRY_INSTANCES_MATCH_PREV)
@@ -149,14 +179,42 @@ layout(
     vec2 g_dynamicTexCoords_Layer3[];
 };
 
+layout(
+    set = DESC_SET_VERTEX_DATA,
+    binding = BINDING_EMISSIVE_TRIANGLES)
+    readonly
+    buffer EmissiveTriangles_BT
+{
+    ShEmissiveTriangle g_emissiveTriangles[];
+};
+
 
-vec3 getStaticVerticesPositions(uint index)
+bool isQuantized(const ShGeometryInstance inst)
 {
+    return ( inst.flags & GEOM_INST_FLAG_QUANTIZED_VERTICES ) != 0;
+}
+
+vec3 dequantizePosition(const ShGeometryInstance inst, const ShVertexQuantized v)
+{
+    const vec3 snorm = vec3( unpackSnorm2x16( v.positionXY ), unpackSnorm2x16( v.positionZW ).x );
+    return inst.dequantCenter.xyz + inst.dequantExtent.xyz * snorm;
+}
+
+vec3 getStaticVerticesPositions(const ShGeometryInstance inst, uint index)
+{
+    if( isQuantized( inst ) )
+    {
+        return dequantizePosition( inst, g_staticVerticesQuantized[ index ] );
+    }
     return g_staticVertices[index].position.xyz;
 }
 
-vec3 getStaticVerticesNormals(uint index)
+vec3 getStaticVerticesNormals(const ShGeometryInstance inst, uint index)
 {
+    if( isQuantized( inst ) )
+    {
+        return decodeNormal( g_staticVerticesQuantized[ index ].normalPacked );
+    }
     return decodeNormal(g_staticVertices[index].normalPacked);
 }
 
@@ -171,8 +229,13 @@ vec3 getDynamicVerticesNormals(uint index)
 }
 
 #ifdef VERTEX_BUFFER_WRITEABLE
-void setStaticVerticesNormals(uint index, vec3 value)
+void setStaticVerticesNormals(const ShGeometryInstance inst, uint index, vec3 value)
 {
+    if( isQuantized( inst ) )
+    {
+        g_staticVerticesQuantized[ index ].normalPacked = encodeNormal( value );
+        return;
+    }
     g_staticVertices[index].normalPacked = encodeNormal(value);
 }
 
@@ -182,16 +245,106 @@ void setDynamicVerticesNormals(uint index, vec3 value)
 }
 #endif // VERTEX_BUFFER_WRITEABLE
 
+// 16-bit indices are packed in pairs into uint: even ones in the low half, odd ones in the high.
+// 'baseIndexIndex' is always in uints, 'local' is an index of an element in the index buffer.
+uint unpackIndex16(uint packedPair, uint element)
+{
+    return (element & 1) == 0 ? (packedPair & 0xFFFF) : (packedPair >> 16);
+}
+
+uint getStaticIndex(uint baseIndexIndex, uint local, bool indices16)
+{
+    if (indices16)
+    {
+        const uint element = baseIndexIndex * 2 + local;
+        return unpackIndex16(staticIndices[element >> 1], element);
+    }
+    return staticIndices[baseIndexIndex + local];
+}
+
+uint getDynamicIndex(uint baseIndexIndex, uint local, bool indices16)
+{
+    if (indices16)
+    {
+        const uint element = baseIndexIndex * 2 + local;
+        return unpackIndex16(dynamicIndices[element >> 1], element);
+    }
+    return dynamicIndices[baseIndexIndex + local];
+}
+
+uint getPrevDynamicIndex(uint prevBaseIndexIndex, uint local, bool indices16)
+{
+    if (indices16)
+    {
+        const uint element = prevBaseIndexIndex * 2 + local;
+        return unpackIndex16(prevDynamicIndices[element >> 1], element);
+    }
+    return prevDynamicIndices[prevBaseIndexIndex + local];
+}
+
+bool hasIndices16(const ShGeometryInstance inst)
+{
+    return (inst.flags & GEOM_INST_FLAG_INDICES_16BIT) != 0;
+}
+
+bool hasPrevIndices16(const ShGeometryInstance inst)
+{
+    return (inst.flags & GEOM_INST_FLAG_PREV_INDICES_16BIT) != 0;
+}
+
+// Current vertices and indices of a geometry are fetched through its buffer device addresses,
+// which point at the first vertex / index, so there's no descriptor indexing and base offsets.
+// Texture coordinate layers and the previous frame's data are still in the bound buffers.
+#extension GL_EXT_buffer_reference : require
+#extension GL_EXT_buffer_reference_uvec2 : require
+
+layout( buffer_reference, std430, buffer_reference_align = 16 ) readonly buffer VertexRef_BT
+{
+    ShVertex v[];
+};
+
+layout( buffer_reference, std430, buffer_reference_align = 4 ) readonly buffer VertexQuantizedRef_BT
+{
+    ShVertexQuantized v[];
+};
+
+layout( buffer_reference, std430, buffer_reference_align = 4 ) readonly buffer IndexRef_BT
+{
+    uint i[];
+};
+
+// Vertex indices of a triangle, relative to the first vertex of the geometry
+uvec3 getLocalVertIndices( const ShGeometryInstance inst, uint primitiveId )
+{
+    const uvec3 elements = primitiveId * 3 + uvec3( 0, 1, 2 );
+
+    // if to use indices
+    if( inst.baseIndexIndex != UINT32_MAX )
+    {
+        IndexRef_BT ib = IndexRef_BT( inst.indexBufferAddress );
+
+        if( hasIndices16( inst ) )
+        {
+            // the first index of a geometry is always at the start of a uint
+            return uvec3( unpackIndex16( ib.i[ elements[ 0 ] >> 1 ], elements[ 0 ] ),
+                          unpackIndex16( ib.i[ elements[ 1 ] >> 1 ], elements[ 1 ] ),
+                          unpackIndex16( ib.i[ elements[ 2 ] >> 1 ], elements[ 2 ] ) );
+        }
+        return uvec3( ib.i[ elements[ 0 ] ], ib.i[ elements[ 1 ] ], ib.i[ elements[ 2 ] ] );
+    }
+    return elements;
+}
+
 // Get indices in vertex buffer. If geom uses index buffer then it flattens them to vertex buffer indices.
-uvec3 getVertIndicesStatic(uint baseVertexIndex, uint baseIndexIndex, uint primitiveId)
+uvec3 getVertIndicesStatic(uint baseVertexIndex, uint baseIndexIndex, uint primitiveId, bool indices16)
 {
     // if to use indices
     if (baseIndexIndex != UINT32_MAX)
     {
         return uvec3(
-            baseVertexIndex + staticIndices[baseIndexIndex + primitiveId * 3 + 0],
-            baseVertexIndex + staticIndices[baseIndexIndex + primitiveId * 3 + 1],
-            baseVertexIndex + staticIndices[baseIndexIndex + primitiveId * 3 + 2]);
+            baseVertexIndex + getStaticIndex(baseIndexIndex, primitiveId * 3 + 0, indices16),
+            baseVertexIndex + getStaticIndex(baseIndexIndex, primitiveId * 3 + 1, indices16),
+            baseVertexIndex + getStaticIndex(baseIndexIndex, primitiveId * 3 + 2, indices16));
     }
     else
     {
@@ -202,15 +355,15 @@ uvec3 getVertIndicesStatic(uint baseVertexIndex, uint baseIndexIndex, uint primi
     }
 }
 
-uvec3 getVertIndicesDynamic(uint baseVertexIndex, uint baseIndexIndex, uint primitiveId)
+uvec3 getVertIndicesDynamic(uint baseVertexIndex, uint baseIndexIndex, uint primitiveId, bool indices16)
 {
     // if to use indices
     if (baseIndexIndex != UINT32_MAX)
     {
         return uvec3(
-            baseVertexIndex + dynamicIndices[baseIndexIndex + primitiveId * 3 + 0],
-            baseVertexIndex + dynamicIndices[baseIndexIndex + primitiveId * 3 + 1],
-            baseVertexIndex + dynamicIndices[baseIndexIndex + primitiveId * 3 + 2]);
+            baseVertexIndex + getDynamicIndex(baseIndexIndex, primitiveId * 3 + 0, indices16),
+            baseVertexIndex + getDynamicIndex(baseIndexIndex, primitiveId * 3 + 1, indices16),
+            baseVertexIndex + getDynamicIndex(baseIndexIndex, primitiveId * 3 + 2, indices16));
     }
     else
     {
@@ -222,15 +375,15 @@ uvec3 getVertIndicesDynamic(uint baseVertexIndex, uint baseIndexIndex, uint prim
 }
 
 // Only for dynamic, static geom vertices are not changed.
-uvec3 getPrevVertIndicesDynamic(uint prevBaseVertexIndex, uint prevBaseIndexIndex, uint primitiveId)
+uvec3 getPrevVertIndicesDynamic(uint prevBaseVertexIndex, uint prevBaseIndexIndex, uint primitiveId, bool indices16)
 {
     // if to use indices
     if (prevBaseIndexIndex != UINT32_MAX)
     {
         return uvec3(
-            prevBaseVertexIndex + prevDynamicIndices[prevBaseIndexIndex + primitiveId * 3 + 0],
-            prevBaseVertexIndex + prevDynamicIndices[prevBaseIndexIndex + primitiveId * 3 + 1],
-            prevBaseVertexIndex + prevDynamicIndices[prevBaseIndexIndex + primitiveId * 3 + 2]);
+            prevBaseVertexIndex + getPrevDynamicIndex(prevBaseIndexIndex, primitiveId * 3 + 0, indices16),
+            prevBaseVertexIndex + getPrevDynamicIndex(prevBaseIndexIndex, primitiveId * 3 + 1, indices16),
+            prevBaseVertexIndex + getPrevDynamicIndex(prevBaseIndexIndex, primitiveId * 3 + 2, indices16));
     }
     else
     {
@@ -323,6 +476,32 @@ ShTriangle makeTriangleFromCompact(const ShVertexCompact a, const ShVertexCompac
     return tr;
 }
 
+ShTriangle makeTriangleFromQuantized(const ShGeometryInstance inst,
+                                     const ShVertexQuantized  a,
+                                     const ShVertexQuantized  b,
+                                     const ShVertexQuantized  c)
+{
+    ShTriangle tr;
+
+    tr.positions[ 0 ] = dequantizePosition( inst, a );
+    tr.positions[ 1 ] = dequantizePosition( inst, b );
+    tr.positions[ 2 ] = dequantizePosition( inst, c );
+
+    tr.normals[ 0 ] = decodeNormal( a.normalPacked );
+    tr.normals[ 1 ] = decodeNormal( b.normalPacked );
+    tr.normals[ 2 ] = decodeNormal( c.normalPacked );
+
+    tr.layerTexCoord[ 0 ][ 0 ] = unpackHalf2x16( a.texCoordPacked );
+    tr.layerTexCoord[ 0 ][ 1 ] = unpackHalf2x16( b.texCoordPacked );
+    tr.layerTexCoord[ 0 ][ 2 ] = unpackHalf2x16( c.texCoordPacked );
+
+    tr.vertexColors[ 0 ] = a.color;
+    tr.vertexColors[ 1 ] = b.color;
+    tr.vertexColors[ 2 ] = c.color;
+
+    return tr;
+}
+
 bool getCurrentGeometryIndexByPrev(int prevInstanceID, int prevLocalGeometryIndex, out int curFrameGlobalGeomIndex)
 {
     // try to find instance index in current frame by it
@@ -345,7 +524,7 @@ ShTriangleTexInfo getTriangleTexInfo
 #else
 ShTriangle getTriangle
 #endif
-    ( int instanceID,          // index in TLAS
+    ( int instanceID,          // index in geometry infos, see getGeometryInstanceIndex
       int instanceCustomIndex, //
       int localGeometryIndex,  //
       int primitiveId          // index of a triangle
@@ -359,13 +538,14 @@ ShTriangle getTriangle
 
     if( isDynamic )
     {
+        const uvec3 localIndices = getLocalVertIndices( inst, primitiveId );
         {
-            const uvec3 vertIndices = getVertIndicesDynamic(inst.baseVertexIndex, inst.baseIndexIndex, primitiveId);
+            VertexRef_BT vb = VertexRef_BT( inst.vertexBufferAddress );
 
             tr = makeTriangle(
-                g_dynamicVertices[vertIndices[0]],
-                g_dynamicVertices[vertIndices[1]],
-                g_dynamicVertices[vertIndices[2]]);
+                vb.v[ localIndices[ 0 ] ],
+                vb.v[ localIndices[ 1 ] ],
+                vb.v[ localIndices[ 2 ] ] );
         }
 
 #ifndef ONLY_LAYER0_TEXCOLOR
@@ -373,24 +553,21 @@ ShTriangle getTriangle
 #if !SUPPRESS_TEXLAYERS
         if( ( inst.flags & GEOM_INST_FLAG_EXISTS_LAYER1 ) != 0 )
         {
-            const uvec3 vertIndices =
-                getVertIndicesDynamic( inst.firstVertex_Layer1, inst.baseIndexIndex, primitiveId );
+            const uvec3 vertIndices = inst.firstVertex_Layer1 + localIndices;
             tr.layerTexCoord[ 1 ][ 0 ] = g_dynamicTexCoords_Layer1[ vertIndices[ 0 ] ];
             tr.layerTexCoord[ 1 ][ 1 ] = g_dynamicTexCoords_Layer1[ vertIndices[ 1 ] ];
             tr.layerTexCoord[ 1 ][ 2 ] = g_dynamicTexCoords_Layer1[ vertIndices[ 2 ] ];
         }
         if( ( inst.flags & GEOM_INST_FLAG_EXISTS_LAYER2 ) != 0 )
         {
-            const uvec3 vertIndices =
-                getVertIndicesDynamic( inst.firstVertex_Layer2, inst.baseIndexIndex, primitiveId );
+            const uvec3 vertIndices = inst.firstVertex_Layer2 + localIndices;
             tr.layerTexCoord[ 2 ][ 0 ] = g_dynamicTexCoords_Layer2[ vertIndices[ 0 ] ];
             tr.layerTexCoord[ 2 ][ 1 ] = g_dynamicTexCoords_Layer2[ vertIndices[ 1 ] ];
             tr.layerTexCoord[ 2 ][ 2 ] = g_dynamicTexCoords_Layer2[ vertIndices[ 2 ] ];
         }
         if( ( inst.flags & GEOM_INST_FLAG_EXISTS_LAYER3 ) != 0 )
         {
-            const uvec3 vertIndices =
-                getVertIndicesDynamic( inst.firstVertex_Layer3, inst.baseIndexIndex, primitiveId );
+            const uvec3 vertIndices = inst.firstVertex_Layer3 + localIndices;
             tr.layerTexCoord[ 3 ][ 0 ] = g_dynamicTexCoords_Layer3[ vertIndices[ 0 ] ];
             tr.layerTexCoord[ 3 ][ 1 ] = g_dynamicTexCoords_Layer3[ vertIndices[ 1 ] ];
             tr.layerTexCoord[ 3 ][ 2 ] = g_dynamicTexCoords_Layer3[ vertIndices[ 2 ] ];
@@ -403,16 +580,17 @@ ShTriangle getTriangle
         tr.positions[ 2 ] = transformBy( inst, vec4( tr.positions[ 2 ], 1.0 ) );
 
         // dynamic     -- use prev model matrix and prev positions if exist
-        const bool hasPrevInfo = inst.prevBaseVertexIndex != UINT32_MAX;
+        const ShGeometryInstancePrev instPrev = geometryInstancesPrev[ instanceID ];
+        const bool hasPrevInfo = instPrev.prevBaseVertexIndex != UINT32_MAX;
 
         if( hasPrevInfo )
         {
             const uvec3 prevVertIndices = getPrevVertIndicesDynamic(
-                inst.prevBaseVertexIndex, inst.prevBaseIndexIndex, primitiveId );
+                instPrev.prevBaseVertexIndex, instPrev.prevBaseIndexIndex, primitiveId, hasPrevIndices16( inst ) );
 
-            tr.prevPositions[ 0 ] = transformBy_prev( inst, vec4( getPrevDynamicVerticesPositions( prevVertIndices[ 0 ] ), 1.0 ) );
-            tr.prevPositions[ 1 ] = transformBy_prev( inst, vec4( getPrevDynamicVerticesPositions( prevVertIndices[ 1 ] ), 1.0 ) );
-            tr.prevPositions[ 2 ] = transformBy_prev( inst, vec4( getPrevDynamicVerticesPositions( prevVertIndices[ 2 ] ), 1.0 ) );
+            tr.prevPositions[ 0 ] = transformBy_prev( instPrev, vec4( getPrevDynamicVerticesPositions( prevVertIndices[ 0 ] ), 1.0 ) );
+            tr.prevPositions[ 1 ] = transformBy_prev( instPrev, vec4( getPrevDynamicVerticesPositions( prevVertIndices[ 1 ] ), 1.0 ) );
+            tr.prevPositions[ 2 ] = transformBy_prev( instPrev, vec4( getPrevDynamicVerticesPositions( prevVertIndices[ 2 ] ), 1.0 ) );
         }
         else
         {
@@ -424,13 +602,27 @@ ShTriangle getTriangle
     }
     else
     {
+        const uvec3 localIndices = getLocalVertIndices( inst, primitiveId );
         {
-            const uvec3 vertIndices = getVertIndicesStatic(inst.baseVertexIndex, inst.baseIndexIndex, primitiveId);
-        
-            tr = makeTriangle(
-                g_staticVertices[vertIndices[0]],
-                g_staticVertices[vertIndices[1]],
-                g_staticVertices[vertIndices[2]]);
+            if( isQuantized( inst ) )
+            {
+                VertexQuantizedRef_BT vb = VertexQuantizedRef_BT( inst.vertexBufferAddress );
+
+                tr = makeTriangleFromQuantized(
+                    inst,
+                    vb.v[ localIndices[ 0 ] ],
+                    vb.v[ localIndices[ 1 ] ],
+                    vb.v[ localIndices[ 2 ] ] );
+            }
+            else
+            {
+                VertexRef_BT vb = VertexRef_BT( inst.vertexBufferAddress );
+
+                tr = makeTriangle(
+                    vb.v[ localIndices[ 0 ] ],
+                    vb.v[ localIndices[ 1 ] ],
+                    vb.v[ localIndices[ 2 ] ] );
+            }
         }
 
 #ifndef ONLY_LAYER0_TEXCOLOR
@@ -438,24 +630,21 @@ ShTriangle getTriangle
 #if !SUPPRESS_TEXLAYERS
         if( ( inst.flags & GEOM_INST_FLAG_EXISTS_LAYER1 ) != 0 )
         {
-            const uvec3 vertIndices =
-                getVertIndicesStatic( inst.firstVertex_Layer1, inst.baseIndexIndex, primitiveId );
+            const uvec3 vertIndices = inst.firstVertex_Layer1 + localIndices;
             tr.layerTexCoord[ 1 ][ 0 ] = g_staticTexCoords_Layer1[ vertIndices[ 0 ] ];
             tr.layerTexCoord[ 1 ][ 1 ] = g_staticTexCoords_Layer1[ vertIndices[ 1 ] ];
             tr.layerTexCoord[ 1 ][ 2 ] = g_staticTexCoords_Layer1[ vertIndices[ 2 ] ];
         }
         if( ( inst.flags & GEOM_INST_FLAG_EXISTS_LAYER2 ) != 0 )
         {
-            const uvec3 vertIndices =
-                getVertIndicesStatic( inst.firstVertex_Layer2, inst.baseIndexIndex, primitiveId );
+            const uvec3 vertIndices = inst.firstVertex_Layer2 + localIndices;
             tr.layerTexCoord[ 2 ][ 0 ] = g_staticTexCoords_Layer2[ vertIndices[ 0 ] ];
             tr.layerTexCoord[ 2 ][ 1 ] = g_staticTexCoords_Layer2[ vertIndices[ 1 ] ];
             tr.layerTexCoord[ 2 ][ 2 ] = g_staticTexCoords_Layer2[ vertIndices[ 2 ] ];
         }
         if( ( inst.flags & GEOM_INST_FLAG_EXISTS_LAYER3 ) != 0 )
         {
-            const uvec3 vertIndices =
-                getVertIndicesStatic( inst.firstVertex_Layer3, inst.baseIndexIndex, primitiveId );
+            const uvec3 vertIndices = inst.firstVertex_Layer3 + localIndices;
             tr.layerTexCoord[ 3 ][ 0 ] = g_staticTexCoords_Layer3[ vertIndices[ 0 ] ];
             tr.layerTexCoord[ 3 ][ 1 ] = g_staticTexCoords_Layer3[ vertIndices[ 1 ] ];
             tr.layerTexCoord[ 3 ][ 2 ] = g_staticTexCoords_Layer3[ vertIndices[ 2 ] ];
@@ -473,16 +662,17 @@ ShTriangle getTriangle
         tr.positions[ 1 ] = transformBy( inst, vec4( localPos[ 1 ], 1.0 ) );
         tr.positions[ 2 ] = transformBy( inst, vec4( localPos[ 2 ], 1.0 ) );
 
-        const bool hasPrevInfo = inst.prevBaseVertexIndex != UINT32_MAX;
+        const ShGeometryInstancePrev instPrev = geometryInstancesPrev[ instanceID ];
+        const bool hasPrevInfo = instPrev.prevBaseVertexIndex != UINT32_MAX;
 
         // use prev model matrix if exist
         if( hasPrevInfo )
         {
             // static geoms' local positions are constant,
             // only model matrices are changing
-            tr.prevPositions[ 0 ] = transformBy_prev( inst, vec4( localPos[ 0 ], 1.0 ) );
-            tr.prevPositions[ 1 ] = transformBy_prev( inst, vec4( localPos[ 1 ], 1.0 ) );
-            tr.prevPositions[ 2 ] = transformBy_prev( inst, vec4( localPos[ 2 ], 1.0 ) );
+            tr.prevPositions[ 0 ] = transformBy_prev( instPrev, vec4( localPos[ 0 ], 1.0 ) );
+            tr.prevPositions[ 1 ] = transformBy_prev( instPrev, vec4( localPos[ 1 ], 1.0 ) );
+            tr.prevPositions[ 2 ] = transformBy_prev( instPrev, vec4( localPos[ 2 ], 1.0 ) );
         }
         else
         {
@@ -493,35 +683,37 @@ ShTriangle getTriangle
 #endif // !ONLY_LAYER0_TEXCOLOR
     }
 
+    const ShGeometryMaterial mat = geometryMaterials[ inst.materialIndex ];
+
 #ifndef ONLY_LAYER0_TEXCOLOR
 
     tr.layerColorTextures = uint[](
-        inst.texture_base
+        mat.texture_base
 #if !SUPPRESS_TEXLAYERS
-    ,   inst.texture_layer1
-    ,   inst.texture_layer2
-    ,   inst.texture_layer3
+    ,   mat.texture_layer1
+    ,   mat.texture_layer2
+    ,   mat.texture_layer3
 #endif
     );
 
     tr.layerColors = uint[](
-        inst.colorFactor_base
+        mat.colorFactor_base
 #if !SUPPRESS_TEXLAYERS
-    ,   inst.colorFactor_layer1
-    ,   inst.colorFactor_layer2
-    ,   inst.colorFactor_layer3
+    ,   mat.colorFactor_layer1
+    ,   mat.colorFactor_layer2
+    ,   mat.colorFactor_layer3
 #endif
     );
 
-    tr.roughnessDefault = ( ( inst.roughnessDefault_metallicDefault >> 0 ) & 0xFF ) / 255.0;
-    tr.metallicDefault  = ( ( inst.roughnessDefault_metallicDefault >> 8 ) & 0xFF ) / 255.0;
-    tr.occlusionRougnessMetallicTexture = inst.texture_base_ORM;
+    tr.roughnessDefault = ( ( mat.roughnessDefault_metallicDefault >> 0 ) & 0xFF ) / 255.0;
+    tr.metallicDefault  = ( ( mat.roughnessDefault_metallicDefault >> 8 ) & 0xFF ) / 255.0;
+    tr.occlusionRougnessMetallicTexture = mat.texture_base_ORM;
 
-    tr.normalTexture = inst.texture_base_N;
-    tr.heightTexture = inst.texture_base_D;
+    tr.normalTexture = mat.texture_base_N;
+    tr.heightTexture = mat.texture_base_D;
 
-    tr.emissiveMult = inst.emissiveMult;
-    tr.emissiveTexture = inst.texture_base_E;
+    tr.emissiveMult = mat.emissiveMult;
+    tr.emissiveTexture = mat.texture_base_E;
 
     {
         // to world space
@@ -539,8 +731,8 @@ ShTriangle getTriangle
 
     ShTriangleTexInfo trTexInfo;
     trTexInfo.layerTexCoord_0      = tr.layerTexCoord[ 0 ];
-    trTexInfo.layerColorTextures_0 = inst.texture_base;
-    trTexInfo.layerColors_0        = inst.colorFactor_base;
+    trTexInfo.layerColorTextures_0 = mat.texture_base;
+    trTexInfo.layerColors_0        = mat.colorFactor_base;
     return trTexInfo;
 
 #endif // !ONLY_LAYER0_TEXCOLOR
@@ -552,25 +744,26 @@ mat3 getOnlyCurPositions(int globalGeometryIndex, int primitiveId)
 
     const ShGeometryInstance inst = geometryInstances[globalGeometryIndex];
 
-    const bool isDynamic = ( ( inst.flags & GEOM_INST_FLAG_IS_DYNAMIC ) != 0 );
+    const uvec3 localIndices = getLocalVertIndices( inst, primitiveId );
 
-    if (isDynamic)
+    // only static geometry can be quantized
+    if( isQuantized( inst ) )
     {
-        const uvec3 vertIndices = getVertIndicesDynamic(inst.baseVertexIndex, inst.baseIndexIndex, primitiveId);
+        VertexQuantizedRef_BT vb = VertexQuantizedRef_BT( inst.vertexBufferAddress );
 
         // to world space
-        positions[0] = transformBy(inst, vec4(getDynamicVerticesPositions(vertIndices[0]), 1.0));
-        positions[1] = transformBy(inst, vec4(getDynamicVerticesPositions(vertIndices[1]), 1.0));
-        positions[2] = transformBy(inst, vec4(getDynamicVerticesPositions(vertIndices[2]), 1.0));
+        positions[0] = transformBy(inst, vec4(dequantizePosition(inst, vb.v[localIndices[0]]), 1.0));
+        positions[1] = transformBy(inst, vec4(dequantizePosition(inst, vb.v[localIndices[1]]), 1.0));
+        positions[2] = transformBy(inst, vec4(dequantizePosition(inst, vb.v[localIndices[2]]), 1.0));
     }
     else
     {
-        const uvec3 vertIndices = getVertIndicesStatic(inst.baseVertexIndex, inst.baseIndexIndex, primitiveId);
+        VertexRef_BT vb = VertexRef_BT( inst.vertexBufferAddress );
 
         // to world space
-        positions[0] = transformBy(inst, vec4(getStaticVerticesPositions(vertIndices[0]), 1.0));
-        positions[1] = transformBy(inst, vec4(getStaticVerticesPositions(vertIndices[1]), 1.0));
-        positions[2] = transformBy(inst, vec4(getStaticVerticesPositions(vertIndices[2]), 1.0));
+        positions[0] = transformBy(inst, vec4(vb.v[localIndices[0]].position.xyz, 1.0));
+        positions[1] = transformBy(inst, vec4(vb.v[localIndices[1]].position.xyz, 1.0));
+        positions[2] = transformBy(inst, vec4(vb.v[localIndices[2]].position.xyz, 1.0));
     }
     
     return positions;
@@ -21,23 +21,24 @@
 
 #if defined(VERTEX_PREPROCESS_PARTIAL_DYNAMIC)
     #define FUNC_NAME convertForInstance_Dynamic
-    #define GET_POSITIONS getDynamicVerticesPositions
-    #define GET_NORMALS getDynamicVerticesNormals
-    #define SET_NORMALS setDynamicVerticesNormals
-    #define INDICES dynamicIndices
+    #define GET_POSITIONS( inst, index ) getDynamicVerticesPositions( index )
+    #define GET_NORMALS( inst, index ) getDynamicVerticesNormals( index )
+    #define SET_NORMALS( inst, index, value ) setDynamicVerticesNormals( index, value )
+    #define GET_INDEX( inst, local ) getDynamicIndex( inst.baseIndexIndex, local, hasIndices16( inst ) )
 #elif defined(VERTEX_PREPROCESS_PARTIAL_STATIC)
     #define FUNC_NAME convertForInstance_Static
     #define GET_POSITIONS getStaticVerticesPositions
     #define GET_NORMALS getStaticVerticesNormals
     #define SET_NORMALS setStaticVerticesNormals
-    #define INDICES staticIndices
+    // static ones might be quantized, so they need instance info
+    #define GET_INDEX( inst, local ) getStaticIndex( inst.baseIndexIndex, local, hasIndices16( inst ) )
 #else
     #error
 #endif
 
 
 
-void FUNC_NAME (const ShGeometryInstance inst)
+void FUNC_NAME (const ShGeometryInstance inst, const uint tri)
 {
     const bool useIndices = inst.baseIndexIndex != UINT32_MAX;
     const bool genNormals = ( inst.flags & GEOM_INST_FLAG_GENERATE_NORMALS ) != 0 &&
@@ -45,66 +46,36 @@ void FUNC_NAME (const ShGeometryInstance inst)
     // -1 if normals should be inverted
     const float normalSign = float((inst.flags & GEOM_INST_FLAG_INVERTED_NORMALS) == 0) * 2.0 - 1.0;
 
-    if (useIndices)
+    if (!genNormals)
     {
-        for (uint tri = 0; tri < inst.indexCount / 3; tri++)
-        {
-            const uint i = inst.baseIndexIndex + tri * 3;
-
-            const uvec3 vertexIndices = uvec3(
-                inst.baseVertexIndex + INDICES[i + 0],
-                inst.baseVertexIndex + INDICES[i + 1],
-                inst.baseVertexIndex + INDICES[i + 2]);
-
-            const vec3 localPos[] = 
-            {
-                GET_POSITIONS(vertexIndices[0]),
-                GET_POSITIONS(vertexIndices[1]),
-                GET_POSITIONS(vertexIndices[2])
-            };
-
-            vec3 localNormal;
-            
-            if (genNormals)
-            {
-                localNormal = normalSign * normalize(cross(localPos[1] - localPos[0], localPos[2] - localPos[0]));
-                
-                SET_NORMALS(vertexIndices[0], localNormal);
-                SET_NORMALS(vertexIndices[1], localNormal);
-                SET_NORMALS(vertexIndices[2], localNormal);
-            }
-        }
+        return;
     }
-    else
-    {
-        for (uint tri = 0; tri < inst.vertexCount / 3; tri++)
-        {
-            const uint v = inst.baseVertexIndex + tri * 3;
 
-            const uvec3 vertexIndices = uvec3(
-                v + 0,
-                v + 1,
-                v + 2);
+    const uint i = tri * 3;
 
-            const vec3 localPos[] = 
-            {
-                GET_POSITIONS(vertexIndices[0]),
-                GET_POSITIONS(vertexIndices[1]),
-                GET_POSITIONS(vertexIndices[2])
-            };
+    const uvec3 vertexIndices = useIndices ?
+        uvec3(
+            inst.baseVertexIndex + GET_INDEX(inst, i + 0),
+            inst.baseVertexIndex + GET_INDEX(inst, i + 1),
+            inst.baseVertexIndex + GET_INDEX(inst, i + 2)) :
+        uvec3(
+            inst.baseVertexIndex + i + 0,
+            inst.baseVertexIndex + i + 1,
+            inst.baseVertexIndex + i + 2);
 
-            vec3 localNormal;
+    const vec3 localPos[] = 
+    {
+        GET_POSITIONS(inst, vertexIndices[0]),
+        GET_POSITIONS(inst, vertexIndices[1]),
+        GET_POSITIONS(inst, vertexIndices[2])
+    };
 
-            if (genNormals)
-            {
-                localNormal = normalSign * normalize(cross(localPos[1] - localPos[0], localPos[2] - localPos[0]));
+    // if a vertex is shared, any of its triangles' normals is written
+    const vec3 localNormal = normalSign * normalize(cross(localPos[1] - localPos[0], localPos[2] - localPos[0]));
 
-                SET_NORMALS(vertexIndices[0], localNormal);
-                SET_NORMALS(vertexIndices[1], localNormal);
-                SET_NORMALS(vertexIndices[2], localNormal);
-            }
-        } 
-    }
+    SET_NORMALS(inst, vertexIndices[0], localNormal);
+    SET_NORMALS(inst, vertexIndices[1], localNormal);
+    SET_NORMALS(inst, vertexIndices[2], localNormal);
 }
 
 
@@ -112,7 +83,7 @@ void FUNC_NAME (const ShGeometryInstance inst)
 #undef GET_POSITIONS
 #undef GET_NORMALS
 #undef SET_NORMALS
-#undef INDICES
+#undef GET_INDEX
 
 #undef VERTEX_PREPROCESS_PARTIAL_STATIC
 #undef VERTEX_PREPROCESS_PARTIAL_DYNAMIC
\ No newline at end of file
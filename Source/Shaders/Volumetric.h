@@ -28,10 +28,26 @@
 
 #define VOLUMETRIC_DISTANCE_POW 1
 
+// Active froxel grid resolution, volume images are allocated with the max one
+ivec3 volume_getSize()
+{
+    return ivec3( globalUniform.volumeSizeX, globalUniform.volumeSizeY, globalUniform.volumeSizeZ );
+}
+
+// Sample position in [0..1] of the active grid to the texture coordinates
+vec3 volume_toTexCoords( const vec3 samplePosition )
+{
+    const vec3 size    = vec3( volume_getSize() );
+    const vec3 maxSize = vec3( VOLUMETRIC_SIZE_X, VOLUMETRIC_SIZE_Y, VOLUMETRIC_SIZE_Z );
+
+    // don't filter with the texels outside of the active grid
+    const vec3 sp = clamp( samplePosition, 0.5 / size, 1.0 - 0.5 / size );
+    return sp * size / maxSize;
+}
+
 vec3 volume_getCenter_T( const ivec3 cell, const mat4 viewprojInv, const vec3 origin )
 {
-    vec3 local =
-        ( vec3( cell ) + 0.5 ) / vec3( VOLUMETRIC_SIZE_X, VOLUMETRIC_SIZE_Y, VOLUMETRIC_SIZE_Z );
+    vec3 local = ( vec3( cell ) + 0.5 ) / vec3( volume_getSize() );
 
     vec4 ndc = {
         local.x * 2.0 - 1.0,
@@ -89,8 +105,7 @@ vec3 volume_getCenter_Prev( const ivec3 prevcell )
 
 ivec3 volume_toCellIndex( const vec3 samplePosition )
 {
-    return ivec3( samplePosition *
-                  vec3( VOLUMETRIC_SIZE_X, VOLUMETRIC_SIZE_Y, VOLUMETRIC_SIZE_Z ) );
+    return ivec3( samplePosition * vec3( volume_getSize() ) );
 }
 
 
@@ -99,7 +114,7 @@ vec4 volume_sample( const vec3 world )
     vec3 sp = volume_toSamplePosition_T(
         world, globalUniform.volumeViewProj, globalUniform.cameraPosition.xyz );
 
-    return textureLod( g_volumetric_Sampler, sp, 0.0 );
+    return textureLod( g_volumetric_Sampler, volume_toTexCoords( sp ), 0.0 );
 }
 
 vec4 volume_sample_Prev( const ivec3 curcell )
@@ -109,7 +124,39 @@ vec4 volume_sample_Prev( const ivec3 curcell )
     vec3 spPrev = volume_toSamplePosition_T(
         curworld, globalUniform.volumeViewProj_Prev, globalUniform.cameraPositionPrev.xyz );
 
-    return textureLod( g_volumetric_Sampler_Prev, spPrev, 0.0 );
+    return textureLod( g_volumetric_Sampler_Prev, volume_toTexCoords( spPrev ), 0.0 );
+}
+
+// If reprojection is enabled, each 2x2 block of froxels traces only one
+// of them per frame, the rest are reprojected from the previous frame
+bool volume_isTracedInCurrentFrame( const ivec3 cell )
+{
+    if( globalUniform.volumeReprojection == 0 )
+    {
+        return true;
+    }
+
+    const uint order[ 4 ] = uint[]( 0, 3, 1, 2 );
+    const uint index      = uint( cell.x & 1 ) | ( uint( cell.y & 1 ) << 1 );
+
+    return index == order[ globalUniform.frameId % 4 ];
+}
+
+// Returns false, if the froxel wasn't in the previous frame's volume
+bool volume_tryReprojectRaw( const ivec3 cell, out vec4 raw )
+{
+    vec3 spPrev = volume_toSamplePosition_T( volume_getCenter( cell ),
+                                             globalUniform.volumeViewProj_Prev,
+                                             globalUniform.cameraPositionPrev.xyz );
+
+    if( any( lessThan( spPrev.xy, vec2( 0.0 ) ) ) || any( greaterThan( spPrev.xy, vec2( 1.0 ) ) ) )
+    {
+        raw = vec4( 0 );
+        return false;
+    }
+
+    raw = textureLod( g_volumetricRaw_Sampler_Prev, volume_toTexCoords( spPrev ), 0.0 );
+    return true;
 }
 
 vec4 volume_sampleDithered( const vec3  world,
@@ -120,10 +167,9 @@ vec4 volume_sampleDithered( const vec3  world,
     vec3 sp = volume_toSamplePosition_T(
         world, globalUniform.volumeViewProj, globalUniform.cameraPosition.xyz );
 
-    sp += rnd01 * ditherRadius * unitBasis /
-          vec3( VOLUMETRIC_SIZE_X, VOLUMETRIC_SIZE_Y, VOLUMETRIC_SIZE_Z );
+    sp += rnd01 * ditherRadius * unitBasis / vec3( volume_getSize() );
 
-    return textureLod( g_volumetric_Sampler, sp, 0.0 );
+    return textureLod( g_volumetric_Sampler, volume_toTexCoords( sp ), 0.0 );
 }
 
 
@@ -115,6 +115,11 @@ RTGL1::FramebufferImageIndex RTGL1::Sharpening::Apply(
 
 void RTGL1::Sharpening::OnShaderReload(const ShaderManager *shaderManager)
 {
+    if (!shaderManager->AnyChanged({ "CCas" }))
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines(shaderManager);
 }
@@ -187,7 +192,13 @@ void RTGL1::Sharpening::CreatePipelines(const ShaderManager *shaderManager)
             data.isSourcePing = b;
             data.useSimpleSharp = t == RG_RENDER_SHARPEN_TECHNIQUE_NAIVE;
 
-            VkResult r = vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &plInfo, nullptr, GetPipeline(t, b));
+            VkResult r = vkCreateComputePipelines( device,
+                                                   shaderManager->GetPipelineCache(),
+                                                   1,
+                                                   &plInfo,
+                                                   nullptr,
+                                                   GetPipeline(t,
+                                                   b) );
             VK_CHECKERROR(r);
 
             SET_DEBUG_NAME(device, *GetPipeline(t, b), VK_OBJECT_TYPE_PIPELINE, data.useSimpleSharp ? "Simple sharpening" : "CAS");
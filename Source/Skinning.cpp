@@ -0,0 +1,556 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Skinning.h"
+
+#include "CmdLabel.h"
+#include "Utils.h"
+#include "Generated/ShaderCommonC.h"
+
+namespace
+{
+
+// bind poses of all skinned primitives, persistent between the frames
+constexpr uint32_t SKIN_MAX_BIND_POSE_VERTEX_COUNT = 1 << 18;
+// per frame
+constexpr uint32_t SKIN_MAX_BONE_COUNT = 1 << 14;
+constexpr uint32_t SKIN_MAX_JOB_COUNT  = 1 << 12;
+// joint indices are 8-bit
+constexpr uint32_t SKIN_MAX_BONES_PER_PRIMITIVE = 256;
+
+// bind pose to mesh space matrix, as 3 rows
+constexpr uint32_t SKIN_BONE_ROW_COUNT = 3;
+
+uint32_t PackUnorm8( float v )
+{
+    return static_cast< uint32_t >( std::clamp( v, 0.f, 1.f ) * 255.f + 0.5f );
+}
+
+RTGL1::ShSkinVertex MakeSkinVertex( const RgPrimitiveVertex& v, const RgVertexSkinWeights& w )
+{
+    return RTGL1::ShSkinVertex{
+        .position     = { v.position[ 0 ], v.position[ 1 ], v.position[ 2 ] },
+        .normalPacked = v.normalPacked,
+        .texCoord     = { v.texCoord[ 0 ], v.texCoord[ 1 ] },
+        .color        = v.color,
+        .jointsPacked = uint32_t{ w.joints[ 0 ] } << 0 | uint32_t{ w.joints[ 1 ] } << 8 |
+                        uint32_t{ w.joints[ 2 ] } << 16 | uint32_t{ w.joints[ 3 ] } << 24,
+        .weightsPacked = PackUnorm8( w.weights[ 0 ] ) << 0 | PackUnorm8( w.weights[ 1 ] ) << 8 |
+                         PackUnorm8( w.weights[ 2 ] ) << 16 | PackUnorm8( w.weights[ 3 ] ) << 24,
+    };
+}
+
+}
+
+RTGL1::Skinning::Skinning( VkDevice                           _device,
+                           std::shared_ptr< MemoryAllocator > _allocator,
+                           const GlobalUniform&               _uniform,
+                           VkDescriptorSetLayout              _vertexDataSetLayout,
+                           const ShaderManager&               _shaderManager )
+    : device( _device )
+    , descPool( VK_NULL_HANDLE )
+    , descSetLayout( VK_NULL_HANDLE )
+    , descSet( VK_NULL_HANDLE )
+    , pipelineLayout( VK_NULL_HANDLE )
+    , pipeline( VK_NULL_HANDLE )
+{
+    bindPoses = std::make_unique< AutoBuffer >( _allocator );
+    bindPoses->Create( SKIN_MAX_BIND_POSE_VERTEX_COUNT * sizeof( ShSkinVertex ),
+                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                       "Skinning bind poses" );
+
+    bones = std::make_unique< AutoBuffer >( _allocator );
+    bones->Create( SKIN_MAX_BONE_COUNT * SKIN_BONE_ROW_COUNT * sizeof( float[ 4 ] ),
+                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                   "Skinning bones" );
+
+    jobs = std::make_unique< AutoBuffer >( std::move( _allocator ) );
+    jobs->Create( SKIN_MAX_JOB_COUNT * sizeof( ShSkinJob ),
+                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                  "Skinning jobs" );
+
+    CreateDescriptors();
+
+    VkDescriptorSetLayout setLayouts[] = {
+        _uniform.GetDescSetLayout(),
+        _vertexDataSetLayout,
+        descSetLayout,
+    };
+
+    CreatePipelineLayout( setLayouts, std::size( setLayouts ) );
+    CreatePipeline( &_shaderManager );
+}
+
+RTGL1::Skinning::~Skinning()
+{
+    vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
+    DestroyPipeline();
+    vkDestroyDescriptorPool( device, descPool, nullptr );
+    vkDestroyDescriptorSetLayout( device, descSetLayout, nullptr );
+}
+
+void RTGL1::Skinning::BeginFrame( uint32_t frameIndex )
+{
+    frameCounter++;
+
+    if( bindPoseResetPending )
+    {
+        uploadedBindPoses.clear();
+        bindPoseVertexCount  = 0;
+        bindPoseResetPending = false;
+    }
+    else
+    {
+        // space is not reclaimed, but the map doesn't grow
+        erase_if( uploadedBindPoses, [ this ]( const auto& b ) {
+            return b.second.lastUsedFrame + 1 < frameCounter;
+        } );
+    }
+
+    bindPoseCopies.clear();
+    boneCount = 0;
+    jobCount  = 0;
+}
+
+auto RTGL1::Skinning::PrepareBindPose( uint32_t                          frameIndex,
+                                       const PrimitiveUniqueID&          uniqueID,
+                                       const RgMeshPrimitiveInfo&        primitive,
+                                       const RgMeshPrimitiveSkinningEXT& skin )
+    -> std::optional< uint32_t >
+{
+    if( !primitive.pVertices || !skin.pSkinWeights || !skin.pBoneTransforms ||
+        skin.boneCount == 0 || primitive.vertexCount == 0 )
+    {
+        debug::Warning( "RgMeshPrimitiveSkinningEXT: skin weights, bone transforms and bind pose "
+                        "vertices must be provided" );
+        return std::nullopt;
+    }
+
+    if( skin.boneCount > SKIN_MAX_BONES_PER_PRIMITIVE )
+    {
+        debug::Warning( "RgMeshPrimitiveSkinningEXT: too many bones ({}), the limit is {}",
+                        skin.boneCount,
+                        SKIN_MAX_BONES_PER_PRIMITIVE );
+        return std::nullopt;
+    }
+
+    if( jobCount >= SKIN_MAX_JOB_COUNT || boneCount + skin.boneCount > SKIN_MAX_BONE_COUNT )
+    {
+        debug::Warning( "Too many skinned primitives in a frame, the limits are: {} primitives, "
+                        "{} bones",
+                        SKIN_MAX_JOB_COUNT,
+                        SKIN_MAX_BONE_COUNT );
+        return std::nullopt;
+    }
+
+    auto existing = uploadedBindPoses.find( uniqueID );
+    if( existing != uploadedBindPoses.end() )
+    {
+        BindPose& b = existing->second;
+
+        if( b.version == skin.bindPoseVersion && b.vertexCount == primitive.vertexCount )
+        {
+            b.lastUsedFrame = frameCounter;
+            return b.offset;
+        }
+
+        // can't overwrite in place, as the previous frame might still read it
+        uploadedBindPoses.erase( existing );
+    }
+
+    if( bindPoseVertexCount + primitive.vertexCount > SKIN_MAX_BIND_POSE_VERTEX_COUNT )
+    {
+        // other bind poses of this frame are already referenced, so reupload all in the next one
+        bindPoseResetPending = true;
+        debug::Warning( "Skinning bind pose buffer is full, the limit is {} vertices",
+                        SKIN_MAX_BIND_POSE_VERTEX_COUNT );
+        return std::nullopt;
+    }
+
+    const uint32_t offset = bindPoseVertexCount;
+    bindPoseVertexCount += primitive.vertexCount;
+
+    auto* dst = bindPoses->GetMappedAs< ShSkinVertex* >( frameIndex );
+    for( uint32_t i = 0; i < primitive.vertexCount; i++ )
+    {
+        dst[ offset + i ] = MakeSkinVertex( primitive.pVertices[ i ], skin.pSkinWeights[ i ] );
+    }
+
+    bindPoseCopies.push_back( VkBufferCopy{
+        .srcOffset = offset * sizeof( ShSkinVertex ),
+        .dstOffset = offset * sizeof( ShSkinVertex ),
+        .size      = primitive.vertexCount * sizeof( ShSkinVertex ),
+    } );
+
+    uploadedBindPoses[ uniqueID ] = BindPose{
+        .offset        = offset,
+        .vertexCount   = primitive.vertexCount,
+        .version       = skin.bindPoseVersion,
+        .lastUsedFrame = frameCounter,
+    };
+    return offset;
+}
+
+void RTGL1::Skinning::AddJob( uint32_t                          frameIndex,
+                              uint32_t                          bindPoseOffset,
+                              uint32_t                          vertexCount,
+                              const RgMeshPrimitiveSkinningEXT& skin,
+                              uint32_t                          dstVertexIndex )
+{
+    assert( jobCount < SKIN_MAX_JOB_COUNT );
+    assert( boneCount + skin.boneCount <= SKIN_MAX_BONE_COUNT );
+
+    auto* dstBones = bones->GetMappedAs< float( * )[ 4 ] >( frameIndex );
+    for( uint32_t b = 0; b < skin.boneCount; b++ )
+    {
+        static_assert( sizeof( skin.pBoneTransforms[ b ].matrix ) ==
+                       SKIN_BONE_ROW_COUNT * sizeof( float[ 4 ] ) );
+        memcpy( dstBones[ ( boneCount + b ) * SKIN_BONE_ROW_COUNT ],
+                skin.pBoneTransforms[ b ].matrix,
+                sizeof( skin.pBoneTransforms[ b ].matrix ) );
+    }
+
+    auto* dstJobs = jobs->GetMappedAs< ShSkinJob* >( frameIndex );
+    dstJobs[ jobCount ] = ShSkinJob{
+        .bindPoseOffset = bindPoseOffset,
+        .dstVertexIndex = dstVertexIndex,
+        .vertexCount    = vertexCount,
+        .boneOffset     = boneCount,
+    };
+
+    boneCount += skin.boneCount;
+    jobCount++;
+}
+
+void RTGL1::Skinning::Dispatch( VkCommandBuffer      cmd,
+                                uint32_t             frameIndex,
+                                const GlobalUniform& uniform,
+                                VkDescriptorSet      vertexDataSet )
+{
+    if( jobCount == 0 )
+    {
+        return;
+    }
+
+    CmdLabel label( cmd, "Skinning" );
+
+    {
+        // bind poses, bones and jobs might still be read by the previous frame
+        VkMemoryBarrier barrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = 0,
+        };
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              0,
+                              1,
+                              &barrier,
+                              0,
+                              nullptr,
+                              0,
+                              nullptr );
+    }
+
+    bindPoses->CopyFromStaging(
+        cmd, frameIndex, bindPoseCopies.data(), uint32_t( bindPoseCopies.size() ) );
+    bones->CopyFromStaging(
+        cmd, frameIndex, boneCount * SKIN_BONE_ROW_COUNT * sizeof( float[ 4 ] ) );
+    jobs->CopyFromStaging( cmd, frameIndex, jobCount * sizeof( ShSkinJob ) );
+
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+
+    VkDescriptorSet sets[] = {
+        uniform.GetDescSet( frameIndex ),
+        vertexDataSet,
+        descSet,
+    };
+
+    vkCmdBindDescriptorSets( cmd,
+                             VK_PIPELINE_BIND_POINT_COMPUTE,
+                             pipelineLayout,
+                             0,
+                             std::size( sets ),
+                             sets,
+                             0,
+                             nullptr );
+
+    vkCmdDispatch( cmd, jobCount, 1, 1 );
+
+
+    {
+        // skinned vertices are used for BLAS build, vertex preprocessing
+        // and as the previous frame's vertices
+        VkMemoryBarrier barrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR |
+                             VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT,
+        };
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                  VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR |
+                                  VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              0,
+                              1,
+                              &barrier,
+                              0,
+                              nullptr,
+                              0,
+                              nullptr );
+    }
+}
+
+void RTGL1::Skinning::OnShaderReload( const ShaderManager* shaderManager )
+{
+    if( !shaderManager->AnyChanged( { "CSkinning" } ) )
+    {
+        return;
+    }
+
+    DestroyPipeline();
+    CreatePipeline( shaderManager );
+}
+
+void RTGL1::Skinning::CreateDescriptors()
+{
+    VkResult r;
+
+    VkDescriptorSetLayoutBinding bindings[] = {
+        {
+            .binding         = BINDING_SKIN_BIND_POSE,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_SKIN_BONES,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_SKIN_JOBS,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = std::size( bindings ),
+        .pBindings    = bindings,
+    };
+
+    r = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descSetLayout );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME(
+        device, descSetLayout, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, "Skinning Desc set layout" );
+
+    VkDescriptorPoolSize poolSize = {
+        .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = std::size( bindings ),
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo = {
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets       = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes    = &poolSize,
+    };
+
+    r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &descPool );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, descPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Skinning Desc pool" );
+
+    VkDescriptorSetAllocateInfo allocInfo = {
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool     = descPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts        = &descSetLayout,
+    };
+
+    r = vkAllocateDescriptorSets( device, &allocInfo, &descSet );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, descSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Skinning Desc set" );
+
+
+    VkDescriptorBufferInfo bufs[] = {
+        {
+            .buffer = bindPoses->GetDeviceLocal(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = bones->GetDeviceLocal(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = jobs->GetDeviceLocal(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+    };
+
+    VkWriteDescriptorSet wrts[] = {
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_SKIN_BIND_POSE,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_SKIN_BIND_POSE ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_SKIN_BONES,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_SKIN_BONES ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_SKIN_JOBS,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_SKIN_JOBS ],
+        },
+    };
+    static_assert( std::size( wrts ) == std::size( bufs ) );
+
+    vkUpdateDescriptorSets( device, std::size( wrts ), wrts, 0, nullptr );
+}
+
+void RTGL1::Skinning::CreatePipelineLayout( const VkDescriptorSetLayout* pSetLayouts,
+                                            uint32_t                     setLayoutCount )
+{
+    VkPipelineLayoutCreateInfo plLayoutInfo = {
+        .sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = setLayoutCount,
+        .pSetLayouts    = pSetLayouts,
+    };
+
+    VkResult r = vkCreatePipelineLayout( device, &plLayoutInfo, nullptr, &pipelineLayout );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME(
+        device, pipelineLayout, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "Skinning pipeline layout" );
+}
+
+void RTGL1::Skinning::CreatePipeline( const ShaderManager* shaderManager )
+{
+    VkComputePipelineCreateInfo plInfo = {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = shaderManager->GetStageInfo( "CSkinning" ),
+        .layout = pipelineLayout,
+    };
+
+    VkResult r = vkCreateComputePipelines( device,
+                                           shaderManager->GetPipelineCache(),
+                                           1,
+                                           &plInfo,
+                                           nullptr,
+                                           &pipeline );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, pipeline, VK_OBJECT_TYPE_PIPELINE, "Skinning pipeline" );
+}
+
+void RTGL1::Skinning::DestroyPipeline()
+{
+    vkDestroyPipeline( device, pipeline, nullptr );
+    pipeline = VK_NULL_HANDLE;
+}
+
+bool RTGL1::SkinVerticesOnCPU( const RgMeshPrimitiveInfo&        primitive,
+                               const RgMeshPrimitiveSkinningEXT& skin,
+                               std::vector< RgPrimitiveVertex >& dst )
+{
+    if( !primitive.pVertices || !skin.pSkinWeights || !skin.pBoneTransforms ||
+        skin.boneCount == 0 || skin.boneCount > SKIN_MAX_BONES_PER_PRIMITIVE )
+    {
+        return false;
+    }
+
+    dst.resize( primitive.vertexCount );
+
+    for( uint32_t i = 0; i < primitive.vertexCount; i++ )
+    {
+        const RgPrimitiveVertex&   src = primitive.pVertices[ i ];
+        const RgVertexSkinWeights& w   = skin.pSkinWeights[ i ];
+
+        float skinned[ 3 ][ 4 ] = {};
+        for( uint32_t j = 0; j < 4; j++ )
+        {
+            if( w.joints[ j ] >= skin.boneCount )
+            {
+                continue;
+            }
+
+            // quantized the same way as for GPU, so both give the same pose
+            const float weight = float( PackUnorm8( w.weights[ j ] ) ) / 255.f;
+            const auto& bone   = skin.pBoneTransforms[ w.joints[ j ] ].matrix;
+
+            for( uint32_t r = 0; r < 3; r++ )
+            {
+                for( uint32_t c = 0; c < 4; c++ )
+                {
+                    skinned[ r ][ c ] += weight * bone[ r ][ c ];
+                }
+            }
+        }
+
+        const RgFloat3D n = Utils::UnpackNormal( src.normalPacked );
+
+        float position[ 3 ];
+        float normal[ 3 ];
+        for( uint32_t r = 0; r < 3; r++ )
+        {
+            position[ r ] = skinned[ r ][ 0 ] * src.position[ 0 ] +
+                            skinned[ r ][ 1 ] * src.position[ 1 ] +
+                            skinned[ r ][ 2 ] * src.position[ 2 ] + skinned[ r ][ 3 ];
+            normal[ r ] = skinned[ r ][ 0 ] * n.data[ 0 ] + skinned[ r ][ 1 ] * n.data[ 1 ] +
+                          skinned[ r ][ 2 ] * n.data[ 2 ];
+        }
+
+        dst[ i ]               = src;
+        dst[ i ].position[ 0 ] = position[ 0 ];
+        dst[ i ].position[ 1 ] = position[ 1 ];
+        dst[ i ].position[ 2 ] = position[ 2 ];
+        dst[ i ].normalPacked  = Utils::TryNormalize( normal )
+                                     ? Utils::PackNormal( normal[ 0 ], normal[ 1 ], normal[ 2 ] )
+                                     : Utils::PackNormal( 0, 1, 0 );
+    }
+
+    return true;
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "AutoBuffer.h"
+#include "Containers.h"
+#include "GlobalUniform.h"
+#include "ShaderManager.h"
+#include "UniqueID.h"
+
+namespace RTGL1
+{
+
+// Dynamic primitives with RgMeshPrimitiveSkinningEXT are skinned on GPU from a bind pose,
+// that is kept in GPU memory between the frames, and a bone palette that is uploaded
+// each frame. The skinned vertices are written directly into the dynamic vertex buffer.
+class Skinning : public IShaderDependency
+{
+public:
+    Skinning( VkDevice                           device,
+              std::shared_ptr< MemoryAllocator > allocator,
+              const GlobalUniform&               uniform,
+              VkDescriptorSetLayout              vertexDataSetLayout,
+              const ShaderManager&               shaderManager );
+    ~Skinning() override;
+
+    Skinning( const Skinning& other )                = delete;
+    Skinning( Skinning&& other ) noexcept            = delete;
+    Skinning& operator=( const Skinning& other )     = delete;
+    Skinning& operator=( Skinning&& other ) noexcept = delete;
+
+    void BeginFrame( uint32_t frameIndex );
+
+    // Upload the bind pose, if it's new or its version changed.
+    // Returns its offset in the bind pose buffer; null, if the primitive
+    // can't be skinned on GPU in this frame, then CPU vertices should be used
+    auto PrepareBindPose( uint32_t                          frameIndex,
+                          const PrimitiveUniqueID&          uniqueID,
+                          const RgMeshPrimitiveInfo&        primitive,
+                          const RgMeshPrimitiveSkinningEXT& skin ) -> std::optional< uint32_t >;
+    // Must be called after successful PrepareBindPose of the same primitive
+    void AddJob( uint32_t                          frameIndex,
+                 uint32_t                          bindPoseOffset,
+                 uint32_t                          vertexCount,
+                 const RgMeshPrimitiveSkinningEXT& skin,
+                 uint32_t                          dstVertexIndex );
+    bool HasJobs() const { return jobCount > 0; }
+
+    // Must be called after dynamic vertex data is copied from staging,
+    // and before BLAS-es that use the skinned vertices are built
+    void Dispatch( VkCommandBuffer      cmd,
+                   uint32_t             frameIndex,
+                   const GlobalUniform& uniform,
+                   VkDescriptorSet      vertexDataSet );
+
+    void OnShaderReload( const ShaderManager* shaderManager ) override;
+
+private:
+    void CreateDescriptors();
+    void CreatePipelineLayout( const VkDescriptorSetLayout* pSetLayouts, uint32_t setLayoutCount );
+    void CreatePipeline( const ShaderManager* shaderManager );
+    void DestroyPipeline();
+
+private:
+    VkDevice device;
+
+    std::unique_ptr< AutoBuffer > bindPoses;
+    std::unique_ptr< AutoBuffer > bones;
+    std::unique_ptr< AutoBuffer > jobs;
+
+    struct BindPose
+    {
+        uint32_t offset;
+        uint32_t vertexCount;
+        uint32_t version;
+        uint64_t lastUsedFrame;
+    };
+    rgl::unordered_map< PrimitiveUniqueID, BindPose > uploadedBindPoses;
+    // bind poses can't be freed individually, all are reuploaded on overflow
+    uint32_t                                          bindPoseVertexCount{ 0 };
+    bool                                              bindPoseResetPending{ false };
+    std::vector< VkBufferCopy >                       bindPoseCopies;
+    uint64_t                                          frameCounter{ 0 };
+
+    uint32_t boneCount{ 0 };
+    uint32_t jobCount{ 0 };
+
+    VkDescriptorPool      descPool;
+    VkDescriptorSetLayout descSetLayout;
+    VkDescriptorSet       descSet;
+
+    VkPipelineLayout pipelineLayout;
+    VkPipeline       pipeline;
+};
+
+// Same as CmSkinning.comp, for the passes that read the vertices on CPU:
+// rasterization and the exporter. Returns false, if the bind pose should be used as is
+bool SkinVerticesOnCPU( const RgMeshPrimitiveInfo&        primitive,
+                        const RgMeshPrimitiveSkinningEXT& skin,
+                        std::vector< RgPrimitiveVertex >& dst );
+
+}
@@ -27,6 +27,7 @@
 #include "DX12_CopyFramebuf.h"
 #include "FSR3_DX12.h"
 #include "HDR_Platform.h"
+#include "HitchRecorder.h"
 #include "LibraryConfig.h"
 #include "RgException.h"
 #include "DX12_Interop.h"
@@ -52,6 +53,11 @@ struct std::formatter< VkColorSpaceKHR >
     }
 };
 
+namespace RTGL1
+{
+extern bool g_supportsLowLatency2;
+}
+
 namespace
 {
 std::string JoinAsString( std::span< VkSurfaceFormatKHR > fs )
@@ -87,6 +93,12 @@ std::string JoinAsString( std::span< VkPresentModeKHR > fs )
     return s;
 }
 
+// blit converts linear values to sRGB, as if it was a regular LDR swapchain
+constexpr auto HeadlessFormat = VkSurfaceFormatKHR{
+    .format     = VK_FORMAT_R8G8B8A8_SRGB,
+    .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR,
+};
+
 bool IsNullExtent( const VkExtent2D& a )
 {
     return a.width == 0 || a.height == 0;
@@ -376,23 +388,29 @@ RTGL1::Swapchain::Swapchain( VkDevice                                _device,
                              std::shared_ptr< Framebuffers >         framebuffers,
                              std::shared_ptr< DLSS3_DX12 >&          dlss3,
                              std::shared_ptr< FSR3_DX12 >&           fsr3,
-                             std::optional< uint64_t >               gpuLuid )
+                             std::optional< uint64_t >               gpuLuid,
+                             std::optional< VkExtent2D >             headlessExtent )
     : device{ _device }
     , surface{ _surface }
     , physDevice{ _physDevice }
     , cmdManager{ std::move( _cmdManager ) }
     , allocator{ std::move( _allocator ) }
-    , m_surfaceFormat{ FindLdrAndHdrSurfaceFormats( _physDevice, _surface, true ) }
-    , m_presentMode{ FindPresentModes( _physDevice, _surface ) }
+    , m_surfaceFormat{ headlessExtent
+                           ? SurfaceFormats{ .ldr = HeadlessFormat }
+                           : FindLdrAndHdrSurfaceFormats( _physDevice, _surface, true ) }
+    , m_presentMode{ headlessExtent ? PresentModes{} : FindPresentModes( _physDevice, _surface ) }
     , m_dlss3{ dlss3 }
     , m_fsr3{ fsr3 }
     , m_framebuffers{ std::move( framebuffers ) }
     , m_gpuLuid{ gpuLuid }
+    , m_headlessExtent{ headlessExtent }
 {
+    assert( !!surface != !!m_headlessExtent );
+
     BakeStartupHDRState();
 
     // SHIPPING_HACK begin - precheck DLSS3, so it doesn't fail during the game
-    if( gpuLuid )
+    if( gpuLuid && !m_headlessExtent )
     {
         auto inst = DLSS3_DX12::MakeInstance( *gpuLuid, true );
         if( !inst )
@@ -405,11 +423,25 @@ RTGL1::Swapchain::Swapchain( VkDevice                                _device,
     // SHIPPING_HACK end
 }
 
-void RTGL1::Swapchain::AcquireImage( bool          vsync,
+void RTGL1::Swapchain::AcquireImage( uint32_t      frameIndex,
+                                     bool          vsync,
                                      bool          hdr,
                                      SwapchainType type,
                                      VkSemaphore   imageAvailableSemaphore )
 {
+    // frame fence with this index was waited, swapchains retired on it are not in use
+    currentFrameIndex = frameIndex;
+    DestroyRetiredSwapchains( frameIndex );
+
+    if( m_headlessExtent )
+    {
+        TryRecreate( *m_headlessExtent, false, false, SWAPCHAIN_TYPE_HEADLESS );
+
+        // an image per frame in flight, so there's no need to wait for anything
+        currentSwapchainIndex = frameIndex;
+        return;
+    }
+
     TryRecreate( CalculateOptimalExtent( physDevice, surface ), //
                  vsync,
                  hdr,
@@ -465,6 +497,26 @@ void RTGL1::Swapchain::AcquireImage( bool          vsync,
     }
 }
 
+bool RTGL1::Swapchain::AcquireAnotherImage( VkSemaphore imageAvailableSemaphore )
+{
+    if( !Valid() || m_type != SWAPCHAIN_TYPE_VULKAN_NATIVE )
+    {
+        assert( 0 );
+        return false;
+    }
+
+    assert( imageAvailableSemaphore );
+    VkResult r = vkAcquireNextImageKHR( device,
+                                        swapchain,
+                                        UINT64_MAX,
+                                        imageAvailableSemaphore,
+                                        VK_NULL_HANDLE,
+                                        &currentSwapchainIndex );
+
+    // on suboptimal, the semaphore is still signaled; recreation happens on present
+    return r == VK_SUCCESS || r == VK_SUBOPTIMAL_KHR;
+}
+
 void RTGL1::Swapchain::BlitForPresent( VkCommandBuffer   cmd,
                                        VkImage           srcImage,
                                        const VkExtent2D& srcSize,
@@ -515,6 +567,8 @@ void RTGL1::Swapchain::BlitForPresent( VkCommandBuffer   cmd,
     VkImageLayout swapchainImageLayout = m_type == SWAPCHAIN_TYPE_VULKAN_NATIVE
                                              ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
                                              : VK_IMAGE_LAYOUT_GENERAL;
+    // UNDEFINED, if the image is used for the first time since the swapchain creation
+    VkImageLayout swapchainPrevLayout = swapchainLayouts[ currentSwapchainIndex ];
 
     {
         VkImageMemoryBarrier2 bs[] = {
@@ -539,7 +593,7 @@ void RTGL1::Swapchain::BlitForPresent( VkCommandBuffer   cmd,
                 .srcAccessMask       = VK_ACCESS_2_NONE,
                 .dstStageMask        = VK_PIPELINE_STAGE_2_BLIT_BIT,
                 .dstAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
-                .oldLayout           = swapchainImageLayout,
+                .oldLayout           = swapchainPrevLayout,
                 .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                 .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
                 .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
@@ -618,6 +672,8 @@ void RTGL1::Swapchain::BlitForPresent( VkCommandBuffer   cmd,
 
         svkCmdPipelineBarrier2KHR( cmd, &dep );
     }
+
+    swapchainLayouts[ currentSwapchainIndex ] = swapchainImageLayout;
 }
 
 void RTGL1::Swapchain::OnQueuePresent( VkResult queuePresentResult )
@@ -633,6 +689,111 @@ void RTGL1::Swapchain::OnQueuePresent( VkResult queuePresentResult )
     }
 }
 
+void RTGL1::Swapchain::CopyForReadback( VkCommandBuffer cmd, uint64_t frameNumber )
+{
+    if( !Valid() || !IsHeadless() )
+    {
+        assert( 0 );
+        return;
+    }
+
+    VkImage       image    = swapchainImages[ currentSwapchainIndex ];
+    const Buffer& readback = m_headlessReadback[ currentSwapchainIndex ];
+
+    {
+        auto b = VkImageMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+            .pNext               = nullptr,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_BLIT_BIT,
+            .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
+            .oldLayout           = swapchainLayouts[ currentSwapchainIndex ],
+            .newLayout           = swapchainLayouts[ currentSwapchainIndex ],
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .image               = image,
+            .subresourceRange    = {
+                   .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                   .baseMipLevel   = 0,
+                   .levelCount     = 1,
+                   .baseArrayLayer = 0,
+                   .layerCount     = 1,
+            },
+        };
+
+        auto dep = VkDependencyInfo{
+            .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .imageMemoryBarrierCount = 1,
+            .pImageMemoryBarriers    = &b,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    auto region = VkBufferImageCopy{
+        .bufferOffset      = 0,
+        .bufferRowLength   = 0,
+        .bufferImageHeight = 0,
+        .imageSubresource  = {
+             .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+             .mipLevel       = 0,
+             .baseArrayLayer = 0,
+             .layerCount     = 1,
+        },
+        .imageOffset = {},
+        .imageExtent = { surfaceExtent.width, surfaceExtent.height, 1 },
+    };
+
+    vkCmdCopyImageToBuffer( cmd,
+                            image,
+                            swapchainLayouts[ currentSwapchainIndex ],
+                            readback.GetBuffer(),
+                            1,
+                            &region );
+
+    {
+        auto b = VkBufferMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .srcStageMask        = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .srcAccessMask       = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask        = VK_PIPELINE_STAGE_2_HOST_BIT,
+            .dstAccessMask       = VK_ACCESS_2_HOST_READ_BIT,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = readback.GetBuffer(),
+            .offset              = 0,
+            .size                = VK_WHOLE_SIZE,
+        };
+
+        auto dep = VkDependencyInfo{
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+
+        svkCmdPipelineBarrier2KHR( cmd, &dep );
+    }
+
+    m_headlessFrameNumber[ currentSwapchainIndex ] = frameNumber;
+}
+
+auto RTGL1::Swapchain::GetHeadlessFrame( uint32_t frameIndex ) const -> RgUtilHeadlessFrame
+{
+    if( !IsHeadless() || frameIndex >= swapchainImages.size() ||
+        !m_headlessFrameNumber[ frameIndex ] )
+    {
+        return RgUtilHeadlessFrame{};
+    }
+
+    return RgUtilHeadlessFrame{
+        .pPixels     = m_headlessPixels[ frameIndex ],
+        .width       = surfaceExtent.width,
+        .height      = surfaceExtent.height,
+        .frameNumber = *m_headlessFrameNumber[ frameIndex ],
+    };
+}
+
 bool RTGL1::Swapchain::Valid() const
 {
     return m_type != SWAPCHAIN_TYPE_NONE && !IsNullExtent( surfaceExtent ) &&
@@ -678,18 +839,52 @@ bool RTGL1::Swapchain::TryRecreate( const VkExtent2D& newExtent,
         return false;
     }
 
-    vkDeviceWaitIdle( device );
-    dxgi::WaitIdle();
+    RG_HITCH_MARKER( "Swapchain recreation" );
+
+    // a native swapchain is retired through 'oldSwapchain' and destroyed later,
+    // so only DXGI swapchains (and their shared images) require the GPU to be idle
+    const bool nativeOnly = ( m_type == SWAPCHAIN_TYPE_VULKAN_NATIVE || //
+                              m_type == SWAPCHAIN_TYPE_NONE ) &&
+                            ( type == SWAPCHAIN_TYPE_VULKAN_NATIVE || //
+                              type == SWAPCHAIN_TYPE_NONE );
+
+    if( !nativeOnly )
+    {
+        vkDeviceWaitIdle( device );
+        dxgi::WaitIdle();
+    }
 
     VkSwapchainKHR old = DestroyWithoutSwapchain();
     Create( newExtent, vsync, hdr, type, old );
 
-    vkDeviceWaitIdle( device );
-    dxgi::WaitIdle();
+    if( !nativeOnly )
+    {
+        vkDeviceWaitIdle( device );
+        dxgi::WaitIdle();
+    }
 
     return true;
 }
 
+void RTGL1::Swapchain::RetireSwapchain( VkSwapchainKHR old )
+{
+    if( old != VK_NULL_HANDLE )
+    {
+        // can't destroy immediately, as the current and previous frames might still present
+        // to it; the frame fence with the same index guarantees that they are done
+        retiredSwapchains[ currentFrameIndex ].push_back( old );
+    }
+}
+
+void RTGL1::Swapchain::DestroyRetiredSwapchains( uint32_t frameIndex )
+{
+    for( VkSwapchainKHR old : retiredSwapchains[ frameIndex ] )
+    {
+        vkDestroySwapchainKHR( device, old, nullptr );
+    }
+    retiredSwapchains[ frameIndex ].clear();
+}
+
 void RTGL1::Swapchain::Create( const VkExtent2D& size, //
                                bool              vsync,
                                bool              hdr,
@@ -805,6 +1000,12 @@ void RTGL1::Swapchain::Create( const VkExtent2D& size, //
     };
 
     auto l_safeHdr = [ this ]( bool hdr ) -> bool {
+        // don't touch the display state, if nothing is presented
+        if( m_headlessExtent )
+        {
+            return false;
+        }
+
         if( hdr && !SupportsHDR() )
         {
             assert( 0 ); // should be sanitized before Create()
@@ -876,17 +1077,15 @@ void RTGL1::Swapchain::Create( const VkExtent2D& size, //
     if( m_type == SWAPCHAIN_TYPE_NONE )
     {
         assert( IsNullExtent( surfaceExtent ) );
-        if( oldSwapchain )
-        {
-            vkDestroySwapchainKHR( device, oldSwapchain, nullptr );
-            oldSwapchain = nullptr;
-        }
+        RetireSwapchain( oldSwapchain );
+        return;
+    }
+    if( m_type == SWAPCHAIN_TYPE_HEADLESS )
+    {
+        assert( oldSwapchain == VK_NULL_HANDLE );
+        CreateHeadless();
         return;
     }
-
-    const VkImageLayout targetLayout =
-        ( m_type == SWAPCHAIN_TYPE_VULKAN_NATIVE ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
-                                                 : VK_IMAGE_LAYOUT_GENERAL );
 
     const VkSurfaceFormatKHR surfaceFormat = isHDR ? *m_surfaceFormat.hdr //
                                                    : m_surfaceFormat.ldr;
@@ -917,8 +1116,15 @@ void RTGL1::Swapchain::Create( const VkExtent2D& size, //
         this->m_fsr3  = {};
         this->m_dlss3 = {};
 
+        // required to set latency sleep mode and markers on this swapchain
+        auto latencyInfo = VkSwapchainLatencyCreateInfoNV{
+            .sType             = VK_STRUCTURE_TYPE_SWAPCHAIN_LATENCY_CREATE_INFO_NV,
+            .latencyModeEnable = VK_TRUE,
+        };
+
         auto swapchainInfo = VkSwapchainCreateInfoKHR{
             .sType            = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+            .pNext            = g_supportsLowLatency2 ? &latencyInfo : nullptr,
             .surface          = surface,
             .minImageCount    = CheckAndCalcImageCount( surface, physDevice, surfaceExtent ),
             .imageFormat      = surfaceFormat.format,
@@ -938,10 +1144,7 @@ void RTGL1::Swapchain::Create( const VkExtent2D& size, //
 
         r = vkCreateSwapchainKHR( device, &swapchainInfo, nullptr, &swapchain );
         VK_CHECKERROR( r );
-        if( oldSwapchain != VK_NULL_HANDLE )
-        {
-            vkDestroySwapchainKHR( device, oldSwapchain, nullptr );
-        }
+        RetireSwapchain( oldSwapchain );
 
         uint32_t imageCount{ 0 };
         r = vkGetSwapchainImagesKHR( device, swapchain, &imageCount, nullptr );
@@ -950,8 +1153,14 @@ void RTGL1::Swapchain::Create( const VkExtent2D& size, //
         swapchainImages.resize( imageCount );
         r = vkGetSwapchainImagesKHR( device, swapchain, &imageCount, swapchainImages.data() );
         VK_CHECKERROR( r );
+
+        // native images are transitioned on their first BlitForPresent,
+        // so there's no need to submit and wait here
+        swapchainLayouts.assign( imageCount, VK_IMAGE_LAYOUT_UNDEFINED );
+        return;
     }
 
+    // DXGI images are shared with DX12, so they must be in a known layout before any use
     VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
     for( VkImage img : swapchainImages )
     {
@@ -962,17 +1171,77 @@ void RTGL1::Swapchain::Create( const VkExtent2D& size, //
                                  0,
                                  0,
                                  VK_IMAGE_LAYOUT_UNDEFINED,
-                                 targetLayout );
+                                 VK_IMAGE_LAYOUT_GENERAL );
         }
     }
     cmdManager->Submit( cmd );
     cmdManager->WaitGraphicsIdle();
+
+    swapchainLayouts.assign( swapchainImages.size(), VK_IMAGE_LAYOUT_GENERAL );
 }
 
-VkSwapchainKHR RTGL1::Swapchain::DestroyWithoutSwapchain()
+void RTGL1::Swapchain::CreateHeadless()
 {
-    vkDeviceWaitIdle( device );
+    assert( m_type == SWAPCHAIN_TYPE_HEADLESS );
+    assert( m_headlessExtent && surfaceExtent == *m_headlessExtent );
+
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_FRAMEBUFFERS };
+
+    const uint32_t     imageCount = FramesInFlight();
+    const VkDeviceSize pixelsSize =
+        VkDeviceSize{ 4 } * surfaceExtent.width * surfaceExtent.height;
+
+    swapchainImages.resize( imageCount );
+    swapchainMemory.resize( imageCount );
+
+    for( uint32_t i = 0; i < imageCount; i++ )
+    {
+        auto info = VkImageCreateInfo{
+            .sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+            .imageType     = VK_IMAGE_TYPE_2D,
+            .format        = m_surfaceFormat.ldr.format,
+            .extent        = { surfaceExtent.width, surfaceExtent.height, 1 },
+            .mipLevels     = 1,
+            .arrayLayers   = 1,
+            .samples       = VK_SAMPLE_COUNT_1_BIT,
+            .tiling        = VK_IMAGE_TILING_OPTIMAL,
+            .usage         = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+            .sharingMode   = VK_SHARING_MODE_EXCLUSIVE,
+            .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        };
+
+        VkResult r = vkCreateImage( device, &info, nullptr, &swapchainImages[ i ] );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device, swapchainImages[ i ], VK_OBJECT_TYPE_IMAGE, "Headless image" );
 
+        VkMemoryRequirements memReqs = {};
+        vkGetImageMemoryRequirements( device, swapchainImages[ i ], &memReqs );
+
+        swapchainMemory[ i ] = allocator->AllocDedicated( memReqs,
+                                                          VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                                          MemoryAllocator::AllocType::DEFAULT,
+                                                          "Headless image memory" );
+
+        r = vkBindImageMemory( device, swapchainImages[ i ], swapchainMemory[ i ], 0 );
+        VK_CHECKERROR( r );
+
+        m_headlessReadback[ i ].Init( *allocator,
+                                      pixelsSize,
+                                      VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                      "Headless readback" );
+        // persistently mapped, so the app can read it at any time
+        m_headlessPixels[ i ]      = m_headlessReadback[ i ].Map();
+        m_headlessFrameNumber[ i ] = std::nullopt;
+    }
+
+    // transitioned on their first BlitForPresent
+    swapchainLayouts.assign( imageCount, VK_IMAGE_LAYOUT_UNDEFINED );
+}
+
+VkSwapchainKHR RTGL1::Swapchain::DestroyWithoutSwapchain()
+{
     if( m_type == SWAPCHAIN_TYPE_DXGI || //
         m_type == SWAPCHAIN_TYPE_FRAME_GENERATION_DLSS3 ||
         m_type == SWAPCHAIN_TYPE_FRAME_GENERATION_FSR3 )
@@ -989,6 +1258,24 @@ VkSwapchainKHR RTGL1::Swapchain::DestroyWithoutSwapchain()
             vkDestroyImage( device, i, nullptr );
         }
     }
+    else if( m_type == SWAPCHAIN_TYPE_HEADLESS )
+    {
+        for( VkDeviceMemory m : swapchainMemory )
+        {
+            MemoryAllocator::FreeDedicated( device, m );
+        }
+        for( VkImage i : swapchainImages )
+        {
+            vkDestroyImage( device, i, nullptr );
+        }
+        for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+        {
+            m_headlessReadback[ i ].TryUnmap();
+            m_headlessReadback[ i ].Destroy();
+            m_headlessPixels[ i ]      = nullptr;
+            m_headlessFrameNumber[ i ] = std::nullopt;
+        }
+    }
     else
     {
         assert( swapchainMemory.empty() );
@@ -996,6 +1283,7 @@ VkSwapchainKHR RTGL1::Swapchain::DestroyWithoutSwapchain()
 
     swapchainImages.clear();
     swapchainMemory.clear();
+    swapchainLayouts.clear();
 
     VkSwapchainKHR old = this->swapchain;
 
@@ -1006,8 +1294,17 @@ VkSwapchainKHR RTGL1::Swapchain::DestroyWithoutSwapchain()
 
 RTGL1::Swapchain::~Swapchain()
 {
+    vkDeviceWaitIdle( device );
+
     VkSwapchainKHR old = DestroyWithoutSwapchain();
-    vkDestroySwapchainKHR( device, old, nullptr );
+    if( old )
+    {
+        vkDestroySwapchainKHR( device, old, nullptr );
+    }
+    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        DestroyRetiredSwapchains( i );
+    }
 
     // restore the state at the app start
     TryRevertHDRStateToStartup();
@@ -1037,6 +1334,11 @@ bool RTGL1::Swapchain::IsST2084ColorSpace() const
     return m_surfaceFormat.hdr->colorSpace == VK_COLOR_SPACE_HDR10_ST2084_EXT;
 }
 
+bool RTGL1::Swapchain::IsVSync() const
+{
+    return m_vsync;
+}
+
 bool RTGL1::Swapchain::WithDXGI() const
 {
     return m_type == SWAPCHAIN_TYPE_DXGI || //
@@ -1044,6 +1346,11 @@ bool RTGL1::Swapchain::WithDXGI() const
            m_type == SWAPCHAIN_TYPE_FRAME_GENERATION_FSR3;
 }
 
+bool RTGL1::Swapchain::IsHeadless() const
+{
+    return m_type == SWAPCHAIN_TYPE_HEADLESS;
+}
+
 bool RTGL1::Swapchain::WithDLSS3FrameGeneration() const
 {
     if( m_type == SWAPCHAIN_TYPE_FRAME_GENERATION_DLSS3 )
@@ -1112,6 +1419,11 @@ VkSwapchainKHR RTGL1::Swapchain::GetHandle() const
     return swapchain;
 }
 
+VkSwapchainKHR RTGL1::Swapchain::GetNativeHandle() const
+{
+    return Valid() && !WithDXGI() ? swapchain : VK_NULL_HANDLE;
+}
+
 void RTGL1::Swapchain::MarkAsFailed( SwapchainType t )
 {
     if( t == SWAPCHAIN_TYPE_DXGI ||                   //
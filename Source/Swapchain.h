@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include "Buffer.h"
 #include "Common.h"
 #include "CommandBufferManager.h"
 #include "ISwapchainDependency.h"
@@ -67,10 +68,12 @@ enum SwapchainType
     SWAPCHAIN_TYPE_DXGI,
     SWAPCHAIN_TYPE_FRAME_GENERATION_DLSS3,
     SWAPCHAIN_TYPE_FRAME_GENERATION_FSR3,
+    // Offscreen images without a surface, the result is read back instead of presenting
+    SWAPCHAIN_TYPE_HEADLESS,
 };
 // clang-format off
 template< typename T > constexpr size_t enum_size_t() = delete;
-template<>             constexpr size_t enum_size_t< SwapchainType >() { return 5; }
+template<>             constexpr size_t enum_size_t< SwapchainType >() { return 6; }
 template< typename T > constexpr size_t enum_size = enum_size_t< T >();
 // clang-format on
 
@@ -86,7 +89,8 @@ public:
                std::shared_ptr< Framebuffers >         framebuffers,
                std::shared_ptr< DLSS3_DX12 >&          dlss3,
                std::shared_ptr< FSR3_DX12 >&           fsr3,
-               std::optional< uint64_t >               gpuLuid );
+               std::optional< uint64_t >               gpuLuid,
+               std::optional< VkExtent2D >             headlessExtent );
     ~Swapchain();
 
     Swapchain( const Swapchain& )                = delete;
@@ -94,25 +98,36 @@ public:
     Swapchain& operator=( const Swapchain& )     = delete;
     Swapchain& operator=( Swapchain&& ) noexcept = delete;
 
-    void AcquireImage( bool          vsync,
+    // Must be called after the frame fence with 'frameIndex' was waited
+    void AcquireImage( uint32_t      frameIndex,
+                       bool          vsync,
                        bool          hdr,
                        SwapchainType type,
                        VkSemaphore   imageAvailableSemaphore );
+    // Acquire one more image within a frame, after the current one was presented.
+    // Only for a native Vulkan swapchain. False, if failed: then skip the present
+    bool AcquireAnotherImage( VkSemaphore imageAvailableSemaphore );
     void BlitForPresent( VkCommandBuffer   cmd,
                          VkImage           srcImage,
                          const VkExtent2D& srcSize,
                          VkFilter          filter,
                          VkImageLayout     srcImageLayout = VK_IMAGE_LAYOUT_GENERAL );
     void OnQueuePresent( VkResult queuePresentResult );
+    // Only for a headless swapchain: must be called after BlitForPresent.
+    // The copy can be read by GetHeadlessFrame, after the frame fence is waited
+    void CopyForReadback( VkCommandBuffer cmd, uint64_t frameNumber );
+    auto GetHeadlessFrame( uint32_t frameIndex ) const -> RgUtilHeadlessFrame;
 
     bool Valid() const;
 
     bool SupportsHDR() const;
     bool IsHDREnabled() const;
     bool IsST2084ColorSpace() const;
+    bool IsVSync() const;
     bool WithDXGI() const;
     bool WithDLSS3FrameGeneration() const;
     bool WithFSR3FrameGeneration() const;
+    bool IsHeadless() const;
 
     auto FailReason( SwapchainType t ) const -> const char*;
 
@@ -120,6 +135,8 @@ public:
     auto GetHeight() const -> uint32_t;
     auto GetCurrentImageIndex() const -> uint32_t;
     auto GetHandle() const -> VkSwapchainKHR;
+    // Null, if not a valid Vulkan swapchain
+    auto GetNativeHandle() const -> VkSwapchainKHR;
 
     void MarkAsFailed( SwapchainType t );
 
@@ -136,8 +153,12 @@ private:
                  SwapchainType     type,
                  VkSwapchainKHR    oldSwapchain = VK_NULL_HANDLE );
 
+    void CreateHeadless();
     auto DestroyWithoutSwapchain() -> VkSwapchainKHR;
 
+    void RetireSwapchain( VkSwapchainKHR old );
+    void DestroyRetiredSwapchains( uint32_t frameIndex );
+
 private:
     VkDevice                                device{};
     VkSurfaceKHR                            surface{};
@@ -156,8 +177,12 @@ private:
     VkSwapchainKHR                swapchain{};
     std::vector< VkImage >        swapchainImages{};
     std::vector< VkDeviceMemory > swapchainMemory{};
+    std::vector< VkImageLayout >  swapchainLayouts{};
 
     uint32_t currentSwapchainIndex{ UINT32_MAX };
+    uint32_t currentFrameIndex{ 0 };
+
+    std::vector< VkSwapchainKHR > retiredSwapchains[ MAX_FRAMES_IN_FLIGHT ]{};
 
     std::shared_ptr< DLSS3_DX12 >& m_dlss3;
     std::shared_ptr< FSR3_DX12 >&  m_fsr3;
@@ -167,6 +192,11 @@ private:
     std::optional< std::string > m_failed[ enum_size< SwapchainType > ]{};
 
     std::optional< uint64_t > m_gpuLuid{};
+
+    std::optional< VkExtent2D > m_headlessExtent{};
+    Buffer                      m_headlessReadback[ MAX_FRAMES_IN_FLIGHT ]{};
+    const void*                 m_headlessPixels[ MAX_FRAMES_IN_FLIGHT ]{};
+    std::optional< uint64_t >   m_headlessFrameNumber[ MAX_FRAMES_IN_FLIGHT ]{};
 };
 
 }
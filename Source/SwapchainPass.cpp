@@ -44,7 +44,7 @@ RTGL1::SwapchainPass::SwapchainPass( VkDevice                    _device,
                                                  _pipelineLayout,
                                                  swapchainRenderPass,
                                                  _shaderManager,
-                                                 "VertDefault",
+                                                 "VertSwapchain",
                                                  "FragSwapchain",
                                                  false,
                                                  _instanceInfo.rasterizedVertexColorGamma );
@@ -53,7 +53,7 @@ RTGL1::SwapchainPass::SwapchainPass( VkDevice                    _device,
                                                  _pipelineLayout,
                                                  swapchainRenderPass_hudOnly,
                                                  _shaderManager,
-                                                 "VertDefault",
+                                                 "VertSwapchain",
                                                  "FragSwapchain",
                                                  false,
                                                  _instanceInfo.rasterizedVertexColorGamma );
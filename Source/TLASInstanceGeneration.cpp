@@ -0,0 +1,372 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "TLASInstanceGeneration.h"
+
+#include "CmdLabel.h"
+#include "Utils.h"
+
+namespace
+{
+
+// must be same as in CmTlasInstances.comp
+struct TlasInstancesPush
+{
+    uint32_t instanceCount;
+    uint32_t cullingEnabled;
+    float    maxDistance;
+    float    frustumMargin;
+    uint32_t frameIndex;
+};
+
+}
+
+RTGL1::TLASInstanceGeneration::TLASInstanceGeneration(
+    VkDevice                           _device,
+    std::shared_ptr< MemoryAllocator > _allocator,
+    const GlobalUniform&               _uniform,
+    VkDescriptorSetLayout              _vertexDataSetLayout,
+    VkBuffer                           _instanceBuffer,
+    uint32_t                           _maxInstanceCount,
+    const ShaderManager&               _shaderManager )
+    : device( _device )
+    , descPool( VK_NULL_HANDLE )
+    , descSetLayout( VK_NULL_HANDLE )
+    , descSet( VK_NULL_HANDLE )
+    , pipelineLayout( VK_NULL_HANDLE )
+    , pipeline( VK_NULL_HANDLE )
+{
+    culledCounts.Init( *_allocator,
+                       MAX_FRAMES_IN_FLIGHT * sizeof( uint32_t ),
+                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                       "TLAS instances culled count" );
+    {
+        auto* counts = static_cast< uint32_t* >( culledCounts.Map() );
+        std::fill_n( counts, MAX_FRAMES_IN_FLIGHT, 0 );
+        culledCounts.Unmap();
+    }
+
+    sources = std::make_unique< AutoBuffer >( std::move( _allocator ) );
+    sources->Create( VkDeviceSize{ _maxInstanceCount } * sizeof( ShTlasInstanceSource ),
+                     VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                     "TLAS instance sources" );
+
+    CreateDescriptors( _instanceBuffer );
+
+    VkDescriptorSetLayout setLayouts[] = {
+        _uniform.GetDescSetLayout(),
+        _vertexDataSetLayout,
+        descSetLayout,
+    };
+
+    CreatePipelineLayout( setLayouts, std::size( setLayouts ) );
+    CreatePipeline( &_shaderManager );
+}
+
+RTGL1::TLASInstanceGeneration::~TLASInstanceGeneration()
+{
+    vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
+    DestroyPipeline();
+    vkDestroyDescriptorPool( device, descPool, nullptr );
+    vkDestroyDescriptorSetLayout( device, descSetLayout, nullptr );
+}
+
+uint32_t RTGL1::TLASInstanceGeneration::ReadCulledCount( uint32_t frameIndex )
+{
+    auto* counts = static_cast< uint32_t* >( culledCounts.Map() );
+
+    const uint32_t count = std::exchange( counts[ frameIndex ], 0 );
+
+    culledCounts.Unmap();
+    return count;
+}
+
+auto RTGL1::TLASInstanceGeneration::GetSources( uint32_t frameIndex ) -> ShTlasInstanceSource*
+{
+    return sources->GetMappedAs< ShTlasInstanceSource* >( frameIndex );
+}
+
+void RTGL1::TLASInstanceGeneration::Dispatch( VkCommandBuffer      cmd,
+                                              uint32_t             frameIndex,
+                                              const GlobalUniform& uniform,
+                                              VkDescriptorSet      vertexDataSet,
+                                              uint32_t             instanceCount,
+                                              const RgDrawFrameInstanceCullingParams& culling )
+{
+    if( instanceCount == 0 )
+    {
+        return;
+    }
+
+    CmdLabel label( cmd, "TLAS instances" );
+
+    {
+        // sources might still be read by the previous frame,
+        // instances -- by the previous TLAS build
+        VkMemoryBarrier barrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = 0,
+        };
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                                  VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              0,
+                              1,
+                              &barrier,
+                              0,
+                              nullptr,
+                              0,
+                              nullptr );
+    }
+
+    sources->CopyFromStaging( cmd, frameIndex, instanceCount * sizeof( ShTlasInstanceSource ) );
+
+
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+
+    VkDescriptorSet sets[] = {
+        uniform.GetDescSet( frameIndex ),
+        vertexDataSet,
+        descSet,
+    };
+
+    vkCmdBindDescriptorSets( cmd,
+                             VK_PIPELINE_BIND_POINT_COMPUTE,
+                             pipelineLayout,
+                             0,
+                             std::size( sets ),
+                             sets,
+                             0,
+                             nullptr );
+
+    const TlasInstancesPush push = {
+        .instanceCount  = instanceCount,
+        .cullingEnabled = culling.enable ? 1u : 0u,
+        .maxDistance    = culling.maxDistance,
+        .frustumMargin  = culling.frustumMargin,
+        .frameIndex     = frameIndex,
+    };
+
+    vkCmdPushConstants(
+        cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( push ), &push );
+
+    vkCmdDispatch(
+        cmd, Utils::GetWorkGroupCount( instanceCount, COMPUTE_TLAS_INSTANCES_GROUP_SIZE_X ), 1, 1 );
+
+
+    {
+        // instances are the input of the TLAS build
+        VkMemoryBarrier barrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+        };
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                              0,
+                              1,
+                              &barrier,
+                              0,
+                              nullptr,
+                              0,
+                              nullptr );
+    }
+}
+
+void RTGL1::TLASInstanceGeneration::OnShaderReload( const ShaderManager* shaderManager )
+{
+    if( !shaderManager->AnyChanged( { "CTlasInstances" } ) )
+    {
+        return;
+    }
+
+    DestroyPipeline();
+    CreatePipeline( shaderManager );
+}
+
+void RTGL1::TLASInstanceGeneration::CreateDescriptors( VkBuffer instanceBuffer )
+{
+    VkResult r;
+
+    VkDescriptorSetLayoutBinding bindings[] = {
+        {
+            .binding         = BINDING_TLAS_INSTANCE_SOURCES,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_TLAS_INSTANCES,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_TLAS_INSTANCES_CULLED,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = std::size( bindings ),
+        .pBindings    = bindings,
+    };
+
+    r = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descSetLayout );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device,
+                    descSetLayout,
+                    VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+                    "TLAS instances Desc set layout" );
+
+    VkDescriptorPoolSize poolSize = {
+        .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = std::size( bindings ),
+    };
+
+    VkDescriptorPoolCreateInfo poolInfo = {
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets       = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes    = &poolSize,
+    };
+
+    r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &descPool );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, descPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "TLAS instances Desc pool" );
+
+    VkDescriptorSetAllocateInfo allocInfo = {
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool     = descPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts        = &descSetLayout,
+    };
+
+    r = vkAllocateDescriptorSets( device, &allocInfo, &descSet );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device, descSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "TLAS instances Desc set" );
+
+
+    VkDescriptorBufferInfo bufs[] = {
+        {
+            .buffer = sources->GetDeviceLocal(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = instanceBuffer,
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+        {
+            .buffer = culledCounts.GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        },
+    };
+
+    VkWriteDescriptorSet wrts[] = {
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_TLAS_INSTANCE_SOURCES,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_TLAS_INSTANCE_SOURCES ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_TLAS_INSTANCES,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_TLAS_INSTANCES ],
+        },
+        {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSet,
+            .dstBinding      = BINDING_TLAS_INSTANCES_CULLED,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufs[ BINDING_TLAS_INSTANCES_CULLED ],
+        },
+    };
+    static_assert( std::size( wrts ) == std::size( bufs ) );
+
+    vkUpdateDescriptorSets( device, std::size( wrts ), wrts, 0, nullptr );
+}
+
+void RTGL1::TLASInstanceGeneration::CreatePipelineLayout( const VkDescriptorSetLayout* pSetLayouts,
+                                                          uint32_t setLayoutCount )
+{
+    VkPushConstantRange push = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset     = 0,
+        .size       = sizeof( TlasInstancesPush ),
+    };
+
+    VkPipelineLayoutCreateInfo plLayoutInfo = {
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount         = setLayoutCount,
+        .pSetLayouts            = pSetLayouts,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &push,
+    };
+
+    VkResult r = vkCreatePipelineLayout( device, &plLayoutInfo, nullptr, &pipelineLayout );
+
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME(
+        device, pipelineLayout, VK_OBJECT_TYPE_PIPELINE_LAYOUT, "TLAS instances pipeline layout" );
+}
+
+void RTGL1::TLASInstanceGeneration::CreatePipeline( const ShaderManager* shaderManager )
+{
+    VkComputePipelineCreateInfo plInfo = {
+        .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage  = shaderManager->GetStageInfo( "CTlasInstances" ),
+        .layout = pipelineLayout,
+    };
+
+    VkResult r = vkCreateComputePipelines(
+        device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &pipeline );
+    VK_CHECKERROR( r );
+
+    SET_DEBUG_NAME( device, pipeline, VK_OBJECT_TYPE_PIPELINE, "TLAS instances pipeline" );
+}
+
+void RTGL1::TLASInstanceGeneration::DestroyPipeline()
+{
+    vkDestroyPipeline( device, pipeline, nullptr );
+    pipeline = VK_NULL_HANDLE;
+}
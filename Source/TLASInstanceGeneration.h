@@ -0,0 +1,93 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "AutoBuffer.h"
+#include "GlobalUniform.h"
+#include "ShaderManager.h"
+
+#include "Generated/ShaderCommonC.h"
+
+namespace RTGL1
+{
+
+// TLAS instance records are written on GPU: the transforms are taken from the geometry
+// instance buffer, so CPU only provides the BLAS address, mask and SBT offset.
+// Dynamic instances can be culled by distance and frustum, then they're made inactive
+// with a null BLAS reference, so their TLAS indices and geometry instances stay the same.
+class TLASInstanceGeneration : public IShaderDependency
+{
+public:
+    TLASInstanceGeneration( VkDevice                           device,
+                            std::shared_ptr< MemoryAllocator > allocator,
+                            const GlobalUniform&               uniform,
+                            VkDescriptorSetLayout              vertexDataSetLayout,
+                            VkBuffer                           instanceBuffer,
+                            uint32_t                           maxInstanceCount,
+                            const ShaderManager&               shaderManager );
+    ~TLASInstanceGeneration() override;
+
+    TLASInstanceGeneration( const TLASInstanceGeneration& other )                = delete;
+    TLASInstanceGeneration( TLASInstanceGeneration&& other ) noexcept            = delete;
+    TLASInstanceGeneration& operator=( const TLASInstanceGeneration& other )     = delete;
+    TLASInstanceGeneration& operator=( TLASInstanceGeneration&& other ) noexcept = delete;
+
+    // Instances that were culled on GPU, when the frame index was used last time.
+    // Must be called after the frame's fence is waited
+    uint32_t ReadCulledCount( uint32_t frameIndex );
+
+    // Array of 'maxInstanceCount', must be filled with the TLAS instances in their order
+    auto GetSources( uint32_t frameIndex ) -> ShTlasInstanceSource*;
+
+    // Geometry instances of the frame must be copied from staging before it.
+    // 'culling' is applied only to the sources with non-negative bounds radius
+    void Dispatch( VkCommandBuffer                         cmd,
+                   uint32_t                                frameIndex,
+                   const GlobalUniform&                    uniform,
+                   VkDescriptorSet                         vertexDataSet,
+                   uint32_t                                instanceCount,
+                   const RgDrawFrameInstanceCullingParams& culling );
+
+    void OnShaderReload( const ShaderManager* shaderManager ) override;
+
+private:
+    void CreateDescriptors( VkBuffer instanceBuffer );
+    void CreatePipelineLayout( const VkDescriptorSetLayout* pSetLayouts, uint32_t setLayoutCount );
+    void CreatePipeline( const ShaderManager* shaderManager );
+    void DestroyPipeline();
+
+private:
+    VkDevice device;
+
+    std::unique_ptr< AutoBuffer > sources;
+    // a counter per frame in flight, read on CPU
+    Buffer                        culledCounts;
+
+    VkDescriptorPool      descPool;
+    VkDescriptorSetLayout descSetLayout;
+    VkDescriptorSet       descSet;
+
+    VkPipelineLayout pipelineLayout;
+    VkPipeline       pipeline;
+};
+
+}
@@ -21,21 +21,43 @@
 #include "TextureDescriptors.h"
 #include "Const.h"
 
+#include "Generated/ShaderCommonC.h"
+
 using namespace RTGL1;
 
+namespace RTGL1
+{
+extern bool g_supportsUpdateAfterBind;
+}
+
+static_assert( SamplerManager::SamplerTableSize == TEXTURE_SAMPLER_TABLE_SIZE,
+               "Sampler table size must match the one in shaders" );
+
+namespace
+{
+    constexpr uint32_t NoSamplerIndex = UINT32_MAX;
+}
+
 TextureDescriptors::TextureDescriptors( VkDevice                          _device,
                                         std::shared_ptr< SamplerManager > _samplerManager,
                                         uint32_t                          _maxTextureCount,
-                                        uint32_t                          _bindingIndex )
+                                        uint32_t                          _bindingIndex,
+                                        std::optional< uint32_t >         _feedbackBindingIndex,
+                                        std::optional< SeparateSamplers > _separateSamplers )
     : device( _device )
     , samplerManager( std::move( _samplerManager ) )
     , bindingIndex( _bindingIndex )
+    , feedbackBindingIndex( _feedbackBindingIndex )
+    , separateSamplers( std::move( _separateSamplers ) )
+    , updateAfterBind( g_supportsUpdateAfterBind )
     , descPool( VK_NULL_HANDLE )
     , descLayout( VK_NULL_HANDLE )
     , descSets{}
     , emptyTextureImageView( VK_NULL_HANDLE )
     , emptyTextureImageLayout( VK_IMAGE_LAYOUT_UNDEFINED )
+    , currentImageInfoCount( 0 )
     , currentWriteCount( 0 )
+    , mappedSamplerIndices{}
 {
     writeImageInfos.resize( _maxTextureCount );
     writeInfos.resize( _maxTextureCount );
@@ -43,13 +65,28 @@ TextureDescriptors::TextureDescriptors( VkDevice                          _devic
     for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
     {
         writeCache[ i ].resize( _maxTextureCount );
+        if( updateAfterBind )
+        {
+            isBound[ i ].resize( _maxTextureCount, false );
+        }
     }
 
     CreateDescriptors( _maxTextureCount );
+
+    if( separateSamplers )
+    {
+        assert( separateSamplers->allocator );
+        CreateSamplerIndexBuffers( *separateSamplers->allocator, _maxTextureCount );
+    }
 }
 
 TextureDescriptors::~TextureDescriptors()
 {
+    for( auto& b : samplerIndexBuffers )
+    {
+        b.TryUnmap();
+    }
+
     vkDestroyDescriptorPool( device, descPool, nullptr );
     vkDestroyDescriptorSetLayout( device, descLayout, nullptr );
 }
@@ -70,20 +107,95 @@ void TextureDescriptors::SetEmptyTextureInfo( VkImageView view )
     emptyTextureImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 }
 
+void TextureDescriptors::SetFeedbackBuffer( VkBuffer buffer )
+{
+    assert( feedbackBindingIndex );
+
+    VkDescriptorBufferInfo bufInfo = {
+        .buffer = buffer,
+        .offset = 0,
+        .range  = VK_WHOLE_SIZE,
+    };
+
+    VkWriteDescriptorSet writes[ MAX_FRAMES_IN_FLIGHT ];
+    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        writes[ i ] = VkWriteDescriptorSet{
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSets[ i ],
+            .dstBinding      = *feedbackBindingIndex,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufInfo,
+        };
+    }
+
+    vkUpdateDescriptorSets( device, std::size( writes ), writes, 0, nullptr );
+}
+
 void TextureDescriptors::CreateDescriptors( uint32_t maxTextureCount )
 {
+    const VkDescriptorType imageType = separateSamplers ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+                                                        : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+
     {
-        VkDescriptorSetLayoutBinding binding = {
+        VkDescriptorSetLayoutBinding bindings[ 4 ];
+        VkDescriptorBindingFlags     bindingFlags[ 4 ] = {};
+        uint32_t                     bindingCount      = 0;
+
+        if( updateAfterBind )
+        {
+            bindingFlags[ bindingCount ] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                           VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                           VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        }
+        bindings[ bindingCount++ ] = {
             .binding         = bindingIndex,
-            .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorType  = imageType,
             .descriptorCount = maxTextureCount,
             .stageFlags      = VK_SHADER_STAGE_ALL,
         };
+        if( feedbackBindingIndex )
+        {
+            bindings[ bindingCount++ ] = {
+                .binding         = *feedbackBindingIndex,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_ALL,
+            };
+        }
+        if( separateSamplers )
+        {
+            bindings[ bindingCount++ ] = {
+                .binding         = separateSamplers->samplersBindingIndex,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLER,
+                .descriptorCount = SamplerManager::SamplerTableSize,
+                .stageFlags      = VK_SHADER_STAGE_ALL,
+            };
+            bindings[ bindingCount++ ] = {
+                .binding         = separateSamplers->samplerIndicesBindingIndex,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = 1,
+                .stageFlags      = VK_SHADER_STAGE_ALL,
+            };
+        }
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo = {
+            .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+            .bindingCount  = bindingCount,
+            .pBindingFlags = bindingFlags,
+        };
 
         VkDescriptorSetLayoutCreateInfo layoutInfo = {
             .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-            .bindingCount = 1,
-            .pBindings    = &binding,
+            .pNext        = updateAfterBind ? &flagsInfo : nullptr,
+            .flags        = updateAfterBind
+                                ? VkDescriptorSetLayoutCreateFlags(
+                                      VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT )
+                                : 0,
+            .bindingCount = bindingCount,
+            .pBindings    = bindings,
         };
 
         VkResult r = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descLayout );
@@ -94,16 +206,40 @@ void TextureDescriptors::CreateDescriptors( uint32_t maxTextureCount )
     }
 
     {
-        VkDescriptorPoolSize poolSize = {
-            .type            = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        const uint32_t storageBufferCount =
+            ( feedbackBindingIndex ? 1 : 0 ) + ( separateSamplers ? 1 : 0 );
+
+        VkDescriptorPoolSize poolSizes[ 3 ];
+        uint32_t             poolSizeCount = 0;
+
+        poolSizes[ poolSizeCount++ ] = {
+            .type            = imageType,
             .descriptorCount = maxTextureCount * MAX_FRAMES_IN_FLIGHT,
         };
+        if( storageBufferCount > 0 )
+        {
+            poolSizes[ poolSizeCount++ ] = {
+                .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                .descriptorCount = storageBufferCount * MAX_FRAMES_IN_FLIGHT,
+            };
+        }
+        if( separateSamplers )
+        {
+            poolSizes[ poolSizeCount++ ] = {
+                .type            = VK_DESCRIPTOR_TYPE_SAMPLER,
+                .descriptorCount = SamplerManager::SamplerTableSize * MAX_FRAMES_IN_FLIGHT,
+            };
+        }
 
         VkDescriptorPoolCreateInfo poolInfo = {
             .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .flags         = updateAfterBind
+                                 ? VkDescriptorPoolCreateFlags(
+                                       VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT )
+                                 : 0,
             .maxSets       = MAX_FRAMES_IN_FLIGHT,
-            .poolSizeCount = 1,
-            .pPoolSizes    = &poolSize,
+            .poolSizeCount = poolSizeCount,
+            .pPoolSizes    = poolSizes,
         };
 
         VkResult r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &descPool );
@@ -130,11 +266,57 @@ void TextureDescriptors::CreateDescriptors( uint32_t maxTextureCount )
     }
 }
 
+void TextureDescriptors::CreateSamplerIndexBuffers( MemoryAllocator& allocator,
+                                                    uint32_t         maxTextureCount )
+{
+    assert( separateSamplers );
+
+    for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
+    {
+        // host-visible, so only the changed slots are written, without any copy commands
+        samplerIndexBuffers[ i ].Init( allocator,
+                                       sizeof( uint32_t ) * maxTextureCount,
+                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                           VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                       "Texture sampler indices" );
+
+        mappedSamplerIndices[ i ] = static_cast< uint32_t* >( samplerIndexBuffers[ i ].Map() );
+        memset( mappedSamplerIndices[ i ], 0, sizeof( uint32_t ) * maxTextureCount );
+
+        samplerIndexCache[ i ].assign( maxTextureCount, 0 );
+
+        VkDescriptorBufferInfo bufInfo = {
+            .buffer = samplerIndexBuffers[ i ].GetBuffer(),
+            .offset = 0,
+            .range  = VK_WHOLE_SIZE,
+        };
+
+        VkWriteDescriptorSet write = {
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSets[ i ],
+            .dstBinding      = separateSamplers->samplerIndicesBindingIndex,
+            .dstArrayElement = 0,
+            .descriptorCount = 1,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo     = &bufInfo,
+        };
+
+        vkUpdateDescriptorSets( device, 1, &write, 0, nullptr );
+    }
+}
+
 bool TextureDescriptors::IsCached( uint32_t               frameIndex,
                                    uint32_t               textureIndex,
                                    VkImageView            view,
                                    SamplerManager::Handle samplerHandle )
 {
+    if( separateSamplers )
+    {
+        // sampler is not a part of the image descriptor
+        return writeCache[ frameIndex ][ textureIndex ].view == view;
+    }
+
     return writeCache[ frameIndex ][ textureIndex ].view == view &&
            writeCache[ frameIndex ][ textureIndex ].samplerHandle == samplerHandle;
 }
@@ -162,7 +344,72 @@ void RTGL1::TextureDescriptors::ResetAllCache( uint32_t frameIndex )
             f.view          = VK_NULL_HANDLE;
             f.samplerHandle = SamplerManager::Handle();
         }
+
+        std::ranges::fill( samplerIndexCache[ i ], NoSamplerIndex );
+    }
+}
+
+void TextureDescriptors::UpdateSamplers( uint32_t frameIndex )
+{
+    const uint32_t generation = samplerManager->GetGeneration();
+
+    if( samplersGeneration[ frameIndex ] == generation )
+    {
+        return;
+    }
+    samplersGeneration[ frameIndex ] = generation;
+
+    if( !separateSamplers )
+    {
+        // samplers are baked into the combined descriptors, rewrite all of them
+        for( auto& f : writeCache[ frameIndex ] )
+        {
+            f.view          = VK_NULL_HANDLE;
+            f.samplerHandle = SamplerManager::Handle();
+        }
+        return;
+    }
+
+    const SamplerManager::SamplerTable table = samplerManager->GetSamplerTable();
+
+    VkDescriptorImageInfo samplerInfos[ SamplerManager::SamplerTableSize ];
+    for( uint32_t i = 0; i < SamplerManager::SamplerTableSize; i++ )
+    {
+        samplerInfos[ i ] = VkDescriptorImageInfo{
+            .sampler = table[ i ],
+        };
     }
+
+    VkWriteDescriptorSet write = {
+        .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet          = descSets[ frameIndex ],
+        .dstBinding      = separateSamplers->samplersBindingIndex,
+        .dstArrayElement = 0,
+        .descriptorCount = SamplerManager::SamplerTableSize,
+        .descriptorType  = VK_DESCRIPTOR_TYPE_SAMPLER,
+        .pImageInfo      = samplerInfos,
+    };
+
+    vkUpdateDescriptorSets( device, 1, &write, 0, nullptr );
+}
+
+void TextureDescriptors::WriteSamplerIndex( uint32_t               frameIndex,
+                                            uint32_t               textureIndex,
+                                            SamplerManager::Handle samplerHandle )
+{
+    assert( separateSamplers && mappedSamplerIndices[ frameIndex ] );
+
+    const uint32_t samplerIndex = samplerManager->GetSamplerTableIndex( samplerHandle );
+
+    if( samplerIndexCache[ frameIndex ][ textureIndex ] == samplerIndex )
+    {
+        return;
+    }
+
+    // don't read back from the mapped memory, as it may be write-combined
+    mappedSamplerIndices[ frameIndex ][ textureIndex ] = samplerIndex;
+   
+    samplerIndexCache[ frameIndex ][ textureIndex ] = samplerIndex;
 }
 
 void TextureDescriptors::UpdateTextureDesc( uint32_t               frameIndex,
@@ -172,10 +419,9 @@ void TextureDescriptors::UpdateTextureDesc( uint32_t               frameIndex,
 {
     assert( view != VK_NULL_HANDLE );
 
-    if( currentWriteCount >= writeInfos.size() )
+    if( separateSamplers )
     {
-        assert( 0 );
-        return;
+        WriteSamplerIndex( frameIndex, textureIndex, samplerHandle );
     }
 
     // don't update if already is set to given parameters
@@ -184,23 +430,50 @@ void TextureDescriptors::UpdateTextureDesc( uint32_t               frameIndex,
         return;
     }
 
-    writeImageInfos[ currentWriteCount ] = VkDescriptorImageInfo{
-        .sampler     = samplerManager->GetSampler( samplerHandle ),
+    if( currentImageInfoCount >= writeImageInfos.size() )
+    {
+        assert( 0 );
+        return;
+    }
+
+    writeImageInfos[ currentImageInfoCount ] = VkDescriptorImageInfo{
+        .sampler = separateSamplers ? VK_NULL_HANDLE : samplerManager->GetSampler( samplerHandle ),
         .imageView   = view,
         .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
     };
-    writeInfos[ currentWriteCount ] = VkWriteDescriptorSet{
-        .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-        .dstSet          = descSets[ frameIndex ],
-        .dstBinding      = bindingIndex,
-        .dstArrayElement = textureIndex,
-        .descriptorCount = 1,
-        .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-        .pImageInfo      = &writeImageInfos[ currentWriteCount ],
-    };
-    currentWriteCount++;
+
+    // extend the previous write, if the slot is right after it:
+    // its image infos end at the current one, as they are allocated sequentially
+    VkWriteDescriptorSet* prev =
+        currentWriteCount > 0 ? &writeInfos[ currentWriteCount - 1 ] : nullptr;
+
+    if( prev && prev->dstSet == descSets[ frameIndex ] &&
+        prev->dstArrayElement + prev->descriptorCount == textureIndex )
+    {
+        prev->descriptorCount++;
+    }
+    else
+    {
+        writeInfos[ currentWriteCount ] = VkWriteDescriptorSet{
+            .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet          = descSets[ frameIndex ],
+            .dstBinding      = bindingIndex,
+            .dstArrayElement = textureIndex,
+            .descriptorCount = 1,
+            .descriptorType  = separateSamplers ? VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE
+                                                : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .pImageInfo      = &writeImageInfos[ currentImageInfoCount ],
+        };
+        currentWriteCount++;
+    }
+    currentImageInfoCount++;
 
     AddToCache( frameIndex, textureIndex, view, samplerHandle );
+
+    if( updateAfterBind )
+    {
+        isBound[ frameIndex ][ textureIndex ] = true;
+    }
 }
 
 void TextureDescriptors::ResetTextureDesc( uint32_t frameIndex, uint32_t textureIndex )
@@ -212,6 +485,13 @@ void TextureDescriptors::ResetTextureDesc( uint32_t frameIndex, uint32_t texture
                                                             RG_SAMPLER_ADDRESS_MODE_REPEAT,
                                                             RG_SAMPLER_ADDRESS_MODE_REPEAT };
 
+    // partially bound: a slot that never had a texture can't be used by shaders,
+    // so it's left unwritten; the first one is a fallback index, so it's always valid
+    if( updateAfterBind && textureIndex != 0 && !isBound[ frameIndex ][ textureIndex ] )
+    {
+        return;
+    }
+
     // try to update with empty data
     UpdateTextureDesc( frameIndex, textureIndex, emptyTextureImageView, nullSampler );
 }
@@ -219,5 +499,6 @@ void TextureDescriptors::ResetTextureDesc( uint32_t frameIndex, uint32_t texture
 void TextureDescriptors::FlushDescWrites()
 {
     vkUpdateDescriptorSets( device, currentWriteCount, writeInfos.data(), 0, nullptr );
-    currentWriteCount = 0;
+    currentImageInfoCount = 0;
+    currentWriteCount     = 0;
 }
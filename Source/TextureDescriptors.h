@@ -20,21 +20,41 @@
 
 #pragma once
 
+#include <optional>
 #include <vector>
 
+#include "Buffer.h"
 #include "Common.h"
 #include "SamplerManager.h"
 
 namespace RTGL1
 {
 
+// If the device supports it, the texture array is partially bound and update-after-bind:
+// slots that never had a texture are not written with the empty one, and a slot
+// that is not used by the pending frames can be written while their sets are bound
 class TextureDescriptors
 {
 public:
-    explicit TextureDescriptors( VkDevice                          device,
-                                 std::shared_ptr< SamplerManager > samplerManager,
-                                 uint32_t                          maxTextureCount,
-                                 uint32_t                          bindingIndex );
+    // If specified, images and samplers are bound separately: image descriptors
+    // at bindingIndex, all samplers in a small table at samplersBindingIndex,
+    // and a per-texture index into that table in a host-visible storage buffer.
+    // So sampler recreation only rewrites the table, not the image descriptors
+    struct SeparateSamplers
+    {
+        std::shared_ptr< MemoryAllocator > allocator;
+        uint32_t                           samplersBindingIndex;
+        uint32_t                           samplerIndicesBindingIndex;
+    };
+
+public:
+    explicit TextureDescriptors(
+        VkDevice                          device,
+        std::shared_ptr< SamplerManager > samplerManager,
+        uint32_t                          maxTextureCount,
+        uint32_t                          bindingIndex,
+        std::optional< uint32_t >         feedbackBindingIndex = std::nullopt,
+        std::optional< SeparateSamplers > separateSamplers     = std::nullopt );
     ~TextureDescriptors();
 
     TextureDescriptors( const TextureDescriptors& other )     = delete;
@@ -49,6 +69,10 @@ public:
     void                  ResetTextureDesc( uint32_t frameIndex, uint32_t textureIndex );
     void                  ResetAllCache( uint32_t frameIndex );
 
+    // Must be called before UpdateTextureDesc for the frame to pick up
+    // samplers that were recreated by the SamplerManager
+    void                  UpdateSamplers( uint32_t frameIndex );
+
     // Must be called after a series of UpdateTextureDesc and
     // ResetTextureDesc to make an actual desc write
     void                  FlushDescWrites();
@@ -59,8 +83,13 @@ public:
     // Set texture info that should be used in ResetTextureDesc(..)
     void                  SetEmptyTextureInfo( VkImageView view );
 
+    // Bind a storage buffer that shaders write texture requests to.
+    // Only if feedbackBindingIndex was specified on creation
+    void                  SetFeedbackBuffer( VkBuffer buffer );
+
 private:
     void CreateDescriptors( uint32_t maxTextureCount );
+    void CreateSamplerIndexBuffers( MemoryAllocator& allocator, uint32_t maxTextureCount );
 
     bool IsCached( uint32_t               frameIndex,
                    uint32_t               textureIndex,
@@ -71,6 +100,9 @@ private:
                      VkImageView            view,
                      SamplerManager::Handle samplerHandle );
     void ResetCache( uint32_t frameIndex, uint32_t textureIndex );
+    void WriteSamplerIndex( uint32_t               frameIndex,
+                            uint32_t               textureIndex,
+                            SamplerManager::Handle samplerHandle );
 
 private:
     struct UpdatedDescCache
@@ -84,6 +116,9 @@ private:
     std::shared_ptr< SamplerManager >    samplerManager;
 
     uint32_t                             bindingIndex;
+    std::optional< uint32_t >            feedbackBindingIndex;
+    std::optional< SeparateSamplers >    separateSamplers;
+    bool                                 updateAfterBind;
 
     VkDescriptorPool                     descPool;
     VkDescriptorSetLayout                descLayout;
@@ -92,11 +127,21 @@ private:
     VkImageView                          emptyTextureImageView;
     VkImageLayout                        emptyTextureImageLayout;
 
+    // consecutive slots of the same set are merged into one write
+    uint32_t                             currentImageInfoCount;
     uint32_t                             currentWriteCount;
     std::vector< VkDescriptorImageInfo > writeImageInfos;
     std::vector< VkWriteDescriptorSet >  writeInfos;
 
     std::vector< UpdatedDescCache >      writeCache[ MAX_FRAMES_IN_FLIGHT ];
+    std::optional< uint32_t >            samplersGeneration[ MAX_FRAMES_IN_FLIGHT ];
+    // only with updateAfterBind: if a slot was ever written, unlike writeCache it's never reset
+    std::vector< bool >                  isBound[ MAX_FRAMES_IN_FLIGHT ];
+
+    // only with separateSamplers
+    Buffer                               samplerIndexBuffers[ MAX_FRAMES_IN_FLIGHT ];
+    uint32_t*                            mappedSamplerIndices[ MAX_FRAMES_IN_FLIGHT ];
+    std::vector< uint32_t >              samplerIndexCache[ MAX_FRAMES_IN_FLIGHT ];
 };
 
 }
\ No newline at end of file
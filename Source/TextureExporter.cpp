@@ -73,6 +73,11 @@ PrepareResult PrepareTargetFile( const std::filesystem::path& filepath, bool ove
 
 }
 
+RTGL1::TextureExporter::~TextureExporter()
+{
+    WriteFinished();
+}
+
 bool RTGL1::TextureExporter::WriteTGA( std::filesystem::path filepath,
                                        const void*           pixels,
                                        const RgExtent2D&     size )
@@ -119,7 +124,6 @@ bool RTGL1::TextureExporter::ExportAsTGA( MemoryAllocator&             allocator
         return false;
     }
 
-    vkDeviceWaitIdle( device );
     VkCommandBuffer cmd = cmdManager.StartGraphicsCmd();
 
     constexpr VkImageLayout srcImageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -131,12 +135,6 @@ bool RTGL1::TextureExporter::ExportAsTGA( MemoryAllocator&             allocator
         .baseArrayLayer = 0,
         .layerCount     = 1,
     };
-    const VkImageSubresource subres = {
-        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-        .mipLevel   = 0,
-        .arrayLayer = 0,
-    };
-
     // Can't vkCmdBlit into a linear tiling directly
     // Can't vkCmdCopy directly from a compressed format (diff block extents with rgba8)
     // 1. Blit from compressed to optimal rgba8
@@ -228,10 +226,10 @@ bool RTGL1::TextureExporter::ExportAsTGA( MemoryAllocator&             allocator
     // blit srcImage -> dstImage_Optimal
     {
         VkImageMemoryBarrier2 bs[] = {
-            // srcImage to transfer src
+            // srcImage to transfer src, after any previous reads, as the device is not idle
             {
                 .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR,
-                .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
+                .srcStageMask        = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
                 .srcAccessMask       = VK_ACCESS_2_SHADER_READ_BIT,
                 .dstStageMask        = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
                 .dstAccessMask       = VK_ACCESS_2_TRANSFER_READ_BIT,
@@ -398,86 +396,136 @@ bool RTGL1::TextureExporter::ExportAsTGA( MemoryAllocator&             allocator
         svkCmdPipelineBarrier2KHR( cmd, &dependencyInfo );
     }
 
-    cmdManager.Submit( cmd );
-    cmdManager.WaitGraphicsIdle();
-
-    bool success = false;
+    VkFence fence = VK_NULL_HANDLE;
     {
-        VkSubresourceLayout subresLayout = {};
-        vkGetImageSubresourceLayout( device, dstImage_Linear, &subres, &subresLayout );
+        VkFenceCreateInfo info = {
+            .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+        };
 
-        if( subresLayout.rowPitch == DstBytesPerPixel * srcImageSize.width )
-        {
-            assert( subresLayout.size ==
-                    DstBytesPerPixel * srcImageSize.width * srcImageSize.height );
+        VkResult r = vkCreateFence( device, &info, nullptr, &fence );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME( device, fence, VK_OBJECT_TYPE_FENCE, "Export readback fence" );
+    }
 
-            uint8_t* data{ nullptr };
-            VkResult r = vkMapMemory( device,
-                                      dstMemory_Linear,
-                                      0,
-                                      VK_WHOLE_SIZE,
-                                      0,
-                                      reinterpret_cast< void** >( &data ) );
-            VK_CHECKERROR( r );
+    cmdManager.Submit( cmd, fence );
 
-            success = WriteTGA( filepath, &data[ subresLayout.offset ], srcImageSize );
+    assert( this->device == VK_NULL_HANDLE || this->device == device );
+    this->device = device;
 
-            vkUnmapMemory( device, dstMemory_Linear );
-        }
-        else
+    readbacks.push_back( Readback{
+        .fence         = fence,
+        .imageOptimal  = dstImage_Optimal,
+        .memoryOptimal = dstMemory_Optimal,
+        .imageLinear   = dstImage_Linear,
+        .memoryLinear  = dstMemory_Linear,
+        .size          = srcImageSize,
+        .filepath      = filepath,
+    } );
+    return true;
+}
+
+bool RTGL1::TextureExporter::WriteFinished()
+{
+    const VkImageSubresource subres = {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .mipLevel   = 0,
+        .arrayLayer = 0,
+    };
+
+    bool allSucceeded = true;
+
+    for( const Readback& rb : readbacks )
+    {
+        VkResult r = vkWaitForFences( device, 1, &rb.fence, VK_TRUE, UINT64_MAX );
+        VK_CHECKERROR( r );
+
+        const RgExtent2D&            srcImageSize = rb.size;
+        const std::filesystem::path& filepath     = rb.filepath;
+
+        bool success = false;
         {
-            // manually, if small enough
-            if( srcImageSize.width <= 64 && srcImageSize.height <= 64 )
-            {
-                auto pixels = std::make_unique< uint8_t[] >( DstBytesPerPixel * srcImageSize.width *
-                                                             srcImageSize.height );
-                {
-                    uint8_t* rawData{ nullptr };
-                    VkResult r = vkMapMemory( device,
-                                              dstMemory_Linear,
-                                              0,
-                                              VK_WHOLE_SIZE,
-                                              0,
-                                              reinterpret_cast< void** >( &rawData ) );
-                    VK_CHECKERROR( r );
+            VkSubresourceLayout subresLayout = {};
+            vkGetImageSubresourceLayout( device, rb.imageLinear, &subres, &subresLayout );
 
-                    uint8_t* beginData = &rawData[ subresLayout.offset ];
-                    uint8_t* endData   = &rawData[ subresLayout.offset + subresLayout.size ];
+            if( subresLayout.rowPitch == DstBytesPerPixel * srcImageSize.width )
+            {
+                assert( subresLayout.size ==
+                        DstBytesPerPixel * srcImageSize.width * srcImageSize.height );
 
-                    uint8_t* dstPtr = pixels.get();
+                uint8_t* data{ nullptr };
+                r = vkMapMemory( device,
+                                 rb.memoryLinear,
+                                 0,
+                                 VK_WHOLE_SIZE,
+                                 0,
+                                 reinterpret_cast< void** >( &data ) );
+                VK_CHECKERROR( r );
 
-                    for( uint8_t* ptr = beginData; ptr < endData; ptr += subresLayout.rowPitch )
-                    {
-                        memcpy( dstPtr, ptr, DstBytesPerPixel * srcImageSize.width );
-                        dstPtr += DstBytesPerPixel * srcImageSize.width;
-                    }
+                success = WriteTGA( filepath, &data[ subresLayout.offset ], srcImageSize );
 
-                    vkUnmapMemory( device, dstMemory_Linear );
-                }
-                success = WriteTGA( filepath, pixels.get(), srcImageSize );
+                vkUnmapMemory( device, rb.memoryLinear );
             }
             else
             {
-                debug::Warning(
-                    "Can't export to image file, as mapped data is not tightly packed: {}. "
-                    "VkSubresourceLayout::rowPitch is {}; expected "
-                    "( {} bytes per pixel * {} pixels in a row )",
-                    filepath.string(),
-                    subresLayout.rowPitch,
-                    DstBytesPerPixel,
-                    srcImageSize.width );
+                // manually, if small enough
+                if( srcImageSize.width <= 64 && srcImageSize.height <= 64 )
+                {
+                    auto pixels = std::make_unique< uint8_t[] >(
+                        DstBytesPerPixel * srcImageSize.width * srcImageSize.height );
+                    {
+                        uint8_t* rawData{ nullptr };
+                        r = vkMapMemory( device,
+                                         rb.memoryLinear,
+                                         0,
+                                         VK_WHOLE_SIZE,
+                                         0,
+                                         reinterpret_cast< void** >( &rawData ) );
+                        VK_CHECKERROR( r );
+
+                        uint8_t* beginData = &rawData[ subresLayout.offset ];
+                        uint8_t* endData   = &rawData[ subresLayout.offset + subresLayout.size ];
+
+                        uint8_t* dstPtr = pixels.get();
+
+                        for( uint8_t* ptr = beginData; ptr < endData;
+                             ptr += subresLayout.rowPitch )
+                        {
+                            memcpy( dstPtr, ptr, DstBytesPerPixel * srcImageSize.width );
+                            dstPtr += DstBytesPerPixel * srcImageSize.width;
+                        }
+
+                        vkUnmapMemory( device, rb.memoryLinear );
+                    }
+                    success = WriteTGA( filepath, pixels.get(), srcImageSize );
+                }
+                else
+                {
+                    debug::Warning(
+                        "Can't export to image file, as mapped data is not tightly packed: {}. "
+                        "VkSubresourceLayout::rowPitch is {}; expected "
+                        "( {} bytes per pixel * {} pixels in a row )",
+                        filepath.string(),
+                        subresLayout.rowPitch,
+                        DstBytesPerPixel,
+                        srcImageSize.width );
+                }
             }
         }
-    }
-    {
-        MemoryAllocator::FreeDedicated( device, dstMemory_Linear );
-        MemoryAllocator::FreeDedicated( device, dstMemory_Optimal );
+        {
+            MemoryAllocator::FreeDedicated( device, rb.memoryLinear );
+            MemoryAllocator::FreeDedicated( device, rb.memoryOptimal );
+
+            vkDestroyImage( device, rb.imageLinear, nullptr );
+            vkDestroyImage( device, rb.imageOptimal, nullptr );
+
+            vkDestroyFence( device, rb.fence, nullptr );
+        }
 
-        vkDestroyImage( device, dstImage_Linear, nullptr );
-        vkDestroyImage( device, dstImage_Optimal, nullptr );
+        allSucceeded &= success;
     }
 
-    return success;
+    readbacks.clear();
+    return allSucceeded;
 }
 
 bool RTGL1::TextureExporter::CheckSupport( VkPhysicalDevice physDevice,
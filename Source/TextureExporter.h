@@ -32,7 +32,7 @@ class TextureExporter
 {
 public:
     TextureExporter() = default;
-    ~TextureExporter() = default;
+    ~TextureExporter();
 
     TextureExporter( const TextureExporter& other )                = delete;
     TextureExporter( TextureExporter&& other ) noexcept            = delete;
@@ -43,6 +43,8 @@ public:
                           const void*           pixels,
                           const RgExtent2D&     size );
 
+    // Records and submits a readback of the image, the file is written in WriteFinished().
+    // The render thread doesn't wait for the device: only the readback has a fence
     bool ExportAsTGA( MemoryAllocator&             allocator,
                       CommandBufferManager&        cmdManager,
                       VkImage                      srcImage,
@@ -52,11 +54,28 @@ public:
                       bool                         exportAsSRGB,
                       bool                         overwriteFiles = true );
 
+    // Wait for the submitted readbacks, and write them into files. Can be called on any thread.
+    // False, if any of the files failed
+    bool WriteFinished();
+
     bool CheckSupport( VkPhysicalDevice physDevice,
                        VkFormat         srcImageFormat,
                        VkFormat         dstImageFormat );
 
 private:
+    struct Readback
+    {
+        VkFence               fence{ VK_NULL_HANDLE };
+        VkImage               imageOptimal{ VK_NULL_HANDLE };
+        VkDeviceMemory        memoryOptimal{ VK_NULL_HANDLE };
+        VkImage               imageLinear{ VK_NULL_HANDLE };
+        VkDeviceMemory        memoryLinear{ VK_NULL_HANDLE };
+        RgExtent2D            size{};
+        std::filesystem::path filepath{};
+    };
+
+    VkDevice                device{ VK_NULL_HANDLE };
+    std::vector< Readback > readbacks{};
 };
 
 }
@@ -0,0 +1,112 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "TextureFileIndex.h"
+
+#include "Const.h"
+#include "DebugPrint.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace fs = std::filesystem;
+
+bool RTGL1::TextureFileIndex::MayExist( const fs::path& folder, const fs::path& filepath )
+{
+    if( !indexedFolders.contains( MakeKey( folder ) ) )
+    {
+        IndexFolder( folder );
+    }
+
+    const std::string key = MakeKey( filepath );
+
+    if( files.contains( key ) )
+    {
+        return true;
+    }
+
+    return std::ranges::any_of( unindexedFolders, [ &key ]( const std::string& prefix ) {
+        return key.starts_with( prefix );
+    } );
+}
+
+void RTGL1::TextureFileIndex::Add( const fs::path& filepath )
+{
+    files.insert( MakeKey( filepath ) );
+}
+
+void RTGL1::TextureFileIndex::IndexFolder( const fs::path& folder )
+{
+    indexedFolders.insert( MakeKey( folder ) );
+
+    std::error_code ec;
+    if( !fs::is_directory( folder, ec ) )
+    {
+        return;
+    }
+
+    const size_t countBefore = files.size();
+
+    auto iter = fs::recursive_directory_iterator( folder, ec );
+    for( ; !ec && iter != fs::recursive_directory_iterator{}; iter.increment( ec ) )
+    {
+        const fs::directory_entry& entry = *iter;
+
+        if( entry.is_directory( ec ) )
+        {
+            if( entry.path().filename() == TEXTURES_FOLDER_JUNCTION ||
+                entry.path().filename() == DEV_TEXTURE_CACHE_FOLDER )
+            {
+                unindexedFolders.push_back( MakeKey( entry.path() ) + '/' );
+                iter.disable_recursion_pending();
+            }
+            continue;
+        }
+
+        if( entry.is_regular_file( ec ) )
+        {
+            files.insert( MakeKey( entry.path() ) );
+        }
+    }
+
+    if( ec )
+    {
+        // can't rely on the index, so probe everything in this folder
+        debug::Warning( "Failed to index {}: {}", folder.string(), ec.message() );
+        unindexedFolders.push_back( MakeKey( folder ) + '/' );
+    }
+
+    debug::Verbose( "Indexed {} texture files in {}", files.size() - countBefore, folder.string() );
+}
+
+std::string RTGL1::TextureFileIndex::MakeKey( const fs::path& p )
+{
+    auto key = p.generic_string();
+#ifdef _WIN32
+    // file system is case-insensitive
+    std::ranges::transform( key, key.begin(), []( unsigned char c ) { return std::tolower( c ); } );
+#endif
+    while( key.ends_with( '/' ) )
+    {
+        key.pop_back();
+    }
+    return key;
+}
@@ -0,0 +1,65 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "Containers.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace RTGL1
+{
+
+// Names of the files in the texture override folders, so a material creation can check
+// which of the candidate paths exist without probing the file system for each of them.
+// A folder is scanned once, on the first query; new files should be added with Add,
+// as they are reported by FolderObserver. Deleted files are not removed, so a positive
+// answer still must be checked by opening the file. Not thread-safe
+class TextureFileIndex
+{
+public:
+    TextureFileIndex() = default;
+    ~TextureFileIndex() = default;
+
+    TextureFileIndex( const TextureFileIndex& other )                = delete;
+    TextureFileIndex( TextureFileIndex&& other ) noexcept            = delete;
+    TextureFileIndex& operator=( const TextureFileIndex& other )     = delete;
+    TextureFileIndex& operator=( TextureFileIndex&& other ) noexcept = delete;
+
+    // False, if 'filepath' (which is in 'folder') definitely doesn't exist
+    bool MayExist( const std::filesystem::path& folder, const std::filesystem::path& filepath );
+    void Add( const std::filesystem::path& filepath );
+
+private:
+    void IndexFolder( const std::filesystem::path& folder );
+
+    static std::string MakeKey( const std::filesystem::path& p );
+
+private:
+    rgl::string_set indexedFolders;
+    rgl::string_set files;
+    // subfolders that are not scanned, e.g. junctions; files in them are always probed
+    std::vector< std::string > unindexedFolders;
+};
+
+}
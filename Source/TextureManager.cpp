@@ -20,7 +20,11 @@
 
 #include "TextureManager.h"
 
+#include "ApiChains.h"
+#include "CmdLabel.h"
 #include "Const.h"
+#include "CpuProfiler.h"
+#include "HitchRecorder.h"
 #include "DrawFrameInfo.h"
 #include "JsonParser.h"
 #include "RgException.h"
@@ -30,11 +34,17 @@
 
 #include "Generated/ShaderCommonC.h"
 
+#include <algorithm>
+#include <cstring>
 #include <numeric>
 #include <ranges>
 
 using namespace RTGL1;
 
+namespace RTGL1
+{
+extern bool g_supportsOpacityMicromap;
+}
 
 namespace
 {
@@ -50,6 +60,24 @@ static_assert( TEXTURES_PER_MATERIAL_COUNT == 5 );
 
 constexpr bool PreferExistingMaterials = true;
 
+// to spread the uploads of asynchronously loaded materials over frames
+constexpr size_t MaxAsyncMaterialUploadsPerFrame = 32;
+// and to not stall a frame on large batches, e.g. hot-reloaded textures
+constexpr size_t MaxAsyncUploadBytesPerFrame = 64 * 1024 * 1024;
+
+// texture streaming: initially, only mip levels that are not larger than this are uploaded
+constexpr uint32_t StreamingTailMaxSize = 128;
+// fully resident texture falls back to its tail, if it wasn't requested for that long
+constexpr auto StreamingEvictTimeout = std::chrono::seconds( 10 );
+// if the DEVICE_LOCAL usage is more than this fraction of the budget, full mip chains are not
+// uploaded, and the least recently requested textures fall back to their tails
+constexpr double StreamingBudgetFraction = 0.9;
+// evictions per frame, as the memory is freed only after MAX_FRAMES_IN_FLIGHT
+constexpr uint32_t StreamingMaxEvictionsPerFrame = 8;
+
+// texture memory defragmentation: bytes copied in one pass, a pass is done per FramesInFlight()
+constexpr VkDeviceSize DefragmentationMaxBytesPerPass = 32 * 1024 * 1024;
+
 template< typename T >
 constexpr const T* DefaultIfNull( const T* pData, const T* pDefault )
 {
@@ -71,10 +99,111 @@ bool ContainsTextures( const MaterialTextures& m )
 auto FindEmptySlot( std::vector< Texture >& textures )
 {
     return std::ranges::find_if( textures, []( const Texture& t ) {
-        return t.image == VK_NULL_HANDLE && t.view == VK_NULL_HANDLE;
+        return t.image == VK_NULL_HANDLE && t.view == VK_NULL_HANDLE && !t.reserved;
     } );
 }
 
+// Null, if there are no pregenerated levels to cut
+std::optional< ImageLoader::ResultInfo > MakeTailMips( const ImageLoader::ResultInfo& full )
+{
+    if( !full.isPregenerated || full.levelCount <= 1 )
+    {
+        return std::nullopt;
+    }
+
+    uint32_t first = 0;
+    while( first + 1 < full.levelCount &&
+           std::max( full.baseSize.width >> first, full.baseSize.height >> first ) >
+               StreamingTailMaxSize )
+    {
+        first++;
+    }
+
+    if( first == 0 )
+    {
+        return std::nullopt;
+    }
+
+    // levels are not guaranteed to be stored from the largest to the smallest
+    size_t begin = SIZE_MAX, end = 0;
+    for( uint32_t i = first; i < full.levelCount; i++ )
+    {
+        begin = std::min( begin, full.levelOffsets[ i ] );
+        end   = std::max( end, full.levelOffsets[ i ] + full.levelSizes[ i ] );
+    }
+    assert( begin < end && end <= full.dataSize );
+
+    auto tail = ImageLoader::ResultInfo{
+        .levelOffsets   = {},
+        .levelSizes     = {},
+        .levelCount     = full.levelCount - first,
+        .isPregenerated = true,
+        .pData          = full.pData + begin,
+        .dataSize       = end - begin,
+        .baseSize       = { std::max( full.baseSize.width >> first, 1u ),
+                            std::max( full.baseSize.height >> first, 1u ) },
+        .format         = full.format,
+    };
+
+    for( uint32_t i = first; i < full.levelCount; i++ )
+    {
+        tail.levelOffsets[ i - first ]           = full.levelOffsets[ i ] - begin;
+        tail.levelSizes[ i - first ]             = full.levelSizes[ i ];
+        tail.levelPageSizes[ i - first ]         = full.levelPageSizes[ i ];
+        tail.levelDecompressedSizes[ i - first ] = full.levelDecompressedSizes[ i ];
+    }
+
+    return tail;
+}
+
+// Key of an image in TextureManager::sharedImages, never 0
+uint64_t HashTextureContents( const ImageLoader::ResultInfo&      info,
+                              bool                                useMipmaps,
+                              std::optional< RgTextureSwizzling > swizzling,
+                              bool                                isNormalMap )
+{
+    auto hashCombine = []< typename T >( uint64_t seed, const T& v ) {
+        return seed ^ ( std::hash< T >{}( v ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 ) );
+    };
+
+    uint64_t h = ankerl::unordered_dense::hash< std::string_view >{}(
+        std::string_view{ reinterpret_cast< const char* >( info.pData ), info.dataSize } );
+
+    // same bytes can be a different image, or have a different view
+    h = hashCombine( h, uint32_t( info.format ) );
+    h = hashCombine( h, info.baseSize.width );
+    h = hashCombine( h, info.baseSize.height );
+    h = hashCombine( h, info.isPregenerated ? info.levelCount : 0 );
+    h = hashCombine( h, useMipmaps );
+    h = hashCombine( h, swizzling ? uint32_t( *swizzling ) + 1 : 0 );
+    h = hashCombine( h, isNormalMap );
+
+    return h != 0 ? h : 1;
+}
+
+// Independent of HashTextureContents, to verify its match
+uint64_t ChecksumTextureContents( const ImageLoader::ResultInfo& info )
+{
+    uint64_t a = 1, b = 0;
+
+    size_t i = 0;
+    for( ; i + sizeof( uint64_t ) <= info.dataSize; i += sizeof( uint64_t ) )
+    {
+        uint64_t word;
+        memcpy( &word, info.pData + i, sizeof( uint64_t ) );
+
+        a += word;
+        b += a;
+    }
+    for( ; i < info.dataSize; i++ )
+    {
+        a += info.pData[ i ];
+        b += a;
+    }
+
+    return a ^ ( ( b << 1 ) | ( b >> 63 ) );
+}
+
 VkFormat toVkFormat( RgFormat f )
 {
     switch( f )
@@ -86,10 +215,34 @@ VkFormat toVkFormat( RgFormat f )
         case RG_FORMAT_R8G8B8A8_SRGB: return VK_FORMAT_R8G8B8A8_SRGB;
         case RG_FORMAT_B8G8R8A8_UNORM: return VK_FORMAT_B8G8R8A8_UNORM;
         case RG_FORMAT_B8G8R8A8_SRGB: return VK_FORMAT_B8G8R8A8_SRGB;
+        case RG_FORMAT_BC1_RGBA_UNORM: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case RG_FORMAT_BC1_RGBA_SRGB: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case RG_FORMAT_BC3_UNORM: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case RG_FORMAT_BC3_SRGB: return VK_FORMAT_BC3_SRGB_BLOCK;
+        case RG_FORMAT_BC4_UNORM: return VK_FORMAT_BC4_UNORM_BLOCK;
+        case RG_FORMAT_BC5_UNORM: return VK_FORMAT_BC5_UNORM_BLOCK;
+        case RG_FORMAT_BC7_UNORM: return VK_FORMAT_BC7_UNORM_BLOCK;
+        case RG_FORMAT_BC7_SRGB: return VK_FORMAT_BC7_SRGB_BLOCK;
         default: assert( 0 ); return VK_FORMAT_R8G8B8A8_SRGB;
     }
 }
 
+bool isBlockCompressed( RgFormat f )
+{
+    switch( f )
+    {
+        case RG_FORMAT_BC1_RGBA_UNORM:
+        case RG_FORMAT_BC1_RGBA_SRGB:
+        case RG_FORMAT_BC3_UNORM:
+        case RG_FORMAT_BC3_SRGB:
+        case RG_FORMAT_BC4_UNORM:
+        case RG_FORMAT_BC5_UNORM:
+        case RG_FORMAT_BC7_UNORM:
+        case RG_FORMAT_BC7_SRGB: return true;
+        default: return false;
+    }
+}
+
 VkFormat getVkFormat( const RgOriginalTextureDetailsEXT* details, VkFormat fallback )
 {
     if( details )
@@ -110,7 +263,8 @@ TextureManager::TextureManager( VkDevice                                _device,
                                 const std::filesystem::path&            _dirtMaskTexturePath,
                                 const std::filesystem::path&            _sceneBuildingTexturePath,
                                 RgTextureSwizzling                      _pbrSwizzling,
-                                bool                                    _forceNormalMapFilterLinear )
+                                bool                                    _forceNormalMapFilterLinear,
+                                uint64_t                                _stagingRingSize )
     : device{ _device }
     , pbrSwizzling{ _pbrSwizzling }
     , imageLoaderKtx{ std::make_shared< ImageLoader >() }
@@ -119,10 +273,10 @@ TextureManager::TextureManager( VkDevice                                _device,
     , memAllocator{ std::move( _memAllocator ) }
     , cmdManager{ std::move( _cmdManager ) }
     , samplerMgr{ std::move( _samplerMgr ) }
+    , streamingEnabled{ LibConfig().textureStreaming }
     , waterNormalTextureIndex{ EMPTY_TEXTURE_INDEX }
     , dirtMaskTextureIndex{ EMPTY_TEXTURE_INDEX }
     , sceneBuildingTextureIndex{ EMPTY_TEXTURE_INDEX }
-    , currentDynamicSamplerFilter{ RG_SAMPLER_FILTER_LINEAR }
     , postfixes
         {
             TEXTURE_ALBEDO_ALPHA_POSTFIX,
@@ -134,15 +288,62 @@ TextureManager::TextureManager( VkDevice                                _device,
     , forceNormalMapFilterLinear{ _forceNormalMapFilterLinear }
 {
     textureDesc = std::make_shared< TextureDescriptors >(
-        device, samplerMgr, TEXTURE_COUNT_MAX, BINDING_TEXTURES );
-    textureUploader = std::make_shared< TextureUploader >( device, memAllocator );
+        device,
+        samplerMgr,
+        TEXTURE_COUNT_MAX,
+        BINDING_TEXTURES,
+        BINDING_TEXTURE_STREAMING_FEEDBACK,
+        TextureDescriptors::SeparateSamplers{
+            .allocator                  = memAllocator,
+            .samplersBindingIndex       = BINDING_TEXTURE_SAMPLERS,
+            .samplerIndicesBindingIndex = BINDING_TEXTURE_SAMPLER_INDICES,
+        } );
+    textureUploader = std::make_shared< TextureUploader >(
+        device,
+        memAllocator,
+        cmdManager,
+        _stagingRingSize > 0 ? _stagingRingSize : TEXTURE_STAGING_RING_DEFAULT_SIZE );
+    asyncLoader     = std::make_unique< AsyncTextureLoader >(
+        std::clamp( std::thread::hardware_concurrency() / 2, 1u, 4u ) );
 
     textures.resize( TEXTURE_COUNT_MAX );
 
+    // buffers are always created, as the descriptor must be valid
+    {
+        auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_TEXTURES };
+
+        constexpr VkDeviceSize feedbackSize = sizeof( uint32_t ) * TEXTURE_COUNT_MAX;
+
+        streamingFeedback.Init( *memAllocator,
+                                feedbackSize,
+                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                "Texture streaming feedback" );
+
+        for( auto& readback : streamingFeedbackReadback )
+        {
+            readback.Init( *memAllocator,
+                           feedbackSize,
+                           VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                           VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                           "Texture streaming feedback readback" );
+
+            memset( readback.Map(), 0, feedbackSize );
+            readback.Unmap();
+        }
+
+        textureDesc->SetFeedbackBuffer( streamingFeedback.GetBuffer() );
+    }
+
     // submit cmd to create empty texture
     {
         VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
         {
+            vkCmdFillBuffer( cmd, streamingFeedback.GetBuffer(), 0, VK_WHOLE_SIZE, 0 );
+
             CreateEmptyTexture( cmd, 0 );
 
             waterNormalTextureIndex = CreateWaterNormalTexture( cmd, 0, _waterNormalTexturePath );
@@ -239,7 +440,8 @@ uint32_t TextureManager::CreateWaterNormalTexture( VkCommandBuffer
                            false,
                            std::nullopt,
                            std::move( ovrd.path ),
-                           FindEmptySlot( textures ) );
+                           FindEmptySlot( textures ),
+                           true );
 }
 
 uint32_t TextureManager::CreateDirtMaskTexture( VkCommandBuffer              cmd,
@@ -337,6 +539,22 @@ uint32_t TextureManager::CreateSceneBuildingTexture( VkCommandBuffer
 
 TextureManager::~TextureManager()
 {
+    for( const auto& p : provided )
+    {
+        if( p.pfnReleasePixels )
+        {
+            p.pfnReleasePixels( p.levels.pData, p.pUserData );
+        }
+    }
+
+    // new images of the unfinished pass are already in 'textures'
+    memAllocator->EndTexturesDefragmentationPass();
+    for( VkImageView view : defragOldViews )
+    {
+        vkDestroyImageView( device, view, nullptr );
+    }
+    memAllocator->EndTexturesDefragmentation();
+
     for( auto& texture : textures )
     {
         assert( ( texture.image == VK_NULL_HANDLE && texture.view == VK_NULL_HANDLE ) ||
@@ -357,8 +575,25 @@ TextureManager::~TextureManager()
     }
 }
 
+void TextureManager::SetMipmapGenerator( std::shared_ptr< MipmapGenerator > generator )
+{
+    textureUploader->SetMipmapGenerator( std::move( generator ) );
+}
+
 void TextureManager::PrepareForFrame( uint32_t frameIndex )
 {
+    // the copies were done FramesInFlight() ago, so the old images are not in use anymore
+    if( defragPassFrameIndex == frameIndex )
+    {
+        memAllocator->EndTexturesDefragmentationPass();
+        for( VkImageView view : defragOldViews )
+        {
+            vkDestroyImageView( device, view, nullptr );
+        }
+        defragOldViews.clear();
+        defragPassFrameIndex = std::nullopt;
+    }
+
     // destroy delayed textures
     for( auto& t : texturesToDestroy[ frameIndex ] )
     {
@@ -368,10 +603,287 @@ void TextureManager::PrepareForFrame( uint32_t frameIndex )
 
     // clear staging buffer that are not in use
     textureUploader->ClearStaging( frameIndex );
+    textureUploader->BeginTransferUploads();
+
+    if( streamingEnabled )
+    {
+        ProcessStreamingFeedback( frameIndex );
+    }
+}
+
+void TextureManager::SubmitTransferUploads()
+{
+    textureUploader->SubmitTransferUploads();
+}
+
+void TextureManager::RequestDefragmentation()
+{
+    defragRequested = true;
+}
+
+void TextureManager::DefragmentationStep( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    // previous pass is still in flight
+    if( defragPassFrameIndex )
+    {
+        return;
+    }
+
+    if( !memAllocator->IsTexturesDefragmentationActive() )
+    {
+        // start when the freed textures are actually destroyed
+        bool idle = std::ranges::all_of( texturesToDestroy, []( const auto& pending ) {
+            return pending.empty();
+        } );
+
+        if( !defragRequested || !idle )
+        {
+            return;
+        }
+        defragRequested = false;
+
+        memAllocator->BeginTexturesDefragmentation( DefragmentationMaxBytesPerPass );
+        if( !memAllocator->IsTexturesDefragmentationActive() )
+        {
+            return;
+        }
+    }
+
+    // key: image, value: first slot that references it
+    auto live = rgl::unordered_map< VkImage, uint32_t >{};
+    for( uint32_t i = 0; i < textures.size(); i++ )
+    {
+        if( textures[ i ].image != VK_NULL_HANDLE )
+        {
+            live.emplace( textures[ i ].image, i );
+        }
+    }
+    // empty texture's view is also stored in the texture descriptors
+    live.erase( textures[ EMPTY_TEXTURE_INDEX ].image );
+
+    // might be in use by the frames in flight
+    auto inUse = rgl::unordered_set< VkImage >{};
+    for( const auto& pending : texturesToDestroy )
+    {
+        for( const Texture& t : pending )
+        {
+            inUse.insert( t.image );
+        }
+    }
+
+    auto moves = memAllocator->BeginTexturesDefragmentationPass( [ & ]( VkImage image ) {
+        return live.contains( image ) && !inUse.contains( image );
+    } );
+
+    if( !memAllocator->IsTexturesDefragmentationPassActive() )
+    {
+        return;
+    }
+    defragPassFrameIndex = frameIndex;
+
+    auto moved = rgl::unordered_map< VkImage, std::pair< VkImage, VkImageView > >{};
+    for( const auto& m : moves )
+    {
+        const Texture& src = textures[ live[ m.oldImage ] ];
+
+        VkImageView newView =
+            textureUploader->MoveImage( cmd, m.oldImage, m.newImage, m.info, src.swizzling );
+
+        defragOldViews.push_back( src.view );
+        moved.emplace( m.oldImage, std::pair{ m.newImage, newView } );
+    }
+
+    // descriptors are rewritten in SubmitDescriptors, as the views have changed
+    for( Texture& t : textures )
+    {
+        auto found = moved.find( t.image );
+        if( found != moved.end() )
+        {
+            std::tie( t.image, t.view ) = found->second;
+        }
+    }
+    for( SharedImage& shared : sharedImages | std::views::values )
+    {
+        auto found = moved.find( shared.image );
+        if( found != moved.end() )
+        {
+            std::tie( shared.image, shared.view ) = found->second;
+        }
+    }
 }
 
-void TextureManager::TryHotReload( VkCommandBuffer cmd, uint32_t frameIndex )
+void TextureManager::ProcessStreamingFeedback( uint32_t frameIndex )
 {
+    // was written MAX_FRAMES_IN_FLIGHT ago, and the GPU has already finished that frame
+    const auto* requested =
+        static_cast< const uint32_t* >( streamingFeedbackReadback[ frameIndex ].Map() );
+
+    const auto now = std::chrono::steady_clock::now();
+
+    const auto memory = memAllocator->GetDeviceLocalBudget();
+    const bool overBudget =
+        memory.budget > 0 &&
+        double( memory.usage ) > double( memory.budget ) * StreamingBudgetFraction;
+
+    uint32_t pendingEvictions = 0;
+    auto     evictCandidates  = std::vector< StreamedTexture* >{};
+
+    for( auto& [ textureIndex, st ] : streamedTextures )
+    {
+        const uint32_t req = requested[ textureIndex ];
+
+        if( req > 0 )
+        {
+            st.lastRequested = now;
+        }
+
+        if( st.isLoading )
+        {
+            // loading the tail of a fully resident texture
+            if( st.isFullyResident )
+            {
+                pendingEvictions++;
+            }
+            continue;
+        }
+
+        if( !st.isFullyResident && req > st.residentMaxSize )
+        {
+            // don't make it worse, wait for evictions to free the memory
+            if( !overBudget )
+            {
+                RequestStreamedTexture( st );
+            }
+        }
+        else if( st.isFullyResident && now - st.lastRequested > StreamingEvictTimeout )
+        {
+            // the file is reloaded to upload only the tail
+            RequestStreamedTexture( st );
+            pendingEvictions++;
+        }
+        else if( st.isFullyResident )
+        {
+            evictCandidates.push_back( &st );
+        }
+    }
+
+    streamingFeedbackReadback[ frameIndex ].Unmap();
+
+    // if previous evictions haven't freed the memory yet, they might be enough
+    if( overBudget && pendingEvictions == 0 )
+    {
+        const size_t count =
+            std::min< size_t >( evictCandidates.size(), StreamingMaxEvictionsPerFrame );
+
+        std::ranges::partial_sort( evictCandidates,
+                                   evictCandidates.begin() + ptrdiff_t( count ),
+                                   []( const StreamedTexture* a, const StreamedTexture* b ) {
+                                       return a->lastRequested < b->lastRequested;
+                                   } );
+
+        for( size_t i = 0; i < count; i++ )
+        {
+            RequestStreamedTexture( *evictCandidates[ i ] );
+        }
+    }
+}
+
+void TextureManager::RequestStreamedTexture( StreamedTexture& st )
+{
+    auto request = AsyncTextureLoader::Request{
+        .materialName       = st.materialName,
+        .materialGeneration = st.materialGeneration,
+    };
+    request.paths[ st.materialTextureIndex ]  = st.path;
+    request.isSRGB[ st.materialTextureIndex ] = st.isSRGB;
+
+    asyncLoader->Enqueue( std::move( request ) );
+    st.isLoading = true;
+}
+
+void TextureManager::CopyStreamingFeedback( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    if( !streamingEnabled )
+    {
+        return;
+    }
+
+    auto label = CmdLabel{ cmd, "Texture streaming feedback" };
+
+    const VkBuffer feedback = streamingFeedback.GetBuffer();
+
+    auto makeBarrier = []( VkBuffer              buffer,
+                           VkPipelineStageFlags2 srcStage,
+                           VkAccessFlags2        srcAccess,
+                           VkPipelineStageFlags2 dstStage,
+                           VkAccessFlags2        dstAccess ) {
+        return VkBufferMemoryBarrier2{
+            .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+            .pNext               = nullptr,
+            .srcStageMask        = srcStage,
+            .srcAccessMask       = srcAccess,
+            .dstStageMask        = dstStage,
+            .dstAccessMask       = dstAccess,
+            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .buffer              = buffer,
+            .offset              = 0,
+            .size                = VK_WHOLE_SIZE,
+        };
+    };
+
+    auto barrier = [ & ]( const VkBufferMemoryBarrier2& b ) {
+        VkDependencyInfo dependency = {
+            .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+            .bufferMemoryBarrierCount = 1,
+            .pBufferMemoryBarriers    = &b,
+        };
+        svkCmdPipelineBarrier2KHR( cmd, &dependency );
+    };
+
+    // fragment shaders of the rasterized passes write too, they are recorded later,
+    // so their requests are read in the next frame
+    barrier( makeBarrier( feedback,
+                          VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR |
+                              VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                          VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                          VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                          VK_ACCESS_2_TRANSFER_READ_BIT ) );
+    {
+        VkBufferCopy region = {
+            .srcOffset = 0,
+            .dstOffset = 0,
+            .size      = streamingFeedback.GetSize(),
+        };
+        vkCmdCopyBuffer(
+            cmd, feedback, streamingFeedbackReadback[ frameIndex ].GetBuffer(), 1, &region );
+    }
+    barrier( makeBarrier( streamingFeedbackReadback[ frameIndex ].GetBuffer(),
+                          VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                          VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                          VK_PIPELINE_STAGE_2_HOST_BIT,
+                          VK_ACCESS_2_HOST_READ_BIT ) );
+
+    // reset for the next frame
+    barrier( makeBarrier( feedback,
+                          VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                          VK_ACCESS_2_TRANSFER_READ_BIT,
+                          VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                          VK_ACCESS_2_TRANSFER_WRITE_BIT ) );
+    vkCmdFillBuffer( cmd, feedback, 0, VK_WHOLE_SIZE, 0 );
+    barrier( makeBarrier( feedback,
+                          VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+                          VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                          VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR |
+                              VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                          VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                              VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT ) );
+}
+
+void TextureManager::TryHotReload()
+{
+    RG_CPU_ZONE( "TextureManager::TryHotReload" );
+
     uint32_t count = 0;
 
     for( const auto& newFilePath : texturesToReload )
@@ -385,71 +897,217 @@ void TextureManager::TryHotReload( VkCommandBuffer cmd, uint32_t frameIndex )
                 continue;
             }
 
-            constexpr bool isUpdateable = false;
-
             bool sameWithoutExt =
                 std::filesystem::path( slot->filepath ).replace_extension( "" ) == newFilePathNoExt;
 
             if( sameWithoutExt )
             {
-                TextureOverrides ovrd(
-                    newFilePath, Utils::IsSRGB( slot->format ), AnyImageLoader() );
-
-                if( ovrd.result )
-                {
-                    const auto prevSampler   = slot->samplerHandle;
-                    const auto prevSwizzling = slot->swizzling;
-
-                    AddToBeDestroyed( frameIndex, *slot );
-
-                    auto tindex = PrepareTexture( cmd,
-                                                  frameIndex,
-                                                  ovrd.result,
-                                                  prevSampler,
-                                                  true,
-                                                  ovrd.debugname,
-                                                  isUpdateable,
-                                                  prevSwizzling,
-                                                  std::move( ovrd.path ),
-                                                  slot );
-
-                    // must match, so materials' indices are still correct
-                    assert( tindex == std::distance( textures.begin(), slot ) );
-
-                    count++;
-                    break;
-                }
+                // decoded on the worker threads, and uploaded in UploadAsyncLoadedMaterials
+                auto request = AsyncTextureLoader::Request{
+                    .materialName       = {},
+                    .materialGeneration = 0,
+                    .hotReload =
+                        AsyncTextureLoader::HotReload{
+                            .textureIndex = uint32_t( std::distance( textures.begin(), slot ) ),
+                            .prevPath     = slot->filepath,
+                        },
+                };
+                request.paths[ 0 ]  = newFilePath;
+                request.isSRGB[ 0 ] = Utils::IsSRGB( slot->format );
+
+                asyncLoader->Enqueue( std::move( request ) );
+
+                count++;
+                break;
             }
         }
     }
 
     if( !texturesToReload.empty() )
     {
-        debug::Info( "Hot-reloaded textures: {} out of {}", count, texturesToReload.size() );
+        debug::Info( "Hot-reloading textures: {} out of {}", count, texturesToReload.size() );
     }
 
     texturesToReload.clear();
 }
 
-void TextureManager::SubmitDescriptors( uint32_t                         frameIndex,
-                                        const RgDrawFrameTexturesParams& texturesParams,
-                                        bool                             forceUpdateAllDescriptors )
+void TextureManager::UploadHotReloaded( VkCommandBuffer              cmd,
+                                        uint32_t                     frameIndex,
+                                        AsyncTextureLoader::Result&& loaded )
 {
-    // check if dynamic sampler filter was changed
-    RgSamplerFilter newDynamicSamplerFilter = texturesParams.dynamicSamplerFilter;
+    const auto& hotReload = *loaded.hotReload;
+    const auto& ovrd      = loaded.textures[ 0 ];
+
+    auto slot = textures.begin() + hotReload.textureIndex;
 
-    if( currentDynamicSamplerFilter != newDynamicSamplerFilter )
+    // slot was freed or reused, while the file was loading
+    if( slot->image == VK_NULL_HANDLE || slot->filepath != hotReload.prevPath )
     {
-        currentDynamicSamplerFilter = newDynamicSamplerFilter;
-        forceUpdateAllDescriptors   = true;
+        return;
     }
 
+    if( !ovrd || !ovrd->result )
+    {
+        debug::Warning( "Hot-reload failed: {}", hotReload.prevPath.string() );
+        return;
+    }
+
+    constexpr bool isUpdateable = false;
 
-    if( forceUpdateAllDescriptors )
+    Texture prev = std::move( *slot );
+    *slot        = {};
+
+    auto tindex = PrepareTexture( cmd,
+                                  frameIndex,
+                                  ovrd->result,
+                                  prev.samplerHandle,
+                                  true,
+                                  ovrd->debugname,
+                                  isUpdateable,
+                                  prev.swizzling,
+                                  std::move( ovrd->path ),
+                                  slot,
+                                  prev.isNormalMap );
+
+    if( tindex == EMPTY_TEXTURE_INDEX )
     {
-        textureDesc->ResetAllCache( frameIndex );
+        // keep the previous version
+        *slot = std::move( prev );
+        return;
     }
 
+    // must match, so materials' indices are still correct
+    assert( tindex == hotReload.textureIndex );
+
+    // descriptor is written in SubmitDescriptors, as the view has changed
+    AddToBeDestroyed( frameIndex, prev );
+
+    // hot-reloaded texture is always fully resident
+    streamedTextures.erase( tindex );
+}
+
+void TextureManager::UploadAsyncLoadedMaterials( VkCommandBuffer cmd, uint32_t frameIndex )
+{
+    RG_HITCH_MARKER( "Texture creation: async loaded materials" );
+
+    for( auto& loaded :
+         asyncLoader->TakeFinished( MaxAsyncMaterialUploadsPerFrame, MaxAsyncUploadBytesPerFrame ) )
+    {
+        if( loaded.hotReload )
+        {
+            UploadHotReloaded( cmd, frameIndex, std::move( loaded ) );
+            continue;
+        }
+
+        auto it = materials.find( loaded.materialName );
+
+        // material was destroyed or recreated, while its files were loading
+        if( it == materials.end() || it->second.generation != loaded.materialGeneration )
+        {
+            continue;
+        }
+
+        Material& mat = it->second;
+
+        for( uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++ )
+        {
+            const auto& ovrd = loaded.textures[ i ];
+
+            if( !ovrd || !ovrd->result || mat.textures.indices[ i ] == EMPTY_TEXTURE_INDEX )
+            {
+                continue;
+            }
+
+            const uint32_t textureIndex = mat.textures.indices[ i ];
+            auto           streamed     = streamedTextures.find( textureIndex );
+
+            // if streaming, the full mip chain is uploaded only if it was requested
+            auto tail = std::optional< ImageLoader::ResultInfo >{};
+            if( streamingEnabled )
+            {
+                bool requestedFull =
+                    streamed != streamedTextures.end() && !streamed->second.isFullyResident;
+
+                if( !requestedFull )
+                {
+                    tail = MakeTailMips( *ovrd->result );
+                }
+            }
+
+            // indices might be already used by static geometry, so write to the same slot
+            auto slot = textures.begin() + textureIndex;
+
+            Texture prev = std::move( *slot );
+            *slot        = {};
+
+            auto filepath = ovrd->path;
+            auto tindex   = PrepareTexture( cmd,
+                                          frameIndex,
+                                          tail ? tail : ovrd->result,
+                                          prev.samplerHandle,
+                                          true,
+                                          ovrd->debugname,
+                                          mat.isUpdateable,
+                                          prev.swizzling,
+                                          std::move( ovrd->path ),
+                                          slot,
+                                          i == TEXTURE_NORMAL_INDEX );
+
+            if( tindex == EMPTY_TEXTURE_INDEX )
+            {
+                // keep the original
+                *slot = std::move( prev );
+                if( streamed != streamedTextures.end() )
+                {
+                    streamed->second.isLoading = false;
+                }
+                continue;
+            }
+            assert( tindex == textureIndex );
+
+            if( prev.image != VK_NULL_HANDLE )
+            {
+                AddToBeDestroyed( frameIndex, prev );
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if( tail )
+            {
+                streamedTextures[ textureIndex ] = StreamedTexture{
+                    .materialName         = loaded.materialName,
+                    .materialGeneration   = loaded.materialGeneration,
+                    .materialTextureIndex = i,
+                    .path                 = std::move( filepath ),
+                    .isSRGB               = Utils::IsSRGB( ovrd->result->format ),
+                    .residentMaxSize      = std::max( tail->baseSize.width, tail->baseSize.height ),
+                    .isFullyResident      = false,
+                    .isLoading            = false,
+                    .lastRequested        = now,
+                };
+            }
+            else if( streamed != streamedTextures.end() )
+            {
+                const auto& full = ovrd->result->baseSize;
+
+                streamed->second.residentMaxSize = std::max( full.width, full.height );
+                streamed->second.isFullyResident = true;
+                streamed->second.isLoading       = false;
+                streamed->second.lastRequested   = now;
+            }
+        }
+    }
+}
+
+void TextureManager::SubmitDescriptors( uint32_t                         frameIndex,
+                                        const RgDrawFrameTexturesParams& texturesParams )
+{
+    RG_CPU_ZONE( "TextureManager::SubmitDescriptors" );
+
+    // if dynamic sampler filter was changed, only the sampler indices are rewritten
+    RgSamplerFilter newDynamicSamplerFilter = texturesParams.dynamicSamplerFilter;
+
+    textureDesc->UpdateSamplers( frameIndex );
+
     // update desc set with current values
     for( uint32_t i = 0; i < textures.size(); i++ )
     {
@@ -471,10 +1129,11 @@ void TextureManager::SubmitDescriptors( uint32_t                         frameIn
     textureDesc->FlushDescWrites();
 }
 
-bool TextureManager::TryCreateMaterial( VkCommandBuffer              cmd,
-                                        uint32_t                     frameIndex,
-                                        const RgOriginalTextureInfo& info,
-                                        const std::filesystem::path& ovrdFolder )
+bool TextureManager::TryCreateMaterial( VkCommandBuffer                cmd,
+                                        uint32_t                       frameIndex,
+                                        const RgOriginalTextureInfo&   info,
+                                        const std::filesystem::path&   ovrdFolder,
+                                        const ImageLoader::ResultInfo* providedAlbedo )
 {
     if( Utils::IsCstrEmpty( info.pTextureName ) )
     {
@@ -511,17 +1170,61 @@ bool TextureManager::TryCreateMaterial( VkCommandBuffer              cmd,
     auto details = pnext::find< RgOriginalTextureDetailsEXT >( &info );
 
 
+    const VkFormat formats[] = {
+        getVkFormat( details, VK_FORMAT_R8G8B8A8_SRGB ),
+        VK_FORMAT_R8G8B8A8_UNORM,
+        VK_FORMAT_R8G8B8A8_UNORM,
+        VK_FORMAT_R8G8B8A8_SRGB,
+        VK_FORMAT_R8_UNORM,
+    };
+    static_assert( std::size( formats ) == TEXTURES_PER_MATERIAL_COUNT );
+
+
+    // override files are only searched here, and decoded on worker threads;
+    // until then, the original pixels are used
+    auto                     asyncRequest = AsyncTextureLoader::Request{};
+    TextureOverrides::Loader loaders[ TEXTURES_PER_MATERIAL_COUNT ];
+
+    for( uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++ )
+    {
+        // opacity micromaps need CPU-side albedo on material creation
+        if( i == TEXTURE_ALBEDO_ALPHA_INDEX && g_supportsOpacityMicromap )
+        {
+            loaders[ i ] = OnlyKTX2LoaderIfNonDevMode();
+            continue;
+        }
+
+        loaders[ i ]             = NoFileLoader();
+        asyncRequest.isSRGB[ i ] = Utils::IsSRGB( formats[ i ] );
+        asyncRequest.paths[ i ]  = TextureOverrides::FindTexturePath( ovrdFolder,
+                                                                     info.pTextureName,
+                                                                     postfixes[ i ],
+                                                                     OnlyKTX2LoaderIfNonDevMode(),
+                                                                     &fileIndex );
+    }
+
+
+    // provided levels are used directly, if override file wasn't found
+    const void* albedoPixels = providedAlbedo ? nullptr : info.pPixels;
+
     // clang-format off
     TextureOverrides ovrd[] = {
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 0 ], info.pPixels, info.size, getVkFormat( details, VK_FORMAT_R8G8B8A8_SRGB ), OnlyKTX2LoaderIfNonDevMode() },
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 1 ], nullptr, {}, VK_FORMAT_R8G8B8A8_UNORM, OnlyKTX2LoaderIfNonDevMode() },
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 2 ], nullptr, {}, VK_FORMAT_R8G8B8A8_UNORM, OnlyKTX2LoaderIfNonDevMode() },
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 3 ], nullptr, {}, VK_FORMAT_R8G8B8A8_SRGB, OnlyKTX2LoaderIfNonDevMode() },
-        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 4 ], nullptr, {}, VK_FORMAT_R8_UNORM, OnlyKTX2LoaderIfNonDevMode() },
+        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 0 ], albedoPixels, info.size, formats[ 0 ], loaders[ 0 ], &fileIndex },
+        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 1 ], nullptr, {}, formats[ 1 ], loaders[ 1 ], &fileIndex },
+        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 2 ], nullptr, {}, formats[ 2 ], loaders[ 2 ], &fileIndex },
+        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 3 ], nullptr, {}, formats[ 3 ], loaders[ 3 ], &fileIndex },
+        TextureOverrides{ ovrdFolder, info.pTextureName, postfixes[ 4 ], nullptr, {}, formats[ 4 ], loaders[ 4 ], &fileIndex },
     };
     static_assert( std::size( ovrd ) == TEXTURES_PER_MATERIAL_COUNT );
     // clang-format on
 
+    if( providedAlbedo && !ovrd[ 0 ].result )
+    {
+        ovrd[ 0 ].result = *providedAlbedo;
+        ovrd[ 0 ].path   = TextureOverrides::GetTexturePath(
+            ovrdFolder / TEXTURES_FOLDER_DEV, info.pTextureName, postfixes[ 0 ], "" );
+    }
+
 
     SamplerManager::Handle samplers[] = {
         SamplerManager::Handle{ info.filter, info.addressModeU, info.addressModeV },
@@ -557,16 +1260,167 @@ bool TextureManager::TryCreateMaterial( VkCommandBuffer              cmd,
     }
 
 
-    MakeMaterial( cmd, frameIndex, info.pTextureName, ovrd, samplers, swizzlings );
+    MakeMaterial( cmd,
+                  frameIndex,
+                  info.pTextureName,
+                  ovrd,
+                  samplers,
+                  swizzlings,
+                  std::move( asyncRequest ) );
     return true;
 }
 
+bool TextureManager::ProvideOriginalAsync( const RgOriginalTextureInfo&     info,
+                                           const RgOriginalTextureAsyncEXT& async )
+{
+    // the pixels must be released exactly once, even if they're rejected
+    auto reject = [ & ]( std::string_view msg ) {
+        debug::Warning( "{}: {}", msg, Utils::SafeCstr( info.pTextureName ) );
+        if( async.pfnReleasePixels )
+        {
+            async.pfnReleasePixels( info.pPixels, async.pUserData );
+        }
+        return false;
+    };
+
+    if( Utils::IsCstrEmpty( info.pTextureName ) )
+    {
+        return reject( "RgOriginalTextureInfo::pTextureName must not be null or an empty string" );
+    }
+
+    if( info.pPixels == nullptr )
+    {
+        return reject( "RgOriginalTextureInfo::pPixels must not be null" );
+    }
+
+    const RgFormat format = apichain::OriginalTextureFormat( info );
+
+    if( apichain::OriginalTextureLevelSize( format, 1, 1 ) == 0 )
+    {
+        return reject( "RgOriginalTextureDetailsEXT::format is not supported" );
+    }
+
+    if( isBlockCompressed( format ) && async.pregeneratedLevelCount == 0 )
+    {
+        return reject( "Block-compressed format requires "
+                       "RgOriginalTextureAsyncEXT::pregeneratedLevelCount to be not 0" );
+    }
+
+    if( async.pregeneratedLevelCount > MAX_PREGENERATED_MIPMAP_LEVELS )
+    {
+        return reject( "RgOriginalTextureAsyncEXT::pregeneratedLevelCount is too large" );
+    }
+
+
+    auto levels = ImageLoader::ResultInfo{
+        .levelOffsets   = {},
+        .levelSizes     = {},
+        .levelCount     = apichain::OriginalTextureLevelCount( info ),
+        .isPregenerated = async.pregeneratedLevelCount > 0,
+        .pData          = static_cast< const uint8_t* >( info.pPixels ),
+        .dataSize       = 0,
+        .baseSize       = info.size,
+        .format         = toVkFormat( format ),
+    };
+
+    for( uint32_t i = 0; i < levels.levelCount; i++ )
+    {
+        levels.levelOffsets[ i ] = levels.dataSize;
+        levels.levelSizes[ i ]   = apichain::OriginalTextureLevelSize(
+            format, std::max( info.size.width >> i, 1u ), std::max( info.size.height >> i, 1u ) );
+
+        levels.dataSize += levels.levelSizes[ i ];
+    }
+    assert( levels.dataSize == apichain::OriginalTextureDataSize( info ) );
+
+
+    auto details = pnext::find< RgOriginalTextureDetailsEXT >( &info );
+
+    auto p = ProvidedOriginal{
+        .name    = info.pTextureName,
+        .info    = info,
+        .details = details ? *details
+                           : RgOriginalTextureDetailsEXT{
+                                 .sType  = RG_STRUCTURE_TYPE_ORIGINAL_TEXTURE_DETAILS_EXT,
+                                 .pNext  = nullptr,
+                                 .flags  = 0,
+                                 .format = format,
+                             },
+        .levels           = levels,
+        .ownedPixels      = {},
+        .pfnReleasePixels = async.pfnReleasePixels,
+        .pUserData        = async.pUserData,
+    };
+
+    // no callback, so the caller keeps the ownership
+    if( !async.pfnReleasePixels )
+    {
+        p.ownedPixels.assign( levels.pData, levels.pData + levels.dataSize );
+        p.levels.pData = p.ownedPixels.data();
+    }
+
+    {
+        auto lock = std::lock_guard{ providedMutex };
+        provided.push_back( std::move( p ) );
+    }
+    return true;
+}
+
+auto TextureManager::CreateProvidedMaterials( VkCommandBuffer              cmd,
+                                              uint32_t                     frameIndex,
+                                              const std::filesystem::path& ovrdFolder )
+    -> std::vector< std::string >
+{
+    RG_CPU_ZONE( "TextureManager::CreateProvidedMaterials" );
+
+    auto toCreate = std::vector< ProvidedOriginal >{};
+    {
+        auto lock = std::lock_guard{ providedMutex };
+
+        // same limits as for the async loaded materials, but at least one is taken
+        size_t bytes = 0;
+        while( !provided.empty() && toCreate.size() < MaxAsyncMaterialUploadsPerFrame &&
+               ( toCreate.empty() ||
+                 bytes + provided.front().levels.dataSize <= MaxAsyncUploadBytesPerFrame ) )
+        {
+            bytes += provided.front().levels.dataSize;
+            toCreate.push_back( std::move( provided.front() ) );
+            provided.pop_front();
+        }
+    }
+
+    auto created = std::vector< std::string >{};
+
+    for( ProvidedOriginal& p : toCreate )
+    {
+        // pointers are set only now, as the struct was moved
+        p.details.pNext     = nullptr;
+        p.info.pNext        = &p.details;
+        p.info.pTextureName = p.name.c_str();
+        p.info.pPixels      = p.levels.pData;
+
+        if( TryCreateMaterial( cmd, frameIndex, p.info, ovrdFolder, &p.levels ) )
+        {
+            created.push_back( p.name );
+        }
+
+        // the pixels are already copied to the staging memory
+        if( p.pfnReleasePixels )
+        {
+            p.pfnReleasePixels( p.levels.pData, p.pUserData );
+        }
+    }
+
+    return created;
+}
+
 void TextureManager::MakeMaterial( VkCommandBuffer                                  cmd,
                                    uint32_t                                         frameIndex,
                                    std::string_view                                 materialName,
                                    std::span< TextureOverrides >                    ovrd,
                                    std::span< const SamplerManager::Handle >        samplers,
-                                   std::span< std::optional< RgTextureSwizzling > > swizzlings )
+                                   std::span< std::optional< RgTextureSwizzling > > swizzlings,
+                                   AsyncTextureLoader::Request&&                    asyncRequest )
 {
     assert( ovrd.size() == TEXTURES_PER_MATERIAL_COUNT );
     assert( samplers.size() == TEXTURES_PER_MATERIAL_COUNT );
@@ -574,6 +1428,22 @@ void TextureManager::MakeMaterial( VkCommandBuffer
 
     constexpr bool isUpdateable = false;
 
+    // for baking opacity micromaps, CPU-side data is needed
+    std::shared_ptr< const OpacityMask > opacityMask{};
+    if( g_supportsOpacityMicromap )
+    {
+        const auto& albedo = ovrd[ TEXTURE_ALBEDO_ALPHA_INDEX ].result;
+        if( albedo && !albedo->IsGDeflate() &&
+            ( albedo->format == VK_FORMAT_R8G8B8A8_SRGB ||
+              albedo->format == VK_FORMAT_R8G8B8A8_UNORM ) &&
+            albedo->levelSizes[ 0 ] >= size_t{ albedo->baseSize.width } *
+                                           albedo->baseSize.height * 4 )
+        {
+            opacityMask = OpacityMask::FromRGBA8( albedo->pData + albedo->levelOffsets[ 0 ],
+                                                  albedo->baseSize );
+        }
+    }
+
     MaterialTextures mtextures = {};
     for( uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++ )
     {
@@ -586,15 +1456,60 @@ void TextureManager::MakeMaterial( VkCommandBuffer
                                                  isUpdateable,
                                                  swizzlings[ i ],
                                                  std::move( ovrd[ i ].path ),
-                                                 FindEmptySlot( textures ) );
+                                                 FindEmptySlot( textures ),
+                                                 i == TEXTURE_NORMAL_INDEX );
     }
 
+    // reserve slots for the textures that will be loaded asynchronously,
+    // so the indices stay the same after the upload
+    bool anyAsync = false;
+    for( uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++ )
+    {
+        if( asyncRequest.paths[ i ].empty() )
+        {
+            continue;
+        }
+
+        if( mtextures.indices[ i ] == EMPTY_TEXTURE_INDEX )
+        {
+            auto slot = FindEmptySlot( textures );
+            if( slot == textures.end() )
+            {
+                debug::Warning( "Reached texture limit: {}, while reserving for {}",
+                                textures.size(),
+                                asyncRequest.paths[ i ].string() );
+                asyncRequest.paths[ i ].clear();
+                continue;
+            }
+
+            *slot = Texture{
+                .samplerHandle = samplers[ i ],
+                .swizzling     = swizzlings[ i ],
+                .reserved      = true,
+            };
+            mtextures.indices[ i ] = uint32_t( std::distance( textures.begin(), slot ) );
+        }
+
+        anyAsync = true;
+    }
+
+    const uint64_t generation = ++materialGenerationCounter;
+
     InsertMaterial( frameIndex,
                     materialName,
                     Material{
                         .textures     = mtextures,
                         .isUpdateable = isUpdateable,
+                        .opacityMask  = std::move( opacityMask ),
+                        .generation   = generation,
                     } );
+
+    if( anyAsync )
+    {
+        asyncRequest.materialName       = std::string( materialName );
+        asyncRequest.materialGeneration = generation;
+        asyncLoader->Enqueue( std::move( asyncRequest ) );
+    }
 }
 
 bool TextureManager::TryCreateImportedMaterial( VkCommandBuffer    cmd,
@@ -657,13 +1572,35 @@ bool TextureManager::TryCreateImportedMaterial( VkCommandBuffer    cmd,
         return false;
     }
 
+    // files are decoded on worker threads, the material is empty until then
+    auto asyncRequest = AsyncTextureLoader::Request{
+        .isSRGB = { true, false, false, true, true },
+    };
+    TextureOverrides::Loader loaders[ TEXTURES_PER_MATERIAL_COUNT ];
+
+    for( uint32_t i = 0; i < TEXTURES_PER_MATERIAL_COUNT; i++ )
+    {
+        // opacity micromaps need CPU-side albedo on material creation
+        if( i == TEXTURE_ALBEDO_ALPHA_INDEX && g_supportsOpacityMicromap )
+        {
+            loaders[ i ] = AnyImageLoader();
+            continue;
+        }
+
+        loaders[ i ] = NoFileLoader();
+        if( std::filesystem::is_regular_file( fullPaths[ i ] ) )
+        {
+            asyncRequest.paths[ i ] = fullPaths[ i ];
+        }
+    }
+
     // clang-format off
     TextureOverrides ovrd[] = {
-        TextureOverrides{ fullPaths[ 0 ], true, AnyImageLoader() },
-        TextureOverrides{ fullPaths[ 1 ], false, AnyImageLoader() },
-        TextureOverrides{ fullPaths[ 2 ], false, AnyImageLoader() },
-        TextureOverrides{ fullPaths[ 3 ], true, AnyImageLoader() },
-        TextureOverrides{ fullPaths[ 4 ], true, AnyImageLoader() },
+        TextureOverrides{ fullPaths[ 0 ], asyncRequest.isSRGB[ 0 ], loaders[ 0 ] },
+        TextureOverrides{ fullPaths[ 1 ], asyncRequest.isSRGB[ 1 ], loaders[ 1 ] },
+        TextureOverrides{ fullPaths[ 2 ], asyncRequest.isSRGB[ 2 ], loaders[ 2 ] },
+        TextureOverrides{ fullPaths[ 3 ], asyncRequest.isSRGB[ 3 ], loaders[ 3 ] },
+        TextureOverrides{ fullPaths[ 4 ], asyncRequest.isSRGB[ 4 ], loaders[ 4 ] },
     };
     static_assert( std::size( ovrd ) == TEXTURES_PER_MATERIAL_COUNT );
     // clang-format on
@@ -684,7 +1621,8 @@ bool TextureManager::TryCreateImportedMaterial( VkCommandBuffer    cmd,
         materialName, isReplacement ? ImportedType::ForReplacement : ImportedType::ForStatic );
     assert( isNew );
 
-    MakeMaterial( cmd, frameIndex, materialName, ovrd, samplers, swizzlings );
+    MakeMaterial(
+        cmd, frameIndex, materialName, ovrd, samplers, swizzlings, std::move( asyncRequest ) );
     return true;
 }
 
@@ -710,6 +1648,9 @@ void TextureManager::FreeAllImportedMaterials( uint32_t frameIndex, bool freeRep
         erase_if( importedMaterials,
                   []( const auto& kv ) { return kv.second != ImportedType::ForReplacement; } );
     }
+
+    // freed textures leave gaps in the memory blocks
+    RequestDefragmentation();
 }
 
 uint32_t TextureManager::PrepareTexture( VkCommandBuffer                                 cmd,
@@ -721,7 +1662,8 @@ uint32_t TextureManager::PrepareTexture( VkCommandBuffer
                                          bool                                isUpdateable,
                                          std::optional< RgTextureSwizzling > swizzling,
                                          std::filesystem::path&&             filepath,
-                                         std::vector< Texture >::iterator    targetSlot )
+                                         std::vector< Texture >::iterator    targetSlot,
+                                         bool                                isNormalMap )
 {
     if( !info )
     {
@@ -763,22 +1705,61 @@ uint32_t TextureManager::PrepareTexture( VkCommandBuffer
     }
     // SHIPPING_HACK end
 
+    // updateable images are written in place, so they can't be shared
+    uint64_t contentHash =
+        isUpdateable ? 0 : HashTextureContents( *info, useMipmaps, swizzling, isNormalMap );
+    const uint64_t checksum = contentHash != 0 ? ChecksumTextureContents( *info ) : 0;
+
+    if( contentHash != 0 )
+    {
+        auto found = sharedImages.find( contentHash );
+        if( found != sharedImages.end() &&
+            ( found->second.format != info->format ||
+              found->second.size.width != info->baseSize.width ||
+              found->second.size.height != info->baseSize.height ||
+              found->second.dataSize != info->dataSize || found->second.checksum != checksum ) )
+        {
+            // hash collision: upload as a separate image, that is not shared
+            contentHash = 0;
+        }
+        else if( found != sharedImages.end() )
+        {
+            found->second.refCount++;
+
+            *targetSlot = Texture{
+                .image         = found->second.image,
+                .view          = found->second.view,
+                .size          = info->baseSize,
+                .format        = info->format,
+                .samplerHandle = samplerHandle,
+                .swizzling     = swizzling,
+                .filepath      = std::move( filepath ),
+                .isNormalMap   = isNormalMap,
+                .contentHash   = contentHash,
+            };
+            return uint32_t( std::distance( textures.begin(), targetSlot ) );
+        }
+    }
+
     auto uploadInfo = TextureUploader::UploadInfo{
-        .cmd                    = cmd,
-        .frameIndex             = frameIndex,
-        .pData                  = info->pData,
-        .dataSize               = info->dataSize,
-        .cubemap                = {},
-        .baseSize               = info->baseSize,
-        .format                 = info->format,
-        .useMipmaps             = useMipmaps,
-        .pregeneratedLevelCount = info->isPregenerated ? info->levelCount : 0,
-        .pLevelDataOffsets      = info->levelOffsets,
-        .pLevelDataSizes        = info->levelSizes,
-        .isUpdateable           = isUpdateable,
-        .pDebugName             = debugName,
-        .isCubemap              = false,
-        .swizzling              = swizzling,
+        .cmd                     = cmd,
+        .frameIndex              = frameIndex,
+        .pData                   = info->pData,
+        .dataSize                = info->dataSize,
+        .cubemap                 = {},
+        .baseSize                = info->baseSize,
+        .format                  = info->format,
+        .useMipmaps              = useMipmaps,
+        .pregeneratedLevelCount  = info->isPregenerated ? info->levelCount : 0,
+        .pLevelDataOffsets       = info->levelOffsets,
+        .pLevelDataSizes         = info->levelSizes,
+        .pLevelPageSizes         = info->IsGDeflate() ? info->levelPageSizes : nullptr,
+        .pLevelDecompressedSizes = info->levelDecompressedSizes,
+        .isUpdateable            = isUpdateable,
+        .pDebugName              = debugName,
+        .isCubemap               = false,
+        .swizzling               = swizzling,
+        .isNormalMap             = isNormalMap,
     };
 
     auto [ wasUploaded, image, view ] = textureUploader->UploadImage( uploadInfo );
@@ -800,7 +1781,23 @@ uint32_t TextureManager::PrepareTexture( VkCommandBuffer
         .samplerHandle = samplerHandle,
         .swizzling     = uploadInfo.swizzling,
         .filepath      = std::move( filepath ),
+        .isNormalMap   = isNormalMap,
+        .contentHash   = contentHash,
     };
+
+    if( contentHash != 0 )
+    {
+        sharedImages.emplace( contentHash,
+                              SharedImage{
+                                  .image    = image,
+                                  .view     = view,
+                                  .refCount = 1,
+                                  .format   = info->format,
+                                  .size     = info->baseSize,
+                                  .dataSize = info->dataSize,
+                                  .checksum = checksum,
+                              } );
+    }
     return uint32_t( std::distance( textures.begin(), targetSlot ) );
 }
 
@@ -809,6 +1806,7 @@ void TextureManager::InsertMaterial( uint32_t         frameIndex,
                                      const Material&  material )
 {
     auto [ iter, insertednew ] = materials.emplace( std::string( materialName ), material );
+    handleToMaterial.Clear();
 
     if( !insertednew )
     {
@@ -837,7 +1835,18 @@ void TextureManager::DestroyMaterialTextures( uint32_t frameIndex, const Materia
     {
         if( t != EMPTY_TEXTURE_INDEX )
         {
-            AddToBeDestroyed( frameIndex, textures[ t ] );
+            streamedTextures.erase( t );
+
+            if( textures[ t ].image != VK_NULL_HANDLE )
+            {
+                AddToBeDestroyed( frameIndex, textures[ t ] );
+            }
+            else
+            {
+                // asynchronous upload hasn't finished yet, just free the reserved slot
+                assert( textures[ t ].reserved );
+                textures[ t ] = {};
+            }
         }
     }
 }
@@ -857,6 +1866,7 @@ bool TextureManager::TryDestroyMaterial( uint32_t frameIndex, const char* materi
 
     DestroyMaterialTextures( frameIndex, it->second );
     materials.erase( it );
+    handleToMaterial.Clear();
 
     forceExportAsExternal.erase( materialName );
 
@@ -867,6 +1877,22 @@ void TextureManager::DestroyTexture( const Texture& texture )
 {
     assert( texture.image != VK_NULL_HANDLE && texture.view != VK_NULL_HANDLE );
 
+    if( texture.contentHash != 0 )
+    {
+        auto found = sharedImages.find( texture.contentHash );
+        assert( found != sharedImages.end() && found->second.refCount > 0 );
+
+        if( found != sharedImages.end() )
+        {
+            // still used by other slots
+            if( --found->second.refCount > 0 )
+            {
+                return;
+            }
+            sharedImages.erase( found );
+        }
+    }
+
     textureUploader->DestroyImage( texture.image, texture.view );
 }
 
@@ -897,6 +1923,41 @@ MaterialTextures TextureManager::GetMaterialTextures( const char* materialName )
     return it->second.textures;
 }
 
+MaterialTextures TextureManager::GetMaterialTextures( const char*  materialName,
+                                                     RgNameHandle materialHandle ) const
+{
+    uint32_t index = handleToMaterial.Get( materialHandle, [ & ] {
+        if( Utils::IsCstrEmpty( materialName ) )
+        {
+            return UINT32_MAX;
+        }
+        const auto it = materials.find( materialName );
+        return it != materials.end() ? uint32_t( it - materials.begin() ) : UINT32_MAX;
+    } );
+
+    if( index >= materials.size() )
+    {
+        return EmptyMaterialTextures;
+    }
+    return ( materials.begin() + index )->second.textures;
+}
+
+auto TextureManager::GetOpacityMask( const char* materialName ) const -> const OpacityMask*
+{
+    if( Utils::IsCstrEmpty( materialName ) )
+    {
+        return nullptr;
+    }
+
+    const auto it = materials.find( materialName );
+    if( it == materials.end() )
+    {
+        return nullptr;
+    }
+
+    return it->second.opacityMask.get();
+}
+
 VkDescriptorSet TextureManager::GetDescSet( uint32_t frameIndex ) const
 {
     return textureDesc->GetDescSet( frameIndex );
@@ -912,6 +1973,7 @@ void TextureManager::OnFileChanged( FileType type, const std::filesystem::path&
     if( type == FileType::PNG || type == FileType::TGA || type == FileType::KTX2 ||
         type == FileType::JPG )
     {
+        fileIndex.Add( filepath );
         texturesToReload.push_back( filepath );
     }
 }
@@ -931,21 +1993,31 @@ uint32_t TextureManager::GetSceneBuildingTextureIndex() const
     return sceneBuildingTextureIndex;
 }
 
+VkImageView TextureManager::GetTextureView( uint32_t textureIndex ) const
+{
+    return textureIndex < textures.size() ? textures[ textureIndex ].view : VK_NULL_HANDLE;
+}
+
 std::array< MaterialTextures, 4 > TextureManager::GetTexturesForLayers(
     const RgMeshPrimitiveInfo& primitive ) const
 {
+    RG_CPU_ZONE( "TextureManager::GetTexturesForLayers" );
+
+    auto handleExt = pnext::find< RgMeshPrimitiveNameHandleEXT >( &primitive );
+    auto handle    = handleExt ? handleExt->textureName : 0;
+
 #if !SUPPRESS_TEXLAYERS
     auto layers = pnext::find< RgMeshPrimitiveTextureLayersEXT >( &primitive );
 
     return {
-        GetMaterialTextures( primitive.pTextureName ),
+        GetMaterialTextures( primitive.pTextureName, handle ),
         GetMaterialTextures( layers && layers->pLayer1 ? layers->pLayer1->pTextureName : nullptr ),
         GetMaterialTextures( layers && layers->pLayer2 ? layers->pLayer2->pTextureName : nullptr ),
         GetMaterialTextures( layers && layers->pLayer3 ? layers->pLayer3->pTextureName : nullptr ),
     };
 #else
     return {
-        GetMaterialTextures( primitive.pTextureName ),
+        GetMaterialTextures( primitive.pTextureName, handle ),
         {},
         {},
         {},
@@ -1034,7 +2106,8 @@ auto TryCopyFromLookupFolder( const std::filesystem::path* srcFolder,
 auto TextureManager::ExportMaterialTextures( const char*                  materialName,
                                              const std::filesystem::path& folder,
                                              bool                         overwriteExisting,
-                                             const std::filesystem::path* lookupFolder ) const
+                                             const std::filesystem::path* lookupFolder,
+                                             TextureExporter*             deferredWrites ) const
     -> std::array< ExportResult, TEXTURES_PER_MATERIAL_COUNT >
 {
     std::array< ExportResult, TEXTURES_PER_MATERIAL_COUNT > arr;
@@ -1077,14 +2150,22 @@ auto TextureManager::ExportMaterialTextures( const char*                  materi
         }
         else
         {
-            exported = TextureExporter{}.ExportAsTGA( *memAllocator,
-                                                      *cmdManager,
-                                                      info.image,
-                                                      info.size,
-                                                      info.format,
-                                                      folder / relativeFilePath,
-                                                      asSrgb,
-                                                      overwriteExisting );
+            auto  immediate = TextureExporter{};
+            auto& exporter  = deferredWrites ? *deferredWrites : immediate;
+
+            exported = exporter.ExportAsTGA( *memAllocator,
+                                             *cmdManager,
+                                             info.image,
+                                             info.size,
+                                             info.format,
+                                             folder / relativeFilePath,
+                                             asSrgb,
+                                             overwriteExisting );
+
+            if( !deferredWrites )
+            {
+                exported = exported && immediate.WriteFinished();
+            }
         }
 
         if( exported )
@@ -1107,6 +2188,9 @@ void TextureManager::ExportOriginalMaterialTextures( const std::filesystem::path
 {
     constexpr bool overwriteExisting = false;
 
+    // all readbacks are submitted first, then written at once
+    auto exporter = TextureExporter{};
+
     for( const auto& [ materialName, mat ] : materials )
     {
         if( materialName.empty() )
@@ -1142,14 +2226,14 @@ void TextureManager::ExportOriginalMaterialTextures( const std::filesystem::path
             bool asSrgb = ( i == TEXTURE_ALBEDO_ALPHA_INDEX ) || ( i == TEXTURE_EMISSIVE_INDEX );
             assert( asSrgb == Utils::IsSRGB( info.format ) );
 
-            TextureExporter().ExportAsTGA( *memAllocator,
-                                           *cmdManager,
-                                           info.image,
-                                           info.size,
-                                           info.format,
-                                           folder / relativeFilePath,
-                                           asSrgb,
-                                           overwriteExisting );
+            exporter.ExportAsTGA( *memAllocator,
+                                  *cmdManager,
+                                  info.image,
+                                  info.size,
+                                  info.format,
+                                  folder / relativeFilePath,
+                                  asSrgb,
+                                  overwriteExisting );
         }
     }
 }
@@ -21,9 +21,14 @@
 #pragma once
 
 #include <array>
+#include <chrono>
+#include <deque>
 #include <list>
+#include <mutex>
 #include <string>
 
+#include "AsyncTextureLoader.h"
+#include "Buffer.h"
 #include "CommandBufferManager.h"
 #include "Common.h"
 #include "IFileDependency.h"
@@ -31,6 +36,8 @@
 #include "ImageLoaderDev.h"
 #include "Material.h"
 #include "MemoryAllocator.h"
+#include "NameRegistry.h"
+#include "OpacityMicromap.h"
 #include "SamplerManager.h"
 #include "TextureDescriptors.h"
 #include "TextureOverrides.h"
@@ -41,6 +48,7 @@ namespace RTGL1
 
 
 struct TextureOverrides;
+class TextureExporter;
 
 
 class TextureManager : public IFileDependency
@@ -54,7 +62,8 @@ public:
                     const std::filesystem::path&            dirtMaskTexturePath,
                     const std::filesystem::path&            sceneBuildingTexturePath,
                     RgTextureSwizzling                      pbrSwizzling,
-                    bool                                    forceNormalMapFilterLinear );
+                    bool                                    forceNormalMapFilterLinear,
+                    uint64_t                                stagingRingSize );
     ~TextureManager() override;
 
     TextureManager( const TextureManager& other )                = delete;
@@ -62,18 +71,43 @@ public:
     TextureManager& operator=( const TextureManager& other )     = delete;
     TextureManager& operator=( TextureManager&& other ) noexcept = delete;
 
-    void PrepareForFrame( uint32_t frameIndex );
-    void TryHotReload( VkCommandBuffer cmd, uint32_t frameIndex );
-
-    void SubmitDescriptors( uint32_t                         frameIndex,
-                            const RgDrawFrameTexturesParams& texturesParams,
-                            bool                             forceUpdateAllDescriptors =
-                                false /* true, if mip lod bias was changed, for example */ );
+    // Textures that are uploaded after this call generate their mipmaps in a compute shader
+    void SetMipmapGenerator( std::shared_ptr< MipmapGenerator > generator );
 
-    bool TryCreateMaterial( VkCommandBuffer              cmd,
-                            uint32_t                     frameIndex,
-                            const RgOriginalTextureInfo& info,
-                            const std::filesystem::path& ovrdFolder );
+    void PrepareForFrame( uint32_t frameIndex );
+    // Changed files are decoded asynchronously, and uploaded in UploadAsyncLoadedMaterials
+    void TryHotReload();
+    void UploadAsyncLoadedMaterials( VkCommandBuffer cmd, uint32_t frameIndex );
+    // Must be called before submitting the frame's command buffer
+    void SubmitTransferUploads();
+    // Compact the texture memory, e.g. after a level load; it's done over the next frames
+    void RequestDefragmentation();
+    // Must be called before any texture is created or used in the 'cmd'
+    void DefragmentationStep( VkCommandBuffer cmd, uint32_t frameIndex );
+    // Must be called after the shaders that request texture resolutions
+    void CopyStreamingFeedback( VkCommandBuffer cmd, uint32_t frameIndex );
+    bool IsStreamingEnabled() const { return streamingEnabled; }
+
+    // Recreated samplers (e.g. mip lod bias change) are picked up automatically,
+    // only the sampler table is rewritten in that case
+    void SubmitDescriptors( uint32_t frameIndex, const RgDrawFrameTexturesParams& texturesParams );
+
+    // If 'providedAlbedo' is not null, it's used instead of 'info.pPixels',
+    // unless there's an override file
+    bool TryCreateMaterial( VkCommandBuffer                cmd,
+                            uint32_t                       frameIndex,
+                            const RgOriginalTextureInfo&   info,
+                            const std::filesystem::path&   ovrdFolder,
+                            const ImageLoader::ResultInfo* providedAlbedo = nullptr );
+
+    // Thread-safe. The material is created later, in CreateProvidedMaterials
+    bool ProvideOriginalAsync( const RgOriginalTextureInfo&     info,
+                               const RgOriginalTextureAsyncEXT& async );
+    // Returns the names of the created materials
+    auto CreateProvidedMaterials( VkCommandBuffer              cmd,
+                                  uint32_t                     frameIndex,
+                                  const std::filesystem::path& ovrdFolder )
+        -> std::vector< std::string >;
 
     bool TryCreateImportedMaterial( VkCommandBuffer                           cmd,
                                     uint32_t                                  frameIndex,
@@ -93,8 +127,15 @@ public:
     auto GetWaterNormalTextureIndex() const -> uint32_t;
     auto GetDirtMaskTextureIndex() const -> uint32_t;
     auto GetSceneBuildingTextureIndex() const -> uint32_t;
+    // Changes if the texture at the index was replaced, e.g. by streaming or hot reload
+    auto GetTextureView( uint32_t textureIndex ) const -> VkImageView;
 
     auto GetMaterialTextures( const char* materialName ) const -> MaterialTextures;
+    // Same, but the lookup by name is done once per handle
+    auto GetMaterialTextures( const char* materialName, RgNameHandle materialHandle ) const
+        -> MaterialTextures;
+    // Null, if albedo texture was not uncompressed RGBA8, or if micromaps are not supported
+    auto GetOpacityMask( const char* materialName ) const -> const OpacityMask*;
 
     auto GetTexturesForLayers( const RgMeshPrimitiveInfo& primitive ) const
         -> std::array< MaterialTextures, 4 >;
@@ -111,10 +152,13 @@ public:
         RgSamplerFilter      filter{ RG_SAMPLER_FILTER_AUTO };
     };
 
+    // If 'deferredWrites' is not null, the files are written by it later, which
+    // allows to not stall the render thread. Otherwise, they're written before return
     auto ExportMaterialTextures( const char*                  materialName,
                                  const std::filesystem::path& folder,
                                  bool                         overwriteExisting,
-                                 const std::filesystem::path* lookupFolder ) const
+                                 const std::filesystem::path* lookupFolder,
+                                 TextureExporter*             deferredWrites = nullptr ) const
         -> std::array< ExportResult, TEXTURES_PER_MATERIAL_COUNT >;
 
     void ExportOriginalMaterialTextures( const std::filesystem::path& folder ) const;
@@ -127,8 +171,38 @@ public:
 private:
     struct Material
     {
-        MaterialTextures textures;
-        bool             isUpdateable;
+        MaterialTextures                     textures;
+        bool                                 isUpdateable;
+        std::shared_ptr< const OpacityMask > opacityMask{};
+        uint64_t                             generation{ 0 };
+    };
+
+    // A texture that has only its tail mip levels uploaded, until shaders request more
+    struct StreamedTexture
+    {
+        std::string           materialName;
+        uint64_t              materialGeneration;
+        uint32_t              materialTextureIndex; // albedo, normal, etc
+        std::filesystem::path path;
+        bool                  isSRGB;
+        uint32_t              residentMaxSize; // max dimension of the uploaded base level
+        bool                  isFullyResident;
+        bool                  isLoading;
+
+        std::chrono::steady_clock::time_point lastRequested;
+    };
+
+    // Original texture that was provided asynchronously, and waits for CreateProvidedMaterials
+    struct ProvidedOriginal
+    {
+        std::string                        name;
+        RgOriginalTextureInfo              info;
+        RgOriginalTextureDetailsEXT        details;
+        ImageLoader::ResultInfo            levels;
+        // if the pixels were copied, otherwise they're released by the callback
+        std::vector< uint8_t >             ownedPixels;
+        PFN_rgReleaseOriginalTexturePixels pfnReleasePixels;
+        void*                              pUserData;
     };
 
 private:
@@ -148,7 +222,8 @@ private:
                        std::string_view                                 materialName,
                        std::span< TextureOverrides >                    ovrd,
                        std::span< const SamplerManager::Handle >        samplers,
-                       std::span< std::optional< RgTextureSwizzling > > swizzlings );
+                       std::span< std::optional< RgTextureSwizzling > > swizzlings,
+                       AsyncTextureLoader::Request&&                    asyncRequest );
 
     uint32_t PrepareTexture( VkCommandBuffer                                 cmd,
                              uint32_t                                        frameIndex,
@@ -159,7 +234,15 @@ private:
                              bool                                            isUpdateable,
                              std::optional< RgTextureSwizzling >             swizzling,
                              std::filesystem::path&&                         filepath,
-                             std::vector< Texture >::iterator                targetSlot );
+                             std::vector< Texture >::iterator                targetSlot,
+                             bool                                            isNormalMap = false );
+
+    void UploadHotReloaded( VkCommandBuffer              cmd,
+                            uint32_t                     frameIndex,
+                            AsyncTextureLoader::Result&& loaded );
+
+    void ProcessStreamingFeedback( uint32_t frameIndex );
+    void RequestStreamedTexture( StreamedTexture& st );
 
     void DestroyTexture( const Texture& texture );
     void AddToBeDestroyed( uint32_t frameIndex, Texture& texture );
@@ -186,6 +269,9 @@ private:
         };
     }
 
+    // Only the default data is used, files are not searched
+    static TextureOverrides::Loader NoFileLoader() { return std::tuple< ImageLoader* >{ nullptr }; }
+
     TextureOverrides::Loader OnlyKTX2LoaderIfNonDevMode()
     {
         if( isdevmode )
@@ -216,10 +302,46 @@ private:
     std::shared_ptr< TextureDescriptors > textureDesc;
     std::shared_ptr< TextureUploader >    textureUploader;
 
+    std::unique_ptr< AsyncTextureLoader > asyncLoader;
+    uint64_t                              materialGenerationCounter{ 0 };
+
+    std::mutex                     providedMutex;
+    std::deque< ProvidedOriginal > provided;
+
+    bool streamingEnabled;
+    // max requested resolution per texture, written by shaders
+    Buffer streamingFeedback;
+    Buffer streamingFeedbackReadback[ MAX_FRAMES_IN_FLIGHT ];
+    // key: texture index
+    rgl::unordered_map< uint32_t, StreamedTexture > streamedTextures;
+
     std::vector< Texture >               textures;
     // Textures are not destroyed immediately, but only when they are not in use anymore
     std::vector< Texture >               texturesToDestroy[ MAX_FRAMES_IN_FLIGHT ];
     std::vector< std::filesystem::path > texturesToReload;
+    // to find override files of a new material without probing the file system
+    TextureFileIndex                     fileIndex;
+
+    bool                      defragRequested{ false };
+    // frame index of the command buffer that has the copies of the current pass
+    std::optional< uint32_t > defragPassFrameIndex{};
+    // views of the moved images, destroyed with them when the pass ends
+    std::vector< VkImageView > defragOldViews{};
+
+    struct SharedImage
+    {
+        VkImage     image;
+        VkImageView view;
+        // count of textures (including the ones in texturesToDestroy) that reference the image
+        uint32_t    refCount;
+        // the key is only a hash, so a match is verified with these
+        VkFormat    format;
+        RgExtent2D  size;
+        size_t      dataSize;
+        uint64_t    checksum;
+    };
+    // key: Texture::contentHash
+    rgl::unordered_map< uint64_t, SharedImage > sharedImages;
 
     enum class ImportedType
     {
@@ -230,12 +352,13 @@ private:
     rgl::string_map< Material >     materials;
     rgl::string_map< ImportedType > importedMaterials;
 
+    // index in 'materials' values, or UINT32_MAX if none; indices change only on insert / erase
+    mutable NameHandleCache< uint32_t > handleToMaterial;
+
     uint32_t waterNormalTextureIndex;
     uint32_t dirtMaskTextureIndex;
     uint32_t sceneBuildingTextureIndex;
 
-    RgSamplerFilter currentDynamicSamplerFilter;
-
     std::string postfixes[ TEXTURES_PER_MATERIAL_COUNT ];
 
     bool forceNormalMapFilterLinear;
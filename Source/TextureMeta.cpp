@@ -21,13 +21,161 @@
 #include "TextureMeta.h"
 
 #include "Const.h"
+#include "CpuProfiler.h"
+#include "DrawFrameInfo.h"
 #include "Utils.h"
 
+#include <format>
+#include <fstream>
+#include <span>
+
 
 namespace
 {
 std::string_view TEXTURES_FILENAME = "textures.json";
 
+constexpr char     META_CACHE_MAGIC[ 4 ] = { 'R', 'G', 'T', 'M' };
+constexpr uint32_t META_CACHE_VERSION    = 1;
+
+struct MetaCacheHeader
+{
+    char     magic[ 4 ];
+    uint32_t version;
+    uint64_t metaSize;
+    uint64_t count;
+};
+
+// Binary copy of a parsed json, so glaze runs only when the json was changed.
+// Empty, if the file can't be cached
+auto GetMetaCachePath( const std::filesystem::path& jsonPath ) -> std::filesystem::path
+{
+    std::error_code ec;
+
+    const auto fileSize = std::filesystem::file_size( jsonPath, ec );
+    if( ec )
+    {
+        return {};
+    }
+
+    const auto writeTime = std::filesystem::last_write_time( jsonPath, ec );
+    if( ec )
+    {
+        return {};
+    }
+
+    using ankerl::unordered_dense::detail::wyhash::hash;
+
+    // std::hash is not guaranteed to be the same between runs and builds
+    const auto pathStr = jsonPath.generic_u8string();
+
+    // a changed file has a different key, so the outdated cache is not read
+    const uint64_t values[] = {
+        hash( pathStr.data(), pathStr.size() ),
+        uint64_t( fileSize ),
+        uint64_t( writeTime.time_since_epoch().count() ),
+    };
+    const uint64_t key = hash( values, sizeof( values ) );
+
+    return jsonPath.parent_path() / RTGL1::DEV_TEXTURE_CACHE_FOLDER /
+           std::format( "{}.{:016x}.bin", jsonPath.filename().string(), key );
+}
+
+// All members after textureName are trivially copyable
+auto MetaBytes( RTGL1::TextureMeta& meta ) -> std::span< char >
+{
+    auto begin = reinterpret_cast< char* >( &meta.forceIgnore );
+    auto end   = reinterpret_cast< char* >( &meta ) + sizeof( RTGL1::TextureMeta );
+    return { begin, end };
+}
+
+auto ReadMetaCache( const std::filesystem::path& cachePath )
+    -> std::optional< RTGL1::TextureMetaArray >
+{
+    auto f = std::ifstream( cachePath, std::ios::binary );
+    if( !f )
+    {
+        return std::nullopt;
+    }
+
+    auto header = MetaCacheHeader{};
+    f.read( reinterpret_cast< char* >( &header ), sizeof( header ) );
+
+    if( !f || memcmp( header.magic, META_CACHE_MAGIC, sizeof( META_CACHE_MAGIC ) ) != 0 ||
+        header.version != META_CACHE_VERSION || header.metaSize != sizeof( RTGL1::TextureMeta ) )
+    {
+        return std::nullopt;
+    }
+
+    auto result = RTGL1::TextureMetaArray{};
+    result.array.resize( header.count );
+
+    for( RTGL1::TextureMeta& meta : result.array )
+    {
+        uint32_t nameLength = 0;
+        f.read( reinterpret_cast< char* >( &nameLength ), sizeof( nameLength ) );
+        if( !f )
+        {
+            return std::nullopt;
+        }
+
+        meta.textureName.resize( nameLength );
+        f.read( meta.textureName.data(), nameLength );
+
+        auto bytes = MetaBytes( meta );
+        f.read( bytes.data(), std::streamsize( bytes.size() ) );
+    }
+
+    if( !f )
+    {
+        return std::nullopt;
+    }
+    return result;
+}
+
+void WriteMetaCache( const std::filesystem::path& cachePath, RTGL1::TextureMetaArray& arr )
+{
+    std::error_code ec;
+    std::filesystem::create_directories( cachePath.parent_path(), ec );
+
+    const auto tmpPath = std::filesystem::path( cachePath ).concat( ".tmp" );
+    {
+        auto f = std::ofstream( tmpPath, std::ios::binary | std::ios::trunc );
+
+        auto header = MetaCacheHeader{
+            .version  = META_CACHE_VERSION,
+            .metaSize = sizeof( RTGL1::TextureMeta ),
+            .count    = arr.array.size(),
+        };
+        memcpy( header.magic, META_CACHE_MAGIC, sizeof( META_CACHE_MAGIC ) );
+        f.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+
+        for( RTGL1::TextureMeta& meta : arr.array )
+        {
+            auto nameLength = uint32_t( meta.textureName.size() );
+            f.write( reinterpret_cast< const char* >( &nameLength ), sizeof( nameLength ) );
+            f.write( meta.textureName.data(), nameLength );
+
+            auto bytes = MetaBytes( meta );
+            f.write( bytes.data(), std::streamsize( bytes.size() ) );
+        }
+
+        if( !f )
+        {
+            ec = std::make_error_code( std::errc::io_error );
+        }
+    }
+
+    if( !ec )
+    {
+        std::filesystem::rename( tmpPath, cachePath, ec );
+    }
+    if( ec )
+    {
+        std::filesystem::remove( tmpPath, ec );
+        RTGL1::debug::Verbose( "Failed to write texture meta cache: {}", cachePath.string() );
+    }
+}
+
 template< size_t N >
     requires( N == 3 || N == 4 )
 RgColor4DPacked32 ClampAndPackColor( std::array< int, N > color )
@@ -65,58 +213,89 @@ RTGL1::TextureMetaManager::TextureMetaManager( std::filesystem::path _databaseFo
     TextureMetaManager::OnFileChanged( FileType::JSON, sourceGlobal );
 }
 
-auto RTGL1::TextureMetaManager::Access( const char* pTextureName ) const
-    -> std::optional< TextureMeta >
+auto RTGL1::TextureMetaManager::Access( const char* pTextureName ) const -> const TextureMeta*
 {
     if( Utils::IsCstrEmpty( pTextureName ) )
     {
-        return std::nullopt;
+        return nullptr;
     }
 
-    auto strTextureName = std::string_view{ pTextureName };
-    {
-        auto found = dataScene.find( strTextureName );
-        if( found != dataScene.end() )
-        {
-            return found->second;
-        }
-    }
+    auto found = metaIndices.find( std::string_view{ pTextureName } );
+    if( found != metaIndices.end() )
     {
-        auto found = dataGlobal.find( strTextureName );
-        if( found != dataGlobal.end() )
-        {
-            return found->second;
-        }
+        return &metas[ found->second ];
     }
-    return std::nullopt;
+    return nullptr;
+}
+
+auto RTGL1::TextureMetaManager::Access( const char* pTextureName, RgNameHandle textureHandle ) const
+    -> const TextureMeta*
+{
+    uint32_t index = handleToMeta.Get( textureHandle, [ & ] {
+        const TextureMeta* meta = Access( pTextureName );
+        return meta ? uint32_t( meta - metas.data() ) : UINT32_MAX;
+    } );
+
+    return index < metas.size() ? &metas[ index ] : nullptr;
 }
 
 void RTGL1::TextureMetaManager::RereadFromFiles( std::filesystem::path sceneFile )
 {
     sourceScene = std::move( sceneFile );
 
-    dataGlobal.clear();
-    dataScene.clear();
+    metas.clear();
+    metaIndices.clear();
+    handleToMeta.Clear();
 
-    auto reread = [ this ]( const std::filesystem::path& filepath, auto& data ) {
+    auto reread = [ this ]( const std::filesystem::path& filepath, bool overrideExisting ) {
         if( !std::filesystem::exists( filepath ) )
         {
             return;
         }
 
-        if( auto arr = json_parser::ReadFileAs< TextureMetaArray >( filepath ) )
+        const auto cachePath = GetMetaCachePath( filepath );
+
+        auto arr = std::optional< TextureMetaArray >{};
+        if( !cachePath.empty() )
+        {
+            arr = ReadMetaCache( cachePath );
+        }
+        if( !arr )
+        {
+            arr = json_parser::ReadFileAs< TextureMetaArray >( filepath );
+            if( arr && !cachePath.empty() )
+            {
+                WriteMetaCache( cachePath, *arr );
+            }
+        }
+
+        if( arr )
         {
+            auto seen = rgl::string_set{};
+
             for( TextureMeta& v : arr->array )
             {
-                if( !data.contains( v.textureName ) )
-                {
-                    data.insert_or_assign( std::string{ v.textureName }, std::move( v ) );
-                }
-                else
+                if( seen.contains( v.textureName ) )
                 {
                     debug::Warning( "{}: textureName \"{}\" seen not once in the array, ignoring",
                                     filepath.string(),
                                     v.textureName );
+                    continue;
+                }
+                seen.insert( v.textureName );
+
+                auto existing = metaIndices.find( v.textureName );
+                if( existing != metaIndices.end() )
+                {
+                    if( overrideExisting )
+                    {
+                        metas[ existing->second ] = std::move( v );
+                    }
+                }
+                else
+                {
+                    metaIndices.emplace( v.textureName, uint32_t( metas.size() ) );
+                    metas.push_back( std::move( v ) );
                 }
             }
 
@@ -124,8 +303,8 @@ void RTGL1::TextureMetaManager::RereadFromFiles( std::filesystem::path sceneFile
         }
     };
 
-    reread( sourceGlobal, dataGlobal );
-    reread( sourceScene, dataScene );
+    reread( sourceGlobal, false );
+    reread( sourceScene, true );
 }
 
 bool RTGL1::TextureMetaManager::Modify(
@@ -134,7 +313,11 @@ bool RTGL1::TextureMetaManager::Modify(
     std::optional< RgMeshPrimitivePBREXT >&           refPbr,
     bool                                              isStatic ) const
 {
-    if( auto meta = Access( prim.pTextureName ) )
+    RG_CPU_ZONE( "TextureMetaManager::Modify" );
+
+    auto handleExt = pnext::find< RgMeshPrimitiveNameHandleEXT >( &prim );
+
+    if( auto meta = Access( prim.pTextureName, handleExt ? handleExt->textureName : 0 ) )
     {
         if( meta->forceGenerateNormals )
         {
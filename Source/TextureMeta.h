@@ -24,7 +24,9 @@
 #include "Containers.h"
 #include "IFileDependency.h"
 #include "JsonParser.h"
+#include "NameRegistry.h"
 
+#include <array>
 #include <string>
 
 namespace RTGL1
@@ -46,7 +48,13 @@ public:
                  std::optional< RgMeshPrimitivePBREXT >&           refPbr,
                  bool                                              isStatic ) const;
 
-    std::optional< TextureMeta > Access( const char* pTextureName ) const;
+    // Null, if there's no meta for the texture. Valid until the next reread
+    const TextureMeta* Access( const char* pTextureName ) const;
+    // Same, but the lookup by name is done once per handle
+    const TextureMeta* Access( const char* pTextureName, RgNameHandle textureHandle ) const;
+
+    // Files that the result of Modify / Access depends on
+    auto SourceFiles() const { return std::array{ sourceGlobal, sourceScene }; }
 
     void RereadFromFiles( std::string_view currentSceneName );
     void OnFileChanged( FileType type, const std::filesystem::path& filepath ) override;
@@ -60,8 +68,12 @@ private:
     std::filesystem::path sourceGlobal;
     std::filesystem::path sourceScene;
 
-    rgl::string_map< TextureMeta > dataGlobal;
-    rgl::string_map< TextureMeta > dataScene;
+    // scene entries override global ones, so a texture name is looked up only once
+    std::vector< TextureMeta >  metas;
+    rgl::string_map< uint32_t > metaIndices;
+
+    // index in 'metas', or UINT32_MAX if none
+    mutable NameHandleCache< uint32_t > handleToMeta;
 };
 
 }
\ No newline at end of file
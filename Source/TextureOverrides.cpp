@@ -61,6 +61,13 @@ namespace loader
 {
     namespace detail
     {
+        bool MayExist( TextureFileIndex*            fileIndex,
+                       const std::filesystem::path& folder,
+                       const std::filesystem::path& filepath )
+        {
+            return !fileIndex || fileIndex->MayExist( folder, filepath );
+        }
+
         template< typename T >
         auto LoadByFullPath( T& specificLoader, const std::filesystem::path& filepath )
         {
@@ -81,6 +88,7 @@ namespace loader
                           const std::filesystem::path&,
                           std::string_view,
                           std::string_view,
+                          TextureFileIndex*,
                           std::filesystem::path& outPath )
         {
             assert( outPath.empty() );
@@ -93,6 +101,7 @@ namespace loader
                           const std::filesystem::path& ovrdFolder,
                           std::string_view             name,
                           std::string_view             postfix,
+                          TextureFileIndex*            fileIndex,
                           std::filesystem::path&       outPath )
         {
             if( auto l = std::get< I >( loaders ) )
@@ -106,6 +115,11 @@ namespace loader
                     auto filepath =
                         TextureOverrides::GetTexturePath( basePath, name, postfix, ext );
 
+                    if( !MayExist( fileIndex, basePath, filepath ) )
+                    {
+                        continue;
+                    }
+
                     if( auto r = LoadByFullPath( *l, filepath ) )
                     {
                         outPath = std::move( filepath );
@@ -114,7 +128,48 @@ namespace loader
                 }
             }
 
-            return LoadByIndex< I + 1 >( loaders, ovrdFolder, name, postfix, outPath );
+            return LoadByIndex< I + 1 >( loaders, ovrdFolder, name, postfix, fileIndex, outPath );
+        }
+
+        template< size_t I, typename Loaders >
+            requires( I >= std::tuple_size_v< Loaders > )
+        auto FindByIndex( const Loaders&,
+                          const std::filesystem::path&,
+                          std::string_view,
+                          std::string_view,
+                          TextureFileIndex* )
+        {
+            return std::filesystem::path{};
+        }
+
+        template< size_t I, typename Loaders >
+            requires( I < std::tuple_size_v< Loaders > )
+        auto FindByIndex( const Loaders&               loaders,
+                          const std::filesystem::path& ovrdFolder,
+                          std::string_view             name,
+                          std::string_view             postfix,
+                          TextureFileIndex*            fileIndex )
+        {
+            if( std::get< I >( loaders ) )
+            {
+                using LoaderType = std::remove_pointer_t< std::tuple_element_t< I, Loaders > >;
+
+                auto basePath = ovrdFolder / LoaderType::GetFolder();
+
+                for( const char* ext : LoaderType::GetExtensions() )
+                {
+                    auto filepath =
+                        TextureOverrides::GetTexturePath( basePath, name, postfix, ext );
+
+                    if( MayExist( fileIndex, basePath, filepath ) &&
+                        std::filesystem::is_regular_file( filepath ) )
+                    {
+                        return filepath;
+                    }
+                }
+            }
+
+            return FindByIndex< I + 1 >( loaders, ovrdFolder, name, postfix, fileIndex );
         }
 
         template< size_t I, typename Loaders >
@@ -145,9 +200,10 @@ namespace loader
                const std::filesystem::path& ovrdFolder,
                std::string_view             name,
                std::string_view             postfix,
+               TextureFileIndex*            fileIndex,
                std::filesystem::path&       outPath )
     {
-        return detail::LoadByIndex< 0 >( loaders, ovrdFolder, name, postfix, outPath );
+        return detail::LoadByIndex< 0 >( loaders, ovrdFolder, name, postfix, fileIndex, outPath );
     }
 
     template< typename Loaders >
@@ -156,6 +212,16 @@ namespace loader
         return detail::LoadByFullPathByIndex< 0 >( loaders, fullpath );
     }
 
+    template< typename Loaders >
+    auto Find( const Loaders&               loaders,
+               const std::filesystem::path& ovrdFolder,
+               std::string_view             name,
+               std::string_view             postfix,
+               TextureFileIndex*            fileIndex )
+    {
+        return detail::FindByIndex< 0 >( loaders, ovrdFolder, name, postfix, fileIndex );
+    }
+
     template< typename Loaders >
     void FreeLoaded( Loaders& loaders )
     {
@@ -183,7 +249,8 @@ TextureOverrides::TextureOverrides( const std::filesystem::path& _ovrdFolder,
                                     const void*                  _defaultPixels,
                                     const RgExtent2D&            _defaultSize,
                                     VkFormat                     _defaultFormat,
-                                    Loader                       _loader )
+                                    Loader                       _loader,
+                                    TextureFileIndex*            _fileIndex )
     : result{ std::nullopt }, debugname{}, iloader( std::move( _loader ) )
 {
     Utils::SafeCstrCopy( debugname, _name );
@@ -191,7 +258,7 @@ TextureOverrides::TextureOverrides( const std::filesystem::path& _ovrdFolder,
     
     std::visit(
         [ & ]( auto&& specific ) {
-            if( auto r = loader::Load( specific, _ovrdFolder, _name, _postfix, path ) )
+            if( auto r = loader::Load( specific, _ovrdFolder, _name, _postfix, _fileIndex, path ) )
             {
                 r->format = Utils::IsSRGB( _defaultFormat ) ? Utils::ToSRGB( r->format )
                                                             : Utils::ToUnorm( r->format );
@@ -285,3 +352,16 @@ std::filesystem::path TextureOverrides::GetTexturePath( std::filesystem::path ba
 
     return basePath.append( validName ).make_preferred().concat( postfix ).concat( extension );
 }
+
+std::filesystem::path TextureOverrides::FindTexturePath( const std::filesystem::path& ovrdFolder,
+                                                         std::string_view             name,
+                                                         std::string_view             postfix,
+                                                         const Loader&                loader,
+                                                         TextureFileIndex*            fileIndex )
+{
+    return std::visit(
+        [ & ]( auto&& specific ) {
+            return loader::Find( specific, ovrdFolder, name, postfix, fileIndex );
+        },
+        loader );
+}
@@ -25,6 +25,7 @@
 #include "Common.h"
 #include "ImageLoader.h"
 #include "ImageLoaderDev.h"
+#include "TextureFileIndex.h"
 
 namespace RTGL1
 {
@@ -40,13 +41,15 @@ struct TextureOverrides
                                  std::tuple< ImageLoaderDev*, ImageLoader* > >;
 
 
+    // If 'fileIndex' is not null, only the candidate paths that are in it are probed
     explicit TextureOverrides( const std::filesystem::path& ovrdFolder,
                                std::string_view             name,
                                std::string_view             postfix,
                                const void*                  defaultPixels,
                                const RgExtent2D&            defaultSize,
                                VkFormat                     defaultFormat,
-                               Loader                       loader );
+                               Loader                       loader,
+                               TextureFileIndex*            fileIndex );
 
     explicit TextureOverrides( const std::filesystem::path& fullPath, bool isSRGB, Loader loader );
 
@@ -62,6 +65,13 @@ struct TextureOverrides
                                                  std::string_view      postfix,
                                                  std::string_view      extension );
 
+    // Empty, if there is no file that would be loaded by the first constructor
+    static std::filesystem::path FindTexturePath( const std::filesystem::path& ovrdFolder,
+                                                  std::string_view             name,
+                                                  std::string_view             postfix,
+                                                  const Loader&                loader,
+                                                  TextureFileIndex*            fileIndex );
+
     std::optional< ImageLoader::ResultInfo > result;
     char                                     debugname[ TEXTURE_DEBUG_NAME_MAX_LENGTH ];
     std::filesystem::path                    path;
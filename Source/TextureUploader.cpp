@@ -24,8 +24,15 @@
 #include <cmath>
 
 #include "Const.h"
+#include "HitchRecorder.h"
+#include "ImageLoader.h"
 #include "Utils.h"
 
+namespace RTGL1
+{
+extern bool g_supportsMemoryDecompression;
+}
+
 namespace
 {
 
@@ -302,16 +309,94 @@ auto GetFormatsWithBlitSupport( VkPhysicalDevice physDevice ) -> rgl::unordered_
 
 using namespace RTGL1;
 
-TextureUploader::TextureUploader( VkDevice                           _device,
-                                  std::shared_ptr< MemoryAllocator > _memAllocator )
+namespace
+{
+// bufferOffset of a copy must be a multiple of the texel block size (up to 32 bytes,
+// incl. 3-component formats) and 4; 256 is a common optimalBufferCopyOffsetAlignment
+constexpr VkDeviceSize StagingRingAlignment = 768;
+// srcAddress of a decompression region must be 4-byte aligned
+constexpr VkDeviceSize GDeflateStreamAlignment = 4;
+}
+
+TextureUploader::TextureUploader( VkDevice                                _device,
+                                  std::shared_ptr< MemoryAllocator >      _memAllocator,
+                                  std::shared_ptr< CommandBufferManager > _cmdManager,
+                                  uint64_t                                _stagingRingSize )
     : device( _device )
     , memAllocator{ std::move( _memAllocator ) }
     , supportBlit{ GetFormatsWithBlitSupport( memAllocator->GetPhysicalDevice() ) }
+    , cmdManager{ std::move( _cmdManager ) }
 {
+    // without a separate family, there's no benefit over the graphics queue
+    if( cmdManager && !cmdManager->HasDedicatedTransfer() )
+    {
+        cmdManager.reset();
+    }
+
+    if( cmdManager )
+    {
+        auto timelineInfo = VkSemaphoreTypeCreateInfo{
+            .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+            .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+            .initialValue  = 0,
+        };
+        auto semaphoreInfo = VkSemaphoreCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+            .pNext = &timelineInfo,
+        };
+
+        VkResult r = vkCreateSemaphore( device, &semaphoreInfo, nullptr, &transferTimeline );
+        VK_CHECKERROR( r );
+        SET_DEBUG_NAME(
+            device, transferTimeline, VK_OBJECT_TYPE_SEMAPHORE, "Texture transfer timeline" );
+    }
+
+    // allocated from the staging pool, so can't be larger than its block
+    const auto ringSize =
+        std::min< VkDeviceSize >( _stagingRingSize, ALLOCATOR_BLOCK_SIZE_STAGING_TEXTURES );
+
+    if( ringSize > 0 )
+    {
+        // only for the frame indices in use
+        for( StagingRing& ring : std::span( stagingRing, FramesInFlight() ) )
+        {
+            VkBufferCreateInfo ringInfo = {
+                .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                .size  = ringSize,
+                // GDeflate pages are read by address
+                .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                         ( g_supportsMemoryDecompression
+                               ? VkBufferUsageFlags( VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT )
+                               : 0 ),
+            };
+
+            void* mapped = nullptr;
+            ring.buffer  = memAllocator->CreateStagingSrcTextureBuffer(
+                &ringInfo, "Texture staging ring", &mapped );
+            if( ring.buffer == VK_NULL_HANDLE )
+            {
+                debug::Warning( "Failed to allocate texture staging ring of {} bytes",
+                                uint64_t( ringSize ) );
+                continue;
+            }
+            SET_DEBUG_NAME(
+                device, ring.buffer, VK_OBJECT_TYPE_BUFFER, "Texture staging ring" );
+
+            ring.mapped = static_cast< uint8_t* >( mapped );
+            ring.size   = ringSize;
+            ring.offset = 0;
+        }
+    }
 }
 
 TextureUploader::~TextureUploader()
 {
+    assert( transferCmd == VK_NULL_HANDLE );
+    if( transferTimeline != VK_NULL_HANDLE )
+    {
+        vkDestroySemaphore( device, transferTimeline, nullptr );
+    }
+
     for( uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++ )
     {
         ClearStaging( i );
@@ -321,6 +406,14 @@ TextureUploader::~TextureUploader()
     {
         memAllocator->DestroyStagingSrcTextureBuffer( p.second.stagingBuffer );
     }
+
+    for( const StagingRing& ring : stagingRing )
+    {
+        if( ring.buffer != VK_NULL_HANDLE )
+        {
+            memAllocator->DestroyStagingSrcTextureBuffer( ring.buffer );
+        }
+    }
 }
 
 void TextureUploader::ClearStaging( uint32_t frameIndex )
@@ -332,6 +425,164 @@ void TextureUploader::ClearStaging( uint32_t frameIndex )
     }
 
     stagingToFree[ frameIndex ].clear();
+    decompressedToFree[ frameIndex ].clear();
+
+    stagingRing[ frameIndex ].offset = 0;
+
+    if( mipmapGenerator )
+    {
+        mipmapGenerator->PrepareForFrame( frameIndex );
+    }
+}
+
+void TextureUploader::SetMipmapGenerator( std::shared_ptr< MipmapGenerator > generator )
+{
+    mipmapGenerator = std::move( generator );
+}
+
+std::optional< VkDeviceSize > TextureUploader::AllocFromStagingRing( uint32_t     frameIndex,
+                                                                     VkDeviceSize size )
+{
+    StagingRing& ring = stagingRing[ frameIndex ];
+
+    if( ring.buffer == VK_NULL_HANDLE )
+    {
+        return std::nullopt;
+    }
+
+    VkDeviceSize offset = Utils::Align( ring.offset, StagingRingAlignment );
+    if( offset + size > ring.size )
+    {
+        return std::nullopt;
+    }
+
+    ring.offset = offset + size;
+    return offset;
+}
+
+void TextureUploader::BeginTransferUploads()
+{
+    assert( transferCmd == VK_NULL_HANDLE );
+    transferUploadsAllowed = cmdManager != nullptr;
+}
+
+void TextureUploader::SubmitTransferUploads()
+{
+    transferUploadsAllowed = false;
+
+    if( transferCmd == VK_NULL_HANDLE )
+    {
+        return;
+    }
+
+    transferTimelineValue++;
+    cmdManager->Submit_Timeline( transferCmd,
+                                 VK_NULL_HANDLE,
+                                 ToWait{},
+                                 ToSignal{ transferTimeline, transferTimelineValue } );
+    transferCmd = VK_NULL_HANDLE;
+
+    // only the shaders that sample textures wait,
+    // the graphics queue doesn't stall in frames without new uploads
+    cmdManager->WaitSemaphoreOnGraphics( transferTimeline,
+                                         transferTimelineValue,
+                                         VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR |
+                                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT );
+}
+
+bool TextureUploader::CanUploadOnTransferQueue( const UploadInfo& info ) const
+{
+    // GDeflate is inflated on the graphics queue, so the result is not transferred between queues
+    if( !transferUploadsAllowed || info.isUpdateable || info.pLevelPageSizes )
+    {
+        return false;
+    }
+
+    // transfer queue can't blit, so mipmaps can't be generated on it
+    return AreMipmapsPregenerated( info ) || GetMipmapCount( info.baseSize, info ) == 1;
+}
+
+void TextureUploader::PrepareImageOnTransferQueue( VkImage           image,
+                                                   VkBuffer          staging,
+                                                   VkDeviceSize      stagingOffset,
+                                                   const UploadInfo& info )
+{
+    assert( cmdManager );
+
+    if( transferCmd == VK_NULL_HANDLE )
+    {
+        transferCmd = cmdManager->StartTransferCmd();
+    }
+
+    const uint32_t layerCount = info.isCubemap ? 6 : 1;
+
+    const auto allMipmaps = VkImageSubresourceRange{
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel   = 0,
+        .levelCount     = GetMipmapCount( info.baseSize, info ),
+        .baseArrayLayer = 0,
+        .layerCount     = layerCount,
+    };
+
+    Utils::BarrierImage( transferCmd,
+                         image,
+                         0,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_IMAGE_LAYOUT_UNDEFINED,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         allMipmaps );
+
+    for( uint32_t layer = 0; layer < layerCount; layer++ )
+    {
+        VkDeviceSize layerOffset = stagingOffset + layer * VkDeviceSize( info.dataSize );
+
+        if( AreMipmapsPregenerated( info ) )
+        {
+            CopyStagingToImageMipmaps( transferCmd, staging, layerOffset, image, layer, info );
+        }
+        else
+        {
+            CopyStagingToImage(
+                transferCmd, staging, layerOffset, image, info.baseSize, layer, 1 );
+        }
+    }
+
+    // release on the transfer queue and acquire on the graphics queue
+    // must specify the same layout transition
+    auto ownership = VkImageMemoryBarrier{
+        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask       = 0,
+        .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout           = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .srcQueueFamilyIndex = cmdManager->GetTransferFamily(),
+        .dstQueueFamilyIndex = cmdManager->GetGraphicsFamily(),
+        .image               = image,
+        .subresourceRange    = allMipmaps,
+    };
+
+    vkCmdPipelineBarrier( transferCmd,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                          0,
+                          0,
+                          nullptr,
+                          0,
+                          nullptr,
+                          1,
+                          &ownership );
+
+    // chained with the semaphore wait in SubmitTransferUploads
+    constexpr VkPipelineStageFlags consumers =
+        VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+    ownership.srcAccessMask = 0;
+    ownership.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(
+        info.cmd, consumers, consumers, 0, 0, nullptr, 0, nullptr, 1, &ownership );
 }
 
 bool TextureUploader::DoesFormatSupportBlit( VkFormat format ) const
@@ -362,6 +613,23 @@ uint32_t TextureUploader::GetMipmapCount( const RgExtent2D& size, const UploadIn
     return std::min( widthCount, heightCount ) + 1;
 }
 
+bool TextureUploader::UseComputeMipmaps( const UploadInfo& info ) const
+{
+    if( !mipmapGenerator || AreMipmapsPregenerated( info ) )
+    {
+        return false;
+    }
+
+    // updateable images regenerate with blits in UpdateImage
+    if( info.isCubemap || info.isUpdateable )
+    {
+        return false;
+    }
+
+    return GetMipmapCount( info.baseSize, info ) > 1 &&
+           mipmapGenerator->IsSupported( info.format, info.baseSize );
+}
+
 void TextureUploader::PrepareMipmaps( VkCommandBuffer cmd,
                                       VkImage         image,
                                       uint32_t        baseWidth,
@@ -447,13 +715,14 @@ void TextureUploader::PrepareMipmaps( VkCommandBuffer cmd,
 
 void TextureUploader::CopyStagingToImage( VkCommandBuffer   cmd,
                                           VkBuffer          staging,
+                                          VkDeviceSize      stagingOffset,
                                           VkImage           image,
                                           const RgExtent2D& size,
                                           uint32_t          baseLayer,
                                           uint32_t          layerCount )
 {
     VkBufferImageCopy copyRegion = {};
-    copyRegion.bufferOffset      = 0;
+    copyRegion.bufferOffset      = stagingOffset;
     // tigthly packed
     copyRegion.bufferRowLength                 = 0;
     copyRegion.bufferImageHeight               = 0;
@@ -470,6 +739,7 @@ void TextureUploader::CopyStagingToImage( VkCommandBuffer   cmd,
 
 void TextureUploader::CopyStagingToImageMipmaps( VkCommandBuffer   cmd,
                                                  VkBuffer          staging,
+                                                 VkDeviceSize      stagingOffset,
                                                  VkImage           image,
                                                  uint32_t          layerIndex,
                                                  const UploadInfo& info )
@@ -486,7 +756,7 @@ void TextureUploader::CopyStagingToImageMipmaps( VkCommandBuffer   cmd,
         auto& cr = copyRegions[ mipLevel ];
 
         cr                                 = {};
-        cr.bufferOffset                    = info.pLevelDataOffsets[ mipLevel ];
+        cr.bufferOffset                    = stagingOffset + info.pLevelDataOffsets[ mipLevel ];
         cr.bufferRowLength                 = 0;
         cr.bufferImageHeight               = 0;
         cr.imageExtent                     = { mipWidth, mipHeight, 1 };
@@ -504,6 +774,126 @@ void TextureUploader::CopyStagingToImageMipmaps( VkCommandBuffer   cmd,
         cmd, staging, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levelCount, copyRegions );
 }
 
+auto TextureUploader::GetGDeflateStagingSize( const UploadInfo& info ) const -> VkDeviceSize
+{
+    VkDeviceSize size = 0;
+
+    for( uint32_t level = 0; level < GetMipmapCount( info.baseSize, info ); level++ )
+    {
+        const size_t pageCount =
+            ImageLoader::GDeflatePageCount( info.pLevelDecompressedSizes[ level ] );
+
+        for( size_t p = 0; p < pageCount; p++ )
+        {
+            size += Utils::Align( VkDeviceSize{ info.pLevelPageSizes[ level ][ p ] },
+                                  GDeflateStreamAlignment );
+        }
+    }
+
+    return size;
+}
+
+void TextureUploader::PrepareImageFromGDeflate( VkImage           image,
+                                                VkBuffer          staging,
+                                                VkDeviceSize      stagingOffset,
+                                                uint8_t*          pMapped,
+                                                const UploadInfo& info )
+{
+    assert( g_supportsMemoryDecompression );
+    assert( info.pLevelPageSizes && info.pLevelDecompressedSizes );
+
+    const uint32_t levelCount = GetMipmapCount( info.baseSize, info );
+
+    // inflated levels are copied to the image, so they are aligned as in the staging ring
+    size_t       inflatedOffsets[ MAX_PREGENERATED_MIPMAP_LEVELS ] = {};
+    VkDeviceSize inflatedSize                                      = 0;
+    for( uint32_t level = 0; level < levelCount; level++ )
+    {
+        inflatedSize             = Utils::Align( inflatedSize, StagingRingAlignment );
+        inflatedOffsets[ level ] = size_t( inflatedSize );
+        inflatedSize += info.pLevelDecompressedSizes[ level ];
+    }
+
+    auto inflated = std::make_unique< Buffer >();
+    inflated->Init( *memAllocator,
+                    inflatedSize,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    info.pDebugName );
+
+    auto addrInfo = VkBufferDeviceAddressInfo{
+        .sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+        .buffer = staging,
+    };
+    const VkDeviceAddress stagingAddress = vkGetBufferDeviceAddress( device, &addrInfo );
+
+    const auto* src = static_cast< const uint8_t* >( info.pData );
+
+    auto         regions     = std::vector< VkDecompressMemoryRegionNV >{};
+    VkDeviceSize stagingUsed = 0;
+
+    for( uint32_t level = 0; level < levelCount; level++ )
+    {
+        const uint32_t* pageSizes = info.pLevelPageSizes[ level ];
+        size_t          srcOffset = info.pLevelDataOffsets[ level ];
+        size_t          remaining = info.pLevelDecompressedSizes[ level ];
+
+        for( size_t p = 0; remaining > 0; p++ )
+        {
+            const size_t pageSize = std::min( remaining, ImageLoader::GDeflatePageSize );
+
+            memcpy( pMapped + stagingUsed, src + srcOffset, pageSizes[ p ] );
+
+            regions.push_back( VkDecompressMemoryRegionNV{
+                .srcAddress = stagingAddress + stagingOffset + stagingUsed,
+                .dstAddress = inflated->GetAddress() + inflatedOffsets[ level ] +
+                              p * ImageLoader::GDeflatePageSize,
+                .compressedSize      = pageSizes[ p ],
+                .decompressedSize    = pageSize,
+                .decompressionMethod = VK_MEMORY_DECOMPRESSION_METHOD_GDEFLATE_1_0_BIT_NV,
+            } );
+
+            srcOffset += pageSizes[ p ];
+            stagingUsed += Utils::Align( VkDeviceSize{ pageSizes[ p ] }, GDeflateStreamAlignment );
+            remaining -= pageSize;
+        }
+    }
+
+    svkCmdDecompressMemoryNV( info.cmd, uint32_t( regions.size() ), regions.data() );
+
+    // the extension doesn't define a pipeline stage for the decompression
+    auto written = VkBufferMemoryBarrier{
+        .sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask       = VK_ACCESS_MEMORY_WRITE_BIT,
+        .dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer              = inflated->GetBuffer(),
+        .offset              = 0,
+        .size                = VK_WHOLE_SIZE,
+    };
+    vkCmdPipelineBarrier( info.cmd,
+                          VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          0,
+                          0,
+                          nullptr,
+                          1,
+                          &written,
+                          0,
+                          nullptr );
+
+    UploadInfo inflatedInfo              = info;
+    inflatedInfo.pLevelDataOffsets       = inflatedOffsets;
+    inflatedInfo.pLevelDataSizes         = info.pLevelDecompressedSizes;
+    inflatedInfo.pLevelPageSizes         = nullptr;
+    inflatedInfo.pLevelDecompressedSizes = nullptr;
+
+    VkBuffer inflatedBuffer = inflated->GetBuffer();
+    PrepareImage( image, &inflatedBuffer, inflatedInfo, ImagePrepareType::INIT );
+
+    decompressedToFree[ info.frameIndex ].push_back( std::move( inflated ) );
+}
 
 bool TextureUploader::CreateImage( const UploadInfo& info, VkImage* result )
 {
@@ -524,6 +914,18 @@ bool TextureUploader::CreateImage( const UploadInfo& info, VkImage* result )
     imageInfo.usage             = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
                       VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
 
+    if( UseComputeMipmaps( info ) )
+    {
+        imageInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+
+        // e.g. sRGB can't be a storage image, so levels are written through a UNORM view
+        if( MipmapGenerator::GetStorageFormat( info.format ) != info.format )
+        {
+            imageInfo.flags |=
+                VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT | VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+        }
+    }
+
     VkImage image = memAllocator->CreateDstTextureImage( &imageInfo, info.pDebugName );
     if( image == VK_NULL_HANDLE )
     {
@@ -539,7 +941,9 @@ bool TextureUploader::CreateImage( const UploadInfo& info, VkImage* result )
 void TextureUploader::PrepareImage( VkImage           image,
                                     VkBuffer          staging[],
                                     const UploadInfo& info,
-                                    ImagePrepareType  prepareType )
+                                    ImagePrepareType  prepareType,
+                                    VkDeviceSize      stagingOffset,
+                                    VkDeviceSize      stagingLayerStride )
 {
     VkCommandBuffer   cmd         = info.cmd;
     const RgExtent2D& size        = info.baseSize;
@@ -589,10 +993,6 @@ void TextureUploader::PrepareImage( VkImage           image,
         {
             // copy all mip levels from memory
 
-            assert( layerCount == 1 );
-
-            const uint32_t layerIndex = 0;
-
             // set layout for copying
             Utils::BarrierImage( cmd,
                                  image,
@@ -609,7 +1009,15 @@ void TextureUploader::PrepareImage( VkImage           image,
             curLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
             curStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
-            CopyStagingToImageMipmaps( cmd, staging[ layerIndex ], image, layerIndex, info );
+            for( uint32_t layer = 0; layer < layerCount; layer++ )
+            {
+                CopyStagingToImageMipmaps( cmd,
+                                           staging[ layer ],
+                                           stagingOffset + layer * stagingLayerStride,
+                                           image,
+                                           layer,
+                                           info );
+            }
         }
         else
         {
@@ -634,7 +1042,13 @@ void TextureUploader::PrepareImage( VkImage           image,
                 curStageMask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
                 // copy only first mipmap
-                CopyStagingToImage( cmd, staging[ layer ], image, size, layer, 1 );
+                CopyStagingToImage( cmd,
+                                    staging[ layer ],
+                                    stagingOffset + layer * stagingLayerStride,
+                                    image,
+                                    size,
+                                    layer,
+                                    1 );
             }
         }
     }
@@ -645,7 +1059,19 @@ void TextureUploader::PrepareImage( VkImage           image,
         {
             // 3A. 1. Generate mipmaps
 
-            if( DoesFormatSupportBlit( info.format ) )
+            if( UseComputeMipmaps( info ) && curLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL )
+            {
+                // all levels in one dispatch, and they are left in SHADER_READ_ONLY
+                mipmapGenerator->Generate( cmd,
+                                           info.frameIndex,
+                                           image,
+                                           info.format,
+                                           size,
+                                           mipmapCount,
+                                           info.isNormalMap );
+                return;
+            }
+            else if( DoesFormatSupportBlit( info.format ) )
             {
                 // first mipmap to TRANSFER_SRC to create mipmaps using blit
                 Utils::BarrierImage( cmd,
@@ -784,8 +1210,15 @@ VkImageView TextureUploader::CreateImageView( VkImage
     }
 
 
+    // image may have a storage usage that its format doesn't support
+    VkImageViewUsageCreateInfo usageInfo = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO,
+        .usage = VK_IMAGE_USAGE_SAMPLED_BIT,
+    };
+
     VkImageViewCreateInfo viewInfo = {
         .sType      = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .pNext      = &usageInfo,
         .image      = image,
         .viewType   = isCubemap ? VK_IMAGE_VIEW_TYPE_CUBE : VK_IMAGE_VIEW_TYPE_2D,
         .format     = format,
@@ -808,12 +1241,25 @@ VkImageView TextureUploader::CreateImageView( VkImage
 
 TextureUploader::UploadResult TextureUploader::UploadImage( const UploadInfo& info )
 {
+    RG_HITCH_MARKER( "Texture creation" );
+
     // cubemaps are processed in other class
     assert( !info.isCubemap );
 
 
+    const bool isGDeflate = info.pLevelPageSizes != nullptr;
+
+    // updateable images keep the staging data to copy it again
+    if( isGDeflate && ( info.isUpdateable || !g_supportsMemoryDecompression ) )
+    {
+        debug::Warning( "GDeflate texture can't be uploaded: {}",
+                        Utils::IsCstrEmpty( info.pDebugName ) ? "<unnamed>" : info.pDebugName );
+        return {};
+    }
+
+
     const void*       data     = info.pData;
-    VkDeviceSize      dataSize = info.dataSize;
+    VkDeviceSize      dataSize = isGDeflate ? GetGDeflateStagingSize( info ) : info.dataSize;
     const RgExtent2D& size     = info.baseSize;
 
 
@@ -824,33 +1270,51 @@ TextureUploader::UploadResult TextureUploader::UploadImage( const UploadInfo& in
     }
 
 
-    VkResult r;
-    void*    mappedData;
-    VkImage  image;
+    void*        mappedData    = nullptr;
+    VkBuffer     stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceSize stagingOffset = 0;
+    VkImage      image;
 
 
     // 1. Allocate and fill buffer
 
-    VkBufferCreateInfo stagingInfo = {
-        .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-        .size  = dataSize,
-        .usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-    };
+    // updateable images keep their staging buffer, so they can't use the ring
+    std::optional< VkDeviceSize > inRing =
+        info.isUpdateable ? std::nullopt : AllocFromStagingRing( info.frameIndex, dataSize );
 
-    VkBuffer stagingBuffer =
-        memAllocator->CreateStagingSrcTextureBuffer( &stagingInfo, info.pDebugName, &mappedData );
-    if( stagingBuffer == VK_NULL_HANDLE )
+    if( inRing )
     {
-        return {};
+        mappedData    = stagingRing[ info.frameIndex ].mapped + *inRing;
+        stagingBuffer = stagingRing[ info.frameIndex ].buffer;
+        stagingOffset = *inRing;
+    }
+    else
+    {
+        VkBufferCreateInfo stagingInfo = {
+            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size  = dataSize,
+            .usage = isGDeflate ? VkBufferUsageFlags( VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT )
+                                : VkBufferUsageFlags( VK_BUFFER_USAGE_TRANSFER_SRC_BIT ),
+        };
+
+        stagingBuffer = memAllocator->CreateStagingSrcTextureBuffer(
+            &stagingInfo, info.pDebugName, &mappedData );
+        if( stagingBuffer == VK_NULL_HANDLE )
+        {
+            return {};
+        }
+        SET_DEBUG_NAME( device, stagingBuffer, VK_OBJECT_TYPE_BUFFER, info.pDebugName );
     }
-    SET_DEBUG_NAME( device, stagingBuffer, VK_OBJECT_TYPE_BUFFER, info.pDebugName );
 
 
     bool wasCreated = CreateImage( info, &image );
     if( !wasCreated )
     {
         // clean created resources
-        memAllocator->DestroyStagingSrcTextureBuffer( stagingBuffer );
+        if( !inRing )
+        {
+            memAllocator->DestroyStagingSrcTextureBuffer( stagingBuffer );
+        }
         return {};
     }
 
@@ -861,13 +1325,25 @@ TextureUploader::UploadResult TextureUploader::UploadImage( const UploadInfo& in
         // create image without copying
         PrepareImage( image, VK_NULL_HANDLE, info, ImagePrepareType::INIT_WITHOUT_COPYING );
     }
+    else if( isGDeflate )
+    {
+        PrepareImageFromGDeflate(
+            image, stagingBuffer, stagingOffset, static_cast< uint8_t* >( mappedData ), info );
+    }
     else
     {
         // copy image data to buffer
         memcpy( mappedData, data, dataSize );
 
         // and copy it to image
-        PrepareImage( image, &stagingBuffer, info, ImagePrepareType::INIT );
+        if( CanUploadOnTransferQueue( info ) )
+        {
+            PrepareImageOnTransferQueue( image, stagingBuffer, stagingOffset, info );
+        }
+        else
+        {
+            PrepareImage( image, &stagingBuffer, info, ImagePrepareType::INIT, stagingOffset );
+        }
     }
 
 
@@ -891,7 +1367,7 @@ TextureUploader::UploadResult TextureUploader::UploadImage( const UploadInfo& in
             .format          = info.format,
         };
     }
-    else
+    else if( !inRing )
     {
         // for static images that won't be updated:
         // push staging buffer to be deleted when it won't be in use
@@ -931,6 +1407,98 @@ void TextureUploader::UpdateImage( VkCommandBuffer cmd, VkImage targetImage, con
     }
 }
 
+VkImageView TextureUploader::MoveImage( VkCommandBuffer                     cmd,
+                                        VkImage                             oldImage,
+                                        VkImage                             newImage,
+                                        const VkImageCreateInfo&            info,
+                                        std::optional< RgTextureSwizzling > swizzling )
+{
+    const VkImageSubresourceRange allMipmaps = {
+        .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel   = 0,
+        .levelCount     = info.mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount     = info.arrayLayers,
+    };
+
+    Utils::BarrierImage( cmd,
+                         oldImage,
+                         VK_ACCESS_SHADER_READ_BIT,
+                         VK_ACCESS_TRANSFER_READ_BIT,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         allMipmaps );
+    Utils::BarrierImage( cmd,
+                         newImage,
+                         0,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_IMAGE_LAYOUT_UNDEFINED,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         allMipmaps );
+
+    auto regions = std::vector< VkImageCopy >{};
+    regions.reserve( info.mipLevels );
+
+    for( uint32_t mip = 0; mip < info.mipLevels; mip++ )
+    {
+        const VkImageSubresourceLayers layers = {
+            .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+            .mipLevel       = mip,
+            .baseArrayLayer = 0,
+            .layerCount     = info.arrayLayers,
+        };
+
+        regions.push_back( VkImageCopy{
+            .srcSubresource = layers,
+            .srcOffset      = { 0, 0, 0 },
+            .dstSubresource = layers,
+            .dstOffset      = { 0, 0, 0 },
+            .extent         = { std::max( info.extent.width >> mip, 1u ),
+                                std::max( info.extent.height >> mip, 1u ),
+                                1 },
+        } );
+    }
+
+    vkCmdCopyImage( cmd,
+                    oldImage,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    newImage,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    uint32_t( regions.size() ),
+                    regions.data() );
+
+    Utils::BarrierImage( cmd,
+                         newImage,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_ACCESS_SHADER_READ_BIT,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         allMipmaps );
+
+    // staging buffer of an updateable image is reused for the new one
+    auto updateable = updateableImageInfos.find( oldImage );
+    if( updateable != updateableImageInfos.end() )
+    {
+        UpdateableImageInfo moved = updateable->second;
+        updateableImageInfos.erase( updateable );
+        updateableImageInfos.emplace( newImage, moved );
+    }
+
+    return CreateImageView( newImage,
+                            info.format,
+                            info.flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT,
+                            info.mipLevels,
+                            swizzling );
+}
+
 void TextureUploader::DestroyImage( VkImage image, VkImageView view )
 {
     auto it = updateableImageInfos.find( image );
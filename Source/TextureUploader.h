@@ -23,8 +23,11 @@
 #include <optional>
 #include <vector>
 
+#include "Buffer.h"
 #include "Common.h"
+#include "CommandBufferManager.h"
 #include "MemoryAllocator.h"
+#include "MipmapGenerator.h"
 #include "RTGL1/RTGL1.h"
 
 namespace RTGL1
@@ -59,14 +62,27 @@ public:
         uint32_t                            pregeneratedLevelCount;
         const size_t*                       pLevelDataOffsets;
         const size_t*                       pLevelDataSizes;
+        // if not null, each level is GDeflate-compressed by pages, see ImageLoader::ResultInfo,
+        // and it's inflated on device to pLevelDecompressedSizes bytes
+        const uint32_t* const*              pLevelPageSizes;
+        const size_t*                       pLevelDecompressedSizes;
         bool                                isUpdateable;
         const char*                         pDebugName;
         bool                                isCubemap;
         std::optional< RgTextureSwizzling > swizzling;
+        // to preserve the normal length in generated mipmaps
+        bool                                isNormalMap;
     };
 
 public:
-    TextureUploader( VkDevice device, std::shared_ptr< MemoryAllocator > memAllocator );
+    // If cmdManager is provided and there's a dedicated transfer queue,
+    // static images are copied on it between Begin/SubmitTransferUploads.
+    // If stagingRingSize is not 0, static images are sub-allocated from
+    // a persistent staging buffer per frame
+    TextureUploader( VkDevice                                device,
+                     std::shared_ptr< MemoryAllocator >      memAllocator,
+                     std::shared_ptr< CommandBufferManager > cmdManager      = nullptr,
+                     uint64_t                                stagingRingSize = 0 );
     virtual ~TextureUploader();
 
     TextureUploader( const TextureUploader& other )     = delete;
@@ -77,9 +93,26 @@ public:
     // Clear staging buffer for given frame index.
     void                 ClearStaging( uint32_t frameIndex );
 
+    // Must be called after CommandBufferManager::PrepareForFrame
+    void                 BeginTransferUploads();
+    // Must be called before the submission of the graphics command buffers
+    // that were passed to UploadImage, as they acquire the images' ownership
+    void                 SubmitTransferUploads();
+
+    // If set, mipmaps of the supported formats are generated by it instead of blits
+    void                 SetMipmapGenerator( std::shared_ptr< MipmapGenerator > generator );
+
     virtual UploadResult UploadImage( const UploadInfo& info );
     void                 UpdateImage( VkCommandBuffer cmd, VkImage targetImage, const void* data );
     void                 DestroyImage( VkImage image, VkImageView view );
+    // For an image that was moved by the memory defragmentation: record the copy of
+    // all its subresources to 'newImage', and create a view for it. Both images must
+    // be in SHADER_READ_ONLY_OPTIMAL; 'oldImage' is left in TRANSFER_SRC_OPTIMAL
+    VkImageView          MoveImage( VkCommandBuffer                     cmd,
+                                    VkImage                             oldImage,
+                                    VkImage                             newImage,
+                                    const VkImageCreateInfo&            info,
+                                    std::optional< RgTextureSwizzling > swizzling );
 
 protected:
     enum class ImagePrepareType
@@ -93,6 +126,7 @@ protected:
     bool        DoesFormatSupportBlit( VkFormat format ) const;
     bool        AreMipmapsPregenerated( const UploadInfo& info ) const;
     uint32_t    GetMipmapCount( const RgExtent2D& size, const UploadInfo& info ) const;
+    bool        UseComputeMipmaps( const UploadInfo& info ) const;
 
     // Generate mipmaps for VkImage. First mipmap's layout must be TRANSFER_SRC
     // and others must have UNDEFINED
@@ -106,28 +140,60 @@ protected:
     // Image must have TRANSFER_DST layout
     static void CopyStagingToImage( VkCommandBuffer   cmd,
                                     VkBuffer          staging,
+                                    VkDeviceSize      stagingOffset,
                                     VkImage           image,
                                     const RgExtent2D& size,
                                     uint32_t          baseLayer,
                                     uint32_t          layerCount );
     void        CopyStagingToImageMipmaps( VkCommandBuffer   cmd,
                                            VkBuffer          staging,
+                                           VkDeviceSize      stagingOffset,
                                            VkImage           image,
                                            uint32_t          layerIndex,
                                            const UploadInfo& info );
 
     bool        CreateImage( const UploadInfo& info, VkImage* result );
-    // Create mipmaps and prepare image for usage in shaders
+    // Create mipmaps and prepare image for usage in shaders.
+    // Layer i is read from staging[i] at (stagingOffset + i * stagingLayerStride)
     void        PrepareImage( VkImage           image,
                               VkBuffer          staging[],
                               const UploadInfo& info,
-                              ImagePrepareType  prepareType );
+                              ImagePrepareType  prepareType,
+                              VkDeviceSize      stagingOffset      = 0,
+                              VkDeviceSize      stagingLayerStride = 0 );
+    // Repack GDeflate pages of info.pData to 'pMapped' region of 'staging', inflate them
+    // into a temporary device-local buffer, and copy the result to the image levels
+    void        PrepareImageFromGDeflate( VkImage           image,
+                                          VkBuffer          staging,
+                                          VkDeviceSize      stagingOffset,
+                                          uint8_t*          pMapped,
+                                          const UploadInfo& info );
+    auto        GetGDeflateStagingSize( const UploadInfo& info ) const -> VkDeviceSize;
+    bool        CanUploadOnTransferQueue( const UploadInfo& info ) const;
+    // Copy on the transfer queue, and acquire the ownership in info.cmd.
+    // Cubemap faces must be laid out contiguously, each of info.dataSize bytes
+    void        PrepareImageOnTransferQueue( VkImage           image,
+                                             VkBuffer          staging,
+                                             VkDeviceSize      stagingOffset,
+                                             const UploadInfo& info );
     VkImageView CreateImageView( VkImage                             image,
                                  VkFormat                            format,
                                  bool                                isCubemap,
                                  uint32_t                            mipmapCount,
                                  std::optional< RgTextureSwizzling > swizzling );
 
+protected:
+    struct StagingRing
+    {
+        VkBuffer     buffer{ VK_NULL_HANDLE };
+        uint8_t*     mapped{ nullptr };
+        VkDeviceSize size{ 0 };
+        VkDeviceSize offset{ 0 };
+    };
+
+    // Returns an offset in stagingRing[frameIndex], or none if out of space
+    std::optional< VkDeviceSize > AllocFromStagingRing( uint32_t frameIndex, VkDeviceSize size );
+
 private:
     struct UpdateableImageInfo
     {
@@ -147,11 +213,23 @@ protected:
     // Staging buffers that were used for uploading must be destroyed
     // on the frame with same index when it'll be certainly not in use
     std::vector< VkBuffer >                            stagingToFree[ MAX_FRAMES_IN_FLIGHT ];
+    // Reset on the frame with same index, as staging buffers above
+    StagingRing                                        stagingRing[ MAX_FRAMES_IN_FLIGHT ];
+    // Destinations of the GPU decompression, destroyed as staging buffers above
+    std::vector< std::unique_ptr< Buffer > >           decompressedToFree[ MAX_FRAMES_IN_FLIGHT ];
 
     // Each dynamic image has its pointer to HOST_VISIBLE data for updating.
     rgl::unordered_map< VkImage, UpdateableImageInfo > updateableImageInfos;
 
     const rgl::unordered_set< VkFormat > supportBlit;
+
+    std::shared_ptr< MipmapGenerator > mipmapGenerator;
+
+    std::shared_ptr< CommandBufferManager > cmdManager;
+    VkSemaphore                             transferTimeline{ VK_NULL_HANDLE };
+    uint64_t                                transferTimelineValue{ 0 };
+    VkCommandBuffer                         transferCmd{ VK_NULL_HANDLE };
+    bool                                    transferUploadsAllowed{ false };
 };
 
 }
@@ -62,12 +62,16 @@ void RTGL1::Tonemapping::CalculateExposure( VkCommandBuffer cmd,
 {
     auto label = CmdLabel{ cmd, "Exposure" };
 
-    // sync access to histogram buffer
+    // histogram and work group counter must start from zero
+    if( !tmBufferCleared )
     {
+        vkCmdFillBuffer( cmd, tmBuffer.GetBuffer(), 0, VK_WHOLE_SIZE, 0 );
+        tmBufferCleared = true;
+
         VkBufferMemoryBarrier2 b = {
             .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
-            .srcStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
-            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .srcStageMask  = VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
             .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
             .dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT,
             .buffer        = tmBuffer.GetBuffer(),
@@ -84,33 +88,6 @@ void RTGL1::Tonemapping::CalculateExposure( VkCommandBuffer cmd,
         svkCmdPipelineBarrier2KHR( cmd, &dep );
     }
 
-    // sync access
-    framebuffers->BarrierOne( cmd, frameIndex, FramebufferImageIndex::FB_IMAGE_INDEX_PRE_FINAL );
-
-
-    // bind desc sets
-    VkDescriptorSet sets[]   = { framebuffers->GetDescSet( frameIndex ),
-                               uniform->GetDescSet( frameIndex ),
-                               tmDescSet };
-    const uint32_t  setCount = sizeof( sets ) / sizeof( VkDescriptorSet );
-
-    vkCmdBindDescriptorSets(
-        cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, setCount, sets, 0, nullptr );
-
-
-    // histogram
-
-    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, histogramPipeline );
-
-    // cover full render size
-    uint32_t wgCountX = Utils::GetWorkGroupCount( uniform->GetData()->renderWidth,
-                                                  COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_X );
-    uint32_t wgCountY = Utils::GetWorkGroupCount( uniform->GetData()->renderHeight,
-                                                  COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_Y );
-
-    vkCmdDispatch( cmd, wgCountX, wgCountY, 1 );
-
-
     // sync access to histogram buffer
     {
         VkBufferMemoryBarrier2 b = {
@@ -133,11 +110,34 @@ void RTGL1::Tonemapping::CalculateExposure( VkCommandBuffer cmd,
         svkCmdPipelineBarrier2KHR( cmd, &dep );
     }
 
+    // sync access
+    framebuffers->BarrierOne( cmd, frameIndex, FramebufferImageIndex::FB_IMAGE_INDEX_PRE_FINAL );
 
-    // calculate average luminance
-    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, avgLuminancePipeline );
-    // only one working group
-    vkCmdDispatch( cmd, 1, 1, 1 );
+
+    // bind desc sets
+    VkDescriptorSet sets[]   = { framebuffers->GetDescSet( frameIndex ),
+                               uniform->GetDescSet( frameIndex ),
+                               tmDescSet };
+    const uint32_t  setCount = sizeof( sets ) / sizeof( VkDescriptorSet );
+
+    vkCmdBindDescriptorSets(
+        cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, setCount, sets, 0, nullptr );
+
+
+    // histogram, and the average luminance is calculated by the last work group
+    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, histogramPipeline );
+
+    // cover full render size, an invocation processes a downsampled block
+    uint32_t wgCountX = Utils::GetWorkGroupCount(
+        Utils::GetWorkGroupCount( uniform->GetData()->renderWidth,
+                                  COMPUTE_LUM_HISTOGRAM_DOWNSAMPLE ),
+        COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_X );
+    uint32_t wgCountY = Utils::GetWorkGroupCount(
+        Utils::GetWorkGroupCount( uniform->GetData()->renderHeight,
+                                  COMPUTE_LUM_HISTOGRAM_DOWNSAMPLE ),
+        COMPUTE_LUM_HISTOGRAM_GROUP_SIZE_Y );
+
+    vkCmdDispatch( cmd, wgCountX, wgCountY, 1 );
 
 
     // sync access to histogram buffer to read in compute / raster
@@ -176,6 +176,11 @@ VkDescriptorSet RTGL1::Tonemapping::GetDescSet() const
 
 void RTGL1::Tonemapping::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { "CLuminanceHistogram" } ) )
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines( shaderManager );
 }
@@ -185,7 +190,7 @@ void RTGL1::Tonemapping::CreateTonemappingBuffer(
 {
     tmBuffer.Init( *allocator,
                    sizeof( ShTonemapping ),
-                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                    "Tonemapping buffer" );
 }
@@ -283,7 +288,7 @@ void RTGL1::Tonemapping::CreatePipelines( const ShaderManager* shaderManager )
         plInfo.stage = shaderManager->GetStageInfo( "CLuminanceHistogram" );
 
         r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &histogramPipeline );
+            device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &histogramPipeline );
         VK_CHECKERROR( r );
 
         SET_DEBUG_NAME( device,
@@ -291,26 +296,10 @@ void RTGL1::Tonemapping::CreatePipelines( const ShaderManager* shaderManager )
                         VK_OBJECT_TYPE_PIPELINE,
                         "Tonemapping LuminanceHistogram pipeline" );
     }
-
-    {
-        plInfo.stage = shaderManager->GetStageInfo( "CLuminanceAvg" );
-
-        r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &avgLuminancePipeline );
-        VK_CHECKERROR( r );
-
-        SET_DEBUG_NAME( device,
-                        avgLuminancePipeline,
-                        VK_OBJECT_TYPE_PIPELINE,
-                        "Tonemapping LuminanceAvg pipeline" );
-    }
 }
 
 void RTGL1::Tonemapping::DestroyPipelines()
 {
     vkDestroyPipeline( device, histogramPipeline, nullptr );
-    vkDestroyPipeline( device, avgLuminancePipeline, nullptr );
-
-    histogramPipeline    = VK_NULL_HANDLE;
-    avgLuminancePipeline = VK_NULL_HANDLE;
+    histogramPipeline = VK_NULL_HANDLE;
 }
\ No newline at end of file
@@ -68,6 +68,7 @@ private:
     std::shared_ptr< Framebuffers > framebuffers;
 
     Buffer                          tmBuffer;
+    bool                            tmBufferCleared = false;
     VkDescriptorSetLayout           tmDescSetLayout;
     VkDescriptorPool                tmDescPool;
     VkDescriptorSet                 tmDescSet;
@@ -75,7 +76,6 @@ private:
     VkPipelineLayout                pipelineLayout;
 
     VkPipeline                      histogramPipeline;
-    VkPipeline                      avgLuminancePipeline;
 };
 
 }
\ No newline at end of file
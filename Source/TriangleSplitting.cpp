@@ -0,0 +1,264 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "TriangleSplitting.h"
+
+#include "Const.h"
+#include "Containers.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+
+uint64_t MakeEdgeKey( uint32_t a, uint32_t b )
+{
+    return ( uint64_t( std::min( a, b ) ) << 32 ) | uint64_t( std::max( a, b ) );
+}
+
+RgPrimitiveVertex MakeMidpoint( const RgPrimitiveVertex& a, const RgPrimitiveVertex& b )
+{
+    const RgFloat3D na = RTGL1::Utils::UnpackNormal( a.normalPacked );
+    const RgFloat3D nb = RTGL1::Utils::UnpackNormal( b.normalPacked );
+
+    const auto ca = RTGL1::Utils::UnpackColor4DPacked32Components( a.color );
+    const auto cb = RTGL1::Utils::UnpackColor4DPacked32Components( b.color );
+
+    const auto avg = []( uint8_t x, uint8_t y ) { return uint8_t( ( x + y + 1 ) / 2 ); };
+
+    return RgPrimitiveVertex{
+        .position     = { ( a.position[ 0 ] + b.position[ 0 ] ) * 0.5f,
+                          ( a.position[ 1 ] + b.position[ 1 ] ) * 0.5f,
+                          ( a.position[ 2 ] + b.position[ 2 ] ) * 0.5f },
+        .normalPacked = RTGL1::Utils::PackNormal( na.data[ 0 ] + nb.data[ 0 ],
+                                                  na.data[ 1 ] + nb.data[ 1 ],
+                                                  na.data[ 2 ] + nb.data[ 2 ] ),
+        .texCoord     = { ( a.texCoord[ 0 ] + b.texCoord[ 0 ] ) * 0.5f,
+                          ( a.texCoord[ 1 ] + b.texCoord[ 1 ] ) * 0.5f },
+        .color        = RTGL1::Utils::PackColor( avg( ca[ 0 ], cb[ 0 ] ),
+                                                 avg( ca[ 1 ], cb[ 1 ] ),
+                                                 avg( ca[ 2 ], cb[ 2 ] ),
+                                                 avg( ca[ 3 ], cb[ 3 ] ) ),
+    };
+}
+
+float DistanceSq( const RgPrimitiveVertex& a, const RgPrimitiveVertex& b )
+{
+    const float d[] = {
+        a.position[ 0 ] - b.position[ 0 ],
+        a.position[ 1 ] - b.position[ 1 ],
+        a.position[ 2 ] - b.position[ 2 ],
+    };
+    return d[ 0 ] * d[ 0 ] + d[ 1 ] * d[ 1 ] + d[ 2 ] * d[ 2 ];
+}
+
+bool IsLongTriangle( const RgPrimitiveVertex& a,
+                     const RgPrimitiveVertex& b,
+                     const RgPrimitiveVertex& c )
+{
+    const RgFloat3D positions[] = {
+        { a.position[ 0 ], a.position[ 1 ], a.position[ 2 ] },
+        { b.position[ 0 ], b.position[ 1 ], b.position[ 2 ] },
+        { c.position[ 0 ], c.position[ 1 ], c.position[ 2 ] },
+    };
+
+    RgFloat3D normal;
+    float     area;
+    if( !RTGL1::Utils::GetNormalAndArea( positions, normal, area ) )
+    {
+        // degenerate, splitting won't help
+        return false;
+    }
+
+    float extent[ 3 ];
+    for( int i = 0; i < 3; i++ )
+    {
+        extent[ i ] = std::max( { a.position[ i ], b.position[ i ], c.position[ i ] } ) -
+                      std::min( { a.position[ i ], b.position[ i ], c.position[ i ] } );
+    }
+    const float aabbArea = 2.0f * ( extent[ 0 ] * extent[ 1 ] + extent[ 1 ] * extent[ 2 ] +
+                                    extent[ 2 ] * extent[ 0 ] );
+
+    return aabbArea > RTGL1::TRIANGLE_SPLIT_MIN_AABB_RATIO * area;
+}
+
+}
+
+auto RTGL1::SplitLongTriangles( std::span< const RgPrimitiveVertex > srcVertices,
+                                std::span< const uint32_t >          srcIndices )
+    -> std::optional< SplitTriangles >
+{
+    if( srcIndices.empty() || srcIndices.size() % 3 != 0 )
+    {
+        return std::nullopt;
+    }
+
+    auto vertices = std::vector< RgPrimitiveVertex >( srcVertices.begin(), srcVertices.end() );
+    auto indices  = std::vector< uint32_t >( srcIndices.begin(), srcIndices.end() );
+
+    // bound the growth of the vertex data
+    const size_t maxIndexCount = srcIndices.size() * 2;
+
+    bool anySplit = false;
+
+    for( uint32_t pass = 0; pass < TRIANGLE_SPLIT_MAX_PASSES; pass++ )
+    {
+        // how many triangles use an edge
+        auto edgeUsage = rgl::unordered_map< uint64_t, uint32_t >{};
+        for( size_t t = 0; t < indices.size(); t += 3 )
+        {
+            for( size_t e = 0; e < 3; e++ )
+            {
+                edgeUsage[ MakeEdgeKey( indices[ t + e ], indices[ t + ( e + 1 ) % 3 ] ) ]++;
+            }
+        }
+
+        // midpoint vertex of each edge to split
+        auto   midpoints     = rgl::unordered_map< uint64_t, uint32_t >{};
+        size_t newIndexCount = indices.size();
+
+        for( size_t t = 0; t < indices.size(); t += 3 )
+        {
+            const uint32_t tri[] = { indices[ t + 0 ], indices[ t + 1 ], indices[ t + 2 ] };
+
+            if( !IsLongTriangle(
+                    vertices[ tri[ 0 ] ], vertices[ tri[ 1 ] ], vertices[ tri[ 2 ] ] ) )
+            {
+                continue;
+            }
+
+            size_t longest   = 0;
+            float  longestSq = -1;
+            for( size_t e = 0; e < 3; e++ )
+            {
+                const float sq =
+                    DistanceSq( vertices[ tri[ e ] ], vertices[ tri[ ( e + 1 ) % 3 ] ] );
+                if( sq > longestSq )
+                {
+                    longest   = e;
+                    longestSq = sq;
+                }
+            }
+
+            const uint32_t a   = tri[ longest ];
+            const uint32_t b   = tri[ ( longest + 1 ) % 3 ];
+            const uint64_t key = MakeEdgeKey( a, b );
+
+            // a boundary edge might be shared with another primitive
+            if( edgeUsage[ key ] != 2 || midpoints.contains( key ) )
+            {
+                continue;
+            }
+
+            // each split edge adds a triangle on both of its sides
+            if( newIndexCount + 6 > maxIndexCount )
+            {
+                break;
+            }
+            newIndexCount += 6;
+
+            midpoints[ key ] = static_cast< uint32_t >( vertices.size() );
+            vertices.push_back( MakeMidpoint( vertices[ a ], vertices[ b ] ) );
+        }
+
+        if( midpoints.empty() )
+        {
+            break;
+        }
+        anySplit = true;
+
+        auto split = std::vector< uint32_t >{};
+        split.reserve( newIndexCount );
+
+        for( size_t t = 0; t < indices.size(); t += 3 )
+        {
+            const uint32_t tri[] = { indices[ t + 0 ], indices[ t + 1 ], indices[ t + 2 ] };
+
+            // midpoint of the edge that starts at the vertex
+            uint32_t mid[ 3 ];
+            uint32_t splitCount = 0;
+            for( size_t e = 0; e < 3; e++ )
+            {
+                auto found = midpoints.find( MakeEdgeKey( tri[ e ], tri[ ( e + 1 ) % 3 ] ) );
+                mid[ e ]   = found != midpoints.end() ? found->second : UINT32_MAX;
+                splitCount += found != midpoints.end() ? 1 : 0;
+            }
+
+            const auto add = [ &split ]( uint32_t i0, uint32_t i1, uint32_t i2 ) {
+                split.push_back( i0 );
+                split.push_back( i1 );
+                split.push_back( i2 );
+            };
+
+            if( splitCount == 0 )
+            {
+                add( tri[ 0 ], tri[ 1 ], tri[ 2 ] );
+            }
+            else if( splitCount == 3 )
+            {
+                add( tri[ 0 ], mid[ 0 ], mid[ 2 ] );
+                add( mid[ 0 ], tri[ 1 ], mid[ 1 ] );
+                add( mid[ 2 ], mid[ 1 ], tri[ 2 ] );
+                add( mid[ 0 ], mid[ 1 ], mid[ 2 ] );
+            }
+            else
+            {
+                // rotate the vertices, so the first edge is split, and the last is not;
+                // winding order is preserved
+                size_t r = 0;
+                while( !( mid[ r ] != UINT32_MAX && mid[ ( r + 2 ) % 3 ] == UINT32_MAX ) )
+                {
+                    r++;
+                }
+                const uint32_t v0  = tri[ r ];
+                const uint32_t v1  = tri[ ( r + 1 ) % 3 ];
+                const uint32_t v2  = tri[ ( r + 2 ) % 3 ];
+                const uint32_t m01 = mid[ r ];
+                const uint32_t m12 = mid[ ( r + 1 ) % 3 ];
+
+                if( m12 == UINT32_MAX )
+                {
+                    add( v0, m01, v2 );
+                    add( m01, v1, v2 );
+                }
+                else
+                {
+                    add( m01, v1, m12 );
+                    add( v0, m01, m12 );
+                    add( v0, m12, v2 );
+                }
+            }
+        }
+
+        indices = std::move( split );
+    }
+
+    if( !anySplit )
+    {
+        return std::nullopt;
+    }
+
+    return SplitTriangles{
+        .vertices = std::move( vertices ),
+        .indices  = std::move( indices ),
+    };
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <RTGL1/RTGL1.h>
+
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace RTGL1
+{
+
+struct SplitTriangles
+{
+    std::vector< RgPrimitiveVertex > vertices;
+    std::vector< uint32_t >          indices;
+};
+
+// Long thin triangles have large AABB-s, which overlap in BVH and make traversal slower.
+// Such triangles are split at the midpoints of their longest edges. Only the edges shared by
+// two triangles are split, and for both of them, so no T-junctions are introduced.
+// Returns null, if nothing was split
+auto SplitLongTriangles( std::span< const RgPrimitiveVertex > vertices,
+                         std::span< const uint32_t >          indices )
+    -> std::optional< SplitTriangles >;
+
+}
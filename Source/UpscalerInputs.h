@@ -0,0 +1,39 @@
+// Copyright (c) 2024 V.Shirokii
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "Generated/ShaderCommonCFramebuf.h"
+
+namespace RTGL1
+{
+
+// Inputs of the temporal upscalers. They are written once per frame, by the primary rays
+// and the rasterized geometry, and consumed as is by every backend (FSR2, FSR3, DLSS and
+// their DX12 variants), so a new backend should only map these onto its own resource slots.
+// FB_IMAGE_INDEX_REACTIVITY is the single reactive / current color bias mask
+constexpr FramebufferImageIndex UPSCALER_INPUT_IMAGES[] = {
+    FB_IMAGE_INDEX_FINAL,
+    FB_IMAGE_INDEX_DEPTH_NDC,
+    FB_IMAGE_INDEX_MOTION_DLSS,
+    FB_IMAGE_INDEX_REACTIVITY,
+};
+
+}
@@ -20,11 +20,26 @@
 
 #include "Utils.h"
 
+#include <atomic>
 #include <cmath>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#if defined( _WIN32 )
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
 
 #ifdef __linux__
     #include <dlfcn.h>
-    #include <unistd.h>
     #include <linux/limits.h>
 #endif
 
@@ -55,6 +70,136 @@ auto Utils::FindBinFolder() -> std::filesystem::path
     return binFolder;
 }
 
+bool Utils::MapFile( const std::filesystem::path& path,
+                     void**                       pView,
+                     size_t*                      pSize,
+                     void**                       pHandle )
+{
+#if defined( _WIN32 )
+    HANDLE file = CreateFileW( path.c_str(),
+                               GENERIC_READ,
+                               FILE_SHARE_READ,
+                               nullptr,
+                               OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                               nullptr );
+    if( file == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size = {};
+    if( !GetFileSizeEx( file, &size ) || size.QuadPart == 0 )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+    // mapping holds a reference to the file
+    CloseHandle( file );
+    if( !mapping )
+    {
+        return false;
+    }
+
+    void* view = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+    if( !view )
+    {
+        CloseHandle( mapping );
+        return false;
+    }
+
+    *pView   = view;
+    *pSize   = size_t( size.QuadPart );
+    *pHandle = mapping;
+    return true;
+#else
+    int fd = open( path.c_str(), O_RDONLY );
+    if( fd < 0 )
+    {
+        return false;
+    }
+
+    struct stat st = {};
+    if( fstat( fd, &st ) != 0 || st.st_size <= 0 )
+    {
+        close( fd );
+        return false;
+    }
+
+    void* view = mmap( nullptr, size_t( st.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+    // mapping holds a reference to the file
+    close( fd );
+    if( view == MAP_FAILED )
+    {
+        return false;
+    }
+    madvise( view, size_t( st.st_size ), MADV_SEQUENTIAL );
+
+    *pView   = view;
+    *pSize   = size_t( st.st_size );
+    *pHandle = nullptr;
+    return true;
+#endif
+}
+
+void Utils::UnmapFile( void* view, size_t size, void* handle )
+{
+#if defined( _WIN32 )
+    UnmapViewOfFile( view );
+    CloseHandle( handle );
+#else
+    munmap( view, size );
+#endif
+}
+
+void Utils::ParallelFor( size_t count, const std::function< void( size_t ) >& job )
+{
+    auto next  = std::atomic_size_t{ 0 };
+    auto error = std::exception_ptr{};
+    auto guard = std::mutex{};
+
+    auto worker = [ & ]() {
+        for( size_t i = next++; i < count; i = next++ )
+        {
+            try
+            {
+                job( i );
+            }
+            catch( ... )
+            {
+                auto l = std::lock_guard{ guard };
+                if( !error )
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    const size_t threadCount = std::clamp< size_t >(
+        std::thread::hardware_concurrency(), 1, std::max< size_t >( count, 1 ) );
+
+    auto workers = std::vector< std::future< void > >{};
+    for( size_t t = 1; t < threadCount; t++ )
+    {
+        workers.push_back( std::async( std::launch::async, worker ) );
+    }
+
+    // current thread participates too
+    worker();
+    for( auto& w : workers )
+    {
+        w.get();
+    }
+
+    if( error )
+    {
+        std::rethrow_exception( error );
+    }
+}
+
 void Utils::BarrierImage( VkCommandBuffer                cmd,
                           VkImage                        image,
                           VkAccessFlags                  srcAccessMask,
@@ -172,6 +317,18 @@ void Utils::ASBuildMemoryBarrier( VkCommandBuffer cmd )
                           nullptr );
 }
 
+void Utils::DispatchFullscreen( VkCommandBuffer cmd,
+                                uint32_t        width,
+                                uint32_t        height,
+                                uint32_t        groupSizeX,
+                                uint32_t        groupSizeY )
+{
+    vkCmdDispatch( cmd,
+                   GetWorkGroupCount( width, groupSizeX ),
+                   GetWorkGroupCount( height, groupSizeY ),
+                   1 );
+}
+
 void Utils::WaitForFence( VkDevice device, VkFence fence )
 {
     VkResult r = vkWaitForFences( device, 1, &fence, VK_TRUE, UINT64_MAX );
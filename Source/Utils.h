@@ -24,6 +24,8 @@
 #include <array>
 #include <optional>
 #include <filesystem>
+#include <functional>
+#include <span>
 
 #include "Common.h"
 #include "RTGL1/RTGL1.h"
@@ -122,6 +124,14 @@ namespace Utils
     // Path to the folder containing .dll / .so
     auto FindBinFolder() -> std::filesystem::path;
 
+    // Read-only memory mapping of a whole file. Returns false, if the file is empty or missing
+    bool MapFile( const std::filesystem::path& path, void** pView, size_t* pSize, void** pHandle );
+    void UnmapFile( void* view, size_t size, void* handle );
+
+    // Call 'job' for each index in [0, count) on the hardware threads, the current one included.
+    // The first exception thrown by a job is rethrown, after all jobs are finished
+    void ParallelFor( size_t count, const std::function< void( size_t ) >& job );
+
     void BarrierImage( VkCommandBuffer                cmd,
                        VkImage                        image,
                        VkAccessFlags                  srcAccessMask,
@@ -158,6 +168,14 @@ namespace Utils
 
     void ASBuildMemoryBarrier( VkCommandBuffer cmd );
 
+    // Dispatch a 2D grid of workgroups that covers 'width' x 'height' pixels.
+    // The shader is expected to remap the workgroups into tiles, see ThreadGroupSwizzle.h
+    void DispatchFullscreen( VkCommandBuffer cmd,
+                             uint32_t        width,
+                             uint32_t        height,
+                             uint32_t        groupSizeX,
+                             uint32_t        groupSizeY );
+
     void WaitForFence( VkDevice device, VkFence fence );
     void ResetFence( VkDevice device, VkFence fence );
     void WaitAndResetFence( VkDevice device, VkFence fence );
@@ -245,9 +263,9 @@ namespace Utils
         assert( count > 0 );
         return ( value + ( count - 1 ) ) % count;
     }
-    constexpr uint32_t PrevFrame( uint32_t frameIndex )
+    inline uint32_t PrevFrame( uint32_t frameIndex )
     {
-        return GetPreviousByModulo( frameIndex, MAX_FRAMES_IN_FLIGHT );
+        return GetPreviousByModulo( frameIndex, FramesInFlight() );
     }
 
     template< uint32_t GroupSize >
@@ -388,6 +406,25 @@ namespace Utils
     {
         return cstr == nullptr || *cstr == '\0';
     }
+
+    // Indices of a primitive are either 32-bit, or 16-bit in 'pIndices16'
+    inline bool HasIndices( const RgMeshPrimitiveInfo& prim )
+    {
+        return prim.indexCount > 0 && ( prim.pIndices || prim.pIndices16 );
+    }
+    inline uint32_t GetIndex( const RgMeshPrimitiveInfo& prim, uint32_t i )
+    {
+        return prim.pIndices16 ? uint32_t{ prim.pIndices16[ i ] } : prim.pIndices[ i ];
+    }
+    inline auto GetIndexData( const RgMeshPrimitiveInfo& prim ) -> std::span< const std::byte >
+    {
+        if( !HasIndices( prim ) )
+        {
+            return {};
+        }
+        return prim.pIndices16 ? std::as_bytes( std::span{ prim.pIndices16, prim.indexCount } )
+                               : std::as_bytes( std::span{ prim.pIndices, prim.indexCount } );
+    }
     inline const char* SafeCstr( const char* cstr )
     {
         return cstr ? cstr : "";
@@ -20,6 +20,7 @@
 
 #include "VertexCollector.h"
 
+#include "CpuProfiler.h"
 #include "DrawFrameInfo.h"
 #include "GeomInfoManager.h"
 #include "Utils.h"
@@ -28,8 +29,12 @@
 
 #include <algorithm>
 #include <array>
+#include <cfloat>
+#include <cmath>
 #include <cstring>
 
+#include "glm/glm.hpp"
+
 namespace
 {
 
@@ -61,6 +66,76 @@ auto MakeUsage( bool isDynamic, bool accelStructureRead )
     return usage;
 }
 
+// neighbour ranges separated by alignment padding are copied as one region
+constexpr uint32_t DIRTY_COALESCE_GAP = 2;
+
+void MarkDirty( std::vector< RTGL1::CopyRange >& dirty, uint32_t first, uint32_t count )
+{
+    using RTGL1::CopyRange;
+
+    if( count == 0 )
+    {
+        return;
+    }
+    const auto rng = RTGL1::MakeRangeFromCount( first, count );
+
+    // uploads are mostly sequential, so usually it's an extension of the last one
+    if( !dirty.empty() && rng.vbegin <= dirty.back().vend + DIRTY_COALESCE_GAP &&
+        rng.vend >= dirty.back().vbegin )
+    {
+        dirty.back() = CopyRange::merge( dirty.back(), rng );
+        return;
+    }
+
+    // keep sorted by the beginning, intersections are resolved in TakeDirty
+    auto at = std::ranges::upper_bound( dirty, rng.vbegin, {}, &CopyRange::vbegin );
+    dirty.insert( at, rng );
+}
+
+// Remove parts of dirty ranges that are inside 'rng', and return them coalesced
+auto TakeDirty( std::vector< RTGL1::CopyRange >& dirty, const RTGL1::CopyRange& rng )
+    -> std::vector< RTGL1::CopyRange >
+{
+    using RTGL1::CopyRange;
+
+    auto taken = std::vector< CopyRange >{};
+    auto left  = std::vector< CopyRange >{};
+
+    for( const CopyRange& d : dirty )
+    {
+        // outside of the requested range, leave for a later copy
+        if( d.vbegin < rng.vbegin )
+        {
+            left.push_back( { .vbegin = d.vbegin, .vend = std::min( d.vend, rng.vbegin ) } );
+        }
+        if( d.vend > rng.vend )
+        {
+            left.push_back( { .vbegin = std::max( d.vbegin, rng.vend ), .vend = d.vend } );
+        }
+
+        const auto inside = CopyRange{
+            .vbegin = std::max( d.vbegin, rng.vbegin ),
+            .vend   = std::min( d.vend, rng.vend ),
+        };
+        if( inside.vbegin >= inside.vend )
+        {
+            continue;
+        }
+
+        if( !taken.empty() && inside.vbegin <= taken.back().vend + DIRTY_COALESCE_GAP )
+        {
+            taken.back() = CopyRange::merge( taken.back(), inside );
+        }
+        else
+        {
+            taken.push_back( inside );
+        }
+    }
+
+    dirty = std::move( left );
+    return taken;
+}
+
 }
 
 RTGL1::VertexCollector::VertexCollector( VkDevice         _device,
@@ -68,28 +143,41 @@ RTGL1::VertexCollector::VertexCollector( VkDevice         _device,
                                          const size_t ( &_maxVertsPerLayer )[ 4 ],
                                          const size_t     _maxIndices,
                                          bool             _isDynamic,
-                                         std::string_view _debugName )
+                                         std::string_view _debugName,
+                                         bool             _quantizeVertices,
+                                         bool             _directWrite )
     : device{ _device }
+    , directWrite{ _directWrite }
     , bufVertices{ _allocator,
-                   _maxVertsPerLayer[ 0 ],
+                   _quantizeVertices ? 0 : _maxVertsPerLayer[ 0 ],
                    MakeUsage( _isDynamic, true ),
-                   MakeName( "Vertices", _debugName ) }
+                   MakeName( "Vertices", _debugName ),
+                   _directWrite }
+    , bufVerticesQuantized{ _allocator,
+                            _quantizeVertices ? _maxVertsPerLayer[ 0 ] : 0,
+                            MakeUsage( _isDynamic, true ),
+                            MakeName( "Vertices Quantized", _debugName ),
+                            _directWrite }
     , bufIndices{ _allocator,
                   _maxIndices,
                   MakeUsage( _isDynamic, true ),
-                  MakeName( "Indices", _debugName ) }
+                  MakeName( "Indices", _debugName ),
+                  _directWrite }
     , bufTexcoordLayer1{ _allocator,
                          _maxVertsPerLayer[ 1 ],
                          MakeUsage( _isDynamic, false ),
-                         MakeName( "Texcoords Layer1", _debugName ) }
+                         MakeName( "Texcoords Layer1", _debugName ),
+                         _directWrite }
     , bufTexcoordLayer2{ _allocator,
                          _maxVertsPerLayer[ 2 ],
                          MakeUsage( _isDynamic, false ),
-                         MakeName( "Texcoords Layer2", _debugName ) }
+                         MakeName( "Texcoords Layer2", _debugName ),
+                         _directWrite }
     , bufTexcoordLayer3{ _allocator,
                          _maxVertsPerLayer[ 3 ],
                          MakeUsage( _isDynamic, false ),
-                         MakeName( "Texcoords Layer3", _debugName ) }
+                         MakeName( "Texcoords Layer3", _debugName ),
+                         _directWrite }
 {
     if( _isDynamic )
     {
@@ -102,7 +190,11 @@ RTGL1::VertexCollector::VertexCollector( const VertexCollector& _src,
                                          MemoryAllocator&       _allocator,
                                          std::string_view       _debugName )
     : device{ _src.device }
+    , directWrite{ false }
     , bufVertices{ _src.bufVertices, _allocator, MakeName( "Vertices", _debugName ) }
+    , bufVerticesQuantized{ _src.bufVerticesQuantized,
+                            _allocator,
+                            MakeName( "Vertices Quantized", _debugName ) }
     , bufIndices{ _src.bufIndices, _allocator, MakeName( "Indices", _debugName ) }
     , bufTexcoordLayer1{ _src.bufTexcoordLayer1,
                          _allocator,
@@ -115,7 +207,7 @@ RTGL1::VertexCollector::VertexCollector( const VertexCollector& _src,
                          MakeName( "Texcoords Layer3", _debugName ) }
 {
     // allocate staging, if "src" had staging allocated
-    if( _src.bufVertices.staging.IsInitted() )
+    if( _src.bufVertices.staging.IsInitted() || _src.bufVerticesQuantized.staging.IsInitted() )
     {
         AllocateStaging( _allocator );
     }
@@ -137,46 +229,144 @@ uint32_t AlignUpBy3( uint32_t x )
     return ( ( x + 2 ) / 3 ) * 3;
 }
 
+// layouts are the same, see CopyDataToStaging
+RgPrimitiveVertex* AsPrimitiveVertices( RTGL1::ShVertex* v )
+{
+    return reinterpret_cast< RgPrimitiveVertex* >( v );
+}
+
+const RgPrimitiveVertex* AsPrimitiveVertices( const RTGL1::ShVertex* v )
+{
+    return reinterpret_cast< const RgPrimitiveVertex* >( v );
+}
+
+auto MakeDequantization( const RgMeshPrimitiveInfo& prim )
+    -> RTGL1::VertexCollector::Dequantization
+{
+    float vmin[ 3 ] = { +FLT_MAX, +FLT_MAX, +FLT_MAX };
+    float vmax[ 3 ] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+    for( uint32_t i = 0; i < prim.vertexCount; i++ )
+    {
+        for( int a = 0; a < 3; a++ )
+        {
+            vmin[ a ] = std::min( vmin[ a ], prim.pVertices[ i ].position[ a ] );
+            vmax[ a ] = std::max( vmax[ a ], prim.pVertices[ i ].position[ a ] );
+        }
+    }
+
+    auto d = RTGL1::VertexCollector::Dequantization{};
+    if( prim.vertexCount == 0 )
+    {
+        d.extent = { 1, 1, 1 };
+        return d;
+    }
+
+    const float maxExtent =
+        std::max( { vmax[ 0 ] - vmin[ 0 ], vmax[ 1 ] - vmin[ 1 ], vmax[ 2 ] - vmin[ 2 ] } ) * 0.5f;
+
+    for( int a = 0; a < 3; a++ )
+    {
+        d.center.data[ a ] = ( vmin[ a ] + vmax[ a ] ) * 0.5f;
+        // a flat primitive must not make a degenerate BLAS transform
+        d.extent.data[ a ] = std::max( ( vmax[ a ] - vmin[ a ] ) * 0.5f,
+                                       std::max( maxExtent * 0.0001f, 0.000001f ) );
+    }
+    return d;
+}
+
+uint32_t QuantizeSnorm16( float v )
+{
+    const float c = std::clamp( v, -1.0f, 1.0f );
+    return uint32_t( int32_t( std::round( c * 32767.0f ) ) ) & 0xFFFF;
+}
+
 }
 
 auto RTGL1::VertexCollector::Upload( VertexCollectorFilterTypeFlags geomFlags,
-                                     const RgMeshPrimitiveInfo&     prim )
+                                     const RgMeshPrimitiveInfo&     prim,
+                                     bool                           verticesOnDevice )
     -> std::optional< UploadResult >
 {
+    RG_CPU_ZONE( "VertexCollector::Upload" );
+
     using FT = VertexCollectorFilterTypeFlagBits;
 
-    const uint32_t vertIndex   = AlignUpBy3( count.vertex );
+    // quantization is done on CPU
+    assert( !verticesOnDevice || !bufVerticesQuantized.IsInitialized() );
+
+    // vertices might be already written in place
+    const std::optional< uint32_t > reservedIndex = FindStagingVertexIndex( prim );
+
+    const uint32_t vertIndex   = reservedIndex ? *reservedIndex : AlignUpBy3( count.vertex );
     const uint32_t indIndex    = AlignUpBy3( count.index );
     const uint32_t texcIndex_1 = count.texCoord_Layer1;
     const uint32_t texcIndex_2 = count.texCoord_Layer2;
     const uint32_t texcIndex_3 = count.texCoord_Layer3;
 
-    const bool     useIndices    = prim.indexCount != 0 && prim.pIndices != nullptr;
+    const bool     useIndices    = Utils::HasIndices( prim );
+    const bool     useIndices16  = useIndices && prim.pIndices16 != nullptr;
     const uint32_t triangleCount = useIndices ? prim.indexCount / 3 : prim.vertexCount / 3;
+    // 16-bit indices are packed in pairs into the elements of the index buffer
+    const uint32_t indexSlots =
+        useIndices ? ( useIndices16 ? ( prim.indexCount + 1 ) / 2 : prim.indexCount ) : 0;
 
 
-    if( count.vertex + prim.vertexCount >= bufVertices.ElementCount() )
+    if( !reservedIndex && count.vertex + prim.vertexCount >= GetVertexCapacity() )
     {
+        overflow.vertex += AlignUpBy3( prim.vertexCount );
+        overflow.index += AlignUpBy3( indexSlots );
         debug::Error( geomFlags & FT::CF_DYNAMIC ? "Too many dynamic vertices: the limit is {}"
                                                  : "Too many static vertices: the limit is {}",
-                      bufVertices.ElementCount() );
+                      GetVertexCapacity() );
         return {};
     }
-    if( count.index + ( useIndices ? prim.indexCount : 0 ) >= bufIndices.ElementCount() )
+    if( count.index + indexSlots >= bufIndices.ElementCount() )
     {
+        overflow.vertex += AlignUpBy3( prim.vertexCount );
+        overflow.index += AlignUpBy3( indexSlots );
         debug::Error( "Too many indices: the limit is {}", bufIndices.ElementCount() );
         return {};
     }
 
 
     // clang-format off
-    count.vertex          = vertIndex   + ( prim.vertexCount );
-    count.index           = indIndex    + ( useIndices ? prim.indexCount : 0 );
+    count.vertex          = reservedIndex ? count.vertex : vertIndex + prim.vertexCount;
+    count.index           = indIndex    + indexSlots;
     count.texCoord_Layer1 = texcIndex_1 + ( GeomInfoManager::LayerExists( prim, 1 ) ? prim.vertexCount : 0 );
     count.texCoord_Layer2 = texcIndex_2 + ( GeomInfoManager::LayerExists( prim, 2 ) ? prim.vertexCount : 0 );
     count.texCoord_Layer3 = texcIndex_3 + ( GeomInfoManager::LayerExists( prim, 3 ) ? prim.vertexCount : 0 );
     // clang-format on
 
+    // reserved vertices were written in place by the user, so they're dirty too;
+    // but the ones written on GPU must not be overwritten by the copy from staging
+    if( !verticesOnDevice )
+    {
+        MarkDirty( bufVerticesQuantized.IsInitialized() ? bufVerticesQuantized.dirty
+                                                        : bufVertices.dirty,
+                   vertIndex,
+                   prim.vertexCount );
+    }
+    MarkDirty( bufIndices.dirty, indIndex, indexSlots );
+    {
+        std::tuple< SharedDeviceLocal< RgFloat2D >*, uint32_t, uint32_t > texLayers[] = {
+            { &bufTexcoordLayer1, texcIndex_1, 1 },
+            { &bufTexcoordLayer2, texcIndex_2, 2 },
+            { &bufTexcoordLayer3, texcIndex_3, 3 },
+        };
+        for( auto [ tbuf, texcIndex, layerIndex ] : texLayers )
+        {
+            if( tbuf->IsInitialized() && GeomInfoManager::LayerExists( prim, layerIndex ) )
+            {
+                MarkDirty( tbuf->dirty, texcIndex, prim.vertexCount );
+            }
+        }
+    }
+
+
+    const auto dequant = bufVerticesQuantized.IsInitialized()
+                             ? std::optional{ MakeDequantization( prim ) }
+                             : std::nullopt;
 
     // copy data to staging buffers
     CopyDataToStaging( prim,
@@ -184,25 +374,43 @@ auto RTGL1::VertexCollector::Upload( VertexCollectorFilterTypeFlags geomFlags,
                        useIndices ? std::optional{ indIndex } : std::nullopt,
                        texcIndex_1,
                        texcIndex_2,
-                       texcIndex_3 );
+                       texcIndex_3,
+                       dequant,
+                       !verticesOnDevice );
 
 
     auto triangles = VkAccelerationStructureGeometryTrianglesDataKHR{
         .sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR,
         // vertices
         .vertexFormat = VK_FORMAT_R32G32B32_SFLOAT,
-        .vertexData   = { .deviceAddress = bufVertices.deviceLocal->GetAddress() +
-                                           vertIndex * sizeof( ShVertex ) +
-                                           offsetof( ShVertex, position ) },
+        .vertexData   = {},
         .vertexStride = sizeof( ShVertex ),
         .maxVertex    = prim.vertexCount,
         // indices
-        .indexType = useIndices ? VK_INDEX_TYPE_UINT32 : VK_INDEX_TYPE_NONE_KHR,
+        .indexType = useIndices16 ? VK_INDEX_TYPE_UINT16
+                     : useIndices ? VK_INDEX_TYPE_UINT32
+                                  : VK_INDEX_TYPE_NONE_KHR,
         .indexData = { .deviceAddress = useIndices ? bufIndices.deviceLocal->GetAddress() +
                                                          indIndex * sizeof( uint32_t )
                                                    : 0 },
     };
 
+    if( dequant )
+    {
+        // one of the formats that are required to be supported for BLAS build
+        triangles.vertexFormat = VK_FORMAT_R16G16B16A16_SNORM;
+        triangles.vertexData   = { .deviceAddress = bufVerticesQuantized.deviceLocal->GetAddress() +
+                                                    vertIndex * sizeof( ShVertexQuantized ) +
+                                                    offsetof( ShVertexQuantized, positionXY ) };
+        triangles.vertexStride = sizeof( ShVertexQuantized );
+    }
+    else
+    {
+        triangles.vertexData = { .deviceAddress = bufVertices.deviceLocal->GetAddress() +
+                                                  vertIndex * sizeof( ShVertex ) +
+                                                  offsetof( ShVertex, position ) };
+    }
+
     auto geom = VkAccelerationStructureGeometryKHR{
         .sType        = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR,
         .geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR,
@@ -227,20 +435,122 @@ auto RTGL1::VertexCollector::Upload( VertexCollectorFilterTypeFlags geomFlags,
         .firstVertex_Layer1 = texcIndex_1,
         .firstVertex_Layer2 = texcIndex_2,
         .firstVertex_Layer3 = texcIndex_3,
+        .dequant            = dequant,
     };
 }
 
-void RTGL1::VertexCollector::CopyDataToStaging( const RgMeshPrimitiveInfo& info,
+namespace
+{
+thread_local RTGL1::VertexCollector::DeferredStagingCopies* t_deferredCopies = nullptr;
+}
+
+RTGL1::VertexCollector::DeferredStagingCopies::DeferredStagingCopies()
+    : prev{ t_deferredCopies }
+{
+    t_deferredCopies = this;
+}
+
+RTGL1::VertexCollector::DeferredStagingCopies::~DeferredStagingCopies()
+{
+    assert( t_deferredCopies == this );
+    t_deferredCopies = prev;
+
+    Flush();
+}
+
+void RTGL1::VertexCollector::DeferredStagingCopies::Flush()
+{
+    for( const Copy& c : copies )
+    {
+        memcpy( c.dst, c.src, c.size );
+    }
+    copies.clear();
+}
+
+void RTGL1::VertexCollector::DeferredStagingCopies::FlushCurrent()
+{
+    if( t_deferredCopies )
+    {
+        t_deferredCopies->Flush();
+    }
+}
+
+void RTGL1::VertexCollector::CopyToStaging( void* dst, const void* src, size_t size )
+{
+    if( t_deferredCopies )
+    {
+        t_deferredCopies->copies.push_back( DeferredStagingCopies::Copy{
+            .dst  = dst,
+            .src  = src,
+            .size = size,
+        } );
+        return;
+    }
+    memcpy( dst, src, size );
+}
+
+void RTGL1::VertexCollector::QuantizeToStaging( const RgMeshPrimitiveInfo& info,
                                                 uint32_t                   vertIndex,
-                                                std::optional< uint32_t >  indIndex,
-                                                uint32_t                   texcIndex_1,
-                                                uint32_t                   texcIndex_2,
-                                                uint32_t                   texcIndex_3 )
+                                                const Dequantization&      dequant )
 {
+    assert( bufVerticesQuantized.mapped );
+    assert( ( vertIndex + info.vertexCount ) * sizeof( ShVertexQuantized ) <
+            bufVerticesQuantized.deviceLocal->GetSize() );
+    static_assert( offsetof( ShVertexQuantized, positionZW ) ==
+                       offsetof( ShVertexQuantized, positionXY ) + sizeof( uint32_t ),
+                   "Position must be R16G16B16A16 for BLAS" );
+
+    const int64_t idInStaging = int64_t{ vertIndex } - int64_t{ stagingOffset.vertex };
+
+    assert( idInStaging >= 0 );
+    if( idInStaging < 0 )
+    {
+        return;
+    }
+
+    const auto quantize = [ &dequant ]( const float* pos, int axis ) {
+        return QuantizeSnorm16( ( pos[ axis ] - dequant.center.data[ axis ] ) /
+                                dequant.extent.data[ axis ] );
+    };
+
+    // converted on this thread, not deferred: source is not copied as is
+    ShVertexQuantized* dst = &bufVerticesQuantized.mapped[ idInStaging ];
+    for( uint32_t i = 0; i < info.vertexCount; i++ )
+    {
+        const RgPrimitiveVertex& src = info.pVertices[ i ];
+
+        dst[ i ] = ShVertexQuantized{
+            .positionXY     = quantize( src.position, 0 ) | ( quantize( src.position, 1 ) << 16 ),
+            .positionZW     = quantize( src.position, 2 ),
+            .normalPacked   = src.normalPacked,
+            .texCoordPacked = glm::packHalf2x16( { src.texCoord[ 0 ], src.texCoord[ 1 ] } ),
+            .color          = src.color,
+        };
+    }
+}
+
+void RTGL1::VertexCollector::CopyDataToStaging( const RgMeshPrimitiveInfo&             info,
+                                                uint32_t                               vertIndex,
+                                                std::optional< uint32_t >              indIndex,
+                                                uint32_t                               texcIndex_1,
+                                                uint32_t                               texcIndex_2,
+                                                uint32_t                               texcIndex_3,
+                                                const std::optional< Dequantization >& dequant,
+                                                bool                                   copyVertices )
+{
+    if( !copyVertices )
+    {
+        // vertices are written on GPU
+    }
+    else if( dequant )
+    {
+        QuantizeToStaging( info, vertIndex, *dequant );
+    }
+    else
     {
         assert( bufVertices.mapped );
         assert( ( vertIndex + info.vertexCount ) * sizeof( ShVertex ) <
-                bufVertices.staging.GetSize() );
+                bufVertices.deviceLocal->GetSize() );
 
         // must be same to copy
         static_assert( std::is_same_v< decltype( info.pVertices ), const RgPrimitiveVertex* > );
@@ -255,28 +565,30 @@ void RTGL1::VertexCollector::CopyDataToStaging( const RgMeshPrimitiveInfo& info,
         uint32_t countInStaging = info.vertexCount;
 
         assert( idInStaging >= 0 );
-        if( idInStaging >= 0 )
+        // skip, if reserved by ReserveStagingVertices and filled in place
+        if( idInStaging >= 0 &&
+            info.pVertices != AsPrimitiveVertices( &bufVertices.mapped[ idInStaging ] ) )
         {
-            memcpy( &bufVertices.mapped[ idInStaging ],
-                    info.pVertices,
-                    countInStaging * sizeof( ShVertex ) );
+            CopyToStaging( &bufVertices.mapped[ idInStaging ],
+                           info.pVertices,
+                           countInStaging * sizeof( ShVertex ) );
         }
     }
 
     if( indIndex )
     {
-        assert( info.indexCount > 0 && info.pIndices );
+        assert( Utils::HasIndices( info ) );
         assert( bufIndices.mapped );
 
-        int64_t  idInStaging    = int64_t{ indIndex.value() } - int64_t{ stagingOffset.index };
-        uint32_t countInStaging = info.indexCount;
+        int64_t idInStaging = int64_t{ indIndex.value() } - int64_t{ stagingOffset.index };
+
+        // as is: 16-bit indices are read in pairs from a 32-bit element
+        const std::span< const std::byte > src = Utils::GetIndexData( info );
 
         assert( idInStaging >= 0 );
         if( idInStaging >= 0 )
         {
-            memcpy( &bufIndices.mapped[ idInStaging ],
-                    info.pIndices,
-                    countInStaging * sizeof( uint32_t ) );
+            CopyToStaging( &bufIndices.mapped[ idInStaging ], src.data(), src.size() );
         }
     }
 
@@ -323,53 +635,128 @@ void RTGL1::VertexCollector::CopyDataToStaging( const RgMeshPrimitiveInfo& info,
             assert( idInStaging >= 0 );
             if( idInStaging >= 0 )
             {
-                memcpy(
+                CopyToStaging(
                     &dst.buffer->mapped[ idInStaging ], src, countInStaging * sizeof( RgFloat2D ) );
             }
         }
     }
 }
 
+RgPrimitiveVertex* RTGL1::VertexCollector::ReserveStagingVertices( uint32_t vertexCount )
+{
+    if( !bufVertices.mapped || vertexCount == 0 )
+    {
+        return nullptr;
+    }
+
+    const uint32_t vertIndex = AlignUpBy3( count.vertex );
+
+    if( vertIndex + vertexCount >= bufVertices.ElementCount() )
+    {
+        overflow.vertex += AlignUpBy3( vertexCount );
+        debug::Error( "Too many dynamic vertices: the limit is {}", bufVertices.ElementCount() );
+        return nullptr;
+    }
+
+    const int64_t idInStaging = int64_t{ vertIndex } - int64_t{ stagingOffset.vertex };
+    assert( idInStaging >= 0 );
+    if( idInStaging < 0 )
+    {
+        return nullptr;
+    }
+
+    count.vertex = vertIndex + vertexCount;
+    return AsPrimitiveVertices( &bufVertices.mapped[ idInStaging ] );
+}
+
+auto RTGL1::VertexCollector::FindStagingVertexIndex( const RgMeshPrimitiveInfo& prim ) const
+    -> std::optional< uint32_t >
+{
+    if( !bufVertices.mapped || !prim.pVertices )
+    {
+        return std::nullopt;
+    }
+
+    // pointers can be unrelated, compare as integers
+    const auto begin = reinterpret_cast< uintptr_t >( AsPrimitiveVertices( bufVertices.mapped ) );
+    const auto end =
+        begin + sizeof( RgPrimitiveVertex ) * ( count.vertex - stagingOffset.vertex );
+    const auto src   = reinterpret_cast< uintptr_t >( prim.pVertices );
+
+    if( src < begin || src + sizeof( RgPrimitiveVertex ) * prim.vertexCount > end ||
+        ( src - begin ) % sizeof( RgPrimitiveVertex ) != 0 )
+    {
+        return std::nullopt;
+    }
+
+    const uint32_t vertIndex =
+        uint32_t( ( src - begin ) / sizeof( RgPrimitiveVertex ) ) + stagingOffset.vertex;
+
+    // same alignment as on a regular upload
+    if( vertIndex != AlignUpBy3( vertIndex ) )
+    {
+        return std::nullopt;
+    }
+    return vertIndex;
+}
+
 void RTGL1::VertexCollector::Reset( const CopyRanges* rangeToPreserve )
 {
     if( rangeToPreserve )
     {
-        // only at the beginning
-        assert( rangeToPreserve->vertices.first() == 0 );
-        assert( rangeToPreserve->indices.first() == 0 );
-        assert( rangeToPreserve->texCoord1.first() == 0 );
-        assert( rangeToPreserve->texCoord2.first() == 0 );
-        assert( rangeToPreserve->texCoord3.first() == 0 );
-
         assert( rangeToPreserve->vertices.count() <= count.vertex );
         assert( rangeToPreserve->indices.count() <= count.index );
         assert( rangeToPreserve->texCoord1.count() <= count.texCoord_Layer1 );
         assert( rangeToPreserve->texCoord2.count() <= count.texCoord_Layer2 );
         assert( rangeToPreserve->texCoord3.count() <= count.texCoord_Layer3 );
 
-        stagingOffset = Count{
-            .vertex          = rangeToPreserve->vertices.count(),
-            .index           = rangeToPreserve->indices.count(),
-            .texCoord_Layer1 = rangeToPreserve->texCoord1.count(),
-            .texCoord_Layer2 = rangeToPreserve->texCoord2.count(),
-            .texCoord_Layer3 = rangeToPreserve->texCoord3.count(),
-        };
-
-        count = Count{
-            .vertex          = rangeToPreserve->vertices.count(),
-            .index           = rangeToPreserve->indices.count(),
-            .texCoord_Layer1 = rangeToPreserve->texCoord1.count(),
-            .texCoord_Layer2 = rangeToPreserve->texCoord2.count(),
-            .texCoord_Layer3 = rangeToPreserve->texCoord3.count(),
-        };
+        ResetToPrefix( *rangeToPreserve );
     }
     else
     {
         count         = {};
         stagingOffset = {};
+        overflow      = {};
+        ClearDirty();
     }
 }
 
+void RTGL1::VertexCollector::ClearDirty()
+{
+    bufVertices.dirty.clear();
+    bufVerticesQuantized.dirty.clear();
+    bufIndices.dirty.clear();
+    bufTexcoordLayer1.dirty.clear();
+    bufTexcoordLayer2.dirty.clear();
+    bufTexcoordLayer3.dirty.clear();
+}
+
+void RTGL1::VertexCollector::ResetToPrefix( const CopyRanges& prefix )
+{
+    // only at the beginning
+    assert( prefix.vertices.first() == 0 );
+    assert( prefix.indices.first() == 0 );
+    assert( prefix.texCoord1.first() == 0 );
+    assert( prefix.texCoord2.first() == 0 );
+    assert( prefix.texCoord3.first() == 0 );
+
+    const auto prefixCount = Count{
+        .vertex          = prefix.vertices.count(),
+        .index           = prefix.indices.count(),
+        .texCoord_Layer1 = prefix.texCoord1.count(),
+        .texCoord_Layer2 = prefix.texCoord2.count(),
+        .texCoord_Layer3 = prefix.texCoord3.count(),
+    };
+
+    // if written in place, the prefix stays where it is
+    stagingOffset = directWrite ? Count{} : prefixCount;
+
+    count    = prefixCount;
+    overflow = {};
+    // prefix is not in staging anymore
+    ClearDirty();
+}
+
 RTGL1::VertexCollector::CopyRanges RTGL1::VertexCollector::GetCurrentRanges() const
 {
     return CopyRanges{
@@ -389,6 +776,7 @@ bool RTGL1::VertexCollector::CopyFromStaging( VkCommandBuffer cmd )
 void RTGL1::VertexCollector::AllocateStaging( MemoryAllocator& alloc )
 {
     bufVertices.InitStaging( alloc );
+    bufVerticesQuantized.InitStaging( alloc );
     bufIndices.InitStaging( alloc );
     bufTexcoordLayer1.InitStaging( alloc );
     bufTexcoordLayer2.InitStaging( alloc );
@@ -398,6 +786,7 @@ void RTGL1::VertexCollector::AllocateStaging( MemoryAllocator& alloc )
 void RTGL1::VertexCollector::DeleteStaging()
 {
     bufVertices.DestroyStaging();
+    bufVerticesQuantized.DestroyStaging();
     bufIndices.DestroyStaging();
     bufTexcoordLayer1.DestroyStaging();
     bufTexcoordLayer2.DestroyStaging();
@@ -413,29 +802,52 @@ bool RTGL1::VertexCollector::CopyFromStaging( VkCommandBuffer cmd, const CopyRan
         VkDeviceSize size;
     };
 
+    // only the written parts of 'rng' are copied, with one region per dirty range
     auto copyFromStaging = []< typename T >( VkCommandBuffer         cmd,
                                              SharedDeviceLocal< T >& buf,
                                              uint32_t                stagingOffsetElem,
                                              const CopyRange& rng ) -> std::optional< Temp > {
-        if( rng.valid() )
+        if( !rng.valid() || !buf.IsInitialized() )
         {
-            assert( int64_t{ rng.first() } - int64_t{ stagingOffsetElem } >= 0 );
+            return {};
+        }
 
-            auto info = VkBufferCopy{
-                .srcOffset = ( rng.first() - stagingOffsetElem ) * sizeof( T ),
-                .dstOffset = rng.first() * sizeof( T ),
-                .size      = rng.count() * sizeof( T ),
-            };
+        const auto toCopy = TakeDirty( buf.dirty, rng );
+        if( toCopy.empty() )
+        {
+            return {};
+        }
 
-            vkCmdCopyBuffer( cmd, buf.staging.GetBuffer(), buf.deviceLocal->GetBuffer(), 1, &info );
+        auto regions = std::vector< VkBufferCopy >{};
+        regions.reserve( toCopy.size() );
 
-            return Temp{
-                .buf    = buf.deviceLocal->GetBuffer(),
-                .offset = info.dstOffset,
-                .size   = info.size,
-            };
+        for( const CopyRange& d : toCopy )
+        {
+            assert( int64_t{ d.first() } - int64_t{ stagingOffsetElem } >= 0 );
+
+            regions.push_back( VkBufferCopy{
+                .srcOffset = ( d.first() - stagingOffsetElem ) * sizeof( T ),
+                .dstOffset = d.first() * sizeof( T ),
+                .size      = d.count() * sizeof( T ),
+            } );
         }
-        return {};
+
+        // if written in place, host writes are visible to the device on submit
+        if( !buf.direct )
+        {
+            vkCmdCopyBuffer( cmd,
+                             buf.staging.GetBuffer(),
+                             buf.deviceLocal->GetBuffer(),
+                             uint32_t( regions.size() ),
+                             regions.data() );
+        }
+
+        // sorted, so one barrier covers all
+        return Temp{
+            .buf    = buf.deviceLocal->GetBuffer(),
+            .offset = regions.front().dstOffset,
+            .size   = regions.back().dstOffset + regions.back().size - regions.front().dstOffset,
+        };
     };
 
     auto barriers     = std::array< VkBufferMemoryBarrier2, 5 >{};
@@ -443,7 +855,10 @@ bool RTGL1::VertexCollector::CopyFromStaging( VkCommandBuffer cmd, const CopyRan
 
     afterBuild.barriers_count = 0;
 
-    if( auto c = copyFromStaging( cmd, bufVertices, stagingOffset.vertex, ranges.vertices ) )
+    if( auto c = bufVerticesQuantized.IsInitialized()
+                     ? copyFromStaging(
+                           cmd, bufVerticesQuantized, stagingOffset.vertex, ranges.vertices )
+                     : copyFromStaging( cmd, bufVertices, stagingOffset.vertex, ranges.vertices ) )
     {
         barriers[ barrierCount++ ] = VkBufferMemoryBarrier2{
             .sType         = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
@@ -539,7 +954,7 @@ bool RTGL1::VertexCollector::CopyFromStaging( VkCommandBuffer cmd, const CopyRan
         }
     }
 
-    if( barrierCount > 0 )
+    if( barrierCount > 0 && !directWrite )
     {
         auto dep = VkDependencyInfo{
             .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
@@ -555,7 +970,14 @@ bool RTGL1::VertexCollector::CopyFromStaging( VkCommandBuffer cmd, const CopyRan
 
 VkBuffer RTGL1::VertexCollector::GetVertexBuffer() const
 {
-    return bufVertices.deviceLocal->GetBuffer();
+    return bufVerticesQuantized.IsInitialized() ? bufVerticesQuantized.deviceLocal->GetBuffer()
+                                                : bufVertices.deviceLocal->GetBuffer();
+}
+
+size_t RTGL1::VertexCollector::GetVertexCapacity() const
+{
+    return bufVerticesQuantized.IsInitialized() ? bufVerticesQuantized.ElementCount()
+                                                : bufVertices.ElementCount();
 }
 
 VkBuffer RTGL1::VertexCollector::GetTexcoordBuffer_Layer1() const
@@ -625,3 +1047,10 @@ uint32_t RTGL1::VertexCollector::GetCurrentIndexCount() const
 {
     return count.index;
 }
+
+uint32_t RTGL1::VertexCollector::GetRequiredVertexCapacity() const
+{
+    // index buffer is allocated with 3 indices per vertex
+    return std::max( count.vertex + overflow.vertex,
+                     ( count.index + overflow.index + 2 ) / 3 );
+}
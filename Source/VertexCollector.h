@@ -36,6 +36,7 @@ namespace RTGL1
 {
 
 struct ShVertex;
+struct ShVertexQuantized;
 
 class GeomInfoManager;
 
@@ -43,12 +44,17 @@ class GeomInfoManager;
 class VertexCollector
 {
 public:
+    // If 'quantizeVertices', vertices are stored as ShVertexQuantized.
+    // If 'directWrite', there's no staging: device-local buffers are host-visible (Resizable BAR)
+    // and written in place, so they must not be shared with a collector of another frame
     explicit VertexCollector( VkDevice         device,
                               MemoryAllocator& allocator,
                               const size_t ( &maxVertsPerLayer )[ 4 ],
                               const size_t     maxIndices,
                               bool             isDynamic,
-                              std::string_view debugName );
+                              std::string_view debugName,
+                              bool             quantizeVertices = false,
+                              bool             directWrite      = false );
 
     // Create new vertex collector, but with shared device local buffers
     explicit VertexCollector( const VertexCollector& src,
@@ -104,6 +110,13 @@ public:
     void DeleteStaging();
 
 
+    // Local position = center + extent * (snorm position in BLAS)
+    struct Dequantization
+    {
+        RgFloat3D center;
+        RgFloat3D extent;
+    };
+
     struct UploadResult
     {
         VkAccelerationStructureGeometryKHR       asGeometryInfo;
@@ -113,13 +126,62 @@ public:
         uint32_t                                 firstVertex_Layer1;
         uint32_t                                 firstVertex_Layer2;
         uint32_t                                 firstVertex_Layer3;
+        // if vertices are quantized, BLAS must be placed by this transform
+        std::optional< Dequantization >          dequant;
     };
 
-    auto Upload( VertexCollectorFilterTypeFlags geomFlags, const RgMeshPrimitiveInfo& prim )
+    // If 'verticesOnDevice', only the space for vertices is allocated,
+    // they're written on GPU before the BLAS build, e.g. by skinning
+    auto Upload( VertexCollectorFilterTypeFlags geomFlags,
+                 const RgMeshPrimitiveInfo&     prim,
+                 bool                           verticesOnDevice = false )
         -> std::optional< UploadResult >;
 
+    // Reserve vertices right in the staging buffer, to be filled by the caller in place.
+    // Upload of a primitive that points to them doesn't copy the vertices.
+    // Valid until the next Reset
+    RgPrimitiveVertex* ReserveStagingVertices( uint32_t vertexCount );
+    // If primitive's vertices were reserved by ReserveStagingVertices, return their index
+    auto FindStagingVertexIndex( const RgMeshPrimitiveInfo& prim ) const
+        -> std::optional< uint32_t >;
+
+    // While alive, copies to staging on this thread are only recorded, and done on
+    // destruction, so they can overlap with other threads, after Upload-s are ordered.
+    // Source data must be valid until then
+    class DeferredStagingCopies
+    {
+    public:
+        DeferredStagingCopies();
+        ~DeferredStagingCopies();
+
+        DeferredStagingCopies( const DeferredStagingCopies& other )                = delete;
+        DeferredStagingCopies( DeferredStagingCopies&& other ) noexcept            = delete;
+        DeferredStagingCopies& operator=( const DeferredStagingCopies& other )     = delete;
+        DeferredStagingCopies& operator=( DeferredStagingCopies&& other ) noexcept = delete;
+
+        // Copy the recorded ones now, if the source data is temporary
+        static void FlushCurrent();
+
+    private:
+        void Flush();
+
+        struct Copy
+        {
+            void*       dst;
+            const void* src;
+            size_t      size;
+        };
+        std::vector< Copy >    copies;
+        DeferredStagingCopies* prev;
+
+        friend class VertexCollector;
+    };
+
 
     void Reset( const CopyRanges* rangeToPreserve );
+    // Same as Reset, but the prefix might have been written through another collector
+    // with the same device-local buffers, so it can be larger than the current ranges
+    void ResetToPrefix( const CopyRanges& prefix );
 
 
     CopyRanges GetCurrentRanges() const;
@@ -130,6 +192,9 @@ public:
     VkBuffer   GetIndexBuffer() const;
     uint32_t   GetCurrentVertexCount() const;
     uint32_t   GetCurrentIndexCount() const;
+    // Capacity that would be enough for all uploads since the last Reset,
+    // including the ones that were rejected because of the limits
+    uint32_t   GetRequiredVertexCapacity() const;
 
 
     // begin=0: Make sure that copying was done
@@ -137,15 +202,25 @@ public:
     void InsertVertexPreprocessBarrier( VkCommandBuffer cmd, bool begin );
 
 private:
-    void CopyDataToStaging( const RgMeshPrimitiveInfo& info,
-                            uint32_t                   vertIndex,
-                            std::optional< uint32_t >  indIndex,
-                            uint32_t                   texcIndex_1,
-                            uint32_t                   texcIndex_2,
-                            uint32_t                   texcIndex_3 );
+    static void CopyToStaging( void* dst, const void* src, size_t size );
+    void        CopyDataToStaging( const RgMeshPrimitiveInfo&             info,
+                                    uint32_t                               vertIndex,
+                                    std::optional< uint32_t >              indIndex,
+                                    uint32_t                               texcIndex_1,
+                                    uint32_t                               texcIndex_2,
+                                    uint32_t                               texcIndex_3,
+                                    const std::optional< Dequantization >& dequant,
+                                    bool                                   copyVertices );
+    void        QuantizeToStaging( const RgMeshPrimitiveInfo& info,
+                                   uint32_t                   vertIndex,
+                                   const Dequantization&      dequant );
+    size_t      GetVertexCapacity() const;
+    // forget written data that was not copied by CopyFromStaging
+    void        ClearDirty();
 
 private:
     VkDevice device;
+    bool     directWrite;
 
 
     template< typename T >
@@ -160,7 +235,7 @@ private:
     public:
         void InitStaging( MemoryAllocator& allocator )
         {
-            if( !staging.IsInitted() )
+            if( !direct && !staging.IsInitted() )
             {
                 if( deviceLocal && deviceLocal->GetSize() > 0 )
                 {
@@ -178,6 +253,10 @@ private:
 
         void DestroyStaging()
         {
+            if( direct )
+            {
+                return;
+            }
             if( mapped )
             {
                 staging.TryUnmap();
@@ -189,7 +268,8 @@ private:
         explicit SharedDeviceLocal( MemoryAllocator&   allocator,
                                     size_t             maxElements,
                                     VkBufferUsageFlags usage,
-                                    std::string_view   name )
+                                    std::string_view   name,
+                                    bool               directWrite )
             : debugName{ name }
         {
             if( maxElements > 0 )
@@ -198,8 +278,17 @@ private:
                 deviceLocal->Init( allocator,
                                    sizeof( T ) * maxElements,
                                    usage,
-                                   VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                   directWrite ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT |
+                                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                                     VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+                                               : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                                    MakeName( debugName, false ).c_str() );
+
+                if( directWrite )
+                {
+                    direct = true;
+                    mapped = static_cast< T* >( deviceLocal->Map() );
+                }
             }
         }
 
@@ -208,6 +297,8 @@ private:
                                     std::string_view         name )
             : deviceLocal{ other.deviceLocal }, debugName{ name }
         {
+            // in-place writes would race with the other frame
+            assert( !other.direct );
         }
 
         [[nodiscard]] bool IsInitialized() const { return deviceLocal != nullptr; }
@@ -218,7 +309,15 @@ private:
             return deviceLocal->GetSize() / sizeof( T );
         }
 
-        ~SharedDeviceLocal() { DestroyStaging(); }
+        ~SharedDeviceLocal()
+        {
+            DestroyStaging();
+            if( direct && mapped )
+            {
+                deviceLocal->TryUnmap();
+                mapped = nullptr;
+            }
+        }
 
         SharedDeviceLocal( const SharedDeviceLocal& )                = delete;
         SharedDeviceLocal( SharedDeviceLocal&& ) noexcept            = delete;
@@ -227,12 +326,18 @@ private:
 
         std::shared_ptr< Buffer > deviceLocal{};
         Buffer                    staging{};
+        // points to staging, or to device local, if 'direct'
         T*                        mapped{ nullptr };
+        bool                      direct{ false };
         std::string               debugName{};
+        // element ranges written to staging, but not yet copied to device local
+        std::vector< CopyRange >  dirty{};
     };
 
 
-    SharedDeviceLocal< ShVertex >  bufVertices;
+    // only one of them is initialized
+    SharedDeviceLocal< ShVertex >          bufVertices;
+    SharedDeviceLocal< ShVertexQuantized > bufVerticesQuantized;
     SharedDeviceLocal< uint32_t >  bufIndices;
     SharedDeviceLocal< RgFloat2D > bufTexcoordLayer1;
     SharedDeviceLocal< RgFloat2D > bufTexcoordLayer2;
@@ -253,6 +358,9 @@ private:
     // so need to copy from staging to device local considering offsets
     Count stagingOffset{};
 
+    // what didn't fit into the buffers since the last Reset
+    Count overflow{};
+
     // we can't have both in one barrier, so delay:
     // VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
     // VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT
@@ -24,84 +24,259 @@
 #include "Generated/ShaderCommonC.h"
 #include "CmdLabel.h"
 
-RTGL1::VertexPreprocessing::VertexPreprocessing( VkDevice             _device,
-                                                 const GlobalUniform& _uniform,
-                                                 const ASManager&     _asManager,
-                                                 const ShaderManager& _shaderManager )
+namespace
+{
+
+// must be same as in CmVertexPreprocess.comp
+struct VertPreprocPush
+{
+    uint32_t itemCount;
+    uint32_t triangleCount;
+};
+
+// threads loop over the flat triangle range, if it's larger
+constexpr uint32_t VERT_PREPROC_MAX_GROUP_COUNT = 65535;
+
+}
+
+RTGL1::VertexPreprocessing::VertexPreprocessing( VkDevice                            _device,
+                                                 std::shared_ptr< MemoryAllocator >& _allocator,
+                                                 const GlobalUniform&                _uniform,
+                                                 const ASManager&                    _asManager,
+                                                 const ShaderManager& _shaderManager,
+                                                 uint32_t             _maxItemCount )
     : device( _device )
+    , maxItemCount( _maxItemCount )
+    , descPool( VK_NULL_HANDLE )
+    , descSetLayout( VK_NULL_HANDLE )
+    , descSet( VK_NULL_HANDLE )
+    , pipelineLayout( VK_NULL_HANDLE )
+    , pipeline( VK_NULL_HANDLE )
 {
+    items = std::make_unique< AutoBuffer >( _allocator );
+    items->Create( VkDeviceSize{ maxItemCount } * sizeof( ShVertPreprocItem ),
+                   VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                   "Vertex preprocessing items" );
+
+    CreateDescriptors();
+
     VkDescriptorSetLayout setLayouts[] = {
         _uniform.GetDescSetLayout(),
         _asManager.GetBuffersDescSetLayout(),
+        descSetLayout,
     };
 
     CreatePipelineLayout( setLayouts, std::size( setLayouts ) );
-    CreatePipelines( &_shaderManager );
+    CreatePipeline( &_shaderManager );
 }
 
 RTGL1::VertexPreprocessing::~VertexPreprocessing()
 {
     vkDestroyPipelineLayout( device, pipelineLayout, nullptr );
-    DestroyPipelines();
+    DestroyPipeline();
+    vkDestroyDescriptorPool( device, descPool, nullptr );
+    vkDestroyDescriptorSetLayout( device, descSetLayout, nullptr );
 }
 
-void RTGL1::VertexPreprocessing::Preprocess( VkCommandBuffer      cmd,
-                                             uint32_t             frameIndex,
-                                             uint32_t             preprocMode,
-                                             const GlobalUniform& uniform,
-                                             ASManager&           asManager,
-                                             uint32_t             tlasInstanceCount )
+void RTGL1::VertexPreprocessing::Preprocess(
+    VkCommandBuffer                                         cmd,
+    uint32_t                                                frameIndex,
+    uint32_t                                                preprocMode,
+    const GlobalUniform&                                    uniform,
+    ASManager&                                              asManager,
+    std::span< const GeomInfoManager::PreprocessCandidate > candidates )
 {
     CmdLabel label( cmd, "Vertex preprocessing" );
 
 
+    // compact, so GPU time depends on the triangle count, and not on the instance count
+    uint32_t itemCount     = 0;
+    uint32_t triangleCount = 0;
+    {
+        auto* dst = items->GetMappedAs< ShVertPreprocItem* >( frameIndex );
+
+        for( const auto& c : candidates )
+        {
+            if( preprocMode == VERT_PREPROC_MODE_ONLY_DYNAMIC && !c.isDynamic )
+            {
+                continue;
+            }
+
+            assert( itemCount < maxItemCount );
+            dst[ itemCount ] = ShVertPreprocItem{
+                .tlasInstanceIndex = c.tlasInstanceID,
+                .firstTriangle     = triangleCount,
+            };
+
+            itemCount++;
+            triangleCount += c.triangleCount;
+        }
+    }
+
+    if( itemCount > 0 )
+    {
+        // items might still be read by the previous frame
+        VkMemoryBarrier barrier = {
+            .sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = 0,
+            .dstAccessMask = 0,
+        };
+
+        vkCmdPipelineBarrier( cmd,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT,
+                              0,
+                              1,
+                              &barrier,
+                              0,
+                              nullptr,
+                              0,
+                              nullptr );
+
+        items->CopyFromStaging( cmd, frameIndex, itemCount * sizeof( ShVertPreprocItem ) );
+    }
+
+
+    // barriers are needed even if nothing is processed, as they sync the vertex data copy
     asManager.OnVertexPreprocessingBegin(
         cmd, frameIndex, preprocMode == VERT_PREPROC_MODE_ONLY_DYNAMIC );
 
+    if( itemCount > 0 )
+    {
+        vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline );
+
+        VkDescriptorSet sets[] = {
+            uniform.GetDescSet( frameIndex ),
+            asManager.GetBuffersDescSet( frameIndex ),
+            descSet,
+        };
+
+        vkCmdBindDescriptorSets( cmd,
+                                 VK_PIPELINE_BIND_POINT_COMPUTE,
+                                 pipelineLayout,
+                                 0,
+                                 std::size( sets ),
+                                 sets,
+                                 0,
+                                 nullptr );
+
+        const VertPreprocPush push = {
+            .itemCount     = itemCount,
+            .triangleCount = triangleCount,
+        };
+
+        vkCmdPushConstants(
+            cmd, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof( push ), &push );
+
+        const uint32_t groupCount =
+            Utils::GetWorkGroupCount( triangleCount, COMPUTE_VERT_PREPROC_GROUP_SIZE_X );
+
+        vkCmdDispatch( cmd, std::min( groupCount, VERT_PREPROC_MAX_GROUP_COUNT ), 1, 1 );
+    }
 
-    VkPipeline pl = preprocMode == VERT_PREPROC_MODE_ALL ? pipelineAll
-                    : preprocMode == VERT_PREPROC_MODE_DYNAMIC_AND_MOVABLE
-                        ? pipelineDynamicAndMovable
-                        : pipelineOnlyDynamic;
+    asManager.OnVertexPreprocessingFinish(
+        cmd, frameIndex, preprocMode == VERT_PREPROC_MODE_ONLY_DYNAMIC );
+}
 
-    vkCmdBindPipeline( cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pl );
+void RTGL1::VertexPreprocessing::OnShaderReload( const ShaderManager* shaderManager )
+{
+    if( !shaderManager->AnyChanged( { "CVertexPreprocess" } ) )
+    {
+        return;
+    }
+
+    DestroyPipeline();
+    CreatePipeline( shaderManager );
+}
 
+void RTGL1::VertexPreprocessing::CreateDescriptors()
+{
+    VkResult r;
 
-    VkDescriptorSet sets[] = {
-        uniform.GetDescSet( frameIndex ),
-        asManager.GetBuffersDescSet( frameIndex ),
+    VkDescriptorSetLayoutBinding binding = {
+        .binding         = BINDING_VERT_PREPROC_ITEMS,
+        .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags      = VK_SHADER_STAGE_COMPUTE_BIT,
     };
 
-    vkCmdBindDescriptorSets( cmd,
-                             VK_PIPELINE_BIND_POINT_COMPUTE,
-                             pipelineLayout,
-                             0,
-                             std::size( sets ),
-                             sets,
-                             0,
-                             nullptr );
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {
+        .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindings    = &binding,
+    };
 
+    r = vkCreateDescriptorSetLayout( device, &layoutInfo, nullptr, &descSetLayout );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME( device,
+                    descSetLayout,
+                    VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+                    "Vertex preprocessing Desc set layout" );
 
-    vkCmdDispatch( cmd, tlasInstanceCount, 1, 1 );
+    VkDescriptorPoolSize poolSize = {
+        .type            = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+    };
 
+    VkDescriptorPoolCreateInfo poolInfo = {
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets       = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes    = &poolSize,
+    };
 
-    asManager.OnVertexPreprocessingFinish(
-        cmd, frameIndex, preprocMode == VERT_PREPROC_MODE_ONLY_DYNAMIC );
-}
+    r = vkCreateDescriptorPool( device, &poolInfo, nullptr, &descPool );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME(
+        device, descPool, VK_OBJECT_TYPE_DESCRIPTOR_POOL, "Vertex preprocessing Desc pool" );
+
+    VkDescriptorSetAllocateInfo allocInfo = {
+        .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool     = descPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts        = &descSetLayout,
+    };
 
-void RTGL1::VertexPreprocessing::OnShaderReload( const ShaderManager* shaderManager )
-{
-    DestroyPipelines();
-    CreatePipelines( shaderManager );
+    r = vkAllocateDescriptorSets( device, &allocInfo, &descSet );
+    VK_CHECKERROR( r );
+    SET_DEBUG_NAME(
+        device, descSet, VK_OBJECT_TYPE_DESCRIPTOR_SET, "Vertex preprocessing Desc set" );
+
+
+    VkDescriptorBufferInfo buf = {
+        .buffer = items->GetDeviceLocal(),
+        .offset = 0,
+        .range  = VK_WHOLE_SIZE,
+    };
+
+    VkWriteDescriptorSet wrt = {
+        .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet          = descSet,
+        .dstBinding      = BINDING_VERT_PREPROC_ITEMS,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo     = &buf,
+    };
+
+    vkUpdateDescriptorSets( device, 1, &wrt, 0, nullptr );
 }
 
 void RTGL1::VertexPreprocessing::CreatePipelineLayout( const VkDescriptorSetLayout* pSetLayouts,
                                                        uint32_t                     setLayoutCount )
 {
+    VkPushConstantRange push = {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset     = 0,
+        .size       = sizeof( VertPreprocPush ),
+    };
+
     VkPipelineLayoutCreateInfo plLayoutInfo = {
-        .sType          = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = setLayoutCount,
-        .pSetLayouts    = pSetLayouts,
+        .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount         = setLayoutCount,
+        .pSetLayouts            = pSetLayouts,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &push,
     };
 
     VkResult r = vkCreatePipelineLayout( device, &plLayoutInfo, nullptr, &pipelineLayout );
@@ -113,78 +288,23 @@ void RTGL1::VertexPreprocessing::CreatePipelineLayout( const VkDescriptorSetLayo
                     "Vertex preprocessing pipeline layout" );
 }
 
-void RTGL1::VertexPreprocessing::CreatePipelines( const ShaderManager* shaderManager )
+void RTGL1::VertexPreprocessing::CreatePipeline( const ShaderManager* shaderManager )
 {
-    VkResult r;
-
-    uint32_t specInfoDataOnlyDynamic = 0;
-
-    VkSpecializationMapEntry specEntry = {
-        .constantID = 0,
-        .offset     = 0,
-        .size       = sizeof( uint32_t ),
-    };
-
-    VkSpecializationInfo specInfo = {
-        .mapEntryCount = 1,
-        .pMapEntries   = &specEntry,
-        .dataSize      = sizeof( uint32_t ),
-        .pData         = &specInfoDataOnlyDynamic,
-    };
-
     VkComputePipelineCreateInfo plInfo = {
         .sType  = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
         .stage  = shaderManager->GetStageInfo( "CVertexPreprocess" ),
         .layout = pipelineLayout,
     };
-    plInfo.stage.pSpecializationInfo = &specInfo;
-
-    {
-        specInfoDataOnlyDynamic = VERT_PREPROC_MODE_ONLY_DYNAMIC;
-
-        r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &pipelineOnlyDynamic );
-        VK_CHECKERROR( r );
-
-        SET_DEBUG_NAME( device,
-                        pipelineOnlyDynamic,
-                        VK_OBJECT_TYPE_PIPELINE,
-                        "Vertex only dynamic preprocessing pipeline" );
-    }
-
-    {
-        specInfoDataOnlyDynamic = VERT_PREPROC_MODE_DYNAMIC_AND_MOVABLE;
-
-        r = vkCreateComputePipelines(
-            device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &pipelineDynamicAndMovable );
-        VK_CHECKERROR( r );
 
-        SET_DEBUG_NAME( device,
-                        pipelineDynamicAndMovable,
-                        VK_OBJECT_TYPE_PIPELINE,
-                        "Vertex movable/dynamic preprocessing pipeline" );
-    }
-
-    {
-        specInfoDataOnlyDynamic = VERT_PREPROC_MODE_ALL;
-
-        r = vkCreateComputePipelines( device, VK_NULL_HANDLE, 1, &plInfo, nullptr, &pipelineAll );
-        VK_CHECKERROR( r );
+    VkResult r = vkCreateComputePipelines(
+        device, shaderManager->GetPipelineCache(), 1, &plInfo, nullptr, &pipeline );
+    VK_CHECKERROR( r );
 
-        SET_DEBUG_NAME( device,
-                        pipelineAll,
-                        VK_OBJECT_TYPE_PIPELINE,
-                        "Vertex static/movable/dynamic preprocessing pipeline" );
-    }
+    SET_DEBUG_NAME( device, pipeline, VK_OBJECT_TYPE_PIPELINE, "Vertex preprocessing pipeline" );
 }
 
-void RTGL1::VertexPreprocessing::DestroyPipelines()
+void RTGL1::VertexPreprocessing::DestroyPipeline()
 {
-    vkDestroyPipeline( device, pipelineOnlyDynamic, nullptr );
-    vkDestroyPipeline( device, pipelineDynamicAndMovable, nullptr );
-    vkDestroyPipeline( device, pipelineAll, nullptr );
-
-    pipelineOnlyDynamic       = VK_NULL_HANDLE;
-    pipelineDynamicAndMovable = VK_NULL_HANDLE;
-    pipelineAll               = VK_NULL_HANDLE;
+    vkDestroyPipeline( device, pipeline, nullptr );
+    pipeline = VK_NULL_HANDLE;
 }
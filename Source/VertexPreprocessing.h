@@ -22,6 +22,8 @@
 
 #include "Common.h"
 #include "ASManager.h"
+#include "AutoBuffer.h"
+#include "GeomInfoManager.h"
 #include "GlobalUniform.h"
 #include "ShaderManager.h"
 
@@ -31,10 +33,12 @@ namespace RTGL1
 class VertexPreprocessing : public IShaderDependency
 {
 public:
-    VertexPreprocessing( VkDevice             device,
-                         const GlobalUniform& uniform,
-                         const ASManager&     asManager,
-                         const ShaderManager& shaderManager );
+    VertexPreprocessing( VkDevice                            device,
+                         std::shared_ptr< MemoryAllocator >& allocator,
+                         const GlobalUniform&                uniform,
+                         const ASManager&                    asManager,
+                         const ShaderManager&                shaderManager,
+                         uint32_t                            maxItemCount );
 
     ~VertexPreprocessing() override;
 
@@ -43,26 +47,36 @@ public:
     VertexPreprocessing& operator=( const VertexPreprocessing& other )     = delete;
     VertexPreprocessing& operator=( VertexPreprocessing&& other ) noexcept = delete;
 
-    void Preprocess( VkCommandBuffer      cmd,
-                     uint32_t             frameIndex,
-                     uint32_t             preprocMode,
-                     const GlobalUniform& uniform,
-                     ASManager&           asManager,
-                     uint32_t             tlasInstanceCount );
+    // Only the triangles of 'candidates' that correspond to 'preprocMode' are processed,
+    // one thread per triangle
+    void Preprocess( VkCommandBuffer                                         cmd,
+                     uint32_t                                                frameIndex,
+                     uint32_t                                                preprocMode,
+                     const GlobalUniform&                                    uniform,
+                     ASManager&                                              asManager,
+                     std::span< const GeomInfoManager::PreprocessCandidate > candidates );
 
     void OnShaderReload( const ShaderManager* shaderManager ) override;
 
 private:
+    void CreateDescriptors();
     void CreatePipelineLayout( const VkDescriptorSetLayout* pSetLayouts, uint32_t setLayoutCount );
-    void CreatePipelines( const ShaderManager* shaderManager );
-    void DestroyPipelines();
+    void CreatePipeline( const ShaderManager* shaderManager );
+    void DestroyPipeline();
 
 private:
-    VkDevice         device;
+    VkDevice device;
+
+    // compacted list of the geometries to process, with their first triangle in a flat range
+    std::unique_ptr< AutoBuffer > items;
+    uint32_t                      maxItemCount;
+
+    VkDescriptorPool      descPool;
+    VkDescriptorSetLayout descSetLayout;
+    VkDescriptorSet       descSet;
+
     VkPipelineLayout pipelineLayout;
-    VkPipeline       pipelineOnlyDynamic;
-    VkPipeline       pipelineDynamicAndMovable;
-    VkPipeline       pipelineAll;
+    VkPipeline       pipeline;
 };
 
 }
@@ -62,6 +62,12 @@ RTGL1::Volumetric::~Volumetric()
         vkDestroyImageView( device, i.view, nullptr );
         MemoryAllocator::FreeDedicated( device, i.memory );
     }
+    for( auto i : scatteringRaw )
+    {
+        vkDestroyImage( device, i.image, nullptr );
+        vkDestroyImageView( device, i.view, nullptr );
+        MemoryAllocator::FreeDedicated( device, i.memory );
+    }
 #if ILLUMINATION_VOLUME
     vkDestroyImage( device, illumination.image, nullptr );
     vkDestroyImageView( device, illumination.view, nullptr );
@@ -83,29 +89,51 @@ void RTGL1::Volumetric::ProcessScattering( VkCommandBuffer      cmd,
 
     // sync
     {
-        VkImageMemoryBarrier2 b = {
-            .sType        = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
-            .pNext        = nullptr,
-            .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
-                            VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
-            .srcAccessMask       = VK_ACCESS_2_SHADER_WRITE_BIT,
-            .dstStageMask        = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
-            .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT,
-            .oldLayout           = VK_IMAGE_LAYOUT_GENERAL,
-            .newLayout           = VK_IMAGE_LAYOUT_GENERAL,
-            .srcQueueFamilyIndex = 0,
-            .dstQueueFamilyIndex = 0,
-            .image               = scattering[ frameIndex ].image,
-            .subresourceRange    = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-                                     .baseMipLevel   = 0,
-                                     .levelCount     = 1,
-                                     .baseArrayLayer = 0,
-                                     .layerCount     = 1 },
+        VkImageMemoryBarrier2 bs[] = {
+            {
+                .sType        = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .pNext        = nullptr,
+                .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+                                VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+                .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+                .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR,
+                .dstAccessMask = VK_ACCESS_2_SHADER_READ_BIT_KHR | VK_ACCESS_2_SHADER_WRITE_BIT,
+                .oldLayout     = VK_IMAGE_LAYOUT_GENERAL,
+                .newLayout     = VK_IMAGE_LAYOUT_GENERAL,
+                .srcQueueFamilyIndex = 0,
+                .dstQueueFamilyIndex = 0,
+                .image               = scattering[ frameIndex ].image,
+                .subresourceRange    = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                                         .baseMipLevel   = 0,
+                                         .levelCount     = 1,
+                                         .baseArrayLayer = 0,
+                                         .layerCount     = 1 },
+            },
+            {
+                // raw is also read in the next frame's ray tracing for reprojection
+                .sType        = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .pNext        = nullptr,
+                .srcStageMask = VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+                .srcAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT,
+                .dstStageMask  = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR |
+                                VK_PIPELINE_STAGE_2_RAY_TRACING_SHADER_BIT_KHR,
+                .dstAccessMask       = VK_ACCESS_2_SHADER_READ_BIT_KHR,
+                .oldLayout           = VK_IMAGE_LAYOUT_GENERAL,
+                .newLayout           = VK_IMAGE_LAYOUT_GENERAL,
+                .srcQueueFamilyIndex = 0,
+                .dstQueueFamilyIndex = 0,
+                .image               = scatteringRaw[ frameIndex ].image,
+                .subresourceRange    = { .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+                                         .baseMipLevel   = 0,
+                                         .levelCount     = 1,
+                                         .baseArrayLayer = 0,
+                                         .layerCount     = 1 },
+            },
         };
         VkDependencyInfoKHR info = {
             .sType                   = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR,
-            .imageMemoryBarrierCount = 1,
-            .pImageMemoryBarriers    = &b,
+            .imageMemoryBarrierCount = std::size( bs ),
+            .pImageMemoryBarriers    = bs,
         };
         svkCmdPipelineBarrier2KHR( cmd, &info );
     }
@@ -128,11 +156,12 @@ void RTGL1::Volumetric::ProcessScattering( VkCommandBuffer      cmd,
                                  0,
                                  nullptr );
 
-        vkCmdDispatch(
-            cmd,
-            Utils::GetWorkGroupCountT( VOLUMETRIC_SIZE_X, COMPUTE_VOLUMETRIC_GROUP_SIZE_X ),
-            Utils::GetWorkGroupCountT( VOLUMETRIC_SIZE_Y, COMPUTE_VOLUMETRIC_GROUP_SIZE_Y ),
-            1 );
+        vkCmdDispatch( cmd,
+                       Utils::GetWorkGroupCount( uniform.GetData()->volumeSizeX,
+                                                 COMPUTE_VOLUMETRIC_GROUP_SIZE_X ),
+                       Utils::GetWorkGroupCount( uniform.GetData()->volumeSizeY,
+                                                 COMPUTE_VOLUMETRIC_GROUP_SIZE_Y ),
+                       1 );
     }
 
     // sync to read scattering 3D image for screen space accum / rasterized world geometry
@@ -234,6 +263,11 @@ void RTGL1::Volumetric::BarrierToReadIllumination( VkCommandBuffer cmd )
 
 void RTGL1::Volumetric::OnShaderReload( const ShaderManager* shaderManager )
 {
+    if( !shaderManager->AnyChanged( { "CVolumetricProcess", "ScatterAccum" } ) )
+    {
+        return;
+    }
+
     DestroyPipelines();
     CreatePipelines( *shaderManager );
 }
@@ -264,11 +298,15 @@ void RTGL1::Volumetric::CreateSampler()
 
 void RTGL1::Volumetric::CreateImages( CommandBufferManager& cmdManager, MemoryAllocator& allocator )
 {
+    auto memoryScope = MemoryCategoryScope{ RG_UTIL_MEMORY_CATEGORY_VOLUMETRIC };
+
     VkCommandBuffer cmd = cmdManager.StartGraphicsCmd();
 
     std::tuple< VolumeDef*, VkFormat, const char* > all[] = {
         { &scattering[ 0 ], SCATTERING_VOLUME_FORMAT, "Scattering Volume" },
         { &scattering[ 1 ], SCATTERING_VOLUME_FORMAT, "Scattering Volume" },
+        { &scatteringRaw[ 0 ], SCATTERING_VOLUME_FORMAT, "Scattering Volume Raw" },
+        { &scatteringRaw[ 1 ], SCATTERING_VOLUME_FORMAT, "Scattering Volume Raw" },
 #if ILLUMINATION_VOLUME
         { &illumination, ILLUMINATION_VOLUME_FORMAT, "Illumination Volume" },
 #endif
@@ -366,6 +404,18 @@ void RTGL1::Volumetric::CreateDescriptors()
             .stageFlags      = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT |
                           VK_SHADER_STAGE_FRAGMENT_BIT,
         },
+        {
+            .binding         = BINDING_VOLUMETRIC_RAW_STORAGE,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT,
+        },
+        {
+            .binding         = BINDING_VOLUMETRIC_RAW_SAMPLER_PREV,
+            .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+            .descriptorCount = 1,
+            .stageFlags      = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_COMPUTE_BIT,
+        },
 #if ILLUMINATION_VOLUME
         {
             .binding         = BINDING_VOLUMETRIC_ILLUMINATION,
@@ -463,7 +513,18 @@ void RTGL1::Volumetric::UpdateDescriptors()
             {
                 .sampler = volumeSampler,
                 .imageView =
-                    scattering[ Utils::GetPreviousByModulo( i, MAX_FRAMES_IN_FLIGHT ) ].view,
+                    scattering[ Utils::GetPreviousByModulo( i, FramesInFlight() ) ].view,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            },
+            {
+                .sampler     = VK_NULL_HANDLE,
+                .imageView   = scatteringRaw[ i ].view,
+                .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+            },
+            {
+                .sampler = volumeSampler,
+                .imageView =
+                    scatteringRaw[ Utils::GetPreviousByModulo( i, FramesInFlight() ) ].view,
                 .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
             },
 #if ILLUMINATION_VOLUME
@@ -508,6 +569,24 @@ void RTGL1::Volumetric::UpdateDescriptors()
                 .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
                 .pImageInfo      = &imgs[ 2 ],
             },
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = descSets[ i ],
+                .dstBinding      = BINDING_VOLUMETRIC_RAW_STORAGE,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+                .pImageInfo      = &imgs[ 3 ],
+            },
+            {
+                .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                .dstSet          = descSets[ i ],
+                .dstBinding      = BINDING_VOLUMETRIC_RAW_SAMPLER_PREV,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+                .pImageInfo      = &imgs[ 4 ],
+            },
 #if ILLUMINATION_VOLUME
             {
                 .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -516,7 +595,7 @@ void RTGL1::Volumetric::UpdateDescriptors()
                 .dstArrayElement = 0,
                 .descriptorCount = 1,
                 .descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                .pImageInfo      = &imgs[ 3 ],
+                .pImageInfo      = &imgs[ 5 ],
             },
             {
                 .sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
@@ -525,7 +604,7 @@ void RTGL1::Volumetric::UpdateDescriptors()
                 .dstArrayElement = 0,
                 .descriptorCount = 1,
                 .descriptorType  = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                .pImageInfo      = &imgs[ 4 ],
+                .pImageInfo      = &imgs[ 6 ],
             },
 #endif
         };
@@ -621,8 +700,12 @@ void RTGL1::Volumetric::CreatePipelines( const ShaderManager& shaderManager )
             .layout = processPipelineLayout,
         };
 
-        VkResult r =
-            vkCreateComputePipelines( device, VK_NULL_HANDLE, 1, &info, nullptr, &processPipeline );
+        VkResult r = vkCreateComputePipelines( device,
+                                               shaderManager.GetPipelineCache(),
+                                               1,
+                                               &info,
+                                               nullptr,
+                                               &processPipeline );
         VK_CHECKERROR( r );
 
         SET_DEBUG_NAME(
@@ -637,8 +720,12 @@ void RTGL1::Volumetric::CreatePipelines( const ShaderManager& shaderManager )
             .layout = accumPipelineLayout,
         };
 
-        VkResult r =
-            vkCreateComputePipelines( device, VK_NULL_HANDLE, 1, &info, nullptr, &accumPipeline );
+        VkResult r = vkCreateComputePipelines( device,
+                                               shaderManager.GetPipelineCache(),
+                                               1,
+                                               &info,
+                                               nullptr,
+                                               &accumPipeline );
         VK_CHECKERROR( r );
 
         SET_DEBUG_NAME(
@@ -84,7 +84,10 @@ private:
         VkDeviceMemory memory{ VK_NULL_HANDLE };
     };
 
+    // accumulated along the view ray
     VolumeDef scattering[ MAX_FRAMES_IN_FLIGHT ]{};
+    // per-froxel, previous one is used for reprojection
+    VolumeDef scatteringRaw[ MAX_FRAMES_IN_FLIGHT ]{};
 #if ILLUMINATION_VOLUME_
     VolumeDef illumination{};
 #endif
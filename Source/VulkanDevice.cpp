@@ -20,7 +20,10 @@
 
 #include "VulkanDevice.h"
 
+#include "CpuProfiler.h"
 #include "HaltonSequence.h"
+#include "HitchRecorder.h"
+#include "LibraryConfig.h"
 #include "Matrix.h"
 #include "RenderResolutionHelper.h"
 #include "RgException.h"
@@ -31,22 +34,26 @@
 #include "Generated/ShaderCommonC.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <d3d12.h>
 #include <d3dx12.h>
+#include <thread>
 
 namespace RTGL1
 {
 namespace
 {
-    SwapchainType MakeSwapchainType( const RgStartFrameRenderResolutionParams& resolution )
+    SwapchainType MakeSwapchainType( const RgStartFrameRenderResolutionParams& resolution,
+                                     bool                                      fsr3Native )
     {
         if( resolution.frameGeneration != RG_FRAME_GENERATION_MODE_OFF )
         {
             switch( resolution.upscaleTechnique )
             {
                 case RG_RENDER_UPSCALE_TECHNIQUE_AMD_FSR2:
-                    return SWAPCHAIN_TYPE_FRAME_GENERATION_FSR3;
+                    return fsr3Native ? SWAPCHAIN_TYPE_VULKAN_NATIVE
+                                      : SWAPCHAIN_TYPE_FRAME_GENERATION_FSR3;
 
                 case RG_RENDER_UPSCALE_TECHNIQUE_NVIDIA_DLSS:
                     return SWAPCHAIN_TYPE_FRAME_GENERATION_DLSS3;
@@ -65,15 +72,29 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
     uint32_t frameIndex = currentFrameState.IncrementFrameIndexAndGet();
     timelineFrame++;
 
-    assert( timelineFrame % dxgi::MAX_FRAMES_IN_FLIGHT_DX12 == frameIndex % MAX_FRAMES_IN_FLIGHT );
+    {
+        RG_CPU_ZONE( "Frame pacing" );
+        framePacer->Wait( swapchain->GetNativeHandle(),
+                          pnext::get< RgStartFrameFramePacingParams >( info ) );
+    }
+
+    // on DXGI, Reflex sleeps in the end of the previous frame
+    {
+        RG_CPU_ZONE( "Latency sleep" );
+        lowLatency->Sleep( swapchain->GetNativeHandle(), info.lowLatency, frameId );
+    }
 
     if( !waitForOutOfFrameFence )
     {
+        RG_CPU_ZONE( "Wait for frame fence" );
+
         // wait for previous cmd with the same frame index
         Utils::WaitAndResetFence( device, frameFences[ frameIndex ] );
     }
     else
     {
+        RG_CPU_ZONE( "Wait for frame fence" );
+
         Utils::WaitAndResetFences(
             device, frameFences[ frameIndex ], outOfFrameFences[ frameIndex ] );
     }
@@ -89,9 +110,17 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
     const auto& resolution = pnext::get< RgStartFrameRenderResolutionParams >( info );
     const auto& fluidInfo  = pnext::get< RgStartFrameFluidParams >( info );
 
-    swapchain->AcquireImage( info.vsync,
+    // if DX12 path is not available or not preferred, FSR3 works on a Vulkan swapchain
+    m_fsr3Native = amdFsr2 && amdFsr3vk && amdFsr3vk->IsAvailable() && !headless &&
+                   resolution.frameGeneration != RG_FRAME_GENERATION_MODE_OFF &&
+                   resolution.upscaleTechnique == RG_RENDER_UPSCALE_TECHNIQUE_AMD_FSR2 &&
+                   ( LibConfig().fsr3native ||
+                     swapchain->FailReason( SWAPCHAIN_TYPE_FRAME_GENERATION_FSR3 ) );
+
+    swapchain->AcquireImage( frameIndex,
+                             info.vsync,
                              info.hdr,
-                             MakeSwapchainType( resolution ),
+                             MakeSwapchainType( resolution, m_fsr3Native ),
                              vkswapchainAvailableSemaphores[ frameIndex ] );
     m_skipGeneratedFrame =
         ( resolution.frameGeneration == RG_FRAME_GENERATION_MODE_WITHOUT_GENERATED );
@@ -112,7 +141,7 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
                 preFrameCmd,
                 {},
                 inFrameSemaphores[ frameIndex ],
-                outOfFrameFences[ ( frameIndex + 1 ) % MAX_FRAMES_IN_FLIGHT ] );
+                outOfFrameFences[ ( frameIndex + 1 ) % FramesInFlight() ] );
 
             // should wait other semaphore in this case
             semaphoreToWaitOnSubmit = inFrameSemaphores[ frameIndex ];
@@ -135,6 +164,17 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
     sceneImportExport->PrepareForFrame( Utils::SafeCstr( info.pMapName ), info.allowMapAutoExport );
 
     {
+        bool newTimings = gpuProfiler->ReadBack( frameIndex );
+        if( newTimings )
+        {
+            // the timings are of the frame that used 'frameIndex' before
+            hitchrecorder::AddGpuTimings( frameId - FramesInFlight(), *gpuProfiler );
+        }
+        rayCostStats->ReadBack( frameIndex );
+        frameReadback->Deliver( frameIndex );
+
+        renderResolution.SetupViews( pnext::get< RgStartFrameViewsParams >( info ),
+                                     pnext::get< RgStartFrameStereoParams >( info ) );
         renderResolution.Setup( resolution,
                                 swapchain->GetWidth(),
                                 swapchain->GetHeight(),
@@ -142,9 +182,14 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
                                 swapchain->WithFSR3FrameGeneration() ? amdFsr3dx12.get() : nullptr,
                                 nvDlss2.get(),
                                 swapchain->WithDLSS3FrameGeneration() ? nvDlss3dx12.get()
-                                                                      : nullptr );
+                                                                      : nullptr,
+                                dynamicResolution->Update(
+                                    resolution,
+                                    newTimings ? std::optional{ gpuProfiler->GetFrameTimeMs() }
+                                               : std::nullopt ) );
 
         framebuffers->PrepareForSize( renderResolution.GetResolutionState(),
+                                      renderResolution.GetAllocationState(),
                                       ( swapchain->WithDXGI() ) );
 
         m_pixelated = resolution.pixelizedRenderSizeEnable
@@ -154,10 +199,11 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
 
     // reset cmds for current frame index
     cmdManager->PrepareForFrame( frameIndex );
+    memAllocator->SetCurrentFrameIndex( frameId );
 
-    // clear the data that were created MAX_FRAMES_IN_FLIGHT ago
-    worldSamplerManager->PrepareForFrame( frameIndex );
-    genericSamplerManager->PrepareForFrame( frameIndex );
+    // clear the data that were created FramesInFlight() ago
+    deletionQueue->Flush( frameIndex );
+    framebuffers->PrepareForFrame( frameIndex );
     textureManager->PrepareForFrame( frameIndex );
     cubemapManager->PrepareForFrame( frameIndex );
     rasterizer->PrepareForFrame( frameIndex );
@@ -174,7 +220,7 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
                                                fluidInfo.particleRadius );
             shaderManager->Subscribe( fluid );
             framebuffers->Subscribe( fluid );
-            fluid->OnFramebuffersSizeChange( renderResolution.GetResolutionState() );
+            fluid->OnFramebuffersSizeChange( framebuffers->GetAllocatedResolution() );
         }
         else if( !fluidInfo.enabled && fluid )
         {
@@ -197,9 +243,17 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
     }
 
     VkCommandBuffer cmd = cmdManager->StartGraphicsCmd();
+    gpuProfiler->SetPipelineStatisticsEnabled( devmode && devmode->pipelineStatistics );
+    gpuProfiler->BeginFrame( cmd, frameIndex );
     BeginCmdLabel( cmd, "Prepare for frame" );
 
-    textureManager->TryHotReload( cmd, frameIndex );
+    textureManager->DefragmentationStep( cmd, frameIndex );
+    textureManager->TryHotReload();
+    textureManager->UploadAsyncLoadedMaterials( cmd, frameIndex );
+    for( const auto& name : textureManager->CreateProvidedMaterials( cmd, frameIndex, ovrdFolder ) )
+    {
+        Hack_PatchStaticPrimitiveTextures( name.c_str() );
+    }
     lightManager->PrepareForFrame( cmd, frameIndex );
     lightManager->SetLightstyles( info );
     scene->PrepareForFrame( cmd,
@@ -235,7 +289,7 @@ VkCommandBuffer RTGL1::VulkanDevice::BeginFrame( const RgStartFrameInfo& info )
 
     if( fluid )
     {
-        fluid->PrepareForFrame( fluidInfo.reset );
+        fluid->PrepareForFrame( fluidInfo, gpuProfiler->GetFrameTimeMs() );
     }
 
     return cmd;
@@ -270,6 +324,53 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
         }
     }
 
+    {
+        const uint32_t prevViewCount = gu->viewCount;
+        gu->viewCount                = renderResolution.ViewCount();
+
+        memcpy( gu->viewsViewPrev, gu->viewsView, sizeof( gu->viewsView ) );
+        memcpy( gu->viewsProjectionPrev, gu->viewsProjection, sizeof( gu->viewsProjection ) );
+
+        const auto& viewsParams = pnext::get< RgDrawFrameViewsParams >( drawInfo );
+
+        for( uint32_t v = 0; v < gu->viewCount; v++ )
+        {
+            Camera c = cameraInfo;
+
+            if( auto halfIpd = renderResolution.GetStereoHalfIpd() )
+            {
+                // eyes share the orientation, the left one is at -X in view space
+                const float shift = v == 0 ? -*halfIpd : *halfIpd;
+
+                c.view[ 12 ] -= shift;
+                for( int i = 0; i < 3; i++ )
+                {
+                    c.viewInverse[ 12 + i ] += shift * c.viewInverse[ i ];
+                }
+            }
+            else if( v > 0 && v - 1 < viewsParams.additionalCameraCount &&
+                     viewsParams.pAdditionalCameras )
+            {
+                c = MakeCamera( viewsParams.pAdditionalCameras[ v - 1 ] );
+            }
+
+            memcpy( &gu->viewsView[ 16 * v ], c.view, 16 * sizeof( float ) );
+            memcpy( &gu->viewsInvView[ 16 * v ], c.viewInverse, 16 * sizeof( float ) );
+            memcpy( &gu->viewsProjection[ 16 * v ], c.projection, 16 * sizeof( float ) );
+            memcpy( &gu->viewsInvProjection[ 16 * v ], c.projectionInverse, 16 * sizeof( float ) );
+
+            const RgFloat3D p = MakeCameraPosition( c );
+            RG_SET_VEC3_A( &gu->viewsCameraPosition[ 4 * v ], p.data );
+        }
+
+        // no history for the new views
+        if( prevViewCount != gu->viewCount )
+        {
+            memcpy( gu->viewsViewPrev, gu->viewsView, sizeof( gu->viewsView ) );
+            memcpy( gu->viewsProjectionPrev, gu->viewsProjection, sizeof( gu->viewsProjection ) );
+        }
+    }
+
     {
         gu->frameId   = frameId;
         gu->timeDelta = static_cast< float >(
@@ -278,11 +379,26 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
     }
 
     {
+        const ResolutionState& alloc = framebuffers->GetAllocatedResolution();
+
+        // the previous frame was rendered into a subregion of the same images,
+        // unless they were reallocated, then there's no valid history anyway
+        const bool sameImages = gu->renderWidth > 0 &&
+                                gu->renderAllocWidth == static_cast< float >( alloc.renderWidth ) &&
+                                gu->renderAllocHeight == static_cast< float >( alloc.renderHeight );
+        const float prevWidth  = gu->renderWidth;
+        const float prevHeight = gu->renderHeight;
+
         gu->renderWidth  = static_cast< float >( renderResolution.Width() );
         gu->renderHeight = static_cast< float >( renderResolution.Height() );
         // render width must be always even for checkerboarding!
         assert( ( int )gu->renderWidth % 2 == 0 );
 
+        gu->renderWidthPrev   = sameImages ? prevWidth : gu->renderWidth;
+        gu->renderHeightPrev  = sameImages ? prevHeight : gu->renderHeight;
+        gu->renderAllocWidth  = static_cast< float >( alloc.renderWidth );
+        gu->renderAllocHeight = static_cast< float >( alloc.renderHeight );
+
         gu->upscaledRenderWidth  = static_cast< float >( renderResolution.UpscaledWidth() );
         gu->upscaledRenderHeight = static_cast< float >( renderResolution.UpscaledHeight() );
 
@@ -297,6 +413,10 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
             {
                 jitter = amdFsr3dx12->GetJitter( renderResolution.GetResolutionState(), frameId );
             }
+            else if( m_fsr3Native )
+            {
+                jitter = amdFsr3vk->GetJitter( renderResolution.GetResolutionState(), frameId );
+            }
             else if( amdFsr2 )
             {
                 jitter = amdFsr2->GetJitter( renderResolution.GetResolutionState(), frameId );
@@ -324,10 +444,13 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
     }
 
     {
-        gu->lightCount     = lightManager->GetLightCount();
-        gu->lightCountPrev = lightManager->GetLightCountPrev();
+        gu->lightCount         = lightManager->GetLightCount();
+        gu->lightCountPrev     = lightManager->GetLightCountPrev();
+        gu->lightTreeLeafCount = lightManager->GetLightTreeLeafCount();
 
         gu->directionalLightExists = lightManager->DoesDirectionalLightExist();
+
+        gu->emissiveTriangleCount = scene->GetASManager()->GetEmissiveTriangleCount();
     }
 
     {
@@ -401,13 +524,70 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
         gu->maxBounceShadowsLights     = params.maxBounceShadows;
         gu->polyLightSpotlightFactor   = std::max( 0.0f, params.polygonalLightSpotlightFactor );
         gu->indirSecondBounce          = !!params.enableSecondBounceForIndirect;
+        gu->adaptiveSamplingEnable     = !!params.enableAdaptiveSampling;
+        gu->irradianceCacheEnable      = !!params.enableIrradianceCache;
+        gu->irradianceCacheCellSize    = std::max( params.irradianceCacheCellSize, 0.001f );
+        gu->irradianceCacheUpdateRate  = std::clamp( params.irradianceCacheUpdateRate, 0.0f, 1.0f );
+        gu->sunShadowCacheEnable       = !!params.enableSunShadowCache;
+        gu->sunShadowCacheUpdateRate   = std::clamp( params.sunShadowCacheUpdateRate, 0.0f, 1.0f );
         gu->lightIndexIgnoreFPVShadows = lightManager->GetLightIndexForShaders(
             currentFrameState.GetFrameIndex(), params.lightUniqueIdIgnoreFirstPersonViewerShadows );
+        gu->lightGridEnable     = !!params.enableLightGrid;
         gu->cellWorldSize       = std::max( params.cellWorldSize, 0.001f );
         gu->gradientMultDiffuse = std::clamp( params.directDiffuseSensitivityToChange, 0.0f, 1.0f );
         gu->gradientMultIndirect =
             std::clamp( params.indirectDiffuseSensitivityToChange, 0.0f, 1.0f );
         gu->gradientMultSpecular = std::clamp( params.specularSensitivityToChange, 0.0f, 1.0f );
+
+        switch( params.indirectResolution )
+        {
+            case RG_INDIRECT_ILLUMINATION_RESOLUTION_HALF: gu->indirStride = 2; break;
+            case RG_INDIRECT_ILLUMINATION_RESOLUTION_QUARTER: gu->indirStride = 4; break;
+            case RG_INDIRECT_ILLUMINATION_RESOLUTION_CHECKERBOARD: gu->indirStride = 2; break;
+            default: gu->indirStride = 1; break;
+        }
+        gu->indirCheckerboard =
+            params.indirectResolution == RG_INDIRECT_ILLUMINATION_RESOLUTION_CHECKERBOARD;
+
+        // traced pixel in each block is changed every frame
+        if( gu->indirCheckerboard )
+        {
+            gu->indirTraceOffset = frameId % 2;
+        }
+        else
+        {
+            RgFloat2D h = HaltonSequence::GetJitter_Halton23( frameId );
+
+            auto x = uint32_t( ( h.data[ 0 ] + 0.5f ) * float( gu->indirStride ) );
+            auto y = uint32_t( ( h.data[ 1 ] + 0.5f ) * float( gu->indirStride ) );
+
+            gu->indirTraceOffset = std::min( x, gu->indirStride - 1 ) +
+                                   std::min( y, gu->indirStride - 1 ) * gu->indirStride;
+        }
+
+        switch( params.sampleSequence )
+        {
+            case RG_SAMPLE_SEQUENCE_BLUE_NOISE:
+                gu->sampleSequence = SAMPLE_SEQUENCE_BLUE_NOISE;
+                break;
+            case RG_SAMPLE_SEQUENCE_SOBOL: gu->sampleSequence = SAMPLE_SEQUENCE_SOBOL; break;
+            default: gu->sampleSequence = SAMPLE_SEQUENCE_WHITE_NOISE; break;
+        }
+
+        gu->primaryVisibilityBuffer =
+            rtPipeline->GetPipelineVisibilityResolve_Compute() != VK_NULL_HANDLE ? 1 : 0;
+
+        // upper limits, so random salts of the samples fit before the next RANDOM_SALT_*_BASE
+        auto l_budget = []( uint32_t countMin, uint32_t countMax, uint32_t lower, uint32_t upper ) {
+            countMax = std::clamp( countMax, lower, upper );
+            return std::pair{ std::clamp( countMin, lower, countMax ), countMax };
+        };
+        std::tie( gu->restirDirectCandidatesMin, gu->restirDirectCandidatesMax ) = l_budget(
+            params.restirDirectCandidateCountMin, params.restirDirectCandidateCountMax, 1, 10 );
+        std::tie( gu->restirDirectSpatialMin, gu->restirDirectSpatialMax ) = l_budget(
+            params.restirDirectSpatialCountMin, params.restirDirectSpatialCountMax, 0, 10 );
+        std::tie( gu->restirIndirectSpatialMin, gu->restirIndirectSpatialMax ) = l_budget(
+            params.restirIndirectSpatialCountMin, params.restirIndirectSpatialCountMax, 0, 16 );
     }
 
     {
@@ -433,6 +613,12 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
 
         gu->reflectRefractMaxDepth = std::min( 16u, params.maxReflectRefractDepth );
 
+        gu->reflectRefractMinThroughput = std::max( 0.0f, params.minReflectRefractThroughput );
+        gu->reflectRefractMaxRoughness =
+            std::clamp( params.maxReflectRefractRoughness, 0.0f, 1.0f );
+        gu->reflectRefractMaxDistance      = std::max( 0.0f, params.maxReflectRefractDistance );
+        gu->reflectRefractSkyOnTermination = !!params.skyOnReflectRefractTermination;
+
         gu->indexOfRefractionGlass = std::max( 0.0f, params.indexOfRefractionGlass );
         gu->indexOfRefractionWater = std::max( 0.0f, params.indexOfRefractionWater );
         gu->thinMediaWidth         = std::max( 0.0f, params.thinMediaWidth );
@@ -458,17 +644,20 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
     gu->primaryRayMinDist = clamp( cameraInfo.cameraNear, 0.001f, gu->rayLength );
 
     {
-        gu->rayCullMaskWorld =
-            INSTANCE_MASK_WORLD_0 | INSTANCE_MASK_WORLD_1 | INSTANCE_MASK_WORLD_2;
+        gu->rayCullMaskWorld = INSTANCE_MASK_WORLD_0 | INSTANCE_MASK_WORLD_0_DYNAMIC |
+                               INSTANCE_MASK_WORLD_1 | INSTANCE_MASK_WORLD_2;
 
         // skip shadows for:
         // WORLD_1 - 'no shadows' geometry
         // WORLD_2 - 'sky' geometry
-        gu->rayCullMaskWorld_Shadow = INSTANCE_MASK_WORLD_0;
+        // and include geometry of invisible areas that still casts shadows
+        gu->rayCullMaskWorld_Shadow = INSTANCE_MASK_WORLD_0 | INSTANCE_MASK_WORLD_0_DYNAMIC |
+                                      INSTANCE_MASK_AREA_SHADOW_ONLY;
     }
 
     gu->waterNormalTextureIndex = textureManager->GetWaterNormalTextureIndex();
     gu->dirtMaskTextureIndex    = textureManager->GetDirtMaskTextureIndex();
+    gu->textureStreamingEnable  = textureManager->IsStreamingEnabled();
 
     gu->cameraRayConeSpreadAngle = atanf( ( 2.0f * tanf( cameraInfo.fovYRadians * 0.5f ) ) /
                                           float( renderResolution.Height() ) );
@@ -478,13 +667,16 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
     gu->lightmapScreenCoverage = lightmapScreenCoverage;
 
     {
-        gu->fluidEnabled = fluid && fluid->Active();
+        // fluid depth is rasterized for one camera
+        gu->fluidEnabled = fluid && fluid->Active() && !renderResolution.IsMultiView();
         RG_SET_VEC3_A( gu->fluidColor, fluidColor.data );
     }
 
     {
         const auto& params = pnext::get< RgDrawFrameVolumetricParams >( drawInfo );
 
+        const uint32_t prevVolumeEnableType = gu->volumeEnableType;
+
         gu->volumeCameraNear = std::max( cameraInfo.cameraNear, 0.001f );
         gu->volumeCameraFar  = std::min( cameraInfo.cameraFar, params.volumetricFar );
 
@@ -538,6 +730,27 @@ void RTGL1::VulkanDevice::FillUniform( RTGL1::ShGlobalUniform* gu,
             RG_MAX_VEC3( gu->volumeUnderwaterColor, 0.0f );
         }
 
+        {
+            auto l_gridSize = []( uint32_t v, uint32_t maxSize ) {
+                return v == 0 ? maxSize : std::clamp( v, 1u, maxSize );
+            };
+
+            uint32_t sizeX = l_gridSize( params.gridWidth, VOLUMETRIC_SIZE_X );
+            uint32_t sizeY = l_gridSize( params.gridHeight, VOLUMETRIC_SIZE_Y );
+            uint32_t sizeZ = l_gridSize( params.gridDepth, VOLUMETRIC_SIZE_Z );
+
+            // previous frame's volume must be valid and in the same layout
+            bool canReproject = !drawInfo.resetHistory &&
+                                prevVolumeEnableType == VOLUME_ENABLE_VOLUMETRIC &&
+                                gu->volumeSizeX == sizeX && gu->volumeSizeY == sizeY &&
+                                gu->volumeSizeZ == sizeZ;
+
+            gu->volumeSizeX        = sizeX;
+            gu->volumeSizeY        = sizeY;
+            gu->volumeSizeZ        = sizeZ;
+            gu->volumeReprojection = params.temporalReprojection && canReproject;
+        }
+
         if( gu->volumeEnableType != VOLUME_ENABLE_NONE )
         {
             memcpy( gu->volumeViewProj_Prev, gu->volumeViewProj, 16 * sizeof( float ) );
@@ -581,13 +794,16 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
 
     const auto& cameraInfo = scene->GetCamera( renderResolution.Aspect() );
 
-    bool mipLodBiasUpdated =
-        worldSamplerManager->TryChangeMipLodBias( frameIndex, renderResolution.GetMipLodBias() );
+    worldSamplerManager->TryChangeMipLodBias( frameIndex, renderResolution.GetMipLodBias() );
     const RgFloat2D jitter = { uniform->GetData()->jitterX, uniform->GetData()->jitterY };
 
-    textureManager->SubmitDescriptors(
-        frameIndex, pnext::get< RgDrawFrameTexturesParams >( drawInfo ), mipLodBiasUpdated );
-    cubemapManager->SubmitDescriptors( frameIndex );
+    {
+        RG_CPU_ZONE( "Descriptor updates" );
+
+        textureManager->SubmitDescriptors(
+            frameIndex, pnext::get< RgDrawFrameTexturesParams >( drawInfo ) );
+        cubemapManager->SubmitDescriptors( frameIndex );
+    }
 
     lightManager->SubmitForFrame( cmd, frameIndex );
 
@@ -598,7 +814,11 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
                            frameIndex,
                            uniform,
                            uniform->GetData()->rayCullMaskWorld,
-                           drawInfo.disableRayTracedGeometry );
+                           drawInfo.disableRayTracedGeometry,
+                           pnext::get< RgDrawFrameInstanceCullingParams >( drawInfo ),
+                           pnext::get< RgDrawFrameAreaVisibilityParams >( drawInfo ),
+                           *textureManager,
+                           *gpuProfiler );
 
     if( drawInfo.presentPrevFrame )
     {
@@ -615,26 +835,52 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
                                                     w );
     }
 
+    // light grid depends only on the uploaded lights and uniform, so submit
+    // the uploads now, and overlap the async build with rasterization
+    const bool asyncLightGrid = uniform->GetData()->lightGridEnable && lightGrid->IsAsync();
+    if( asyncLightGrid )
+    {
+        const VkSemaphore initFrameFinished = currentFrameState.GetSemaphoreForWaitAndRemove();
+
+        textureManager->SubmitTransferUploads();
+        cubemapManager->SubmitTransferUploads();
+        cmdManager->Submit_Timeline( //
+            cmd,
+            nullptr,
+            ToWait{ initFrameFinished, SEMAPHORE_IS_BINARY },
+            ToSignal{ VK_NULL_HANDLE, 0 } );
+
+        lightGrid->BuildAsync( frameIndex, uniform, blueNoise, lightManager );
+
+        cmd = cmdManager->StartGraphicsCmd();
+    }
+
     if( !drawInfo.disableRasterization )
     {
+        auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Rasterization };
+
         rasterizer->SubmitForFrame( cmd, frameIndex );
 
         // draw rasterized sky to albedo before tracing primary rays
         if( uniform->GetData()->skyType == RG_SKY_TYPE_RASTERIZED_GEOMETRY )
         {
-            rasterizer->DrawSkyToCubemap( cmd, frameIndex, *textureManager, *uniform );
+            const auto& skyParams = pnext::get< RgDrawFrameSkyParams >( drawInfo );
+
+            rasterizer->DrawSkyToCubemap( cmd, frameIndex, *textureManager, *uniform, skyParams );
             rasterizer->DrawSkyToAlbedo(
                 cmd,
                 frameIndex,
                 *textureManager,
+                *uniform,
                 cameraInfo.view,
-                pnext::get< RgDrawFrameSkyParams >( drawInfo ).skyViewerPosition,
+                skyParams.skyViewerPosition,
                 cameraInfo.projection,
                 jitter,
                 renderResolution );
         }
 
-        if( fluid && !( devmode && devmode->fluidStopVisualize ) )
+        if( fluid && !renderResolution.IsMultiView() &&
+            !( devmode && devmode->fluidStopVisualize ) )
         {
             fluid->Visualize( cmd,
                               frameIndex,
@@ -648,7 +894,10 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
 
 
     {
-        lightGrid->Build( cmd, frameIndex, uniform, blueNoise, lightManager );
+        if( uniform->GetData()->lightGridEnable && !asyncLightGrid )
+        {
+            lightGrid->Build( cmd, frameIndex, uniform, blueNoise, lightManager );
+        }
 
         portalList->SubmitForFrame( cmd, frameIndex );
 
@@ -672,65 +921,117 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
                                                         *portalList,
                                                         *volumetric );
 
-        pathTracer->TracePrimaryRays( params );
+        {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::PrimaryRays };
+            pathTracer->TracePrimaryRays( params );
+        }
 
         // draw decals on top of primary surface
-        rasterizer->DrawDecals( cmd,
-                                frameIndex,
-                                *uniform,
-                                *textureManager,
-                                cameraInfo.view,
-                                cameraInfo.projection,
-                                jitter,
-                                renderResolution );
+        {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Rasterization };
+            rasterizer->DrawDecals( cmd,
+                                    frameIndex,
+                                    *uniform,
+                                    *textureManager,
+                                    cameraInfo.view,
+                                    cameraInfo.projection,
+                                    jitter,
+                                    renderResolution );
+        }
 
         if( uniform->GetData()->reflectRefractMaxDepth > 0 )
         {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::ReflectRefract };
             pathTracer->TraceReflectionRefractionRays( params );
         }
+        textureManager->CopyStreamingFeedback( cmd, frameIndex );
 
-        lightManager->BarrierLightGrid( cmd, frameIndex );
-        pathTracer->CalculateInitialReservoirs( params );
-        pathTracer->TraceDirectllumination( params );
-        pathTracer->TraceIndirectllumination( params );
-        pathTracer->TraceVolumetric( params );
+        if( uniform->GetData()->lightGridEnable )
+        {
+            lightManager->BarrierLightGrid( cmd, frameIndex );
+        }
+        framebuffers->BeginPass( cmd, FramebufferPass::DirectIllumination );
+        {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::DirectIllumination };
+            pathTracer->CalculateInitialReservoirs( params );
+            pathTracer->TraceDirectllumination( params );
+        }
+        framebuffers->BeginPass( cmd, FramebufferPass::IndirectIllumination );
+        {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::IndirectIllumination };
+            irradianceCache->Prepare( cmd,
+                                      *restirBuffers,
+                                      uniform->GetData()->irradianceCacheEnable != 0,
+                                      resetHistory );
+            pathTracer->TraceIndirectllumination( params );
+            irradianceCache->Resolve( cmd, frameIndex, *uniform, *restirBuffers );
+        }
+        {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Volumetric };
+            pathTracer->TraceVolumetric( params );
+        }
 
         if( fluid )
         {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Fluid };
+
+            const uint32_t prevFrameIndex =
+                ( frameIndex + FramesInFlight() - 1 ) % FramesInFlight();
+
             fluid->Simulate( cmd,
                              frameIndex,
                              scene->GetASManager()->GetTLASDescSet( frameIndex ),
+                             scene->GetASManager()->GetTLASDescSet( prevFrameIndex ),
                              float( timeDelta ),
-                             fluidGravity );
+                             fluidGravity,
+                             cameraInfo.view,
+                             cameraInfo.projection );
         }
 
-        pathTracer->CalculateGradientsSamples( params );
-        pathTracer->FinalizeIndirectIllumination_Compute( cmd,
-                                                          frameIndex,
-                                                          renderResolution.Width(),
-                                                          renderResolution.Height(),
-                                                          *scene,
-                                                          *uniform,
-                                                          *textureManager,
-                                                          *framebuffers,
-                                                          *restirBuffers,
-                                                          *blueNoise,
-                                                          *lightManager,
-                                                          *cubemapManager,
-                                                          *rasterizer->GetRenderCubemap(),
-                                                          *portalList,
-                                                          *volumetric );
-        denoiser->Denoise( cmd, frameIndex, uniform );
-        volumetric->ProcessScattering(
-            cmd, frameIndex, *uniform, *blueNoise, *framebuffers, volumetricMaxHistoryLen );
-        tonemapping->CalculateExposure( cmd, frameIndex, uniform );
+        {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::IndirectIllumination };
+            pathTracer->CalculateGradientsSamples( params );
+            pathTracer->FinalizeIndirectIllumination_Compute( cmd,
+                                                              frameIndex,
+                                                              renderResolution.Width(),
+                                                              renderResolution.Height(),
+                                                              *scene,
+                                                              *uniform,
+                                                              *textureManager,
+                                                              *framebuffers,
+                                                              *restirBuffers,
+                                                              *blueNoise,
+                                                              *lightManager,
+                                                              *cubemapManager,
+                                                              *rasterizer->GetRenderCubemap(),
+                                                              *portalList,
+                                                              *volumetric );
+        }
+        framebuffers->BeginPass( cmd, FramebufferPass::Denoise );
+        {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Denoiser };
+            ( renderResolution.IsNvDlssRayReconstructionEnabled() ? noisyComposition : denoiser )
+                ->Denoise( cmd, frameIndex, uniform );
+        }
+        {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Volumetric };
+            volumetric->ProcessScattering(
+                cmd, frameIndex, *uniform, *blueNoise, *framebuffers, volumetricMaxHistoryLen );
+        }
+        {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Tonemapping };
+            tonemapping->CalculateExposure( cmd, frameIndex, uniform );
+        }
     }
 
+    framebuffers->BeginPass( cmd, FramebufferPass::Composition );
     imageComposition->PrepareForRaster( cmd, frameIndex, uniform.get() );
     volumetric->BarrierToReadIllumination( cmd );
 
     if( !drawInfo.disableRasterization )
     {
+        auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Rasterization };
+
         // draw rasterized geometry into the final image
         rasterizer->DrawToFinalImage( cmd,
                                       frameIndex,
@@ -751,6 +1052,12 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
                                 *tonemapping,
                                 pnext::get< RgDrawFrameTonemappingParams >( drawInfo ) );
 
+    if( devmode && ( devmode->debugShowFlags & RayCostStats::DebugShowFlags ) )
+    {
+        rayCostStats->CopyForReadback(
+            cmd, frameIndex, *framebuffers, renderResolution.GetResolutionState() );
+    }
+
     FramebufferImageIndex accum       = FB_IMAGE_INDEX_FINAL;
     bool                  needHudOnly = false;
     {
@@ -773,6 +1080,8 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
                 return nullptr;
             }
 
+            textureManager->SubmitTransferUploads();
+            cubemapManager->SubmitTransferUploads();
             cmdManager->Submit_Timeline( //
                 vkcmd,
                 nullptr,
@@ -855,13 +1164,15 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
             }
             else if( nvDlss2 )
             {
-                accum = nvDlss2->Apply( cmd,
-                                        frameIndex,
-                                        *framebuffers,
-                                        renderResolution,
-                                        jitter,
-                                        timeDelta,
-                                        resetHistory );
+                auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Upscaler };
+                accum  = nvDlss2->Apply( cmd,
+                                         frameIndex,
+                                         *framebuffers,
+                                         renderResolution,
+                                         jitter,
+                                         timeDelta,
+                                         resetHistory,
+                                         cameraInfo );
             }
             else
             {
@@ -899,17 +1210,42 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
             }
             else if( amdFsr2 )
             {
-                accum = amdFsr2->Apply( cmd,
-                                        frameIndex,
-                                        *framebuffers,
-                                        renderResolution,
-                                        jitter,
-                                        timeDelta,
-                                        cameraInfo.cameraNear,
-                                        cameraInfo.cameraFar,
-                                        cameraInfo.fovYRadians,
-                                        resetHistory,
-                                        sceneImportExport->GetWorldScale() );
+                auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Upscaler };
+
+                auto u = m_fsr3Native ? amdFsr3vk->Apply( cmd,
+                                                          frameIndex,
+                                                          *framebuffers,
+                                                          renderResolution,
+                                                          jitter,
+                                                          timeDelta,
+                                                          cameraInfo.cameraNear,
+                                                          cameraInfo.cameraFar,
+                                                          cameraInfo.fovYRadians,
+                                                          resetHistory,
+                                                          sceneImportExport->GetWorldScale(),
+                                                          frameId,
+                                                          m_skipGeneratedFrame )
+                                      : std::nullopt;
+                if( u )
+                {
+                    accum = *u;
+                }
+                else
+                {
+                    // if FSR3 failed, it's not available anymore, so fall back to FSR2
+                    m_fsr3Native = false;
+                    accum        = amdFsr2->Apply( cmd,
+                                                   frameIndex,
+                                                   *framebuffers,
+                                                   renderResolution,
+                                                   jitter,
+                                                   timeDelta,
+                                                   cameraInfo.cameraNear,
+                                                   cameraInfo.cameraFar,
+                                                   cameraInfo.fovYRadians,
+                                                   resetHistory,
+                                                   sceneImportExport->GetWorldScale() );
+                }
             }
             else
             {
@@ -919,6 +1255,7 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
 
         if( lightmapScreenCoverage > 0 && !drawInfo.disableRasterization )
         {
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Rasterization };
             rasterizer->DrawClassic(
                 cmd,
                 frameIndex,
@@ -955,51 +1292,85 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
     {
         if( renderResolution.IsDedicatedSharpeningEnabled() )
         {
-            accum = sharpening->Apply( cmd,
-                                       frameIndex,
-                                       framebuffers,
-                                       renderResolution.UpscaledWidth(),
-                                       renderResolution.UpscaledHeight(),
-                                       accum,
-                                       renderResolution.GetSharpeningTechnique(),
-                                       renderResolution.GetSharpeningIntensity() );
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::PostEffects };
+            accum  = sharpening->Apply( cmd,
+                                        frameIndex,
+                                        framebuffers,
+                                        renderResolution.UpscaledWidth(),
+                                        renderResolution.UpscaledHeight(),
+                                        accum,
+                                        renderResolution.GetSharpeningTechnique(),
+                                        renderResolution.GetSharpeningIntensity() );
         }
 
         if( pnext::get< RgDrawFrameBloomParams >( drawInfo ).bloomIntensity > 0.0f )
         {
-            accum = bloom->Apply( cmd,
-                                  frameIndex,
-                                  *uniform,
-                                  *tonemapping,
-                                  *textureManager,
-                                  renderResolution.UpscaledWidth(),
-                                  renderResolution.UpscaledHeight(),
-                                  accum );
+            framebuffers->BeginPass( cmd, FramebufferPass::Bloom );
+
+            auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Bloom };
+            accum  = bloom->Apply( cmd,
+                                   frameIndex,
+                                   *uniform,
+                                   *tonemapping,
+                                   *textureManager,
+                                   renderResolution.UpscaledWidth(),
+                                   renderResolution.UpscaledHeight(),
+                                   accum );
         }
 
-        auto l_applyIf = [ &args ]( auto&                 effect,
-                                    auto&                 setupArg,
-                                    FramebufferImageIndex input ) -> FramebufferImageIndex {
-            return effect->Setup( args, setupArg ) ? effect->Apply( args, input ) : input;
+        // pointwise effects are deferred, so the consecutive ones are applied in one dispatch
+        uint32_t fusedBits = 0;
+
+        auto l_applyFused = [ & ]( FramebufferImageIndex input ) -> FramebufferImageIndex {
+            switch( const uint32_t bits = std::exchange( fusedBits, 0 ) )
+            {
+                case 0: return input;
+                case EFFECT_FUSED_TELEPORT: return effectTeleport->Apply( args, input );
+                case EFFECT_FUSED_HUE_SHIFT: return effectHueShift->Apply( args, input );
+                case EFFECT_FUSED_NIGHT_VISION: return effectNightVision->Apply( args, input );
+                default:
+                    effectFusedPointwise[ bits ]->Setup(
+                        *effectTeleport, *effectHueShift, *effectNightVision );
+                    return effectFusedPointwise[ bits ]->Apply( args, input );
+            }
+        };
+
+        auto l_applyIf = [ & ]( auto&                 effect,
+                                auto&                 setupArg,
+                                FramebufferImageIndex input ) -> FramebufferImageIndex {
+            return effect->Setup( args, setupArg ) ? effect->Apply( args, l_applyFused( input ) )
+                                                   : input;
+        };
+
+        auto l_deferIf = [ & ]( auto& effect, auto& setupArg, EffectFusedPointwise_Bits bit ) {
+            if( effect->Setup( args, setupArg ) )
+            {
+                fusedBits |= bit;
+            }
         };
 
         const auto& postef = pnext::get< RgDrawFramePostEffectsParams >( drawInfo );
 
-        accum = l_applyIf( effectTeleport, postef.pTeleport, accum );
+        auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::PostEffects };
+
+        l_deferIf( effectTeleport, postef.pTeleport, EFFECT_FUSED_TELEPORT );
         accum = l_applyIf( effectColorTint, postef.pColorTint, accum );
         accum = l_applyIf( effectInverseBW, postef.pInverseBlackAndWhite, accum );
-        accum = l_applyIf( effectHueShift, postef.pHueShift, accum );
-        accum = l_applyIf( effectNightVision, postef.pNightVision, accum );
+        l_deferIf( effectHueShift, postef.pHueShift, EFFECT_FUSED_HUE_SHIFT );
+        l_deferIf( effectNightVision, postef.pNightVision, EFFECT_FUSED_NIGHT_VISION );
         accum = l_applyIf( effectChromaticAberration, postef.pChromaticAberration, accum );
         accum = l_applyIf( effectDistortedSides, postef.pDistortedSides, accum );
         accum = l_applyIf( effectWaves, postef.pWaves, accum );
         accum = l_applyIf( effectRadialBlur, postef.pRadialBlur, accum );
         accum = l_applyIf( effectVHS, postef.pVHS, accum );
+        accum = l_applyFused( accum );
     }
 
     // draw geometry such as HUD into an upscaled framebuf
     if( !drawInfo.disableRasterization )
     {
+        auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::Rasterization };
+
         if( !needHudOnly )
         {
             framebuffers->BarrierOne(
@@ -1037,21 +1408,36 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
         }
     }
 
+    // if dither must be applied within the tonemapping pass
+    bool fuseDither = false;
+
     // post-effect that work on swapchain geometry too
     {
         const auto& postef = pnext::get< RgDrawFramePostEffectsParams >( drawInfo );
 
+        auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::PostEffects };
+
         if( effectWipe->Setup( args, postef.pWipe, frameId ) )
         {
             accum = effectWipe->Apply( args, *blueNoise, accum );
         }
 
+        const bool crtActive = postef.pCRT != nullptr && postef.pCRT->isActive;
+
         if( effectDither->Setup( args, postef.pDither ) )
         {
-            accum = effectDither->Apply( args, accum );
+            // if nothing is between dither and tonemapping, apply them in one dispatch
+            if( crtActive )
+            {
+                accum = effectDither->Apply( args, accum );
+            }
+            else
+            {
+                fuseDither = true;
+            }
         }
 
-        if( postef.pCRT != nullptr && postef.pCRT->isActive )
+        if( crtActive )
         {
             effectCrtDemodulateEncode->Setup( args );
             accum = effectCrtDemodulateEncode->Apply( args, accum );
@@ -1066,16 +1452,19 @@ auto RTGL1::VulkanDevice::Render( VkCommandBuffer& cmd, const RgDrawFrameInfo& d
     {
         const auto& tnmp = pnext::get< RgDrawFrameTonemappingParams >( drawInfo );
 
+        auto t = GpuProfiler::Scope{ *gpuProfiler, cmd, GpuPass::PostEffects };
+
         VkDescriptorSet lpmDescSet =
             imageComposition->SetupLpmParams( cmd, frameIndex, tnmp, swapchain->IsHDREnabled() );
-        effectHDRPrepare->Setup( args, tnmp );
+        auto& hdrPrepare = fuseDither ? effectHDRPrepareWithDither : effectHDRPrepare;
+        hdrPrepare->Setup( args, tnmp, fuseDither ? effectDither.get() : nullptr );
 
         VkDescriptorSet descSets[] = {
             args.framebuffers->GetDescSet( args.frameIndex ),
             args.uniform->GetDescSet( args.frameIndex ),
             lpmDescSet,
         };
-        accum = effectHDRPrepare->Apply( descSets, args, accum );
+        accum = hdrPrepare->Apply( descSets, args, accum );
     }
 
     m_prevAccum = accum;
@@ -1121,11 +1510,17 @@ void WaitTimelineAndSignalBinary( VkQueue     q,
 
 void RTGL1::VulkanDevice::EndFrame( VkCommandBuffer cmd, FramebufferImageIndex rendered )
 {
+    RG_CPU_ZONE( "Submit and present" );
+
     auto label = CmdLabel{ cmd, "Blit to swapchain" };
 
     const uint32_t    frameIndex        = currentFrameState.GetFrameIndex();
     const VkSemaphore initFrameFinished = currentFrameState.GetSemaphoreForWaitAndRemove();
 
+    // frame's cmd acquires the ownership of the images copied on the transfer queue
+    textureManager->SubmitTransferUploads();
+    cubemapManager->SubmitTransferUploads();
+
     // present debug window
     if( debugWindows && !debugWindows->IsMinimized() )
     {
@@ -1158,16 +1553,23 @@ void RTGL1::VulkanDevice::EndFrame( VkCommandBuffer cmd, FramebufferImageIndex r
         debugWindows->OnQueuePresent( r );
     }
 
+    gpuProfiler->EndFrame( cmd );
+
     if( nvDlss3dx12 )
     {
         nvDlss3dx12->Reflex_RenderEnd();
         nvDlss3dx12->Reflex_PresentStart();
     }
+    lowLatency->Marker( swapchain->GetNativeHandle(), VK_LATENCY_MARKER_RENDERSUBMIT_END_NV );
+    lowLatency->Marker( swapchain->GetNativeHandle(), VK_LATENCY_MARKER_PRESENT_START_NV );
 
 
     const auto rendered_size =
         framebuffers->GetFramebufSize( renderResolution.GetResolutionState(), rendered );
 
+    frameReadback->CopyForReadback(
+        cmd, frameIndex, frameId, *framebuffers, renderResolution.GetResolutionState(), rendered );
+
 
     // present
     if( swapchain->WithDXGI() )
@@ -1258,9 +1660,128 @@ void RTGL1::VulkanDevice::EndFrame( VkCommandBuffer cmd, FramebufferImageIndex r
             }
         }();
     }
+    else if( swapchain->IsHeadless() )
+    {
+        // nothing to present: blit to an offscreen image and copy it to a host-visible buffer,
+        // which will be readable after the fence of this frame index
+        if( swapchain->Valid() )
+        {
+            framebuffers->BarrierOne( cmd, frameIndex, rendered );
+
+            swapchain->BlitForPresent( cmd,
+                                       framebuffers->GetImage( rendered, frameIndex ),
+                                       rendered_size,
+                                       VK_FILTER_NEAREST,
+                                       VK_IMAGE_LAYOUT_GENERAL );
+            swapchain->CopyForReadback( cmd, frameId );
+        }
+
+        uint32_t    towait_count = 0;
+        VkSemaphore towait[ 1 ]  = {};
+        if( initFrameFinished )
+        {
+            towait[ towait_count++ ] = initFrameFinished;
+        }
+
+        cmdManager->Submit_Binary( //
+            cmd,
+            std::span{ towait, towait_count },
+            VK_NULL_HANDLE,
+            frameFences[ frameIndex ] );
+    }
     else
     {
+        VkSemaphore imageAvailable =
+            swapchain->Valid() ? vkswapchainAvailableSemaphores[ frameIndex ] : VK_NULL_HANDLE;
+        VkSemaphore initFinished = initFrameFinished;
+
+        // FSR3 frame generation without a frame interpolation swapchain:
+        // present the generated frame first, then acquire another image for the rendered one
+        auto generated = std::optional< FramebufferImageIndex >{};
+        if( m_fsr3Native && !m_skipGeneratedFrame && imageAvailable )
+        {
+            uint32_t hdrDisplay = HDR_DISPLAY_NONE;
+            if( swapchain->IsHDREnabled() )
+            {
+                hdrDisplay =
+                    swapchain->IsST2084ColorSpace() ? HDR_DISPLAY_ST2084 : HDR_DISPLAY_LINEAR;
+            }
+
+            generated = amdFsr3vk->Interpolate( cmd,
+                                                frameIndex,
+                                                *framebuffers,
+                                                renderResolution.GetResolutionState(),
+                                                rendered,
+                                                hdrDisplay );
+        }
+
+        if( generated )
+        {
+            framebuffers->BarrierOne( cmd, frameIndex, *generated );
+
+            swapchain->BlitForPresent( cmd,
+                                       framebuffers->GetImage( *generated, frameIndex ),
+                                       rendered_size,
+                                       VK_FILTER_NEAREST,
+                                       VK_IMAGE_LAYOUT_GENERAL );
+
+            uint32_t    towait_count = 0;
+            VkSemaphore towait[ 2 ]  = {};
+            towait[ towait_count++ ] = imageAvailable;
+            if( initFinished )
+            {
+                towait[ towait_count++ ] = initFinished;
+            }
+
+            cmdManager->Submit_Binary( //
+                cmd,
+                std::span{ towait, towait_count },
+                generatedFinishedSemaphores[ frameIndex ], // signal
+                VK_NULL_HANDLE );
+
+            VkResult       r       = VK_SUCCESS;
+            VkSwapchainKHR sw      = swapchain->GetHandle();
+            uint32_t       swIndex = swapchain->GetCurrentImageIndex();
+
+            auto presentInfo = VkPresentInfoKHR{
+                .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+                .waitSemaphoreCount = 1,
+                .pWaitSemaphores    = &generatedFinishedSemaphores[ frameIndex ],
+                .swapchainCount     = 1,
+                .pSwapchains        = &sw,
+                .pImageIndices      = &swIndex,
+                .pResults           = &r,
+            };
+            vkQueuePresentKHR( queues->GetGraphics(), &presentInfo );
+            if( presentId )
+            {
+                framePacer->OnPresent( sw, *presentId );
+            }
+            swapchain->OnQueuePresent( r );
+
+            // without vsync, nothing spaces out the two presents,
+            // so hold the rendered frame for a half of the previous frame interval
+            if( !swapchain->IsVSync() )
+            {
+                RG_CPU_ZONE( "Frame generation pacing" );
+
+                double halfInterval = 0.5 * ( currentFrameTime - previousFrameTime );
+                std::this_thread::sleep_for(
+                    std::chrono::duration< double >( std::clamp( halfInterval, 0.0, 0.05 ) ) );
+            }
+
+            cmd            = cmdManager->StartGraphicsCmd();
+            initFinished   = VK_NULL_HANDLE;
+            imageAvailable = vkswapchainAnotherAvailableSemaphores[ frameIndex ];
+
+            if( !swapchain->Valid() || !swapchain->AcquireAnotherImage( imageAvailable ) )
+            {
+                imageAvailable = VK_NULL_HANDLE;
+            }
+        }
+
         // copy to swapchain's back buffer
+        if( imageAvailable )
         {
             framebuffers->BarrierOne( cmd, frameIndex, rendered );
 
@@ -1273,30 +1794,44 @@ void RTGL1::VulkanDevice::EndFrame( VkCommandBuffer cmd, FramebufferImageIndex r
 
         uint32_t    towait_count = 0;
         VkSemaphore towait[ 2 ]  = {};
-        if( swapchain->Valid() )
+        if( imageAvailable )
         {
-            towait[ towait_count++ ] = vkswapchainAvailableSemaphores[ frameIndex ];
+            towait[ towait_count++ ] = imageAvailable;
         }
-        if( initFrameFinished )
+        if( initFinished )
         {
-            towait[ towait_count++ ] = initFrameFinished;
+            towait[ towait_count++ ] = initFinished;
         }
 
         cmdManager->Submit_Binary( //
             cmd,
             std::span{ towait, towait_count },
-            emulatedSemaphores[ frameIndex ], // signal
+            imageAvailable ? emulatedSemaphores[ frameIndex ] : VK_NULL_HANDLE, // signal
             frameFences[ frameIndex ] );
 
-        if( swapchain->Valid() )
+        if( imageAvailable )
         {
             VkResult       r       = VK_SUCCESS;
             VkSwapchainKHR sw      = swapchain->GetHandle();
             uint32_t       swIndex = swapchain->GetCurrentImageIndex();
 
+            // to match with the latency markers, and to wait for it in the next frames
+            std::optional< uint64_t > presentId = lowLatency->GetPresentId();
+            if( !presentId )
+            {
+                presentId = framePacer->GetPresentId( frameId );
+            }
+
+            auto presentIdInfo = VkPresentIdKHR{
+                .sType          = VK_STRUCTURE_TYPE_PRESENT_ID_KHR,
+                .swapchainCount = 1,
+                .pPresentIds    = presentId ? &presentId.value() : nullptr,
+            };
+
             // present to surfaces after finishing the rendering
             auto presentInfo = VkPresentInfoKHR{
                 .sType              = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+                .pNext              = presentId ? &presentIdInfo : nullptr,
                 .waitSemaphoreCount = 1,
                 .pWaitSemaphores    = &emulatedSemaphores[ frameIndex ],
                 .swapchainCount     = 1,
@@ -1313,6 +1848,7 @@ void RTGL1::VulkanDevice::EndFrame( VkCommandBuffer cmd, FramebufferImageIndex r
     {
         nvDlss3dx12->Reflex_PresentEnd();
     }
+    lowLatency->Marker( swapchain->GetNativeHandle(), VK_LATENCY_MARKER_PRESENT_END_NV );
 
     frameId++;
 
@@ -1345,6 +1881,10 @@ void RTGL1::VulkanDevice::StartFrame( const RgStartFrameInfo* pOriginalInfo )
         throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
     }
 
+    cpuprofiler::BeginFrame( frameId );
+    hitchrecorder::BeginFrame( frameId );
+    RG_CPU_ZONE( "rgStartFrame" );
+
     auto startFrame_Core = [ this ]( const RgStartFrameInfo& info ) {
         VkCommandBuffer newFrameCmd = BeginFrame( info );
         currentFrameState.OnBeginFrame( newFrameCmd );
@@ -1391,6 +1931,13 @@ void RTGL1::VulkanDevice::DrawFrame( const RgDrawFrameInfo* pOriginalInfo )
         throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
     }
 
+    RG_CPU_ZONE( "rgDrawFrame" );
+
+    retainedMeshes.ForEach(
+        [ this ]( const RgMeshInfo& mesh, std::span< const RgMeshPrimitiveInfo > primitives ) {
+            UploadMeshPrimitives_NoLock( &mesh, primitives );
+        } );
+
     DrawEndUserWarnings();
 
     auto drawFrame_Core = [ this ]( const RgDrawFrameInfo& info ) {
@@ -1409,6 +1956,8 @@ void RTGL1::VulkanDevice::DrawFrame( const RgDrawFrameInfo* pOriginalInfo )
             nvDlss3dx12->Reflex_SimEnd();
             nvDlss3dx12->Reflex_RenderStart();
         }
+        lowLatency->Marker( swapchain->GetNativeHandle(), VK_LATENCY_MARKER_SIMULATION_END_NV );
+        lowLatency->Marker( swapchain->GetNativeHandle(), VK_LATENCY_MARKER_RENDERSUBMIT_START_NV );
 
         FramebufferImageIndex rendered;
 
@@ -1428,6 +1977,8 @@ void RTGL1::VulkanDevice::DrawFrame( const RgDrawFrameInfo* pOriginalInfo )
 
 
         sceneImportExport->TryExport( *textureManager, ovrdFolder );
+
+        cpuprofiler::EndFrame();
     };
 
     auto drawFrame_WithScene = [ this, &drawFrame_Core ]( const RgDrawFrameInfo& original ) {
@@ -1516,19 +2067,79 @@ namespace
 void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
                                                const RgMeshPrimitiveInfo* pPrimitive )
 {
-    if( pPrimitive == nullptr )
+    if( validateInput && pPrimitive == nullptr )
     {
         throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
     }
-    if( pPrimitive->sType != RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO )
+    UploadMeshPrimitives( pMesh, pPrimitive, 1 );
+}
+
+void RTGL1::VulkanDevice::UploadMeshPrimitives( const RgMeshInfo*          pMesh,
+                                                const RgMeshPrimitiveInfo* pPrimitives,
+                                                uint32_t                   primitiveCount )
+{
+    if( validateInput && pPrimitives == nullptr && primitiveCount > 0 )
     {
-        throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
     }
-    if( pPrimitive->vertexCount == 0 || pPrimitive->pVertices == nullptr )
+
+    RG_CPU_ZONE( "rgUploadMeshPrimitive" );
+
+    const auto primitives = std::span{ pPrimitives, primitiveCount };
+
+    if( !multithreadedUpload )
     {
+        UploadMeshPrimitives_NoLock( pMesh, primitives );
         return;
     }
-    Dev_TryBreak( pPrimitive->pTextureName, false );
+
+    // vertex data is copied to staging after unlocking, in parallel with other threads;
+    // user's arrays are valid until the return
+    auto copies = VertexCollector::DeferredStagingCopies{};
+    auto lock   = std::lock_guard{ uploadMutex };
+
+    UploadMeshPrimitives_NoLock( pMesh, primitives );
+}
+
+void RTGL1::VulkanDevice::UploadMeshPrimitives_NoLock(
+    const RgMeshInfo* pMesh, std::span< const RgMeshPrimitiveInfo > primitives )
+{
+    // mesh-level checks are done once for all primitives
+    if( validateInput && pMesh )
+    {
+        if( pMesh->sType != RG_STRUCTURE_TYPE_MESH_INFO )
+        {
+            throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
+        }
+        if( pMesh->flags & RG_MESH_EXPORT_AS_SEPARATE_FILE )
+        {
+            if( !pMesh->isExportable )
+            {
+                throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT,
+                                   "RG_MESH_INFO_EXPORT_AS_SEPARATE_FILE is set, "
+                                   "expected isExportable to be true" );
+            }
+        }
+    }
+
+    // registered names are resolved once here, so the rest sees plain c-strings
+    auto resolvedMesh = std::optional< RgMeshInfo >{};
+    if( auto handleExt = pnext::find< RgMeshNameHandleEXT >( pMesh ) )
+    {
+        if( handleExt->meshName != 0 )
+        {
+            resolvedMesh            = *pMesh;
+            resolvedMesh->pMeshName = nameRegistry.Get( handleExt->meshName );
+            pMesh                   = &resolvedMesh.value();
+        }
+    }
+
+    // ignore replacement, if the scene requires
+    const bool replacementIgnored =
+        pMesh && pMesh->isExportable && ( pMesh->flags & RG_MESH_EXPORT_AS_SEPARATE_FILE ) &&
+        !Utils::IsCstrEmpty( pMesh->pMeshName ) &&
+        sceneMetaManager->IsReplacementIgnored( sceneImportExport->GetImportMapName(),
+                                                pMesh->pMeshName );
 
 
     auto logDebugStat = [ this ]( Devmode::DebugPrimMode     mode,
@@ -1594,6 +2205,21 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
                                                          const RgMeshPrimitiveInfo& prim ) {
         assert( !pnext::find< RgMeshPrimitiveSwapchainedEXT >( &prim ) );
 
+        // GPU skinning is only for ray tracing, others need the posed vertices on CPU
+        auto posed   = std::optional< RgMeshPrimitiveInfo >{};
+        auto l_posed = [ & ]() -> const RgMeshPrimitiveInfo& {
+            if( !posed )
+            {
+                posed     = prim;
+                auto skin = pnext::find< RgMeshPrimitiveSkinningEXT >( &prim );
+                if( skin && SkinVerticesOnCPU( prim, *skin, tempStorageSkinned ) )
+                {
+                    posed->pVertices = tempStorageSkinned.data();
+                }
+            }
+            return *posed;
+        };
+
         if( IsRasterized( mesh, prim ) )
         {
             rasterizer->Upload( currentFrameState.GetFrameIndex(),
@@ -1601,7 +2227,7 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
                                 : prim.flags & RG_MESH_PRIMITIVE_DECAL ? GeometryRasterType::DECAL
                                                                        : GeometryRasterType::WORLD,
                                 mesh.transform,
-                                prim,
+                                l_posed(),
                                 nullptr,
                                 nullptr );
 
@@ -1620,6 +2246,13 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
                                                      *lightManager,
                                                      false );
 
+            // particle quads exist only on GPU, so there's nothing to rasterize or export
+            if( pnext::find< RgMeshPrimitiveParticlesEXT >( &prim ) )
+            {
+                logDebugStat( Devmode::DebugPrimMode::RayTraced, &mesh, prim, r );
+                return;
+            }
+
             if( lightmapScreenCoverage > 0 )
             {
                 if( !( mesh.flags & RG_MESH_FIRST_PERSON_VIEWER ) )
@@ -1627,7 +2260,7 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
                     rasterizer->Upload( currentFrameState.GetFrameIndex(),
                                         GeometryRasterType::WORLD_CLASSIC,
                                         mesh.transform,
-                                        prim,
+                                        l_posed(),
                                         nullptr,
                                         nullptr );
                 }
@@ -1658,7 +2291,7 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
 
                 if( allowMeshExport( mesh ) )
                 {
-                    e->AddPrimitive( mesh, prim );
+                    e->AddPrimitive( mesh, l_posed() );
                 }
 
                 // SHIPPING_HACK: add lights to the scene gltf even for non-exportable geometry
@@ -1762,17 +2395,11 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
 
     // --- //
 
-    auto uploadPrimitive_WithMeta = [ this, &uploadPrimitive_Core ](
+    auto uploadPrimitive_WithMeta = [ this, &uploadPrimitive_Core, replacementIgnored ](
                                         const RgMeshInfo& mesh, const RgMeshPrimitiveInfo& prim ) {
-        // ignore replacement, if the scene requires
-        if( mesh.isExportable && ( mesh.flags & RG_MESH_EXPORT_AS_SEPARATE_FILE ) &&
-            !Utils::IsCstrEmpty( mesh.pMeshName ) )
+        if( replacementIgnored )
         {
-            if( sceneMetaManager->IsReplacementIgnored( sceneImportExport->GetImportMapName(),
-                                                        mesh.pMeshName ) )
-            {
-                return;
-            }
+            return;
         }
 
         auto modified = RgMeshPrimitiveInfo{ prim };
@@ -1780,14 +2407,17 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
         auto modified_attachedLight = std::optional< RgMeshPrimitiveAttachedLightEXT >{};
         auto modified_pbr           = std::optional< RgMeshPrimitivePBREXT >{};
 
-        if( auto original = pnext::find< RgMeshPrimitiveAttachedLightEXT >( &prim ) )
+        const auto [ originalAttachedLight, originalPbr ] =
+            pnext::findAll< RgMeshPrimitiveAttachedLightEXT, RgMeshPrimitivePBREXT >( &prim );
+
+        if( originalAttachedLight )
         {
-            modified_attachedLight = *original;
+            modified_attachedLight = *originalAttachedLight;
         }
 
-        if( auto original = pnext::find< RgMeshPrimitivePBREXT >( &prim ) )
+        if( originalPbr )
         {
-            modified_pbr = *original;
+            modified_pbr = *originalPbr;
         }
 
         if( mesh.flags & RG_MESH_FORCE_MIRROR )
@@ -1822,23 +2452,38 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
             modified.pNext             = &modified_pbr.value();
         }
 
+        // ray-traced particles are expanded on GPU, but the rasterized ones are needed on CPU
+        if( auto particles = pnext::find< RgMeshPrimitiveParticlesEXT >( &modified ) )
+        {
+            if( IsRasterized( mesh, modified ) )
+            {
+                const auto& camera = scene->GetCamera( renderResolution.Aspect() );
+                ParticleExpansion::ExpandOnCPU(
+                    *particles, mesh.transform, camera.view, tempStorageParticles );
+
+                if( tempStorageParticles.empty() )
+                {
+                    return;
+                }
+
+                modified.pVertices   = tempStorageParticles.data();
+                modified.vertexCount = uint32_t( tempStorageParticles.size() );
+                modified.pIndices    = nullptr;
+                modified.pIndices16  = nullptr;
+                modified.indexCount  = 0;
+            }
+        }
+
         uploadPrimitive_Core( mesh, modified );
     };
 
     // --- //
 
     auto uploadPrimitive_FilterSwapchained = [ this, &uploadPrimitive_WithMeta, &logDebugStat ](
-                                                 const RgMeshInfo*          mesh,
-                                                 const RgMeshPrimitiveInfo& prim ) {
-        if( mesh )
-        {
-            if( mesh->sType != RG_STRUCTURE_TYPE_MESH_INFO )
-            {
-                throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
-            }
-        }
-
-        if( auto raster = pnext::find< RgMeshPrimitiveSwapchainedEXT >( &prim ) )
+                                                 const RgMeshInfo*                    mesh,
+                                                 const RgMeshPrimitiveInfo&           prim,
+                                                 const RgMeshPrimitiveSwapchainedEXT* raster ) {
+        if( raster )
         {
             float vp[ 16 ];
             if( raster->pViewProjection )
@@ -1865,19 +2510,10 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
         }
         else
         {
-            if( mesh == nullptr )
+            if( validateInput && mesh == nullptr )
             {
                 throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
             }
-            if( mesh->flags & RG_MESH_EXPORT_AS_SEPARATE_FILE )
-            {
-                if( !mesh->isExportable )
-                {
-                    throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT,
-                                       "RG_MESH_INFO_EXPORT_AS_SEPARATE_FILE is set, "
-                                       "expected isExportable to be true" );
-                }
-            }
 
             uploadPrimitive_WithMeta( *mesh, prim );
         }
@@ -1885,7 +2521,148 @@ void RTGL1::VulkanDevice::UploadMeshPrimitive( const RgMeshInfo*          pMesh,
 
     // --- //
 
-    uploadPrimitive_FilterSwapchained( pMesh, *pPrimitive );
+    for( const RgMeshPrimitiveInfo& prim : primitives )
+    {
+        if( validateInput && prim.sType != RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO )
+        {
+            throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
+        }
+
+        const auto [ handleExt, swapchained, particles ] =
+            pnext::findAll< RgMeshPrimitiveNameHandleEXT,
+                            RgMeshPrimitiveSwapchainedEXT,
+                            RgMeshPrimitiveParticlesEXT >( &prim );
+
+        if( particles )
+        {
+            if( particles->particleCount == 0 || particles->pParticles == nullptr )
+            {
+                continue;
+            }
+            if( swapchained )
+            {
+                debug::Warning( "RgMeshPrimitiveParticlesEXT is not supported for swapchained "
+                                "primitives, ignoring" );
+                continue;
+            }
+        }
+        else if( prim.vertexCount == 0 || prim.pVertices == nullptr )
+        {
+            continue;
+        }
+
+        const RgMeshPrimitiveInfo* resolved = &prim;
+
+        auto withName = RgMeshPrimitiveInfo{};
+        if( handleExt )
+        {
+            if( handleExt->textureName != 0 )
+            {
+                withName              = prim;
+                withName.pTextureName = nameRegistry.Get( handleExt->textureName );
+                resolved              = &withName;
+            }
+        }
+
+        Dev_TryBreak( resolved->pTextureName, false );
+
+        uploadPrimitive_FilterSwapchained( pMesh, *resolved, swapchained );
+    }
+}
+
+void RTGL1::VulkanDevice::CreateMesh( const RgMeshInfo*          pMesh,
+                                      const RgMeshPrimitiveInfo* pPrimitives,
+                                      uint32_t                   primitiveCount,
+                                      RgMeshHandle*              pOutMesh )
+{
+    if( pMesh == nullptr || pOutMesh == nullptr ||
+        ( pPrimitives == nullptr && primitiveCount > 0 ) )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+    if( pMesh->sType != RG_STRUCTURE_TYPE_MESH_INFO )
+    {
+        throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
+    }
+    if( ( pMesh->flags & RG_MESH_EXPORT_AS_SEPARATE_FILE ) && !pMesh->isExportable )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT,
+                           "RG_MESH_INFO_EXPORT_AS_SEPARATE_FILE is set, "
+                           "expected isExportable to be true" );
+    }
+
+    const auto primitives = std::span{ pPrimitives, primitiveCount };
+
+    for( const RgMeshPrimitiveInfo& prim : primitives )
+    {
+        if( prim.sType != RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO )
+        {
+            throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
+        }
+        if( pnext::find< RgMeshPrimitiveSwapchainedEXT >( &prim ) )
+        {
+            throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT,
+                               "RgMeshPrimitiveSwapchainedEXT can't be used with rgCreateMesh" );
+        }
+        if( prim.vertexCount > 0 && prim.pVertices == nullptr )
+        {
+            throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+        }
+    }
+
+    auto lock = std::unique_lock{ uploadMutex, std::defer_lock };
+    if( multithreadedUpload )
+    {
+        lock.lock();
+    }
+
+    *pOutMesh = retainedMeshes.Create( *pMesh, primitives, nameRegistry );
+}
+
+void RTGL1::VulkanDevice::UpdateMeshTransform( RgMeshHandle       mesh,
+                                               const RgTransform* pTransform,
+                                               RgMeshInfoFlags    flags )
+{
+    if( pTransform == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+
+    auto lock = std::unique_lock{ uploadMutex, std::defer_lock };
+    if( multithreadedUpload )
+    {
+        lock.lock();
+    }
+
+    if( !retainedMeshes.SetTransform( mesh, *pTransform, flags ) )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Mesh handle is invalid" );
+    }
+}
+
+void RTGL1::VulkanDevice::DestroyMesh( RgMeshHandle mesh )
+{
+    auto lock = std::unique_lock{ uploadMutex, std::defer_lock };
+    if( multithreadedUpload )
+    {
+        lock.lock();
+    }
+
+    if( !retainedMeshes.Destroy( mesh ) )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Mesh handle is invalid" );
+    }
+}
+
+auto RTGL1::VulkanDevice::RegisterName( const char* pName ) -> RgNameHandle
+{
+    auto lock = std::unique_lock{ uploadMutex, std::defer_lock };
+    if( multithreadedUpload )
+    {
+        lock.lock();
+    }
+
+    return nameRegistry.Register( Utils::SafeCstr( pName ) );
 }
 
 void RTGL1::VulkanDevice::UploadLensFlare( const RgLensFlareInfo* pInfo )
@@ -1945,6 +2722,23 @@ void RTGL1::VulkanDevice::SpawnFluid( const RgSpawnFluidInfo* pInfo )
     fluid->AddSource( *pInfo );
 }
 
+void RTGL1::VulkanDevice::RequestReadback( const RgReadbackRequestInfo* pInfo )
+{
+    if( pInfo == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
+    }
+    if( pInfo->sType != RG_STRUCTURE_TYPE_READBACK_REQUEST_INFO )
+    {
+        throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
+    }
+    if( pInfo->pfnCallback == nullptr )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "pfnCallback is null" );
+    }
+    frameReadback->Request( *pInfo );
+}
+
 void RTGL1::VulkanDevice::UploadCamera( const RgCameraInfo* pInfo )
 {
     if( pInfo == nullptr )
@@ -2002,48 +2796,45 @@ void RTGL1::VulkanDevice::UploadCamera( const RgCameraInfo* pInfo )
 
 void RTGL1::VulkanDevice::UploadLight( const RgLightInfo* pInfo )
 {
-    if( pInfo == nullptr )
-    {
-        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
-    }
-    if( pInfo->sType != RG_STRUCTURE_TYPE_LIGHT_INFO )
+    if( validateInput )
     {
-        throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
-    }
-
-    auto findExt =
-        []( const RgLightInfo& info ) -> std::optional< std::variant< RgLightDirectionalEXT,
-                                                                      RgLightSphericalEXT,
-                                                                      RgLightSpotEXT,
-                                                                      RgLightPolygonalEXT > > {
-        if( auto l = pnext::find< RgLightDirectionalEXT >( &info ) )
-        {
-            return *l;
-        }
-        if( auto l = pnext::find< RgLightSphericalEXT >( &info ) )
+        if( pInfo == nullptr )
         {
-            return *l;
+            throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT, "Argument is null" );
         }
-        if( auto l = pnext::find< RgLightSpotEXT >( &info ) )
+        if( pInfo->sType != RG_STRUCTURE_TYPE_LIGHT_INFO )
         {
-            return *l;
+            throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
         }
-        if( auto l = pnext::find< RgLightPolygonalEXT >( &info ) )
-        {
-            return *l;
-        }
-        return {};
-    };
+    }
 
-    auto findAdditional = []( const RgLightInfo& info ) -> std::optional< RgLightAdditionalEXT > {
-        if( auto l = pnext::find< RgLightAdditionalEXT >( &info ) )
-        {
-            return *l;
-        }
-        return {};
-    };
+    RG_CPU_ZONE( "rgUploadLight" );
+
+    const auto [ directional, spherical, spot, polygonal, additional ] =
+        pnext::findAll< RgLightDirectionalEXT,
+                        RgLightSphericalEXT,
+                        RgLightSpotEXT,
+                        RgLightPolygonalEXT,
+                        RgLightAdditionalEXT >( pInfo );
+
+    auto ext = std::optional< AnyLightEXT >{};
+    if( directional )
+    {
+        ext = *directional;
+    }
+    else if( spherical )
+    {
+        ext = *spherical;
+    }
+    else if( spot )
+    {
+        ext = *spot;
+    }
+    else if( polygonal )
+    {
+        ext = *polygonal;
+    }
 
-    auto ext = findExt( *pInfo );
     if( !ext )
     {
         debug::Warning( "Couldn't find RgLightDirectionalEXT, RgLightSphericalEXT, RgLightSpotEXT "
@@ -2055,7 +2846,7 @@ void RTGL1::VulkanDevice::UploadLight( const RgLightInfo* pInfo )
     auto light = LightCopy{
         .base       = *pInfo,
         .extension  = *ext,
-        .additional = findAdditional( *pInfo ),
+        .additional = additional ? std::optional{ *additional } : std::nullopt,
     };
 
     // reset pNext, as using in-place members
@@ -2090,6 +2881,14 @@ void RTGL1::VulkanDevice::ProvideOriginalTexture( const RgOriginalTextureInfo* p
     {
         throw RgException( RG_RESULT_WRONG_STRUCTURE_TYPE );
     }
+
+    // can be called from any thread, so only the queue of the texture manager is accessed
+    if( auto async = pnext::find< RgOriginalTextureAsyncEXT >( pInfo ) )
+    {
+        textureManager->ProvideOriginalAsync( *pInfo, *async );
+        return;
+    }
+
     Dev_TryBreak( pInfo->pTextureName, true );
 
     textureManager->TryCreateMaterial( currentFrameState.GetCmdBufferForMaterials( cmdManager ),
@@ -2097,16 +2896,21 @@ void RTGL1::VulkanDevice::ProvideOriginalTexture( const RgOriginalTextureInfo* p
                                        *pInfo,
                                        ovrdFolder );
 
+    Hack_PatchStaticPrimitiveTextures( pInfo->pTextureName );
+}
+
+void RTGL1::VulkanDevice::Hack_PatchStaticPrimitiveTextures( const char* pTextureName )
+{
     // SHIPPING_HACK begin
-    if( !Utils::IsCstrEmpty( pInfo->pTextureName ) )
+    if( !Utils::IsCstrEmpty( pTextureName ) )
     {
-        auto texturesToUpdateOnStaticGeom = scene->m_primitivesToUpdateTextures.find( pInfo->pTextureName );
+        auto texturesToUpdateOnStaticGeom = scene->m_primitivesToUpdateTextures.find( pTextureName );
         if( texturesToUpdateOnStaticGeom != scene->m_primitivesToUpdateTextures.end() )
         {
             for( const PrimitiveUniqueID& geomUniqueId : texturesToUpdateOnStaticGeom->second )
             {
                 scene->GetASManager()->Hack_PatchTexturesForStaticPrimitive(
-                    geomUniqueId, pInfo->pTextureName, *textureManager );
+                    geomUniqueId, pTextureName, *textureManager );
             }
         }
     }
@@ -2145,6 +2949,12 @@ bool RTGL1::VulkanDevice::IsUpscaleTechniqueAvailable( RgRenderUpscaleTechnique
                 const char* error = swapchain->FailReason( SWAPCHAIN_TYPE_FRAME_GENERATION_FSR3 );
                 assert( error == nullptr || error[ 0 ] != '\0' );
 
+                // fallback to a native Vulkan swapchain
+                if( amdFsr2 && amdFsr3vk && amdFsr3vk->IsAvailable() )
+                {
+                    error = nullptr;
+                }
+
                 if( ppFailureReason )
                 {
                     *ppFailureReason = error;
@@ -2217,7 +3027,55 @@ RgUtilMemoryUsage RTGL1::VulkanDevice::RequestMemoryUsage() const
         r_usage    = RTGL1::RequestMemoryUsage( physDevice->Get() );
     }
 
-    return r_usage;
+    // cheap, so always of the last frame
+    const auto stats      = scene->GetASManager()->GetInstanceStats();
+    const auto allocStats = scene->GetASManager()->GetAllocatorStats();
+    const auto drawStats  = rasterizer->GetDrawStats();
+
+    auto usage                = r_usage;
+    usage.tlasInstanceCount   = stats.instanceCount;
+    usage.tlasInstancesCulled = stats.culledCount;
+    usage.asPoolsAllocated    = allocStats.allocatedSize;
+    usage.asPoolsPeakUsed     = allocStats.peakUsedSize;
+    usage.asPoolsWasted       = allocStats.wastedSize;
+    usage.asPoolsChunkCount   = allocStats.chunkCount;
+
+    usage.rasterizedDrawCount        = drawStats.drawCount;
+    usage.rasterizedDrawCallCount    = drawStats.drawCallCount;
+    usage.rasterizedPipelineSwitches = drawStats.pipelineSwitches;
+    usage.rasterizedVertexCount      = drawStats.storage.vertexCount;
+    usage.rasterizedVertexCapacity   = drawStats.storage.vertexCapacity;
+    usage.rasterizedIndexCount       = drawStats.storage.indexCount;
+    usage.rasterizedIndexCapacity    = drawStats.storage.indexCapacity;
+    usage.rasterizedDroppedCount     = drawStats.storage.droppedCount;
+
+    if( fluid )
+    {
+        const auto fluidStats      = fluid->GetStats();
+        usage.fluidParticleCount   = fluidStats.particleCount;
+        usage.fluidParticlesCulled = fluidStats.culledCount;
+    }
+
+    MemoryAllocator::GetCategoryUsage( usage.categories );
+    return usage;
+}
+
+RgUtilHeadlessFrame RTGL1::VulkanDevice::GetHeadlessFrame() const
+{
+    if( !currentFrameState.WasFrameStarted() )
+    {
+        return RgUtilHeadlessFrame{};
+    }
+
+    // the fence for this frame index was waited in rgStartFrame
+    return swapchain->GetHeadlessFrame( currentFrameState.GetFrameIndex() );
+}
+
+RgUtilFrameTimings RTGL1::VulkanDevice::GetFrameTimings() const
+{
+    RgUtilFrameTimings timings = gpuProfiler->GetTimings();
+    timings.presentLatency     = framePacer->GetPresentLatency();
+    return timings;
 }
 
 RgPrimitiveVertex* RTGL1::VulkanDevice::ScratchAllocForVertices( uint32_t vertexCount )
@@ -2232,6 +3090,24 @@ void RTGL1::VulkanDevice::ScratchFree( const RgPrimitiveVertex* pPointer )
     delete[] pPointer;
 }
 
+RgPrimitiveVertex* RTGL1::VulkanDevice::StagingAllocForVertices( uint32_t vertexCount )
+{
+    if( !currentFrameState.WasFrameStarted() )
+    {
+        throw RgException( RG_RESULT_FRAME_WASNT_STARTED );
+    }
+
+    const uint32_t frameIndex = currentFrameState.GetFrameIndex();
+
+    if( !multithreadedUpload )
+    {
+        return scene->GetASManager()->ReserveDynamicVertices( frameIndex, vertexCount );
+    }
+
+    auto lock = std::lock_guard{ uploadMutex };
+    return scene->GetASManager()->ReserveDynamicVertices( frameIndex, vertexCount );
+}
+
 void RTGL1::VulkanDevice::Print( std::string_view msg, RgMessageSeverityFlags severity ) const
 {
     static auto printMutex = std::mutex{};
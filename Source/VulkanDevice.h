@@ -23,12 +23,16 @@
 #include <RTGL1/RTGL1.h>
 
 #include <memory>
+#include <mutex>
+#include <span>
 
 // clang-format off
 #include "Common.h"
 
 #include "CommandBufferManager.h"
+#include "DeletionQueue.h"
 #include "PhysicalDevice.h"
+#include "PipelineCache.h"
 #include "Scene.h"
 #include "Swapchain.h"
 #include "Queues.h"
@@ -37,34 +41,46 @@
 #include "Rasterizer.h"
 #include "Framebuffers.h"
 #include "MemoryAllocator.h"
+#include "MipmapGenerator.h"
 #include "TextureManager.h"
 #include "BlueNoise.h"
 #include "ImageComposition.h"
 #include "Tonemapping.h"
 #include "CubemapManager.h"
 #include "Denoiser.h"
+#include "NoisyComposition.h"
 #include "UserFunction.h"
 #include "Bloom.h"
 #include "Sharpening.h"
 #include "DLSS2.h"
 #include "DLSS3_DX12.h"
+#include "DynamicResolution.h"
+#include "GpuProfiler.h"
+#include "LowLatency.h"
+#include "FramePacer.h"
 #include "RenderResolutionHelper.h"
 #include "EffectWipe.h"
 #include "EffectSimple_Instances.h"
 #include "LightGrid.h"
 #include "FSR2.h"
 #include "FSR3_DX12.h"
+#include "FSR3_VK.h"
 #include "FrameState.h"
 #include "PortalList.h"
 #include "RestirBuffers.h"
+#include "IrradianceCache.h"
 #include "Volumetric.h"
 #include "DebugWindows.h"
 #include "ScratchImmediate.h"
 #include "FolderObserver.h"
 #include "TextureMeta.h"
 #include "SceneMeta.h"
+#include "NameRegistry.h"
+#include "RetainedMeshes.h"
 #include "DrawFrameInfo.h"
 #include "Fluid.h"
+#include "RayCostStats.h"
+#include "FrameReadback.h"
 #include "VulkanDevice_Dev.h"
 // clang-format on
 
@@ -86,8 +102,24 @@ public:
     VulkanDevice& operator=( VulkanDevice&& other ) noexcept = delete;
 
     void UploadMeshPrimitive( const RgMeshInfo* pMesh, const RgMeshPrimitiveInfo* pPrimitive );
+    void UploadMeshPrimitives( const RgMeshInfo*          pMesh,
+                               const RgMeshPrimitiveInfo* pPrimitives,
+                               uint32_t                   primitiveCount );
+    void UploadMeshPrimitives_NoLock( const RgMeshInfo*                      pMesh,
+                                      std::span< const RgMeshPrimitiveInfo > primitives );
     void UploadLensFlare( const RgLensFlareInfo* pInfo );
     void SpawnFluid( const RgSpawnFluidInfo* pInfo );
+    // Can be called from any thread
+    void RequestReadback( const RgReadbackRequestInfo* pInfo );
+    auto RegisterName( const char* pName ) -> RgNameHandle;
+    void CreateMesh( const RgMeshInfo*          pMesh,
+                     const RgMeshPrimitiveInfo* pPrimitives,
+                     uint32_t                   primitiveCount,
+                     RgMeshHandle*              pOutMesh );
+    void UpdateMeshTransform( RgMeshHandle       mesh,
+                              const RgTransform* pTransform,
+                              RgMeshInfoFlags    flags );
+    void DestroyMesh( RgMeshHandle mesh );
 
     void UploadCamera( const RgCameraInfo* pInfo );
 
@@ -105,12 +137,15 @@ public:
                                       RgFrameGenerationMode    frameGeneration,
                                       const char**             ppFailureReason ) const;
 
-    bool              IsDXGIAvailable( const char** ppFailureReason ) const;
-    RgFeatureFlags    GetSupportedFeatures() const;
-    RgUtilMemoryUsage RequestMemoryUsage() const;
+    bool                IsDXGIAvailable( const char** ppFailureReason ) const;
+    RgFeatureFlags      GetSupportedFeatures() const;
+    RgUtilMemoryUsage   RequestMemoryUsage() const;
+    RgUtilFrameTimings  GetFrameTimings() const;
+    RgUtilHeadlessFrame GetHeadlessFrame() const;
 
     RgPrimitiveVertex* ScratchAllocForVertices( uint32_t count );
     void               ScratchFree( const RgPrimitiveVertex* pPointer );
+    RgPrimitiveVertex* StagingAllocForVertices( uint32_t count );
     ScratchImmediate&  ScratchIm() { return scratchImmediate; }
 
 
@@ -134,6 +169,7 @@ private:
     void            EndFrame( VkCommandBuffer cmd, FramebufferImageIndex rendered );
 
     void DrawEndUserWarnings();
+    void Hack_PatchStaticPrimitiveTextures( const char* pTextureName );
 
 private:
     bool Dev_IsDevmodeInitialized() const;
@@ -150,7 +186,9 @@ private:
 private:
     VkInstance   instance;
     VkDevice     device;
+    // Null, if headless
     VkSurfaceKHR surface;
+    bool         headless;
 
     FrameState currentFrameState;
 
@@ -163,6 +201,9 @@ private:
     VkSemaphore inFrameSemaphores[ MAX_FRAMES_IN_FLIGHT ]        = {};
     VkSemaphore vkswapchainAvailableSemaphores[ MAX_FRAMES_IN_FLIGHT ] = {};
     VkSemaphore emulatedSemaphores[ MAX_FRAMES_IN_FLIGHT ]       = {};
+    // for presenting a generated frame before the rendered one
+    VkSemaphore vkswapchainAnotherAvailableSemaphores[ MAX_FRAMES_IN_FLIGHT ] = {};
+    VkSemaphore generatedFinishedSemaphores[ MAX_FRAMES_IN_FLIGHT ]           = {};
 
     bool    waitForOutOfFrameFence;
     VkFence outOfFrameFences[ MAX_FRAMES_IN_FLIGHT ] = {};
@@ -176,16 +217,19 @@ private:
     std::shared_ptr< MemoryAllocator > memAllocator;
 
     std::shared_ptr< CommandBufferManager > cmdManager;
+    std::shared_ptr< DeletionQueue >        deletionQueue;
 
     std::shared_ptr< Framebuffers >  framebuffers;
-    std::shared_ptr< RestirBuffers > restirBuffers;
-    std::shared_ptr< Volumetric >    volumetric;
-    std::shared_ptr< Fluid >         fluid;
+    std::shared_ptr< RestirBuffers >   restirBuffers;
+    std::shared_ptr< IrradianceCache > irradianceCache;
+    std::shared_ptr< Volumetric >      volumetric;
+    std::shared_ptr< Fluid >           fluid;
 
     std::shared_ptr< GlobalUniform >     uniform;
     std::shared_ptr< Scene >             scene;
     std::shared_ptr< SceneImportExport > sceneImportExport;
 
+    std::shared_ptr< PipelineCache >             pipelineCache;
     std::shared_ptr< ShaderManager >             shaderManager;
     std::shared_ptr< RayTracingPipeline >        rtPipeline;
     std::shared_ptr< PathTracer >                pathTracer;
@@ -193,14 +237,23 @@ private:
     std::shared_ptr< PortalList >                portalList;
     std::shared_ptr< LightManager >              lightManager;
     std::shared_ptr< LightGrid >                 lightGrid;
-    std::shared_ptr< Denoiser >                  denoiser;
+    std::shared_ptr< IDenoiser >                 denoiser;
+    // if DLSS Ray Reconstruction is enabled
+    std::shared_ptr< IDenoiser >                 noisyComposition;
     std::shared_ptr< Tonemapping >               tonemapping;
     std::shared_ptr< ImageComposition >          imageComposition;
     std::shared_ptr< Bloom >                     bloom;
     std::shared_ptr< FSR2 >                      amdFsr2;
     std::shared_ptr< FSR3_DX12 >                 amdFsr3dx12;
+    std::shared_ptr< FSR3_VK >                   amdFsr3vk;
     std::shared_ptr< DLSS2 >                     nvDlss2;
     std::shared_ptr< DLSS3_DX12 >                nvDlss3dx12;
+    std::shared_ptr< DynamicResolution >         dynamicResolution;
+    std::shared_ptr< GpuProfiler >               gpuProfiler;
+    std::shared_ptr< RayCostStats >              rayCostStats;
+    std::shared_ptr< FrameReadback >             frameReadback;
+    std::shared_ptr< LowLatency >                lowLatency;
+    std::shared_ptr< FramePacer >                framePacer;
     std::shared_ptr< Sharpening >                sharpening;
     std::shared_ptr< EffectWipe >                effectWipe;
     std::shared_ptr< EffectRadialBlur >          effectRadialBlur;
@@ -216,12 +269,15 @@ private:
     std::shared_ptr< EffectCrtDecode >           effectCrtDecode;
     std::shared_ptr< EffectVHS >                 effectVHS;
     std::shared_ptr< EffectDither >              effectDither;
+    std::shared_ptr< EffectFusedPointwise >      effectFusedPointwise[ EFFECT_FUSED_PERMUTATION_COUNT ];
     std::shared_ptr< EffectHDRPrepare >          effectHDRPrepare;
+    std::shared_ptr< EffectHDRPrepare >          effectHDRPrepareWithDither;
 
     std::shared_ptr< SamplerManager >     worldSamplerManager;
     std::shared_ptr< SamplerManager >     genericSamplerManager;
     std::shared_ptr< BlueNoise >          blueNoise;
     std::shared_ptr< TextureManager >     textureManager;
+    std::shared_ptr< MipmapGenerator >    mipmapGenerator;
     std::shared_ptr< TextureMetaManager > textureMetaManager;
     std::shared_ptr< SceneMetaManager >   sceneMetaManager;
     std::shared_ptr< CubemapManager >     cubemapManager;
@@ -239,11 +295,26 @@ private:
     // TODO: remove; used to not allocate on each call
     std::vector< PositionNormal > tempStorageInit;
     std::vector< AnyLightEXT >    tempStorageLights;
+    // quads of the rasterized particles
+    std::vector< RgPrimitiveVertex > tempStorageParticles;
+    // posed vertices of a skinned primitive, for rasterization and export
+    std::vector< RgPrimitiveVertex > tempStorageSkinned;
 
     std::unique_ptr< Devmode > devmode;
 
     bool rayCullBackFacingTriangles;
 
+    // if false, the arguments of hot calls are trusted; can be false only in release builds
+    bool validateInput;
+
+    // if rgUploadMeshPrimitive can be called from multiple threads
+    bool       multithreadedUpload;
+    std::mutex uploadMutex;
+
+    // guarded by uploadMutex, as the handles are resolved while uploading
+    NameRegistry   nameRegistry;
+    RetainedMeshes retainedMeshes;
+
     RenderResolutionHelper renderResolution;
 
     double previousFrameTime;
@@ -256,6 +327,8 @@ private:
     std::optional< RgExtent2D > m_pixelated{};
     FramebufferImageIndex       m_prevAccum{ FB_IMAGE_INDEX_UPSCALED_PONG };
     bool                        m_skipGeneratedFrame{ false };
+    // FSR3 frame generation on a native Vulkan swapchain, without DX12
+    bool                        m_fsr3Native{ false };
 
     RgFloat3D fluidGravity{ 0, -9.8f, 0 };
     RgFloat3D fluidColor{ 1, 1, 1 };
@@ -20,6 +20,8 @@
 
 #include "VulkanDevice.h"
 
+#include "CpuProfiler.h"
+
 #include "Matrix.h"
 
 #include "Generated/ShaderCommonC.h"
@@ -27,6 +29,7 @@
 #include <imgui.h>
 #include <imgui_internal.h>
 
+#include <cfloat>
 #include <ranges>
 
 namespace
@@ -160,6 +163,24 @@ void RTGL1::VulkanDevice::Dev_Draw() const
             {
                 ImGui::Checkbox( "Vsync", &modifiers.vsync );
             }
+
+            {
+                ImGui::BeginDisabled( !lowLatency->IsAvailable() );
+                ImGui::Checkbox( "Low latency", &modifiers.lowLatency );
+                ImGui::EndDisabled();
+
+                ImGui::SameLine();
+                switch( lowLatency->GetBackend() )
+                {
+                    case LowLatency::Backend::NvLowLatency2:
+                        ImGui::TextUnformatted( "(VK_NV_low_latency2)" );
+                        break;
+                    case LowLatency::Backend::AmdAntiLag:
+                        ImGui::TextUnformatted( "(VK_AMD_anti_lag)" );
+                        break;
+                    default: ImGui::TextUnformatted( "(not supported)" ); break;
+                }
+            }
             
             if( modifiers.frameGeneration == RG_FRAME_GENERATION_MODE_OFF )
             {
@@ -233,6 +254,12 @@ void RTGL1::VulkanDevice::Dev_Draw() const
                                     reinterpret_cast< int* >( &modifiers.upscaleTechnique ),
                                     RG_RENDER_UPSCALE_TECHNIQUE_NVIDIA_DLSS );
                 ImGui::EndDisabled();
+
+                ImGui::BeginDisabled(
+                    modifiers.upscaleTechnique != RG_RENDER_UPSCALE_TECHNIQUE_NVIDIA_DLSS ||
+                    modifiers.frameGeneration != RG_FRAME_GENERATION_MODE_OFF );
+                ImGui::Checkbox( "DLSS Ray Reconstruction", &modifiers.dlssRayReconstruction );
+                ImGui::EndDisabled();
             }
             if( !Utils::IsCstrEmpty( dlssError ) )
             {
@@ -298,6 +325,21 @@ void RTGL1::VulkanDevice::Dev_Draw() const
                     ImGui::SliderInt( "Pixelization size", &modifiers.pixelizedHeight, 100, 600 );
                 }
             }
+            {
+                ImGui::Checkbox( "Dynamic resolution", &modifiers.dynamicResolution );
+                if( modifiers.dynamicResolution )
+                {
+                    ImGui::SliderFloat( "Target GPU frame time (ms)",
+                                        &modifiers.dynamicResolutionTargetFrameTime,
+                                        4.0f,
+                                        50.0f,
+                                        "%.1f" );
+                    ImGui::Text( "GPU frame time: %.2f ms, render size: %u x %u",
+                                 dynamicResolution->GetGpuTimeMs(),
+                                 renderResolution.Width(),
+                                 renderResolution.Height() );
+                }
+            }
 
             {
                 ImGui::Spacing();
@@ -337,6 +379,54 @@ void RTGL1::VulkanDevice::Dev_Draw() const
                               ImGuiSliderFlags_AlwaysClamp | ImGuiSliderFlags_NoInput );
             ImGui::Checkbox( "Second bounce for indirect",
                              &modifiers.enableSecondBounceForIndirect );
+            ImGui::TextUnformatted( "Indirect resolution:" );
+            ImGui::RadioButton( "Full##Indirect",
+                                reinterpret_cast< int* >( &modifiers.indirectResolution ),
+                                RG_INDIRECT_ILLUMINATION_RESOLUTION_FULL );
+            ImGui::SameLine();
+            ImGui::RadioButton( "Half##Indirect",
+                                reinterpret_cast< int* >( &modifiers.indirectResolution ),
+                                RG_INDIRECT_ILLUMINATION_RESOLUTION_HALF );
+            ImGui::SameLine();
+            ImGui::RadioButton( "Quarter##Indirect",
+                                reinterpret_cast< int* >( &modifiers.indirectResolution ),
+                                RG_INDIRECT_ILLUMINATION_RESOLUTION_QUARTER );
+            ImGui::SameLine();
+            ImGui::RadioButton( "Checkerboard##Indirect",
+                                reinterpret_cast< int* >( &modifiers.indirectResolution ),
+                                RG_INDIRECT_ILLUMINATION_RESOLUTION_CHECKERBOARD );
+            ImGui::Checkbox( "Adaptive sampling", &modifiers.enableAdaptiveSampling );
+            ImGui::SliderInt2(
+                "ReSTIR direct candidates", modifiers.restirDirectCandidates, 1, 10, "%d" );
+            ImGui::SliderInt2(
+                "ReSTIR direct spatial", modifiers.restirDirectSpatial, 0, 10, "%d" );
+            ImGui::SliderInt2(
+                "ReSTIR indirect spatial", modifiers.restirIndirectSpatial, 0, 16, "%d" );
+            ImGui::TextUnformatted( "Sample sequence:" );
+            ImGui::RadioButton( "White noise##Sequence",
+                                reinterpret_cast< int* >( &modifiers.sampleSequence ),
+                                RG_SAMPLE_SEQUENCE_WHITE_NOISE );
+            ImGui::SameLine();
+            ImGui::RadioButton( "Blue noise##Sequence",
+                                reinterpret_cast< int* >( &modifiers.sampleSequence ),
+                                RG_SAMPLE_SEQUENCE_BLUE_NOISE );
+            ImGui::SameLine();
+            ImGui::RadioButton( "Sobol##Sequence",
+                                reinterpret_cast< int* >( &modifiers.sampleSequence ),
+                                RG_SAMPLE_SEQUENCE_SOBOL );
+            ImGui::Checkbox( "Irradiance cache", &modifiers.enableIrradianceCache );
+            ImGui::SliderFloat( "Irradiance cache update rate",
+                                &modifiers.irradianceCacheUpdateRate,
+                                0.0f,
+                                1.0f,
+                                "%.2f" );
+            ImGui::Checkbox( "Sun shadow cache", &modifiers.enableSunShadowCache );
+            ImGui::SliderFloat( "Sun shadow cache update rate",
+                                &modifiers.sunShadowCacheUpdateRate,
+                                0.0f,
+                                1.0f,
+                                "%.3f" );
+            ImGui::Checkbox( "Light grid", &modifiers.enableLightGrid );
             ImGui::SliderFloat( "Sensitivity to change: Diffuse Direct",
                                 &modifiers.directDiffuseSensitivityToChange,
                                 0.0f,
@@ -431,11 +521,38 @@ void RTGL1::VulkanDevice::Dev_Draw() const
                 { "Gradients", DEBUG_SHOW_FLAG_GRADIENTS },
                 { "Light grid", DEBUG_SHOW_FLAG_LIGHT_GRID },
                 { "Bloom", DEBUG_SHOW_FLAG_BLOOM },
+                { "Ray cost heatmap", DEBUG_SHOW_FLAG_RAY_COST },
+                { "Any-hit heatmap", DEBUG_SHOW_FLAG_ANY_HIT },
+                { "Translucent overdraw", DEBUG_SHOW_FLAG_TRANSLUCENT_OVERDRAW },
             };
             for( const auto [ name, f ] : fs )
             {
                 ImGui::CheckboxFlags( name, &devmode->debugShowFlags, f );
             }
+
+            if( ( devmode->debugShowFlags & RayCostStats::DebugShowFlags ) &&
+                rayCostStats->GetTotals() )
+            {
+                const auto& t   = *rayCostStats->GetTotals();
+                const auto  per = [ & ]( uint64_t v ) {
+                    return double( v ) / double( std::max( t.pixelCount, 1u ) );
+                };
+
+                ImGui::Dummy( ImVec2( 0, 4 ) );
+                ImGui::Text( "Rays:         %llu (%.2f per pixel, max %u)",
+                             static_cast< unsigned long long >( t.rays ),
+                             per( t.rays ),
+                             t.maxRaysPerPixel );
+                ImGui::Text( "Any-hits:     %llu (%.2f per pixel, max %u)",
+                             static_cast< unsigned long long >( t.anyHits ),
+                             per( t.anyHits ),
+                             t.maxAnyHitsPerPixel );
+                ImGui::Text( "Any-hit area: %.1f%% of pixels", 100.0 * per( t.anyHitPixelCount ) );
+                ImGui::Text( "Translucent:  %llu layers (%.2f per pixel, max %u)",
+                             static_cast< unsigned long long >( t.translucentLayers ),
+                             per( t.translucentLayers ),
+                             t.maxTranslucentLayersPerPixel );
+            }
             ImGui::TreePop();
         }
 
@@ -808,6 +925,158 @@ void RTGL1::VulkanDevice::Dev_Draw() const
         ImGui::EndTabItem();
     }
 
+    if( ImGui::BeginTabItem( "Profiler" ) )
+    {
+        if( !gpuProfiler->IsAvailable() )
+        {
+            ImGui::TextUnformatted( "Timestamp queries are not supported" );
+        }
+        else
+        {
+            ImGui::PlotLines( "GPU frame time (ms)",
+                              gpuProfiler->GetHistory(),
+                              GpuProfiler::HistoryLength,
+                              int( gpuProfiler->GetHistoryOffset() ),
+                              nullptr,
+                              0.0f,
+                              FLT_MAX,
+                              ImVec2( 0, 80 ) );
+
+            ImGui::BeginDisabled( !gpuProfiler->IsPipelineStatisticsAvailable() );
+            ImGui::Checkbox( "Pipeline statistics", &devmode->pipelineStatistics );
+            ImGui::EndDisabled();
+            if( ImGui::IsItemHovered( ImGuiHoveredFlags_AllowWhenDisabled ) )
+            {
+                ImGui::SetTooltip( "Shader invocations per pass, in millions.\n"
+                                   "Throughput is all invocations per nanosecond of the pass:\n"
+                                   "low throughput with a long time hints at a bandwidth\n"
+                                   "or occupancy limit, high throughput at an ALU limit.\n"
+                                   "Ray tracing stages are not counted by Vulkan" );
+            }
+
+            const bool withStats = devmode->pipelineStatistics &&
+                                   gpuProfiler->IsPipelineStatisticsAvailable();
+
+            if( ImGui::BeginTable( "Profiler table",
+                                   withStats ? 8 : 3,
+                                   ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg |
+                                       ImGuiTableFlags_Borders ) )
+            {
+                ImGui::TableSetupColumn( "Pass", ImGuiTableColumnFlags_WidthStretch );
+                ImGui::TableSetupColumn( "ms" );
+                ImGui::TableSetupColumn( "%" );
+                if( withStats )
+                {
+                    ImGui::TableSetupColumn( "VS" );
+                    ImGui::TableSetupColumn( "Prims" );
+                    ImGui::TableSetupColumn( "FS" );
+                    ImGui::TableSetupColumn( "CS" );
+                    ImGui::TableSetupColumn( "Inv/ns" );
+                }
+                ImGui::TableHeadersRow();
+
+                const float frameMs = gpuProfiler->GetFrameTimeMs();
+
+                for( uint32_t i = 0; i < uint32_t( GpuPass::Count ); i++ )
+                {
+                    float ms = gpuProfiler->GetPassTimeMs( GpuPass( i ) );
+
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( GpuPassName( GpuPass( i ) ) );
+                    ImGui::TableNextColumn();
+                    ImGui::Text( "%.3f", ms );
+                    ImGui::TableNextColumn();
+                    ImGui::Text( "%.1f", frameMs > 0.0f ? 100.0f * ms / frameMs : 0.0f );
+
+                    if( withStats )
+                    {
+                        const auto& st = gpuProfiler->GetPassStatistics( GpuPass( i ) );
+
+                        const uint64_t invocations =
+                            st.vertexInvocations + st.fragmentInvocations + st.computeInvocations;
+
+                        for( uint64_t v : { st.vertexInvocations,
+                                            st.clippingPrimitives,
+                                            st.fragmentInvocations,
+                                            st.computeInvocations } )
+                        {
+                            ImGui::TableNextColumn();
+                            ImGui::Text( "%.2f", double( v ) / 1000000.0 );
+                        }
+                        ImGui::TableNextColumn();
+                        ImGui::Text( "%.2f",
+                                     ms > 0.0f ? double( invocations ) / ( ms * 1000000.0 ) : 0.0 );
+                    }
+                }
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( "Frame" );
+                ImGui::TableNextColumn();
+                ImGui::Text( "%.3f", frameMs );
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted( "100.0" );
+
+                ImGui::EndTable();
+            }
+        }
+
+        ImGui::Separator();
+
+        if( !cpuprofiler::IsEnabled() )
+        {
+            ImGui::TextUnformatted( "CPU zones: build with RG_WITH_CPU_PROFILING" );
+        }
+        else
+        {
+            RgUtilCpuZone zones[ 64 ];
+            uint32_t      zoneCount = cpuprofiler::GetLastFrameZones( zones, std::size( zones ) );
+
+            if( ImGui::BeginTable( "CPU zones table",
+                                   3,
+                                   ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg |
+                                       ImGuiTableFlags_Borders ) )
+            {
+                ImGui::TableSetupColumn( "CPU zone", ImGuiTableColumnFlags_WidthStretch );
+                ImGui::TableSetupColumn( "ms" );
+                ImGui::TableSetupColumn( "Calls" );
+                ImGui::TableHeadersRow();
+
+                for( const auto& z : std::span{ zones, zoneCount } )
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted( z.pName );
+                    ImGui::TableNextColumn();
+                    ImGui::Text( "%.3f", z.timeMs );
+                    ImGui::TableNextColumn();
+                    ImGui::Text( "%u", z.callCount );
+                }
+
+                ImGui::EndTable();
+            }
+
+            if( ImGui::TreeNode( "Recent CPU events" ) )
+            {
+                cpuprofiler::ZoneEvent events[ 128 ];
+                uint32_t eventCount = cpuprofiler::GetRecentEvents( events, std::size( events ) );
+
+                for( const auto& e : std::span{ events, eventCount } )
+                {
+                    ImGui::Text( "[%llu] thread %u: %s at %.3f ms, took %.3f ms",
+                                 static_cast< unsigned long long >( e.frameId ),
+                                 e.threadIndex,
+                                 e.name,
+                                 e.beginMs,
+                                 e.durationMs );
+                }
+                ImGui::TreePop();
+            }
+        }
+        ImGui::EndTabItem();
+    }
+
     if( ImGui::BeginTabItem( "Import/Export" ) )
     {
         auto& dev = sceneImportExport->dev;
@@ -1194,6 +1463,7 @@ void RTGL1::VulkanDevice::Dev_Override( RgStartFrameInfo&                   info
         // apply modifiers
         {
             dst.vsync                  = modifiers.vsync;
+            dst.lowLatency             = modifiers.lowLatency;
             dst.hdr                    = modifiers.hdr;
             dst.allowMapAutoExport     = modifiers.allowMapAutoExport;
             dst.lightmapScreenCoverage = modifiers.lightmapScreenCoverage;
@@ -1224,6 +1494,9 @@ void RTGL1::VulkanDevice::Dev_Override( RgStartFrameInfo&                   info
                     static_cast< uint32_t >( aspect * float( modifiers.pixelizedHeight ) ) ),
                 ClampPix< uint32_t >( modifiers.pixelizedHeight ),
             };
+            dst_resol.dlssRayReconstruction            = modifiers.dlssRayReconstruction;
+            dst_resol.dynamicResolution                = modifiers.dynamicResolution;
+            dst_resol.dynamicResolutionTargetFrameTime = modifiers.dynamicResolutionTargetFrameTime;
         }
     }
     else
@@ -1235,6 +1508,7 @@ void RTGL1::VulkanDevice::Dev_Override( RgStartFrameInfo&                   info
         // reset modifiers
         {
             modifiers.vsync                  = src.vsync;
+            modifiers.lowLatency             = src.lowLatency;
             modifiers.hdr                    = src.hdr;
             modifiers.allowMapAutoExport     = src.allowMapAutoExport;
             modifiers.lightmapScreenCoverage = src.lightmapScreenCoverage;
@@ -1266,6 +1540,14 @@ void RTGL1::VulkanDevice::Dev_Override( RgStartFrameInfo&                   info
                 src_resol.pixelizedRenderSizeEnable
                     ? ClampPix< int >( src_resol.pixelizedRenderSize.height )
                     : 0;
+
+            modifiers.dlssRayReconstruction = src_resol.dlssRayReconstruction;
+
+            modifiers.dynamicResolution = src_resol.dynamicResolution;
+            modifiers.dynamicResolutionTargetFrameTime =
+                src_resol.dynamicResolutionTargetFrameTime > 0.0f
+                    ? src_resol.dynamicResolutionTargetFrameTime
+                    : 16.6f;
         }
     }
 }
@@ -1331,6 +1613,20 @@ void RTGL1::VulkanDevice::Dev_Override( RgDrawFrameIlluminationParams& illuminat
         {
             dst_illum.maxBounceShadows                 = modifiers.maxBounceShadows;
             dst_illum.enableSecondBounceForIndirect    = modifiers.enableSecondBounceForIndirect;
+            dst_illum.indirectResolution               = modifiers.indirectResolution;
+            dst_illum.enableAdaptiveSampling           = modifiers.enableAdaptiveSampling;
+            dst_illum.restirDirectCandidateCountMin = modifiers.restirDirectCandidates[ 0 ];
+            dst_illum.restirDirectCandidateCountMax = modifiers.restirDirectCandidates[ 1 ];
+            dst_illum.restirDirectSpatialCountMin   = modifiers.restirDirectSpatial[ 0 ];
+            dst_illum.restirDirectSpatialCountMax   = modifiers.restirDirectSpatial[ 1 ];
+            dst_illum.restirIndirectSpatialCountMin = modifiers.restirIndirectSpatial[ 0 ];
+            dst_illum.restirIndirectSpatialCountMax = modifiers.restirIndirectSpatial[ 1 ];
+            dst_illum.sampleSequence                   = modifiers.sampleSequence;
+            dst_illum.enableIrradianceCache            = modifiers.enableIrradianceCache;
+            dst_illum.irradianceCacheUpdateRate        = modifiers.irradianceCacheUpdateRate;
+            dst_illum.enableSunShadowCache             = modifiers.enableSunShadowCache;
+            dst_illum.sunShadowCacheUpdateRate         = modifiers.sunShadowCacheUpdateRate;
+            dst_illum.enableLightGrid                  = modifiers.enableLightGrid;
             dst_illum.directDiffuseSensitivityToChange = modifiers.directDiffuseSensitivityToChange;
             dst_illum.indirectDiffuseSensitivityToChange =
                 modifiers.indirectDiffuseSensitivityToChange;
@@ -1363,6 +1659,20 @@ void RTGL1::VulkanDevice::Dev_Override( RgDrawFrameIlluminationParams& illuminat
         {
             modifiers.maxBounceShadows                 = int( src_illum.maxBounceShadows );
             modifiers.enableSecondBounceForIndirect    = src_illum.enableSecondBounceForIndirect;
+            modifiers.indirectResolution               = src_illum.indirectResolution;
+            modifiers.enableAdaptiveSampling           = src_illum.enableAdaptiveSampling;
+            modifiers.restirDirectCandidates[ 0 ] = int( src_illum.restirDirectCandidateCountMin );
+            modifiers.restirDirectCandidates[ 1 ] = int( src_illum.restirDirectCandidateCountMax );
+            modifiers.restirDirectSpatial[ 0 ]    = int( src_illum.restirDirectSpatialCountMin );
+            modifiers.restirDirectSpatial[ 1 ]    = int( src_illum.restirDirectSpatialCountMax );
+            modifiers.restirIndirectSpatial[ 0 ]  = int( src_illum.restirIndirectSpatialCountMin );
+            modifiers.restirIndirectSpatial[ 1 ]  = int( src_illum.restirIndirectSpatialCountMax );
+            modifiers.sampleSequence                   = src_illum.sampleSequence;
+            modifiers.enableIrradianceCache            = src_illum.enableIrradianceCache;
+            modifiers.irradianceCacheUpdateRate        = src_illum.irradianceCacheUpdateRate;
+            modifiers.enableSunShadowCache             = src_illum.enableSunShadowCache;
+            modifiers.sunShadowCacheUpdateRate         = src_illum.sunShadowCacheUpdateRate;
+            modifiers.enableLightGrid                  = src_illum.enableLightGrid;
             modifiers.directDiffuseSensitivityToChange = src_illum.directDiffuseSensitivityToChange;
             modifiers.indirectDiffuseSensitivityToChange =
                 src_illum.indirectDiffuseSensitivityToChange;
@@ -50,16 +50,28 @@ struct Devmode
 
     bool antiFirefly{ true };
     bool fluidStopVisualize{ false };
+    bool pipelineStatistics{ false };
 
     struct
     {
         bool enable;
 
-        int   maxBounceShadows;
-        bool  enableSecondBounceForIndirect;
-        float directDiffuseSensitivityToChange;
-        float indirectDiffuseSensitivityToChange;
-        float specularSensitivityToChange;
+        int                              maxBounceShadows;
+        bool                             enableSecondBounceForIndirect;
+        RgIndirectIlluminationResolution indirectResolution;
+        bool                             enableAdaptiveSampling;
+        int                              restirDirectCandidates[ 2 ];
+        int                              restirDirectSpatial[ 2 ];
+        int                              restirIndirectSpatial[ 2 ];
+        RgSampleSequence                 sampleSequence;
+        bool                             enableIrradianceCache;
+        float                            irradianceCacheUpdateRate;
+        bool                             enableSunShadowCache;
+        float                            sunShadowCacheUpdateRate;
+        bool                             enableLightGrid;
+        float                            directDiffuseSensitivityToChange;
+        float                            indirectDiffuseSensitivityToChange;
+        float                            specularSensitivityToChange;
 
         bool  disableEyeAdaptation;
         float ev100Min;
@@ -68,15 +80,19 @@ struct Devmode
         float crosstalk[ 3 ];
 
         bool                     vsync;
+        bool                     lowLatency;
         RgFrameGenerationMode    frameGeneration;
         bool                     preferDxgiPresent;
         bool                     hdr;
         RgRenderUpscaleTechnique upscaleTechnique;
+        bool                     dlssRayReconstruction;
         RgRenderSharpenTechnique sharpenTechnique;
         RgRenderResolutionMode   resolutionMode;
         float                    customRenderSizeScale;
         bool                     pixelizedEnable;
         int                      pixelizedHeight;
+        bool                     dynamicResolution;
+        float                    dynamicResolutionTargetFrameTime;
 
         float normalMapStrength;
         float heightMapDepth;
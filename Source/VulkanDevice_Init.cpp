@@ -22,9 +22,11 @@
 
 #include <algorithm>
 #include <cstring>
+#include <future>
 #include <regex>
 
 #include "HaltonSequence.h"
+#include "HitchRecorder.h"
 #include "JsonParser.h"
 #include "RenderResolutionHelper.h"
 #include "RgException.h"
@@ -213,12 +215,19 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
     : instance( VK_NULL_HANDLE )
     , device( VK_NULL_HANDLE )
     , surface( VK_NULL_HANDLE )
+    , headless( info->pHeadlessCreateInfo != nullptr )
     , frameId( 1 )
     , waitForOutOfFrameFence( false )
     , ovrdFolder{ Utils::SafeCstr( info->pOverrideFolderPath ) }
     , debugMessenger( VK_NULL_HANDLE )
     , userPrint{ std::make_unique< UserPrint >( info->pfnPrint, info->pUserPrintData ) }
     , rayCullBackFacingTriangles( info->rayCullBackFacingTriangles )
+#ifdef NDEBUG
+    , validateInput( !info->trustedInput )
+#else
+    , validateInput( true )
+#endif
+    , multithreadedUpload( info->allowMultithreadedUpload )
     , previousFrameTime( -1.0 / 60.0 )
     , currentFrameTime( 0 )
     , appGuid{ ValidateGUID( info->pAppGUID ) }
@@ -228,8 +237,16 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
     g_libConfig = json_parser::ReadFileAs< LibraryConfig >( ovrdFolder / "RTGL1.json" )
                       .value_or( LibraryConfig{} );
 
+    if( LibConfig().hitchRecorder )
+    {
+        hitchrecorder::Enable( ovrdFolder / "hitches", LibConfig().hitchThresholdMs );
+    }
+
 
     ValidateAndOverrideCreateInfo( info );
+    SetFramesInFlight( info->framesInFlight != 0 ? info->framesInFlight
+                                                 : DEFAULT_FRAMES_IN_FLIGHT );
+    currentFrameState.ResetFrameIndex();
 
 
     // init vulkan instance
@@ -240,7 +257,7 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
 
 
     // create VkSurfaceKHR using user's function
-    surface = GetSurfaceFromUser( instance, *info );
+    surface = headless ? VK_NULL_HANDLE : GetSurfaceFromUser( instance, *info );
     if( info->pWin32SurfaceInfo && info->pWin32SurfaceInfo->hwnd )
     {
         dxgi::SetHwnd( info->pWin32SurfaceInfo->hwnd );
@@ -249,7 +266,11 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
 
     // create selected physical device
     physDevice = std::make_shared< PhysicalDevice >( instance );
-    queues     = std::make_shared< Queues >( physDevice->Get(), surface );
+    queues = std::make_shared< Queues >( physDevice->Get(),
+                                         surface,
+                                         LibConfig().asyncBlasBuild ||
+                                             LibConfig().asyncFluidSimulation ||
+                                             LibConfig().asyncLightGrid );
 
     // create vulkan device and set extension function pointers
     CreateDevice();
@@ -269,6 +290,8 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         device, 
         queues );
 
+    deletionQueue = std::make_shared< DeletionQueue >();
+
     uniform = std::make_shared< GlobalUniform >( 
         device, 
         memAllocator );
@@ -289,9 +312,12 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         framebuffers,
         nvDlss3dx12,
         amdFsr3dx12,
-        physDevice->GetLUID() );
+        physDevice->GetLUID(),
+        headless ? std::optional{ VkExtent2D{ info->pHeadlessCreateInfo->width,
+                                              info->pHeadlessCreateInfo->height } }
+                 : std::nullopt );
     
-    if( LibConfig().developerMode )
+    if( LibConfig().developerMode && !headless )
     {
         debugWindows = std::make_shared< DebugWindows >( 
             instance,
@@ -308,8 +334,8 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
     }
 
     // for world samplers with modifyable lod biad
-    worldSamplerManager = std::make_shared< SamplerManager >( device, 8, info->textureSamplerForceMinificationFilterLinear );
-    genericSamplerManager = std::make_shared< SamplerManager >( device, 0, info->textureSamplerForceMinificationFilterLinear );
+    worldSamplerManager = std::make_shared< SamplerManager >( device, deletionQueue, 8, info->textureSamplerForceMinificationFilterLinear );
+    genericSamplerManager = std::make_shared< SamplerManager >( device, deletionQueue, 0, info->textureSamplerForceMinificationFilterLinear );
 
     restirBuffers = std::make_shared< RestirBuffers >( 
         device, 
@@ -330,7 +356,8 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         ovrdFolder / "DirtMask.ktx2",
         ovrdFolder / "SceneBuildWarning.ktx2",
         info->pbrTextureSwizzling,
-        !!info->textureSamplerForceNormalMapFilterLinear );
+        !!info->textureSamplerForceNormalMapFilterLinear,
+        info->textureStagingRingSize );
 
     textureMetaManager = std::make_shared< TextureMetaManager >(
         ovrdFolder / DATABASE_FOLDER );
@@ -342,12 +369,52 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         device, 
         memAllocator, 
         genericSamplerManager, 
-        *cmdManager );
+        cmdManager,
+        deletionQueue,
+        info->textureStagingRingSize );
+
+    // upscalers only load their libraries here, contexts are created on first use;
+    // the loading is overlapped with the rest of the initialization
+    auto pendingFsr2 = std::async( std::launch::async, [ this ] {
+        return FSR2::MakeInstance( device, physDevice->Get() );
+    } );
+    auto pendingFsr3vk = std::async( std::launch::async, [ this ] {
+        return FSR3_VK::MakeInstance( device, physDevice->Get() );
+    } );
+#ifdef RG_USE_NATIVE_DLSS2
+    auto pendingDlss2 = std::async( std::launch::async, [ this ] {
+        return DLSS2::MakeInstance( instance, device, physDevice->Get(), appGuid.c_str() );
+    } );
+#endif
+
+    pipelineCache = std::make_shared< PipelineCache >( 
+        device, 
+        *physDevice, 
+        ovrdFolder / PIPELINE_CACHE_FILE );
 
     shaderManager = std::make_shared< ShaderManager >( 
         device, 
         ovrdFolder / SHADERS_FOLDER,
-        m_supportsRayQueryAndPositionFetch );
+        m_supportsRayQueryAndPositionFetch,
+        g_supportsInvocationReorder,
+        devmode != nullptr,
+        pipelineCache->Get() );
+
+    mipmapGenerator = std::make_shared< MipmapGenerator >(
+        device, 
+        physDevice->Get(), 
+        memAllocator, 
+        *shaderManager );
+    textureManager->SetMipmapGenerator( mipmapGenerator );
+
+    // instance ids are packed into 28 bits in the shaders;
+    // an instance index is also an index of the geometry infos
+    const uint32_t maxInstanceCount = std::min(
+        info->maxInstanceCount > 0 ? info->maxInstanceCount : uint32_t{ MAX_INSTANCE_COUNT },
+        1u << 28 );
+    const uint32_t maxGeometryCount = std::max(
+        info->maxGeometryCount > 0 ? info->maxGeometryCount : uint32_t{ MAX_GEOM_INFO_COUNT },
+        maxInstanceCount );
 
     scene = std::make_shared< Scene >(
         device, 
@@ -358,9 +425,12 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         *shaderManager,
         info->replacementsMaxVertexCount,
         info->dynamicMaxVertexCount,
+        maxInstanceCount,
+        maxGeometryCount,
         info->allowTexCoordLayer1,
         info->allowTexCoordLayer2,
-        info->allowTexCoordLayer3);
+        info->allowTexCoordLayer3,
+        info->quantizeStaticVertices);
 
     sceneImportExport = std::make_shared< SceneImportExport >(
         ovrdFolder / SCENES_FOLDER,
@@ -374,6 +444,12 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         uniform, 
         memAllocator );
 
+    irradianceCache = std::make_shared< IrradianceCache >( 
+        device,
+        *shaderManager,
+        *uniform,
+        *restirBuffers );
+
     volumetric = std::make_shared< Volumetric >( 
         device,
         *cmdManager,
@@ -395,6 +471,7 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
         memAllocator,
         framebuffers,
         cmdManager,
+        deletionQueue,
         *info );
 
     portalList = std::make_shared< PortalList >( 
@@ -407,6 +484,7 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
 
     lightGrid = std::make_shared< LightGrid >(
         device,
+        cmdManager,
         shaderManager, 
         uniform, 
         blueNoise, 
@@ -444,34 +522,54 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
 
     bloom = std::make_shared< Bloom >( 
         device,
+        *memAllocator,
         framebuffers,
         *shaderManager,
         *uniform,
         *textureManager,
         *tonemapping );
 
-    amdFsr2 = FSR2::MakeInstance( 
+    gpuProfiler = std::make_shared< GpuProfiler >( 
         device, 
-        physDevice->Get() );
+        physDevice->Get(), 
+        queues->GetIndexGraphics() );
 
-#ifdef RG_USE_NATIVE_DLSS2
-    nvDlss2 = DLSS2::MakeInstance(
-        instance,
-        device,
-        physDevice->Get(),
-        appGuid.c_str() );
-#endif
+    rayCostStats = std::make_shared< RayCostStats >( memAllocator );
+
+    frameReadback = std::make_shared< FrameReadback >(
+        device, 
+        physDevice->Get(), 
+        memAllocator, 
+        *shaderManager );
+
+    dynamicResolution = std::make_shared< DynamicResolution >();
+
+    lowLatency = std::make_shared< LowLatency >( 
+        device, 
+        g_supportsLowLatency2, 
+        g_supportsAntiLag, 
+        g_supportsPresentId );
+
+    framePacer = std::make_shared< FramePacer >( device, g_supportsPresentWait );
 
     sharpening = std::make_shared< Sharpening >( 
         device, 
         framebuffers, 
         shaderManager );
 
-    denoiser = std::make_shared< Denoiser >(
-        device, 
-        framebuffers, 
-        *shaderManager,
-        *uniform );
+    {
+        auto svgf = std::make_shared< Denoiser >( device, framebuffers, *shaderManager, *uniform );
+        shaderManager->Subscribe( svgf );
+
+        denoiser = std::move( svgf );
+    }
+    {
+        auto noisy =
+            std::make_shared< NoisyComposition >( device, framebuffers, *shaderManager, *uniform );
+        shaderManager->Subscribe( noisy );
+
+        noisyComposition = std::move( noisy );
+    }
 
     effectWipe = std::make_shared< EffectWipe >(
         device, 
@@ -485,23 +583,45 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
     // clang-format on
 
 
-#define CONSTRUCT_SIMPLE_EFFECT( T ) \
-    std::make_shared< T >( device, *shaderManager, *framebuffers, *uniform )
-
-    effectRadialBlur          = CONSTRUCT_SIMPLE_EFFECT( EffectRadialBlur );
-    effectChromaticAberration = CONSTRUCT_SIMPLE_EFFECT( EffectChromaticAberration );
-    effectInverseBW           = CONSTRUCT_SIMPLE_EFFECT( EffectInverseBW );
-    effectHueShift            = CONSTRUCT_SIMPLE_EFFECT( EffectHueShift );
-    effectNightVision         = CONSTRUCT_SIMPLE_EFFECT( EffectNightVision );
-    effectDistortedSides      = CONSTRUCT_SIMPLE_EFFECT( EffectDistortedSides );
-    effectWaves               = CONSTRUCT_SIMPLE_EFFECT( EffectWaves );
-    effectColorTint           = CONSTRUCT_SIMPLE_EFFECT( EffectColorTint );
-    effectTeleport            = CONSTRUCT_SIMPLE_EFFECT( EffectTeleport );
-    effectCrtDemodulateEncode = CONSTRUCT_SIMPLE_EFFECT( EffectCrtDemodulateEncode );
-    effectCrtDecode           = CONSTRUCT_SIMPLE_EFFECT( EffectCrtDecode );
-    effectVHS                 = CONSTRUCT_SIMPLE_EFFECT( EffectVHS );
-    effectDither              = CONSTRUCT_SIMPLE_EFFECT( EffectDither );
-#undef SIMPLE_EFFECT_CONSTRUCTOR_PARAMS
+    // effects only create their pipelines from the already initialized state,
+    // so they are independent of each other and can be constructed concurrently
+    {
+        auto jobs = std::vector< std::function< void() > >{};
+
+#define CONSTRUCT_SIMPLE_EFFECT( T, dst )                                                   \
+    jobs.emplace_back( [ this ] {                                                           \
+        ( dst ) = std::make_shared< T >( device, *shaderManager, *framebuffers, *uniform ); \
+    } )
+
+        CONSTRUCT_SIMPLE_EFFECT( EffectRadialBlur, effectRadialBlur );
+        CONSTRUCT_SIMPLE_EFFECT( EffectChromaticAberration, effectChromaticAberration );
+        CONSTRUCT_SIMPLE_EFFECT( EffectInverseBW, effectInverseBW );
+        CONSTRUCT_SIMPLE_EFFECT( EffectHueShift, effectHueShift );
+        CONSTRUCT_SIMPLE_EFFECT( EffectNightVision, effectNightVision );
+        CONSTRUCT_SIMPLE_EFFECT( EffectDistortedSides, effectDistortedSides );
+        CONSTRUCT_SIMPLE_EFFECT( EffectWaves, effectWaves );
+        CONSTRUCT_SIMPLE_EFFECT( EffectColorTint, effectColorTint );
+        CONSTRUCT_SIMPLE_EFFECT( EffectTeleport, effectTeleport );
+        CONSTRUCT_SIMPLE_EFFECT( EffectCrtDemodulateEncode, effectCrtDemodulateEncode );
+        CONSTRUCT_SIMPLE_EFFECT( EffectCrtDecode, effectCrtDecode );
+        CONSTRUCT_SIMPLE_EFFECT( EffectVHS, effectVHS );
+        CONSTRUCT_SIMPLE_EFFECT( EffectDither, effectDither );
+#undef CONSTRUCT_SIMPLE_EFFECT
+
+        for( uint32_t bits = 0; bits < EFFECT_FUSED_PERMUTATION_COUNT; bits++ )
+        {
+            // only if at least two effects to fuse
+            if( ( bits & ( bits - 1 ) ) != 0 )
+            {
+                jobs.emplace_back( [ this, bits ] {
+                    effectFusedPointwise[ bits ] = std::make_shared< EffectFusedPointwise >(
+                        device, *shaderManager, *framebuffers, *uniform, bits );
+                } );
+            }
+        }
+
+        Utils::ParallelFor( jobs.size(), [ &jobs ]( size_t i ) { jobs[ i ](); } );
+    }
     {
         VkDescriptorSetLayout layout[] = {
             framebuffers->GetDescSetLayout(),
@@ -509,17 +629,24 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
             imageComposition->GetLpmDescSetLayout(),
         };
         effectHDRPrepare = std::make_shared< EffectHDRPrepare >( device, *shaderManager, layout );
+        effectHDRPrepareWithDither = std::make_shared< EffectHDRPrepare >(
+            device, *shaderManager, layout, EffectHDRPrepare::PERMUTATION_WITH_DITHER );
     }
 
 
-    shaderManager->Subscribe( denoiser );
     shaderManager->Subscribe( imageComposition );
     shaderManager->Subscribe( rasterizer );
     shaderManager->Subscribe( volumetric );
+    shaderManager->Subscribe( irradianceCache );
     shaderManager->Subscribe( rtPipeline );
     shaderManager->Subscribe( lightGrid );
     shaderManager->Subscribe( tonemapping );
     shaderManager->Subscribe( scene->GetVertexPreprocessing() );
+    shaderManager->Subscribe( scene->GetASManager()->GetSkinning() );
+    shaderManager->Subscribe( scene->GetASManager()->GetParticleExpansion() );
+    shaderManager->Subscribe( scene->GetASManager()->GetTLASInstanceGeneration() );
+    shaderManager->Subscribe( mipmapGenerator );
+    shaderManager->Subscribe( frameReadback );
     shaderManager->Subscribe( bloom );
     shaderManager->Subscribe( sharpening );
     shaderManager->Subscribe( effectWipe );
@@ -536,7 +663,21 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
     shaderManager->Subscribe( effectCrtDecode );
     shaderManager->Subscribe( effectVHS );
     shaderManager->Subscribe( effectDither );
+    for( const auto& f : effectFusedPointwise )
+    {
+        if( f )
+        {
+            shaderManager->Subscribe( f );
+        }
+    }
     shaderManager->Subscribe( effectHDRPrepare );
+    shaderManager->Subscribe( effectHDRPrepareWithDither );
+
+    amdFsr2   = pendingFsr2.get();
+    amdFsr3vk = pendingFsr3vk.get();
+#ifdef RG_USE_NATIVE_DLSS2
+    nvDlss2 = pendingDlss2.get();
+#endif
 
     framebuffers->Subscribe( rasterizer );
     framebuffers->Subscribe( restirBuffers );
@@ -544,6 +685,10 @@ RTGL1::VulkanDevice::VulkanDevice( const RgInstanceCreateInfo* info )
     {
         framebuffers->Subscribe( amdFsr2 );
     }
+    if( amdFsr3vk )
+    {
+        framebuffers->Subscribe( amdFsr3vk );
+    }
 
     if( observer )
     {
@@ -558,12 +703,19 @@ RTGL1::VulkanDevice::~VulkanDevice()
 {
     vkDeviceWaitIdle( device );
 
+    hitchrecorder::Disable();
+
+    // before the owners of the queued resources are destroyed
+    deletionQueue->FlushAll();
+    deletionQueue.reset();
+
     observer.reset();
     physDevice.reset();
     queues.reset();
     swapchain.reset();
     cmdManager.reset();
     framebuffers.reset();
+    irradianceCache.reset();
     restirBuffers.reset();
     volumetric.reset();
     fluid.reset();
@@ -572,8 +724,15 @@ RTGL1::VulkanDevice::~VulkanDevice()
     bloom.reset();
     amdFsr2.reset();
     amdFsr3dx12.reset();
+    amdFsr3vk.reset();
     nvDlss2.reset();
     nvDlss3dx12.reset();
+    dynamicResolution.reset();
+    gpuProfiler.reset();
+    rayCostStats.reset();
+    frameReadback.reset();
+    lowLatency.reset();
+    framePacer.reset();
     sharpening.reset();
     effectWipe.reset();
     effectRadialBlur.reset();
@@ -589,8 +748,14 @@ RTGL1::VulkanDevice::~VulkanDevice()
     effectCrtDecode.reset();
     effectVHS.reset();
     effectDither.reset();
+    for( auto& f : effectFusedPointwise )
+    {
+        f.reset();
+    }
     effectHDRPrepare.reset();
+    effectHDRPrepareWithDither.reset();
     denoiser.reset();
+    noisyComposition.reset();
     uniform.reset();
     scene.reset();
     sceneImportExport.reset();
@@ -605,6 +770,7 @@ RTGL1::VulkanDevice::~VulkanDevice()
     genericSamplerManager.reset();
     blueNoise.reset();
     textureManager.reset();
+    mipmapGenerator.reset();
     textureMetaManager.reset();
     sceneMetaManager.reset();
     cubemapManager.reset();
@@ -612,7 +778,17 @@ RTGL1::VulkanDevice::~VulkanDevice()
     devmode.reset();
     memAllocator.reset();
 
-    vkDestroySurfaceKHR( instance, surface, nullptr );
+    // all pipelines are destroyed, so the cache contains everything
+    if( pipelineCache )
+    {
+        pipelineCache->Save();
+    }
+    pipelineCache.reset();
+
+    if( surface )
+    {
+        vkDestroySurfaceKHR( instance, surface, nullptr );
+    }
     DestroySyncPrimitives();
 
     dxgi::Destroy();
@@ -759,6 +935,13 @@ void RTGL1::VulkanDevice::CreateInstance( const RgInstanceCreateInfo& info )
 
     auto extensions = std::vector{
         VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME,
+
+#ifdef RG_USE_DX12
+        VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME,
+#endif
+    };
+
+    auto surfaceExtensions = std::vector{
         VK_KHR_SURFACE_EXTENSION_NAME,
         VK_EXT_SWAPCHAIN_COLOR_SPACE_EXTENSION_NAME,
 
@@ -781,12 +964,14 @@ void RTGL1::VulkanDevice::CreateInstance( const RgInstanceCreateInfo& info )
 #ifdef RG_USE_SURFACE_XLIB
         VK_KHR_XLIB_SURFACE_EXTENSION_NAME,
 #endif // RG_USE_SURFACE_XLIB
-
-#ifdef RG_USE_DX12
-        VK_KHR_EXTERNAL_MEMORY_CAPABILITIES_EXTENSION_NAME,
-#endif
     };
 
+    // headless instance doesn't depend on a window system, which may be absent on CI machines
+    if( !headless )
+    {
+        extensions.insert( extensions.end(), surfaceExtensions.begin(), surfaceExtensions.end() );
+    }
+
     if( auto d = DLSS2::RequiredVulkanExtensions_Instance() )
     {
         for( const char* dlssExt : d.value() )
@@ -862,7 +1047,15 @@ static void* selectPtr( bool condition, void* a, void* b )
 // TODO: remove global var
 namespace RTGL1
 {
-bool g_supportsPositionFetch = false;
+bool g_supportsPositionFetch   = false;
+bool g_supportsOpacityMicromap = false;
+bool g_supportsInvocationReorder = false;
+bool g_supportsLowLatency2 = false;
+bool g_supportsAntiLag = false;
+bool g_supportsPresentId = false;
+bool g_supportsPresentWait = false;
+bool g_supportsMemoryDecompression = false;
+bool g_supportsUpdateAfterBind = false;
 }
 
 void RTGL1::VulkanDevice::CreateDevice()
@@ -899,6 +1092,36 @@ void RTGL1::VulkanDevice::CreateDevice()
     }
     g_supportsPositionFetch = m_supportsRayQueryAndPositionFetch;
 
+    g_supportsOpacityMicromap = LibConfig().opacityMicromaps &&
+                                physDevice->SupportsOpacityMicromap() &&
+                                l_supported( VK_EXT_OPACITY_MICROMAP_EXTENSION_NAME );
+
+    g_supportsInvocationReorder =
+        LibConfig().invocationReorder && physDevice->SupportsInvocationReorder() &&
+        l_supported( VK_NV_RAY_TRACING_INVOCATION_REORDER_EXTENSION_NAME );
+
+    // latency reduction is bound to presentation
+    g_supportsLowLatency2 = !headless && l_supported( VK_NV_LOW_LATENCY_2_EXTENSION_NAME );
+#ifdef VK_AMD_anti_lag
+    g_supportsAntiLag = !headless && !g_supportsLowLatency2 && physDevice->SupportsAntiLag() &&
+                        l_supported( VK_AMD_ANTI_LAG_EXTENSION_NAME );
+#endif
+    // present wait requires present id
+    g_supportsPresentWait = !headless && physDevice->SupportsPresentId() &&
+                            physDevice->SupportsPresentWait() &&
+                            l_supported( VK_KHR_PRESENT_ID_EXTENSION_NAME ) &&
+                            l_supported( VK_KHR_PRESENT_WAIT_EXTENSION_NAME );
+    g_supportsPresentId = ( g_supportsLowLatency2 || g_supportsAntiLag || g_supportsPresentWait ) &&
+                          physDevice->SupportsPresentId() &&
+                          l_supported( VK_KHR_PRESENT_ID_EXTENSION_NAME );
+
+    // core in Vulkan 1.2, so only the features are checked
+    g_supportsUpdateAfterBind = physDevice->SupportsUpdateAfterBind();
+
+    g_supportsMemoryDecompression = LibConfig().memoryDecompression &&
+                                    physDevice->SupportsMemoryDecompression() &&
+                                    l_supported( VK_NV_MEMORY_DECOMPRESSION_EXTENSION_NAME );
+
 
     VkPhysicalDeviceFeatures features = {
         .robustBufferAccess                      = 1,
@@ -976,6 +1199,9 @@ void RTGL1::VulkanDevice::CreateDevice()
         .shaderInt8               = 1,
         .shaderSampledImageArrayNonUniformIndexing  = 1,
         .shaderStorageBufferArrayNonUniformIndexing = 1,
+        .descriptorBindingSampledImageUpdateAfterBind = g_supportsUpdateAfterBind,
+        .descriptorBindingUpdateUnusedWhilePending    = g_supportsUpdateAfterBind,
+        .descriptorBindingPartiallyBound              = g_supportsUpdateAfterBind,
         .runtimeDescriptorArray                     = 1,
         .timelineSemaphore                          = 1,
         .bufferDeviceAddress                        = 1,
@@ -1023,14 +1249,62 @@ void RTGL1::VulkanDevice::CreateDevice()
         .rayQuery = 1,
     };
 
+    auto opacityMicromapFeatures = VkPhysicalDeviceOpacityMicromapFeaturesEXT{
+        .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_OPACITY_MICROMAP_FEATURES_EXT,
+        .pNext    = selectPtr( m_supportsRayQueryAndPositionFetch, &rtQueryFeatures, &asFeatures ),
+        .micromap = 1,
+    };
+
+    auto invocationReorderFeatures = VkPhysicalDeviceRayTracingInvocationReorderFeaturesNV{
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_INVOCATION_REORDER_FEATURES_NV,
+        .pNext = selectPtr(
+            g_supportsOpacityMicromap, &opacityMicromapFeatures, opacityMicromapFeatures.pNext ),
+        .rayTracingInvocationReorder = 1,
+    };
+
+    auto presentIdFeatures = VkPhysicalDevicePresentIdFeaturesKHR{
+        .sType     = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+        .pNext     = selectPtr( g_supportsInvocationReorder,
+                                &invocationReorderFeatures,
+                                invocationReorderFeatures.pNext ),
+        .presentId = 1,
+    };
+
+    auto presentWaitFeatures = VkPhysicalDevicePresentWaitFeaturesKHR{
+        .sType       = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR,
+        .pNext =
+            selectPtr( g_supportsPresentId, &presentIdFeatures, presentIdFeatures.pNext ),
+        .presentWait = 1,
+    };
+
+#ifdef VK_AMD_anti_lag
+    auto antiLagFeatures = VkPhysicalDeviceAntiLagFeaturesAMD{
+        .sType   = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ANTI_LAG_FEATURES_AMD,
+        .pNext   = selectPtr(
+            g_supportsPresentWait, &presentWaitFeatures, presentWaitFeatures.pNext ),
+        .antiLag = 1,
+    };
+    void* lastFeatures = selectPtr( g_supportsAntiLag, &antiLagFeatures, antiLagFeatures.pNext );
+#else
+    void* lastFeatures =
+        selectPtr( g_supportsPresentWait, &presentWaitFeatures, presentWaitFeatures.pNext );
+#endif
+
+    auto memoryDecompressionFeatures = VkPhysicalDeviceMemoryDecompressionFeaturesNV{
+        .sType               = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_DECOMPRESSION_FEATURES_NV,
+        .pNext               = lastFeatures,
+        .memoryDecompression = 1,
+    };
+
     auto physicalDeviceFeatures2 = VkPhysicalDeviceFeatures2{
         .sType    = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
-        .pNext    = selectPtr( m_supportsRayQueryAndPositionFetch, &rtQueryFeatures, &asFeatures ),
+        .pNext    = selectPtr( g_supportsMemoryDecompression,
+                               &memoryDecompressionFeatures,
+                               memoryDecompressionFeatures.pNext ),
         .features = features,
     };
 
     auto deviceExtensions = std::vector{
-        VK_KHR_SWAPCHAIN_EXTENSION_NAME,
         VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
         VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME,
         VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
@@ -1046,12 +1320,54 @@ void RTGL1::VulkanDevice::CreateDevice()
 #endif // RG_USE_DX12
     };
 
+    if( !headless )
+    {
+        deviceExtensions.push_back( VK_KHR_SWAPCHAIN_EXTENSION_NAME );
+    }
+
     if( m_supportsRayQueryAndPositionFetch )
     {
         deviceExtensions.push_back( VK_KHR_RAY_QUERY_EXTENSION_NAME );
         deviceExtensions.push_back( VK_KHR_RAY_TRACING_POSITION_FETCH_EXTENSION_NAME );
     }
 
+    if( g_supportsOpacityMicromap )
+    {
+        deviceExtensions.push_back( VK_EXT_OPACITY_MICROMAP_EXTENSION_NAME );
+    }
+
+    if( g_supportsInvocationReorder )
+    {
+        deviceExtensions.push_back( VK_NV_RAY_TRACING_INVOCATION_REORDER_EXTENSION_NAME );
+    }
+
+    if( g_supportsLowLatency2 )
+    {
+        deviceExtensions.push_back( VK_NV_LOW_LATENCY_2_EXTENSION_NAME );
+    }
+
+#ifdef VK_AMD_anti_lag
+    if( g_supportsAntiLag )
+    {
+        deviceExtensions.push_back( VK_AMD_ANTI_LAG_EXTENSION_NAME );
+    }
+#endif
+
+    if( g_supportsPresentId )
+    {
+        deviceExtensions.push_back( VK_KHR_PRESENT_ID_EXTENSION_NAME );
+    }
+
+    if( g_supportsPresentWait )
+    {
+        deviceExtensions.push_back( VK_KHR_PRESENT_WAIT_EXTENSION_NAME );
+    }
+
+    if( g_supportsMemoryDecompression )
+    {
+        deviceExtensions.push_back( VK_NV_MEMORY_DECOMPRESSION_EXTENSION_NAME );
+    }
+
     if( auto d = DLSS2::RequiredVulkanExtensions_Device( physDevice->Get() ) )
     {
         for( const char* dlssExt : d.value() )
@@ -1110,6 +1426,31 @@ void RTGL1::VulkanDevice::CreateDevice()
 
     InitDeviceExtensionFunctions( device );
 
+    if( g_supportsOpacityMicromap )
+    {
+        InitDeviceExtensionFunctions_OpacityMicromap( device );
+    }
+
+    if( g_supportsMemoryDecompression )
+    {
+        InitDeviceExtensionFunctions_MemoryDecompression( device );
+    }
+
+    if( g_supportsLowLatency2 )
+    {
+        InitDeviceExtensionFunctions_LowLatency2( device );
+    }
+
+    if( g_supportsAntiLag )
+    {
+        InitDeviceExtensionFunctions_AntiLag( device );
+    }
+
+    if( g_supportsPresentWait )
+    {
+        InitDeviceExtensionFunctions_PresentWait( device );
+    }
+
     if( LibConfig().vulkanValidation )
     {
         InitDeviceExtensionFunctions_DebugUtils( device );
@@ -1170,6 +1511,9 @@ void RTGL1::VulkanDevice::CreateSyncPrimitives()
         vkswapchainAvailableSemaphores[ i ] =
             l_binarySemaphore( "Vulkan Swapchain Image available semaphore" );
         emulatedSemaphores[ i ]       = l_binarySemaphore( "Emulated semaphore" );
+        vkswapchainAnotherAvailableSemaphores[ i ] =
+            l_binarySemaphore( "Vulkan Swapchain Image available semaphore (another)" );
+        generatedFinishedSemaphores[ i ] = l_binarySemaphore( "Generated frame finished semaphore" );
         debugFinishedSemaphores[ i ]  = l_binarySemaphore( "Debug render finished semaphore" );
         inFrameSemaphores[ i ]        = l_binarySemaphore( "In-frame semaphore" );
 
@@ -1201,6 +1545,8 @@ void RTGL1::VulkanDevice::DestroySyncPrimitives()
         vkDestroySemaphore( device, debugFinishedSemaphores[ i ], nullptr );
         vkDestroySemaphore( device, inFrameSemaphores[ i ], nullptr );
         vkDestroySemaphore( device, emulatedSemaphores[ i ], nullptr );
+        vkDestroySemaphore( device, vkswapchainAnotherAvailableSemaphores[ i ], nullptr );
+        vkDestroySemaphore( device, generatedFinishedSemaphores[ i ], nullptr );
         vkDestroyFence( device, frameFences[ i ], nullptr );
         vkDestroyFence( device, outOfFrameFences[ i ], nullptr );
     }
@@ -1218,7 +1564,7 @@ void RTGL1::VulkanDevice::ValidateAndOverrideCreateInfo( const RgInstanceCreateI
     {
         int count = !!pInfo->pWin32SurfaceInfo + !!pInfo->pMetalSurfaceCreateInfo +
                     !!pInfo->pWaylandSurfaceCreateInfo + !!pInfo->pXcbSurfaceCreateInfo +
-                    !!pInfo->pXlibSurfaceCreateInfo;
+                    !!pInfo->pXlibSurfaceCreateInfo + !!pInfo->pHeadlessCreateInfo;
 
         if( count != 1 )
         {
@@ -1227,12 +1573,29 @@ void RTGL1::VulkanDevice::ValidateAndOverrideCreateInfo( const RgInstanceCreateI
         }
     }
 
+    if( pInfo->pHeadlessCreateInfo )
+    {
+        if( pInfo->pHeadlessCreateInfo->width == 0 || pInfo->pHeadlessCreateInfo->height == 0 )
+        {
+            throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT,
+                               "RgHeadlessCreateInfo must have non-zero width and height" );
+        }
+    }
+
     if( pInfo->rasterizedSkyCubemapSize == 0 )
     {
         throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT,
                            "rasterizedSkyCubemapSize must be non-zero" );
     }
 
+    if( pInfo->framesInFlight != 0 &&
+        ( pInfo->framesInFlight < 2 || pInfo->framesInFlight > MAX_FRAMES_IN_FLIGHT ) )
+    {
+        throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT,
+                           "framesInFlight must be 0, or in [2.."s +
+                               std::to_string( MAX_FRAMES_IN_FLIGHT ) + "]" );
+    }
+
     if( pInfo->primaryRaysMaxAlbedoLayers > MATERIALS_MAX_LAYER_COUNT )
     {
         throw RgException( RG_RESULT_WRONG_FUNCTION_ARGUMENT,
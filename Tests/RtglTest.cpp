@@ -1,5 +1,8 @@
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
+#include <fstream>
 #include <cstring>
 #include <span>
 #include <random>
@@ -503,6 +506,1219 @@ void FillGAllMeshes(
 
 
 
+#pragma region BENCHMARK
+
+// Deterministic benchmark: a static scene (with its replacements) is loaded by the map name,
+// the camera is taken from the scene's glTF camera animation, which is played back at a fixed
+// time step. As the library's jitter and blue noise sequences depend only on the frame index,
+// the same frames are rendered on every run.
+namespace
+{
+struct BenchmarkParams
+{
+    std::string mapName{};
+    uint32_t    warmupFrames{ 120 };
+    uint32_t    frameCount{ 1000 };
+    // Give up, if the static scene is not loaded after this amount of frames
+    uint32_t    maxLoadFrames{ 600 };
+    double      timeStep{ 1.0 / 60.0 };
+    std::string outputPath{ "rtgl1_benchmark.json" };
+    // Synthetic CPU load on top of the static scene: count of dynamic primitives and
+    // sphere lights that are uploaded every frame, to measure the library's hot paths at scale
+    uint32_t    syntheticPrimitives{ 0 };
+    uint32_t    syntheticLights{ 0 };
+};
+
+struct BenchmarkFrame
+{
+    // From rgStartFrame to the end of rgDrawFrame
+    double cpuMs;
+    // Between consecutive rgStartFrame calls, so includes presentation and waiting for the GPU
+    double                                         frameMs;
+    RgUtilFrameTimings                             gpu;
+    std::vector< std::pair< std::string, float > > cpuZones;
+    size_t                                         vramUsed;
+};
+
+constexpr std::pair< const char*, float RgUtilFrameTimings::* > GpuTimingFields[] = {
+    { "frame", &RgUtilFrameTimings::frame },
+    { "accelerationStructures", &RgUtilFrameTimings::accelerationStructures },
+    { "vertexPreprocessing", &RgUtilFrameTimings::vertexPreprocessing },
+    { "primaryRays", &RgUtilFrameTimings::primaryRays },
+    { "reflectRefract", &RgUtilFrameTimings::reflectRefract },
+    { "directIllumination", &RgUtilFrameTimings::directIllumination },
+    { "indirectIllumination", &RgUtilFrameTimings::indirectIllumination },
+    { "volumetric", &RgUtilFrameTimings::volumetric },
+    { "denoiser", &RgUtilFrameTimings::denoiser },
+    { "upscaler", &RgUtilFrameTimings::upscaler },
+    { "bloom", &RgUtilFrameTimings::bloom },
+    { "postEffects", &RgUtilFrameTimings::postEffects },
+    { "rasterization", &RgUtilFrameTimings::rasterization },
+};
+
+constexpr const char* MemoryCategoryNames[] = {
+    "other",   "framebuffers", "textures",   "staticGeometry", "dynamicGeometry", "accelStructs",
+    "scratch", "restir",       "volumetric", "fluid",          "cubemaps",        "staging",
+};
+static_assert( std::size( MemoryCategoryNames ) == RG_UTIL_MEMORY_CATEGORY_COUNT );
+
+std::string JsonString( std::string_view str )
+{
+    auto r = std::string{ "\"" };
+    for( char c : str )
+    {
+        if( c == '"' || c == '\\' )
+        {
+            r += '\\';
+        }
+        r += c;
+    }
+    return r + "\"";
+}
+
+double Percentile( std::span< const double > sorted, double p )
+{
+    if( sorted.empty() )
+    {
+        return 0.0;
+    }
+    auto i = size_t( std::ceil( p * double( sorted.size() ) ) );
+    return sorted[ std::clamp< size_t >( i, 1, sorted.size() ) - 1 ];
+}
+
+void WriteBenchmarkJson( const BenchmarkParams&            params,
+                         std::span< const BenchmarkFrame > frames,
+                         const RgUtilMemoryUsage&          memory )
+{
+    auto f = std::ofstream{ params.outputPath };
+    if( !f )
+    {
+        std::cout << "Benchmark: can't write to " << params.outputPath << std::endl;
+        return;
+    }
+
+    auto frameMs = std::vector< double >{};
+    auto cpuMs   = std::vector< double >{};
+    for( const auto& fr : frames )
+    {
+        frameMs.push_back( fr.frameMs );
+        cpuMs.push_back( fr.cpuMs );
+    }
+    std::ranges::sort( frameMs );
+    std::ranges::sort( cpuMs );
+
+    auto l_stats = [ & ]( const char* name, std::span< const double > sorted ) {
+        double avg = 0;
+        for( double v : sorted )
+        {
+            avg += v / double( sorted.size() );
+        }
+        f << "    " << JsonString( name ) << ": { "
+          << "\"avg\": " << avg << ", "
+          << "\"min\": " << ( sorted.empty() ? 0.0 : sorted.front() ) << ", "
+          << "\"p50\": " << Percentile( sorted, 0.50 ) << ", "
+          << "\"p90\": " << Percentile( sorted, 0.90 ) << ", "
+          << "\"p99\": " << Percentile( sorted, 0.99 ) << ", "
+          << "\"max\": " << ( sorted.empty() ? 0.0 : sorted.back() ) << " }";
+    };
+
+    f << "{\n";
+    f << "  \"map\": " << JsonString( params.mapName ) << ",\n";
+    f << "  \"warmupFrames\": " << params.warmupFrames << ",\n";
+    f << "  \"frameCount\": " << frames.size() << ",\n";
+    f << "  \"timeStep\": " << params.timeStep << ",\n";
+    f << "  \"syntheticPrimitives\": " << params.syntheticPrimitives << ",\n";
+    f << "  \"syntheticLights\": " << params.syntheticLights << ",\n";
+
+    f << "  \"summary\": {\n";
+    l_stats( "frameMs", frameMs );
+    f << ",\n";
+    l_stats( "cpuMs", cpuMs );
+    f << "\n  },\n";
+
+    f << "  \"memory\": {\n";
+    f << "    \"vramUsed\": " << memory.vramUsed << ",\n";
+    f << "    \"vramTotal\": " << memory.vramTotal << ",\n";
+    f << "    \"categories\": {";
+    for( uint32_t c = 0; c < RG_UTIL_MEMORY_CATEGORY_COUNT; c++ )
+    {
+        f << ( c > 0 ? ",\n" : "\n" ) << "      " << JsonString( MemoryCategoryNames[ c ] )
+          << ": { \"current\": " << memory.categories[ c ].current
+          << ", \"peak\": " << memory.categories[ c ].peak << " }";
+    }
+    f << "\n    }\n  },\n";
+
+    f << "  \"frames\": [";
+    for( size_t i = 0; i < frames.size(); i++ )
+    {
+        const auto& fr = frames[ i ];
+
+        f << ( i > 0 ? ",\n" : "\n" ) << "    { ";
+        f << "\"frameMs\": " << fr.frameMs << ", ";
+        f << "\"cpuMs\": " << fr.cpuMs << ", ";
+        f << "\"vramUsed\": " << fr.vramUsed << ", ";
+
+        f << "\"gpu\": { ";
+        for( size_t t = 0; t < std::size( GpuTimingFields ); t++ )
+        {
+            const auto& [ name, field ] = GpuTimingFields[ t ];
+            f << ( t > 0 ? ", " : "" ) << JsonString( name ) << ": " << fr.gpu.*field;
+        }
+        f << " }, ";
+
+        f << "\"cpuZones\": { ";
+        for( size_t z = 0; z < fr.cpuZones.size(); z++ )
+        {
+            f << ( z > 0 ? ", " : "" ) << JsonString( fr.cpuZones[ z ].first ) << ": "
+              << fr.cpuZones[ z ].second;
+        }
+        f << " } }";
+    }
+    f << "\n  ]\n}\n";
+
+    std::cout << "Benchmark: written to " << params.outputPath << " (p50 frame "
+              << Percentile( frameMs, 0.50 ) << " ms, p99 frame " << Percentile( frameMs, 0.99 )
+              << " ms)" << std::endl;
+}
+
+// Shared by the benchmark's synthetic load and the scalability workloads
+constexpr uint32_t SyntheticPrimitivesPerMesh = 64;
+constexpr float    SyntheticSpacing           = 2.0f;
+
+uint32_t SyntheticGridSide( uint32_t count )
+{
+    return std::max( 1u, uint32_t( std::ceil( std::sqrt( double( count ) ) ) ) );
+}
+
+// Position on a square grid of 'count' cells, centered at the origin
+RgFloat3D SyntheticGridPosition( uint32_t index, uint32_t count, float height )
+{
+    const auto  side = SyntheticGridSide( count );
+    const float half = 0.5f * SyntheticSpacing * float( side - 1 );
+
+    return {
+        SyntheticSpacing * float( index % side ) - half,
+        height,
+        SyntheticSpacing * float( index / side ) - half,
+    };
+}
+
+// Deterministic grid of cubes and sphere lights, slightly moving every frame,
+// so dynamic geometry and light matching are exercised, and not just cached
+void UploadSyntheticLoad( RgInterface& rt, const BenchmarkParams& params, uint64_t frameId )
+{
+    const auto offset = 0.25f * std::sin( float( frameId ) * 0.05f );
+
+    const auto white = rt.rgUtilPackColorByte4D( 255, 255, 255, 255 );
+    const auto cube  = GetCubeVertices( white );
+
+    for( uint32_t i = 0; i < params.syntheticPrimitives; i++ )
+    {
+        const auto pos = SyntheticGridPosition( i, params.syntheticPrimitives, offset );
+
+        auto mesh = RgMeshInfo{
+            .sType          = RG_STRUCTURE_TYPE_MESH_INFO,
+            .pNext          = nullptr,
+            .uniqueObjectID = 1000000 + i / SyntheticPrimitivesPerMesh,
+            .pMeshName      = "synthetic",
+            .transform      = { {
+                { 1, 0, 0, pos.data[ 0 ] },
+                { 0, 1, 0, pos.data[ 1 ] },
+                { 0, 0, 1, pos.data[ 2 ] },
+            } },
+            .isExportable   = false,
+        };
+
+        auto prim = RgMeshPrimitiveInfo{
+            .sType                = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO,
+            .pNext                = nullptr,
+            .flags                = 0,
+            .primitiveIndexInMesh = i % SyntheticPrimitivesPerMesh,
+            .pVertices            = cube,
+            .vertexCount          = std::size( s_CubePositions ),
+            .pTextureName         = nullptr,
+            .textureFrame         = 0,
+            .color                = rt.rgUtilPackColorByte4D( 128, 128, 128, 255 ),
+            .classicLight         = 1.0f,
+        };
+
+        RgResult r = rt.rgUploadMeshPrimitive( &mesh, &prim );
+        RG_CHECK( r );
+    }
+
+    for( uint32_t i = 0; i < params.syntheticLights; i++ )
+    {
+        auto sphere = RgLightSphericalEXT{
+            .sType     = RG_STRUCTURE_TYPE_LIGHT_SPHERICAL_EXT,
+            .pNext     = nullptr,
+            .color     = rt.rgUtilPackColorByte4D( 255, 200, 160, 255 ),
+            .intensity = 100.0f,
+            .position  = SyntheticGridPosition( i, params.syntheticLights, 2.0f + offset ),
+            .radius    = 0.1f,
+        };
+
+        auto l = RgLightInfo{
+            .sType        = RG_STRUCTURE_TYPE_LIGHT_INFO,
+            .pNext        = &sphere,
+            .uniqueID     = 1000000 + i,
+            .isExportable = false,
+        };
+
+        RgResult r = rt.rgUploadLight( &l );
+        RG_CHECK( r );
+    }
+}
+
+bool RunBenchmark( RgInterface& rt, const BenchmarkParams& params )
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto l_ms = []( Clock::time_point a, Clock::time_point b ) {
+        return std::chrono::duration< double, std::milli >( b - a ).count();
+    };
+
+    auto frames = std::vector< BenchmarkFrame >{};
+    frames.reserve( params.frameCount );
+
+    auto     zones     = std::vector< RgUtilCpuZone >( 256 );
+    auto     prevStart = std::optional< Clock::time_point >{};
+    auto     loadedAt  = std::optional< uint64_t >{};
+    uint64_t frameId   = 0;
+
+    while( frames.size() < params.frameCount )
+    {
+        if( glfwWindowShouldClose( g_GlfwHandle ) )
+        {
+            std::cout << "Benchmark: window was closed, aborting" << std::endl;
+            return false;
+        }
+        glfwPollEvents();
+
+        if( !loadedAt && frameId >= params.maxLoadFrames )
+        {
+            std::cout << "Benchmark: static scene \"" << params.mapName
+                      << "\" was not loaded, aborting" << std::endl;
+            return false;
+        }
+
+        // camera animation starts when the scene is loaded
+        const double animTime = loadedAt ? double( frameId - *loadedAt ) * params.timeStep : 0.0;
+        const bool measure = loadedAt && frameId >= *loadedAt + params.warmupFrames;
+
+        const auto tStart = Clock::now();
+        {
+            auto resolution = RgStartFrameRenderResolutionParams{
+                .sType            = RG_STRUCTURE_TYPE_START_FRAME_RENDER_RESOLUTION_PARAMS,
+                .pNext            = nullptr,
+                .upscaleTechnique = RG_RENDER_UPSCALE_TECHNIQUE_AMD_FSR2,
+                .resolutionMode   = RG_RENDER_RESOLUTION_MODE_BALANCED,
+            };
+
+            RgStaticSceneStatusFlags status = 0;
+
+            auto startInfo = RgStartFrameInfo{
+                .sType                    = RG_STRUCTURE_TYPE_START_FRAME_INFO,
+                .pNext                    = &resolution,
+                .pMapName                 = params.mapName.c_str(),
+                .vsync                    = false,
+                .pResultStaticSceneStatus = &status,
+                .staticSceneAnimationTime = float( animTime ),
+            };
+
+            RgResult r = rt.rgStartFrame( &startInfo );
+            RG_CHECK( r );
+
+            if( !loadedAt && ( status & RG_STATIC_SCENE_STATUS_LOADED ) )
+            {
+                loadedAt = frameId;
+            }
+        }
+
+        // no rgUploadCamera: the camera of the static scene is used
+        UploadSyntheticLoad( rt, params, frameId );
+
+        {
+            auto sky = RgDrawFrameSkyParams{
+                .sType              = RG_STRUCTURE_TYPE_DRAW_FRAME_SKY_PARAMS,
+                .pNext              = nullptr,
+                .skyType            = RG_SKY_TYPE_COLOR,
+                .skyColorDefault    = { 0.71f, 0.88f, 1.0f },
+                .skyColorMultiplier = ctl_SkyIntensity,
+                .skyColorSaturation = 1.0f,
+                .skyViewerPosition  = { 0, 0, 0 },
+            };
+
+            auto frameInfo = RgDrawFrameInfo{
+                .sType       = RG_STRUCTURE_TYPE_DRAW_FRAME_INFO,
+                .pNext       = &sky,
+                .rayLength   = 10000.0f,
+                .currentTime = double( frameId ) * params.timeStep,
+            };
+
+            RgResult r = rt.rgDrawFrame( &frameInfo );
+            RG_CHECK( r );
+        }
+        const auto tEnd = Clock::now();
+
+        if( measure && prevStart )
+        {
+            auto fr = BenchmarkFrame{
+                .cpuMs    = l_ms( tStart, tEnd ),
+                .frameMs  = l_ms( *prevStart, tStart ),
+                .gpu      = rt.rgUtilGetFrameTimings(),
+                .cpuZones = {},
+                .vramUsed = rt.rgUtilRequestMemoryUsage().vramUsed,
+            };
+
+            uint32_t zoneCount = rt.rgUtilGetCpuZones( zones.data(), uint32_t( zones.size() ) );
+            for( uint32_t z = 0; z < std::min< uint32_t >( zoneCount, zones.size() ); z++ )
+            {
+                fr.cpuZones.emplace_back( zones[ z ].pName, zones[ z ].timeMs );
+            }
+
+            frames.push_back( std::move( fr ) );
+        }
+        prevStart = tStart;
+
+        frameId++;
+    }
+
+    WriteBenchmarkJson( params, frames, rt.rgUtilRequestMemoryUsage() );
+    return true;
+}
+
+// RtglExample --benchmark <map name> [--frames N] [--warmup N] [--out path.json]
+//                                     [--primitives N] [--lights N]
+std::optional< BenchmarkParams > ParseBenchmarkArgs( int argc, char* argv[] )
+{
+    if( argc < 3 || std::string_view{ argv[ 1 ] } != "--benchmark" )
+    {
+        return std::nullopt;
+    }
+
+    auto params = BenchmarkParams{
+        .mapName = argv[ 2 ],
+    };
+
+    for( int i = 3; i + 1 < argc; i += 2 )
+    {
+        auto key = std::string_view{ argv[ i ] };
+        auto val = argv[ i + 1 ];
+
+        if( key == "--frames" )
+        {
+            params.frameCount = uint32_t( std::max( 1, std::atoi( val ) ) );
+        }
+        else if( key == "--warmup" )
+        {
+            params.warmupFrames = uint32_t( std::max( 0, std::atoi( val ) ) );
+        }
+        else if( key == "--out" )
+        {
+            params.outputPath = val;
+        }
+        else if( key == "--primitives" )
+        {
+            params.syntheticPrimitives = uint32_t( std::max( 0, std::atoi( val ) ) );
+        }
+        else if( key == "--lights" )
+        {
+            params.syntheticLights = uint32_t( std::max( 0, std::atoi( val ) ) );
+        }
+        else
+        {
+            std::cout << "Benchmark: unknown argument " << key << std::endl;
+        }
+    }
+    return params;
+}
+}
+#pragma endregion BENCHMARK
+
+
+
+#pragma region SCALABILITY
+
+// Procedurally generated workloads, to find the scaling limits of the library without
+// building test maps by hand. Each step of a sweep renders a grid of instances, lights,
+// particles and decals of the given counts, and averages the per-subsystem CPU and GPU
+// timings over the step's frames. The camera looks down on the grid from a fixed position.
+// There's no map, so all geometry is dynamic: 'still' instances keep their transforms.
+namespace
+{
+struct SyntheticWorkload
+{
+    uint32_t stillInstances{ 0 };
+    uint32_t movingInstances{ 0 };
+    uint32_t sphereLights{ 0 };
+    uint32_t spotLights{ 0 };
+    uint32_t polygonalLights{ 0 };
+    // Unique materials that the instances and decals are spread over
+    uint32_t textures{ 0 };
+    uint32_t particles{ 0 };
+    uint32_t decals{ 0 };
+};
+
+// Also the names of the command line arguments
+constexpr std::pair< const char*, uint32_t SyntheticWorkload::* > WorkloadFields[] = {
+    { "instances", &SyntheticWorkload::stillInstances },
+    { "moving", &SyntheticWorkload::movingInstances },
+    { "sphereLights", &SyntheticWorkload::sphereLights },
+    { "spotLights", &SyntheticWorkload::spotLights },
+    { "polygonalLights", &SyntheticWorkload::polygonalLights },
+    { "textures", &SyntheticWorkload::textures },
+    { "particles", &SyntheticWorkload::particles },
+    { "decals", &SyntheticWorkload::decals },
+};
+
+struct ScalabilityParams
+{
+    std::vector< SyntheticWorkload > steps{};
+    uint32_t                         warmupFrames{ 60 };
+    uint32_t                         frameCount{ 300 };
+    bool                             sun{ true };
+    std::string                      outputPath{ "rtgl1_scalability.json" };
+};
+
+struct ScalabilityStep
+{
+    SyntheticWorkload                               workload;
+    std::vector< double >                           frameMs;
+    std::vector< double >                           cpuMs;
+    RgUtilFrameTimings                              gpuAvg;
+    std::vector< std::pair< std::string, double > > cpuZonesAvg;
+    RgUtilMemoryUsage                               memory;
+};
+
+constexpr uint32_t SyntheticParticlesPerMesh = 4096;
+
+std::string SyntheticTextureName( uint32_t index )
+{
+    return "synthetic/" + std::to_string( index );
+}
+
+// Textures are kept between the steps, so only the missing ones are provided
+void ProvideSyntheticTextures( RgInterface& rt, uint32_t& providedCount, uint32_t requiredCount )
+{
+    constexpr uint32_t Size = 64;
+
+    auto pixels = std::vector< uint32_t >( Size * Size );
+
+    for( ; providedCount < requiredCount; providedCount++ )
+    {
+        const auto     name  = SyntheticTextureName( providedCount );
+        const uint32_t color = MurmurHash32( name ) | 0xFF000000;
+
+        for( uint32_t y = 0; y < Size; y++ )
+        {
+            for( uint32_t x = 0; x < Size; x++ )
+            {
+                pixels[ y * Size + x ] = ( x / 8 + y / 8 ) % 2 ? color : 0xFFFFFFFF;
+            }
+        }
+
+        auto info = RgOriginalTextureInfo{
+            .sType        = RG_STRUCTURE_TYPE_ORIGINAL_TEXTURE_INFO,
+            .pTextureName = name.c_str(),
+            .pPixels      = pixels.data(),
+            .size         = { Size, Size },
+        };
+        RgResult r = rt.rgProvideOriginalTexture( &info );
+        RG_CHECK( r );
+    }
+}
+
+void UploadSyntheticCamera( RgInterface& rt, const SyntheticWorkload& w )
+{
+    const uint32_t instanceCount =
+        std::max( { w.stillInstances + w.movingInstances, w.sphereLights, w.spotLights } );
+    const float extent = SyntheticSpacing * float( SyntheticGridSide( instanceCount ) );
+
+    const auto position  = glm::vec3{ 0, std::max( 0.6f * extent, 5.0f ), -0.6f * extent };
+    const auto direction = glm::normalize( -position );
+    const auto right     = glm::normalize( glm::cross( direction, glm::vec3{ 0, 1, 0 } ) );
+    const auto up        = glm::cross( right, direction );
+
+    auto camera = RgCameraInfo{
+        .sType       = RG_STRUCTURE_TYPE_CAMERA_INFO,
+        .pNext       = nullptr,
+        .position    = { position.x, position.y, position.z },
+        .up          = { up.x, up.y, up.z },
+        .right       = { right.x, right.y, right.z },
+        .fovYRadians = glm::radians( 75.0f ),
+        .aspect      = GetWindowAspect(),
+        .cameraNear  = 0.1f,
+        .cameraFar   = 10000.0f,
+    };
+
+    RgResult r = rt.rgUploadCamera( &camera );
+    RG_CHECK( r );
+}
+
+void UploadSyntheticWorkload( RgInterface&                   rt,
+                              const SyntheticWorkload&       w,
+                              bool                           sun,
+                              std::span< const std::string > textureNames,
+                              uint64_t                       frameId )
+{
+    const uint32_t instanceCount = w.stillInstances + w.movingInstances;
+    const float    time          = float( frameId ) * 0.05f;
+
+    const auto white = rt.rgUtilPackColorByte4D( 255, 255, 255, 255 );
+    const auto cube  = GetCubeVertices( white );
+
+    auto l_texture = [ & ]( uint32_t i ) {
+        return textureNames.empty() ? nullptr : textureNames[ i % textureNames.size() ].c_str();
+    };
+
+    for( uint32_t i = 0; i < instanceCount; i++ )
+    {
+        const bool isMoving = i >= w.stillInstances;
+        const auto pos      = SyntheticGridPosition( i, instanceCount, 0.0f );
+        const auto local    = isMoving ? i - w.stillInstances : i;
+        const auto y        = isMoving ? 0.25f * std::sin( time + float( i ) ) : 0.0f;
+
+        auto mesh = RgMeshInfo{
+            .sType          = RG_STRUCTURE_TYPE_MESH_INFO,
+            .pNext          = nullptr,
+            .uniqueObjectID = ( isMoving ? 3000000 : 2000000 ) + local / SyntheticPrimitivesPerMesh,
+            .pMeshName      = isMoving ? "synthetic_moving" : "synthetic_still",
+            .transform      = { {
+                { 1, 0, 0, pos.data[ 0 ] },
+                { 0, 1, 0, y },
+                { 0, 0, 1, pos.data[ 2 ] },
+            } },
+            .isExportable   = false,
+        };
+
+        auto prim = RgMeshPrimitiveInfo{
+            .sType                = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO,
+            .pNext                = nullptr,
+            .flags                = 0,
+            .primitiveIndexInMesh = local % SyntheticPrimitivesPerMesh,
+            .pVertices            = cube,
+            .vertexCount          = std::size( s_CubePositions ),
+            .pTextureName         = l_texture( i ),
+            .textureFrame         = 0,
+            .color                = rt.rgUtilPackColorByte4D( 128, 128, 128, 255 ),
+            .classicLight         = 1.0f,
+        };
+
+        RgResult r = rt.rgUploadMeshPrimitive( &mesh, &prim );
+        RG_CHECK( r );
+    }
+
+    // on top of the instances, or on the ground, if there are none
+    for( uint32_t i = 0; i < w.decals; i++ )
+    {
+        const auto pos = instanceCount > 0
+                             ? SyntheticGridPosition( i % instanceCount, instanceCount, 0.51f )
+                             : SyntheticGridPosition( i, w.decals, 0.01f );
+
+        // quad is in XY, put it on XZ
+        auto mesh = RgMeshInfo{
+            .sType          = RG_STRUCTURE_TYPE_MESH_INFO,
+            .pNext          = nullptr,
+            .uniqueObjectID = 6000000 + i / SyntheticPrimitivesPerMesh,
+            .pMeshName      = "synthetic_decal",
+            .transform      = { {
+                { 0.8f, 0, 0, pos.data[ 0 ] - 0.4f },
+                { 0, 0, 1, pos.data[ 1 ] },
+                { 0, 0.8f, 0, pos.data[ 2 ] - 0.4f },
+            } },
+            .isExportable   = false,
+        };
+
+        auto prim = RgMeshPrimitiveInfo{
+            .sType                = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO,
+            .pNext                = nullptr,
+            .flags                = RG_MESH_PRIMITIVE_DECAL,
+            .primitiveIndexInMesh = i % SyntheticPrimitivesPerMesh,
+            .pVertices            = GetQuadVertices(),
+            .vertexCount          = std::size( s_QuadPositions ),
+            .pTextureName         = l_texture( i ),
+            .textureFrame         = 0,
+            .color                = white,
+        };
+
+        RgResult r = rt.rgUploadMeshPrimitive( &mesh, &prim );
+        RG_CHECK( r );
+    }
+
+    // a cloud above the grid, in chunks, as all particles of a primitive are in one BLAS
+    {
+        static auto particles = std::vector< RgParticle >{};
+        particles.resize( w.particles );
+
+        const float radius = 0.5f * SyntheticSpacing * float( SyntheticGridSide( instanceCount ) );
+
+        for( uint32_t i = 0; i < w.particles; i++ )
+        {
+            const float t = float( i ) * 2.39996f + time;
+            const float r = radius * std::sqrt( float( i ) / float( w.particles ) );
+
+            particles[ i ] = RgParticle{
+                .position = { r * std::cos( t ), 3 + 0.5f * std::sin( 3 * t ), r * std::sin( t ) },
+                .size     = 0.2f,
+                .rotation = t,
+                .color    = rt.rgUtilPackColorByte4D( 255, 160, 64, 128 ),
+                .frame    = 0,
+            };
+        }
+
+        for( uint32_t first = 0; first < w.particles; first += SyntheticParticlesPerMesh )
+        {
+            auto ext = RgMeshPrimitiveParticlesEXT{
+                .sType           = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_PARTICLES_EXT,
+                .pNext           = nullptr,
+                .pParticles      = &particles[ first ],
+                .particleCount   = std::min( w.particles - first, SyntheticParticlesPerMesh ),
+                .flipbookColumns = 1,
+                .flipbookRows    = 1,
+            };
+
+            auto mesh = RgMeshInfo{
+                .sType          = RG_STRUCTURE_TYPE_MESH_INFO,
+                .pNext          = nullptr,
+                .uniqueObjectID = 5000000 + first / SyntheticParticlesPerMesh,
+                .pMeshName      = "synthetic_particles",
+                .transform      = { {
+                    { 1, 0, 0, 0 },
+                    { 0, 1, 0, 0 },
+                    { 0, 0, 1, 0 },
+                } },
+                .isExportable   = false,
+            };
+
+            auto prim = RgMeshPrimitiveInfo{
+                .sType                = RG_STRUCTURE_TYPE_MESH_PRIMITIVE_INFO,
+                .pNext                = &ext,
+                .flags                = RG_MESH_PRIMITIVE_TRANSLUCENT,
+                .primitiveIndexInMesh = 0,
+                .pVertices            = nullptr,
+                .vertexCount          = 0,
+                .pTextureName         = nullptr,
+                .textureFrame         = 0,
+                .color                = white,
+            };
+
+            RgResult r = rt.rgUploadMeshPrimitive( &mesh, &prim );
+            RG_CHECK( r );
+        }
+    }
+
+    auto l_uploadLight = [ &rt ]( uint64_t uniqueID, void* pExtension ) {
+        auto l = RgLightInfo{
+            .sType        = RG_STRUCTURE_TYPE_LIGHT_INFO,
+            .pNext        = pExtension,
+            .uniqueID     = uniqueID,
+            .isExportable = false,
+        };
+
+        RgResult r = rt.rgUploadLight( &l );
+        RG_CHECK( r );
+    };
+
+    const auto lightColor = rt.rgUtilPackColorByte4D( 255, 200, 160, 255 );
+
+    if( sun )
+    {
+        auto dir = RgLightDirectionalEXT{
+            .sType                  = RG_STRUCTURE_TYPE_LIGHT_DIRECTIONAL_EXT,
+            .pNext                  = nullptr,
+            .color                  = white,
+            .intensity              = ctl_SunIntensity,
+            .direction              = { -1, -8, -1 },
+            .angularDiameterDegrees = 0.5f,
+        };
+        l_uploadLight( 1, &dir );
+    }
+
+    for( uint32_t i = 0; i < w.sphereLights; i++ )
+    {
+        const float y = 1.5f + 0.25f * std::sin( time );
+
+        auto sphere = RgLightSphericalEXT{
+            .sType     = RG_STRUCTURE_TYPE_LIGHT_SPHERICAL_EXT,
+            .pNext     = nullptr,
+            .color     = lightColor,
+            .intensity = 100.0f,
+            .position  = SyntheticGridPosition( i, w.sphereLights, y ),
+            .radius    = 0.1f,
+        };
+        l_uploadLight( 2000000 + i, &sphere );
+    }
+
+    for( uint32_t i = 0; i < w.spotLights; i++ )
+    {
+        auto spot = RgLightSpotEXT{
+            .sType      = RG_STRUCTURE_TYPE_LIGHT_SPOT_EXT,
+            .pNext      = nullptr,
+            .color      = lightColor,
+            .intensity  = 100.0f,
+            .position   = SyntheticGridPosition( i, w.spotLights, 2.5f ),
+            .direction  = { 0, -1, 0 },
+            .radius     = 0.1f,
+            .angleOuter = glm::radians( 40.0f ),
+            .angleInner = glm::radians( 20.0f ),
+        };
+        l_uploadLight( 3000000 + i, &spot );
+    }
+
+    for( uint32_t i = 0; i < w.polygonalLights; i++ )
+    {
+        const auto c = SyntheticGridPosition( i, w.polygonalLights, 3.0f );
+
+        auto poly = RgLightPolygonalEXT{
+            .sType     = RG_STRUCTURE_TYPE_LIGHT_POLYGONAL_EXT,
+            .pNext     = nullptr,
+            .color     = lightColor,
+            .intensity = 100.0f,
+            .positions = {
+                { c.data[ 0 ] - 0.2f, c.data[ 1 ], c.data[ 2 ] - 0.2f },
+                { c.data[ 0 ] + 0.2f, c.data[ 1 ], c.data[ 2 ] - 0.2f },
+                { c.data[ 0 ], c.data[ 1 ], c.data[ 2 ] + 0.2f },
+            },
+        };
+        l_uploadLight( 4000000 + i, &poly );
+    }
+}
+
+void WriteScalabilityJson( const ScalabilityParams&          params,
+                           std::span< const ScalabilityStep > steps )
+{
+    auto f = std::ofstream{ params.outputPath };
+    if( !f )
+    {
+        std::cout << "Scalability: can't write to " << params.outputPath << std::endl;
+        return;
+    }
+
+    auto l_stats = [ & ]( const char* name, std::span< const double > sorted ) {
+        double avg = 0;
+        for( double v : sorted )
+        {
+            avg += v / double( sorted.size() );
+        }
+        f << "      " << JsonString( name ) << ": { "
+          << "\"avg\": " << avg << ", "
+          << "\"p50\": " << Percentile( sorted, 0.50 ) << ", "
+          << "\"p99\": " << Percentile( sorted, 0.99 ) << ", "
+          << "\"max\": " << ( sorted.empty() ? 0.0 : sorted.back() ) << " }";
+    };
+
+    f << "{\n";
+    f << "  \"warmupFrames\": " << params.warmupFrames << ",\n";
+    f << "  \"frameCount\": " << params.frameCount << ",\n";
+    f << "  \"sun\": " << ( params.sun ? "true" : "false" ) << ",\n";
+    f << "  \"steps\": [";
+    for( size_t s = 0; s < steps.size(); s++ )
+    {
+        const auto& st = steps[ s ];
+
+        f << ( s > 0 ? ",\n" : "\n" ) << "    {\n";
+
+        f << "      \"workload\": { ";
+        for( size_t i = 0; i < std::size( WorkloadFields ); i++ )
+        {
+            const auto& [ name, field ] = WorkloadFields[ i ];
+            f << ( i > 0 ? ", " : "" ) << JsonString( name ) << ": " << st.workload.*field;
+        }
+        f << " },\n";
+
+        l_stats( "frameMs", st.frameMs );
+        f << ",\n";
+        l_stats( "cpuMs", st.cpuMs );
+        f << ",\n";
+
+        f << "      \"gpuAvg\": { ";
+        for( size_t t = 0; t < std::size( GpuTimingFields ); t++ )
+        {
+            const auto& [ name, field ] = GpuTimingFields[ t ];
+            f << ( t > 0 ? ", " : "" ) << JsonString( name ) << ": " << st.gpuAvg.*field;
+        }
+        f << " },\n";
+
+        f << "      \"cpuZonesAvg\": { ";
+        for( size_t z = 0; z < st.cpuZonesAvg.size(); z++ )
+        {
+            f << ( z > 0 ? ", " : "" ) << JsonString( st.cpuZonesAvg[ z ].first ) << ": "
+              << st.cpuZonesAvg[ z ].second;
+        }
+        f << " },\n";
+
+        f << "      \"vramUsed\": " << st.memory.vramUsed << ",\n";
+        f << "      \"memory\": { ";
+        for( uint32_t c = 0; c < RG_UTIL_MEMORY_CATEGORY_COUNT; c++ )
+        {
+            f << ( c > 0 ? ", " : "" ) << JsonString( MemoryCategoryNames[ c ] ) << ": "
+              << st.memory.categories[ c ].current;
+        }
+        f << " }\n    }";
+    }
+    f << "\n  ]\n}\n";
+
+    std::cout << "Scalability: written to " << params.outputPath << std::endl;
+}
+
+bool RunScalability( RgInterface& rt, const ScalabilityParams& params )
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto l_ms = []( Clock::time_point a, Clock::time_point b ) {
+        return std::chrono::duration< double, std::milli >( b - a ).count();
+    };
+
+    auto     results          = std::vector< ScalabilityStep >{};
+    auto     zones            = std::vector< RgUtilCpuZone >( 256 );
+    auto     prevStart        = std::optional< Clock::time_point >{};
+    uint32_t providedTextures = 0;
+    uint64_t frameId          = 0;
+
+    for( const SyntheticWorkload& workload : params.steps )
+    {
+        ProvideSyntheticTextures( rt, providedTextures, workload.textures );
+
+        auto textureNames = std::vector< std::string >{};
+        for( uint32_t i = 0; i < workload.textures; i++ )
+        {
+            textureNames.push_back( SyntheticTextureName( i ) );
+        }
+
+        auto step = ScalabilityStep{
+            .workload = workload,
+            .gpuAvg   = {},
+        };
+
+        for( uint32_t f = 0; f < params.warmupFrames + params.frameCount; f++ )
+        {
+            if( glfwWindowShouldClose( g_GlfwHandle ) )
+            {
+                std::cout << "Scalability: window was closed, aborting" << std::endl;
+                return false;
+            }
+            glfwPollEvents();
+
+            const auto tStart = Clock::now();
+            {
+                auto resolution = RgStartFrameRenderResolutionParams{
+                    .sType            = RG_STRUCTURE_TYPE_START_FRAME_RENDER_RESOLUTION_PARAMS,
+                    .pNext            = nullptr,
+                    .upscaleTechnique = RG_RENDER_UPSCALE_TECHNIQUE_AMD_FSR2,
+                    .resolutionMode   = RG_RENDER_RESOLUTION_MODE_BALANCED,
+                };
+
+                auto startInfo = RgStartFrameInfo{
+                    .sType    = RG_STRUCTURE_TYPE_START_FRAME_INFO,
+                    .pNext    = &resolution,
+                    .pMapName = nullptr,
+                    .vsync    = false,
+                };
+
+                RgResult r = rt.rgStartFrame( &startInfo );
+                RG_CHECK( r );
+            }
+
+            UploadSyntheticCamera( rt, workload );
+            UploadSyntheticWorkload( rt, workload, params.sun, textureNames, frameId );
+
+            {
+                auto sky = RgDrawFrameSkyParams{
+                    .sType              = RG_STRUCTURE_TYPE_DRAW_FRAME_SKY_PARAMS,
+                    .pNext              = nullptr,
+                    .skyType            = RG_SKY_TYPE_COLOR,
+                    .skyColorDefault    = { 0.71f, 0.88f, 1.0f },
+                    .skyColorMultiplier = ctl_SkyIntensity,
+                    .skyColorSaturation = 1.0f,
+                    .skyViewerPosition  = { 0, 0, 0 },
+                };
+
+                auto frameInfo = RgDrawFrameInfo{
+                    .sType       = RG_STRUCTURE_TYPE_DRAW_FRAME_INFO,
+                    .pNext       = &sky,
+                    .rayLength   = 10000.0f,
+                    .currentTime = double( frameId ) / 60.0,
+                };
+
+                RgResult r = rt.rgDrawFrame( &frameInfo );
+                RG_CHECK( r );
+            }
+            const auto tEnd = Clock::now();
+
+            // warmup also lets the GPU timings, which lag a few frames, catch up with the step
+            if( f >= params.warmupFrames && prevStart )
+            {
+                const auto n = double( params.frameCount );
+
+                step.cpuMs.push_back( l_ms( tStart, tEnd ) );
+                step.frameMs.push_back( l_ms( *prevStart, tStart ) );
+
+                const auto gpu = rt.rgUtilGetFrameTimings();
+                for( const auto& [ name, field ] : GpuTimingFields )
+                {
+                    step.gpuAvg.*field += float( double( gpu.*field ) / n );
+                }
+
+                uint32_t zoneCount = rt.rgUtilGetCpuZones( zones.data(), uint32_t( zones.size() ) );
+                for( uint32_t z = 0; z < std::min< uint32_t >( zoneCount, zones.size() ); z++ )
+                {
+                    auto found = std::ranges::find_if( step.cpuZonesAvg, [ & ]( const auto& p ) {
+                        return p.first == zones[ z ].pName;
+                    } );
+                    if( found == step.cpuZonesAvg.end() )
+                    {
+                        found = step.cpuZonesAvg.emplace(
+                            step.cpuZonesAvg.end(), zones[ z ].pName, 0.0 );
+                    }
+                    found->second += double( zones[ z ].timeMs ) / n;
+                }
+            }
+            prevStart = tStart;
+
+            frameId++;
+        }
+
+        std::ranges::sort( step.frameMs );
+        std::ranges::sort( step.cpuMs );
+        step.memory = rt.rgUtilRequestMemoryUsage();
+
+        std::cout << "Scalability: step " << results.size() << ", p50 frame "
+                  << Percentile( step.frameMs, 0.50 ) << " ms, p50 cpu "
+                  << Percentile( step.cpuMs, 0.50 ) << " ms" << std::endl;
+
+        results.push_back( std::move( step ) );
+    }
+
+    WriteScalabilityJson( params, results );
+    return true;
+}
+
+// RtglExample --scalability [--frames N] [--warmup N] [--out path.json] [--sun 0|1]
+//                           [--instances N,N,...] [--moving N,...] [--sphereLights N,...]
+//                           [--spotLights N,...] [--polygonalLights N,...] [--textures N,...]
+//                           [--particles N,...] [--decals N,...]
+// Each count is a list of values, one per step; a shorter list repeats its last value.
+// So '--instances 1000,10000,60000 --sphereLights 256' sweeps only the instance count.
+std::optional< ScalabilityParams > ParseScalabilityArgs( int argc, char* argv[] )
+{
+    if( argc < 2 || std::string_view{ argv[ 1 ] } != "--scalability" )
+    {
+        return std::nullopt;
+    }
+
+    auto l_parseList = []( std::string_view str ) {
+        auto values = std::vector< uint32_t >{};
+        while( !str.empty() )
+        {
+            const size_t comma = str.find( ',' );
+            const auto   token = std::string{ str.substr( 0, comma ) };
+
+            values.push_back( uint32_t( std::max( 0, std::atoi( token.c_str() ) ) ) );
+            str = comma == std::string_view::npos ? std::string_view{} : str.substr( comma + 1 );
+        }
+        return values;
+    };
+
+    auto params = ScalabilityParams{};
+    auto lists  = std::vector< std::vector< uint32_t > >( std::size( WorkloadFields ) );
+
+    for( int i = 2; i + 1 < argc; i += 2 )
+    {
+        auto key = std::string_view{ argv[ i ] };
+        auto val = argv[ i + 1 ];
+
+        auto field = std::ranges::find_if( WorkloadFields, [ & ]( const auto& wf ) {
+            return key.starts_with( "--" ) && key.substr( 2 ) == wf.first;
+        } );
+
+        if( field != std::end( WorkloadFields ) )
+        {
+            lists[ field - std::begin( WorkloadFields ) ] = l_parseList( val );
+        }
+        else if( key == "--frames" )
+        {
+            params.frameCount = uint32_t( std::max( 1, std::atoi( val ) ) );
+        }
+        else if( key == "--warmup" )
+        {
+            params.warmupFrames = uint32_t( std::max( 0, std::atoi( val ) ) );
+        }
+        else if( key == "--out" )
+        {
+            params.outputPath = val;
+        }
+        else if( key == "--sun" )
+        {
+            params.sun = std::atoi( val ) != 0;
+        }
+        else
+        {
+            std::cout << "Scalability: unknown argument " << key << std::endl;
+        }
+    }
+
+    // default: grow everything at once
+    if( std::ranges::all_of( lists, []( const auto& l ) { return l.empty(); } ) )
+    {
+        lists = {
+            { 1000, 10000, 60000 }, // instances
+            { 100, 1000, 4000 },    // moving
+            { 64, 1024, 8192 },     // sphereLights
+            { 16, 256, 2048 },      // spotLights
+            { 16, 256, 2048 },      // polygonalLights
+            { 16, 256, 2048 },      // textures
+            { 1000, 10000, 50000 }, // particles
+            { 64, 1024, 8192 },     // decals
+        };
+        assert( lists.size() == std::size( WorkloadFields ) );
+    }
+
+    size_t stepCount = 1;
+    for( const auto& l : lists )
+    {
+        stepCount = std::max( stepCount, l.size() );
+    }
+
+    for( size_t s = 0; s < stepCount; s++ )
+    {
+        auto w = SyntheticWorkload{};
+        for( size_t i = 0; i < std::size( WorkloadFields ); i++ )
+        {
+            if( !lists[ i ].empty() )
+            {
+                w.*WorkloadFields[ i ].second = lists[ i ][ std::min( s, lists[ i ].size() - 1 ) ];
+            }
+        }
+        params.steps.push_back( w );
+    }
+    return params;
+}
+}
+#pragma endregion SCALABILITY
+
+
+
+#pragma region REPLAY
+
+// Feed an API capture, recorded with 'RtglExample --capture <path>' (or by any application
+// with RgInstanceCreateInfo::pApiCaptureFilePath), back into the library as fast as possible.
+namespace
+{
+struct ReplayParams
+{
+    std::string capturePath{};
+    // Count of times to replay the capture
+    uint32_t    loops{ 1 };
+};
+
+struct ReplayState
+{
+    std::chrono::steady_clock::time_point prevFrame;
+    std::vector< double >                 frameMs;
+};
+
+bool RunReplay( RgInterface& rt, const ReplayParams& params )
+{
+    using Clock = std::chrono::steady_clock;
+
+    auto state = ReplayState{};
+
+    for( uint32_t loop = 0; loop < params.loops; loop++ )
+    {
+        state.prevFrame = Clock::now();
+
+        RgResult r = rt.rgUtilReplayCapture(
+            params.capturePath.c_str(),
+            []( uint32_t frameIndex, void* pUserData ) -> RgBool32 {
+                auto& st = *static_cast< ReplayState* >( pUserData );
+
+                const auto now = Clock::now();
+                st.frameMs.push_back(
+                    std::chrono::duration< double, std::milli >( now - st.prevFrame ).count() );
+                st.prevFrame = now;
+
+                glfwPollEvents();
+                return !glfwWindowShouldClose( g_GlfwHandle );
+            },
+            &state );
+
+        if( r != RG_RESULT_SUCCESS )
+        {
+            std::cout << "Replay: failed to replay " << params.capturePath << ": "
+                      << rt.rgUtilGetResultDescription( r ) << std::endl;
+            return false;
+        }
+    }
+
+    if( state.frameMs.empty() )
+    {
+        std::cout << "Replay: no frames in " << params.capturePath << std::endl;
+        return false;
+    }
+
+    auto sorted = state.frameMs;
+    std::ranges::sort( sorted );
+
+    double total = 0;
+    for( double ms : sorted )
+    {
+        total += ms;
+    }
+
+    std::cout << "Replay: " << sorted.size() << " frames, average " << total / sorted.size()
+              << " ms, median " << Percentile( sorted, 0.5 ) << " ms, 99th percentile "
+              << Percentile( sorted, 0.99 ) << " ms" << std::endl;
+    return true;
+}
+
+// RtglExample --replay <capture path> [--loops N]
+std::optional< ReplayParams > ParseReplayArgs( int argc, char* argv[] )
+{
+    if( argc < 3 || std::string_view{ argv[ 1 ] } != "--replay" )
+    {
+        return std::nullopt;
+    }
+
+    auto params = ReplayParams{
+        .capturePath = argv[ 2 ],
+    };
+
+    for( int i = 3; i + 1 < argc; i += 2 )
+    {
+        auto key = std::string_view{ argv[ i ] };
+        auto val = argv[ i + 1 ];
+
+        if( key == "--loops" )
+        {
+            params.loops = uint32_t( std::max( 1, std::atoi( val ) ) );
+        }
+        else
+        {
+            std::cout << "Replay: unknown argument " << key << std::endl;
+        }
+    }
+    return params;
+}
+
+// RtglExample --capture <capture path> [gltf path]
+const char* ParseCaptureArg( int& argc, char**& argv )
+{
+    if( argc < 3 || std::string_view{ argv[ 1 ] } != "--capture" )
+    {
+        return nullptr;
+    }
+
+    const char* path = argv[ 2 ];
+    // skip, so the rest is parsed as usual
+    argc -= 2;
+    argv += 2;
+    return path;
+}
+}
+#pragma endregion REPLAY
+
+
+
 void MainLoop( RgInterface& rt, std::string_view gltfPath )
 {
     RgResult r       = RG_RESULT_SUCCESS;
@@ -806,9 +2022,15 @@ void MainLoop( RgInterface& rt, std::string_view gltfPath )
 
 int main( int argc, char* argv[] )
 {
+    const auto benchmark   = ParseBenchmarkArgs( argc, argv );
+    const auto replay      = ParseReplayArgs( argc, argv );
+    const auto capturePath = ParseCaptureArg( argc, argv );
+    const auto scalability = ParseScalabilityArgs( argc, argv );
+
     glfwInit();
     glfwWindowHint( GLFW_CLIENT_API, GLFW_NO_API );
-    glfwWindowHint( GLFW_RESIZABLE, GLFW_TRUE );
+    // fixed resolution for comparable benchmark results
+    glfwWindowHint( GLFW_RESIZABLE, benchmark || scalability || replay ? GLFW_FALSE : GLFW_TRUE );
     g_GlfwHandle = glfwCreateWindow( 1600, 900, "RTGL1 Test", nullptr, nullptr );
 
 
@@ -871,6 +2093,8 @@ int main( int argc, char* argv[] )
         .worldUp      = { 0, 1, 0 },
         .worldForward = { 0, 0, 1 },
         .worldScale   = 1.0f,
+
+        .pApiCaptureFilePath = capturePath,
     };
 
 #ifndef NDEBUG
@@ -888,6 +2112,21 @@ int main( int argc, char* argv[] )
     r = rgLoadLibraryAndCreate( &info, isdebug, nullptr, & rt, &rtDll );
     RG_CHECK( r );
 
+    bool success = true;
+
+    if( benchmark )
+    {
+        success = RunBenchmark( rt, *benchmark );
+    }
+    else if( scalability )
+    {
+        success = RunScalability( rt, *scalability );
+    }
+    else if( replay )
+    {
+        success = RunReplay( rt, *replay );
+    }
+    else
     {
         auto gltfPath = argc > 1 ? argv[ 1 ] : "_external_/Sponza/glTF/Sponza.gltf";
         MainLoop( rt, gltfPath );
@@ -900,5 +2139,5 @@ int main( int argc, char* argv[] )
     glfwDestroyWindow( g_GlfwHandle );
     glfwTerminate();
 
-    return 0;
+    return success ? 0 : 1;
 }
\ No newline at end of file